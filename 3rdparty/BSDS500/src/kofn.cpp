@@ -4,12 +4,14 @@
 #include <chrono>
 #include <cassert>
 #include <functional>
+#include <thread>
 
 using namespace BSDS500;
 
-static std::mt19937 s_oMT(std::chrono::system_clock::now().time_since_epoch().count());
-static std::uniform_real_distribution<double> s_oURDistrib_0_1(0,std::nextafter(1,std::numeric_limits<double>::max()));
-static auto s_oRand_0_1_Funct = std::bind(s_oURDistrib_0_1,s_oMT);
+// generators are kept per-thread so that kOfN can be called concurrently (e.g. from parallel edge matching)
+static thread_local std::mt19937 s_oMT(unsigned(std::chrono::system_clock::now().time_since_epoch().count())^unsigned(std::hash<std::thread::id>()(std::this_thread::get_id())));
+static thread_local std::uniform_real_distribution<double> s_oURDistrib_0_1(0,std::nextafter(1,std::numeric_limits<double>::max()));
+static thread_local auto s_oRand_0_1_Funct = std::bind(s_oURDistrib_0_1,s_oMT);
 
 // O(n) implementation.
 static void
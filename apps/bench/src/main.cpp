@@ -0,0 +1,425 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/features2d.hpp"
+#include "litiv/imgproc.hpp"
+#include "litiv/video.hpp"
+#include <fstream>
+#include <iomanip>
+
+// usage: litiv_bench [--out=<results.json>] [--filter=<name substring>] [--min-time=<seconds>] [--sizes=QVGA,VGA,HD,FHD,UHD]
+//
+// every case is run once for warmup, then repeatedly until the minimum time is reached; results are printed as a table
+// on stdout, and written as JSON (using the same layout as Google Benchmark reports, so existing comparison tools work)
+
+namespace {
+
+    struct BenchResult {
+        std::string sName;
+        cv::Size oFrameSize;
+        int nChannels;
+        size_t nIterations;
+        double dTimePerIter_sec;
+    };
+
+    struct BenchContext {
+        std::string sFilter;
+        double dMinTime_sec = 0.5;
+        std::vector<BenchResult> voResults;
+    };
+
+    /// result accumulator used to keep the compiler from optimizing away the benchmarked calls
+    volatile size_t g_nSink = 0;
+
+    template<typename Tfunc>
+    void runBenchmark(BenchContext& oCtx, const std::string& sFamily, const std::string& sSizeName, const cv::Size& oFrameSize, int nChannels, Tfunc&& lFunc) {
+        const std::string sName = sFamily+"/"+sSizeName+"/"+std::to_string(nChannels)+"ch";
+        if(!oCtx.sFilter.empty() && sName.find(oCtx.sFilter)==std::string::npos)
+            return;
+        lFunc(); // warmup
+        lv::StopWatch oStopWatch;
+        size_t nIterations = 0;
+        double dElapsed_sec = 0.0;
+        do {
+            lFunc();
+            ++nIterations;
+            dElapsed_sec = oStopWatch.tock(false);
+        } while(dElapsed_sec<oCtx.dMinTime_sec);
+        oCtx.voResults.push_back(BenchResult{sName,oFrameSize,nChannels,nIterations,dElapsed_sec/nIterations});
+        const double dMPixPerSec = double(oFrameSize.area())/(dElapsed_sec/nIterations)/1e6;
+        std::cout << std::setw(48) << std::left << sName << std::right << std::setw(12) << std::fixed << std::setprecision(3) << (dElapsed_sec/nIterations)*1e3 << " ms" << std::setw(12) << dMPixPerSec << " Mpx/s" << std::setw(10) << nIterations << " it" << std::endl;
+    }
+
+    template<size_t nChannels>
+    std::enable_if_t<(nChannels==1)> addColorDistanceBenchmarks(BenchContext&, const std::string&, const cv::Mat&, const cv::Mat&) {}
+
+    template<size_t nChannels>
+    std::enable_if_t<(nChannels>1)> addColorDistanceBenchmarks(BenchContext& oCtx, const std::string& sSizeName, const cv::Mat& oFrameA, const cv::Mat& oFrameB) {
+        const size_t nPx = (size_t)oFrameA.total();
+        const uchar* const anDataA = oFrameA.data;
+        const uchar* const anDataB = oFrameB.data;
+        runBenchmark(oCtx,"cdist",sSizeName,oFrameA.size(),(int)nChannels,[&]() {
+            size_t nSum = 0;
+            for(size_t nPxIter=0; nPxIter<nPx; ++nPxIter)
+                nSum += lv::cdist<nChannels>(anDataA+nPxIter*nChannels,anDataB+nPxIter*nChannels);
+            g_nSink += nSum;
+        });
+    }
+
+    template<size_t nChannels>
+    void addDistanceBenchmarks(BenchContext& oCtx, const std::string& sSizeName, const cv::Mat& oFrameA, const cv::Mat& oFrameB) {
+        const size_t nPx = (size_t)oFrameA.total();
+        const uchar* const anDataA = oFrameA.data;
+        const uchar* const anDataB = oFrameB.data;
+        runBenchmark(oCtx,"L1dist",sSizeName,oFrameA.size(),(int)nChannels,[&]() {
+            size_t nSum = 0;
+            for(size_t nPxIter=0; nPxIter<nPx; ++nPxIter)
+                nSum += lv::L1dist<nChannels>(anDataA+nPxIter*nChannels,anDataB+nPxIter*nChannels);
+            g_nSink += nSum;
+        });
+        runBenchmark(oCtx,"L1dist_batch",sSizeName,oFrameA.size(),(int)nChannels,[&]() {
+            g_nSink += lv::L1dist<nChannels>(anDataA,anDataB,nPx);
+        });
+        runBenchmark(oCtx,"L1dist_batch_count",sSizeName,oFrameA.size(),(int)nChannels,[&]() {
+            g_nSink += lv::L1dist_batch_count<nChannels>(anDataA,anDataB,nPx,size_t(30*nChannels));
+        });
+        if(nChannels==1) {
+            std::vector<uchar> vnDists(nPx);
+            runBenchmark(oCtx,"L1dist_elemwise",sSizeName,oFrameA.size(),(int)nChannels,[&]() {
+                lv::L1dist_elemwise<nChannels>(anDataA,anDataB,nPx,vnDists.data());
+                g_nSink += vnDists[nPx/2];
+            });
+        }
+        runBenchmark(oCtx,"L2sqrdist",sSizeName,oFrameA.size(),(int)nChannels,[&]() {
+            size_t nSum = 0;
+            for(size_t nPxIter=0; nPxIter<nPx; ++nPxIter)
+                nSum += lv::L2sqrdist<nChannels>(anDataA+nPxIter*nChannels,anDataB+nPxIter*nChannels);
+            g_nSink += nSum;
+        });
+    }
+
+    template<size_t nChannels>
+    void addPopcountBenchmarks(BenchContext& oCtx, const std::string& sSizeName, const cv::Size& oFrameSize) {
+        cv::Mat oDescMap(oFrameSize,CV_16UC(nChannels));
+        cv::randu(oDescMap,0,USHRT_MAX);
+        const size_t nPx = (size_t)oDescMap.total();
+        const ushort* const anDesc = (const ushort*)oDescMap.data;
+        runBenchmark(oCtx,"popcount",sSizeName,oFrameSize,(int)nChannels,[&]() {
+            size_t nSum = 0;
+            for(size_t nPxIter=0; nPxIter<nPx; ++nPxIter)
+                nSum += lv::popcount<nChannels>(anDesc+nPxIter*nChannels);
+            g_nSink += nSum;
+        });
+        cv::Mat oDescMap2(oFrameSize,CV_16UC(nChannels));
+        cv::randu(oDescMap2,0,USHRT_MAX);
+        const ushort* const anDesc2 = (const ushort*)oDescMap2.data;
+        std::vector<uchar> vnDists(nPx*nChannels);
+        runBenchmark(oCtx,"hdist_bulk",sSizeName,oFrameSize,(int)nChannels,[&]() {
+            lv::hdist_bulk(anDesc,anDesc2,nPx*nChannels,vnDists.data());
+            g_nSink += vnDists[nPx/2];
+        });
+        runBenchmark(oCtx,"hdist_bulk_count",sSizeName,oFrameSize,(int)nChannels,[&]() {
+            g_nSink += lv::hdist_bulk_count(anDesc,anDesc2,nPx*nChannels,size_t(6));
+        });
+    }
+
+    void addRandomBenchmarks(BenchContext& oCtx, const std::string& sSizeName, const cv::Size& oFrameSize) {
+        const size_t nPx = (size_t)oFrameSize.area();
+        std::vector<uint32_t> vnVals(nPx);
+        lv::PCG32 oPCG32(0);
+        runBenchmark(oCtx,"rand_pcg32",sSizeName,oFrameSize,1,[&]() {
+            for(size_t nPxIter=0; nPxIter<nPx; ++nPxIter)
+                vnVals[nPxIter] = oPCG32();
+            g_nSink += vnVals[nPx/2];
+        });
+        lv::TinyMT32Bank oBank(nPx,0);
+        runBenchmark(oCtx,"rand_tinymt32_bank",sSizeName,oFrameSize,1,[&]() {
+            for(int nRowIdx=0; nRowIdx<oFrameSize.height; ++nRowIdx)
+                oBank.generate(size_t(nRowIdx*oFrameSize.width),size_t(oFrameSize.width),vnVals.data()+nRowIdx*oFrameSize.width);
+            g_nSink += vnVals[nPx/2];
+        });
+    }
+
+    template<size_t nChannels>
+    void addLBSPPointBenchmarks(BenchContext& oCtx, const std::string& sSizeName, const cv::Mat& oFrame) {
+        // note: the single-point functions are the ones used inside the background subtraction pixel loops
+        const int nBorder = (int)LBSPPattern<32>::PATCH_SIZE/2;
+        const uchar nThreshold = 30;
+        const auto lRunPattern = [&](auto oPattern, const std::string& sFamily) {
+            typedef decltype(oPattern) Pattern;
+            runBenchmark(oCtx,sFamily,sSizeName,oFrame.size(),(int)nChannels,[&]() {
+                size_t nSum = 0;
+                typename Pattern::desc_t nDesc;
+                for(int nRowIdx=nBorder; nRowIdx<oFrame.rows-nBorder; ++nRowIdx) {
+                    const uchar* const anRow = oFrame.ptr<uchar>(nRowIdx);
+                    for(int nColIdx=nBorder; nColIdx<oFrame.cols-nBorder; ++nColIdx) {
+                        for(size_t c=0; c<nChannels; ++c) {
+                            Pattern::template computeDescriptor<nChannels>(oFrame,anRow[nColIdx*nChannels+c],nColIdx,nRowIdx,c,nThreshold,nDesc);
+                            nSum += nDesc;
+                        }
+                    }
+                }
+                g_nSink += nSum;
+            });
+        };
+        lRunPattern(LBSPPattern<16>(),"LBSP_computeDescriptor");
+        lRunPattern(LBSPPattern<24>(),"LBSP24_computeDescriptor");
+        lRunPattern(LBSPPattern<32>(),"LBSP32_computeDescriptor");
+    }
+
+    template<size_t nChannels>
+    void addLBSPBatchBenchmarks(BenchContext& oCtx, const std::string& sSizeName, const cv::Mat& oFrame) {
+        const LBSP oAbsExtractor(size_t(30));
+        const LBSP oRelExtractor(0.333f);
+        const LBSP_<LBSPThreshold_Relative,nChannels> oRelExtractor_spec(0.333f);
+        cv::Mat oDescMap, oDescMap2, oDiffMap;
+        runBenchmark(oCtx,"LBSP_computeDense_abs",sSizeName,oFrame.size(),(int)nChannels,[&]() {
+            oAbsExtractor.computeDense(oFrame,oDescMap);
+        });
+        runBenchmark(oCtx,"LBSP_computeDense_rel",sSizeName,oFrame.size(),(int)nChannels,[&]() {
+            oRelExtractor.computeDense(oFrame,oDescMap);
+        });
+        runBenchmark(oCtx,"LBSP_computeDense_rel_spec",sSizeName,oFrame.size(),(int)nChannels,[&]() {
+            oRelExtractor_spec.computeDense(oFrame,oDescMap);
+        });
+        std::vector<cv::KeyPoint> voKeyPoints;
+        voKeyPoints.reserve(oFrame.total());
+        for(int nRowIdx=0; nRowIdx<oFrame.rows; ++nRowIdx)
+            for(int nColIdx=0; nColIdx<oFrame.cols; ++nColIdx)
+                voKeyPoints.emplace_back((float)nColIdx,(float)nRowIdx,1.0f);
+        runBenchmark(oCtx,"LBSP_compute2_rel",sSizeName,oFrame.size(),(int)nChannels,[&]() {
+            std::vector<cv::KeyPoint> voCurrKeyPoints = voKeyPoints;
+            oRelExtractor.compute2(oFrame,voCurrKeyPoints,oDescMap);
+        });
+        oAbsExtractor.computeDense(oFrame,oDescMap,cv::Mat(),LBSP::BORDER_SKIP);
+        oRelExtractor.computeDense(oFrame,oDescMap2,cv::Mat(),LBSP::BORDER_SKIP);
+        runBenchmark(oCtx,"LBSP_calcDescImgDiff",sSizeName,oFrame.size(),(int)nChannels,[&]() {
+            LBSP::calcDescImgDiff(oDescMap,oDescMap2,oDiffMap,true);
+        });
+    }
+
+    template<size_t nChannels>
+    void addSampleModelBenchmarks(BenchContext& oCtx, const std::string& sSizeName, const cv::Size& oFrameSize) {
+        // note: models get large quickly (descriptors + bit planes), so these cases are only run up to VGA
+        if(oFrameSize.area()>640*480)
+            return;
+        const size_t nSamples = 64, nPx = (size_t)oFrameSize.area();
+        const size_t nMaxTotDist = 9*nChannels; // matches the SuBSENSE prefilter bound for a per-channel threshold of 4
+        cv::Mat oQueryDescMap(oFrameSize,CV_16UC(nChannels));
+        cv::randu(oQueryDescMap,0,USHRT_MAX);
+        const ushort* const anQueryDescs = (const ushort*)oQueryDescMap.data;
+        lv::PCG32 oPCG32(0);
+        const auto lCreateModel = [&](LBSPSampleModel& oModel, bool bInterleaved, bool bBitSliced) {
+            oModel.setBitSlicedDescriptors(bBitSliced);
+            oModel.create(oFrameSize,nChannels,nSamples,bInterleaved);
+            for(size_t nPxIter=0; nPxIter<nPx; ++nPxIter)
+                for(size_t s=0; s<nSamples; ++s)
+                    for(size_t c=0; c<nChannels; ++c) // half the samples are close to the query, as in BG regions
+                        oModel.desc(s,nPxIter)[c] = ushort((s%2)?(anQueryDescs[nPxIter*nChannels+c]^(1u<<(oPCG32()%16))):oPCG32());
+            oModel.resetMeanSums();
+        };
+        const auto lRunScalar = [&](const std::string& sFamily, bool bInterleaved) {
+            LBSPSampleModel oModel;
+            lCreateModel(oModel,bInterleaved,false);
+            runBenchmark(oCtx,sFamily,sSizeName,oFrameSize,(int)nChannels,[&]() {
+                size_t nSum = 0;
+                for(size_t nPxIter=0; nPxIter<nPx; ++nPxIter) {
+                    uint64_t nMatchMask = 0;
+                    for(size_t s=0; s<nSamples; ++s)
+                        nMatchMask |= uint64_t(lv::hdist<nChannels>(anQueryDescs+nPxIter*nChannels,oModel.desc(s,nPxIter))<=nMaxTotDist)<<s;
+                    nSum += lv::popcount(nMatchMask);
+                }
+                g_nSink += nSum;
+            });
+        };
+        lRunScalar("sampledesc_match_planar",false);
+        lRunScalar("sampledesc_match_interleaved",true);
+        LBSPSampleModel oModel;
+        lCreateModel(oModel,true,true);
+        runBenchmark(oCtx,"sampledesc_match_bitsliced",sSizeName,oFrameSize,(int)nChannels,[&]() {
+            size_t nSum = 0;
+            for(size_t nPxIter=0; nPxIter<nPx; ++nPxIter)
+                nSum += lv::popcount(oModel.getDescMatchMask(nPxIter,0,nSamples,anQueryDescs+nPxIter*nChannels,nChannels,nMaxTotDist));
+            g_nSink += nSum;
+        });
+    }
+
+    void addImgprocBenchmarks(BenchContext& oCtx, const std::string& sSizeName, const cv::Mat& oFrame) {
+        cv::Mat oBinaryMap, oOutput;
+        cv::threshold(oFrame,oBinaryMap,200,255,cv::THRESH_BINARY);
+        runBenchmark(oCtx,"thinning",sSizeName,oFrame.size(),1,[&]() {
+            lv::thinning(oBinaryMap,oOutput);
+        });
+        runBenchmark(oCtx,"nonMaxSuppression_3x3",sSizeName,oFrame.size(),1,[&]() {
+            lv::nonMaxSuppression<3>(oFrame,oOutput);
+        });
+    }
+
+    void addSIMDBenchmarks(BenchContext& oCtx, const std::string& sSizeName, const cv::Mat& oFrame) {
+#if (HAVE_SSE2 || HAVE_NEON)
+        const size_t nChunks = oFrame.total()*oFrame.elemSize()/16;
+        const uchar* const anData = oFrame.data;
+        runBenchmark(oCtx,"hsum_16ub",sSizeName,oFrame.size(),oFrame.channels(),[&]() {
+            size_t nSum = 0;
+            for(size_t nChunkIdx=0; nChunkIdx<nChunks; ++nChunkIdx) {
+#if HAVE_SSE2
+                nSum += lv::hsum_16ub(_mm_loadu_si128((const __m128i*)(anData+nChunkIdx*16)));
+#else //HAVE_NEON
+                nSum += lv::hsum_16ub(vld1q_u8(anData+nChunkIdx*16));
+#endif //HAVE_NEON
+            }
+            g_nSink += nSum;
+        });
+#else //(!HAVE_SSE2 && !HAVE_NEON)
+        UNUSED(oCtx);
+        UNUSED(sSizeName);
+        UNUSED(oFrame);
+#endif //(!HAVE_SSE2 && !HAVE_NEON)
+    }
+
+    std::string getSIMDInstrSetName(lv::SIMDInstrSet eInstrSet) {
+        switch(eInstrSet) {
+            case lv::SIMD_AVX512BW: return "AVX512BW";
+            case lv::SIMD_AVX2: return "AVX2";
+            case lv::SIMD_SSE4_1: return "SSE4_1";
+            case lv::SIMD_SSE2: return "SSE2";
+            default: return "None";
+        }
+    }
+
+    std::string getCompilerName() {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc "+std::to_string(_MSC_VER);
+#else //!(defined(__clang__) || defined(__GNUC__) || defined(_MSC_VER))
+        return "unknown";
+#endif //!(defined(__clang__) || defined(__GNUC__) || defined(_MSC_VER))
+    }
+
+    std::string escapeJSON(const std::string& sInput) {
+        std::string sOutput;
+        for(char c : sInput) {
+            if(c=='"' || c=='\\')
+                sOutput += '\\';
+            if(c=='\n')
+                sOutput += "\\n";
+            else
+                sOutput += c;
+        }
+        return sOutput;
+    }
+
+    void writeJSON(const BenchContext& oCtx, const std::string& sOutputPath) {
+        std::ofstream oFile(sOutputPath);
+        lvAssert__(oFile.is_open(),"could not open output file at '%s'",sOutputPath.c_str());
+        oFile << "{\n  \"context\": {\n";
+        oFile << "    \"date\": \"" << escapeJSON(lv::getTimeStamp()) << "\",\n";
+        oFile << "    \"library_version\": \"" << escapeJSON(lv::getVersionStamp()) << "\",\n";
+        oFile << "    \"compiler\": \"" << escapeJSON(getCompilerName()) << "\",\n";
+        oFile << "    \"simd\": \"" << getSIMDInstrSetName(lv::getSupportedSIMDInstrSet()) << "\",\n";
+        oFile << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+        oFile << "    \"min_time\": " << oCtx.dMinTime_sec << "\n  },\n";
+        oFile << "  \"benchmarks\": [";
+        for(size_t nResultIdx=0; nResultIdx<oCtx.voResults.size(); ++nResultIdx) {
+            const BenchResult& oResult = oCtx.voResults[nResultIdx];
+            const double dTime_ns = oResult.dTimePerIter_sec*1e9;
+            oFile << (nResultIdx?",":"") << "\n    {\"name\": \"" << oResult.sName << "\", \"iterations\": " << oResult.nIterations;
+            oFile << ", \"real_time\": " << std::fixed << std::setprecision(1) << dTime_ns << ", \"cpu_time\": " << dTime_ns << ", \"time_unit\": \"ns\"";
+            oFile << ", \"width\": " << oResult.oFrameSize.width << ", \"height\": " << oResult.oFrameSize.height << ", \"channels\": " << oResult.nChannels;
+            oFile << ", \"items_per_second\": " << std::setprecision(0) << oResult.oFrameSize.area()/oResult.dTimePerIter_sec << "}";
+        }
+        oFile << "\n  ]\n}\n";
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        BenchContext oCtx;
+        std::string sOutputPath = "litiv_bench.json";
+        const std::vector<std::pair<std::string,cv::Size>> voAllSizes = {
+            {"QVGA",cv::Size(320,240)},
+            {"VGA",cv::Size(640,480)},
+            {"HD",cv::Size(1280,720)},
+            {"FHD",cv::Size(1920,1080)},
+            {"UHD",cv::Size(3840,2160)},
+        };
+        std::vector<std::pair<std::string,cv::Size>> voSizes = voAllSizes;
+        for(int nArgIdx=1; nArgIdx<argc; ++nArgIdx) {
+            const std::string sArg(argv[nArgIdx]);
+            if(sArg.compare(0,6,"--out=")==0)
+                sOutputPath = sArg.substr(6);
+            else if(sArg.compare(0,9,"--filter=")==0)
+                oCtx.sFilter = sArg.substr(9);
+            else if(sArg.compare(0,11,"--min-time=")==0)
+                oCtx.dMinTime_sec = std::stod(sArg.substr(11));
+            else if(sArg.compare(0,8,"--sizes=")==0) {
+                voSizes.clear();
+                const std::string sSizes = sArg.substr(8)+",";
+                for(size_t nBegin=0, nEnd; (nEnd=sSizes.find(',',nBegin))!=std::string::npos; nBegin=nEnd+1) {
+                    const std::string sSizeName = sSizes.substr(nBegin,nEnd-nBegin);
+                    auto pSize = std::find_if(voAllSizes.begin(),voAllSizes.end(),[&](const std::pair<std::string,cv::Size>& oSize){return oSize.first==sSizeName;});
+                    lvAssert__(pSize!=voAllSizes.end(),"unknown frame size name '%s'",sSizeName.c_str());
+                    voSizes.push_back(*pSize);
+                }
+            }
+            else
+                lvError_("unknown argument '%s'",sArg.c_str());
+        }
+        lvAssert_(oCtx.dMinTime_sec>0,"minimum time per benchmark must be positive");
+        std::cout << lv::getLogStamp() << "SIMD: " << getSIMDInstrSetName(lv::getSupportedSIMDInstrSet()) << ", compiler: " << getCompilerName() << "\n" << std::endl;
+        cv::theRNG().state = 1337; // all runs use the same input data
+        for(const auto& oSize : voSizes) {
+            std::array<cv::Mat,3> aoFramesA, aoFramesB;
+            const std::array<int,3> anChannels = {1,3,4};
+            for(size_t nIdx=0; nIdx<anChannels.size(); ++nIdx) {
+                aoFramesA[nIdx].create(oSize.second,CV_8UC(anChannels[nIdx]));
+                aoFramesB[nIdx].create(oSize.second,CV_8UC(anChannels[nIdx]));
+                cv::randu(aoFramesA[nIdx],0,256);
+                cv::randu(aoFramesB[nIdx],0,256);
+                // smooth a bit so that descriptors/distances are closer to what natural images produce
+                cv::GaussianBlur(aoFramesA[nIdx],aoFramesA[nIdx],cv::Size(5,5),0);
+                cv::GaussianBlur(aoFramesB[nIdx],aoFramesB[nIdx],cv::Size(5,5),0);
+            }
+            addDistanceBenchmarks<1>(oCtx,oSize.first,aoFramesA[0],aoFramesB[0]);
+            addDistanceBenchmarks<3>(oCtx,oSize.first,aoFramesA[1],aoFramesB[1]);
+            addDistanceBenchmarks<4>(oCtx,oSize.first,aoFramesA[2],aoFramesB[2]);
+            addPopcountBenchmarks<1>(oCtx,oSize.first,oSize.second);
+            addPopcountBenchmarks<3>(oCtx,oSize.first,oSize.second);
+            addPopcountBenchmarks<4>(oCtx,oSize.first,oSize.second);
+            addSIMDBenchmarks(oCtx,oSize.first,aoFramesA[1]);
+            addRandomBenchmarks(oCtx,oSize.first,oSize.second);
+            addLBSPPointBenchmarks<1>(oCtx,oSize.first,aoFramesA[0]);
+            addLBSPPointBenchmarks<3>(oCtx,oSize.first,aoFramesA[1]);
+            addLBSPPointBenchmarks<4>(oCtx,oSize.first,aoFramesA[2]);
+            addLBSPBatchBenchmarks<1>(oCtx,oSize.first,aoFramesA[0]);
+            addLBSPBatchBenchmarks<3>(oCtx,oSize.first,aoFramesA[1]);
+            addSampleModelBenchmarks<1>(oCtx,oSize.first,oSize.second);
+            addSampleModelBenchmarks<3>(oCtx,oSize.first,oSize.second);
+            addImgprocBenchmarks(oCtx,oSize.first,aoFramesA[0]);
+        }
+        writeJSON(oCtx,sOutputPath);
+        std::cout << "\nwrote " << oCtx.voResults.size() << " results to '" << sOutputPath << "'" << std::endl;
+    }
+    catch(const cv::Exception& e) {std::cout << "\n!!!!!!!!!!!!!!\nTop level caught cv::Exception:\n" << e.what() << "\n!!!!!!!!!!!!!!\n" << std::endl; return 1;}
+    catch(const std::exception& e) {std::cout << "\n!!!!!!!!!!!!!!\nTop level caught std::exception:\n" << e.what() << "\n!!!!!!!!!!!!!!\n" << std::endl; return 1;}
+    catch(...) {std::cout << "\n!!!!!!!!!!!!!!\nTop level caught unhandled exception\n!!!!!!!!!!!!!!\n" << std::endl; return 1;}
+    return 0;
+}
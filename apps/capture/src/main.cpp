@@ -25,15 +25,51 @@
 /////////////////////////////////
 #define DISPLAY_OUTPUT          0
 #define WRITE_OUTPUT            1
+#define USE_HW_COLOR_ENCODING   1 // requests hardware-accelerated (e.g. NVENC/QSV) h264 encoding for the color stream (only available w/ opencv >= 4.5.2)
+#define USE_RECORDING_CONTAINER 1 // writes all kinect streams as timestamped chunks in a single indexed recording (replayable via lv::Dataset_Recordings) instead of one video per stream
 /////////////////////////////////
 #define DEFAULT_QUEUE_BUFFER_SIZE   1024*1024*50  // max = 50MB per queue (default)
 #define HIGHDEF_QUEUE_BUFFER_SIZE   1024*1024*1024 // max = 1GB per queue (high-defition stream)
+#define CAPTURE_POOL_SLOT_COUNT     90 // preallocated frames per kinect stream (3 seconds of buffering at 30 fps; ~560MB for 1080p color)
 #define VIDEO_FILE_PREALLOC_SIZE    1024*1024*1024 // tot = 1GB per video file
 #define STRUCT_FILE_PREALLOC_SIZE   1024*1024*20 // tot = 200MB per struct file
+#define RECORDING_FILE_PATH         "e:/temp/test" RECORDING_FILE_SUFFIX
+#define RECORDING_PREALLOC_SIZE     1024LL*1024*1024*4 // tot = 4GB for the recording container (grown past that as needed)
+#define RECORDING_COLOR_WORKER_COUNT 2 // jpeg encoders for the color stream (chunks may be appended out of order, the reader sorts them back by frame index)
+#define CAPTURE_TIMESTAMP_RING_SIZE 256 // latest multi-frame timestamps kept for the writers (must exceed the pool slot count, i.e. the max number of frames in flight)
 /////////////////////////////////
 
 std::atomic_bool g_bIsActive = true;
 
+namespace {
+
+    /// returns the frame size advertised by a kinect frame source
+    template<typename TFrameSource>
+    cv::Size getFrameSize(TFrameSource* pFrameSource) {
+        CComPtr<IFrameDescription> pFrameDesc;
+        lvAssertHR(pFrameSource->get_FrameDescription(&pFrameDesc));
+        int nFrameHeight,nFrameWidth;
+        lvAssertHR(pFrameDesc->get_Height(&nFrameHeight));
+        lvAssertHR(pFrameDesc->get_Width(&nFrameWidth));
+        return cv::Size(nFrameWidth,nFrameHeight);
+    }
+
+    /// opens a video writer, using hardware-accelerated encoding if requested and available (falls back to the default codec otherwise)
+    void openVideoWriter(cv::VideoWriter& oWriter, const std::string& sFilePath, const cv::Size& oSize, bool bIsColor, bool bUseHWAccel) {
+#if CV_VERSION_MAJOR>4 || (CV_VERSION_MAJOR==4 && (CV_VERSION_MINOR>5 || (CV_VERSION_MINOR==5 && CV_VERSION_REVISION>=2)))
+        if(bUseHWAccel && oWriter.open(sFilePath,cv::CAP_ANY,cv::VideoWriter::fourcc('H','2','6','4'),30.0,oSize,{cv::VIDEOWRITER_PROP_HW_ACCELERATION,cv::VIDEO_ACCELERATION_ANY,cv::VIDEOWRITER_PROP_IS_COLOR,(int)bIsColor})) {
+            std::cout << "\t(using hardware-accelerated encoding)" << std::endl;
+            return;
+        }
+#else //(CV_VERSION < 4.5.2)
+        UNUSED(bUseHWAccel);
+#endif //(CV_VERSION < 4.5.2)
+        oWriter.open(sFilePath,-1,30.0,oSize,bIsColor);
+        lvAssert(oWriter.isOpened());
+    }
+
+} // namespace
+
 int main() {
     try {
         lv::RegisterAllConsoleSignals([](int){g_bIsActive = false;});
@@ -65,7 +101,7 @@ int main() {
         cv::VideoWriter oFLIRVideoWriter("c:/temp/test_flir.avi",-1,30.0,cv::Size(320,240),false);
         lvAssert(oFLIRVideoWriter.isOpened());
         lv::DataWriter oFLIRVideoAsyncWriter(std::bind(lEncodeAndSaveFrame,std::placeholders::_1,std::placeholders::_2,oFLIRVideoWriter,nLastSavedFLIRFrameIdx));
-        lvAssert(oFLIRVideoAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true));
+        lvAssert(oFLIRVideoAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true,1,true));
 #endif //WRITE_OUTPUT
 #endif //USE_FLIR_SENSOR
         std::cout << "Setting up Kinect device..." << std::endl;
@@ -77,46 +113,106 @@ int main() {
         lvAssertHR(pKinectSensor->OpenMultiSourceFrameReader(FrameSourceTypes_Color|FrameSourceTypes_Depth|FrameSourceTypes_Infrared|FrameSourceTypes_Body|FrameSourceTypes_BodyIndex,&pMultiFrameReader));
         constexpr size_t nStreamCount = 5;
         lv::KinectBodyFrame oBodyFrame;
-        const cv::Mat oBodyFrameWrapper(1,(int)sizeof(lv::KinectBodyFrame),CV_8UC1,&oBodyFrame);
-        cv::Mat oBodyIdxFrame,oNIRFrame,oDepthFrame,oColorFrame;
+        const cv::Size oBodyFrameSize((int)sizeof(lv::KinectBodyFrame),1);
+        // image streams are copied by the SDK straight into pooled frames, which are then handed over to the writers without cloning
+        CComPtr<IBodyIndexFrameSource> pBodyIdxFrameSource;
+        lvAssertHR(pKinectSensor->get_BodyIndexFrameSource(&pBodyIdxFrameSource));
+        CComPtr<IInfraredFrameSource> pNIRFrameSource;
+        lvAssertHR(pKinectSensor->get_InfraredFrameSource(&pNIRFrameSource));
+        CComPtr<IDepthFrameSource> pDepthFrameSource;
+        lvAssertHR(pKinectSensor->get_DepthFrameSource(&pDepthFrameSource));
+        CComPtr<IColorFrameSource> pColorFrameSource;
+        lvAssertHR(pKinectSensor->get_ColorFrameSource(&pColorFrameSource));
+        const cv::Size oBodyIdxFrameSize = getFrameSize(pBodyIdxFrameSource.p);
+        const cv::Size oNIRFrameSize = getFrameSize(pNIRFrameSource.p);
+        const cv::Size oDepthFrameSize = getFrameSize(pDepthFrameSource.p);
+        const cv::Size oColorFrameSize = getFrameSize(pColorFrameSource.p);
+        lv::PacketPool oBodyFramePool(CAPTURE_POOL_SLOT_COUNT,oBodyFrameSize,CV_8UC1);
+        lv::PacketPool oBodyIdxFramePool(CAPTURE_POOL_SLOT_COUNT,oBodyIdxFrameSize,CV_8UC1);
+        lv::PacketPool oNIRFramePool(CAPTURE_POOL_SLOT_COUNT,oNIRFrameSize,CV_16UC1);
+        lv::PacketPool oDepthFramePool(CAPTURE_POOL_SLOT_COUNT,oDepthFrameSize,CV_16UC1);
+        lv::PacketPool oColorFramePool(CAPTURE_POOL_SLOT_COUNT,oColorFrameSize,CV_8UC3);
+        cv::Mat oBodyFramePacket,oBodyIdxFrame,oNIRFrame,oDepthFrame,oColorFrame;
 #if WRITE_OUTPUT
+#if USE_RECORDING_CONTAINER
+        static_assert(CAPTURE_TIMESTAMP_RING_SIZE>=CAPTURE_POOL_SLOT_COUNT,"writers may lag by a full pool, so the timestamp ring must be at least as large");
+        std::cout << "Setting up Kinect recording container..." << std::endl;
+        enum {eBodyStream,eBodyIdxStream,eNIRStream,eDepthStream,eColorStream};
+        lv::RecordingWriter oRecorder(RECORDING_FILE_PATH,{
+            {"body",oBodyFrameSize,CV_8UC1,lv::RecordingCodec_Raw},
+            {"bodyidx",oBodyIdxFrameSize,CV_8UC1,lv::RecordingCodec_Delta},
+            {"nir",oNIRFrameSize,CV_16UC1,lv::RecordingCodec_Delta},
+            {"depth",oDepthFrameSize,CV_16UC1,lv::RecordingCodec_Delta},
+            {"color",oColorFrameSize,CV_8UC3,lv::RecordingCodec_JPEG},
+        },size_t(RECORDING_PREALLOC_SIZE));
+        // timestamps are kept per accepted multi-frame (not per frame index, as dropped frames leave gaps), and looked up by the writers
+        std::array<std::pair<size_t,int64_t>,CAPTURE_TIMESTAMP_RING_SIZE> aFrameTimestamps;
+        aFrameTimestamps.fill(std::make_pair(SIZE_MAX,int64_t(0)));
+        size_t nAcceptedFrameCount = 0;
+        std::mutex oFrameTimestampsMutex;
+        const auto oCaptureStartTime = std::chrono::steady_clock::now();
+        const auto lRecordPacket = [&](const cv::Mat& oPacket, size_t nIndex, size_t nStreamIdx) {
+            int64_t nTimestamp = -1;
+            {
+                std::mutex_lock_guard oLock(oFrameTimestampsMutex);
+                for(const auto& oEntry : aFrameTimestamps)
+                    if(oEntry.first==nIndex)
+                        nTimestamp = oEntry.second;
+            }
+            lvAssert_(nTimestamp>=0,"could not find the capture timestamp of a queued frame");
+            oRecorder.write(nStreamIdx,nIndex,nTimestamp,oPacket);
+            return (size_t)0;
+        };
+        lv::DataWriter oBodyStructAsyncWriter(std::bind(lRecordPacket,std::placeholders::_1,std::placeholders::_2,size_t(eBodyStream)));
+        lvAssert(oBodyStructAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true,1,true));
+        lv::DataWriter oBodyIdxVideoAsyncWriter(std::bind(lRecordPacket,std::placeholders::_1,std::placeholders::_2,size_t(eBodyIdxStream)));
+        lvAssert(oBodyIdxVideoAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true,1,true));
+        lv::DataWriter oNIRVideoAsyncWriter(std::bind(lRecordPacket,std::placeholders::_1,std::placeholders::_2,size_t(eNIRStream)));
+        lvAssert(oNIRVideoAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true,1,true));
+        lv::DataWriter oDepthVideoAsyncWriter(std::bind(lRecordPacket,std::placeholders::_1,std::placeholders::_2,size_t(eDepthStream)));
+        lvAssert(oDepthVideoAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true,1,true));
+        lv::DataWriter oColorVideoAsyncWriter(std::bind(lRecordPacket,std::placeholders::_1,std::placeholders::_2,size_t(eColorStream)));
+        lvAssert(oColorVideoAsyncWriter.startAsyncWriting(HIGHDEF_QUEUE_BUFFER_SIZE,true,RECORDING_COLOR_WORKER_COUNT,false));
+#else //!USE_RECORDING_CONTAINER
         std::cout << "Setting up Kinect body data writer..." << std::endl;
         size_t nLastSavedBodyFrameIdx = SIZE_MAX;
         std::ofstream oBodyStructWriter("c:/temp/test_body.bin",std::ios::out|std::ios::binary);
         lvAssert(oBodyStructWriter && oBodyStructWriter.is_open());
         lv::DataWriter oBodyStructAsyncWriter(std::bind(lEncodeAndSaveBodyFrame,std::placeholders::_1,std::placeholders::_2,&oBodyStructWriter,nLastSavedBodyFrameIdx));
-        lvAssert(oBodyStructAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true));
+        lvAssert(oBodyStructAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true,1,true));
         std::cout << "Setting up BODYINDEX video writer..." << std::endl;
         size_t nLastSavedBodyIdxFrameIdx = SIZE_MAX;
-        cv::VideoWriter oBodyIdxVideoWriter("c:/temp/test_bodyidx.avi",-1,30.0,cv::Size(512,424),false);
-        lvAssert(oBodyIdxVideoWriter.isOpened());
+        cv::VideoWriter oBodyIdxVideoWriter;
+        openVideoWriter(oBodyIdxVideoWriter,"c:/temp/test_bodyidx.avi",oBodyIdxFrameSize,false,false);
         lv::DataWriter oBodyIdxVideoAsyncWriter(std::bind(lEncodeAndSaveFrame,std::placeholders::_1,std::placeholders::_2,oBodyIdxVideoWriter,nLastSavedBodyIdxFrameIdx));
-        lvAssert(oBodyIdxVideoAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true));
+        lvAssert(oBodyIdxVideoAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true,1,true));
         std::cout << "Setting up NIR video writer..." << std::endl;
         size_t nLastSavedNIRFrameIdx = SIZE_MAX;
-        cv::VideoWriter oNIRVideoWriter("c:/temp/test_nir.avi",-1,30.0,cv::Size(512,424),false);
-        lvAssert(oNIRVideoWriter.isOpened());
+        cv::VideoWriter oNIRVideoWriter;
+        openVideoWriter(oNIRVideoWriter,"c:/temp/test_nir.avi",oNIRFrameSize,false,false);
         lv::DataWriter oNIRVideoAsyncWriter(std::bind(lEncodeAndSaveFrame,std::placeholders::_1,std::placeholders::_2,oNIRVideoWriter,nLastSavedNIRFrameIdx));
-        lvAssert(oNIRVideoAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true));
+        lvAssert(oNIRVideoAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true,1,true));
         std::cout << "Setting up DEPTH video writer..." << std::endl;
         size_t nLastSavedDepthFrameIdx = SIZE_MAX;
-        cv::VideoWriter oDepthVideoWriter("c:/temp/test_depth.avi",-1,30.0,cv::Size(512,424),false);
-        lvAssert(oDepthVideoWriter.isOpened());
+        cv::VideoWriter oDepthVideoWriter;
+        openVideoWriter(oDepthVideoWriter,"c:/temp/test_depth.avi",oDepthFrameSize,false,false);
         lv::DataWriter oDepthVideoAsyncWriter(std::bind(lEncodeAndSaveFrame,std::placeholders::_1,std::placeholders::_2,oDepthVideoWriter,nLastSavedDepthFrameIdx));
-        lvAssert(oDepthVideoAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true));
+        lvAssert(oDepthVideoAsyncWriter.startAsyncWriting(DEFAULT_QUEUE_BUFFER_SIZE,true,1,true));
         std::cout << "Setting up COLOR video writer..." << std::endl;
         size_t nLastSavedColorFrameIdx = SIZE_MAX;
         const std::string sColorVideoFilePath = "e:/temp/test_color.avi";
         lvAssert(lv::CreateBinFileWithPrealloc(sColorVideoFilePath,VIDEO_FILE_PREALLOC_SIZE));
-        cv::VideoWriter oColorVideoWriter(sColorVideoFilePath,-1,30.0,cv::Size(1920,1080),true);
-        lvAssert(oColorVideoWriter.isOpened());
+        cv::VideoWriter oColorVideoWriter;
+        openVideoWriter(oColorVideoWriter,sColorVideoFilePath,oColorFrameSize,true,bool(USE_HW_COLOR_ENCODING));
         lv::DataWriter oColorVideoAsyncWriter(std::bind(lEncodeAndSaveFrame,std::placeholders::_1,std::placeholders::_2,oColorVideoWriter,nLastSavedColorFrameIdx));
-        lvAssert(oColorVideoAsyncWriter.startAsyncWriting(HIGHDEF_QUEUE_BUFFER_SIZE,true));
+        lvAssert(oColorVideoAsyncWriter.startAsyncWriting(HIGHDEF_QUEUE_BUFFER_SIZE,true,1,true));
+#endif //!USE_RECORDING_CONTAINER
 #endif //WRITE_OUTPUT
 
         CComPtr<IMultiSourceFrame> pMultiFrame;
         lv::WorkerPool<nStreamCount> oPool;
-        std::array<std::future<bool>,nStreamCount> abGrabResults;
+        std::array<bool,nStreamCount> abGrabResults;
+        lv::CountdownLatch oGrabLatch;
         const std::array<std::function<bool()>,nStreamCount> alGrabTasks = {
             [&]{
                 CComPtr<IBodyFrameReference> pFrameRef;
@@ -156,14 +252,6 @@ int main() {
                 const bool bGotFrame = SUCCEEDED(pFrameRef->AcquireFrame(&pFrame));
                 if(bGotFrame) {
                     pFrameRef.Release();
-                    if(oBodyIdxFrame.empty()) {
-                        CComPtr<IFrameDescription> pFrameDesc;
-                        lvAssertHR(pFrame->get_FrameDescription(&pFrameDesc));
-                        int nFrameHeight,nFrameWidth;
-                        lvAssertHR(pFrameDesc->get_Height(&nFrameHeight));
-                        lvAssertHR(pFrameDesc->get_Width(&nFrameWidth));
-                        oBodyIdxFrame.create(nFrameHeight,nFrameWidth,CV_8UC1);
-                    }
                     lvAssertHR(pFrame->CopyFrameDataToArray((UINT)oBodyIdxFrame.total(),oBodyIdxFrame.data));
                 }
                 return bGotFrame;
@@ -175,14 +263,6 @@ int main() {
                 const bool bGotFrame = SUCCEEDED(pFrameRef->AcquireFrame(&pFrame));
                 if(bGotFrame) {
                     pFrameRef.Release();
-                    if(oNIRFrame.empty()) {
-                        CComPtr<IFrameDescription> pFrameDesc;
-                        lvAssertHR(pFrame->get_FrameDescription(&pFrameDesc));
-                        int nFrameHeight,nFrameWidth;
-                        lvAssertHR(pFrameDesc->get_Height(&nFrameHeight));
-                        lvAssertHR(pFrameDesc->get_Width(&nFrameWidth));
-                        oNIRFrame.create(nFrameHeight,nFrameWidth,CV_16UC1);
-                    }
                     lvAssertHR(pFrame->CopyFrameDataToArray((UINT)oNIRFrame.total(),(uint16_t*)oNIRFrame.data));
                 }
                 return bGotFrame;
@@ -194,14 +274,6 @@ int main() {
                 const bool bGotFrame = SUCCEEDED(pFrameRef->AcquireFrame(&pFrame));
                 if(bGotFrame) {
                     pFrameRef.Release();
-                    if(oDepthFrame.empty()) {
-                        CComPtr<IFrameDescription> pFrameDesc;
-                        lvAssertHR(pFrame->get_FrameDescription(&pFrameDesc));
-                        int nFrameHeight,nFrameWidth;
-                        lvAssertHR(pFrameDesc->get_Height(&nFrameHeight));
-                        lvAssertHR(pFrameDesc->get_Width(&nFrameWidth));
-                        oDepthFrame.create(nFrameHeight,nFrameWidth,CV_16UC1);
-                    }
                     lvAssertHR(pFrame->CopyFrameDataToArray((UINT)oDepthFrame.total(),(uint16_t*)oDepthFrame.data));
                 }
                 return bGotFrame;
@@ -213,24 +285,16 @@ int main() {
                 const bool bGotFrame = SUCCEEDED(pFrameRef->AcquireFrame(&pFrame));
                 if(bGotFrame) {
                     pFrameRef.Release();
-                    if(oColorFrame.empty()) {
-                        //ColorImageFormat eColorFormat;
-                        //lvAssertHR(pFrame->get_RawColorImageFormat(&eColorFormat));
-                        //CComPtr<IColorCameraSettings> pColorCameraSettings;
-                        //lvAssertHR(pFrame->get_ColorCameraSettings(&pColorCameraSettings));
-                        CComPtr<IFrameDescription> pFrameDesc;
-                        lvAssertHR(pFrame->get_FrameDescription(&pFrameDesc));
-                        int nFrameHeight,nFrameWidth;
-                        lvAssertHR(pFrameDesc->get_Height(&nFrameHeight));
-                        lvAssertHR(pFrameDesc->get_Width(&nFrameWidth));
-                        oColorFrame.create(nFrameHeight,nFrameWidth,CV_8UC3);
-                    }
+                    //ColorImageFormat eColorFormat;
+                    //lvAssertHR(pFrame->get_RawColorImageFormat(&eColorFormat));
+                    //CComPtr<IColorCameraSettings> pColorCameraSettings;
+                    //lvAssertHR(pFrame->get_ColorCameraSettings(&pColorCameraSettings));
                     UINT nBufferSize;
                     BYTE* pBuffer;
                     lvAssertHR(pFrame->AccessRawUnderlyingBuffer(&nBufferSize,&pBuffer));
                     const cv::Mat oRawColorFrame(oColorFrame.size(),CV_8UC2,pBuffer);
                     lvAssert(nBufferSize<=oRawColorFrame.total()*oRawColorFrame.elemSize());
-                    cv::cvtColor(oRawColorFrame,oColorFrame,cv::COLOR_YUV2BGR_YUY2);
+                    cv::cvtColor(oRawColorFrame,oColorFrame,cv::COLOR_YUV2BGR_YUY2); // converted straight into the pooled frame
                 }
                 return bGotFrame;
             },
@@ -242,14 +306,31 @@ int main() {
         while(g_bIsActive) {
             pMultiFrame.Release();
             while(!SUCCEEDED(pMultiFrameReader->AcquireLatestFrame(&pMultiFrame)));
-            for(size_t n=0; n<alGrabTasks.size(); ++n)
-                abGrabResults[n] = oPool.queueTask(alGrabTasks[n]);
+            // all pooled frames are claimed up front; if the writers lag behind, the whole multi-frame is dropped before anything gets copied
+            const bool bGotFreeFrames = oColorFramePool.acquire(oColorFrame) && oDepthFramePool.acquire(oDepthFrame) &&
+                                        oNIRFramePool.acquire(oNIRFrame) && oBodyIdxFramePool.acquire(oBodyIdxFrame) &&
+                                        oBodyFramePool.acquire(oBodyFramePacket);
+#if WRITE_OUTPUT && USE_RECORDING_CONTAINER
+            if(bGotFreeFrames) {
+                // all streams of a multi-frame share the same timestamp, taken when it is acquired
+                const int64_t nTimestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-oCaptureStartTime).count();
+                std::mutex_lock_guard oLock(oFrameTimestampsMutex);
+                aFrameTimestamps[(nAcceptedFrameCount++)%CAPTURE_TIMESTAMP_RING_SIZE] = std::make_pair(nRealFrameIdx,nTimestamp);
+            }
+#endif //WRITE_OUTPUT && USE_RECORDING_CONTAINER
+            bool bFinalGrabResult = bGotFreeFrames;
+            if(bGotFreeFrames) {
+                const auto lGrabTask = [&](size_t n) {abGrabResults[n] = alGrabTasks[n]();};
+                oPool.submitBulk(alGrabTasks.size(),lGrabTask,oGrabLatch);
 #if USE_FLIR_SENSOR
-            pFLIRSensor->GetLatestFrame(oFLIRFrame,true);
+                pFLIRSensor->GetLatestFrame(oFLIRFrame,true);
 #endif //USE_FLIR_SENSOR
-            bool bFinalGrabResult = true;
-            for(size_t n=0; n<abGrabResults.size(); ++n)
-                bFinalGrabResult &= abGrabResults[n].get();
+                oGrabLatch.wait();
+                for(size_t n=0; n<abGrabResults.size(); ++n)
+                    bFinalGrabResult &= abGrabResults[n];
+            }
+            else
+                std::cout << "The capture pools are full, dropping frames!" << std::endl;
             if(bFinalGrabResult) {
 #if DISPLAY_OUTPUT
 #if USE_FLIR_SENSOR
@@ -269,15 +350,18 @@ int main() {
                     break;
 #endif //DISPLAY_OUTPUT
 #if WRITE_OUTPUT
-                if(oColorVideoAsyncWriter.queue(oColorFrame,nRealFrameIdx)!=SIZE_MAX) {
+                // pooled frames are queued by ownership transfer (no copies); only the small flir packets are still cloned
+                oBodyFrame.nFrameIdx = nRealFrameIdx;
+                std::copy_n((const uchar*)&oBodyFrame,sizeof(oBodyFrame),oBodyFramePacket.data);
+                if(oColorVideoAsyncWriter.queue(std::move(oColorFrame),nRealFrameIdx)!=SIZE_MAX) {
                     // color queue is the only one might really overflow, so other queues depend only on that one
 #if USE_FLIR_SENSOR
                     lvAssert(oFLIRVideoAsyncWriter.queue(oFLIRFrame,nRealFrameIdx)!=SIZE_MAX);
 #endif //USE_FLIR_SENSOR
-                    lvAssert(oBodyStructAsyncWriter.queue(oBodyFrameWrapper,nRealFrameIdx)!=SIZE_MAX);
-                    lvAssert(oBodyIdxVideoAsyncWriter.queue(oBodyIdxFrame,nRealFrameIdx)!=SIZE_MAX);
-                    lvAssert(oNIRVideoAsyncWriter.queue(oNIRFrame,nRealFrameIdx)!=SIZE_MAX);
-                    lvAssert(oDepthVideoAsyncWriter.queue(oDepthFrame,nRealFrameIdx)!=SIZE_MAX);
+                    lvAssert(oBodyStructAsyncWriter.queue(std::move(oBodyFramePacket),nRealFrameIdx)!=SIZE_MAX);
+                    lvAssert(oBodyIdxVideoAsyncWriter.queue(std::move(oBodyIdxFrame),nRealFrameIdx)!=SIZE_MAX);
+                    lvAssert(oNIRVideoAsyncWriter.queue(std::move(oNIRFrame),nRealFrameIdx)!=SIZE_MAX);
+                    lvAssert(oDepthVideoAsyncWriter.queue(std::move(oDepthFrame),nRealFrameIdx)!=SIZE_MAX);
                     ++nGoodFrameIdx;
                 }
                 else
@@ -20,7 +20,36 @@
 // @@@ support non-integer textures top level (alg)? need to replace all ui-stores by float-stores, rest is ok
 
 #include "litiv/datasets.hpp"
+#include "litiv/utils/console.hpp"
 #include "litiv/video.hpp"
+#include "litiv/video/BackgroundSubtractorViBe.hpp"
+#include "litiv/video/BackgroundSubtractorPBAS.hpp"
+
+// usage: changedet [--benchmark [--algos=LOBSTER,SuBSENSE,PAWCS,ViBe,PBAS] [--batches=3] [--frames=300] [--warmup=50] [--out=changedet_bench.json]]
+//
+//        changedet --sweep[=sweep.yml] [--algo=SuBSENSE] [--param=nMinColorDistThreshold:20,30,40 ...] [--batches=0] [--threads=0] [--out=changedet_sweep.yml]
+//        changedet --evaluate-only [--threads=0]
+//
+// in benchmark mode, the display/output/evaluation switches below are ignored: each cpu algorithm runs alone (single thread) on the
+// same dataset subset (the first frames of the first batches), only its 'apply' calls are timed, and results are written as JSON
+//
+// in evaluation-only mode, no algorithm is run: the outputs saved by a previous run (in the dataset output directory) are loaded back and
+// evaluated in parallel across batches and frames, and reports are rewritten (useful after a gt fix or a metrics change)
+//
+// in sweep mode, the compile-time switches below are also ignored: a cpu algorithm is instantiated at runtime for every combination
+// of the listed constructor parameter values (Cartesian product; unlisted parameters keep their defaults), and all combinations run
+// in lockstep on the same frames, so each frame of the (shared) dataset is decoded only once for the whole sweep; the pooled binary
+// classification metrics of each combination are then written as YAML. Sweep config files use the following layout (all optional,
+// command line arguments override them):
+//
+//     %YAML:1.0
+//     algo: SuBSENSE
+//     max_batches: 0 # 0 = all batches
+//     threads: 0 # 0 = one per hardware thread
+//     output: changedet_sweep.yml
+//     params:
+//        nMinColorDistThreshold: [ 20, 30, 40 ]
+//        fRelLBSPThreshold: [ 0.25, 0.333 ]
 
 ////////////////////////////////
 #define WRITE_IMG_OUTPUT        0
@@ -39,6 +68,12 @@
 #define DATASET_OUTPUT_PATH     "results_test" // will be created in the app's working directory if using a custom dataset
 #define DATASET_PRECACHING      1
 #define DATASET_SCALE_FACTOR    1.0
+#define GPU_WORKERS_PER_DEVICE  1
+#define PIPELINE_QUEUE_SIZE     8 // max number of packets buffered between two pipeline stages (cpu impl only)
+#define PIPELINE_SPIN_WAIT      0 // if enabled, pipeline stages busy-wait on their queues instead of sleeping (lower handoff latency, but burns one core per stage)
+#define CHECKPOINT_PERIOD       0 // number of packets between two work batch checkpoints, used to resume interrupted runs (0 = disabled, cpu impl only)
+#define TRACE_PACKET_LATENCY    0 // writes per-stage packet latency histograms to 'latency.txt' in each work batch output folder (cpu impl only)
+#define TRACK_MEMORY_USAGE      0 // attributes all new cv::Mat allocations to their owner (algo instance, precacher, writer), and prints a per-owner report at the end (cpu impl only)
 ////////////////////////////////
 #define USE_GPU_IMPL (USE_GLSL_IMPL||USE_CUDA_IMPL||USE_OPENCL_IMPL)
 #if (USE_GLSL_IMPL+USE_CUDA_IMPL+USE_OPENCL_IMPL)>1
@@ -51,7 +86,7 @@
 #endif //ndef(EXTERNAL_DATA_ROOT)
 #ifndef DATASET_ID
 #define DATASET_ID Dataset_Custom
-#define DATASET_PARAMS \
+#define DATASET_PARAMS(bSaveOutput,bUseEvaluator,bForce4ByteDataAlign) \
     "@@@@",                                                      /* => const std::string& sDatasetName */ \
     "@@@@",                                                      /* => const std::string& sDatasetDirPath */ \
     DATASET_OUTPUT_PATH,                                         /* => const std::string& sOutputDirPath */ \
@@ -61,19 +96,19 @@
     std::vector<std::string>{"@@@","@@@","@@@","..."},           /* => const std::vector<std::string>& vsSkippedDirTokens */ \
     std::vector<std::string>{"@@@","@@@","@@@","..."},           /* => const std::vector<std::string>& vsGrayscaleDirTokens */ \
     0,                                                           /* => size_t nOutputIdxOffset */ \
-    bool(WRITE_IMG_OUTPUT),                                      /* => bool bSaveOutput */ \
-    bool(EVALUATE_OUTPUT),                                       /* => bool bUseEvaluator */ \
-    bool(USE_GPU_IMPL),                                          /* => bool bForce4ByteDataAlign */ \
+    bSaveOutput,                                                 /* => bool bSaveOutput */ \
+    bUseEvaluator,                                               /* => bool bUseEvaluator */ \
+    bForce4ByteDataAlign,                                        /* => bool bForce4ByteDataAlign */ \
     DATASET_SCALE_FACTOR                                         /* => double dScaleFactor */
 #else //defined(DATASET_ID)
-#define DATASET_PARAMS \
+#define DATASET_PARAMS(bSaveOutput,bUseEvaluator,bForce4ByteDataAlign) \
     DATASET_OUTPUT_PATH,                                         /* => const std::string& sOutputDirName */ \
-    bool(WRITE_IMG_OUTPUT),                                      /* => bool bSaveOutput */ \
-    bool(EVALUATE_OUTPUT),                                       /* => bool bUseEvaluator */ \
-    bool(USE_GPU_IMPL),                                          /* => bool bForce4ByteDataAlign */ \
+    bSaveOutput,                                                 /* => bool bSaveOutput */ \
+    bUseEvaluator,                                               /* => bool bUseEvaluator */ \
+    bForce4ByteDataAlign,                                        /* => bool bForce4ByteDataAlign */ \
     DATASET_SCALE_FACTOR                                         /* => double dScaleFactor */
 #endif //defined(DATASET_ID)
-void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch);
+void Analyze(int nThreadIdx, size_t nDeviceIdx, lv::IDataHandlerPtr pBatch);
 #if USE_GLSL_IMPL
 constexpr lv::ParallelAlgoType eImplTypeEnum = lv::GLSL;
 #else // USE_..._IMPL
@@ -87,47 +122,477 @@ using BackgroundSubtractorType = BackgroundSubtractorSuBSENSE_<eImplTypeEnum>;
 #elif USE_PAWCS
 using BackgroundSubtractorType = BackgroundSubtractorPAWCS_<eImplTypeEnum>;
 #endif //USE_...
-std::atomic_size_t g_nActiveThreads(0);
 const size_t g_nMaxThreads = USE_GPU_IMPL?1:std::thread::hardware_concurrency()>0?std::thread::hardware_concurrency():DEFAULT_NB_THREADS;
 
-int main(int, char**) {
+namespace {
+
+    struct BenchmarkParams {
+        std::vector<std::string> vsAlgoNames = {"LOBSTER","SuBSENSE","PAWCS","ViBe","PBAS"};
+        size_t nMaxBatches = 3;
+        size_t nMaxFrames = 300;
+        size_t nWarmupFrames = 50;
+        std::string sOutputPath = "changedet_bench.json";
+    };
+
+    struct BenchmarkResult {
+        std::string sAlgoName;
+        size_t nFrames;
+        double dFramesPerSec;
+        double dLatencyP50_ms, dLatencyP99_ms;
+        size_t nPeakRSS;
+    };
+
+    /// runtime-selected cpu background subtraction algorithm (the ViBe/PBAS impls do not derive from IIBackgroundSubtractor)
+    struct BenchmarkAlgo {
+        std::shared_ptr<cv::BackgroundSubtractor> pAlgo;
+        std::function<void(const cv::Mat&,const cv::Mat&)> lInit;
+        double dInitLearningRate, dLearningRate; // the init rate is used for the first 100 frames, as in the regular analysis loop
+    };
+
+    template<typename TAlgo, typename... TArgs>
+    BenchmarkAlgo createLBSPBenchmarkAlgo(TArgs... args) {
+        std::shared_ptr<TAlgo> pAlgo = std::make_shared<TAlgo>(args...);
+        return BenchmarkAlgo{pAlgo,[pAlgo](const cv::Mat& oInitImg, const cv::Mat& oROI){pAlgo->initialize(oInitImg,oROI);},1.0,pAlgo->getDefaultLearningRate()};
+    }
+
+    template<typename TAlgo, typename TAlgo1ch, typename TAlgo3ch, typename... TArgs>
+    BenchmarkAlgo createSampleBenchmarkAlgo(int nChannels, double dLearningRate, TArgs... args) {
+        lvAssert_(nChannels==1 || nChannels==3,"unsupported input channel count");
+        std::shared_ptr<TAlgo> pAlgo;
+        if(nChannels==1)
+            pAlgo = std::make_shared<TAlgo1ch>(args...);
+        else
+            pAlgo = std::make_shared<TAlgo3ch>(args...);
+        return BenchmarkAlgo{pAlgo,[pAlgo](const cv::Mat& oInitImg, const cv::Mat&){pAlgo->initialize(oInitImg);},dLearningRate,dLearningRate};
+    }
+
+    /// runtime description of a cpu algorithm: constructor parameter names (in declaration order) with their default values, and factory
+    struct AlgoDesc {
+        std::string sName;
+        std::vector<std::pair<std::string,double>> vParamDefaults;
+        std::function<BenchmarkAlgo(const std::vector<double>& /*vdParams*/, int /*nChannels*/)> lCreate;
+    };
+
+    const std::vector<AlgoDesc>& getAlgoDescs() {
+        static const std::vector<AlgoDesc> s_voAlgoDescs = {
+            {"LOBSTER",{{"nDescDistThreshold",BGSLOBSTER_DEFAULT_DESC_DIST_THRESHOLD},{"nColorDistThreshold",BGSLOBSTER_DEFAULT_COLOR_DIST_THRESHOLD},
+                        {"nBGSamples",BGSLOBSTER_DEFAULT_NB_BG_SAMPLES},{"nRequiredBGSamples",BGSLOBSTER_DEFAULT_REQUIRED_NB_BG_SAMPLES},
+                        {"nLBSPThresholdOffset",BGSLBSP_DEFAULT_LBSP_OFFSET_SIMILARITY_THRESHOLD},{"fRelLBSPThreshold",BGSLBSP_DEFAULT_LBSP_REL_SIMILARITY_THRESHOLD}},
+             [](const std::vector<double>& v, int) {
+                return createLBSPBenchmarkAlgo<BackgroundSubtractorLOBSTER>((size_t)v[0],(size_t)v[1],(size_t)v[2],(size_t)v[3],(size_t)v[4],(float)v[5]);
+             }},
+            {"SuBSENSE",{{"nDescDistThresholdOffset",BGSSUBSENSE_DEFAULT_DESC_DIST_THRESHOLD_OFFSET},{"nMinColorDistThreshold",BGSSUBSENSE_DEFAULT_MIN_COLOR_DIST_THRESHOLD},
+                         {"nBGSamples",BGSSUBSENSE_DEFAULT_NB_BG_SAMPLES},{"nRequiredBGSamples",BGSSUBSENSE_DEFAULT_REQUIRED_NB_BG_SAMPLES},
+                         {"nSamplesForMovingAvgs",BGSSUBSENSE_DEFAULT_N_SAMPLES_FOR_MV_AVGS},{"fRelLBSPThreshold",BGSLBSP_DEFAULT_LBSP_REL_SIMILARITY_THRESHOLD}},
+             [](const std::vector<double>& v, int) {
+                return createLBSPBenchmarkAlgo<BackgroundSubtractorSuBSENSE>((size_t)v[0],(size_t)v[1],(size_t)v[2],(size_t)v[3],(size_t)v[4],(float)v[5]);
+             }},
+            {"PAWCS",{{"nDescDistThresholdOffset",BGSPAWCS_DEFAULT_DESC_DIST_THRESHOLD_OFFSET},{"nMinColorDistThreshold",BGSPAWCS_DEFAULT_MIN_COLOR_DIST_THRESHOLD},
+                      {"nMaxNbWords",BGSPAWCS_DEFAULT_MAX_NB_WORDS},{"nSamplesForMovingAvgs",BGSPAWCS_DEFAULT_N_SAMPLES_FOR_MV_AVGS},
+                      {"fRelLBSPThreshold",BGSLBSP_DEFAULT_LBSP_REL_SIMILARITY_THRESHOLD}},
+             [](const std::vector<double>& v, int) {
+                return createLBSPBenchmarkAlgo<BackgroundSubtractorPAWCS>((size_t)v[0],(size_t)v[1],(size_t)v[2],(size_t)v[3],(float)v[4]);
+             }},
+            {"ViBe",{{"nColorDistThreshold",BGSVIBE_DEFAULT_COLOR_DIST_THRESHOLD},{"nBGSamples",BGSVIBE_DEFAULT_NB_BG_SAMPLES},
+                     {"nRequiredBGSamples",BGSVIBE_DEFAULT_REQUIRED_NB_BG_SAMPLES}},
+             [](const std::vector<double>& v, int nChannels) {
+                return createSampleBenchmarkAlgo<BackgroundSubtractorViBe,BackgroundSubtractorViBe_1ch,BackgroundSubtractorViBe_3ch>(nChannels,BGSVIBE_DEFAULT_LEARNING_RATE,(size_t)v[0],(size_t)v[1],(size_t)v[2]);
+             }},
+            {"PBAS",{{"nInitColorDistThreshold",BGSPBAS_DEFAULT_COLOR_DIST_THRESHOLD},{"fInitUpdateRate",BGSPBAS_DEFAULT_LEARNING_RATE},
+                     {"nBGSamples",BGSPBAS_DEFAULT_NB_BG_SAMPLES},{"nRequiredBGSamples",BGSPBAS_DEFAULT_REQUIRED_NB_BG_SAMPLES}},
+             [](const std::vector<double>& v, int nChannels) {
+                return createSampleBenchmarkAlgo<BackgroundSubtractorPBAS,BackgroundSubtractorPBAS_1ch,BackgroundSubtractorPBAS_3ch>(nChannels,BGSPBAS_DEFAULT_LEARNING_RATE_OVERRIDE,(size_t)v[0],(float)v[1],(size_t)v[2],(size_t)v[3]);
+             }},
+        };
+        return s_voAlgoDescs;
+    }
+
+    const AlgoDesc& getAlgoDesc(const std::string& sAlgoName) {
+        for(const AlgoDesc& oDesc : getAlgoDescs())
+            if(oDesc.sName==sAlgoName)
+                return oDesc;
+        lvError_("unknown algorithm name '%s' (should be LOBSTER, SuBSENSE, PAWCS, ViBe or PBAS)",sAlgoName.c_str());
+    }
+
+    /// creates an algorithm instance using its default constructor parameters
+    BenchmarkAlgo createBenchmarkAlgo(const std::string& sAlgoName, int nChannels) {
+        const AlgoDesc& oDesc = getAlgoDesc(sAlgoName);
+        std::vector<double> vdParams;
+        for(const auto& oParam : oDesc.vParamDefaults)
+            vdParams.push_back(oParam.second);
+        return oDesc.lCreate(vdParams,nChannels);
+    }
+
+    /// returns the nearest-rank percentile of a sorted (non-empty) value array
+    double getPercentile(const std::vector<double>& vdSortedVals, double dPercentile) {
+        const size_t nRank = (size_t)std::ceil(dPercentile/100*vdSortedVals.size());
+        return vdSortedVals[std::max(nRank,size_t(1))-1];
+    }
+
+    std::string escapeJSON(const std::string& sInput) {
+        std::string sOutput;
+        for(char c : sInput) {
+            if(c=='"' || c=='\\')
+                sOutput += '\\';
+            if(c=='\n')
+                sOutput += "\\n";
+            else
+                sOutput += c;
+        }
+        return sOutput;
+    }
+
+    /// parses a comma-separated list of names
+    std::vector<std::string> splitNames(const std::string& sNames) {
+        std::vector<std::string> vsNames;
+        const std::string sList = sNames+",";
+        for(size_t nBegin=0, nEnd; (nEnd=sList.find(',',nBegin))!=std::string::npos; nBegin=nEnd+1)
+            if(nEnd>nBegin)
+                vsNames.push_back(sList.substr(nBegin,nEnd-nBegin));
+        return vsNames;
+    }
+
+    /// appends the latency stats of an algorithm (from its per-frame apply times) to the result list, and prints them
+    void addBenchmarkResult(std::vector<BenchmarkResult>& voResults, const std::string& sAlgoName, std::vector<double>& vdLatencies) {
+        lvAssert__(!vdLatencies.empty(),"benchmark subset has no frames past the warmup period for '%s'",sAlgoName.c_str());
+        std::sort(vdLatencies.begin(),vdLatencies.end());
+        const double dTotTime = std::max(std::accumulate(vdLatencies.begin(),vdLatencies.end(),0.0),1e-9);
+        voResults.push_back(BenchmarkResult{sAlgoName,vdLatencies.size(),vdLatencies.size()/dTotTime,getPercentile(vdLatencies,50)*1e3,getPercentile(vdLatencies,99)*1e3,lv::GetPeakPhysMemBytesUsed()});
+        const BenchmarkResult& oResult = voResults.back();
+        std::cout << std::setw(12) << std::left << sAlgoName << std::right << std::fixed << std::setprecision(2) << std::setw(10) << oResult.dFramesPerSec << " fps"
+                  << std::setw(10) << oResult.dLatencyP50_ms << " ms p50" << std::setw(10) << oResult.dLatencyP99_ms << " ms p99"
+                  << std::setw(10) << std::setprecision(1) << oResult.nPeakRSS/(1024.0*1024.0) << " MB peak RSS" << std::setw(8) << oResult.nFrames << " frames" << std::endl;
+    }
+
+    void writeBenchmarkJSON(const BenchmarkParams& oParams, const std::vector<BenchmarkResult>& voResults, const std::string& sDatasetName, bool bPeakRSSResettable) {
+        std::ofstream oFile(oParams.sOutputPath);
+        lvAssert__(oFile.is_open(),"could not open output file at '%s'",oParams.sOutputPath.c_str());
+        oFile << "{\n  \"context\": {\n";
+        oFile << "    \"date\": \"" << escapeJSON(lv::getTimeStamp()) << "\",\n";
+        oFile << "    \"library_version\": \"" << escapeJSON(lv::getVersionStamp()) << "\",\n";
+        oFile << "    \"dataset\": \"" << escapeJSON(sDatasetName) << "\",\n";
+        oFile << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+        oFile << "    \"max_batches\": " << oParams.nMaxBatches << ", \"max_frames\": " << oParams.nMaxFrames << ", \"warmup_frames\": " << oParams.nWarmupFrames << ",\n";
+        oFile << "    \"peak_rss_per_algo\": " << (bPeakRSSResettable?"true":"false") << "\n  },\n"; // if false, peak RSS values are process-wide (cumulative)
+        oFile << "  \"benchmarks\": [";
+        for(size_t nResultIdx=0; nResultIdx<voResults.size(); ++nResultIdx) {
+            const BenchmarkResult& oResult = voResults[nResultIdx];
+            oFile << (nResultIdx?",":"") << "\n    {\"name\": \"" << escapeJSON(oResult.sAlgoName) << "\", \"frames\": " << oResult.nFrames;
+            oFile << ", \"frames_per_second\": " << std::fixed << std::setprecision(3) << oResult.dFramesPerSec;
+            oFile << ", \"latency_p50_ms\": " << oResult.dLatencyP50_ms << ", \"latency_p99_ms\": " << oResult.dLatencyP99_ms;
+            oFile << ", \"peak_rss_bytes\": " << oResult.nPeakRSS << "}";
+        }
+        oFile << "\n  ]\n}\n";
+    }
+
+    void runBenchmark(const BenchmarkParams& oParams) {
+        using BenchmarkDatasetType = lv::Dataset_<lv::DatasetTask_ChgDet,lv::DATASET_ID,lv::NonParallel>;
+        lv::IDatasetPtr pDataset = lv::datasets::create<lv::DatasetTask_ChgDet,lv::DATASET_ID,lv::NonParallel>(DATASET_PARAMS(false,false,false));
+        lv::IDataHandlerPtrArray vpBatches = pDataset->getBatches(false);
+        if(vpBatches.size()>oParams.nMaxBatches)
+            vpBatches.resize(oParams.nMaxBatches);
+        lvAssert__(!vpBatches.empty(),"Could not parse any data for dataset '%s'",pDataset->getName().c_str());
+        std::cout << lv::getLogStamp() << "Benchmarking " << oParams.vsAlgoNames.size() << " algorithm(s) on " << vpBatches.size() << " batch(es) of '" << pDataset->getName() << "'...\n" << std::endl;
+        std::vector<BenchmarkResult> voResults;
+        bool bPeakRSSResettable = true;
+        for(const std::string& sAlgoName : oParams.vsAlgoNames) {
+            bPeakRSSResettable &= lv::ResetPeakPhysMemBytesUsed();
+            std::vector<double> vdLatencies;
+            for(const lv::IDataHandlerPtr& pBatch : vpBatches) {
+                BenchmarkDatasetType::WorkBatch& oBatch = dynamic_cast<BenchmarkDatasetType::WorkBatch&>(*pBatch);
+                const size_t nFrameCount = std::min(oBatch.getFrameCount(),oParams.nMaxFrames);
+                oBatch.startAsyncPrecaching(false);
+                srand(0);
+                const cv::Mat& oInitInput = oBatch.getInput(0);
+                BenchmarkAlgo oAlgo = createBenchmarkAlgo(sAlgoName,oInitInput.channels());
+                oAlgo.lInit(oInitInput,oBatch.getROI());
+                cv::Mat oFGMask;
+                lv::StopWatch oStopWatch;
+                for(size_t nFrameIdx=0; nFrameIdx<nFrameCount; ++nFrameIdx) {
+                    const cv::Mat& oInput = oBatch.getInput(nFrameIdx); // fetching is not timed (precached)
+                    oStopWatch.tick();
+                    oAlgo.pAlgo->apply(oInput,oFGMask,nFrameIdx<=100?oAlgo.dInitLearningRate:oAlgo.dLearningRate);
+                    const double dLatency = oStopWatch.tock();
+                    if(nFrameIdx>=oParams.nWarmupFrames)
+                        vdLatencies.push_back(dLatency);
+                }
+                oBatch.stopAsyncPrecaching();
+            }
+            addBenchmarkResult(voResults,sAlgoName,vdLatencies);
+        }
+        writeBenchmarkJSON(oParams,voResults,pDataset->getName(),bPeakRSSResettable);
+        std::cout << "\nwrote " << voResults.size() << " results to '" << oParams.sOutputPath << "'" << std::endl;
+    }
+
+    struct SweepParams {
+        std::string sAlgoName = "SuBSENSE";
+        std::vector<std::pair<std::string,std::vector<double>>> vParamValues; // listed values per swept constructor parameter
+        size_t nMaxBatches = 0; // 0 = all batches
+        size_t nThreads = 0; // 0 = one per hardware thread
+        std::string sOutputPath = "changedet_sweep.yml";
+    };
+
+    /// adds (or replaces) the list of values to sweep for a constructor parameter
+    void setSweepParamValues(SweepParams& oParams, const std::string& sParamName, const std::vector<double>& vdValues) {
+        lvAssert__(!vdValues.empty(),"no values given for swept parameter '%s'",sParamName.c_str());
+        for(auto& oParam : oParams.vParamValues) {
+            if(oParam.first==sParamName) {
+                oParam.second = vdValues;
+                return;
+            }
+        }
+        oParams.vParamValues.emplace_back(sParamName,vdValues);
+    }
+
+    /// parses a 'name:v1,v2,...' command line parameter value list
+    void parseSweepParamArg(SweepParams& oParams, const std::string& sArg) {
+        const size_t nSepIdx = sArg.find(':');
+        lvAssert__(nSepIdx!=std::string::npos && nSepIdx>0,"bad swept parameter format in '%s' (should be name:v1,v2,...)",sArg.c_str());
+        std::vector<double> vdValues;
+        for(const std::string& sValue : splitNames(sArg.substr(nSepIdx+1)))
+            vdValues.push_back(std::stod(sValue));
+        setSweepParamValues(oParams,sArg.substr(0,nSepIdx),vdValues);
+    }
+
+    /// reads sweep settings from a YAML/XML config file (see the usage notes at the top of this file for its layout)
+    void readSweepConfig(const std::string& sConfigPath, SweepParams& oParams) {
+        cv::FileStorage oConfig(sConfigPath,cv::FileStorage::READ);
+        lvAssert__(oConfig.isOpened(),"could not open sweep config file at '%s'",sConfigPath.c_str());
+        if(!oConfig["algo"].empty())
+            oParams.sAlgoName = (std::string)oConfig["algo"];
+        if(!oConfig["max_batches"].empty())
+            oParams.nMaxBatches = (size_t)(int)oConfig["max_batches"];
+        if(!oConfig["threads"].empty())
+            oParams.nThreads = (size_t)(int)oConfig["threads"];
+        if(!oConfig["output"].empty())
+            oParams.sOutputPath = (std::string)oConfig["output"];
+        const cv::FileNode oParamsNode = oConfig["params"];
+        lvAssert__(oParamsNode.empty() || oParamsNode.isMap(),"'params' node in '%s' should be a map of parameter names to value lists",sConfigPath.c_str());
+        for(cv::FileNodeIterator oParamIter=oParamsNode.begin(); oParamIter!=oParamsNode.end(); ++oParamIter) {
+            const cv::FileNode oParamNode = *oParamIter;
+            std::vector<double> vdValues;
+            if(oParamNode.isSeq()) {
+                for(cv::FileNodeIterator oValueIter=oParamNode.begin(); oValueIter!=oParamNode.end(); ++oValueIter)
+                    vdValues.push_back((double)*oValueIter);
+            }
+            else
+                vdValues.push_back((double)oParamNode);
+            setSweepParamValues(oParams,oParamNode.name(),vdValues);
+        }
+    }
+
+    /// returns the full list of constructor parameter combinations to test (Cartesian product of the swept values, defaults elsewhere)
+    std::vector<std::vector<double>> getSweepCombinations(const AlgoDesc& oDesc, const SweepParams& oParams) {
+        std::vector<std::vector<double>> vvdParamValues;
+        for(const auto& oParam : oDesc.vParamDefaults)
+            vvdParamValues.push_back({oParam.second});
+        for(const auto& oParam : oParams.vParamValues) {
+            auto pDefault = std::find_if(oDesc.vParamDefaults.begin(),oDesc.vParamDefaults.end(),[&](const std::pair<std::string,double>& p){return p.first==oParam.first;});
+            lvAssert__(pDefault!=oDesc.vParamDefaults.end(),"unknown constructor parameter '%s' for algorithm '%s'",oParam.first.c_str(),oDesc.sName.c_str());
+            vvdParamValues[pDefault-oDesc.vParamDefaults.begin()] = oParam.second;
+        }
+        std::vector<std::vector<double>> vvdCombinations(1);
+        for(const std::vector<double>& vdValues : vvdParamValues) {
+            std::vector<std::vector<double>> vvdNewCombinations;
+            for(const std::vector<double>& vdPrefix : vvdCombinations) {
+                for(double dValue : vdValues) {
+                    vvdNewCombinations.push_back(vdPrefix);
+                    vvdNewCombinations.back().push_back(dValue);
+                }
+            }
+            vvdCombinations = std::move(vvdNewCombinations);
+        }
+        return vvdCombinations;
+    }
+
+    void writeSweepResults(const SweepParams& oParams, const AlgoDesc& oDesc, const std::vector<std::vector<double>>& vvdCombinations,
+                           const std::vector<lv::BinClassifMetricsAccumulatorPtr>& vpMetrics, const std::string& sDatasetName, size_t nBatches) {
+        cv::FileStorage oOutput(oParams.sOutputPath,cv::FileStorage::WRITE);
+        lvAssert__(oOutput.isOpened(),"could not open output file at '%s'",oParams.sOutputPath.c_str());
+        oOutput << "date" << lv::getTimeStamp();
+        oOutput << "library_version" << lv::getVersionStamp();
+        oOutput << "dataset" << sDatasetName;
+        oOutput << "batches" << (int)nBatches;
+        oOutput << "algo" << oDesc.sName;
+        oOutput << "configs" << "[";
+        size_t nBestIdx = 0;
+        for(size_t nComboIdx=0; nComboIdx<vvdCombinations.size(); ++nComboIdx) {
+            const lv::BinClassifMetricsAccumulator& oMetrics = *vpMetrics[nComboIdx];
+            const double dFMeasure = lv::BinClassifMetricsCalculator::CalcFMeasure(oMetrics);
+            if(dFMeasure>lv::BinClassifMetricsCalculator::CalcFMeasure(*vpMetrics[nBestIdx]))
+                nBestIdx = nComboIdx;
+            oOutput << "{" << "params" << "{";
+            for(size_t nParamIdx=0; nParamIdx<oDesc.vParamDefaults.size(); ++nParamIdx)
+                oOutput << oDesc.vParamDefaults[nParamIdx].first << vvdCombinations[nComboIdx][nParamIdx];
+            oOutput << "}";
+            oOutput << "Rcl" << lv::BinClassifMetricsCalculator::CalcRecall(oMetrics);
+            oOutput << "Prc" << lv::BinClassifMetricsCalculator::CalcPrecision(oMetrics);
+            oOutput << "FM" << dFMeasure;
+            oOutput << "MCC" << lv::BinClassifMetricsCalculator::CalcMatthewsCorrCoeff(oMetrics);
+            oOutput << "PBC" << lv::BinClassifMetricsCalculator::CalcPercentBadClassifs(oMetrics);
+            oOutput << "}";
+        }
+        oOutput << "]";
+        oOutput << "best_config_idx" << (int)nBestIdx;
+        std::cout << "\nbest config (FM=" << std::fixed << std::setprecision(4) << lv::BinClassifMetricsCalculator::CalcFMeasure(*vpMetrics[nBestIdx]) << "):";
+        for(size_t nParamIdx=0; nParamIdx<oDesc.vParamDefaults.size(); ++nParamIdx)
+            std::cout << " " << oDesc.vParamDefaults[nParamIdx].first << "=" << std::defaultfloat << vvdCombinations[nBestIdx][nParamIdx];
+        std::cout << "\nwrote " << vvdCombinations.size() << " results to '" << oParams.sOutputPath << "'" << std::endl;
+    }
+
+    void runSweep(const SweepParams& oParams) {
+        using SweepDatasetType = lv::Dataset_<lv::DatasetTask_ChgDet,lv::DATASET_ID,lv::NonParallel>;
+        const AlgoDesc& oDesc = getAlgoDesc(oParams.sAlgoName);
+        const std::vector<std::vector<double>> vvdCombinations = getSweepCombinations(oDesc,oParams);
+        lv::IDatasetPtr pDataset = lv::datasets::create<lv::DatasetTask_ChgDet,lv::DATASET_ID,lv::NonParallel>(DATASET_PARAMS(false,false,false));
+        lv::IDataHandlerPtrArray vpBatches = pDataset->getBatches(false);
+        if(oParams.nMaxBatches>0 && vpBatches.size()>oParams.nMaxBatches)
+            vpBatches.resize(oParams.nMaxBatches);
+        lvAssert__(!vpBatches.empty(),"Could not parse any data for dataset '%s'",pDataset->getName().c_str());
+        const size_t nCombinations = vvdCombinations.size();
+        lv::ThreadPool oThreadPool(oParams.nThreads);
+        std::cout << lv::getLogStamp() << "Sweeping " << nCombinations << " '" << oDesc.sName << "' config(s) on " << vpBatches.size() << " batch(es) of '" << pDataset->getName() << "' with " << oThreadPool.getThreadCount() << " thread(s)...\n" << std::endl;
+        std::vector<lv::BinClassifMetricsAccumulatorPtr> vpMetrics(nCombinations);
+        for(lv::BinClassifMetricsAccumulatorPtr& pMetrics : vpMetrics)
+            pMetrics = lv::BinClassifMetricsAccumulator::create();
+        std::vector<BenchmarkAlgo> voAlgos(nCombinations);
+        std::vector<cv::Mat> voFGMasks(nCombinations);
+        size_t nDoneBatches = 0;
+        for(const lv::IDataHandlerPtr& pBatch : vpBatches) {
+            SweepDatasetType::WorkBatch& oBatch = dynamic_cast<SweepDatasetType::WorkBatch&>(*pBatch);
+            const size_t nFrameCount = oBatch.getFrameCount();
+            oBatch.startAsyncPrecaching(true);
+            srand(0);
+            const cv::Mat& oInitInput = oBatch.getInput(0);
+            const cv::Mat& oROI = oBatch.getROI();
+            for(size_t nComboIdx=0; nComboIdx<nCombinations; ++nComboIdx) {
+                voAlgos[nComboIdx] = oDesc.lCreate(vvdCombinations[nComboIdx],oInitInput.channels());
+                voAlgos[nComboIdx].lInit(oInitInput,oROI);
+            }
+            for(size_t nFrameIdx=0; nFrameIdx<nFrameCount; ++nFrameIdx) {
+                // every frame is fetched once, and shared by all configs (which only read it)
+                const cv::Mat& oInput = oBatch.getInput(nFrameIdx);
+                const cv::Mat& oGT = oBatch.getGT(nFrameIdx);
+                oThreadPool.parallel_for(nCombinations,[&](size_t nComboIdx) {
+                    BenchmarkAlgo& oAlgo = voAlgos[nComboIdx];
+                    oAlgo.pAlgo->apply(oInput,voFGMasks[nComboIdx],nFrameIdx<=100?oAlgo.dInitLearningRate:oAlgo.dLearningRate);
+                    if(!oGT.empty())
+                        vpMetrics[nComboIdx]->accumulate(voFGMasks[nComboIdx],oGT,oROI);
+                });
+            }
+            oBatch.stopAsyncPrecaching();
+            for(BenchmarkAlgo& oAlgo : voAlgos)
+                oAlgo = BenchmarkAlgo(); // releases all models before the next batch
+            std::cout << "\tCompleted [" << ++nDoneBatches << "/" << vpBatches.size() << "] (" << pBatch->getRelativePath() << ")" << std::endl;
+        }
+        writeSweepResults(oParams,oDesc,vvdCombinations,vpMetrics,pDataset->getName(),vpBatches.size());
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
     try {
-        lv::IDatasetPtr pDataset = lv::datasets::create<lv::DatasetTask_ChgDet,lv::DATASET_ID,eImplTypeEnum>(DATASET_PARAMS);
-        lv::IDataHandlerPtrQueue vpBatches = pDataset->getSortedBatches(false);
+        BenchmarkParams oBenchParams;
+        SweepParams oSweepParams;
+        bool bBenchmarkMode = false, bSweepMode = false, bEvalOnlyMode = false;
+        for(int nArgIdx=1; nArgIdx<argc; ++nArgIdx) {
+            const std::string sArg(argv[nArgIdx]);
+            if(sArg.compare(0,8,"--sweep=")==0) // read first, so that the following arguments override the config file
+                readSweepConfig(sArg.substr(8),oSweepParams);
+        }
+        for(int nArgIdx=1; nArgIdx<argc; ++nArgIdx) {
+            const std::string sArg(argv[nArgIdx]);
+            if(sArg=="--benchmark")
+                bBenchmarkMode = true;
+            else if(sArg=="--sweep" || sArg.compare(0,8,"--sweep=")==0)
+                bSweepMode = true;
+            else if(sArg=="--evaluate-only")
+                bEvalOnlyMode = true;
+            else if(sArg.compare(0,7,"--algo=")==0)
+                oSweepParams.sAlgoName = sArg.substr(7);
+            else if(sArg.compare(0,8,"--param=")==0)
+                parseSweepParamArg(oSweepParams,sArg.substr(8));
+            else if(sArg.compare(0,10,"--threads=")==0)
+                oSweepParams.nThreads = (size_t)std::stoul(sArg.substr(10));
+            else if(sArg.compare(0,8,"--algos=")==0)
+                oBenchParams.vsAlgoNames = splitNames(sArg.substr(8));
+            else if(sArg.compare(0,10,"--batches=")==0)
+                oBenchParams.nMaxBatches = oSweepParams.nMaxBatches = (size_t)std::stoul(sArg.substr(10));
+            else if(sArg.compare(0,9,"--frames=")==0)
+                oBenchParams.nMaxFrames = (size_t)std::stoul(sArg.substr(9));
+            else if(sArg.compare(0,9,"--warmup=")==0)
+                oBenchParams.nWarmupFrames = (size_t)std::stoul(sArg.substr(9));
+            else if(sArg.compare(0,6,"--out=")==0)
+                oBenchParams.sOutputPath = oSweepParams.sOutputPath = sArg.substr(6);
+            else
+                lvError_("unknown argument '%s'",sArg.c_str());
+        }
+        lvAssert_(int(bBenchmarkMode)+int(bSweepMode)+int(bEvalOnlyMode)<=1,"benchmark, sweep and evaluation-only modes cannot be combined");
+        if(bBenchmarkMode) {
+            runBenchmark(oBenchParams);
+            return 0;
+        }
+        if(bSweepMode) {
+            runSweep(oSweepParams);
+            return 0;
+        }
+        if(bEvalOnlyMode) {
+            lv::IDatasetPtr pDataset = lv::datasets::create<lv::DatasetTask_ChgDet,lv::DATASET_ID,lv::NonParallel>(DATASET_PARAMS(false,true,false));
+            lvAssert_(pDataset->getTotPackets()>0,"could not parse any data for dataset");
+            std::cout << "Evaluating saved outputs for dataset '" << pDataset->getName() << "'..." << std::endl;
+            auto pEvaluator = std::dynamic_pointer_cast<lv::IDatasetEvaluator_<lv::DatasetEval_None>>(pDataset);
+            lvAssert_(pEvaluator,"dataset does not provide an evaluator interface");
+            lv::StopWatch oEvalWatch;
+            pEvaluator->evaluateSavedOutputs(oSweepParams.nThreads);
+            std::cout << "Evaluated " << pDataset->getTotPackets() << " packet(s) in " << std::fixed << std::setprecision(1) << oEvalWatch.tock() << " sec." << std::endl;
+            pDataset->writeEvalReport();
+            return 0;
+        }
+#if TRACK_MEMORY_USAGE && !USE_GPU_IMPL
+        cv::TrackingMatAllocator::setAsDefault(true);
+#endif //TRACK_MEMORY_USAGE && !USE_GPU_IMPL
+        // glsl impls upload packed 3-channel frames & expand them on the gpu, so only the other gpu impls need 4-byte aligned packets
+        lv::IDatasetPtr pDataset = lv::datasets::create<lv::DatasetTask_ChgDet,lv::DATASET_ID,eImplTypeEnum>(DATASET_PARAMS(bool(WRITE_IMG_OUTPUT),bool(EVALUATE_OUTPUT),bool(USE_GPU_IMPL&&!USE_GLSL_IMPL)));
+        const lv::IDataHandlerPtrArray vpBatches = pDataset->getBatches(false);
         const size_t nTotPackets = pDataset->getTotPackets();
         const size_t nTotBatches = vpBatches.size();
         if(nTotBatches==0 || nTotPackets==0)
             lvError_("Could not parse any data for dataset '%s'",pDataset->getName().c_str());
         std::cout << "Parsing complete. [" << nTotBatches << " batch(es)]" << std::endl;
         std::cout << "\n[" << lv::getTimeStamp() << "]\n" << std::endl;
-        std::cout << "Executing background subtraction with " << ((g_nMaxThreads>nTotBatches)?nTotBatches:g_nMaxThreads) << " thread(s)..." << std::endl;
-        size_t nProcessedBatches = 0;
-        while(!vpBatches.empty()) {
-            while(g_nActiveThreads>=g_nMaxThreads)
-                std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-            lv::IDataHandlerPtr pBatch = vpBatches.top();
-            std::cout << "\tProcessing [" << ++nProcessedBatches << "/" << nTotBatches << "] (" << pBatch->getRelativePath() << ", L=" << std::scientific << std::setprecision(2) << pBatch->getExpectedLoad() << ")" << std::endl;
+#if (HAVE_GLSL && USE_GLSL_IMPL)
+        // one worker (i.e. one context) per gpu by default; batches are balanced across gpus by the scheduler
+        const size_t nDevices = lv::gl::DeviceContextManager::getDeviceCount();
+        lv::BatchScheduler oScheduler(std::min(nDevices*GPU_WORKERS_PER_DEVICE,nTotBatches));
+        oScheduler.setDeviceCount(nDevices);
+#else //!(HAVE_GLSL && USE_GLSL_IMPL)
+        lv::BatchScheduler oScheduler(std::min(g_nMaxThreads,nTotBatches));
+#endif //!(HAVE_GLSL && USE_GLSL_IMPL)
+        std::cout << "Executing background subtraction with " << oScheduler.getWorkerCount() << " thread(s) on " << oScheduler.getDeviceCount() << " device(s)..." << std::endl;
+        oScheduler.setProgressCallback([](const lv::IDataHandlerPtr& pBatch, size_t nDoneTasks, size_t nTotTasks, size_t nDonePackets, size_t nTotPackets) {
+            std::cout << "\tCompleted [" << nDoneTasks << "/" << nTotTasks << "] (" << pBatch->getRelativePath() << ", " << std::fixed << std::setprecision(1) << (100.0*nDonePackets)/nTotPackets << "% of all packets)" << std::endl;
+        });
+        std::atomic_size_t nStartedBatches(0);
+        oScheduler.run(vpBatches,[&](const lv::IDataHandlerPtr& pBatch, size_t /*nBeginIdx*/, size_t /*nEndIdx*/, size_t nWorkerIdx) {
+            std::cout << "\tProcessing [" << ++nStartedBatches << "/" << nTotBatches << "] (" << pBatch->getRelativePath() << ", L=" << std::scientific << std::setprecision(2) << pBatch->getExpectedLoad() << ")" << std::endl;
             if(DATASET_PRECACHING)
                 dynamic_cast<DatasetType::WorkBatch&>(*pBatch).startAsyncPrecaching(EVALUATE_OUTPUT);
-            ++g_nActiveThreads;
-            std::thread(Analyze,(int)nProcessedBatches,pBatch).detach();
-            vpBatches.pop();
-        }
-        while(g_nActiveThreads>0) // @@@ check if thread crashed?
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            Analyze((int)nWorkerIdx,oScheduler.getWorkerDeviceIdx(nWorkerIdx),pBatch);
+        });
         if(pDataset->getProcessedPacketsCountPromise()==nTotPackets)
             pDataset->writeEvalReport();
     }
     catch(const cv::Exception& e) {std::cout << "\n!!!!!!!!!!!!!!\nTop level caught cv::Exception:\n" << e.what() << "\n!!!!!!!!!!!!!!\n" << std::endl; return 1;}
     catch(const std::exception& e) {std::cout << "\n!!!!!!!!!!!!!!\nTop level caught std::exception:\n" << e.what() << "\n!!!!!!!!!!!!!!\n" << std::endl; return 1;}
     catch(...) {std::cout << "\n!!!!!!!!!!!!!!\nTop level caught unhandled exception\n!!!!!!!!!!!!!!\n" << std::endl; return 1;}
+    lv::AsyncLogger::flush();
     std::cout << "\n[" << lv::getTimeStamp() << "]\n" << std::endl;
     std::cout << "All done." << std::endl;
     return 0;
 }
 
 #if (HAVE_GLSL && USE_GLSL_IMPL)
-void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch) {
+void Analyze(int nThreadIdx, size_t nDeviceIdx, lv::IDataHandlerPtr pBatch) {
     srand(0); // for now, assures that two consecutive runs on the same data return the same results
     //srand((unsigned int)time(NULL));
     try {
@@ -135,7 +600,7 @@ void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch) {
         lvAssert(oBatch.getFrameCount()>1);
         const std::string sCurrBatchName = lv::clampString(oBatch.getName(),12);
         const size_t nTotPacketCount = oBatch.getFrameCount();
-        GLContext oContext(oBatch.getFrameSize(),std::string("[GPU] ")+oBatch.getRelativePath(),DISPLAY_OUTPUT==0);
+        lv::gl::Context& oContext = lv::gl::DeviceContextManager::getThreadContext(nDeviceIdx,oBatch.getFrameSize(),std::string("[GPU] ")+oBatch.getRelativePath(),DISPLAY_OUTPUT==0);
         std::shared_ptr<IBackgroundSubtractor_<lv::GLSL>> pAlgo = std::make_shared<BackgroundSubtractorType>();
 #if DISPLAY_OUTPUT>1
         cv::DisplayHelperPtr pDisplayHelper = cv::DisplayHelper::create(oBatch.getName(),oBatch.getOutputPath()+"/../");
@@ -148,7 +613,7 @@ void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch) {
         size_t nNextIdx = 1;
         while(nNextIdx<=nTotPacketCount) {
             if(!(nNextIdx%100))
-                std::cout << "\t\t" << lv::clampString(sCurrBatchName,12) << " @ F:" << std::setfill('0') << std::setw(lv::digit_count((int)nTotPacketCount)) << nNextIdx << "/" << nTotPacketCount << "   [GPU]" << std::endl;
+                lvLogInfo("\t\t%s @ F:%0*d/%d   [GPU=%d]",lv::clampString(sCurrBatchName,12),lv::digit_count((int)nTotPacketCount),(int)nNextIdx,(int)nTotPacketCount,(int)nDeviceIdx);
             const double dCurrLearningRate = nNextIdx<=100?1:dDefaultLearningRate;
             oBatch.apply_gl(pAlgo,nNextIdx++,false,dCurrLearningRate);
             //pGLSLAlgoEvaluator->apply_gl(oNextGTMask);
@@ -169,19 +634,18 @@ void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch) {
         oBatch.stopProcessing();
         const double dTimeElapsed = oBatch.getProcessTime();
         const double dProcessSpeed = (double)(nNextIdx-1)/dTimeElapsed;
-        std::cout << "\t\t" << sCurrBatchName << " @ F:" << (nNextIdx-1) << "/" << nTotPacketCount << "   [T=" << nThreadIdx << "]   (" << std::fixed << std::setw(4) << dTimeElapsed << " sec, " << std::setw(4) << dProcessSpeed << " Hz)" << std::endl;
+        lvLogInfo("\t\t%s @ F:%d/%d   [T=%d]   (%4f sec, %4f Hz)",sCurrBatchName,(int)(nNextIdx-1),(int)nTotPacketCount,nThreadIdx,dTimeElapsed,dProcessSpeed);
         oBatch.writeEvalReport(); // this line is optional; it allows results to be read before all batches are processed
     }
     catch(const lv::Exception& e) {
         std::cout << "\nAnalyze caught Exception:\n" << e.what();
-        const std::string sContextErrMsg = GLContext::getLatestErrorMessage();
+        const std::string sContextErrMsg = lv::gl::Context::getLatestErrorMessage();
         if(!sContextErrMsg.empty())
             std::cout << "\nContext error: " << sContextErrMsg << "\n" << std::endl;
     }
     catch(const cv::Exception& e) {std::cout << "\nAnalyze caught cv::Exception:\n" << e.what() << "\n" << std::endl;}
     catch(const std::exception& e) {std::cout << "\nAnalyze caught std::exception:\n" << e.what() << "\n" << std::endl;}
     catch(...) {std::cout << "\nAnalyze caught unhandled exception\n" << std::endl;}
-    --g_nActiveThreads;
     try {
         DatasetType::WorkBatch& oBatch = dynamic_cast<DatasetType::WorkBatch&>(*pBatch);
         if(oBatch.isProcessing())
@@ -196,7 +660,7 @@ static_assert(false,"missing impl");
 #elif (HAVE_OPENCL && USE_OPENCL_IMPL)
 static_assert(false,"missing impl");
 #elif !USE_GPU_IMPL
-void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch) {
+void Analyze(int nThreadIdx, size_t /*nDeviceIdx*/, lv::IDataHandlerPtr pBatch) {
     srand(0); // for now, assures that two consecutive runs on the same data return the same results
     //srand((unsigned int)time(NULL));
     size_t nCurrIdx = 0;
@@ -206,47 +670,172 @@ void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch) {
         const std::string sCurrBatchName = lv::clampString(oBatch.getName(),12);
         const size_t nTotPacketCount = oBatch.getFrameCount();
         const cv::Mat oROI = oBatch.getROI();
-        cv::Mat oCurrInput = oBatch.getInput(nCurrIdx).clone();
+        cv::Mat oCurrInput = oBatch.getInput(nCurrIdx);
         lvAssert(!oCurrInput.empty() && oCurrInput.isContinuous());
         cv::Mat oCurrFGMask(oBatch.getFrameSize(),CV_8UC1,cv::Scalar_<uchar>(0));
         std::shared_ptr<IBackgroundSubtractor> pAlgo = std::make_shared<BackgroundSubtractorType>();
         const double dDefaultLearningRate = pAlgo->getDefaultLearningRate();
-        pAlgo->initialize(oCurrInput,oROI);
+        {
+            const lv::MemoryTracker::Scope oMemoryScope(pAlgo->getMemoryTag());
+            pAlgo->initialize(oCurrInput,oROI);
+        }
+#if CHECKPOINT_PERIOD>0
+        // batches resume from their last checkpoint (if any), and fully processed ones are skipped
+        std::string sAlgoState;
+        nCurrIdx = oBatch.readCheckpoint(sAlgoState);
+        if(nCurrIdx>=nTotPacketCount) {
+            std::cout << "\t\t" << sCurrBatchName << " already fully processed (checkpoint found), skipping." << std::endl;
+            return;
+        }
+        else if(nCurrIdx>0) {
+            std::istringstream ssAlgoState(sAlgoState);
+            pAlgo->loadModel(ssAlgoState);
+            std::cout << "\t\t" << sCurrBatchName << " resuming from checkpoint @ F:" << nCurrIdx << "/" << nTotPacketCount << std::endl;
+        }
+        // model snapshots taken by the algo stage, waiting for the output stage to catch up before being written along with the metrics
+        std::mutex oCheckpointMutex;
+        std::map<size_t,std::string> msCheckpointAlgoStates;
+#endif //CHECKPOINT_PERIOD>0
+        const size_t nFirstPacketIdx = nCurrIdx;
 #if DISPLAY_OUTPUT>0
         cv::DisplayHelperPtr pDisplayHelper = cv::DisplayHelper::create(oBatch.getName(),oBatch.getOutputPath()+"/../");
         pAlgo->m_pDisplayHelper = pDisplayHelper;
 #endif //DISPLAY_OUTPUT>0
+        // staged pipeline: input fetching (fed by the precacher) -> algorithm (this thread) -> output writing (evaluation runs on its own async worker);
+        // stages are linked by bounded queues, so a slow stage stalls the previous ones instead of letting packets pile up
+        using Packet = std::pair<size_t,cv::Mat>;
+        constexpr lv::QueueWaitStrategy ePipelineWaitStrategy = PIPELINE_SPIN_WAIT?lv::QueueWait_Spin:lv::QueueWait_Block;
+        lv::BoundedSPSCQueue<Packet,ePipelineWaitStrategy> oInputQueue(PIPELINE_QUEUE_SIZE), oOutputQueue(PIPELINE_QUEUE_SIZE);
+        std::array<double,3> adStageBusyTimes = {0.0,0.0,0.0}; // input/algo/output, each only written by its own stage
+        std::exception_ptr pInputException, pOutputException;
+        oBatch.setAsyncEvaluation(true);
+#if TRACE_PACKET_LATENCY
+        const auto pLatencyTracer = std::make_shared<lv::PacketLatencyTracer>();
+        oBatch.setLatencyTracer(pLatencyTracer);
+#endif //TRACE_PACKET_LATENCY
         oBatch.startProcessing();
-        while(nCurrIdx<nTotPacketCount) {
-            if(!((nCurrIdx+1)%100) && nCurrIdx<nTotPacketCount)
-                std::cout << "\t\t" << sCurrBatchName << " @ F:" << std::setfill('0') << std::setw(lv::digit_count((int)nTotPacketCount)) << nCurrIdx+1 << "/" << nTotPacketCount << "   [T=" << nThreadIdx << "]" << std::endl;
-            const double dCurrLearningRate = nCurrIdx<=100?1:dDefaultLearningRate;
-            oCurrInput = oBatch.getInput(nCurrIdx);
-            pAlgo->apply(oCurrInput,oCurrFGMask,dCurrLearningRate);
-#if DISPLAY_OUTPUT>0
-            cv::Mat oCurrBGImg;
-            pAlgo->getBackgroundImage(oCurrBGImg);
-            if(!oROI.empty()) {
-                cv::bitwise_or(oCurrBGImg,UCHAR_MAX/2,oCurrBGImg,oROI==0);
-                cv::bitwise_or(oCurrFGMask,UCHAR_MAX/2,oCurrFGMask,oROI==0);
+        lv::StopWatch oPipelineWatch;
+        std::thread oInputThread([&]() {
+            try {
+                lv::StopWatch oStageWatch;
+                for(size_t nPacketIdx=nFirstPacketIdx; nPacketIdx<nTotPacketCount; ++nPacketIdx) {
+                    oStageWatch.tick();
+                    cv::Mat oInput = oBatch.getInput(nPacketIdx);
+                    adStageBusyTimes[0] += oStageWatch.tock();
+                    if(!oInputQueue.push(Packet(nPacketIdx,std::move(oInput))))
+                        break;
+                }
             }
-            pDisplayHelper->display(oCurrInput,oCurrBGImg,oBatch.getColoredMask(oCurrFGMask,nCurrIdx),nCurrIdx);
-            const int nKeyPressed = pDisplayHelper->waitKey();
-            if(nKeyPressed==(int)'q')
-                break;
+            catch(...) {pInputException = std::current_exception();}
+            oInputQueue.close();
+        });
+        std::thread oOutputThread([&]() {
+            try {
+                lv::StopWatch oStageWatch;
+                Packet oPacket;
+                while(oOutputQueue.pop(oPacket)) {
+                    oStageWatch.tick();
+                    oBatch.push(oPacket.second,oPacket.first);
+#if CHECKPOINT_PERIOD>0
+                    std::string sCheckpointAlgoState;
+                    bool bCheckpointReady = false;
+                    {
+                        std::mutex_lock_guard oLock(oCheckpointMutex);
+                        auto psAlgoStateIter = msCheckpointAlgoStates.find(oPacket.first);
+                        if((bCheckpointReady=(psAlgoStateIter!=msCheckpointAlgoStates.end()))) {
+                            sCheckpointAlgoState = std::move(psAlgoStateIter->second);
+                            msCheckpointAlgoStates.erase(psAlgoStateIter);
+                        }
+                    }
+                    if(bCheckpointReady)
+                        oBatch.writeCheckpoint(sCheckpointAlgoState);
+#endif //CHECKPOINT_PERIOD>0
+                    adStageBusyTimes[2] += oStageWatch.tock();
+                }
+            }
+            catch(...) {pOutputException = std::current_exception();}
+            oOutputQueue.close();
+        });
+        const auto lJoinStages = [&]() {
+            oInputQueue.close();
+            oOutputQueue.close();
+            oInputThread.join();
+            oOutputThread.join();
+        };
+        try {
+            lv::StopWatch oStageWatch;
+            Packet oPacket;
+            while(oInputQueue.pop(oPacket)) {
+                oStageWatch.tick();
+                lvDbgAssert(oPacket.first==nCurrIdx);
+                if(!((nCurrIdx+1)%100) && nCurrIdx<nTotPacketCount)
+                    lvLogInfo("\t\t%s @ F:%0*d/%d   [T=%d]",sCurrBatchName,lv::digit_count((int)nTotPacketCount),(int)(nCurrIdx+1),(int)nTotPacketCount,nThreadIdx);
+                const double dCurrLearningRate = nCurrIdx<=100?1:dDefaultLearningRate;
+                oCurrInput = oPacket.second;
+                {
+                    const lv::MemoryTracker::Scope oMemoryScope(pAlgo->getMemoryTag());
+                    pAlgo->apply(oCurrInput,oCurrFGMask,dCurrLearningRate);
+                }
+#if CHECKPOINT_PERIOD>0
+                if(!((nCurrIdx+1)%CHECKPOINT_PERIOD) && nCurrIdx+1<nTotPacketCount) {
+                    std::ostringstream ssAlgoState;
+                    pAlgo->saveModel(ssAlgoState);
+                    std::mutex_lock_guard oLock(oCheckpointMutex);
+                    msCheckpointAlgoStates[nCurrIdx] = ssAlgoState.str();
+                }
+#endif //CHECKPOINT_PERIOD>0
+                adStageBusyTimes[1] += oStageWatch.tock();
+#if DISPLAY_OUTPUT>0
+                cv::Mat oCurrBGImg;
+                pAlgo->getBackgroundImage(oCurrBGImg);
+                if(!oROI.empty()) {
+                    cv::bitwise_or(oCurrBGImg,UCHAR_MAX/2,oCurrBGImg,oROI==0);
+                    cv::bitwise_or(oCurrFGMask,UCHAR_MAX/2,oCurrFGMask,oROI==0);
+                }
+                pDisplayHelper->display(oCurrInput,oCurrBGImg,oBatch.getColoredMask(oCurrFGMask,nCurrIdx),nCurrIdx);
+                const int nKeyPressed = pDisplayHelper->waitKey();
+                if(nKeyPressed==(int)'q')
+                    break;
 #endif //DISPLAY_OUTPUT>0
-            oBatch.push(oCurrFGMask,nCurrIdx++);
+                if(!oOutputQueue.push(Packet(nCurrIdx,oCurrFGMask.clone())))
+                    break;
+                ++nCurrIdx;
+            }
+        }
+        catch(...) {
+            lJoinStages();
+            throw;
         }
+        lJoinStages();
+        const double dPipelineTime = std::max(oPipelineWatch.tock(),1e-6);
+        if(pInputException)
+            std::rethrow_exception(pInputException);
+        if(pOutputException)
+            std::rethrow_exception(pOutputException);
+        std::cout << "\t\t" << sCurrBatchName << " stage occupancy:   input=" << std::fixed << std::setprecision(1) << 100*adStageBusyTimes[0]/dPipelineTime
+                  << "% (queue " << 100*oInputQueue.getAvgOccupancy() << "% full, " << oInputQueue.getFullWaitCount() << " stalls)   algo=" << 100*adStageBusyTimes[1]/dPipelineTime
+                  << "%   output=" << 100*adStageBusyTimes[2]/dPipelineTime << "% (queue " << 100*oOutputQueue.getAvgOccupancy() << "% full, " << oOutputQueue.getFullWaitCount() << " stalls)" << std::endl;
         oBatch.stopProcessing();
+#if TRACE_PACKET_LATENCY
+        oBatch.setLatencyTracer(nullptr);
+        pLatencyTracer->writeReport(oBatch.getOutputPath()+"/latency.txt");
+#endif //TRACE_PACKET_LATENCY
+#if CHECKPOINT_PERIOD>0
+        if(nCurrIdx==nTotPacketCount)
+            oBatch.writeCheckpoint(); // marks the batch as fully processed for later runs
+#endif //CHECKPOINT_PERIOD>0
         const double dTimeElapsed = oBatch.getProcessTime();
         const double dProcessSpeed = (double)nCurrIdx/dTimeElapsed;
-        std::cout << "\t\t" << sCurrBatchName << " @ F:" << nCurrIdx << "/" << nTotPacketCount << "   [T=" << nThreadIdx << "]   (" << std::fixed << std::setw(4) << dTimeElapsed << " sec, " << std::setw(4) << dProcessSpeed << " Hz)" << std::endl;
+        lvLogInfo("\t\t%s @ F:%d/%d   [T=%d]   (%4f sec, %4f Hz)",sCurrBatchName,(int)nCurrIdx,(int)nTotPacketCount,nThreadIdx,dTimeElapsed,dProcessSpeed);
+#if TRACK_MEMORY_USAGE
+        const lv::MemoryTracker::Usage oAlgoMemUsage = pAlgo->getMemoryUsage();
+        lvLogInfo("\t\t%s algo memory:   %zu mb (peak = %zu mb, %zu allocations)",sCurrBatchName,(oAlgoMemUsage.nCurrBytes/1024)/1024,(oAlgoMemUsage.nPeakBytes/1024)/1024,oAlgoMemUsage.nAllocCount);
+#endif //TRACK_MEMORY_USAGE
         oBatch.writeEvalReport(); // this line is optional; it allows results to be read before all batches are processed
     }
     catch(const cv::Exception& e) {std::cout << "\nAnalyze caught cv::Exception:\n" << e.what() << "\n" << std::endl;}
     catch(const std::exception& e) {std::cout << "\nAnalyze caught std::exception:\n" << e.what() << "\n" << std::endl;}
     catch(...) {std::cout << "\nAnalyze caught unhandled exception\n" << std::endl;}
-    --g_nActiveThreads;
     try {
         DatasetType::WorkBatch& oBatch = dynamic_cast<DatasetType::WorkBatch&>(*pBatch);
         if(oBatch.isProcessing())
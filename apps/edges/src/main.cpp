@@ -16,8 +16,14 @@
 // limitations under the License.
 
 #include "litiv/datasets.hpp"
+#include "litiv/utils/console.hpp"
 #include "litiv/imgproc.hpp"
 
+// usage: edges [--benchmark [--algos=Canny,LBSP] [--batches=3] [--frames=300] [--warmup=5] [--full-thresh=0|1] [--out=edges_bench.json]]
+//
+// in benchmark mode, the display/output/evaluation switches below are ignored: each cpu algorithm runs alone (single thread) on the
+// same dataset subset (the first images of the first batches), only its 'apply' calls are timed, and results are written as JSON
+
 ////////////////////////////////
 #define WRITE_IMG_OUTPUT        0
 #define EVALUATE_OUTPUT         0
@@ -55,7 +61,7 @@
 #endif //ndef(EXTERNAL_DATA_ROOT)
 #ifndef DATASET_ID
 #define DATASET_ID Dataset_Custom
-#define DATASET_PARAMS \
+#define DATASET_PARAMS(bSaveOutput,bUseEvaluator,bForce4ByteDataAlign) \
     "@@@@",                                                      /* => const std::string& sDatasetName */ \
     "@@@@",                                                      /* => const std::string& sDatasetDirPath */ \
     DATASET_OUTPUT_PATH,                                         /* => const std::string& sOutputDirPath */ \
@@ -65,21 +71,20 @@
     std::vector<std::string>{"@@@","@@@","@@@","..."},           /* => const std::vector<std::string>& vsSkippedDirTokens */ \
     std::vector<std::string>{"@@@","@@@","@@@","..."},           /* => const std::vector<std::string>& vsGrayscaleDirTokens */ \
     0,                                                           /* => size_t nOutputIdxOffset */ \
-    bool(WRITE_IMG_OUTPUT),                                      /* => bool bSaveOutput */ \
-    bool(EVALUATE_OUTPUT),                                       /* => bool bUseEvaluator */ \
-    bool(USE_GPU_IMPL),                                          /* => bool bForce4ByteDataAlign */ \
+    bSaveOutput,                                                 /* => bool bSaveOutput */ \
+    bUseEvaluator,                                               /* => bool bUseEvaluator */ \
+    bForce4ByteDataAlign,                                        /* => bool bForce4ByteDataAlign */ \
     DATASET_SCALE_FACTOR                                         /* => double dScaleFactor */
 #else //defined(DATASET_ID)
-#define DATASET_PARAMS \
+#define DATASET_PARAMS(bSaveOutput,bUseEvaluator,bForce4ByteDataAlign) \
     DATASET_OUTPUT_PATH,                                         /* => const std::string& sOutputDirName */ \
-    bool(WRITE_IMG_OUTPUT),                                      /* => bool bSaveOutput */ \
-    bool(EVALUATE_OUTPUT),                                       /* => bool bUseEvaluator */ \
-    bool(USE_GPU_IMPL),                                          /* => bool bForce4ByteDataAlign */ \
+    bSaveOutput,                                                 /* => bool bSaveOutput */ \
+    bUseEvaluator,                                               /* => bool bUseEvaluator */ \
+    bForce4ByteDataAlign,                                        /* => bool bForce4ByteDataAlign */ \
     DATASET_SCALE_FACTOR                                         /* => double dScaleFactor */
 #endif //defined(DATASET_ID)
 void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch);
 #if USE_GLSL_IMPL
-static_assert(false,"Missing impl");
 constexpr lv::ParallelAlgoType eImplTypeEnum = lv::GLSL;
 #else // USE_..._IMPL
 constexpr lv::ParallelAlgoType eImplTypeEnum = lv::NonParallel;
@@ -90,75 +95,230 @@ using EdgeDetectorType = EdgeDetectorCanny;
 #elif USE_LBSP
 using EdgeDetectorType = EdgeDetectorLBSP;
 #endif //USE_...
-std::atomic_size_t g_nActiveThreads(0);
 const size_t g_nMaxThreads = USE_GPU_IMPL?1:std::thread::hardware_concurrency()>0?std::thread::hardware_concurrency():DEFAULT_NB_THREADS;
 
-int main(int, char**) {
+namespace {
+
+    struct BenchmarkParams {
+        std::vector<std::string> vsAlgoNames = {"Canny","LBSP"};
+        size_t nMaxBatches = 3;
+        size_t nMaxFrames = 300;
+        size_t nWarmupFrames = 5;
+        std::string sOutputPath = "edges_bench.json";
+        bool bFullThreshAnalysis = bool(FULL_THRESH_ANALYSIS); // if false, only the default threshold is applied
+    };
+
+    struct BenchmarkResult {
+        std::string sAlgoName;
+        size_t nFrames;
+        double dFramesPerSec;
+        double dLatencyP50_ms, dLatencyP99_ms;
+        size_t nPeakRSS;
+    };
+
+    std::shared_ptr<IEdgeDetector> createBenchmarkAlgo(const std::string& sAlgoName) {
+        if(sAlgoName=="Canny")
+            return std::make_shared<EdgeDetectorCanny>();
+        else if(sAlgoName=="LBSP")
+            return std::make_shared<EdgeDetectorLBSP>();
+        lvError_("unknown algorithm name '%s' (should be Canny or LBSP)",sAlgoName.c_str());
+    }
+
+    /// returns the nearest-rank percentile of a sorted (non-empty) value array
+    double getPercentile(const std::vector<double>& vdSortedVals, double dPercentile) {
+        const size_t nRank = (size_t)std::ceil(dPercentile/100*vdSortedVals.size());
+        return vdSortedVals[std::max(nRank,size_t(1))-1];
+    }
+
+    std::string escapeJSON(const std::string& sInput) {
+        std::string sOutput;
+        for(char c : sInput) {
+            if(c=='"' || c=='\\')
+                sOutput += '\\';
+            if(c=='\n')
+                sOutput += "\\n";
+            else
+                sOutput += c;
+        }
+        return sOutput;
+    }
+
+    /// parses a comma-separated list of names
+    std::vector<std::string> splitNames(const std::string& sNames) {
+        std::vector<std::string> vsNames;
+        const std::string sList = sNames+",";
+        for(size_t nBegin=0, nEnd; (nEnd=sList.find(',',nBegin))!=std::string::npos; nBegin=nEnd+1)
+            if(nEnd>nBegin)
+                vsNames.push_back(sList.substr(nBegin,nEnd-nBegin));
+        return vsNames;
+    }
+
+    /// appends the latency stats of an algorithm (from its per-frame apply times) to the result list, and prints them
+    void addBenchmarkResult(std::vector<BenchmarkResult>& voResults, const std::string& sAlgoName, std::vector<double>& vdLatencies) {
+        lvAssert__(!vdLatencies.empty(),"benchmark subset has no frames past the warmup period for '%s'",sAlgoName.c_str());
+        std::sort(vdLatencies.begin(),vdLatencies.end());
+        const double dTotTime = std::max(std::accumulate(vdLatencies.begin(),vdLatencies.end(),0.0),1e-9);
+        voResults.push_back(BenchmarkResult{sAlgoName,vdLatencies.size(),vdLatencies.size()/dTotTime,getPercentile(vdLatencies,50)*1e3,getPercentile(vdLatencies,99)*1e3,lv::GetPeakPhysMemBytesUsed()});
+        const BenchmarkResult& oResult = voResults.back();
+        std::cout << std::setw(12) << std::left << sAlgoName << std::right << std::fixed << std::setprecision(2) << std::setw(10) << oResult.dFramesPerSec << " fps"
+                  << std::setw(10) << oResult.dLatencyP50_ms << " ms p50" << std::setw(10) << oResult.dLatencyP99_ms << " ms p99"
+                  << std::setw(10) << std::setprecision(1) << oResult.nPeakRSS/(1024.0*1024.0) << " MB peak RSS" << std::setw(8) << oResult.nFrames << " frames" << std::endl;
+    }
+
+    void writeBenchmarkJSON(const BenchmarkParams& oParams, const std::vector<BenchmarkResult>& voResults, const std::string& sDatasetName, bool bPeakRSSResettable) {
+        std::ofstream oFile(oParams.sOutputPath);
+        lvAssert__(oFile.is_open(),"could not open output file at '%s'",oParams.sOutputPath.c_str());
+        oFile << "{\n  \"context\": {\n";
+        oFile << "    \"date\": \"" << escapeJSON(lv::getTimeStamp()) << "\",\n";
+        oFile << "    \"library_version\": \"" << escapeJSON(lv::getVersionStamp()) << "\",\n";
+        oFile << "    \"dataset\": \"" << escapeJSON(sDatasetName) << "\",\n";
+        oFile << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+        oFile << "    \"max_batches\": " << oParams.nMaxBatches << ", \"max_frames\": " << oParams.nMaxFrames << ", \"warmup_frames\": " << oParams.nWarmupFrames << ",\n";
+        oFile << "    \"peak_rss_per_algo\": " << (bPeakRSSResettable?"true":"false") << "\n  },\n"; // if false, peak RSS values are process-wide (cumulative)
+        oFile << "  \"benchmarks\": [";
+        for(size_t nResultIdx=0; nResultIdx<voResults.size(); ++nResultIdx) {
+            const BenchmarkResult& oResult = voResults[nResultIdx];
+            oFile << (nResultIdx?",":"") << "\n    {\"name\": \"" << escapeJSON(oResult.sAlgoName) << "\", \"frames\": " << oResult.nFrames;
+            oFile << ", \"frames_per_second\": " << std::fixed << std::setprecision(3) << oResult.dFramesPerSec;
+            oFile << ", \"latency_p50_ms\": " << oResult.dLatencyP50_ms << ", \"latency_p99_ms\": " << oResult.dLatencyP99_ms;
+            oFile << ", \"peak_rss_bytes\": " << oResult.nPeakRSS << "}";
+        }
+        oFile << "\n  ]\n}\n";
+    }
+
+    void runBenchmark(const BenchmarkParams& oParams) {
+        using BenchmarkDatasetType = lv::Dataset_<lv::DatasetTask_EdgDet,lv::DATASET_ID,lv::NonParallel>;
+        lv::IDatasetPtr pDataset = lv::datasets::create<lv::DatasetTask_EdgDet,lv::DATASET_ID,lv::NonParallel>(DATASET_PARAMS(false,false,false));
+        lv::IDataHandlerPtrArray vpBatches = pDataset->getBatches(false);
+        if(vpBatches.size()>oParams.nMaxBatches)
+            vpBatches.resize(oParams.nMaxBatches);
+        lvAssert__(!vpBatches.empty(),"Could not parse any data for dataset '%s'",pDataset->getName().c_str());
+        std::cout << lv::getLogStamp() << "Benchmarking " << oParams.vsAlgoNames.size() << " algorithm(s) on " << vpBatches.size() << " batch(es) of '" << pDataset->getName() << "'...\n" << std::endl;
+        std::vector<BenchmarkResult> voResults;
+        bool bPeakRSSResettable = true;
+        for(const std::string& sAlgoName : oParams.vsAlgoNames) {
+            bPeakRSSResettable &= lv::ResetPeakPhysMemBytesUsed();
+            std::vector<double> vdLatencies;
+            for(const lv::IDataHandlerPtr& pBatch : vpBatches) {
+                BenchmarkDatasetType::WorkBatch& oBatch = dynamic_cast<BenchmarkDatasetType::WorkBatch&>(*pBatch);
+                const size_t nImageCount = std::min(oBatch.getImageCount(),oParams.nMaxFrames);
+                oBatch.startAsyncPrecaching(false);
+                srand(0);
+                std::shared_ptr<IEdgeDetector> pAlgo = createBenchmarkAlgo(sAlgoName);
+                const double dDefaultThreshold = pAlgo->getDefaultThreshold();
+                cv::Mat oEdgeMask;
+                lv::StopWatch oStopWatch;
+                for(size_t nImageIdx=0; nImageIdx<nImageCount; ++nImageIdx) {
+                    const cv::Mat& oInput = oBatch.getInput(nImageIdx); // fetching is not timed (precached)
+                    oStopWatch.tick();
+                    if(oParams.bFullThreshAnalysis)
+                        pAlgo->apply(oInput,oEdgeMask);
+                    else
+                        pAlgo->apply_threshold(oInput,oEdgeMask,dDefaultThreshold);
+                    const double dLatency = oStopWatch.tock();
+                    if(nImageIdx>=oParams.nWarmupFrames)
+                        vdLatencies.push_back(dLatency);
+                }
+                oBatch.stopAsyncPrecaching();
+            }
+            addBenchmarkResult(voResults,sAlgoName,vdLatencies);
+        }
+        writeBenchmarkJSON(oParams,voResults,pDataset->getName(),bPeakRSSResettable);
+        std::cout << "\nwrote " << voResults.size() << " results to '" << oParams.sOutputPath << "'" << std::endl;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
     try {
-        lv::IDatasetPtr pDataset = lv::datasets::create<lv::DatasetTask_EdgDet,lv::DATASET_ID,eImplTypeEnum>(DATASET_PARAMS);
-        lv::IDataHandlerPtrQueue vpBatches = pDataset->getSortedBatches(false);
+        BenchmarkParams oBenchParams;
+        bool bBenchmarkMode = false;
+        for(int nArgIdx=1; nArgIdx<argc; ++nArgIdx) {
+            const std::string sArg(argv[nArgIdx]);
+            if(sArg=="--benchmark")
+                bBenchmarkMode = true;
+            else if(sArg.compare(0,8,"--algos=")==0)
+                oBenchParams.vsAlgoNames = splitNames(sArg.substr(8));
+            else if(sArg.compare(0,10,"--batches=")==0)
+                oBenchParams.nMaxBatches = (size_t)std::stoul(sArg.substr(10));
+            else if(sArg.compare(0,9,"--frames=")==0)
+                oBenchParams.nMaxFrames = (size_t)std::stoul(sArg.substr(9));
+            else if(sArg.compare(0,9,"--warmup=")==0)
+                oBenchParams.nWarmupFrames = (size_t)std::stoul(sArg.substr(9));
+            else if(sArg.compare(0,6,"--out=")==0)
+                oBenchParams.sOutputPath = sArg.substr(6);
+            else if(sArg.compare(0,14,"--full-thresh=")==0)
+                oBenchParams.bFullThreshAnalysis = std::stoi(sArg.substr(14))!=0;
+            else
+                lvError_("unknown argument '%s'",sArg.c_str());
+        }
+        if(bBenchmarkMode) {
+            runBenchmark(oBenchParams);
+            return 0;
+        }
+        lv::IDatasetPtr pDataset = lv::datasets::create<lv::DatasetTask_EdgDet,lv::DATASET_ID,eImplTypeEnum>(DATASET_PARAMS(bool(WRITE_IMG_OUTPUT),bool(EVALUATE_OUTPUT),bool(USE_GPU_IMPL)));
+        const lv::IDataHandlerPtrArray vpBatches = pDataset->getBatches(false);
         const size_t nTotPackets = pDataset->getTotPackets();
         const size_t nTotBatches = vpBatches.size();
         if(nTotBatches==0 || nTotPackets==0)
             lvError_("Could not parse any data for dataset '%s'",pDataset->getName().c_str());
         std::cout << "Parsing complete. [" << nTotBatches << " batch(es)]" << std::endl;
         std::cout << "\n[" << lv::getTimeStamp() << "]\n" << std::endl;
-        std::cout << "Executing edge detection with " << ((g_nMaxThreads>nTotBatches)?nTotBatches:g_nMaxThreads) << " thread(s)..." << std::endl;
-        size_t nProcessedBatches = 0;
-        while(!vpBatches.empty()) {
-            while(g_nActiveThreads>=g_nMaxThreads)
-                std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-            lv::IDataHandlerPtr pBatch = vpBatches.top();
-            std::cout << "\tProcessing [" << ++nProcessedBatches << "/" << nTotBatches << "] (" << pBatch->getRelativePath() << ", L=" << std::scientific << std::setprecision(2) << pBatch->getExpectedLoad() << ")" << std::endl;
+        lv::BatchScheduler oScheduler(std::min(g_nMaxThreads,nTotBatches));
+        std::cout << "Executing edge detection with " << oScheduler.getWorkerCount() << " thread(s)..." << std::endl;
+        oScheduler.setProgressCallback([](const lv::IDataHandlerPtr& pBatch, size_t nDoneTasks, size_t nTotTasks, size_t nDonePackets, size_t nTotPackets) {
+            std::cout << "\tCompleted [" << nDoneTasks << "/" << nTotTasks << "] (" << pBatch->getRelativePath() << ", " << std::fixed << std::setprecision(1) << (100.0*nDonePackets)/nTotPackets << "% of all packets)" << std::endl;
+        });
+        std::atomic_size_t nStartedBatches(0);
+        oScheduler.run(vpBatches,[&](const lv::IDataHandlerPtr& pBatch, size_t /*nBeginIdx*/, size_t /*nEndIdx*/, size_t nWorkerIdx) {
+            std::cout << "\tProcessing [" << ++nStartedBatches << "/" << nTotBatches << "] (" << pBatch->getRelativePath() << ", L=" << std::scientific << std::setprecision(2) << pBatch->getExpectedLoad() << ")" << std::endl;
             if(DATASET_PRECACHING)
                 dynamic_cast<DatasetType::WorkBatch&>(*pBatch).startAsyncPrecaching(EVALUATE_OUTPUT);
-            ++g_nActiveThreads;
-            std::thread(Analyze,(int)nProcessedBatches,pBatch).detach();
-            vpBatches.pop();
-        }
-        while(g_nActiveThreads>0)
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            Analyze((int)nWorkerIdx,pBatch);
+        });
         if(pDataset->getProcessedPacketsCountPromise()==nTotPackets)
             pDataset->writeEvalReport();
     }
     catch(const cv::Exception& e) {std::cout << "\n!!!!!!!!!!!!!!\nTop level caught cv::Exception:\n" << e.what() << "\n!!!!!!!!!!!!!!\n" << std::endl; return 1;}
     catch(const std::exception& e) {std::cout << "\n!!!!!!!!!!!!!!\nTop level caught std::exception:\n" << e.what() << "\n!!!!!!!!!!!!!!\n" << std::endl; return 1;}
     catch(...) {std::cout << "\n!!!!!!!!!!!!!!\nTop level caught unhandled exception\n!!!!!!!!!!!!!!\n" << std::endl; return 1;}
+    lv::AsyncLogger::flush();
     std::cout << "\n[" << lv::getTimeStamp() << "]\n" << std::endl;
     std::cout << "All done." << std::endl;
     return 0;
 }
 
 #if (HAVE_GLSL && USE_GLSL_IMPL)
-static_assert(false,"Missing impl");
 void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch) {
     srand(0); // for now, assures that two consecutive runs on the same data return the same results
     //srand((unsigned int)time(NULL));
-    size_t nCurrImageIdx = 0;
-    size_t nNextImageIdx = nCurrImageIdx+1;
-    bool bGPUContextInitialized = false;
     try {
         DatasetType::WorkBatch& oBatch = dynamic_cast<DatasetType::WorkBatch&>(*pBatch);
         lvAssert(oBatch.getImageCount()>1);
         const std::string sCurrBatchName = lv::clampString(oBatch.getName(),12);
         const size_t nTotPacketCount = oBatch.getImageCount();
-        GLContext oContext(oBatch.getMaxImageSize(),std::string("[GPU] ")+oBatch.getRelativePath(),DISPLAY_OUTPUT==0);
+        lvAssert(oBatch.isInputConstantSize() && oBatch.getInputPacketType()==lv::ImagePacket);
+        GLContext oContext(oBatch.getInputMaxSize(),std::string("[GPU] ")+oBatch.getRelativePath(),DISPLAY_OUTPUT==0);
         std::shared_ptr<IEdgeDetector_<lv::GLSL>> pAlgo = std::make_shared<EdgeDetectorType>();
 #if DISPLAY_OUTPUT>1
         cv::DisplayHelperPtr pDisplayHelper = cv::DisplayHelper::create(oBatch.getName(),oBatch.getOutputPath()+"/../");
         pAlgo->m_pDisplayHelper = pDisplayHelper;
 #endif //DISPLAY_OUTPUT>1
-        const double dDefaultLearningRate = pAlgo->getDefaultLearningRate();
+#if FULL_THRESH_ANALYSIS
+        const double dThreshold = -1; // all thresholds are encoded in the output edge mask
+#else //(!FULL_THRESH_ANALYSIS)
+        const double dThreshold = pAlgo->getDefaultThreshold();
+#endif //(!FULL_THRESH_ANALYSIS)
         oBatch.initialize_gl(pAlgo);
         oContext.setWindowSize(oBatch.getIdealGLWindowSize());
         oBatch.startProcessing();
         size_t nNextIdx = 1;
+        // the consumer uploads image N+1 while image N is processed, and reads back image N-1's edge mask (evaluated on a cpu worker);
+        // the last iteration re-processes the final image only to flush its output
         while(nNextIdx<=nTotPacketCount) {
             if(!(nNextIdx%100))
-                std::cout << "\t\t" << lv::clampString(sCurrBatchName,12) << " @ F:" << std::setfill('0') << std::setw(lv::digit_count((int)nTotPacketCount)) << nNextIdx << "/" << nTotPacketCount << "   [GPU]" << std::endl;
-            const double dCurrLearningRate = nNextIdx<=100?1:dDefaultLearningRate;
-            oBatch.apply_gl(pAlgo,nNextIdx++,false,dCurrLearningRate);
-            //pGLSLAlgoEvaluator->apply_gl(oNextGTMask);
+                lvLogInfo("\t\t%s @ F:%0*d/%d   [GPU]",lv::clampString(sCurrBatchName,12),lv::digit_count((int)nTotPacketCount),(int)nNextIdx,(int)nTotPacketCount);
+            oBatch.apply_gl(pAlgo,nNextIdx++,false,dThreshold);
             glErrorCheck;
             if(oContext.pollEventsAndCheckIfShouldClose())
                 break;
@@ -176,7 +336,7 @@ void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch) {
         oBatch.stopProcessing();
         const double dTimeElapsed = oBatch.getProcessTime();
         const double dProcessSpeed = (double)(nNextIdx-1)/dTimeElapsed;
-        std::cout << "\t\t" << sCurrBatchName << " @ F:" << (nNextIdx-1) << "/" << nTotPacketCount << "   [T=" << nThreadIdx << "]   (" << std::fixed << std::setw(4) << dTimeElapsed << " sec, " << std::setw(4) << dProcessSpeed << " Hz)" << std::endl;
+        lvLogInfo("\t\t%s @ F:%d/%d   [T=%d]   (%4f sec, %4f Hz)",sCurrBatchName,(int)(nNextIdx-1),(int)nTotPacketCount,nThreadIdx,dTimeElapsed,dProcessSpeed);
         oBatch.writeEvalReport(); // this line is optional; it allows results to be read before all batches are processed
     }
     catch(const lv::Exception& e) {
@@ -188,7 +348,6 @@ void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch) {
     catch(const cv::Exception& e) {std::cout << "\nAnalyze caught cv::Exception:\n" << e.what() << "\n" << std::endl;}
     catch(const std::exception& e) {std::cout << "\nAnalyze caught std::exception:\n" << e.what() << "\n" << std::endl;}
     catch(...) {std::cout << "\nAnalyze caught unhandled exception\n" << std::endl;}
-    --g_nActiveThreads;
     try {
         DatasetType::WorkBatch& oBatch = dynamic_cast<DatasetType::WorkBatch&>(*pBatch);
         if(oBatch.isProcessing())
@@ -212,7 +371,7 @@ void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch) {
         lvAssert(oBatch.getImageCount()>1);
         const std::string sCurrBatchName = lv::clampString(oBatch.getName(),12);
         const size_t nTotPacketCount = oBatch.getImageCount();
-        cv::Mat oCurrInput = oBatch.getInput(nCurrIdx).clone();
+        cv::Mat oCurrInput = oBatch.getInput(nCurrIdx);
         lvAssert(!oCurrInput.empty() && oCurrInput.isContinuous());
         lvAssert(oBatch.isInputConstantSize() && oBatch.getInputPacketType()==lv::ImagePacket);
         cv::Mat oCurrEdgeMask(oBatch.getInputMaxSize(),CV_8UC1,cv::Scalar_<uchar>(0));
@@ -227,7 +386,7 @@ void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch) {
         oBatch.startProcessing();
         while(nCurrIdx<nTotPacketCount) {
             //if(!((nCurrIdx+1)%100) && nCurrIdx<nTotPacketCount)
-                std::cout << "\t\t" << sCurrBatchName << " @ F:" << std::setfill('0') << std::setw(lv::digit_count((int)nTotPacketCount)) << nCurrIdx+1 << "/" << nTotPacketCount << "   [T=" << nThreadIdx << "]" << std::endl;
+                lvLogInfo("\t\t%s @ F:%0*d/%d   [T=%d]",sCurrBatchName,lv::digit_count((int)nTotPacketCount),(int)(nCurrIdx+1),(int)nTotPacketCount,nThreadIdx);
             oCurrInput = oBatch.getInput(nCurrIdx);
 #if FULL_THRESH_ANALYSIS
             pAlgo->apply(oCurrInput,oCurrEdgeMask);
@@ -245,13 +404,12 @@ void Analyze(int nThreadIdx, lv::IDataHandlerPtr pBatch) {
         oBatch.stopProcessing();
         const double dTimeElapsed = oBatch.getProcessTime();
         const double dProcessSpeed = (double)nCurrIdx/dTimeElapsed;
-        std::cout << "\t\t" << sCurrBatchName << " @ F:" << nCurrIdx << "/" << nTotPacketCount << "   [T=" << nThreadIdx << "]   (" << std::fixed << std::setw(4) << dTimeElapsed << " sec, " << std::setw(4) << dProcessSpeed << " Hz)" << std::endl;
+        lvLogInfo("\t\t%s @ F:%d/%d   [T=%d]   (%4f sec, %4f Hz)",sCurrBatchName,(int)nCurrIdx,(int)nTotPacketCount,nThreadIdx,dTimeElapsed,dProcessSpeed);
         oBatch.writeEvalReport(); // this line is optional; it allows results to be read before all batches are processed
     }
     catch(const cv::Exception& e) {std::cout << "\nAnalyze caught cv::Exception:\n" << e.what() << "\n" << std::endl;}
     catch(const std::exception& e) {std::cout << "\nAnalyze caught std::exception:\n" << e.what() << "\n" << std::endl;}
     catch(...) {std::cout << "\nAnalyze caught unhandled exception\n" << std::endl;}
-    --g_nActiveThreads;
     try {
         DatasetType::WorkBatch& oBatch = dynamic_cast<DatasetType::WorkBatch&>(*pBatch);
         if(oBatch.isProcessing())
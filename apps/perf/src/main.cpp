@@ -0,0 +1,340 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/features2d.hpp"
+#include "litiv/imgproc.hpp"
+#include "litiv/video.hpp"
+#include "litiv/datasets.hpp"
+#include <iomanip>
+
+// usage: litiv_perf [--baseline=<baseline.yml>] [--tolerance=<percent>] [--update-baseline] [--out=<results.yml>] [--filter=<name substring>] [--repeat=<N>]
+//
+// runs end-to-end scenarios at fixed sizes on the bundled sample data, and compares their median times with the ones stored in the
+// baseline file; scenarios slower than their baseline by more than the tolerance are flagged, and the exit code is then non-zero.
+// if the baseline file does not exist yet (or if --update-baseline is given), it is (re)written using the current results instead.
+// consistency checks (output equivalence between code paths) are run before timing, and any failure also makes the exit code non-zero.
+
+#define PERF_FRAME_SIZE             cv::Size(640,480) // fixed processing resolution used by all image scenarios
+#define PERF_DEFAULT_TOLERANCE      10.0              // default slowdown percentage above which a scenario is flagged as a regression
+#define PERF_DEFAULT_REPEAT_COUNT   7                 // default number of timed samples per scenario (the median is kept)
+#define PERF_SEQUENCE_LENGTH        64                // number of synthetic frames cycled through by background subtraction scenarios
+#define PERF_IO_PACKET_COUNT        100               // number of packets read/written in each sample of the precacher/writer scenarios
+#define PERF_IO_WORKER_COUNT        4                 // number of decode/write workers used by the precacher/writer scenarios
+#define PERF_CHECK_WARMUP_FRAMES    8                 // number of noisy frames processed by background subtractors before consistency checks
+
+namespace {
+
+    struct PerfResult {
+        std::string sName;
+        double dTime_ms; // median time per sample
+        double dBaseline_ms; // <=0 if no baseline exists for this scenario
+    };
+
+    struct PerfContext {
+        std::string sFilter;
+        size_t nRepeatCount = PERF_DEFAULT_REPEAT_COUNT;
+        std::vector<PerfResult> voResults;
+        std::map<std::string,double> mBaselines;
+        size_t nFailedChecks = 0;
+    };
+
+    /// result accumulator used to keep the compiler from optimizing away the timed calls
+    volatile size_t g_nSink = 0;
+
+    /// runs a scenario once untimed (warmup), then nRepeatCount times, and keeps the median time (one sample = one call of lFunc)
+    void runScenario(PerfContext& oCtx, const std::string& sName, const std::function<void()>& lFunc) {
+        if(!oCtx.sFilter.empty() && sName.find(oCtx.sFilter)==std::string::npos)
+            return;
+        lFunc();
+        std::vector<double> vdTimes_ms(oCtx.nRepeatCount);
+        lv::StopWatch oStopWatch;
+        for(size_t nSampleIdx=0; nSampleIdx<oCtx.nRepeatCount; ++nSampleIdx) {
+            oStopWatch.tick();
+            lFunc();
+            vdTimes_ms[nSampleIdx] = oStopWatch.tock()*1e3;
+        }
+        std::nth_element(vdTimes_ms.begin(),vdTimes_ms.begin()+vdTimes_ms.size()/2,vdTimes_ms.end());
+        const double dTime_ms = vdTimes_ms[vdTimes_ms.size()/2];
+        auto pBaseline = oCtx.mBaselines.find(sName);
+        const double dBaseline_ms = (pBaseline!=oCtx.mBaselines.end())?pBaseline->second:0.0;
+        oCtx.voResults.push_back(PerfResult{sName,dTime_ms,dBaseline_ms});
+        std::cout << std::setw(40) << std::left << sName << std::right << std::setw(12) << std::fixed << std::setprecision(3) << dTime_ms << " ms";
+        if(dBaseline_ms>0)
+            std::cout << std::setw(12) << dBaseline_ms << " ms" << std::setw(10) << std::showpos << std::setprecision(1) << (dTime_ms/dBaseline_ms-1)*100 << std::noshowpos << " %";
+        std::cout << std::endl;
+    }
+
+    /// runs a consistency check once (untimed), and counts it as failed if lFunc returns false
+    void runCheck(PerfContext& oCtx, const std::string& sName, const std::function<bool()>& lFunc) {
+        if(!oCtx.sFilter.empty() && sName.find(oCtx.sFilter)==std::string::npos)
+            return;
+        const bool bPassed = lFunc();
+        if(!bPassed)
+            ++oCtx.nFailedChecks;
+        std::cout << std::setw(40) << std::left << sName << std::right << std::setw(15) << (bPassed?"passed":"FAILED") << std::endl;
+    }
+
+    /// cycles through a synthetic sequence (a static background with a bouncing object) built from the sample image
+    std::vector<cv::Mat> createSequence(const cv::Mat& oBackground) {
+        std::vector<cv::Mat> voFrames(PERF_SEQUENCE_LENGTH);
+        const cv::Size oObjectSize(oBackground.cols/8,oBackground.rows/8);
+        const int nRangeX = oBackground.cols-oObjectSize.width, nRangeY = oBackground.rows-oObjectSize.height;
+        for(size_t nFrameIdx=0; nFrameIdx<voFrames.size(); ++nFrameIdx) {
+            oBackground.copyTo(voFrames[nFrameIdx]);
+            const int nPosX = int((nFrameIdx*13)%(2*nRangeX)), nPosY = int((nFrameIdx*7)%(2*nRangeY));
+            cv::rectangle(voFrames[nFrameIdx],cv::Rect(cv::Point(nPosX<nRangeX?nPosX:2*nRangeX-nPosX,nPosY<nRangeY?nPosY:2*nRangeY-nPosY),oObjectSize),cv::Scalar::all(255),-1);
+        }
+        return voFrames;
+    }
+
+    /// adds a scenario processing one frame per sample with an initialized background subtractor (state keeps evolving across samples, like in a real sequence)
+    template<typename TAlgo, typename TInitFunc>
+    void addBGSScenario(PerfContext& oCtx, const std::string& sName, const std::vector<cv::Mat>& voFrames, TAlgo& oAlgo, TInitFunc&& lInit) {
+        if(!oCtx.sFilter.empty() && sName.find(oCtx.sFilter)==std::string::npos)
+            return;
+        lInit(oAlgo,voFrames[0]);
+        cv::Mat oFGMask;
+        size_t nFrameIdx = 0;
+        for(; nFrameIdx<PERF_SEQUENCE_LENGTH/2; ++nFrameIdx) // lets the model settle before timing
+            oAlgo.apply(voFrames[nFrameIdx],oFGMask);
+        runScenario(oCtx,sName,[&]() {
+            oAlgo.apply(voFrames[(nFrameIdx++)%voFrames.size()],oFGMask);
+            g_nSink += oFGMask.data[oFGMask.total()/2];
+        });
+    }
+
+    void addLBSPScenarios(PerfContext& oCtx, const cv::Mat& oFrame_3ch, const cv::Mat& oFrame_1ch) {
+        const LBSP oRelExtractor(0.333f);
+        const LBSP oAbsExtractor(size_t(30));
+        cv::Mat oDescMap;
+        runScenario(oCtx,"lbsp/computeDense_rel/3ch",[&]() {oRelExtractor.computeDense(oFrame_3ch,oDescMap);});
+        runScenario(oCtx,"lbsp/computeDense_rel/1ch",[&]() {oRelExtractor.computeDense(oFrame_1ch,oDescMap);});
+        runScenario(oCtx,"lbsp/computeDense_abs/3ch",[&]() {oAbsExtractor.computeDense(oFrame_3ch,oDescMap);});
+    }
+
+    void addBGSScenarios(PerfContext& oCtx, const cv::Mat& oFrame_3ch) {
+        const std::vector<cv::Mat> voFrames = createSequence(oFrame_3ch);
+        const auto lInitLBSPAlgo = [](IBackgroundSubtractor& oAlgo, const cv::Mat& oInit) {oAlgo.initialize(oInit,cv::Mat());};
+        const auto lInitCVAlgo = [](auto& oAlgo, const cv::Mat& oInit) {oAlgo.initialize(oInit);};
+        {
+            BackgroundSubtractorLOBSTER oAlgo;
+            addBGSScenario(oCtx,"bgs/LOBSTER/3ch",voFrames,oAlgo,lInitLBSPAlgo);
+        }
+        {
+            BackgroundSubtractorSuBSENSE oAlgo;
+            addBGSScenario(oCtx,"bgs/SuBSENSE/3ch",voFrames,oAlgo,lInitLBSPAlgo);
+        }
+        {
+            BackgroundSubtractorPAWCS oAlgo;
+            addBGSScenario(oCtx,"bgs/PAWCS/3ch",voFrames,oAlgo,lInitLBSPAlgo);
+        }
+        {
+            BackgroundSubtractorViBe_3ch oAlgo;
+            addBGSScenario(oCtx,"bgs/ViBe/3ch",voFrames,oAlgo,lInitCVAlgo);
+        }
+        {
+            BackgroundSubtractorPBAS_3ch oAlgo;
+            addBGSScenario(oCtx,"bgs/PBAS/3ch",voFrames,oAlgo,lInitCVAlgo);
+        }
+    }
+
+    void addConsistencyChecks(PerfContext& oCtx, const cv::Mat& oFrame_1ch) {
+        runCheck(oCtx,"check/SuBSENSE/classify_vs_apply/16u",[&]() {
+            // the noise amplitude puts many 16-bit color distances right around the (scaled) thresholds, where rounding differences would show
+            cv::Mat oBackground_16u;
+            oFrame_1ch.convertTo(oBackground_16u,CV_16U,BGSLBSP_16BIT_INTENSITY_SCALE);
+            cv::RNG oRNG(0);
+            const auto lGetNoisyFrame = [&]() {
+                cv::Mat oNoise(oBackground_16u.size(),CV_32SC1),oFrame;
+                oRNG.fill(oNoise,cv::RNG::UNIFORM,-20*BGSLBSP_16BIT_INTENSITY_SCALE,20*BGSLBSP_16BIT_INTENSITY_SCALE);
+                cv::Mat oFrame_32s;
+                oBackground_16u.convertTo(oFrame_32s,CV_32S);
+                cv::Mat(oFrame_32s+oNoise).convertTo(oFrame,CV_16U); // saturates
+                return oFrame;
+            };
+            BackgroundSubtractorSuBSENSE oAlgo;
+            oAlgo.initialize(oBackground_16u,cv::Mat());
+            cv::Mat oFGMask_apply,oFGMask_classify;
+            for(size_t nFrameIdx=0; nFrameIdx<PERF_CHECK_WARMUP_FRAMES; ++nFrameIdx) // spreads the per-pixel thresholds (odd & even ones)
+                oAlgo.apply(lGetNoisyFrame(),oFGMask_apply);
+            const cv::Mat oFrame = lGetNoisyFrame();
+            oAlgo.classify(oFrame,oFGMask_classify);
+            // with learning disabled, 'apply' does not touch the samples matched by the following pixels, so both masks must be identical
+            oAlgo.apply(oFrame,oFGMask_apply,std::numeric_limits<double>::infinity());
+            return cv::countNonZero(oFGMask_apply!=oFGMask_classify)==0;
+        });
+    }
+
+    void addEdgeScenarios(PerfContext& oCtx, const cv::Mat& oFrame_3ch) {
+        cv::Mat oEdgeMask;
+        const auto lAddDetector = [&](IEdgeDetector& oAlgo, const std::string& sAlgoName) {
+            const double dThreshold = oAlgo.getDefaultThreshold();
+            runScenario(oCtx,"edges/"+sAlgoName+"/sweep",[&]() {oAlgo.apply(oFrame_3ch,oEdgeMask);});
+            runScenario(oCtx,"edges/"+sAlgoName+"/threshold",[&]() {oAlgo.apply_threshold(oFrame_3ch,oEdgeMask,dThreshold);});
+        };
+        EdgeDetectorCanny oCanny;
+        lAddDetector(oCanny,"Canny");
+        EdgeDetectorLBSP oLBSP;
+        lAddDetector(oLBSP,"LBSP");
+    }
+
+    void addIOScenarios(PerfContext& oCtx, const cv::Mat& oFrame_3ch) {
+        std::vector<uchar> vnEncodedFrame;
+        cv::imencode(".jpg",oFrame_3ch,vnEncodedFrame);
+        runScenario(oCtx,"io/precacher/decode",[&]() {
+            // packets are decoded from an in-memory jpeg, so that only decoding & precaching costs are measured (not disk I/O)
+            cv::Mat oLastPacket;
+            lv::DataPrecacher oPrecacher(
+                [&](size_t nIdx) -> const cv::Mat& {
+                    oLastPacket = (nIdx<PERF_IO_PACKET_COUNT)?cv::imdecode(vnEncodedFrame,cv::IMREAD_COLOR):cv::Mat();
+                    return oLastPacket;
+                },
+                [&](size_t nIdx) {
+                    return (nIdx<PERF_IO_PACKET_COUNT)?cv::imdecode(vnEncodedFrame,cv::IMREAD_COLOR):cv::Mat();
+                }
+            );
+            oPrecacher.setDecodeWorkerCount(PERF_IO_WORKER_COUNT);
+            lvAssert_(oPrecacher.startAsyncPrecaching(PERF_IO_PACKET_COUNT*oFrame_3ch.total()*oFrame_3ch.elemSize()),"could not start precacher");
+            for(size_t nPacketIdx=0; nPacketIdx<PERF_IO_PACKET_COUNT; ++nPacketIdx)
+                g_nSink += oPrecacher.getPacket(nPacketIdx).data[0];
+            oPrecacher.stopAsyncPrecaching();
+        });
+        runScenario(oCtx,"io/writer/encode",[&]() {
+            // packets are encoded to in-memory pngs, so that only queueing & encoding costs are measured (not disk I/O)
+            std::atomic_size_t nTotEncodedBytes(0);
+            lv::DataWriter oWriter([&](const cv::Mat& oPacket, size_t) {
+                std::vector<uchar> vnBuffer;
+                cv::imencode(".png",oPacket,vnBuffer,{cv::IMWRITE_PNG_COMPRESSION,1});
+                nTotEncodedBytes += vnBuffer.size();
+                return vnBuffer.size();
+            });
+            lvAssert_(oWriter.startAsyncWriting(PERF_IO_PACKET_COUNT*oFrame_3ch.total()*oFrame_3ch.elemSize(),false,PERF_IO_WORKER_COUNT),"could not start writer");
+            for(size_t nPacketIdx=0; nPacketIdx<PERF_IO_PACKET_COUNT; ++nPacketIdx)
+                oWriter.queue(oFrame_3ch,nPacketIdx);
+            oWriter.stopAsyncWriting();
+            g_nSink += nTotEncodedBytes;
+        });
+    }
+
+    void addMetricsScenarios(PerfContext& oCtx, const cv::Mat& oFrame_1ch) {
+        const cv::Mat oGT = oFrame_1ch>128;
+        cv::Mat oBlurred;
+        cv::GaussianBlur(oFrame_1ch,oBlurred,cv::Size(9,9),0);
+        const cv::Mat oClassif = oBlurred>120;
+        lv::BinClassifMetricsAccumulatorPtr pMetrics = lv::BinClassifMetricsAccumulator::create();
+        runScenario(oCtx,"metrics/accumulate",[&]() {pMetrics->accumulate(oClassif,oGT);});
+        lv::ThreadPool oThreadPool;
+        runScenario(oCtx,"metrics/accumulate_banded",[&]() {pMetrics->accumulate(oClassif,oGT,cv::Mat(),oThreadPool);});
+        g_nSink += pMetrics->nTP;
+    }
+
+    void readBaselines(PerfContext& oCtx, const std::string& sBaselinePath) {
+        cv::FileStorage oFS(sBaselinePath,cv::FileStorage::READ);
+        if(!oFS.isOpened())
+            return;
+        const cv::FileNode oScenarios = oFS["scenarios"];
+        for(auto pScenario=oScenarios.begin(); pScenario!=oScenarios.end(); ++pScenario)
+            oCtx.mBaselines[(std::string)(*pScenario)["name"]] = (double)(*pScenario)["time_ms"];
+    }
+
+    void writeResults(const PerfContext& oCtx, const std::string& sOutputPath) {
+        cv::FileStorage oFS(sOutputPath,cv::FileStorage::WRITE);
+        lvAssert__(oFS.isOpened(),"could not open output file at '%s'",sOutputPath.c_str());
+        oFS << "date" << lv::getTimeStamp();
+        oFS << "library_version" << lv::getVersionStamp();
+        oFS << "num_cpus" << (int)std::thread::hardware_concurrency();
+        oFS << "scenarios" << "[";
+        for(const PerfResult& oResult : oCtx.voResults)
+            oFS << "{" << "name" << oResult.sName << "time_ms" << oResult.dTime_ms << "}";
+        oFS << "]";
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        PerfContext oCtx;
+        std::string sBaselinePath = "litiv_perf_baseline.yml";
+        std::string sOutputPath = "litiv_perf_results.yml";
+        double dTolerance = PERF_DEFAULT_TOLERANCE;
+        bool bUpdateBaseline = false;
+        for(int nArgIdx=1; nArgIdx<argc; ++nArgIdx) {
+            const std::string sArg(argv[nArgIdx]);
+            if(sArg.compare(0,11,"--baseline=")==0)
+                sBaselinePath = sArg.substr(11);
+            else if(sArg.compare(0,12,"--tolerance=")==0)
+                dTolerance = std::stod(sArg.substr(12));
+            else if(sArg=="--update-baseline")
+                bUpdateBaseline = true;
+            else if(sArg.compare(0,6,"--out=")==0)
+                sOutputPath = sArg.substr(6);
+            else if(sArg.compare(0,9,"--filter=")==0)
+                oCtx.sFilter = sArg.substr(9);
+            else if(sArg.compare(0,9,"--repeat=")==0)
+                oCtx.nRepeatCount = (size_t)std::stoul(sArg.substr(9));
+            else
+                lvError_("unknown argument '%s'",sArg.c_str());
+        }
+        lvAssert_(dTolerance>=0,"regression tolerance must be non-negative");
+        lvAssert_(oCtx.nRepeatCount>0,"repeat count must be positive");
+        if(!bUpdateBaseline)
+            readBaselines(oCtx,sBaselinePath);
+        const cv::Mat oSampleImage = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg");
+        lvAssert_(!oSampleImage.empty(),"could not load test image from internal sample data folder");
+        cv::Mat oFrame_3ch,oFrame_1ch;
+        cv::resize(oSampleImage,oFrame_3ch,PERF_FRAME_SIZE,0,0,cv::INTER_LINEAR);
+        cv::cvtColor(oFrame_3ch,oFrame_1ch,cv::COLOR_BGR2GRAY);
+        std::cout << lv::getLogStamp() << "baseline: '" << sBaselinePath << "' (" << oCtx.mBaselines.size() << " scenarios), tolerance: " << dTolerance << "%\n" << std::endl;
+        addConsistencyChecks(oCtx,oFrame_1ch);
+        addLBSPScenarios(oCtx,oFrame_3ch,oFrame_1ch);
+        addBGSScenarios(oCtx,oFrame_3ch);
+        addEdgeScenarios(oCtx,oFrame_3ch);
+        addIOScenarios(oCtx,oFrame_3ch);
+        addMetricsScenarios(oCtx,oFrame_1ch);
+        writeResults(oCtx,sOutputPath);
+        std::cout << "\nwrote " << oCtx.voResults.size() << " results to '" << sOutputPath << "'" << std::endl;
+        if(oCtx.nFailedChecks) {
+            std::cout << oCtx.nFailedChecks << " consistency check(s) failed" << std::endl;
+            return 2;
+        }
+        if(oCtx.mBaselines.empty()) {
+            writeResults(oCtx,sBaselinePath);
+            std::cout << "wrote new baseline to '" << sBaselinePath << "'" << std::endl;
+            return 0;
+        }
+        size_t nRegressions = 0, nMissingBaselines = 0;
+        for(const PerfResult& oResult : oCtx.voResults) {
+            if(oResult.dBaseline_ms<=0)
+                ++nMissingBaselines;
+            else if((oResult.dTime_ms/oResult.dBaseline_ms-1)*100>dTolerance) {
+                std::cout << "REGRESSION: '" << oResult.sName << "' took " << oResult.dTime_ms << " ms (baseline = " << oResult.dBaseline_ms << " ms)" << std::endl;
+                ++nRegressions;
+            }
+        }
+        if(nMissingBaselines)
+            std::cout << nMissingBaselines << " scenario(s) have no baseline yet (use --update-baseline to record them)" << std::endl;
+        if(nRegressions) {
+            std::cout << nRegressions << " scenario(s) regressed by more than " << dTolerance << "%" << std::endl;
+            return 2;
+        }
+        std::cout << "no regression above " << dTolerance << "%" << std::endl;
+    }
+    catch(const cv::Exception& e) {std::cout << "\n!!!!!!!!!!!!!!\nTop level caught cv::Exception:\n" << e.what() << "\n!!!!!!!!!!!!!!\n" << std::endl; return 1;}
+    catch(const std::exception& e) {std::cout << "\n!!!!!!!!!!!!!!\nTop level caught std::exception:\n" << e.what() << "\n!!!!!!!!!!!!!!\n" << std::endl; return 1;}
+    catch(...) {std::cout << "\n!!!!!!!!!!!!!!\nTop level caught unhandled exception\n!!!!!!!!!!!!!!\n" << std::endl; return 1;}
+    return 0;
+}
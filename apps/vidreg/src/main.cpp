@@ -41,12 +41,24 @@
 #endif //USE_FILESTORAGE_RES_OUTPUT
 #endif //(USE_VIDEOWRITER_RES_OUTPUT||USE_FILESTORAGE_RES_OUTPUT)
 
-#include "MultimodalVideoRegistrAlg.h"
+#include "litiv/imgproc.hpp"
+
+namespace {
+
+    /// paints filled foreground blob contours (with a distinct edge color) over a black image of the given size
+    void paintContours(const std::vector<std::vector<cv::Point>>& vvoContours, const cv::Scalar& vFillColor, const cv::Scalar& vEdgeColor, const cv::Size& oSize, cv::Mat& oOutput) {
+        oOutput.create(oSize,CV_8UC3);
+        oOutput = cv::Scalar_<uchar>::all(0);
+        cv::drawContours(oOutput,vvoContours,-1,vFillColor,cv::FILLED);
+        cv::drawContours(oOutput,vvoContours,-1,vEdgeColor,1);
+    }
+
+} // namespace
 
 int main(int /*argc*/, char **/*argv*/) {
     try {
 
-        MultimodalVideoRegistrAlg oAlg;
+        lv::MultimodalRegistrator oAlg;
 
         cv::Mat oGTTransMat_THERMAL,oGTTransMat_VISIBLE;
         cv::Mat oPolyListMat_THERMAL,oPolyListMat_VISIBLE;
@@ -74,6 +86,8 @@ int main(int /*argc*/, char **/*argv*/) {
         cv::Mat& oContours_ToTransform = oContours_THERMAL;
         cv::Mat& oContours = oContours_VISIBLE;
 #endif //USE_FULL_DEBUG_DISPLAY
+        const cv::Mat& oForeground_ToTransform = oForeground_THERMAL;
+        const cv::Mat& oForeground = oForeground_VISIBLE;
         const cv::Size& oTransformedImageSize = oInputSize_VISIBLE;
         const cv::Mat& oPolyMat_ToTransform = oPolyMat_THERMAL;
         const cv::Mat& oPolyMat = oPolyMat_VISIBLE;
@@ -88,6 +102,8 @@ int main(int /*argc*/, char **/*argv*/) {
         cv::Mat& oContours_ToTransform = oContours_VISIBLE;
         cv::Mat& oContours = oContours_THERMAL;
 #endif //USE_FULL_DEBUG_DISPLAY
+        const cv::Mat& oForeground_ToTransform = oForeground_VISIBLE;
+        const cv::Mat& oForeground = oForeground_THERMAL;
         const cv::Size& oTransformedImageSize = oInputSize_THERMAL;
         const cv::Mat& oPolyMat_ToTransform = oPolyMat_VISIBLE;
         const cv::Mat& oPolyMat = oPolyMat_THERMAL;
@@ -122,40 +138,50 @@ int main(int /*argc*/, char **/*argv*/) {
 
 #if USE_FULL_DEBUG_DISPLAY
         bool bContinuousUpdates = false;
+#endif //USE_FULL_DEBUG_DISPLAY
+        // remap luts are only rebuilt when the estimated transformation changes (by the registrator, for its own warps), and never for the groundtruth one
+#if USE_FULL_DEBUG_DISPLAY
+        lv::PerspectiveWarper oGTSourceWarper,oGTContoursWarper;
+        oGTSourceWarper.setTransform(oGTTransMat,oTransformedImageSize,cv::INTER_LINEAR|cv::WARP_INVERSE_MAP);
+        oGTContoursWarper.setTransform(oGTTransMat,oTransformedImageSize,cv::INTER_LINEAR|cv::WARP_INVERSE_MAP);
 #endif //USE_FULL_DEBUG_DISPLAY
         int nFirstIndex = nFrameCount;
         cv::Point2d oCumulativePolyRegErrors(0,0);
         float fCumulativePolyOverlapErrors = 0.0f;
         float fCumulativeForegroundBlobOverlapErrors = 0.0f;
+        // all four streams are decoded concurrently (plus the bgs conversions), as sequential reads dominated the per-frame time
+        std::array<cv::VideoCapture*,4> apCaptures = {&oCapOrig_THERMAL,&oCapOrig_VISIBLE,&oCapBGS_THERMAL,&oCapBGS_VISIBLE};
+        std::array<cv::Mat,4> aoCapFrames;
+        std::array<cv::Mat*,2> apForegrounds = {&oForeground_THERMAL,&oForeground_VISIBLE};
+        lv::WorkerPool<4> oCapturePool;
+        lv::CountdownLatch oCaptureLatch;
+        const auto lCaptureTask = [&](size_t nCapIdx) {
+            *apCaptures[nCapIdx] >> aoCapFrames[nCapIdx];
+            if(nCapIdx>=2 && !aoCapFrames[nCapIdx].empty())
+                cv::cvtColor(aoCapFrames[nCapIdx],*apForegrounds[nCapIdx-2],cv::COLOR_BGR2GRAY);
+        };
         for(int nCurrFrameIndex=0; nCurrFrameIndex<nFrameCount; ++nCurrFrameIndex) {
             if((nCurrFrameIndex%50)==0)
                 std::cout << "# " << nCurrFrameIndex << std::endl;
-            oCapOrig_THERMAL >> oSource_THERMAL;
-            oCapOrig_VISIBLE >> oSource_VISIBLE;
-            if(oSource_THERMAL.empty() || oSource_VISIBLE.empty())
-                break;
-            cv::Mat oForegroundBGR_THERMAL,oForegroundBGR_VISIBLE;
-            oCapBGS_THERMAL >> oForegroundBGR_THERMAL;
-            oCapBGS_VISIBLE >> oForegroundBGR_VISIBLE;
-            if(oForegroundBGR_THERMAL.empty() || oForegroundBGR_VISIBLE.empty())
+            oCapturePool.submitBulk(apCaptures.size(),lCaptureTask,oCaptureLatch);
+            oCaptureLatch.wait();
+            if(std::any_of(aoCapFrames.begin(),aoCapFrames.end(),[](const cv::Mat& oFrame){return oFrame.empty();}))
                 break;
-            cv::cvtColor(oForegroundBGR_THERMAL,oForeground_THERMAL,cv::COLOR_BGR2GRAY);
-            cv::cvtColor(oForegroundBGR_VISIBLE,oForeground_VISIBLE,cv::COLOR_BGR2GRAY);
-            oAlg.ProcessForeground(oForeground_THERMAL,oForeground_VISIBLE);
-            const cv::Mat& oTransMat = oAlg.GetTransformationMatrix(false);
+            oSource_THERMAL = aoCapFrames[0];
+            oSource_VISIBLE = aoCapFrames[1];
+            oAlg.process(oForeground_ToTransform,oForeground);
+            const cv::Mat& oTransMat = oAlg.getTransform(false);
             if(!oTransMat.empty()) {
                 if(nFirstIndex==nFrameCount)
                     nFirstIndex = nCurrFrameIndex;
-                const cv::Mat& oTransMat_inv = oAlg.GetTransformationMatrix(true);
+                const cv::Mat& oTransMat_inv = oAlg.getTransform(true);
 #if USE_FULL_DEBUG_DISPLAY
-                oContours.create(oTransformedImageSize,CV_8UC3);
-                oContours_ToTransform.create(oTransformedImageSize,CV_8UC3);
-                MultimodalVideoRegistrAlg::PaintFGRegions(oAlg.GetLatestContours(false),cv::Scalar(0,0,255),cv::Scalar(255,0,0),oContours);
-                MultimodalVideoRegistrAlg::PaintFGRegions(oAlg.GetLatestContours(true),cv::Scalar(0,255,0),cv::Scalar(0,0,255),oContours_ToTransform);
-                cv::warpPerspective(oSource_ToTransform,oTransformedSource,oTransMat,oTransformedImageSize,cv::INTER_LINEAR|cv::WARP_INVERSE_MAP,cv::BORDER_CONSTANT);
-                cv::warpPerspective(oContours_ToTransform,oTransformedContours,oTransMat,oTransformedImageSize,cv::INTER_LINEAR|cv::WARP_INVERSE_MAP,cv::BORDER_CONSTANT);
+                paintContours(oAlg.getContours(1),cv::Scalar(0,0,255),cv::Scalar(255,0,0),oTransformedImageSize,oContours);
+                paintContours(oAlg.getContours(0),cv::Scalar(0,255,0),cv::Scalar(0,0,255),oSource_ToTransform.size(),oContours_ToTransform);
+                oAlg.warp(oSource_ToTransform,oTransformedSource,oTransformedImageSize,cv::INTER_LINEAR,false);
+                oAlg.warp(oContours_ToTransform,oTransformedContours,oTransformedImageSize,cv::INTER_LINEAR);
 #endif //USE_FULL_DEBUG_DISPLAY
-                cv::warpPerspective(oPolyMat_ToTransform,oTransformedPolyMat,oTransMat,oTransformedImageSize,cv::INTER_NEAREST|cv::WARP_INVERSE_MAP,cv::BORDER_CONSTANT);
+                oAlg.warp(oPolyMat_ToTransform,oTransformedPolyMat,oTransformedImageSize,cv::INTER_NEAREST);
                 const float fPolyOverlapError = lv::CalcForegroundOverlapError(oPolyMat,oTransformedPolyMat);
                 fCumulativePolyOverlapErrors += fPolyOverlapError;
                 const cv::Mat oTransformedPolyPts = oTransMat_inv*oPolyPts_ToTransform;
@@ -170,8 +196,8 @@ int main(int /*argc*/, char **/*argv*/) {
 #endif //USE_FILESTORAGE_RES_OUTPUT
             }
 #if USE_FULL_DEBUG_DISPLAY
-            cv::warpPerspective(oSource_ToTransform,oGTTransformedSource,oGTTransMat,oTransformedImageSize,cv::INTER_LINEAR|cv::WARP_INVERSE_MAP,cv::BORDER_CONSTANT);
-            cv::warpPerspective(oContours_ToTransform,oGTTransformedContours,oGTTransMat,oTransformedImageSize,cv::INTER_LINEAR|cv::WARP_INVERSE_MAP,cv::BORDER_CONSTANT);
+            oGTSourceWarper.apply(oSource_ToTransform,oGTTransformedSource,false);
+            oGTContoursWarper.apply(oContours_ToTransform,oGTTransformedContours);
             cv::Mat oTransformedSourceOverlay = (USE_THERMAL_TO_VISIBLE_PROJ?oSource_VISIBLE:oSource_THERMAL)+oTransformedSource;
             cv::putText(oTransformedSourceOverlay,"Estimated Transformation",cv::Point(20,20),cv::FONT_HERSHEY_PLAIN,0.8,cv::Scalar_<uchar>::all(255),1);
             cv::Mat oGTTransformedSourceOverlay = (USE_THERMAL_TO_VISIBLE_PROJ?oSource_VISIBLE:oSource_THERMAL)+oGTTransformedSource;
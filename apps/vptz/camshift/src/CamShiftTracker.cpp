@@ -0,0 +1,97 @@
+#include "CamShiftTracker.hpp"
+#include "litiv/vptz/virtualptz.hpp"
+
+namespace {
+
+    constexpr int s_nLUTShift = 8-CAMSHIFT_LUT_BITS_PER_CHANNEL;
+    constexpr int s_nLUTChannelSize = 1<<CAMSHIFT_LUT_BITS_PER_CHANNEL;
+
+    inline size_t getLUTIdx(uchar b, uchar g, uchar r) {
+        return (size_t(b>>s_nLUTShift)<<(2*CAMSHIFT_LUT_BITS_PER_CHANNEL))|(size_t(g>>s_nLUTShift)<<CAMSHIFT_LUT_BITS_PER_CHANNEL)|size_t(r>>s_nLUTShift);
+    }
+
+    template<int nChannels>
+    void backProjectLUT(const cv::Mat& oInput, const std::vector<uchar>& vuLUT, cv::Mat& oOutput) {
+        for(int nRowIdx=0; nRowIdx<oInput.rows; ++nRowIdx) {
+            const uchar* pInputRow = oInput.ptr<uchar>(nRowIdx);
+            uchar* pOutputRow = oOutput.ptr<uchar>(nRowIdx);
+            for(int nColIdx=0; nColIdx<oInput.cols; ++nColIdx, pInputRow+=nChannels)
+                pOutputRow[nColIdx] = vuLUT[getLUTIdx(pInputRow[0],pInputRow[1],pInputRow[2])];
+        }
+    }
+
+} // namespace
+
+CamShiftTracker::CamShiftTracker(const BackProjFunc& lBackProjFunc, const cv::TermCriteria& oTermCrit) :
+        m_oTermCrit(oTermCrit) {
+    lvAssert_(lBackProjFunc,"tracker requires a reference back-projection function");
+    // each lut entry is the reference model evaluated at the center of its quantized color cell
+    cv::Mat oPalette(s_nLUTChannelSize*s_nLUTChannelSize,s_nLUTChannelSize,CV_8UC3);
+    const int nCellOffset = (1<<s_nLUTShift)/2;
+    for(int nBIdx=0; nBIdx<s_nLUTChannelSize; ++nBIdx)
+        for(int nGIdx=0; nGIdx<s_nLUTChannelSize; ++nGIdx)
+            for(int nRIdx=0; nRIdx<s_nLUTChannelSize; ++nRIdx)
+                oPalette.at<cv::Vec3b>(nBIdx*s_nLUTChannelSize+nGIdx,nRIdx) = cv::Vec3b(uchar((nBIdx<<s_nLUTShift)+nCellOffset),uchar((nGIdx<<s_nLUTShift)+nCellOffset),uchar((nRIdx<<s_nLUTShift)+nCellOffset));
+    cv::Mat oPaletteBackProj;
+    lBackProjFunc(oPalette,oPaletteBackProj);
+    lvAssert_(oPaletteBackProj.type()==CV_8UC1 && oPaletteBackProj.size()==oPalette.size() && oPaletteBackProj.isContinuous(),"bad reference back-projection output");
+    // palette rows are laid out so that the back-projection is already in lut index order
+    m_vuLUT.assign(oPaletteBackProj.datastart,oPaletteBackProj.dataend);
+}
+
+void CamShiftTracker::initialize(const cv::Rect& oInitBBox, const cv::Size& oMinBBoxSize, const cv::Size& oMaxBBoxSize) {
+    m_oBBox = oInitBBox;
+    m_oSearchWindow = cv::Rect();
+    m_oMinBBoxSize = oMinBBoxSize;
+    m_oMaxBBoxSize = oMaxBBoxSize;
+}
+
+const cv::Rect& CamShiftTracker::track(const cv::Mat& oFrame, const cv::Point& oPredictedCenter) {
+    lvAssert_(!oFrame.empty() && (oFrame.type()==CV_8UC3 || oFrame.type()==CV_8UC4),"tracker requires BGR or BGRA frames");
+    const cv::Rect oFrameRect(cv::Point(0,0),oFrame.size());
+    m_oBBox.width = std::max(m_oBBox.width,1);
+    m_oBBox.height = std::max(m_oBBox.height,1);
+    if(oPredictedCenter.x>=0 && oPredictedCenter.y>=0)
+        m_oBBox -= (m_oBBox.tl()+m_oBBox.br())/2-oPredictedCenter;
+    const cv::Point oMargin(int(m_oBBox.width*CAMSHIFT_SEARCH_WINDOW_MARGIN),int(m_oBBox.height*CAMSHIFT_SEARCH_WINDOW_MARGIN));
+    m_oSearchWindow = cv::Rect(m_oBBox.tl()-oMargin,m_oBBox.br()+oMargin)&oFrameRect;
+    if(m_oSearchWindow.area()==0)
+        m_oSearchWindow = oFrameRect; // target was lost outside the frame, search everywhere
+    backProjectWindow(oFrame);
+    // camshift runs on the window only, where the box is first re-expressed
+    cv::Rect oLocalBBox = (m_oBBox-m_oSearchWindow.tl())&cv::Rect(cv::Point(0,0),m_oSearchWindow.size());
+    if(oLocalBBox.area()==0)
+        oLocalBBox = cv::Rect(cv::Point(0,0),m_oSearchWindow.size());
+    cv::CamShift(m_oBackProj(m_oSearchWindow),oLocalBBox,m_oTermCrit);
+    m_oBBox = oLocalBBox+m_oSearchWindow.tl();
+    limitBBoxSize(oFrame.size());
+    return m_oBBox;
+}
+
+void CamShiftTracker::backProjectWindow(const cv::Mat& oFrame) {
+    if(m_oBackProj.size()!=oFrame.size())
+        m_oBackProj.create(oFrame.size(),CV_8UC1);
+    m_oBackProj = cv::Scalar_<uchar>::all(0);
+    cv::Mat oBackProjWindow = m_oBackProj(m_oSearchWindow);
+    if(oFrame.channels()==4)
+        backProjectLUT<4>(oFrame(m_oSearchWindow),m_vuLUT,oBackProjWindow);
+    else
+        backProjectLUT<3>(oFrame(m_oSearchWindow),m_vuLUT,oBackProjWindow);
+}
+
+void CamShiftTracker::limitBBoxSize(const cv::Size& oFrameSize) {
+    if(m_oMaxBBoxSize.area()>0 && (m_oBBox.width>m_oMaxBBoxSize.width || m_oBBox.width<m_oMinBBoxSize.width)) {
+        const int nWidthDiff = ((m_oBBox.width>m_oMaxBBoxSize.width)?m_oMaxBBoxSize.width:m_oMinBBoxSize.width)-m_oBBox.width;
+        m_oBBox.x = std::max(std::min(m_oBBox.x-nWidthDiff/2,oFrameSize.width-1),0);
+        m_oBBox.width += nWidthDiff;
+        if(m_oBBox.x+m_oBBox.width>=oFrameSize.width)
+            m_oBBox.width = oFrameSize.width-m_oBBox.x;
+    }
+    if(m_oMaxBBoxSize.area()>0 && (m_oBBox.height>m_oMaxBBoxSize.height || m_oBBox.height<m_oMinBBoxSize.height)) {
+        const int nHeightDiff = ((m_oBBox.height>m_oMaxBBoxSize.height)?m_oMaxBBoxSize.height:m_oMinBBoxSize.height)-m_oBBox.height;
+        m_oBBox.y = std::max(std::min(m_oBBox.y-nHeightDiff/2,oFrameSize.height-1),0);
+        m_oBBox.height += nHeightDiff;
+        if(m_oBBox.y+m_oBBox.height>=oFrameSize.height)
+            m_oBBox.height = oFrameSize.height-m_oBBox.y;
+    }
+}
@@ -0,0 +1,48 @@
+//======================================================================================
+//
+// Color histogram tracker used as the fast CamShift baseline for the vptz evaluator.
+//
+// The per-pixel model (e.g. BGR->HSV conversion, saturation/value masking, histogram
+// back-projection and thresholding) is evaluated once per quantized BGR color at
+// initialization, so that tracking only requires a single LUT fetch per pixel, and only
+// inside a search window around the predicted target box.
+//
+//======================================================================================
+
+#pragma once
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+#include <functional>
+#include <vector>
+
+#define CAMSHIFT_LUT_BITS_PER_CHANNEL  6    // quantization of the fused color lut (6 bits = 262144 entries, i.e. 256KB, which fits in L2)
+#define CAMSHIFT_SEARCH_WINDOW_MARGIN  1.0f // margin added on each side of the predicted box for back-projection, relative to its size
+
+class CamShiftTracker {
+public:
+    /// reference per-pixel back-projection pipeline; receives a BGR (8UC3) image, and must output its back-projection (8UC1)
+    typedef std::function<void(const cv::Mat& /*oImage*/, cv::Mat& /*oBackProj*/)> BackProjFunc;
+    /// builds the fused color lut by running the reference back-projection pipeline over all quantized BGR colors
+    CamShiftTracker(const BackProjFunc& lBackProjFunc, const cv::TermCriteria& oTermCrit);
+    /// sets the initial target box, and the min/max box sizes enforced after each update (no limit if empty)
+    void initialize(const cv::Rect& oInitBBox, const cv::Size& oMinBBoxSize=cv::Size(), const cv::Size& oMaxBBoxSize=cv::Size());
+    /// updates the target box using a new BGR/BGRA frame; the search window is centered on oPredictedCenter (or on the last box if negative)
+    const cv::Rect& track(const cv::Mat& oFrame, const cv::Point& oPredictedCenter=cv::Point(-1,-1));
+    /// returns the latest target box
+    const cv::Rect& getBBox() const {return m_oBBox;}
+    /// returns the latest search window (in frame coordinates)
+    const cv::Rect& getSearchWindow() const {return m_oSearchWindow;}
+    /// returns the latest back-projection (frame-sized, but only filled inside the search window)
+    const cv::Mat& getBackProj() const {return m_oBackProj;}
+protected:
+    /// back-projects the search window of a frame using the fused lut
+    void backProjectWindow(const cv::Mat& oFrame);
+    /// clamps the target box size to the min/max limits, keeping it centered & inside the frame
+    void limitBBoxSize(const cv::Size& oFrameSize);
+    const cv::TermCriteria m_oTermCrit;
+    std::vector<uchar> m_vuLUT;
+    cv::Rect m_oBBox,m_oSearchWindow;
+    cv::Size m_oMinBBoxSize,m_oMaxBBoxSize;
+    cv::Mat m_oBackProj;
+};
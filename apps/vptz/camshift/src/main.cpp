@@ -9,6 +9,7 @@
 //======================================================================================
 
 #include "litiv/vptz/virtualptz.hpp"
+#include "CamShiftTracker.hpp"
 
 ////////////////////////////////////////
 #define USE_VPTZ_TRACKING          1       // allows testing without vptz framework (i.e. on regular sequences)
@@ -18,6 +19,8 @@
 #define VPTZ_USE_WAITSLEEP         0       // = 'simulate' full delays by 'sleeping' between frames
 #define VPTZ_EXEC_DELAY_RATIO      1.0     // = normal processing delay penalty (100% time lost considered)
 #define VPTZ_COMMUNICATION_DELAY   0.125   // = 125ms network ping delay between server and client
+#define VPTZ_USE_BATCH_EVALUATOR   1       // runs the sequences of each test set concurrently via vptz::BatchEvaluator (without display; requires all/single test set mode)
+#define VPTZ_BATCH_WORKER_COUNT    0       // = number of concurrently tested sequences in batch mode (0 = one per hardware thread)
 #endif //USE_VPTZ_TRACKING /////////////
 #define CAMSHIFT_USE_PURE_HSV      1
 #define CAMSHIFT_USE_MIXED_HSV     0
@@ -114,6 +117,113 @@ void onMouse( int event, int x, int y, int, void* );
 #if (VPTZ_USE_ALL_TEST_SETS+VPTZ_USE_SINGLE_TEST_SET)>1
 #error "config error, must specify all test sets or a single test set"
 #endif //(VPTZ_USE_ALL_TEST_SETS+VPTZ_USE_SINGLE_TEST_SET)>0
+#define VPTZ_USE_BATCH_MODE (USE_VPTZ_TRACKING && VPTZ_USE_BATCH_EVALUATOR && (VPTZ_USE_ALL_TEST_SETS || VPTZ_USE_SINGLE_TEST_SET))
+
+/// reference per-pixel back-projection pipeline (only used to build the tracker's fused color lut)
+void backProject(const cv::Mat& oImage, const cv::Mat& oHist, cv::Mat& oBackProj) {
+#if CAMSHIFT_USE_PURE_HSV
+    cv::Mat oImage_HSV,oImage_MASK;
+    cv::cvtColor(oImage,oImage_HSV,cv::COLOR_BGR2HSV);
+    cv::inRange(oImage_HSV,cv::Scalar(0,smin,std::min(vmin,vmax)),cv::Scalar(180,256,std::max(vmin,vmax)),oImage_MASK);
+#if CAMSHIFT_USE_MIXED_HSV
+    cv::Mat oImage_HUE;
+    oImage_HUE.create(oImage_HSV.size(),oImage_HSV.depth());
+    cv::mixChannels(&oImage_HSV,1,&oImage_HUE,1,anChannelPairMix,1);
+    cv::calcBackProject(&oImage_HUE,1,0,oHist,oBackProj,aafHistRanges);
+#else //(!CAMSHIFT_USE_MIXED_HSV)
+    cv::calcBackProject(&oImage_HSV,1,anHistChannels,oHist,oBackProj,aafHistRanges);
+#endif //(!CAMSHIFT_USE_MIXED_HSV)
+    oBackProj &= oImage_MASK;
+    cv::threshold(oBackProj,oBackProj,pmin,255,cv::THRESH_TOZERO);
+#else //(!CAMSHIFT_USE_PURE_HSV)
+    cv::calcBackProject(&oImage,1,anHistChannels,oHist,oBackProj,aafHistRanges);
+#endif //(!CAMSHIFT_USE_PURE_HSV)
+}
+
+/// builds the target color model & its tracker (the target image/mask are cropped in place if using the 70% init)
+CamShiftTracker createTracker(cv::Mat& oTargetImg, cv::Mat& oTargetMask, const cv::Size& oImageSize, cv::Size& oMinTargetBBoxSize, cv::Size& oMaxTargetBBoxSize) {
+#if CAMSHIFT_LIMIT_SCALE_VAR
+    oMaxTargetBBoxSize = cv::Size(std::min(int(oTargetImg.cols*fTargetBBoxMaxScaleVarFactor),oImageSize.width),
+                                  std::min(int(oTargetImg.rows*fTargetBBoxMaxScaleVarFactor),oImageSize.height));
+    oMinTargetBBoxSize = cv::Size(std::max(int(oTargetImg.cols/fTargetBBoxMaxScaleVarFactor),1),
+                                  std::max(int(oTargetImg.rows/fTargetBBoxMaxScaleVarFactor),1));
+#else //(!CAMSHIFT_LIMIT_SCALE_VAR)
+    UNUSED(oImageSize);
+    oMinTargetBBoxSize = oMaxTargetBBoxSize = cv::Size();
+#endif //(!CAMSHIFT_LIMIT_SCALE_VAR)
+#if CAMSHIFT_USE_70p100_INIT
+    const int nInitTargetWidth_30p100 = std::max(int(oTargetImg.cols*0.3),1);
+    const int nInitTargetHeight_30p100 = std::max(int(oTargetImg.rows*0.3),1);
+    const cv::Rect oInitTargetBBox_70p100( nInitTargetWidth_30p100/2,nInitTargetHeight_30p100/2,
+                                           oTargetImg.cols-nInitTargetWidth_30p100,
+                                           oTargetImg.rows-nInitTargetHeight_30p100);
+    oTargetImg = oTargetImg(oInitTargetBBox_70p100);
+    if(!oTargetMask.empty())
+        oTargetMask = oTargetMask(oInitTargetBBox_70p100);
+#endif //CAMSHIFT_USE_70p100_INIT
+    cv::Mat oTargetImg_HIST;
+#if CAMSHIFT_USE_PURE_HSV
+    cv::Mat oTargetImg_HSV,oTargetImg_HSV_mask;
+    cv::cvtColor(oTargetImg,oTargetImg_HSV,cv::COLOR_BGR2HSV);
+    cv::inRange(oTargetImg_HSV,cv::Scalar(0,smin,std::min(vmin,vmax)),cv::Scalar(180,256,std::max(vmin,vmax)),oTargetImg_HSV_mask);
+    if(oTargetMask.empty())
+        oTargetMask = oTargetImg_HSV_mask;
+    else
+        oTargetMask &= oTargetImg_HSV_mask;
+#if CAMSHIFT_USE_MIXED_HSV
+    cv::Mat oTargetImg_HUE;
+    oTargetImg_HUE.create(oTargetImg_HSV.size(),oTargetImg_HSV.depth());
+    cv::mixChannels(&oTargetImg_HSV,1,&oTargetImg_HUE,1,anChannelPairMix,1);
+    cv::calcHist(&oTargetImg_HUE,1,anHistChannels,oTargetMask,oTargetImg_HIST,nHistDims,anHistBins,aafHistRanges);
+#else //(!CAMSHIFT_USE_MIXED_HSV)
+    cv::calcHist(&oTargetImg_HSV,1,anHistChannels,oTargetMask,oTargetImg_HIST,nHistDims,anHistBins,aafHistRanges);
+#endif //(!CAMSHIFT_USE_MIXED_HSV)
+#else //(!CAMSHIFT_USE_PURE_HSV)
+    cv::calcHist(&oTargetImg,1,anHistChannels,cv::Mat(),oTargetImg_HIST,nHistDims,anHistBins,aafHistRanges);
+#endif //(!CAMSHIFT_USE_PURE_HSV)
+    cv::normalize(oTargetImg_HIST,oTargetImg_HIST,0,UCHAR_MAX,cv::NORM_MINMAX);
+    return CamShiftTracker([oTargetImg_HIST](const cv::Mat& oImage, cv::Mat& oBackProj){backProject(oImage,oTargetImg_HIST,oBackProj);},
+                           cv::TermCriteria(cv::TermCriteria::EPS|cv::TermCriteria::MAX_ITER,nMeanShiftMaxIterCount,fMeanShiftMinEpsilon));
+}
+
+#if VPTZ_USE_BATCH_MODE
+/// runs the tracker on a single (already set up) test sequence of a batch evaluator, without display; returns the processed frame count
+int trackSequence(vptz::Evaluator& oTestEval) {
+    cv::Mat oCurrImg = oTestEval.GetInitTargetFrame();
+    cv::Mat oTargetImg = oTestEval.GetInitTarget();
+    cv::Mat oTargetMask = oTestEval.GetInitTargetMask();
+    lvAssert(oTargetImg.type()==CV_8UC4);
+    const cv::Point oCenterPos(oCurrImg.cols/2,oCurrImg.rows/2);
+    cv::Size oMinTargetBBoxSize,oMaxTargetBBoxSize;
+    CamShiftTracker oTracker = createTracker(oTargetImg,oTargetMask,oCurrImg.size(),oMinTargetBBoxSize,oMaxTargetBBoxSize);
+    cv::Rect oTargetBBox((oCurrImg.cols-oTargetImg.cols)/2,(oCurrImg.rows-oTargetImg.rows)/2,oTargetImg.cols,oTargetImg.rows); // assuming target starts centered in first frame
+    oTracker.initialize(oTargetBBox,oMinTargetBBoxSize,oMaxTargetBBoxSize);
+    int nProcessedFrameCount = 0;
+    oTestEval.BeginTesting();
+    while(true) {
+        const cv::Point oTargetCenterPos = (oTargetBBox.tl()+oTargetBBox.br())*0.5;
+#if CAMSHIFT_USE_POSE_PREDICT
+        const cv::Point oExpectedDisplacement = oTargetBBox.area()?((oTargetCenterPos-oCenterPos)*fPosPredictScaleFactor):cv::Point(0,0);
+        cv::Point oNewCenterPos = oTargetCenterPos+oExpectedDisplacement;
+        oNewCenterPos.x = std::min(std::max(oNewCenterPos.x,0),oCurrImg.cols-1);
+        oNewCenterPos.y = std::min(std::max(oNewCenterPos.y,0),oCurrImg.rows-1);
+#else //(!CAMSHIFT_USE_POSE_PREDICT)
+        const cv::Point oNewCenterPos = oTargetCenterPos;
+#endif //(!CAMSHIFT_USE_POSE_PREDICT)
+        oCurrImg = oTestEval.GetNextFrame(oNewCenterPos,VPTZ_USE_WAITSLEEP);
+        if(oCurrImg.empty())
+            break;
+        lvAssert(oCurrImg.type()==CV_8UC4);
+        // the camera was re-aimed on the expected target position, which is now the image center
+        oTargetBBox = oTracker.track(oCurrImg,oCenterPos);
+        oTestEval.UpdateCurrentResult(oTargetBBox,false);
+        ++nProcessedFrameCount;
+    }
+    oTestEval.EndTesting();
+    return nProcessedFrameCount;
+}
+#endif //VPTZ_USE_BATCH_MODE
+
 int main(int /*argc*/, char** /*argv*/) {
 #if VPTZ_USE_ALL_TEST_SETS
     const char* asTestSets[] = INTPUT_TEST_SETS_NAMES;
@@ -125,8 +235,32 @@ int main(int /*argc*/, char** /*argv*/) {
     {
 #endif //(!VPTZ_USE_ALL_TEST_SETS)
         try {
+#if VPTZ_USE_BATCH_MODE
+#if VPTZ_USE_ALL_TEST_SETS
+            vptz::BatchEvaluator oBatchEval( sCurrTestSetPath,sCurrResultFilePath,
+                                             VPTZ_COMMUNICATION_DELAY,VPTZ_EXEC_DELAY_RATIO,VPTZ_BATCH_WORKER_COUNT);
+#else //(!VPTZ_USE_ALL_TEST_SETS)
+            vptz::BatchEvaluator oBatchEval( VPTZ_DATASET_ROOT_DIR_PATH+INPUT_TEST_SET_PATH,
+                                             VPTZ_DATASET_ROOT_DIR_PATH+OUTPUT_EVAL_FILE_PATH,
+                                             VPTZ_COMMUNICATION_DELAY,VPTZ_EXEC_DELAY_RATIO,VPTZ_BATCH_WORKER_COUNT);
+#endif //(!VPTZ_USE_ALL_TEST_SETS)
+            std::atomic_int nTotPotentialFrameCount(0),nTotProcessedFrameCount(0);
+            std::mutex oPrintMutex;
+            oBatchEval.Run([&](vptz::Evaluator& oTestEval, int nTestIdx) {
+                {
+                    std::mutex_lock_guard oLock(oPrintMutex);
+                    std::cout << "Processing seq#" << nTestIdx+1 << " [" << oBatchEval.GetTestSequenceName(nTestIdx) << "]..." << std::endl;
+                }
+                nTotPotentialFrameCount += oTestEval.GetPotentialTestFrameCount();
+                nTotProcessedFrameCount += trackSequence(oTestEval);
+            });
+            std::cout << std::endl;
+            std::cout << "nTotPotentialFrameCount = " << nTotPotentialFrameCount << std::endl;
+            std::cout << "nTotProcessedFrameCount = " << nTotProcessedFrameCount << std::endl;
+            std::cout << std::endl;
+#else //(!VPTZ_USE_BATCH_MODE)
             cv::Mat oCurrImg;
-            cv::Mat oTargetImg,oTargetMask,oTargetImg_HIST;
+            cv::Mat oTargetImg,oTargetMask;
             int nTotPotentialFrameCount = 0;
             int nTotProcessedFrameCount = 0;
 #if USE_VPTZ_TRACKING
@@ -198,48 +332,14 @@ int main(int /*argc*/, char** /*argv*/) {
                 lvAssert(oTargetImg.type()==CV_8UC4);
                 const int nImageWidth = oCurrImg.cols;
                 const int nImageHeight = oCurrImg.rows;
-#if CAMSHIFT_USE_POSE_PREDICT
+#if USE_VPTZ_TRACKING
                 const cv::Point oCenterPos(nImageWidth/2,nImageHeight/2);
-#endif //CAMSHIFT_USE_POSE_PREDICT
-#if CAMSHIFT_LIMIT_SCALE_VAR
-                const int nMaxTargetBBoxWidth = std::min(int(oTargetImg.cols*fTargetBBoxMaxScaleVarFactor),nImageWidth);
-                const int nMinTargetBBoxWidth = std::max(int(oTargetImg.cols/fTargetBBoxMaxScaleVarFactor),1);
-                const int nMaxTargetBBoxHeight = std::min(int(oTargetImg.rows*fTargetBBoxMaxScaleVarFactor),nImageHeight);
-                const int nMinTargetBBoxHeight = std::max(int(oTargetImg.rows/fTargetBBoxMaxScaleVarFactor),1);
-#endif //CAMSHIFT_LIMIT_SCALE_VAR
-#if CAMSHIFT_USE_70p100_INIT
-                const int nInitTargetWidth_30p100 = std::max(int(oTargetImg.cols*0.3),1);
-                const int nInitTargetHeight_30p100 = std::max(int(oTargetImg.rows*0.3),1);
-                const cv::Rect oInitTargetBBox_70p100( nInitTargetWidth_30p100/2,nInitTargetHeight_30p100/2,
-                                                       oTargetImg.cols-nInitTargetWidth_30p100,
-                                                       oTargetImg.rows-nInitTargetHeight_30p100);
-                oTargetImg = oTargetImg(oInitTargetBBox_70p100);
-                if(!oTargetMask.empty())
-                    oTargetMask = oTargetMask(oInitTargetBBox_70p100);
-#endif //CAMSHIFT_USE_70p100_INIT
-#if CAMSHIFT_USE_PURE_HSV
-                cv::Mat oTargetImg_HSV,oTargetImg_HSV_mask;
-                cv::cvtColor(oTargetImg,oTargetImg_HSV,cv::COLOR_BGR2HSV);
-                cv::inRange(oTargetImg_HSV,cv::Scalar(0,smin,std::min(vmin,vmax)),cv::Scalar(180,256,std::max(vmin,vmax)),oTargetImg_HSV_mask);
-                if(oTargetMask.empty())
-                    oTargetMask = oTargetImg_HSV_mask;
-                else
-                    oTargetMask &= oTargetImg_HSV_mask;
+#endif //USE_VPTZ_TRACKING
+                cv::Size oMinTargetBBoxSize,oMaxTargetBBoxSize;
+                CamShiftTracker oTracker = createTracker(oTargetImg,oTargetMask,oCurrImg.size(),oMinTargetBBoxSize,oMaxTargetBBoxSize);
 #if CAMSHIFT_DISPLAY_FG_MASK
                 cv::imshow("oTargetMask",oTargetMask);
 #endif //CAMSHIFT_DISPLAY_FG_MASK
-#if CAMSHIFT_USE_MIXED_HSV
-                cv::Mat oTargetImg_HUE;
-                oTargetImg_HUE.create(oTargetImg_HSV.size(),oTargetImg_HSV.depth());
-                cv::mixChannels(&oTargetImg_HSV,1,&oTargetImg_HUE,1,anChannelPairMix,1);
-                cv::calcHist(&oTargetImg_HUE,1,anHistChannels,oTargetMask,oTargetImg_HIST,nHistDims,anHistBins,aafHistRanges);
-#else //(!CAMSHIFT_USE_MIXED_HSV)
-                calcHist(&oTargetImg_HSV,1,anHistChannels,oTargetMask,oTargetImg_HIST,nHistDims,anHistBins,aafHistRanges);
-#endif //(!CAMSHIFT_USE_MIXED_HSV)
-#else //(!CAMSHIFT_USE_PURE_HSV)
-                calcHist(&oTargetImg,1,anHistChannels,cv::Mat(),oTargetImg_HIST,nHistDims,anHistBins,aafHistRanges);
-#endif //(!CAMSHIFT_USE_PURE_HSV)
-                cv::normalize(oTargetImg_HIST,oTargetImg_HIST,0,UCHAR_MAX,cv::NORM_MINMAX);
 #if CAMSHIFT_DISPLAY_TARGET||CAMSHIFT_DISPLAY_FG_MASK
                 cv::imshow("oTargetImg",oTargetImg);
                 cv::waitKey(0);
@@ -247,6 +347,7 @@ int main(int /*argc*/, char** /*argv*/) {
 #if USE_VPTZ_TRACKING
                 cv::Rect oTargetBBox((oCurrImg.cols-oTargetImg.cols)/2,(oCurrImg.rows-oTargetImg.rows)/2,oTargetImg.cols,oTargetImg.rows); // assuming target starts centered in first frame
 #endif //USE_VPTZ_TRACKING
+                oTracker.initialize(oTargetBBox,oMinTargetBBoxSize,oMaxTargetBBoxSize);
                 cv::Mat oCurrImg_display = oCurrImg.clone();
                 cv::rectangle(oCurrImg_display,oTargetBBox,cv::Scalar(0,255,0),3);
                 while(oCurrImg_display.cols>1024 || oCurrImg_display.rows>768)
@@ -274,46 +375,12 @@ int main(int /*argc*/, char** /*argv*/) {
                     if(oCurrImg.empty())
                         break;
                     lvAssert(oCurrImg.type()==CV_8UC4);
-                    cv::Mat oCurrImg_BP;
-#if CAMSHIFT_USE_PURE_HSV
-                    cv::Mat oCurrImg_HSV, oCurrImg_MASK;
-                    cv::cvtColor(oCurrImg,oCurrImg_HSV,cv::COLOR_BGR2HSV);
-                    cv::inRange(oCurrImg_HSV,cv::Scalar(0,smin,std::min(vmin,vmax)),cv::Scalar(180,256,std::max(vmin,vmax)),oCurrImg_MASK);
-#if CAMSHIFT_DISPLAY_FG_MASK
-                    cv::imshow("oCurrImg_MASK",oCurrImg_MASK);
-#endif //CAMSHIFT_DISPLAY_FG_MASK
-#if CAMSHIFT_USE_MIXED_HSV
-                    cv::Mat oCurrImg_HUE;
-                    oCurrImg_HUE.create(oCurrImg_HSV.size(), oCurrImg_HSV.depth());
-                    cv::mixChannels(&oCurrImg_HSV,1,&oCurrImg_HUE,1,anChannelPairMix,1);
-                    cv::calcBackProject(&oCurrImg_HUE,1,0,oTargetImg_HIST,oCurrImg_BP,aafHistRanges);
-#else //(!CAMSHIFT_USE_MIXED_HSV)
-                    cv::calcBackProject(&oCurrImg_HSV,1,anHistChannels,oTargetImg_HIST,oCurrImg_BP,aafHistRanges);
-#endif //(!CAMSHIFT_USE_MIXED_HSV)
-                    oCurrImg_BP &= oCurrImg_MASK;
-                    cv::threshold(oCurrImg_BP,oCurrImg_BP,pmin,255,cv::THRESH_TOZERO);
-#else //(!CAMSHIFT_USE_PURE_HSV)
-                    cv::calcBackProject(&oCurrImg,1,anHistChannels,oTargetImg_HIST,oCurrImg_BP,aafHistRanges);
-#endif //(!CAMSHIFT_USE_PURE_HSV)
-                    oTargetBBox.width = std::max(oTargetBBox.width,1);
-                    oTargetBBox.height = std::max(oTargetBBox.height,1);
-                    cv::CamShift(oCurrImg_BP,oTargetBBox,cv::TermCriteria(cv::TermCriteria::EPS|cv::TermCriteria::MAX_ITER,nMeanShiftMaxIterCount,fMeanShiftMinEpsilon));
-#if CAMSHIFT_LIMIT_SCALE_VAR
-                    if(oTargetBBox.width>nMaxTargetBBoxWidth || oTargetBBox.width<nMinTargetBBoxWidth) {
-                        int nWidthDiff = ((oTargetBBox.width>nMaxTargetBBoxWidth)?nMaxTargetBBoxWidth:nMinTargetBBoxWidth)-oTargetBBox.width;
-                        oTargetBBox.x = std::max(std::min(oTargetBBox.x-nWidthDiff/2,nImageWidth-1),0);
-                        oTargetBBox.width += nWidthDiff;
-                        if(oTargetBBox.x+oTargetBBox.width>=nImageWidth)
-                            oTargetBBox.width = nImageWidth-oTargetBBox.x;
-                    }
-                    if(oTargetBBox.height>nMaxTargetBBoxHeight || oTargetBBox.height<nMinTargetBBoxHeight) {
-                        int nHeightDiff = ((oTargetBBox.height>nMaxTargetBBoxHeight)?nMaxTargetBBoxHeight:nMinTargetBBoxHeight)-oTargetBBox.height;
-                        oTargetBBox.y = std::max(std::min(oTargetBBox.y-nHeightDiff/2,nImageHeight-1),0);
-                        oTargetBBox.height += nHeightDiff;
-                        if(oTargetBBox.y+oTargetBBox.height>=nImageHeight)
-                            oTargetBBox.height = nImageHeight-oTargetBBox.y;
-                    }
-#endif //CAMSHIFT_LIMIT_SCALE_VAR
+#if USE_VPTZ_TRACKING
+                    // the camera was re-aimed on the expected target position, which is now the image center
+                    oTargetBBox = oTracker.track(oCurrImg,oCenterPos);
+#else //(!USE_VPTZ_TRACKING)
+                    oTargetBBox = oTracker.track(oCurrImg);
+#endif //(!USE_VPTZ_TRACKING)
 #if USE_VPTZ_TRACKING
                     oTestEval.UpdateCurrentResult(oTargetBBox,!(VPTZ_USE_SINGLE_TEST_SET||VPTZ_USE_ALL_TEST_SETS));
 #endif //USE_VPTZ_TRACKING
@@ -322,7 +389,7 @@ int main(int /*argc*/, char** /*argv*/) {
 #if USE_VPTZ_TRACKING
                     cv::rectangle(oCurrImg,oTestEval.GetLastGTBoundingBox(),cv::Scalar(0,255,255));
 #endif //USE_VPTZ_TRACKING
-                    cv::Mat oCurrImg_BP_display = oCurrImg_BP.clone();
+                    cv::Mat oCurrImg_BP_display = oTracker.getBackProj().clone();
                     oCurrImg_display = oCurrImg.clone();
                     while(oCurrImg_display.cols>1024 || oCurrImg_display.rows>768) {
                         cv::resize(oCurrImg_BP_display,oCurrImg_BP_display,cv::Size(0,0),0.5,0.5);
@@ -343,6 +410,7 @@ int main(int /*argc*/, char** /*argv*/) {
             std::cout << "nTotPotentialFrameCount = " << nTotPotentialFrameCount << std::endl;
             std::cout << "nTotProcessedFrameCount = " << nTotProcessedFrameCount << std::endl;
             std::cout << std::endl;
+#endif //(!VPTZ_USE_BATCH_MODE)
         }
         catch(const cv::Exception& e) {
             std::cerr << "top level caught cv::Exception:\n" << e.what() << std::endl;
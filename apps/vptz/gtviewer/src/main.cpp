@@ -1,9 +1,10 @@
-
 //======================================================================================
 //
 // This program is used to view ground truth annotations while controlling the camera.
 //
-// Before running, set the input scenario/gt paths using the defines below.
+// Before running, set the input scenario/gt paths using the defines below. Viewports of
+// upcoming frames are prefetched while playing, rendered viewports are cached, and the
+// 'Frame' trackbar can be used to scrub through the sequence (low-res while dragging).
 //
 //======================================================================================
 
@@ -13,15 +14,64 @@
 #define INPUT_SCENARIO_PATH        "/some/root/directory/litiv_vptz_icip2015//scenario3/scenario3.avi"
 #define INPUT_GT_SEQUENCE_PATH     "/some/root/directory/litiv_vptz_icip2015/scenario3/gt/scenario3_torso02.yml"
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define GTVIEWER_CACHE_SIZE        64   // max number of rendered viewports kept in the cache (oldest are evicted first)
+#define GTVIEWER_SCRUB_DOWNSCALE   4    // viewport downscale factor used for rendering while scrubbing
+#define GTVIEWER_SCRUB_IDLE_MS     250  // delay after the last trackbar move before going back to full-res rendering
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 cv::Point g_oLastMouseClickPos;
+bool g_bMouseClicked = false;
 void onMouse(int nEventCode, int x, int y, int, void*) {
     if(nEventCode==cv::EVENT_LBUTTONDOWN) {
         std::cout << "Clicked at [" << x << "," << y << "]" << std::endl;
         g_oLastMouseClickPos = cv::Point(x,y);
+        g_bMouseClicked = true;
     }
 }
 
+int g_nCurrGTIdx = 0;
+int g_nScrubGTIdx = 0;
+int64 g_nLastScrubTick = 0;
+void onTrackbar(int nPos, void*) {
+    if(nPos!=g_nCurrGTIdx) // programmatic updates always match the current index
+        g_nLastScrubTick = cv::getTickCount();
+}
+
+struct GTFrameData {
+    int nFrameIdx;
+    int nBBoxWidth,nBBoxHeight;
+    cv::Point2d oTargetPos_HX;
+};
+
+/// caches rendered viewports by frame index and camera orientation/FOV, evicting the oldest ones first
+class ViewportCache {
+public:
+    typedef std::tuple<int,double,double,double> Key;
+    static Key getKey(vptz::Camera& oCamera) {
+        return Key(int(oCamera.Get(vptz::PTZ_CAM_FRAME_POS)),oCamera.Get(vptz::PTZ_CAM_HORI_ANGLE),oCamera.Get(vptz::PTZ_CAM_VERTI_ANGLE),oCamera.Get(vptz::PTZ_CAM_VERTI_FOV));
+    }
+    /// returns the cached viewport for the given key (or an empty mat if missing)
+    cv::Mat get(const Key& oKey) const {
+        auto pEntry = m_mCache.find(oKey);
+        return (pEntry==m_mCache.end())?cv::Mat():pEntry->second;
+    }
+    bool contains(const Key& oKey) const {
+        return m_mCache.count(oKey)>0;
+    }
+    void insert(const Key& oKey, const cv::Mat& oViewport) {
+        if(oViewport.empty() || !m_mCache.insert(std::make_pair(oKey,oViewport)).second)
+            return;
+        m_qInsertOrder.push_back(oKey);
+        while(m_qInsertOrder.size()>size_t(GTVIEWER_CACHE_SIZE)) {
+            m_mCache.erase(m_qInsertOrder.front());
+            m_qInsertOrder.pop_front();
+        }
+    }
+private:
+    std::map<Key,cv::Mat> m_mCache;
+    std::deque<Key> m_qInsertOrder;
+};
+
 int main(int /*argc*/, char** /*argv*/) {
     try {
         cv::FileStorage oInputGT(INPUT_GT_SEQUENCE_PATH, cv::FileStorage::READ);
@@ -30,11 +80,27 @@ int main(int /*argc*/, char** /*argv*/) {
         double dGTVerticalFOV = oInputGT["verticalFOV"];
         vptz::Camera oCamera(INPUT_SCENARIO_PATH);
         vptz::GTTranslator oGTTranslator(&oCamera, nGTFrameWidth, nGTFrameHeight, dGTVerticalFOV);
+        const cv::Size oViewportSize((int)oCamera.Get(vptz::PTZ_CAM_OUTPUT_WIDTH),(int)oCamera.Get(vptz::PTZ_CAM_OUTPUT_HEIGHT));
+        // low-res camera used while scrubbing (it mirrors the main camera state, so overlays stay valid once upscaled)
+        vptz::Camera oScrubCamera(INPUT_SCENARIO_PATH,oCamera.Get(vptz::PTZ_CAM_VERTI_FOV),
+                                  std::max(oViewportSize.width/GTVIEWER_SCRUB_DOWNSCALE,2),std::max(oViewportSize.height/GTVIEWER_SCRUB_DOWNSCALE,2));
+        ViewportCache oViewportCache;
         cv::Point oTargetPos_XY;
-        cv::Point2d oTargetPos_HX;
         cv::Mat oCurrView;
-        int nBBoxWidth, nBBoxHeight;
-        int nFrameIdx;
+
+        std::vector<GTFrameData> voGTFrames;
+        cv::FileNode oGTNode = oInputGT["basicGroundTruth"];
+        for(auto oGTFrame=oGTNode.begin(); oGTFrame!=oGTNode.end(); ++oGTFrame) {
+            GTFrameData oData;
+            oData.nFrameIdx = (*oGTFrame)["framePos"];
+            oData.nBBoxWidth = (*oGTFrame)["width"];
+            oData.nBBoxHeight = (*oGTFrame)["height"];
+            oData.oTargetPos_HX.x = (*oGTFrame)["horizontalAngle"];
+            oData.oTargetPos_HX.y = (*oGTFrame)["verticalAngle"];
+            voGTFrames.push_back(oData);
+        }
+        if(voGTFrames.empty())
+            return 0;
 
         oCamera.Set(vptz::PTZ_CAM_FRAME_POS, 0);
         oCurrView = oCamera.GetFrame();
@@ -42,32 +108,64 @@ int main(int /*argc*/, char** /*argv*/) {
         cv::imshow("Current View", oCurrView);
         cv::waitKey(2);
         cv::setMouseCallback("Current View", onMouse, 0);
+        cv::createTrackbar("Frame", "Current View", &g_nScrubGTIdx, std::max(int(voGTFrames.size())-1,1), onTrackbar);
         g_oLastMouseClickPos = cv::Point(oCurrView.cols/2, oCurrView.rows/2);
 
-        cv::FileNode oGTNode = oInputGT["basicGroundTruth"];
         bool bPaused = true;
-        for(auto oGTFrame=oGTNode.begin(); oGTFrame!=oGTNode.end(); ++oGTFrame) {
-            nFrameIdx = (*oGTFrame)["framePos"];
-            nBBoxWidth = (*oGTFrame)["width"];
-            nBBoxHeight = (*oGTFrame)["height"];
-            oTargetPos_HX.x = (*oGTFrame)["horizontalAngle"];
-            oTargetPos_HX.y = (*oGTFrame)["verticalAngle"];
-            std::cout << "\t#" << nFrameIdx << std::endl;
-            oCamera.Set(vptz::PTZ_CAM_FRAME_POS, nFrameIdx);
+        while(g_nCurrGTIdx<int(voGTFrames.size())) {
+            const GTFrameData& oCurrGT = voGTFrames[g_nCurrGTIdx];
+            std::cout << "\t#" << oCurrGT.nFrameIdx << std::endl;
+            bool bScrubbed = false;
             while(true) {
-                oCamera.GoToPosition(g_oLastMouseClickPos);
-                oCurrView = oCamera.GetFrame();
-                if(oCurrView.empty())
-                    break;
+                oCamera.Set(vptz::PTZ_CAM_FRAME_POS, oCurrGT.nFrameIdx);
+                if(g_bMouseClicked) {
+                    oCamera.GoToPosition(g_oLastMouseClickPos);
+                    g_bMouseClicked = false;
+                }
+                const bool bScrubbing = g_nLastScrubTick && (cv::getTickCount()-g_nLastScrubTick)*1000.0/cv::getTickFrequency()<GTVIEWER_SCRUB_IDLE_MS;
+                const ViewportCache::Key oKey = ViewportCache::getKey(oCamera);
+                cv::Mat oCachedView = oViewportCache.get(oKey);
+                if(!oCachedView.empty())
+                    oCurrView = oCachedView.clone();
+                else if(bScrubbing) {
+                    oScrubCamera.Set(vptz::PTZ_CAM_FRAME_POS, oCurrGT.nFrameIdx);
+                    oScrubCamera.Set(vptz::PTZ_CAM_VERTI_FOV, oCamera.Get(vptz::PTZ_CAM_VERTI_FOV));
+                    oScrubCamera.Set(vptz::PTZ_CAM_HORI_ANGLE, oCamera.Get(vptz::PTZ_CAM_HORI_ANGLE));
+                    oScrubCamera.Set(vptz::PTZ_CAM_VERTI_ANGLE, oCamera.Get(vptz::PTZ_CAM_VERTI_ANGLE));
+                    const cv::Mat& oScrubView = oScrubCamera.GetFrame();
+                    if(oScrubView.empty())
+                        break;
+                    cv::resize(oScrubView, oCurrView, oViewportSize, 0, 0, cv::INTER_LINEAR);
+                }
+                else {
+                    const cv::Mat& oView = oCamera.GetFrame();
+                    if(oView.empty())
+                        break;
+                    oViewportCache.insert(oKey, oView.clone());
+                    oCurrView = oView.clone();
+                }
                 g_oLastMouseClickPos = cv::Point(oCurrView.cols/2, oCurrView.rows/2);
                 cv::circle(oCurrView, cv::Point(oCurrView.cols/2,oCurrView.rows/2), 3, cv::Scalar(0,255,0), 5);
-                oGTTranslator.GetGTTargetPoint(oTargetPos_HX.x, oTargetPos_HX.y, oTargetPos_XY);
+                oGTTranslator.GetGTTargetPoint(oCurrGT.oTargetPos_HX.x, oCurrGT.oTargetPos_HX.y, oTargetPos_XY);
                 cv::circle(oCurrView, oTargetPos_XY, 3, cv::Scalar(0,255,255), 5);
                 cv::Rect bb;
-                oGTTranslator.GetGTBoundingBox(oTargetPos_HX.x, oTargetPos_HX.y, nBBoxWidth, nBBoxHeight, bb);
+                oGTTranslator.GetGTBoundingBox(oCurrGT.oTargetPos_HX.x, oCurrGT.oTargetPos_HX.y, oCurrGT.nBBoxWidth, oCurrGT.nBBoxHeight, bb);
                 cv::rectangle(oCurrView, bb, cv::Scalar(0,255,255));
                 cv::imshow("Current View", oCurrView);
+                if(!bPaused && !bScrubbing && g_nCurrGTIdx+1<int(voGTFrames.size())) {
+                    // starts rendering/reading back the next viewport while this one is displayed
+                    oCamera.Set(vptz::PTZ_CAM_FRAME_POS, voGTFrames[g_nCurrGTIdx+1].nFrameIdx);
+                    if(!oViewportCache.contains(ViewportCache::getKey(oCamera)))
+                        oCamera.PrepareFrame();
+                }
                 char cKey = (char)cv::waitKey(1);
+                if(g_nScrubGTIdx!=g_nCurrGTIdx) {
+                    g_nCurrGTIdx = g_nScrubGTIdx;
+                    bScrubbed = true;
+                    break;
+                }
+                if(bScrubbing)
+                    continue; // keeps refreshing until the trackbar is idle, so that the full-res viewport eventually replaces the low-res one
                 if(cKey==' ')
                     bPaused = !bPaused;
                 else if(cKey!=-1)
@@ -75,6 +173,11 @@ int main(int /*argc*/, char** /*argv*/) {
                 if(!bPaused)
                     break;
             }
+            if(!bScrubbed) {
+                ++g_nCurrGTIdx;
+                if(g_nCurrGTIdx<int(voGTFrames.size()))
+                    cv::setTrackbarPos("Frame", "Current View", g_nCurrGTIdx);
+            }
         }
         return 0;
     }
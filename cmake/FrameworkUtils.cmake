@@ -63,9 +63,12 @@ macro(target_link_litiv_dependencies name)
     if(USE_GLSL)
         if(USE_GLFW)
             target_link_libraries(${name} ${GLFW_LIBRARIES})
-        else(USE_FREEGLUT)
+        elseif(USE_FREEGLUT)
             target_link_libraries(${name} ${FREEGLUT_LIBRARY})
         endif()
+        if(USE_EGL)
+            target_link_libraries(${name} ${EGL_LIBRARIES})
+        endif()
         target_link_libraries(${name} ${OPENGL_LIBRARIES})
         target_link_libraries(${name} ${GLEW_LIBRARIES})
         target_link_libraries(${name} ${GLM_LIBRARIES})
@@ -74,11 +77,9 @@ macro(target_link_litiv_dependencies name)
         target_link_libraries(${name} ${OpenGM_LIBRARIES})
     endif()
     if(USE_CUDA)
-        # @@@@ add cuda package
         message(FATAL_ERROR "Missing CUDA target link libraries")
     endif()
     if(USE_OPENCL)
-        # @@@@ add opencl package
         message(FATAL_ERROR "Missing OpenCL target link libraries")
     endif()
 endmacro(target_link_litiv_dependencies name)
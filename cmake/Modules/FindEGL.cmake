@@ -0,0 +1,66 @@
+# This file is part of the LITIV framework; visit the original repository at
+# https://github.com/plstcharles/litiv for more information.
+#
+# Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Try to find the EGL library and include path (used for headless GL contexts).
+# Once done this will define
+#
+# EGL_FOUND
+# EGL_INCLUDE_DIR
+# EGL_LIBRARIES
+#
+
+find_path(EGL_INCLUDE_DIR
+    NAMES
+        EGL/egl.h
+    HINTS
+        "${EGL_LOCATION}/include"
+        "$ENV{EGL_LOCATION}/include"
+    PATHS
+        "${OPENGL_INCLUDE_DIR}"
+        /usr/local/include
+        /usr/include
+    DOC
+        "The directory where EGL/egl.h resides"
+)
+
+find_library(EGL_LIBRARY
+    NAMES
+        EGL
+    HINTS
+        "${EGL_LOCATION}/lib"
+        "$ENV{EGL_LOCATION}/lib"
+    PATHS
+        /usr/local/lib
+        /usr/lib
+        /usr/lib/x86_64-linux-gnu
+    PATH_SUFFIXES
+        lib64
+    DOC
+        "The EGL library"
+)
+
+set(EGL_LIBRARIES ${EGL_LIBRARY})
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(EGL
+    REQUIRED_VARS
+        EGL_INCLUDE_DIR
+        EGL_LIBRARY
+)
+
+if(EGL_FOUND)
+    mark_as_advanced(EGL_INCLUDE_DIR EGL_LIBRARY)
+endif()
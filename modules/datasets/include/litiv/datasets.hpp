@@ -48,6 +48,10 @@ namespace lv {
         virtual bool isGrayscale() const override final;
         /// returns a pointer to this work batch/group's parent dataset interface
         virtual IDatasetPtr getDatasetInfo() const override final;
+        /// sets the tracer that pipeline stages will timestamp packets into (for groups, set on all children batches)
+        virtual void setLatencyTracer(const PacketLatencyTracerPtr& pTracer) override final;
+        /// returns the tracer that pipeline stages timestamp packets into (nullptr if disabled)
+        virtual PacketLatencyTracer* getLatencyTracer() const override final {return m_pLatencyTracer.get();}
     protected:
         /// fills internal impl parameters based on batch name, dataset parameters & current relative data path
         DataHandler(const std::string& sBatchName, std::shared_ptr<IDataset> pDataset, const std::string& sRelativePath);
@@ -62,6 +66,7 @@ namespace lv {
         const std::string m_sOutputPath;
         const bool m_bForcingGrayscale;
         const IDatasetPtr m_pDataset;
+        PacketLatencyTracerPtr m_pLatencyTracer;
     };
 
     /// top-level dataset interface where work batches & groups are implemented based on template policies --- all internal methods can be overriden via dataset impl headers
@@ -89,7 +94,13 @@ namespace lv {
             /// always returns an empty data handler array for non-group work batches
             virtual IDataHandlerPtrArray getBatches(bool /*bWithHierarchy*/) const override final {return IDataHandlerPtrArray();}
             /// returns the current (or final) duration elapsed between start/stopProcessing calls
-            virtual double getProcessTime() const override final {return m_dElapsedTime_sec;}
+            virtual double getProcessTime() const override final {return (m_bIsProcessing?m_oStopWatch.tock(false):m_dElapsedTime_sec)+m_dAddedTime_sec;}
+            /// adds processing time measured elsewhere (e.g. by another node of a sharded run, or before a checkpoint) to the work batch total
+            virtual void addProcessTime(double dProcessTime) override final {lvAssert_(!m_bIsProcessing,"cannot add process time while processing"); m_dAddedTime_sec += dProcessTime;}
+            /// returns the processing time measured for this work batch in previous runs (if any), or its rescaled estimated load otherwise
+            virtual double getExpectedLoad() const override final {return getDatasetInfo()->getMeasuredLoad(getRelativePath(),getEstimatedLoad());}
+            /// returns the static load estimate for this work batch (based on packet sizes and count only)
+            double getEstimatedLoad() const {return DataProducer_<eDatasetTask,eDatasetSource,eDataset>::getExpectedLoad();}
             /// returns whether the work batch is still being processed or not (i.e. between start/stopProcessing calls)
             virtual bool isProcessing() const override final {return m_bIsProcessing;}
             /// sets the work batch in 'processing' mode, initializing timers, packet counters and other time-critical evaluation components (if any)
@@ -105,6 +116,9 @@ namespace lv {
                 if(m_bIsProcessing) {
                     m_dElapsedTime_sec = m_oStopWatch.tock();
                     m_bIsProcessing = false;
+                    // partial runs (e.g. segments or early exits) are not representative of the batch's full cost
+                    if(this->getProcessedPacketsCount()==this->getTotPackets())
+                        getDatasetInfo()->setMeasuredLoad(getRelativePath(),getProcessTime());
                     _stopProcessing();
                     this->stopAsyncPrecaching();
                     this->setProcessedPacketsPromise();
@@ -121,11 +135,13 @@ namespace lv {
         protected:
             /// work batch default constructor (protected, objects should always be instantiated via 'create' member function)
             WorkBatch(const std::string& sBatchName, IDatasetPtr pDataset, const std::string& sRelativePath=std::string("./")) :
-                    DataHandler(sBatchName,pDataset,sRelativePath),m_dElapsedTime_sec(0),m_bIsProcessing(false) {parseData();}
+                    DataHandler(sBatchName,pDataset,sRelativePath),m_dElapsedTime_sec(0),m_dAddedTime_sec(0),m_bIsProcessing(false) {parseData();}
             WorkBatch& operator=(const WorkBatch&) = delete;
             WorkBatch(const WorkBatch&) = delete;
-            lv::StopWatch m_oStopWatch;
+            mutable lv::StopWatch m_oStopWatch;
             double m_dElapsedTime_sec;
+            /// processing time measured outside of the current start/stopProcessing calls (restored from checkpoints or merged from shards)
+            double m_dAddedTime_sec;
             bool m_bIsProcessing;
         };
         /// fully implemented work group interface with template specializations
@@ -167,6 +183,8 @@ namespace lv {
             virtual bool isProcessing() const override final {for(const auto& pBatch : getBatches(true)) if(pBatch->isProcessing()) return true; return false;}
             /// returns the current (or final) duration elapsed between start/stopProcessing calls, recursively queried for all children work batches
             virtual double getProcessTime() const override final {return lv::accumulateMembers<double,IDataHandlerPtr>(getBatches(true),[](const IDataHandlerPtr& p){return p->getProcessTime();});}
+            /// always fails for work groups (process times are only kept by work batches)
+            virtual void addProcessTime(double /*dProcessTime*/) override final {lvError("cannot add process time to a work group");}
             /// accumulates the expected CPU load for this data batch based on all children work batches load
             virtual double getExpectedLoad() const override final {return lv::accumulateMembers<double,IDataHandlerPtr>(getBatches(true),[](const IDataHandlerPtr& p){return p->getExpectedLoad();});}
             /// accumulate total packet count from all children work batches
@@ -189,9 +207,9 @@ namespace lv {
                     std::cout << "\tParsing directory '" << pDataset->getDatasetPath()+sRelativePath << "' for work group '" << getName() << "'..." << std::endl;
                     std::vector<std::string> vsWorkBatchPaths;
                     // all subdirs are considered work batch directories (if none, the category directory itself is a batch, and 'bare')
-                    lv::GetSubDirsFromDir(getDataPath(),vsWorkBatchPaths);
+                    pDataset->getSubDirsFromDir(getDataPath(),vsWorkBatchPaths);
                     if(vsWorkBatchPaths.empty()) {
-                        m_vpBatches.push_back(WorkBatch::create(getName(),pDataset,getRelativePath()));
+                        m_vBatchCreationArgs.emplace_back(getName(),getRelativePath());
                         m_bIsBare = true;
                     }
                     else {
@@ -199,15 +217,24 @@ namespace lv {
                             const size_t nLastSlashPos = sPathIter.find_last_of("/\\");
                             const std::string sNewBatchName = nLastSlashPos==std::string::npos?sPathIter:sPathIter.substr(nLastSlashPos+1);
                             if(!lv::string_contains_token(sNewBatchName,pDataset->getSkippedDirTokens()))
-                                m_vpBatches.push_back(WorkBatch::create(sNewBatchName,pDataset,lv::AddDirSlashIfMissing(getRelativePath())+sNewBatchName+"/"));
+                                m_vBatchCreationArgs.emplace_back(sNewBatchName,lv::AddDirSlashIfMissing(getRelativePath())+sNewBatchName+"/");
                         }
                     }
+                    // batch slots are reserved now to keep a stable ordering, but batches are only created (and parsed) by the dataset
+                    m_vpBatches.resize(m_vBatchCreationArgs.size());
                 }
             }
+            /// creates (and parses) the work batch reserved in the given slot; slots can be created concurrently
+            void createBatch(size_t nBatchIdx) {
+                lvDbgAssert(nBatchIdx<m_vBatchCreationArgs.size() && !m_vpBatches[nBatchIdx]);
+                m_vpBatches[nBatchIdx] = WorkBatch::create(m_vBatchCreationArgs[nBatchIdx].first,getDatasetInfo(),m_vBatchCreationArgs[nBatchIdx].second);
+            }
             WorkBatchGroup& operator=(const WorkBatchGroup&) = delete;
             WorkBatchGroup(const WorkBatchGroup&) = delete;
             IDataHandlerPtrArray m_vpBatches;
+            std::vector<std::pair<std::string,std::string>> m_vBatchCreationArgs;
             bool m_bIsBare;
+            friend struct IDataset_;
         };
         /// returns the dataset name
         virtual const std::string& getName() const override final {return m_sDatasetName;}
@@ -249,8 +276,68 @@ namespace lv {
             m_vpBatches.clear();
             if(!getOutputPath().empty())
                 lv::CreateDirIfNotExist(getOutputPath());
-            for(const auto& sPathIter : getWorkBatchDirs())
-                m_vpBatches.push_back(WorkBatchGroup::create(sPathIter,this->shared_from_this()));
+            // the index is kept next to the dataset if possible, or in the output directory otherwise (for read-only data storage)
+            const std::string sIndexFileName = std::string(DATASETUTILS_INDEX_FILE_NAME_PREFIX)+getName();
+            std::vector<std::string> vsIndexFilePaths(1,getDatasetPath()+sIndexFileName);
+            if(!getOutputPath().empty())
+                vsIndexFilePaths.push_back(getOutputPath()+sIndexFileName);
+            m_pIndex = std::make_shared<DatasetIndex>(vsIndexFilePaths);
+            // groups only list their children here; all work batches are then parsed concurrently into their reserved slots
+            std::vector<std::pair<std::shared_ptr<WorkBatchGroup>,size_t>> vBatchSlots;
+            for(const auto& sPathIter : getWorkBatchDirs()) {
+                std::shared_ptr<WorkBatchGroup> pGroup = WorkBatchGroup::create(sPathIter,this->shared_from_this());
+                for(size_t nBatchIdx=0; nBatchIdx<pGroup->m_vBatchCreationArgs.size(); ++nBatchIdx)
+                    vBatchSlots.emplace_back(pGroup,nBatchIdx);
+                m_vpBatches.push_back(pGroup);
+            }
+            const size_t nHardwareThreads = std::max((size_t)std::thread::hardware_concurrency(),size_t(1));
+            const size_t nParsingThreads = std::min(std::max(vBatchSlots.size(),size_t(1)),DATASETUTILS_PARSING_THREAD_COUNT?size_t(DATASETUTILS_PARSING_THREAD_COUNT):nHardwareThreads);
+            m_nParsingThreadCount = std::max(nHardwareThreads/nParsingThreads,size_t(1));
+            lv::ThreadPool oThreadPool(nParsingThreads);
+            oThreadPool.parallel_for(vBatchSlots.size(),[&](size_t nSlotIdx) {
+                vBatchSlots[nSlotIdx].first->createBatch(vBatchSlots[nSlotIdx].second);
+            });
+            m_nParsingThreadCount = 0;
+            m_pIndex->save();
+            // estimated loads of batches without measurements are rescaled to seconds, so both kinds can be scheduled together
+            m_pLoadHistory = std::make_shared<BatchLoadHistory>((getOutputPath().empty()?getDatasetPath():getOutputPath())+DATASETUTILS_LOAD_HISTORY_FILE_NAME);
+            double dTotMeasuredTime = 0.0, dTotEstimatedLoad = 0.0;
+            for(const auto& pBatch : getBatches(false)) {
+                double dProcessTime;
+                if(m_pLoadHistory->getProcessTime(pBatch->getRelativePath(),dProcessTime)) {
+                    dTotMeasuredTime += dProcessTime;
+                    dTotEstimatedLoad += dynamic_cast<const WorkBatch&>(*pBatch).getEstimatedLoad();
+                }
+            }
+            m_dMeasuredLoadScale = (dTotEstimatedLoad>0.0)?dTotMeasuredTime/dTotEstimatedLoad:0.0;
+        }
+        /// returns the processing time measured for a work batch in previous runs, or its estimated load rescaled to match those measurements
+        virtual double getMeasuredLoad(const std::string& sBatchRelPath, double dEstimatedLoad) const override final {
+            double dProcessTime;
+            if(m_pLoadHistory && m_pLoadHistory->getProcessTime(sBatchRelPath,dProcessTime))
+                return dProcessTime;
+            return (m_dMeasuredLoadScale>0.0)?dEstimatedLoad*m_dMeasuredLoadScale:dEstimatedLoad;
+        }
+        /// records the processing time of a fully processed work batch, for use as its expected load in later runs
+        virtual void setMeasuredLoad(const std::string& sBatchRelPath, double dProcessTime) override final {
+            if(m_pLoadHistory)
+                m_pLoadHistory->addProcessTime(sBatchRelPath,dProcessTime);
+        }
+        /// returns the number of threads a single work batch may use internally while parsing its data (0 = one per hardware thread)
+        virtual size_t getParsingThreadCount() const override final {return m_nParsingThreadCount;}
+        /// returns the file paths found in a directory, using the persistent dataset index (if available)
+        virtual void getFilesFromDir(const std::string& sDirPath, std::vector<std::string>& vsFilePaths) const override final {
+            if(m_pIndex)
+                m_pIndex->getFilesFromDir(sDirPath,vsFilePaths);
+            else
+                lv::GetFilesFromDir(sDirPath,vsFilePaths);
+        }
+        /// returns the subdirectory paths found in a directory, using the persistent dataset index (if available)
+        virtual void getSubDirsFromDir(const std::string& sDirPath, std::vector<std::string>& vsSubDirPaths) const override final {
+            if(m_pIndex)
+                m_pIndex->getSubDirsFromDir(sDirPath,vsSubDirPaths);
+            else
+                lv::GetSubDirsFromDir(sDirPath,vsSubDirPaths);
         }
         /// returns the array of work batches (or groups) contained in this dataset
         virtual IDataHandlerPtrArray getBatches(bool bWithHierarchy) const override final {
@@ -301,7 +388,9 @@ namespace lv {
                 m_bSavingOutput(bSaveOutput),
                 m_bUsingEvaluator(bUseEvaluator),
                 m_bForce4ByteDataAlign(bForce4ByteDataAlign),
-                m_dScaleFactor(dScaleFactor) {}
+                m_dScaleFactor(dScaleFactor),
+                m_nParsingThreadCount(0),
+                m_dMeasuredLoadScale(0.0) {}
         const std::string m_sDatasetName;
         const std::string m_sDatasetPath;
         const std::string m_sOutputPath;
@@ -316,6 +405,10 @@ namespace lv {
         const bool m_bForce4ByteDataAlign;
         const double m_dScaleFactor;
         IDataHandlerPtrArray m_vpBatches;
+        DatasetIndexPtr m_pIndex;
+        size_t m_nParsingThreadCount;
+        BatchLoadHistoryPtr m_pLoadHistory;
+        double m_dMeasuredLoadScale;
     private:
         IDataset_& operator=(const IDataset_&) = delete;
         IDataset_(const IDataset_&) = delete;
@@ -352,8 +445,10 @@ namespace lv {
     #define __LITIV_DATASETS_IMPL_H
     #include "litiv/datasets/impl/BSDS500.hpp"
     #include "litiv/datasets/impl/CDnet.hpp"
+    #include "litiv/datasets/impl/LiveStream.hpp"
     //#include "litiv/datasets/impl/LITIV2012b.hpp"  @@@@ still need to work on interfaces for eDatasetType_VideoRegistr
     #include "litiv/datasets/impl/PETS2001.hpp"
+    #include "litiv/datasets/impl/Recordings.hpp"
     #include "litiv/datasets/impl/Wallflower.hpp"
     #undef __LITIV_DATASETS_IMPL_H
 
@@ -18,6 +18,10 @@
 #pragma once
 
 #define DATASETUTILS_VALIDATE_ASYNC_EVALUATORS 0
+#define DATASETUTILS_METRICSSINK_DEFAULT_EXPORT_PERIOD_SEC 10.0
+#define DATASETUTILS_USE_ASYNC_CPU_EVALUATORS 1
+#define DATASETUTILS_ASYNC_EVAL_MAX_QUEUE_SIZE 32
+#define DATASETUTILS_SAVED_OUTPUTS_EVAL_CHUNK_SIZE 64
 
 #include "litiv/datasets/metrics.hpp"
 
@@ -31,6 +35,14 @@ namespace lv {
     struct IDatasetEvaluator_<DatasetEval_None> : public IDataset {
         /// writes an overall evaluation report listing packet counts, seconds elapsed and algo speed (default eval)
         virtual void writeEvalReport() const override;
+        /// returns the work batches assigned to the given shard of a sharded run (greedy packet count balancing, identical on all nodes parsing the same dataset)
+        IDataHandlerPtrArray getShardBatches(size_t nShardIdx, size_t nShardCount) const;
+        /// writes the processing results (time elapsed & metrics) of the given work batches to a binary shard file
+        void writeShardResults(const std::string& sFilePath, const IDataHandlerPtrArray& vpBatches) const;
+        /// merges the shard files written by all nodes into this dataset's work batches, so that 'writeEvalReport' covers the full run
+        void mergeShardResults(const std::vector<std::string>& vsFilePaths);
+        /// evaluates the outputs previously saved for all work batches (evaluation-only mode, no algorithm involved), with batches & packets spread over nThreads threads (0 = one per hardware thread)
+        void evaluateSavedOutputs(size_t nThreads=0);
     };
 
     template<>
@@ -55,12 +67,68 @@ namespace lv {
     struct IDataReporter_<DatasetEval_None> : public virtual IDataHandler {
         /// writes an evaluation report listing packet counts, seconds elapsed and algo speed for current batch(es)
         virtual void writeEvalReport() const override;
+        /// writes the processing results of this work batch to a binary stream (see IDatasetEvaluator_::writeShardResults)
+        virtual void writeShardResults(std::ostream& oStream) const;
+        /// merges processing results written via 'writeShardResults' (possibly by another process) into this work batch
+        virtual void mergeShardResults(std::istream& oStream);
+        /// atomically writes a checkpoint of this work batch (processed packets count, shard results & opaque algo state, e.g. a model snapshot) to its output directory
+        void writeCheckpoint(const std::string& sAlgoState=std::string()) const;
+        /// restores the last checkpoint of this work batch, if any (must be called before 'startProcessing'); returns the index of the next packet to process
+        size_t readCheckpoint(std::string& sAlgoState);
+        /// returns the path of the checkpoint file of this work batch
+        std::string getCheckpointFilePath() const;
+        /// evaluates the outputs previously saved for this work batch (loaded via IDataArchiver::load), replacing its current results (must not be processing)
+        virtual void evaluateSavedOutputs();
     protected:
         /// returns a one-line string listing packet counts, seconds elapsed and algo speed for current batch(es)
         virtual std::string writeInlineEvalReport(size_t nIndentSize) const;
         friend struct IDatasetEvaluator_<DatasetEval_None>;
     };
 
+    /// streaming binary classification metrics sink; keeps running totals per batch/category/dataset, and periodically exports them
+    struct MetricsStreamSink {
+        /// list of supported export formats (both are written to a file, and rewritten/appended at each export)
+        enum ExportFormat {
+            /// one JSON object per node appended at each export (tail-friendly)
+            ExportFormat_JSONLines,
+            /// Prometheus text exposition format, atomically rewritten at each export (for textfile collectors)
+            ExportFormat_Prometheus,
+        };
+        /// packed counters array, indexed via BinClassifMetricsAccumulator::CountersList
+        using Counters = std::array<uint64_t,BinClassifMetricsAccumulator::nCountersCount>;
+        /// creates a sink which will export its running totals to the given file at most once per period
+        MetricsStreamSink(const std::string& sExportFilePath, ExportFormat eFormat=ExportFormat_JSONLines, double dExportPeriod_sec=DATASETUTILS_METRICSSINK_DEFAULT_EXPORT_PERIOD_SEC);
+        /// writes a last export of the running totals
+        ~MetricsStreamSink();
+        /// registers a (non-group) work batch and its parent nodes, returning the node index to push deltas to
+        size_t registerBatch(const IDataHandlerPtr& pBatch);
+        /// adds a per-packet counters delta to a batch node and all of its parents in O(depth), and exports totals if the period elapsed
+        void push(size_t nNodeIdx, const Counters& anDelta, size_t nPackets=1);
+        /// exports the current running totals immediately
+        void flush();
+        /// returns the packed counters of a binary classification accumulator
+        static Counters getCounters(const BinClassifMetricsAccumulator& m);
+    protected:
+        /// running totals of a single node in the batch hierarchy
+        struct Node {
+            std::string sName; // full path of the node, starting with the dataset name
+            size_t nParentIdx; // SIZE_MAX for dataset-level nodes
+            Counters anCounters;
+            size_t nPackets;
+            std::weak_ptr<const IDataHandler> pBatch; // only set for work batches (used to query processing time)
+        };
+        /// writes the running totals of all nodes (sink mutex must be locked)
+        void exportTotals();
+        const std::string m_sExportFilePath;
+        const ExportFormat m_eFormat;
+        const double m_dExportPeriod_sec;
+        std::mutex m_oMutex;
+        std::vector<Node> m_voNodes;
+        std::map<std::string,size_t> m_mNodeIdxs;
+        lv::StopWatch m_oElapsedTimer,m_oExportTimer;
+    };
+    using MetricsStreamSinkPtr = std::shared_ptr<MetricsStreamSink>;
+
     template<>
     struct IDataReporter_<DatasetEval_BinaryClassifier> : IDataReporter_<DatasetEval_None> {
         /// accumulates basic metrics from current batch(es) --- provides group-impl only
@@ -69,9 +137,21 @@ namespace lv {
         virtual IMetricsCalculatorPtr getMetrics(bool bAverage) const;
         /// writes an evaluation report listing high-level metrics for current batch(es)
         virtual void writeEvalReport() const override;
+        /// sets the streaming sink that per-packet metrics deltas will be pushed into (for groups, set on all children batches)
+        virtual void setMetricsSink(const MetricsStreamSinkPtr& pMetricsSink);
+        /// writes the processing results of this work batch (including basic metrics counters) to a binary stream
+        virtual void writeShardResults(std::ostream& oStream) const override;
+        /// merges processing results written via 'writeShardResults' (including basic metrics counters) into this work batch
+        virtual void mergeShardResults(std::istream& oStream) override;
     protected:
+        /// adds the given basic metrics to the ones accumulated by this work batch --- provides non-group-impl only
+        virtual void mergeMetricsBase(const IMetricsAccumulatorConstPtr& pMetricsBase);
         /// returns a one-line string listing high-level metrics for current batch(es)
         virtual std::string writeInlineEvalReport(size_t nIndentSize) const override;
+        /// pushes the counters delta between the given snapshot and the current accumulator to the metrics sink, if any
+        void pushMetricsDelta(const MetricsStreamSink::Counters& anPrevCounters, const BinClassifMetricsAccumulator& oCurrMetrics);
+        MetricsStreamSinkPtr m_pMetricsSink;
+        size_t m_nMetricsSinkNodeIdx = SIZE_MAX;
         friend struct IDatasetEvaluator_<DatasetEval_BinaryClassifier>;
     };
 
@@ -89,20 +169,47 @@ namespace lv {
     struct DataEvaluator_<DatasetEval_BinaryClassifier,eDataset,lv::NonParallel> :
             public IDataConsumer_<DatasetEval_BinaryClassifier>,
             public DataReporter_<DatasetEval_BinaryClassifier,eDataset> {
+        /// stops the async evaluation worker (if any) after all queued results have been evaluated
+        virtual ~DataEvaluator_() {
+            try {
+                stopAsyncEvaluation();
+            }
+            catch(...) {} // destructors must not throw; errors should be caught via getMetricsBase or stopProcessing instead
+        }
         /// overrides 'getMetricsBase' from IDataReporter_ for non-group-impl (as always required)
         virtual IMetricsAccumulatorConstPtr getMetricsBase() const override {
+            waitForAsyncEvaluation();
             if(!m_pMetricsBase)
                 return BinClassifMetricsAccumulator::create();
             return m_pMetricsBase;
         }
-        /// overrides 'push' from IDataConsumer_ to simultaneously evaluate the pushed results
+        /// overrides 'push' from IDataConsumer_ to simultaneously evaluate the pushed results (on a worker thread, if async evaluation is enabled)
         virtual void push(const cv::Mat& oClassif, size_t nIdx) override {
             IDataConsumer_<DatasetEval_BinaryClassifier>::push(oClassif,nIdx);
             if(getDatasetInfo()->isUsingEvaluator()) {
                 auto pLoader = shared_from_this_cast<IDataLoader>(true);
+                if(m_bUsingAsyncEval) {
+                    // gt & roi packets are only referenced (precacher buffers are never recycled while in use), but the output must be copied
+                    queueAsyncEvaluation(AsyncEvalTask{oClassif.clone(),pLoader->getGT(nIdx),pLoader->getInputROI(nIdx)});
+                    return;
+                }
+                if(!m_pMetricsBase)
+                    m_pMetricsBase = BinClassifMetricsAccumulator::create();
+                accumulate(oClassif,pLoader->getGT(nIdx),pLoader->getInputROI(nIdx));
+            }
+        }
+        /// overrides 'push' from IDataConsumer_ to simultaneously evaluate the pushed bit-packed results (on a worker thread, if async evaluation is enabled)
+        virtual void push(const lv::PackedBinaryMask& oClassif, size_t nIdx) override {
+            IDataConsumer_<DatasetEval_BinaryClassifier>::push(oClassif,nIdx);
+            if(getDatasetInfo()->isUsingEvaluator()) {
+                auto pLoader = shared_from_this_cast<IDataLoader>(true);
+                if(m_bUsingAsyncEval) {
+                    queueAsyncEvaluation(AsyncEvalTask{cv::Mat(),pLoader->getGT(nIdx),pLoader->getInputROI(nIdx),oClassif});
+                    return;
+                }
                 if(!m_pMetricsBase)
                     m_pMetricsBase = BinClassifMetricsAccumulator::create();
-                m_pMetricsBase->accumulate(oClassif,pLoader->getGT(nIdx),pLoader->getInputROI(nIdx));
+                accumulate(oClassif,pLoader->getGT(nIdx),pLoader->getInputROI(nIdx));
             }
         }
         /// provides a visual feedback on result quality based on evaluation guidelines
@@ -112,10 +219,153 @@ namespace lv {
         }
         /// resets internal metrics counters to zero
         virtual void resetMetrics() {
+            waitForAsyncEvaluation();
             m_pMetricsBase = BinClassifMetricsAccumulator::create();
         }
+        /// toggles whether pushed results are evaluated on a separate worker thread (off the processing thread's critical path) or synchronously
+        void setAsyncEvaluation(bool bUsingAsyncEval) {
+            if(!bUsingAsyncEval)
+                stopAsyncEvaluation();
+            m_bUsingAsyncEval = bUsingAsyncEval;
+        }
+        /// returns whether pushed results are evaluated on a separate worker thread
+        bool isUsingAsyncEvaluation() const {return m_bUsingAsyncEval;}
+        /// overrides 'evaluateSavedOutputs' from IDataReporter_ to decode & evaluate saved outputs in parallel (gt packets are still fetched sequentially, one chunk at a time)
+        virtual void evaluateSavedOutputs() override {
+            lvAssert_(!isProcessing(),"must stop processing batch before evaluating saved outputs");
+            lvAssert_(getDatasetInfo()->isUsingEvaluator(),"dataset evaluator must be enabled to evaluate saved outputs");
+            auto pLoader = shared_from_this_cast<IDataLoader>(true);
+            stopAsyncEvaluation();
+            m_pMetricsBase = BinClassifMetricsAccumulator::create();
+            const size_t nTotPackets = getTotPackets();
+            std::vector<cv::Mat> voChunkGTs(DATASETUTILS_SAVED_OUTPUTS_EVAL_CHUNK_SIZE),voChunkROIs(DATASETUTILS_SAVED_OUTPUTS_EVAL_CHUNK_SIZE);
+            std::mutex oMetricsMutex;
+            for(size_t nChunkBeginIdx=0; nChunkBeginIdx<nTotPackets; nChunkBeginIdx+=DATASETUTILS_SAVED_OUTPUTS_EVAL_CHUNK_SIZE) {
+                const size_t nChunkEndIdx = std::min(nChunkBeginIdx+DATASETUTILS_SAVED_OUTPUTS_EVAL_CHUNK_SIZE,nTotPackets);
+                // gt & roi packets are only referenced (as for async evaluation), the loader is not reentrant
+                for(size_t nIdx=nChunkBeginIdx; nIdx<nChunkEndIdx; ++nIdx) {
+                    voChunkGTs[nIdx-nChunkBeginIdx] = pLoader->getGT(nIdx);
+                    voChunkROIs[nIdx-nChunkBeginIdx] = pLoader->getInputROI(nIdx);
+                }
+                lv::parallel_for(nChunkBeginIdx,nChunkEndIdx,1,[&](size_t nBeginIdx, size_t nEndIdx) {
+                    BinClassifMetricsAccumulatorPtr pMetricsBase = BinClassifMetricsAccumulator::create();
+                    for(size_t nIdx=nBeginIdx; nIdx<nEndIdx; ++nIdx) {
+                        const cv::Mat oClassif = load(nIdx);
+                        lvAssert__(!oClassif.empty(),"could not load saved output #%d for batch '%s'",(int)nIdx,getName().c_str());
+                        pMetricsBase->accumulate(oClassif,voChunkGTs[nIdx-nChunkBeginIdx],voChunkROIs[nIdx-nChunkBeginIdx]);
+                    }
+                    std::mutex_lock_guard oLock(oMetricsMutex);
+                    m_pMetricsBase->accumulate(pMetricsBase);
+                });
+            }
+            restoreProcessedPacketsCount(nTotPackets);
+        }
     protected:
+        /// output/gt/roi packets queued for async evaluation
+        struct AsyncEvalTask {
+            cv::Mat oClassif,oGT,oROI;
+            lv::PackedBinaryMask oPackedClassif; // only used if oClassif is empty
+        };
+        /// overrides '_stopProcessing' from IDataHandler to make sure all queued results are evaluated once processing is done
+        virtual void _stopProcessing() override {
+            stopAsyncEvaluation();
+        }
+        /// overrides 'mergeMetricsBase' from IDataReporter_ for non-group-impl (as always required)
+        virtual void mergeMetricsBase(const IMetricsAccumulatorConstPtr& pMetricsBase) override {
+            waitForAsyncEvaluation();
+            if(!m_pMetricsBase)
+                m_pMetricsBase = BinClassifMetricsAccumulator::create();
+            m_pMetricsBase->accumulate(pMetricsBase);
+        }
+        /// accumulates metrics for a single (regular or bit-packed) result, and forwards the counters delta to the streaming metrics sink (if any)
+        template<typename TClassif>
+        void accumulate(const TClassif& oClassif, const cv::Mat& oGT, const cv::Mat& oROI) {
+            if(this->m_pMetricsSink) {
+                const MetricsStreamSink::Counters anPrevCounters = MetricsStreamSink::getCounters(*m_pMetricsBase);
+                m_pMetricsBase->accumulate(oClassif,oGT,oROI);
+                this->pushMetricsDelta(anPrevCounters,*m_pMetricsBase);
+            }
+            else
+                m_pMetricsBase->accumulate(oClassif,oGT,oROI);
+        }
+        /// queues a result for async evaluation, starting the worker if needed (only blocks if the worker falls behind by a full queue)
+        void queueAsyncEvaluation(AsyncEvalTask&& oTask) {
+            std::mutex_unique_lock oLock(m_oAsyncEvalMutex);
+            if(!m_oAsyncEvalWorker.joinable()) {
+                if(!m_pMetricsBase)
+                    m_pMetricsBase = BinClassifMetricsAccumulator::create();
+                m_bAsyncEvalActive = true;
+                m_oAsyncEvalWorker = std::thread(&DataEvaluator_::asyncEvaluationLoop,this);
+            }
+            m_oAsyncEvalCondVar.wait(oLock,[&]{return m_qoAsyncEvalTasks.size()<DATASETUTILS_ASYNC_EVAL_MAX_QUEUE_SIZE;});
+            rethrowAsyncEvaluationException();
+            m_qoAsyncEvalTasks.push_back(std::move(oTask));
+            ++m_nAsyncEvalPendingCount;
+            m_oAsyncEvalCondVar.notify_all();
+        }
+        /// blocks until all queued results have been evaluated
+        void waitForAsyncEvaluation() const {
+            std::mutex_unique_lock oLock(m_oAsyncEvalMutex);
+            m_oAsyncEvalCondVar.wait(oLock,[&]{return m_nAsyncEvalPendingCount==0;});
+            rethrowAsyncEvaluationException();
+        }
+        /// rethrows the first exception caught by the async evaluation worker, if any (async eval mutex must be locked)
+        void rethrowAsyncEvaluationException() const {
+            if(m_pAsyncEvalException) {
+                std::exception_ptr pException = m_pAsyncEvalException;
+                m_pAsyncEvalException = nullptr;
+                std::rethrow_exception(pException);
+            }
+        }
+        /// evaluates all queued results, then stops & joins the async evaluation worker
+        void stopAsyncEvaluation() {
+            {
+                std::mutex_lock_guard oLock(m_oAsyncEvalMutex);
+                if(!m_oAsyncEvalWorker.joinable())
+                    return;
+                m_bAsyncEvalActive = false;
+                m_oAsyncEvalCondVar.notify_all();
+            }
+            m_oAsyncEvalWorker.join();
+            std::mutex_lock_guard oLock(m_oAsyncEvalMutex);
+            rethrowAsyncEvaluationException();
+        }
+        /// async evaluation worker loop
+        void asyncEvaluationLoop() {
+            std::mutex_unique_lock oLock(m_oAsyncEvalMutex);
+            while(true) {
+                m_oAsyncEvalCondVar.wait(oLock,[&]{return !m_qoAsyncEvalTasks.empty() || !m_bAsyncEvalActive;});
+                if(m_qoAsyncEvalTasks.empty())
+                    break;
+                AsyncEvalTask oTask = std::move(m_qoAsyncEvalTasks.front());
+                m_qoAsyncEvalTasks.pop_front();
+                m_oAsyncEvalCondVar.notify_all();
+                oLock.unlock();
+                try {
+                    if(oTask.oClassif.empty())
+                        accumulate(oTask.oPackedClassif,oTask.oGT,oTask.oROI);
+                    else
+                        accumulate(oTask.oClassif,oTask.oGT,oTask.oROI);
+                }
+                catch(...) { // will be rethrown in the processing thread on the next sync point
+                    oLock.lock();
+                    m_pAsyncEvalException = std::current_exception();
+                    oLock.unlock();
+                }
+                oLock.lock();
+                --m_nAsyncEvalPendingCount;
+                m_oAsyncEvalCondVar.notify_all();
+            }
+        }
         BinClassifMetricsAccumulatorPtr m_pMetricsBase;
+        bool m_bUsingAsyncEval = bool(DATASETUTILS_USE_ASYNC_CPU_EVALUATORS);
+        bool m_bAsyncEvalActive = false;
+        size_t m_nAsyncEvalPendingCount = 0;
+        std::deque<AsyncEvalTask> m_qoAsyncEvalTasks;
+        mutable std::mutex m_oAsyncEvalMutex;
+        mutable std::condition_variable m_oAsyncEvalCondVar;
+        std::thread m_oAsyncEvalWorker;
+        mutable std::exception_ptr m_pAsyncEvalException;
     };
 
 #if HAVE_GLSL
@@ -150,6 +400,13 @@ namespace lv {
                 m_pMetricsBase = pMetricsBase;
             }
         }
+        /// overrides 'mergeMetricsBase' from IDataReporter_ for non-group-impl (as always required)
+        virtual void mergeMetricsBase(const IMetricsAccumulatorConstPtr& pMetricsBase) override {
+            lvAssert_(!isProcessing(),"must stop processing batch before merging metrics under async data evaluator interface");
+            if(!m_pMetricsBase)
+                m_pMetricsBase = BinClassifMetricsAccumulator::create();
+            m_pMetricsBase->accumulate(pMetricsBase);
+        }
         /// overrides 'post_initialize_gl' from IAsyncDataConsumer_ to initialize an evaluation algo interface
         virtual void post_initialize_gl() override {
             IAsyncDataConsumer_<DatasetEval_BinaryClassifier,lv::GLSL>::post_initialize_gl();
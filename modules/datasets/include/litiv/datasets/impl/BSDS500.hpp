@@ -25,8 +25,13 @@
 // as defined in the BSDS500 scripts/dataset
 #define DATASETS_BSDS500_EVAL_DEFAULT_THRESH_BINS   99
 #define DATASETS_BSDS500_EVAL_IMAGE_DIAG_RATIO_DIST 0.0075
+// number of worker threads used to match edge maps in parallel (0 = use all hardware threads)
+#define DATASETS_BSDS500_EVAL_THREAD_COUNT         0
+// default edge matching mode used by new evaluators (see BSDS500EvalMode)
+#define DATASETS_BSDS500_EVAL_DEFAULT_MODE          BSDS500EvalMode_Exact
 
 struct BSDS500MetricsAccumulator;
+struct BSDS500GTData;
 
 enum BSDS500DatasetGroup {
     BSDS500Dataset_Training,
@@ -34,6 +39,16 @@ enum BSDS500DatasetGroup {
     BSDS500Dataset_Training_Validation_Test,
 };
 
+/// edge matching strategies used to evaluate boundary maps (counters from both modes share the same layout)
+enum BSDS500EvalMode {
+    /// one-to-one bipartite matching of edge pixels (via CSA when USE_BSDS500_BENCHMARK is set, greedy otherwise)
+    BSDS500EvalMode_Exact,
+    /// distance transform-based tolerance matching; much faster (no assignment problem), but since edge pixels
+    /// can be matched more than once, it overestimates both recall and precision (typically by ~0.01-0.03 in
+    /// F-measure on BSDS500 boundaries) --- useful to rank hyperparameter sets, not to report final scores
+    BSDS500EvalMode_Approx,
+};
+
 template<>
 struct DatasetEvaluator_<DatasetEval_BinaryClassifier,Dataset_BSDS500> :
         public IDatasetEvaluator_<DatasetEval_None> {
@@ -84,11 +99,11 @@ protected:
     virtual void parseData() override final {
         lvDbgExceptionWatch;
         // 'this' is required below since name lookup is done during instantiation because of not-fully-specialized class template
-        lv::GetFilesFromDir(this->getDataPath(),this->m_vsInputPaths);
+        this->getDatasetInfo()->getFilesFromDir(this->getDataPath(),this->m_vsInputPaths);
         lv::FilterFilePaths(this->m_vsInputPaths,{},{".jpg",".png",".bmp"});
         if(this->m_vsInputPaths.empty())
             lvError_("BSDS500 set '%s' did not possess any jpg/png/bmp image file",this->getName().c_str());
-        lv::GetSubDirsFromDir(lv::AddDirSlashIfMissing(this->getDatasetInfo()->getDatasetPath())+"../groundTruth_bdry_images/"+this->getRelativePath(),this->m_vsGTPaths);
+        this->getDatasetInfo()->getSubDirsFromDir(lv::AddDirSlashIfMissing(this->getDatasetInfo()->getDatasetPath())+"../groundTruth_bdry_images/"+this->getRelativePath(),this->m_vsGTPaths);
         if(this->m_vsGTPaths.empty())
             lvError_("BSDS500 set '%s' did not possess any groundtruth image folders",this->getName().c_str());
         else if(this->m_vsGTPaths.size()!=this->m_vsInputPaths.size())
@@ -96,7 +111,7 @@ protected:
         // make sure folders are non-empty, and folders & images are similarliy ordered
         std::vector<std::string> vsTempPaths;
         for(size_t nImageIdx=0; nImageIdx<this->m_vsGTPaths.size(); ++nImageIdx) {
-            lv::GetFilesFromDir(this->m_vsGTPaths[nImageIdx],vsTempPaths);
+            this->getDatasetInfo()->getFilesFromDir(this->m_vsGTPaths[nImageIdx],vsTempPaths);
             lvAssert(!vsTempPaths.empty());
             const size_t nLastInputSlashPos = this->m_vsInputPaths[nImageIdx].find_last_of("/\\");
             const std::string sInputFullName = nLastInputSlashPos==std::string::npos?this->m_vsInputPaths[nImageIdx]:this->m_vsInputPaths[nImageIdx].substr(nLastInputSlashPos+1);
@@ -125,7 +140,7 @@ protected:
             this->m_vbInputTransposed.push_back(oCurrInput.size()==cv::Size(321,481));
             this->m_vbGTTransposed.push_back(false);
             this->m_voInputOrigSizes.push_back(oCurrInput.size());
-            lv::GetFilesFromDir(this->m_vsGTPaths[nImageIdx],vsTempPaths);
+            this->getDatasetInfo()->getFilesFromDir(this->m_vsGTPaths[nImageIdx],vsTempPaths);
             lvAssert(!vsTempPaths.empty());
             this->m_voGTOrigSizes.push_back(cv::Size(481,321*int(vsTempPaths.size())));
             this->m_voInputSizes.push_back(cv::Size(int(481*dScale),int(321*dScale)));
@@ -143,7 +158,7 @@ protected:
         // 'this' is always required here since function name lookup is done during instantiation because of not-fully-specialized class template
         if(this->m_vsGTPaths.size()>nIdx) {
             std::vector<std::string> vsTempPaths;
-            lv::GetFilesFromDir(this->m_vsGTPaths[nIdx],vsTempPaths);
+            this->getDatasetInfo()->getFilesFromDir(this->m_vsGTPaths[nIdx],vsTempPaths);
             lvAssert(!vsTempPaths.empty());
             cv::Mat oTempRefGTImage = cv::imread(vsTempPaths[0],cv::IMREAD_GRAYSCALE);
             lvAssert(!oTempRefGTImage.empty());
@@ -192,6 +207,63 @@ public:
     virtual cv::Mat getColoredMask(const cv::Mat& oClassif, size_t nIdx);
     /// resets internal metrics counters to zero
     virtual void resetMetrics();
+    /// sets the edge matching mode used for all subsequently pushed results
+    void setEvalMode(BSDS500EvalMode eEvalMode);
+    /// returns the edge matching mode used for pushed results
+    inline BSDS500EvalMode getEvalMode() const {return m_eEvalMode;}
+    /// sets the directory where gt-side matching structures are also cached on disk, so later runs can skip building them (empty = in-memory cache only)
+    void setGTCacheDirPath(const std::string& sDirPath);
+protected:
+    std::shared_ptr<BSDS500MetricsAccumulator> m_pMetricsBase;
+    BSDS500EvalMode m_eEvalMode = DATASETS_BSDS500_EVAL_DEFAULT_MODE;
+    /// gt-side matching structures of all evaluated packets (kept across metrics resets)
+    std::map<size_t,std::shared_ptr<const BSDS500GTData>> m_mpGTDataCache;
+    std::string m_sGTCacheDirPath;
+};
+
+#if HAVE_GLSL
+
+template<>
+struct DataEvaluator_<DatasetEval_BinaryClassifier,Dataset_BSDS500,lv::GLSL> :
+        public IAsyncDataConsumer_<DatasetEval_BinaryClassifier,lv::GLSL>,
+        public DataReporter_<DatasetEval_BinaryClassifier,Dataset_BSDS500> {
+public:
+    /// stops the evaluation worker (if any) after all fetched results have been evaluated
+    virtual ~DataEvaluator_();
+    /// overrides 'getMetricsBase' from IDataReporter_ for non-group-impl (as always required)
+    virtual IMetricsAccumulatorConstPtr getMetricsBase() const override;
+    /// resets internal metrics counters to zero
+    virtual void resetMetrics();
+    /// sets the edge matching mode used for all subsequently evaluated results
+    void setEvalMode(BSDS500EvalMode eEvalMode);
+    /// returns the edge matching mode used for evaluated results
+    inline BSDS500EvalMode getEvalMode() const {return m_eEvalMode;}
 protected:
+    /// output/gt/roi packets fetched from the gpu, waiting for cpu evaluation
+    struct AsyncEvalTask {
+        cv::Mat oOutput,oGT,oROI;
+        size_t nIdx;
+    };
+    /// overrides '_stopProcessing' from IDataHandler to make sure all fetched results are evaluated once processing is done
+    virtual void _stopProcessing() override;
+    /// overrides 'post_initialize_gl' from IAsyncDataConsumer_ to fetch edge masks back from the gpu for evaluation
+    virtual void post_initialize_gl() override;
+    /// callback entrypoint for the edge masks read back from the gpu (queues them for evaluation on the worker thread)
+    void evaluationCallback(const cv::Mat& oInput, const cv::Mat& oDebug, const cv::Mat& oOutput, const cv::Mat& oGT, const cv::Mat& oROI, size_t nIdx);
+    /// evaluates all queued results, then stops & joins the evaluation worker
+    void stopAsyncEvaluation();
+    /// evaluation worker loop
+    void asyncEvaluationLoop();
     std::shared_ptr<BSDS500MetricsAccumulator> m_pMetricsBase;
+    BSDS500EvalMode m_eEvalMode = DATASETS_BSDS500_EVAL_DEFAULT_MODE;
+    /// gt-side matching structures of all evaluated packets (kept across metrics resets, only used by the worker)
+    std::map<size_t,std::shared_ptr<const BSDS500GTData>> m_mpGTDataCache;
+    bool m_bAsyncEvalActive = false;
+    std::deque<AsyncEvalTask> m_qoAsyncEvalTasks;
+    mutable std::mutex m_oAsyncEvalMutex;
+    mutable std::condition_variable m_oAsyncEvalCondVar;
+    std::thread m_oAsyncEvalWorker;
+    std::exception_ptr m_pAsyncEvalException;
 };
+
+#endif //HAVE_GLSL
@@ -59,13 +59,13 @@ protected:
     virtual void parseData() override final {
         // 'this' is required below since name lookup is done during instantiation because of not-fully-specialized class template
         std::vector<std::string> vsSubDirs;
-        lv::GetSubDirsFromDir(this->getDataPath(),vsSubDirs);
+        this->getDatasetInfo()->getSubDirsFromDir(this->getDataPath(),vsSubDirs);
         auto gtDir = std::find(vsSubDirs.begin(),vsSubDirs.end(),lv::AddDirSlashIfMissing(this->getDataPath())+"groundtruth");
         auto inputDir = std::find(vsSubDirs.begin(),vsSubDirs.end(),lv::AddDirSlashIfMissing(this->getDataPath())+"input");
         if(gtDir==vsSubDirs.end() || inputDir==vsSubDirs.end())
             lvError_("CDnet sequence '%s' did not possess the required groundtruth and input directories",this->getName().c_str());
-        lv::GetFilesFromDir(*inputDir,this->m_vsInputPaths);
-        lv::GetFilesFromDir(*gtDir,this->m_vsGTPaths);
+        this->getDatasetInfo()->getFilesFromDir(*inputDir,this->m_vsInputPaths);
+        this->getDatasetInfo()->getFilesFromDir(*gtDir,this->m_vsGTPaths);
         if(this->m_vsGTPaths.size()!=this->m_vsInputPaths.size())
             lvError_("CDnet sequence '%s' did not possess same amount of GT & input frames",this->getName().c_str());
         this->m_oROI = cv::imread(lv::AddDirSlashIfMissing(this->getDataPath())+"ROI.bmp",cv::IMREAD_GRAYSCALE);
@@ -87,5 +87,12 @@ protected:
         this->m_mGTIndexLUT.clear();
         for(size_t i=0; i<this->m_nFrameCount; ++i)
             this->m_mGTIndexLUT[i] = i; // direct gt path index to frame index mapping
+        // gt frames outside the temporal roi only contain out-of-scope labels (file holds the first/last evaluated frame numbers, 1-based)
+        std::ifstream oTemporalROIFile(lv::AddDirSlashIfMissing(this->getDataPath())+"temporalROI.txt");
+        size_t nTemporalROIFirst,nTemporalROILast;
+        if(oTemporalROIFile >> nTemporalROIFirst >> nTemporalROILast && nTemporalROIFirst>0 && nTemporalROIFirst<=nTemporalROILast) {
+            this->m_nTemporalROIBegin = nTemporalROIFirst-1;
+            this->m_nTemporalROIEnd = nTemporalROILast;
+        }
     }
 };
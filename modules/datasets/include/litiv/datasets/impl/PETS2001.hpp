@@ -59,17 +59,17 @@ protected:
         // 'this' is required below since name lookup is done during instantiation because of not-fully-specialized class template
         // @@@@ untested since 2016/01 refactoring
         std::vector<std::string> vsVideoSeqPaths;
-        lv::GetFilesFromDir(this->getDataPath(),vsVideoSeqPaths);
+        this->getDatasetInfo()->getFilesFromDir(this->getDataPath(),vsVideoSeqPaths);
         if(vsVideoSeqPaths.size()!=1)
             lvError_("PETS2006D3TC1 sequence '%s': bad subdirectory for parsing (should contain only one video sequence file)",this->getName().c_str());
         std::vector<std::string> vsGTSubdirPaths;
-        lv::GetSubDirsFromDir(this->getDataPath(),vsGTSubdirPaths);
+        this->getDatasetInfo()->getSubDirsFromDir(this->getDataPath(),vsGTSubdirPaths);
         if(vsGTSubdirPaths.size()!=1)
             lvError_("PETS2006D3TC1 sequence '%s': bad subdirectory for parsing (should contain only one GT subdir)",this->getName().c_str());
-        this->m_voVideoReader.open(vsVideoSeqPaths[0]);
+        this->openVideoReader(vsVideoSeqPaths[0]);
         if(!this->m_voVideoReader.isOpened())
             lvError_("PETS2006D3TC1 sequence '%s': video file could not be opened",this->getName().c_str());
-        lv::GetFilesFromDir(vsGTSubdirPaths[0],this->m_vsGTFramePaths);
+        this->getDatasetInfo()->getFilesFromDir(vsGTSubdirPaths[0],this->m_vsGTFramePaths);
         if(this->m_vsGTFramePaths.empty())
             lvError_("PETS2006D3TC1 sequence '%s': did not possess any valid GT frames",this->getName().c_str());
         const std::string sGTFilePrefix("image_");
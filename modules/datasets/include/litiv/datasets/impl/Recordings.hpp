@@ -0,0 +1,52 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// note: we should already be in the litiv namespace
+#ifndef __LITIV_DATASETS_IMPL_H
+#error "This file should never be included directly; use litiv/datasets.hpp instead"
+#endif //__LITIV_DATASETS_IMPL_H
+
+template<DatasetTaskList eDatasetTask, lv::ParallelAlgoType eEvalImpl>
+struct Dataset_<eDatasetTask,Dataset_Recordings,eEvalImpl> :
+        public IDataset_<eDatasetTask,DatasetSource_Recording,Dataset_Recordings,getDatasetEval<eDatasetTask,Dataset_Recordings>(),eEvalImpl> {
+    static_assert(eDatasetTask!=DatasetTask_Registr,"recordings do not support image registration (no image arrays)");
+protected: // should still be protected, as creation should always be done via datasets::create
+    Dataset_(
+            const std::string& sOutputDirName, ///< output directory (full) path for debug logs, evaluation reports and results archiving (will be created in recordings folder)
+            bool bSaveOutput=false, ///< defines whether results should be archived or not
+            bool bUseEvaluator=false, ///< defines whether results should be fully evaluated, or simply acknowledged (recordings have no gt, so all pixels are out of scope)
+            bool bForce4ByteDataAlign=false, ///< defines whether data packets should be 4-byte aligned (useful for GPU upload)
+            double dScaleFactor=1.0 ///< defines the scale factor to use to resize/rescale read packets
+    ) :
+            IDataset_<eDatasetTask,DatasetSource_Recording,Dataset_Recordings,getDatasetEval<eDatasetTask,Dataset_Recordings>(),eEvalImpl>(
+                    "Recordings",
+                    lv::AddDirSlashIfMissing(EXTERNAL_DATA_ROOT)+"Recordings/dataset/",
+                    lv::AddDirSlashIfMissing(EXTERNAL_DATA_ROOT)+"Recordings/"+lv::AddDirSlashIfMissing(sOutputDirName),
+                    "bin",
+                    ".png",
+                    std::vector<std::string>{""}, // each subdirectory holding a '.lvrec' container (e.g. written by apps/capture) is a work batch
+                    std::vector<std::string>{},
+                    std::vector<std::string>{},
+                    0,
+                    bSaveOutput,
+                    bUseEvaluator,
+                    bForce4ByteDataAlign,
+                    dScaleFactor
+            ) {}
+};
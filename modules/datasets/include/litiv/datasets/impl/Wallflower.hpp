@@ -59,7 +59,7 @@ protected:
         // 'this' is required below since name lookup is done during instantiation because of not-fully-specialized class template
         // @@@@ untested since 2016/01 refactoring
         std::vector<std::string> vsImgPaths;
-        lv::GetFilesFromDir(this->getDataPath(),vsImgPaths);
+        this->getDatasetInfo()->getFilesFromDir(this->getDataPath(),vsImgPaths);
         bool bFoundScript=false, bFoundGTFile=false;
         const std::string sGTFilePrefix("hand_segmented_");
         const size_t nInputFileNbDecimals = 5;
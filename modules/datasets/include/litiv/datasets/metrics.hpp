@@ -60,6 +60,10 @@ namespace lv {
         virtual bool isEqual(const IMetricsAccumulatorConstPtr& m) const override;
         virtual IMetricsAccumulatorPtr accumulate(const IMetricsAccumulatorConstPtr& m) override;
         virtual void accumulate(const cv::Mat& oClassif, const cv::Mat& oGT, const cv::Mat& oROI=cv::Mat());
+        /// accumulates counters like the function above, but splits the work into row bands processed by the given thread pool (useful for very large masks)
+        void accumulate(const cv::Mat& oClassif, const cv::Mat& oGT, const cv::Mat& oROI, ThreadPool& oThreadPool);
+        /// accumulates counters for a bit-packed classifier result (set bits are positives), where gt/roi flags are packed on the fly and counted 64 pixels at a time (AND + popcount)
+        void accumulate(const PackedBinaryMask& oClassif, const cv::Mat& oGT, const cv::Mat& oROI=cv::Mat());
         static cv::Mat getColoredMask(const cv::Mat& oClassif, const cv::Mat& oGT, const cv::Mat& oROI=cv::Mat());
         inline uint64_t total(bool bWithDontCare=false) const {return nTP+nTN+nFP+nFN+(bWithDontCare?nDC:uint64_t(0));}
         static std::shared_ptr<MetricsAccumulator_<DatasetEval_BinaryClassifier>> create();
@@ -121,4 +125,46 @@ namespace lv {
     using BinClassifMetricsCalculatorPtr = std::shared_ptr<BinClassifMetricsCalculator>;
     using BinClassifMetricsCalculatorConstPtr = std::shared_ptr<const BinClassifMetricsCalculator>;
 
+    /// confidence histogram accumulator used to evaluate soft 2d binary classifiers at all 8-bit thresholds in a single pass
+    struct BinClassifROCAccumulator :
+            public IMetricsAccumulator {
+        virtual bool isEqual(const IMetricsAccumulatorConstPtr& m) const override;
+        virtual IMetricsAccumulatorPtr accumulate(const IMetricsAccumulatorConstPtr& m) override;
+        /// adds the confidence values (8UC1) of all valid pixels to the positive or negative histogram, based on their gt label (pixels are valid as in BinClassifMetricsAccumulator)
+        void accumulate(const cv::Mat& oConfidence, const cv::Mat& oGT, const cv::Mat& oROI=cv::Mat());
+        /// accumulates histograms like the function above, but splits the work into row bands processed by the given thread pool (useful for very large masks)
+        void accumulate(const cv::Mat& oConfidence, const cv::Mat& oGT, const cv::Mat& oROI, ThreadPool& oThreadPool);
+        /// returns the binary classification counters obtained by labeling pixels with a confidence greater or equal to the given threshold as positive
+        BinClassifMetricsAccumulatorPtr getCounters(size_t nThreshold) const;
+        static std::shared_ptr<BinClassifROCAccumulator> create();
+        std::array<uint64_t,UCHAR_MAX+1> anPosHist; // confidence histogram of gt-positive pixels
+        std::array<uint64_t,UCHAR_MAX+1> anNegHist; // confidence histogram of gt-negative pixels
+        uint64_t nDC; // 'dont care' counter (pixels left out of both histograms)
+    protected:
+        /// default constructor sets all histogram bins to zero
+        BinClassifROCAccumulator();
+    };
+    using BinClassifROCAccumulatorPtr = std::shared_ptr<BinClassifROCAccumulator>;
+    using BinClassifROCAccumulatorConstPtr = std::shared_ptr<const BinClassifROCAccumulator>;
+
+    /// ROC/PR curves & summary metrics of soft 2d binary classifiers, derived from the cumulative sums of BinClassifROCAccumulator histograms
+    struct BinClassifROCCalculator :
+            public IMetricsCalculator {
+        virtual IMetricsCalculatorPtr accumulate(const IMetricsCalculatorConstPtr& m) override;
+        static std::shared_ptr<BinClassifROCCalculator> create(const IMetricsAccumulatorConstPtr& m);
+        std::vector<double> vdRecall; // true positive rate for each threshold in [0,256] (where 256 labels all pixels as negative)
+        std::vector<double> vdFPR; // false positive rate for each threshold in [0,256]
+        std::vector<double> vdPrecision; // precision for each threshold in [0,256]
+        double dAUC; // area under the ROC curve (trapezoidal rule)
+        double dBestFMeasure; // max F-measure over all thresholds
+        size_t nBestThreshold; // threshold yielding the max F-measure
+    protected:
+        /// default contructor requires a base histogram accumulator, as otherwise, we may obtain NaN's
+        BinClassifROCCalculator(const IMetricsAccumulatorConstPtr& m);
+        /// updates the best F-measure & threshold from the current curves
+        void updateBestFMeasure();
+    };
+    using BinClassifROCCalculatorPtr = std::shared_ptr<BinClassifROCCalculator>;
+    using BinClassifROCCalculatorConstPtr = std::shared_ptr<const BinClassifROCCalculator>;
+
 } // namespace lv
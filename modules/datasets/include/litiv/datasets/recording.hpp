@@ -0,0 +1,119 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/utils/platform.hpp"
+#include <opencv2/core.hpp>
+
+/// defines the file name suffix of multi-stream recording containers
+#define RECORDING_FILE_SUFFIX ".lvrec"
+/// defines the jpeg quality used by lossy recording streams
+#define RECORDING_JPEG_QUALITY 90
+/// defines the maximum length of recording stream names (including the null terminator)
+#define RECORDING_STREAM_NAME_MAX_LENGTH 32
+
+namespace lv {
+
+    /// packet codecs available for recording streams (chosen per stream when the container is created)
+    enum RecordingCodec {
+        RecordingCodec_Raw, ///< packets are stored as-is (any type)
+        RecordingCodec_Delta, ///< lossless left-predicted deltas w/ zero-run varint coding (1-channel 8U/16U, e.g. depth, infrared or label maps)
+        RecordingCodec_PNG, ///< lossless png coding via cv::imencode (8U/16U, 1 or 3 channels)
+        RecordingCodec_JPEG, ///< lossy jpeg coding via cv::imencode (8U, 1 or 3 channels)
+    };
+
+    /// description of a recording stream; all packets of a stream share the same size and type
+    struct RecordingStreamInfo {
+        std::string sName;
+        cv::Size oSize;
+        int nType;
+        RecordingCodec eCodec;
+    };
+
+    /// multi-stream recording container writer; packets of all streams are appended as interleaved timestamped chunks, and indexed on close
+    /// note: the container header stores the index offset, so files can be preallocated (the index is rebuilt by scanning chunks if it is missing)
+    struct RecordingWriter {
+        /// creates the container file (overwriting any previous content) with a fixed stream layout, optionally preallocating nPreallocBytes on disk
+        RecordingWriter(const std::string& sFilePath, const std::vector<RecordingStreamInfo>& voStreams, size_t nPreallocBytes=0);
+        /// writes the index and closes the container, if not already done
+        ~RecordingWriter();
+        /// encodes and appends a timestamped packet to a stream (thread-safe; only the file append is serialized, and any stream/frame order is accepted)
+        void write(size_t nStreamIdx, size_t nFrameIdx, int64_t nTimestamp, const cv::Mat& oPacket);
+        /// writes the index and closes the container (further writes are not allowed)
+        void close();
+        /// returns the number of streams in the container
+        inline size_t getStreamCount() const {return m_voStreams.size();}
+        /// returns the number of bytes written to the container so far (excluding preallocated space)
+        size_t getWrittenBytes() const;
+    private:
+        /// index entry kept in memory until the container is closed
+        struct ChunkEntry {
+            uint32_t nStreamIdx;
+            uint64_t nFrameIdx;
+            int64_t nTimestamp;
+            uint64_t nOffset;
+            uint64_t nSize;
+        };
+        const std::string m_sFilePath;
+        const std::vector<RecordingStreamInfo> m_voStreams;
+        std::fstream m_oFile;
+        mutable std::mutex m_oFileMutex;
+        std::vector<ChunkEntry> m_voChunks;
+        uint64_t m_nWritePos;
+        uint32_t m_nSessionTag;
+        RecordingWriter& operator=(const RecordingWriter&) = delete;
+        RecordingWriter(const RecordingWriter&) = delete;
+    };
+
+    /// multi-stream recording container reader; the container is memory-mapped, so packets can be decoded concurrently and out of order
+    struct RecordingReader {
+        /// opens and indexes the container at the given path (throws if it is not a valid recording)
+        RecordingReader(const std::string& sFilePath);
+        /// returns the number of streams in the container
+        inline size_t getStreamCount() const {return m_voStreams.size();}
+        /// returns the description of a stream
+        const RecordingStreamInfo& getStreamInfo(size_t nStreamIdx) const;
+        /// returns the index of the stream with the given name, or SIZE_MAX if there is none
+        size_t findStream(const std::string& sStreamName) const;
+        /// returns the number of packets recorded for a stream (packets are indexed by increasing frame index)
+        size_t getPacketCount(size_t nStreamIdx) const;
+        /// returns the frame index a packet was recorded with
+        size_t getFrameIdx(size_t nStreamIdx, size_t nPacketIdx) const;
+        /// returns the timestamp a packet was recorded with
+        int64_t getTimestamp(size_t nStreamIdx, size_t nPacketIdx) const;
+        /// decodes and returns a packet (reentrant)
+        cv::Mat read(size_t nStreamIdx, size_t nPacketIdx) const;
+        /// returns whether the index was rebuilt by scanning chunks (i.e. if the container was not closed properly)
+        inline bool isRecovered() const {return m_bRecovered;}
+    private:
+        struct PacketEntry {
+            uint64_t nFrameIdx;
+            int64_t nTimestamp;
+            uint64_t nOffset;
+            uint64_t nSize;
+        };
+        const PacketEntry& getPacketEntry(size_t nStreamIdx, size_t nPacketIdx) const;
+        const MappedFile m_oFile;
+        std::vector<RecordingStreamInfo> m_voStreams;
+        std::vector<std::vector<PacketEntry>> m_vvoPackets;
+        bool m_bRecovered;
+        RecordingReader& operator=(const RecordingReader&) = delete;
+        RecordingReader(const RecordingReader&) = delete;
+    };
+
+} // namespace lv
@@ -20,6 +20,8 @@
 #include "litiv/utils/parallel.hpp"
 #include "litiv/utils/opencv.hpp"
 #include "litiv/utils/platform.hpp"
+#include "litiv/utils/profiler.hpp"
+#include "litiv/datasets/recording.hpp"
 #include <opencv2/videoio.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
@@ -34,6 +36,29 @@
 // as defined in the bsds500 evaluation script
 #define DATASETUTILS_IMAGEEDGDET_EVAL_THRESHOLD_BINS 99
 
+// persistent dataset index file name (the dataset name is appended to it)
+#define DATASETUTILS_INDEX_FILE_NAME_PREFIX ".litiv_index_"
+/// defines the default directory in which node-wide shared packed caches are created (should be RAM-backed; empty = dataset output directory)
+#if defined(_MSC_VER)
+#define DATASETUTILS_SHARED_PACKED_CACHE_DIR ""
+#else //(!defined(_MSC_VER))
+#define DATASETUTILS_SHARED_PACKED_CACHE_DIR "/dev/shm/"
+#endif //(!defined(_MSC_VER))
+/// defines the name of the file in which measured work batch processing times are kept between runs (in the dataset output directory)
+#define DATASETUTILS_LOAD_HISTORY_FILE_NAME ".litiv_batch_loads"
+/// defines the weight of the latest measurement in the (exponentially smoothed) processing time of each work batch
+#define DATASETUTILS_LOAD_HISTORY_SMOOTHING 0.5
+/// defines the name of the file read in each live stream batch directory (first line: url/pipeline or camera index, optional second line: max frame count)
+#define DATASETUTILS_STREAM_SOURCE_FILE_NAME "stream.txt"
+/// defines the default number of frames served by a live stream batch if its source file does not specify it
+#define DATASETUTILS_STREAM_DEFAULT_FRAME_COUNT 1000000
+/// defines the maximum time to wait for a new frame from a live stream before considering it ended
+#define DATASETUTILS_STREAM_FRAME_TIMEOUT_MS 5000
+/// defines the name of the recording stream replayed as input by recording batches (the first stream is used if it is absent)
+#define DATASETUTILS_RECORDING_DEFAULT_STREAM "color"
+/// defines the number of threads used to parse work batches concurrently in IDataset::parseDataset (0 = one per hardware thread)
+#define DATASETUTILS_PARSING_THREAD_COUNT 0
+
 namespace lv {
 
     enum DatasetTaskList { // from the task type, we can derive the source and eval types
@@ -49,6 +74,8 @@ namespace lv {
         DatasetSource_VideoArray,
         DatasetSource_Image,
         DatasetSource_ImageArray,
+        DatasetSource_Stream,
+        DatasetSource_Recording,
         // ...
     };
 
@@ -67,6 +94,8 @@ namespace lv {
         Dataset_PETS2001D3TC1,
         Dataset_LITIV2012b,
         Dataset_BSDS500,
+        Dataset_LiveStream,
+        Dataset_Recordings,
         // ...
         Dataset_Custom // 'datasets::create' will forward all parameters from Dataset constr
     };
@@ -88,6 +117,13 @@ namespace lv {
         NoMapping
     };
 
+    enum GTPolicyFlag { // used to determine how gt packets are loaded and precached (flags can be combined)
+        GTPolicy_SkipOutOfScope = 1, // gt frames outside the batch's temporal roi are filled with the out-of-scope value instead of being decoded
+        GTPolicy_OnDemand = 2, // gt packets are never precached, and only decoded when requested (e.g. by the evaluator)
+        GTPolicy_Compact = 4, // precached gt packets are kept in a 2-bit palette encoding (when they use at most 4 label values)
+        GTPolicy_Default = GTPolicy_SkipOutOfScope
+    };
+
     /// returns the output packet type policy to use based on the dataset task type
     template<DatasetTaskList eDatasetTask>
     constexpr PacketPolicy getOutputPacketType() {
@@ -126,11 +162,54 @@ namespace lv {
     using IDatasetPtr = std::shared_ptr<IDataset>;
     using IDataHandlerPtr = std::shared_ptr<IDataHandler>;
     using IDataHandlerPtrArray = std::vector<IDataHandlerPtr>;
+    struct PacketLatencyTracer;
+    using PacketLatencyTracerPtr = std::shared_ptr<PacketLatencyTracer>;
     using IDataHandlerConstPtr = std::shared_ptr<const IDataHandler>;
     using IDataHandlerConstPtrArray = std::vector<IDataHandlerConstPtr>;
     using IDataHandlerPtrQueue = std::priority_queue<IDataHandlerPtr,IDataHandlerPtrArray,std::function<bool(const IDataHandlerPtr&,const IDataHandlerPtr&)>>;
     using AsyncDataCallbackFunc = std::function<void(const cv::Mat& /*oInput*/,const cv::Mat& /*oDebug*/,const cv::Mat& /*oOutput*/,const cv::Mat& /*oGT*/,const cv::Mat& /*oROI*/,size_t /*nIdx*/)>;
 
+    /// persistent directory listing index used to speed up dataset parsing (entries are validated via directory modification times)
+    struct DatasetIndex {
+        /// loads the index from the first valid file in the given list (if none, starts from an empty index)
+        DatasetIndex(const std::vector<std::string>& vsIndexFilePaths);
+        /// returns the (sorted) file paths found in a directory, listing it only if its index entry is missing or outdated
+        void getFilesFromDir(const std::string& sDirPath, std::vector<std::string>& vsFilePaths);
+        /// returns the (sorted) subdirectory paths found in a directory, listing it only if its index entry is missing or outdated
+        void getSubDirsFromDir(const std::string& sDirPath, std::vector<std::string>& vsSubDirPaths);
+        /// writes the index to the first writable file in the list if any entry changed; returns whether the index is up-to-date on disk
+        bool save();
+    protected:
+        /// cached listing of a single directory
+        struct DirEntry {
+            int64_t nModifTime;
+            bool bHasFiles,bHasSubDirs;
+            std::vector<std::string> vsFilePaths,vsSubDirPaths;
+        };
+        /// returns the index entry of a directory, resetting it if the directory changed since it was listed (index mutex must be locked)
+        DirEntry& getDirEntry(const std::string& sDirPath);
+        const std::vector<std::string> m_vsIndexFilePaths;
+        std::mutex m_oMutex;
+        std::map<std::string,DirEntry> m_mDirEntries;
+        bool m_bModified;
+    };
+    using DatasetIndexPtr = std::shared_ptr<DatasetIndex>;
+
+    /// persistent record of measured work batch processing times, used to schedule batches by actual (instead of estimated) cost
+    struct BatchLoadHistory {
+        /// loads previously measured processing times from the given file (if it exists)
+        BatchLoadHistory(const std::string& sFilePath);
+        /// fetches the (smoothed) processing time measured for a work batch in previous runs; returns false if none was recorded
+        bool getProcessTime(const std::string& sBatchRelPath, double& dProcessTime) const;
+        /// records a new processing time measurement for a work batch and rewrites the history file (failures are silently ignored)
+        void addProcessTime(const std::string& sBatchRelPath, double dProcessTime);
+    protected:
+        const std::string m_sFilePath;
+        mutable std::mutex m_oMutex;
+        std::map<std::string,double> m_mProcessTimes;
+    };
+    using BatchLoadHistoryPtr = std::shared_ptr<BatchLoadHistory>;
+
     /// fully abstract dataset interface (dataset parser & evaluator implementations will derive from this)
     struct IDataset : lv::enable_shared_from_this<IDataset> {
         /// returns the dataset name
@@ -171,6 +250,16 @@ namespace lv {
         virtual size_t getProcessedPacketsCount() const = 0;
         /// clears all batches and reparses them from the dataset metadata
         virtual void parseDataset() = 0;
+        /// returns the file paths found in a directory, using the persistent dataset index (if available)
+        virtual void getFilesFromDir(const std::string& sDirPath, std::vector<std::string>& vsFilePaths) const = 0;
+        /// returns the subdirectory paths found in a directory, using the persistent dataset index (if available)
+        virtual void getSubDirsFromDir(const std::string& sDirPath, std::vector<std::string>& vsSubDirPaths) const = 0;
+        /// returns the number of threads a single work batch may use internally while parsing its data (split with concurrently parsed batches)
+        virtual size_t getParsingThreadCount() const = 0;
+        /// returns the processing time measured for a work batch in previous runs, or its estimated load rescaled to match those measurements
+        virtual double getMeasuredLoad(const std::string& sBatchRelPath, double dEstimatedLoad) const = 0;
+        /// records the processing time of a fully processed work batch, for use as its expected load in later runs
+        virtual void setMeasuredLoad(const std::string& sBatchRelPath, double dProcessTime) = 0;
         /// writes the dataset-level evaluation report
         virtual void writeEvalReport() const = 0;
         /// returns the array of work batches (or groups, if requested with hierarchy) contained in this dataset
@@ -219,10 +308,18 @@ namespace lv {
         virtual bool isProcessing() const = 0;
         /// returns the current (or final) duration elapsed between start/stopProcessing calls (recursively queried for work groups)
         virtual double getProcessTime() const = 0;
+        /// adds processing time measured elsewhere (e.g. by another node of a sharded run) to the work batch total (work batches only)
+        virtual void addProcessTime(double dProcessTime) = 0;
         /// returns the total processed packet count, blocking if processing is not finished yet (recursively queried for work groups)
         virtual size_t getProcessedPacketsCountPromise() = 0;
         /// returns the total processed packet count (recursively queried from work batches)
         virtual size_t getProcessedPacketsCount() const = 0;
+        /// restores the processed packet count of a work batch resumed from a checkpoint (work batches only)
+        virtual void restoreProcessedPacketsCount(size_t nPackets) = 0;
+        /// sets the tracer that pipeline stages will timestamp packets into (for groups, set on all children batches; nullptr = disabled)
+        virtual void setLatencyTracer(const PacketLatencyTracerPtr& pTracer) = 0;
+        /// returns the tracer that pipeline stages timestamp packets into (nullptr if disabled)
+        virtual PacketLatencyTracer* getLatencyTracer() const = 0;
     protected:
         /// work batch/group comparison function based on names
         template<typename Tp>
@@ -260,23 +357,232 @@ namespace lv {
         friend struct IDataset_; // required for data handler sorting and other top-level dataset utility functions
     };
 
+    /// dataset-level work scheduler; runs a processing task over work batches (or batch segments) on a pool of workers, heaviest first, with work stealing
+    struct BatchScheduler {
+        /// task callback; receives the batch, the packet range [nBeginIdx,nEndIdx) to process, and the index of the worker running it
+        using TaskCallback = std::function<void(const IDataHandlerPtr& pBatch, size_t nBeginIdx, size_t nEndIdx, size_t nWorkerIdx)>;
+        /// progress callback; called (serialized) after each task with the completed task's batch, and the completed/total task & packet counts
+        using ProgressCallback = std::function<void(const IDataHandlerPtr& pBatch, size_t nDoneTasks, size_t nTotTasks, size_t nDonePackets, size_t nTotPackets)>;
+        /// creates a scheduler using nWorkers threads in total, including the caller of run (0 = one per hardware thread)
+        explicit BatchScheduler(size_t nWorkers=0);
+        /// returns the total number of workers used in run calls (including the caller)
+        inline size_t getWorkerCount() const {return m_nWorkers;}
+        /// sets the minimum packet count of batch segments (0 = never split batches); only enable if the task can process packet ranges of a batch independently
+        void setSegmentation(size_t nMinSegmentPackets);
+        /// sets the number of devices (e.g. GPUs) workers are spread over; tasks are balanced across devices first, then across each device's workers
+        void setDeviceCount(size_t nDevices);
+        /// returns the number of devices workers are spread over
+        inline size_t getDeviceCount() const {return m_nDevices;}
+        /// returns the index of the device the given worker is assigned to (workers are assigned round-robin)
+        inline size_t getWorkerDeviceIdx(size_t nWorkerIdx) const {return nWorkerIdx%m_nDevices;}
+        /// sets the callback used to report progress
+        void setProgressCallback(ProgressCallback lCallback);
+        /// runs the task over all given batches and blocks until done; the first exception thrown by a task is rethrown here (remaining tasks are skipped)
+        void run(const IDataHandlerPtrArray& vpBatches, const TaskCallback& lTask);
+    private:
+        struct Task {
+            IDataHandlerPtr pBatch;
+            size_t nBeginIdx,nEndIdx;
+            double dLoad;
+        };
+        const size_t m_nWorkers;
+        size_t m_nDevices;
+        size_t m_nMinSegmentPackets;
+        ProgressCallback m_lProgressCallback;
+    };
+
+    /// per-packet timestamp tracer for the data pipeline; stages timestamp packets by index, and latencies w.r.t. the previous stage reached by each packet are accumulated in histograms
+    struct PacketLatencyTracer {
+        /// list of traced pipeline stages (in pipeline order)
+        enum Stage {
+            /// frame captured by a live stream source
+            Stage_Capture,
+            /// packet loaded & transformed by the data loader
+            Stage_Decode,
+            /// packet handed to the algorithm via 'getInput'
+            Stage_Request,
+            /// processed packet pushed to the data consumer
+            Stage_Push,
+            /// processed packet queued in an async data writer
+            Stage_Enqueue,
+            /// processed packet written to disk
+            Stage_Write,
+            nStagesCount
+        };
+        /// latency histogram with power-of-two bins (bin N counts latencies in [2^N,2^(N+1)) microseconds, and bin 0 also counts shorter ones)
+        struct Histogram {
+            std::array<uint64_t,32> anBinCounts;
+            uint64_t nCount;
+            double dTotLatency_usec,dMaxLatency_usec;
+            /// returns an upper bound on the given latency percentile (in [0,1]), in microseconds
+            double getPercentile(double dPercentile) const;
+        };
+        /// creates a tracer keeping the timestamps of up to nMaxPendingPackets packets in flight at once
+        explicit PacketLatencyTracer(size_t nMaxPendingPackets=256);
+        /// records the time a packet reached a stage (only the first time is kept if marked again); thread-safe
+        void mark(size_t nIdx, Stage eStage, std::chrono::steady_clock::time_point nTime=std::chrono::steady_clock::now());
+        /// returns the latency histogram of a stage, in which each packet is timed w.r.t. the latest previous stage it reached
+        Histogram getStageHistogram(Stage eStage) const;
+        /// returns the end-to-end latency histogram, from the first to the last stage reached by each packet (only includes flushed packets)
+        Histogram getEndToEndHistogram() const;
+        /// accounts the end-to-end latencies of all pending packets, and clears them
+        void flush();
+        /// flushes pending packets, and writes all histograms (with their mean/percentiles) as a text report to the given file
+        void writeReport(const std::string& sFilePath);
+        /// returns the printable name of a stage
+        static const char* getStageName(Stage eStage);
+    private:
+        /// timestamps of a packet in flight (-1 for stages it has not reached)
+        struct Record {
+            size_t nIdx;
+            std::array<int64_t,nStagesCount> anStamps_usec;
+        };
+        /// accounts the end-to-end latency of a record, if it reached at least two stages (mutex must be locked)
+        void finalize(Record& oRecord);
+        static void addToHistogram(Histogram& oHist, double dLatency_usec);
+        mutable std::mutex m_oMutex;
+        std::vector<Record> m_voRecords;
+        std::array<Histogram,nStagesCount> m_aoStageHists;
+        Histogram m_oEndToEndHist;
+        const std::chrono::steady_clock::time_point m_nCreationTime;
+    };
+
+    /// process-wide memory budget shared by all data precachers & writers; capacity is periodically redistributed between their buffers based on recent consumption rates & stall times
+    struct BufferBudgetManager {
+        /// allocation snapshot of a registered buffer (for monitoring purposes)
+        struct Allocation {
+            std::string sName;
+            size_t nRequestedSize; // in bytes (upper bound on the allocation)
+            size_t nAllocatedSize; // in bytes
+            double dConsumptionRate; // smoothed, in bytes per second
+            double dStallRatio; // smoothed fraction of time spent stalled on this buffer
+        };
+        /// budget registration held by a buffer owner (unregisters on destruction); the allocation can be polled & activity reported without locking
+        struct Lease {
+            /// unregisters the buffer, returning its allocation to the others
+            ~Lease();
+            /// returns the current allocation of the buffer, in bytes
+            inline size_t getAllocatedSize() const {return m_nAllocatedSize;}
+            /// reports the bytes consumed from (or queued into) the buffer and the time its users were stalled on it since the last report
+            void reportActivity(size_t nConsumedBytes, double dStalledTime_sec);
+        private:
+            Lease(BufferBudgetManager& oManager, const std::string& sName, size_t nRequestedSize);
+            BufferBudgetManager& m_oManager;
+            const std::string m_sName;
+            const size_t m_nRequestedSize;
+            std::atomic_size_t m_nAllocatedSize;
+            std::atomic_size_t m_nConsumedBytes,m_nStalledTime_usec; // accumulated since the last rebalance
+            double m_dConsumptionRate,m_dStallRatio; // smoothed stats (manager mutex must be locked)
+            bool m_bHasStats;
+            friend struct BufferBudgetManager;
+            Lease& operator=(const Lease&) = delete;
+            Lease(const Lease&) = delete;
+        };
+        using LeasePtr = std::unique_ptr<Lease>;
+        /// returns the process-wide budget manager (total budget defaults to the compile-time cache size)
+        static BufferBudgetManager& get();
+        /// sets the total budget shared by all buffers (in bytes), and rebalances allocations
+        void setTotalSize(size_t nTotalSize);
+        /// returns the total budget shared by all buffers (in bytes)
+        size_t getTotalSize() const;
+        /// registers a new buffer which should never use more than nRequestedSize bytes, and rebalances allocations
+        LeasePtr registerBuffer(const std::string& sName, size_t nRequestedSize);
+        /// returns an allocation snapshot of all registered buffers
+        std::vector<Allocation> getAllocations() const;
+    private:
+        BufferBudgetManager();
+        /// rebalances allocations if the rebalancing period elapsed (lock-free if not)
+        void rebalanceIfDue();
+        /// redistributes the total budget between registered buffers (mutex must be locked)
+        void rebalance();
+        /// returns the time elapsed since the creation of the manager, in microseconds
+        int64_t getElapsedTime_usec() const;
+        mutable std::mutex m_oMutex;
+        std::vector<Lease*> m_vpLeases;
+        size_t m_nTotalSize;
+        const std::chrono::steady_clock::time_point m_nCreationTime;
+        int64_t m_nLastRebalanceTime_usec; // since creation (mutex must be locked)
+        std::atomic<int64_t> m_nNextRebalanceTime_usec; // since creation
+        BufferBudgetManager& operator=(const BufferBudgetManager&) = delete;
+        BufferBudgetManager(const BufferBudgetManager&) = delete;
+    };
+
+    /// batched asynchronous file reader; files following the last request are read into memory buffers by a pool of i/o threads, keeping many reads in flight at once (hides per-file latency, e.g. on network file systems)
+    struct AsyncFileReader {
+        /// creates a reader for the given file list, keeping up to nMaxInFlight files read (or being read) ahead of requests using nThreads i/o threads
+        AsyncFileReader(const std::vector<std::string>& vsFilePaths, size_t nMaxInFlight, size_t nThreads);
+        /// joins all i/o threads (pending reads are completed, but their results dropped)
+        ~AsyncFileReader();
+        /// returns the contents of a file by index, waiting for its pending read (or reading it synchronously if it was not queued), and queues reads for the following files (thread-safe)
+        bool read(size_t nIdx, std::vector<uchar>& vBuffer);
+    private:
+        /// read slot of a queued file; consumed (and erased) by 'read'
+        struct ReadSlot {
+            bool bDone,bSuccess;
+            std::vector<uchar> vBuffer;
+        };
+        void entry();
+        /// reads a whole file into the given buffer, returning false if it could not be opened or read
+        static bool readFile(const std::string& sFilePath, std::vector<uchar>& vBuffer);
+        const std::vector<std::string> m_vsFilePaths;
+        const size_t m_nMaxInFlight;
+        std::vector<std::thread> m_vhWorkers;
+        std::mutex m_oMutex;
+        std::condition_variable m_oQueueCondVar,m_oDoneCondVar;
+        std::deque<size_t> m_qnQueuedIdxs;
+        std::map<size_t,ReadSlot> m_mReadSlots;
+        size_t m_nNextQueueIdx;
+        bool m_bStopping;
+        AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+        AsyncFileReader(const AsyncFileReader&) = delete;
+    };
+
     /// general-purpose data packet precacher, fully implemented (i.e. can be used stand-alone)
     struct DataPrecacher {
-        /// attaches to data loader (will halt auto-precaching if an empty packet is fetched)
-        DataPrecacher(std::function<const cv::Mat&(size_t)> lDataLoaderCallback);
+        /// attaches to data loader (will halt auto-precaching if an empty packet is fetched); the optional reentrant loader enables parallel decoding
+        DataPrecacher(std::function<const cv::Mat&(size_t)> lDataLoaderCallback, std::function<cv::Mat(size_t)> lReentrantDataLoaderCallback=nullptr);
         /// default destructor (joins the precaching thread, if still running)
         ~DataPrecacher();
         /// fetches a packet, with or without precaching enabled (should never be called concurrently, returned packets should never be altered directly, and a single packet loaded twice is assumed identical)
+        /// note: returned packets are ref-counted views of pooled buffers which are not recycled while referenced, so copies of their headers can be held across requests without cloning
         const cv::Mat& getPacket(size_t nIdx);
-        /// initializes precaching with a given buffer size (starts up thread)
+        /// initializes precaching with a given max buffer size (starts up thread); the actual buffer size is granted by the process-wide budget manager
         bool startAsyncPrecaching(size_t nSuggestedBufferSize);
         /// joins precaching thread and clears all internal buffers
         void stopAsyncPrecaching();
         /// returns whether the precaching thread has already been started or not
         inline bool isActive() const {return m_bIsActive;}
+        /// sets the number of workers decoding packets ahead of the precaching thread (only used with a reentrant loader, applied on next start; 1 = no pool)
+        void setDecodeWorkerCount(size_t nWorkers);
+        /// returns the number of workers decoding packets ahead of the precaching thread
+        inline size_t getDecodeWorkerCount() const {return m_nDecodeWorkerCount;}
+        /// hints the precaching thread that packets in [nBegin,nEnd) will soon be requested (best effort; ignored if precaching is inactive)
+        void prefetch(size_t nBegin, size_t nEnd);
+        /// returns the number of packet requests answered from the cache since precaching was last started
+        inline size_t getCacheHitCount() const {return m_nCacheHitCount;}
+        /// returns the number of packet requests that had to be loaded synchronously since precaching was last started
+        inline size_t getCacheMissCount() const {return m_nCacheMissCount;}
+        /// returns the memory usage currently attributed to this precacher (i.e. allocated by its precaching & decoding threads)
+        lv::MemoryTracker::Usage getMemoryUsage() const;
     private:
-        void entry(const size_t nBufferSize);
+        void entry();
+        void decoderEntry();
+        /// returns the packet at the given index, from the decode pool (in order) if it is active, or from the loader directly otherwise (uniquely owned when possible)
+        cv::Mat fetchPacket(size_t nIdx);
+        /// returns the packet at the given index directly from the loader, preferring the by-value callback (so that the result can be adopted without copies)
+        cv::Mat loadPacket(size_t nIdx);
         const std::function<const cv::Mat&(size_t)> m_lCallback;
+        const std::function<cv::Mat(size_t)> m_lReentrantCallback;
+        size_t m_nDecodeWorkerCount;
+        std::vector<std::thread> m_vhDecoders;
+        std::mutex m_oDecodeMutex;
+        std::condition_variable m_oDecodeReqCondVar;
+        std::condition_variable m_oDecodeDoneCondVar;
+        std::map<size_t,cv::Mat> m_mDecodedPackets;
+        size_t m_nDecodeWindowStart,m_nNextDecodeIdx,m_nDecodeWindowSize,m_nDecodeGeneration;
+        std::mutex m_oHintMutex;
+        std::queue<std::pair<size_t,size_t>> m_qoPrefetchHints;
+        std::atomic_size_t m_nCacheHitCount,m_nCacheMissCount;
         std::thread m_hWorker;
         std::mutex m_oSyncMutex;
         std::condition_variable m_oReqCondVar;
@@ -284,6 +590,8 @@ namespace lv {
         std::atomic_bool m_bIsActive;
         size_t m_nReqIdx,m_nLastReqIdx;
         cv::Mat m_oReqPacket,m_oLastReqPacket;
+        BufferBudgetManager::LeasePtr m_pBudgetLease;
+        const lv::MemoryTracker::TagPtr m_pMemoryTag;
         DataPrecacher& operator=(const DataPrecacher&) = delete;
         DataPrecacher(const DataPrecacher&) = delete;
     };
@@ -302,10 +610,36 @@ namespace lv {
         virtual void startAsyncPrecaching(bool bPrecacheGT, size_t nSuggestedBufferSize=SIZE_MAX);
         /// kills the asynchronyzed precacher, and clears internal buffers
         virtual void stopAsyncPrecaching();
+        /// sets the number of parallel decode workers used by the precachers (only effective if packet loading is reentrant for this batch, applied on next start)
+        void setPrecacheDecodeWorkerCount(size_t nWorkers);
+        /// decodes & transforms all input (and optionally gt) packets of this batch, and writes them as raw aligned planes in a single packed binary file
+        void writePackedCache(const std::string& sFilePath, bool bWithGT=true);
+        /// memory-maps a packed binary file written via writePackedCache; packets are then returned as zero-copy views of the mapping (precaching is disabled)
+        void usePackedCache(const std::string& sFilePath);
+        /// maps a packed cache shared by all processes on this node, keyed by dataset, batch and packet transforms; the first process to get here writes it (under a file lock), others wait and map it read-only
+        void useSharedPackedCache(const std::string& sCacheDirPath=std::string(DATASETUTILS_SHARED_PACKED_CACHE_DIR), bool bWithGT=true);
+        /// returns whether packets are currently served from a memory-mapped packed cache
+        inline bool isUsingPackedCache() const {return bool(m_pPackedCache);}
+        /// hints the precachers that packets in [nBegin,nEnd) will soon be requested (useful before seeking or scrubbing through the batch)
+        void prefetchPackets(size_t nBegin, size_t nEnd, bool bWithGT=false) {m_oInputPrecacher.prefetch(nBegin,nEnd); if(bWithGT) m_oGTPrecacher.prefetch(nBegin,nEnd);}
         /// returns an input packet by index (with both with and without precaching enabled)
-        const cv::Mat& getInput(size_t nPacketIdx) {return m_oInputPrecacher.getPacket(nPacketIdx);}
+        const cv::Mat& getInput(size_t nPacketIdx) {
+            const cv::Mat& oPacket = m_oInputPrecacher.getPacket(nPacketIdx);
+            if(PacketLatencyTracer* pTracer = getLatencyTracer())
+                pTracer->mark(nPacketIdx,PacketLatencyTracer::Stage_Request);
+            return oPacket;
+        }
+        /// returns up to nCount consecutive input packets (all of the same size/type) stacked in a single contiguous 3-dim matrix (count x rows x cols); per-packet 2d views can also be returned
+        /// note: the stacked buffer is reused across calls only once all references to it are released, and the following range is prefetched
+        cv::Mat getInputBatch(size_t nFirstIdx, size_t nCount, std::vector<cv::Mat>* pvoPacketViews=nullptr);
         /// returns a gt packet by index (with both with and without precaching enabled)
-        const cv::Mat& getGT(size_t nPacketIdx) {return m_oGTPrecacher.getPacket(nPacketIdx);}
+        const cv::Mat& getGT(size_t nPacketIdx);
+        /// sets the gt loading/precaching policy as a combination of GTPolicyFlag values (applied on next precaching start)
+        void setGTPolicy(int nGTPolicyFlags) {m_nGTPolicyFlags = nGTPolicyFlags;}
+        /// returns the gt loading/precaching policy as a combination of GTPolicyFlag values
+        inline int getGTPolicy() const {return m_nGTPolicyFlags;}
+        /// returns whether a gt packet lies outside the temporal roi of this batch, i.e. would only contain out-of-scope labels (dataset-specific)
+        virtual bool isGTOutOfScope(size_t /*nPacketIdx*/) const {return false;}
         /// returns whether an input packet should be transposed or not (only applicable to image packets)
         virtual bool isInputTransposed(size_t /*nPacketIdx*/) const {return false;}
         /// returns whether a gt packet should be transposed or not (only applicable to image packets)
@@ -333,9 +667,22 @@ namespace lv {
         virtual cv::Mat _getInputPacket_impl(size_t nIdx) = 0;
         /// gt packet load function, dataset-specific (can return empty mats)
         virtual cv::Mat _getGTPacket_impl(size_t nIdx) = 0;
+        /// returns whether the packet load functions above can be called concurrently for different indices (required for parallel decoding)
+        virtual bool isPacketLoadReentrant() const {return false;}
+        /// reads an input image packet from disk (or decodes it from the given file contents); if it will be downscaled by half or more, the decoder's native reduced decoding is used (e.g. jpeg dct scaling), and the returned packet is smaller than its original size
+        cv::Mat readInputImagePacket(const std::string& sFilePath, size_t nIdx, const std::vector<uchar>* pvFileData=nullptr) const;
     private:
-        cv::Mat m_oLatestInputPacket, m_oLatestGTPacket;
+        cv::Mat m_oLatestInputPacket, m_oLatestGTPacket, m_oDecodedGTPacket, m_oInputBatchBuffer;
         DataPrecacher m_oInputPrecacher,m_oGTPrecacher;
+        int m_nGTPolicyFlags;
+        bool m_bGTPrecacheCompact;
+        size_t m_nPrecacheDecodeWorkerCount;
+        std::shared_ptr<const MappedFile> m_pPackedCache;
+        bool m_bPackedCacheHasGT;
+        cv::Mat _getPackedPacket(size_t nIdx, bool bGT) const;
+        cv::Mat _loadInputPacket(size_t nIdx);
+        cv::Mat _loadGTPacket(size_t nIdx);
+        cv::Mat _loadPrecachedGTPacket(size_t nIdx);
         const cv::Mat& _getInputPacket_redirect(size_t nIdx);
         const cv::Mat& _getGTPacket_redirect(size_t nIdx);
         const PacketPolicy m_eInputType,m_eOutputType;
@@ -361,6 +708,8 @@ namespace lv {
         virtual const cv::Size& getFrameSize() const {return m_oSize;}
         /// return the original (constant) frame size used in this video sequence
         virtual const cv::Size& getFrameOrigSize() const {return m_oOrigSize;}
+        /// returns whether a gt frame lies outside the [begin,end) temporal roi of this video sequence (if any)
+        virtual bool isGTOutOfScope(size_t nPacketIdx) const override {return nPacketIdx<m_nTemporalROIBegin || nPacketIdx>=m_nTemporalROIEnd;}
 
     protected:
         IDataProducer_(PacketPolicy eOutputType, MappingPolicy eGTMappingType, MappingPolicy eIOMappingType);
@@ -378,11 +727,17 @@ namespace lv {
         virtual cv::Mat _getInputPacket_impl(size_t nIdx) override;
         virtual cv::Mat _getGTPacket_impl(size_t nIdx) override;
         virtual void parseData() override;
+        virtual bool isPacketLoadReentrant() const override;
+        /// opens the video reader on the given file, requesting hardware-accelerated decoding when supported by the opencv build
+        bool openVideoReader(const std::string& sVideoFilePath);
+        /// positions the (stateful) video reader so that the next retrieved frame is the requested one
+        void seekVideoReader(size_t nFrameIdx);
         size_t m_nFrameCount;
         std::unordered_map<size_t,size_t> m_mGTIndexLUT;
         std::vector<std::string> m_vsInputPaths,m_vsGTPaths;
         cv::VideoCapture m_voVideoReader;
         size_t m_nNextExpectedVideoReaderFrameIdx;
+        size_t m_nTemporalROIBegin,m_nTemporalROIEnd;
         bool m_bTransposeFrames;
         cv::Mat m_oROI;
         cv::Size m_oOrigSize,m_oSize;
@@ -391,12 +746,16 @@ namespace lv {
     template<>
     struct IDataProducer_<DatasetSource_Image> :
             public IDataLoader {
+        /// stops precaching before the input file reader is released
+        virtual ~IDataProducer_();
         /// redirects to getTotPackets()
         inline size_t getImageCount() const {return getTotPackets();}
         /// compute the expected CPU load for this data batch based on max image size, image count, and channel count
         virtual double getExpectedLoad() const override;
-        /// initializes image precaching for this work batch (will try to allocate enough memory for the entire set)
+        /// initializes image precaching for this work batch (will try to allocate enough memory for the entire set), with input files read ahead asynchronously
         virtual void startAsyncPrecaching(bool bUsingGT, size_t /*nUnused*/=0) override;
+        /// stops image precaching, and releases the input file reader
+        virtual void stopAsyncPrecaching() override;
         /// returns whether all input images in this batch have the same size
         virtual bool isInputConstantSize() const;
         /// returns whether all input images in this batch have the same size
@@ -430,6 +789,7 @@ namespace lv {
         virtual cv::Mat _getInputPacket_impl(size_t nIdx) override;
         virtual cv::Mat _getGTPacket_impl(size_t nIdx) override;
         virtual void parseData() override;
+        virtual bool isPacketLoadReentrant() const override;
         size_t m_nImageCount;
         std::unordered_map<size_t,size_t> m_mGTIndexLUT;
         std::vector<std::string> m_vsInputPaths,m_vsGTPaths;
@@ -438,6 +798,115 @@ namespace lv {
         std::vector<bool> m_vbInputTransposed,m_vbGTTransposed;
         bool m_bIsInputConstantSize,m_bIsGTConstantSize;
         cv::Size m_oInputMaxSize,m_oGTMaxSize;
+        std::unique_ptr<AsyncFileReader> m_pInputFileReader;
+    };
+
+    template<>
+    struct IDataProducer_<DatasetSource_Stream> :
+            public IDataLoader {
+        /// joins the capture thread, if still running
+        virtual ~IDataProducer_();
+        /// redirects to getTotPackets() (i.e. the maximum number of frames served from the stream)
+        inline size_t getFrameCount() const {return getTotPackets();}
+        /// compute the expected CPU load for this data batch based on frame size, frame count, and channel count
+        virtual double getExpectedLoad() const override;
+        /// starts the capture thread; packets are never precached ahead, as only the latest captured frame is served (latest-wins)
+        virtual void startAsyncPrecaching(bool bUsingGT, size_t /*nUnused*/=0) override;
+        /// stops and joins the capture thread
+        virtual void stopAsyncPrecaching() override;
+        /// returns the ROI associated with the stream (always the full frame)
+        virtual const cv::Mat& getROI() const {return m_oROI;}
+        /// return the (constant) frame size used in this stream, post-transformations
+        virtual const cv::Size& getFrameSize() const {return m_oSize;}
+        /// return the original (constant) frame size used in this stream
+        virtual const cv::Size& getFrameOrigSize() const {return m_oOrigSize;}
+        /// live streams have no gt, so all gt packets are considered out of scope
+        virtual bool isGTOutOfScope(size_t /*nPacketIdx*/) const override {return true;}
+        /// returns the capture timestamp (in seconds since capture start) of a served packet, or a negative value if it was not served yet
+        double getCaptureTimestamp(size_t nPacketIdx) const;
+        /// returns the number of frames captured since the capture thread was started
+        size_t getCapturedFrameCount() const;
+        /// returns the number of captured frames that were dropped because a newer frame was available when a packet was requested
+        size_t getDroppedFrameCount() const;
+        /// returns the standard deviation of the intervals between captured frames, in milliseconds
+        double getCaptureJitter() const;
+
+    protected:
+        IDataProducer_(PacketPolicy eOutputType, MappingPolicy eGTMappingType, MappingPolicy eIOMappingType);
+        virtual size_t getTotPackets() const override;
+        virtual const cv::Mat& getInputROI(size_t nPacketIdx) const override final;
+        virtual const cv::Mat& getGTROI(size_t nPacketIdx) const override;
+        virtual const cv::Size& getInputSize(size_t nPacketIdx) const override final;
+        virtual const cv::Size& getGTSize(size_t nPacketIdx) const override;
+        virtual const cv::Size& getInputOrigSize(size_t nPacketIdx) const override final;
+        virtual const cv::Size& getGTOrigSize(size_t nPacketIdx) const override;
+        virtual const cv::Size& getInputMaxSize() const override final;
+        virtual const cv::Size& getGTMaxSize() const override;
+        virtual cv::Mat _getInputPacket_impl(size_t nIdx) override;
+        virtual cv::Mat _getGTPacket_impl(size_t nIdx) override;
+        virtual void parseData() override;
+        /// opens the capture device/stream described by m_sStreamSource
+        bool openStream();
+        /// capture thread loop, which keeps only the latest frame read from the stream
+        void captureEntry();
+        std::string m_sStreamSource;
+        size_t m_nFrameCount;
+        cv::VideoCapture m_oCapture;
+        std::thread m_hCaptureWorker;
+        mutable std::mutex m_oCaptureMutex;
+        std::condition_variable m_oCaptureCondVar;
+        std::atomic_bool m_bCaptureActive;
+        bool m_bStreamEnded;
+        cv::Mat m_oLatestFrame;
+        size_t m_nCapturedFrameCount,m_nLastServedFrameCount,m_nDroppedFrameCount;
+        double m_dLatestFrameTimestamp,m_dMeanInterval,m_dIntervalM2;
+        std::vector<double> m_vdPacketTimestamps;
+        std::chrono::steady_clock::time_point m_oCaptureStartTime;
+        cv::Mat m_oROI;
+        cv::Size m_oOrigSize,m_oSize;
+    };
+
+    template<>
+    struct IDataProducer_<DatasetSource_Recording> :
+            public IDataLoader {
+        /// redirects to getTotPackets() (i.e. the number of packets recorded in the input stream)
+        inline size_t getFrameCount() const {return getTotPackets();}
+        /// compute the expected CPU load for this data batch based on frame size, frame count, and channel count
+        virtual double getExpectedLoad() const override;
+        /// initializes packet precaching for this work batch (packets are decoded straight from the memory-mapped recording, and concurrently if possible)
+        virtual void startAsyncPrecaching(bool bUsingGT, size_t /*nUnused*/=0) override;
+        /// returns the ROI associated with the recording (always the full frame)
+        virtual const cv::Mat& getROI() const {return m_oROI;}
+        /// return the (constant) frame size used in this recording, post-transformations
+        virtual const cv::Size& getFrameSize() const {return m_oSize;}
+        /// return the original (constant) frame size used in this recording
+        virtual const cv::Size& getFrameOrigSize() const {return m_oOrigSize;}
+        /// recordings have no gt, so all gt packets are considered out of scope
+        virtual bool isGTOutOfScope(size_t /*nPacketIdx*/) const override {return true;}
+        /// returns the capture timestamp (in microseconds since capture start) of an input packet
+        int64_t getPacketTimestamp(size_t nPacketIdx) const;
+        /// returns the recording reader, e.g. to fetch the (synchronized) packets of other streams
+        const RecordingReader& getRecording() const;
+
+    protected:
+        IDataProducer_(PacketPolicy eOutputType, MappingPolicy eGTMappingType, MappingPolicy eIOMappingType);
+        virtual size_t getTotPackets() const override;
+        virtual const cv::Mat& getInputROI(size_t nPacketIdx) const override final;
+        virtual const cv::Mat& getGTROI(size_t nPacketIdx) const override;
+        virtual const cv::Size& getInputSize(size_t nPacketIdx) const override final;
+        virtual const cv::Size& getGTSize(size_t nPacketIdx) const override;
+        virtual const cv::Size& getInputOrigSize(size_t nPacketIdx) const override final;
+        virtual const cv::Size& getGTOrigSize(size_t nPacketIdx) const override;
+        virtual const cv::Size& getInputMaxSize() const override final;
+        virtual const cv::Size& getGTMaxSize() const override;
+        virtual cv::Mat _getInputPacket_impl(size_t nIdx) override;
+        virtual cv::Mat _getGTPacket_impl(size_t nIdx) override;
+        virtual void parseData() override;
+        virtual bool isPacketLoadReentrant() const override {return true;}
+        std::unique_ptr<RecordingReader> m_pRecording;
+        size_t m_nInputStreamIdx;
+        cv::Mat m_oROI;
+        cv::Size m_oOrigSize,m_oSize;
     };
 
     /// data producer interface specialization default constructor override for cleaner implementations
@@ -467,6 +936,8 @@ namespace lv {
         virtual size_t getProcessedPacketsCountPromise() override final;
         /// gets current processed packets count
         virtual size_t getProcessedPacketsCount() const override final;
+        /// restores the processed packets count of a work batch resumed from a checkpoint
+        virtual void restoreProcessedPacketsCount(size_t nPackets) override final;
     private:
         size_t m_nProcessedPackets;
         std::promise<size_t> m_nProcessedPacketsPromise;
@@ -478,6 +949,8 @@ namespace lv {
         virtual size_t getProcessedPacketsCountPromise() override final;
         /// gets current processed packets count from children batches
         virtual size_t getProcessedPacketsCount() const override final;
+        /// always fails for work groups (checkpoints are restored per work batch)
+        virtual void restoreProcessedPacketsCount(size_t nPackets) override final;
     };
 
     /// general-purpose data packet writer, fully implemented (i.e. can be used stand-alone)
@@ -486,42 +959,87 @@ namespace lv {
         DataWriter(std::function<size_t(const cv::Mat&,size_t)> lDataArchiverCallback);
         /// default destructor (joins the writing thread, if still running)
         ~DataWriter();
-        /// queues a packet, with or without async writing enabled, and returns its position in queue
+        /// queues a copy of a packet, with or without async writing enabled, and returns its position in queue (or SIZE_MAX if dropped)
         size_t queue(const cv::Mat& oPacket, size_t nIdx);
+        /// queues a packet without copying it (ownership is handed over: the caller's header is released), and returns its position in queue (or SIZE_MAX if dropped)
+        size_t queue(cv::Mat&& oPacket, size_t nIdx);
         /// returns the current queue size, in packets
         inline size_t getCurrentQueueCount() const {return m_nQueueCount;}
         /// returns the current queue size, in bytes
         inline size_t getCurrentQueueSize() const {return m_nQueueSize;}
-        /// initializes async writing with a given queue size (in bytes) and a number of threads
-        bool startAsyncWriting(size_t nSuggestedQueueSize, bool bDropPacketsIfFull=false, size_t nWorkers=1);
+        /// initializes async writing with a given max queue size (in bytes, granted by the budget manager) and a number of threads; if ordered, callbacks complete in queueing order even with many workers
+        bool startAsyncWriting(size_t nSuggestedQueueSize, bool bDropPacketsIfFull=false, size_t nWorkers=1, bool bOrderedWrites=false);
         /// joins writing thread and clears all internal buffers
         void stopAsyncWriting();
         /// returns whether the wariting thread has already been started or not
         inline bool isActive() const {return m_bIsActive;}
+        /// sets the tracer that queued & written packets are timestamped into (nullptr = disabled; must not be changed while writing asynchronously)
+        void setLatencyTracer(const PacketLatencyTracerPtr& pTracer) {m_pLatencyTracer = pTracer;}
+        /// returns the memory usage currently attributed to this writer (i.e. queued packet copies & allocations of its writing threads)
+        lv::MemoryTracker::Usage getMemoryUsage() const;
     private:
+        /// queued packet, along with its index
+        struct QueuedPacket {
+            size_t nIdx;
+            cv::Mat oPacket;
+        };
         void entry();
+        size_t enqueue(const cv::Mat& oPacket, size_t nIdx);
+        bool dequeue(cv::Mat& oPacket, size_t& nIdx, size_t& nTicket);
         const std::function<size_t(const cv::Mat&,size_t)> m_lCallback;
         std::vector<std::thread> m_vhWorkers;
         std::mutex m_oSyncMutex;
         std::condition_variable m_oQueueCondVar;
         std::condition_variable m_oClearCondVar;
-        std::map<size_t,cv::Mat> m_mQueue;
+        std::condition_variable m_oOrderCondVar;
+        lv::BoundedMPMCQueue<QueuedPacket> m_oQueue;
+        size_t m_nNextWriteTicket;
         std::atomic_bool m_bIsActive;
         bool m_bAllowPacketDrop;
-        size_t m_nQueueMaxSize;
+        bool m_bOrderedWrites;
+        BufferBudgetManager::LeasePtr m_pBudgetLease;
+        PacketLatencyTracerPtr m_pLatencyTracer;
         std::atomic_size_t m_nQueueSize;
         std::atomic_size_t m_nQueueCount;
+        const lv::MemoryTracker::TagPtr m_pMemoryTag;
         DataWriter& operator=(const DataWriter&) = delete;
         DataWriter(const DataWriter&) = delete;
     };
 
-    /// data archiver interface for work batches for processed packet saving/loading from disk
+    /// fixed-size pool of preallocated packet buffers, for producers that fill packets in place and hand them over to a data writer without copies
+    /// note: a buffer stays in use while any mat header references it (e.g. while it is queued in a writer), and is recycled once all are released
+    struct PacketPool {
+        /// preallocates nSlots packet buffers of the given size and type
+        PacketPool(size_t nSlots, const cv::Size& oSize, int nType);
+        /// releases oPacket, and makes it a header to a free buffer (with stale contents); returns false (and leaves oPacket empty) if all are in use
+        bool acquire(cv::Mat& oPacket);
+        /// returns the number of buffers currently referenced outside the pool
+        size_t getUsedCount() const;
+        /// returns the total number of buffers in the pool
+        inline size_t getSlotCount() const {return m_voSlots.size();}
+    private:
+        std::vector<cv::Mat> m_voSlots;
+        size_t m_nNextSlotIdx;
+        PacketPool& operator=(const PacketPool&) = delete;
+        PacketPool(const PacketPool&) = delete;
+    };
+
+    /// data archiver interface for work batches for processed packet saving/loading from disk (the output name suffix selects the codec: '.lvrle', '.lvbit', '.lvraw', or any opencv image format)
+    /// note: prefixing the output name suffix with '.seq' (e.g. '.seq.lvbit') appends all packets of the batch into a single indexed container file instead
     struct IDataArchiver : public virtual IDataHandler {
     protected:
         /// saves a processed data packet locally based on idx and packet name (if available)
         virtual size_t save(const cv::Mat& oOutput, size_t nIdx) const;
+        /// saves a bit-packed binary mask packet locally; '.lvbit' outputs are written directly from the packed bits when no resizing/transposition is needed
+        virtual size_t save(const lv::PackedBinaryMask& oOutput, size_t nIdx) const;
         /// loads a processed data packet based on idx and packet name (if available)
         virtual cv::Mat load(size_t nIdx) const;
+    private:
+        struct OutputContainer;
+        /// returns the (lazily created) per-batch output container
+        OutputContainer& getOutputContainer() const;
+        mutable std::mutex m_oOutputContainerMutex;
+        mutable std::shared_ptr<OutputContainer> m_pOutputContainer;
     };
 
     /// data consumer interface for work batches for receiving processed packets
@@ -532,6 +1050,17 @@ namespace lv {
         /// push a processed data packet for writing and/or evaluation (also registers it as 'done' for internal purposes)
         virtual void push(const cv::Mat& oOutput, size_t nIdx) {
             lvAssert_(isProcessing(),"data processing must be toggled via 'startProcessing()' before pushing packets");
+            if(PacketLatencyTracer* pTracer = getLatencyTracer())
+                pTracer->mark(nIdx,PacketLatencyTracer::Stage_Push);
+            processPacket();
+            if(getDatasetInfo()->isSavingOutput())
+                save(oOutput,nIdx);
+        }
+        /// push a processed bit-packed binary mask for writing and/or evaluation (also registers it as 'done' for internal purposes)
+        virtual void push(const lv::PackedBinaryMask& oOutput, size_t nIdx) {
+            lvAssert_(isProcessing(),"data processing must be toggled via 'startProcessing()' before pushing packets");
+            if(PacketLatencyTracer* pTracer = getLatencyTracer())
+                pTracer->mark(nIdx,PacketLatencyTracer::Stage_Push);
             processPacket();
             if(getDatasetInfo()->isSavingOutput())
                 save(oOutput,nIdx);
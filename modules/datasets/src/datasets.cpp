@@ -24,6 +24,13 @@ const std::string& lv::DataHandler::getRelativePath() const {return m_sRelativeP
 bool lv::DataHandler::isGrayscale() const {return m_bForcingGrayscale;}
 lv::IDatasetPtr lv::DataHandler::getDatasetInfo() const {return m_pDataset;}
 
+void lv::DataHandler::setLatencyTracer(const PacketLatencyTracerPtr& pTracer) {
+    if(isGroup())
+        for(const auto& pBatch : getBatches(true))
+            pBatch->setLatencyTracer(pTracer);
+    m_pLatencyTracer = pTracer;
+}
+
 lv::DataHandler::DataHandler(const std::string& sBatchName, IDatasetPtr pDataset, const std::string& sRelativePath) :
         m_sBatchName(sBatchName),
         m_sRelativePath(sRelativePath),
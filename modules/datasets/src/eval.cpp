@@ -18,6 +18,13 @@
 #include "litiv/datasets/eval.hpp"
 //#include "litiv/utils/console.hpp" @@@@@ reuse later?
 
+// local define used to identify shard result files
+#define SHARD_RESULTS_MAGIC "LVDSHARD"
+// local define used to specify the current shard result file format version
+#define SHARD_RESULTS_VERSION (1)
+// local define used to identify work batch checkpoint files
+#define CHECKPOINT_MAGIC "LVDCKPT1"
+
 void lv::IDatasetEvaluator_<lv::DatasetEval_None>::writeEvalReport() const {
     if(getBatches(false).empty()) {
         std::cout << "No report to write for dataset '" << getName() << "', skipping." << std::endl;
@@ -47,6 +54,83 @@ void lv::IDatasetEvaluator_<lv::DatasetEval_None>::writeEvalReport() const {
     }
 }
 
+void lv::IDatasetEvaluator_<lv::DatasetEval_None>::evaluateSavedOutputs(size_t nThreads) {
+    // heaviest batches first, so that the last ones to finish still have packet-level parallelism to offer
+    IDataHandlerPtrArray vpBatches = getBatches(false);
+    std::stable_sort(vpBatches.begin(),vpBatches.end(),[](const IDataHandlerPtr& a, const IDataHandlerPtr& b) {
+        return a->getTotPackets()>b->getTotPackets();
+    });
+    lv::ThreadPool oThreadPool(nThreads);
+    oThreadPool.parallel_for(vpBatches.size(),[&](size_t nBatchIdx) {
+        vpBatches[nBatchIdx]->shared_from_this_cast<IDataReporter_<DatasetEval_None>>(true)->evaluateSavedOutputs();
+    });
+}
+
+lv::IDataHandlerPtrArray lv::IDatasetEvaluator_<lv::DatasetEval_None>::getShardBatches(size_t nShardIdx, size_t nShardCount) const {
+    lvAssert_(nShardCount>0 && nShardIdx<nShardCount,"bad shard index/count");
+    // packet counts are used as loads since measured processing times may differ between nodes (assignments must be identical everywhere)
+    IDataHandlerPtrArray vpBatches = getBatches(false);
+    std::stable_sort(vpBatches.begin(),vpBatches.end(),[](const IDataHandlerPtr& a, const IDataHandlerPtr& b) {
+        return (a->getTotPackets()!=b->getTotPackets())?(a->getTotPackets()>b->getTotPackets()):(a->getRelativePath()<b->getRelativePath());
+    });
+    std::vector<size_t> vnShardLoads(nShardCount,0);
+    IDataHandlerPtrArray vpShardBatches;
+    for(const auto& pBatch : vpBatches) {
+        const size_t nTargetShardIdx = size_t(std::min_element(vnShardLoads.begin(),vnShardLoads.end())-vnShardLoads.begin());
+        vnShardLoads[nTargetShardIdx] += pBatch->getTotPackets();
+        if(nTargetShardIdx==nShardIdx)
+            vpShardBatches.push_back(pBatch);
+    }
+    return vpShardBatches;
+}
+
+void lv::IDatasetEvaluator_<lv::DatasetEval_None>::writeShardResults(const std::string& sFilePath, const IDataHandlerPtrArray& vpBatches) const {
+    std::ofstream oShardOutput(sFilePath,std::ios::binary);
+    lvAssert_(oShardOutput.is_open(),"could not open shard results file for writing");
+    oShardOutput.write(SHARD_RESULTS_MAGIC,sizeof(SHARD_RESULTS_MAGIC)-1);
+    lv::writeBinary(oShardOutput,(uint32_t)SHARD_RESULTS_VERSION);
+    lv::writeBinary(oShardOutput,getName());
+    lv::writeBinary(oShardOutput,(uint64_t)vpBatches.size());
+    for(const auto& pBatch : vpBatches) {
+        lvAssert_(pBatch && !pBatch->isGroup() && !pBatch->isProcessing(),"shard results can only be written for work batches that are done processing");
+        lv::writeBinary(oShardOutput,pBatch->getRelativePath());
+        pBatch->shared_from_this_cast<const IDataReporter_<DatasetEval_None>>(true)->writeShardResults(oShardOutput);
+    }
+    lvAssert_(oShardOutput.good(),"failed to write shard results file");
+}
+
+void lv::IDatasetEvaluator_<lv::DatasetEval_None>::mergeShardResults(const std::vector<std::string>& vsFilePaths) {
+    std::map<std::string,IDataHandlerPtr> mpBatches;
+    for(const auto& pBatch : getBatches(false))
+        lvAssert_(mpBatches.emplace(pBatch->getRelativePath(),pBatch).second,"work batch relative paths must be unique to merge shard results");
+    std::set<std::string> oMergedBatchPaths;
+    for(const std::string& sFilePath : vsFilePaths) {
+        std::ifstream oShardInput(sFilePath,std::ios::binary);
+        lvAssert_(oShardInput.is_open(),"could not open shard results file for reading");
+        std::array<char,sizeof(SHARD_RESULTS_MAGIC)-1> acMagic;
+        oShardInput.read(acMagic.data(),acMagic.size());
+        lvAssert_(oShardInput.good() && std::equal(acMagic.begin(),acMagic.end(),SHARD_RESULTS_MAGIC),"file does not contain shard results");
+        uint32_t nVersion;
+        lv::readBinary(oShardInput,nVersion);
+        lvAssert_(nVersion==SHARD_RESULTS_VERSION,"unsupported shard results version");
+        std::string sDatasetName;
+        lv::readBinary(oShardInput,sDatasetName);
+        lvAssert_(sDatasetName==getName(),"shard results were written for another dataset");
+        uint64_t nBatchCount;
+        lv::readBinary(oShardInput,nBatchCount);
+        for(uint64_t nBatchIdx=0; nBatchIdx<nBatchCount; ++nBatchIdx) {
+            std::string sRelativePath;
+            lv::readBinary(oShardInput,sRelativePath);
+            auto pBatchIter = mpBatches.find(sRelativePath);
+            lvAssert_(pBatchIter!=mpBatches.end(),"shard results contain an unknown work batch");
+            pBatchIter->second->shared_from_this_cast<IDataReporter_<DatasetEval_None>>(true)->mergeShardResults(oShardInput);
+            oMergedBatchPaths.insert(sRelativePath);
+        }
+    }
+    if(oMergedBatchPaths.size()<mpBatches.size())
+        std::cout << "Warning: merged shard results only cover " << oMergedBatchPaths.size() << " out of " << mpBatches.size() << " work batches for dataset '" << getName() << "'." << std::endl;
+}
+
 void lv::IDatasetEvaluator_<lv::DatasetEval_BinaryClassifier>::writeEvalReport() const {
     if(getBatches(false).empty() || !isUsingEvaluator()) {
         IDatasetEvaluator_<lv::DatasetEval_None>::writeEvalReport();
@@ -131,6 +215,67 @@ void lv::IDataReporter_<lv::DatasetEval_None>::writeEvalReport() const {
     }
 }
 
+void lv::IDataReporter_<lv::DatasetEval_None>::writeShardResults(std::ostream& oStream) const {
+    lvAssert_(!isGroup(),"shard results can only be written for work batches");
+    lv::writeBinary(oStream,getProcessTime());
+}
+
+void lv::IDataReporter_<lv::DatasetEval_None>::mergeShardResults(std::istream& oStream) {
+    lvAssert_(!isGroup(),"shard results can only be merged into work batches");
+    double dProcessTime;
+    lv::readBinary(oStream,dProcessTime);
+    addProcessTime(dProcessTime);
+}
+
+void lv::IDataReporter_<lv::DatasetEval_None>::writeCheckpoint(const std::string& sAlgoState) const {
+    lvAssert_(!isGroup(),"checkpoints can only be written for work batches");
+    const std::string sFilePath = getCheckpointFilePath();
+    const std::string sTempFilePath = sFilePath+".tmp";
+    lv::CreateDirIfNotExist(getOutputPath());
+    {
+        std::ofstream oCheckpointOutput(sTempFilePath,std::ios::binary);
+        lvAssert_(oCheckpointOutput.is_open(),"could not open checkpoint file for writing");
+        oCheckpointOutput.write(CHECKPOINT_MAGIC,sizeof(CHECKPOINT_MAGIC)-1);
+        lv::writeBinary(oCheckpointOutput,getRelativePath());
+        lv::writeBinary(oCheckpointOutput,(uint64_t)getProcessedPacketsCount());
+        // the processing time written here includes the time elapsed since the last 'startProcessing' call
+        writeShardResults(oCheckpointOutput);
+        lv::writeBinary(oCheckpointOutput,sAlgoState);
+        lvAssert_(oCheckpointOutput.good(),"failed to write checkpoint file");
+    }
+    // the previous checkpoint is only replaced once the new one is complete, so a crash while writing never loses it
+    lvAssert_(std::rename(sTempFilePath.c_str(),sFilePath.c_str())==0,"failed to replace checkpoint file");
+}
+
+size_t lv::IDataReporter_<lv::DatasetEval_None>::readCheckpoint(std::string& sAlgoState) {
+    lvAssert_(!isGroup() && !isProcessing(),"checkpoints can only be restored for work batches that are not processing");
+    sAlgoState.clear();
+    std::ifstream oCheckpointInput(getCheckpointFilePath(),std::ios::binary);
+    if(!oCheckpointInput.is_open())
+        return 0;
+    std::array<char,sizeof(CHECKPOINT_MAGIC)-1> acMagic;
+    oCheckpointInput.read(acMagic.data(),acMagic.size());
+    lvAssert_(oCheckpointInput.good() && std::equal(acMagic.begin(),acMagic.end(),CHECKPOINT_MAGIC),"file does not contain a work batch checkpoint");
+    std::string sRelativePath;
+    lv::readBinary(oCheckpointInput,sRelativePath);
+    lvAssert_(sRelativePath==getRelativePath(),"checkpoint was written for another work batch");
+    uint64_t nProcessedPackets;
+    lv::readBinary(oCheckpointInput,nProcessedPackets);
+    lvAssert_(nProcessedPackets<=getTotPackets(),"bad processed packets count in checkpoint");
+    mergeShardResults(oCheckpointInput);
+    lv::readBinary(oCheckpointInput,sAlgoState);
+    restoreProcessedPacketsCount((size_t)nProcessedPackets);
+    return (size_t)nProcessedPackets;
+}
+
+std::string lv::IDataReporter_<lv::DatasetEval_None>::getCheckpointFilePath() const {
+    return lv::AddDirSlashIfMissing(getOutputPath())+"checkpoint.bin";
+}
+
+void lv::IDataReporter_<lv::DatasetEval_None>::evaluateSavedOutputs() {
+    lvError_("work batch '%s' has no evaluator able to process saved outputs",getName().c_str());
+}
+
 std::string lv::IDataReporter_<lv::DatasetEval_None>::writeInlineEvalReport(size_t nIndentSize) const {
     if(!getTotPackets())
         return std::string();
@@ -218,6 +363,216 @@ std::string lv::IDataReporter_<lv::DatasetEval_BinaryClassifier>::writeInlineEva
     return ssStr.str();
 }
 
+void lv::IDataReporter_<lv::DatasetEval_BinaryClassifier>::setMetricsSink(const MetricsStreamSinkPtr& pMetricsSink) {
+    if(isGroup()) {
+        for(const auto& pBatch : getBatches(true))
+            pBatch->shared_from_this_cast<IDataReporter_<DatasetEval_BinaryClassifier>>(true)->setMetricsSink(pMetricsSink);
+        return;
+    }
+    m_pMetricsSink = pMetricsSink;
+    m_nMetricsSinkNodeIdx = pMetricsSink?pMetricsSink->registerBatch(shared_from_this()):SIZE_MAX;
+}
+
+void lv::IDataReporter_<lv::DatasetEval_BinaryClassifier>::writeShardResults(std::ostream& oStream) const {
+    IDataReporter_<DatasetEval_None>::writeShardResults(oStream);
+    const auto pMetricsBase = std::dynamic_pointer_cast<const BinClassifMetricsAccumulator>(getMetricsBase());
+    lvAssert_(pMetricsBase,"shard results only support basic binary classification metrics counters");
+    lv::writeBinary(oStream,MetricsStreamSink::getCounters(*pMetricsBase));
+}
+
+void lv::IDataReporter_<lv::DatasetEval_BinaryClassifier>::mergeShardResults(std::istream& oStream) {
+    IDataReporter_<DatasetEval_None>::mergeShardResults(oStream);
+    MetricsStreamSink::Counters anCounters;
+    lv::readBinary(oStream,anCounters);
+    BinClassifMetricsAccumulatorPtr pMetricsBase = BinClassifMetricsAccumulator::create();
+    pMetricsBase->nTP = anCounters[BinClassifMetricsAccumulator::Counter_TP];
+    pMetricsBase->nTN = anCounters[BinClassifMetricsAccumulator::Counter_TN];
+    pMetricsBase->nFP = anCounters[BinClassifMetricsAccumulator::Counter_FP];
+    pMetricsBase->nFN = anCounters[BinClassifMetricsAccumulator::Counter_FN];
+    pMetricsBase->nSE = anCounters[BinClassifMetricsAccumulator::Counter_SE];
+    pMetricsBase->nDC = anCounters[BinClassifMetricsAccumulator::Counter_DC];
+    mergeMetricsBase(pMetricsBase);
+}
+
+void lv::IDataReporter_<lv::DatasetEval_BinaryClassifier>::mergeMetricsBase(const IMetricsAccumulatorConstPtr& /*pMetricsBase*/) {
+    lvError("group data reporter specialization attempted to merge metrics directly");
+}
+
+void lv::IDataReporter_<lv::DatasetEval_BinaryClassifier>::pushMetricsDelta(const MetricsStreamSink::Counters& anPrevCounters, const BinClassifMetricsAccumulator& oCurrMetrics) {
+    if(!m_pMetricsSink)
+        return;
+    MetricsStreamSink::Counters anDelta = MetricsStreamSink::getCounters(oCurrMetrics);
+    for(size_t nCounterIdx=0; nCounterIdx<anDelta.size(); ++nCounterIdx) {
+        lvDbgAssert(anDelta[nCounterIdx]>=anPrevCounters[nCounterIdx]);
+        anDelta[nCounterIdx] -= anPrevCounters[nCounterIdx];
+    }
+    m_pMetricsSink->push(m_nMetricsSinkNodeIdx,anDelta);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+lv::MetricsStreamSink::MetricsStreamSink(const std::string& sExportFilePath, ExportFormat eFormat, double dExportPeriod_sec) :
+        m_sExportFilePath(sExportFilePath),m_eFormat(eFormat),m_dExportPeriod_sec(dExportPeriod_sec) {
+    lvAssert_(!m_sExportFilePath.empty(),"metrics sink export file path must be non-empty");
+    lvAssert_(m_eFormat==ExportFormat_JSONLines || m_eFormat==ExportFormat_Prometheus,"unknown metrics sink export format");
+    lvAssert_(m_dExportPeriod_sec>=0.0,"metrics sink export period must be non-negative");
+    if(m_eFormat==ExportFormat_JSONLines) {
+        std::ofstream oExportFile(m_sExportFilePath,std::ios::out|std::ios::trunc);
+        lvAssert__(oExportFile.is_open(),"could not create metrics sink export file at '%s'",m_sExportFilePath.c_str());
+    }
+}
+
+lv::MetricsStreamSink::~MetricsStreamSink() {
+    std::mutex_lock_guard oLock(m_oMutex);
+    if(!m_voNodes.empty())
+        exportTotals();
+}
+
+size_t lv::MetricsStreamSink::registerBatch(const IDataHandlerPtr& pBatch) {
+    lvAssert_(pBatch && !pBatch->isGroup(),"metrics sink can only register non-group work batches");
+    // node names follow the batch hierarchy, i.e. 'dataset/category/batch' (relative paths always use forward slashes)
+    std::vector<std::string> vsNodeNames(1,pBatch->getDatasetInfo()->getName());
+    const std::string& sRelativePath = pBatch->getRelativePath();
+    size_t nTokenBegin = 0;
+    while(nTokenBegin<sRelativePath.size()) {
+        const size_t nTokenEnd = std::min(sRelativePath.find_first_of("/\\",nTokenBegin),sRelativePath.size());
+        if(nTokenEnd>nTokenBegin)
+            vsNodeNames.push_back(vsNodeNames.back()+"/"+sRelativePath.substr(nTokenBegin,nTokenEnd-nTokenBegin));
+        nTokenBegin = nTokenEnd+1;
+    }
+    std::mutex_lock_guard oLock(m_oMutex);
+    size_t nParentIdx = SIZE_MAX;
+    for(const std::string& sNodeName : vsNodeNames) {
+        auto pNodeIter = m_mNodeIdxs.find(sNodeName);
+        if(pNodeIter==m_mNodeIdxs.end()) {
+            pNodeIter = m_mNodeIdxs.insert(std::make_pair(sNodeName,m_voNodes.size())).first;
+            m_voNodes.push_back(Node{sNodeName,nParentIdx,Counters(),0,std::weak_ptr<const IDataHandler>()});
+            m_voNodes.back().anCounters.fill(0);
+        }
+        nParentIdx = pNodeIter->second;
+    }
+    m_voNodes[nParentIdx].pBatch = pBatch;
+    return nParentIdx;
+}
+
+void lv::MetricsStreamSink::push(size_t nNodeIdx, const Counters& anDelta, size_t nPackets) {
+    std::mutex_lock_guard oLock(m_oMutex);
+    lvDbgAssert(nNodeIdx<m_voNodes.size());
+    while(nNodeIdx!=SIZE_MAX) {
+        Node& oNode = m_voNodes[nNodeIdx];
+        for(size_t nCounterIdx=0; nCounterIdx<anDelta.size(); ++nCounterIdx)
+            oNode.anCounters[nCounterIdx] += anDelta[nCounterIdx];
+        oNode.nPackets += nPackets;
+        nNodeIdx = oNode.nParentIdx;
+    }
+    if(m_oExportTimer.tock(false)>=m_dExportPeriod_sec)
+        exportTotals();
+}
+
+void lv::MetricsStreamSink::flush() {
+    std::mutex_lock_guard oLock(m_oMutex);
+    exportTotals();
+}
+
+lv::MetricsStreamSink::Counters lv::MetricsStreamSink::getCounters(const BinClassifMetricsAccumulator& m) {
+    Counters anCounters;
+    anCounters[BinClassifMetricsAccumulator::Counter_TP] = m.nTP;
+    anCounters[BinClassifMetricsAccumulator::Counter_TN] = m.nTN;
+    anCounters[BinClassifMetricsAccumulator::Counter_FP] = m.nFP;
+    anCounters[BinClassifMetricsAccumulator::Counter_FN] = m.nFN;
+    anCounters[BinClassifMetricsAccumulator::Counter_SE] = m.nSE;
+    anCounters[BinClassifMetricsAccumulator::Counter_DC] = m.nDC;
+    return anCounters;
+}
+
+void lv::MetricsStreamSink::exportTotals() {
+    m_oExportTimer.tick();
+    const double dElapsedTime_sec = m_oElapsedTimer.tock(false);
+    // batch processing times are only final once their processing stops; they are summed bottom-up for parent nodes
+    std::vector<double> vdProcessTimes(m_voNodes.size(),0.0);
+    for(size_t nNodeIdx=0; nNodeIdx<m_voNodes.size(); ++nNodeIdx) {
+        const auto pBatch = m_voNodes[nNodeIdx].pBatch.lock();
+        if(!pBatch)
+            continue;
+        const double dProcessTime_sec = pBatch->getProcessTime();
+        for(size_t nCurrIdx=nNodeIdx; nCurrIdx!=SIZE_MAX; nCurrIdx=m_voNodes[nCurrIdx].nParentIdx)
+            vdProcessTimes[nCurrIdx] += dProcessTime_sec;
+    }
+    static const std::array<const char*,BinClassifMetricsAccumulator::nCountersCount> s_asCounterNames = {"tp","tn","fp","fn","se","dc"};
+    const auto lEscape = [](const std::string& sName) {
+        std::string sEscapedName;
+        for(char c : sName) {
+            if(c=='"' || c=='\\')
+                sEscapedName.push_back('\\');
+            sEscapedName.push_back(c);
+        }
+        return sEscapedName;
+    };
+    std::stringstream ssStr;
+    ssStr << std::setprecision(6);
+    for(size_t nNodeIdx=0; nNodeIdx<m_voNodes.size(); ++nNodeIdx) {
+        const Node& oNode = m_voNodes[nNodeIdx];
+        const uint64_t nTP = oNode.anCounters[BinClassifMetricsAccumulator::Counter_TP];
+        const double dRecall = BinClassifMetricsCalculator::CalcRecall(nTP,nTP+oNode.anCounters[BinClassifMetricsAccumulator::Counter_FN]);
+        const double dPrecision = BinClassifMetricsCalculator::CalcPrecision(nTP,nTP+oNode.anCounters[BinClassifMetricsAccumulator::Counter_FP]);
+        const double dFMeasure = BinClassifMetricsCalculator::CalcFMeasure(dRecall,dPrecision);
+        const double dPacketRate = dElapsedTime_sec>0.0?oNode.nPackets/dElapsedTime_sec:0.0;
+        const std::string sEscapedName = lEscape(oNode.sName);
+        if(m_eFormat==ExportFormat_JSONLines) {
+            ssStr << "{\"elapsed_s\":" << dElapsedTime_sec << ",\"node\":\"" << sEscapedName << "\",\"packets\":" << oNode.nPackets <<
+                     ",\"packets_per_s\":" << dPacketRate << ",\"process_time_s\":" << vdProcessTimes[nNodeIdx];
+            for(size_t nCounterIdx=0; nCounterIdx<oNode.anCounters.size(); ++nCounterIdx)
+                ssStr << ",\"" << s_asCounterNames[nCounterIdx] << "\":" << oNode.anCounters[nCounterIdx];
+            ssStr << ",\"rcl\":" << dRecall << ",\"prc\":" << dPrecision << ",\"fm\":" << dFMeasure << "}\n";
+        }
+        else {
+            const std::string sLabel = "{node=\""+sEscapedName+"\"";
+            ssStr << "litiv_eval_packets_total" << sLabel << "} " << oNode.nPackets << "\n";
+            ssStr << "litiv_eval_packets_per_second" << sLabel << "} " << dPacketRate << "\n";
+            ssStr << "litiv_eval_process_time_seconds" << sLabel << "} " << vdProcessTimes[nNodeIdx] << "\n";
+            for(size_t nCounterIdx=0; nCounterIdx<oNode.anCounters.size(); ++nCounterIdx)
+                ssStr << "litiv_eval_counter_total" << sLabel << ",counter=\"" << s_asCounterNames[nCounterIdx] << "\"} " << oNode.anCounters[nCounterIdx] << "\n";
+            ssStr << "litiv_eval_recall" << sLabel << "} " << dRecall << "\n";
+            ssStr << "litiv_eval_precision" << sLabel << "} " << dPrecision << "\n";
+            ssStr << "litiv_eval_fmeasure" << sLabel << "} " << dFMeasure << "\n";
+        }
+    }
+    // memory usage is exported per tracker tag (algorithm instances, precachers, writers, ...) alongside the eval totals
+    for(const lv::MemoryTracker::Usage& oUsage : lv::MemoryTracker::getUsage()) {
+        const std::string sEscapedName = lEscape(oUsage.sName);
+        if(m_eFormat==ExportFormat_JSONLines)
+            ssStr << "{\"elapsed_s\":" << dElapsedTime_sec << ",\"mem_tag\":\"" << sEscapedName << "\",\"bytes\":" << oUsage.nCurrBytes <<
+                     ",\"peak_bytes\":" << oUsage.nPeakBytes << ",\"allocs\":" << oUsage.nAllocCount << "}\n";
+        else {
+            const std::string sLabel = "{tag=\""+sEscapedName+"\"} ";
+            ssStr << "litiv_mem_bytes" << sLabel << oUsage.nCurrBytes << "\n";
+            ssStr << "litiv_mem_peak_bytes" << sLabel << oUsage.nPeakBytes << "\n";
+            ssStr << "litiv_mem_allocs_total" << sLabel << oUsage.nAllocCount << "\n";
+        }
+    }
+    if(m_eFormat==ExportFormat_JSONLines) {
+        std::ofstream oExportFile(m_sExportFilePath,std::ios::out|std::ios::app);
+        if(oExportFile.is_open())
+            oExportFile << ssStr.str();
+    }
+    else {
+        // scrapers must never see a partially written file, so the new totals are renamed over the old ones
+        const std::string sTempFilePath = m_sExportFilePath+".tmp";
+        {
+            std::ofstream oExportFile(sTempFilePath,std::ios::out|std::ios::trunc);
+            if(!oExportFile.is_open())
+                return;
+            oExportFile << ssStr.str();
+        }
+        if(std::rename(sTempFilePath.c_str(),m_sExportFilePath.c_str())!=0) { // some platforms cannot rename over existing files
+            std::remove(m_sExportFilePath.c_str());
+            std::rename(sTempFilePath.c_str(),m_sExportFilePath.c_str());
+        }
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
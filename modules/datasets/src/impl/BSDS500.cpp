@@ -58,6 +58,10 @@
 #endif //__clang__
 #endif //USE_BSDS500_BENCHMARK
 
+#define GT_CACHE_FILE_SUFFIX  ".lvbsdsgt" // name suffix of on-disk gt-side matching structure files (one per image)
+#define GT_CACHE_FILE_MAGIC   "LVBSDSGT"
+#define GT_CACHE_FILE_VERSION 1 // must be bumped when the BSDS500GTData layout below changes
+
 namespace lv {
 
     struct BSDS500Counters { // edge detection counters for a single image
@@ -84,6 +88,466 @@ namespace lv {
         }
     };
 
+    /// neighborhood offset (and its length) used when looking for edge matches within the max distance
+    struct BSDS500NeighbOffset {
+        int nRowOffset;
+        int nColOffset;
+        double dDist;
+    };
+
+    /// gt-side matching structures of a single image; these only depend on the gt masks, so they can be reused for all threshold bins & parameter sets
+    struct BSDS500GTData {
+        /// builds the gt-side structures for a stack of gt masks of the given size (concatenated vertically, as returned by the data loader)
+        static std::shared_ptr<const BSDS500GTData> create(const cv::Mat& oGT, const cv::Size& oSize) {
+            lvAssert(oGT.type()==CV_8UC1 && oGT.isContinuous() && oSize.area()>0);
+            lvAssert(oGT.cols==oSize.width && (oGT.rows%oSize.height)==0 && (oGT.rows/oSize.height)>=1);
+            auto pData = std::make_shared<BSDS500GTData>();
+            pData->initNeighbOffsets(oSize);
+            pData->nGTHash = getHash(oGT);
+            const size_t nGTMaskCount = size_t(oGT.rows/oSize.height);
+            pData->vvnGTPxIdxs.resize(nGTMaskCount);
+            pData->oGTToleranceUnion.create(oSize,CV_8UC1);
+            pData->oGTToleranceUnion = cv::Scalar_<uchar>(0);
+            pData->nGTPosCount = 0;
+            const float fMaxDist = float(pData->dMaxDist);
+            for(size_t nGTMaskIdx=0; nGTMaskIdx<nGTMaskCount; ++nGTMaskIdx) {
+                const cv::Mat oCurrGTSegmMask = oGT(cv::Rect(0,int(oSize.height*nGTMaskIdx),oSize.width,oSize.height));
+                std::vector<int>& vnGTPxIdxs = pData->vvnGTPxIdxs[nGTMaskIdx];
+                for(int nPxIdx=0; nPxIdx<int(oSize.area()); ++nPxIdx)
+                    if(oCurrGTSegmMask.data[nPxIdx]) // sub-mats of a continuous stack are continuous as well
+                        vnGTPxIdxs.push_back(nPxIdx);
+                pData->nGTPosCount += uint64_t(vnGTPxIdxs.size()); // sumR += ...
+                if(!vnGTPxIdxs.empty()) {
+                    cv::Mat oGTDist;
+                    cv::distanceTransform(oCurrGTSegmMask==0,oGTDist,cv::DIST_L2,cv::DIST_MASK_PRECISE);
+                    pData->oGTToleranceUnion |= (oGTDist<=fMaxDist);
+                }
+            }
+            return pData;
+        }
+        /// returns whether these structures were built for the given gt masks
+        bool isMatching(const cv::Mat& oGT, const cv::Size& oSize) const {
+            return oSize==this->oSize && oGT.cols==oSize.width && size_t(oGT.rows)==oSize.height*vvnGTPxIdxs.size() && getHash(oGT)==nGTHash;
+        }
+        /// returns whether the given gt pixel can be offset by any neighborhood offset without bound checks
+        inline bool isInterior(int nPxIdx) const {
+            const int i = nPxIdx/oSize.width, j = nPxIdx%oSize.width;
+            return i>=nMaxDist && i<oSize.height-nMaxDist && j>=nMaxDist && j<oSize.width-nMaxDist;
+        }
+        /// writes the gt-side structures to a binary file at the given location
+        void write(const std::string& sFilePath) const {
+            std::ofstream oOutput(sFilePath,std::ios::binary);
+            lvAssert__(oOutput.is_open(),"could not open bsds500 gt cache file at '%s' for writing",sFilePath.c_str());
+            oOutput.write(GT_CACHE_FILE_MAGIC,sizeof(GT_CACHE_FILE_MAGIC)-1);
+            lv::writeBinary(oOutput,(uint32_t)GT_CACHE_FILE_VERSION);
+            lv::writeBinary(oOutput,(int32_t)oSize.width);
+            lv::writeBinary(oOutput,(int32_t)oSize.height);
+            lv::writeBinary(oOutput,nGTHash);
+            lv::writeBinary(oOutput,(uint64_t)vvnGTPxIdxs.size());
+            for(const std::vector<int>& vnGTPxIdxs : vvnGTPxIdxs)
+                lv::writeBinary(oOutput,vnGTPxIdxs);
+            lvDbgAssert(oGTToleranceUnion.isContinuous());
+            oOutput.write((const char*)oGTToleranceUnion.data,oGTToleranceUnion.total());
+            lvAssert__(oOutput.good(),"failed to write bsds500 gt cache file at '%s'",sFilePath.c_str());
+        }
+        /// reads gt-side structures previously written via 'write', returning nullptr if the file is missing, invalid, or outdated
+        static std::shared_ptr<const BSDS500GTData> read(const std::string& sFilePath) {
+            std::ifstream oInput(sFilePath,std::ios::binary);
+            if(!oInput.is_open())
+                return nullptr;
+            std::array<char,sizeof(GT_CACHE_FILE_MAGIC)-1> acMagic;
+            oInput.read(acMagic.data(),acMagic.size());
+            uint32_t nVersion = 0;
+            if(oInput.good())
+                lv::readBinary(oInput,nVersion);
+            if(!oInput.good() || !std::equal(acMagic.begin(),acMagic.end(),GT_CACHE_FILE_MAGIC) || nVersion!=GT_CACHE_FILE_VERSION)
+                return nullptr;
+            int32_t nWidth,nHeight;
+            uint64_t nGTMaskCount;
+            auto pData = std::make_shared<BSDS500GTData>();
+            lv::readBinary(oInput,nWidth);
+            lv::readBinary(oInput,nHeight);
+            lv::readBinary(oInput,pData->nGTHash);
+            lv::readBinary(oInput,nGTMaskCount);
+            if(!oInput.good() || nWidth<=0 || nHeight<=0 || nGTMaskCount==0 || nGTMaskCount>size_t(UCHAR_MAX))
+                return nullptr;
+            pData->initNeighbOffsets(cv::Size(nWidth,nHeight));
+            pData->vvnGTPxIdxs.resize(size_t(nGTMaskCount));
+            pData->nGTPosCount = 0;
+            for(std::vector<int>& vnGTPxIdxs : pData->vvnGTPxIdxs) {
+                lv::readBinary(oInput,vnGTPxIdxs);
+                pData->nGTPosCount += uint64_t(vnGTPxIdxs.size());
+            }
+            pData->oGTToleranceUnion.create(pData->oSize,CV_8UC1);
+            oInput.read((char*)pData->oGTToleranceUnion.data,pData->oGTToleranceUnion.total());
+            if(!oInput.good())
+                return nullptr;
+            return pData;
+        }
+        cv::Size oSize; // size of a single gt mask
+        double dMaxDist; // max matching distance, derived from the image diagonal
+        int nMaxDist; // max matching distance, rounded up (i.e. max neighborhood offset)
+        uint64_t nGTHash; // hash of the gt mask stack used to validate cached structures
+        std::vector<BSDS500NeighbOffset> voNeighbOffsets; // neighborhood offsets within the max matching distance, in row-major scan order
+        std::vector<int> vnNeighbLinearOffsets; // linear pixel index offsets matching voNeighbOffsets (for interior pixels)
+        std::vector<std::vector<int>> vvnGTPxIdxs; // per gt mask, linear indices of all gt edge pixels (in row-major scan order)
+        uint64_t nGTPosCount; // total gt edge pixel count over all masks
+        cv::Mat oGTToleranceUnion; // union of gt edge pixel neighborhoods within the max distance (for approx eval mode)
+    private:
+        void initNeighbOffsets(const cv::Size& oNewSize) {
+            oSize = oNewSize;
+            dMaxDist = DATASETS_BSDS500_EVAL_IMAGE_DIAG_RATIO_DIST*sqrt(double(oSize.width*oSize.width+oSize.height*oSize.height));
+            const double dMaxDistSqr = dMaxDist*dMaxDist;
+            nMaxDist = (int)ceil(dMaxDist);
+            lvAssert(dMaxDist>0 && nMaxDist>0);
+            voNeighbOffsets.clear();
+            vnNeighbLinearOffsets.clear();
+            for(int u=-nMaxDist; u<=nMaxDist; ++u) {
+                for(int v=-nMaxDist; v<=nMaxDist; ++v) {
+                    if(double(u*u+v*v)<=dMaxDistSqr) {
+                        voNeighbOffsets.push_back({u,v,sqrt(double(u*u+v*v))});
+                        vnNeighbLinearOffsets.push_back(u*oSize.width+v);
+                    }
+                }
+            }
+        }
+        static uint64_t getHash(const cv::Mat& oGT) { // 64-bit FNV-1a
+            lvDbgAssert(oGT.isContinuous());
+            uint64_t nHash = 14695981039346656037ull;
+            const size_t nByteCount = oGT.total()*oGT.elemSize();
+            for(size_t nByteIdx=0; nByteIdx<nByteCount; ++nByteIdx)
+                nHash = (nHash^oGT.data[nByteIdx])*1099511628211ull;
+            return nHash;
+        }
+    };
+    using BSDS500GTDataConstPtr = std::shared_ptr<const BSDS500GTData>;
+
+    /// returns the gt-side structures of a packet from the given cache, rebuilding them (or reloading them from disk, if a cache dir path is given) if the gt itself changed
+    static const BSDS500GTData& getCachedGTData(std::map<size_t,BSDS500GTDataConstPtr>& mpGTDataCache, const std::string& sCacheFilePath, size_t nIdx, const cv::Mat& oGT, const cv::Size& oSize) {
+        BSDS500GTDataConstPtr& pGTData = mpGTDataCache[nIdx];
+        if(!pGTData || !pGTData->isMatching(oGT,oSize)) {
+            pGTData = sCacheFilePath.empty()?nullptr:BSDS500GTData::read(sCacheFilePath);
+            if(!pGTData || !pGTData->isMatching(oGT,oSize)) {
+                pGTData = BSDS500GTData::create(oGT,oSize);
+                if(!sCacheFilePath.empty())
+                    pGTData->write(sCacheFilePath);
+            }
+        }
+        return *pGTData;
+    }
+
+#if USE_BSDS500_BENCHMARK
+
+    /// matches a thinned segmentation edge mask with a gt edge mask via CSA, adding matched segm pixel linear indices to the given array, and returning the match count
+    static uint64_t matchEdgeMaps(const cv::Mat& oCurrSegmMask, const BSDS500GTData& oGTData, size_t nGTMaskIdx, std::vector<int>& vnMatchedSegmPxIdxs) {
+
+        ///////////////////////////////////////////////////////
+        // code below is adapted from match.cc::matchEdgeMaps()
+        ///////////////////////////////////////////////////////
+
+        struct Edge {
+            int nNodeIdx_SEGM;
+            int nNodeIdx_GT;
+            double dEdgeDist;
+        };
+        // scratch buffers are kept per worker thread, and reused across threshold bins & gt masks
+        struct MatchingArena {
+            cv::Mat oMatchable_SEGM,oMatchable_GT;
+            cv::Mat oPxToNodeLUT_SEGM,oPxToNodeLUT_GT;
+            std::vector<cv::Point2i> voNodeToPxLUT_SEGM,voNodeToPxLUT_GT;
+            std::vector<Edge> voEdges;
+            std::vector<int> vnOutliers,vnGraph,vnOutGraph;
+        };
+        thread_local MatchingArena oArena;
+
+        const std::vector<BSDS500NeighbOffset>& voNeighbOffsets = oGTData.voNeighbOffsets;
+        const std::vector<int>& vnNeighbLinearOffsets = oGTData.vnNeighbLinearOffsets;
+        const std::vector<int>& vnGTPxIdxs = oGTData.vvnGTPxIdxs[nGTMaskIdx];
+        const double dOutlierCost = 100*oGTData.dMaxDist;
+        lvAssert(dOutlierCost>1);
+        uint64_t nIndivTP = 0;
+
+        static constexpr int multiplier = 100;
+        static constexpr int degree = 6;
+        static_assert(degree>0,"csa config bad; degree of outlier connections should be > 0");
+        static_assert(multiplier>0,"csa config bad; floating-point weights to integers should be > 0");
+
+        const int nRows = oCurrSegmMask.rows, nCols = oCurrSegmMask.cols;
+        cv::Mat& oMatchable_SEGM = oArena.oMatchable_SEGM;
+        cv::Mat& oMatchable_GT = oArena.oMatchable_GT;
+        oMatchable_SEGM.create(oCurrSegmMask.size(),CV_8UC1);
+        oMatchable_GT.create(oCurrSegmMask.size(),CV_8UC1);
+        oMatchable_SEGM = cv::Scalar_<uchar>(0);
+        oMatchable_GT = cv::Scalar_<uchar>(0);
+        // Figure out which nodes are matchable, i.e. within maxDist
+        // of another node. (gt nodes come from the cached gt pixel list,
+        // and interior ones skip bound checks)
+        lvDbgAssert(oCurrSegmMask.isContinuous() && oCurrSegmMask.size()==oGTData.oSize);
+        for(int nGTPxIdx : vnGTPxIdxs) {
+            const int i = nGTPxIdx/nCols, j = nGTPxIdx%nCols;
+            if(oGTData.isInterior(nGTPxIdx)) {
+                for(int nLinearOffset : vnNeighbLinearOffsets) {
+                    if(oCurrSegmMask.data[nGTPxIdx+nLinearOffset]) {
+                        oMatchable_SEGM.data[nGTPxIdx+nLinearOffset] = UCHAR_MAX;
+                        oMatchable_GT.data[nGTPxIdx] = UCHAR_MAX;
+                    }
+                }
+                continue;
+            }
+            for(const BSDS500NeighbOffset& oOffset : voNeighbOffsets) {
+                const int u = oOffset.nRowOffset, v = oOffset.nColOffset;
+                if(i+u<0 || i+u>=nRows || j+v<0 || j+v>=nCols) continue;
+                if(oCurrSegmMask.at<uchar>(i+u,j+v)) {
+                    oMatchable_SEGM.at<uchar>(i+u,j+v) = UCHAR_MAX;
+                    oMatchable_GT.at<uchar>(i,j) = UCHAR_MAX;
+                }
+            }
+        }
+
+        int nNodeCount_SEGM=0, nNodeCount_GT=0;
+        std::vector<cv::Point2i>& voNodeToPxLUT_SEGM = oArena.voNodeToPxLUT_SEGM;
+        std::vector<cv::Point2i>& voNodeToPxLUT_GT = oArena.voNodeToPxLUT_GT;
+        voNodeToPxLUT_SEGM.clear();
+        voNodeToPxLUT_GT.clear();
+        cv::Mat& oPxToNodeLUT_SEGM = oArena.oPxToNodeLUT_SEGM;
+        cv::Mat& oPxToNodeLUT_GT = oArena.oPxToNodeLUT_GT;
+        oPxToNodeLUT_SEGM.create(oCurrSegmMask.size(),CV_32SC1);
+        oPxToNodeLUT_GT.create(oCurrSegmMask.size(),CV_32SC1);
+        oPxToNodeLUT_SEGM = cv::Scalar_<int>(-1);
+        oPxToNodeLUT_GT = cv::Scalar_<int>(-1);
+        // Count the number of nodes on each side of the match.
+        // Construct nodeID->pixel and pixel->nodeID maps.
+        // Node IDs range from [0,nNodeCount_SEGM) and [0,nNodeCount_GT).
+        for(int i=0; i<nRows; ++i) {
+            for(int j=0; j<nCols; ++j) {
+                cv::Point2i px(j,i);
+                if(oMatchable_SEGM.at<uchar>(px)) {
+                    oPxToNodeLUT_SEGM.at<int>(px) = nNodeCount_SEGM;
+                    voNodeToPxLUT_SEGM.push_back(px);
+                    ++nNodeCount_SEGM;
+                }
+                if(oMatchable_GT.at<uchar>(px)) {
+                    oPxToNodeLUT_GT.at<int>(px) = nNodeCount_GT;
+                    voNodeToPxLUT_GT.push_back(px);
+                    ++nNodeCount_GT;
+                }
+            }
+        }
+
+        std::vector<Edge>& voEdges = oArena.voEdges;
+        voEdges.clear();
+        // Construct the list of edges between pixels within maxDist.
+        // (matchable gt nodes are a subset of the cached gt pixel list,
+        // which keeps the original scan order)
+        for(int nGTPxIdx : vnGTPxIdxs) {
+            if(!oMatchable_GT.data[nGTPxIdx]) continue;
+            const int i = nGTPxIdx/nCols, j = nGTPxIdx%nCols;
+            const bool bInterior = oGTData.isInterior(nGTPxIdx);
+            for(size_t nOffsetIdx=0; nOffsetIdx<voNeighbOffsets.size(); ++nOffsetIdx) {
+                const int u = voNeighbOffsets[nOffsetIdx].nRowOffset, v = voNeighbOffsets[nOffsetIdx].nColOffset;
+                if(!bInterior && (i+u<0 || i+u>=nRows || j+v<0 || j+v>=nCols)) continue;
+                const int nSegmPxIdx = nGTPxIdx+vnNeighbLinearOffsets[nOffsetIdx];
+                if(!oMatchable_SEGM.data[nSegmPxIdx]) continue;
+                Edge e;
+                e.nNodeIdx_SEGM = ((const int*)oPxToNodeLUT_SEGM.data)[nSegmPxIdx];
+                e.nNodeIdx_GT = ((const int*)oPxToNodeLUT_GT.data)[nGTPxIdx];
+                e.dEdgeDist = voNeighbOffsets[nOffsetIdx].dDist;
+                lvDbgAssert(e.nNodeIdx_SEGM>=0 && e.nNodeIdx_SEGM<nNodeCount_SEGM);
+                lvDbgAssert(e.nNodeIdx_GT>=0 && e.nNodeIdx_GT<nNodeCount_GT);
+                voEdges.push_back(e);
+            }
+        }
+
+        // The cardinality of the match is n.
+        const int n = nNodeCount_SEGM+nNodeCount_GT;
+        const int nmin = std::min(nNodeCount_SEGM,nNodeCount_GT);
+        const int nmax = std::max(nNodeCount_SEGM,nNodeCount_GT);
+
+        // Compute the degree of various outlier connections.
+        const int degree_SEGM = std::max(0,std::min(degree,nNodeCount_SEGM-1)); // from map1
+        const int degree_GT = std::max(0,std::min(degree,nNodeCount_GT-1)); // from map2
+        const int degree_mix = std::min(degree,std::min(nNodeCount_SEGM,nNodeCount_GT)); // between outliers
+        const int dmax = std::max(degree_SEGM,std::max(degree_GT,degree_mix));
+
+        lvDbgAssert(nNodeCount_SEGM==0 || (degree_SEGM>=0 && degree_SEGM<nNodeCount_SEGM));
+        lvDbgAssert(nNodeCount_GT==0 || (degree_GT>=0 && degree_GT<nNodeCount_GT));
+        lvDbgAssert(degree_mix>=0 && degree_mix<=nmin);
+
+        // Count the number of edges.
+        int m = 0;
+        m += (int)voEdges.size();         // real connections
+        m += degree_SEGM*nNodeCount_SEGM; // outlier connections
+        m += degree_GT*nNodeCount_GT;     // outlier connections
+        m += degree_mix*nmax;             // outlier-outlier connections
+        m += n;                           // high-cost perfect match overlay
+                                          // If the graph is empty, then there's nothing to do.
+        if(m>0) {
+            // Weight of outlier connections.
+            const int nOutlierWeight = (int)ceil(dOutlierCost*multiplier);
+            // Scratch array for outlier edges.
+            std::vector<int>& vnOutliers = oArena.vnOutliers;
+            vnOutliers.resize(dmax);
+            // Construct the input graph for the assignment problem (m rows of 3 ints).
+            std::vector<int>& vnGraph = oArena.vnGraph;
+            vnGraph.resize(size_t(m)*3);
+            int nGraphIdx = 0;
+            const auto lAddGraphEdge = [&](int a, int b, int c) {
+                vnGraph[nGraphIdx*3+0] = a;
+                vnGraph[nGraphIdx*3+1] = b;
+                vnGraph[nGraphIdx*3+2] = c;
+                nGraphIdx++;
+            };
+            // real edges
+            for(int a=0; a<(int)voEdges.size(); ++a) {
+                int nNodeIdx_SEGM = voEdges[a].nNodeIdx_SEGM;
+                int nNodeIdx_GT = voEdges[a].nNodeIdx_GT;
+                lvDbgAssert(nNodeIdx_SEGM>=0 && nNodeIdx_SEGM<nNodeCount_SEGM);
+                lvDbgAssert(nNodeIdx_GT>=0 && nNodeIdx_GT<nNodeCount_GT);
+                lAddGraphEdge(nNodeIdx_SEGM,nNodeIdx_GT,(int)rint(voEdges[a].dEdgeDist*multiplier));
+            }
+            // outliers edges for map1, exclude diagonal
+            for(int nNodeIdx_SEGM=0; nNodeIdx_SEGM<nNodeCount_SEGM; ++nNodeIdx_SEGM) {
+                BSDS500::kOfN(degree_SEGM,nNodeCount_SEGM-1,vnOutliers.data());
+                for(int a=0; a<degree_SEGM; a++) {
+                    int j = vnOutliers[a];
+                    if(j>=nNodeIdx_SEGM) {j++;}
+                    lvDbgAssert(nNodeIdx_SEGM!=j);
+                    lvDbgAssert(j>=0 && j<nNodeCount_SEGM);
+                    lAddGraphEdge(nNodeIdx_SEGM,nNodeCount_GT+j,nOutlierWeight);
+                }
+            }
+            // outliers edges for map2, exclude diagonal
+            for(int nNodeIdx_GT = 0; nNodeIdx_GT<nNodeCount_GT; nNodeIdx_GT++) {
+                BSDS500::kOfN(degree_GT,nNodeCount_GT-1,vnOutliers.data());
+                for(int a = 0; a<degree_GT; a++) {
+                    int i = vnOutliers[a];
+                    if(i>=nNodeIdx_GT) {i++;}
+                    lvDbgAssert(i!=nNodeIdx_GT);
+                    lvDbgAssert(i>=0 && i<nNodeCount_GT);
+                    lAddGraphEdge(nNodeCount_SEGM+i,nNodeIdx_GT,nOutlierWeight);
+                }
+            }
+            // outlier-to-outlier edges
+            for(int i = 0; i<nmax; i++) {
+                BSDS500::kOfN(degree_mix,nmin,vnOutliers.data());
+                for(int a = 0; a<degree_mix; a++) {
+                    const int j = vnOutliers[a];
+                    lvDbgAssert(j>=0 && j<nmin);
+                    if(nNodeCount_SEGM<nNodeCount_GT) {
+                        lvDbgAssert(i>=0 && i<nNodeCount_GT);
+                        lvDbgAssert(j>=0 && j<nNodeCount_SEGM);
+                        lAddGraphEdge(nNodeCount_SEGM+i,nNodeCount_GT+j,nOutlierWeight);
+                    }
+                    else {
+                        lvDbgAssert(i>=0 && i<nNodeCount_SEGM);
+                        lvDbgAssert(j>=0 && j<nNodeCount_GT);
+                        lAddGraphEdge(nNodeCount_SEGM+j,nNodeCount_GT+i,nOutlierWeight);
+                    }
+                }
+            }
+            // perfect match overlay (diagonal)
+            for(int i = 0; i<nNodeCount_SEGM; i++)
+                lAddGraphEdge(i,nNodeCount_GT+i,nOutlierWeight*multiplier);
+            for(int i = 0; i<nNodeCount_GT; i++)
+                lAddGraphEdge(nNodeCount_SEGM+i,i,nOutlierWeight*multiplier);
+            lvDbgAssert(nGraphIdx==m);
+
+            // Check all the edges, and set the values up for CSA.
+            for(int i = 0; i<m; i++) {
+                lvDbgAssert(vnGraph[i*3+0]>=0 && vnGraph[i*3+0]<n);
+                lvDbgAssert(vnGraph[i*3+1]>=0 && vnGraph[i*3+1]<n);
+                vnGraph[i*3+0] += 1;
+                vnGraph[i*3+1] += 1+n;
+            }
+
+            // Solve the assignment problem.
+            BSDS500::CSA oCSASolver(2*n,m,vnGraph.data());
+            lvAssert(oCSASolver.edges()==n);
+
+            std::vector<int>& vnOutGraph = oArena.vnOutGraph;
+            vnOutGraph.resize(size_t(n)*3);
+            for(int i = 0; i<n; i++) {
+                int a,b,c;
+                oCSASolver.edge(i,a,b,c);
+                vnOutGraph[i*3+0] = a-1;
+                vnOutGraph[i*3+1] = b-1-n;
+                vnOutGraph[i*3+2] = c;
+            }
+
+            // Check the solution.
+            // Count the number of high-cost edges from the perfect match
+            // overlay that were used in the match.
+            int nOverlayCount = 0;
+            for(int a = 0; a<n; a++) {
+                const int i = vnOutGraph[a*3+0];
+                const int j = vnOutGraph[a*3+1];
+                const int c = vnOutGraph[a*3+2];
+                lvDbgAssert(i>=0 && i<n);
+                lvDbgAssert(j>=0 && j<n);
+                lvDbgAssert(c>=0);
+                // edge from high-cost perfect match overlay
+                if(c==nOutlierWeight*multiplier) {nOverlayCount++;}
+                // skip outlier edges
+                if(i>=nNodeCount_SEGM) {continue;}
+                if(j>=nNodeCount_GT) {continue;}
+                // for edges between real nodes, check the edge weight
+                lvDbgAssert((int)rint(sqrt((voNodeToPxLUT_SEGM[i].x-voNodeToPxLUT_GT[j].x)*(voNodeToPxLUT_SEGM[i].x-voNodeToPxLUT_GT[j].x)+(voNodeToPxLUT_SEGM[i].y-voNodeToPxLUT_GT[j].y)*(voNodeToPxLUT_SEGM[i].y-voNodeToPxLUT_GT[j].y))*multiplier)==c);
+            }
+
+            // Print a warning if any of the edges from the perfect match overlay
+            // were used.  This should happen rarely.  If it happens frequently,
+            // then the outlier connectivity should be increased.
+            if(nOverlayCount>5) {
+                fprintf(stderr,"%s:%d: WARNING: The match includes %d outlier(s) from the perfect match overlay.\n",__FILE__,__LINE__,nOverlayCount);
+            }
+
+            // Compute match arrays.
+            for(int a = 0; a<n; a++) {
+                // node ids
+                const int i = vnOutGraph[a*3+0];
+                const int j = vnOutGraph[a*3+1];
+                // skip outlier edges
+                if(i>=nNodeCount_SEGM) {continue;}
+                if(j>=nNodeCount_GT) {continue;}
+                // for edges between real nodes, check the edge weight
+                const cv::Point2i oPx_SEGM = voNodeToPxLUT_SEGM[i];
+                const cv::Point2i oPx_GT = voNodeToPxLUT_GT[j];
+                // record edges
+                lvAssert(oCurrSegmMask.at<uchar>(oPx_SEGM));
+                lvDbgAssert(std::binary_search(vnGTPxIdxs.begin(),vnGTPxIdxs.end(),oPx_GT.y*nCols+oPx_GT.x));
+                vnMatchedSegmPxIdxs.push_back(oPx_SEGM.y*nCols+oPx_SEGM.x);
+                ++nIndivTP;
+            }
+        }
+        return nIndivTP;
+    }
+
+#else //(!USE_BSDS500_BENCHMARK)
+
+    /// matches each gt edge pixel with the first segmentation edge pixel found within the max distance, adding matched segm pixel linear indices to the given array, and returning the match count
+    static uint64_t matchEdgeMaps(const cv::Mat& oCurrSegmMask, const BSDS500GTData& oGTData, size_t nGTMaskIdx, std::vector<int>& vnMatchedSegmPxIdxs) {
+        lvDbgAssert(oCurrSegmMask.isContinuous() && oCurrSegmMask.size()==oGTData.oSize);
+        const int nRows = oCurrSegmMask.rows, nCols = oCurrSegmMask.cols;
+        uint64_t nIndivTP = 0;
+        for(int nGTPxIdx : oGTData.vvnGTPxIdxs[nGTMaskIdx]) {
+            const int i = nGTPxIdx/nCols, j = nGTPxIdx%nCols;
+            const bool bInterior = oGTData.isInterior(nGTPxIdx);
+            for(size_t nOffsetIdx=0; nOffsetIdx<oGTData.voNeighbOffsets.size(); ++nOffsetIdx) {
+                const int u = oGTData.voNeighbOffsets[nOffsetIdx].nRowOffset, v = oGTData.voNeighbOffsets[nOffsetIdx].nColOffset;
+                if(!bInterior && (i+u<0 || i+u>=nRows || j+v<0 || j+v>=nCols)) continue;
+                const int nSegmPxIdx = nGTPxIdx+oGTData.vnNeighbLinearOffsets[nOffsetIdx];
+                if(oCurrSegmMask.data[nSegmPxIdx]) {
+                    ++nIndivTP;
+                    vnMatchedSegmPxIdxs.push_back(nSegmPxIdx);
+                    break;
+                }
+            }
+        }
+        return nIndivTP;
+    }
+
+#endif //(!USE_BSDS500_BENCHMARK)
+
     struct BSDS500MetricsAccumulator : IMetricsAccumulator {
         virtual bool isEqual(const std::shared_ptr<const IMetricsAccumulator>& m) const override {
             const auto& m2 = dynamic_cast<const BSDS500MetricsAccumulator&>(*m.get());
@@ -102,360 +566,86 @@ namespace lv {
             if(oGT.empty())
                 return;
             lvAssert(oClassif.type()==CV_8UC1 && oGT.type()==CV_8UC1);
-            lvAssert(oClassif.isContinuous() && oGT.isContinuous());
             lvAssert(oClassif.cols==oGT.cols && (oGT.rows%oClassif.rows)==0 && (oGT.rows/oClassif.rows)>=1);
-            lvAssert(oClassif.step.p[0]==oGT.step.p[0]);
-
-            const double dMaxDist = DATASETS_BSDS500_EVAL_IMAGE_DIAG_RATIO_DIST*sqrt(double(oClassif.cols*oClassif.cols+oClassif.rows*oClassif.rows));
-            const double dMaxDistSqr = dMaxDist*dMaxDist;
-            const int nMaxDist = (int)ceil(dMaxDist);
-            lvAssert(dMaxDist>0 && nMaxDist>0);
-
+            accumulate(oClassif,*BSDS500GTData::create(oGT,oClassif.size()));
+        }
+        /// accumulates the counters of a single image using prebuilt (possibly cached) gt-side matching structures
+        void accumulate(const cv::Mat& oClassif, const BSDS500GTData& oGTData) {
+            lvAssert(oClassif.type()==CV_8UC1 && oClassif.isContinuous());
+            lvAssert(oClassif.size()==oGTData.oSize);
             BSDS500Counters oMetricsBase(m_nThresholdBins);
             const std::vector<uchar> vuEvalUniqueVals = lv::unique<uchar>(oClassif);
-            cv::Mat oCurrSegmMask(oClassif.size(),CV_8UC1), oTmpSegmMask(oClassif.size(),CV_8UC1);
-            cv::Mat oSegmTPAccumulator(oClassif.size(),CV_8UC1);
+            // consecutive bins that yield the same binarized mask are only evaluated once (on the first bin of each run)
+            std::vector<size_t> vnEvalBinIdxs,vnBinSourceIdxs(oMetricsBase.vnThresholds.size());
             size_t nNextEvalUniqueValIdx = 0;
             size_t nThresholdBinIdx = 0;
             while(nThresholdBinIdx<oMetricsBase.vnThresholds.size()) {
-                cv::compare(oClassif,oMetricsBase.vnThresholds[nThresholdBinIdx],oTmpSegmMask,cv::CMP_GE);
-                lv::thinning(oTmpSegmMask,oCurrSegmMask);
-
-    #if USE_BSDS500_BENCHMARK
+                const size_t nSourceBinIdx = nThresholdBinIdx;
+                vnEvalBinIdxs.push_back(nSourceBinIdx);
+                vnBinSourceIdxs[nSourceBinIdx] = nSourceBinIdx;
+                while(nNextEvalUniqueValIdx+1<vuEvalUniqueVals.size() && vuEvalUniqueVals[nNextEvalUniqueValIdx]<=oMetricsBase.vnThresholds[nThresholdBinIdx])
+                    ++nNextEvalUniqueValIdx;
+                while(++nThresholdBinIdx<oMetricsBase.vnThresholds.size() && oMetricsBase.vnThresholds[nThresholdBinIdx]<=vuEvalUniqueVals[nNextEvalUniqueValIdx])
+                    vnBinSourceIdxs[nThresholdBinIdx] = nSourceBinIdx;
+            }
 
-                ///////////////////////////////////////////////////////
-                // code below is adapted from match.cc::matchEdgeMaps()
-                ///////////////////////////////////////////////////////
+            // thinned masks are computed for all evaluated bins first, then matched against each gt mask; both steps run on a thread pool
+            const size_t nGTMaskCount = oGTData.vvnGTPxIdxs.size();
+            lv::ThreadPool oThreadPool(DATASETS_BSDS500_EVAL_THREAD_COUNT);
+            std::vector<cv::Mat> voSegmMasks(vnEvalBinIdxs.size());
+            oThreadPool.parallel_for(vnEvalBinIdxs.size(),[&](size_t nEvalIdx) {
+                cv::Mat oTmpSegmMask;
+                cv::compare(oClassif,oMetricsBase.vnThresholds[vnEvalBinIdxs[nEvalIdx]],oTmpSegmMask,cv::CMP_GE);
+                lv::thinning(oTmpSegmMask,voSegmMasks[nEvalIdx]);
+            });
+            if(m_eEvalMode==BSDS500EvalMode_Approx) {
+                accumulateApprox(oMetricsBase,oGTData,voSegmMasks,vnEvalBinIdxs,vnBinSourceIdxs,oThreadPool);
+                m_voMetricsBase.push_back(oMetricsBase);
+                return;
+            }
+            const size_t nMatchTaskCount = vnEvalBinIdxs.size()*nGTMaskCount;
+            std::vector<uint64_t> vnTaskIndivTP(nMatchTaskCount,0);
+            std::vector<std::vector<int>> vvnTaskMatchedPxIdxs(nMatchTaskCount);
+            std::atomic_size_t nDoneTaskCount(0);
+            std::mutex oProgressMutex;
+            oThreadPool.parallel_for(nMatchTaskCount,[&](size_t nTaskIdx) {
+                const size_t nEvalIdx = nTaskIdx/nGTMaskCount, nGTMaskIdx = nTaskIdx%nGTMaskCount;
+                vnTaskIndivTP[nTaskIdx] = matchEdgeMaps(voSegmMasks[nEvalIdx],oGTData,nGTMaskIdx,vvnTaskMatchedPxIdxs[nTaskIdx]);
+                const float fCompltRatio = float(++nDoneTaskCount)/nMatchTaskCount;
+                std::mutex_lock_guard oProgressLock(oProgressMutex);
+                lv::updateConsoleProgressBar("BSDS500 eval:",fCompltRatio);
+            });
 
-                const double dOutlierCost = 100*dMaxDist;
-                lvAssert(dOutlierCost>1);
+            const uint64_t nGTPosCount = oGTData.nGTPosCount; // sumR += ...
+            cv::Mat oSegmTPAccumulator(oClassif.size(),CV_8UC1); // accP |= ...
+            for(size_t nEvalIdx=0; nEvalIdx<vnEvalBinIdxs.size(); ++nEvalIdx) {
                 oSegmTPAccumulator = cv::Scalar_<uchar>(0);
-                cv::Mat oGTAccumulator(oCurrSegmMask.size(),CV_8UC1,cv::Scalar_<uchar>(0));
-                uint64_t nIndivTP = 0;
-                uint64_t nGTPosCount = 0;
-
-                static constexpr int multiplier = 100;
-                static constexpr int degree = 6;
-                static_assert(degree>0,"csa config bad; degree of outlier connections should be > 0");
-                static_assert(multiplier>0,"csa config bad; floating-point weights to integers should be > 0");
-
-                for(size_t nGTMaskIdx=0; nGTMaskIdx<size_t(oGT.rows/oCurrSegmMask.rows); ++nGTMaskIdx) {
-                    cv::Mat oCurrGTSegmMask = oGT(cv::Rect(0,int(oCurrSegmMask.rows*nGTMaskIdx),oCurrSegmMask.cols,oCurrSegmMask.rows));
-                    cv::Mat oMatchable_SEGM(oCurrSegmMask.size(),CV_8UC1,cv::Scalar_<uchar>(0));
-                    cv::Mat oMatchable_GT(oCurrSegmMask.size(),CV_8UC1,cv::Scalar_<uchar>(0));
-                    // Figure out which nodes are matchable, i.e. within maxDist
-                    // of another node.
-                    for(int i=0; i<oCurrSegmMask.rows; ++i) {
-                        for(int j=0; j<oCurrSegmMask.cols; ++j) {
-                            if(!oCurrGTSegmMask.at<uchar>(i,j)) continue;
-                            for(int u=-nMaxDist; u<=nMaxDist; ++u) {
-                                if(i+u<0) continue;
-                                if(i+u>=oCurrSegmMask.rows) continue;
-                                if(double(u)>dMaxDist) continue;
-                                for(int v=-nMaxDist; v<=nMaxDist; ++v) {
-                                    if(j+v<0) continue;
-                                    if(j+v>=oCurrSegmMask.cols) continue;
-                                    if(double(v)>dMaxDist) continue;
-                                    const double dCurrDistSqr = u*u+v*v;
-                                    if(dCurrDistSqr>dMaxDistSqr) continue;
-                                    if(oCurrSegmMask.at<uchar>(i+u,j+v)) {
-                                        oMatchable_SEGM.at<uchar>(i+u,j+v) = UCHAR_MAX;
-                                        oMatchable_GT.at<uchar>(i,j) = UCHAR_MAX;
-                                    }
-                                }
-                            }
-                        }
-                    }
-
-                    int nNodeCount_SEGM=0, nNodeCount_GT=0;
-                    std::vector<cv::Point2i> voNodeToPxLUT_SEGM,voNodeToPxLUT_GT;
-                    cv::Mat oPxToNodeLUT_SEGM(oCurrSegmMask.size(),CV_32SC1,cv::Scalar_<int>(-1));
-                    cv::Mat oPxToNodeLUT_GT(oCurrSegmMask.size(),CV_32SC1,cv::Scalar_<int>(-1));
-                    // Count the number of nodes on each side of the match.
-                    // Construct nodeID->pixel and pixel->nodeID maps.
-                    // Node IDs range from [0,nNodeCount_SEGM) and [0,nNodeCount_GT).
-                    for(int i=0; i<oCurrSegmMask.rows; ++i) {
-                        for(int j=0; j<oCurrSegmMask.cols; ++j) {
-                            cv::Point2i px(j,i);
-                            if(oMatchable_SEGM.at<uchar>(px)) {
-                                oPxToNodeLUT_SEGM.at<int>(px) = nNodeCount_SEGM;
-                                voNodeToPxLUT_SEGM.push_back(px);
-                                ++nNodeCount_SEGM;
-                            }
-                            if(oMatchable_GT.at<uchar>(px)) {
-                                oPxToNodeLUT_GT.at<int>(px) = nNodeCount_GT;
-                                voNodeToPxLUT_GT.push_back(px);
-                                ++nNodeCount_GT;
-                            }
-                        }
-                    }
-
-                    struct Edge {
-                        int nNodeIdx_SEGM;
-                        int nNodeIdx_GT;
-                        double dEdgeDist;
-                    };
-                    std::vector<Edge> voEdges;
-                    // Construct the list of edges between pixels within maxDist.
-                    for(int i=0; i<oCurrSegmMask.rows; ++i) {
-                        for(int j=0; j<oCurrSegmMask.cols; ++j) {
-                            if(!oMatchable_GT.at<uchar>(i,j)) continue;
-                            for(int u=-nMaxDist; u<=nMaxDist; ++u) {
-                                if(i+u<0) continue;
-                                if(i+u>=oCurrSegmMask.rows) continue;
-                                if(double(u)>dMaxDist) continue;
-                                for(int v=-nMaxDist; v<=nMaxDist; ++v) {
-                                    if(j+v<0) continue;
-                                    if(j+v>=oCurrSegmMask.cols) continue;
-                                    if(double(v)>dMaxDist) continue;
-                                    if(!oMatchable_SEGM.at<uchar>(i+u,j+v)) continue;
-                                    const double dCurrDistSqr = u*u+v*v;
-                                    if(dCurrDistSqr>dMaxDistSqr) continue;
-                                    Edge e;
-                                    e.nNodeIdx_SEGM = oPxToNodeLUT_SEGM.at<int>(i+u,j+v);
-                                    e.nNodeIdx_GT = oPxToNodeLUT_GT.at<int>(i,j);
-                                    e.dEdgeDist = sqrt(dCurrDistSqr);
-                                    lvDbgAssert(e.nNodeIdx_SEGM>=0 && e.nNodeIdx_SEGM<nNodeCount_SEGM);
-                                    lvDbgAssert(e.nNodeIdx_GT>=0 && e.nNodeIdx_GT<nNodeCount_GT);
-                                    voEdges.push_back(e);
-                                }
-                            }
-                        }
-                    }
-
-                    // The cardinality of the match is n.
-                    const int n = nNodeCount_SEGM+nNodeCount_GT;
-                    const int nmin = std::min(nNodeCount_SEGM,nNodeCount_GT);
-                    const int nmax = std::max(nNodeCount_SEGM,nNodeCount_GT);
-
-                    // Compute the degree of various outlier connections.
-                    const int degree_SEGM = std::max(0,std::min(degree,nNodeCount_SEGM-1)); // from map1
-                    const int degree_GT = std::max(0,std::min(degree,nNodeCount_GT-1)); // from map2
-                    const int degree_mix = std::min(degree,std::min(nNodeCount_SEGM,nNodeCount_GT)); // between outliers
-                    const int dmax = std::max(degree_SEGM,std::max(degree_GT,degree_mix));
-
-                    lvDbgAssert(nNodeCount_SEGM==0 || (degree_SEGM>=0 && degree_SEGM<nNodeCount_SEGM));
-                    lvDbgAssert(nNodeCount_GT==0 || (degree_GT>=0 && degree_GT<nNodeCount_GT));
-                    lvDbgAssert(degree_mix>=0 && degree_mix<=nmin);
-
-                    // Count the number of edges.
-                    int m = 0;
-                    m += (int)voEdges.size();         // real connections
-                    m += degree_SEGM*nNodeCount_SEGM; // outlier connections
-                    m += degree_GT*nNodeCount_GT;     // outlier connections
-                    m += degree_mix*nmax;             // outlier-outlier connections
-                    m += n;                           // high-cost perfect match overlay
-                                                      // If the graph is empty, then there's nothing to do.
-                    if(m>0) {
-                        // Weight of outlier connections.
-                        const int nOutlierWeight = (int)ceil(dOutlierCost*multiplier);
-                        // Scratch array for outlier edges.
-                        std::vector<int> vnOutliers(dmax);
-                        // Construct the input graph for the assignment problem.
-                        cv::Mat oGraph(m,3,CV_32SC1);
-                        int nGraphIdx = 0;
-                        // real edges
-                        for(int a=0; a<(int)voEdges.size(); ++a) {
-                            int nNodeIdx_SEGM = voEdges[a].nNodeIdx_SEGM;
-                            int nNodeIdx_GT = voEdges[a].nNodeIdx_GT;
-                            lvDbgAssert(nNodeIdx_SEGM>=0 && nNodeIdx_SEGM<nNodeCount_SEGM);
-                            lvDbgAssert(nNodeIdx_GT>=0 && nNodeIdx_GT<nNodeCount_GT);
-                            oGraph.at<int>(nGraphIdx,0) = nNodeIdx_SEGM;
-                            oGraph.at<int>(nGraphIdx,1) = nNodeIdx_GT;
-                            oGraph.at<int>(nGraphIdx,2) = (int)rint(voEdges[a].dEdgeDist*multiplier);
-                            nGraphIdx++;
-                        }
-                        // outliers edges for map1, exclude diagonal
-                        for(int nNodeIdx_SEGM=0; nNodeIdx_SEGM<nNodeCount_SEGM; ++nNodeIdx_SEGM) {
-                            BSDS500::kOfN(degree_SEGM,nNodeCount_SEGM-1,vnOutliers.data());
-                            for(int a=0; a<degree_SEGM; a++) {
-                                int j = vnOutliers[a];
-                                if(j>=nNodeIdx_SEGM) {j++;}
-                                lvDbgAssert(nNodeIdx_SEGM!=j);
-                                lvDbgAssert(j>=0 && j<nNodeCount_SEGM);
-                                oGraph.at<int>(nGraphIdx,0) = nNodeIdx_SEGM;
-                                oGraph.at<int>(nGraphIdx,1) = nNodeCount_GT+j;
-                                oGraph.at<int>(nGraphIdx,2) = nOutlierWeight;
-                                nGraphIdx++;
-                            }
-                        }
-                        // outliers edges for map2, exclude diagonal
-                        for(int nNodeIdx_GT = 0; nNodeIdx_GT<nNodeCount_GT; nNodeIdx_GT++) {
-                            BSDS500::kOfN(degree_GT,nNodeCount_GT-1,vnOutliers.data());
-                            for(int a = 0; a<degree_GT; a++) {
-                                int i = vnOutliers[a];
-                                if(i>=nNodeIdx_GT) {i++;}
-                                lvDbgAssert(i!=nNodeIdx_GT);
-                                lvDbgAssert(i>=0 && i<nNodeCount_GT);
-                                oGraph.at<int>(nGraphIdx,0) = nNodeCount_SEGM+i;
-                                oGraph.at<int>(nGraphIdx,1) = nNodeIdx_GT;
-                                oGraph.at<int>(nGraphIdx,2) = nOutlierWeight;
-                                nGraphIdx++;
-                            }
-                        }
-                        // outlier-to-outlier edges
-                        for(int i = 0; i<nmax; i++) {
-                            BSDS500::kOfN(degree_mix,nmin,vnOutliers.data());
-                            for(int a = 0; a<degree_mix; a++) {
-                                const int j = vnOutliers[a];
-                                lvDbgAssert(j>=0 && j<nmin);
-                                if(nNodeCount_SEGM<nNodeCount_GT) {
-                                    lvDbgAssert(i>=0 && i<nNodeCount_GT);
-                                    lvDbgAssert(j>=0 && j<nNodeCount_SEGM);
-                                    oGraph.at<int>(nGraphIdx,0) = nNodeCount_SEGM+i;
-                                    oGraph.at<int>(nGraphIdx,1) = nNodeCount_GT+j;
-                                }
-                                else {
-                                    lvDbgAssert(i>=0 && i<nNodeCount_SEGM);
-                                    lvDbgAssert(j>=0 && j<nNodeCount_GT);
-                                    oGraph.at<int>(nGraphIdx,0) = nNodeCount_SEGM+j;
-                                    oGraph.at<int>(nGraphIdx,1) = nNodeCount_GT+i;
-                                }
-                                oGraph.at<int>(nGraphIdx,2) = nOutlierWeight;
-                                nGraphIdx++;
-                            }
-                        }
-                        // perfect match overlay (diagonal)
-                        for(int i = 0; i<nNodeCount_SEGM; i++) {
-                            oGraph.at<int>(nGraphIdx,0) = i;
-                            oGraph.at<int>(nGraphIdx,1) = nNodeCount_GT+i;
-                            oGraph.at<int>(nGraphIdx,2) = nOutlierWeight*multiplier;
-                            nGraphIdx++;
-                        }
-                        for(int i = 0; i<nNodeCount_GT; i++) {
-                            oGraph.at<int>(nGraphIdx,0) = nNodeCount_SEGM+i;
-                            oGraph.at<int>(nGraphIdx,1) = i;
-                            oGraph.at<int>(nGraphIdx,2) = nOutlierWeight*multiplier;
-                            nGraphIdx++;
-                        }
-                        lvDbgAssert(nGraphIdx==m);
-
-                        // Check all the edges, and set the values up for CSA.
-                        for(int i = 0; i<m; i++) {
-                            lvDbgAssert(oGraph.at<int>(i,0)>=0 && oGraph.at<int>(i,0)<n);
-                            lvDbgAssert(oGraph.at<int>(i,1)>=0 && oGraph.at<int>(i,1)<n);
-                            oGraph.at<int>(i,0) += 1;
-                            oGraph.at<int>(i,1) += 1+n;
-                        }
-
-                        // Solve the assignment problem.
-                        BSDS500::CSA oCSASolver(2*n,m,(int*)oGraph.data);
-                        lvAssert(oCSASolver.edges()==n);
-
-                        cv::Mat oOutGraph(n,3,CV_32SC1);
-                        for(int i = 0; i<n; i++) {
-                            int a,b,c;
-                            oCSASolver.edge(i,a,b,c);
-                            oOutGraph.at<int>(i,0) = a-1;
-                            oOutGraph.at<int>(i,1) = b-1-n;
-                            oOutGraph.at<int>(i,2) = c;
-                        }
-
-                        // Check the solution.
-                        // Count the number of high-cost edges from the perfect match
-                        // overlay that were used in the match.
-                        int nOverlayCount = 0;
-                        for(int a = 0; a<n; a++) {
-                            const int i = oOutGraph.at<int>(a,0);
-                            const int j = oOutGraph.at<int>(a,1);
-                            const int c = oOutGraph.at<int>(a,2);
-                            lvDbgAssert(i>=0 && i<n);
-                            lvDbgAssert(j>=0 && j<n);
-                            lvDbgAssert(c>=0);
-                            // edge from high-cost perfect match overlay
-                            if(c==nOutlierWeight*multiplier) {nOverlayCount++;}
-                            // skip outlier edges
-                            if(i>=nNodeCount_SEGM) {continue;}
-                            if(j>=nNodeCount_GT) {continue;}
-                            // for edges between real nodes, check the edge weight
-                            lvDbgAssert((int)rint(sqrt((voNodeToPxLUT_SEGM[i].x-voNodeToPxLUT_GT[j].x)*(voNodeToPxLUT_SEGM[i].x-voNodeToPxLUT_GT[j].x)+(voNodeToPxLUT_SEGM[i].y-voNodeToPxLUT_GT[j].y)*(voNodeToPxLUT_SEGM[i].y-voNodeToPxLUT_GT[j].y))*multiplier)==c);
-                        }
-
-                        // Print a warning if any of the edges from the perfect match overlay
-                        // were used.  This should happen rarely.  If it happens frequently,
-                        // then the outlier connectivity should be increased.
-                        if(nOverlayCount>5) {
-                            fprintf(stderr,"%s:%d: WARNING: The match includes %d outlier(s) from the perfect match overlay.\n",__FILE__,__LINE__,nOverlayCount);
-                        }
-
-                        // Compute match arrays.
-                        for(int a = 0; a<n; a++) {
-                            // node ids
-                            const int i = oOutGraph.at<int>(a,0);
-                            const int j = oOutGraph.at<int>(a,1);
-                            // skip outlier edges
-                            if(i>=nNodeCount_SEGM) {continue;}
-                            if(j>=nNodeCount_GT) {continue;}
-                            // for edges between real nodes, check the edge weight
-                            const cv::Point2i oPx_SEGM = voNodeToPxLUT_SEGM[i];
-                            const cv::Point2i oPx_GT = voNodeToPxLUT_GT[j];
-                            // record edges
-                            lvAssert(oCurrSegmMask.at<uchar>(oPx_SEGM) && oCurrGTSegmMask.at<uchar>(oPx_GT));
-                            oSegmTPAccumulator.at<uchar>(oPx_SEGM) = UCHAR_MAX;
-                            ++nIndivTP;
-                        }
-                    }
-                    nGTPosCount += cv::countNonZero(oCurrGTSegmMask);
-                    oGTAccumulator |= oCurrGTSegmMask;
-                }
-
-    #else //(!USE_BSDS500_BENCHMARK)
-
-                oSegmTPAccumulator = cv::Scalar_<uchar>(0); // accP |= ...
                 uint64_t nIndivTP = 0; // cntR += ...
-                uint64_t nGTPosCount = 0; // sumR += ...
-                for(size_t nGTMaskIdx = 0; nGTMaskIdx<size_t(oGT.rows/oCurrSegmMask.rows); ++nGTMaskIdx) {
-                    cv::Mat oCurrGTSegmMask = oGT(cv::Rect(0,int(oCurrSegmMask.rows*nGTMaskIdx),oCurrSegmMask.cols,oCurrSegmMask.rows));
-                    for(int i = 0; i<oCurrSegmMask.rows; ++i) {
-                        for(int j = 0; j<oCurrSegmMask.cols; ++j) {
-                            if(!oCurrGTSegmMask.at<uchar>(i,j)) continue;
-                            ++nGTPosCount;
-                            bool bFoundMatch = false;
-                            for(int u = -nMaxDist; u<=nMaxDist && !bFoundMatch; ++u) {
-                                if(i+u<0) continue;
-                                if(i+u>=oCurrSegmMask.rows) continue;
-                                if(double(u)>dMaxDist) continue;
-                                for(int v = -nMaxDist; v<=nMaxDist && !bFoundMatch; ++v) {
-                                    if(j+v<0) continue;
-                                    if(j+v>=oCurrSegmMask.cols) continue;
-                                    if(double(v)>dMaxDist) continue;
-                                    const double dCurrDistSqr = u*u+v*v;
-                                    if(dCurrDistSqr>dMaxDistSqr) continue;
-                                    if(oCurrSegmMask.at<uchar>(i+u,j+v)) {
-                                        ++nIndivTP;
-                                        oSegmTPAccumulator.at<uchar>(i+u,j+v) = UCHAR_MAX;
-                                        bFoundMatch = true;
-                                    }
-                                }
-                            }
-                        }
-                    }
+                for(size_t nGTMaskIdx=0; nGTMaskIdx<nGTMaskCount; ++nGTMaskIdx) {
+                    nIndivTP += vnTaskIndivTP[nEvalIdx*nGTMaskCount+nGTMaskIdx];
+                    for(int nPxIdx : vvnTaskMatchedPxIdxs[nEvalIdx*nGTMaskCount+nGTMaskIdx])
+                        oSegmTPAccumulator.data[nPxIdx] = UCHAR_MAX;
                 }
-
-    #endif //(!USE_BSDS500_BENCHMARK)
+                const size_t nBinIdx = vnEvalBinIdxs[nEvalIdx];
 
                 //re = TP / (TP + FN)
                 lvAssert(nGTPosCount>=nIndivTP);
-                oMetricsBase.vnIndivTP[nThresholdBinIdx] = nIndivTP;
-                oMetricsBase.vnIndivTPFN[nThresholdBinIdx] = nGTPosCount;
+                oMetricsBase.vnIndivTP[nBinIdx] = nIndivTP;
+                oMetricsBase.vnIndivTPFN[nBinIdx] = nGTPosCount;
 
                 //pr = TP / (TP + FP)
                 uint64_t nSegmTPAccCount = uint64_t(cv::countNonZero(oSegmTPAccumulator));
-                uint64_t nSegmPosCount = uint64_t(cv::countNonZero(oCurrSegmMask));
+                uint64_t nSegmPosCount = uint64_t(cv::countNonZero(voSegmMasks[nEvalIdx]));
                 lvAssert(nSegmPosCount>=nSegmTPAccCount);
-                oMetricsBase.vnTotalTP[nThresholdBinIdx] = nSegmTPAccCount;
-                oMetricsBase.vnTotalTPFP[nThresholdBinIdx] = nSegmPosCount;
-                while(nNextEvalUniqueValIdx+1<vuEvalUniqueVals.size() && vuEvalUniqueVals[nNextEvalUniqueValIdx]<=oMetricsBase.vnThresholds[nThresholdBinIdx])
-                    ++nNextEvalUniqueValIdx;
-                while(++nThresholdBinIdx<oMetricsBase.vnThresholds.size() && oMetricsBase.vnThresholds[nThresholdBinIdx]<=vuEvalUniqueVals[nNextEvalUniqueValIdx]) {
-                    oMetricsBase.vnIndivTP[nThresholdBinIdx] = oMetricsBase.vnIndivTP[nThresholdBinIdx-1];
-                    oMetricsBase.vnIndivTPFN[nThresholdBinIdx] = oMetricsBase.vnIndivTPFN[nThresholdBinIdx-1];
-                    oMetricsBase.vnTotalTP[nThresholdBinIdx] = oMetricsBase.vnTotalTP[nThresholdBinIdx-1];
-                    oMetricsBase.vnTotalTPFP[nThresholdBinIdx] = oMetricsBase.vnTotalTPFP[nThresholdBinIdx-1];
-                }
-
-                const float fCompltRatio = float(nThresholdBinIdx)/oMetricsBase.vnThresholds.size();
-                lv::updateConsoleProgressBar("BSDS500 eval:",fCompltRatio);
+                oMetricsBase.vnTotalTP[nBinIdx] = nSegmTPAccCount;
+                oMetricsBase.vnTotalTPFP[nBinIdx] = nSegmPosCount;
+            }
+            for(size_t nBinIdx=0; nBinIdx<oMetricsBase.vnThresholds.size(); ++nBinIdx) {
+                const size_t nSourceBinIdx = vnBinSourceIdxs[nBinIdx];
+                oMetricsBase.vnIndivTP[nBinIdx] = oMetricsBase.vnIndivTP[nSourceBinIdx];
+                oMetricsBase.vnIndivTPFN[nBinIdx] = oMetricsBase.vnIndivTPFN[nSourceBinIdx];
+                oMetricsBase.vnTotalTP[nBinIdx] = oMetricsBase.vnTotalTP[nSourceBinIdx];
+                oMetricsBase.vnTotalTPFP[nBinIdx] = oMetricsBase.vnTotalTPFP[nSourceBinIdx];
             }
             lv::cleanConsoleRow();
             m_voMetricsBase.push_back(oMetricsBase);
@@ -496,16 +686,60 @@ namespace lv {
             cv::mixChannels(std::vector<cv::Mat>{oSegm_FN_byte|oSegm_FP_byte,oSegm_FN_byte,oSegm_TP_byte},std::vector<cv::Mat>{oResult},vnMixPairs.data(),vnMixPairs.size()/2);
             return oResult;
         }
-        static std::shared_ptr<BSDS500MetricsAccumulator> create(size_t nThresholdsBins) {
+        static std::shared_ptr<BSDS500MetricsAccumulator> create(size_t nThresholdsBins, BSDS500EvalMode eEvalMode=DATASETS_BSDS500_EVAL_DEFAULT_MODE) {
             struct MetricsAccumulatorWrapper : BSDS500MetricsAccumulator {
-                MetricsAccumulatorWrapper(size_t nThresholdsBins) : BSDS500MetricsAccumulator(nThresholdsBins) {} // cant do 'using BaseCstr::BaseCstr;' since it keeps the access level
+                MetricsAccumulatorWrapper(size_t nThresholdsBins, BSDS500EvalMode eEvalMode) : BSDS500MetricsAccumulator(nThresholdsBins,eEvalMode) {} // cant do 'using BaseCstr::BaseCstr;' since it keeps the access level
             };
-            return std::make_shared<MetricsAccumulatorWrapper>(nThresholdsBins);
+            return std::make_shared<MetricsAccumulatorWrapper>(nThresholdsBins,eEvalMode);
         }
         std::vector<BSDS500Counters> m_voMetricsBase; // one counter block per image
         const size_t m_nThresholdBins;
+        BSDS500EvalMode m_eEvalMode; // only used when accumulating new images
     protected:
-        BSDS500MetricsAccumulator(size_t nThresholdBins) : m_nThresholdBins(nThresholdBins) {lvAssert(m_nThresholdBins>0 && m_nThresholdBins<=UCHAR_MAX);}
+        BSDS500MetricsAccumulator(size_t nThresholdBins, BSDS500EvalMode eEvalMode) :
+                m_nThresholdBins(nThresholdBins), m_eEvalMode(eEvalMode) {lvAssert(m_nThresholdBins>0 && m_nThresholdBins<=UCHAR_MAX);}
+        /// approximate counterpart of the matching step: edge pixels are matched if they lie within the max distance of any
+        /// pixel of the other map (via distance transforms), without enforcing a one-to-one assignment
+        static void accumulateApprox(BSDS500Counters& oMetricsBase, const BSDS500GTData& oGTData, const std::vector<cv::Mat>& voSegmMasks,
+                                     const std::vector<size_t>& vnEvalBinIdxs, const std::vector<size_t>& vnBinSourceIdxs,
+                                     lv::ThreadPool& oThreadPool) {
+            lvDbgAssert(!voSegmMasks.empty() && voSegmMasks.size()==vnEvalBinIdxs.size());
+            const float fMaxDist = float(oGTData.dMaxDist);
+            // gt tolerance masks only depend on the image, and are part of the (reusable) gt-side structures
+            const cv::Mat& oGTToleranceUnion = oGTData.oGTToleranceUnion;
+            const uint64_t nGTPosCount = oGTData.nGTPosCount; // sumR += ...
+            oThreadPool.parallel_for(vnEvalBinIdxs.size(),[&](size_t nEvalIdx) {
+                const cv::Mat& oCurrSegmMask = voSegmMasks[nEvalIdx];
+                const size_t nBinIdx = vnEvalBinIdxs[nEvalIdx];
+                const uint64_t nSegmPosCount = uint64_t(cv::countNonZero(oCurrSegmMask));
+                uint64_t nIndivTP = 0; // cntR += ...
+                if(nSegmPosCount>0) {
+                    cv::Mat oSegmDist;
+                    cv::distanceTransform(oCurrSegmMask==0,oSegmDist,cv::DIST_L2,cv::DIST_MASK_PRECISE);
+                    const cv::Mat oSegmTolerance = (oSegmDist<=fMaxDist);
+                    lvDbgAssert(oSegmTolerance.isContinuous());
+                    for(const std::vector<int>& vnGTPxIdxs : oGTData.vvnGTPxIdxs)
+                        for(int nGTPxIdx : vnGTPxIdxs)
+                            nIndivTP += uint64_t(oSegmTolerance.data[nGTPxIdx]!=0);
+                }
+                //re = TP / (TP + FN)
+                lvAssert(nGTPosCount>=nIndivTP);
+                oMetricsBase.vnIndivTP[nBinIdx] = nIndivTP;
+                oMetricsBase.vnIndivTPFN[nBinIdx] = nGTPosCount;
+                //pr = TP / (TP + FP)
+                const uint64_t nSegmTPAccCount = uint64_t(cv::countNonZero(oCurrSegmMask&oGTToleranceUnion)); // accP |= ...
+                lvAssert(nSegmPosCount>=nSegmTPAccCount);
+                oMetricsBase.vnTotalTP[nBinIdx] = nSegmTPAccCount;
+                oMetricsBase.vnTotalTPFP[nBinIdx] = nSegmPosCount;
+            });
+            for(size_t nBinIdx=0; nBinIdx<oMetricsBase.vnThresholds.size(); ++nBinIdx) {
+                const size_t nSourceBinIdx = vnBinSourceIdxs[nBinIdx];
+                oMetricsBase.vnIndivTP[nBinIdx] = oMetricsBase.vnIndivTP[nSourceBinIdx];
+                oMetricsBase.vnIndivTPFN[nBinIdx] = oMetricsBase.vnIndivTPFN[nSourceBinIdx];
+                oMetricsBase.vnTotalTP[nBinIdx] = oMetricsBase.vnTotalTP[nSourceBinIdx];
+                oMetricsBase.vnTotalTPFP[nBinIdx] = oMetricsBase.vnTotalTPFP[nSourceBinIdx];
+            }
+        }
     };
     using BSDS500MetricsAccumulatorPtr = std::shared_ptr<BSDS500MetricsAccumulator>;
     using BSDS500MetricsAccumulatorConstPtr = std::shared_ptr<const BSDS500MetricsAccumulator>;
@@ -810,8 +1044,13 @@ void lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,lv:
     if(getDatasetInfo()->isUsingEvaluator()) {
         auto pLoader = shared_from_this_cast<IDataLoader>(true);
         if(!m_pMetricsBase)
-            m_pMetricsBase = BSDS500MetricsAccumulator::create(DATASETS_BSDS500_EVAL_DEFAULT_THRESH_BINS);
-        m_pMetricsBase->accumulate(oClassif,pLoader->getGT(nIdx),pLoader->getInputROI(nIdx));
+            m_pMetricsBase = BSDS500MetricsAccumulator::create(DATASETS_BSDS500_EVAL_DEFAULT_THRESH_BINS,m_eEvalMode);
+        const cv::Mat& oGT = pLoader->getGT(nIdx);
+        if(oGT.empty())
+            return;
+        // gt-side structures are kept across metrics resets (i.e. parameter sweeps), and are only rebuilt if the gt itself changed
+        const std::string sCacheFilePath = m_sGTCacheDirPath.empty()?std::string():(m_sGTCacheDirPath+getPacketName(nIdx)+GT_CACHE_FILE_SUFFIX);
+        m_pMetricsBase->accumulate(oClassif,getCachedGTData(m_mpGTDataCache,sCacheFilePath,nIdx,oGT,oClassif.size()));
     }
 }
 
@@ -821,5 +1060,126 @@ cv::Mat lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,
 }
 
 void lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,lv::NonParallel>::resetMetrics() {
-    m_pMetricsBase = BSDS500MetricsAccumulator::create(DATASETS_BSDS500_EVAL_DEFAULT_THRESH_BINS);
+    m_pMetricsBase = BSDS500MetricsAccumulator::create(DATASETS_BSDS500_EVAL_DEFAULT_THRESH_BINS,m_eEvalMode);
+}
+
+void lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,lv::NonParallel>::setGTCacheDirPath(const std::string& sDirPath) {
+    m_sGTCacheDirPath = sDirPath.empty()?std::string():lv::AddDirSlashIfMissing(sDirPath);
+    if(!m_sGTCacheDirPath.empty())
+        lv::CreateDirIfNotExist(m_sGTCacheDirPath);
+}
+
+void lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,lv::NonParallel>::setEvalMode(BSDS500EvalMode eEvalMode) {
+    lvAssert_(eEvalMode==BSDS500EvalMode_Exact || eEvalMode==BSDS500EvalMode_Approx,"unknown BSDS500 eval mode");
+    m_eEvalMode = eEvalMode;
+    if(m_pMetricsBase)
+        m_pMetricsBase->m_eEvalMode = eEvalMode;
+}
+
+#if HAVE_GLSL
+
+lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,lv::GLSL>::~DataEvaluator_() {
+    try {
+        stopAsyncEvaluation();
+    }
+    catch(...) {} // destructors must not throw; errors should be caught via stopProcessing instead
+}
+
+lv::IMetricsAccumulatorConstPtr lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,lv::GLSL>::getMetricsBase() const {
+    if(isProcessing())
+        lvError("Must stop processing batch before querying metrics under async data evaluator interface");
+    else if(!m_pMetricsBase)
+        return BSDS500MetricsAccumulator::create(DATASETS_BSDS500_EVAL_DEFAULT_THRESH_BINS);
+    return m_pMetricsBase;
+}
+
+void lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,lv::GLSL>::resetMetrics() {
+    lvAssert_(!isProcessing(),"must stop processing batch before resetting metrics under async data evaluator interface");
+    m_pMetricsBase = BSDS500MetricsAccumulator::create(DATASETS_BSDS500_EVAL_DEFAULT_THRESH_BINS,m_eEvalMode);
+}
+
+void lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,lv::GLSL>::setEvalMode(BSDS500EvalMode eEvalMode) {
+    lvAssert_(eEvalMode==BSDS500EvalMode_Exact || eEvalMode==BSDS500EvalMode_Approx,"unknown BSDS500 eval mode");
+    lvAssert_(!isProcessing(),"must stop processing batch before changing eval mode under async data evaluator interface");
+    m_eEvalMode = eEvalMode;
+    if(m_pMetricsBase)
+        m_pMetricsBase->m_eEvalMode = eEvalMode;
+}
+
+void lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,lv::GLSL>::_stopProcessing() {
+    stopAsyncEvaluation();
 }
+
+void lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,lv::GLSL>::post_initialize_gl() {
+    IAsyncDataConsumer_<DatasetEval_BinaryClassifier,lv::GLSL>::post_initialize_gl();
+    if(getDatasetInfo()->isUsingEvaluator()) {
+        // there is no gpu implementation of the bsds500 matching step, so edge masks are read back and evaluated on the cpu worker, while
+        // the gpu keeps going with the next image (uploads/dispatches/readbacks already overlap via the last/curr/next packet buffers)
+        if(!m_pMetricsBase)
+            m_pMetricsBase = BSDS500MetricsAccumulator::create(DATASETS_BSDS500_EVAL_DEFAULT_THRESH_BINS,m_eEvalMode);
+        using namespace std::placeholders;
+        m_lDataCallback = std::bind(&DataEvaluator_<DatasetEval_BinaryClassifier,Dataset_BSDS500,lv::GLSL>::evaluationCallback,this,_1,_2,_3,_4,_5,_6);
+        m_pAlgo->setOutputFetching(true);
+    }
+}
+
+void lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,lv::GLSL>::evaluationCallback(const cv::Mat& /*oInput*/, const cv::Mat& /*oDebug*/, const cv::Mat& oOutput, const cv::Mat& oGT, const cv::Mat& oROI, size_t nIdx) {
+    lvAssert_(!oOutput.empty(),"provided output mat needs to be non-empty");
+    if(oGT.empty())
+        return;
+    std::mutex_unique_lock oLock(m_oAsyncEvalMutex);
+    if(!m_oAsyncEvalWorker.joinable()) {
+        m_bAsyncEvalActive = true;
+        m_oAsyncEvalWorker = std::thread(&DataEvaluator_::asyncEvaluationLoop,this);
+    }
+    m_oAsyncEvalCondVar.wait(oLock,[&]{return m_qoAsyncEvalTasks.size()<DATASETUTILS_ASYNC_EVAL_MAX_QUEUE_SIZE;});
+    if(m_pAsyncEvalException) {
+        std::exception_ptr pException = m_pAsyncEvalException;
+        m_pAsyncEvalException = nullptr;
+        std::rethrow_exception(pException);
+    }
+    // the output & last gt buffers are recycled by the async consumer on the next packet, so they must be copied; the roi is only referenced
+    m_qoAsyncEvalTasks.push_back(AsyncEvalTask{oOutput.clone(),oGT.clone(),oROI,nIdx});
+    m_oAsyncEvalCondVar.notify_all();
+}
+
+void lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,lv::GLSL>::stopAsyncEvaluation() {
+    {
+        std::mutex_lock_guard oLock(m_oAsyncEvalMutex);
+        if(!m_oAsyncEvalWorker.joinable())
+            return;
+        m_bAsyncEvalActive = false;
+        m_oAsyncEvalCondVar.notify_all();
+    }
+    m_oAsyncEvalWorker.join();
+    std::mutex_lock_guard oLock(m_oAsyncEvalMutex);
+    if(m_pAsyncEvalException) {
+        std::exception_ptr pException = m_pAsyncEvalException;
+        m_pAsyncEvalException = nullptr;
+        std::rethrow_exception(pException);
+    }
+}
+
+void lv::DataEvaluator_<lv::DatasetEval_BinaryClassifier,lv::Dataset_BSDS500,lv::GLSL>::asyncEvaluationLoop() {
+    std::mutex_unique_lock oLock(m_oAsyncEvalMutex);
+    while(true) {
+        m_oAsyncEvalCondVar.wait(oLock,[&]{return !m_qoAsyncEvalTasks.empty() || !m_bAsyncEvalActive;});
+        if(m_qoAsyncEvalTasks.empty())
+            break;
+        AsyncEvalTask oTask = std::move(m_qoAsyncEvalTasks.front());
+        m_qoAsyncEvalTasks.pop_front();
+        m_oAsyncEvalCondVar.notify_all();
+        oLock.unlock();
+        try {
+            m_pMetricsBase->accumulate(oTask.oOutput,getCachedGTData(m_mpGTDataCache,std::string(),oTask.nIdx,oTask.oGT,oTask.oOutput.size()));
+        }
+        catch(...) { // will be rethrown in the processing thread on the next sync point
+            oLock.lock();
+            m_pAsyncEvalException = std::current_exception();
+            oLock.unlock();
+        }
+        oLock.lock();
+    }
+}
+
+#endif //HAVE_GLSL
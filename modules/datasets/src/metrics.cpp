@@ -16,6 +16,141 @@
 // limitations under the License.
 
 #include "litiv/datasets/metrics.hpp"
+#include "litiv/utils/parallel.hpp"
+#include "metrics_kernels.hpp"
+
+// local define used to specify the minimum number of rows processed per band in the multi-threaded accumulation variant
+#define METRICS_MIN_BAND_ROWS (32)
+
+namespace {
+
+    using BinClassifCounters = std::array<uint64_t,lv::BinClassifMetricsAccumulator::nCountersCount>;
+
+    void validateBinClassifInputs(const cv::Mat& oClassif, const cv::Mat& oGT, const cv::Mat& oROI) {
+        lvAssert_(!oClassif.empty() && oClassif.type()==CV_8UC1,"binary classifier results must be non-empty and of type 8UC1");
+        lvAssert_(oGT.empty() || oGT.type()==CV_8UC1,"gt mat must be empty, or of type 8UC1")
+        lvAssert_(oROI.empty() || oROI.type()==CV_8UC1,"ROI mat must be empty, or of type 8UC1");
+        lvAssert_((oGT.empty() || oClassif.size()==oGT.size()) && (oROI.empty() || oClassif.size()==oROI.size()),"all input mat sizes must match");
+    }
+
+    /// returns the binary classification row kernel best suited for the current CPU
+    metrics_impl::BinClassifRowKernel getBinClassifRowKernel() {
+#if METRICS_KERNELS_X86
+        switch(lv::getSupportedSIMDInstrSet()) {
+            case lv::SIMD_AVX512BW:
+            case lv::SIMD_AVX2: return &metrics_impl::binClassifRow_AVX2;
+            case lv::SIMD_SSE4_1:
+            case lv::SIMD_SSE2: return &metrics_impl::binClassifRow_SSE2;
+            default: break;
+        }
+#elif METRICS_KERNELS_NEON
+        return &metrics_impl::binClassifRow_NEON;
+#endif //METRICS_KERNELS_NEON
+        return &metrics_impl::binClassifRow_Scalar;
+    }
+
+    /// returns the packed binary classification kernel best suited for the current CPU
+    metrics_impl::BinClassifPackedKernel getBinClassifPackedKernel() {
+#if METRICS_KERNELS_X86
+        switch(lv::getSupportedSIMDInstrSet()) {
+            case lv::SIMD_AVX512BW:
+            case lv::SIMD_AVX2: return &metrics_impl::binClassifPacked_AVX2;
+            case lv::SIMD_SSE4_1:
+            case lv::SIMD_SSE2: return &metrics_impl::binClassifPacked_SSE2;
+            default: break;
+        }
+#elif METRICS_KERNELS_NEON
+        return &metrics_impl::binClassifPacked_NEON;
+#endif //METRICS_KERNELS_NEON
+        return &metrics_impl::binClassifPacked_Scalar;
+    }
+
+    /// returns the gt label values used by the binary classification kernels
+    metrics_impl::BinClassifLabels getBinClassifLabels() {
+        static_assert(dATASETUTILS_NEGATIVE_VAL==0,"binary classification kernels assume that roi pixels are invalid when null");
+        return metrics_impl::BinClassifLabels{DATASETUTILS_POSITIVE_VAL,DATASETUTILS_OUTOFSCOPE_VAL,DATASETUTILS_UNKNOWN_VAL,DATASETUTILS_SHADOW_VAL};
+    }
+
+    /// accumulates binary classification counters over rows [nRowBegin,nRowEnd); pixels are valid if their gt is neither out-of-scope nor unknown, and if they lie in the ROI
+    void accumulateBinClassifRows(const cv::Mat& oClassif, const cv::Mat& oGT, const cv::Mat& oROI, int nRowBegin, int nRowEnd, BinClassifCounters& anCounters) {
+        using Accumulator = lv::BinClassifMetricsAccumulator;
+        static const metrics_impl::BinClassifRowKernel s_pKernel = getBinClassifRowKernel();
+        const metrics_impl::BinClassifLabels oLabels = getBinClassifLabels();
+        const bool bUsingROI = !oROI.empty();
+        const int nCols = oClassif.cols;
+        for(int nRowIdx=nRowBegin; nRowIdx<nRowEnd; ++nRowIdx) {
+            std::array<unsigned long long,metrics_impl::nKernelCountersCount> anRowCounters = {};
+            s_pKernel(oClassif.ptr<uchar>(nRowIdx),oGT.ptr<uchar>(nRowIdx),bUsingROI?oROI.ptr<uchar>(nRowIdx):nullptr,size_t(nCols),oLabels,anRowCounters.data());
+            const uint64_t nValid = anRowCounters[metrics_impl::KernelCounter_Valid];
+            anCounters[Accumulator::Counter_TP] += anRowCounters[metrics_impl::KernelCounter_TP];
+            anCounters[Accumulator::Counter_TN] += nValid-anRowCounters[metrics_impl::KernelCounter_TP]-anRowCounters[metrics_impl::KernelCounter_FP]-anRowCounters[metrics_impl::KernelCounter_FN];
+            anCounters[Accumulator::Counter_FP] += anRowCounters[metrics_impl::KernelCounter_FP];
+            anCounters[Accumulator::Counter_FN] += anRowCounters[metrics_impl::KernelCounter_FN];
+            anCounters[Accumulator::Counter_SE] += anRowCounters[metrics_impl::KernelCounter_SE];
+            anCounters[Accumulator::Counter_DC] += uint64_t(nCols)-nValid;
+        }
+    }
+
+    using ROCHistograms = std::array<std::array<uint32_t,UCHAR_MAX+1>,2>; // negative & positive confidence histograms (per band, so 32-bit bins suffice)
+
+    /// accumulates gt-negative & gt-positive confidence histograms over rows [nRowBegin,nRowEnd), returning the number of 'dont care' pixels; pixels are valid as in accumulateBinClassifRows
+    uint64_t accumulateROCRows(const cv::Mat& oConfidence, const cv::Mat& oGT, const cv::Mat& oROI, int nRowBegin, int nRowEnd, ROCHistograms& aanHists) {
+        const bool bUsingROI = !oROI.empty();
+        const int nCols = oConfidence.cols;
+        // scatter increments go through 4 interleaved sub-histograms, so that runs of identical values do not serialize on a single bin
+        std::array<ROCHistograms,4> aaanSubHists = {};
+        uint64_t nValid = 0;
+        for(int nRowIdx=nRowBegin; nRowIdx<nRowEnd; ++nRowIdx) {
+            const uchar* const anInput = oConfidence.ptr<uchar>(nRowIdx);
+            const uchar* const anGT = oGT.ptr<uchar>(nRowIdx);
+            const uchar* const anROI = bUsingROI?oROI.ptr<uchar>(nRowIdx):nullptr;
+            int nColIdx = 0;
+            // pixel labels (0=dont care, 1=negative, 2=positive) are computed 16 at a time, and only the scatter step is scalar
+#if HAVE_NEON || HAVE_SSE2
+            alignas(16) std::array<uchar,16> anLabels;
+            while(nColIdx+16<=nCols) {
+#if HAVE_NEON
+                const uint8x16_t anGTVals = vld1q_u8(anGT+nColIdx);
+                uint8x16_t anValid = vmvnq_u8(vorrq_u8(vceqq_u8(anGTVals,vdupq_n_u8(DATASETUTILS_OUTOFSCOPE_VAL)),vceqq_u8(anGTVals,vdupq_n_u8(DATASETUTILS_UNKNOWN_VAL))));
+                if(bUsingROI)
+                    anValid = vbicq_u8(anValid,vceqq_u8(vld1q_u8(anROI+nColIdx),vdupq_n_u8(0)));
+                const uint8x16_t anGTPos = vandq_u8(vceqq_u8(anGTVals,vdupq_n_u8(DATASETUTILS_POSITIVE_VAL)),anValid);
+                vst1q_u8(anLabels.data(),vsubq_u8(vsubq_u8(vdupq_n_u8(0),anValid),anGTPos)); // valid => 1, +1 if positive
+#else //HAVE_SSE2
+                const __m128i anGTVals = _mm_loadu_si128((const __m128i*)(anGT+nColIdx));
+                __m128i anValid = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi8(anGTVals,_mm_set1_epi8(char(DATASETUTILS_OUTOFSCOPE_VAL))),_mm_cmpeq_epi8(anGTVals,_mm_set1_epi8(char(DATASETUTILS_UNKNOWN_VAL)))),_mm_set1_epi8(char(-1)));
+                if(bUsingROI)
+                    anValid = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(anROI+nColIdx)),_mm_setzero_si128()),anValid);
+                const __m128i anGTPos = _mm_and_si128(_mm_cmpeq_epi8(anGTVals,_mm_set1_epi8(char(DATASETUTILS_POSITIVE_VAL))),anValid);
+                _mm_store_si128((__m128i*)anLabels.data(),_mm_sub_epi8(_mm_sub_epi8(_mm_setzero_si128(),anValid),anGTPos)); // valid => 1, +1 if positive
+#endif //HAVE_SSE2
+                for(int nOffset=0; nOffset<16; ++nOffset) {
+                    const uchar nLabel = anLabels[nOffset];
+                    if(nLabel) {
+                        ++aaanSubHists[nOffset&3][nLabel-1][anInput[nColIdx+nOffset]];
+                        ++nValid;
+                    }
+                }
+                nColIdx += 16;
+            }
+#endif //HAVE_NEON || HAVE_SSE2
+            for(; nColIdx<nCols; ++nColIdx) {
+                if(anGT[nColIdx]!=DATASETUTILS_OUTOFSCOPE_VAL &&
+                   anGT[nColIdx]!=DATASETUTILS_UNKNOWN_VAL &&
+                   (!bUsingROI || anROI[nColIdx]!=dATASETUTILS_NEGATIVE_VAL)) {
+                    ++aaanSubHists[nColIdx&3][anGT[nColIdx]==DATASETUTILS_POSITIVE_VAL][anInput[nColIdx]];
+                    ++nValid;
+                }
+            }
+        }
+        for(const ROCHistograms& aanSubHists : aaanSubHists)
+            for(size_t nHistIdx=0; nHistIdx<2; ++nHistIdx)
+                for(size_t nBinIdx=0; nBinIdx<=UCHAR_MAX; ++nBinIdx)
+                    aanHists[nHistIdx][nBinIdx] += aanSubHists[nHistIdx][nBinIdx];
+        return uint64_t(nRowEnd-nRowBegin)*uint64_t(nCols)-nValid;
+    }
+
+} // namespace
 
 bool lv::IMetricsAccumulator::operator!=(const IMetricsAccumulator& m) const {
     return !isEqual(m.shared_from_this());
@@ -54,7 +189,44 @@ lv::IMetricsAccumulatorPtr lv::MetricsAccumulator_<lv::DatasetEval_BinaryClassif
 }
 
 void lv::MetricsAccumulator_<lv::DatasetEval_BinaryClassifier>::accumulate(const cv::Mat& oClassif, const cv::Mat& oGT, const cv::Mat& oROI) {
-    lvAssert_(!oClassif.empty() && oClassif.type()==CV_8UC1,"binary classifier results must be non-empty and of type 8UC1");
+    validateBinClassifInputs(oClassif,oGT,oROI);
+    if(oGT.empty()) {
+        nDC += oClassif.size().area();
+        return;
+    }
+    BinClassifCounters anCounters = {};
+    accumulateBinClassifRows(oClassif,oGT,oROI,0,oClassif.rows,anCounters);
+    nTP += anCounters[Counter_TP];
+    nTN += anCounters[Counter_TN];
+    nFP += anCounters[Counter_FP];
+    nFN += anCounters[Counter_FN];
+    nSE += anCounters[Counter_SE];
+    nDC += anCounters[Counter_DC];
+}
+
+void lv::MetricsAccumulator_<lv::DatasetEval_BinaryClassifier>::accumulate(const cv::Mat& oClassif, const cv::Mat& oGT, const cv::Mat& oROI, ThreadPool& oThreadPool) {
+    validateBinClassifInputs(oClassif,oGT,oROI);
+    if(oGT.empty()) {
+        nDC += oClassif.size().area();
+        return;
+    }
+    const int nBands = std::max(std::min(int(oThreadPool.getThreadCount()*2),oClassif.rows/METRICS_MIN_BAND_ROWS),1);
+    std::vector<BinClassifCounters> vanBandCounters(nBands,BinClassifCounters{});
+    oThreadPool.parallel_for(size_t(nBands),[&](size_t nBandIdx) {
+        accumulateBinClassifRows(oClassif,oGT,oROI,int(oClassif.rows*nBandIdx/nBands),int(oClassif.rows*(nBandIdx+1)/nBands),vanBandCounters[nBandIdx]);
+    });
+    for(const BinClassifCounters& anCounters : vanBandCounters) {
+        nTP += anCounters[Counter_TP];
+        nTN += anCounters[Counter_TN];
+        nFP += anCounters[Counter_FP];
+        nFN += anCounters[Counter_FN];
+        nSE += anCounters[Counter_SE];
+        nDC += anCounters[Counter_DC];
+    }
+}
+
+void lv::MetricsAccumulator_<lv::DatasetEval_BinaryClassifier>::accumulate(const PackedBinaryMask& oClassif, const cv::Mat& oGT, const cv::Mat& oROI) {
+    lvAssert_(!oClassif.empty(),"binary classifier results must be non-empty");
     lvAssert_(oGT.empty() || oGT.type()==CV_8UC1,"gt mat must be empty, or of type 8UC1")
     lvAssert_(oROI.empty() || oROI.type()==CV_8UC1,"ROI mat must be empty, or of type 8UC1");
     lvAssert_((oGT.empty() || oClassif.size()==oGT.size()) && (oROI.empty() || oClassif.size()==oROI.size()),"all input mat sizes must match");
@@ -62,37 +234,23 @@ void lv::MetricsAccumulator_<lv::DatasetEval_BinaryClassifier>::accumulate(const
         nDC += oClassif.size().area();
         return;
     }
-    const size_t step_row = oClassif.step.p[0];
-    for(size_t i = 0; i<(size_t)oClassif.rows; ++i) {
-        const size_t idx_nstep = step_row*i;
-        const uchar* input_step_ptr = oClassif.data+idx_nstep;
-        const uchar* gt_step_ptr = oGT.data+idx_nstep;
-        const uchar* roi_step_ptr = oROI.data+idx_nstep;
-        for(int j = 0; j<oClassif.cols; ++j) {
-            if(gt_step_ptr[j]!=DATASETUTILS_OUTOFSCOPE_VAL &&
-               gt_step_ptr[j]!=DATASETUTILS_UNKNOWN_VAL &&
-               (oROI.empty() || roi_step_ptr[j]!=dATASETUTILS_NEGATIVE_VAL)) {
-                if(input_step_ptr[j]==DATASETUTILS_POSITIVE_VAL) {
-                    if(gt_step_ptr[j]==DATASETUTILS_POSITIVE_VAL)
-                        ++nTP;
-                    else // gt_step_ptr[j]==s_nSegmNegative
-                        ++nFP;
-                }
-                else { // input_step_ptr[j]==s_nSegmNegative
-                    if(gt_step_ptr[j]==DATASETUTILS_POSITIVE_VAL)
-                        ++nFN;
-                    else // gt_step_ptr[j]==s_nSegmNegative
-                        ++nTN;
-                }
-                if(gt_step_ptr[j]==DATASETUTILS_SHADOW_VAL) {
-                    if(input_step_ptr[j]==DATASETUTILS_POSITIVE_VAL)
-                        ++nSE;
-                }
-            }
-            else
-                ++nDC;
-        }
-    }
+    // packed pixels are addressed in raster order without row padding, so gt & roi must be continuous as well
+    const cv::Mat oContGT = oGT.isContinuous()?oGT:oGT.clone();
+    const cv::Mat oContROI = (oROI.empty() || oROI.isContinuous())?oROI:oROI.clone();
+    const size_t nTotPxCount = size_t(oClassif.size().area());
+    static_assert(sizeof(uint64_t)==sizeof(unsigned long long),"bad kernel type assumptions");
+    static const metrics_impl::BinClassifPackedKernel s_pKernel = getBinClassifPackedKernel();
+    std::array<unsigned long long,metrics_impl::nKernelCountersCount> anCounters = {};
+    s_pKernel((const unsigned long long*)oClassif.words(),oContGT.data,oContROI.empty()?nullptr:oContROI.data,nTotPxCount,getBinClassifLabels(),anCounters.data());
+    const uint64_t nValid = anCounters[metrics_impl::KernelCounter_Valid];
+    const uint64_t nCurrTP = anCounters[metrics_impl::KernelCounter_TP], nCurrFP = anCounters[metrics_impl::KernelCounter_FP];
+    const uint64_t nCurrFN = anCounters[metrics_impl::KernelCounter_FN], nCurrSE = anCounters[metrics_impl::KernelCounter_SE];
+    nTP += nCurrTP;
+    nTN += nValid-nCurrTP-nCurrFP-nCurrFN;
+    nFP += nCurrFP;
+    nFN += nCurrFN;
+    nSE += nCurrSE;
+    nDC += uint64_t(nTotPxCount)-nValid;
 }
 
 cv::Mat lv::MetricsAccumulator_<lv::DatasetEval_BinaryClassifier>::getColoredMask(const cv::Mat& oClassif, const cv::Mat& oGT, const cv::Mat& oROI) {
@@ -208,3 +366,142 @@ lv::MetricsCalculator_<lv::DatasetEval_BinaryClassifier>::MetricsCalculator_(con
     dFMeasure = CalcFMeasure(m3);
     dMCC = CalcMatthewsCorrCoeff(m3);
 }
+
+bool lv::BinClassifROCAccumulator::isEqual(const IMetricsAccumulatorConstPtr& m) const {
+    const auto& m2 = dynamic_cast<const BinClassifROCAccumulator&>(*m.get());
+    return
+        (this->anPosHist==m2.anPosHist) &&
+        (this->anNegHist==m2.anNegHist);
+}
+
+lv::IMetricsAccumulatorPtr lv::BinClassifROCAccumulator::accumulate(const IMetricsAccumulatorConstPtr& m) {
+    const auto& m2 = dynamic_cast<const BinClassifROCAccumulator&>(*m.get());
+    for(size_t nBinIdx=0; nBinIdx<=UCHAR_MAX; ++nBinIdx) {
+        this->anPosHist[nBinIdx] += m2.anPosHist[nBinIdx];
+        this->anNegHist[nBinIdx] += m2.anNegHist[nBinIdx];
+    }
+    this->nDC += m2.nDC;
+    return shared_from_this();
+}
+
+void lv::BinClassifROCAccumulator::accumulate(const cv::Mat& oConfidence, const cv::Mat& oGT, const cv::Mat& oROI) {
+    validateBinClassifInputs(oConfidence,oGT,oROI);
+    if(oGT.empty()) {
+        nDC += oConfidence.size().area();
+        return;
+    }
+    ROCHistograms aanHists = {};
+    nDC += accumulateROCRows(oConfidence,oGT,oROI,0,oConfidence.rows,aanHists);
+    for(size_t nBinIdx=0; nBinIdx<=UCHAR_MAX; ++nBinIdx) {
+        anNegHist[nBinIdx] += aanHists[0][nBinIdx];
+        anPosHist[nBinIdx] += aanHists[1][nBinIdx];
+    }
+}
+
+void lv::BinClassifROCAccumulator::accumulate(const cv::Mat& oConfidence, const cv::Mat& oGT, const cv::Mat& oROI, ThreadPool& oThreadPool) {
+    validateBinClassifInputs(oConfidence,oGT,oROI);
+    if(oGT.empty()) {
+        nDC += oConfidence.size().area();
+        return;
+    }
+    const int nBands = std::max(std::min(int(oThreadPool.getThreadCount()*2),oConfidence.rows/METRICS_MIN_BAND_ROWS),1);
+    std::vector<ROCHistograms> vaanBandHists(nBands,ROCHistograms{});
+    std::vector<uint64_t> vnBandDC(nBands,0);
+    oThreadPool.parallel_for(size_t(nBands),[&](size_t nBandIdx) {
+        vnBandDC[nBandIdx] = accumulateROCRows(oConfidence,oGT,oROI,int(oConfidence.rows*nBandIdx/nBands),int(oConfidence.rows*(nBandIdx+1)/nBands),vaanBandHists[nBandIdx]);
+    });
+    for(int nBandIdx=0; nBandIdx<nBands; ++nBandIdx) {
+        for(size_t nBinIdx=0; nBinIdx<=UCHAR_MAX; ++nBinIdx) {
+            anNegHist[nBinIdx] += vaanBandHists[nBandIdx][0][nBinIdx];
+            anPosHist[nBinIdx] += vaanBandHists[nBandIdx][1][nBinIdx];
+        }
+        nDC += vnBandDC[nBandIdx];
+    }
+}
+
+lv::BinClassifMetricsAccumulatorPtr lv::BinClassifROCAccumulator::getCounters(size_t nThreshold) const {
+    lvAssert_(nThreshold<=UCHAR_MAX+1,"threshold out of range");
+    BinClassifMetricsAccumulatorPtr pCounters = BinClassifMetricsAccumulator::create();
+    for(size_t nBinIdx=0; nBinIdx<=UCHAR_MAX; ++nBinIdx) {
+        if(nBinIdx>=nThreshold) {
+            pCounters->nTP += anPosHist[nBinIdx];
+            pCounters->nFP += anNegHist[nBinIdx];
+        }
+        else {
+            pCounters->nFN += anPosHist[nBinIdx];
+            pCounters->nTN += anNegHist[nBinIdx];
+        }
+    }
+    pCounters->nDC = nDC;
+    return pCounters;
+}
+
+lv::BinClassifROCAccumulatorPtr lv::BinClassifROCAccumulator::create() {
+    struct MetricsAccumulatorWrapper : public BinClassifROCAccumulator {
+        MetricsAccumulatorWrapper() : BinClassifROCAccumulator() {} // cant do 'using BaseCstr::BaseCstr;' since it keeps the access level
+    };
+    return std::make_shared<MetricsAccumulatorWrapper>();
+}
+
+lv::BinClassifROCAccumulator::BinClassifROCAccumulator() : nDC(0) {
+    anPosHist.fill(0);
+    anNegHist.fill(0);
+}
+
+lv::IMetricsCalculatorPtr lv::BinClassifROCCalculator::accumulate(const IMetricsCalculatorConstPtr& m) {
+    const auto& m2 = dynamic_cast<const BinClassifROCCalculator&>(*m.get());
+    const size_t nTotWeight = this->nWeight+m2.nWeight;
+    for(size_t nThreshold=0; nThreshold<vdRecall.size(); ++nThreshold) {
+        this->vdRecall[nThreshold] = (m2.vdRecall[nThreshold]*m2.nWeight + this->vdRecall[nThreshold]*this->nWeight)/nTotWeight;
+        this->vdFPR[nThreshold] = (m2.vdFPR[nThreshold]*m2.nWeight + this->vdFPR[nThreshold]*this->nWeight)/nTotWeight;
+        this->vdPrecision[nThreshold] = (m2.vdPrecision[nThreshold]*m2.nWeight + this->vdPrecision[nThreshold]*this->nWeight)/nTotWeight;
+    }
+    this->dAUC = (m2.dAUC*m2.nWeight + this->dAUC*this->nWeight)/nTotWeight;
+    this->nWeight = nTotWeight;
+    updateBestFMeasure();
+    return shared_from_this();
+}
+
+lv::BinClassifROCCalculatorPtr lv::BinClassifROCCalculator::create(const IMetricsAccumulatorConstPtr& m) {
+    struct MetricsCalculatorWrapper : public BinClassifROCCalculator {
+        MetricsCalculatorWrapper(const IMetricsAccumulatorConstPtr& m2) : BinClassifROCCalculator(m2) {} // cant do 'using BaseCstr::BaseCstr;' since it keeps the access level
+    };
+    return std::make_shared<MetricsCalculatorWrapper>(m);
+}
+
+lv::BinClassifROCCalculator::BinClassifROCCalculator(const IMetricsAccumulatorConstPtr& m) :
+        vdRecall(UCHAR_MAX+2),vdFPR(UCHAR_MAX+2),vdPrecision(UCHAR_MAX+2) {
+    lvAssert_(m.get(),"bad input pointer");
+    const auto& m2 = std::dynamic_pointer_cast<const BinClassifROCAccumulator>(m);
+    lvAssert_(m2.get(),"input metrics accumulator did not possess a BinClassifROCAccumulator interface");
+    const BinClassifROCAccumulator& m3 = *m2.get();
+    const uint64_t nTotPos = std::accumulate(m3.anPosHist.begin(),m3.anPosHist.end(),uint64_t(0));
+    const uint64_t nTotNeg = std::accumulate(m3.anNegHist.begin(),m3.anNegHist.end(),uint64_t(0));
+    // counters at each threshold are the cumulative sums of the histograms, from the highest confidence bin down
+    uint64_t nTP = 0, nFP = 0;
+    dAUC = 0.0;
+    for(size_t nThreshold=UCHAR_MAX+1; nThreshold-->0;) {
+        const double dPrevRecall = BinClassifMetricsCalculator::CalcRecall(nTP,nTotPos), dPrevFPR = nTotNeg>0?((double)nFP/nTotNeg):0;
+        if(nThreshold<=UCHAR_MAX) {
+            nTP += m3.anPosHist[nThreshold];
+            nFP += m3.anNegHist[nThreshold];
+        }
+        vdRecall[nThreshold] = BinClassifMetricsCalculator::CalcRecall(nTP,nTotPos);
+        vdFPR[nThreshold] = nTotNeg>0?((double)nFP/nTotNeg):0;
+        vdPrecision[nThreshold] = (nTP+nFP)>0?BinClassifMetricsCalculator::CalcPrecision(nTP,nTP+nFP):1.0; // no positive prediction = no false alarm
+        dAUC += (vdFPR[nThreshold]-dPrevFPR)*(vdRecall[nThreshold]+dPrevRecall)/2;
+    }
+    updateBestFMeasure();
+}
+
+void lv::BinClassifROCCalculator::updateBestFMeasure() {
+    dBestFMeasure = 0.0;
+    nBestThreshold = 0;
+    for(size_t nThreshold=0; nThreshold<vdRecall.size(); ++nThreshold) {
+        const double dFMeasure = BinClassifMetricsCalculator::CalcFMeasure(vdRecall[nThreshold],vdPrecision[nThreshold]);
+        if(dFMeasure>dBestFMeasure) {
+            dBestFMeasure = dFMeasure;
+            nBestThreshold = nThreshold;
+        }
+    }
+}
@@ -0,0 +1,254 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "metrics_kernels.hpp"
+
+using namespace metrics_impl;
+
+namespace {
+
+    inline unsigned long long popcount64_Scalar(unsigned long long nBits) {
+        nBits = nBits-((nBits>>1)&0x5555555555555555ull);
+        nBits = (nBits&0x3333333333333333ull)+((nBits>>2)&0x3333333333333333ull);
+        nBits = (nBits+(nBits>>4))&0x0F0F0F0F0F0F0F0Full;
+        return (nBits*0x0101010101010101ull)>>56;
+    }
+
+    /// ors the validity, gt-positive & gt-shadow bits of pixels [nPxBegin,nPxEnd) into the given words (pixel indices are word-relative)
+    inline void packBinClassifWords_Scalar(const unsigned char* anGT, const unsigned char* anROI, size_t nPxBegin, size_t nPxEnd, const BinClassifLabels& oLabels,
+                                           unsigned long long& nValidWord, unsigned long long& nGTPosWord, unsigned long long& nGTShadowWord) {
+        for(size_t nPxIdx=nPxBegin; nPxIdx<nPxEnd; ++nPxIdx) {
+            const bool bValid = anGT[nPxIdx]!=oLabels.nOutOfScope && anGT[nPxIdx]!=oLabels.nUnknown && (!anROI || anROI[nPxIdx]!=0);
+            nValidWord |= (unsigned long long)bValid<<nPxIdx;
+            nGTPosWord |= (unsigned long long)(anGT[nPxIdx]==oLabels.nPositive)<<nPxIdx;
+            nGTShadowWord |= (unsigned long long)(anGT[nPxIdx]==oLabels.nShadow)<<nPxIdx;
+        }
+    }
+
+    inline void countPackedWord_Scalar(unsigned long long nInputWord, unsigned long long nValidWord, unsigned long long nGTPosWord, unsigned long long nGTShadowWord, unsigned long long* anCounters) {
+        const unsigned long long nInputPosWord = nInputWord&nValidWord;
+        anCounters[KernelCounter_Valid] += popcount64_Scalar(nValidWord);
+        anCounters[KernelCounter_TP] += popcount64_Scalar(nInputPosWord&nGTPosWord);
+        anCounters[KernelCounter_FP] += popcount64_Scalar(nInputPosWord&~nGTPosWord);
+        anCounters[KernelCounter_FN] += popcount64_Scalar(nGTPosWord&nValidWord&~nInputPosWord);
+        anCounters[KernelCounter_SE] += popcount64_Scalar(nInputPosWord&nGTShadowWord);
+    }
+
+#if METRICS_KERNELS_X86 && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2))
+    inline unsigned long long hsum8_SSE2(const __m128i& vnAcc) {
+        const __m128i vnSums = _mm_sad_epu8(vnAcc,_mm_setzero_si128());
+        return (unsigned long long)(_mm_cvtsi128_si32(vnSums)+_mm_cvtsi128_si32(_mm_srli_si128(vnSums,8)));
+    }
+
+    inline size_t binClassifRow_SSE2_impl(const unsigned char* anInput, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters) {
+        const __m128i vnPositiveVal = _mm_set1_epi8((char)oLabels.nPositive), vnOutOfScopeVal = _mm_set1_epi8((char)oLabels.nOutOfScope);
+        const __m128i vnUnknownVal = _mm_set1_epi8((char)oLabels.nUnknown), vnShadowVal = _mm_set1_epi8((char)oLabels.nShadow);
+        const __m128i vnZero = _mm_setzero_si128(), vnOnes = _mm_set1_epi8((char)-1);
+        // compare masks (all-ones bytes) are subtracted from per-byte counters, which are flushed via horizontal sums before they can overflow
+        size_t nPxIdx = 0;
+        while(nPxIdx+16<=nPx) {
+            __m128i vnValidAcc = vnZero, vnTPAcc = vnZero, vnFPAcc = vnZero, vnFNAcc = vnZero, vnSEAcc = vnZero;
+            for(size_t nBlockIdx=0; nBlockIdx<255 && nPxIdx+16<=nPx; ++nBlockIdx, nPxIdx+=16) {
+                const __m128i vnInputVals = _mm_loadu_si128((const __m128i*)(anInput+nPxIdx));
+                const __m128i vnGTVals = _mm_loadu_si128((const __m128i*)(anGT+nPxIdx));
+                __m128i vbValid = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi8(vnGTVals,vnOutOfScopeVal),_mm_cmpeq_epi8(vnGTVals,vnUnknownVal)),vnOnes);
+                if(anROI)
+                    vbValid = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(anROI+nPxIdx)),vnZero),vbValid);
+                const __m128i vbInputPos = _mm_and_si128(_mm_cmpeq_epi8(vnInputVals,vnPositiveVal),vbValid);
+                const __m128i vbGTPos = _mm_cmpeq_epi8(vnGTVals,vnPositiveVal);
+                vnValidAcc = _mm_sub_epi8(vnValidAcc,vbValid);
+                vnTPAcc = _mm_sub_epi8(vnTPAcc,_mm_and_si128(vbInputPos,vbGTPos));
+                vnFPAcc = _mm_sub_epi8(vnFPAcc,_mm_andnot_si128(vbGTPos,vbInputPos));
+                vnFNAcc = _mm_sub_epi8(vnFNAcc,_mm_andnot_si128(vbInputPos,_mm_and_si128(vbGTPos,vbValid)));
+                vnSEAcc = _mm_sub_epi8(vnSEAcc,_mm_and_si128(vbInputPos,_mm_cmpeq_epi8(vnGTVals,vnShadowVal)));
+            }
+            anCounters[KernelCounter_Valid] += hsum8_SSE2(vnValidAcc);
+            anCounters[KernelCounter_TP] += hsum8_SSE2(vnTPAcc);
+            anCounters[KernelCounter_FP] += hsum8_SSE2(vnFPAcc);
+            anCounters[KernelCounter_FN] += hsum8_SSE2(vnFNAcc);
+            anCounters[KernelCounter_SE] += hsum8_SSE2(vnSEAcc);
+        }
+        return nPxIdx;
+    }
+
+    inline size_t packBinClassifWords_SSE2_impl(const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels,
+                                                unsigned long long& nValidWord, unsigned long long& nGTPosWord, unsigned long long& nGTShadowWord) {
+        size_t nPxIdx = 0;
+        for(; nPxIdx+16<=nPx; nPxIdx+=16) {
+            const __m128i vnGTVals = _mm_loadu_si128((const __m128i*)(anGT+nPxIdx));
+            __m128i vbInvalid = _mm_or_si128(_mm_cmpeq_epi8(vnGTVals,_mm_set1_epi8((char)oLabels.nOutOfScope)),_mm_cmpeq_epi8(vnGTVals,_mm_set1_epi8((char)oLabels.nUnknown)));
+            if(anROI)
+                vbInvalid = _mm_or_si128(vbInvalid,_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(anROI+nPxIdx)),_mm_setzero_si128()));
+            nValidWord |= (unsigned long long)((~_mm_movemask_epi8(vbInvalid))&0xFFFF)<<nPxIdx;
+            nGTPosWord |= (unsigned long long)_mm_movemask_epi8(_mm_cmpeq_epi8(vnGTVals,_mm_set1_epi8((char)oLabels.nPositive)))<<nPxIdx;
+            nGTShadowWord |= (unsigned long long)_mm_movemask_epi8(_mm_cmpeq_epi8(vnGTVals,_mm_set1_epi8((char)oLabels.nShadow)))<<nPxIdx;
+        }
+        return nPxIdx;
+    }
+#define METRICS_KERNELS_SSE2 1
+#endif //METRICS_KERNELS_X86 && __SSE2__
+
+#if METRICS_KERNELS_NEON
+    inline unsigned long long hsum8_NEON(const uint8x16_t& vnAcc) {
+        const uint64x2_t vnSums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vnAcc)));
+        return (unsigned long long)(vgetq_lane_u64(vnSums,0)+vgetq_lane_u64(vnSums,1));
+    }
+
+    /// returns the 16-bit mask of all-ones bytes in a byte-wide compare result (equivalent of SSE2's movemask)
+    inline unsigned long long movemask8_NEON(const uint8x16_t& vbVals) {
+        static const unsigned char s_anBitWeights[16] = {1,2,4,8,16,32,64,128,1,2,4,8,16,32,64,128};
+        const uint8x16_t vnBits = vandq_u8(vbVals,vld1q_u8(s_anBitWeights));
+        uint8x8_t vnSums = vpadd_u8(vget_low_u8(vnBits),vget_high_u8(vnBits));
+        vnSums = vpadd_u8(vnSums,vnSums);
+        vnSums = vpadd_u8(vnSums,vnSums);
+        return (unsigned long long)vget_lane_u16(vreinterpret_u16_u8(vnSums),0);
+    }
+
+    inline unsigned long long popcount64_NEON(unsigned long long nBits) {
+        return (unsigned long long)vget_lane_u64(vpaddl_u32(vpaddl_u16(vpaddl_u8(vcnt_u8(vcreate_u8(nBits))))),0);
+    }
+
+    inline size_t binClassifRow_NEON_impl(const unsigned char* anInput, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters) {
+        const uint8x16_t vnPositiveVal = vdupq_n_u8(oLabels.nPositive), vnOutOfScopeVal = vdupq_n_u8(oLabels.nOutOfScope);
+        const uint8x16_t vnUnknownVal = vdupq_n_u8(oLabels.nUnknown), vnShadowVal = vdupq_n_u8(oLabels.nShadow), vnZero = vdupq_n_u8(0);
+        size_t nPxIdx = 0;
+        while(nPxIdx+16<=nPx) {
+            uint8x16_t vnValidAcc = vnZero, vnTPAcc = vnZero, vnFPAcc = vnZero, vnFNAcc = vnZero, vnSEAcc = vnZero;
+            for(size_t nBlockIdx=0; nBlockIdx<255 && nPxIdx+16<=nPx; ++nBlockIdx, nPxIdx+=16) {
+                const uint8x16_t vnInputVals = vld1q_u8(anInput+nPxIdx);
+                const uint8x16_t vnGTVals = vld1q_u8(anGT+nPxIdx);
+                uint8x16_t vbValid = vmvnq_u8(vorrq_u8(vceqq_u8(vnGTVals,vnOutOfScopeVal),vceqq_u8(vnGTVals,vnUnknownVal)));
+                if(anROI)
+                    vbValid = vbicq_u8(vbValid,vceqq_u8(vld1q_u8(anROI+nPxIdx),vnZero));
+                const uint8x16_t vbInputPos = vandq_u8(vceqq_u8(vnInputVals,vnPositiveVal),vbValid);
+                const uint8x16_t vbGTPos = vceqq_u8(vnGTVals,vnPositiveVal);
+                vnValidAcc = vsubq_u8(vnValidAcc,vbValid);
+                vnTPAcc = vsubq_u8(vnTPAcc,vandq_u8(vbInputPos,vbGTPos));
+                vnFPAcc = vsubq_u8(vnFPAcc,vbicq_u8(vbInputPos,vbGTPos));
+                vnFNAcc = vsubq_u8(vnFNAcc,vbicq_u8(vandq_u8(vbGTPos,vbValid),vbInputPos));
+                vnSEAcc = vsubq_u8(vnSEAcc,vandq_u8(vbInputPos,vceqq_u8(vnGTVals,vnShadowVal)));
+            }
+            anCounters[KernelCounter_Valid] += hsum8_NEON(vnValidAcc);
+            anCounters[KernelCounter_TP] += hsum8_NEON(vnTPAcc);
+            anCounters[KernelCounter_FP] += hsum8_NEON(vnFPAcc);
+            anCounters[KernelCounter_FN] += hsum8_NEON(vnFNAcc);
+            anCounters[KernelCounter_SE] += hsum8_NEON(vnSEAcc);
+        }
+        return nPxIdx;
+    }
+
+    inline size_t packBinClassifWords_NEON_impl(const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels,
+                                                unsigned long long& nValidWord, unsigned long long& nGTPosWord, unsigned long long& nGTShadowWord) {
+        size_t nPxIdx = 0;
+        for(; nPxIdx+16<=nPx; nPxIdx+=16) {
+            const uint8x16_t vnGTVals = vld1q_u8(anGT+nPxIdx);
+            uint8x16_t vbInvalid = vorrq_u8(vceqq_u8(vnGTVals,vdupq_n_u8(oLabels.nOutOfScope)),vceqq_u8(vnGTVals,vdupq_n_u8(oLabels.nUnknown)));
+            if(anROI)
+                vbInvalid = vorrq_u8(vbInvalid,vceqq_u8(vld1q_u8(anROI+nPxIdx),vdupq_n_u8(0)));
+            nValidWord |= ((~movemask8_NEON(vbInvalid))&0xFFFF)<<nPxIdx;
+            nGTPosWord |= movemask8_NEON(vceqq_u8(vnGTVals,vdupq_n_u8(oLabels.nPositive)))<<nPxIdx;
+            nGTShadowWord |= movemask8_NEON(vceqq_u8(vnGTVals,vdupq_n_u8(oLabels.nShadow)))<<nPxIdx;
+        }
+        return nPxIdx;
+    }
+
+    inline void countPackedWord_NEON(unsigned long long nInputWord, unsigned long long nValidWord, unsigned long long nGTPosWord, unsigned long long nGTShadowWord, unsigned long long* anCounters) {
+        const unsigned long long nInputPosWord = nInputWord&nValidWord;
+        anCounters[KernelCounter_Valid] += popcount64_NEON(nValidWord);
+        anCounters[KernelCounter_TP] += popcount64_NEON(nInputPosWord&nGTPosWord);
+        anCounters[KernelCounter_FP] += popcount64_NEON(nInputPosWord&~nGTPosWord);
+        anCounters[KernelCounter_FN] += popcount64_NEON(nGTPosWord&nValidWord&~nInputPosWord);
+        anCounters[KernelCounter_SE] += popcount64_NEON(nInputPosWord&nGTShadowWord);
+    }
+#endif //METRICS_KERNELS_NEON
+
+} // namespace
+
+void metrics_impl::binClassifRow_Scalar(const unsigned char* anInput, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters) {
+    for(size_t nPxIdx=0; nPxIdx<nPx; ++nPxIdx) {
+        if(anGT[nPxIdx]!=oLabels.nOutOfScope && anGT[nPxIdx]!=oLabels.nUnknown && (!anROI || anROI[nPxIdx]!=0)) {
+            ++anCounters[KernelCounter_Valid];
+            if(anInput[nPxIdx]==oLabels.nPositive) {
+                if(anGT[nPxIdx]==oLabels.nPositive)
+                    ++anCounters[KernelCounter_TP];
+                else
+                    ++anCounters[KernelCounter_FP];
+                if(anGT[nPxIdx]==oLabels.nShadow)
+                    ++anCounters[KernelCounter_SE];
+            }
+            else if(anGT[nPxIdx]==oLabels.nPositive)
+                ++anCounters[KernelCounter_FN];
+        }
+    }
+}
+
+void metrics_impl::binClassifPacked_Scalar(const unsigned long long* anInputWords, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters) {
+    for(size_t nPxOffset=0; nPxOffset<nPx; nPxOffset+=64) {
+        const size_t nWordPx = (nPx-nPxOffset)<64?(nPx-nPxOffset):64;
+        unsigned long long nValidWord = 0, nGTPosWord = 0, nGTShadowWord = 0;
+        packBinClassifWords_Scalar(anGT+nPxOffset,anROI?anROI+nPxOffset:nullptr,0,nWordPx,oLabels,nValidWord,nGTPosWord,nGTShadowWord);
+        countPackedWord_Scalar(anInputWords[nPxOffset/64],nValidWord,nGTPosWord,nGTShadowWord,anCounters);
+    }
+}
+
+void metrics_impl::binClassifRow_SSE2(const unsigned char* anInput, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters) {
+#if METRICS_KERNELS_SSE2
+    const size_t nDone = binClassifRow_SSE2_impl(anInput,anGT,anROI,nPx,oLabels,anCounters);
+    binClassifRow_Scalar(anInput+nDone,anGT+nDone,anROI?anROI+nDone:nullptr,nPx-nDone,oLabels,anCounters);
+#else //(!METRICS_KERNELS_SSE2)
+    binClassifRow_Scalar(anInput,anGT,anROI,nPx,oLabels,anCounters);
+#endif //(!METRICS_KERNELS_SSE2)
+}
+
+void metrics_impl::binClassifPacked_SSE2(const unsigned long long* anInputWords, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters) {
+#if METRICS_KERNELS_SSE2
+    for(size_t nPxOffset=0; nPxOffset<nPx; nPxOffset+=64) {
+        const size_t nWordPx = (nPx-nPxOffset)<64?(nPx-nPxOffset):64;
+        const unsigned char* const anWordROI = anROI?anROI+nPxOffset:nullptr;
+        unsigned long long nValidWord = 0, nGTPosWord = 0, nGTShadowWord = 0;
+        const size_t nDone = packBinClassifWords_SSE2_impl(anGT+nPxOffset,anWordROI,nWordPx,oLabels,nValidWord,nGTPosWord,nGTShadowWord);
+        packBinClassifWords_Scalar(anGT+nPxOffset,anWordROI,nDone,nWordPx,oLabels,nValidWord,nGTPosWord,nGTShadowWord);
+        countPackedWord_Scalar(anInputWords[nPxOffset/64],nValidWord,nGTPosWord,nGTShadowWord,anCounters);
+    }
+#else //(!METRICS_KERNELS_SSE2)
+    binClassifPacked_Scalar(anInputWords,anGT,anROI,nPx,oLabels,anCounters);
+#endif //(!METRICS_KERNELS_SSE2)
+}
+
+void metrics_impl::binClassifRow_NEON(const unsigned char* anInput, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters) {
+#if METRICS_KERNELS_NEON
+    const size_t nDone = binClassifRow_NEON_impl(anInput,anGT,anROI,nPx,oLabels,anCounters);
+    binClassifRow_Scalar(anInput+nDone,anGT+nDone,anROI?anROI+nDone:nullptr,nPx-nDone,oLabels,anCounters);
+#else //(!METRICS_KERNELS_NEON)
+    binClassifRow_Scalar(anInput,anGT,anROI,nPx,oLabels,anCounters);
+#endif //(!METRICS_KERNELS_NEON)
+}
+
+void metrics_impl::binClassifPacked_NEON(const unsigned long long* anInputWords, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters) {
+#if METRICS_KERNELS_NEON
+    for(size_t nPxOffset=0; nPxOffset<nPx; nPxOffset+=64) {
+        const size_t nWordPx = (nPx-nPxOffset)<64?(nPx-nPxOffset):64;
+        const unsigned char* const anWordROI = anROI?anROI+nPxOffset:nullptr;
+        unsigned long long nValidWord = 0, nGTPosWord = 0, nGTShadowWord = 0;
+        const size_t nDone = packBinClassifWords_NEON_impl(anGT+nPxOffset,anWordROI,nWordPx,oLabels,nValidWord,nGTPosWord,nGTShadowWord);
+        packBinClassifWords_Scalar(anGT+nPxOffset,anWordROI,nDone,nWordPx,oLabels,nValidWord,nGTPosWord,nGTShadowWord);
+        countPackedWord_NEON(anInputWords[nPxOffset/64],nValidWord,nGTPosWord,nGTShadowWord,anCounters);
+    }
+#else //(!METRICS_KERNELS_NEON)
+    binClassifPacked_Scalar(anInputWords,anGT,anROI,nPx,oLabels,anCounters);
+#endif //(!METRICS_KERNELS_NEON)
+}
@@ -0,0 +1,77 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// note: this header is shared by the runtime-dispatched metrics kernel translation units, which are compiled with
+// different instruction set flags; it must stay free of any inline code coming from other headers (e.g. std/cv/lv),
+// as the linker could otherwise pick an instantiation that uses instructions not supported by the current CPU
+
+#include <cstddef>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define METRICS_KERNELS_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else //(!defined(_MSC_VER))
+#include <x86intrin.h>
+#endif //(!defined(_MSC_VER))
+#else //(!x86)
+#define METRICS_KERNELS_X86 0
+#endif //(!x86)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define METRICS_KERNELS_NEON 1
+#include <arm_neon.h>
+#else //(!NEON)
+#define METRICS_KERNELS_NEON 0
+#endif //(!NEON)
+
+namespace metrics_impl {
+
+    /// gt label values used by the binary classification kernels (roi pixels are always considered invalid when null)
+    struct BinClassifLabels {
+        unsigned char nPositive, nOutOfScope, nUnknown, nShadow;
+    };
+
+    /// indices of the counters accumulated by the binary classification kernels (TN & DC are deduced from them by the caller)
+    enum BinClassifKernelCounter {
+        KernelCounter_Valid, KernelCounter_TP, KernelCounter_FP, KernelCounter_FN, KernelCounter_SE, nKernelCountersCount
+    };
+
+    /// signature of the binary classification row kernels (roi may be null; counters are incremented, not overwritten)
+    typedef void(*BinClassifRowKernel)(const unsigned char* anInput, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters);
+    /// signature of the packed binary classification kernels (input bits are read from 64-bit words in raster order, as in lv::PackedBinaryMask)
+    typedef void(*BinClassifPackedKernel)(const unsigned long long* anInputWords, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters);
+
+    /// baseline implementation, always available
+    void binClassifRow_Scalar(const unsigned char* anInput, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters);
+    /// SSE2 implementation (16 pixels per iteration, per-byte accumulators flushed via sad, falls back to scalar if not compiled in)
+    void binClassifRow_SSE2(const unsigned char* anInput, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters);
+    /// AVX2 implementation (32 pixels per iteration, per-byte accumulators flushed via sad, falls back to SSE2 if not compiled in)
+    void binClassifRow_AVX2(const unsigned char* anInput, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters);
+    /// NEON implementation (16 pixels per iteration, per-byte accumulators flushed via pairwise adds, falls back to scalar if not compiled in)
+    void binClassifRow_NEON(const unsigned char* anInput, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters);
+
+    /// baseline implementation, always available (SWAR popcount)
+    void binClassifPacked_Scalar(const unsigned long long* anInputWords, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters);
+    /// SSE2 implementation (gt words packed 16 pixels at a time via movemask, SWAR popcount, falls back to scalar if not compiled in)
+    void binClassifPacked_SSE2(const unsigned long long* anInputWords, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters);
+    /// AVX2 implementation (gt words packed 32 pixels at a time via movemask, hardware popcount, falls back to SSE2 if not compiled in)
+    void binClassifPacked_AVX2(const unsigned long long* anInputWords, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters);
+    /// NEON implementation (gt words packed 16 pixels at a time, vcnt popcount, falls back to scalar if not compiled in)
+    void binClassifPacked_NEON(const unsigned long long* anInputWords, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters);
+
+} // namespace metrics_impl
@@ -0,0 +1,128 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// note: this translation unit is compiled with AVX2 & POPCNT enabled (see CMakeLists.txt); its kernels are only called when
+// the current CPU supports AVX2 (which always implies POPCNT), so nothing else than the kernels themselves should ever be defined here
+
+#include "metrics_kernels.hpp"
+
+#if METRICS_KERNELS_X86 && defined(__AVX2__)
+
+using namespace metrics_impl;
+
+namespace {
+
+    inline unsigned long long hsum8_AVX2(const __m256i& vnAcc) {
+        const __m256i vnSums = _mm256_sad_epu8(vnAcc,_mm256_setzero_si256());
+        const __m128i vnHalfSums = _mm_add_epi64(_mm256_castsi256_si128(vnSums),_mm256_extracti128_si256(vnSums,1));
+        return (unsigned long long)(_mm_cvtsi128_si32(vnHalfSums)+_mm_cvtsi128_si32(_mm_srli_si128(vnHalfSums,8)));
+    }
+
+    inline unsigned long long popcount64_AVX2(unsigned long long nBits) {
+#if defined(__POPCNT__) || defined(_MSC_VER)
+        return (unsigned long long)(_mm_popcnt_u32((unsigned int)nBits)+_mm_popcnt_u32((unsigned int)(nBits>>32)));
+#else //!(defined(__POPCNT__) || defined(_MSC_VER))
+        nBits = nBits-((nBits>>1)&0x5555555555555555ull);
+        nBits = (nBits&0x3333333333333333ull)+((nBits>>2)&0x3333333333333333ull);
+        nBits = (nBits+(nBits>>4))&0x0F0F0F0F0F0F0F0Full;
+        return (nBits*0x0101010101010101ull)>>56;
+#endif //!(defined(__POPCNT__) || defined(_MSC_VER))
+    }
+
+    inline size_t packBinClassifWords_AVX2_impl(const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels,
+                                                unsigned long long& nValidWord, unsigned long long& nGTPosWord, unsigned long long& nGTShadowWord) {
+        size_t nPxIdx = 0;
+        for(; nPxIdx+32<=nPx; nPxIdx+=32) {
+            const __m256i vnGTVals = _mm256_loadu_si256((const __m256i*)(anGT+nPxIdx));
+            __m256i vbInvalid = _mm256_or_si256(_mm256_cmpeq_epi8(vnGTVals,_mm256_set1_epi8((char)oLabels.nOutOfScope)),_mm256_cmpeq_epi8(vnGTVals,_mm256_set1_epi8((char)oLabels.nUnknown)));
+            if(anROI)
+                vbInvalid = _mm256_or_si256(vbInvalid,_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(anROI+nPxIdx)),_mm256_setzero_si256()));
+            nValidWord |= (unsigned long long)(~(unsigned int)_mm256_movemask_epi8(vbInvalid))<<nPxIdx;
+            nGTPosWord |= (unsigned long long)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(vnGTVals,_mm256_set1_epi8((char)oLabels.nPositive)))<<nPxIdx;
+            nGTShadowWord |= (unsigned long long)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(vnGTVals,_mm256_set1_epi8((char)oLabels.nShadow)))<<nPxIdx;
+        }
+        return nPxIdx;
+    }
+
+    inline void countPackedWord_AVX2(unsigned long long nInputWord, unsigned long long nValidWord, unsigned long long nGTPosWord, unsigned long long nGTShadowWord, unsigned long long* anCounters) {
+        const unsigned long long nInputPosWord = nInputWord&nValidWord;
+        anCounters[KernelCounter_Valid] += popcount64_AVX2(nValidWord);
+        anCounters[KernelCounter_TP] += popcount64_AVX2(nInputPosWord&nGTPosWord);
+        anCounters[KernelCounter_FP] += popcount64_AVX2(nInputPosWord&~nGTPosWord);
+        anCounters[KernelCounter_FN] += popcount64_AVX2(nGTPosWord&nValidWord&~nInputPosWord);
+        anCounters[KernelCounter_SE] += popcount64_AVX2(nInputPosWord&nGTShadowWord);
+    }
+
+} // namespace
+
+void metrics_impl::binClassifRow_AVX2(const unsigned char* anInput, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters) {
+    const __m256i vnPositiveVal = _mm256_set1_epi8((char)oLabels.nPositive), vnOutOfScopeVal = _mm256_set1_epi8((char)oLabels.nOutOfScope);
+    const __m256i vnUnknownVal = _mm256_set1_epi8((char)oLabels.nUnknown), vnShadowVal = _mm256_set1_epi8((char)oLabels.nShadow);
+    const __m256i vnZero = _mm256_setzero_si256(), vnOnes = _mm256_set1_epi8((char)-1);
+    size_t nPxIdx = 0;
+    while(nPxIdx+32<=nPx) {
+        __m256i vnValidAcc = vnZero, vnTPAcc = vnZero, vnFPAcc = vnZero, vnFNAcc = vnZero, vnSEAcc = vnZero;
+        for(size_t nBlockIdx=0; nBlockIdx<255 && nPxIdx+32<=nPx; ++nBlockIdx, nPxIdx+=32) {
+            const __m256i vnInputVals = _mm256_loadu_si256((const __m256i*)(anInput+nPxIdx));
+            const __m256i vnGTVals = _mm256_loadu_si256((const __m256i*)(anGT+nPxIdx));
+            __m256i vbValid = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpeq_epi8(vnGTVals,vnOutOfScopeVal),_mm256_cmpeq_epi8(vnGTVals,vnUnknownVal)),vnOnes);
+            if(anROI)
+                vbValid = _mm256_andnot_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(anROI+nPxIdx)),vnZero),vbValid);
+            const __m256i vbInputPos = _mm256_and_si256(_mm256_cmpeq_epi8(vnInputVals,vnPositiveVal),vbValid);
+            const __m256i vbGTPos = _mm256_cmpeq_epi8(vnGTVals,vnPositiveVal);
+            vnValidAcc = _mm256_sub_epi8(vnValidAcc,vbValid);
+            vnTPAcc = _mm256_sub_epi8(vnTPAcc,_mm256_and_si256(vbInputPos,vbGTPos));
+            vnFPAcc = _mm256_sub_epi8(vnFPAcc,_mm256_andnot_si256(vbGTPos,vbInputPos));
+            vnFNAcc = _mm256_sub_epi8(vnFNAcc,_mm256_andnot_si256(vbInputPos,_mm256_and_si256(vbGTPos,vbValid)));
+            vnSEAcc = _mm256_sub_epi8(vnSEAcc,_mm256_and_si256(vbInputPos,_mm256_cmpeq_epi8(vnGTVals,vnShadowVal)));
+        }
+        anCounters[KernelCounter_Valid] += hsum8_AVX2(vnValidAcc);
+        anCounters[KernelCounter_TP] += hsum8_AVX2(vnTPAcc);
+        anCounters[KernelCounter_FP] += hsum8_AVX2(vnFPAcc);
+        anCounters[KernelCounter_FN] += hsum8_AVX2(vnFNAcc);
+        anCounters[KernelCounter_SE] += hsum8_AVX2(vnSEAcc);
+    }
+    binClassifRow_SSE2(anInput+nPxIdx,anGT+nPxIdx,anROI?anROI+nPxIdx:nullptr,nPx-nPxIdx,oLabels,anCounters);
+}
+
+void metrics_impl::binClassifPacked_AVX2(const unsigned long long* anInputWords, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters) {
+    for(size_t nPxOffset=0; nPxOffset<nPx; nPxOffset+=64) {
+        const size_t nWordPx = (nPx-nPxOffset)<64?(nPx-nPxOffset):64;
+        const unsigned char* const anWordGT = anGT+nPxOffset;
+        const unsigned char* const anWordROI = anROI?anROI+nPxOffset:nullptr;
+        unsigned long long nValidWord = 0, nGTPosWord = 0, nGTShadowWord = 0;
+        for(size_t nPxIdx=packBinClassifWords_AVX2_impl(anWordGT,anWordROI,nWordPx,oLabels,nValidWord,nGTPosWord,nGTShadowWord); nPxIdx<nWordPx; ++nPxIdx) {
+            const bool bValid = anWordGT[nPxIdx]!=oLabels.nOutOfScope && anWordGT[nPxIdx]!=oLabels.nUnknown && (!anWordROI || anWordROI[nPxIdx]!=0);
+            nValidWord |= (unsigned long long)bValid<<nPxIdx;
+            nGTPosWord |= (unsigned long long)(anWordGT[nPxIdx]==oLabels.nPositive)<<nPxIdx;
+            nGTShadowWord |= (unsigned long long)(anWordGT[nPxIdx]==oLabels.nShadow)<<nPxIdx;
+        }
+        countPackedWord_AVX2(anInputWords[nPxOffset/64],nValidWord,nGTPosWord,nGTShadowWord,anCounters);
+    }
+}
+
+#else //!(METRICS_KERNELS_X86 && defined(__AVX2__))
+
+void metrics_impl::binClassifRow_AVX2(const unsigned char* anInput, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters) {
+    binClassifRow_SSE2(anInput,anGT,anROI,nPx,oLabels,anCounters);
+}
+
+void metrics_impl::binClassifPacked_AVX2(const unsigned long long* anInputWords, const unsigned char* anGT, const unsigned char* anROI, size_t nPx, const BinClassifLabels& oLabels, unsigned long long* anCounters) {
+    binClassifPacked_SSE2(anInputWords,anGT,anROI,nPx,oLabels,anCounters);
+}
+
+#endif //!(METRICS_KERNELS_X86 && defined(__AVX2__))
@@ -0,0 +1,363 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/datasets/recording.hpp"
+#include <opencv2/imgcodecs.hpp>
+#include <cstddef>
+#include <random>
+
+#define RECORDING_HEADER_MAGIC     "LVRECHDR"
+#define RECORDING_CHUNK_MAGIC      "LVCK"
+#define RECORDING_VERSION          1 // must be bumped when the container layout below changes
+#define RECORDING_PNG_COMPRESSION  1 // zlib level used for png streams (lossless at any level, higher levels are much slower)
+
+namespace {
+
+    /// container file header, followed by nStreamCount stream headers, and then by chunks
+    struct RecordingFileHeader {
+        char acMagic[8];
+        uint32_t nVersion;
+        uint32_t nStreamCount;
+        uint32_t nSessionTag; // random tag copied in all chunk headers, so that stale chunks in preallocated/reused files are never indexed
+        uint32_t nReserved;
+        uint64_t nIndexOffset; // stays zero until the container is closed properly
+        uint64_t nIndexCount;
+    };
+
+    struct RecordingStreamHeader {
+        char acName[RECORDING_STREAM_NAME_MAX_LENGTH];
+        int32_t nRows,nCols,nType;
+        uint32_t nCodec;
+    };
+
+    /// per-chunk header (the chunk payload is one encoded packet)
+    struct RecordingChunkHeader {
+        char acMagic[4];
+        uint32_t nSessionTag;
+        uint32_t nStreamIdx;
+        uint32_t nReserved;
+        uint64_t nFrameIdx;
+        int64_t nTimestamp;
+        uint64_t nSize;
+    };
+
+    /// index entry written on close (offset points to the chunk payload)
+    struct RecordingIndexEntry {
+        uint32_t nStreamIdx;
+        uint32_t nReserved;
+        uint64_t nFrameIdx;
+        int64_t nTimestamp;
+        uint64_t nOffset;
+        uint64_t nSize;
+    };
+
+    inline void writeVarint(std::vector<uchar>& vBuffer, uint64_t nValue) {
+        while(nValue>=0x80) {
+            vBuffer.push_back(uchar(nValue|0x80));
+            nValue >>= 7;
+        }
+        vBuffer.push_back(uchar(nValue));
+    }
+
+    inline uint64_t readVarint(const uchar*& pData, const uchar* pDataEnd) {
+        uint64_t nValue = 0;
+        for(int nShift=0; ; nShift+=7) {
+            lvAssert_(pData<pDataEnd && nShift<64,"delta-coded recording packet is truncated or corrupted");
+            const uchar nByte = *pData++;
+            nValue |= uint64_t(nByte&0x7F)<<nShift;
+            if(!(nByte&0x80))
+                return nValue;
+        }
+    }
+
+    /// encodes pixel deltas w.r.t. the left neighbor (or the pixel above, for the first column) as zigzag varints, with runs of zero deltas merged in a single token
+    template<typename T>
+    void encodeDelta(const cv::Mat& oPacket, std::vector<uchar>& vBuffer) {
+        size_t nZeroRun = 0;
+        const auto lFlushZeroRun = [&]() {
+            if(nZeroRun>0) {
+                writeVarint(vBuffer,(uint64_t(nZeroRun-1)<<1)|1);
+                nZeroRun = 0;
+            }
+        };
+        for(int nRowIdx=0; nRowIdx<oPacket.rows; ++nRowIdx) {
+            const T* pRow = oPacket.ptr<T>(nRowIdx);
+            int nPred = nRowIdx>0?int(oPacket.ptr<T>(nRowIdx-1)[0]):0;
+            for(int nColIdx=0; nColIdx<oPacket.cols; ++nColIdx) {
+                const int nDelta = int(pRow[nColIdx])-nPred;
+                nPred = int(pRow[nColIdx]);
+                if(nDelta==0)
+                    ++nZeroRun;
+                else {
+                    lFlushZeroRun();
+                    const uint32_t nZigZag = (uint32_t(nDelta)<<1)^uint32_t(nDelta>>31);
+                    writeVarint(vBuffer,uint64_t(nZigZag)<<1);
+                }
+            }
+        }
+        lFlushZeroRun();
+    }
+
+    template<typename T>
+    void decodeDelta(const uchar* pData, const uchar* pDataEnd, cv::Mat& oPacket) {
+        size_t nZeroRunLeft = 0;
+        for(int nRowIdx=0; nRowIdx<oPacket.rows; ++nRowIdx) {
+            T* pRow = oPacket.ptr<T>(nRowIdx);
+            int nPred = nRowIdx>0?int(oPacket.ptr<T>(nRowIdx-1)[0]):0;
+            for(int nColIdx=0; nColIdx<oPacket.cols; ++nColIdx) {
+                int nDelta = 0;
+                if(nZeroRunLeft>0)
+                    --nZeroRunLeft;
+                else {
+                    const uint64_t nToken = readVarint(pData,pDataEnd);
+                    if(nToken&1)
+                        nZeroRunLeft = size_t(nToken>>1);
+                    else {
+                        const uint32_t nZigZag = uint32_t(nToken>>1);
+                        nDelta = int(nZigZag>>1)^-int(nZigZag&1);
+                    }
+                }
+                nPred += nDelta;
+                pRow[nColIdx] = T(nPred);
+            }
+        }
+        lvAssert_(pData==pDataEnd && nZeroRunLeft==0,"delta-coded recording packet size mismatch");
+    }
+
+    void validateStream(const lv::RecordingStreamInfo& oStream) {
+        lvAssert__(!oStream.sName.empty() && oStream.sName.size()<RECORDING_STREAM_NAME_MAX_LENGTH,"bad recording stream name '%s'",oStream.sName.c_str());
+        lvAssert__(oStream.oSize.area()>0,"recording stream '%s' has an empty packet size",oStream.sName.c_str());
+        const int nDepth = CV_MAT_DEPTH(oStream.nType), nChannels = CV_MAT_CN(oStream.nType);
+        if(oStream.eCodec==lv::RecordingCodec_Delta)
+            lvAssert__(nChannels==1 && (nDepth==CV_8U || nDepth==CV_16U),"delta codec of recording stream '%s' requires 1-channel 8U/16U packets",oStream.sName.c_str());
+        else if(oStream.eCodec==lv::RecordingCodec_PNG)
+            lvAssert__((nChannels==1 || nChannels==3) && (nDepth==CV_8U || nDepth==CV_16U),"png codec of recording stream '%s' requires 1/3-channel 8U/16U packets",oStream.sName.c_str());
+        else if(oStream.eCodec==lv::RecordingCodec_JPEG)
+            lvAssert__((nChannels==1 || nChannels==3) && nDepth==CV_8U,"jpeg codec of recording stream '%s' requires 1/3-channel 8U packets",oStream.sName.c_str());
+        else
+            lvAssert__(oStream.eCodec==lv::RecordingCodec_Raw,"unknown codec for recording stream '%s'",oStream.sName.c_str());
+    }
+
+    void encodePacket(const lv::RecordingStreamInfo& oStream, const cv::Mat& oPacket, std::vector<uchar>& vBuffer) {
+        vBuffer.clear();
+        if(oStream.eCodec==lv::RecordingCodec_Delta) {
+            if(CV_MAT_DEPTH(oStream.nType)==CV_8U)
+                encodeDelta<uint8_t>(oPacket,vBuffer);
+            else
+                encodeDelta<uint16_t>(oPacket,vBuffer);
+        }
+        else if(oStream.eCodec==lv::RecordingCodec_PNG)
+            lvAssert_(cv::imencode(".png",oPacket,vBuffer,{cv::IMWRITE_PNG_COMPRESSION,RECORDING_PNG_COMPRESSION}),"could not png-encode recording packet");
+        else if(oStream.eCodec==lv::RecordingCodec_JPEG)
+            lvAssert_(cv::imencode(".jpg",oPacket,vBuffer,{cv::IMWRITE_JPEG_QUALITY,RECORDING_JPEG_QUALITY}),"could not jpeg-encode recording packet");
+        else {
+            const cv::Mat oContPacket = oPacket.isContinuous()?oPacket:oPacket.clone();
+            vBuffer.assign(oContPacket.data,oContPacket.data+oContPacket.total()*oContPacket.elemSize());
+        }
+    }
+
+} // namespace
+
+lv::RecordingWriter::RecordingWriter(const std::string& sFilePath, const std::vector<RecordingStreamInfo>& voStreams, size_t nPreallocBytes) :
+        m_sFilePath(sFilePath),
+        m_voStreams(voStreams),
+        m_nWritePos(0) {
+    lvAssert_(!m_voStreams.empty(),"recording requires at least one stream");
+    for(const RecordingStreamInfo& oStream : m_voStreams)
+        validateStream(oStream);
+    if(nPreallocBytes>0)
+        m_oFile = lv::CreateBinFileWithPrealloc(sFilePath,nPreallocBytes);
+    else
+        m_oFile.open(sFilePath,std::ios::out|std::ios::binary|std::ios::trunc);
+    lvAssert__(m_oFile.is_open(),"could not create recording file at '%s'",sFilePath.c_str());
+    m_oFile.seekp(0);
+    RecordingFileHeader oHeader = {};
+    std::copy_n(RECORDING_HEADER_MAGIC,sizeof(oHeader.acMagic),oHeader.acMagic);
+    oHeader.nVersion = RECORDING_VERSION;
+    oHeader.nStreamCount = uint32_t(m_voStreams.size());
+    oHeader.nSessionTag = uint32_t(std::random_device()());
+    m_oFile.write((const char*)&oHeader,sizeof(oHeader));
+    for(const RecordingStreamInfo& oStream : m_voStreams) {
+        RecordingStreamHeader oStreamHeader = {};
+        std::copy(oStream.sName.begin(),oStream.sName.end(),oStreamHeader.acName);
+        oStreamHeader.nRows = oStream.oSize.height;
+        oStreamHeader.nCols = oStream.oSize.width;
+        oStreamHeader.nType = oStream.nType;
+        oStreamHeader.nCodec = uint32_t(oStream.eCodec);
+        m_oFile.write((const char*)&oStreamHeader,sizeof(oStreamHeader));
+    }
+    lvAssert__(m_oFile.good(),"could not write recording header to '%s'",sFilePath.c_str());
+    m_nWritePos = sizeof(RecordingFileHeader)+m_voStreams.size()*sizeof(RecordingStreamHeader);
+    m_nSessionTag = oHeader.nSessionTag;
+}
+
+lv::RecordingWriter::~RecordingWriter() {
+    close();
+}
+
+void lv::RecordingWriter::write(size_t nStreamIdx, size_t nFrameIdx, int64_t nTimestamp, const cv::Mat& oPacket) {
+    lvAssert_(nStreamIdx<m_voStreams.size(),"recording stream index out of range");
+    const RecordingStreamInfo& oStream = m_voStreams[nStreamIdx];
+    lvAssert__(oPacket.size()==oStream.oSize && oPacket.type()==oStream.nType,"packet size/type mismatch for recording stream '%s'",oStream.sName.c_str());
+    // packets are encoded by the calling thread, in its own buffer, so that concurrent writers only contend for the file append
+    thread_local std::vector<uchar> s_vEncodeBuffer;
+    encodePacket(oStream,oPacket,s_vEncodeBuffer);
+    RecordingChunkHeader oChunkHeader = {};
+    std::copy_n(RECORDING_CHUNK_MAGIC,sizeof(oChunkHeader.acMagic),oChunkHeader.acMagic);
+    oChunkHeader.nSessionTag = m_nSessionTag;
+    oChunkHeader.nStreamIdx = uint32_t(nStreamIdx);
+    oChunkHeader.nFrameIdx = uint64_t(nFrameIdx);
+    oChunkHeader.nTimestamp = nTimestamp;
+    oChunkHeader.nSize = uint64_t(s_vEncodeBuffer.size());
+    std::mutex_lock_guard oLock(m_oFileMutex);
+    lvAssert__(m_oFile.is_open(),"recording at '%s' was already closed",m_sFilePath.c_str());
+    m_oFile.seekp(std::streamoff(m_nWritePos));
+    m_oFile.write((const char*)&oChunkHeader,sizeof(oChunkHeader));
+    m_oFile.write((const char*)s_vEncodeBuffer.data(),std::streamsize(s_vEncodeBuffer.size()));
+    lvAssert__(m_oFile.good(),"could not append chunk to recording at '%s'",m_sFilePath.c_str());
+    m_voChunks.push_back(ChunkEntry{uint32_t(nStreamIdx),uint64_t(nFrameIdx),nTimestamp,m_nWritePos+sizeof(oChunkHeader),oChunkHeader.nSize});
+    m_nWritePos += sizeof(oChunkHeader)+oChunkHeader.nSize;
+}
+
+void lv::RecordingWriter::close() {
+    std::mutex_lock_guard oLock(m_oFileMutex);
+    if(!m_oFile.is_open())
+        return;
+    const uint64_t nIndexOffset = m_nWritePos;
+    m_oFile.seekp(std::streamoff(nIndexOffset));
+    for(const ChunkEntry& oChunk : m_voChunks) {
+        const RecordingIndexEntry oEntry = {oChunk.nStreamIdx,0,oChunk.nFrameIdx,oChunk.nTimestamp,oChunk.nOffset,oChunk.nSize};
+        m_oFile.write((const char*)&oEntry,sizeof(oEntry));
+    }
+    // the index location is only published once the index itself is fully written
+    m_oFile.flush();
+    m_oFile.seekp(std::streamoff(offsetof(RecordingFileHeader,nIndexOffset)));
+    const uint64_t anIndexInfo[2] = {nIndexOffset,uint64_t(m_voChunks.size())};
+    m_oFile.write((const char*)anIndexInfo,sizeof(anIndexInfo));
+    m_oFile.close();
+    m_nWritePos += m_voChunks.size()*sizeof(RecordingIndexEntry);
+}
+
+size_t lv::RecordingWriter::getWrittenBytes() const {
+    std::mutex_lock_guard oLock(m_oFileMutex);
+    return size_t(m_nWritePos);
+}
+
+lv::RecordingReader::RecordingReader(const std::string& sFilePath) :
+        m_oFile(sFilePath),
+        m_bRecovered(false) {
+    const uint8_t* pData = m_oFile.data();
+    const size_t nFileSize = m_oFile.size();
+    RecordingFileHeader oHeader;
+    lvAssert__(nFileSize>=sizeof(oHeader),"recording at '%s' is truncated",sFilePath.c_str());
+    std::copy_n(pData,sizeof(oHeader),(uint8_t*)&oHeader);
+    lvAssert__(std::equal(oHeader.acMagic,oHeader.acMagic+sizeof(oHeader.acMagic),RECORDING_HEADER_MAGIC),"file at '%s' is not a recording",sFilePath.c_str());
+    lvAssert__(oHeader.nVersion==RECORDING_VERSION,"recording at '%s' has an unsupported version (%d)",sFilePath.c_str(),(int)oHeader.nVersion);
+    const size_t nHeadersSize = sizeof(oHeader)+size_t(oHeader.nStreamCount)*sizeof(RecordingStreamHeader);
+    lvAssert__(oHeader.nStreamCount>0 && nFileSize>=nHeadersSize,"recording at '%s' has a bad stream layout",sFilePath.c_str());
+    for(size_t nStreamIdx=0; nStreamIdx<oHeader.nStreamCount; ++nStreamIdx) {
+        RecordingStreamHeader oStreamHeader;
+        std::copy_n(pData+sizeof(oHeader)+nStreamIdx*sizeof(oStreamHeader),sizeof(oStreamHeader),(uint8_t*)&oStreamHeader);
+        oStreamHeader.acName[RECORDING_STREAM_NAME_MAX_LENGTH-1] = '\0';
+        m_voStreams.push_back(RecordingStreamInfo{std::string(oStreamHeader.acName),cv::Size(oStreamHeader.nCols,oStreamHeader.nRows),oStreamHeader.nType,RecordingCodec(oStreamHeader.nCodec)});
+        validateStream(m_voStreams.back());
+    }
+    m_vvoPackets.resize(m_voStreams.size());
+    const auto lAddPacket = [&](uint32_t nStreamIdx, uint64_t nFrameIdx, int64_t nTimestamp, uint64_t nOffset, uint64_t nSize) {
+        lvAssert__(nStreamIdx<m_voStreams.size() && nOffset>=nHeadersSize && nOffset<=nFileSize && nSize<=nFileSize-nOffset,"recording at '%s' has a corrupted index",sFilePath.c_str());
+        m_vvoPackets[nStreamIdx].push_back(PacketEntry{nFrameIdx,nTimestamp,nOffset,nSize});
+    };
+    if(oHeader.nIndexOffset>=nHeadersSize && oHeader.nIndexOffset<=nFileSize && oHeader.nIndexCount<=(nFileSize-oHeader.nIndexOffset)/sizeof(RecordingIndexEntry)) {
+        for(size_t nEntryIdx=0; nEntryIdx<oHeader.nIndexCount; ++nEntryIdx) {
+            RecordingIndexEntry oEntry;
+            std::copy_n(pData+oHeader.nIndexOffset+nEntryIdx*sizeof(oEntry),sizeof(oEntry),(uint8_t*)&oEntry);
+            lAddPacket(oEntry.nStreamIdx,oEntry.nFrameIdx,oEntry.nTimestamp,oEntry.nOffset,oEntry.nSize);
+        }
+    }
+    else {
+        // the container was not closed properly (e.g. capture crash); chunks are scanned until the first one that does not belong to this session
+        m_bRecovered = true;
+        size_t nOffset = nHeadersSize;
+        RecordingChunkHeader oChunkHeader;
+        while(nFileSize-nOffset>=sizeof(oChunkHeader)) {
+            std::copy_n(pData+nOffset,sizeof(oChunkHeader),(uint8_t*)&oChunkHeader);
+            if(!std::equal(oChunkHeader.acMagic,oChunkHeader.acMagic+sizeof(oChunkHeader.acMagic),RECORDING_CHUNK_MAGIC) || oChunkHeader.nSessionTag!=oHeader.nSessionTag ||
+               oChunkHeader.nStreamIdx>=m_voStreams.size() || oChunkHeader.nSize>nFileSize-nOffset-sizeof(oChunkHeader))
+                break;
+            lAddPacket(oChunkHeader.nStreamIdx,oChunkHeader.nFrameIdx,oChunkHeader.nTimestamp,nOffset+sizeof(oChunkHeader),oChunkHeader.nSize);
+            nOffset += sizeof(oChunkHeader)+size_t(oChunkHeader.nSize);
+        }
+    }
+    // chunks are interleaved in arrival order (possibly out of order within a stream, with many writers), but packets are served by frame index
+    for(std::vector<PacketEntry>& voPackets : m_vvoPackets)
+        std::stable_sort(voPackets.begin(),voPackets.end(),[](const PacketEntry& a, const PacketEntry& b){return a.nFrameIdx<b.nFrameIdx;});
+}
+
+const lv::RecordingStreamInfo& lv::RecordingReader::getStreamInfo(size_t nStreamIdx) const {
+    lvAssert_(nStreamIdx<m_voStreams.size(),"recording stream index out of range");
+    return m_voStreams[nStreamIdx];
+}
+
+size_t lv::RecordingReader::findStream(const std::string& sStreamName) const {
+    for(size_t nStreamIdx=0; nStreamIdx<m_voStreams.size(); ++nStreamIdx)
+        if(m_voStreams[nStreamIdx].sName==sStreamName)
+            return nStreamIdx;
+    return SIZE_MAX;
+}
+
+size_t lv::RecordingReader::getPacketCount(size_t nStreamIdx) const {
+    lvAssert_(nStreamIdx<m_vvoPackets.size(),"recording stream index out of range");
+    return m_vvoPackets[nStreamIdx].size();
+}
+
+size_t lv::RecordingReader::getFrameIdx(size_t nStreamIdx, size_t nPacketIdx) const {
+    return size_t(getPacketEntry(nStreamIdx,nPacketIdx).nFrameIdx);
+}
+
+int64_t lv::RecordingReader::getTimestamp(size_t nStreamIdx, size_t nPacketIdx) const {
+    return getPacketEntry(nStreamIdx,nPacketIdx).nTimestamp;
+}
+
+cv::Mat lv::RecordingReader::read(size_t nStreamIdx, size_t nPacketIdx) const {
+    const PacketEntry& oEntry = getPacketEntry(nStreamIdx,nPacketIdx);
+    const RecordingStreamInfo& oStream = m_voStreams[nStreamIdx];
+    const uchar* pData = m_oFile.data()+oEntry.nOffset;
+    const uchar* pDataEnd = pData+oEntry.nSize;
+    cv::Mat oPacket;
+    if(oStream.eCodec==RecordingCodec_Delta) {
+        oPacket.create(oStream.oSize,oStream.nType);
+        if(CV_MAT_DEPTH(oStream.nType)==CV_8U)
+            decodeDelta<uint8_t>(pData,pDataEnd,oPacket);
+        else
+            decodeDelta<uint16_t>(pData,pDataEnd,oPacket);
+    }
+    else if(oStream.eCodec==RecordingCodec_PNG || oStream.eCodec==RecordingCodec_JPEG) {
+        oPacket = cv::imdecode(cv::Mat(1,int(oEntry.nSize),CV_8UC1,(void*)pData),cv::IMREAD_UNCHANGED);
+        lvAssert__(oPacket.size()==oStream.oSize && oPacket.type()==oStream.nType,"could not decode packet #%d of recording stream '%s'",(int)nPacketIdx,oStream.sName.c_str());
+    }
+    else {
+        oPacket.create(oStream.oSize,oStream.nType);
+        lvAssert__(oEntry.nSize==oPacket.total()*oPacket.elemSize(),"raw packet #%d of recording stream '%s' has a bad size",(int)nPacketIdx,oStream.sName.c_str());
+        std::copy(pData,pDataEnd,oPacket.data); // copied out of the (read-only) mapping, as served packets may be modified
+    }
+    return oPacket;
+}
+
+const lv::RecordingReader::PacketEntry& lv::RecordingReader::getPacketEntry(size_t nStreamIdx, size_t nPacketIdx) const {
+    lvAssert_(nStreamIdx<m_vvoPackets.size() && nPacketIdx<m_vvoPackets[nStreamIdx].size(),"recording packet index out of range");
+    return m_vvoPackets[nStreamIdx][nPacketIdx];
+}
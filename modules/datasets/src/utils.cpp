@@ -16,16 +16,472 @@
 // limitations under the License.
 
 #include "litiv/datasets/utils.hpp"
+#include "litiv/utils/console.hpp"
 
 #define HARDCODE_IMAGE_PACKET_INDEX        0 // for sync debug only! will corrupt data for non-image packets
-#define CONSOLE_DEBUG                      0
 #define PRECACHE_REQUEST_TIMEOUT_MS        1
 #define PRECACHE_QUERY_TIMEOUT_MS          10
 #define PRECACHE_PREFILL_TIMEOUT_MS        5000
+#define PRECACHE_DECODE_WINDOW_PER_WORKER  4 // max number of packets decoded ahead of the precaching thread, per decode worker
+#define PRECACHE_BACKWARD_BUFFER_FRACTION  4 // 1/N of the precache buffer is reserved for packets behind the last request
+#define VIDEO_READER_USE_HW_ACCELERATION   1 // requests hardware-accelerated decoding from opencv video readers (only available w/ opencv >= 4.5.2)
+#define VIDEO_READER_MAX_GRAB_SKIP_FRAMES  32 // forward jumps up to this many frames are skipped via grab() instead of a (keyframe-based) seek
+#define VIDEO_READER_SEEK_PREROLL_FRAMES   64 // number of frames to back up by when a seek overshoots the requested frame
+#define ASYNCFILEREADER_MAX_IN_FLIGHT      32 // max number of input files read ahead of requests by image data producers
+#define ASYNCFILEREADER_THREAD_COUNT       8 // number of i/o threads per async file reader (reads are latency-bound, so this may exceed the core count)
+#define DATAWRITER_QUEUE_SLOT_COUNT        256 // number of preallocated packet slots in async data writer rings (must be a power of two)
+#define DATAWRITER_WAIT_TIMEOUT_MS         5
+#define DATAARCHIVER_PNG_COMPRESSION_LEVEL 1 // zlib level used for png outputs (lossless at any level, but level 9 is several times slower to encode)
+#define DATAARCHIVER_RLE_SUFFIX            ".lvrle" // output name suffix selecting run-length encoded 8UC1 masks
+#define DATAARCHIVER_BITPACKED_SUFFIX      ".lvbit" // output name suffix selecting bit-packed (1bpp) binary masks
+#define DATAARCHIVER_RAW_SUFFIX            ".lvraw" // output name suffix selecting uncompressed raw packets
+#define DATAARCHIVER_CONTAINER_PREFIX      ".seq" // output name suffix prefix selecting per-batch containers (e.g. '.seq.lvbit', '.seq.png')
+#define DATAARCHIVER_CONTAINER_NAME        "sequence" // file name (w/o suffix) of per-batch output containers
+#define DATAARCHIVER_CONTAINER_MAGIC       "LVSEQPKT"
+#define DATAARCHIVER_CONTAINER_INDEX_MAGIC "LVSEQIDX"
 #if (!(defined(_M_X64) || defined(__amd64__)) && CACHE_MAX_SIZE_GB>2)
 #error "Cache max size exceeds system limit (x86)."
 #endif //(!(defined(_M_X64) || defined(__amd64__)) && CACHE_MAX_SIZE_GB>2)
 #define CACHE_MAX_SIZE size_t(((CACHE_MAX_SIZE_GB*1024)*1024)*1024)
+#define BUFFERBUDGET_REBALANCE_PERIOD_MS   500 // min delay between two rebalancings triggered by activity reports
+#define BUFFERBUDGET_MIN_SHARE_FRACTION    4 // each buffer is always granted 1/(N*K) of the total budget (or its requested size, if smaller), with N buffers
+#define BUFFERBUDGET_STALL_WEIGHT          4.0 // weight of the stall ratio w.r.t. the consumption rate when splitting the remaining budget
+#define BUFFERBUDGET_STATS_SMOOTHING       0.5 // exponential smoothing factor applied to consumption rates & stall ratios at each rebalancing
+#define PACKED_CACHE_MAGIC                 "LVPKDATA"
+#define PACKED_CACHE_VERSION               1 // must be bumped when the packed cache layout below changes
+#define PACKED_CACHE_ALIGNMENT             64 // byte alignment of each raw packet plane in packed cache files
+#define IMAGE_PACKET_USE_REDUCED_DECODE    1 // input images downscaled by half or more are decoded at the nearest power-of-two reduced size (1/2, 1/4 or 1/8) before the residual resize
+#define IMAGE_METADATA_USE_HEADER_PROBING  1 // image sizes are read from png/jpeg/bmp headers instead of fully decoding each image
+#define IMAGE_METADATA_CACHE_NAME          ".litiv_image_meta" // per-directory image metadata cache file name (must not contain image extension tokens)
+#define IMAGE_METADATA_CACHE_MAGIC         "LVIMGMET"
+#define IMAGE_METADATA_CACHE_VERSION       1
+#define DATASET_INDEX_MAGIC                "LVDSINDX"
+#define DATASET_INDEX_VERSION              1
+#define DATASET_INDEX_MIN_DIR_AGE_SEC      2 // directories modified more recently than this are not indexed, as mtimes have a coarse resolution
+#define COMPACT_GT_PACKET_TYPE             CV_8SC1 // type of 2-bit encoded gt packets in precacher buffers (never used by actual gt packets)
+
+namespace {
+
+    /// packed cache file header; followed by one input & one gt plane descriptor per packet, and then by the aligned raw planes
+    struct PackedCacheHeader {
+        char acMagic[8];
+        uint32_t nVersion;
+        uint32_t nFlags;
+        uint64_t nPacketCount;
+        double dScaleFactor;
+    };
+
+    /// packed cache plane descriptor (empty packets have a null size)
+    struct PackedCachePlane {
+        uint64_t nOffset;
+        int32_t nRows,nCols,nType,nUnused;
+    };
+
+    enum PackedCacheFlags {
+        PackedCacheFlag_HasGT=1,
+        PackedCacheFlag_4ByteAligned=2,
+    };
+
+    /// compact gt packet header; followed by the 2-bit palette indices of all pixels, packed 4 per byte in row-major order
+    struct CompactGTHeader {
+        int32_t nRows,nCols;
+        uchar anPalette[4];
+    };
+
+    /// encodes an 8UC1 gt packet using a 2-bit palette if it contains at most 4 different values, or returns it unchanged otherwise
+    cv::Mat encodeCompactGTPacket(const cv::Mat& oPacket) {
+        if(oPacket.empty() || oPacket.type()!=CV_8UC1 || oPacket.dims!=2)
+            return oPacket;
+        std::array<int,256> anPaletteLUT;
+        anPaletteLUT.fill(-1);
+        CompactGTHeader oHeader = {oPacket.rows,oPacket.cols,{}};
+        int nPaletteSize = 0;
+        for(int nRowIdx=0; nRowIdx<oPacket.rows; ++nRowIdx) {
+            const uchar* pRow = oPacket.ptr<uchar>(nRowIdx);
+            for(int nColIdx=0; nColIdx<oPacket.cols; ++nColIdx) {
+                if(anPaletteLUT[pRow[nColIdx]]<0) {
+                    if(nPaletteSize==4)
+                        return oPacket;
+                    oHeader.anPalette[nPaletteSize] = pRow[nColIdx];
+                    anPaletteLUT[pRow[nColIdx]] = nPaletteSize++;
+                }
+            }
+        }
+        const size_t nPixels = size_t(oPacket.rows)*size_t(oPacket.cols);
+        cv::Mat oEncoded(1,int(sizeof(CompactGTHeader)+(nPixels+3)/4),COMPACT_GT_PACKET_TYPE,cv::Scalar(0));
+        memcpy(oEncoded.data,&oHeader,sizeof(CompactGTHeader));
+        uchar* const pData = oEncoded.data+sizeof(CompactGTHeader);
+        size_t nPxIdx = 0;
+        for(int nRowIdx=0; nRowIdx<oPacket.rows; ++nRowIdx) {
+            const uchar* pRow = oPacket.ptr<uchar>(nRowIdx);
+            for(int nColIdx=0; nColIdx<oPacket.cols; ++nColIdx,++nPxIdx)
+                pData[nPxIdx/4] |= uchar(anPaletteLUT[pRow[nColIdx]]<<((nPxIdx%4)*2));
+        }
+        return oEncoded;
+    }
+
+    /// decodes a gt packet encoded via encodeCompactGTPacket into an 8UC1 matrix (reallocated only if needed)
+    void decodeCompactGTPacket(const cv::Mat& oEncoded, cv::Mat& oPacket) {
+        lvDbgAssert(oEncoded.type()==COMPACT_GT_PACKET_TYPE && oEncoded.total()>=sizeof(CompactGTHeader));
+        CompactGTHeader oHeader;
+        memcpy(&oHeader,oEncoded.data,sizeof(CompactGTHeader));
+        oPacket.create(oHeader.nRows,oHeader.nCols,CV_8UC1);
+        lvDbgAssert(oPacket.isContinuous());
+        const uchar* const pData = oEncoded.data+sizeof(CompactGTHeader);
+        uchar* const pOutput = oPacket.data;
+        const size_t nPixels = size_t(oHeader.nRows)*size_t(oHeader.nCols);
+        for(size_t nPxIdx=0; nPxIdx<nPixels; ++nPxIdx)
+            pOutput[nPxIdx] = oHeader.anPalette[(pData[nPxIdx/4]>>((nPxIdx%4)*2))&3];
+    }
+
+    /// dataset index file header; followed by one serialized directory entry per indexed directory
+    struct DatasetIndexHeader {
+        char acMagic[8];
+        uint32_t nVersion;
+        uint32_t nUnused;
+        uint64_t nDirCount;
+    };
+
+    /// writes a length-prefixed string to a binary stream
+    void writeIndexString(std::ostream& oStream, const std::string& sStr) {
+        const uint32_t nLength = uint32_t(sStr.size());
+        oStream.write((const char*)&nLength,sizeof(nLength));
+        oStream.write(sStr.data(),nLength);
+    }
+
+    /// reads a length-prefixed string from a binary stream; returns false on failure
+    bool readIndexString(std::istream& oStream, std::string& sStr) {
+        uint32_t nLength;
+        if(!oStream.read((char*)&nLength,sizeof(nLength)) || nLength>(1u<<16))
+            return false;
+        sStr.resize(nLength);
+        return nLength==0 || bool(oStream.read(&sStr[0],nLength));
+    }
+
+    /// writes a string array to a binary stream
+    void writeIndexStrings(std::ostream& oStream, const std::vector<std::string>& vsStrs) {
+        const uint64_t nCount = uint64_t(vsStrs.size());
+        oStream.write((const char*)&nCount,sizeof(nCount));
+        for(const std::string& sStr : vsStrs)
+            writeIndexString(oStream,sStr);
+    }
+
+    /// reads a string array from a binary stream; returns false on failure
+    bool readIndexStrings(std::istream& oStream, std::vector<std::string>& vsStrs) {
+        uint64_t nCount;
+        if(!oStream.read((char*)&nCount,sizeof(nCount)) || nCount>(uint64_t(1)<<32))
+            return false;
+        vsStrs.resize(size_t(nCount));
+        for(std::string& sStr : vsStrs)
+            if(!readIndexString(oStream,sStr))
+                return false;
+        return true;
+    }
+
+    /// image metadata cache file header; followed by one entry per image (with its file name appended)
+    struct ImageMetadataCacheHeader {
+        char acMagic[8];
+        uint32_t nVersion;
+        uint32_t nUnused;
+        uint64_t nEntryCount;
+    };
+
+    /// image metadata cache entry; file stats are used to invalidate it
+    struct ImageMetadataCacheEntry {
+        int64_t nModifTime;
+        int64_t nFileSize;
+        int32_t nRows,nCols;
+        uint32_t nNameLength,nUnused;
+    };
+
+    /// reads image dimensions from png/jpeg/bmp file headers only; returns false if the format is not handled (or if the decoder could reorient it)
+    bool probeImageHeaderSize(const std::string& sFilePath, cv::Size& oSize) {
+        std::ifstream oFile(sFilePath,std::ios::in|std::ios::binary);
+        if(!oFile.is_open())
+            return false;
+        std::array<uint8_t,26> anHeader = {};
+        oFile.read((char*)anHeader.data(),anHeader.size());
+        const size_t nReadBytes = size_t(oFile.gcount());
+        const auto lReadBE16 = [](const uint8_t* p) {return int(p[0])<<8|int(p[1]);};
+        const auto lReadBE32 = [](const uint8_t* p) {return uint32_t(p[0])<<24|uint32_t(p[1])<<16|uint32_t(p[2])<<8|uint32_t(p[3]);};
+        const auto lReadLE32 = [](const uint8_t* p) {return int32_t(uint32_t(p[0])|uint32_t(p[1])<<8|uint32_t(p[2])<<16|uint32_t(p[3])<<24);};
+        if(nReadBytes>=24 && !memcmp(anHeader.data(),"\x89PNG\r\n\x1a\n",8) && !memcmp(anHeader.data()+12,"IHDR",4)) {
+            const uint32_t nWidth = lReadBE32(anHeader.data()+16), nHeight = lReadBE32(anHeader.data()+20);
+            if(nWidth==0 || nHeight==0 || nWidth>uint32_t(INT_MAX) || nHeight>uint32_t(INT_MAX))
+                return false;
+            oSize = cv::Size(int(nWidth),int(nHeight));
+            return true;
+        }
+        else if(nReadBytes>=26 && anHeader[0]=='B' && anHeader[1]=='M') {
+            const int32_t nDIBHeaderSize = lReadLE32(anHeader.data()+14);
+            if(nDIBHeaderSize==12) // BITMAPCOREHEADER (16-bit dims)
+                oSize = cv::Size(int(anHeader[18])|int(anHeader[19])<<8,int(anHeader[20])|int(anHeader[21])<<8);
+            else if(nDIBHeaderSize>=40) // BITMAPINFOHEADER & later (negative height means top-down)
+                oSize = cv::Size(lReadLE32(anHeader.data()+18),std::abs(lReadLE32(anHeader.data()+22)));
+            else
+                return false;
+            return oSize.width>0 && oSize.height>0;
+        }
+        else if(nReadBytes>=4 && anHeader[0]==0xFF && anHeader[1]==0xD8) {
+            oFile.clear();
+            oFile.seekg(2);
+            while(oFile) {
+                int nByte = oFile.get();
+                if(nByte!=0xFF)
+                    return false;
+                while(nByte==0xFF) // skip fill bytes
+                    nByte = oFile.get();
+                if(nByte==EOF || nByte==0xD9 || nByte==0xDA) // eoi or sos reached before any sof marker
+                    return false;
+                if(nByte==0x01 || (nByte>=0xD0 && nByte<=0xD7)) // standalone markers
+                    continue;
+                std::array<uint8_t,8> anSegment;
+                if(!oFile.read((char*)anSegment.data(),2))
+                    return false;
+                const int nSegmentLength = lReadBE16(anSegment.data());
+                if(nSegmentLength<2)
+                    return false;
+                if(nByte>=0xC0 && nByte<=0xCF && nByte!=0xC4 && nByte!=0xC8 && nByte!=0xCC) {
+                    if(!oFile.read((char*)anSegment.data(),5))
+                        return false;
+                    oSize = cv::Size(lReadBE16(anSegment.data()+3),lReadBE16(anSegment.data()+1));
+                    return oSize.width>0 && oSize.height>0;
+                }
+                if(nByte==0xE1 && nSegmentLength>=8) { // exif orientation tags may make the decoder rotate the image, so we let it decide
+                    if(!oFile.read((char*)anSegment.data(),6))
+                        return false;
+                    if(!memcmp(anSegment.data(),"Exif\0\0",6))
+                        return false;
+                    oFile.seekg(nSegmentLength-8,std::ios::cur);
+                }
+                else
+                    oFile.seekg(nSegmentLength-2,std::ios::cur);
+            }
+        }
+        return false;
+    }
+
+    /// loads a per-directory image metadata cache, mapping file names to their stats and dimensions (returns an empty map on failure)
+    std::map<std::string,ImageMetadataCacheEntry> loadImageMetadataCache(const std::string& sCacheFilePath) {
+        std::map<std::string,ImageMetadataCacheEntry> mEntries;
+        std::ifstream oCacheFile(sCacheFilePath,std::ios::in|std::ios::binary);
+        if(!oCacheFile.is_open())
+            return mEntries;
+        ImageMetadataCacheHeader oHeader;
+        if(!oCacheFile.read((char*)&oHeader,sizeof(oHeader)) || memcmp(oHeader.acMagic,IMAGE_METADATA_CACHE_MAGIC,sizeof(oHeader.acMagic)) || oHeader.nVersion!=IMAGE_METADATA_CACHE_VERSION)
+            return mEntries;
+        std::string sName;
+        for(uint64_t nEntryIdx=0; nEntryIdx<oHeader.nEntryCount; ++nEntryIdx) {
+            ImageMetadataCacheEntry oEntry;
+            if(!oCacheFile.read((char*)&oEntry,sizeof(oEntry)) || oEntry.nNameLength>FILENAME_MAX)
+                return std::map<std::string,ImageMetadataCacheEntry>();
+            sName.resize(oEntry.nNameLength);
+            if(!oCacheFile.read(&sName[0],oEntry.nNameLength))
+                return std::map<std::string,ImageMetadataCacheEntry>();
+            mEntries[sName] = oEntry;
+        }
+        return mEntries;
+    }
+
+    /// writes a per-directory image metadata cache (failures are silently ignored, as data directories may be read-only)
+    void saveImageMetadataCache(const std::string& sCacheFilePath, const std::vector<std::pair<std::string,ImageMetadataCacheEntry>>& voEntries) {
+        const std::string sTempFilePath = sCacheFilePath+".tmp";
+        {
+            std::ofstream oCacheFile(sTempFilePath,std::ios::out|std::ios::binary|std::ios::trunc);
+            if(!oCacheFile.is_open())
+                return;
+            ImageMetadataCacheHeader oHeader = {};
+            memcpy(oHeader.acMagic,IMAGE_METADATA_CACHE_MAGIC,sizeof(oHeader.acMagic));
+            oHeader.nVersion = IMAGE_METADATA_CACHE_VERSION;
+            oHeader.nEntryCount = voEntries.size();
+            oCacheFile.write((const char*)&oHeader,sizeof(oHeader));
+            for(const auto& oEntry : voEntries) {
+                oCacheFile.write((const char*)&oEntry.second,sizeof(oEntry.second));
+                oCacheFile.write(oEntry.first.data(),oEntry.first.size());
+            }
+            if(!oCacheFile)
+                return;
+        }
+        if(std::rename(sTempFilePath.c_str(),sCacheFilePath.c_str())!=0) {
+            std::remove(sCacheFilePath.c_str());
+            if(std::rename(sTempFilePath.c_str(),sCacheFilePath.c_str())!=0)
+                std::remove(sTempFilePath.c_str());
+        }
+    }
+
+} // namespace
+
+lv::DatasetIndex::DatasetIndex(const std::vector<std::string>& vsIndexFilePaths) :
+        m_vsIndexFilePaths(vsIndexFilePaths),m_bModified(false) {
+    lvAssert_(!m_vsIndexFilePaths.empty(),"dataset index requires at least one file path");
+    for(const std::string& sIndexFilePath : m_vsIndexFilePaths) {
+        std::ifstream oIndexFile(sIndexFilePath,std::ios::in|std::ios::binary);
+        if(!oIndexFile.is_open())
+            continue;
+        DatasetIndexHeader oHeader;
+        if(!oIndexFile.read((char*)&oHeader,sizeof(oHeader)) || memcmp(oHeader.acMagic,DATASET_INDEX_MAGIC,sizeof(oHeader.acMagic)) || oHeader.nVersion!=DATASET_INDEX_VERSION)
+            continue;
+        std::map<std::string,DirEntry> mDirEntries;
+        bool bValid = true;
+        for(uint64_t nDirIdx=0; bValid && nDirIdx<oHeader.nDirCount; ++nDirIdx) {
+            std::string sDirPath;
+            DirEntry oEntry;
+            uint8_t anFlags[2];
+            bValid = readIndexString(oIndexFile,sDirPath) &&
+                     oIndexFile.read((char*)&oEntry.nModifTime,sizeof(oEntry.nModifTime)) &&
+                     oIndexFile.read((char*)anFlags,sizeof(anFlags)) &&
+                     readIndexStrings(oIndexFile,oEntry.vsFilePaths) &&
+                     readIndexStrings(oIndexFile,oEntry.vsSubDirPaths);
+            oEntry.bHasFiles = anFlags[0]!=0;
+            oEntry.bHasSubDirs = anFlags[1]!=0;
+            if(bValid)
+                mDirEntries[sDirPath] = std::move(oEntry);
+        }
+        if(bValid) {
+            m_mDirEntries = std::move(mDirEntries);
+            return;
+        }
+    }
+}
+
+lv::DatasetIndex::DirEntry& lv::DatasetIndex::getDirEntry(const std::string& sDirPath) {
+    int64_t nModifTime=-1, nSize;
+    if(!lv::GetFileStats(sDirPath,nModifTime,nSize))
+        nModifTime = -1;
+    DirEntry& oEntry = m_mDirEntries[sDirPath];
+    if(oEntry.nModifTime!=nModifTime || nModifTime<0) {
+        oEntry.nModifTime = nModifTime;
+        oEntry.bHasFiles = oEntry.bHasSubDirs = false;
+        oEntry.vsFilePaths.clear();
+        oEntry.vsSubDirPaths.clear();
+    }
+    return oEntry;
+}
+
+void lv::DatasetIndex::getFilesFromDir(const std::string& sDirPath, std::vector<std::string>& vsFilePaths) {
+    std::mutex_lock_guard oLock(m_oMutex);
+    DirEntry& oEntry = getDirEntry(sDirPath);
+    if(!oEntry.bHasFiles) {
+        lv::GetFilesFromDir(sDirPath,oEntry.vsFilePaths);
+        // listings of missing or recently modified directories are not trusted (they might change within the same mtime tick)
+        oEntry.bHasFiles = oEntry.nModifTime>=0 && int64_t(time(nullptr))-oEntry.nModifTime>=DATASET_INDEX_MIN_DIR_AGE_SEC;
+        m_bModified |= oEntry.bHasFiles;
+    }
+    vsFilePaths = oEntry.vsFilePaths;
+}
+
+void lv::DatasetIndex::getSubDirsFromDir(const std::string& sDirPath, std::vector<std::string>& vsSubDirPaths) {
+    std::mutex_lock_guard oLock(m_oMutex);
+    DirEntry& oEntry = getDirEntry(sDirPath);
+    if(!oEntry.bHasSubDirs) {
+        lv::GetSubDirsFromDir(sDirPath,oEntry.vsSubDirPaths);
+        oEntry.bHasSubDirs = oEntry.nModifTime>=0 && int64_t(time(nullptr))-oEntry.nModifTime>=DATASET_INDEX_MIN_DIR_AGE_SEC;
+        m_bModified |= oEntry.bHasSubDirs;
+    }
+    vsSubDirPaths = oEntry.vsSubDirPaths;
+}
+
+bool lv::DatasetIndex::save() {
+    std::mutex_lock_guard oLock(m_oMutex);
+    if(!m_bModified)
+        return true;
+    for(const std::string& sIndexFilePath : m_vsIndexFilePaths) {
+        const std::string sTempFilePath = sIndexFilePath+".tmp";
+        {
+            std::ofstream oIndexFile(sTempFilePath,std::ios::out|std::ios::binary|std::ios::trunc);
+            if(!oIndexFile.is_open())
+                continue;
+            DatasetIndexHeader oHeader = {};
+            memcpy(oHeader.acMagic,DATASET_INDEX_MAGIC,sizeof(oHeader.acMagic));
+            oHeader.nVersion = DATASET_INDEX_VERSION;
+            for(const auto& oEntry : m_mDirEntries)
+                oHeader.nDirCount += uint64_t(oEntry.second.bHasFiles || oEntry.second.bHasSubDirs);
+            oIndexFile.write((const char*)&oHeader,sizeof(oHeader));
+            for(const auto& oEntry : m_mDirEntries) {
+                if(!oEntry.second.bHasFiles && !oEntry.second.bHasSubDirs)
+                    continue;
+                const uint8_t anFlags[2] = {uint8_t(oEntry.second.bHasFiles),uint8_t(oEntry.second.bHasSubDirs)};
+                writeIndexString(oIndexFile,oEntry.first);
+                oIndexFile.write((const char*)&oEntry.second.nModifTime,sizeof(oEntry.second.nModifTime));
+                oIndexFile.write((const char*)anFlags,sizeof(anFlags));
+                writeIndexStrings(oIndexFile,oEntry.second.vsFilePaths);
+                writeIndexStrings(oIndexFile,oEntry.second.vsSubDirPaths);
+            }
+            if(!oIndexFile) {
+                oIndexFile.close();
+                std::remove(sTempFilePath.c_str());
+                continue;
+            }
+        }
+        if(std::rename(sTempFilePath.c_str(),sIndexFilePath.c_str())!=0) {
+            std::remove(sIndexFilePath.c_str());
+            if(std::rename(sTempFilePath.c_str(),sIndexFilePath.c_str())!=0) {
+                std::remove(sTempFilePath.c_str());
+                continue;
+            }
+        }
+        m_bModified = false;
+        return true;
+    }
+    return false;
+}
+
+lv::BatchLoadHistory::BatchLoadHistory(const std::string& sFilePath) :
+        m_sFilePath(sFilePath) {
+    std::ifstream oFile(m_sFilePath);
+    std::string sLine;
+    while(std::getline(oFile,sLine)) {
+        // each line holds a processing time (in seconds) followed by the batch relative path (which may contain spaces)
+        std::istringstream ssLine(sLine);
+        double dProcessTime;
+        std::string sBatchRelPath;
+        if(ssLine >> dProcessTime && std::getline(ssLine >> std::ws,sBatchRelPath) && !sBatchRelPath.empty() && dProcessTime>0)
+            m_mProcessTimes[sBatchRelPath] = dProcessTime;
+    }
+}
+
+bool lv::BatchLoadHistory::getProcessTime(const std::string& sBatchRelPath, double& dProcessTime) const {
+    std::mutex_lock_guard oLock(m_oMutex);
+    const auto pEntry = m_mProcessTimes.find(sBatchRelPath);
+    if(pEntry==m_mProcessTimes.end())
+        return false;
+    dProcessTime = pEntry->second;
+    return true;
+}
+
+void lv::BatchLoadHistory::addProcessTime(const std::string& sBatchRelPath, double dProcessTime) {
+    if(!(dProcessTime>0))
+        return;
+    std::mutex_lock_guard oLock(m_oMutex);
+    const auto pEntry = m_mProcessTimes.find(sBatchRelPath);
+    if(pEntry==m_mProcessTimes.end())
+        m_mProcessTimes[sBatchRelPath] = dProcessTime;
+    else
+        pEntry->second += (dProcessTime-pEntry->second)*DATASETUTILS_LOAD_HISTORY_SMOOTHING;
+    const std::string sTempFilePath = m_sFilePath+".tmp";
+    {
+        std::ofstream oFile(sTempFilePath,std::ios::out|std::ios::trunc);
+        if(!oFile.is_open())
+            return;
+        oFile << std::setprecision(6) << std::scientific;
+        for(const auto& oEntry : m_mProcessTimes)
+            oFile << oEntry.second << " " << oEntry.first << "\n";
+        if(!oFile) {
+            oFile.close();
+            std::remove(sTempFilePath.c_str());
+            return;
+        }
+    }
+    if(std::rename(sTempFilePath.c_str(),m_sFilePath.c_str())!=0) {
+        std::remove(m_sFilePath.c_str());
+        if(std::rename(sTempFilePath.c_str(),m_sFilePath.c_str())!=0)
+            std::remove(sTempFilePath.c_str());
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -57,20 +513,531 @@ std::string lv::IDataHandler::getPacketName(size_t nPacketIdx) const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-lv::DataPrecacher::DataPrecacher(std::function<const cv::Mat&(size_t)> lDataLoaderCallback) :
-        m_lCallback(lDataLoaderCallback) {
+lv::BatchScheduler::BatchScheduler(size_t nWorkers) :
+        m_nWorkers(nWorkers==0?std::max((size_t)std::thread::hardware_concurrency(),size_t(1)):nWorkers),
+        m_nDevices(1),
+        m_nMinSegmentPackets(0) {}
+
+void lv::BatchScheduler::setDeviceCount(size_t nDevices) {
+    lvAssert_(nDevices>0,"batch scheduler needs at least one device");
+    m_nDevices = nDevices;
+}
+
+void lv::BatchScheduler::setSegmentation(size_t nMinSegmentPackets) {
+    m_nMinSegmentPackets = nMinSegmentPackets;
+}
+
+void lv::BatchScheduler::setProgressCallback(ProgressCallback lCallback) {
+    m_lProgressCallback = lCallback;
+}
+
+void lv::BatchScheduler::run(const IDataHandlerPtrArray& vpBatches, const TaskCallback& lTask) {
+    lvAssert_(lTask,"invalid batch scheduler task");
+    std::vector<Task> voTasks;
+    size_t nTotPackets = 0;
+    for(const IDataHandlerPtr& pBatch : vpBatches) {
+        lvAssert_(pBatch && !pBatch->isGroup(),"batch scheduler can only run on work batches");
+        const size_t nBatchPackets = pBatch->getTotPackets();
+        const double dBatchLoad = pBatch->getExpectedLoad();
+        const size_t nSegments = (m_nMinSegmentPackets>0 && m_nWorkers>1)?std::max(std::min(m_nWorkers,nBatchPackets/m_nMinSegmentPackets),size_t(1)):size_t(1);
+        for(size_t nSegmentIdx=0; nSegmentIdx<nSegments; ++nSegmentIdx) {
+            const size_t nBeginIdx = (nBatchPackets*nSegmentIdx)/nSegments, nEndIdx = (nBatchPackets*(nSegmentIdx+1))/nSegments;
+            voTasks.push_back(Task{pBatch,nBeginIdx,nEndIdx,dBatchLoad*(nEndIdx-nBeginIdx)/std::max(nBatchPackets,size_t(1))});
+        }
+        nTotPackets += nBatchPackets;
+    }
+    std::stable_sort(voTasks.begin(),voTasks.end(),[](const Task& a, const Task& b){return a.dLoad>b.dLoad;});
+    // tasks are dealt heaviest first to the least loaded device, then to its least loaded worker queue; idle workers then steal the lightest
+    // tasks left in other queues (from workers of their own device first)
+    const size_t nActiveWorkers = std::max(std::min(m_nWorkers,voTasks.size()),size_t(1));
+    const size_t nActiveDevices = std::min(m_nDevices,nActiveWorkers);
+    std::vector<std::deque<Task>> vqWorkerTasks(nActiveWorkers);
+    std::vector<double> vdWorkerLoads(nActiveWorkers,0.0), vdDeviceLoads(nActiveDevices,0.0);
+    std::vector<std::mutex> voWorkerMutexes(nActiveWorkers);
+    for(const Task& oTask : voTasks) {
+        const size_t nDeviceIdx = size_t(std::min_element(vdDeviceLoads.begin(),vdDeviceLoads.end())-vdDeviceLoads.begin());
+        size_t nWorkerIdx = nDeviceIdx;
+        for(size_t nCandidateIdx=nDeviceIdx+m_nDevices; nCandidateIdx<nActiveWorkers; nCandidateIdx+=m_nDevices)
+            if(vdWorkerLoads[nCandidateIdx]<vdWorkerLoads[nWorkerIdx])
+                nWorkerIdx = nCandidateIdx;
+        vqWorkerTasks[nWorkerIdx].push_back(oTask);
+        vdWorkerLoads[nWorkerIdx] += oTask.dLoad;
+        vdDeviceLoads[nDeviceIdx] += oTask.dLoad;
+    }
+    const auto lPopTask = [&](size_t nWorkerIdx, Task& oTask) -> bool {
+        {
+            std::mutex_lock_guard oLock(voWorkerMutexes[nWorkerIdx]);
+            if(!vqWorkerTasks[nWorkerIdx].empty()) {
+                oTask = vqWorkerTasks[nWorkerIdx].front();
+                vqWorkerTasks[nWorkerIdx].pop_front();
+                return true;
+            }
+        }
+        for(size_t nPassIdx=0; nPassIdx<2; ++nPassIdx) {
+            for(size_t nOffset=1; nOffset<nActiveWorkers; ++nOffset) {
+                const size_t nVictimIdx = (nWorkerIdx+nOffset)%nActiveWorkers;
+                if((getWorkerDeviceIdx(nVictimIdx)==getWorkerDeviceIdx(nWorkerIdx))!=(nPassIdx==0))
+                    continue;
+                std::mutex_lock_guard oLock(voWorkerMutexes[nVictimIdx]);
+                if(!vqWorkerTasks[nVictimIdx].empty()) {
+                    oTask = vqWorkerTasks[nVictimIdx].back();
+                    vqWorkerTasks[nVictimIdx].pop_back();
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+    std::mutex oProgressMutex;
+    std::exception_ptr pException;
+    std::atomic_bool bAborted(false);
+    size_t nDoneTasks = 0, nDonePackets = 0;
+    const auto lWorker = [&](size_t nWorkerIdx) {
+        lv::ApplyThreadPlacementPolicy(lv::ThreadRole_Analysis); // also applied to the calling thread, which acts as worker #0
+        Task oTask;
+        while(!bAborted && lPopTask(nWorkerIdx,oTask)) {
+            try {
+                lTask(oTask.pBatch,oTask.nBeginIdx,oTask.nEndIdx,nWorkerIdx);
+            }
+            catch(...) {
+                std::mutex_lock_guard oLock(oProgressMutex);
+                if(!pException)
+                    pException = std::current_exception();
+                bAborted = true;
+                return;
+            }
+            std::mutex_lock_guard oLock(oProgressMutex);
+            ++nDoneTasks;
+            nDonePackets += oTask.nEndIdx-oTask.nBeginIdx;
+            if(m_lProgressCallback)
+                m_lProgressCallback(oTask.pBatch,nDoneTasks,voTasks.size(),nDonePackets,nTotPackets);
+        }
+    };
+    std::vector<std::thread> vhWorkers;
+    for(size_t nWorkerIdx=1; nWorkerIdx<std::min(nActiveWorkers,voTasks.size()); ++nWorkerIdx)
+        vhWorkers.emplace_back(lWorker,nWorkerIdx);
+    lWorker(0);
+    for(std::thread& hWorker : vhWorkers)
+        hWorker.join();
+    if(pException)
+        std::rethrow_exception(pException);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double lv::PacketLatencyTracer::Histogram::getPercentile(double dPercentile) const {
+    lvAssert_(dPercentile>=0.0 && dPercentile<=1.0,"percentile must be in [0,1]");
+    if(nCount==0)
+        return 0.0;
+    const uint64_t nTarget = std::max(uint64_t(std::ceil(dPercentile*nCount)),uint64_t(1));
+    uint64_t nCumulCount = 0;
+    for(size_t nBinIdx=0; nBinIdx<anBinCounts.size(); ++nBinIdx) {
+        nCumulCount += anBinCounts[nBinIdx];
+        if(nCumulCount>=nTarget)
+            return std::min(double(uint64_t(1)<<(nBinIdx+1)),dMaxLatency_usec);
+    }
+    return dMaxLatency_usec;
+}
+
+lv::PacketLatencyTracer::PacketLatencyTracer(size_t nMaxPendingPackets) :
+        m_voRecords(std::max(nMaxPendingPackets,size_t(1))),
+        m_nCreationTime(std::chrono::steady_clock::now()) {
+    for(Record& oRecord : m_voRecords) {
+        oRecord.nIdx = SIZE_MAX;
+        oRecord.anStamps_usec.fill(-1);
+    }
+    for(Histogram& oHist : m_aoStageHists)
+        oHist = Histogram{};
+    m_oEndToEndHist = Histogram{};
+}
+
+void lv::PacketLatencyTracer::mark(size_t nIdx, Stage eStage, std::chrono::steady_clock::time_point nTime) {
+    lvDbgAssert(eStage>=0 && eStage<nStagesCount);
+    const int64_t nStamp_usec = std::chrono::duration_cast<std::chrono::microseconds>(nTime-m_nCreationTime).count();
+    std::mutex_lock_guard oLock(m_oMutex);
+    Record& oRecord = m_voRecords[nIdx%m_voRecords.size()];
+    if(oRecord.nIdx!=nIdx) {
+        // the slot is recycled once a packet far enough ahead is traced; its previous packet is considered done
+        finalize(oRecord);
+        oRecord.nIdx = nIdx;
+    }
+    if(oRecord.anStamps_usec[eStage]>=0)
+        return; // packets may be requested or written more than once; only the first pass is timed
+    oRecord.anStamps_usec[eStage] = nStamp_usec;
+    for(int nPrevStage=int(eStage)-1; nPrevStage>=0; --nPrevStage) {
+        if(oRecord.anStamps_usec[nPrevStage]>=0) {
+            addToHistogram(m_aoStageHists[eStage],double(nStamp_usec-oRecord.anStamps_usec[nPrevStage]));
+            break;
+        }
+    }
+}
+
+lv::PacketLatencyTracer::Histogram lv::PacketLatencyTracer::getStageHistogram(Stage eStage) const {
+    lvAssert_(eStage>=0 && eStage<nStagesCount,"invalid stage");
+    std::mutex_lock_guard oLock(m_oMutex);
+    return m_aoStageHists[eStage];
+}
+
+lv::PacketLatencyTracer::Histogram lv::PacketLatencyTracer::getEndToEndHistogram() const {
+    std::mutex_lock_guard oLock(m_oMutex);
+    return m_oEndToEndHist;
+}
+
+void lv::PacketLatencyTracer::flush() {
+    std::mutex_lock_guard oLock(m_oMutex);
+    for(Record& oRecord : m_voRecords)
+        finalize(oRecord);
+}
+
+void lv::PacketLatencyTracer::writeReport(const std::string& sFilePath) {
+    flush();
+    std::ofstream oReport(sFilePath);
+    lvAssert__(oReport.is_open(),"could not create latency report at '%s'",sFilePath.c_str());
+    const auto lWriteLine = [&](const char* sName, const Histogram& oHist) {
+        oReport << std::setw(12) << sName << "|" <<
+                   std::setw(12) << oHist.nCount << "|" <<
+                   std::setw(12) << ((oHist.nCount>0)?(oHist.dTotLatency_usec/oHist.nCount):0.0) << "|" <<
+                   std::setw(12) << oHist.getPercentile(0.5) << "|" <<
+                   std::setw(12) << oHist.getPercentile(0.9) << "|" <<
+                   std::setw(12) << oHist.getPercentile(0.99) << "|" <<
+                   std::setw(12) << oHist.dMaxLatency_usec << "\n";
+    };
+    std::mutex_lock_guard oLock(m_oMutex);
+    oReport << "Per-stage packet latencies (in usec, w.r.t. the previous stage reached by each packet; percentiles are bin upper bounds):\n\n";
+    oReport << "       Stage|       Count|        Mean|         p50|         p90|         p99|         Max\n";
+    oReport << "------------|------------|------------|------------|------------|------------|------------\n";
+    for(int nStage=0; nStage<nStagesCount; ++nStage)
+        if(m_aoStageHists[nStage].nCount>0)
+            lWriteLine(getStageName(Stage(nStage)),m_aoStageHists[nStage]);
+    lWriteLine("end-to-end",m_oEndToEndHist);
+    oReport << "\nHistogram bins (packet counts per [2^N,2^(N+1)) usec bin):\n\n";
+    for(int nStage=0; nStage<=nStagesCount; ++nStage) {
+        const Histogram& oHist = (nStage<nStagesCount)?m_aoStageHists[nStage]:m_oEndToEndHist;
+        if(oHist.nCount==0)
+            continue;
+        oReport << std::setw(12) << ((nStage<nStagesCount)?getStageName(Stage(nStage)):"end-to-end") << ":";
+        for(uint64_t nBinCount : oHist.anBinCounts)
+            oReport << " " << nBinCount;
+        oReport << "\n";
+    }
+}
+
+const char* lv::PacketLatencyTracer::getStageName(Stage eStage) {
+    static const std::array<const char*,nStagesCount> s_asStageNames = {"capture","decode","request","push","enqueue","write"};
+    lvAssert_(eStage>=0 && eStage<nStagesCount,"invalid stage");
+    return s_asStageNames[eStage];
+}
+
+void lv::PacketLatencyTracer::finalize(Record& oRecord) {
+    if(oRecord.nIdx==SIZE_MAX)
+        return;
+    int64_t nFirstStamp_usec = -1, nLastStamp_usec = -1;
+    for(int64_t nStamp_usec : oRecord.anStamps_usec) {
+        if(nStamp_usec<0)
+            continue;
+        if(nFirstStamp_usec<0 || nStamp_usec<nFirstStamp_usec)
+            nFirstStamp_usec = nStamp_usec;
+        nLastStamp_usec = std::max(nLastStamp_usec,nStamp_usec);
+    }
+    if(nLastStamp_usec>nFirstStamp_usec)
+        addToHistogram(m_oEndToEndHist,double(nLastStamp_usec-nFirstStamp_usec));
+    oRecord.nIdx = SIZE_MAX;
+    oRecord.anStamps_usec.fill(-1);
+}
+
+void lv::PacketLatencyTracer::addToHistogram(Histogram& oHist, double dLatency_usec) {
+    dLatency_usec = std::max(dLatency_usec,0.0);
+    size_t nBinIdx = 0;
+    while(nBinIdx+1<oHist.anBinCounts.size() && dLatency_usec>=double(uint64_t(1)<<(nBinIdx+1)))
+        ++nBinIdx;
+    ++oHist.anBinCounts[nBinIdx];
+    ++oHist.nCount;
+    oHist.dTotLatency_usec += dLatency_usec;
+    oHist.dMaxLatency_usec = std::max(oHist.dMaxLatency_usec,dLatency_usec);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+lv::BufferBudgetManager::Lease::Lease(BufferBudgetManager& oManager, const std::string& sName, size_t nRequestedSize) :
+        m_oManager(oManager),
+        m_sName(sName),
+        m_nRequestedSize(nRequestedSize),
+        m_dConsumptionRate(0.0),
+        m_dStallRatio(0.0),
+        m_bHasStats(false) {
+    m_nAllocatedSize = 0;
+    m_nConsumedBytes = m_nStalledTime_usec = 0;
+}
+
+lv::BufferBudgetManager::Lease::~Lease() {
+    std::mutex_lock_guard oLock(m_oManager.m_oMutex);
+    m_oManager.m_vpLeases.erase(std::find(m_oManager.m_vpLeases.begin(),m_oManager.m_vpLeases.end(),this));
+    m_oManager.rebalance();
+}
+
+void lv::BufferBudgetManager::Lease::reportActivity(size_t nConsumedBytes, double dStalledTime_sec) {
+    m_nConsumedBytes += nConsumedBytes;
+    m_nStalledTime_usec += size_t(std::max(dStalledTime_sec,0.0)*1e6);
+    m_oManager.rebalanceIfDue();
+}
+
+lv::BufferBudgetManager::BufferBudgetManager() :
+        m_nTotalSize(CACHE_MAX_SIZE),
+        m_nCreationTime(std::chrono::steady_clock::now()),
+        m_nLastRebalanceTime_usec(0) {
+    m_nNextRebalanceTime_usec = 0;
+}
+
+lv::BufferBudgetManager& lv::BufferBudgetManager::get() {
+    static BufferBudgetManager s_oManager;
+    return s_oManager;
+}
+
+void lv::BufferBudgetManager::setTotalSize(size_t nTotalSize) {
+    std::mutex_lock_guard oLock(m_oMutex);
+    m_nTotalSize = nTotalSize;
+    rebalance();
+}
+
+size_t lv::BufferBudgetManager::getTotalSize() const {
+    std::mutex_lock_guard oLock(m_oMutex);
+    return m_nTotalSize;
+}
+
+lv::BufferBudgetManager::LeasePtr lv::BufferBudgetManager::registerBuffer(const std::string& sName, size_t nRequestedSize) {
+    LeasePtr pLease(new Lease(*this,sName,nRequestedSize));
+    std::mutex_lock_guard oLock(m_oMutex);
+    m_vpLeases.push_back(pLease.get());
+    rebalance();
+    return pLease;
+}
+
+std::vector<lv::BufferBudgetManager::Allocation> lv::BufferBudgetManager::getAllocations() const {
+    std::mutex_lock_guard oLock(m_oMutex);
+    std::vector<Allocation> voAllocations;
+    voAllocations.reserve(m_vpLeases.size());
+    for(const Lease* pLease : m_vpLeases)
+        voAllocations.push_back(Allocation{pLease->m_sName,pLease->m_nRequestedSize,pLease->m_nAllocatedSize,pLease->m_dConsumptionRate,pLease->m_dStallRatio});
+    return voAllocations;
+}
+
+int64_t lv::BufferBudgetManager::getElapsedTime_usec() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-m_nCreationTime).count();
+}
+
+void lv::BufferBudgetManager::rebalanceIfDue() {
+    int64_t nNextRebalanceTime_usec = m_nNextRebalanceTime_usec;
+    const int64_t nCurrTime_usec = getElapsedTime_usec();
+    // only the reporter winning the exchange rebalances, others keep going without touching the mutex
+    if(nCurrTime_usec<nNextRebalanceTime_usec || !m_nNextRebalanceTime_usec.compare_exchange_strong(nNextRebalanceTime_usec,nCurrTime_usec+BUFFERBUDGET_REBALANCE_PERIOD_MS*1000))
+        return;
+    std::mutex_lock_guard oLock(m_oMutex);
+    rebalance();
+}
+
+void lv::BufferBudgetManager::rebalance() {
+    const int64_t nCurrTime_usec = getElapsedTime_usec();
+    const double dElapsedTime_sec = double(nCurrTime_usec-m_nLastRebalanceTime_usec)/1e6;
+    m_nLastRebalanceTime_usec = nCurrTime_usec;
+    m_nNextRebalanceTime_usec = nCurrTime_usec+BUFFERBUDGET_REBALANCE_PERIOD_MS*1000;
+    const size_t nLeases = m_vpLeases.size();
+    if(nLeases==0)
+        return;
+    // buffers that are drained quickly (or that keep their users waiting) get a larger share of what remains after the guaranteed minimums
+    std::vector<double> vdWeights(nLeases,0.0);
+    double dTotStatsWeight = 0.0;
+    size_t nStatsCount = 0;
+    for(size_t nLeaseIdx=0; nLeaseIdx<nLeases; ++nLeaseIdx) {
+        Lease& oLease = *m_vpLeases[nLeaseIdx];
+        const size_t nConsumedBytes = oLease.m_nConsumedBytes.exchange(0);
+        const size_t nStalledTime_usec = oLease.m_nStalledTime_usec.exchange(0);
+        if(dElapsedTime_sec>0.0 && (oLease.m_bHasStats || nConsumedBytes>0 || nStalledTime_usec>0)) {
+            const double dConsumptionRate = nConsumedBytes/dElapsedTime_sec;
+            const double dStallRatio = std::min(nStalledTime_usec/(dElapsedTime_sec*1e6),1.0);
+            const double dSmoothing = oLease.m_bHasStats?BUFFERBUDGET_STATS_SMOOTHING:0.0;
+            oLease.m_dConsumptionRate = dSmoothing*oLease.m_dConsumptionRate+(1.0-dSmoothing)*dConsumptionRate;
+            oLease.m_dStallRatio = dSmoothing*oLease.m_dStallRatio+(1.0-dSmoothing)*dStallRatio;
+            oLease.m_bHasStats = true;
+        }
+        if(oLease.m_bHasStats) {
+            vdWeights[nLeaseIdx] = (oLease.m_dConsumptionRate+1.0)*(1.0+BUFFERBUDGET_STALL_WEIGHT*oLease.m_dStallRatio);
+            dTotStatsWeight += vdWeights[nLeaseIdx];
+            ++nStatsCount;
+        }
+    }
+    // buffers without any activity reported yet are given the average weight, so that new ones start on par with the others
+    const double dDefaultWeight = nStatsCount?dTotStatsWeight/nStatsCount:1.0;
+    for(size_t nLeaseIdx=0; nLeaseIdx<nLeases; ++nLeaseIdx)
+        if(!m_vpLeases[nLeaseIdx]->m_bHasStats)
+            vdWeights[nLeaseIdx] = dDefaultWeight;
+    const size_t nMinShare = m_nTotalSize/(nLeases*BUFFERBUDGET_MIN_SHARE_FRACTION);
+    std::vector<size_t> vnAllocatedSizes(nLeases);
+    std::vector<bool> vbCapped(nLeases);
+    size_t nRemainingSize = m_nTotalSize;
+    for(size_t nLeaseIdx=0; nLeaseIdx<nLeases; ++nLeaseIdx) {
+        vnAllocatedSizes[nLeaseIdx] = std::min(m_vpLeases[nLeaseIdx]->m_nRequestedSize,nMinShare);
+        vbCapped[nLeaseIdx] = (vnAllocatedSizes[nLeaseIdx]==m_vpLeases[nLeaseIdx]->m_nRequestedSize);
+        nRemainingSize -= vnAllocatedSizes[nLeaseIdx];
+    }
+    // water-filling: buffers whose weighted share exceeds their requested size are capped, and the surplus is split again between the others
+    while(nRemainingSize>0) {
+        double dTotWeight = 0.0;
+        for(size_t nLeaseIdx=0; nLeaseIdx<nLeases; ++nLeaseIdx)
+            if(!vbCapped[nLeaseIdx])
+                dTotWeight += vdWeights[nLeaseIdx];
+        if(dTotWeight<=0.0)
+            break;
+        bool bNewlyCapped = false;
+        for(size_t nLeaseIdx=0; nLeaseIdx<nLeases; ++nLeaseIdx) {
+            const size_t nMissingSize = m_vpLeases[nLeaseIdx]->m_nRequestedSize-vnAllocatedSizes[nLeaseIdx];
+            if(!vbCapped[nLeaseIdx] && nRemainingSize*(vdWeights[nLeaseIdx]/dTotWeight)>=double(nMissingSize)) {
+                vnAllocatedSizes[nLeaseIdx] += nMissingSize;
+                nRemainingSize -= nMissingSize;
+                vbCapped[nLeaseIdx] = bNewlyCapped = true;
+            }
+        }
+        if(!bNewlyCapped) {
+            for(size_t nLeaseIdx=0; nLeaseIdx<nLeases; ++nLeaseIdx)
+                if(!vbCapped[nLeaseIdx])
+                    vnAllocatedSizes[nLeaseIdx] += size_t(nRemainingSize*(vdWeights[nLeaseIdx]/dTotWeight));
+            break;
+        }
+    }
+    for(size_t nLeaseIdx=0; nLeaseIdx<nLeases; ++nLeaseIdx)
+        m_vpLeases[nLeaseIdx]->m_nAllocatedSize = vnAllocatedSizes[nLeaseIdx];
+    lvLogDebug("buffer budget manager rebalanced %zu buffer(s) (%zu/%zu mb)",nLeases,(std::accumulate(vnAllocatedSizes.begin(),vnAllocatedSizes.end(),size_t(0))/1024)/1024,(m_nTotalSize/1024)/1024);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+lv::AsyncFileReader::AsyncFileReader(const std::vector<std::string>& vsFilePaths, size_t nMaxInFlight, size_t nThreads) :
+        m_vsFilePaths(vsFilePaths),
+        m_nMaxInFlight(nMaxInFlight),
+        m_nNextQueueIdx(0),
+        m_bStopping(false) {
+    lvAssert_(nMaxInFlight>0 && nThreads>0,"async file reader requires at least one thread & in-flight read");
+    for(size_t nThreadIdx=0; nThreadIdx<nThreads; ++nThreadIdx)
+        m_vhWorkers.emplace_back(&AsyncFileReader::entry,this);
+}
+
+lv::AsyncFileReader::~AsyncFileReader() {
+    {
+        std::mutex_lock_guard oLock(m_oMutex);
+        m_bStopping = true;
+        m_oQueueCondVar.notify_all();
+    }
+    for(std::thread& hWorker : m_vhWorkers)
+        hWorker.join();
+}
+
+bool lv::AsyncFileReader::readFile(const std::string& sFilePath, std::vector<uchar>& vBuffer) {
+    std::ifstream oFile(sFilePath,std::ios::in|std::ios::binary|std::ios::ate);
+    if(!oFile.is_open())
+        return false;
+    const std::streamoff nFileSize = oFile.tellg();
+    if(nFileSize<0)
+        return false;
+    vBuffer.resize(size_t(nFileSize));
+    oFile.seekg(0);
+    return bool(oFile.read((char*)vBuffer.data(),nFileSize));
+}
+
+bool lv::AsyncFileReader::read(size_t nIdx, std::vector<uchar>& vBuffer) {
+    if(nIdx>=m_vsFilePaths.size())
+        return false;
+    std::mutex_unique_lock oLock(m_oMutex);
+    // slots far behind the request were skipped (e.g. after a seek); requests outside the read-ahead window restart it
+    while(!m_mReadSlots.empty() && m_mReadSlots.begin()->first+m_nMaxInFlight<nIdx)
+        m_mReadSlots.erase(m_mReadSlots.begin());
+    if(nIdx>=m_nNextQueueIdx || nIdx+m_nMaxInFlight<m_nNextQueueIdx)
+        m_nNextQueueIdx = nIdx+1;
+    while(m_mReadSlots.size()<m_nMaxInFlight && m_nNextQueueIdx<m_vsFilePaths.size()) {
+        if(!m_mReadSlots.count(m_nNextQueueIdx) && m_nNextQueueIdx!=nIdx) {
+            m_mReadSlots[m_nNextQueueIdx] = ReadSlot{false,false,std::vector<uchar>()};
+            m_qnQueuedIdxs.push_back(m_nNextQueueIdx);
+        }
+        ++m_nNextQueueIdx;
+    }
+    m_oQueueCondVar.notify_all();
+    auto pSlotIter = m_mReadSlots.find(nIdx);
+    if(pSlotIter==m_mReadSlots.end()) {
+        oLock.unlock();
+        return readFile(m_vsFilePaths[nIdx],vBuffer);
+    }
+    m_oDoneCondVar.wait(oLock,[&]{return pSlotIter->second.bDone;});
+    const bool bSuccess = pSlotIter->second.bSuccess;
+    vBuffer = std::move(pSlotIter->second.vBuffer);
+    m_mReadSlots.erase(pSlotIter);
+    return bSuccess;
+}
+
+void lv::AsyncFileReader::entry() {
+    LV_PROFILE_THREAD_NAME("file-reader");
+    lv::ApplyThreadPlacementPolicy(lv::ThreadRole_Precacher);
+    std::mutex_unique_lock oLock(m_oMutex);
+    while(true) {
+        m_oQueueCondVar.wait(oLock,[&]{return m_bStopping || !m_qnQueuedIdxs.empty();});
+        if(m_bStopping)
+            break;
+        const size_t nIdx = m_qnQueuedIdxs.front();
+        m_qnQueuedIdxs.pop_front();
+        if(!m_mReadSlots.count(nIdx)) // dropped before being read
+            continue;
+        oLock.unlock();
+        std::vector<uchar> vBuffer;
+        bool bSuccess;
+        {
+            LV_PROFILE_SCOPE("AsyncFileReader::readFile");
+            bSuccess = readFile(m_vsFilePaths[nIdx],vBuffer);
+        }
+        oLock.lock();
+        auto pSlotIter = m_mReadSlots.find(nIdx);
+        if(pSlotIter!=m_mReadSlots.end()) {
+            pSlotIter->second.vBuffer = std::move(vBuffer);
+            pSlotIter->second.bSuccess = bSuccess;
+            pSlotIter->second.bDone = true;
+            m_oDoneCondVar.notify_all();
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+lv::DataPrecacher::DataPrecacher(std::function<const cv::Mat&(size_t)> lDataLoaderCallback, std::function<cv::Mat(size_t)> lReentrantDataLoaderCallback) :
+        m_lCallback(lDataLoaderCallback),
+        m_lReentrantCallback(lReentrantDataLoaderCallback),
+        m_nDecodeWorkerCount(1),
+        m_pMemoryTag(lv::MemoryTracker::createTag("data precacher",this)) {
     lvAssert_(m_lCallback,"invalid data precacher callback");
     m_bIsActive = false;
     m_nReqIdx = m_nLastReqIdx = size_t(-1);
+    m_nDecodeWindowStart = m_nNextDecodeIdx = m_nDecodeWindowSize = m_nDecodeGeneration = 0;
+    m_nCacheHitCount = m_nCacheMissCount = 0;
 }
 
 lv::DataPrecacher::~DataPrecacher() {
     stopAsyncPrecaching();
 }
 
+lv::MemoryTracker::Usage lv::DataPrecacher::getMemoryUsage() const {
+    return lv::MemoryTracker::getUsage(*m_pMemoryTag);
+}
+
 const cv::Mat& lv::DataPrecacher::getPacket(size_t nIdx) {
-    if(nIdx==m_nLastReqIdx)
+    LV_PROFILE_SCOPE("DataPrecacher::getPacket");
+    if(nIdx==m_nLastReqIdx) {
+        if(m_bIsActive)
+            ++m_nCacheHitCount;
         return m_oLastReqPacket;
+    }
     else if(!m_bIsActive) {
         m_oLastReqPacket = m_lCallback(nIdx);
         m_nLastReqIdx = nIdx;
@@ -82,10 +1049,8 @@ const cv::Mat& lv::DataPrecacher::getPacket(size_t nIdx) {
     do {
         m_oReqCondVar.notify_one();
         res = m_oSyncCondVar.wait_for(sync_lock,std::chrono::milliseconds(PRECACHE_REQUEST_TIMEOUT_MS));
-#if CONSOLE_DEBUG
         if(res==std::cv_status::timeout)
-            std::cout << "data precacher [" << uintptr_t(this) << "] retrying request for packet #" << nIdx << "..." << std::endl;
-#endif //CONSOLE_DEBUG
+            lvLogDebug("data precacher [%p] retrying request for packet #%zu...",(void*)this,nIdx);
     } while(res==std::cv_status::timeout);
     m_oLastReqPacket = m_oReqPacket;
     m_nLastReqIdx = nIdx;
@@ -101,7 +1066,18 @@ bool lv::DataPrecacher::startAsyncPrecaching(size_t nSuggestedBufferSize) {
     if(nSuggestedBufferSize>0) {
         m_bIsActive = true;
         m_nReqIdx = size_t(-1);
-        m_hWorker = std::thread(&DataPrecacher::entry,this,(nSuggestedBufferSize>CACHE_MAX_SIZE)?(CACHE_MAX_SIZE):nSuggestedBufferSize);
+        m_nCacheHitCount = m_nCacheMissCount = 0;
+        m_qoPrefetchHints = std::queue<std::pair<size_t,size_t>>();
+        if(m_lReentrantCallback && m_nDecodeWorkerCount>1) {
+            m_mDecodedPackets.clear();
+            m_nDecodeWindowStart = m_nNextDecodeIdx = 0;
+            m_nDecodeWindowSize = m_nDecodeWorkerCount*PRECACHE_DECODE_WINDOW_PER_WORKER;
+            ++m_nDecodeGeneration;
+            for(size_t nWorkerIdx=0; nWorkerIdx<m_nDecodeWorkerCount; ++nWorkerIdx)
+                m_vhDecoders.emplace_back(&DataPrecacher::decoderEntry,this);
+        }
+        m_pBudgetLease = BufferBudgetManager::get().registerBuffer("data precacher ["+std::to_string(uintptr_t(this))+"]",(nSuggestedBufferSize>CACHE_MAX_SIZE)?(CACHE_MAX_SIZE):nSuggestedBufferSize);
+        m_hWorker = std::thread(&DataPrecacher::entry,this);
     }
     return m_bIsActive;
 }
@@ -109,116 +1085,253 @@ bool lv::DataPrecacher::startAsyncPrecaching(size_t nSuggestedBufferSize) {
 void lv::DataPrecacher::stopAsyncPrecaching() {
     if(m_bIsActive) {
         m_bIsActive = false;
+        m_oDecodeReqCondVar.notify_all();
+        m_oDecodeDoneCondVar.notify_all();
         m_hWorker.join();
+        for(std::thread& hDecoder : m_vhDecoders)
+            hDecoder.join();
+        m_vhDecoders.clear();
+        m_mDecodedPackets.clear();
+        m_qoPrefetchHints = std::queue<std::pair<size_t,size_t>>();
+        m_pBudgetLease = nullptr;
     }
 }
 
-void lv::DataPrecacher::entry(const size_t nBufferSize) {
+void lv::DataPrecacher::prefetch(size_t nBegin, size_t nEnd) {
+    if(!m_bIsActive || nBegin>=nEnd)
+        return;
+    std::mutex_lock_guard hint_lock(m_oHintMutex);
+    m_qoPrefetchHints.emplace(nBegin,nEnd);
+}
+
+void lv::DataPrecacher::setDecodeWorkerCount(size_t nWorkers) {
+    lvAssert_(nWorkers>0,"decode worker count must be positive");
+    m_nDecodeWorkerCount = nWorkers;
+}
+
+void lv::DataPrecacher::decoderEntry() {
+    LV_PROFILE_THREAD_NAME("precache-decoder");
+    lv::ApplyThreadPlacementPolicy(lv::ThreadRole_Precacher);
+    const lv::MemoryTracker::Scope oMemoryScope(m_pMemoryTag);
+    std::mutex_unique_lock decode_lock(m_oDecodeMutex);
+    while(m_bIsActive) {
+        if(m_nNextDecodeIdx>=m_nDecodeWindowStart+m_nDecodeWindowSize) {
+            m_oDecodeReqCondVar.wait_for(decode_lock,std::chrono::milliseconds(PRECACHE_QUERY_TIMEOUT_MS));
+            continue;
+        }
+        const size_t nIdx = m_nNextDecodeIdx++;
+        const size_t nGeneration = m_nDecodeGeneration;
+        decode_lock.unlock();
+        cv::Mat oPacket;
+        {
+            LV_PROFILE_SCOPE("DataPrecacher::decodePacket");
+            oPacket = m_lReentrantCallback(nIdx);
+        }
+        decode_lock.lock();
+        if(nGeneration==m_nDecodeGeneration) { // packets decoded before a seek are dropped
+            m_mDecodedPackets[nIdx] = oPacket;
+            m_oDecodeDoneCondVar.notify_all();
+        }
+    }
+}
+
+cv::Mat lv::DataPrecacher::loadPacket(size_t nIdx) {
+    LV_PROFILE_SCOPE("DataPrecacher::loadPacket");
+    // only ever called from the precaching thread, so the by-value callback is safe to use here even if loading is not reentrant
+    return m_lReentrantCallback?m_lReentrantCallback(nIdx):m_lCallback(nIdx);
+}
+
+cv::Mat lv::DataPrecacher::fetchPacket(size_t nIdx) {
+    if(m_vhDecoders.empty())
+        return loadPacket(nIdx);
+    std::mutex_unique_lock decode_lock(m_oDecodeMutex);
+    if(nIdx<m_nDecodeWindowStart || nIdx>m_nNextDecodeIdx) {
+        lvLogDebug("data precacher [%p] resetting decode pool at packet #%zu",(void*)this,nIdx);
+        m_mDecodedPackets.clear();
+        m_nNextDecodeIdx = nIdx;
+        ++m_nDecodeGeneration;
+    }
+    else
+        m_mDecodedPackets.erase(m_mDecodedPackets.begin(),m_mDecodedPackets.lower_bound(nIdx));
+    m_nDecodeWindowStart = nIdx;
+    m_oDecodeReqCondVar.notify_all();
+    auto pPacketIter = m_mDecodedPackets.find(nIdx);
+    while(pPacketIter==m_mDecodedPackets.end() && m_bIsActive) {
+        m_oDecodeDoneCondVar.wait_for(decode_lock,std::chrono::milliseconds(PRECACHE_QUERY_TIMEOUT_MS));
+        pPacketIter = m_mDecodedPackets.find(nIdx);
+    }
+    if(pPacketIter==m_mDecodedPackets.end()) // stopping, decoders are gone
+        return loadPacket(nIdx);
+    // decoded packets are handed over (so their buffers can be adopted by the cache); fetching the same index again restarts decoding from it
+    const cv::Mat oPacket = pPacketIter->second;
+    m_mDecodedPackets.erase(pPacketIter);
+    m_nDecodeWindowStart = nIdx+1;
+    return oPacket;
+}
+
+void lv::DataPrecacher::entry() {
+    LV_PROFILE_THREAD_NAME("precacher");
+    lv::ApplyThreadPlacementPolicy(lv::ThreadRole_Precacher);
+    const lv::MemoryTracker::Scope oMemoryScope(m_pMemoryTag);
     std::mutex_unique_lock sync_lock(m_oSyncMutex);
-    std::queue<cv::Mat> qoCache;
-    std::vector<uchar> vcBuffer(nBufferSize);
-    size_t nNextExpectedReqIdx = 0;
-    size_t nNextPrecacheIdx = 0;
-    size_t nFirstBufferIdx = 0;
-    size_t nNextBufferIdx = 0;
-#if CONSOLE_DEBUG
-    std::cout << "data precacher [" << uintptr_t(this) << "] init w/ buffer size = " << (nBufferSize/1024)/1024 << " mb" << std::endl;
-#endif //CONSOLE_DEBUG
+    // cached packets are indexed by packet id and handed out as ref-counted views of pooled buffers; a buffer is only reused (or freed) once no other mat references it
+    std::map<size_t,cv::Mat> mCache;
+    std::vector<cv::Mat> voBufferPool;
+    size_t nPoolSize = 0;
+    size_t nCursorIdx = 0; // index of the last requested packet, around which packets are prefetched in both directions
+    size_t nStreamEndIdx = SIZE_MAX; // index of the first packet found to be empty (nothing is prefetched past it)
+    // the buffer size follows the allocation granted by the budget manager, which may change at any time
+    size_t nBufferSize,nBackwardBufferSize,nForwardBufferSize;
+    const auto lUpdateBufferSize = [&]() {
+        nBufferSize = m_pBudgetLease->getAllocatedSize();
+        nBackwardBufferSize = nBufferSize/PRECACHE_BACKWARD_BUFFER_FRACTION;
+        nForwardBufferSize = nBufferSize-nBackwardBufferSize;
+    };
+    lUpdateBufferSize();
+    lvLogDebug("data precacher [%p] init w/ buffer size = %zu mb",(void*)this,size_t((nBufferSize/1024)/1024));
+    const auto lGetPacketSize = [](const cv::Mat& oPacket) {
+        return oPacket.total()*oPacket.elemSize();
+    };
+    const auto lGetCursorDistance = [&](size_t nIdx) {
+        // packets behind the cursor get a smaller share of the buffer, so their distance is scaled up accordingly
+        return (nIdx>=nCursorIdx)?(nIdx-nCursorIdx):((nCursorIdx-nIdx)*(PRECACHE_BACKWARD_BUFFER_FRACTION-1));
+    };
+    const auto lReservePoolSpace = [&](size_t nPacketSize, size_t nIdx) -> bool {
+        while(true) {
+            for(auto pBufferIter=voBufferPool.begin(); nPoolSize+nPacketSize>nBufferSize && pBufferIter!=voBufferPool.end();) {
+                if(pBufferIter->u->refcount==1) {
+                    nPoolSize -= lGetPacketSize(*pBufferIter);
+                    pBufferIter = voBufferPool.erase(pBufferIter);
+                }
+                else
+                    ++pBufferIter;
+            }
+            if(nPoolSize+nPacketSize<=nBufferSize)
+                return true;
+            if(mCache.empty())
+                return false;
+            // evicts the cached packet farthest from the cursor (always at one end of the index map), if it is farther than the new one
+            const auto pFarthestIter = (lGetCursorDistance(mCache.begin()->first)>=lGetCursorDistance(mCache.rbegin()->first))?mCache.begin():std::prev(mCache.end());
+            if(lGetCursorDistance(pFarthestIter->first)<=lGetCursorDistance(nIdx))
+                return false;
+            mCache.erase(pFarthestIter);
+        }
+    };
+    const auto lAcquireBuffer = [&](const cv::Mat& oPacket, size_t nIdx) -> cv::Mat {
+        for(const cv::Mat& oBuffer : voBufferPool)
+            if(oBuffer.u->refcount==1 && oBuffer.size==oPacket.size && oBuffer.type()==oPacket.type())
+                return oBuffer;
+        if(!lReservePoolSpace(lGetPacketSize(oPacket),nIdx))
+            return cv::Mat();
+        voBufferPool.emplace_back(oPacket.dims,oPacket.size.p,oPacket.type());
+        nPoolSize += lGetPacketSize(oPacket);
+        return voBufferPool.back();
+    };
+    const auto lFetchPacket = [&](size_t nIdx, bool bSequential) -> cv::Mat {
+        // only loads moving forward from the cursor go through the (sequential) decode pool, others would reset it
+        cv::Mat oPacket = bSequential?fetchPacket(nIdx):loadPacket(nIdx);
+        if(oPacket.empty())
+            nStreamEndIdx = std::min(nStreamEndIdx,nIdx);
+        return oPacket;
+    };
+    const auto lCachePacket = [&](size_t nIdx, const cv::Mat& oPacket) -> bool {
+        if(oPacket.empty())
+            return false;
+        const size_t nPacketSize = lGetPacketSize(oPacket);
+        if(oPacket.u && oPacket.u->refcount==1 && oPacket.u->size==nPacketSize) {
+            // freshly decoded packets that nobody else references are adopted as pool buffers directly (no copy)
+            if(!lReservePoolSpace(nPacketSize,nIdx))
+                return false;
+            voBufferPool.push_back(oPacket);
+            nPoolSize += nPacketSize;
+            mCache[nIdx] = oPacket;
+            return true;
+        }
+        cv::Mat oPacket_cache = lAcquireBuffer(oPacket,nIdx);
+        if(oPacket_cache.empty())
+            return false;
+        oPacket.copyTo(oPacket_cache);
+        mCache[nIdx] = oPacket_cache;
+        return true;
+    };
+    const auto lPrefetchHintedPacket = [&]() -> bool {
+        size_t nHintIdx = SIZE_MAX;
+        {
+            std::mutex_lock_guard hint_lock(m_oHintMutex);
+            while(!m_qoPrefetchHints.empty() && nHintIdx==SIZE_MAX) {
+                std::pair<size_t,size_t>& oHint = m_qoPrefetchHints.front();
+                while(oHint.first<oHint.second && (oHint.first>=nStreamEndIdx || mCache.count(oHint.first)))
+                    ++oHint.first;
+                if(oHint.first<oHint.second)
+                    nHintIdx = oHint.first++;
+                else
+                    m_qoPrefetchHints.pop();
+            }
+        }
+        if(nHintIdx==SIZE_MAX)
+            return false;
+        if(!lCachePacket(nHintIdx,lFetchPacket(nHintIdx,false))) {
+            // no room left for hinted packets without evicting closer ones; drop remaining hints instead of retrying them forever
+            std::mutex_lock_guard hint_lock(m_oHintMutex);
+            m_qoPrefetchHints = std::queue<std::pair<size_t,size_t>>();
+        }
+        return true;
+    };
+    const auto lPrefetchNextPacket = [&]() -> bool {
+        if(lPrefetchHintedPacket())
+            return true;
+        size_t nForwardSize = 0, nBackwardSize = 0;
+        for(const auto& oCachedPacket : mCache)
+            ((oCachedPacket.first>=nCursorIdx)?nForwardSize:nBackwardSize) += lGetPacketSize(oCachedPacket.second);
+        size_t nNextIdx = nCursorIdx;
+        while(mCache.count(nNextIdx))
+            ++nNextIdx;
+        if(nForwardSize<nForwardBufferSize && nNextIdx<nStreamEndIdx)
+            return lCachePacket(nNextIdx,lFetchPacket(nNextIdx,true));
+        if(nBackwardSize<nBackwardBufferSize && nCursorIdx>0) {
+            size_t nPrevIdx = nCursorIdx-1;
+            while(nPrevIdx>0 && mCache.count(nPrevIdx))
+                --nPrevIdx;
+            if(!mCache.count(nPrevIdx))
+                return lCachePacket(nPrevIdx,lFetchPacket(nPrevIdx,false));
+        }
+        return false;
+    };
     const std::chrono::time_point<std::chrono::high_resolution_clock> nPrefillTick = std::chrono::high_resolution_clock::now();
-    while(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now()-nPrefillTick).count()<PRECACHE_PREFILL_TIMEOUT_MS) {
-        const cv::Mat& oNextPacket = m_lCallback(nNextPrecacheIdx);
-        const size_t nNextPacketSize = oNextPacket.total()*oNextPacket.elemSize();
-        if(nNextPacketSize>0 && nNextBufferIdx+nNextPacketSize<nBufferSize) {
-            cv::Mat oNextPacket_cache(oNextPacket.size(),oNextPacket.type(),vcBuffer.data()+nNextBufferIdx);
-            oNextPacket.copyTo(oNextPacket_cache);
-            qoCache.push(oNextPacket_cache);
-            nNextBufferIdx += nNextPacketSize;
-            ++nNextPrecacheIdx;
-        }
-        else break;
-    }
+    while(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now()-nPrefillTick).count()<PRECACHE_PREFILL_TIMEOUT_MS)
+        if(!lPrefetchNextPacket())
+            break;
     while(m_bIsActive) {
-        if(m_oReqCondVar.wait_for(sync_lock,std::chrono::milliseconds(PRECACHE_QUERY_TIMEOUT_MS))!=std::cv_status::timeout) {
-            if(m_nReqIdx!=nNextExpectedReqIdx-1) {
-                if(!qoCache.empty()) {
-                    if(m_nReqIdx<nNextPrecacheIdx && m_nReqIdx>=nNextExpectedReqIdx) {
-//#if CONSOLE_DEBUG
-//                        std::cout << "data precacher [" << uintptr_t(this) << "] popping " << m_nReqIdx-nNextExpectedReqIdx+1 << " packet(s) from cache" << std::endl;
-//#endif //CONSOLE_DEBUG
-                        while(m_nReqIdx-nNextExpectedReqIdx+1>0) {
-                            m_oReqPacket = qoCache.front();
-                            nFirstBufferIdx = (size_t)(m_oReqPacket.data-vcBuffer.data());
-                            qoCache.pop();
-                            ++nNextExpectedReqIdx;
-                        }
-                    }
-                    else {
-#if CONSOLE_DEBUG
-                        std::cout << "data precacher [" << uintptr_t(this) << "] out-of-order request, destroying cache" << std::endl;
-#endif //CONSOLE_DEBUG
-                        qoCache = std::queue<cv::Mat>();
-                        m_oReqPacket = m_lCallback(m_nReqIdx);
-                        nFirstBufferIdx = nNextBufferIdx = size_t(-1);
-                        nNextExpectedReqIdx = nNextPrecacheIdx = m_nReqIdx+1;
-                    }
-                }
-                else {
-#if CONSOLE_DEBUG
-                    std::cout << "data precacher [" << uintptr_t(this) << "] answering request manually, precaching is falling behind" << std::endl;
-#endif //CONSOLE_DEBUG
-                    m_oReqPacket = m_lCallback(m_nReqIdx);
-                    nFirstBufferIdx = nNextBufferIdx = size_t(-1);
-                    nNextExpectedReqIdx = nNextPrecacheIdx = m_nReqIdx+1;
-                }
+        lUpdateBufferSize();
+        if(nPoolSize>nBufferSize)
+            lReservePoolSpace(0,nCursorIdx); // the allocation shrank; evicts the packets farthest from the cursor until the pool fits again
+        if(m_oReqCondVar.wait_for(sync_lock,std::chrono::milliseconds(PRECACHE_QUERY_TIMEOUT_MS))!=std::cv_status::timeout && m_nReqIdx!=size_t(-1)) {
+            nCursorIdx = m_nReqIdx;
+            auto pCacheIter = mCache.find(m_nReqIdx);
+            double dStalledTime_sec = 0.0;
+            if(pCacheIter!=mCache.end()) {
+                m_oReqPacket = pCacheIter->second;
+                ++m_nCacheHitCount;
+            }
+            else {
+                lvLogDebug("data precacher [%p] cache miss, answering request for packet #%zu manually",(void*)this,size_t(m_nReqIdx));
+                ++m_nCacheMissCount;
+                lv::StopWatch oStallWatch;
+                const cv::Mat oPacket = lFetchPacket(m_nReqIdx,true);
+                if(lCachePacket(m_nReqIdx,oPacket))
+                    m_oReqPacket = mCache[m_nReqIdx];
+                else
+                    m_oReqPacket = oPacket.clone();
+                dStalledTime_sec = oStallWatch.tock();
             }
-#if CONSOLE_DEBUG
-            else
-                std::cout << "data precacher [" << uintptr_t(this) << "] answering request using last packet" << std::endl;
-#endif //CONSOLE_DEBUG
             m_oSyncCondVar.notify_one();
+            m_pBudgetLease->reportActivity(lGetPacketSize(m_oReqPacket),dStalledTime_sec);
         }
         else {
-            size_t nUsedBufferSize = nFirstBufferIdx==size_t(-1)?0:(nFirstBufferIdx<nNextBufferIdx?nNextBufferIdx-nFirstBufferIdx:nBufferSize-nFirstBufferIdx+nNextBufferIdx);
-            if(nUsedBufferSize<nBufferSize/4) {
-#if CONSOLE_DEBUG
-                std::cout << "data precacher [" << uintptr_t(this) << "] filling precache buffer... (current size = " << (nUsedBufferSize/1024)/1024 << " mb)" << std::endl;
-#endif //CONSOLE_DEBUG
-                size_t nFillCount = 0;
-                while(nUsedBufferSize<nBufferSize && nFillCount<10) {
-                    const cv::Mat& oNextPacket = m_lCallback(nNextPrecacheIdx);
-                    const size_t nNextPacketSize = oNextPacket.total()*oNextPacket.elemSize();
-                    if(nNextPacketSize==0)
-                        break;
-                    else if(nFirstBufferIdx<=nNextBufferIdx) {
-                        if(nNextBufferIdx==size_t(-1) || (nNextBufferIdx+nNextPacketSize>=nBufferSize)) {
-                            if((nFirstBufferIdx!=size_t(-1) && nNextPacketSize>=nFirstBufferIdx) || nNextPacketSize>=nBufferSize)
-                                break;
-                            cv::Mat oNextPacket_cache(oNextPacket.size(),oNextPacket.type(),vcBuffer.data());
-                            oNextPacket.copyTo(oNextPacket_cache);
-                            qoCache.push(oNextPacket_cache);
-                            nNextBufferIdx = nNextPacketSize;
-                            if(nFirstBufferIdx==size_t(-1))
-                                nFirstBufferIdx = 0;
-                        }
-                        else { // nNextBufferIdx+nNextPacketSize<m_nBufferSize
-                            cv::Mat oNextPacket_cache(oNextPacket.size(),oNextPacket.type(),vcBuffer.data()+nNextBufferIdx);
-                            oNextPacket.copyTo(oNextPacket_cache);
-                            qoCache.push(oNextPacket_cache);
-                            nNextBufferIdx += nNextPacketSize;
-                        }
-                    }
-                    else if(nNextBufferIdx+nNextPacketSize<nFirstBufferIdx) {
-                        cv::Mat oNextPacket_cache(oNextPacket.size(),oNextPacket.type(),vcBuffer.data()+nNextBufferIdx);
-                        oNextPacket.copyTo(oNextPacket_cache);
-                        qoCache.push(oNextPacket_cache);
-                        nNextBufferIdx += nNextPacketSize;
-                    }
-                    else // nNextBufferIdx+nNextPacketSize>=nFirstBufferIdx
-                        break;
-                    nUsedBufferSize += nNextPacketSize;
-                    ++nNextPrecacheIdx;
-                }
-            }
+            lvLogDebug("data precacher [%p] filling precache buffer... (current pool size = %zu mb)",(void*)this,size_t((nPoolSize/1024)/1024));
+            for(size_t nFillCount=0; nFillCount<10; ++nFillCount)
+                if(!lPrefetchNextPacket())
+                    break;
         }
     }
 }
@@ -228,65 +1341,283 @@ void lv::DataPrecacher::entry(const size_t nBufferSize) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void lv::IDataLoader::startAsyncPrecaching(bool bUsingGT, size_t nSuggestedBufferSize) {
+    if(m_pPackedCache)
+        return; // packets are already served as views of the mapped file
+    m_oInputPrecacher.setDecodeWorkerCount(isPacketLoadReentrant()?m_nPrecacheDecodeWorkerCount:1);
+    m_oGTPrecacher.setDecodeWorkerCount(isPacketLoadReentrant()?m_nPrecacheDecodeWorkerCount:1);
     lvAssert_(m_oInputPrecacher.startAsyncPrecaching(nSuggestedBufferSize),"could not start precaching input packets");
-    lvAssert_(!bUsingGT || m_oGTPrecacher.startAsyncPrecaching(nSuggestedBufferSize),"could not start precaching gt packets");
+    if(bUsingGT && !(m_nGTPolicyFlags&GTPolicy_OnDemand)) {
+        m_bGTPrecacheCompact = (m_nGTPolicyFlags&GTPolicy_Compact) && m_eGTMappingType==PixelMapping && m_eInputType==ImagePacket;
+        // compact packets are 4x smaller, but the suggested size still bounds the worst case (i.e. packets that could not be encoded)
+        lvAssert_(m_oGTPrecacher.startAsyncPrecaching(nSuggestedBufferSize),"could not start precaching gt packets");
+    }
 }
 
 void lv::IDataLoader::stopAsyncPrecaching() {
     m_oInputPrecacher.stopAsyncPrecaching();
     m_oGTPrecacher.stopAsyncPrecaching();
+    m_bGTPrecacheCompact = false;
+    m_oDecodedGTPacket = cv::Mat();
+}
+
+cv::Mat lv::IDataLoader::getInputBatch(size_t nFirstIdx, size_t nCount, std::vector<cv::Mat>* pvoPacketViews) {
+    const size_t nTotPackets = getTotPackets();
+    nCount = (nFirstIdx<nTotPackets)?std::min(nCount,nTotPackets-nFirstIdx):size_t(0);
+    if(pvoPacketViews)
+        pvoPacketViews->clear();
+    if(nCount==0)
+        return cv::Mat();
+    m_oInputPrecacher.prefetch(nFirstIdx+nCount,std::min(nFirstIdx+nCount*2,nTotPackets));
+    const cv::Mat& oFirstPacket = m_oInputPrecacher.getPacket(nFirstIdx);
+    lvAssert_(!oFirstPacket.empty() && oFirstPacket.dims==2,"input batches can only be built from non-empty 2d packets");
+    // the first packet reference is invalidated by the next request, so its layout is kept aside for the checks below
+    const cv::Size oPacketSize = oFirstPacket.size();
+    const int anBatchDims[3] = {int(nCount),oPacketSize.height,oPacketSize.width};
+    const int nType = oFirstPacket.type();
+    // the stacked buffer is only recycled when the caller released all views of the previous batch (as for precacher buffers)
+    if(m_oInputBatchBuffer.empty() || m_oInputBatchBuffer.u->refcount!=1 || m_oInputBatchBuffer.type()!=nType ||
+       m_oInputBatchBuffer.size[0]!=anBatchDims[0] || m_oInputBatchBuffer.size[1]!=anBatchDims[1] || m_oInputBatchBuffer.size[2]!=anBatchDims[2])
+        m_oInputBatchBuffer = cv::Mat(3,anBatchDims,nType);
+    lvDbgAssert(m_oInputBatchBuffer.isContinuous());
+    // packet views are row ranges of a 2d reshape of the buffer, so they keep it referenced on their own
+    const int anStackedDims[2] = {int(nCount)*oPacketSize.height,oPacketSize.width};
+    const cv::Mat oStackedPackets = m_oInputBatchBuffer.reshape(0,2,anStackedDims);
+    for(size_t nOffset=0; nOffset<nCount; ++nOffset) {
+        // the first packet is copied right away, before the next request overwrites it
+        const cv::Mat& oPacket = (nOffset==0)?oFirstPacket:m_oInputPrecacher.getPacket(nFirstIdx+nOffset);
+        lvAssert__(oPacket.dims==2 && oPacket.size()==oPacketSize && oPacket.type()==nType,"input packet #%d does not match the size/type of the first packet in the batch",int(nFirstIdx+nOffset));
+        cv::Mat oSlice = oStackedPackets.rowRange(int(nOffset)*oPacketSize.height,int(nOffset+1)*oPacketSize.height);
+        oPacket.copyTo(oSlice);
+        lvDbgAssert(oSlice.data==oStackedPackets.data+oSlice.step.p[0]*oPacketSize.height*nOffset);
+        if(pvoPacketViews)
+            pvoPacketViews->push_back(oSlice);
+    }
+    return m_oInputBatchBuffer;
+}
+
+const cv::Mat& lv::IDataLoader::getGT(size_t nPacketIdx) {
+    const cv::Mat& oPacket = m_oGTPrecacher.getPacket(nPacketIdx);
+    if(!m_bGTPrecacheCompact || oPacket.type()!=COMPACT_GT_PACKET_TYPE)
+        return oPacket;
+    // the previous decoded packet is only overwritten if nobody else holds a reference to it (as for precacher buffers)
+    if(m_oDecodedGTPacket.u && m_oDecodedGTPacket.u->refcount!=1)
+        m_oDecodedGTPacket = cv::Mat();
+    decodeCompactGTPacket(oPacket,m_oDecodedGTPacket);
+    return m_oDecodedGTPacket;
+}
+
+void lv::IDataLoader::setPrecacheDecodeWorkerCount(size_t nWorkers) {
+    lvAssert_(nWorkers>0,"decode worker count must be positive");
+    m_nPrecacheDecodeWorkerCount = nWorkers;
+}
+
+void lv::IDataLoader::writePackedCache(const std::string& sFilePath, bool bWithGT) {
+    static_assert(sizeof(PackedCacheHeader)%8==0 && sizeof(PackedCachePlane)%8==0,"bad packed cache struct packing");
+    const size_t nPacketCount = getTotPackets();
+    lvAssert_(nPacketCount>0,"cannot pack an empty batch");
+    std::ofstream oFile(sFilePath,std::ios::out|std::ios::binary|std::ios::trunc);
+    lvAssert__(oFile.is_open(),"could not create packed cache file at '%s'",sFilePath.c_str());
+    PackedCacheHeader oHeader = {};
+    std::copy_n(PACKED_CACHE_MAGIC,sizeof(oHeader.acMagic),oHeader.acMagic);
+    oHeader.nVersion = PACKED_CACHE_VERSION;
+    oHeader.nFlags = (bWithGT?PackedCacheFlag_HasGT:0)|(getDatasetInfo()->is4ByteAligned()?PackedCacheFlag_4ByteAligned:0);
+    oHeader.nPacketCount = nPacketCount;
+    oHeader.dScaleFactor = getDatasetInfo()->getScaleFactor();
+    std::vector<PackedCachePlane> voPlanes(nPacketCount*2,PackedCachePlane{});
+    oFile.write((const char*)&oHeader,sizeof(oHeader));
+    oFile.write((const char*)voPlanes.data(),voPlanes.size()*sizeof(PackedCachePlane));
+    size_t nFileOffset = sizeof(oHeader)+voPlanes.size()*sizeof(PackedCachePlane);
+    const std::array<char,PACKED_CACHE_ALIGNMENT> acPadding = {};
+    const auto lWritePlane = [&](const cv::Mat& oPacket, PackedCachePlane& oPlane) {
+        if(oPacket.empty())
+            return;
+        lvAssert_(oPacket.dims==2,"packed cache only supports 2d packets");
+        const cv::Mat oData = oPacket.isContinuous()?oPacket:oPacket.clone();
+        const size_t nPaddingSize = (PACKED_CACHE_ALIGNMENT-nFileOffset%PACKED_CACHE_ALIGNMENT)%PACKED_CACHE_ALIGNMENT;
+        oFile.write(acPadding.data(),nPaddingSize);
+        nFileOffset += nPaddingSize;
+        oPlane.nOffset = nFileOffset;
+        oPlane.nRows = oData.rows;
+        oPlane.nCols = oData.cols;
+        oPlane.nType = oData.type();
+        const size_t nPlaneSize = oData.total()*oData.elemSize();
+        oFile.write((const char*)oData.data,nPlaneSize);
+        nFileOffset += nPlaneSize;
+    };
+    for(size_t nPacketIdx=0; nPacketIdx<nPacketCount; ++nPacketIdx) {
+        lWritePlane(_loadInputPacket(nPacketIdx),voPlanes[nPacketIdx*2]);
+        if(bWithGT)
+            lWritePlane(_loadGTPacket(nPacketIdx),voPlanes[nPacketIdx*2+1]);
+    }
+    oFile.seekp(sizeof(oHeader));
+    oFile.write((const char*)voPlanes.data(),voPlanes.size()*sizeof(PackedCachePlane));
+    lvAssert__(oFile.good(),"failed to write packed cache file at '%s'",sFilePath.c_str());
+}
+
+void lv::IDataLoader::usePackedCache(const std::string& sFilePath) {
+    std::shared_ptr<const MappedFile> pFile = std::make_shared<const MappedFile>(sFilePath);
+    lvAssert__(pFile->size()>=sizeof(PackedCacheHeader),"packed cache file at '%s' is truncated",sFilePath.c_str());
+    const PackedCacheHeader& oHeader = *(const PackedCacheHeader*)pFile->data();
+    lvAssert__(std::equal(oHeader.acMagic,oHeader.acMagic+sizeof(oHeader.acMagic),PACKED_CACHE_MAGIC) && oHeader.nVersion==PACKED_CACHE_VERSION,"bad packed cache file header in '%s'",sFilePath.c_str());
+    lvAssert_(oHeader.nPacketCount==getTotPackets(),"packed cache packet count mismatch with batch packet count");
+    lvAssert_(oHeader.dScaleFactor==getDatasetInfo()->getScaleFactor() && bool(oHeader.nFlags&PackedCacheFlag_4ByteAligned)==getDatasetInfo()->is4ByteAligned(),"packed cache was written using different packet transformations");
+    lvAssert__(pFile->size()>=sizeof(PackedCacheHeader)+oHeader.nPacketCount*2*sizeof(PackedCachePlane),"packed cache file at '%s' is truncated",sFilePath.c_str());
+    const PackedCachePlane* const pPlanes = (const PackedCachePlane*)(pFile->data()+sizeof(PackedCacheHeader));
+    for(size_t nPlaneIdx=0; nPlaneIdx<oHeader.nPacketCount*2; ++nPlaneIdx) {
+        const PackedCachePlane& oPlane = pPlanes[nPlaneIdx];
+        const size_t nPlaneSize = size_t(oPlane.nRows)*size_t(oPlane.nCols)*CV_ELEM_SIZE(oPlane.nType);
+        lvAssert__(oPlane.nRows>=0 && oPlane.nCols>=0 && (nPlaneSize==0 || oPlane.nOffset+nPlaneSize<=pFile->size()),"packed cache file at '%s' is truncated or corrupted",sFilePath.c_str());
+    }
+    stopAsyncPrecaching();
+    m_pPackedCache = pFile;
+    m_bPackedCacheHasGT = bool(oHeader.nFlags&PackedCacheFlag_HasGT);
+}
+
+void lv::IDataLoader::useSharedPackedCache(const std::string& sCacheDirPath, bool bWithGT) {
+    const std::string sDirPath = lv::AddDirSlashIfMissing(sCacheDirPath.empty()?getDatasetInfo()->getOutputPath():sCacheDirPath);
+    lvAssert_(!sDirPath.empty(),"shared packed cache requires a cache directory or a dataset output directory");
+    // the key covers everything that changes packed packet contents, so that processes using other transforms never collide
+    std::stringstream ssFileName;
+    ssFileName << "litiv_" << getDatasetInfo()->getName() << "_" << getRelativePath() << "_s" << getDatasetInfo()->getScaleFactor() << (getDatasetInfo()->is4ByteAligned()?"_a4":"") << (bWithGT?"_gt":"");
+    std::string sFileName = ssFileName.str();
+    std::replace_if(sFileName.begin(),sFileName.end(),[](char c){return c=='/' || c=='\\' || c==':' || c==' ';},'_');
+    const std::string sFilePath = sDirPath+sFileName+".lvpkc";
+    lv::CreateDirIfNotExist(sDirPath);
+    {
+        // writers publish via rename, so a cache file that exists is always complete; stale ones (e.g. dataset changed) are rewritten
+        lv::FileLock oLock(sFilePath+".lock");
+        int64_t nModifTime,nFileSize;
+        if(lv::GetFileStats(sFilePath,nModifTime,nFileSize)) {
+            try {
+                usePackedCache(sFilePath);
+                return;
+            }
+            catch(const std::exception&) {
+                std::cout << "\tShared packed cache '" << sFilePath << "' is outdated, rewriting it..." << std::endl;
+            }
+        }
+        const std::string sTempFilePath = sFilePath+".tmp";
+        writePackedCache(sTempFilePath,bWithGT);
+        if(std::rename(sTempFilePath.c_str(),sFilePath.c_str())!=0) {
+            std::remove(sFilePath.c_str());
+            lvAssert__(std::rename(sTempFilePath.c_str(),sFilePath.c_str())==0,"could not publish shared packed cache at '%s'",sFilePath.c_str());
+        }
+    }
+    usePackedCache(sFilePath);
+}
+
+cv::Mat lv::IDataLoader::_getPackedPacket(size_t nIdx, bool bGT) const {
+    lvDbgAssert(m_pPackedCache && nIdx<getTotPackets());
+    const PackedCachePlane& oPlane = ((const PackedCachePlane*)(m_pPackedCache->data()+sizeof(PackedCacheHeader)))[nIdx*2+(bGT?1:0)];
+    if(oPlane.nRows==0 || oPlane.nCols==0)
+        return cv::Mat();
+    // the mapping is read-only, so returned packets must never be altered (as already required by the precacher)
+    return cv::Mat(oPlane.nRows,oPlane.nCols,oPlane.nType,(void*)(m_pPackedCache->data()+oPlane.nOffset));
 }
 
 lv::IDataLoader::IDataLoader(PacketPolicy eInputType, PacketPolicy eOutputType, MappingPolicy eGTMappingType, MappingPolicy eIOMappingType) :
-        m_oInputPrecacher(std::bind(&IDataLoader::_getInputPacket_redirect,this,std::placeholders::_1)),
-        m_oGTPrecacher(std::bind(&IDataLoader::_getGTPacket_redirect,this,std::placeholders::_1)),
+        m_oInputPrecacher(std::bind(&IDataLoader::_getInputPacket_redirect,this,std::placeholders::_1),std::bind(&IDataLoader::_loadInputPacket,this,std::placeholders::_1)),
+        m_oGTPrecacher(std::bind(&IDataLoader::_getGTPacket_redirect,this,std::placeholders::_1),std::bind(&IDataLoader::_loadPrecachedGTPacket,this,std::placeholders::_1)),
+        m_nGTPolicyFlags(GTPolicy_Default),
+        m_bGTPrecacheCompact(false),
+        m_nPrecacheDecodeWorkerCount(1),
+        m_bPackedCacheHasGT(false),
         m_eInputType(eInputType),m_eOutputType(eOutputType),m_eGTMappingType(eGTMappingType),m_eIOMappingType(eIOMappingType) {}
 
-const cv::Mat& lv::IDataLoader::_getInputPacket_redirect(size_t nIdx) {
+cv::Mat lv::IDataLoader::_loadInputPacket(size_t nIdx) {
     if(nIdx>=getTotPackets())
-        return cv::emptyMat();
-    m_oLatestInputPacket = _getInputPacket_impl(nIdx);
-    if(!m_oLatestInputPacket.empty()) {
-        lvAssert_(getInputOrigSize(nIdx)==m_oLatestInputPacket.size(),"expected packet size does not match loaded packet size"); // @@@ compare N-dims here?
+        return cv::Mat();
+    if(m_pPackedCache)
+        return _getPackedPacket(nIdx,false);
+    cv::Mat oPacket = _getInputPacket_impl(nIdx);
+    if(!oPacket.empty()) {
+        const cv::Size& oOrigSize = getInputOrigSize(nIdx);
+        // image packets may come from a reduced decode (see readInputImagePacket), in which case the resize below only handles the residual scaling
+        lvAssert_(oOrigSize==oPacket.size() || (m_eInputType==ImagePacket && oPacket.cols<oOrigSize.width && oPacket.rows<oOrigSize.height),"expected packet size does not match loaded packet size"); // @@@ compare N-dims here?
         if(m_eInputType==ImagePacket) {
             if(isInputTransposed(nIdx))
-                cv::transpose(m_oLatestInputPacket,m_oLatestInputPacket);
+                cv::transpose(oPacket,oPacket);
 #if HARDCODE_IMAGE_PACKET_INDEX
             std::stringstream sstr;
             sstr << "Packet #" << nIdx;
-            writeOnImage(m_oLatestInputPacket,sstr.str(),cv::Scalar_<uchar>::all(255);
+            writeOnImage(oPacket,sstr.str(),cv::Scalar_<uchar>::all(255);
 #endif //HARDCODE_IMAGE_PACKET_INDEX
-            if(getDatasetInfo()->is4ByteAligned() && m_oLatestInputPacket.channels()==3)
-                cv::cvtColor(m_oLatestInputPacket,m_oLatestInputPacket,cv::COLOR_BGR2BGRA);
+            if(getDatasetInfo()->is4ByteAligned() && oPacket.channels()==3)
+                cv::cvtColor(oPacket,oPacket,cv::COLOR_BGR2BGRA);
             const cv::Size& oPacketSize = getInputSize(nIdx);
-            if(oPacketSize.area()>0 && m_oLatestInputPacket.size()!=oPacketSize)
-                cv::resize(m_oLatestInputPacket,m_oLatestInputPacket,oPacketSize,0,0,cv::INTER_NEAREST);
+            if(oPacketSize.area()>0 && oPacket.size()!=oPacketSize)
+                cv::resize(oPacket,oPacket,oPacketSize,0,0,cv::INTER_NEAREST);
         }
+        if(PacketLatencyTracer* pTracer = getLatencyTracer())
+            pTracer->mark(nIdx,PacketLatencyTracer::Stage_Decode);
+    }
+    return oPacket;
+}
+
+cv::Mat lv::IDataLoader::readInputImagePacket(const std::string& sFilePath, size_t nIdx, const std::vector<uchar>* pvFileData) const {
+    const bool bGrayscale = isGrayscale();
+    int nFlags = bGrayscale?cv::IMREAD_GRAYSCALE:cv::IMREAD_COLOR;
+#if IMAGE_PACKET_USE_REDUCED_DECODE
+    const cv::Size& oOrigSize = getInputOrigSize(nIdx);
+    cv::Size oTargetSize = getInputSize(nIdx);
+    if(isInputTransposed(nIdx)) // target size is given post-transposition
+        std::swap(oTargetSize.width,oTargetSize.height);
+    if(m_eInputType==ImagePacket && oOrigSize.area()>0 && oTargetSize.area()>0) {
+        // largest power-of-two reduction for which the decoded packet is still at least as large as the target (reduced sizes are rounded up)
+        int nReduction = 1;
+        while(nReduction<8 && oOrigSize.width>=oTargetSize.width*nReduction*2 && oOrigSize.height>=oTargetSize.height*nReduction*2)
+            nReduction *= 2;
+        if(nReduction>1)
+            nFlags = (nReduction==2)?(bGrayscale?cv::IMREAD_REDUCED_GRAYSCALE_2:cv::IMREAD_REDUCED_COLOR_2):
+                     (nReduction==4)?(bGrayscale?cv::IMREAD_REDUCED_GRAYSCALE_4:cv::IMREAD_REDUCED_COLOR_4):
+                                     (bGrayscale?cv::IMREAD_REDUCED_GRAYSCALE_8:cv::IMREAD_REDUCED_COLOR_8);
     }
+#endif //IMAGE_PACKET_USE_REDUCED_DECODE
+    if(pvFileData)
+        return pvFileData->empty()?cv::Mat():cv::imdecode(*pvFileData,nFlags);
+    return cv::imread(sFilePath,nFlags);
+}
+
+const cv::Mat& lv::IDataLoader::_getInputPacket_redirect(size_t nIdx) {
+    m_oLatestInputPacket = _loadInputPacket(nIdx);
     return m_oLatestInputPacket;
 }
 
-const cv::Mat& lv::IDataLoader::_getGTPacket_redirect(size_t nIdx) {
+cv::Mat lv::IDataLoader::_loadGTPacket(size_t nIdx) {
     if(nIdx>=getTotPackets())
-        return cv::emptyMat();
-    m_oLatestGTPacket = _getGTPacket_impl(nIdx);
-    if(!m_oLatestGTPacket.empty()) {
-        lvAssert_(getGTOrigSize(nIdx)==m_oLatestGTPacket.size(),"expected packet size does not match loaded packet size"); // @@@ compare N-dims here?
+        return cv::Mat();
+    if(m_pPackedCache && m_bPackedCacheHasGT)
+        return _getPackedPacket(nIdx,true);
+    if((m_nGTPolicyFlags&GTPolicy_SkipOutOfScope) && m_eGTMappingType==PixelMapping && m_eInputType==ImagePacket && isGTOutOfScope(nIdx))
+        return cv::Mat(getGTSize(nIdx),CV_8UC1,cv::Scalar_<uchar>(DATASETUTILS_OUTOFSCOPE_VAL)); // already post-transform, no need to decode
+    cv::Mat oPacket = _getGTPacket_impl(nIdx);
+    if(!oPacket.empty()) {
+        lvAssert_(getGTOrigSize(nIdx)==oPacket.size(),"expected packet size does not match loaded packet size"); // @@@ compare N-dims here?
         if(m_eGTMappingType==PixelMapping && m_eInputType==ImagePacket) {
             if(isGTTransposed(nIdx))
-                cv::transpose(m_oLatestGTPacket,m_oLatestGTPacket);
+                cv::transpose(oPacket,oPacket);
 #if HARDCODE_IMAGE_PACKET_INDEX
             std::stringstream sstr;
             sstr << "Packet #" << nIdx;
-            writeOnImage(m_oLatestGTPacket,sstr.str(),cv::Scalar_<uchar>::all(255);
+            writeOnImage(oPacket,sstr.str(),cv::Scalar_<uchar>::all(255);
 #endif //HARDCODE_IMAGE_PACKET_INDEX
-            if(getDatasetInfo()->is4ByteAligned() && m_oLatestGTPacket.channels()==3)
-                cv::cvtColor(m_oLatestGTPacket,m_oLatestGTPacket,cv::COLOR_BGR2BGRA);
+            if(getDatasetInfo()->is4ByteAligned() && oPacket.channels()==3)
+                cv::cvtColor(oPacket,oPacket,cv::COLOR_BGR2BGRA);
             const cv::Size& oPacketSize = getGTSize(nIdx);
-            if(oPacketSize.area()>0 && m_oLatestGTPacket.size()!=oPacketSize)
-                cv::resize(m_oLatestGTPacket,m_oLatestGTPacket,oPacketSize,0,0,cv::INTER_NEAREST);
+            if(oPacketSize.area()>0 && oPacket.size()!=oPacketSize)
+                cv::resize(oPacket,oPacket,oPacketSize,0,0,cv::INTER_NEAREST);
         }
     }
+    return oPacket;
+}
+
+cv::Mat lv::IDataLoader::_loadPrecachedGTPacket(size_t nIdx) {
+    cv::Mat oPacket = _loadGTPacket(nIdx);
+    return m_bGTPrecacheCompact?encodeCompactGTPacket(oPacket):oPacket;
+}
+
+const cv::Mat& lv::IDataLoader::_getGTPacket_redirect(size_t nIdx) {
+    m_oLatestGTPacket = _loadPrecachedGTPacket(nIdx);
     return m_oLatestGTPacket;
 }
 
@@ -303,7 +1634,7 @@ void lv::IDataProducer_<lv::DatasetSource_Video>::startAsyncPrecaching(bool bUsi
 }
 
 lv::IDataProducer_<lv::DatasetSource_Video>::IDataProducer_(PacketPolicy eOutputType, MappingPolicy eGTMappingType, MappingPolicy eIOMappingType) :
-        IDataLoader(ImagePacket,eOutputType,eGTMappingType,eIOMappingType),m_nFrameCount(0),m_nNextExpectedVideoReaderFrameIdx(size_t(-1)),m_bTransposeFrames(false) {}
+        IDataLoader(ImagePacket,eOutputType,eGTMappingType,eIOMappingType),m_nFrameCount(0),m_nNextExpectedVideoReaderFrameIdx(size_t(-1)),m_nTemporalROIBegin(0),m_nTemporalROIEnd(SIZE_MAX),m_bTransposeFrames(false) {}
 
 size_t lv::IDataProducer_<lv::DatasetSource_Video>::getTotPackets() const {
     return m_nFrameCount;
@@ -354,23 +1685,53 @@ cv::Mat lv::IDataProducer_<lv::DatasetSource_Video>::_getInputPacket_impl(size_t
     lvAssert_(nFrameIdx<getTotPackets(),"requested frame index is out of range");
     cv::Mat oFrame;
     if(!m_voVideoReader.isOpened())
-        oFrame = cv::imread(m_vsInputPaths[nFrameIdx],isGrayscale()?cv::IMREAD_GRAYSCALE:cv::IMREAD_COLOR);
+        oFrame = readInputImagePacket(m_vsInputPaths[nFrameIdx],nFrameIdx);
     else {
-        if(m_nNextExpectedVideoReaderFrameIdx!=nFrameIdx) {
-            m_voVideoReader.set(cv::CAP_PROP_POS_FRAMES,(double)nFrameIdx);
-            m_nNextExpectedVideoReaderFrameIdx = nFrameIdx+1;
-        }
-        else
-            ++m_nNextExpectedVideoReaderFrameIdx;
+        if(m_nNextExpectedVideoReaderFrameIdx!=nFrameIdx)
+            seekVideoReader(nFrameIdx);
         m_voVideoReader >> oFrame;
+        ++m_nNextExpectedVideoReaderFrameIdx;
     }
     return oFrame;
 }
 
+bool lv::IDataProducer_<lv::DatasetSource_Video>::openVideoReader(const std::string& sVideoFilePath) {
+#if VIDEO_READER_USE_HW_ACCELERATION && (CV_VERSION_MAJOR>4 || (CV_VERSION_MAJOR==4 && (CV_VERSION_MINOR>5 || (CV_VERSION_MINOR==5 && CV_VERSION_REVISION>=2))))
+    if(m_voVideoReader.open(sVideoFilePath,cv::CAP_ANY,{cv::CAP_PROP_HW_ACCELERATION,cv::VIDEO_ACCELERATION_ANY}))
+        return true;
+#endif //VIDEO_READER_USE_HW_ACCELERATION && (CV_VERSION >= 4.5.2)
+    return m_voVideoReader.open(sVideoFilePath);
+}
+
+void lv::IDataProducer_<lv::DatasetSource_Video>::seekVideoReader(size_t nFrameIdx) {
+    lvDbgAssert(m_voVideoReader.isOpened());
+    if(m_nNextExpectedVideoReaderFrameIdx<nFrameIdx && nFrameIdx-m_nNextExpectedVideoReaderFrameIdx<=VIDEO_READER_MAX_GRAB_SKIP_FRAMES) {
+        // grabbing decodes without retrieving/converting frames, which beats a keyframe seek + decode for short jumps
+        while(m_nNextExpectedVideoReaderFrameIdx<nFrameIdx && m_voVideoReader.grab())
+            ++m_nNextExpectedVideoReaderFrameIdx;
+    }
+    else {
+        m_voVideoReader.set(cv::CAP_PROP_POS_FRAMES,(double)nFrameIdx);
+        // some backends land on the nearest keyframe instead of the requested frame; back up if we overshot, and decode forward from there
+        double dCurrPos = m_voVideoReader.get(cv::CAP_PROP_POS_FRAMES);
+        if(dCurrPos>(double)nFrameIdx) {
+            m_voVideoReader.set(cv::CAP_PROP_POS_FRAMES,(double)(nFrameIdx>VIDEO_READER_SEEK_PREROLL_FRAMES?nFrameIdx-VIDEO_READER_SEEK_PREROLL_FRAMES:0));
+            dCurrPos = m_voVideoReader.get(cv::CAP_PROP_POS_FRAMES);
+        }
+        if(dCurrPos>=0.0)
+            for(size_t nCurrPos=(size_t)dCurrPos; nCurrPos<nFrameIdx && m_voVideoReader.grab(); ++nCurrPos);
+    }
+    m_nNextExpectedVideoReaderFrameIdx = nFrameIdx;
+}
+
+bool lv::IDataProducer_<lv::DatasetSource_Video>::isPacketLoadReentrant() const {
+    return !m_voVideoReader.isOpened(); // image sequences only, the video reader is stateful
+}
+
 cv::Mat lv::IDataProducer_<lv::DatasetSource_Video>::_getGTPacket_impl(size_t nFrameIdx) {
     lvAssert_(nFrameIdx<getTotPackets(),"requested gt frame index is out of range");
     if(m_mGTIndexLUT.count(nFrameIdx)) {
-        const size_t nGTIdx = m_mGTIndexLUT[nFrameIdx];
+        const size_t nGTIdx = m_mGTIndexLUT.at(nFrameIdx);
         if(m_vsGTPaths.size()>nGTIdx) {
             lvAssert_(getGTMappingType()==PixelMapping,"tried to load a gt packet that was not an image via imread");
             return cv::imread(m_vsGTPaths[nGTIdx],cv::IMREAD_GRAYSCALE); // @@@@ expose grayscale flag in class member?
@@ -382,15 +1743,15 @@ cv::Mat lv::IDataProducer_<lv::DatasetSource_Video>::_getGTPacket_impl(size_t nF
 void lv::IDataProducer_<lv::DatasetSource_Video>::parseData() {
     lvAssert_(getInputPacketType()==ImagePacket,"video data producer can only ready image packets");
     cv::Mat oTempImg;
-    m_voVideoReader.open(getDataPath());
+    openVideoReader(getDataPath());
     if(!m_voVideoReader.isOpened()) {
-        lv::GetFilesFromDir(getDataPath(),m_vsInputPaths);
+        getDatasetInfo()->getFilesFromDir(getDataPath(),m_vsInputPaths);
         if(m_vsInputPaths.size()>1) {
             oTempImg = cv::imread(m_vsInputPaths[0]);
             m_nFrameCount = m_vsInputPaths.size();
         }
         else if(m_vsInputPaths.size()==1)
-            m_voVideoReader.open(m_vsInputPaths[0]);
+            openVideoReader(m_vsInputPaths[0]);
     }
     if(m_voVideoReader.isOpened()) {
         m_voVideoReader.set(cv::CAP_PROP_POS_FRAMES,0);
@@ -410,14 +1771,26 @@ void lv::IDataProducer_<lv::DatasetSource_Video>::parseData() {
     lvAssert_(m_nFrameCount>0,"could not find any input frames");
 }
 
+lv::IDataProducer_<lv::DatasetSource_Image>::~IDataProducer_() {
+    IDataLoader::stopAsyncPrecaching();
+}
+
 double lv::IDataProducer_<lv::DatasetSource_Image>::getExpectedLoad() const {
     return (double)getInputMaxSize().area()*m_nImageCount*(int(!isGrayscale())+1);
 }
 
 void lv::IDataProducer_<lv::DatasetSource_Image>::startAsyncPrecaching(bool bUsingGT, size_t /*nUnused*/) {
+    // packets are only loaded by the precachers from here on, so the reader can be swapped safely
+    if(!isUsingPackedCache() && !m_pInputFileReader)
+        m_pInputFileReader = std::make_unique<AsyncFileReader>(m_vsInputPaths,size_t(ASYNCFILEREADER_MAX_IN_FLIGHT),size_t(ASYNCFILEREADER_THREAD_COUNT));
     return IDataLoader::startAsyncPrecaching(bUsingGT,getInputMaxSize().area()*(m_nImageCount+1)*(isGrayscale()?1:getDatasetInfo()->is4ByteAligned()?4:3));
 }
 
+void lv::IDataProducer_<lv::DatasetSource_Image>::stopAsyncPrecaching() {
+    IDataLoader::stopAsyncPrecaching();
+    m_pInputFileReader = nullptr;
+}
+
 bool lv::IDataProducer_<lv::DatasetSource_Image>::isInputConstantSize() const {
     return m_bIsInputConstantSize;
 }
@@ -496,16 +1869,26 @@ size_t lv::IDataProducer_<lv::DatasetSource_Image>::getTotPackets() const {
 cv::Mat lv::IDataProducer_<lv::DatasetSource_Image>::_getInputPacket_impl(size_t nImageIdx) {
     lvDbgAssert_(getInputPacketType()==ImagePacket,"image data producer must be associated with a image packet data loader");
     lvAssert_(nImageIdx<getTotPackets(),"requested image index is out of range");
-    return cv::imread(m_vsInputPaths[nImageIdx],isGrayscale()?cv::IMREAD_GRAYSCALE:cv::IMREAD_COLOR);
+    if(m_pInputFileReader) {
+        thread_local std::vector<uchar> vFileData; // per-decoder buffer, reused across packets
+        if(!m_pInputFileReader->read(nImageIdx,vFileData))
+            vFileData.clear();
+        return readInputImagePacket(m_vsInputPaths[nImageIdx],nImageIdx,&vFileData);
+    }
+    return readInputImagePacket(m_vsInputPaths[nImageIdx],nImageIdx);
+}
+
+bool lv::IDataProducer_<lv::DatasetSource_Image>::isPacketLoadReentrant() const {
+    return true;
 }
 
 cv::Mat lv::IDataProducer_<lv::DatasetSource_Image>::_getGTPacket_impl(size_t nImageIdx) {
     lvAssert_(nImageIdx<getTotPackets(),"requested gt image index is out of range");
     if(m_mGTIndexLUT.count(nImageIdx)) {
-        const size_t nGTIdx = m_mGTIndexLUT[nImageIdx];
+        const size_t nGTIdx = m_mGTIndexLUT.at(nImageIdx);
         if(m_vsGTPaths.size()>nGTIdx) {
             lvAssert_(getGTMappingType()==PixelMapping,"tried to load a gt packet that was not an image via imread");
-            return cv::imread(m_vsGTPaths[m_mGTIndexLUT[nGTIdx]],cv::IMREAD_GRAYSCALE); // @@@@ expose grayscale flag in class member?
+            return cv::imread(m_vsGTPaths[nGTIdx],cv::IMREAD_GRAYSCALE); // @@@@ expose grayscale flag in class member?
         }
     }
     return cv::Mat();
@@ -513,7 +1896,7 @@ cv::Mat lv::IDataProducer_<lv::DatasetSource_Image>::_getGTPacket_impl(size_t nI
 
 void lv::IDataProducer_<lv::DatasetSource_Image>::parseData() {
     lvAssert_(getInputPacketType()==ImagePacket,"image data producer can only read image packets");
-    lv::GetFilesFromDir(getDataPath(),m_vsInputPaths);
+    getDatasetInfo()->getFilesFromDir(getDataPath(),m_vsInputPaths);
     lv::FilterFilePaths(m_vsInputPaths,{},{".jpg",".png",".bmp"});
     if(m_vsInputPaths.empty())
         lvError_("Set '%s' did not possess any jpg/png/bmp image file",getName().c_str());
@@ -531,35 +1914,359 @@ void lv::IDataProducer_<lv::DatasetSource_Image>::parseData() {
     m_vbInputTransposed.reserve(m_vsInputPaths.size());
     m_vbGTTransposed.clear();
     m_vbGTTransposed.reserve(m_vsInputPaths.size());
-    cv::Mat oLastInput;
+    // image dimensions are probed in parallel, reusing the per-directory metadata cache for unchanged files
+    const std::string sCacheFilePath = lv::AddDirSlashIfMissing(getDataPath())+IMAGE_METADATA_CACHE_NAME;
+    const std::map<std::string,ImageMetadataCacheEntry> mCachedEntries = loadImageMetadataCache(sCacheFilePath);
+    std::vector<std::pair<std::string,ImageMetadataCacheEntry>> voEntries(m_vsInputPaths.size());
+    std::atomic_size_t nUpdatedEntryCount(0);
+    lv::ThreadPool oThreadPool(getDatasetInfo()->getParsingThreadCount());
+    oThreadPool.parallel_for(m_vsInputPaths.size(),[&](size_t n) {
+        const size_t nLastSlashPos = m_vsInputPaths[n].find_last_of("/\\");
+        std::pair<std::string,ImageMetadataCacheEntry>& oEntry = voEntries[n];
+        oEntry.first = (nLastSlashPos==std::string::npos)?m_vsInputPaths[n]:m_vsInputPaths[n].substr(nLastSlashPos+1);
+        oEntry.second = ImageMetadataCacheEntry{-1,-1,0,0,uint32_t(oEntry.first.size()),0};
+        const bool bGotStats = lv::GetFileStats(m_vsInputPaths[n],oEntry.second.nModifTime,oEntry.second.nFileSize);
+        const auto pCachedEntry = mCachedEntries.find(oEntry.first);
+        if(bGotStats && pCachedEntry!=mCachedEntries.end() && pCachedEntry->second.nModifTime==oEntry.second.nModifTime && pCachedEntry->second.nFileSize==oEntry.second.nFileSize) {
+            oEntry.second = pCachedEntry->second;
+            return;
+        }
+        ++nUpdatedEntryCount;
+        cv::Size oSize;
+        if(!IMAGE_METADATA_USE_HEADER_PROBING || !probeImageHeaderSize(m_vsInputPaths[n],oSize))
+            oSize = cv::imread(m_vsInputPaths[n],isGrayscale()?cv::IMREAD_GRAYSCALE:cv::IMREAD_COLOR).size();
+        oEntry.second.nRows = oSize.height;
+        oEntry.second.nCols = oSize.width;
+    });
+    if(nUpdatedEntryCount>0 || mCachedEntries.size()!=voEntries.size())
+        saveImageMetadataCache(sCacheFilePath,voEntries);
     const double dScale = getDatasetInfo()->getScaleFactor();
+    std::vector<std::string> vsValidInputPaths;
+    vsValidInputPaths.reserve(m_vsInputPaths.size());
     for(size_t n = 0; n<m_vsInputPaths.size(); ++n) {
-        cv::Mat oCurrInput = cv::imread(m_vsInputPaths[n],isGrayscale()?cv::IMREAD_GRAYSCALE:cv::IMREAD_COLOR);
-        while(oCurrInput.empty()) {
-            m_vsInputPaths.erase(m_vsInputPaths.begin()+n);
-            if(n>=m_vsInputPaths.size())
-                break;
-            oCurrInput = cv::imread(m_vsInputPaths[n],isGrayscale()?cv::IMREAD_GRAYSCALE:cv::IMREAD_COLOR);
-        }
-        if(oCurrInput.empty())
-            break;
-        m_voInputOrigSizes.push_back(oCurrInput.size());
-        if(dScale!=1.0)
-            cv::resize(oCurrInput,oCurrInput,cv::Size(),dScale,dScale,cv::INTER_NEAREST);
-        m_voInputSizes.push_back(oCurrInput.size());
-        if(m_oInputMaxSize.width<oCurrInput.cols)
-            m_oInputMaxSize.width = oCurrInput.cols;
-        if(m_oInputMaxSize.height<oCurrInput.rows)
-            m_oInputMaxSize.height = oCurrInput.rows;
-        if(!oLastInput.empty() && oCurrInput.size()!=oLastInput.size())
+        const cv::Size oOrigSize(voEntries[n].second.nCols,voEntries[n].second.nRows);
+        if(oOrigSize.area()<=0) // unreadable images are skipped
+            continue;
+        vsValidInputPaths.push_back(m_vsInputPaths[n]);
+        m_voInputOrigSizes.push_back(oOrigSize);
+        // same rounding as cv::resize w/ scale factors
+        const cv::Size oCurrSize = (dScale!=1.0)?cv::Size(cv::saturate_cast<int>(oOrigSize.width*dScale),cv::saturate_cast<int>(oOrigSize.height*dScale)):oOrigSize;
+        if(!m_voInputSizes.empty() && oCurrSize!=m_voInputSizes.back())
             m_bIsInputConstantSize = false;
-        oLastInput = oCurrInput;
+        m_voInputSizes.push_back(oCurrSize);
+        if(m_oInputMaxSize.width<oCurrSize.width)
+            m_oInputMaxSize.width = oCurrSize.width;
+        if(m_oInputMaxSize.height<oCurrSize.height)
+            m_oInputMaxSize.height = oCurrSize.height;
         m_vbInputTransposed.push_back(false);
     }
+    m_vsInputPaths = std::move(vsValidInputPaths);
     m_nImageCount = m_vsInputPaths.size();
     lvAssert_(m_nImageCount>0,"could not find any input images");
 }
 
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+lv::IDataProducer_<lv::DatasetSource_Stream>::~IDataProducer_() {
+    stopAsyncPrecaching();
+}
+
+double lv::IDataProducer_<lv::DatasetSource_Stream>::getExpectedLoad() const {
+    return (double)m_oSize.area()*m_nFrameCount*(int(!isGrayscale())+1);
+}
+
+void lv::IDataProducer_<lv::DatasetSource_Stream>::startAsyncPrecaching(bool /*bUsingGT*/, size_t /*nUnused*/) {
+    if(m_bCaptureActive)
+        return;
+    if(!m_oCapture.isOpened())
+        lvAssert__(openStream(),"could not reopen live stream '%s'",m_sStreamSource.c_str());
+    {
+        std::mutex_lock_guard oLock(m_oCaptureMutex);
+        m_bStreamEnded = false;
+        m_oLatestFrame = cv::Mat();
+        m_nCapturedFrameCount = m_nLastServedFrameCount = m_nDroppedFrameCount = 0;
+        m_dLatestFrameTimestamp = m_dMeanInterval = m_dIntervalM2 = 0.0;
+        m_oCaptureStartTime = std::chrono::steady_clock::now();
+    }
+    m_bCaptureActive = true;
+    m_hCaptureWorker = std::thread(&IDataProducer_::captureEntry,this);
+}
+
+void lv::IDataProducer_<lv::DatasetSource_Stream>::stopAsyncPrecaching() {
+    if(!m_bCaptureActive)
+        return;
+    m_bCaptureActive = false;
+    if(m_hCaptureWorker.joinable())
+        m_hCaptureWorker.join();
+    m_oCaptureCondVar.notify_all();
+}
+
+double lv::IDataProducer_<lv::DatasetSource_Stream>::getCaptureTimestamp(size_t nPacketIdx) const {
+    std::mutex_lock_guard oLock(m_oCaptureMutex);
+    return (nPacketIdx<m_vdPacketTimestamps.size())?m_vdPacketTimestamps[nPacketIdx]:-1.0;
+}
+
+size_t lv::IDataProducer_<lv::DatasetSource_Stream>::getCapturedFrameCount() const {
+    std::mutex_lock_guard oLock(m_oCaptureMutex);
+    return m_nCapturedFrameCount;
+}
+
+size_t lv::IDataProducer_<lv::DatasetSource_Stream>::getDroppedFrameCount() const {
+    std::mutex_lock_guard oLock(m_oCaptureMutex);
+    return m_nDroppedFrameCount;
+}
+
+double lv::IDataProducer_<lv::DatasetSource_Stream>::getCaptureJitter() const {
+    std::mutex_lock_guard oLock(m_oCaptureMutex);
+    return (m_nCapturedFrameCount>2)?std::sqrt(m_dIntervalM2/(m_nCapturedFrameCount-2))*1000:0.0;
+}
+
+lv::IDataProducer_<lv::DatasetSource_Stream>::IDataProducer_(PacketPolicy eOutputType, MappingPolicy eGTMappingType, MappingPolicy eIOMappingType) :
+        IDataLoader(ImagePacket,eOutputType,eGTMappingType,eIOMappingType),m_nFrameCount(0),m_bCaptureActive(false),m_bStreamEnded(false),
+        m_nCapturedFrameCount(0),m_nLastServedFrameCount(0),m_nDroppedFrameCount(0),m_dLatestFrameTimestamp(0),m_dMeanInterval(0),m_dIntervalM2(0) {}
+
+size_t lv::IDataProducer_<lv::DatasetSource_Stream>::getTotPackets() const {
+    return m_nFrameCount;
+}
+
+const cv::Mat& lv::IDataProducer_<lv::DatasetSource_Stream>::getInputROI(size_t /*nPacketIdx*/) const {
+    return m_oROI;
+}
+
+const cv::Mat& lv::IDataProducer_<lv::DatasetSource_Stream>::getGTROI(size_t /*nPacketIdx*/) const {
+    return m_oROI;
+}
+
+const cv::Size& lv::IDataProducer_<lv::DatasetSource_Stream>::getInputSize(size_t /*nPacketIdx*/) const {
+    return m_oSize;
+}
+
+const cv::Size& lv::IDataProducer_<lv::DatasetSource_Stream>::getGTSize(size_t /*nPacketIdx*/) const {
+    return m_oSize;
+}
+
+const cv::Size& lv::IDataProducer_<lv::DatasetSource_Stream>::getInputOrigSize(size_t /*nPacketIdx*/) const {
+    return m_oOrigSize;
+}
+
+const cv::Size& lv::IDataProducer_<lv::DatasetSource_Stream>::getGTOrigSize(size_t /*nPacketIdx*/) const {
+    return m_oOrigSize;
+}
+
+const cv::Size& lv::IDataProducer_<lv::DatasetSource_Stream>::getInputMaxSize() const {
+    return m_oSize;
+}
+
+const cv::Size& lv::IDataProducer_<lv::DatasetSource_Stream>::getGTMaxSize() const {
+    return m_oSize;
+}
+
+cv::Mat lv::IDataProducer_<lv::DatasetSource_Stream>::_getInputPacket_impl(size_t nFrameIdx) {
+    lvAssert_(nFrameIdx<getTotPackets(),"requested frame index is out of range");
+    cv::Mat oFrame;
+    if(!m_bCaptureActive) {
+        // without the capture thread, frames are simply read in sequence (no latency bound)
+        if(!m_oCapture.isOpened() || !m_oCapture.read(oFrame) || oFrame.empty())
+            return cv::Mat();
+        if(isGrayscale() && oFrame.channels()==3)
+            cv::cvtColor(oFrame,oFrame,cv::COLOR_BGR2GRAY);
+        if(PacketLatencyTracer* pTracer = getLatencyTracer())
+            pTracer->mark(nFrameIdx,PacketLatencyTracer::Stage_Capture);
+        std::mutex_lock_guard oLock(m_oCaptureMutex);
+        m_vdPacketTimestamps[nFrameIdx] = std::chrono::duration<double>(std::chrono::steady_clock::now()-m_oCaptureStartTime).count();
+        return oFrame;
+    }
+    std::mutex_unique_lock oLock(m_oCaptureMutex);
+    // waits for a frame newer than the last one served; all frames captured in-between are dropped
+    if(!m_oCaptureCondVar.wait_for(oLock,std::chrono::milliseconds(DATASETUTILS_STREAM_FRAME_TIMEOUT_MS),[&]{return m_nCapturedFrameCount>m_nLastServedFrameCount || m_bStreamEnded || !m_bCaptureActive;}) || m_nCapturedFrameCount==m_nLastServedFrameCount)
+        return cv::Mat();
+    m_nDroppedFrameCount += m_nCapturedFrameCount-m_nLastServedFrameCount-1;
+    m_nLastServedFrameCount = m_nCapturedFrameCount;
+    m_vdPacketTimestamps[nFrameIdx] = m_dLatestFrameTimestamp;
+    if(PacketLatencyTracer* pTracer = getLatencyTracer()) // the frame was captured before being served, so its capture time is backdated
+        pTracer->mark(nFrameIdx,PacketLatencyTracer::Stage_Capture,m_oCaptureStartTime+std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(m_dLatestFrameTimestamp)));
+    return m_oLatestFrame; // never written to again by the capture thread, which reads each new frame in its own buffer
+}
+
+cv::Mat lv::IDataProducer_<lv::DatasetSource_Stream>::_getGTPacket_impl(size_t /*nFrameIdx*/) {
+    lvAssert_(getGTMappingType()==PixelMapping,"live streams can only provide (out-of-scope) pixel-mapped gt packets");
+    return cv::Mat(m_oOrigSize,CV_8UC1,cv::Scalar_<uchar>(DATASETUTILS_OUTOFSCOPE_VAL));
+}
+
+void lv::IDataProducer_<lv::DatasetSource_Stream>::parseData() {
+    lvAssert_(getInputPacketType()==ImagePacket,"stream data producer can only ready image packets");
+    const std::string sSourceFilePath = lv::AddDirSlashIfMissing(getDataPath())+DATASETUTILS_STREAM_SOURCE_FILE_NAME;
+    std::ifstream oSourceFile(sSourceFilePath);
+    if(!oSourceFile.is_open() || !std::getline(oSourceFile,m_sStreamSource) || m_sStreamSource.empty())
+        lvError_("Stream '%s': could not read stream source from '%s'",getName().c_str(),sSourceFilePath.c_str());
+    if(!(oSourceFile >> m_nFrameCount) || m_nFrameCount==0)
+        m_nFrameCount = DATASETUTILS_STREAM_DEFAULT_FRAME_COUNT;
+    if(!openStream())
+        lvError_("Stream '%s': could not open stream source '%s'",getName().c_str(),m_sStreamSource.c_str());
+    cv::Mat oTempImg;
+    if(!m_oCapture.read(oTempImg) || oTempImg.empty())
+        lvError_("Stream '%s': could not read a first frame from stream source '%s'",getName().c_str(),m_sStreamSource.c_str());
+    m_oOrigSize = oTempImg.size();
+    const double dScale = getDatasetInfo()->getScaleFactor();
+    if(dScale!=1.0)
+        cv::resize(oTempImg,oTempImg,cv::Size(),dScale,dScale,cv::INTER_NEAREST);
+    m_oROI = cv::Mat(oTempImg.size(),CV_8UC1,cv::Scalar_<uchar>(255));
+    m_oSize = oTempImg.size();
+    m_vdPacketTimestamps.assign(m_nFrameCount,-1.0);
+    m_oCaptureStartTime = std::chrono::steady_clock::now();
+}
+
+bool lv::IDataProducer_<lv::DatasetSource_Stream>::openStream() {
+    // a source made only of digits is a local camera index, anything else is handed to the capture backend as a url/pipeline
+    const bool bIsCameraIdx = std::all_of(m_sStreamSource.begin(),m_sStreamSource.end(),[](char c){return c>='0' && c<='9';});
+    if(bIsCameraIdx)
+        m_oCapture.open(std::stoi(m_sStreamSource));
+    else
+        m_oCapture.open(m_sStreamSource);
+    if(m_oCapture.isOpened())
+        m_oCapture.set(cv::CAP_PROP_BUFFERSIZE,1); // not supported by all backends, but drastically reduces latency when it is
+    return m_oCapture.isOpened();
+}
+
+void lv::IDataProducer_<lv::DatasetSource_Stream>::captureEntry() {
+    lv::ApplyThreadPlacementPolicy(lv::ThreadRole_Precacher);
+    cv::Mat oFrame;
+    while(m_bCaptureActive) {
+        // the previous frame buffer may still be referenced by a served packet, in which case a new one is allocated
+        if(oFrame.u && oFrame.u->refcount>1)
+            oFrame = cv::Mat();
+        if(!m_oCapture.read(oFrame) || oFrame.empty()) {
+            std::mutex_lock_guard oLock(m_oCaptureMutex);
+            m_bStreamEnded = true;
+            m_oCaptureCondVar.notify_all();
+            break;
+        }
+        if(isGrayscale() && oFrame.channels()==3)
+            cv::cvtColor(oFrame,oFrame,cv::COLOR_BGR2GRAY);
+        const double dTimestamp = std::chrono::duration<double>(std::chrono::steady_clock::now()-m_oCaptureStartTime).count();
+        {
+            std::mutex_lock_guard oLock(m_oCaptureMutex);
+            if(m_nCapturedFrameCount>0) {
+                // running variance of inter-frame intervals (welford), used as the jitter estimate
+                const double dInterval = dTimestamp-m_dLatestFrameTimestamp;
+                const size_t nIntervalCount = m_nCapturedFrameCount;
+                const double dDelta = dInterval-m_dMeanInterval;
+                m_dMeanInterval += dDelta/nIntervalCount;
+                m_dIntervalM2 += dDelta*(dInterval-m_dMeanInterval);
+            }
+            std::swap(m_oLatestFrame,oFrame);
+            m_dLatestFrameTimestamp = dTimestamp;
+            ++m_nCapturedFrameCount;
+        }
+        m_oCaptureCondVar.notify_one();
+    }
+    m_oCapture.release();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double lv::IDataProducer_<lv::DatasetSource_Recording>::getExpectedLoad() const {
+    return (double)m_oSize.area()*getTotPackets()*(int(!isGrayscale())+1);
+}
+
+void lv::IDataProducer_<lv::DatasetSource_Recording>::startAsyncPrecaching(bool bUsingGT, size_t /*nUnused*/) {
+    return IDataLoader::startAsyncPrecaching(bUsingGT,m_oSize.area()*(getTotPackets()+1)*(isGrayscale()?1:getDatasetInfo()->is4ByteAligned()?4:3));
+}
+
+int64_t lv::IDataProducer_<lv::DatasetSource_Recording>::getPacketTimestamp(size_t nPacketIdx) const {
+    return getRecording().getTimestamp(m_nInputStreamIdx,nPacketIdx);
+}
+
+const lv::RecordingReader& lv::IDataProducer_<lv::DatasetSource_Recording>::getRecording() const {
+    lvAssert_(m_pRecording,"recording was not parsed yet");
+    return *m_pRecording;
+}
+
+lv::IDataProducer_<lv::DatasetSource_Recording>::IDataProducer_(PacketPolicy eOutputType, MappingPolicy eGTMappingType, MappingPolicy eIOMappingType) :
+        IDataLoader(ImagePacket,eOutputType,eGTMappingType,eIOMappingType),m_nInputStreamIdx(0) {}
+
+size_t lv::IDataProducer_<lv::DatasetSource_Recording>::getTotPackets() const {
+    return m_pRecording?m_pRecording->getPacketCount(m_nInputStreamIdx):size_t(0);
+}
+
+const cv::Mat& lv::IDataProducer_<lv::DatasetSource_Recording>::getInputROI(size_t /*nPacketIdx*/) const {
+    return m_oROI;
+}
+
+const cv::Mat& lv::IDataProducer_<lv::DatasetSource_Recording>::getGTROI(size_t /*nPacketIdx*/) const {
+    return m_oROI;
+}
+
+const cv::Size& lv::IDataProducer_<lv::DatasetSource_Recording>::getInputSize(size_t /*nPacketIdx*/) const {
+    return m_oSize;
+}
+
+const cv::Size& lv::IDataProducer_<lv::DatasetSource_Recording>::getGTSize(size_t /*nPacketIdx*/) const {
+    return m_oSize;
+}
+
+const cv::Size& lv::IDataProducer_<lv::DatasetSource_Recording>::getInputOrigSize(size_t /*nPacketIdx*/) const {
+    return m_oOrigSize;
+}
+
+const cv::Size& lv::IDataProducer_<lv::DatasetSource_Recording>::getGTOrigSize(size_t /*nPacketIdx*/) const {
+    return m_oOrigSize;
+}
+
+const cv::Size& lv::IDataProducer_<lv::DatasetSource_Recording>::getInputMaxSize() const {
+    return m_oSize;
+}
+
+const cv::Size& lv::IDataProducer_<lv::DatasetSource_Recording>::getGTMaxSize() const {
+    return m_oSize;
+}
+
+cv::Mat lv::IDataProducer_<lv::DatasetSource_Recording>::_getInputPacket_impl(size_t nFrameIdx) {
+    lvAssert_(nFrameIdx<getTotPackets(),"requested frame index is out of range");
+    cv::Mat oFrame = m_pRecording->read(m_nInputStreamIdx,nFrameIdx);
+    if(isGrayscale() && oFrame.channels()==3)
+        cv::cvtColor(oFrame,oFrame,cv::COLOR_BGR2GRAY);
+    else if(!isGrayscale() && oFrame.channels()==1)
+        cv::cvtColor(oFrame,oFrame,cv::COLOR_GRAY2BGR);
+    return oFrame;
+}
+
+cv::Mat lv::IDataProducer_<lv::DatasetSource_Recording>::_getGTPacket_impl(size_t /*nFrameIdx*/) {
+    lvAssert_(getGTMappingType()==PixelMapping,"recordings can only provide (out-of-scope) pixel-mapped gt packets");
+    return cv::Mat(m_oOrigSize,CV_8UC1,cv::Scalar_<uchar>(DATASETUTILS_OUTOFSCOPE_VAL));
+}
+
+void lv::IDataProducer_<lv::DatasetSource_Recording>::parseData() {
+    lvAssert_(getInputPacketType()==ImagePacket,"recording data producer can only ready image packets");
+    std::vector<std::string> vsFilePaths;
+    lv::GetFilesFromDir(getDataPath(),vsFilePaths);
+    const std::string sSuffix = RECORDING_FILE_SUFFIX;
+    const auto pRecordingPath = std::find_if(vsFilePaths.begin(),vsFilePaths.end(),[&](const std::string& sPath){
+        return sPath.size()>sSuffix.size() && sPath.compare(sPath.size()-sSuffix.size(),sSuffix.size(),sSuffix)==0;
+    });
+    if(pRecordingPath==vsFilePaths.end())
+        lvError_("Recording '%s': could not find a '%s' file in '%s'",getName().c_str(),RECORDING_FILE_SUFFIX,getDataPath().c_str());
+    m_pRecording = std::make_unique<RecordingReader>(*pRecordingPath);
+    if(m_pRecording->isRecovered())
+        std::cout << "recording '" << getName() << "' was not closed properly, its index was rebuilt from its valid chunks" << std::endl;
+    m_nInputStreamIdx = m_pRecording->findStream(DATASETUTILS_RECORDING_DEFAULT_STREAM);
+    if(m_nInputStreamIdx==SIZE_MAX)
+        m_nInputStreamIdx = 0;
+    const RecordingStreamInfo& oStream = m_pRecording->getStreamInfo(m_nInputStreamIdx);
+    if(CV_MAT_DEPTH(oStream.nType)!=CV_8U || (CV_MAT_CN(oStream.nType)!=1 && CV_MAT_CN(oStream.nType)!=3))
+        lvError_("Recording '%s': input stream '%s' does not hold 8-bit images",getName().c_str(),oStream.sName.c_str());
+    if(m_pRecording->getPacketCount(m_nInputStreamIdx)==0)
+        lvError_("Recording '%s': input stream '%s' is empty",getName().c_str(),oStream.sName.c_str());
+    m_oOrigSize = oStream.oSize;
+    const double dScale = getDatasetInfo()->getScaleFactor();
+    m_oSize = (dScale!=1.0)?cv::Size(cvRound(m_oOrigSize.width*dScale),cvRound(m_oOrigSize.height*dScale)):m_oOrigSize;
+    m_oROI = cv::Mat(m_oSize,CV_8UC1,cv::Scalar_<uchar>(255));
+}
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -572,6 +2279,11 @@ size_t lv::DataCounter_<lv::NotGroup>::getProcessedPacketsCount() const {
     return m_nProcessedPackets;
 }
 
+void lv::DataCounter_<lv::NotGroup>::restoreProcessedPacketsCount(size_t nPackets) {
+    lvAssert_(!isProcessing(),"processed packets count cannot be restored while processing");
+    m_nProcessedPackets = nPackets;
+}
+
 size_t lv::DataCounter_<lv::Group>::getProcessedPacketsCountPromise() {
     return lv::accumulateMembers<size_t,IDataHandlerPtr>(getBatches(true),[](const IDataHandlerPtr& p){return p->getProcessedPacketsCountPromise();});
 }
@@ -580,65 +2292,126 @@ size_t lv::DataCounter_<lv::Group>::getProcessedPacketsCount() const {
     return lv::accumulateMembers<size_t,IDataHandlerPtr>(getBatches(true),[](const IDataHandlerPtr& p){return p->getProcessedPacketsCount();});
 }
 
+void lv::DataCounter_<lv::Group>::restoreProcessedPacketsCount(size_t /*nPackets*/) {
+    lvError("cannot restore the processed packets count of a work group");
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 lv::DataWriter::DataWriter(std::function<size_t(const cv::Mat&,size_t)> lDataArchiverCallback) :
-        m_lCallback(lDataArchiverCallback) {
+        m_lCallback(lDataArchiverCallback),
+        m_oQueue(DATAWRITER_QUEUE_SLOT_COUNT),
+        m_pMemoryTag(lv::MemoryTracker::createTag("data writer",this)) {
+    static_assert(DATAWRITER_QUEUE_SLOT_COUNT>1 && (DATAWRITER_QUEUE_SLOT_COUNT&(DATAWRITER_QUEUE_SLOT_COUNT-1))==0,"Data writer slot count must be a power of two");
     lvAssert_(m_lCallback,"invalid data writer callback");
     m_bIsActive = false;
     m_bAllowPacketDrop = false;
+    m_bOrderedWrites = false;
     m_nQueueSize = 0;
     m_nQueueCount = 0;
+    m_nNextWriteTicket = 0;
 }
 
 lv::DataWriter::~DataWriter() {
     stopAsyncWriting();
 }
 
+lv::MemoryTracker::Usage lv::DataWriter::getMemoryUsage() const {
+    return lv::MemoryTracker::getUsage(*m_pMemoryTag);
+}
+
 size_t lv::DataWriter::queue(const cv::Mat& oPacket, size_t nIdx) {
     if(!m_bIsActive)
         return m_lCallback(oPacket,nIdx);
-    cv::Mat oPacketCopy = oPacket.clone();
-    const size_t nPacketSize = oPacket.total()*oPacket.elemSize();
-    size_t nPacketPosition;
+    if(m_pLatencyTracer)
+        m_pLatencyTracer->mark(nIdx,PacketLatencyTracer::Stage_Enqueue);
+    cv::Mat oPacketCopy;
     {
+        const lv::MemoryTracker::Scope oMemoryScope(m_pMemoryTag); // queued copies belong to the writer until written
+        oPacketCopy = oPacket.clone();
+    }
+    return enqueue(oPacketCopy,nIdx);
+}
+
+size_t lv::DataWriter::queue(cv::Mat&& oPacket, size_t nIdx) {
+    if(m_bIsActive && m_pLatencyTracer)
+        m_pLatencyTracer->mark(nIdx,PacketLatencyTracer::Stage_Enqueue);
+    const size_t nRes = m_bIsActive?enqueue(oPacket,nIdx):m_lCallback(oPacket,nIdx);
+    oPacket.release(); // the queue slot now holds the only reference (so pooled buffers are recycled as soon as they are written)
+    return nRes;
+}
+
+size_t lv::DataWriter::enqueue(const cv::Mat& oPacket, size_t nIdx) {
+    const size_t nPacketSize = oPacket.total()*oPacket.elemSize();
+    size_t nCurrQueueSize = m_nQueueSize;
+    lv::StopWatch oStallWatch;
+    double dStalledTime_sec = 0.0;
+    const auto lWaitForClear = [&]() {
+        oStallWatch.tick();
         std::mutex_unique_lock sync_lock(m_oSyncMutex);
-        if(!m_bAllowPacketDrop && m_nQueueSize+nPacketSize>m_nQueueMaxSize)
-            m_oClearCondVar.wait(sync_lock,[&]{return m_nQueueSize+nPacketSize<=m_nQueueMaxSize;});
-        if(m_nQueueSize+nPacketSize<=m_nQueueMaxSize) {
-            m_mQueue[nIdx] = std::move(oPacketCopy);
-            m_nQueueSize += nPacketSize;
-            // @@@ could cut a find operation here using C++17's map::insert_or_assign above
-            nPacketPosition = std::distance(m_mQueue.begin(),m_mQueue.find(nIdx));
-            ++m_nQueueCount;
+        m_oClearCondVar.wait_for(sync_lock,std::chrono::milliseconds(DATAWRITER_WAIT_TIMEOUT_MS));
+        dStalledTime_sec += oStallWatch.tock();
+    };
+    while(true) {
+        // the byte budget is reserved first, then a ring slot is claimed (both without locks); the mutex is only used to sleep when full
+        // note: the queue max size follows the budget manager's allocation, but an empty queue always accepts a packet (so shrinking never deadlocks)
+        if(nCurrQueueSize>0 && nCurrQueueSize+nPacketSize>m_pBudgetLease->getAllocatedSize()) {
+            if(m_bAllowPacketDrop)
+                break;
+            lWaitForClear();
+            nCurrQueueSize = m_nQueueSize;
+            continue;
         }
-        else {
-#if CONSOLE_DEBUG
-            std::cout << "data writer [" << uintptr_t(this) << "] dropping packet #" << nIdx << std::endl;
-#endif //CONSOLE_DEBUG
-            nPacketPosition = SIZE_MAX; // packet dropped
+        if(!m_nQueueSize.compare_exchange_weak(nCurrQueueSize,nCurrQueueSize+nPacketSize))
+            continue;
+        while(true) {
+            ++m_nQueueCount; // counted before publishing, so that consumers never see it underflow
+            size_t nPos;
+            if(m_oQueue.try_push(QueuedPacket{nIdx,oPacket},&nPos)) {
+                const size_t nPacketPosition = nPos-std::min(nPos,m_oQueue.getPopCount());
+                m_oQueueCondVar.notify_one();
+                m_pBudgetLease->reportActivity(nPacketSize,dStalledTime_sec);
+                if((nIdx%50)==0)
+                    lvLogDebug("data writer [%p] queue @ %d%% capacity",(void*)this,(int)(((float)m_nQueueSize*100)/std::max(m_pBudgetLease->getAllocatedSize(),size_t(1))));
+                return nPacketPosition;
+            }
+            --m_nQueueCount;
+            // all slots are in use
+            if(m_bAllowPacketDrop)
+                break;
+            lWaitForClear();
         }
+        m_nQueueSize -= nPacketSize;
+        break;
     }
-    m_oQueueCondVar.notify_one();
-#if CONSOLE_DEBUG
-    if((nIdx%50)==0)
-        std::cout << "data writer [" << uintptr_t(this) << "] queue @ " << (int)(((float)m_nQueueSize*100)/m_nQueueMaxSize) << "% capacity" << std::endl;
-#endif //CONSOLE_DEBUG
-    return nPacketPosition;
+    m_pBudgetLease->reportActivity(nPacketSize,dStalledTime_sec); // dropped packets still count as demand
+    lvLogDebug("data writer [%p] dropping packet #%zu",(void*)this,nIdx);
+    return SIZE_MAX; // packet dropped
+}
+
+bool lv::DataWriter::dequeue(cv::Mat& oPacket, size_t& nIdx, size_t& nTicket) {
+    QueuedPacket oQueuedPacket;
+    if(!m_oQueue.try_pop(oQueuedPacket,&nTicket))
+        return false; // queue is empty
+    oPacket = std::move(oQueuedPacket.oPacket);
+    nIdx = oQueuedPacket.nIdx;
+    return true;
 }
 
-bool lv::DataWriter::startAsyncWriting(size_t nSuggestedQueueSize, bool bDropPacketsIfFull, size_t nWorkers) {
+bool lv::DataWriter::startAsyncWriting(size_t nSuggestedQueueSize, bool bDropPacketsIfFull, size_t nWorkers, bool bOrderedWrites) {
     if(m_bIsActive)
         stopAsyncWriting();
     if(nSuggestedQueueSize>0) {
+        lvAssert_(nWorkers>0,"data writer requires at least one worker");
         m_bIsActive = true;
         m_bAllowPacketDrop = bDropPacketsIfFull;
-        m_nQueueMaxSize = (nSuggestedQueueSize>CACHE_MAX_SIZE)?(CACHE_MAX_SIZE):nSuggestedQueueSize;
+        m_bOrderedWrites = bOrderedWrites;
+        m_pBudgetLease = BufferBudgetManager::get().registerBuffer("data writer ["+std::to_string(uintptr_t(this))+"]",(nSuggestedQueueSize>CACHE_MAX_SIZE)?(CACHE_MAX_SIZE):nSuggestedQueueSize);
         m_nQueueSize = 0;
         m_nQueueCount = 0;
-        m_mQueue.clear();
+        m_nNextWriteTicket = m_oQueue.getPushCount();
         for(size_t n=0; n<nWorkers; ++n)
             m_vhWorkers.emplace_back(std::bind(&DataWriter::entry,this));
     }
@@ -651,38 +2424,343 @@ void lv::DataWriter::stopAsyncWriting() {
         m_oQueueCondVar.notify_all();
         for(std::thread& oWorker : m_vhWorkers)
             oWorker.join();
+        m_vhWorkers.clear();
+        m_pBudgetLease = nullptr;
     }
 }
 
 void lv::DataWriter::entry() {
-    std::mutex_unique_lock sync_lock(m_oSyncMutex);
-#if CONSOLE_DEBUG
-    std::cout << "data writer [" << uintptr_t(this) << "] init w/ max buffer size = " << (m_nQueueMaxSize/1024)/1024 << " mb" << std::endl;
-#endif //CONSOLE_DEBUG
+    LV_PROFILE_THREAD_NAME("writer");
+    lv::ApplyThreadPlacementPolicy(lv::ThreadRole_Writer);
+    const lv::MemoryTracker::Scope oMemoryScope(m_pMemoryTag);
+    lvLogDebug("data writer [%p] init w/ buffer size = %zu mb",(void*)this,size_t((m_pBudgetLease->getAllocatedSize()/1024)/1024));
+    cv::Mat oPacketData;
+    size_t nPacketIdx,nTicket;
     while(m_bIsActive || m_nQueueCount>0) {
-        if(m_nQueueCount==0)
-            m_oQueueCondVar.wait(sync_lock);
-        if(m_nQueueCount>0) {
-            auto pCurrPacket = m_mQueue.begin();
-            lvAssert_(pCurrPacket!=m_mQueue.end(),"data writer notified for missing packet");
-            const cv::Mat oPacketData(std::move(pCurrPacket->second));
-            const size_t nPacketIdx = pCurrPacket->first;
-            const size_t nPacketSize = oPacketData.total()*oPacketData.elemSize();
-            lvAssert_(nPacketSize<=m_nQueueSize,"data writer packet size exceeds queue size");
-            m_nQueueSize -= nPacketSize;
-            m_mQueue.erase(pCurrPacket);
-            --m_nQueueCount;
-            std::unlock_guard<std::mutex_unique_lock> oUnlock(sync_lock);
+        if(!dequeue(oPacketData,nPacketIdx,nTicket)) {
+            std::mutex_unique_lock sync_lock(m_oSyncMutex);
+            if(m_nQueueCount==0 && m_bIsActive)
+                m_oQueueCondVar.wait_for(sync_lock,std::chrono::milliseconds(DATAWRITER_WAIT_TIMEOUT_MS));
+            continue;
+        }
+        const size_t nPacketSize = oPacketData.total()*oPacketData.elemSize();
+        lvAssert_(nPacketSize<=m_nQueueSize,"data writer packet size exceeds queue size");
+        if(m_bOrderedWrites) {
+            // tickets follow queueing order; workers dequeue in parallel, but only the next ticket holder may invoke the callback
+            std::mutex_unique_lock sync_lock(m_oSyncMutex);
+            m_oOrderCondVar.wait(sync_lock,[&]{return m_nNextWriteTicket==nTicket;});
+            {
+                std::unlock_guard<std::mutex_unique_lock> oUnlock(sync_lock);
+                LV_PROFILE_SCOPE("DataWriter::writePacket");
+                m_lCallback(oPacketData,nPacketIdx);
+            }
+            ++m_nNextWriteTicket;
+            m_oOrderCondVar.notify_all();
+        }
+        else {
+            LV_PROFILE_SCOPE("DataWriter::writePacket");
             m_lCallback(oPacketData,nPacketIdx);
-            m_oClearCondVar.notify_all();
         }
+        oPacketData = cv::Mat();
+        m_nQueueSize -= nPacketSize;
+        --m_nQueueCount;
+        m_oClearCondVar.notify_all();
     }
 }
 
+lv::PacketPool::PacketPool(size_t nSlots, const cv::Size& oSize, int nType) :
+        m_nNextSlotIdx(0) {
+    lvAssert_(nSlots>0 && oSize.area()>0,"packet pool requires at least one non-empty slot");
+    m_voSlots.reserve(nSlots);
+    for(size_t nSlotIdx=0; nSlotIdx<nSlots; ++nSlotIdx)
+        m_voSlots.emplace_back(oSize,nType);
+}
+
+bool lv::PacketPool::acquire(cv::Mat& oPacket) {
+    oPacket.release();
+    // slots are scanned round-robin from the last one handed out, so buffers are recycled in the order they were queued
+    for(size_t nOffset=0; nOffset<m_voSlots.size(); ++nOffset) {
+        const size_t nSlotIdx = (m_nNextSlotIdx+nOffset)%m_voSlots.size();
+        if(m_voSlots[nSlotIdx].u->refcount==1) {
+            oPacket = m_voSlots[nSlotIdx];
+            m_nNextSlotIdx = (nSlotIdx+1)%m_voSlots.size();
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t lv::PacketPool::getUsedCount() const {
+    return (size_t)std::count_if(m_voSlots.begin(),m_voSlots.end(),[](const cv::Mat& oSlot){return oSlot.u->refcount>1;});
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+    /// output packet codecs, selected by the dataset output name suffix (anything not listed here goes through cv::imwrite/cv::imread)
+    enum OutputCodec {
+        OutputCodec_OpenCV,
+        OutputCodec_RLE,
+        OutputCodec_BitPacked,
+        OutputCodec_Raw,
+    };
+
+    /// header prepended to all packets encoded with a non-opencv codec
+    struct OutputPacketHeader {
+        char acMagic[4];
+        int32_t nRows;
+        int32_t nCols;
+        int32_t nType;
+    };
+
+    OutputCodec getOutputCodec(const std::string& sOutputNameSuffix) {
+        if(sOutputNameSuffix==DATAARCHIVER_RLE_SUFFIX)
+            return OutputCodec_RLE;
+        else if(sOutputNameSuffix==DATAARCHIVER_BITPACKED_SUFFIX)
+            return OutputCodec_BitPacked;
+        else if(sOutputNameSuffix==DATAARCHIVER_RAW_SUFFIX)
+            return OutputCodec_Raw;
+        return OutputCodec_OpenCV;
+    }
+
+    const char* getOutputCodecMagic(OutputCodec eCodec) {
+        lvDbgAssert(eCodec!=OutputCodec_OpenCV);
+        return (eCodec==OutputCodec_RLE)?"LRLE":(eCodec==OutputCodec_BitPacked)?"LBIT":"LRAW";
+    }
+
+    /// encodes a continuous 2d packet in the given buffer (bit-packed masks only keep DATASETUTILS_POSITIVE_VAL pixels, LSB-first)
+    void encodeOutputPacket(const cv::Mat& oPacket, OutputCodec eCodec, std::vector<uchar>& vBuffer) {
+        lvAssert_(oPacket.dims==2 && oPacket.isContinuous(),"output packet must be 2d and continuous");
+        lvAssert_(eCodec==OutputCodec_Raw || oPacket.type()==CV_8UC1,"run-length and bit-packed output codecs only support 8UC1 masks");
+        OutputPacketHeader oHeader;
+        std::copy_n(getOutputCodecMagic(eCodec),sizeof(oHeader.acMagic),oHeader.acMagic);
+        oHeader.nRows = oPacket.rows;
+        oHeader.nCols = oPacket.cols;
+        oHeader.nType = oPacket.type();
+        vBuffer.assign((const uchar*)&oHeader,(const uchar*)&oHeader+sizeof(oHeader));
+        const uchar* const pData = oPacket.data;
+        const size_t nElems = oPacket.total();
+        if(eCodec==OutputCodec_RLE) {
+            // each run is stored as its value followed by its length as a 7-bit varint
+            for(size_t nElemIdx=0; nElemIdx<nElems;) {
+                const uchar nVal = pData[nElemIdx];
+                size_t nRunLength = 1;
+                while(nElemIdx+nRunLength<nElems && pData[nElemIdx+nRunLength]==nVal)
+                    ++nRunLength;
+                nElemIdx += nRunLength;
+                vBuffer.push_back(nVal);
+                for(; nRunLength>=0x80; nRunLength>>=7)
+                    vBuffer.push_back(uchar(nRunLength|0x80));
+                vBuffer.push_back(uchar(nRunLength));
+            }
+        }
+        else if(eCodec==OutputCodec_BitPacked) {
+            const size_t nOffset = vBuffer.size();
+            vBuffer.resize(nOffset+(nElems+7)/8,uchar(0));
+            uchar* const pBits = vBuffer.data()+nOffset;
+            size_t nElemIdx = 0;
+#if HAVE_SSE2
+            const __m128i anPositiveVal = _mm_set1_epi8(char(DATASETUTILS_POSITIVE_VAL));
+            for(; nElemIdx+16<=nElems; nElemIdx+=16) {
+                const int nMask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(pData+nElemIdx)),anPositiveVal));
+                pBits[nElemIdx/8] = uchar(nMask);
+                pBits[nElemIdx/8+1] = uchar(nMask>>8);
+            }
+#endif //HAVE_SSE2
+            for(; nElemIdx<nElems; ++nElemIdx)
+                if(pData[nElemIdx]==DATASETUTILS_POSITIVE_VAL)
+                    pBits[nElemIdx/8] |= uchar(1<<(nElemIdx%8));
+        }
+        else
+            vBuffer.insert(vBuffer.end(),pData,pData+nElems*oPacket.elemSize());
+    }
+
+    /// encodes a bit-packed binary mask in the given buffer using the bit-packed codec (packed bits are already laid out as the codec expects)
+    void encodePackedOutputPacket(const lv::PackedBinaryMask& oPacket, std::vector<uchar>& vBuffer) {
+        OutputPacketHeader oHeader;
+        std::copy_n(getOutputCodecMagic(OutputCodec_BitPacked),sizeof(oHeader.acMagic),oHeader.acMagic);
+        oHeader.nRows = oPacket.size().height;
+        oHeader.nCols = oPacket.size().width;
+        oHeader.nType = CV_8UC1;
+        vBuffer.assign((const uchar*)&oHeader,(const uchar*)&oHeader+sizeof(oHeader));
+        const size_t nOffset = vBuffer.size(), nBytes = oPacket.getByteCount();
+        vBuffer.resize(nOffset+nBytes);
+        const uint64_t* const anWords = oPacket.words();
+        for(size_t nByteIdx=0; nByteIdx<nBytes; ++nByteIdx)
+            vBuffer[nOffset+nByteIdx] = uchar(anWords[nByteIdx/8]>>((nByteIdx%8)*8));
+    }
+
+    /// decodes a packet previously encoded via encodeOutputPacket
+    cv::Mat decodeOutputPacket(const uchar* pBuffer, size_t nBufferSize, OutputCodec eCodec) {
+        lvAssert_(nBufferSize>=sizeof(OutputPacketHeader),"output packet is truncated");
+        OutputPacketHeader oHeader;
+        std::copy_n(pBuffer,sizeof(oHeader),(uchar*)&oHeader);
+        lvAssert_(std::equal(oHeader.acMagic,oHeader.acMagic+sizeof(oHeader.acMagic),getOutputCodecMagic(eCodec)),"output packet codec mismatch");
+        lvAssert_(oHeader.nRows>=0 && oHeader.nCols>=0,"bad output packet header");
+        cv::Mat oPacket(oHeader.nRows,oHeader.nCols,oHeader.nType);
+        const uchar* pData = pBuffer+sizeof(oHeader);
+        const uchar* const pDataEnd = pBuffer+nBufferSize;
+        const size_t nElems = oPacket.total();
+        if(eCodec==OutputCodec_RLE) {
+            for(size_t nElemIdx=0; nElemIdx<nElems;) {
+                lvAssert_(pData<pDataEnd,"run-length encoded output packet is truncated");
+                const uchar nVal = *pData++;
+                size_t nRunLength = 0;
+                for(size_t nShift=0;; nShift+=7) {
+                    lvAssert_(pData<pDataEnd,"run-length encoded output packet is truncated");
+                    nRunLength |= size_t(*pData&0x7F)<<nShift;
+                    if(!(*pData++&0x80))
+                        break;
+                }
+                lvAssert_(nRunLength>0 && nRunLength<=nElems-nElemIdx,"run-length encoded output packet is corrupted");
+                std::fill_n(oPacket.data+nElemIdx,nRunLength,nVal);
+                nElemIdx += nRunLength;
+            }
+        }
+        else if(eCodec==OutputCodec_BitPacked) {
+            lvAssert_(size_t(pDataEnd-pData)>=(nElems+7)/8,"bit-packed output packet is truncated");
+            for(size_t nElemIdx=0; nElemIdx<nElems; ++nElemIdx)
+                oPacket.data[nElemIdx] = ((pData[nElemIdx/8]>>(nElemIdx%8))&1)?DATASETUTILS_POSITIVE_VAL:dATASETUTILS_NEGATIVE_VAL;
+        }
+        else {
+            lvAssert_(size_t(pDataEnd-pData)>=nElems*oPacket.elemSize(),"raw output packet is truncated");
+            std::copy_n(pData,nElems*oPacket.elemSize(),oPacket.data);
+        }
+        return oPacket;
+    }
+
+    /// per-record header in output containers (the record payload is one encoded packet)
+    struct OutputContainerRecord {
+        uint64_t nIdx;
+        uint64_t nSize;
+    };
+
+    /// footer at the end of finalized output containers, preceded by nEntryCount index entries
+    struct OutputContainerFooter {
+        uint64_t nEntryCount;
+        char acMagic[8];
+    };
+
+    /// output container index entry (offset points to the record payload)
+    struct OutputContainerIndexEntry {
+        uint64_t nIdx;
+        uint64_t nOffset;
+        uint64_t nSize;
+    };
+
+} // namespace
+
+/// per-batch output container state; records are appended (in any packet order) while saving, and indexed via a footer written on destruction
+struct lv::IDataArchiver::OutputContainer {
+    OutputContainer(const std::string& sPath) :
+            sFilePath(sPath),nWriteOffset(0),bIndexLoaded(false) {}
+    ~OutputContainer() {
+        if(oWriter.is_open()) {
+            for(const auto& oEntry : mIndex) {
+                const OutputContainerIndexEntry oIndexEntry = {uint64_t(oEntry.first),oEntry.second.first,oEntry.second.second};
+                oWriter.write((const char*)&oIndexEntry,sizeof(oIndexEntry));
+            }
+            OutputContainerFooter oFooter;
+            oFooter.nEntryCount = mIndex.size();
+            std::copy_n(DATAARCHIVER_CONTAINER_INDEX_MAGIC,sizeof(oFooter.acMagic),oFooter.acMagic);
+            oWriter.write((const char*)&oFooter,sizeof(oFooter));
+        }
+    }
+    void append(size_t nIdx, const std::vector<uchar>& vBuffer) {
+        std::mutex_lock_guard lock(oMutex);
+        if(!oWriter.is_open()) {
+            // the first save of this run truncates whatever container was left by previous runs
+            oReader.close();
+            oWriter.open(sFilePath,std::ios::out|std::ios::binary|std::ios::trunc);
+            lvAssert__(oWriter.is_open(),"could not create output container at '%s'",sFilePath.c_str());
+            oWriter.write(DATAARCHIVER_CONTAINER_MAGIC,sizeof(DATAARCHIVER_CONTAINER_MAGIC)-1);
+            nWriteOffset = sizeof(DATAARCHIVER_CONTAINER_MAGIC)-1;
+            mIndex.clear();
+            bIndexLoaded = true;
+        }
+        const OutputContainerRecord oRecord = {uint64_t(nIdx),uint64_t(vBuffer.size())};
+        oWriter.write((const char*)&oRecord,sizeof(oRecord));
+        oWriter.write((const char*)vBuffer.data(),vBuffer.size());
+        oWriter.flush(); // keeps records readable (through a scan) even if the footer is never written
+        lvAssert__(oWriter.good(),"failed writing to output container at '%s'",sFilePath.c_str());
+        nWriteOffset += sizeof(oRecord);
+        mIndex[nIdx] = std::make_pair(uint64_t(nWriteOffset),uint64_t(vBuffer.size()));
+        nWriteOffset += vBuffer.size();
+    }
+    bool read(size_t nIdx, std::vector<uchar>& vBuffer) {
+        std::mutex_lock_guard lock(oMutex);
+        if(!oReader.is_open()) {
+            oReader.open(sFilePath,std::ios::in|std::ios::binary);
+            if(!oReader.is_open())
+                return false;
+        }
+        oReader.clear();
+        if(!bIndexLoaded)
+            loadIndex();
+        const auto pEntryIter = mIndex.find(nIdx);
+        if(pEntryIter==mIndex.end())
+            return false;
+        vBuffer.resize(size_t(pEntryIter->second.second));
+        oReader.seekg(std::streamoff(pEntryIter->second.first));
+        oReader.read((char*)vBuffer.data(),vBuffer.size());
+        return oReader.good();
+    }
+    void loadIndex() {
+        mIndex.clear();
+        bIndexLoaded = true;
+        oReader.seekg(0,std::ios::end);
+        const uint64_t nFileSize = uint64_t(oReader.tellg());
+        const uint64_t nHeaderSize = sizeof(DATAARCHIVER_CONTAINER_MAGIC)-1;
+        char acMagic[sizeof(DATAARCHIVER_CONTAINER_MAGIC)-1];
+        oReader.seekg(0);
+        lvAssert__(nFileSize>=nHeaderSize && oReader.read(acMagic,sizeof(acMagic)) && std::equal(acMagic,acMagic+sizeof(acMagic),DATAARCHIVER_CONTAINER_MAGIC),"bad output container at '%s'",sFilePath.c_str());
+        OutputContainerFooter oFooter;
+        if(nFileSize>=nHeaderSize+sizeof(oFooter)) {
+            oReader.seekg(std::streamoff(nFileSize-sizeof(oFooter)));
+            oReader.read((char*)&oFooter,sizeof(oFooter));
+            if(std::equal(oFooter.acMagic,oFooter.acMagic+sizeof(oFooter.acMagic),DATAARCHIVER_CONTAINER_INDEX_MAGIC) &&
+               oFooter.nEntryCount<=(nFileSize-nHeaderSize-sizeof(oFooter))/sizeof(OutputContainerIndexEntry)) {
+                std::vector<OutputContainerIndexEntry> voEntries(size_t(oFooter.nEntryCount));
+                oReader.seekg(std::streamoff(nFileSize-sizeof(oFooter)-voEntries.size()*sizeof(OutputContainerIndexEntry)));
+                oReader.read((char*)voEntries.data(),voEntries.size()*sizeof(OutputContainerIndexEntry));
+                for(const OutputContainerIndexEntry& oEntry : voEntries)
+                    mIndex[size_t(oEntry.nIdx)] = std::make_pair(oEntry.nOffset,oEntry.nSize);
+                return;
+            }
+        }
+        // no valid footer (e.g. the writing run was interrupted); rebuild the index by scanning records
+        uint64_t nOffset = nHeaderSize;
+        OutputContainerRecord oRecord;
+        oReader.clear();
+        oReader.seekg(std::streamoff(nOffset));
+        while(nOffset+sizeof(oRecord)<=nFileSize && oReader.read((char*)&oRecord,sizeof(oRecord)) && oRecord.nSize<=nFileSize-nOffset-sizeof(oRecord)) {
+            nOffset += sizeof(oRecord);
+            mIndex[size_t(oRecord.nIdx)] = std::make_pair(nOffset,oRecord.nSize);
+            nOffset += oRecord.nSize;
+            oReader.seekg(std::streamoff(nOffset));
+        }
+    }
+    std::mutex oMutex;
+    const std::string sFilePath;
+    std::ofstream oWriter;
+    std::ifstream oReader;
+    uint64_t nWriteOffset;
+    std::map<size_t,std::pair<uint64_t,uint64_t>> mIndex; // packet idx -> (payload offset, payload size)
+    bool bIndexLoaded;
+};
+
+lv::IDataArchiver::OutputContainer& lv::IDataArchiver::getOutputContainer() const {
+    std::mutex_lock_guard lock(m_oOutputContainerMutex);
+    if(!m_pOutputContainer) {
+        const std::string sFilePath = getOutputPath()+getDatasetInfo()->getOutputNamePrefix()+DATAARCHIVER_CONTAINER_NAME+getDatasetInfo()->getOutputNameSuffix();
+        m_pOutputContainer = std::make_shared<OutputContainer>(sFilePath);
+    }
+    return *m_pOutputContainer;
+}
+
 size_t lv::IDataArchiver::save(const cv::Mat& oOutput, size_t nIdx) const {
     lvAssert_(!getDatasetInfo()->getOutputNameSuffix().empty(),"data archiver requires packet output name suffix (i.e. file extension)");
     std::stringstream sOutputFilePath;
@@ -690,15 +2768,38 @@ size_t lv::IDataArchiver::save(const cv::Mat& oOutput, size_t nIdx) const {
     const auto pLoader = shared_from_this_cast<const IDataLoader>(true);
     if(pLoader->getIOMappingType()==PixelMapping && pLoader->getOutputPacketType()==ImagePacket) {
         const cv::Mat& oROI = pLoader->getInputROI(nIdx);
-        cv::Mat oOutputClone = oOutput.clone();
+        thread_local cv::Mat oOutputClone; // per-worker encode buffer, reused across packets when saving from async data writer threads
+        oOutput.copyTo(oOutputClone);
         if(!oROI.empty() && oROI.size()==oOutputClone.size())
             cv::bitwise_or(oOutputClone,DATASETUTILS_UNKNOWN_VAL,oOutputClone,oROI==0);
         if(pLoader->isInputTransposed(nIdx))
             cv::transpose(oOutputClone,oOutputClone);
         if(pLoader->getInputOrigSize(nIdx).area()>0 && oOutputClone.size()!=pLoader->getInputOrigSize(nIdx))
             cv::resize(oOutputClone,oOutputClone,pLoader->getInputOrigSize(nIdx),0,0,cv::INTER_NEAREST);
-        const std::vector<int> vnComprParams = {cv::IMWRITE_PNG_COMPRESSION,9};
-        cv::imwrite(sOutputFilePath.str(),oOutputClone,vnComprParams);
+        const std::string& sOutputNameSuffix = getDatasetInfo()->getOutputNameSuffix();
+        const bool bUsingContainer = sOutputNameSuffix.compare(0,sizeof(DATAARCHIVER_CONTAINER_PREFIX)-1,DATAARCHIVER_CONTAINER_PREFIX)==0;
+        const std::string sPacketNameSuffix = bUsingContainer?sOutputNameSuffix.substr(sizeof(DATAARCHIVER_CONTAINER_PREFIX)-1):sOutputNameSuffix;
+        const OutputCodec eCodec = getOutputCodec(sPacketNameSuffix);
+        static const std::vector<int> vnComprParams = {cv::IMWRITE_PNG_COMPRESSION,DATAARCHIVER_PNG_COMPRESSION_LEVEL};
+        if(bUsingContainer) {
+            thread_local std::vector<uchar> vEncodeBuffer;
+            if(eCodec==OutputCodec_OpenCV)
+                lvAssert__(cv::imencode(sPacketNameSuffix,oOutputClone,vEncodeBuffer,vnComprParams),"could not encode output packet as '%s'",sPacketNameSuffix.c_str());
+            else
+                encodeOutputPacket(oOutputClone,eCodec,vEncodeBuffer);
+            getOutputContainer().append(nIdx,vEncodeBuffer);
+        }
+        else if(eCodec==OutputCodec_OpenCV)
+            cv::imwrite(sOutputFilePath.str(),oOutputClone,vnComprParams);
+        else {
+            thread_local std::vector<uchar> vEncodeBuffer;
+            encodeOutputPacket(oOutputClone,eCodec,vEncodeBuffer);
+            std::ofstream oFile(sOutputFilePath.str(),std::ios::out|std::ios::binary|std::ios::trunc);
+            lvAssert__(oFile.is_open(),"could not create output file at '%s'",sOutputFilePath.str().c_str());
+            oFile.write((const char*)vEncodeBuffer.data(),vEncodeBuffer.size());
+        }
+        if(PacketLatencyTracer* pTracer = getLatencyTracer())
+            pTracer->mark(nIdx,PacketLatencyTracer::Stage_Write);
     }
     else {
         // @@@@ save to YML
@@ -707,13 +2808,61 @@ size_t lv::IDataArchiver::save(const cv::Mat& oOutput, size_t nIdx) const {
     return 0;
 }
 
+size_t lv::IDataArchiver::save(const lv::PackedBinaryMask& oOutput, size_t nIdx) const {
+    lvAssert_(!getDatasetInfo()->getOutputNameSuffix().empty(),"data archiver requires packet output name suffix (i.e. file extension)");
+    const auto pLoader = shared_from_this_cast<const IDataLoader>(true);
+    const std::string& sOutputNameSuffix = getDatasetInfo()->getOutputNameSuffix();
+    const bool bUsingContainer = sOutputNameSuffix.compare(0,sizeof(DATAARCHIVER_CONTAINER_PREFIX)-1,DATAARCHIVER_CONTAINER_PREFIX)==0;
+    const std::string sPacketNameSuffix = bUsingContainer?sOutputNameSuffix.substr(sizeof(DATAARCHIVER_CONTAINER_PREFIX)-1):sOutputNameSuffix;
+    // ROI masking is not needed for direct writes, as out-of-ROI pixels only become 'unknown' if they are not positive (and bit-packed packets only keep positives)
+    const bool bDirectWrite = getOutputCodec(sPacketNameSuffix)==OutputCodec_BitPacked &&
+                              pLoader->getIOMappingType()==PixelMapping && pLoader->getOutputPacketType()==ImagePacket && !pLoader->isInputTransposed(nIdx) &&
+                              (pLoader->getInputOrigSize(nIdx).area()==0 || oOutput.size()==pLoader->getInputOrigSize(nIdx));
+    if(!bDirectWrite) {
+        thread_local cv::Mat oUnpackedOutput;
+        oOutput.unpack(oUnpackedOutput,DATASETUTILS_POSITIVE_VAL);
+        return save(oUnpackedOutput,nIdx);
+    }
+    thread_local std::vector<uchar> vEncodeBuffer;
+    encodePackedOutputPacket(oOutput,vEncodeBuffer);
+    if(bUsingContainer)
+        getOutputContainer().append(nIdx,vEncodeBuffer);
+    else {
+        std::stringstream sOutputFilePath;
+        sOutputFilePath << getOutputPath() << getDatasetInfo()->getOutputNamePrefix() << getPacketName(nIdx) << sOutputNameSuffix;
+        std::ofstream oFile(sOutputFilePath.str(),std::ios::out|std::ios::binary|std::ios::trunc);
+        lvAssert__(oFile.is_open(),"could not create output file at '%s'",sOutputFilePath.str().c_str());
+        oFile.write((const char*)vEncodeBuffer.data(),vEncodeBuffer.size());
+    }
+    if(PacketLatencyTracer* pTracer = getLatencyTracer())
+        pTracer->mark(nIdx,PacketLatencyTracer::Stage_Write);
+    return 0;
+}
+
 cv::Mat lv::IDataArchiver::load(size_t nIdx) const {
     lvAssert_(!getDatasetInfo()->getOutputNameSuffix().empty(),"data archiver requires packet output name suffix (i.e. file extension)");
     std::stringstream sOutputFilePath;
     sOutputFilePath << getOutputPath() << getDatasetInfo()->getOutputNamePrefix() << getPacketName(nIdx) << getDatasetInfo()->getOutputNameSuffix();
     const auto pLoader = shared_from_this_cast<const IDataLoader>(true);
     if(pLoader->getIOMappingType()==PixelMapping && pLoader->getOutputPacketType()==ImagePacket) {
-        cv::Mat oOutput = cv::imread(sOutputFilePath.str(),isGrayscale()?cv::IMREAD_GRAYSCALE:cv::IMREAD_COLOR);
+        const std::string& sOutputNameSuffix = getDatasetInfo()->getOutputNameSuffix();
+        const bool bUsingContainer = sOutputNameSuffix.compare(0,sizeof(DATAARCHIVER_CONTAINER_PREFIX)-1,DATAARCHIVER_CONTAINER_PREFIX)==0;
+        const std::string sPacketNameSuffix = bUsingContainer?sOutputNameSuffix.substr(sizeof(DATAARCHIVER_CONTAINER_PREFIX)-1):sOutputNameSuffix;
+        const OutputCodec eCodec = getOutputCodec(sPacketNameSuffix);
+        cv::Mat oOutput;
+        if(bUsingContainer) {
+            std::vector<uchar> vBuffer;
+            if(getOutputContainer().read(nIdx,vBuffer)) // missing packets yield an empty mat, as with cv::imread
+                oOutput = (eCodec==OutputCodec_OpenCV)?cv::imdecode(vBuffer,isGrayscale()?cv::IMREAD_GRAYSCALE:cv::IMREAD_COLOR):decodeOutputPacket(vBuffer.data(),vBuffer.size(),eCodec);
+        }
+        else if(eCodec==OutputCodec_OpenCV)
+            oOutput = cv::imread(sOutputFilePath.str(),isGrayscale()?cv::IMREAD_GRAYSCALE:cv::IMREAD_COLOR);
+        else {
+            std::ifstream oFile(sOutputFilePath.str(),std::ios::in|std::ios::binary);
+            lvAssert__(oFile.is_open(),"could not open output file at '%s'",sOutputFilePath.str().c_str());
+            const std::vector<uchar> vBuffer((std::istreambuf_iterator<char>(oFile)),std::istreambuf_iterator<char>());
+            oOutput = decodeOutputPacket(vBuffer.data(),vBuffer.size(),eCodec);
+        }
         if(pLoader->isInputTransposed(nIdx))
             cv::transpose(oOutput,oOutput);
         if(getDatasetInfo()->is4ByteAligned() && oOutput.channels()==3)
@@ -758,7 +2907,7 @@ void lv::IAsyncDataConsumer_<lv::DatasetEval_BinaryClassifier,lv::GLSL>::pre_ini
     lvAssert_(m_pLoader->getTotPackets()>1,"async data consumer work batch should contain more than one packet");
     lvAssert_(m_pAlgo,"invalid algo given to async data consumer");
     m_oCurrInput = m_pLoader->getInput(m_nCurrIdx).clone();
-    m_oNextInput = m_pLoader->getInput(m_nNextIdx).clone();
+    m_oNextInput = m_pLoader->getInput(m_nNextIdx);
     m_oLastInput = m_oCurrInput.clone();
     lvAssert_(!m_oCurrInput.empty() && m_oCurrInput.isContinuous(),"invalid input fetched from loader");
     lvAssert_(m_oCurrInput.channels()==1 || m_oCurrInput.channels()==4,"loaded data must be 1ch or 4ch to avoid alignment problems");
@@ -768,7 +2917,7 @@ void lv::IAsyncDataConsumer_<lv::DatasetEval_BinaryClassifier,lv::GLSL>::pre_ini
         m_pAlgo->setDebugFetching(true);
     if(getDatasetInfo()->isUsingEvaluator()) {
         m_oCurrGT = m_pLoader->getGT(m_nCurrIdx).clone();
-        m_oNextGT = m_pLoader->getGT(m_nNextIdx).clone();
+        m_oNextGT = m_pLoader->getGT(m_nNextIdx);
         m_oLastGT = m_oCurrGT.clone();
         lvAssert_(!m_oCurrGT.empty() && m_oCurrGT.isContinuous(),"invalid gt fetched from loader");
         lvAssert_(m_oCurrGT.channels()==1 || m_oCurrGT.channels()==4,"gt data must be 1ch or 4ch to avoid alignment problems");
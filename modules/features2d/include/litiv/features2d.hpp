@@ -18,3 +18,5 @@
 #pragma once
 
 #include "litiv/features2d/LBSP.hpp"
+#include "litiv/features2d/LBSPMatcher.hpp"
+#include "litiv/features2d/LBSPDenseExtractor.hpp"
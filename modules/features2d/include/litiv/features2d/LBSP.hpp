@@ -27,6 +27,8 @@
 
     Note 1: both grayscale and RGB/BGR images may be used with this extractor.
     Note 2: using LBSP::compute2(...) is logically equivalent to using LBSP::compute(...) followed by LBSP::reshapeDesc(...).
+    Note 3: when all pixels need to be described, LBSP::computeDense(...) avoids the keypoint allocation/validation overhead.
+    Note 4: when the threshold mode and channel count are known at compile time, see LBSP_<eThresholdMode,nChannels> instead.
 
     For more details on the different parameters, see G.-A. Bilodeau et al, "Change Detection in Feature Space Using Local
     Binary Similarity Patterns", in CRV 2013.
@@ -55,16 +57,24 @@ public:
     virtual float getRelThreshold() const;
     /// returns the current absolute threshold used for comparisons (-1 = invalid/not used)
     virtual size_t getAbsThreshold() const;
+    /// sets the number of threads used by batch computations (0 = use all hardware threads)
+    void setThreadCount(size_t nThreads);
+    /// returns the number of threads used by batch computations (always at least one)
+    size_t getThreadCount() const;
 
     /// similar to DescriptorExtractor::compute(const cv::Mat& image, ...), but in this case, the descriptors matrix has the same shape as the input matrix
     void compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoints, cv::Mat& oDescriptors) const;
-    /// batch version of LBSP::compute2(const cv::Mat& image, ...)
+    /// batch version of LBSP::compute2(const cv::Mat& image, ...), runs images (and bands of large images) concurrently based on the thread count
     void compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<std::vector<cv::KeyPoint> >& vvoPointCollection, std::vector<cv::Mat>& voDescCollection) const;
+    /// computes descriptors for all pixels without keypoints, writing a CV_16UC(n) map of the input size; the optional 8UC1/8UC(n) threshold map overrides the internal thresholds
+    void computeDense(const cv::Mat& oImage, cv::Mat& oDescMap, const cv::Mat& oThresholds=cv::Mat(), int nBorderType=cv::BORDER_REPLICATE) const;
 
     /// utility function, used to reshape a descriptors matrix to its input image size via their keypoint locations
     static void reshapeDesc(cv::Size oSize, const std::vector<cv::KeyPoint>& voKeypoints, const cv::Mat& oDescriptors, cv::Mat& oOutput);
     /// utility function, used to illustrate the difference between two descriptor images
     static void calcDescImgDiff(const cv::Mat& oDesc1, const cv::Mat& oDesc2, cv::Mat& oOutput, bool bForceMergeChannels=false);
+    /// utility function, writes the raw per-pixel hamming distances between two descriptor images in a CV_8U map (merged channel distances are summed; the output buffer is reused if possible)
+    static void calcDescImgHammingDist(const cv::Mat& oDesc1, const cv::Mat& oDesc2, cv::Mat& oOutput, bool bMergeChannels=false);
     /// utility function, used to filter out bad keypoints that would trigger out of bounds error because they're too close to the image border
     static void validateKeyPoints(std::vector<cv::KeyPoint>& voKeypoints, cv::Size oImgSize);
     /// utility function, used to filter out bad pixels in a ROI that would trigger out of bounds error because they're too close to the image border
@@ -84,6 +94,8 @@ public:
     static constexpr size_t DESC_SIZE_BITS = DESC_SIZE*8;
     /// utility, specifies the maximum gradient magnitude value that can be returned by computeDescriptor_gradient
     static constexpr size_t MAX_GRAD_MAG = DESC_SIZE_BITS;
+    /// utility, border type to pass to computeDense in order to skip (and zero-fill) pixels too close to the image border instead of padding
+    static constexpr int BORDER_SKIP = -1;
 
     /// utility function, shortcut/lightweight/direct single-point LBSP computation function for extra flexibility (single-channel lookup, single-channel array thresholding)
     template<size_t nChannels>
@@ -93,6 +105,14 @@ public:
         nDesc = LBSP::computeDescriptor_threshold(anVals.data(),nRef,nThreshold);
     }
 
+    /// utility function, shortcut/lightweight/direct single-point LBSP computation function for extra flexibility (single-channel lookup, single-channel array thresholding, 16-bit input)
+    template<size_t nChannels>
+    static inline void computeDescriptor(const cv::Mat& oInputImg, const ushort nRef, const int _x, const int _y, const size_t _c, const ushort nThreshold, desc_t& nDesc) {
+        alignas(16) std::array<ushort,LBSP::DESC_SIZE_BITS> anVals;
+        LBSP::computeDescriptor_lookup<nChannels>(oInputImg,_x,_y,_c,anVals);
+        nDesc = LBSP::computeDescriptor_threshold(anVals.data(),nRef,nThreshold);
+    }
+
     /// utility function, shortcut/lightweight/direct single-point LBSP computation function for extra flexibility (multi-channel lookup, multi-channel array thresholding)
     template<size_t nChannels>
     static inline void computeDescriptor(const cv::Mat& oInputImg, const std::array<uchar,nChannels>& anRefs, const int _x, const int _y, const std::array<uchar,nChannels>& anThresholds, std::array<desc_t,nChannels>& anDesc) {
@@ -122,46 +142,48 @@ public:
     }
 
     /// utility function, shortcut/lightweight/direct single-point LBSP computation function for extra flexibility (single-channel lookup only)
-    template<size_t nChannels>
-    static inline void computeDescriptor_lookup(const cv::Mat& oInputImg, const int _x, const int _y, const size_t _c, std::array<uchar,DESC_SIZE_BITS>& anVals) {
-        static_assert(sizeof(std::array<uchar,DESC_SIZE_BITS>)==sizeof(uchar)*DESC_SIZE_BITS,"terrible impl of std::array right here");
+    template<size_t nChannels, typename TVal>
+    static inline void computeDescriptor_lookup(const cv::Mat& oInputImg, const int _x, const int _y, const size_t _c, std::array<TVal,DESC_SIZE_BITS>& anVals) {
+        static_assert(sizeof(std::array<TVal,DESC_SIZE_BITS>)==sizeof(TVal)*DESC_SIZE_BITS,"terrible impl of std::array right here");
         LBSP::computeDescriptor_lookup<nChannels>(oInputImg,_x,_y,_c,anVals.data());
     }
 
     /// utility function, shortcut/lightweight/direct single-point LBSP computation function for extra flexibility (multi-channel lookup only)
-    template<size_t nChannels>
-    static inline void computeDescriptor_lookup(const cv::Mat& oInputImg, const int _x, const int _y, std::array<std::array<uchar,DESC_SIZE_BITS>,nChannels>& aanVals) {
-        static_assert(sizeof(std::array<std::array<uchar,DESC_SIZE_BITS>,nChannels>)==sizeof(uchar)*DESC_SIZE_BITS*nChannels,"terrible impl of std::array right here");
+    template<size_t nChannels, typename TVal>
+    static inline void computeDescriptor_lookup(const cv::Mat& oInputImg, const int _x, const int _y, std::array<std::array<TVal,DESC_SIZE_BITS>,nChannels>& aanVals) {
+        static_assert(sizeof(std::array<std::array<TVal,DESC_SIZE_BITS>,nChannels>)==sizeof(TVal)*DESC_SIZE_BITS*nChannels,"terrible impl of std::array right here");
         lvDbgAssert_((void*)aanVals.data()==(void*)aanVals[0].data(),"bad indexing in array-of-array impl");
         LBSP::computeDescriptor_lookup<nChannels>(oInputImg,_x,_y,aanVals[0].data());
     }
 
-    /// utility function, shortcut/lightweight/direct single-point LBSP computation function for extra flexibility (single-channel lookup only)
-    template<size_t nChannels>
-    static inline void computeDescriptor_lookup(const cv::Mat& oInputImg, const int _x, const int _y, const size_t _c, uchar* anVals) {
+    /// utility function, shortcut/lightweight/direct single-point LBSP computation function for extra flexibility (single-channel lookup only; TVal must match the input depth)
+    template<size_t nChannels, typename TVal>
+    static inline void computeDescriptor_lookup(const cv::Mat& oInputImg, const int _x, const int _y, const size_t _c, TVal* anVals) {
         static_assert(nChannels>0,"need at least one image channel");
+        static_assert(std::is_same<TVal,uchar>::value || std::is_same<TVal,ushort>::value,"lookup only supports 8-bit and 16-bit unsigned pixels");
         lvDbgAssert_(anVals,"need to provide a valid pixel pointer");
-        lvDbgAssert__(!oInputImg.empty() && oInputImg.type()==CV_8UC(nChannels) && _c<nChannels,"need to provide a non-empty matrix of %d channels, with _c<%d",(int)nChannels,(int)nChannels);
+        lvDbgAssert__(!oInputImg.empty() && oInputImg.type()==CV_MAKETYPE(cv::DataType<TVal>::depth,(int)nChannels) && _c<nChannels,"need to provide a non-empty matrix of %d channels (with matching depth), with _c<%d",(int)nChannels,(int)nChannels);
         lvDbgAssert__(_x>=(int)LBSP::PATCH_SIZE/2 && _y>=(int)LBSP::PATCH_SIZE/2,"descriptor center needs to be at least %d pixels from image borders",(int)LBSP::PATCH_SIZE/2);
         lvDbgAssert__(_x<oInputImg.cols-(int)LBSP::PATCH_SIZE/2 && _y<oInputImg.rows-(int)LBSP::PATCH_SIZE/2,"descriptor center needs to be at least %d pixels from image borders",(int)LBSP::PATCH_SIZE/2);
-        const size_t nRowStep = oInputImg.step.p[0];
-        const size_t nColStep = oInputImg.step.p[1];
-        const uchar* const anData = oInputImg.data+_y*nRowStep+_x*nColStep+_c;
+        const size_t nRowStep = oInputImg.step.p[0]/sizeof(TVal);
+        const size_t nColStep = oInputImg.step.p[1]/sizeof(TVal);
+        const TVal* const anData = ((const TVal*)oInputImg.data)+_y*nRowStep+_x*nColStep+_c;
         LBSP::lookup_16bits_dbcross<nChannels>(anData,nRowStep,nColStep,anVals);
     }
 
-    /// utility function, shortcut/lightweight/direct single-point LBSP computation function for extra flexibility (multi-channel lookup only)
-    template<size_t nChannels>
-    static inline void computeDescriptor_lookup(const cv::Mat& oInputImg, const int _x, const int _y, uchar* aanVals) {
+    /// utility function, shortcut/lightweight/direct single-point LBSP computation function for extra flexibility (multi-channel lookup only; TVal must match the input depth)
+    template<size_t nChannels, typename TVal>
+    static inline void computeDescriptor_lookup(const cv::Mat& oInputImg, const int _x, const int _y, TVal* aanVals) {
         static_assert(nChannels>0,"need at least one image channel");
+        static_assert(std::is_same<TVal,uchar>::value || std::is_same<TVal,ushort>::value,"lookup only supports 8-bit and 16-bit unsigned pixels");
         lvDbgAssert_(aanVals,"need to provide a valid pixel pointer");
-        lvDbgAssert__(!oInputImg.empty() && oInputImg.type()==CV_8UC(nChannels),"need to provide a non-empty matrix of %d channels",(int)nChannels);
+        lvDbgAssert__(!oInputImg.empty() && oInputImg.type()==CV_MAKETYPE(cv::DataType<TVal>::depth,(int)nChannels),"need to provide a non-empty matrix of %d channels (with matching depth)",(int)nChannels);
         lvDbgAssert__(_x>=(int)LBSP::PATCH_SIZE/2 && _y>=(int)LBSP::PATCH_SIZE/2,"descriptor center needs to be at least %d pixels from image borders",(int)LBSP::PATCH_SIZE/2);
         lvDbgAssert__(_x<oInputImg.cols-(int)LBSP::PATCH_SIZE/2 && _y<oInputImg.rows-(int)LBSP::PATCH_SIZE/2,"descriptor center needs to be at least %d pixels from image borders",(int)LBSP::PATCH_SIZE/2);
-        const size_t nRowStep = oInputImg.step.p[0];
-        const size_t nColStep = oInputImg.step.p[1];
+        const size_t nRowStep = oInputImg.step.p[0]/sizeof(TVal);
+        const size_t nColStep = oInputImg.step.p[1]/sizeof(TVal);
         lv::unroll<nChannels>([&](int _c) {
-            const uchar* const anData = oInputImg.data+_y*nRowStep+_x*nColStep+_c;
+            const TVal* const anData = ((const TVal*)oInputImg.data)+_y*nRowStep+_x*nColStep+_c;
             LBSP::lookup_16bits_dbcross<nChannels>(anData,nRowStep,nColStep,aanVals+_c*LBSP::DESC_SIZE_BITS);
         });
     }
@@ -177,7 +199,11 @@ public:
         // note: this function is used to threshold an LBSP pattern based on a predefined lookup array (see LBSP_16bits_dbcross_lookup for more information)
         // @@@ todo: use array template to unroll loops & allow any descriptor size here
         lvDbgAssert_(anVals,"need to provide a valid pixel pointer");
-#if (!HAVE_SSE4_1 && !HAVE_SSE2)
+#if HAVE_NEON
+        static_assert(LBSP::DESC_SIZE_BITS==16,"current neon impl can only manage 16-byte chunks");
+        const uint8x16_t _abCmpRes = vcgtq_u8(vabdq_u8(vld1q_u8(anVals),vdupq_n_u8(nRef)),vdupq_n_u8(nThreshold));
+        return (desc_t)lv::movemask_16ub(_abCmpRes);
+#elif (!HAVE_SSE4_1 && !HAVE_SSE2)
         desc_t nDesc = 0;
         lv::unroll<LBSP::DESC_SIZE_BITS>([&](int n) {
             nDesc |= (lv::L1dist(anVals[n],nRef) > nThreshold) << n;
@@ -206,6 +232,52 @@ public:
 #endif //(HAVE_SSE4_1 || HAVE_SSE2)
     }
 
+    /// utility function, shortcut/lightweight/direct single-point LBSP computation function for extra flexibility (16-bit array thresholding only)
+    static inline desc_t computeDescriptor_threshold(const std::array<ushort,LBSP::DESC_SIZE_BITS>& anVals, const ushort nRef, const ushort nThreshold) {
+        static_assert(sizeof(std::array<ushort,LBSP::DESC_SIZE_BITS>)==sizeof(ushort)*LBSP::DESC_SIZE_BITS,"terrible impl of std::array right here");
+        return LBSP::computeDescriptor_threshold(anVals.data(),nRef,nThreshold);
+    }
+
+    /// utility function, shortcut/lightweight/direct single-point LBSP computation function for extra flexibility (16-bit array thresholding only)
+    static inline desc_t computeDescriptor_threshold(const ushort* const anVals, const ushort nRef, const ushort nThreshold) {
+        lvDbgAssert_(anVals,"need to provide a valid pixel pointer");
+#if HAVE_NEON
+        static_assert(LBSP::DESC_SIZE_BITS==16,"current neon impl can only manage 16-element chunks");
+        const uint16x8_t _anRefVals = vdupq_n_u16(nRef), _anThreshold = vdupq_n_u16(nThreshold);
+        const uint16x8_t _abCmpRes_lo = vcgtq_u16(vabdq_u16(vld1q_u16(anVals),_anRefVals),_anThreshold);
+        const uint16x8_t _abCmpRes_hi = vcgtq_u16(vabdq_u16(vld1q_u16(anVals+8),_anRefVals),_anThreshold);
+        return (desc_t)lv::movemask_16ub(vcombine_u8(vmovn_u16(_abCmpRes_lo),vmovn_u16(_abCmpRes_hi)));
+#elif !HAVE_SSE2
+        desc_t nDesc = 0;
+        lv::unroll<LBSP::DESC_SIZE_BITS>([&](int n) {
+            nDesc |= (lv::L1dist(anVals[n],nRef) > nThreshold) << n;
+        });
+        return nDesc;
+#else //HAVE_SSE2
+        static_assert(LBSP::DESC_SIZE_BITS==16,"current sse impl can only manage 16-element chunks");
+        // unsigned abs diffs are built from saturated subtractions, and 'dist>threshold' is tested as a non-null saturated 'dist-threshold'
+        const __m128i _anRefVals = _mm_set1_epi16((short)nRef), _anThreshold = _mm_set1_epi16((short)nThreshold), _anZero = _mm_setzero_si128();
+        const __m128i _anInputVals_lo = _mm_loadu_si128((const __m128i*)anVals), _anInputVals_hi = _mm_loadu_si128((const __m128i*)(anVals+8));
+        const __m128i _anDistVals_lo = _mm_or_si128(_mm_subs_epu16(_anInputVals_lo,_anRefVals),_mm_subs_epu16(_anRefVals,_anInputVals_lo));
+        const __m128i _anDistVals_hi = _mm_or_si128(_mm_subs_epu16(_anInputVals_hi,_anRefVals),_mm_subs_epu16(_anRefVals,_anInputVals_hi));
+        const __m128i _abMatchRes_lo = _mm_cmpeq_epi16(_mm_subs_epu16(_anDistVals_lo,_anThreshold),_anZero);
+        const __m128i _abMatchRes_hi = _mm_cmpeq_epi16(_mm_subs_epu16(_anDistVals_hi,_anThreshold),_anZero);
+        return (desc_t)~_mm_movemask_epi8(_mm_packs_epi16(_abMatchRes_lo,_abMatchRes_hi));
+#endif //HAVE_SSE2
+    }
+
+    /// utility function, row-batched LBSP computation function for a contiguous run of pixels (interleaved lookup, fixed thresholding)
+    template<size_t nChannels>
+    static inline void computeDescriptor_row(const uchar* const anData, const uchar* const anRefs, const size_t nRowStep, const size_t nPx, const uchar nThreshold, desc_t* const anDesc) {
+        LBSP::computeDescriptor_row_impl<nChannels,false>(anData,anRefs,nRowStep,nPx,nullptr,nThreshold,anDesc);
+    }
+
+    /// utility function, row-batched LBSP computation function for a contiguous run of pixels (interleaved lookup, per-element array thresholding)
+    template<size_t nChannels>
+    static inline void computeDescriptor_row(const uchar* const anData, const uchar* const anRefs, const size_t nRowStep, const size_t nPx, const uchar* const anThresholds, desc_t* const anDesc) {
+        LBSP::computeDescriptor_row_impl<nChannels,true>(anData,anRefs,nRowStep,nPx,anThresholds,0,anDesc);
+    }
+
     /// utility function, shortcut/lightweight/direct single-point LBSP gradient computation function (mixes rel+abs, returns max-channel only)
     template<size_t nChannels, size_t nAbsOffset=20, size_t nRelShift=2, typename Tr1=int, typename Tr2=uint>
     static inline void computeDescriptor_gradient(const std::array<std::array<uchar,DESC_SIZE_BITS>,nChannels>& aanVals, const std::array<uchar,nChannels>& anRefs, Tr1& nGradX, Tr1& nGradY, Tr2& nGradMag) {
@@ -245,6 +317,10 @@ protected:
     const float m_fRelThreshold;
     const size_t m_nThreshold;
     cv::Mat m_oRefImage;
+    /// number of threads to use for batch computations (0 = all hardware threads)
+    size_t m_nThreadCount;
+    /// fills a lookup table with the comparison threshold to use for each possible 8-bit reference value
+    void fillThresholdLUT(std::array<uchar,UCHAR_MAX+1>& anThresholdLUT) const;
 
     // arrays below do not rely on std::array to avoid multi-dim init problems w/ static constexpr in header files
 
@@ -274,6 +350,25 @@ protected:
             s_oIdxLUT_16bitdbcross_x = {{-2, 2, 0, 0,  -2, 2, 2,-2,   0,-1, 0, 1,  -1, 1, 1,-1}},
             s_oIdxLUT_16bitdbcross_y = {{ 0, 0,-2, 2,   2,-2, 2,-2,   1, 0,-1, 0,  -1, 1,-1, 1}};
 
+    template<size_t nChannels, bool bUseThresholdArray>
+    static inline void computeDescriptor_row_impl(const uchar* const anData, const uchar* const anRefs, const size_t nRowStep, const size_t nPx, const uchar* const anThresholds, const uchar nThreshold, desc_t* const anDesc) {
+        // note: all 'nPx' pixels pointed to by anData must be at least PATCH_SIZE/2 away from the image borders; since channels are interleaved
+        // and share the same neighbor offsets, consecutive elements (pixel*nChannels+c) of a row can be processed as a single flat array
+        static_assert(nChannels>0,"need at least one image channel");
+        static_assert(LBSP::DESC_SIZE_BITS==16,"current row-batched impl can only manage 16-bit descriptors");
+        lvDbgAssert_(anData && anRefs && anDesc,"need to provide valid data/ref/desc pointers");
+        lvDbgAssert_(!bUseThresholdArray || anThresholds,"need to provide a valid threshold array pointer");
+        lvDbgAssert(nRowStep*2+nChannels*2<INT32_MAX);
+        std::array<ptrdiff_t,LBSP::DESC_SIZE_BITS> anOffsets;
+        lv::unroll<LBSP::DESC_SIZE_BITS>([&](int n) {
+            anOffsets[n] = (ptrdiff_t)nRowStep*s_oIdxLUT_16bitdbcross_y.anOffsets[n]+(ptrdiff_t)nChannels*s_oIdxLUT_16bitdbcross_x.anOffsets[n];
+        });
+        LBSP::computeDescriptor_row_dispatch(anData,anRefs,anOffsets.data(),nPx*nChannels,bUseThresholdArray?anThresholds:nullptr,nThreshold,anDesc);
+    }
+
+    /// runtime-dispatched row-batched kernel (picks the best instruction set supported by the current CPU, see lv::getSupportedSIMDInstrSet)
+    static void computeDescriptor_row_dispatch(const uchar* anData, const uchar* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const uchar* anThresholds, uchar nThreshold, desc_t* anDesc);
+
     template<size_t nChannels, typename Tv>
     static inline void lookup_16bits_dbcross(const Tv* const anData, const size_t nRowStep, const size_t nColStep, Tv* const anVals) {
 /*#if !HAVE_SSE2
@@ -295,3 +390,177 @@ protected:
 //#endif //(!HAVE_SSE2)
     }
 };
+
+/// comparison threshold modes which can be fixed at compile time for LBSP extractors (see LBSP_)
+enum LBSPThresholdMode {
+    LBSPThreshold_Absolute, ///< fixed intensity threshold, see LBSP::LBSP(size_t)
+    LBSPThreshold_Relative, ///< reference-intensity-based threshold with fixed offset, see LBSP::LBSP(float,size_t)
+};
+
+/*!
+    LBSP feature extractor specialization with threshold mode and channel count fixed at compile time
+
+    The threshold LUT is computed once at construction time, and all computations branch directly to the proper row-batched
+    kernels without any runtime mode/channel dispatching; input images must be of type CV_8UC(nChannels).
+ */
+template<LBSPThresholdMode eThresholdMode, size_t nChannels>
+class LBSP_ : public LBSP {
+    static_assert(nChannels==1 || nChannels==3,"specialized LBSP extractors only support 1- or 3-channel images");
+public:
+    /// constructor for absolute threshold mode, see LBSP::LBSP(size_t)
+    template<LBSPThresholdMode eModeTemp=eThresholdMode, typename=std::enable_if_t<eModeTemp==LBSPThreshold_Absolute>>
+    explicit LBSP_(size_t nThreshold) : LBSP(nThreshold) {fillThresholdLUT(m_anThresholdLUT);}
+    /// constructor for relative threshold mode, see LBSP::LBSP(float,size_t)
+    template<LBSPThresholdMode eModeTemp=eThresholdMode, typename=std::enable_if_t<eModeTemp==LBSPThreshold_Relative>>
+    explicit LBSP_(float fRelThreshold, size_t nThresholdOffset=0) : LBSP(fRelThreshold,nThresholdOffset) {fillThresholdLUT(m_anThresholdLUT);}
+    using LBSP::compute2;
+    /// specialized version of LBSP::compute2(const cv::Mat& image, ...)
+    void compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoints, cv::Mat& oDescriptors) const;
+    /// specialized version of LBSP::computeDense(...)
+    void computeDense(const cv::Mat& oImage, cv::Mat& oDescMap, const cv::Mat& oThresholds=cv::Mat(), int nBorderType=cv::BORDER_REPLICATE) const;
+    /// returns the precomputed comparison threshold to use for a given reference intensity
+    inline uchar getThreshold(uchar nRef) const {
+        return m_anThresholdLUT[eThresholdMode==LBSPThreshold_Absolute?0:nRef];
+    }
+    /// single-point LBSP computation function using the precomputed thresholds (same as LBSP::computeDescriptor<nChannels>(...) with per-channel thresholds)
+    inline void computeDescriptor(const cv::Mat& oInputImg, const uchar* const anRefs, const int _x, const int _y, desc_t* anDesc) const {
+        std::array<uchar,nChannels> anThresholds;
+        lv::unroll<nChannels>([&](int _c) {
+            anThresholds[_c] = getThreshold(anRefs[_c]);
+        });
+        LBSP::computeDescriptor<nChannels>(oInputImg,anRefs,_x,_y,anThresholds.data(),anDesc);
+    }
+
+protected:
+    /// specialized version of LBSP::computeImpl(...)
+    virtual void computeImpl(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoints, cv::Mat& oDescriptors) const override;
+    /// comparison thresholds for all possible 8-bit reference values (filled at construction)
+    std::array<uchar,UCHAR_MAX+1> m_anThresholdLUT;
+};
+
+/// absolute-threshold grayscale LBSP extractor
+using LBSP_Abs1ch = LBSP_<LBSPThreshold_Absolute,1>;
+/// absolute-threshold color LBSP extractor
+using LBSP_Abs3ch = LBSP_<LBSPThreshold_Absolute,3>;
+/// relative-threshold grayscale LBSP extractor
+using LBSP_Rel1ch = LBSP_<LBSPThreshold_Relative,1>;
+/// relative-threshold color LBSP extractor
+using LBSP_Rel3ch = LBSP_<LBSPThreshold_Relative,3>;
+
+/*!
+    LBSP sampling pattern utilities, templated on descriptor size (16, 24 or 32 bits)
+
+    The 16-bit pattern is the double-cross pattern used everywhere else in the framework (see LBSP), and simply forwards to
+    its functions. The 24-bit pattern samples the full 5x5 patch around the center pixel, and the 32-bit pattern adds the
+    8 corners/tips of a 7x7 cross to it. Wider descriptors are stored in 32-bit integers (lv::popcount/lv::hdist handle them
+    via the 32-bit hardware popcount when available).
+ */
+template<size_t nDescBits>
+struct LBSPPattern {
+    static_assert(nDescBits==24 || nDescBits==32,"unsupported LBSP pattern size (use 16, 24 or 32 bits)");
+    /// utility, specifies the integer type used to store descriptors
+    typedef uint32_t desc_t;
+    /// utility, specifies the pixel size of the pattern used (width and height)
+    static constexpr size_t PATCH_SIZE = (nDescBits==24)?5:7;
+    /// utility, specifies the number of bytes per descriptor
+    static constexpr size_t DESC_SIZE = sizeof(desc_t);
+    /// utility, specifies the number of bits per descriptor
+    static constexpr size_t DESC_SIZE_BITS = nDescBits;
+    /// utility, specifies the size of lookup value arrays (padded to a multiple of 16 bytes for SIMD thresholding)
+    static constexpr size_t LOOKUP_SIZE = ((nDescBits+15)/16)*16;
+
+    /// utility function, shortcut/lightweight/direct single-point LBSP computation function
+    template<size_t nChannels>
+    static inline void computeDescriptor(const cv::Mat& oInputImg, const uchar nRef, const int _x, const int _y, const size_t _c, const uchar nThreshold, desc_t& nDesc) {
+        alignas(16) std::array<uchar,LOOKUP_SIZE> anVals;
+        LBSPPattern::computeDescriptor_lookup<nChannels>(oInputImg,_x,_y,_c,anVals.data());
+        nDesc = LBSPPattern::computeDescriptor_threshold(anVals.data(),nRef,nThreshold);
+    }
+
+    /// utility function, shortcut/lightweight/direct single-point LBSP computation function (single-channel lookup only, array must hold LOOKUP_SIZE values)
+    template<size_t nChannels>
+    static inline void computeDescriptor_lookup(const cv::Mat& oInputImg, const int _x, const int _y, const size_t _c, uchar* anVals) {
+        static_assert(nChannels>0,"need at least one image channel");
+        lvDbgAssert_(anVals,"need to provide a valid pixel pointer");
+        lvDbgAssert__(!oInputImg.empty() && oInputImg.type()==CV_8UC(nChannels) && _c<nChannels,"need to provide a non-empty matrix of %d channels, with _c<%d",(int)nChannels,(int)nChannels);
+        lvDbgAssert__(_x>=(int)PATCH_SIZE/2 && _y>=(int)PATCH_SIZE/2,"descriptor center needs to be at least %d pixels from image borders",(int)PATCH_SIZE/2);
+        lvDbgAssert__(_x<oInputImg.cols-(int)PATCH_SIZE/2 && _y<oInputImg.rows-(int)PATCH_SIZE/2,"descriptor center needs to be at least %d pixels from image borders",(int)PATCH_SIZE/2);
+        const size_t nRowStep = oInputImg.step.p[0];
+        const uchar* const anData = oInputImg.data+_y*nRowStep+_x*nChannels+_c;
+        lv::unroll<nDescBits>([&](int n) {
+            anVals[n] = anData[(ptrdiff_t)nRowStep*s_anIdxLUT_y[n]+(ptrdiff_t)nChannels*s_anIdxLUT_x[n]];
+        });
+        for(size_t n=nDescBits; n<LOOKUP_SIZE; ++n)
+            anVals[n] = anData[0]; // padding, masked out during thresholding
+    }
+
+    /// utility function, shortcut/lightweight/direct single-point LBSP computation function (array thresholding only, array must hold LOOKUP_SIZE values)
+    static inline desc_t computeDescriptor_threshold(const uchar* const anVals, const uchar nRef, const uchar nThreshold) {
+        lvDbgAssert_(anVals,"need to provide a valid pixel pointer");
+        constexpr desc_t nDescMask = desc_t(0xFFFFFFFFu>>(32-nDescBits));
+        desc_t nDesc = 0;
+#if HAVE_NEON
+        lv::unroll<LOOKUP_SIZE/16>([&](int n) {
+            const uint8x16_t _abCmpRes = vcgtq_u8(vabdq_u8(vld1q_u8(anVals+n*16),vdupq_n_u8(nRef)),vdupq_n_u8(nThreshold));
+            nDesc |= desc_t(lv::movemask_16ub(_abCmpRes))<<(n*16);
+        });
+#elif HAVE_SSE2
+        // unsigned 'dist > threshold' is evaluated via saturated subtraction (non-zero result means greater)
+        const __m128i _anRefVals = _mm_set1_epi8((char)nRef);
+        const __m128i _anThresholdVals = _mm_set1_epi8((char)nThreshold);
+        const __m128i _anZeros = _mm_setzero_si128();
+        lv::unroll<LOOKUP_SIZE/16>([&](int n) {
+            const __m128i _anInputVals = _mm_loadu_si128((const __m128i*)(anVals+n*16));
+            const __m128i _anDistVals = _mm_or_si128(_mm_subs_epu8(_anInputVals,_anRefVals),_mm_subs_epu8(_anRefVals,_anInputVals));
+            const int nCmpRes = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(_anDistVals,_anThresholdVals),_anZeros))&0xFFFF;
+            nDesc |= desc_t(nCmpRes)<<(n*16);
+        });
+#else //(!HAVE_NEON && !HAVE_SSE2)
+        lv::unroll<nDescBits>([&](int n) {
+            nDesc |= desc_t(lv::L1dist(anVals[n],nRef) > nThreshold) << n;
+        });
+#endif //(!HAVE_NEON && !HAVE_SSE2)
+        return nDesc&nDescMask;
+    }
+
+    /// pattern offsets (x,y); the first 24 cover the full 5x5 patch, the last 8 are only used by the 32-bit pattern
+    static constexpr int s_anIdxLUT_x[32] = {-2,-1, 0, 1, 2,  -2,-1, 0, 1, 2,  -2,-1, 1, 2,  -2,-1, 0, 1, 2,  -2,-1, 0, 1, 2,  -3, 3, 0, 0,  -3, 3, 3,-3};
+    static constexpr int s_anIdxLUT_y[32] = {-2,-2,-2,-2,-2,  -1,-1,-1,-1,-1,   0, 0, 0, 0,   1, 1, 1, 1, 1,   2, 2, 2, 2, 2,   0, 0,-3, 3,  -3, 3,-3, 3};
+};
+
+template<size_t nDescBits>
+constexpr int LBSPPattern<nDescBits>::s_anIdxLUT_x[32];
+template<size_t nDescBits>
+constexpr int LBSPPattern<nDescBits>::s_anIdxLUT_y[32];
+
+/// 16-bit LBSP pattern specialization (default), forwards to the original double-cross implementation in LBSP
+template<>
+struct LBSPPattern<16> {
+    /// utility, specifies the integer type used to store descriptors
+    typedef LBSP::desc_t desc_t;
+    /// utility, specifies the pixel size of the pattern used (width and height)
+    static constexpr size_t PATCH_SIZE = LBSP::PATCH_SIZE;
+    /// utility, specifies the number of bytes per descriptor
+    static constexpr size_t DESC_SIZE = LBSP::DESC_SIZE;
+    /// utility, specifies the number of bits per descriptor
+    static constexpr size_t DESC_SIZE_BITS = LBSP::DESC_SIZE_BITS;
+    /// utility, specifies the size of lookup value arrays
+    static constexpr size_t LOOKUP_SIZE = LBSP::DESC_SIZE_BITS;
+
+    /// utility function, shortcut/lightweight/direct single-point LBSP computation function
+    template<size_t nChannels>
+    static inline void computeDescriptor(const cv::Mat& oInputImg, const uchar nRef, const int _x, const int _y, const size_t _c, const uchar nThreshold, desc_t& nDesc) {
+        LBSP::computeDescriptor<nChannels>(oInputImg,nRef,_x,_y,_c,nThreshold,nDesc);
+    }
+
+    /// utility function, shortcut/lightweight/direct single-point LBSP computation function (single-channel lookup only, array must be 16-byte aligned)
+    template<size_t nChannels>
+    static inline void computeDescriptor_lookup(const cv::Mat& oInputImg, const int _x, const int _y, const size_t _c, uchar* anVals) {
+        LBSP::computeDescriptor_lookup<nChannels>(oInputImg,_x,_y,_c,anVals);
+    }
+
+    /// utility function, shortcut/lightweight/direct single-point LBSP computation function (array thresholding only, array must be 16-byte aligned)
+    static inline desc_t computeDescriptor_threshold(const uchar* const anVals, const uchar nRef, const uchar nThreshold) {
+        return LBSP::computeDescriptor_threshold(anVals,nRef,nThreshold);
+    }
+};
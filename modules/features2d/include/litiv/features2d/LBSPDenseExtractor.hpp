@@ -0,0 +1,84 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/features2d/LBSP.hpp"
+#include "litiv/utils/parallel.hpp"
+
+#define LBSPDENSE_GLSL_USE_SHAREDMEM 1
+
+/*!
+    Dense LBSP descriptor map extractor for streams of images, running on the GPU
+
+    Note 1: descriptor maps are CV_16UC1/CV_16UC3 images of the input size, and are identical to the ones returned by
+            LBSP::computeDense(..., cv::BORDER_CONSTANT) (out-of-bounds image loads return zero); pixels outside the ROI are zeroed.
+    Note 2: each 'apply' call uploads the next image and describes the previous one (i.e. the initialization image on the first
+            call); readback is optional, and the descriptor map image can be consumed directly by other GPU algos (see
+            GLImageProcPipeline) without any host round-trip.
+ */
+template<lv::ParallelAlgoType eImpl>
+struct LBSPDenseExtractor_;
+
+#if HAVE_GLSL
+template<>
+struct LBSPDenseExtractor_<lv::GLSL> : public lv::IParallelAlgo_GLSL {
+    /// constructor 1, threshold = absolute intensity 'similarity' threshold used when computing comparisons
+    LBSPDenseExtractor_(size_t nChannels, size_t nThreshold, bool bUseDisplay=false, bool bUseTimers=false);
+    /// constructor 2, threshold = relative intensity 'similarity' threshold used when computing comparisons
+    LBSPDenseExtractor_(size_t nChannels, float fRelThreshold, size_t nThresholdOffset, bool bUseDisplay=false, bool bUseTimers=false);
+    /// (re)initialization method; needs to be called before processing the image stream (the ROI defaults to the full image)
+    void initialize(const cv::Mat& oInitImg, const cv::Mat& oROI=cv::Mat());
+    /// uploads the next image to the GPU & computes the descriptor map of the previous one (no readback)
+    void apply(const cv::Mat& oNextImg, bool bRebindAll=false);
+    /// uploads the next image to the GPU, computes the descriptor map of the previous one, and fetches it; returns its frame index
+    size_t apply(const cv::Mat& oNextImg, cv::Mat& oLastDescMap, bool bRebindAll=false);
+    /// fetches the latest computed descriptor map (enables output fetching if needed); returns its frame index (size_t(-1) if none yet)
+    size_t getLatestDescMap(cv::Mat& oLastDescMap);
+    /// returns the GLSL compute shader source code to run for a given algo stage
+    virtual std::string getComputeShaderSource(size_t nStage) const override;
+    /// returns whether this extractor is using a relative threshold or not
+    bool isUsingRelThreshold() const {return !m_bOnlyUsingAbsThreshold;}
+    /// number of input image (and output descriptor map) channels
+    const size_t m_nChannels;
+
+protected:
+    /// custom dispatch call function to cover the full image with the current work group size
+    virtual void dispatch(size_t nStage, GLShader& oShader) override;
+    /// returns the number of shader variants available for autotuning (default shared mem preloading setting, and its opposite)
+    virtual size_t getShaderVariantCount() const override {return 2;}
+    /// returns whether the current shader variant preloads image data in shared mem or not
+    bool getIsUsingSharedMem() const {return (m_nShaderVariant==0)==bool(LBSPDENSE_GLSL_USE_SHAREDMEM);}
+
+    const bool m_bOnlyUsingAbsThreshold;
+    const float m_fRelThreshold;
+    const size_t m_nThreshold;
+    bool m_bInitialized;
+    cv::Size m_oImgSize;
+    int m_nImgType;
+};
+
+using LBSPDenseExtractor_GLSL = LBSPDenseExtractor_<lv::GLSL>;
+#endif //HAVE_GLSL
+
+#if HAVE_CUDA
+// LBSPDenseExtractor_<lv::CUDA> will not compile here, missing impl
+#endif //HAVE_CUDA
+
+#if HAVE_OPENCL
+// LBSPDenseExtractor_<lv::OpenCL> will not compile here, missing impl
+#endif //HAVE_OPENCL
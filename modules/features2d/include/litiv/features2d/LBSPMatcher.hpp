@@ -0,0 +1,74 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/features2d/LBSP.hpp"
+
+/*!
+    Hamming distance matcher specialized for LBSP descriptors
+
+    Note 1: descriptor mats are used as-is, i.e. CV_16UC(n) mats (n in [1,3]) as returned by LBSP::compute (Nx1),
+            LBSP::compute2 or LBSP::computeDense (image-shaped), where every element is one descriptor (raster order).
+    Note 2: train descriptors are stored channel-planar, so brute-force matching computes 16 distances per SIMD
+            iteration; large train sets are also indexed in a multi-index hash table (one table per 8- or 16-bit
+            descriptor substring, see M. Norouzi et al., "Fast Search in Hamming Space with Multi-Index Hashing",
+            in CVPR 2012), which is used for small radii and falls back to brute-force matching otherwise.
+    Note 3: returned matches are sorted by distance, then by train index.
+ */
+class LBSPMatcher {
+public:
+    /// constructor; the multi-index hash is only built for train sets of at least nMultiIndexMinTrainSize descriptors (0 = never)
+    explicit LBSPMatcher(size_t nMultiIndexMinTrainSize=4096);
+    /// sets the train descriptors (replaces the previous ones, and rebuilds the multi-index hash if needed)
+    void train(const cv::Mat& oTrainDescs);
+    /// releases the train descriptors & multi-index hash
+    void clear();
+    /// returns the number of train descriptors
+    size_t getTrainSize() const {return m_nTrainSize;}
+    /// returns the channel count of train descriptors (0 if not trained)
+    size_t getChannelCount() const {return m_nChannels;}
+    /// returns whether the multi-index hash is built for the current train set
+    bool isUsingMultiIndex() const {return !m_vvnBucketOffsets.empty();}
+    /// finds the nearest train descriptor of each query descriptor
+    void match(const cv::Mat& oQueryDescs, std::vector<cv::DMatch>& voMatches) const;
+    /// finds the (up to) nK nearest train descriptors of each query descriptor
+    void knnMatch(const cv::Mat& oQueryDescs, std::vector<std::vector<cv::DMatch>>& vvoMatches, size_t nK) const;
+    /// finds all train descriptors within a hamming distance of nMaxDist of each query descriptor
+    void radiusMatch(const cv::Mat& oQueryDescs, std::vector<std::vector<cv::DMatch>>& vvoMatches, size_t nMaxDist) const;
+
+protected:
+    /// finds the (up to) nK nearest train descriptors of a query, or all those within nMaxDist if nK==0
+    void matchQuery(const ushort* anQuery, size_t nK, size_t nMaxDist, std::vector<std::pair<uchar,uint>>& vMatches, std::vector<uchar>& vnDistRow) const;
+    /// multi-index hash version of matchQuery; returns false if the search radius is too large for multi-index lookups to pay off
+    bool matchQuery_MultiIndex(uint64_t nQueryKey, size_t nK, size_t nMaxDist, std::vector<std::pair<uchar,uint>>& vMatches) const;
+    /// runs matchQuery over all query descriptors (in parallel) and converts the results to DMatch vectors
+    void matchAll(const cv::Mat& oQueryDescs, size_t nK, size_t nMaxDist, std::vector<std::vector<cv::DMatch>>& vvoMatches) const;
+    /// minimum train set size for which the multi-index hash is built
+    const size_t m_nMultiIndexMinTrainSize;
+    /// number of channels & number of train descriptors
+    size_t m_nChannels,m_nTrainSize;
+    /// channel-planar train descriptors; each plane holds m_nPlaneStride (>=m_nTrainSize, multiple of 16) descriptors
+    std::vector<ushort,lv::AlignedMemAllocator<ushort,16>> m_vnTrainPlanes;
+    size_t m_nPlaneStride;
+    /// train descriptors packed in 64-bit keys (channel c in bits [16c,16c+16)), used for multi-index candidate checks
+    std::vector<uint64_t> m_vnTrainKeys;
+    /// multi-index hash substring width (in bits) & substring count
+    size_t m_nSubstrBits,m_nSubstrCount;
+    /// multi-index hash tables; per substring, the bucket offsets (CSR, 2^m_nSubstrBits+1 entries) in the train index list
+    std::vector<std::vector<uint>> m_vvnBucketOffsets,m_vvnBucketIdxs;
+};
@@ -16,6 +16,7 @@
 // limitations under the License.
 
 #include "litiv/features2d/LBSP.hpp"
+#include "LBSP_kernels.hpp"
 
 // make sure static constexpr array addresses exist
 constexpr int LBSP::s_anIdxLUT_16bitdbcross[16][2];
@@ -23,18 +24,21 @@ constexpr int LBSP::s_anIdxLUT_16bitdbcross_GradX[16];
 constexpr int LBSP::s_anIdxLUT_16bitdbcross_GradY[16];
 constexpr LBSP::IdxLUTOffsetArray LBSP::s_oIdxLUT_16bitdbcross_x;
 constexpr LBSP::IdxLUTOffsetArray LBSP::s_oIdxLUT_16bitdbcross_y;
+constexpr int LBSP::BORDER_SKIP;
 
 LBSP::LBSP(size_t nThreshold) :
         m_bOnlyUsingAbsThreshold(true),
         m_fRelThreshold(0), // unused
         m_nThreshold(nThreshold),
-        m_oRefImage() {}
+        m_oRefImage(),
+        m_nThreadCount(DEFAULT_NB_THREADS) {}
 
 LBSP::LBSP(float fRelThreshold, size_t nThresholdOffset) :
         m_bOnlyUsingAbsThreshold(false),
         m_fRelThreshold(fRelThreshold),
         m_nThreshold(nThresholdOffset),
-        m_oRefImage() {
+        m_oRefImage(),
+        m_nThreadCount(DEFAULT_NB_THREADS) {
     lvAssert_(m_fRelThreshold>=0,"relative LBSP threshold must be non-negative");
 }
 
@@ -75,82 +79,224 @@ size_t LBSP::getAbsThreshold() const {
 
 namespace {
 
-void lbsp_computeImpl(const cv::Mat& oInputImg, const cv::Mat& oRefImg, const std::vector<cv::KeyPoint>& voKeyPoints, cv::Mat& oDesc, bool bSingleColumnDesc, size_t nThreshold) {
+lbsp_impl::RowKernel lbsp_getRowKernel() {
+    static_assert(lbsp_impl::s_nKernelOffsets==LBSP::DESC_SIZE_BITS,"bad kernel/descriptor size assumptions");
+    static_assert(sizeof(LBSP::desc_t)==sizeof(unsigned short),"bad kernel/descriptor size assumptions");
+#if LBSP_KERNELS_X86
+    switch(lv::getSupportedSIMDInstrSet()) {
+        case lv::SIMD_AVX512BW: return &lbsp_impl::computeRow_AVX512BW;
+        case lv::SIMD_AVX2: return &lbsp_impl::computeRow_AVX2;
+        case lv::SIMD_SSE4_1:
+        case lv::SIMD_SSE2: return &lbsp_impl::computeRow_SSE2;
+        default: break;
+    }
+#elif LBSP_KERNELS_NEON
+    return &lbsp_impl::computeRow_NEON;
+#endif //LBSP_KERNELS_NEON
+    return &lbsp_impl::computeRow_Scalar;
+}
+
+lbsp_impl::HDistKernel lbsp_getHDistKernel() {
+#if LBSP_KERNELS_X86
+    switch(lv::getSupportedSIMDInstrSet()) {
+        case lv::SIMD_AVX512BW: return &lbsp_impl::computeHDistRow_AVX512BW;
+        case lv::SIMD_AVX2: return &lbsp_impl::computeHDistRow_AVX2;
+        case lv::SIMD_SSE4_1:
+        case lv::SIMD_SSE2: return &lbsp_impl::computeHDistRow_SSE2;
+        default: break;
+    }
+#elif LBSP_KERNELS_NEON
+    return &lbsp_impl::computeHDistRow_NEON;
+#endif //LBSP_KERNELS_NEON
+    return &lbsp_impl::computeHDistRow_Scalar;
+}
+
+void lbsp_calcDescImgHDist(const cv::Mat& oDesc1, const cv::Mat& oDesc2, cv::Mat& oOutput, bool bMergeChannels, bool bScaled) {
     static_assert(LBSP::DESC_SIZE==2,"bad assumptions in impl below");
-    lvAssert_(!oInputImg.empty() && oInputImg.isContinuous() && (oInputImg.type()==CV_8UC1 || oInputImg.type()==CV_8UC3),"input image must be non-empty, continuous, and of type 8UC1/8UC3");
-    lvAssert_(oRefImg.empty() || (oRefImg.size==oInputImg.size && oRefImg.type()==oInputImg.type()),"ref image must be empty, or of the same size/type as the input image");
-    const size_t nChannels = (size_t)oInputImg.channels();
-    const cv::Mat& oRefMat = oRefImg.empty()?oInputImg:oRefImg;
-    const size_t nKeyPoints = voKeyPoints.size();
-    const uchar t = cv::saturate_cast<uchar>(nThreshold);
-    if(nChannels==1) {
-        if(bSingleColumnDesc)
-            oDesc.create((int)nKeyPoints,1,CV_16UC1);
-        else
-            oDesc.create(oInputImg.size(),CV_16UC1);
-        for(size_t k=0; k<nKeyPoints; ++k) {
-            const int x = (int)voKeyPoints[k].pt.x;
-            const int y = (int)voKeyPoints[k].pt.y;
-            LBSP::computeDescriptor<1>(oInputImg,oRefMat.at<uchar>(y,x),x,y,0,t,oDesc.at<ushort>((int)k));
+    static const lbsp_impl::HDistKernel s_pKernel = lbsp_getHDistKernel();
+    lvAssert_(!oDesc1.empty() && (oDesc1.type()==CV_16UC1 || oDesc1.type()==CV_16UC3),"desc1 mat must be non-empty, and of type 16UC1/16UC3");
+    lvAssert_(!oDesc2.empty() && (oDesc2.type()==CV_16UC1 || oDesc2.type()==CV_16UC3),"desc2 mat must be non-empty, and of type 16UC1/16UC3");
+    lvAssert_(oDesc1.size()==oDesc2.size() && oDesc1.type()==oDesc2.type(),"size/type of descriptor mats must match");
+    lvAssert_(oOutput.data!=oDesc1.data && oOutput.data!=oDesc2.data,"output mat cannot share data with the descriptor mats");
+    const int nChannels = oDesc1.channels();
+    const bool bMerge = bMergeChannels && nChannels==3;
+    // create() is a no-op if the output already has the right size/type, so per-frame calls do not reallocate
+    oOutput.create(oDesc1.size(),bMerge?CV_8UC1:CV_8UC(nChannels));
+    const size_t nRowElems = size_t(oDesc1.cols)*nChannels;
+    const lbsp_impl::HDistMode eMode = bScaled?(bMerge?lbsp_impl::HDist_ScaledThird:lbsp_impl::HDist_Scaled):lbsp_impl::HDist_Raw;
+    for(int nRowIdx=0; nRowIdx<oDesc1.rows; ++nRowIdx) {
+        const ushort* const anDesc1 = oDesc1.ptr<ushort>(nRowIdx);
+        const ushort* const anDesc2 = oDesc2.ptr<ushort>(nRowIdx);
+        uchar* const anOutput = oOutput.ptr<uchar>(nRowIdx);
+        if(!bMerge)
+            s_pKernel(anDesc1,anDesc2,nRowElems,eMode,anOutput);
+        else {
+            // per-channel distances are computed in fixed-size chunks on the stack, then summed pixel-wise
+            constexpr size_t nChunkPxCount = 128;
+            std::array<uchar,nChunkPxCount*3> anChunk;
+            for(size_t nColIdx=0; nColIdx<size_t(oDesc1.cols); nColIdx+=nChunkPxCount) {
+                const size_t nCurrPxCount = std::min(nChunkPxCount,size_t(oDesc1.cols)-nColIdx);
+                s_pKernel(anDesc1+nColIdx*3,anDesc2+nColIdx*3,nCurrPxCount*3,eMode,anChunk.data());
+                for(size_t nPxIdx=0; nPxIdx<nCurrPxCount; ++nPxIdx)
+                    anOutput[nColIdx+nPxIdx] = (uchar)(anChunk[nPxIdx*3]+anChunk[nPxIdx*3+1]+anChunk[nPxIdx*3+2]);
+            }
         }
-        return;
     }
-    else { //nChannels==3
-        if(bSingleColumnDesc)
-            oDesc.create((int)nKeyPoints,1,CV_16UC3);
-        else
-            oDesc.create(oInputImg.size(),CV_16UC3);
-        alignas(16) const std::array<uchar,3> anThreshold = {t,t,t};
-        for(size_t k=0; k<nKeyPoints; ++k) {
-            const int x = (int)voKeyPoints[k].pt.x;
-            const int y = (int)voKeyPoints[k].pt.y;
-            const uchar* acRef = oRefMat.data+oInputImg.step.p[0]*y+oInputImg.step.p[1]*x;
-            LBSP::computeDescriptor(oInputImg,acRef,x,y,anThreshold,((ushort*)(oDesc.data+oDesc.step.p[0]*k)));
+}
+
+template<size_t nChannels, bool bUseThresholdLUT>
+void lbsp_computeImpl_rows(const cv::Mat& oInputImg, const cv::Mat& oRefMat, const std::vector<cv::KeyPoint>& voKeyPoints, size_t nKeyPointBegin, size_t nKeyPointEnd, cv::Mat& oDesc, bool bSingleColumnDesc, uchar nThreshold, const uchar* anThresholdLUT) {
+    // keypoints are grouped in runs of horizontally consecutive pixels (as produced by dense grids) and fed to the row-batched kernel
+    const size_t nRowStep = oInputImg.step.p[0];
+    std::vector<uchar> vnThresholds;
+    size_t nRunBeginIdx = nKeyPointBegin;
+    while(nRunBeginIdx<nKeyPointEnd) {
+        const int nRunBeginX = (int)voKeyPoints[nRunBeginIdx].pt.x;
+        const int nRunY = (int)voKeyPoints[nRunBeginIdx].pt.y;
+        size_t nRunEndIdx = nRunBeginIdx+1;
+        while(nRunEndIdx<nKeyPointEnd && (int)voKeyPoints[nRunEndIdx].pt.y==nRunY && (int)voKeyPoints[nRunEndIdx].pt.x==nRunBeginX+(int)(nRunEndIdx-nRunBeginIdx))
+            ++nRunEndIdx;
+        const size_t nRunLength = nRunEndIdx-nRunBeginIdx;
+        const size_t nImgOffset = nRowStep*nRunY+nChannels*nRunBeginX;
+        const uchar* const anRefs = oRefMat.data+nImgOffset;
+        LBSP::desc_t* const anDesc = (LBSP::desc_t*)(bSingleColumnDesc?(oDesc.data+oDesc.step.p[0]*nRunBeginIdx):(oDesc.data+oDesc.step.p[0]*nRunY+oDesc.step.p[1]*nRunBeginX));
+        if(bUseThresholdLUT) {
+            lvDbgAssert(anThresholdLUT);
+            vnThresholds.resize(nRunLength*nChannels);
+            for(size_t n=0; n<vnThresholds.size(); ++n)
+                vnThresholds[n] = anThresholdLUT[anRefs[n]];
+            LBSP::computeDescriptor_row<nChannels>(oInputImg.data+nImgOffset,anRefs,nRowStep,nRunLength,vnThresholds.data(),anDesc);
         }
+        else
+            LBSP::computeDescriptor_row<nChannels>(oInputImg.data+nImgOffset,anRefs,nRowStep,nRunLength,nThreshold,anDesc);
+        nRunBeginIdx = nRunEndIdx;
     }
 }
 
-void lbsp_computeImpl(const cv::Mat& oInputImg, const cv::Mat& oRefImg, const std::vector<cv::KeyPoint>& voKeyPoints, cv::Mat& oDesc, bool bSingleColumnDesc, float fThreshold, size_t nThresholdOffset) {
+void lbsp_createDesc(const cv::Mat& oInputImg, const cv::Mat& oRefImg, size_t nKeyPoints, cv::Mat& oDesc, bool bSingleColumnDesc) {
     static_assert(LBSP::DESC_SIZE==2,"bad assumptions in impl below");
     lvAssert_(!oInputImg.empty() && oInputImg.isContinuous() && (oInputImg.type()==CV_8UC1 || oInputImg.type()==CV_8UC3),"input image must be non-empty, continuous, and of type 8UC1/8UC3");
     lvAssert_(oRefImg.empty() || (oRefImg.size==oInputImg.size && oRefImg.type()==oInputImg.type()),"ref image must be empty, or of the same size/type as the input image");
-    lvAssert_(fThreshold>=0,"lbsp internal relative threshold must be non-negative");
-    const size_t nChannels = (size_t)oInputImg.channels();
+    if(bSingleColumnDesc)
+        oDesc.create((int)nKeyPoints,1,CV_16UC(oInputImg.channels()));
+    else
+        oDesc.create(oInputImg.size(),CV_16UC(oInputImg.channels()));
+}
+
+void lbsp_computeImpl(const cv::Mat& oInputImg, const cv::Mat& oRefImg, const std::vector<cv::KeyPoint>& voKeyPoints, size_t nKeyPointBegin, size_t nKeyPointEnd, cv::Mat& oDesc, bool bSingleColumnDesc, uchar nThreshold, const uchar* anThresholdLUT) {
+    // note: the output descriptor matrix must have been allocated beforehand via lbsp_createDesc
+    lvDbgAssert(nKeyPointBegin<=nKeyPointEnd && nKeyPointEnd<=voKeyPoints.size());
     const cv::Mat& oRefMat = oRefImg.empty()?oInputImg:oRefImg;
-    const size_t nKeyPoints = voKeyPoints.size();
-    if(nChannels==1) {
-        if(bSingleColumnDesc)
-            oDesc.create((int)nKeyPoints,1,CV_16UC1);
+    if(oInputImg.channels()==1) {
+        if(anThresholdLUT)
+            lbsp_computeImpl_rows<1,true>(oInputImg,oRefMat,voKeyPoints,nKeyPointBegin,nKeyPointEnd,oDesc,bSingleColumnDesc,nThreshold,anThresholdLUT);
         else
-            oDesc.create(oInputImg.size(),CV_16UC1);
-        for(size_t k=0; k<nKeyPoints; ++k) {
-            const int x = (int)voKeyPoints[k].pt.x;
-            const int y = (int)voKeyPoints[k].pt.y;
-            const uchar nThreshold = cv::saturate_cast<uchar>(oRefMat.at<uchar>(y,x)*fThreshold+nThresholdOffset);
-            ushort& nResult = bSingleColumnDesc?oDesc.at<ushort>((int)k):oDesc.at<ushort>(y,x);
-            LBSP::computeDescriptor<1>(oInputImg,oRefMat.at<uchar>(y,x),x,y,0,nThreshold,nResult);
-        }
+            lbsp_computeImpl_rows<1,false>(oInputImg,oRefMat,voKeyPoints,nKeyPointBegin,nKeyPointEnd,oDesc,bSingleColumnDesc,nThreshold,anThresholdLUT);
     }
     else { //nChannels==3
-        if(bSingleColumnDesc)
-            oDesc.create((int)nKeyPoints,1,CV_16UC3);
+        if(anThresholdLUT)
+            lbsp_computeImpl_rows<3,true>(oInputImg,oRefMat,voKeyPoints,nKeyPointBegin,nKeyPointEnd,oDesc,bSingleColumnDesc,nThreshold,anThresholdLUT);
         else
-            oDesc.create(oInputImg.size(),CV_16UC3);
-        for(size_t k=0; k<nKeyPoints; ++k) {
-            const int x = (int)voKeyPoints[k].pt.x;
-            const int y = (int)voKeyPoints[k].pt.y;
-            const uchar* acRef = oRefMat.data+oInputImg.step.p[0]*y+oInputImg.step.p[1]*x;
-            alignas(16) const std::array<uchar,3> anThreshold = {cv::saturate_cast<uchar>(acRef[0]*fThreshold+nThresholdOffset),
-                                                                 cv::saturate_cast<uchar>(acRef[1]*fThreshold+nThresholdOffset),
-                                                                 cv::saturate_cast<uchar>(acRef[2]*fThreshold+nThresholdOffset)};
-            ushort* anResult = (ushort*)(bSingleColumnDesc?(oDesc.data+oDesc.step.p[0]*k):(oDesc.data+oDesc.step.p[0]*y+oDesc.step.p[1]*x));
-            LBSP::computeDescriptor(oInputImg,acRef,x,y,anThreshold,anResult);
+            lbsp_computeImpl_rows<3,false>(oInputImg,oRefMat,voKeyPoints,nKeyPointBegin,nKeyPointEnd,oDesc,bSingleColumnDesc,nThreshold,anThresholdLUT);
+    }
+}
+
+template<size_t nChannels, bool bRelThreshold>
+void lbsp_computeDense(const cv::Mat& oImage, const cv::Mat& oRefImage, cv::Mat& oDescMap, const cv::Mat& oThresholds, int nBorderType, uchar nFixedThreshold, const uchar* anThresholdLUT) {
+    static_assert(LBSP::DESC_SIZE==2,"bad assumptions in impl below");
+    lvAssert_(!oImage.empty() && oImage.type()==CV_8UC(nChannels),"input image must be non-empty, and of type 8UC1/8UC3");
+    lvAssert_(oRefImage.empty() || (oRefImage.size==oImage.size && oRefImage.type()==oImage.type()),"ref image must be empty, or of the same size/type as the input image");
+    lvAssert_(oThresholds.empty() || (oThresholds.size==oImage.size && (oThresholds.type()==CV_8UC1 || oThresholds.type()==oImage.type())),"threshold map must be empty, or of the same size as the input image with one or as many 8-bit channels");
+    const int nBorderSize = (int)LBSP::PATCH_SIZE/2;
+    const bool bSkipBorder = (nBorderType==LBSP::BORDER_SKIP);
+    const cv::Mat& oRefMat = oRefImage.empty()?oImage:oRefImage;
+    oDescMap.create(oImage.size(),CV_16UC(nChannels));
+    if(bSkipBorder) {
+        oDescMap = cv::Scalar_<ushort>::all(0);
+        if(oImage.cols<=nBorderSize*2 || oImage.rows<=nBorderSize*2)
+            return;
+    }
+    cv::Mat oPaddedImage;
+    if(!bSkipBorder)
+        cv::copyMakeBorder(oImage,oPaddedImage,nBorderSize,nBorderSize,nBorderSize,nBorderSize,nBorderType);
+    const cv::Mat& oSourceMat = bSkipBorder?oImage:oPaddedImage;
+    const int nSourceOffset = bSkipBorder?0:nBorderSize;
+    const int nRowBegin = bSkipBorder?nBorderSize:0, nRowEnd = bSkipBorder?oImage.rows-nBorderSize:oImage.rows;
+    const int nColBegin = bSkipBorder?nBorderSize:0, nColEnd = bSkipBorder?oImage.cols-nBorderSize:oImage.cols;
+    const size_t nRunLength = size_t(nColEnd-nColBegin);
+    const size_t nSourceRowStep = oSourceMat.step.p[0];
+    const bool bUseThresholdLUT = bRelThreshold && oThresholds.empty();
+    const bool bExpandThresholds = !oThresholds.empty() && oThresholds.channels()!=(int)nChannels;
+    lvDbgAssert(!bUseThresholdLUT || anThresholdLUT);
+    std::vector<uchar> vnThresholds((bUseThresholdLUT||bExpandThresholds)?nRunLength*nChannels:0);
+    for(int nRowIdx=nRowBegin; nRowIdx<nRowEnd; ++nRowIdx) {
+        const uchar* const anData = oSourceMat.ptr<uchar>(nRowIdx+nSourceOffset)+(nColBegin+nSourceOffset)*nChannels;
+        const uchar* const anRefs = oRefMat.ptr<uchar>(nRowIdx)+nColBegin*nChannels;
+        LBSP::desc_t* const anDesc = oDescMap.ptr<LBSP::desc_t>(nRowIdx)+nColBegin*nChannels;
+        const uchar* anThresholds = nullptr;
+        if(bUseThresholdLUT) {
+            for(size_t n=0; n<vnThresholds.size(); ++n)
+                vnThresholds[n] = anThresholdLUT[anRefs[n]];
+            anThresholds = vnThresholds.data();
+        }
+        else if(bExpandThresholds) {
+            const uchar* const anMapThresholds = oThresholds.ptr<uchar>(nRowIdx)+nColBegin;
+            for(size_t n=0; n<vnThresholds.size(); ++n)
+                vnThresholds[n] = anMapThresholds[n/nChannels];
+            anThresholds = vnThresholds.data();
         }
+        else if(!oThresholds.empty())
+            anThresholds = oThresholds.ptr<uchar>(nRowIdx)+nColBegin*nChannels;
+        if(anThresholds)
+            LBSP::computeDescriptor_row<nChannels>(anData,anRefs,nSourceRowStep,nRunLength,anThresholds,anDesc);
+        else
+            LBSP::computeDescriptor_row<nChannels>(anData,anRefs,nSourceRowStep,nRunLength,nFixedThreshold,anDesc);
     }
 }
 
+template<typename Tfunc>
+void lbsp_parallelFor(size_t nTasks, size_t nThreads, Tfunc&& lTask) {
+    // tasks are pulled in order by all workers (including the calling thread); the first exception thrown is rethrown here
+    nThreads = std::min(nThreads,nTasks);
+    if(nThreads<=1) {
+        for(size_t nTaskIdx=0; nTaskIdx<nTasks; ++nTaskIdx)
+            lTask(nTaskIdx);
+        return;
+    }
+    std::atomic_size_t nNextTaskIdx(0);
+    std::exception_ptr pException;
+    std::mutex oExceptionMutex;
+    auto lWorker = [&]() {
+        size_t nTaskIdx;
+        while((nTaskIdx=nNextTaskIdx++)<nTasks) {
+            try {
+                lTask(nTaskIdx);
+            }
+            catch(...) {
+                std::mutex_lock_guard oLock(oExceptionMutex);
+                if(!pException)
+                    pException = std::current_exception();
+                nNextTaskIdx = nTasks;
+            }
+        }
+    };
+    std::vector<std::thread> vhWorkers;
+    for(size_t nThreadIdx=1; nThreadIdx<nThreads; ++nThreadIdx)
+        vhWorkers.emplace_back(lWorker);
+    lWorker();
+    for(auto& hWorker : vhWorkers)
+        hWorker.join();
+    if(pException)
+        std::rethrow_exception(pException);
+}
+
 } // namespace
 
+void LBSP::computeDescriptor_row_dispatch(const uchar* anData, const uchar* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const uchar* anThresholds, uchar nThreshold, desc_t* anDesc) {
+    static const lbsp_impl::RowKernel s_pfnRowKernel = lbsp_getRowKernel();
+    s_pfnRowKernel(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc);
+}
+
 void LBSP::compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoints, cv::Mat& oDescriptors) const {
     lvAssert_(!oImage.empty(),"input image must be non-empty");
     cv::KeyPointsFilter::runByImageBorder(voKeypoints,oImage.size(),PATCH_SIZE/2);
@@ -159,17 +305,74 @@ void LBSP::compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoint
         oDescriptors.release();
         return;
     }
-    if(m_bOnlyUsingAbsThreshold)
-        lbsp_computeImpl(oImage,m_oRefImage,voKeypoints,oDescriptors,false,m_nThreshold);
-    else
-        lbsp_computeImpl(oImage,m_oRefImage,voKeypoints,oDescriptors,false,m_fRelThreshold,m_nThreshold);
+    std::array<uchar,UCHAR_MAX+1> anThresholdLUT;
+    fillThresholdLUT(anThresholdLUT);
+    lbsp_createDesc(oImage,m_oRefImage,voKeypoints.size(),oDescriptors,false);
+    lbsp_computeImpl(oImage,m_oRefImage,voKeypoints,0,voKeypoints.size(),oDescriptors,false,cv::saturate_cast<uchar>(m_nThreshold),m_bOnlyUsingAbsThreshold?nullptr:anThresholdLUT.data());
 }
 
 void LBSP::compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<std::vector<cv::KeyPoint> >& vvoPointCollection, std::vector<cv::Mat>& voDescCollection) const {
     lvAssert_(voImageCollection.size()==vvoPointCollection.size(),"number of images must match number of keypoint lists");
-    voDescCollection.resize(voImageCollection.size());
-    for(size_t i=0; i<voImageCollection.size(); i++)
-        compute2(voImageCollection[i], vvoPointCollection[i], voDescCollection[i]);
+    // large keypoint lists are split in bands so that a few big images can still keep all workers busy
+    static constexpr size_t s_nMaxKeyPointsPerTask = 1<<16;
+    const size_t nImages = voImageCollection.size();
+    const size_t nThreads = getThreadCount();
+    voDescCollection.resize(nImages);
+    std::array<uchar,UCHAR_MAX+1> anThresholdLUT;
+    fillThresholdLUT(anThresholdLUT);
+    const uchar* const anActiveThresholdLUT = m_bOnlyUsingAbsThreshold?nullptr:anThresholdLUT.data();
+    lbsp_parallelFor(nImages,nThreads,[&](size_t nImageIdx) {
+        const cv::Mat& oImage = voImageCollection[nImageIdx];
+        std::vector<cv::KeyPoint>& voKeypoints = vvoPointCollection[nImageIdx];
+        lvAssert_(!oImage.empty(),"input image must be non-empty");
+        cv::KeyPointsFilter::runByImageBorder(voKeypoints,oImage.size(),PATCH_SIZE/2);
+        cv::KeyPointsFilter::runByKeypointSize(voKeypoints,std::numeric_limits<float>::epsilon());
+        if(voKeypoints.empty())
+            voDescCollection[nImageIdx].release();
+        else
+            lbsp_createDesc(oImage,m_oRefImage,voKeypoints.size(),voDescCollection[nImageIdx],false);
+    });
+    std::vector<std::array<size_t,3>> vanTasks; // (image idx, first keypoint idx, last keypoint idx + 1)
+    for(size_t nImageIdx=0; nImageIdx<nImages; ++nImageIdx)
+        for(size_t nKeyPointIdx=0; nKeyPointIdx<vvoPointCollection[nImageIdx].size(); nKeyPointIdx+=s_nMaxKeyPointsPerTask)
+            vanTasks.push_back(std::array<size_t,3>{{nImageIdx,nKeyPointIdx,std::min(nKeyPointIdx+s_nMaxKeyPointsPerTask,vvoPointCollection[nImageIdx].size())}});
+    lbsp_parallelFor(vanTasks.size(),nThreads,[&](size_t nTaskIdx) {
+        const size_t nImageIdx = vanTasks[nTaskIdx][0];
+        lbsp_computeImpl(voImageCollection[nImageIdx],m_oRefImage,vvoPointCollection[nImageIdx],vanTasks[nTaskIdx][1],vanTasks[nTaskIdx][2],voDescCollection[nImageIdx],false,cv::saturate_cast<uchar>(m_nThreshold),anActiveThresholdLUT);
+    });
+}
+
+void LBSP::setThreadCount(size_t nThreads) {
+    m_nThreadCount = nThreads;
+}
+
+size_t LBSP::getThreadCount() const {
+    return m_nThreadCount?m_nThreadCount:std::max((size_t)std::thread::hardware_concurrency(),size_t(1));
+}
+
+void LBSP::fillThresholdLUT(std::array<uchar,UCHAR_MAX+1>& anThresholdLUT) const {
+    // relative thresholds only depend on the 8-bit reference value, so they can all be precomputed once
+    for(size_t nRef=0; nRef<=UCHAR_MAX; ++nRef)
+        anThresholdLUT[nRef] = m_bOnlyUsingAbsThreshold?cv::saturate_cast<uchar>(m_nThreshold):cv::saturate_cast<uchar>(nRef*m_fRelThreshold+m_nThreshold);
+}
+
+void LBSP::computeDense(const cv::Mat& oImage, cv::Mat& oDescMap, const cv::Mat& oThresholds, int nBorderType) const {
+    lvAssert_(!oImage.empty() && (oImage.type()==CV_8UC1 || oImage.type()==CV_8UC3),"input image must be non-empty, and of type 8UC1/8UC3");
+    std::array<uchar,UCHAR_MAX+1> anThresholdLUT;
+    fillThresholdLUT(anThresholdLUT);
+    const uchar nFixedThreshold = cv::saturate_cast<uchar>(m_nThreshold);
+    if(oImage.channels()==1) {
+        if(m_bOnlyUsingAbsThreshold)
+            lbsp_computeDense<1,false>(oImage,m_oRefImage,oDescMap,oThresholds,nBorderType,nFixedThreshold,nullptr);
+        else
+            lbsp_computeDense<1,true>(oImage,m_oRefImage,oDescMap,oThresholds,nBorderType,nFixedThreshold,anThresholdLUT.data());
+    }
+    else { //nChannels==3
+        if(m_bOnlyUsingAbsThreshold)
+            lbsp_computeDense<3,false>(oImage,m_oRefImage,oDescMap,oThresholds,nBorderType,nFixedThreshold,nullptr);
+        else
+            lbsp_computeDense<3,true>(oImage,m_oRefImage,oDescMap,oThresholds,nBorderType,nFixedThreshold,anThresholdLUT.data());
+    }
 }
 
 void LBSP::computeImpl(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoints, cv::Mat& oDescriptors) const {
@@ -180,10 +383,10 @@ void LBSP::computeImpl(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypo
         oDescriptors.release();
         return;
     }
-    if(m_bOnlyUsingAbsThreshold)
-        lbsp_computeImpl(oImage,m_oRefImage,voKeypoints,oDescriptors,true,m_nThreshold);
-    else
-        lbsp_computeImpl(oImage,m_oRefImage,voKeypoints,oDescriptors,true,m_fRelThreshold,m_nThreshold);
+    std::array<uchar,UCHAR_MAX+1> anThresholdLUT;
+    fillThresholdLUT(anThresholdLUT);
+    lbsp_createDesc(oImage,m_oRefImage,voKeypoints.size(),oDescriptors,true);
+    lbsp_computeImpl(oImage,m_oRefImage,voKeypoints,0,voKeypoints.size(),oDescriptors,true,cv::saturate_cast<uchar>(m_nThreshold),m_bOnlyUsingAbsThreshold?nullptr:anThresholdLUT.data());
 }
 
 void LBSP::reshapeDesc(cv::Size oSize, const std::vector<cv::KeyPoint>& voKeypoints, const cv::Mat& oDescriptors, cv::Mat& oOutput) {
@@ -214,48 +417,12 @@ void LBSP::reshapeDesc(cv::Size oSize, const std::vector<cv::KeyPoint>& voKeypoi
 }
 
 void LBSP::calcDescImgDiff(const cv::Mat& oDesc1, const cv::Mat& oDesc2, cv::Mat& oOutput, bool bForceMergeChannels) {
-    static_assert(LBSP::DESC_SIZE_BITS<=UCHAR_MAX,"bad assumptions in impl below");
-    static_assert(LBSP::DESC_SIZE==2,"bad assumptions in impl below");
-    lvAssert_(oDesc1.isContinuous() && (oDesc1.type()==CV_16UC1 || oDesc1.type()==CV_16UC3),"desc1 mat must be continuous, and of type 16UC1/16UC3");
-    lvAssert_(oDesc2.isContinuous() && (oDesc2.type()==CV_16UC1 || oDesc2.type()==CV_16UC3),"desc2 mat must be continuous, and of type 16UC1/16UC3");
-    lvAssert_(oDesc1.size()==oDesc2.size() && oDesc1.type()==oDesc2.type(),"size/type of descriptor mats must match");
-    lvDbgAssert(oDesc1.step.p[0]==oDesc2.step.p[0] && oDesc1.step.p[1]==oDesc2.step.p[1]);
-    const float fScaleFactor = (float)UCHAR_MAX/(LBSP::DESC_SIZE_BITS);
-    const size_t nChannels = CV_MAT_CN(oDesc1.type());
-    const size_t _step_row = oDesc1.step.p[0];
-    if(nChannels==1) {
-        oOutput.create(oDesc1.size(),CV_8UC1);
-        oOutput = cv::Scalar(0);
-        for(int i=0; i<oDesc1.rows; ++i) {
-            const size_t idx = _step_row*i;
-            const ushort* const desc1_ptr = (ushort*)(oDesc1.data+idx);
-            const ushort* const desc2_ptr = (ushort*)(oDesc2.data+idx);
-            for(int j=0; j<oDesc1.cols; ++j)
-                oOutput.at<uchar>(i,j) = (uchar)(fScaleFactor*lv::hdist(desc1_ptr[j],desc2_ptr[j]));
-        }
-    }
-    else { //nChannels==3
-        if(bForceMergeChannels)
-            oOutput.create(oDesc1.size(),CV_8UC1);
-        else
-            oOutput.create(oDesc1.size(),CV_8UC3);
-        oOutput = cv::Scalar::all(0);
-        for(int i=0; i<oDesc1.rows; ++i) {
-            const size_t idx =  _step_row*i;
-            const ushort* const desc1_ptr = (ushort*)(oDesc1.data+idx);
-            const ushort* const desc2_ptr = (ushort*)(oDesc2.data+idx);
-            uchar* output_ptr = oOutput.data + oOutput.step.p[0]*i;
-            for(int j=0; j<oDesc1.cols; ++j) {
-                for(size_t n=0;n<3; ++n) {
-                    const size_t idx2 = 3*j+n;
-                    if(bForceMergeChannels)
-                        output_ptr[j] += (uchar)((fScaleFactor*lv::hdist(desc1_ptr[idx2],desc2_ptr[idx2]))/3);
-                    else
-                        output_ptr[idx2] = (uchar)(fScaleFactor*lv::hdist(desc1_ptr[idx2],desc2_ptr[idx2]));
-                }
-            }
-        }
-    }
+    static_assert(LBSP::DESC_SIZE_BITS==16,"bad assumptions in impl below");
+    lbsp_calcDescImgHDist(oDesc1,oDesc2,oOutput,bForceMergeChannels,true);
+}
+
+void LBSP::calcDescImgHammingDist(const cv::Mat& oDesc1, const cv::Mat& oDesc2, cv::Mat& oOutput, bool bMergeChannels) {
+    lbsp_calcDescImgHDist(oDesc1,oDesc2,oOutput,bMergeChannels,false);
 }
 
 void LBSP::validateKeyPoints(std::vector<cv::KeyPoint>& voKeypoints, cv::Size oImgSize) {
@@ -271,6 +438,42 @@ void LBSP::validateROI(cv::Mat& oROI) {
     oROI = oROI_new;
 }
 
+template<LBSPThresholdMode eThresholdMode, size_t nChannels>
+void LBSP_<eThresholdMode,nChannels>::compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoints, cv::Mat& oDescriptors) const {
+    lvAssert_(!oImage.empty() && oImage.type()==CV_8UC(nChannels),"input image must be non-empty, and of the specialized channel count");
+    cv::KeyPointsFilter::runByImageBorder(voKeypoints,oImage.size(),PATCH_SIZE/2);
+    cv::KeyPointsFilter::runByKeypointSize(voKeypoints,std::numeric_limits<float>::epsilon());
+    if(voKeypoints.empty()) {
+        oDescriptors.release();
+        return;
+    }
+    lbsp_createDesc(oImage,m_oRefImage,voKeypoints.size(),oDescriptors,false);
+    lbsp_computeImpl_rows<nChannels,eThresholdMode==LBSPThreshold_Relative>(oImage,m_oRefImage.empty()?oImage:m_oRefImage,voKeypoints,0,voKeypoints.size(),oDescriptors,false,m_anThresholdLUT[0],m_anThresholdLUT.data());
+}
+
+template<LBSPThresholdMode eThresholdMode, size_t nChannels>
+void LBSP_<eThresholdMode,nChannels>::computeDense(const cv::Mat& oImage, cv::Mat& oDescMap, const cv::Mat& oThresholds, int nBorderType) const {
+    lbsp_computeDense<nChannels,eThresholdMode==LBSPThreshold_Relative>(oImage,m_oRefImage,oDescMap,oThresholds,nBorderType,m_anThresholdLUT[0],m_anThresholdLUT.data());
+}
+
+template<LBSPThresholdMode eThresholdMode, size_t nChannels>
+void LBSP_<eThresholdMode,nChannels>::computeImpl(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoints, cv::Mat& oDescriptors) const {
+    lvAssert_(!oImage.empty() && oImage.type()==CV_8UC(nChannels),"input image must be non-empty, and of the specialized channel count");
+    cv::KeyPointsFilter::runByImageBorder(voKeypoints,oImage.size(),PATCH_SIZE/2);
+    cv::KeyPointsFilter::runByKeypointSize(voKeypoints,std::numeric_limits<float>::epsilon());
+    if(voKeypoints.empty()) {
+        oDescriptors.release();
+        return;
+    }
+    lbsp_createDesc(oImage,m_oRefImage,voKeypoints.size(),oDescriptors,true);
+    lbsp_computeImpl_rows<nChannels,eThresholdMode==LBSPThreshold_Relative>(oImage,m_oRefImage.empty()?oImage:m_oRefImage,voKeypoints,0,voKeypoints.size(),oDescriptors,true,m_anThresholdLUT[0],m_anThresholdLUT.data());
+}
+
+template class LBSP_<LBSPThreshold_Absolute,1>;
+template class LBSP_<LBSPThreshold_Absolute,3>;
+template class LBSP_<LBSPThreshold_Relative,1>;
+template class LBSP_<LBSPThreshold_Relative,3>;
+
 #if HAVE_GLSL
 
 std::string LBSP::getShaderFunctionSource(size_t nChannels, bool bUseSharedDataPreload, const glm::uvec2& vWorkGroupSize) {
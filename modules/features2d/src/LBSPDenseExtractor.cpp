@@ -0,0 +1,125 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/features2d/LBSPDenseExtractor.hpp"
+
+#if HAVE_GLSL
+
+LBSPDenseExtractor_GLSL::LBSPDenseExtractor_(size_t nChannels, size_t nThreshold, bool bUseDisplay, bool bUseTimers) :
+        lv::IParallelAlgo_GLSL(1,1,0,0,0,0,nChannels==1?CV_16UC1:CV_16UC3,-1,true,bUseDisplay,bUseTimers,true),
+        m_nChannels(nChannels),
+        m_bOnlyUsingAbsThreshold(true),
+        m_fRelThreshold(0), // unused
+        m_nThreshold(nThreshold),
+        m_bInitialized(false),
+        m_nImgType(-1) {
+    lvAssert_(m_nChannels==1 || m_nChannels==3,"dense lbsp extractor only supports 1ch/3ch images");
+}
+
+LBSPDenseExtractor_GLSL::LBSPDenseExtractor_(size_t nChannels, float fRelThreshold, size_t nThresholdOffset, bool bUseDisplay, bool bUseTimers) :
+        lv::IParallelAlgo_GLSL(1,1,0,0,0,0,nChannels==1?CV_16UC1:CV_16UC3,-1,true,bUseDisplay,bUseTimers,true),
+        m_nChannels(nChannels),
+        m_bOnlyUsingAbsThreshold(false),
+        m_fRelThreshold(fRelThreshold),
+        m_nThreshold(nThresholdOffset),
+        m_bInitialized(false),
+        m_nImgType(-1) {
+    lvAssert_(m_nChannels==1 || m_nChannels==3,"dense lbsp extractor only supports 1ch/3ch images");
+    lvAssert_(m_fRelThreshold>=0,"relative LBSP threshold must be non-negative");
+}
+
+void LBSPDenseExtractor_GLSL::initialize(const cv::Mat& oInitImg, const cv::Mat& oROI) {
+    lvDbgExceptionWatch;
+    lvAssert_(!oInitImg.empty() && oInitImg.isContinuous(),"initialization image must be non-empty and continuous");
+    lvAssert_(oInitImg.type()==CV_MAKETYPE(CV_8U,(int)m_nChannels),"initialization image type must be 8UC1/8UC3 (matching the extractor channel count)");
+    lvAssert_(oROI.empty() || oROI.size()==oInitImg.size(),"ROI must be empty or of the same size as the initialization image");
+    m_oImgSize = oInitImg.size();
+    m_nImgType = oInitImg.type();
+    m_bInitialized = true;
+    GLImageProcAlgo::initialize_gl(oInitImg,oROI.empty()?cv::Mat(m_oImgSize,CV_8UC1,cv::Scalar_<uchar>(255)):oROI);
+}
+
+void LBSPDenseExtractor_GLSL::apply(const cv::Mat& oNextImg, bool bRebindAll) {
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    lvAssert_(oNextImg.type()==m_nImgType && oNextImg.size()==m_oImgSize,"input image type/size mismatch with initialization type/size");
+    lvAssert_(oNextImg.isContinuous(),"input image data must be continuous");
+    GLImageProcAlgo::apply_gl(oNextImg,bRebindAll);
+}
+
+size_t LBSPDenseExtractor_GLSL::apply(const cv::Mat& oNextImg, cv::Mat& oLastDescMap, bool bRebindAll) {
+    apply(oNextImg,bRebindAll);
+    return getLatestDescMap(oLastDescMap);
+}
+
+size_t LBSPDenseExtractor_GLSL::getLatestDescMap(cv::Mat& oLastDescMap) {
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    lvAssert_(GLImageProcAlgo::m_bFetchingOutput || GLImageProcAlgo::setOutputFetching(true),"algo not initialized with mat output support");
+    oLastDescMap.create(m_oImgSize,m_nOutputType);
+    if(GLImageProcAlgo::m_nInternalFrameIdx>0)
+        return GLImageProcAlgo::fetchLastOutput(oLastDescMap);
+    oLastDescMap = cv::Scalar::all(0);
+    return size_t(-1);
+}
+
+std::string LBSPDenseExtractor_GLSL::getComputeShaderSource(size_t nStage) const {
+    lvDbgExceptionWatch;
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    lvAssert_(nStage<m_nComputeStages,"required compute stage does not exist");
+    const bool bUsingSharedMem = getIsUsingSharedMem();
+    const bool b4ch = (m_nChannels!=1); // 3-channel inputs are bound as rgba images, and descriptors as rgba16ui images
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "#version 430\n"
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_ROIBinding << ", r8ui) readonly uniform uimage2D mROI;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_InputBinding << ", " << (b4ch?"rgba8ui":"r8ui") << ") readonly uniform uimage2D mInput;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_OutputBinding << ", " << (b4ch?"rgba16ui":"r16ui") << ") writeonly uniform uimage2D mOutput;\n"
+             "const uint anLBSPThresLUT[256] = uint[256](\n    ";
+    for(size_t t=0; t<=UCHAR_MAX; ++t) {
+        const uchar nThreshold = m_bOnlyUsingAbsThreshold?cv::saturate_cast<uchar>(m_nThreshold):cv::saturate_cast<uchar>(t*m_fRelThreshold+m_nThreshold);
+        ssSrc << (int)nThreshold << ((t==UCHAR_MAX)?"\n":((t%32)==31)?",\n    ":",");
+    }
+    ssSrc << ");\n" <<
+             LBSP::getShaderFunctionSource(b4ch?4:1,bUsingSharedMem,m_vDefaultWorkGroupSize) <<
+             (bUsingSharedMem?"":"#define lbsp(t,ref,vCoords) lbsp(t,ref,mInput,vCoords)\n");
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "void main() {\n";
+    if(bUsingSharedMem) ssSrc <<
+             "    preload_data(mInput);\n"
+             "    barrier();\n";
+    ssSrc << "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    uvec3 vDesc = uvec3(0);\n"
+             "    if(bool(imageLoad(mROI,vImgCoords).r)) {\n"
+             "        uvec3 vInputColor = imageLoad(mInput,vImgCoords).rgb;\n"
+             "        uvec3 vInputDescThres = uvec3(anLBSPThresLUT[vInputColor.r],anLBSPThresLUT[vInputColor.g],anLBSPThresLUT[vInputColor.b]);\n"
+             "        vDesc = lbsp(vInputDescThres,vInputColor,vImgCoords);\n"
+             "    }\n"
+             "    imageStore(mOutput,vImgCoords,uvec4(vDesc,0));\n"
+             "}\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    return ssSrc.str();
+}
+
+void LBSPDenseExtractor_GLSL::dispatch(size_t nStage, GLShader&) {
+    lvDbgExceptionWatch;
+    lvAssert_(nStage<m_nComputeStages,"required compute stage does not exist");
+    glDispatchCompute((GLuint)ceil((float)m_oFrameSize.width/m_vDefaultWorkGroupSize.x),(GLuint)ceil((float)m_oFrameSize.height/m_vDefaultWorkGroupSize.y),1);
+}
+
+template struct LBSPDenseExtractor_<lv::GLSL>;
+
+#endif //HAVE_GLSL
@@ -0,0 +1,287 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/features2d/LBSPMatcher.hpp"
+
+// local define used to specify the max substring radius probed in multi-index lookups (larger radii fall back to brute-force)
+#define MULTIINDEX_MAX_SUBSTR_RADIUS 2
+// local define used to specify the number of query descriptors processed per parallel task
+#define MATCH_QUERY_GRAIN 64
+
+namespace {
+
+#if HAVE_NEON
+    inline uint16x8_t hdist16_NEON(const uint16x8_t& vnDesc1, const uint16x8_t& vnDesc2) {
+        return vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u16(veorq_u16(vnDesc1,vnDesc2))));
+    }
+#elif HAVE_SSE2
+    inline __m128i hdist16_SSE2(const __m128i& vnDesc1, const __m128i& vnDesc2) {
+        __m128i vnBits = _mm_xor_si128(vnDesc1,vnDesc2);
+        vnBits = _mm_sub_epi16(vnBits,_mm_and_si128(_mm_srli_epi16(vnBits,1),_mm_set1_epi16(0x5555)));
+        vnBits = _mm_add_epi16(_mm_and_si128(vnBits,_mm_set1_epi16(0x3333)),_mm_and_si128(_mm_srli_epi16(vnBits,2),_mm_set1_epi16(0x3333)));
+        vnBits = _mm_and_si128(_mm_add_epi16(vnBits,_mm_srli_epi16(vnBits,4)),_mm_set1_epi16(0x0F0F));
+        return _mm_srli_epi16(_mm_add_epi16(vnBits,_mm_slli_epi16(vnBits,8)),8);
+    }
+#endif //HAVE_SSE2
+
+    /// computes the hamming distances between one query and nPlaneStride channel-planar train descriptors (nPlaneStride must be a multiple of 16)
+    template<size_t nChannels>
+    void computeDistRow(const ushort* anQuery, const ushort* anTrainPlanes, size_t nPlaneStride, uchar* anDists) {
+        static_assert(nChannels>0 && nChannels<=3,"LBSP descriptors have between one and three channels");
+        lvDbgAssert((nPlaneStride%16)==0);
+#if HAVE_NEON
+        uint16x8_t avnQuery[nChannels];
+        lv::unroll<nChannels>([&](size_t c){avnQuery[c] = vdupq_n_u16(anQuery[c]);});
+        for(size_t nTrainIdx=0; nTrainIdx<nPlaneStride; nTrainIdx+=16) {
+            uint16x8_t vnDistLow = vdupq_n_u16(0), vnDistHigh = vdupq_n_u16(0);
+            lv::unroll<nChannels>([&](size_t c) {
+                const ushort* anPlane = anTrainPlanes+c*nPlaneStride+nTrainIdx;
+                vnDistLow = vaddq_u16(vnDistLow,hdist16_NEON(avnQuery[c],vld1q_u16(anPlane)));
+                vnDistHigh = vaddq_u16(vnDistHigh,hdist16_NEON(avnQuery[c],vld1q_u16(anPlane+8)));
+            });
+            vst1q_u8(anDists+nTrainIdx,vcombine_u8(vmovn_u16(vnDistLow),vmovn_u16(vnDistHigh)));
+        }
+#elif HAVE_SSE2
+        __m128i avnQuery[nChannels];
+        lv::unroll<nChannels>([&](size_t c){avnQuery[c] = _mm_set1_epi16((short)anQuery[c]);});
+        for(size_t nTrainIdx=0; nTrainIdx<nPlaneStride; nTrainIdx+=16) {
+            __m128i vnDistLow = _mm_setzero_si128(), vnDistHigh = _mm_setzero_si128();
+            lv::unroll<nChannels>([&](size_t c) {
+                const ushort* anPlane = anTrainPlanes+c*nPlaneStride+nTrainIdx;
+                vnDistLow = _mm_add_epi16(vnDistLow,hdist16_SSE2(avnQuery[c],_mm_load_si128((const __m128i*)anPlane)));
+                vnDistHigh = _mm_add_epi16(vnDistHigh,hdist16_SSE2(avnQuery[c],_mm_load_si128((const __m128i*)(anPlane+8))));
+            });
+            _mm_storeu_si128((__m128i*)(anDists+nTrainIdx),_mm_packus_epi16(vnDistLow,vnDistHigh));
+        }
+#else //!HAVE_SSE2
+        for(size_t nTrainIdx=0; nTrainIdx<nPlaneStride; ++nTrainIdx) {
+            size_t nDist = 0;
+            lv::unroll<nChannels>([&](size_t c){nDist += lv::hdist(anQuery[c],anTrainPlanes[c*nPlaneStride+nTrainIdx]);});
+            anDists[nTrainIdx] = (uchar)nDist;
+        }
+#endif //!HAVE_SSE2
+    }
+
+    /// returns the descriptor pointer of the given (raster-order) element of a descriptor mat
+    inline const ushort* getDescPtr(const cv::Mat& oDescs, size_t nDescIdx) {
+        const int nRow = int(nDescIdx/oDescs.cols), nCol = int(nDescIdx%oDescs.cols);
+        return oDescs.ptr<ushort>(nRow)+nCol*oDescs.channels();
+    }
+
+    /// packs the channels of a descriptor in a 64-bit key (channel c in bits [16c,16c+16))
+    inline uint64_t packDescKey(const ushort* anDesc, size_t nChannels) {
+        uint64_t nKey = 0;
+        for(size_t c=0; c<nChannels; ++c)
+            nKey |= uint64_t(anDesc[c])<<(c*16);
+        return nKey;
+    }
+
+    /// calls lFunc(nKey) for all nBits-wide keys at exactly nRadius bits from nBaseKey
+    template<typename TFunc>
+    void forEachKeyAtRadius(uint nBaseKey, size_t nBits, size_t nRadius, size_t nFirstBit, const TFunc& lFunc) {
+        if(nRadius==0) {
+            lFunc(nBaseKey);
+            return;
+        }
+        for(size_t nBit=nFirstBit; nBit+nRadius<=nBits; ++nBit)
+            forEachKeyAtRadius(nBaseKey^(1u<<nBit),nBits,nRadius-1,nBit+1,lFunc);
+    }
+
+} // anonymous namespace
+
+LBSPMatcher::LBSPMatcher(size_t nMultiIndexMinTrainSize) :
+        m_nMultiIndexMinTrainSize(nMultiIndexMinTrainSize),
+        m_nChannels(0),
+        m_nTrainSize(0),
+        m_nPlaneStride(0),
+        m_nSubstrBits(0),
+        m_nSubstrCount(0) {}
+
+void LBSPMatcher::train(const cv::Mat& oTrainDescs) {
+    lvAssert_(!oTrainDescs.empty() && oTrainDescs.depth()==CV_16U && oTrainDescs.channels()<=3,"train descriptors must be given as a non-empty CV_16UC(n) mat (n<=3)");
+    lvAssert_(oTrainDescs.total()<UINT_MAX,"train set too large");
+    clear();
+    m_nChannels = (size_t)oTrainDescs.channels();
+    m_nTrainSize = oTrainDescs.total();
+    m_nPlaneStride = ((m_nTrainSize+15)/16)*16;
+    // padded descs are left zeroed; their distances are computed along with the others, but never looked at
+    m_vnTrainPlanes.assign(m_nChannels*m_nPlaneStride,0);
+    m_vnTrainKeys.resize(m_nTrainSize);
+    ushort* anTrainPlanes = m_vnTrainPlanes.data();
+    for(size_t nTrainIdx=0; nTrainIdx<m_nTrainSize; ++nTrainIdx) {
+        const ushort* anDesc = getDescPtr(oTrainDescs,nTrainIdx);
+        for(size_t c=0; c<m_nChannels; ++c)
+            anTrainPlanes[c*m_nPlaneStride+nTrainIdx] = anDesc[c];
+        m_vnTrainKeys[nTrainIdx] = packDescKey(anDesc,m_nChannels);
+    }
+    if(m_nMultiIndexMinTrainSize>0 && m_nTrainSize>=m_nMultiIndexMinTrainSize) {
+        // single-channel descs are split in two 8-bit substrings (otherwise, only one table could be used, and lookups would not prune anything)
+        m_nSubstrBits = (m_nChannels==1)?8:16;
+        m_nSubstrCount = (m_nChannels*16)/m_nSubstrBits;
+        const size_t nBuckets = size_t(1)<<m_nSubstrBits;
+        const uint64_t nSubstrMask = nBuckets-1;
+        m_vvnBucketOffsets.resize(m_nSubstrCount);
+        m_vvnBucketIdxs.resize(m_nSubstrCount);
+        for(size_t nSubstrIdx=0; nSubstrIdx<m_nSubstrCount; ++nSubstrIdx) {
+            std::vector<uint>& vnOffsets = m_vvnBucketOffsets[nSubstrIdx];
+            std::vector<uint>& vnIdxs = m_vvnBucketIdxs[nSubstrIdx];
+            vnOffsets.assign(nBuckets+1,0);
+            for(size_t nTrainIdx=0; nTrainIdx<m_nTrainSize; ++nTrainIdx)
+                ++vnOffsets[((m_vnTrainKeys[nTrainIdx]>>(nSubstrIdx*m_nSubstrBits))&nSubstrMask)+1];
+            std::partial_sum(vnOffsets.begin(),vnOffsets.end(),vnOffsets.begin());
+            vnIdxs.resize(m_nTrainSize);
+            std::vector<uint> vnFillOffsets(vnOffsets.begin(),vnOffsets.end()-1);
+            for(size_t nTrainIdx=0; nTrainIdx<m_nTrainSize; ++nTrainIdx)
+                vnIdxs[vnFillOffsets[(m_vnTrainKeys[nTrainIdx]>>(nSubstrIdx*m_nSubstrBits))&nSubstrMask]++] = (uint)nTrainIdx;
+        }
+    }
+}
+
+void LBSPMatcher::clear() {
+    m_nChannels = m_nTrainSize = m_nPlaneStride = 0;
+    m_nSubstrBits = m_nSubstrCount = 0;
+    m_vnTrainPlanes.clear();
+    m_vnTrainKeys.clear();
+    m_vvnBucketOffsets.clear();
+    m_vvnBucketIdxs.clear();
+}
+
+void LBSPMatcher::match(const cv::Mat& oQueryDescs, std::vector<cv::DMatch>& voMatches) const {
+    std::vector<std::vector<cv::DMatch>> vvoMatches;
+    matchAll(oQueryDescs,1,SIZE_MAX,vvoMatches);
+    voMatches.resize(vvoMatches.size());
+    for(size_t nQueryIdx=0; nQueryIdx<vvoMatches.size(); ++nQueryIdx)
+        voMatches[nQueryIdx] = vvoMatches[nQueryIdx][0];
+}
+
+void LBSPMatcher::knnMatch(const cv::Mat& oQueryDescs, std::vector<std::vector<cv::DMatch>>& vvoMatches, size_t nK) const {
+    lvAssert_(nK>0,"need to look for at least one neighbor");
+    matchAll(oQueryDescs,nK,SIZE_MAX,vvoMatches);
+}
+
+void LBSPMatcher::radiusMatch(const cv::Mat& oQueryDescs, std::vector<std::vector<cv::DMatch>>& vvoMatches, size_t nMaxDist) const {
+    matchAll(oQueryDescs,0,nMaxDist,vvoMatches);
+}
+
+void LBSPMatcher::matchAll(const cv::Mat& oQueryDescs, size_t nK, size_t nMaxDist, std::vector<std::vector<cv::DMatch>>& vvoMatches) const {
+    lvAssert_(m_nTrainSize>0,"matcher must be trained first");
+    lvAssert_(oQueryDescs.empty() || (oQueryDescs.depth()==CV_16U && (size_t)oQueryDescs.channels()==m_nChannels),"query descriptors must be given as a CV_16UC(n) mat w/ the same channel count as train descriptors");
+    const size_t nQueries = oQueryDescs.total();
+    vvoMatches.resize(nQueries);
+    lv::parallel_for(0,nQueries,MATCH_QUERY_GRAIN,[&](size_t nQueryBegin, size_t nQueryEnd) {
+        std::vector<std::pair<uchar,uint>> vMatches;
+        std::vector<uchar> vnDistRow;
+        for(size_t nQueryIdx=nQueryBegin; nQueryIdx<nQueryEnd; ++nQueryIdx) {
+            matchQuery(getDescPtr(oQueryDescs,nQueryIdx),nK,nMaxDist,vMatches,vnDistRow);
+            std::vector<cv::DMatch>& voMatches = vvoMatches[nQueryIdx];
+            voMatches.resize(vMatches.size());
+            for(size_t nMatchIdx=0; nMatchIdx<vMatches.size(); ++nMatchIdx)
+                voMatches[nMatchIdx] = cv::DMatch((int)nQueryIdx,(int)vMatches[nMatchIdx].second,(float)vMatches[nMatchIdx].first);
+        }
+    });
+}
+
+void LBSPMatcher::matchQuery(const ushort* anQuery, size_t nK, size_t nMaxDist, std::vector<std::pair<uchar,uint>>& vMatches, std::vector<uchar>& vnDistRow) const {
+    vMatches.clear();
+    if(isUsingMultiIndex() && matchQuery_MultiIndex(packDescKey(anQuery,m_nChannels),nK,nMaxDist,vMatches))
+        return;
+    vnDistRow.resize(m_nPlaneStride);
+    const ushort* anTrainPlanes = m_vnTrainPlanes.data();
+    if(m_nChannels==1)
+        computeDistRow<1>(anQuery,anTrainPlanes,m_nPlaneStride,vnDistRow.data());
+    else if(m_nChannels==2)
+        computeDistRow<2>(anQuery,anTrainPlanes,m_nPlaneStride,vnDistRow.data());
+    else
+        computeDistRow<3>(anQuery,anTrainPlanes,m_nPlaneStride,vnDistRow.data());
+    const uchar* anDists = vnDistRow.data();
+    if(nK==0) {
+        for(size_t nTrainIdx=0; nTrainIdx<m_nTrainSize; ++nTrainIdx)
+            if(anDists[nTrainIdx]<=nMaxDist)
+                vMatches.emplace_back(anDists[nTrainIdx],(uint)nTrainIdx);
+    }
+    else if(nK==1) {
+        size_t nBestIdx = 0;
+        for(size_t nTrainIdx=1; nTrainIdx<m_nTrainSize && anDists[nBestIdx]>0; ++nTrainIdx)
+            if(anDists[nTrainIdx]<anDists[nBestIdx])
+                nBestIdx = nTrainIdx;
+        vMatches.emplace_back(anDists[nBestIdx],(uint)nBestIdx);
+    }
+    else {
+        // distances are bounded by the descriptor bit count, so the k-th smallest one is found via a histogram instead of a partial sort
+        std::array<size_t,LBSP::DESC_SIZE_BITS*3+1> anHist = {};
+        for(size_t nTrainIdx=0; nTrainIdx<m_nTrainSize; ++nTrainIdx)
+            ++anHist[anDists[nTrainIdx]];
+        nK = std::min(nK,m_nTrainSize);
+        size_t nKthDist = 0, nBelowKthDist = 0;
+        while(nBelowKthDist+anHist[nKthDist]<nK)
+            nBelowKthDist += anHist[nKthDist++];
+        size_t nKthDistLeft = nK-nBelowKthDist;
+        for(size_t nTrainIdx=0; nTrainIdx<m_nTrainSize; ++nTrainIdx) {
+            if(anDists[nTrainIdx]<nKthDist || (anDists[nTrainIdx]==nKthDist && nKthDistLeft>0 && nKthDistLeft--))
+                vMatches.emplace_back(anDists[nTrainIdx],(uint)nTrainIdx);
+        }
+    }
+    std::sort(vMatches.begin(),vMatches.end());
+}
+
+bool LBSPMatcher::matchQuery_MultiIndex(uint64_t nQueryKey, size_t nK, size_t nMaxDist, std::vector<std::pair<uchar,uint>>& vMatches) const {
+    lvDbgAssert(isUsingMultiIndex() && vMatches.empty());
+    // pigeonhole principle: any train desc within r of the query is within floor(r/m) of it on at least one of the m substrings
+    const size_t nMaxSubstrRadius = (nK==0)?nMaxDist/m_nSubstrCount:size_t(MULTIINDEX_MAX_SUBSTR_RADIUS);
+    if(nMaxSubstrRadius>MULTIINDEX_MAX_SUBSTR_RADIUS)
+        return false;
+    const uint nSubstrMask = uint((size_t(1)<<m_nSubstrBits)-1);
+    std::vector<uint> vnCandidateIdxs,vnCheckedIdxs;
+    for(size_t nSubstrRadius=0; nSubstrRadius<=nMaxSubstrRadius; ++nSubstrRadius) {
+        vnCandidateIdxs.clear();
+        for(size_t nSubstrIdx=0; nSubstrIdx<m_nSubstrCount; ++nSubstrIdx) {
+            const std::vector<uint>& vnOffsets = m_vvnBucketOffsets[nSubstrIdx];
+            const std::vector<uint>& vnIdxs = m_vvnBucketIdxs[nSubstrIdx];
+            forEachKeyAtRadius(uint(nQueryKey>>(nSubstrIdx*m_nSubstrBits))&nSubstrMask,m_nSubstrBits,nSubstrRadius,0,[&](uint nBucketIdx) {
+                vnCandidateIdxs.insert(vnCandidateIdxs.end(),vnIdxs.begin()+vnOffsets[nBucketIdx],vnIdxs.begin()+vnOffsets[nBucketIdx+1]);
+            });
+        }
+        std::sort(vnCandidateIdxs.begin(),vnCandidateIdxs.end());
+        vnCandidateIdxs.erase(std::unique(vnCandidateIdxs.begin(),vnCandidateIdxs.end()),vnCandidateIdxs.end());
+        const size_t nPrevCheckedCount = vnCheckedIdxs.size();
+        for(uint nTrainIdx : vnCandidateIdxs) {
+            if(std::binary_search(vnCheckedIdxs.begin(),vnCheckedIdxs.begin()+nPrevCheckedCount,nTrainIdx))
+                continue;
+            vnCheckedIdxs.push_back(nTrainIdx);
+            const size_t nDist = lv::popcount(nQueryKey^m_vnTrainKeys[nTrainIdx]);
+            if(nK>0 || nDist<=nMaxDist)
+                vMatches.emplace_back((uchar)nDist,nTrainIdx);
+        }
+        std::inplace_merge(vnCheckedIdxs.begin(),vnCheckedIdxs.begin()+nPrevCheckedCount,vnCheckedIdxs.end());
+        if(nK>0) {
+            // all train descs within (m*(s+1)-1) of the query have been found at this point
+            const size_t nExhaustiveDist = m_nSubstrCount*(nSubstrRadius+1)-1;
+            std::sort(vMatches.begin(),vMatches.end());
+            if(vMatches.size()>=nK && vMatches[nK-1].first<=nExhaustiveDist) {
+                vMatches.resize(nK);
+                return true;
+            }
+        }
+    }
+    if(nK>0) {
+        // not enough close neighbors; let the caller fall back to brute-force matching
+        vMatches.clear();
+        return false;
+    }
+    std::sort(vMatches.begin(),vMatches.end());
+    return true;
+}
@@ -0,0 +1,198 @@
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LBSP_kernels.hpp"
+
+namespace {
+
+    template<bool bUseThresholdArray>
+    inline void computeRow_Scalar_impl(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc) {
+        for(size_t nElemIdx=0; nElemIdx<nElems; ++nElemIdx) {
+            const int nRef = anRefs[nElemIdx];
+            const int nCurrThreshold = bUseThresholdArray?anThresholds[nElemIdx]:nThreshold;
+            unsigned short nDesc = 0;
+            for(size_t n=0; n<lbsp_impl::s_nKernelOffsets; ++n) {
+                const int nDist = (int)anData[nElemIdx+anOffsets[n]]-nRef;
+                nDesc |= (unsigned short)(((nDist<0?-nDist:nDist)>nCurrThreshold)<<n);
+            }
+            anDesc[nElemIdx] = nDesc;
+        }
+    }
+
+    template<lbsp_impl::HDistMode eMode>
+    inline void computeHDistRow_Scalar_impl(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+        for(size_t nElemIdx=0; nElemIdx<nElems; ++nElemIdx) {
+            unsigned int nBits = (unsigned int)(anDesc1[nElemIdx]^anDesc2[nElemIdx]);
+            nBits = nBits-((nBits>>1)&0x5555u);
+            nBits = (nBits&0x3333u)+((nBits>>2)&0x3333u);
+            nBits = (nBits+(nBits>>4))&0x0F0Fu;
+            const unsigned int nDist = (nBits+(nBits>>8))&0x1Fu;
+            // integer equivalents of the former '(255/16)*dist' and '((255/16)*dist)/3' float/truncation expressions
+            anOutput[nElemIdx] = (unsigned char)(eMode==lbsp_impl::HDist_Scaled?((nDist<<4)-(nDist!=0)):eMode==lbsp_impl::HDist_ScaledThird?((nDist*85)>>4):nDist);
+        }
+    }
+
+#if LBSP_KERNELS_X86 && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2))
+    template<bool bUseThresholdArray>
+    inline size_t computeRow_SSE2_impl(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc) {
+        const __m128i vnZero = _mm_setzero_si128();
+        const __m128i vnThreshold = _mm_set1_epi16((short)nThreshold);
+        size_t nElemIdx = 0;
+        for(; nElemIdx+8<=nElems; nElemIdx+=8) {
+            const __m128i vnRefs = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(anRefs+nElemIdx)),vnZero);
+            const __m128i vnThresholds = bUseThresholdArray?_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(anThresholds+nElemIdx)),vnZero):vnThreshold;
+            __m128i vnDesc = _mm_setzero_si128();
+            for(size_t n=0; n<lbsp_impl::s_nKernelOffsets; ++n) {
+                const __m128i vnVals = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(anData+nElemIdx+anOffsets[n])),vnZero);
+                const __m128i vnDists = _mm_sub_epi16(_mm_max_epi16(vnVals,vnRefs),_mm_min_epi16(vnVals,vnRefs));
+                vnDesc = _mm_or_si128(vnDesc,_mm_and_si128(_mm_cmpgt_epi16(vnDists,vnThresholds),_mm_set1_epi16((short)(1<<n))));
+            }
+            _mm_storeu_si128((__m128i*)(anDesc+nElemIdx),vnDesc);
+        }
+        return nElemIdx;
+    }
+    template<lbsp_impl::HDistMode eMode>
+    inline __m128i computeHDist_SSE2(const __m128i& vnDesc1, const __m128i& vnDesc2) {
+        __m128i vnBits = _mm_xor_si128(vnDesc1,vnDesc2);
+        vnBits = _mm_sub_epi16(vnBits,_mm_and_si128(_mm_srli_epi16(vnBits,1),_mm_set1_epi16(0x5555)));
+        vnBits = _mm_add_epi16(_mm_and_si128(vnBits,_mm_set1_epi16(0x3333)),_mm_and_si128(_mm_srli_epi16(vnBits,2),_mm_set1_epi16(0x3333)));
+        vnBits = _mm_and_si128(_mm_add_epi16(vnBits,_mm_srli_epi16(vnBits,4)),_mm_set1_epi16(0x0F0F));
+        const __m128i vnDist = _mm_srli_epi16(_mm_add_epi16(vnBits,_mm_slli_epi16(vnBits,8)),8);
+        if(eMode==lbsp_impl::HDist_Scaled)
+            return _mm_sub_epi16(_mm_slli_epi16(vnDist,4),_mm_min_epi16(vnDist,_mm_set1_epi16(1)));
+        else if(eMode==lbsp_impl::HDist_ScaledThird)
+            return _mm_srli_epi16(_mm_mullo_epi16(vnDist,_mm_set1_epi16(85)),4);
+        return vnDist;
+    }
+
+    template<lbsp_impl::HDistMode eMode>
+    inline size_t computeHDistRow_SSE2_impl(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+        size_t nElemIdx = 0;
+        for(; nElemIdx+16<=nElems; nElemIdx+=16) {
+            const __m128i vnDistLow = computeHDist_SSE2<eMode>(_mm_loadu_si128((const __m128i*)(anDesc1+nElemIdx)),_mm_loadu_si128((const __m128i*)(anDesc2+nElemIdx)));
+            const __m128i vnDistHigh = computeHDist_SSE2<eMode>(_mm_loadu_si128((const __m128i*)(anDesc1+nElemIdx+8)),_mm_loadu_si128((const __m128i*)(anDesc2+nElemIdx+8)));
+            _mm_storeu_si128((__m128i*)(anOutput+nElemIdx),_mm_packus_epi16(vnDistLow,vnDistHigh));
+        }
+        return nElemIdx;
+    }
+#define LBSP_KERNELS_SSE2 1
+#endif //LBSP_KERNELS_X86 && __SSE2__
+
+#if LBSP_KERNELS_NEON
+    template<bool bUseThresholdArray>
+    inline size_t computeRow_NEON_impl(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc) {
+        const uint8x16_t vnThreshold = vdupq_n_u8(nThreshold);
+        size_t nElemIdx = 0;
+        for(; nElemIdx+16<=nElems; nElemIdx+=16) {
+            const uint8x16_t vnRefs = vld1q_u8(anRefs+nElemIdx);
+            const uint8x16_t vnThresholds = bUseThresholdArray?vld1q_u8(anThresholds+nElemIdx):vnThreshold;
+            uint16x8_t vnDescLow = vdupq_n_u16(0), vnDescHigh = vdupq_n_u16(0);
+            for(size_t n=0; n<lbsp_impl::s_nKernelOffsets; ++n) {
+                // comparisons are done on 8-bit lanes, and their (all-ones) results are sign-extended to 16-bit before masking
+                const int8x16_t vbCmpRes = vreinterpretq_s8_u8(vcgtq_u8(vabdq_u8(vld1q_u8(anData+nElemIdx+anOffsets[n]),vnRefs),vnThresholds));
+                const uint16x8_t vnBit = vdupq_n_u16((unsigned short)(1<<n));
+                vnDescLow = vorrq_u16(vnDescLow,vandq_u16(vreinterpretq_u16_s16(vmovl_s8(vget_low_s8(vbCmpRes))),vnBit));
+                vnDescHigh = vorrq_u16(vnDescHigh,vandq_u16(vreinterpretq_u16_s16(vmovl_s8(vget_high_s8(vbCmpRes))),vnBit));
+            }
+            vst1q_u16(anDesc+nElemIdx,vnDescLow);
+            vst1q_u16(anDesc+nElemIdx+8,vnDescHigh);
+        }
+        return nElemIdx;
+    }
+
+    template<lbsp_impl::HDistMode eMode>
+    inline uint16x8_t computeHDist_NEON(const uint16x8_t& vnDesc1, const uint16x8_t& vnDesc2) {
+        const uint16x8_t vnDist = vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u16(veorq_u16(vnDesc1,vnDesc2))));
+        if(eMode==lbsp_impl::HDist_Scaled)
+            return vsubq_u16(vshlq_n_u16(vnDist,4),vminq_u16(vnDist,vdupq_n_u16(1)));
+        else if(eMode==lbsp_impl::HDist_ScaledThird)
+            return vshrq_n_u16(vmulq_n_u16(vnDist,85),4);
+        return vnDist;
+    }
+
+    template<lbsp_impl::HDistMode eMode>
+    inline size_t computeHDistRow_NEON_impl(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+        size_t nElemIdx = 0;
+        for(; nElemIdx+16<=nElems; nElemIdx+=16) {
+            const uint16x8_t vnDistLow = computeHDist_NEON<eMode>(vld1q_u16(anDesc1+nElemIdx),vld1q_u16(anDesc2+nElemIdx));
+            const uint16x8_t vnDistHigh = computeHDist_NEON<eMode>(vld1q_u16(anDesc1+nElemIdx+8),vld1q_u16(anDesc2+nElemIdx+8));
+            vst1q_u8(anOutput+nElemIdx,vcombine_u8(vqmovn_u16(vnDistLow),vqmovn_u16(vnDistHigh)));
+        }
+        return nElemIdx;
+    }
+#endif //LBSP_KERNELS_NEON
+
+} // namespace
+
+void lbsp_impl::computeRow_Scalar(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc) {
+    if(anThresholds)
+        computeRow_Scalar_impl<true>(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc);
+    else
+        computeRow_Scalar_impl<false>(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc);
+}
+
+void lbsp_impl::computeRow_SSE2(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc) {
+#if LBSP_KERNELS_SSE2
+    const size_t nDone = anThresholds?
+        computeRow_SSE2_impl<true>(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc):
+        computeRow_SSE2_impl<false>(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc);
+    computeRow_Scalar(anData+nDone,anRefs+nDone,anOffsets,nElems-nDone,anThresholds?anThresholds+nDone:nullptr,nThreshold,anDesc+nDone);
+#else //(!LBSP_KERNELS_SSE2)
+    computeRow_Scalar(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc);
+#endif //(!LBSP_KERNELS_SSE2)
+}
+
+void lbsp_impl::computeRow_NEON(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc) {
+#if LBSP_KERNELS_NEON
+    const size_t nDone = anThresholds?
+        computeRow_NEON_impl<true>(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc):
+        computeRow_NEON_impl<false>(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc);
+    computeRow_Scalar(anData+nDone,anRefs+nDone,anOffsets,nElems-nDone,anThresholds?anThresholds+nDone:nullptr,nThreshold,anDesc+nDone);
+#else //(!LBSP_KERNELS_NEON)
+    computeRow_Scalar(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc);
+#endif //(!LBSP_KERNELS_NEON)
+}
+
+void lbsp_impl::computeHDistRow_Scalar(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, HDistMode eMode, unsigned char* anOutput) {
+    if(eMode==HDist_Scaled)
+        computeHDistRow_Scalar_impl<HDist_Scaled>(anDesc1,anDesc2,nElems,anOutput);
+    else if(eMode==HDist_ScaledThird)
+        computeHDistRow_Scalar_impl<HDist_ScaledThird>(anDesc1,anDesc2,nElems,anOutput);
+    else
+        computeHDistRow_Scalar_impl<HDist_Raw>(anDesc1,anDesc2,nElems,anOutput);
+}
+
+void lbsp_impl::computeHDistRow_SSE2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, HDistMode eMode, unsigned char* anOutput) {
+#if LBSP_KERNELS_SSE2
+    const size_t nDone = (eMode==HDist_Scaled)?computeHDistRow_SSE2_impl<HDist_Scaled>(anDesc1,anDesc2,nElems,anOutput):
+                         (eMode==HDist_ScaledThird)?computeHDistRow_SSE2_impl<HDist_ScaledThird>(anDesc1,anDesc2,nElems,anOutput):
+                         computeHDistRow_SSE2_impl<HDist_Raw>(anDesc1,anDesc2,nElems,anOutput);
+    computeHDistRow_Scalar(anDesc1+nDone,anDesc2+nDone,nElems-nDone,eMode,anOutput+nDone);
+#else //(!LBSP_KERNELS_SSE2)
+    computeHDistRow_Scalar(anDesc1,anDesc2,nElems,eMode,anOutput);
+#endif //(!LBSP_KERNELS_SSE2)
+}
+
+void lbsp_impl::computeHDistRow_NEON(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, HDistMode eMode, unsigned char* anOutput) {
+#if LBSP_KERNELS_NEON
+    const size_t nDone = (eMode==HDist_Scaled)?computeHDistRow_NEON_impl<HDist_Scaled>(anDesc1,anDesc2,nElems,anOutput):
+                         (eMode==HDist_ScaledThird)?computeHDistRow_NEON_impl<HDist_ScaledThird>(anDesc1,anDesc2,nElems,anOutput):
+                         computeHDistRow_NEON_impl<HDist_Raw>(anDesc1,anDesc2,nElems,anOutput);
+    computeHDistRow_Scalar(anDesc1+nDone,anDesc2+nDone,nElems-nDone,eMode,anOutput+nDone);
+#else //(!LBSP_KERNELS_NEON)
+    computeHDistRow_Scalar(anDesc1,anDesc2,nElems,eMode,anOutput);
+#endif //(!LBSP_KERNELS_NEON)
+}
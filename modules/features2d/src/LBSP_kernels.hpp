@@ -0,0 +1,78 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// note: this header is shared by the runtime-dispatched LBSP kernel translation units, which are compiled with
+// different instruction set flags; it must stay free of any inline code coming from other headers (e.g. std/cv/lv),
+// as the linker could otherwise pick an instantiation that uses instructions not supported by the current CPU
+
+#include <cstddef>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LBSP_KERNELS_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else //(!defined(_MSC_VER))
+#include <x86intrin.h>
+#endif //(!defined(_MSC_VER))
+#else //(!x86)
+#define LBSP_KERNELS_X86 0
+#endif //(!x86)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LBSP_KERNELS_NEON 1
+#include <arm_neon.h>
+#else //(!NEON)
+#define LBSP_KERNELS_NEON 0
+#endif //(!NEON)
+
+namespace lbsp_impl {
+
+    /// signature of the row-batched LBSP descriptor kernels (elements are interleaved pixel channels; thresholds array may be null to use the fixed value)
+    typedef void(*RowKernel)(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc);
+
+    /// number of neighbor offsets used by all kernels below (16-bit double-cross pattern)
+    constexpr size_t s_nKernelOffsets = 16;
+
+    /// baseline implementation, always available
+    void computeRow_Scalar(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc);
+    /// SSE2 implementation (8 elements per iteration, falls back to scalar if not compiled in)
+    void computeRow_SSE2(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc);
+    /// AVX2 implementation (16 elements per iteration, falls back to SSE2 if not compiled in)
+    void computeRow_AVX2(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc);
+    /// NEON implementation (16 elements per iteration, falls back to scalar if not compiled in)
+    void computeRow_NEON(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc);
+    /// AVX-512BW implementation (32 elements per iteration, falls back to AVX2 if not compiled in)
+    void computeRow_AVX512BW(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc);
+
+    /// output modes of the descriptor hamming distance kernels: raw bit count, rescaled to [0,255], or rescaled to [0,85] (for 3-channel merging)
+    enum HDistMode {HDist_Raw,HDist_Scaled,HDist_ScaledThird};
+
+    /// signature of the row-batched descriptor hamming distance kernels (elements are interleaved pixel channels)
+    typedef void(*HDistKernel)(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, HDistMode eMode, unsigned char* anOutput);
+
+    /// baseline implementation, always available
+    void computeHDistRow_Scalar(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, HDistMode eMode, unsigned char* anOutput);
+    /// SSE2 implementation (16 elements per iteration, SWAR popcount, falls back to scalar if not compiled in)
+    void computeHDistRow_SSE2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, HDistMode eMode, unsigned char* anOutput);
+    /// AVX2 implementation (32 elements per iteration, nibble-LUT popcount, falls back to SSE2 if not compiled in)
+    void computeHDistRow_AVX2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, HDistMode eMode, unsigned char* anOutput);
+    /// NEON implementation (16 elements per iteration, falls back to scalar if not compiled in)
+    void computeHDistRow_NEON(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, HDistMode eMode, unsigned char* anOutput);
+    /// AVX-512BW implementation (64 elements per iteration, nibble-LUT popcount, falls back to AVX2 if not compiled in)
+    void computeHDistRow_AVX512BW(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, HDistMode eMode, unsigned char* anOutput);
+
+} // namespace lbsp_impl
@@ -0,0 +1,98 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// note: this translation unit is compiled with AVX2 enabled (see CMakeLists.txt); its kernel is only called when the
+// current CPU supports the instruction set, so nothing else than the kernel itself should ever be defined here
+
+#include "LBSP_kernels.hpp"
+
+#if LBSP_KERNELS_X86 && defined(__AVX2__)
+
+namespace {
+
+    template<bool bUseThresholdArray>
+    inline size_t computeRow_AVX2_impl(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc) {
+        const __m256i vnThreshold = _mm256_set1_epi16((short)nThreshold);
+        size_t nElemIdx = 0;
+        for(; nElemIdx+16<=nElems; nElemIdx+=16) {
+            const __m256i vnRefs = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(anRefs+nElemIdx)));
+            const __m256i vnThresholds = bUseThresholdArray?_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(anThresholds+nElemIdx))):vnThreshold;
+            __m256i vnDesc = _mm256_setzero_si256();
+            for(size_t n=0; n<lbsp_impl::s_nKernelOffsets; ++n) {
+                const __m256i vnVals = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(anData+nElemIdx+anOffsets[n])));
+                const __m256i vbCmpRes = _mm256_cmpgt_epi16(_mm256_abs_epi16(_mm256_sub_epi16(vnVals,vnRefs)),vnThresholds);
+                vnDesc = _mm256_or_si256(vnDesc,_mm256_and_si256(vbCmpRes,_mm256_set1_epi16((short)(1<<n))));
+            }
+            _mm256_storeu_si256((__m256i*)(anDesc+nElemIdx),vnDesc);
+        }
+        return nElemIdx;
+    }
+
+    template<lbsp_impl::HDistMode eMode>
+    inline __m256i computeHDist_AVX2(const __m256i& vnDesc1, const __m256i& vnDesc2) {
+        const __m256i vnNibbleLUT = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+        const __m256i vnNibbleMask = _mm256_set1_epi8(0x0F);
+        const __m256i vnBits = _mm256_xor_si256(vnDesc1,vnDesc2);
+        const __m256i vnByteCounts = _mm256_add_epi8(_mm256_shuffle_epi8(vnNibbleLUT,_mm256_and_si256(vnBits,vnNibbleMask)),
+                                                     _mm256_shuffle_epi8(vnNibbleLUT,_mm256_and_si256(_mm256_srli_epi16(vnBits,4),vnNibbleMask)));
+        const __m256i vnDist = _mm256_maddubs_epi16(vnByteCounts,_mm256_set1_epi8(1));
+        if(eMode==lbsp_impl::HDist_Scaled)
+            return _mm256_sub_epi16(_mm256_slli_epi16(vnDist,4),_mm256_min_epi16(vnDist,_mm256_set1_epi16(1)));
+        else if(eMode==lbsp_impl::HDist_ScaledThird)
+            return _mm256_srli_epi16(_mm256_mullo_epi16(vnDist,_mm256_set1_epi16(85)),4);
+        return vnDist;
+    }
+
+    template<lbsp_impl::HDistMode eMode>
+    inline size_t computeHDistRow_AVX2_impl(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+        size_t nElemIdx = 0;
+        for(; nElemIdx+32<=nElems; nElemIdx+=32) {
+            const __m256i vnDistLow = computeHDist_AVX2<eMode>(_mm256_loadu_si256((const __m256i*)(anDesc1+nElemIdx)),_mm256_loadu_si256((const __m256i*)(anDesc2+nElemIdx)));
+            const __m256i vnDistHigh = computeHDist_AVX2<eMode>(_mm256_loadu_si256((const __m256i*)(anDesc1+nElemIdx+16)),_mm256_loadu_si256((const __m256i*)(anDesc2+nElemIdx+16)));
+            // packing is done per 128-bit lane, so the 64-bit blocks must be reordered afterwards
+            _mm256_storeu_si256((__m256i*)(anOutput+nElemIdx),_mm256_permute4x64_epi64(_mm256_packus_epi16(vnDistLow,vnDistHigh),0xD8));
+        }
+        return nElemIdx;
+    }
+
+} // namespace
+
+void lbsp_impl::computeRow_AVX2(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc) {
+    const size_t nDone = anThresholds?
+        computeRow_AVX2_impl<true>(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc):
+        computeRow_AVX2_impl<false>(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc);
+    computeRow_SSE2(anData+nDone,anRefs+nDone,anOffsets,nElems-nDone,anThresholds?anThresholds+nDone:nullptr,nThreshold,anDesc+nDone);
+}
+
+void lbsp_impl::computeHDistRow_AVX2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, HDistMode eMode, unsigned char* anOutput) {
+    const size_t nDone = (eMode==HDist_Scaled)?computeHDistRow_AVX2_impl<HDist_Scaled>(anDesc1,anDesc2,nElems,anOutput):
+                         (eMode==HDist_ScaledThird)?computeHDistRow_AVX2_impl<HDist_ScaledThird>(anDesc1,anDesc2,nElems,anOutput):
+                         computeHDistRow_AVX2_impl<HDist_Raw>(anDesc1,anDesc2,nElems,anOutput);
+    computeHDistRow_SSE2(anDesc1+nDone,anDesc2+nDone,nElems-nDone,eMode,anOutput+nDone);
+}
+
+#else //!(LBSP_KERNELS_X86 && defined(__AVX2__))
+
+void lbsp_impl::computeRow_AVX2(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc) {
+    computeRow_SSE2(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc);
+}
+
+void lbsp_impl::computeHDistRow_AVX2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, HDistMode eMode, unsigned char* anOutput) {
+    computeHDistRow_SSE2(anDesc1,anDesc2,nElems,eMode,anOutput);
+}
+
+#endif //!(LBSP_KERNELS_X86 && defined(__AVX2__))
@@ -0,0 +1,99 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// note: this translation unit is compiled with AVX-512BW enabled (see CMakeLists.txt); its kernel is only called when the
+// current CPU supports the instruction set, so nothing else than the kernel itself should ever be defined here
+
+#include "LBSP_kernels.hpp"
+
+#if LBSP_KERNELS_X86 && defined(__AVX512BW__)
+
+namespace {
+
+    template<bool bUseThresholdArray>
+    inline size_t computeRow_AVX512BW_impl(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc) {
+        const __m512i vnThreshold = _mm512_set1_epi16((short)nThreshold);
+        size_t nElemIdx = 0;
+        for(; nElemIdx+32<=nElems; nElemIdx+=32) {
+            const __m512i vnRefs = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(anRefs+nElemIdx)));
+            const __m512i vnThresholds = bUseThresholdArray?_mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(anThresholds+nElemIdx))):vnThreshold;
+            __m512i vnDesc = _mm512_setzero_si512();
+            for(size_t n=0; n<lbsp_impl::s_nKernelOffsets; ++n) {
+                const __m512i vnVals = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(anData+nElemIdx+anOffsets[n])));
+                const __mmask32 abCmpRes = _mm512_cmpgt_epu16_mask(_mm512_abs_epi16(_mm512_sub_epi16(vnVals,vnRefs)),vnThresholds);
+                vnDesc = _mm512_or_si512(vnDesc,_mm512_maskz_mov_epi16(abCmpRes,_mm512_set1_epi16((short)(1<<n))));
+            }
+            _mm512_storeu_si512((void*)(anDesc+nElemIdx),vnDesc);
+        }
+        return nElemIdx;
+    }
+
+    template<lbsp_impl::HDistMode eMode>
+    inline __m512i computeHDist_AVX512BW(const __m512i& vnDesc1, const __m512i& vnDesc2) {
+        const __m512i vnNibbleLUT = _mm512_set_epi64(0x0403030203020201,0x0302020102010100,0x0403030203020201,0x0302020102010100,0x0403030203020201,0x0302020102010100,0x0403030203020201,0x0302020102010100);
+        const __m512i vnNibbleMask = _mm512_set1_epi8(0x0F);
+        const __m512i vnBits = _mm512_xor_si512(vnDesc1,vnDesc2);
+        const __m512i vnByteCounts = _mm512_add_epi8(_mm512_shuffle_epi8(vnNibbleLUT,_mm512_and_si512(vnBits,vnNibbleMask)),
+                                                     _mm512_shuffle_epi8(vnNibbleLUT,_mm512_and_si512(_mm512_srli_epi16(vnBits,4),vnNibbleMask)));
+        const __m512i vnDist = _mm512_maddubs_epi16(vnByteCounts,_mm512_set1_epi8(1));
+        if(eMode==lbsp_impl::HDist_Scaled)
+            return _mm512_sub_epi16(_mm512_slli_epi16(vnDist,4),_mm512_min_epi16(vnDist,_mm512_set1_epi16(1)));
+        else if(eMode==lbsp_impl::HDist_ScaledThird)
+            return _mm512_srli_epi16(_mm512_mullo_epi16(vnDist,_mm512_set1_epi16(85)),4);
+        return vnDist;
+    }
+
+    template<lbsp_impl::HDistMode eMode>
+    inline size_t computeHDistRow_AVX512BW_impl(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+        const __m512i vnPackOrder = _mm512_setr_epi64(0,2,4,6,1,3,5,7);
+        size_t nElemIdx = 0;
+        for(; nElemIdx+64<=nElems; nElemIdx+=64) {
+            const __m512i vnDistLow = computeHDist_AVX512BW<eMode>(_mm512_loadu_si512((const void*)(anDesc1+nElemIdx)),_mm512_loadu_si512((const void*)(anDesc2+nElemIdx)));
+            const __m512i vnDistHigh = computeHDist_AVX512BW<eMode>(_mm512_loadu_si512((const void*)(anDesc1+nElemIdx+32)),_mm512_loadu_si512((const void*)(anDesc2+nElemIdx+32)));
+            // packing is done per 128-bit lane, so the 64-bit blocks must be reordered afterwards
+            _mm512_storeu_si512((void*)(anOutput+nElemIdx),_mm512_maskz_permutexvar_epi64((__mmask8)0xFF,vnPackOrder,_mm512_packus_epi16(vnDistLow,vnDistHigh)));
+        }
+        return nElemIdx;
+    }
+
+} // namespace
+
+void lbsp_impl::computeRow_AVX512BW(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc) {
+    const size_t nDone = anThresholds?
+        computeRow_AVX512BW_impl<true>(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc):
+        computeRow_AVX512BW_impl<false>(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc);
+    computeRow_AVX2(anData+nDone,anRefs+nDone,anOffsets,nElems-nDone,anThresholds?anThresholds+nDone:nullptr,nThreshold,anDesc+nDone);
+}
+
+void lbsp_impl::computeHDistRow_AVX512BW(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, HDistMode eMode, unsigned char* anOutput) {
+    const size_t nDone = (eMode==HDist_Scaled)?computeHDistRow_AVX512BW_impl<HDist_Scaled>(anDesc1,anDesc2,nElems,anOutput):
+                         (eMode==HDist_ScaledThird)?computeHDistRow_AVX512BW_impl<HDist_ScaledThird>(anDesc1,anDesc2,nElems,anOutput):
+                         computeHDistRow_AVX512BW_impl<HDist_Raw>(anDesc1,anDesc2,nElems,anOutput);
+    computeHDistRow_AVX2(anDesc1+nDone,anDesc2+nDone,nElems-nDone,eMode,anOutput+nDone);
+}
+
+#else //!(LBSP_KERNELS_X86 && defined(__AVX512BW__))
+
+void lbsp_impl::computeRow_AVX512BW(const unsigned char* anData, const unsigned char* anRefs, const ptrdiff_t* anOffsets, size_t nElems, const unsigned char* anThresholds, unsigned char nThreshold, unsigned short* anDesc) {
+    computeRow_AVX2(anData,anRefs,anOffsets,nElems,anThresholds,nThreshold,anDesc);
+}
+
+void lbsp_impl::computeHDistRow_AVX512BW(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, HDistMode eMode, unsigned char* anOutput) {
+    computeHDistRow_AVX2(anDesc1,anDesc2,nElems,eMode,anOutput);
+}
+
+#endif //!(LBSP_KERNELS_X86 && defined(__AVX512BW__))
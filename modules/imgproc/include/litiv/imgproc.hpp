@@ -19,6 +19,8 @@
 
 #include "litiv/imgproc/EdgeDetectorCanny.hpp"
 #include "litiv/imgproc/EdgeDetectorLBSP.hpp"
+#include "litiv/imgproc/MultimodalRegistrator.hpp"
+#include "litiv/imgproc/PerspectiveWarper.hpp"
 
 namespace lv {
 
@@ -28,8 +30,8 @@ namespace lv {
         ThinningMode_LamLeeSuen
     };
 
-    /// 'thins' the provided image (currently only works on 1ch 8UC1 images, treated as binary)
-    void thinning(const cv::Mat& oInput, cv::Mat& oOutput, ThinningMode eMode=ThinningMode_LamLeeSuen);
+    /// 'thins' the provided image (currently only works on 1ch 8UC1 images, treated as binary); Zhang-Suen row bands run on pThreadPool if provided
+    void thinning(const cv::Mat& oInput, cv::Mat& oOutput, ThinningMode eMode=ThinningMode_LamLeeSuen, lv::ThreadPool* pThreadPool=nullptr);
 
     /// performs non-maximum suppression on the input image, with a (nWinSize)x(nWinSize) window
     template<int nWinSize>
@@ -89,6 +91,114 @@ namespace lv {
             return isLocalMaximum_Diagonal<nHalfWinSize,false>(anMap,nMapColStep,nMapRowStep);
     }
 
+    /// determines if a pixel of an interleaved (char gradx, char grady, uchar gradmag, ...) map is a local maximum along its 3-axis gradient orientation
+    template<size_t nHalfWinSize>
+    inline bool isLocalMaximum_Oriented(const uchar* const anGradPx, const size_t nMapColStep, const size_t nMapRowStep) {
+        const char nGradX = ((const char*)anGradPx)[0];
+        const char nGradY = ((const char*)anGradPx)[1];
+        const uchar* const anMagPx = anGradPx+2;
+        const uint nShift_FPA = 15;
+        constexpr uint nTG22deg_FPA = (int)(0.4142135623730950488016887242097*(1<<nShift_FPA)+0.5); // == tan(pi/8)
+        const uint nGradX_abs = (uint)std::abs(nGradX);
+        const uint nGradY_abs = (uint)std::abs(nGradY)<<nShift_FPA;
+        const uint nTG22GradX_FPA = nGradX_abs*nTG22deg_FPA;
+        if(nGradY_abs<nTG22GradX_FPA) // flat gradient (sector 0)
+            return isLocalMaximum_Horizontal<nHalfWinSize>(anMagPx,nMapColStep,nMapRowStep);
+        const uint nTG67GradX_FPA = nTG22GradX_FPA+(nGradX_abs<<(nShift_FPA+1)); // == tan(3*pi/8)*nGradX_abs
+        if(nGradY_abs>nTG67GradX_FPA) // vertical gradient (sector 2)
+            return isLocalMaximum_Vertical<nHalfWinSize>(anMagPx,nMapColStep,nMapRowStep);
+        if(nGradX || nGradY) // diagonal gradient (sector 1 or 3, depending on grad sign diff)
+            return isLocalMaximum_Diagonal<nHalfWinSize>(anMagPx,nMapColStep,nMapRowStep,(nGradX^nGradY)>=0);
+        return isLocalMaximum_Diagonal<nHalfWinSize,true>(anMagPx,nMapColStep,nMapRowStep) ||
+               isLocalMaximum_Diagonal<nHalfWinSize,false>(anMagPx,nMapColStep,nMapRowStep);
+    }
+
+#if HAVE_SSE2
+    /// extracts byte 'nByteIdx' of 16 consecutive 4-byte interleaved pixels into lane-aligned unsigned bytes
+    template<int nByteIdx>
+    inline __m128i extractInterleaved_4x16ub(const uchar* const anPx) {
+        static_assert(nByteIdx>=0 && nByteIdx<4,"byte index out of range");
+        const __m128i _anMask = _mm_set1_epi32(0xFF);
+        __m128i _anVals[4];
+        lv::unroll<4>([&](int n){
+            _anVals[n] = _mm_and_si128(_mm_srli_epi32(_mm_loadu_si128((const __m128i*)(anPx+n*16)),nByteIdx*8),_anMask);
+        });
+        return _mm_packus_epi16(_mm_packs_epi32(_anVals[0],_anVals[1]),_mm_packs_epi32(_anVals[2],_anVals[3]));
+    }
+
+    /// computes the 'center > neighbor' (bStrict) or 'center >= neighbor' mask of unsigned bytes
+    template<bool bStrict>
+    inline __m128i cmpLocalMax_16ub(const __m128i& _anCenter, const __m128i& _anNeighb) {
+        const __m128i _anMax = _mm_max_epu8(_anCenter,_anNeighb);
+        if(bStrict) // a>b == !(max(a,b)==b)
+            return _mm_andnot_si128(_mm_cmpeq_epi8(_anMax,_anNeighb),_mm_set1_epi8(char(-1)));
+        return _mm_cmpeq_epi8(_anMax,_anCenter);
+    }
+
+    /// computes the local maximum mask of 16 interleaved pixels along a fixed axis (given as a byte offset between consecutive neighbors)
+    template<size_t nHalfWinSize>
+    inline __m128i isLocalMaximum_Axis_16(const uchar* const anMagPx, const __m128i& _anCenter, const ptrdiff_t nAxisOffset) {
+        __m128i _anRes = _mm_set1_epi8(char(-1));
+        lv::unroll<nHalfWinSize>([&](int n){
+            _anRes = _mm_and_si128(_anRes,cmpLocalMax_16ub<true>(_anCenter,extractInterleaved_4x16ub<0>(anMagPx-(n+1)*nAxisOffset)));
+            _anRes = _mm_and_si128(_anRes,cmpLocalMax_16ub<false>(_anCenter,extractInterleaved_4x16ub<0>(anMagPx+(n+1)*nAxisOffset)));
+        });
+        return _anRes;
+    }
+
+    /// computes the 3-axis oriented local maximum mask (0xFF/0x00) of 16 consecutive 4-byte interleaved (char gradx, char grady, uchar gradmag, ...) pixels
+    template<size_t nHalfWinSize>
+    inline __m128i isLocalMaximum_Oriented_16(const uchar* const anGradPx, const size_t nMapRowStep) {
+        constexpr ptrdiff_t nMapColStep = 4;
+        const uchar* const anMagPx = anGradPx+2;
+        const __m128i _anCenter = extractInterleaved_4x16ub<2>(anGradPx);
+        const ptrdiff_t nRowStep = (ptrdiff_t)nMapRowStep;
+        const __m128i _anHorizMax = isLocalMaximum_Axis_16<nHalfWinSize>(anMagPx,_anCenter,nMapColStep);
+        const __m128i _anVertMax = isLocalMaximum_Axis_16<nHalfWinSize>(anMagPx,_anCenter,nRowStep);
+        const __m128i _anDiagMax = isLocalMaximum_Axis_16<nHalfWinSize>(anMagPx,_anCenter,nRowStep+nMapColStep);
+        const __m128i _anInvDiagMax = isLocalMaximum_Axis_16<nHalfWinSize>(anMagPx,_anCenter,nRowStep-nMapColStep);
+        // orientation bins are computed in 32-bit lanes (4 pixels per load), mirroring the fixed-point tests of isLocalMaximum_Oriented
+        constexpr int nTG22deg_FPA = (int)(0.4142135623730950488016887242097*(1<<15)+0.5);
+        __m128i _anFlat[4], _anVert[4], _anInvDiag[4], _anNullGrad[4];
+        lv::unroll<4>([&](int n){
+            const __m128i _anPx = _mm_loadu_si128((const __m128i*)(anGradPx+n*16));
+            const __m128i _anGradX = _mm_srai_epi32(_mm_slli_epi32(_anPx,24),24);
+            const __m128i _anGradY = _mm_srai_epi32(_mm_slli_epi32(_anPx,16),24);
+            const __m128i _anSignX = _mm_srai_epi32(_anGradX,31), _anSignY = _mm_srai_epi32(_anGradY,31);
+            const __m128i _anGradX_abs = _mm_sub_epi32(_mm_xor_si128(_anGradX,_anSignX),_anSignX);
+            const __m128i _anGradY_abs = _mm_slli_epi32(_mm_sub_epi32(_mm_xor_si128(_anGradY,_anSignY),_anSignY),15);
+            const __m128i _anTG22GradX = _mm_madd_epi16(_anGradX_abs,_mm_set1_epi32(nTG22deg_FPA)); // high 16-bit halves are zero
+            const __m128i _anTG67GradX = _mm_add_epi32(_anTG22GradX,_mm_slli_epi32(_anGradX_abs,16));
+            _anFlat[n] = _mm_cmplt_epi32(_anGradY_abs,_anTG22GradX);
+            _anVert[n] = _mm_andnot_si128(_anFlat[n],_mm_cmpgt_epi32(_anGradY_abs,_anTG67GradX));
+            _anInvDiag[n] = _mm_cmpeq_epi32(_anSignX,_anSignY); // (gradx^grady)>=0
+            _anNullGrad[n] = _mm_cmpeq_epi32(_mm_or_si128(_anGradX,_anGradY),_mm_setzero_si128());
+        });
+        const auto lPackMasks = [](const __m128i* _anMasks) {
+            return _mm_packs_epi16(_mm_packs_epi32(_anMasks[0],_anMasks[1]),_mm_packs_epi32(_anMasks[2],_anMasks[3]));
+        };
+        const __m128i _anFlatMask = lPackMasks(_anFlat), _anVertMask = lPackMasks(_anVert);
+        const __m128i _anInvDiagMask = lPackMasks(_anInvDiag), _anNullGradMask = lPackMasks(_anNullGrad);
+        const __m128i _anDiagMask = _mm_andnot_si128(_mm_or_si128(_anFlatMask,_anVertMask),_mm_set1_epi8(char(-1)));
+        // isLocalMaximum_Diagonal's 'inverted' diagonal runs along the (nRowStep-nMapColStep) axis
+        const __m128i _anOrientedDiagMax = _mm_or_si128(_mm_and_si128(_anNullGradMask,_mm_or_si128(_anDiagMax,_anInvDiagMax)),
+                                                        _mm_andnot_si128(_anNullGradMask,_mm_or_si128(_mm_and_si128(_anInvDiagMask,_anInvDiagMax),_mm_andnot_si128(_anInvDiagMask,_anDiagMax))));
+        return _mm_or_si128(_mm_or_si128(_mm_and_si128(_anFlatMask,_anHorizMax),_mm_and_si128(_anVertMask,_anVertMax)),_mm_and_si128(_anDiagMask,_anOrientedDiagMax));
+    }
+#endif //HAVE_SSE2
+
+    /// fills anMaxMask (0xFF/0x00) with the 3-axis oriented local maximum flags of nPx consecutive 4-byte interleaved (char gradx, char grady, uchar gradmag, ...) pixels
+    template<size_t nHalfWinSize>
+    inline void isLocalMaximum_Oriented(const uchar* const anGradRow, const size_t nMapRowStep, const size_t nPx, uchar* const anMaxMask) {
+        size_t nPxIter = 0;
+#if HAVE_SSE2
+        for(; nPxIter+16<=nPx; nPxIter+=16)
+            _mm_storeu_si128((__m128i*)(anMaxMask+nPxIter),isLocalMaximum_Oriented_16<nHalfWinSize>(anGradRow+nPxIter*4,nMapRowStep));
+#endif //HAVE_SSE2
+        for(; nPxIter<nPx; ++nPxIter)
+            anMaxMask[nPxIter] = isLocalMaximum_Oriented<nHalfWinSize>(anGradRow+nPxIter*4,4,nMapRowStep)?UCHAR_MAX:0;
+    }
+
 } // namespace lv
 
 template<int nWinSize>
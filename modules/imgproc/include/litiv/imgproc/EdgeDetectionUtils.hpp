@@ -19,6 +19,90 @@
 
 #include "litiv/utils/parallel.hpp"
 #include "litiv/utils/opencv.hpp"
+#include <list>
+
+/// defines the default byte budget of lv::EdgeDetectorStageCache instances
+#define EDGEDETECT_DEFAULT_STAGE_CACHE_SIZE (size_t(512)<<20)
+
+namespace lv {
+
+    /// pixel labels expected in the input map of lv::ConnectedHysteresis::apply
+    enum HystLabel : uchar {
+        HystLabel_Candidate=0, ///< local maximum above the low threshold (kept only if connected to an edge)
+        HystLabel_NotEdge=1, ///< suppressed or below the low threshold
+        HystLabel_Edge=2, ///< local maximum above the high threshold
+    };
+
+    /// connected-component hysteresis; candidates 8-connected to an edge are kept (union-find over parallel row tiles, merged at tile borders)
+    struct ConnectedHysteresis {
+        /// fills oEdgeMask (8UC1, same size as oLabelMap) with 255 for kept pixels and 0 otherwise; tiles run on pThreadPool if provided
+        void apply(const cv::Mat& oLabelMap, cv::Mat& oEdgeMask, lv::ThreadPool* pThreadPool=nullptr);
+        /// single-pass threshold sweep; fills oLevelMap (32F) with the highest level v for which each pixel is connected through pixels with
+        /// pass level >= v to a seed with seed level >= v (or -1 for non-edge pixels), i.e. the highest threshold at which 'apply' keeps it
+        void sweep(const cv::Mat& oLabelMap, const cv::Mat& oPassLevelMap, const cv::Mat& oSeedLevelMap, cv::Mat& oLevelMap);
+    protected:
+        /// union-find component root data used in the threshold sweep
+        struct SweepRoot {
+            float fMaxSeedLevel; ///< highest seed level in the component (best hysteresis seed)
+            int nPendingHead,nPendingTail; ///< intrusive list of members whose survival level is not yet known
+            bool bResolved; ///< whether the component already reached a seed at a higher sweep level
+        };
+        /// pre-allocated union-find parent map (-1 for non-edge pixels)
+        std::vector<int> m_vnLabels;
+        /// pre-allocated per-root flags set when a component contains at least one edge
+        std::vector<uchar> m_vuRootFlags;
+        /// pre-allocated sweep buffers (pixel order, pending list links, root data)
+        std::vector<int> m_vnSweepOrder,m_vnSweepPendingNext;
+        std::vector<SweepRoot> m_vSweepRoots;
+    };
+
+    /// memoizes threshold-independent edge detection stages (e.g. pyramid/lookup & gradient maps) across 'apply' calls within a byte
+    /// budget (least recently used entries are evicted first); can be shared by several detectors/threads (e.g. in parameter sweeps)
+    struct EdgeDetectorStageCache {
+        /// stage entry key: image id, stage name & values of all upstream parameters the stage depends on
+        struct Key {
+            size_t nImageID;
+            std::string sStageName;
+            std::vector<double> vdParams;
+            bool operator<(const Key& oKey) const {return std::tie(nImageID,sStageName,vdParams)<std::tie(oKey.nImageID,oKey.sStageName,oKey.vdParams);}
+        };
+        /// stage data, i.e. deep copies of all maps produced by the stage
+        using StageData = std::vector<cv::Mat>;
+        /// constructor; the budget is the maximum total byte size of all cached stage data
+        explicit EdgeDetectorStageCache(size_t nMaxByteSize=EDGEDETECT_DEFAULT_STAGE_CACHE_SIZE);
+        /// returns the cached data of the given stage (and marks it as most recently used), or null if it is not cached
+        std::shared_ptr<const StageData> get(const Key& oKey);
+        /// caches a deep copy of the given stage data (replacing any previous entry), evicting least recently used entries if needed; data larger than the budget is skipped
+        void put(const Key& oKey, const StageData& vData);
+        /// releases all cached stage data & resets the hit/miss counters
+        void clear();
+        /// sets the byte budget, evicting least recently used entries if needed
+        void setMaxByteSize(size_t nMaxByteSize);
+        /// returns the byte budget
+        size_t getMaxByteSize() const;
+        /// returns the total byte size of all cached stage data
+        size_t getByteSize() const;
+        /// returns the number of cache hits since construction (or since the last 'clear' call)
+        size_t getHitCount() const;
+        /// returns the number of cache misses since construction (or since the last 'clear' call)
+        size_t getMissCount() const;
+    protected:
+        /// cached stage entry (shared data, byte size & position in the lru key list)
+        struct Entry {
+            std::shared_ptr<const StageData> pData;
+            size_t nByteSize;
+            std::list<Key>::iterator itLRUKey;
+        };
+        /// evicts least recently used entries until the total byte size fits in the given budget (mutex must be held)
+        void evict(size_t nMaxByteSize);
+        mutable std::mutex m_oMutex;
+        size_t m_nMaxByteSize,m_nByteSize,m_nHitCount,m_nMissCount;
+        /// keys ordered by last use (front = most recently used), and cached entries
+        std::list<Key> m_lLRUKeys;
+        std::map<Key,Entry> m_mEntries;
+    };
+
+} // namespace lv
 
 struct IIEdgeDetector : public cv::Algorithm {
 
@@ -28,14 +112,29 @@ struct IIEdgeDetector : public cv::Algorithm {
     virtual void apply_threshold(cv::InputArray oInputImage, cv::OutputArray oEdgeMask, double dThreshold) = 0;
     /// edge detection function; performs a full sensitivty sweep and returns a non-binary (grayscale confidence) edge map
     virtual void apply(cv::InputArray oInputImage, cv::OutputArray oEdgeMask) = 0;
+    /// batch edge detection function; fills one edge mask per input image, processing images grouped by size so internal buffers are reused (threshold<0 = full sensitivity sweep)
+    virtual void applyBatch(const std::vector<cv::Mat>& vInputImages, std::vector<cv::Mat>& vEdgeMasks, double dThreshold=-1);
+    /// sets the stage cache used to memoize threshold-independent stages across 'apply' calls (null = disabled; only used by impls that support it)
+    void setStageCache(const std::shared_ptr<lv::EdgeDetectorStageCache>& pStageCache) {m_pStageCache = pStageCache;}
+    /// returns the stage cache used to memoize threshold-independent stages (null if disabled)
+    const std::shared_ptr<lv::EdgeDetectorStageCache>& getStageCache() const {return m_pStageCache;}
+    /// sets the id of the image passed to the next 'apply' calls, used to key stage cache entries (size_t(-1) = unknown image, never cached)
+    void setStageCacheImageID(size_t nImageID) {m_nStageCacheImageID = nImageID;}
     /// required for derived class destruction from this interface
     virtual ~IIEdgeDetector() {}
 
 protected:
     /// default impl constructor (for common parameters only -- none must be const to avoid constructor hell when deriving)
     IIEdgeDetector();
+    /// returns the batch image indices sorted by size class (stable, so same-size images keep their relative order)
+    static std::vector<size_t> getBatchSizeOrder(const std::vector<cv::Mat>& vInputImages);
+    /// returns whether the stage cache can be used for the next 'apply' call (i.e. whether a cache is set & the image id is known)
+    bool isUsingStageCache() const {return m_pStageCache && m_nStageCacheImageID!=size_t(-1);}
     /// ROI border size to be ignored, useful for descriptor-based methods
     size_t m_nROIBorderSize;
+    /// stage cache used to memoize threshold-independent stages (null if disabled), and id of the next input image
+    std::shared_ptr<lv::EdgeDetectorStageCache> m_pStageCache;
+    size_t m_nStageCacheImageID;
 private:
     IIEdgeDetector& operator=(const IIEdgeDetector&) = delete;
     IIEdgeDetector(const IIEdgeDetector&) = delete;
@@ -65,6 +164,8 @@ struct IEdgeDetector_<lv::GLSL> :
     virtual void apply_threshold(cv::InputArray oNextImage, cv::OutputArray oLastEdgeMask, double dThreshold) override final;
     /// overloads 'apply' from IIEdgeDetector and redirects it to apply_gl (with threshold = -1)
     virtual void apply(cv::InputArray oNextImage, cv::OutputArray oLastEdgeMask) override final;
+    /// overloads 'applyBatch' from IIEdgeDetector; all images must match the initialization size, and outputs are realigned w/ their inputs (the pipeline is flushed once at the end)
+    virtual void applyBatch(const std::vector<cv::Mat>& vInputImages, std::vector<cv::Mat>& vEdgeMasks, double dThreshold=-1) override;
 
 protected:
     /// glsl impl constructor
@@ -31,9 +31,12 @@
 #define EDGCANNY_DEFAULT_HYST_LOW_THRSH_FACT (0.4)
 /// defines the default value for EdgeDetectorCanny::m_dGaussianKernelSigma
 #define EDGCANNY_DEFAULT_GAUSSIAN_KERNEL_SIGMA (sqrt(2.0))
+/// defines the default number of threads used for non-max suppression and hysteresis (1 = sequential)
+#define EDGCANNY_DEFAULT_THREAD_COUNT (1)
 
 /*!
-    Canny edge detection algorithm (wraps the OpenCV implementation).
+    Canny edge detection algorithm (Sobel gradients + non-max suppression, following the OpenCV
+    implementation, with row-tiled connected-component hysteresis).
 
     Only available in non-parallel version.
 
@@ -47,12 +50,39 @@ struct EdgeDetectorCanny : public IEdgeDetector {
     virtual double getDefaultThreshold() const {return EDGCANNY_DEFAULT_THRESHOLD;}
     /// thresholded edge detection function; the threshold should be between 0 and 1 (will use default otherwise), and sets the base hysteresis threshold
     virtual void apply_threshold(cv::InputArray oInputImage, cv::OutputArray oEdgeMask, double dThreshold=EDGCANNY_DEFAULT_THRESHOLD);
-    /// edge detection function; returns a confidence edge mask (0-255) instead of a thresholded/binary edge mask
+    /// edge detection function; returns a confidence edge mask (0-255) instead of a thresholded/binary edge mask (single-pass sweep over all thresholds)
     virtual void apply(cv::InputArray oInputImage, cv::OutputArray oEdgeMask);
+    /// sets the number of threads used for non-max suppression and hysteresis by row tiles (1 = sequential; 0 = one per hardware thread)
+    void setThreadCount(size_t nThreads);
+    /// returns the number of threads used for non-max suppression and hysteresis
+    size_t getThreadCount() const {return m_pThreadPool?m_pThreadPool->getThreadCount():size_t(1);}
 
 protected:
+    /// computes the (optionally blurred) grayscale gradient maps of the input image in a single row-streaming pass (blur fused w/ sobel), or reuses them from the stage cache
+    void apply_internal_gradient(const cv::Mat& oInputImg);
+    /// fills the hysteresis label map from the gradient maps using non-max suppression and the given thresholds
+    void apply_internal_nms(double dLowThreshold, double dHighThreshold);
     /// base threshold multiplier used to compute the upper hysteresis threshold
     const double m_dHystLowThrshFactor;
     /// gaussian blur kernel sigma value
     const double m_dGaussianKernelSigma;
+    /// combined (gaussian blur + sobel) separable derivative/smoothing kernels
+    std::vector<float> m_vfGradDerivKernel,m_vfGradSmoothKernel;
+    /// pre-allocated per-row-band rolling buffers of horizontally filtered rows used for gradient computation
+    std::vector<float> m_vfGradRingBufferData;
+    /// pre-allocated horizontal/vertical sobel gradient maps (16S)
+    cv::Mat m_oGradXMap,m_oGradYMap;
+    /// pre-allocated gradient magnitude map (32F)
+    cv::Mat m_oGradMagMap;
+    /// pre-allocated hysteresis label map (8U, see lv::HystLabel)
+    cv::Mat m_oLabelMap;
+    /// connected-component hysteresis helper (reuses its label buffers across calls)
+    lv::ConnectedHysteresis m_oHysteresis;
+    /// worker pool used for tiled non-max suppression and hysteresis (null if sequential)
+    std::unique_ptr<lv::ThreadPool> m_pThreadPool;
+    /// pre-allocated sweep maps (per-pixel low threshold pass levels, and resulting survival levels) used in 'apply'
+    cv::Mat m_oSweepPassLevelMap,m_oSweepLevelMap;
+    /// per-call scratch arena (reset at the end of each 'apply' call) and its matrix allocator adapter
+    lv::FrameArena m_oFrameArena;
+    cv::ArenaMatAllocator m_oFrameArenaAllocator;
 };
@@ -28,19 +28,107 @@
 #define EDGLBSP_DEFAULT_DET_THRESHOLD_INTEGER (LBSP::MAX_GRAD_MAG/2)
 /// defines the default value for the threshold passed to EdgeDetectorLBSP::apply_threshold
 #define EDGLBSP_DEFAULT_DET_THRESHOLD ((double)EDGLBSP_DEFAULT_DET_THRESHOLD_INTEGER/LBSP::MAX_GRAD_MAG)
+/// defines the default number of threads used for pyramid lookup construction (1 = sequential)
+#define EDGLBSP_DEFAULT_THREAD_COUNT (1)
 
-class EdgeDetectorLBSP : public IEdgeDetector {
+#define EDGLBSP_GLSL_USE_TIMERS 0
+
+template<lv::ParallelAlgoType eImpl>
+struct EdgeDetectorLBSP_;
+
+#if HAVE_GLSL
+template<>
+struct EdgeDetectorLBSP_<lv::GLSL> : public IEdgeDetector_GLSL {
+    /// full constructor
+    EdgeDetectorLBSP_(size_t nLevels=EDGLBSP_DEFAULT_LEVEL_COUNT,
+                      double dHystLowThrshFactor=EDGLBSP_DEFAULT_HYST_LOW_THRSH_FACT);
+    /// returns the default edge detection threshold value used in 'apply_threshold'
+    virtual double getDefaultThreshold() const override {return EDGLBSP_DEFAULT_DET_THRESHOLD;}
+    /// (re)initialization method; needs to be called before starting edge detection (input must be 8UC1 or 8UC4)
+    virtual void initialize_gl(const cv::Mat& oInitInput, const cv::Mat& oROI) override;
+    /// returns the GLSL compute shader source code to run for a given algo stage
+    virtual std::string getComputeShaderSource(size_t nStage) const override;
+    /// returns the number of propagation dispatches used by the hysteresis stage of the latest 'apply_gl' call
+    size_t getLastHysteresisIterCount() const {return m_nLastHystIterCount;}
+
+protected:
+    /// number of pyramid levels to analyze
+    const size_t m_nPyrLevels;
+    /// base threshold multiplier used to compute the upper hysteresis threshold
+    const double m_dHystLowThrshFactor;
+    /// number of channels in the input images (1 or 4)
+    size_t m_nImgChannels;
+    /// multi-level image map size lookup list
+    std::vector<cv::Size> m_voMapSizeList;
+    /// horizontal offset of each pyramid level (past the first) in the pyramid atlas texture
+    std::vector<int> m_vnPyrAtlasOffsets;
+    /// pyramid atlas texture (all levels except the input, side by side), packed gradient texture, and packed hysteresis level texture
+    std::unique_ptr<GLTexture2D> m_pPyrAtlasTexture,m_pGradTexture,m_pLevelTexture;
+    /// number of propagation dispatches used by the latest hysteresis stage
+    size_t m_nLastHystIterCount;
+    /// returns the GLSL compute shader source code used to build the given pyramid level from the previous one
+    std::string getComputeShaderSource_Pyramid(size_t nLevel) const;
+    /// returns the GLSL compute shader source code used to reconstruct the multi-scale gradient map
+    std::string getComputeShaderSource_Gradient() const;
+    /// returns the GLSL compute shader source code used for non-max suppression & hysteresis level initialization
+    std::string getComputeShaderSource_NMS() const;
+    /// returns the GLSL compute shader source code used for (iterative) hysteresis level propagation
+    std::string getComputeShaderSource_Hysteresis() const;
+    /// returns the GLSL compute shader source code used to write the final (binary or confidence) edge mask
+    std::string getComputeShaderSource_Output() const;
+    /// custom dispatch call function to bind internal images, adjust workgroup counts & loop the hysteresis stage until convergence
+    virtual void dispatch(size_t nStage, GLShader& oShader) override;
+    enum LBSPEdgeImageBindingList {
+        LBSPEdgeImage_PyrAtlasBinding = GLImageProcAlgo::nImageDefaultBindingsCount,
+        LBSPEdgeImage_GradBinding,
+        LBSPEdgeImage_LevelBinding,
+        nLBSPEdgeImageBindingsCount
+    };
+    enum LBSPEdgeAtomicCounterBufferBindingList {
+        LBSPEdgeAtomicCounterBuffer_HystUpdateBinding = GLImageProcAlgo::nAtomicCounterBufferDefaultBindingsCount,
+        nLBSPEdgeAtomicCounterBufferBindingsCount
+    };
+};
+
+using EdgeDetectorLBSP_GLSL = EdgeDetectorLBSP_<lv::GLSL>;
+#endif //HAVE_GLSL
+
+#if HAVE_CUDA
+// EdgeDetectorLBSP_<lv::CUDA> will not compile here, missing impl
+#endif //HAVE_CUDA
+
+#if HAVE_OPENCL
+// EdgeDetectorLBSP_<lv::OpenCL> will not compile here, missing impl
+#endif //HAVE_OPENCL
+
+template<>
+struct EdgeDetectorLBSP_<lv::NonParallel> : public IEdgeDetector {
 public:
     /// full constructor
-    EdgeDetectorLBSP(size_t nLevels=EDGLBSP_DEFAULT_LEVEL_COUNT,
-                     double dHystLowThrshFactor=EDGLBSP_DEFAULT_HYST_LOW_THRSH_FACT,
-                     bool bNormalizeOutput=false);
+    EdgeDetectorLBSP_(size_t nLevels=EDGLBSP_DEFAULT_LEVEL_COUNT,
+                      double dHystLowThrshFactor=EDGLBSP_DEFAULT_HYST_LOW_THRSH_FACT,
+                      bool bNormalizeOutput=false);
     /// returns the default edge detection threshold value used in 'apply'
     virtual double getDefaultThreshold() const {return EDGLBSP_DEFAULT_DET_THRESHOLD;}
     /// thresholded edge detection function; the edge detection threshold should be between 0 and 1 (will use default otherwise)
     virtual void apply_threshold(cv::InputArray oInputImage, cv::OutputArray oEdgeMask, double dDetThreshold=EDGLBSP_DEFAULT_DET_THRESHOLD);
     /// edge detection function; returns a confidence edge mask (0-255) instead of a thresholded/binary edge mask
     virtual void apply(cv::InputArray oInputImage, cv::OutputArray oEdgeMask);
+    /// edge detection function w/ oriented output; also fills the gradient orientation map (32FC1, radians, atan2(gy,gx)) and the sub-pixel edge offset map
+    /// (32FC2, (dx,dy) along the gradient axis, zero for non-edge pixels) from the gradients computed in the same pass (threshold<0 = confidence sweep; not tiled)
+    void apply_oriented(cv::InputArray oInputImage, cv::OutputArray oEdgeMask, cv::OutputArray oOrientMap, cv::OutputArray oSubPixOffsetMap, double dDetThreshold=-1);
+    /// batch edge detection function; without tiling, size-sorted image groups are split across per-thread detectors (each reusing its own buffers)
+    virtual void applyBatch(const std::vector<cv::Mat>& vInputImages, std::vector<cv::Mat>& vEdgeMasks, double dThreshold=-1) override;
+    /// sets the number of threads used to build each pyramid level's lookup maps by row bands and to run hysteresis by row tiles (1 = sequential; 0 = one per hardware thread)
+    void setThreadCount(size_t nThreads);
+    /// returns the number of threads used to build each pyramid level's lookup maps
+    size_t getThreadCount() const {return m_pThreadPool?m_pThreadPool->getThreadCount():size_t(1);}
+    /// sets the (square) tile size used to process large images by overlapping tiles with bounded memory (0 = whole image at once); tiles run in parallel if threads are available
+    void setTileSize(size_t nTileSize);
+    /// returns the tile size used to process large images (0 = whole image at once)
+    size_t getTileSize() const {return m_nTileSize;}
+    /// returns the tile halo size (in pixels) needed for gradients & non-max suppression to match the whole-image results at tile borders
+    size_t getTileHaloSize() const;
 
 protected:
 
@@ -56,21 +144,52 @@ protected:
     std::vector<std::aligned_vector<uchar,32>> m_vvuInputPyrMaps;
     /// pre-allocated image pyramid LUT maps for multi-scale LBSP computation
     std::vector<std::aligned_vector<uchar,32>> m_vvuLBSPLookupMaps;
+    /// per-level flat tile flags (filled during lookup); tiles whose gradients are all null skip lookup & gradient computations
+    std::vector<std::vector<uchar>> m_vvuFlatTileMaps;
     /// pre-allocated image gradient reconstruction map
     std::aligned_vector<uchar,32> m_vuLBSPGradMapData;
     /// pre-allocated image edge reconstruction map
     std::aligned_vector<uchar,32> m_vuEdgeTempMaskData;
     /// multi-level image map size lookup list
     std::vector<cv::Size> m_voMapSizeList;
-    /// hysteresis recursive search stack
-    std::vector<uchar*> m_vuHystStack;
+    /// pre-allocated oriented non-max suppression row mask
+    std::vector<uchar> m_vuNMSMaxMask;
+    /// connected-component hysteresis helper (reuses its label buffers across calls)
+    lv::ConnectedHysteresis m_oHysteresis;
+    /// pre-allocated sweep maps (per-pixel low/high threshold pass levels, and resulting survival levels) used in 'apply'
+    cv::Mat m_oSweepPassLevelMap,m_oSweepSeedLevelMap,m_oSweepLevelMap;
+    /// worker pool used for row-band lookup construction and tiled hysteresis (null if sequential)
+    std::unique_ptr<lv::ThreadPool> m_pThreadPool;
+    /// pre-allocated blurred input image (only used if the gaussian kernel sigma is positive)
+    cv::Mat m_oBlurredInputImg;
+    /// tile size used to process large images (0 = whole image at once)
+    size_t m_nTileSize;
+    /// per-lane (sequential, untiled) detectors & tile buffers used in tiled & batch modes
+    std::vector<std::unique_ptr<EdgeDetectorLBSP_>> m_vpTileDetectors;
+    std::vector<cv::Mat> m_voTileInputs,m_voTileOutputs;
 
     /// internal lookup/pyramiding function w/ explicit definitions for 1 to 4 channels
     template<size_t nChannels>
     void apply_internal_lookup(const cv::Mat& oInputImg);
     void apply_internal_lookup(const cv::Mat& oInputImg, size_t nChannels);
+    /// internal gradient reconstruction & non-max suppression function (fills the edge label map) w/ explicit definitions for 1 to 4 channels
+    template<size_t nChannels>
+    void apply_internal_nms(const cv::Mat& oInputImg, uchar nDetThreshold);
+    void apply_internal_nms(const cv::Mat& oInputImg, uchar nDetThreshold, size_t nChannels);
+    /// internal non-max suppression function using an already computed gradient map (fills the edge label map like 'apply_internal_nms')
+    void apply_internal_nms_labels(const cv::Size& oInputSize, uchar nDetThreshold);
+    /// runs the lookup/pyramiding, gradient & nms stages (fills the gradient & edge label maps), reusing the gradient map from the stage cache if possible
+    void apply_internal_stages(const cv::Mat& oInputImg, uchar nDetThreshold);
+    /// returns the (unpadded) edge label map view filled by the last 'apply_internal_nms' call (see lv::HystLabel)
+    cv::Mat getEdgeLabelMap(const cv::Size& oInputSize);
     /// internal thresholding function w/ explicit definitions for 1 to 4 channels
     template<size_t nChannels>
     void apply_internal_threshold(const cv::Mat& oInputImg, cv::Mat& oEdgeMask, uchar nDetThreshold);
     void apply_internal_threshold(const cv::Mat& oInputImg, cv::Mat& oEdgeMask, uchar nDetThreshold, size_t nChannels);
+    /// makes sure at least nLanes per-lane (sequential, untiled) detectors are allocated
+    void initLaneDetectors(size_t nLanes);
+    /// tiled edge detection function; processes overlapping tiles (with halo) and stitches their inner regions (negative threshold = confidence mask)
+    void apply_tiled(const cv::Mat& oInputImg, cv::Mat& oEdgeMask, double dDetThreshold);
 };
+
+using EdgeDetectorLBSP = EdgeDetectorLBSP_<lv::NonParallel>;
@@ -0,0 +1,94 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/imgproc/PerspectiveWarper.hpp"
+
+/// defines the minimum area (in pixels) of the foreground blobs used for registration
+#define MMREGISTR_MIN_BLOB_AREA              100
+/// defines the maximum number of (largest) foreground blobs used for registration in each modality
+#define MMREGISTR_MAX_BLOB_COUNT             4
+/// defines the number of contour points sampled in each blob (i.e. the number of point pairs contributed by each matched blob pair)
+#define MMREGISTR_CONTOUR_SAMPLE_COUNT       32
+/// defines the number of distinct past correspondence sets kept in the estimation reservoir
+#define MMREGISTR_RESERVOIR_SIZE             100
+/// defines the blob centroid displacement (in pixels) below which a correspondence set is considered unchanged (and skipped)
+#define MMREGISTR_CHANGE_MIN_DISPLACEMENT    2.0
+/// defines the mean reprojection error (in pixels) of a new correspondence set above which the homography is re-fitted
+#define MMREGISTR_REFIT_MIN_REPROJ_ERROR     3.0
+/// defines the ransac inlier reprojection threshold (in pixels) used when re-fitting the homography
+#define MMREGISTR_RANSAC_REPROJ_THRESHOLD    3.0
+
+namespace lv {
+
+    /// bimodal (e.g. thermal/visible) video registration via foreground contour correspondences; blobs are extracted in parallel in both
+    /// modalities, matched, and their resampled contours are kept in a temporal reservoir from which the homography is estimated; the
+    /// (ransac) estimation only runs when a new correspondence set appears which the current homography does not already explain
+    struct MultimodalRegistrator {
+        /// number of modalities registered together
+        static constexpr size_t s_nModalityCount = 2;
+        /// default constructor (the homography is unknown until enough correspondences are found)
+        MultimodalRegistrator();
+        /// processes a pair of synchronized foreground masks (8UC1, non-zero is foreground); returns whether the homography was re-fitted
+        bool process(const cv::Mat& oForeground0, const cv::Mat& oForeground1);
+        /// returns the homography mapping modality #1 coords to modality #0 coords (or the inverse), or an empty matrix if not estimated yet
+        const cv::Mat& getTransform(bool bInverse=false) const {return bInverse?m_oTransform_inv:m_oTransform;}
+        /// returns a counter incremented each time the homography is re-fitted (cached warps built from older versions are stale)
+        size_t getTransformVersion() const {return m_nTransformVersion;}
+        /// returns the foreground blob contours extracted from a modality in the last call to 'process'
+        const std::vector<std::vector<cv::Point>>& getContours(size_t nModalityIdx) const;
+        /// warps a modality #0 image onto the modality #1 image plane (of size oOutputSize) using luts cached between re-fits
+        void warp(const cv::Mat& oInput, cv::Mat& oOutput, const cv::Size& oOutputSize, int nInterpFlag=cv::INTER_LINEAR, bool bCropToContent=true);
+        /// clears the correspondence reservoir and homography
+        void reset();
+    protected:
+        /// foreground blob description used for matching (contour samples start at the topmost point, and follow the contour orientation)
+        struct BlobInfo {
+            cv::Point2f oCentroid;
+            double dArea;
+            std::array<cv::Point2f,MMREGISTR_CONTOUR_SAMPLE_COUNT> aContourSamples;
+        };
+        /// set of point correspondences contributed by a single frame
+        struct CorrespSet {
+            std::vector<cv::Point2f> vPts0,vPts1;
+        };
+        /// extracts & describes the largest foreground blobs of a modality (called concurrently for all modalities)
+        void extractBlobs(size_t nModalityIdx, const cv::Mat& oForeground);
+        /// pairs the blobs of both modalities (via the current homography if available), and fills oCorresp with their contour samples
+        bool matchBlobs(CorrespSet& oCorresp) const;
+        /// returns whether the (matched) blob centroids moved enough since the last accepted correspondence set
+        bool isNewCorrespSet(const CorrespSet& oCorresp) const;
+        /// returns the mean reprojection error of a correspondence set under the current homography
+        double getReprojError(const CorrespSet& oCorresp) const;
+        /// re-fits the homography on the full reservoir; returns whether a valid homography was found
+        bool refitTransform();
+        lv::WorkerPool<s_nModalityCount> m_oWorkerPool;
+        lv::CountdownLatch m_oWorkerLatch;
+        std::array<cv::Mat,s_nModalityCount> m_aoForegroundBuffers;
+        std::array<std::vector<std::vector<cv::Point>>,s_nModalityCount> m_avvoContours;
+        std::array<std::vector<BlobInfo>,s_nModalityCount> m_avoBlobs;
+        std::deque<CorrespSet> m_qoReservoir;
+        std::vector<cv::Point2f> m_vLastCentroids0,m_vLastCentroids1;
+        CorrespSet m_oCurrCorresp,m_oReservoirPts;
+        cv::Mat m_oTransform,m_oTransform_inv;
+        cv::Matx33d m_oTransformMatx;
+        size_t m_nTransformVersion;
+        std::array<lv::PerspectiveWarper,2> m_aoWarpers; ///< one per interpolation type (nearest, linear)
+    };
+
+} // namespace lv
@@ -0,0 +1,50 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/utils/opencv.hpp"
+
+namespace lv {
+
+    /// perspective warper w/ cached fixed-point remap luts; luts are rebuilt only when the homography/output size changes, and only the
+    /// output bounding region of the input's non-zero content is remapped (equivalent to cv::warpPerspective w/ a constant zero border)
+    struct PerspectiveWarper {
+        /// default constructor (a transform must be set before calling 'apply')
+        PerspectiveWarper();
+        /// sets the homography & output size; uses the cv::warpPerspective convention (oHomography maps output->input if nFlags has cv::WARP_INVERSE_MAP)
+        void setTransform(const cv::Mat& oHomography, const cv::Size& oOutputSize, int nFlags=cv::INTER_LINEAR);
+        /// warps oInput into oOutput using the cached luts; if bCropToContent is set (and the input is 8U), only the projected non-zero content region is remapped
+        void apply(const cv::Mat& oInput, cv::Mat& oOutput, bool bCropToContent=true);
+        /// returns whether a transform was already set
+        bool isInitialized() const {return !m_oMapXY.empty();}
+    protected:
+        /// output->input homography used to build the luts
+        cv::Matx33d m_oHomography_inv;
+        /// input->output homography used to project the non-zero content region
+        cv::Matx33d m_oHomography;
+        /// output size of the cached luts
+        cv::Size m_oOutputSize;
+        /// interpolation flag used for remapping (cv::INTER_NEAREST or cv::INTER_LINEAR)
+        int m_nInterpFlag;
+        /// cached fixed-point remap luts (16SC2 integer coords + 16UC1 interpolation table indices, the latter empty for nearest interp)
+        cv::Mat m_oMapXY,m_oMapInterp;
+        /// pre-allocated floating point luts used during rebuilds
+        cv::Mat m_oMapX,m_oMapY;
+    };
+
+} // namespace lv
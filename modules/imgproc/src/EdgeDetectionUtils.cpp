@@ -17,8 +17,299 @@
 
 #include "litiv/imgproc/EdgeDetectionUtils.hpp"
 
+#define HYST_TILE_ROW_COUNT 32 // number of rows labeled per parallel hysteresis task
+
+namespace {
+
+    /// returns the root of a union-find tree (with path halving; parents always have lower indices)
+    inline int findRoot(int* anLabels, int nIdx) {
+        while(anLabels[nIdx]!=nIdx)
+            nIdx = anLabels[nIdx] = anLabels[anLabels[nIdx]];
+        return nIdx;
+    }
+
+    /// merges two union-find trees, keeping the lowest index as root
+    inline void mergeRoots(int* anLabels, int nIdxA, int nIdxB) {
+        const int nRootA = findRoot(anLabels,nIdxA);
+        const int nRootB = findRoot(anLabels,nIdxB);
+        if(nRootA<nRootB)
+            anLabels[nRootB] = nRootA;
+        else if(nRootB<nRootA)
+            anLabels[nRootA] = nRootB;
+    }
+
+} // anonymous namespace
+
+void lv::ConnectedHysteresis::apply(const cv::Mat& oLabelMap, cv::Mat& oEdgeMask, lv::ThreadPool* pThreadPool) {
+    lvAssert_(!oLabelMap.empty() && oLabelMap.type()==CV_8UC1,"label map must be non-empty and of type 8UC1");
+    lvAssert_(oEdgeMask.size()==oLabelMap.size() && oEdgeMask.type()==CV_8UC1,"edge mask must be allocated with the label map size and of type 8UC1");
+    lvAssert_(oLabelMap.total()<size_t(INT_MAX),"label map is too large for 32-bit labels");
+    const int nRows = oLabelMap.rows, nCols = oLabelMap.cols;
+    m_vnLabels.resize(oLabelMap.total());
+    m_vuRootFlags.resize(oLabelMap.total());
+    int* const anLabels = m_vnLabels.data();
+    const size_t nTiles = (size_t(nRows)+HYST_TILE_ROW_COUNT-1)/HYST_TILE_ROW_COUNT;
+    const auto lDispatch = [&](const std::function<void(size_t)>& lTask) {
+        if(pThreadPool && nTiles>1)
+            pThreadPool->parallel_for(nTiles,lTask);
+        else
+            for(size_t nTileIdx=0; nTileIdx<nTiles; ++nTileIdx)
+                lTask(nTileIdx);
+    };
+    const auto lMergeUpperRow = [&](int nRowIter, int nColIter) {
+        const int nIdx = nRowIter*nCols+nColIter;
+        const int* const anPrevRow = anLabels+(nRowIter-1)*nCols;
+        for(int nOffset=-1; nOffset<=1; ++nOffset)
+            if(nColIter+nOffset>=0 && nColIter+nOffset<nCols && anPrevRow[nColIter+nOffset]>=0)
+                mergeRoots(anLabels,nIdx,nIdx-nCols+nOffset);
+    };
+    // first pass: local labeling inside each row tile (trees never leave their tile here)
+    lDispatch([&](size_t nTileIdx) {
+        const int nRowBegin = int(nTileIdx*HYST_TILE_ROW_COUNT);
+        const int nRowEnd = std::min(nRowBegin+HYST_TILE_ROW_COUNT,nRows);
+        for(int nRowIter=nRowBegin; nRowIter<nRowEnd; ++nRowIter) {
+            const uchar* const anLabelRow = oLabelMap.ptr<uchar>(nRowIter);
+            int* const anCurrRow = anLabels+nRowIter*nCols;
+            for(int nColIter=0; nColIter<nCols; ++nColIter) {
+                if(anLabelRow[nColIter]==HystLabel_NotEdge) {
+                    anCurrRow[nColIter] = -1;
+                    continue;
+                }
+                const int nIdx = nRowIter*nCols+nColIter;
+                anCurrRow[nColIter] = nIdx;
+                if(nColIter>0 && anCurrRow[nColIter-1]>=0)
+                    mergeRoots(anLabels,nIdx,nIdx-1);
+                if(nRowIter>nRowBegin)
+                    lMergeUpperRow(nRowIter,nColIter);
+            }
+        }
+    });
+    // second pass: merge trees across tile borders (only one row per tile, kept sequential)
+    for(size_t nTileIdx=1; nTileIdx<nTiles; ++nTileIdx) {
+        const int nRowIter = int(nTileIdx*HYST_TILE_ROW_COUNT);
+        for(int nColIter=0; nColIter<nCols; ++nColIter)
+            if(anLabels[nRowIter*nCols+nColIter]>=0)
+                lMergeUpperRow(nRowIter,nColIter);
+    }
+    // third pass: flatten in raster order (parents precede children) and flag components containing an edge
+    uchar* const auRootFlags = m_vuRootFlags.data();
+    for(int nRowIter=0; nRowIter<nRows; ++nRowIter) {
+        const uchar* const anLabelRow = oLabelMap.ptr<uchar>(nRowIter);
+        int* const anCurrRow = anLabels+nRowIter*nCols;
+        for(int nColIter=0; nColIter<nCols; ++nColIter) {
+            const int nParent = anCurrRow[nColIter];
+            if(nParent<0)
+                continue;
+            if(nParent==nRowIter*nCols+nColIter)
+                auRootFlags[nParent] = uchar(anLabelRow[nColIter]==HystLabel_Edge);
+            else {
+                const int nRoot = anCurrRow[nColIter] = anLabels[nParent];
+                auRootFlags[nRoot] |= uchar(anLabelRow[nColIter]==HystLabel_Edge);
+            }
+        }
+    }
+    lDispatch([&](size_t nTileIdx) {
+        const int nRowBegin = int(nTileIdx*HYST_TILE_ROW_COUNT);
+        const int nRowEnd = std::min(nRowBegin+HYST_TILE_ROW_COUNT,nRows);
+        for(int nRowIter=nRowBegin; nRowIter<nRowEnd; ++nRowIter) {
+            const int* const anCurrRow = anLabels+nRowIter*nCols;
+            uchar* const anEdgeMaskRow = oEdgeMask.ptr<uchar>(nRowIter);
+            for(int nColIter=0; nColIter<nCols; ++nColIter)
+                anEdgeMaskRow[nColIter] = (anCurrRow[nColIter]>=0 && auRootFlags[anCurrRow[nColIter]])?UCHAR_MAX:0;
+        }
+    });
+}
+
+void lv::ConnectedHysteresis::sweep(const cv::Mat& oLabelMap, const cv::Mat& oPassLevelMap, const cv::Mat& oSeedLevelMap, cv::Mat& oLevelMap) {
+    lvAssert_(!oLabelMap.empty() && oLabelMap.type()==CV_8UC1,"label map must be non-empty and of type 8UC1");
+    lvAssert_(oPassLevelMap.size()==oLabelMap.size() && oPassLevelMap.type()==CV_32FC1 && oPassLevelMap.isContinuous(),"pass level map must be continuous, of type 32FC1, and match the label map size");
+    lvAssert_(oSeedLevelMap.size()==oLabelMap.size() && oSeedLevelMap.type()==CV_32FC1 && oSeedLevelMap.isContinuous(),"seed level map must be continuous, of type 32FC1, and match the label map size");
+    lvAssert_(oLabelMap.total()<size_t(INT_MAX),"label map is too large for 32-bit labels");
+    // pixels are added by descending pass level; a component 'resolves' once the sweep level drops to its best seed level, after
+    // which all of its (pending and future) members get the level at which they join it, and unresolved ones end at their best seed
+    const int nRows = oLabelMap.rows, nCols = oLabelMap.cols;
+    const size_t nPixels = oLabelMap.total();
+    const float* const afPassLevels = oPassLevelMap.ptr<float>(0);
+    const float* const afSeedLevels = oSeedLevelMap.ptr<float>(0);
+    oLevelMap.create(oLabelMap.size(),CV_32FC1);
+    oLevelMap = -1.0f;
+    float* const afLevels = oLevelMap.ptr<float>(0);
+    m_vnSweepOrder.clear();
+    for(int nRowIter=0; nRowIter<nRows; ++nRowIter) {
+        const uchar* const anLabelRow = oLabelMap.ptr<uchar>(nRowIter);
+        for(int nColIter=0; nColIter<nCols; ++nColIter)
+            if(anLabelRow[nColIter]!=HystLabel_NotEdge)
+                m_vnSweepOrder.push_back(nRowIter*nCols+nColIter);
+    }
+    std::sort(m_vnSweepOrder.begin(),m_vnSweepOrder.end(),[&](int a, int b){return afPassLevels[a]>afPassLevels[b];});
+    m_vnLabels.assign(nPixels,-1);
+    m_vnSweepPendingNext.resize(nPixels);
+    m_vSweepRoots.resize(nPixels);
+    int* const anParents = m_vnLabels.data();
+    const auto lResolvePending = [&](SweepRoot& oRoot, float fLevel) {
+        for(int nIdx=oRoot.nPendingHead; nIdx>=0; nIdx=m_vnSweepPendingNext[nIdx])
+            afLevels[nIdx] = fLevel;
+        oRoot.nPendingHead = oRoot.nPendingTail = -1;
+    };
+    for(const int nIdx : m_vnSweepOrder) {
+        const float fLevel = afPassLevels[nIdx];
+        anParents[nIdx] = nIdx;
+        m_vnSweepPendingNext[nIdx] = -1;
+        m_vSweepRoots[nIdx] = SweepRoot{std::min(afSeedLevels[nIdx],fLevel),nIdx,nIdx,false};
+        const int nRowIter = nIdx/nCols, nColIter = nIdx%nCols;
+        int nRoot = nIdx;
+        for(int nRowOffset=-1; nRowOffset<=1; ++nRowOffset) {
+            for(int nColOffset=-1; nColOffset<=1; ++nColOffset) {
+                if((!nRowOffset && !nColOffset) || nRowIter+nRowOffset<0 || nRowIter+nRowOffset>=nRows || nColIter+nColOffset<0 || nColIter+nColOffset>=nCols)
+                    continue;
+                const int nNeighbIdx = nIdx+nRowOffset*nCols+nColOffset;
+                if(anParents[nNeighbIdx]<0)
+                    continue;
+                const int nNeighbRoot = findRoot(anParents,nNeighbIdx);
+                if(nNeighbRoot==nRoot)
+                    continue;
+                SweepRoot& oRoot = m_vSweepRoots[nRoot];
+                SweepRoot& oNeighbRoot = m_vSweepRoots[nNeighbRoot];
+                if(!oNeighbRoot.bResolved && oNeighbRoot.fMaxSeedLevel>=fLevel) {
+                    // the sweep already passed this component's best seed without any merge, so its members survived up to that seed
+                    lResolvePending(oNeighbRoot,oNeighbRoot.fMaxSeedLevel);
+                    oNeighbRoot.bResolved = true;
+                }
+                oRoot.fMaxSeedLevel = std::max(oRoot.fMaxSeedLevel,oNeighbRoot.fMaxSeedLevel);
+                oRoot.bResolved |= oNeighbRoot.bResolved;
+                if(oNeighbRoot.nPendingHead>=0) {
+                    if(oRoot.nPendingHead>=0)
+                        m_vnSweepPendingNext[oRoot.nPendingTail] = oNeighbRoot.nPendingHead;
+                    else
+                        oRoot.nPendingHead = oNeighbRoot.nPendingHead;
+                    oRoot.nPendingTail = oNeighbRoot.nPendingTail;
+                }
+                anParents[nNeighbRoot] = nRoot;
+            }
+        }
+        SweepRoot& oRoot = m_vSweepRoots[nRoot];
+        oRoot.bResolved |= oRoot.fMaxSeedLevel>=fLevel;
+        if(oRoot.bResolved)
+            lResolvePending(oRoot,fLevel);
+    }
+    // unresolved components only survive up to their own best seed
+    for(const int nIdx : m_vnSweepOrder)
+        if(anParents[nIdx]==nIdx && !m_vSweepRoots[nIdx].bResolved)
+            lResolvePending(m_vSweepRoots[nIdx],m_vSweepRoots[nIdx].fMaxSeedLevel);
+}
+
+lv::EdgeDetectorStageCache::EdgeDetectorStageCache(size_t nMaxByteSize) :
+        m_nMaxByteSize(nMaxByteSize),
+        m_nByteSize(0),
+        m_nHitCount(0),
+        m_nMissCount(0) {}
+
+std::shared_ptr<const lv::EdgeDetectorStageCache::StageData> lv::EdgeDetectorStageCache::get(const Key& oKey) {
+    std::mutex_lock_guard oLock(m_oMutex);
+    auto itEntry = m_mEntries.find(oKey);
+    if(itEntry==m_mEntries.end()) {
+        ++m_nMissCount;
+        return nullptr;
+    }
+    ++m_nHitCount;
+    m_lLRUKeys.splice(m_lLRUKeys.begin(),m_lLRUKeys,itEntry->second.itLRUKey);
+    return itEntry->second.pData;
+}
+
+void lv::EdgeDetectorStageCache::put(const Key& oKey, const StageData& vData) {
+    size_t nByteSize = 0;
+    for(const cv::Mat& oMat : vData)
+        nByteSize += oMat.total()*oMat.elemSize();
+    if(nByteSize>m_nMaxByteSize)
+        return;
+    // deep copies are made outside the lock, as they are the expensive part
+    auto pData = std::make_shared<StageData>(vData.size());
+    for(size_t nMatIdx=0; nMatIdx<vData.size(); ++nMatIdx)
+        (*pData)[nMatIdx] = vData[nMatIdx].clone();
+    std::mutex_lock_guard oLock(m_oMutex);
+    auto itEntry = m_mEntries.find(oKey);
+    if(itEntry!=m_mEntries.end()) {
+        m_nByteSize -= itEntry->second.nByteSize;
+        m_lLRUKeys.erase(itEntry->second.itLRUKey);
+        m_mEntries.erase(itEntry);
+    }
+    evict(m_nMaxByteSize-nByteSize);
+    m_lLRUKeys.push_front(oKey);
+    m_mEntries.emplace(oKey,Entry{std::move(pData),nByteSize,m_lLRUKeys.begin()});
+    m_nByteSize += nByteSize;
+}
+
+void lv::EdgeDetectorStageCache::clear() {
+    std::mutex_lock_guard oLock(m_oMutex);
+    m_mEntries.clear();
+    m_lLRUKeys.clear();
+    m_nByteSize = m_nHitCount = m_nMissCount = 0;
+}
+
+void lv::EdgeDetectorStageCache::setMaxByteSize(size_t nMaxByteSize) {
+    std::mutex_lock_guard oLock(m_oMutex);
+    m_nMaxByteSize = nMaxByteSize;
+    evict(m_nMaxByteSize);
+}
+
+size_t lv::EdgeDetectorStageCache::getMaxByteSize() const {
+    std::mutex_lock_guard oLock(m_oMutex);
+    return m_nMaxByteSize;
+}
+
+size_t lv::EdgeDetectorStageCache::getByteSize() const {
+    std::mutex_lock_guard oLock(m_oMutex);
+    return m_nByteSize;
+}
+
+size_t lv::EdgeDetectorStageCache::getHitCount() const {
+    std::mutex_lock_guard oLock(m_oMutex);
+    return m_nHitCount;
+}
+
+size_t lv::EdgeDetectorStageCache::getMissCount() const {
+    std::mutex_lock_guard oLock(m_oMutex);
+    return m_nMissCount;
+}
+
+void lv::EdgeDetectorStageCache::evict(size_t nMaxByteSize) {
+    while(m_nByteSize>nMaxByteSize && !m_lLRUKeys.empty()) {
+        auto itEntry = m_mEntries.find(m_lLRUKeys.back());
+        lvDbgAssert(itEntry!=m_mEntries.end());
+        m_nByteSize -= itEntry->second.nByteSize;
+        m_mEntries.erase(itEntry);
+        m_lLRUKeys.pop_back();
+    }
+}
+
 IIEdgeDetector::IIEdgeDetector() :
-        m_nROIBorderSize(0) {}
+        m_nROIBorderSize(0),
+        m_nStageCacheImageID(size_t(-1)) {}
+
+void IIEdgeDetector::applyBatch(const std::vector<cv::Mat>& vInputImages, std::vector<cv::Mat>& vEdgeMasks, double dThreshold) {
+    vEdgeMasks.resize(vInputImages.size());
+    // batch images do not have individual ids, so they must never be matched with stage cache entries
+    const size_t nStageCacheImageID = m_nStageCacheImageID;
+    m_nStageCacheImageID = size_t(-1);
+    for(const size_t nImageIdx : getBatchSizeOrder(vInputImages)) {
+        if(dThreshold<0)
+            apply(vInputImages[nImageIdx],vEdgeMasks[nImageIdx]);
+        else
+            apply_threshold(vInputImages[nImageIdx],vEdgeMasks[nImageIdx],dThreshold);
+    }
+    m_nStageCacheImageID = nStageCacheImageID;
+}
+
+std::vector<size_t> IIEdgeDetector::getBatchSizeOrder(const std::vector<cv::Mat>& vInputImages) {
+    std::vector<size_t> vnImageIdxs(vInputImages.size());
+    std::iota(vnImageIdxs.begin(),vnImageIdxs.end(),size_t(0));
+    std::stable_sort(vnImageIdxs.begin(),vnImageIdxs.end(),[&](size_t nIdxA, size_t nIdxB) {
+        const cv::Mat& oImageA = vInputImages[nIdxA];
+        const cv::Mat& oImageB = vInputImages[nIdxB];
+        return std::make_tuple(oImageA.rows,oImageA.cols,oImageA.type())<std::make_tuple(oImageB.rows,oImageB.cols,oImageB.type());
+    });
+    return vnImageIdxs;
+}
 
 #if HAVE_GLSL
 
@@ -55,6 +346,18 @@ void IEdgeDetector_GLSL::apply(cv::InputArray oNextImage, cv::OutputArray oLastE
     apply_gl(oNextImage,oLastEdgeMask,false,-1);
 }
 
+void IEdgeDetector_GLSL::applyBatch(const std::vector<cv::Mat>& vInputImages, std::vector<cv::Mat>& vEdgeMasks, double dThreshold) {
+    vEdgeMasks.resize(vInputImages.size());
+    if(vInputImages.empty())
+        return;
+    // outputs lag inputs by one dispatch; the last image is submitted twice to flush its result
+    for(size_t nImageIdx=0; nImageIdx<=vInputImages.size(); ++nImageIdx) {
+        apply_gl(vInputImages[std::min(nImageIdx,vInputImages.size()-1)],false,dThreshold);
+        if(nImageIdx>0)
+            getLatestEdgeMask(vEdgeMasks[nImageIdx-1]);
+    }
+}
+
 IEdgeDetector_GLSL::IEdgeDetector_(size_t nLevels, size_t nComputeStages, size_t nExtraSSBOs, size_t nExtraACBOs,
                                    size_t nExtraImages, size_t nExtraTextures, int nDebugType, bool bUseDisplay,
                                    bool bUseTimers, bool bUseIntegralFormat) :
@@ -17,30 +17,212 @@
 
 #include "litiv/imgproc/EdgeDetectorCanny.hpp"
 
+#define NMS_TILE_ROW_COUNT 32 // number of rows processed per parallel non-max suppression task
+
 EdgeDetectorCanny::EdgeDetectorCanny(double dHystLowThrshFactor, double dGaussianKernelSigma) :
         m_dHystLowThrshFactor(dHystLowThrshFactor),
-        m_dGaussianKernelSigma(dGaussianKernelSigma) {
+        m_dGaussianKernelSigma(dGaussianKernelSigma),
+        m_oFrameArenaAllocator(m_oFrameArena) {
     lvAssert_(m_dHystLowThrshFactor>0 && m_dHystLowThrshFactor<1,"lower hysteresis threshold factor must be between 0 and 1");
     lvAssert_(m_dGaussianKernelSigma>=0,"gaussian smoothing kernel sigma must be non-negative");
-}
-
-void EdgeDetectorCanny::apply_threshold(cv::InputArray _oInputImage, cv::OutputArray _oEdgeMask, double dThreshold) {
-    cv::Mat oInputImg = _oInputImage.getMat();
-    lvAssert_(!oInputImg.empty() && (oInputImg.channels()==1 || oInputImg.channels()==3 || oInputImg.channels()==4),"input image must be non-empty, and of type 8UC1/8UC3/8UC4");
+    setThreadCount(EDGCANNY_DEFAULT_THREAD_COUNT);
+    cv::Mat oSobelDerivKernel,oSobelSmoothKernel;
+    cv::getDerivKernels(oSobelDerivKernel,oSobelSmoothKernel,1,0,EDGCANNY_SOBEL_KERNEL_SIZE,false,CV_32F);
+    cv::Mat oGaussianKernel = cv::Mat::ones(1,1,CV_32FC1);
     if(m_dGaussianKernelSigma>0) {
         // follows the approach used in Matlab's edge.m implementation of Canny's method
         const int nDefaultKernelSize = int(8*ceil(m_dGaussianKernelSigma));
         const int nRealHalfKernelSize = (nDefaultKernelSize-1)/2;
-        oInputImg = oInputImg.clone();
-        cv::GaussianBlur(oInputImg,oInputImg,cv::Size(nRealHalfKernelSize,nRealHalfKernelSize),m_dGaussianKernelSigma,m_dGaussianKernelSigma);
+        oGaussianKernel = cv::getGaussianKernel(nRealHalfKernelSize,m_dGaussianKernelSigma,CV_32F);
+    }
+    // applying the blur then the sobel filter is equivalent to a single (separable) filter with both kernels convolved
+    const auto lConvolve = [](const cv::Mat& oKernelA, const cv::Mat& oKernelB) {
+        const int nSizeA = int(oKernelA.total()), nSizeB = int(oKernelB.total());
+        std::vector<float> vfKernel(size_t(nSizeA+nSizeB-1),0.0f);
+        for(int nIterA=0; nIterA<nSizeA; ++nIterA)
+            for(int nIterB=0; nIterB<nSizeB; ++nIterB)
+                vfKernel[nIterA+nIterB] += oKernelA.ptr<float>()[nIterA]*oKernelB.ptr<float>()[nIterB];
+        return vfKernel;
+    };
+    m_vfGradDerivKernel = lConvolve(oGaussianKernel,oSobelDerivKernel);
+    m_vfGradSmoothKernel = lConvolve(oGaussianKernel,oSobelSmoothKernel);
+    lvDbgAssert(m_vfGradDerivKernel.size()==m_vfGradSmoothKernel.size() && (m_vfGradDerivKernel.size()%2)==1);
+}
+
+void EdgeDetectorCanny::setThreadCount(size_t nThreads) {
+    if(nThreads==0)
+        nThreads = std::max((size_t)std::thread::hardware_concurrency(),size_t(1));
+    if(nThreads==1)
+        m_pThreadPool = nullptr;
+    else if(!m_pThreadPool || m_pThreadPool->getThreadCount()!=nThreads)
+        m_pThreadPool = std::make_unique<lv::ThreadPool>(nThreads);
+}
+
+void EdgeDetectorCanny::apply_internal_gradient(const cv::Mat& _oInputImg) {
+    // gradients only depend on the image & blur sigma, so sweeps over thresholds/hysteresis factors can reuse them
+    const lv::EdgeDetectorStageCache::Key oCacheKey = {m_nStageCacheImageID,"canny_gradient",{m_dGaussianKernelSigma}};
+    if(isUsingStageCache()) {
+        const auto pCachedData = m_pStageCache->get(oCacheKey);
+        if(pCachedData && pCachedData->size()==3 && (*pCachedData)[2].size()==_oInputImg.size()) {
+            (*pCachedData)[0].copyTo(m_oGradXMap);
+            (*pCachedData)[1].copyTo(m_oGradYMap);
+            (*pCachedData)[2].copyTo(m_oGradMagMap);
+            return;
+        }
     }
+    cv::Mat oInputImg = _oInputImg;
+    if(oInputImg.channels()!=1) {
+        // grayscale copy only lives for this call, so it is carved from the frame arena instead of the heap
+        cv::Mat oGrayInputImg = m_oFrameArenaAllocator.create(oInputImg.size(),CV_8UC1);
+        cv::cvtColor(oInputImg,oGrayInputImg,oInputImg.channels()==3?cv::COLOR_BGR2GRAY:cv::COLOR_BGRA2GRAY);
+        oInputImg = oGrayInputImg;
+    }
+    lvDbgAssert(oInputImg.type()==CV_8UC1);
+    static const bool bUseL2Gradient = EDGCANNY_USE_L2_GRADIENT_NORM;
+    const int nRows = oInputImg.rows, nCols = oInputImg.cols;
+    const int nKernelSize = int(m_vfGradDerivKernel.size()), nKernelRadius = nKernelSize/2;
+    const float* const afDerivKernel = m_vfGradDerivKernel.data();
+    const float* const afSmoothKernel = m_vfGradSmoothKernel.data();
+    m_oGradXMap.create(oInputImg.size(),CV_16SC1);
+    m_oGradYMap.create(oInputImg.size(),CV_16SC1);
+    m_oGradMagMap.create(oInputImg.size(),CV_32FC1);
+    // each row band keeps its own rolling buffer of horizontally filtered rows (deriv + smooth), so no blurred image is ever stored
+    const size_t nTiles = (size_t(nRows)+NMS_TILE_ROW_COUNT-1)/NMS_TILE_ROW_COUNT;
+    const size_t nRingBufferSize = size_t(nKernelSize*nCols*2);
+    m_vfGradRingBufferData.resize(nTiles*nRingBufferSize);
+    const auto lHorizFilter = [&](const uchar* anInputRow, float* afDerivRow, float* afSmoothRow) {
+        const auto lBorderColFilter = [&](int nColIter) {
+            float fDerivSum = 0.0f, fSmoothSum = 0.0f;
+            for(int nKernelIter=0; nKernelIter<nKernelSize; ++nKernelIter) {
+                const float fVal = float(anInputRow[std::min(std::max(nColIter+nKernelIter-nKernelRadius,0),nCols-1)]);
+                fDerivSum += afDerivKernel[nKernelIter]*fVal;
+                fSmoothSum += afSmoothKernel[nKernelIter]*fVal;
+            }
+            afDerivRow[nColIter] = fDerivSum;
+            afSmoothRow[nColIter] = fSmoothSum;
+        };
+        int nColIter = 0;
+        for(; nColIter<std::min(nKernelRadius,nCols); ++nColIter)
+            lBorderColFilter(nColIter);
+        for(; nColIter<nCols-nKernelRadius; ++nColIter) {
+            const uchar* const anInputWin = anInputRow+nColIter-nKernelRadius;
+            float fDerivSum = 0.0f, fSmoothSum = 0.0f;
+            for(int nKernelIter=0; nKernelIter<nKernelSize; ++nKernelIter) {
+                fDerivSum += afDerivKernel[nKernelIter]*anInputWin[nKernelIter];
+                fSmoothSum += afSmoothKernel[nKernelIter]*anInputWin[nKernelIter];
+            }
+            afDerivRow[nColIter] = fDerivSum;
+            afSmoothRow[nColIter] = fSmoothSum;
+        }
+        for(; nColIter<nCols; ++nColIter)
+            lBorderColFilter(nColIter);
+    };
+    const auto lTileGradient = [&](size_t nTileIdx) {
+        const int nRowBegin = int(nTileIdx*NMS_TILE_ROW_COUNT);
+        const int nRowEnd = std::min(nRowBegin+NMS_TILE_ROW_COUNT,nRows);
+        float* const afDerivRing = m_vfGradRingBufferData.data()+nTileIdx*nRingBufferSize;
+        float* const afSmoothRing = afDerivRing+nKernelSize*nCols;
+        const auto lRingRowIdx = [&](int nRowIter) {return ((nRowIter-nRowBegin+nKernelRadius)%nKernelSize)*nCols;};
+        for(int nRowIter=nRowBegin-nKernelRadius; nRowIter<nRowEnd+nKernelRadius; ++nRowIter) {
+            // rows outside the image are replicated, as with cv::BORDER_REPLICATE
+            const uchar* const anInputRow = oInputImg.ptr<uchar>(std::min(std::max(nRowIter,0),nRows-1));
+            lHorizFilter(anInputRow,afDerivRing+lRingRowIdx(nRowIter),afSmoothRing+lRingRowIdx(nRowIter));
+            const int nOutputRowIdx = nRowIter-nKernelRadius;
+            if(nOutputRowIdx<nRowBegin)
+                continue;
+            short* const anGradXRow = m_oGradXMap.ptr<short>(nOutputRowIdx);
+            short* const anGradYRow = m_oGradYMap.ptr<short>(nOutputRowIdx);
+            float* const afGradMagRow = m_oGradMagMap.ptr<float>(nOutputRowIdx);
+            for(int nColIter=0; nColIter<nCols; ++nColIter) {
+                float fGradXSum = 0.0f, fGradYSum = 0.0f;
+                for(int nKernelIter=0; nKernelIter<nKernelSize; ++nKernelIter) {
+                    const int nRingIdx = lRingRowIdx(nOutputRowIdx-nKernelRadius+nKernelIter)+nColIter;
+                    fGradXSum += afSmoothKernel[nKernelIter]*afDerivRing[nRingIdx];
+                    fGradYSum += afDerivKernel[nKernelIter]*afSmoothRing[nRingIdx];
+                }
+                anGradXRow[nColIter] = cv::saturate_cast<short>(fGradXSum);
+                anGradYRow[nColIter] = cv::saturate_cast<short>(fGradYSum);
+                const float fGradX = float(anGradXRow[nColIter]), fGradY = float(anGradYRow[nColIter]);
+                afGradMagRow[nColIter] = bUseL2Gradient?std::sqrt(fGradX*fGradX+fGradY*fGradY):(std::abs(fGradX)+std::abs(fGradY));
+            }
+        }
+    };
+    if(m_pThreadPool && nTiles>1)
+        m_pThreadPool->parallel_for(nTiles,lTileGradient);
+    else
+        for(size_t nTileIdx=0; nTileIdx<nTiles; ++nTileIdx)
+            lTileGradient(nTileIdx);
+    if(isUsingStageCache())
+        m_pStageCache->put(oCacheKey,{m_oGradXMap,m_oGradYMap,m_oGradMagMap});
+}
+
+void EdgeDetectorCanny::apply_internal_nms(double dLowThreshold, double dHighThreshold) {
+    lvDbgAssert(!m_oGradMagMap.empty() && m_oGradMagMap.size()==m_oGradXMap.size() && m_oGradMagMap.size()==m_oGradYMap.size());
+    const int nRows = m_oGradMagMap.rows, nCols = m_oGradMagMap.cols;
+    m_oLabelMap.create(m_oGradMagMap.size(),CV_8UC1);
+    const float fLowThreshold = float(dLowThreshold), fHighThreshold = float(dHighThreshold);
+    const size_t nTiles = (size_t(nRows)+NMS_TILE_ROW_COUNT-1)/NMS_TILE_ROW_COUNT;
+    const auto lTileNMS = [&](size_t nTileIdx) {
+        const int nRowBegin = int(nTileIdx*NMS_TILE_ROW_COUNT);
+        const int nRowEnd = std::min(nRowBegin+NMS_TILE_ROW_COUNT,nRows);
+        for(int nRowIter=nRowBegin; nRowIter<nRowEnd; ++nRowIter) {
+            uchar* const anLabelRow = m_oLabelMap.ptr<uchar>(nRowIter);
+            if(nRowIter==0 || nRowIter==nRows-1) {
+                std::fill_n(anLabelRow,nCols,uchar(lv::HystLabel_NotEdge));
+                continue;
+            }
+            const short* const anGradXRow = m_oGradXMap.ptr<short>(nRowIter);
+            const short* const anGradYRow = m_oGradYMap.ptr<short>(nRowIter);
+            const float* const afPrevMagRow = m_oGradMagMap.ptr<float>(nRowIter-1);
+            const float* const afCurrMagRow = m_oGradMagMap.ptr<float>(nRowIter);
+            const float* const afNextMagRow = m_oGradMagMap.ptr<float>(nRowIter+1);
+            anLabelRow[0] = anLabelRow[nCols-1] = lv::HystLabel_NotEdge;
+            for(int nColIter=1; nColIter<nCols-1; ++nColIter) {
+                const float fGradMag = afCurrMagRow[nColIter];
+                anLabelRow[nColIter] = lv::HystLabel_NotEdge;
+                if(fGradMag<=fLowThreshold)
+                    continue;
+                const int nGradX = anGradXRow[nColIter], nGradY = anGradYRow[nColIter];
+                const int nShift_FPA = 15;
+                constexpr int nTG22deg_FPA = (int)(0.4142135623730950488016887242097*(1<<nShift_FPA)+0.5); // == tan(pi/8)
+                const int64_t nGradX_abs = std::abs(nGradX);
+                const int64_t nGradY_abs = int64_t(std::abs(nGradY))<<nShift_FPA;
+                const int64_t nTG22GradX_FPA = nGradX_abs*nTG22deg_FPA;
+                bool bIsLocalMax;
+                if(nGradY_abs<nTG22GradX_FPA) // flat gradient (sector 0)
+                    bIsLocalMax = fGradMag>afCurrMagRow[nColIter-1] && fGradMag>=afCurrMagRow[nColIter+1];
+                else {
+                    const int64_t nTG67GradX_FPA = nTG22GradX_FPA+(nGradX_abs<<(nShift_FPA+1)); // == tan(3*pi/8)*nGradX_abs
+                    if(nGradY_abs>nTG67GradX_FPA) // vertical gradient (sector 2)
+                        bIsLocalMax = fGradMag>afPrevMagRow[nColIter] && fGradMag>=afNextMagRow[nColIter];
+                    else { // diagonal gradient (sector 1 or 3, depending on grad sign diff)
+                        const int nOffset = (nGradX^nGradY)<0?-1:1;
+                        bIsLocalMax = fGradMag>afPrevMagRow[nColIter-nOffset] && fGradMag>afNextMagRow[nColIter+nOffset];
+                    }
+                }
+                if(bIsLocalMax)
+                    anLabelRow[nColIter] = (fGradMag>fHighThreshold)?lv::HystLabel_Edge:lv::HystLabel_Candidate;
+            }
+        }
+    };
+    if(m_pThreadPool && nTiles>1)
+        m_pThreadPool->parallel_for(nTiles,lTileNMS);
+    else
+        for(size_t nTileIdx=0; nTileIdx<nTiles; ++nTileIdx)
+            lTileNMS(nTileIdx);
+}
+
+void EdgeDetectorCanny::apply_threshold(cv::InputArray _oInputImage, cv::OutputArray _oEdgeMask, double dThreshold) {
+    cv::Mat oInputImg = _oInputImage.getMat();
+    lvAssert_(!oInputImg.empty() && (oInputImg.channels()==1 || oInputImg.channels()==3 || oInputImg.channels()==4),"input image must be non-empty, and of type 8UC1/8UC3/8UC4");
     _oEdgeMask.create(oInputImg.size(),CV_8UC1);
     cv::Mat oEdgeMask = _oEdgeMask.getMat();
     if(dThreshold<0)
         dThreshold = getDefaultThreshold();
-    static const int nWindowSize = EDGCANNY_SOBEL_KERNEL_SIZE;
-    static const bool bUseL2Gradient = EDGCANNY_USE_L2_GRADIENT_NORM;
-    cv::Canny(oInputImg,oEdgeMask,dThreshold*m_dHystLowThrshFactor,dThreshold,nWindowSize,bUseL2Gradient);
+    apply_internal_gradient(oInputImg);
+    apply_internal_nms(dThreshold*m_dHystLowThrshFactor,dThreshold);
+    m_oHysteresis.apply(m_oLabelMap,oEdgeMask,m_pThreadPool.get());
+    m_oFrameArenaAllocator.reset();
 }
 
 void EdgeDetectorCanny::apply(cv::InputArray _oInputImage, cv::OutputArray _oEdgeMask) {
@@ -48,11 +230,19 @@ void EdgeDetectorCanny::apply(cv::InputArray _oInputImage, cv::OutputArray _oEdg
     lvAssert_(!oInputImg.empty() && (oInputImg.channels()==1 || oInputImg.channels()==3 || oInputImg.channels()==4),"input image must be non-empty, and of type 8UC1/8UC3/8UC4");
     _oEdgeMask.create(oInputImg.size(),CV_8UC1);
     cv::Mat oEdgeMask = _oEdgeMask.getMat();
-    oEdgeMask = cv::Scalar_<uchar>(0);
-    cv::Mat oTempEdgeMask = oEdgeMask.clone();
-    for(size_t nCurrThreshold=0; nCurrThreshold<UCHAR_MAX; ++nCurrThreshold) {
-        apply_threshold(oInputImg,oTempEdgeMask,double(nCurrThreshold));
-        oEdgeMask += oTempEdgeMask/UCHAR_MAX;
+    // equivalent to accumulating apply_threshold(t) for all t in [0,UCHAR_MAX), but gradients & nms are computed once; since
+    // results are nested w.r.t. t, each pixel only needs the highest threshold at which it survives hysteresis, i.e. the best
+    // (over all paths to a seed) of min(seed mag, min path mag/low factor), see lv::ConnectedHysteresis::sweep
+    apply_internal_gradient(oInputImg);
+    apply_internal_nms(0.0,std::numeric_limits<double>::max());
+    m_oSweepPassLevelMap = m_oGradMagMap/m_dHystLowThrshFactor; // highest threshold for which each pixel passes the low hysteresis threshold
+    m_oHysteresis.sweep(m_oLabelMap,m_oSweepPassLevelMap,m_oGradMagMap,m_oSweepLevelMap);
+    for(int nRowIter=0; nRowIter<oEdgeMask.rows; ++nRowIter) {
+        const float* const afSweepLevelRow = m_oSweepLevelMap.ptr<float>(nRowIter);
+        uchar* const anEdgeMaskRow = oEdgeMask.ptr<uchar>(nRowIter);
+        for(int nColIter=0; nColIter<oEdgeMask.cols; ++nColIter) // pixel survives all integer thresholds t<level
+            anEdgeMaskRow[nColIter] = (uchar)std::max(std::min(std::ceil(afSweepLevelRow[nColIter]),float(UCHAR_MAX)),0.0f);
     }
     cv::normalize(oEdgeMask,oEdgeMask,0,UCHAR_MAX,cv::NORM_MINMAX);
+    m_oFrameArenaAllocator.reset();
 }
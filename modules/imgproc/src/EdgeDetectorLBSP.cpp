@@ -22,19 +22,154 @@
 #define USE_5x5_NON_MAX_SUPP      1
 #define USE_MIN_GRAD_ORIENT       1
 #define USE_3_AXIS_ORIENT         1
+#define EDGLBSP_LOOKUP_ROW_BAND_SIZE 16 // number of rows per parallel lookup construction task
+#define EDGLBSP_FLAT_TILE_SIZE EDGLBSP_LOOKUP_ROW_BAND_SIZE // flat region test tile size (one tile row per lookup row band)
+#define EDGLBSP_GLSL_HYST_CHECK_INTERVAL 4 // number of hysteresis propagation dispatches between two convergence checks (atomic counter readbacks)
 
-EdgeDetectorLBSP::EdgeDetectorLBSP(size_t nLevels, double dHystLowThrshFactor, bool bNormalizeOutput) :
+namespace {
+
+    /// gradient thresholding parameters passed to LBSP::computeDescriptor_gradient (also used to detect flat tiles)
+    constexpr size_t s_nGradAbsOffset = 20;
+    constexpr size_t s_nGradRelShift = 2;
+
+    /// returns whether all LBSP gradients centered in a tile are null, i.e. if its (halo-extended) value range is within the smallest gradient threshold, per channel
+    template<size_t nChannels>
+    bool isFlatTile(const cv::Mat& oImg, const cv::Rect& oTileWithHalo) {
+        std::array<uchar,nChannels> anMin,anMax;
+        anMin.fill(UCHAR_MAX);
+        anMax.fill(0);
+        for(int nRowIter=oTileWithHalo.y; nRowIter<oTileWithHalo.y+oTileWithHalo.height; ++nRowIter) {
+            const uchar* const anRow = oImg.ptr<uchar>(nRowIter)+oTileWithHalo.x*nChannels;
+            for(size_t nIdx=0; nIdx<size_t(oTileWithHalo.width)*nChannels; nIdx+=nChannels) {
+                lv::unroll<nChannels>([&](size_t nChIter){
+                    anMin[nChIter] = std::min(anMin[nChIter],anRow[nIdx+nChIter]);
+                    anMax[nChIter] = std::max(anMax[nChIter],anRow[nIdx+nChIter]);
+                });
+            }
+            // neighbor-to-center differences are bounded by the range, and the threshold only grows with the center value
+            for(size_t nChIter=0; nChIter<nChannels; ++nChIter)
+                if(size_t(anMax[nChIter]-anMin[nChIter])>((anMin[nChIter]>>s_nGradRelShift)+s_nGradAbsOffset)/2)
+                    return false;
+        }
+        return true;
+    }
+
+#if HAVE_SSE2
+    /// 16-bit dbcross pattern offsets, mirroring LBSP::lookup_16bits_dbcross's (protected) index LUTs
+    constexpr int s_anDBCrossOffsets_x[16] = {-2, 2, 0, 0,  -2, 2, 2,-2,   0,-1, 0, 1,  -1, 1, 1,-1};
+    constexpr int s_anDBCrossOffsets_y[16] = { 0, 0,-2, 2,   2,-2, 2,-2,   1, 0,-1, 0,  -1, 1,-1, 1};
+
+    /// in-place 16x16 byte matrix transpose (four interleaving stages)
+    inline void transpose_16x16ub(__m128i* _aanRows) {
+        __m128i _aanTemp[16];
+        for(size_t nStageIter=0; nStageIter<4; ++nStageIter) {
+            for(size_t n=0; n<8; ++n) {
+                _aanTemp[n*2] = _mm_unpacklo_epi8(_aanRows[n],_aanRows[n+8]);
+                _aanTemp[n*2+1] = _mm_unpackhi_epi8(_aanRows[n],_aanRows[n+8]);
+            }
+            std::copy_n(_aanTemp,16,_aanRows);
+        }
+    }
+#endif //HAVE_SSE2
+
+#if HAVE_GLSL
+    /// 16-bit dbcross pattern offsets, listed as glsl ivec2 initializers (same order as LBSP::lookup_16bits_dbcross's index LUTs)
+    constexpr const char* s_sDBCrossOffsets_glsl = "ivec2(-2,0),ivec2(2,0),ivec2(0,-2),ivec2(0,2),ivec2(-2,2),ivec2(2,-2),ivec2(2,2),ivec2(-2,-2),"
+                                                   "ivec2(0,1),ivec2(-1,0),ivec2(0,-1),ivec2(1,0),ivec2(-1,-1),ivec2(1,1),ivec2(1,-1),ivec2(-1,1)";
+    /// 16-bit dbcross gradient masks, mirroring LBSP's (protected) s_nDesc_16bitdbcross_Grad* values
+    constexpr uint s_nDBCrossGradX_Pos = ((1<<0)+(1<<4)+(1<<7)+(1<<9)+(1<<12)+(1<<15));
+    constexpr uint s_nDBCrossGradX_Neg = ((1<<1)+(1<<5)+(1<<6)+(1<<11)+(1<<13)+(1<<14));
+    constexpr uint s_nDBCrossGradY_Pos = ((1<<3)+(1<<4)+(1<<6)+(1<<8)+(1<<13)+(1<<15));
+    constexpr uint s_nDBCrossGradY_Neg = ((1<<2)+(1<<5)+(1<<7)+(1<<10)+(1<<12)+(1<<14));
+#endif //HAVE_GLSL
+
+    /// fills one (padded) edge label map row via non-max suppression over the matching gradient map rows, which must be final (see EdgeDetectorLBSP::apply_internal_nms)
+    template<size_t nNMSHalfWinSize>
+    void labelEdgeMapRow(const uchar* anGradRow, size_t nGradMapRowStep, uchar* anEdgeMapRow, size_t nEdgeMapRowStep, size_t nCols,
+                         uchar nHystLowThreshold, uchar nHystHighThreshold, std::vector<uchar>& vuNMSMaxMask) {
+        constexpr size_t nGradMapColStep = 4; // 4ch (gradx, grady, gradmag, 'dont care')
+        constexpr size_t nEdgeMapColStep = 1; // 1ch (label)
+        std::fill(anEdgeMapRow-nEdgeMapColStep*nNMSHalfWinSize,anEdgeMapRow,1);
+        std::fill(anEdgeMapRow+nCols*nEdgeMapColStep,anEdgeMapRow+(nCols+nNMSHalfWinSize)*nEdgeMapColStep,1);
+#if USE_3_AXIS_ORIENT
+        vuNMSMaxMask.resize(nCols);
+        lv::isLocalMaximum_Oriented<nNMSHalfWinSize>(anGradRow,nGradMapRowStep,nCols,vuNMSMaxMask.data());
+#else //(!USE_3_AXIS_ORIENT)
+        UNUSED(vuNMSMaxMask);
+#endif //(!USE_3_AXIS_ORIENT)
+        bool nNeighbMax = false;
+        for(size_t nColIter = 0; nColIter<nCols; ++nColIter) {
+            const uchar nGradMag = anGradRow[nColIter*nGradMapColStep+2];
+            if(nGradMag>=nHystLowThreshold) {
+#if USE_3_AXIS_ORIENT
+                if(vuNMSMaxMask[nColIter])
+                    goto _edge_good; // push as 'edge'
+#else //(!USE_3_AXIS_ORIENT)
+                const uint nGradX_abs = (uint)std::abs(anGradRow[nColIter*nGradMapColStep]);
+                const uint nGradY_abs = (uint)std::abs(anGradRow[nColIter*nGradMapColStep+1]);
+                if((nGradY_abs<=nGradX_abs && lv::isLocalMaximum_Horizontal<nNMSHalfWinSize>(anGradRow+nColIter*nGradMapColStep+2,nGradMapColStep,nGradMapRowStep)) ||
+                   (nGradY_abs>nGradX_abs && lv::isLocalMaximum_Vertical<nNMSHalfWinSize>(anGradRow+nColIter*nGradMapColStep+2,nGradMapColStep,nGradMapRowStep)))
+                    goto _edge_good;
+#endif //(!USE_3_AXIS_ORIENT)
+            }
+            nNeighbMax = false;
+            anEdgeMapRow[nColIter*nEdgeMapColStep] = 1; // not an edge
+            continue;
+            _edge_good:
+            // if not neighbor to previously identified edge, and gradmag above max threshold
+            if(!nNeighbMax && nGradMag>=nHystHighThreshold && anEdgeMapRow[nColIter*nEdgeMapColStep+nEdgeMapRowStep]!=2) {
+                anEdgeMapRow[nColIter*nEdgeMapColStep] = 2; // confirmed edge (hysteresis seed)
+                nNeighbMax = true;
+                continue;
+            }
+            //_edge_maybe:
+            anEdgeMapRow[nColIter*nEdgeMapColStep] = 0; // might belong to an edge
+        }
+    }
+
+} // anonymous namespace
+
+EdgeDetectorLBSP::EdgeDetectorLBSP_(size_t nLevels, double dHystLowThrshFactor, bool bNormalizeOutput) :
         m_nLevels(nLevels),
         m_dHystLowThrshFactor(dHystLowThrshFactor),
         m_dGaussianKernelSigma(0),
         m_bNormalizeOutput(bNormalizeOutput),
         m_vvuInputPyrMaps(std::max(nLevels,size_t(1))-1),
         m_vvuLBSPLookupMaps(nLevels),
-        m_voMapSizeList(nLevels) {
+        m_vvuFlatTileMaps(nLevels),
+        m_voMapSizeList(nLevels),
+        m_nTileSize(0) {
     lvAssert_(m_dHystLowThrshFactor>0 && m_dHystLowThrshFactor<1,"lower hysteresis threshold factor must be between 0 and 1");
     lvAssert_(m_dGaussianKernelSigma>=0,"gaussian smoothing kernel sigma must be non-negative");
     m_nROIBorderSize = LBSP::PATCH_SIZE/2;
     lvAssert_(m_nLevels>0,"number of pyramid levels must be positive");
+    setThreadCount(EDGLBSP_DEFAULT_THREAD_COUNT);
+}
+
+void EdgeDetectorLBSP::setThreadCount(size_t nThreads) {
+    if(nThreads==0)
+        nThreads = std::max((size_t)std::thread::hardware_concurrency(),size_t(1));
+    if(nThreads==1)
+        m_pThreadPool = nullptr;
+    else if(!m_pThreadPool || m_pThreadPool->getThreadCount()!=nThreads)
+        m_pThreadPool = std::make_unique<lv::ThreadPool>(nThreads);
+}
+
+void EdgeDetectorLBSP::setTileSize(size_t nTileSize) {
+    // tile origins must stay aligned on the coarsest pyramid grid, otherwise downscaled maps would sample different pixels
+    const size_t nGridStep = size_t(1)<<(m_nLevels-1);
+    m_nTileSize = ((nTileSize+nGridStep-1)/nGridStep)*nGridStep;
+    lvAssert_(m_nTileSize==0 || m_nTileSize>getTileHaloSize(),"tile size must be larger than the tile halo size");
+}
+
+size_t EdgeDetectorLBSP::getTileHaloSize() const {
+    // a level-l pixel depends on a (2^(l+1)-2)-px wide input neighborhood (recursive dbcross means), its gradient adds
+    // two level-l pixels, and its level-0 footprint adds 2^l-1; nms then adds its half window (w/ the half-window row lag)
+    constexpr size_t nNMSHalfWinSize = (USE_5x5_NON_MAX_SUPP?LBSP::PATCH_SIZE:3)>>1;
+    const size_t nCoarsestLevelStep = size_t(1)<<(m_nLevels-1);
+    const size_t nBlurRadius = m_dGaussianKernelSigma>0?size_t(4*ceil(m_dGaussianKernelSigma)):0;
+    const size_t nHaloSize = (5*nCoarsestLevelStep-3)+nNMSHalfWinSize*2+nBlurRadius;
+    return ((nHaloSize+nCoarsestLevelStep-1)/nCoarsestLevelStep)*nCoarsestLevelStep;
 }
 
 template<size_t nChannels>
@@ -71,6 +206,7 @@ void EdgeDetectorLBSP::apply_internal_lookup(const cv::Mat& oInputImg) {
             oNextPyrInputMap = cv::Mat(oNextScaleSize,nOrigType,m_vvuInputPyrMaps[nLevelIter].data());
             lvDbgAssert(size_t(oNextScaleSize.area()*nChannels)==m_vvuInputPyrMaps[nLevelIter].size());
         }
+        const size_t nTileCols = (nCurrScaleCols+EDGLBSP_FLAT_TILE_SIZE-1)/EDGLBSP_FLAT_TILE_SIZE;
         const auto lBorderColLookup = [&](size_t nRowIter, size_t nCurrRowLUTIdx, size_t nColIter){
             const size_t nCurrColLUTIdx = nCurrRowLUTIdx+nColIter*nColLUTStep;
             uchar* aanCurrLUT = m_vvuLBSPLookupMaps[nLevelIter].data()+nCurrColLUTIdx;
@@ -101,44 +237,100 @@ void EdgeDetectorLBSP::apply_internal_lookup(const cv::Mat& oInputImg) {
             for(size_t nColIter = 0; nColIter<nCurrScaleCols; ++nColIter)
                 lBorderColLookup(nRowIter,nCurrRowLUTIdx,nColIter);
         };
-        size_t nRowIter = 0;
-        for(; nRowIter<nROIBorderSize; ++nRowIter)
-            lBorderRowLookup(nRowIter);
-        for(; nRowIter<nCurrScaleRows-nROIBorderSize; ++nRowIter) {
+        const auto lInnerColLookup = [&](size_t nRowIter, size_t nCurrRowLUTIdx, size_t nColIter) {
+            const size_t nCurrColLUTIdx = nCurrRowLUTIdx+nColIter*nColLUTStep;
+            uchar* aanCurrLUT = m_vvuLBSPLookupMaps[nLevelIter].data()+nCurrColLUTIdx;
+            lvDbgAssert(nCurrColLUTIdx<m_vvuLBSPLookupMaps[nLevelIter].size() && (nCurrColLUTIdx%LBSP::DESC_SIZE_BITS)==0);
+            LBSP::computeDescriptor_lookup<nChannels>(oCurrPyrInputMap,int(nColIter),int(nRowIter),aanCurrLUT);
+            if(nNextScaleMapSize && !(nRowIter%2) && !(nColIter%2)) {
+                const size_t nNextColLUTIdx = (nRowIter/2)*nNextRowLUTStep + (nColIter/2)*nColLUTStep;
+                for(size_t nChIter = 0; nChIter<nChannels; ++nChIter) {
+#if HAVE_SSE2
+                    static_assert(LBSP::DESC_SIZE_BITS==16,"all channels should already be 16-byte-aligned");
+                    __m128i _anInputVals = _mm_load_si128((__m128i*)(aanCurrLUT+nChIter*LBSP::DESC_SIZE_BITS));
+                    size_t nLUTSum = (size_t)lv::hsum_16ub(_anInputVals);
+#else //(!HAVE_SSE2)
+                    uchar* anCurrChLUT = aanCurrLUT+nChIter*LBSP::DESC_SIZE_BITS;
+                    size_t nLUTSum = 0;
+                    lv::unroll<LBSP::DESC_SIZE_BITS>([&](size_t nLUTIter){
+                        nLUTSum += anCurrChLUT[nLUTIter];
+                    });
+#endif //(!HAVE_SSE2)
+                    const size_t nNextPyrImgIdx = nNextColLUTIdx/LBSP::DESC_SIZE_BITS + nChIter;
+                    lvDbgAssert(nNextPyrImgIdx<size_t(oNextPyrInputMap.dataend-oNextPyrInputMap.datastart));
+                    *(oNextPyrInputMap.data+nNextPyrImgIdx) = uchar(nLUTSum/LBSP::DESC_SIZE_BITS);
+                }
+            }
+        };
+        // rows only write their own lut entries and (for even rows) their own next-scale pyramid row, so row bands can run in parallel
+        const auto lRowLookup = [&](size_t nRowIter) {
+            if(nRowIter<nROIBorderSize || nRowIter>=nCurrScaleRows-nROIBorderSize) {
+                lBorderRowLookup(nRowIter);
+                return;
+            }
             const size_t nCurrRowLUTIdx = nRowIter*nCurrRowLUTStep;
+            // lookups in flat tiles are never used by the gradient stage, so only those feeding the next pyramid level are computed
+            const uchar* const anFlatTileRow = m_vvuFlatTileMaps[nLevelIter].data()+(nRowIter/EDGLBSP_FLAT_TILE_SIZE)*nTileCols;
             size_t nColIter = 0;
             for(; nColIter<nROIBorderSize; ++nColIter)
                 lBorderColLookup(nRowIter,nCurrRowLUTIdx,nColIter);
-            for(; nColIter<nCurrScaleCols-nROIBorderSize; ++nColIter) {
-                const size_t nCurrColLUTIdx = nCurrRowLUTIdx+nColIter*nColLUTStep;
-                uchar* aanCurrLUT = m_vvuLBSPLookupMaps[nLevelIter].data()+nCurrColLUTIdx;
-                lvDbgAssert(nCurrColLUTIdx<m_vvuLBSPLookupMaps[nLevelIter].size() && (nCurrColLUTIdx%LBSP::DESC_SIZE_BITS)==0);
-                LBSP::computeDescriptor_lookup<nChannels>(oCurrPyrInputMap,int(nColIter),int(nRowIter),aanCurrLUT);
-                if(nNextScaleMapSize && !(nRowIter%2) && !(nColIter%2)) {
-                    const size_t nNextColLUTIdx = (nRowIter/2)*nNextRowLUTStep + (nColIter/2)*nColLUTStep;
-                    for(size_t nChIter = 0; nChIter<nChannels; ++nChIter) {
 #if HAVE_SSE2
-                        static_assert(LBSP::DESC_SIZE_BITS==16,"all channels should already be 16-byte-aligned");
-                        __m128i _anInputVals = _mm_load_si128((__m128i*)(aanCurrLUT+nChIter*LBSP::DESC_SIZE_BITS));
-                        size_t nLUTSum = (size_t)lv::hsum_16ub(_anInputVals);
-#else //(!HAVE_SSE2)
-                        uchar* anCurrChLUT = aanCurrLUT+nChIter*LBSP::DESC_SIZE_BITS;
-                        size_t nLUTSum = 0;
-                        lv::unroll<LBSP::DESC_SIZE_BITS>([&](size_t nLUTIter){
-                            nLUTSum += anCurrChLUT[nLUTIter];
-                        });
-#endif //(!HAVE_SSE2)
-                        const size_t nNextPyrImgIdx = nNextColLUTIdx/LBSP::DESC_SIZE_BITS + nChIter;
-                        lvDbgAssert(nNextPyrImgIdx<size_t(oNextPyrInputMap.dataend-oNextPyrInputMap.datastart));
-                        *(oNextPyrInputMap.data+nNextPyrImgIdx) = uchar(nLUTSum/LBSP::DESC_SIZE_BITS);
+            if(nChannels==1) {
+                // single-channel lookups are gathered 16 pixels at a time: one shifted row load per pattern offset, then a 16x16 byte transpose
+                static_assert(LBSP::DESC_SIZE_BITS==16,"gather impl requires one 16-byte lut per pixel");
+                const size_t nRowStep = oCurrPyrInputMap.step.p[0];
+                for(; nColIter+16<=nCurrScaleCols-nROIBorderSize; nColIter+=16) {
+                    if(anFlatTileRow[nColIter/EDGLBSP_FLAT_TILE_SIZE] && anFlatTileRow[(nColIter+15)/EDGLBSP_FLAT_TILE_SIZE]) {
+                        if(nNextScaleMapSize && !(nRowIter%2))
+                            for(size_t n=(nColIter%2); n<16; n+=2)
+                                lInnerColLookup(nRowIter,nCurrRowLUTIdx,nColIter+n);
+                        continue;
+                    }
+                    const uchar* const anCurrImg = oCurrPyrInputMap.data+nRowIter*nRowStep+nColIter;
+                    uchar* const aanCurrLUT = m_vvuLBSPLookupMaps[nLevelIter].data()+nCurrRowLUTIdx+nColIter*nColLUTStep;
+                    __m128i _aanVals[16];
+                    lv::unroll<16>([&](int n) {
+                        _aanVals[n] = _mm_loadu_si128((const __m128i*)(anCurrImg+(ptrdiff_t)nRowStep*s_anDBCrossOffsets_y[n]+s_anDBCrossOffsets_x[n]));
+                    });
+                    transpose_16x16ub(_aanVals);
+                    lv::unroll<16>([&](int n) {
+                        _mm_store_si128((__m128i*)(aanCurrLUT+n*LBSP::DESC_SIZE_BITS),_aanVals[n]);
+                    });
+                    if(nNextScaleMapSize && !(nRowIter%2)) {
+                        uchar* const anNextPyrRow = oNextPyrInputMap.data+(nRowIter/2)*nNextScaleCols;
+                        for(size_t n=(nColIter%2); n<16; n+=2) {
+                            lvDbgAssert(anNextPyrRow+(nColIter+n)/2<oNextPyrInputMap.dataend);
+                            anNextPyrRow[(nColIter+n)/2] = uchar(lv::hsum_16ub(_aanVals[n])/LBSP::DESC_SIZE_BITS);
+                        }
                     }
                 }
             }
+#endif //HAVE_SSE2
+            for(; nColIter<nCurrScaleCols-nROIBorderSize; ++nColIter)
+                if(!anFlatTileRow[nColIter/EDGLBSP_FLAT_TILE_SIZE] || (nNextScaleMapSize && !(nRowIter%2) && !(nColIter%2)))
+                    lInnerColLookup(nRowIter,nCurrRowLUTIdx,nColIter);
             for(; nColIter<nCurrScaleCols; ++nColIter)
                 lBorderColLookup(nRowIter,nCurrRowLUTIdx,nColIter);
-        }
-        for(; nRowIter<nCurrScaleRows; ++nRowIter)
-            lBorderRowLookup(nRowIter);
+        };
+        const size_t nRowBands = (nCurrScaleRows+EDGLBSP_LOOKUP_ROW_BAND_SIZE-1)/EDGLBSP_LOOKUP_ROW_BAND_SIZE;
+        static_assert(EDGLBSP_FLAT_TILE_SIZE==EDGLBSP_LOOKUP_ROW_BAND_SIZE,"each row band should test its own row of flat tiles");
+        m_vvuFlatTileMaps[nLevelIter].resize(nRowBands*nTileCols);
+        const auto lRowBandLookup = [&](size_t nBandIdx) {
+            uchar* const anFlatTileRow = m_vvuFlatTileMaps[nLevelIter].data()+nBandIdx*nTileCols;
+            for(size_t nTileColIdx=0; nTileColIdx<nTileCols; ++nTileColIdx) {
+                const cv::Rect oTile(int(nTileColIdx*EDGLBSP_FLAT_TILE_SIZE),int(nBandIdx*EDGLBSP_FLAT_TILE_SIZE),EDGLBSP_FLAT_TILE_SIZE,EDGLBSP_FLAT_TILE_SIZE);
+                const cv::Rect oTileWithHalo = (oTile+cv::Size(int(nROIBorderSize*2),int(nROIBorderSize*2))-cv::Point(int(nROIBorderSize),int(nROIBorderSize)))&cv::Rect(0,0,int(nCurrScaleCols),int(nCurrScaleRows));
+                anFlatTileRow[nTileColIdx] = (uchar)isFlatTile<nChannels>(oCurrPyrInputMap,oTileWithHalo);
+            }
+            const size_t nRowEnd = std::min((nBandIdx+1)*EDGLBSP_LOOKUP_ROW_BAND_SIZE,nCurrScaleRows);
+            for(size_t nRowIter=nBandIdx*EDGLBSP_LOOKUP_ROW_BAND_SIZE; nRowIter<nRowEnd; ++nRowIter)
+                lRowLookup(nRowIter);
+        };
+        if(m_pThreadPool && nRowBands>1)
+            m_pThreadPool->parallel_for(nRowBands,lRowBandLookup);
+        else
+            for(size_t nBandIdx=0; nBandIdx<nRowBands; ++nBandIdx)
+                lRowBandLookup(nBandIdx);
     }
 }
 
@@ -161,9 +353,8 @@ void EdgeDetectorLBSP::apply_internal_lookup(const cv::Mat& oInputImg, size_t nC
 }
 
 template<size_t nChannels>
-void EdgeDetectorLBSP::apply_internal_threshold(const cv::Mat& oInputImg, cv::Mat& oEdgeMask, uchar nDetThreshold) {
+void EdgeDetectorLBSP::apply_internal_nms(const cv::Mat& oInputImg, uchar nDetThreshold) {
     lvAssert_(!oInputImg.empty() && oInputImg.isContinuous(),"input image must be non-empty and continuous");
-    lvAssert_(!oEdgeMask.empty() && oEdgeMask.isContinuous(),"output mask must be non-empty and continuous");
     const int nOrigType = CV_8UC(int(nChannels));
     const size_t nColLUTStep = LBSP::DESC_SIZE_BITS*nChannels;
     const uchar nHystHighThreshold = nDetThreshold;
@@ -191,44 +382,32 @@ void EdgeDetectorLBSP::apply_internal_threshold(const cv::Mat& oInputImg, cv::Ma
 #else //(!USE_MIN_GRAD_ORIENT)
     oGradMap(cv::Rect(nNMSHalfWinSize,nNMSHalfWinSize,m_voMapSizeList.back().width,m_voMapSizeList.back().height)) = cv::Scalar_<uchar>(0,0,UCHAR_MAX,0);
 #endif //(!USE_MIN_GRAD_ORIENT)
-    size_t nCurrHystStackSize = std::max(std::max((size_t)1<<10,(size_t)oMapSize.area()/8),m_vuHystStack.size());
-    m_vuHystStack.resize(nCurrHystStackSize);
-    uchar** pauHystStack_top = &m_vuHystStack[0];
-    uchar** pauHystStack_bottom = &m_vuHystStack[0];
-    auto stack_push = [&](uchar* pAddr) {
-        lvDbgAssert(pAddr>=oEdgeTempMask.datastart+nEdgeMapRowStep*nNMSHalfWinSize);
-        lvDbgAssert(pAddr<oEdgeTempMask.dataend-nEdgeMapRowStep*nNMSHalfWinSize);
-        *pAddr = 2, *pauHystStack_top++ = pAddr;
-    };
-    auto stack_pop = [&]() -> uchar* {
-        lvDbgAssert(pauHystStack_top>pauHystStack_bottom);
-        return *--pauHystStack_top;
-    };
-    auto stack_check_size = [&](size_t nPotentialSize) {
-        if(ptrdiff_t(pauHystStack_top-pauHystStack_bottom)+nPotentialSize>nCurrHystStackSize) {
-            const ptrdiff_t nUsedHystStackSize = pauHystStack_top-pauHystStack_bottom;
-            nCurrHystStackSize = std::max(nCurrHystStackSize*2,nUsedHystStackSize+nPotentialSize);
-            m_vuHystStack.resize(nCurrHystStackSize);
-            pauHystStack_bottom = &m_vuHystStack[0];
-            pauHystStack_top = pauHystStack_bottom+nUsedHystStackSize;
-        }
-    };
     for(int nLevelIter = (int)m_nLevels-1; nLevelIter>=0; --nLevelIter) {
         const cv::Size& oCurrScaleSize = m_voMapSizeList[nLevelIter];
         const cv::Mat& oPyrMap = (!nLevelIter)?oInputImg:cv::Mat(oCurrScaleSize,nOrigType,m_vvuInputPyrMaps[nLevelIter-1].data());
         const size_t nRowLUTStep = nColLUTStep*(size_t)oCurrScaleSize.width;
+        const size_t nTileCols = ((size_t)oCurrScaleSize.width+EDGLBSP_FLAT_TILE_SIZE-1)/EDGLBSP_FLAT_TILE_SIZE;
+        lvDbgAssert(m_vvuFlatTileMaps[nLevelIter].size()==nTileCols*(((size_t)oCurrScaleSize.height+EDGLBSP_FLAT_TILE_SIZE-1)/EDGLBSP_FLAT_TILE_SIZE));
         for(int nRowIter = oCurrScaleSize.height-1; nRowIter>=-(int)nNMSHalfWinSize; --nRowIter) {
             uchar* anGradRow = oGradMap.data+(nRowIter+nNMSHalfWinSize)*nGradMapRowStep+nGradMapColStep*nNMSHalfWinSize;
             lvDbgAssert(anGradRow>oGradMap.datastart && anGradRow<oGradMap.dataend);
             if(nRowIter>=0) {
                 const size_t nRowLUTIdx = nRowIter*nRowLUTStep;
+                const uchar* const anFlatTileRow = m_vvuFlatTileMaps[nLevelIter].data()+(nRowIter/EDGLBSP_FLAT_TILE_SIZE)*nTileCols;
                 for(size_t nColIter = (size_t)oCurrScaleSize.width-1; nColIter!=size_t(-1); --nColIter) {
                     const size_t nColLUTIdx = nRowLUTIdx+nColIter*nColLUTStep;
                     const uchar* const anCurrLUT = m_vvuLBSPLookupMaps[nLevelIter].data()+nColLUTIdx;
                     const uchar* const auRefColor = (oPyrMap.data+nColLUTIdx/LBSP::DESC_SIZE_BITS);
-                    char nGradX, nGradY;
-                    uchar nGradMag;
-                    LBSP::computeDescriptor_gradient<nChannels>(anCurrLUT,auRefColor,nGradX,nGradY,nGradMag);
+                    char nGradX=0, nGradY=0;
+                    uchar nGradMag=0;
+#if USE_MIN_GRAD_ORIENT
+                    // null gradients (flat tiles, or null coarser-scale gradients) leave/make the combined gradient null anyway
+                    const bool bNullGrad = anFlatTileRow[nColIter/EDGLBSP_FLAT_TILE_SIZE] || !anGradRow[nColIter*nGradMapColStep+2];
+#else //(!USE_MIN_GRAD_ORIENT)
+                    const bool bNullGrad = anFlatTileRow[nColIter/EDGLBSP_FLAT_TILE_SIZE];
+#endif //(!USE_MIN_GRAD_ORIENT)
+                    if(!bNullGrad)
+                        LBSP::computeDescriptor_gradient<nChannels,s_nGradAbsOffset,s_nGradRelShift>(anCurrLUT,auRefColor,nGradX,nGradY,nGradMag);
 #if USE_MIN_GRAD_ORIENT
                     (char&)(anGradRow[nColIter*nGradMapColStep]) = std::min(nGradX,char(anGradRow[nColIter*nGradMapColStep]),lAbsCharComp);
                     (char&)(anGradRow[nColIter*nGradMapColStep+1]) = std::min(nGradY,char(anGradRow[nColIter*nGradMapColStep+1]),lAbsCharComp);
@@ -260,100 +439,95 @@ void EdgeDetectorLBSP::apply_internal_threshold(const cv::Mat& oInputImg, cv::Ma
                 if(nRowIter<oCurrScaleSize.height-int(nNMSHalfWinSize)) {
                     anGradRow += nGradMapRowStep*nNMSHalfWinSize; // offset by nNMSHalfWinSize rows
                     uchar* anEdgeMapRow = oEdgeTempMask.ptr<uchar>(nRowIter+nNMSHalfWinSize)+nNMSHalfWinSize*nEdgeMapColStep;
-                    std::fill(anEdgeMapRow-nEdgeMapColStep*nNMSHalfWinSize,anEdgeMapRow,1);
-                    std::fill(anEdgeMapRow+oInputImg.cols*nEdgeMapColStep,anEdgeMapRow+(oInputImg.cols+nNMSHalfWinSize)*nEdgeMapColStep,1);
-                    stack_check_size(oInputImg.cols);
-                    bool nNeighbMax = false;
                     for(size_t nColIter = 0; nColIter<(size_t)oInputImg.cols; ++nColIter) {
                         // make sure all 'quick-idx' lookups are at the right positions...
                         lvDbgAssert(anGradRow[nColIter*nGradMapColStep]==oGradMap.at<cv::Vec4b>(int(nRowIter+(nNMSHalfWinSize*2)),int(nColIter+nNMSHalfWinSize))[0]);
                         lvDbgAssert(anGradRow[nColIter*nGradMapColStep+1]==oGradMap.at<cv::Vec4b>(int(nRowIter+(nNMSHalfWinSize*2)),int(nColIter+nNMSHalfWinSize))[1]);
                         for(int nNMSWinIter=-(int)nNMSHalfWinSize; nNMSWinIter<=(int)nNMSHalfWinSize; ++nNMSWinIter)
                             lvDbgAssert(anGradRow[nColIter*nGradMapColStep+nGradMapRowStep*nNMSWinIter+2]==oGradMap.at<cv::Vec4b>(int(nRowIter+nNMSWinIter+(nNMSHalfWinSize*2)),int(nColIter+nNMSHalfWinSize))[2]);
-                        const uchar nGradMag = anGradRow[nColIter*nGradMapColStep+2];
-                        if(nGradMag>=nHystLowThreshold) {
-#if USE_3_AXIS_ORIENT
-                            const char nGradX = ((char*)anGradRow)[nColIter*nGradMapColStep];
-                            const char nGradY = ((char*)anGradRow)[nColIter*nGradMapColStep+1];
-                            const uint nShift_FPA = 15;
-                            constexpr uint nTG22deg_FPA = (int)(0.4142135623730950488016887242097*(1<<nShift_FPA)+0.5); // == tan(pi/8)
-                            const uint nGradX_abs = (uint)std::abs(nGradX);
-                            const uint nGradY_abs = (uint)std::abs(nGradY)<<nShift_FPA;
-                            uint nTG22GradX_FPA = nGradX_abs*nTG22deg_FPA; // == 0.4142135623730950488016887242097*nGradX_abs
-                            if(nGradY_abs<nTG22GradX_FPA) { // if(nGradX_abs<0.4142135623730950488016887242097*nGradX_abs) == flat gradient (sector 0)
-                                if(lv::isLocalMaximum_Horizontal<nNMSHalfWinSize>(anGradRow+nColIter*nGradMapColStep+2,nGradMapColStep,nGradMapRowStep))
-                                    goto _edge_good; // push as 'edge'
-                            }
-                            else { // else(nGradX_abs>=0.4142135623730950488016887242097*nGradX_abs) == not a flat gradient (sectors 1, 2 or 3)
-                                uint nTG67GradX_FPA = nTG22GradX_FPA+(nGradX_abs<<(nShift_FPA+1)); // == 2.4142135623730950488016887242097*nGradX_abs == tan(3*pi/8)*nGradX_abs
-                                if(nGradY_abs>nTG67GradX_FPA) { // if(nGradX_abs>2.4142135623730950488016887242097*nGradX_abs == vertical gradient (sector 2)
-                                    if(lv::isLocalMaximum_Vertical<nNMSHalfWinSize>(anGradRow+nColIter*nGradMapColStep+2,nGradMapColStep,nGradMapRowStep))
-                                        goto _edge_good;
-                                }
-                                else { // else(nGradX_abs<=2.4142135623730950488016887242097*nGradX_abs == diagonal gradient (sector 1 or 3, depending on grad sign diff)
-                                    if(nGradX || nGradY) {
-                                        if(lv::isLocalMaximum_Diagonal<nNMSHalfWinSize>(anGradRow+nColIter*nGradMapColStep+2,nGradMapColStep,nGradMapRowStep,(nGradX^nGradY)>=0))
-                                            goto _edge_good;
-                                    }
-                                    else {
-                                        if(lv::isLocalMaximum_Diagonal<nNMSHalfWinSize,true>(anGradRow+nColIter*nGradMapColStep+2,nGradMapColStep,nGradMapRowStep) ||
-                                           lv::isLocalMaximum_Diagonal<nNMSHalfWinSize,false>(anGradRow+nColIter*nGradMapColStep+2,nGradMapColStep,nGradMapRowStep))
-                                            goto _edge_good;
-                                    }
-                                }
-                            }
-#else //(!USE_3_AXIS_ORIENT)
-                            const uint nGradX_abs = (uint)std::abs(anGradRow[nColIter*nGradMapColStep]);
-                            const uint nGradY_abs = (uint)std::abs(anGradRow[nColIter*nGradMapColStep+1]);
-                            if((nGradY_abs<=nGradX_abs && isLocalMaximum_Horizontal<nNMSHalfWinSize>(anGradRow+nColIter*nGradMapColStep+2,nGradMapColStep,nGradMapRowStep)) ||
-                               (nGradY_abs>nGradX_abs && isLocalMaximum_Vertical<nNMSHalfWinSize>(anGradRow+nColIter*nGradMapColStep+2,nGradMapColStep,nGradMapRowStep)))
-                                goto _edge_good;
-#endif //(!USE_3_AXIS_ORIENT)
-                        }
-                        nNeighbMax = false;
-                        anEdgeMapRow[nColIter*nEdgeMapColStep] = 1; // not an edge
-                        continue;
-                        _edge_good:
-                        // if not neighbor to previously identified edge, and gradmag above max threshold
-                        if(!nNeighbMax && nGradMag>=nHystHighThreshold && anEdgeMapRow[nColIter*nEdgeMapColStep+nEdgeMapRowStep]!=2) {
-                            stack_push(anEdgeMapRow+nColIter);
-                            nNeighbMax = true;
-                            continue;
-                        }
-                        //_edge_maybe:
-                        anEdgeMapRow[nColIter*nEdgeMapColStep] = 0; // might belong to an edge
                     }
+                    labelEdgeMapRow<nNMSHalfWinSize>(anGradRow,nGradMapRowStep,anEdgeMapRow,nEdgeMapRowStep,(size_t)oInputImg.cols,nHystLowThreshold,nHystHighThreshold,m_vuNMSMaxMask);
                 }
             }
         }
     }
     lvDbgAssert(oEdgeTempMask.step.p[0]==nEdgeMapRowStep);
     lvDbgAssert(oEdgeTempMask.step.p[1]==nEdgeMapColStep);
-    while(pauHystStack_top>pauHystStack_bottom) {
-        stack_check_size(8);
-        uchar* pEdgeAddr = stack_pop();
-        if(!pEdgeAddr[-intptr_t(nEdgeMapColStep)])
-            stack_push(pEdgeAddr-nEdgeMapColStep);
-        if(!pEdgeAddr[nEdgeMapColStep])
-            stack_push(pEdgeAddr+nEdgeMapColStep);
-        if(!pEdgeAddr[-intptr_t(nEdgeMapRowStep)-nEdgeMapColStep])
-            stack_push(pEdgeAddr-nEdgeMapRowStep-nEdgeMapColStep);
-        if(!pEdgeAddr[-intptr_t(nEdgeMapRowStep)])
-            stack_push(pEdgeAddr-nEdgeMapRowStep);
-        if(!pEdgeAddr[-intptr_t(nEdgeMapRowStep)+nEdgeMapColStep])
-            stack_push(pEdgeAddr-nEdgeMapRowStep+nEdgeMapColStep);
-        if(!pEdgeAddr[nEdgeMapRowStep-nEdgeMapColStep])
-            stack_push(pEdgeAddr+nEdgeMapRowStep-nEdgeMapColStep);
-        if(!pEdgeAddr[nEdgeMapRowStep])
-            stack_push(pEdgeAddr+nEdgeMapRowStep);
-        if(!pEdgeAddr[nEdgeMapRowStep+nEdgeMapColStep])
-            stack_push(pEdgeAddr+nEdgeMapRowStep+nEdgeMapColStep);
+}
+
+template void EdgeDetectorLBSP::apply_internal_nms<1>(const cv::Mat&, uchar);
+template void EdgeDetectorLBSP::apply_internal_nms<2>(const cv::Mat&, uchar);
+template void EdgeDetectorLBSP::apply_internal_nms<3>(const cv::Mat&, uchar);
+template void EdgeDetectorLBSP::apply_internal_nms<4>(const cv::Mat&, uchar);
+
+void EdgeDetectorLBSP::apply_internal_nms(const cv::Mat& oInputImg, uchar nDetThreshold, size_t nChannels) {
+    if(nChannels==1)
+        apply_internal_nms<1>(oInputImg,nDetThreshold);
+    else if(nChannels==2)
+        apply_internal_nms<2>(oInputImg,nDetThreshold);
+    else if(nChannels==3)
+        apply_internal_nms<3>(oInputImg,nDetThreshold);
+    else if(nChannels==4)
+        apply_internal_nms<4>(oInputImg,nDetThreshold);
+    else
+        CV_Error(-1,"Unexpected channel count");
+}
+
+void EdgeDetectorLBSP::apply_internal_nms_labels(const cv::Size& oInputSize, uchar nDetThreshold) {
+    const uchar nHystHighThreshold = nDetThreshold;
+    const uchar nHystLowThreshold = (uchar)(nDetThreshold*m_dHystLowThrshFactor);
+    constexpr size_t nNMSHalfWinSize = (USE_5x5_NON_MAX_SUPP?LBSP::PATCH_SIZE:3)>>1;
+    const cv::Size oMapSize(oInputSize.width+nNMSHalfWinSize*2,oInputSize.height+nNMSHalfWinSize*2);
+    constexpr size_t nGradMapColStep = 4;
+    const size_t nGradMapRowStep = oMapSize.width*nGradMapColStep;
+    const size_t nEdgeMapRowStep = oMapSize.width;
+    lvDbgAssert(m_vuLBSPGradMapData.size()==oMapSize.height*nGradMapRowStep);
+    m_vuEdgeTempMaskData.resize(oMapSize.height*nEdgeMapRowStep);
+    std::fill(m_vuEdgeTempMaskData.data(),m_vuEdgeTempMaskData.data()+nEdgeMapRowStep*nNMSHalfWinSize,1);
+    std::fill(m_vuEdgeTempMaskData.data()+(oMapSize.height-nNMSHalfWinSize)*nEdgeMapRowStep,m_vuEdgeTempMaskData.data()+oMapSize.height*nEdgeMapRowStep,1);
+    // same row order & half-window row lag as the level-0 pass of apply_internal_nms (seeds check the row below)
+    for(int nRowIter = oInputSize.height-int(nNMSHalfWinSize)-1; nRowIter>=-(int)nNMSHalfWinSize; --nRowIter) {
+        const uchar* const anGradRow = m_vuLBSPGradMapData.data()+(nRowIter+nNMSHalfWinSize*2)*nGradMapRowStep+nGradMapColStep*nNMSHalfWinSize;
+        uchar* const anEdgeMapRow = m_vuEdgeTempMaskData.data()+(nRowIter+nNMSHalfWinSize)*nEdgeMapRowStep+nNMSHalfWinSize;
+        labelEdgeMapRow<nNMSHalfWinSize>(anGradRow,nGradMapRowStep,anEdgeMapRow,nEdgeMapRowStep,(size_t)oInputSize.width,nHystLowThreshold,nHystHighThreshold,m_vuNMSMaxMask);
+    }
+}
+
+void EdgeDetectorLBSP::apply_internal_stages(const cv::Mat& oInputImg, uchar nDetThreshold) {
+    const size_t nChannels = (size_t)oInputImg.channels();
+    // the gradient map only depends on the image, level count & blur sigma (the pyramid/lookup maps it is built from are not needed past it)
+    const lv::EdgeDetectorStageCache::Key oCacheKey = {m_nStageCacheImageID,"lbsp_gradient",{double(m_nLevels),m_dGaussianKernelSigma,double(nChannels)}};
+    constexpr int nNMSHalfWinSize = (USE_5x5_NON_MAX_SUPP?LBSP::PATCH_SIZE:3)>>1;
+    const cv::Size oGradMapSize(oInputImg.cols+nNMSHalfWinSize*2,oInputImg.rows+nNMSHalfWinSize*2);
+    if(isUsingStageCache()) {
+        const auto pCachedData = m_pStageCache->get(oCacheKey);
+        if(pCachedData && pCachedData->size()==1 && (*pCachedData)[0].size()==oGradMapSize && (*pCachedData)[0].isContinuous()) {
+            const cv::Mat& oCachedGradMap = (*pCachedData)[0];
+            m_vuLBSPGradMapData.assign(oCachedGradMap.data,oCachedGradMap.dataend);
+            apply_internal_nms_labels(oInputImg.size(),nDetThreshold);
+            return;
+        }
     }
-    const uchar* anEdgeTempMaskData = oEdgeTempMask.data+nEdgeMapRowStep*nNMSHalfWinSize+nEdgeMapColStep*nNMSHalfWinSize;
-    uchar* oEdgeMaskData = oEdgeMask.data;
-    for(int nRowIter=0; nRowIter<oInputImg.rows; ++nRowIter, anEdgeTempMaskData+=nEdgeMapRowStep, oEdgeMaskData+=oEdgeMask.step)
-        for(int nColIter=0; nColIter<oInputImg.cols; ++nColIter)
-            oEdgeMaskData[nColIter] = (uchar)-(*(anEdgeTempMaskData+nColIter*nEdgeMapColStep)>>1);
+    apply_internal_lookup(oInputImg,nChannels);
+    apply_internal_nms(oInputImg,nDetThreshold,nChannels);
+    if(isUsingStageCache())
+        m_pStageCache->put(oCacheKey,{cv::Mat(oGradMapSize,CV_8UC4,m_vuLBSPGradMapData.data())});
+}
+
+cv::Mat EdgeDetectorLBSP::getEdgeLabelMap(const cv::Size& oInputSize) {
+    constexpr int nNMSHalfWinSize = (USE_5x5_NON_MAX_SUPP?LBSP::PATCH_SIZE:3)>>1;
+    const cv::Size oMapSize(oInputSize.width+nNMSHalfWinSize*2,oInputSize.height+nNMSHalfWinSize*2);
+    lvDbgAssert(m_vuEdgeTempMaskData.size()==size_t(oMapSize.area()));
+    static_assert(lv::HystLabel_Candidate==0 && lv::HystLabel_NotEdge==1 && lv::HystLabel_Edge==2,"edge map labels must match hysteresis labels");
+    return cv::Mat(oMapSize,CV_8UC1,m_vuEdgeTempMaskData.data())(cv::Rect(nNMSHalfWinSize,nNMSHalfWinSize,oInputSize.width,oInputSize.height));
+}
+
+template<size_t nChannels>
+void EdgeDetectorLBSP::apply_internal_threshold(const cv::Mat& oInputImg, cv::Mat& oEdgeMask, uchar nDetThreshold) {
+    lvAssert_(!oEdgeMask.empty() && oEdgeMask.isContinuous(),"output mask must be non-empty and continuous");
+    lvDbgAssert(size_t(oInputImg.channels())==nChannels);
+    apply_internal_stages(oInputImg,nDetThreshold);
+    m_oHysteresis.apply(getEdgeLabelMap(oInputImg.size()),oEdgeMask,m_pThreadPool.get());
 }
 
 template void EdgeDetectorLBSP::apply_internal_threshold<1>(const cv::Mat&, cv::Mat&, uchar);
@@ -374,22 +548,72 @@ void EdgeDetectorLBSP::apply_internal_threshold(const cv::Mat& oInputImg, cv::Ma
         CV_Error(-1,"Unexpected channel count");
 }
 
+void EdgeDetectorLBSP::initLaneDetectors(size_t nLanes) {
+    if(m_vpTileDetectors.size()<nLanes) {
+        m_vpTileDetectors.resize(nLanes);
+        m_voTileInputs.resize(nLanes);
+        m_voTileOutputs.resize(nLanes);
+    }
+    for(size_t nLaneIdx=0; nLaneIdx<nLanes; ++nLaneIdx)
+        if(!m_vpTileDetectors[nLaneIdx]) {
+            m_vpTileDetectors[nLaneIdx] = std::make_unique<EdgeDetectorLBSP>(m_nLevels,m_dHystLowThrshFactor,false);
+            m_vpTileDetectors[nLaneIdx]->setThreadCount(1); // parallelism is already spread across lanes
+        }
+}
+
+void EdgeDetectorLBSP::apply_tiled(const cv::Mat& oInputImg, cv::Mat& oEdgeMask, double dDetThreshold) {
+    lvDbgAssert(m_nTileSize>0 && oEdgeMask.size()==oInputImg.size() && oEdgeMask.type()==CV_8UC1);
+    const int nTileSize = (int)m_nTileSize;
+    const int nHaloSize = (int)getTileHaloSize();
+    const int nTileCols = (oInputImg.cols+nTileSize-1)/nTileSize;
+    const int nTileRows = (oInputImg.rows+nTileSize-1)/nTileSize;
+    const size_t nTileCount = size_t(nTileCols*nTileRows);
+    // each lane owns one sequential detector & its tile buffers, so memory only depends on the tile size & thread count
+    const size_t nLanes = std::min(getThreadCount(),nTileCount);
+    initLaneDetectors(nLanes);
+    const auto lLaneProcess = [&](size_t nLaneIdx) {
+        EdgeDetectorLBSP& oTileDetector = *m_vpTileDetectors[nLaneIdx];
+        cv::Mat& oTileInput = m_voTileInputs[nLaneIdx];
+        cv::Mat& oTileOutput = m_voTileOutputs[nLaneIdx];
+        for(size_t nTileIdx=nLaneIdx; nTileIdx<nTileCount; nTileIdx+=nLanes) {
+            const cv::Rect oTileRect(int(nTileIdx%nTileCols)*nTileSize,int(nTileIdx/nTileCols)*nTileSize,nTileSize,nTileSize);
+            const cv::Rect oInnerRect = oTileRect&cv::Rect(0,0,oInputImg.cols,oInputImg.rows);
+            const cv::Rect oHaloRect = cv::Rect(oInnerRect.x-nHaloSize,oInnerRect.y-nHaloSize,oInnerRect.width+nHaloSize*2,oInnerRect.height+nHaloSize*2)&cv::Rect(0,0,oInputImg.cols,oInputImg.rows);
+            oInputImg(oHaloRect).copyTo(oTileInput);
+            if(dDetThreshold<0)
+                oTileDetector.apply(oTileInput,oTileOutput);
+            else
+                oTileDetector.apply_threshold(oTileInput,oTileOutput,dDetThreshold);
+            oTileOutput(oInnerRect-oHaloRect.tl()).copyTo(oEdgeMask(oInnerRect));
+        }
+    };
+    if(m_pThreadPool && nLanes>1)
+        m_pThreadPool->parallel_for(nLanes,lLaneProcess);
+    else
+        lLaneProcess(0);
+}
+
 void EdgeDetectorLBSP::apply_threshold(cv::InputArray _oInputImage, cv::OutputArray _oEdgeMask, double dDetThreshold) {
     cv::Mat oInputImg = _oInputImage.getMat();
     lvAssert_(!oInputImg.empty() && oInputImg.isContinuous(),"input image must be non-empty and continuous");
     lvAssert_(oInputImg.depth()==CV_8U,"input image depth must be 8U")
+    if(m_nTileSize>0 && (oInputImg.cols>(int)m_nTileSize || oInputImg.rows>(int)m_nTileSize)) {
+        _oEdgeMask.create(oInputImg.size(),CV_8UC1);
+        cv::Mat oEdgeMask = _oEdgeMask.getMat();
+        apply_tiled(oInputImg,oEdgeMask,(dDetThreshold<0||dDetThreshold>1)?getDefaultThreshold():dDetThreshold);
+        return;
+    }
     if(m_dGaussianKernelSigma>0) {
         const int nDefaultKernelSize = int(8*ceil(m_dGaussianKernelSigma));
         const int nRealKernelSize = nDefaultKernelSize%2==0?nDefaultKernelSize+1:nDefaultKernelSize;
-        oInputImg = oInputImg.clone();
-        cv::GaussianBlur(oInputImg,oInputImg,cv::Size(nRealKernelSize,nRealKernelSize),m_dGaussianKernelSigma,m_dGaussianKernelSigma);
+        cv::GaussianBlur(oInputImg,m_oBlurredInputImg,cv::Size(nRealKernelSize,nRealKernelSize),m_dGaussianKernelSigma,m_dGaussianKernelSigma);
+        oInputImg = m_oBlurredInputImg; // kept as the level-0 pyramid map (nms reads its reference colors)
     }
     _oEdgeMask.create(oInputImg.size(),CV_8UC1);
     cv::Mat oEdgeMask = _oEdgeMask.getMat();
     if(dDetThreshold<0||dDetThreshold>1)
         dDetThreshold = getDefaultThreshold();
     const uchar nDetThreshold = (uchar)(dDetThreshold*LBSP::MAX_GRAD_MAG);
-    apply_internal_lookup(oInputImg,oInputImg.channels());
     apply_internal_threshold(oInputImg,oEdgeMask,nDetThreshold,oInputImg.channels());
 }
 
@@ -397,21 +621,488 @@ void EdgeDetectorLBSP::apply(cv::InputArray _oInputImage, cv::OutputArray _oEdge
     cv::Mat oInputImg = _oInputImage.getMat();
     lvAssert_(!oInputImg.empty() && oInputImg.isContinuous(),"input image must be non-empty and continuous");
     lvAssert_(oInputImg.depth()==CV_8U,"input image depth must be 8U")
+    if(m_nTileSize>0 && (oInputImg.cols>(int)m_nTileSize || oInputImg.rows>(int)m_nTileSize)) {
+        _oEdgeMask.create(oInputImg.size(),CV_8UC1);
+        cv::Mat oEdgeMask = _oEdgeMask.getMat();
+        apply_tiled(oInputImg,oEdgeMask,-1);
+        if(m_bNormalizeOutput)
+            cv::normalize(oEdgeMask,oEdgeMask,0,UCHAR_MAX,cv::NORM_MINMAX);
+        return;
+    }
     if(m_dGaussianKernelSigma>0) {
         const int nDefaultKernelSize = int(8*ceil(m_dGaussianKernelSigma));
         const int nRealKernelSize = nDefaultKernelSize%2==0?nDefaultKernelSize+1:nDefaultKernelSize;
-        oInputImg = oInputImg.clone();
-        cv::GaussianBlur(oInputImg,oInputImg,cv::Size(nRealKernelSize,nRealKernelSize),m_dGaussianKernelSigma,m_dGaussianKernelSigma);
+        cv::GaussianBlur(oInputImg,m_oBlurredInputImg,cv::Size(nRealKernelSize,nRealKernelSize),m_dGaussianKernelSigma,m_dGaussianKernelSigma);
+        oInputImg = m_oBlurredInputImg; // kept as the level-0 pyramid map (nms reads its reference colors)
     }
-    apply_internal_lookup(oInputImg,oInputImg.channels());
     _oEdgeMask.create(oInputImg.size(),CV_8UC1);
     cv::Mat oEdgeMask = _oEdgeMask.getMat();
-    oEdgeMask = cv::Scalar_<uchar>(0);
-    cv::Mat oTempEdgeMask = oEdgeMask.clone();
-    for(size_t nCurrThreshold=0; nCurrThreshold<LBSP::MAX_GRAD_MAG; ++nCurrThreshold) {
-        apply_internal_threshold(oInputImg,oTempEdgeMask,uchar(nCurrThreshold),oInputImg.channels());
-        oEdgeMask += oTempEdgeMask/double(LBSP::MAX_GRAD_MAG);
+    // equivalent to accumulating apply_threshold(t) for all t in [0,LBSP::MAX_GRAD_MAG), but gradients & nms are computed once
+    // (local maxima do not depend on t), and the per-pixel survival threshold comes from a single hysteresis sweep
+    apply_internal_stages(oInputImg,uchar(0));
+    const cv::Mat oLabelMap = getEdgeLabelMap(oInputImg.size());
+    constexpr size_t nNMSHalfWinSize = (USE_5x5_NON_MAX_SUPP?LBSP::PATCH_SIZE:3)>>1;
+    constexpr size_t nGradMapColStep = 4;
+    const size_t nGradMapRowStep = (oInputImg.cols+nNMSHalfWinSize*2)*nGradMapColStep;
+    // highest threshold t for which a given magnitude still passes the low hysteresis threshold
+    std::array<float,UCHAR_MAX+1> afPassLevelLUT;
+    for(size_t nGradMag=0; nGradMag<=UCHAR_MAX; ++nGradMag) {
+        size_t nMaxThreshold = 0;
+        while(nMaxThreshold+1<LBSP::MAX_GRAD_MAG && (uchar)((nMaxThreshold+1)*m_dHystLowThrshFactor)<=nGradMag)
+            ++nMaxThreshold;
+        afPassLevelLUT[nGradMag] = float(nMaxThreshold);
+    }
+    m_oSweepPassLevelMap.create(oInputImg.size(),CV_32FC1);
+    m_oSweepSeedLevelMap.create(oInputImg.size(),CV_32FC1);
+    for(int nRowIter=0; nRowIter<oInputImg.rows; ++nRowIter) {
+        // the nms pass writes labels with a half-window row lag w.r.t. the gradient map (see apply_internal_nms)
+        const uchar* const anGradRow = m_vuLBSPGradMapData.data()+(nRowIter+nNMSHalfWinSize*2)*nGradMapRowStep+nNMSHalfWinSize*nGradMapColStep;
+        float* const afPassLevelRow = m_oSweepPassLevelMap.ptr<float>(nRowIter);
+        float* const afSeedLevelRow = m_oSweepSeedLevelMap.ptr<float>(nRowIter);
+        for(int nColIter=0; nColIter<oInputImg.cols; ++nColIter) {
+            const uchar nGradMag = anGradRow[nColIter*nGradMapColStep+2];
+            afPassLevelRow[nColIter] = afPassLevelLUT[nGradMag];
+            afSeedLevelRow[nColIter] = float(nGradMag);
+        }
+    }
+    m_oHysteresis.sweep(oLabelMap,m_oSweepPassLevelMap,m_oSweepSeedLevelMap,m_oSweepLevelMap);
+    const int nThresholdStep = cvRound(double(UCHAR_MAX)/LBSP::MAX_GRAD_MAG); // same per-threshold increment as accumulating 'mask/MAX_GRAD_MAG'
+    for(int nRowIter=0; nRowIter<oInputImg.rows; ++nRowIter) {
+        const float* const afSweepLevelRow = m_oSweepLevelMap.ptr<float>(nRowIter);
+        uchar* const anEdgeMaskRow = oEdgeMask.ptr<uchar>(nRowIter);
+        for(int nColIter=0; nColIter<oInputImg.cols; ++nColIter) // pixel survives all integer thresholds t<=level
+            anEdgeMaskRow[nColIter] = cv::saturate_cast<uchar>((int(afSweepLevelRow[nColIter])+1)*nThresholdStep);
     }
     if(m_bNormalizeOutput)
         cv::normalize(oEdgeMask,oEdgeMask,0,UCHAR_MAX,cv::NORM_MINMAX);
 }
+
+void EdgeDetectorLBSP::apply_oriented(cv::InputArray _oInputImage, cv::OutputArray _oEdgeMask, cv::OutputArray _oOrientMap, cv::OutputArray _oSubPixOffsetMap, double dDetThreshold) {
+    const cv::Size oInputSize = _oInputImage.size();
+    lvAssert_(m_nTileSize==0 || (oInputSize.width<=(int)m_nTileSize && oInputSize.height<=(int)m_nTileSize),"oriented output requires the whole image gradient map (no tiling)");
+    if(dDetThreshold<0)
+        apply(_oInputImage,_oEdgeMask);
+    else
+        apply_threshold(_oInputImage,_oEdgeMask,dDetThreshold);
+    const cv::Mat oEdgeMask = _oEdgeMask.getMat();
+    _oOrientMap.create(oInputSize,CV_32FC1);
+    _oSubPixOffsetMap.create(oInputSize,CV_32FC2);
+    cv::Mat oOrientMap = _oOrientMap.getMat(), oSubPixOffsetMap = _oSubPixOffsetMap.getMat();
+    constexpr int nNMSHalfWinSize = (USE_5x5_NON_MAX_SUPP?LBSP::PATCH_SIZE:3)>>1;
+    constexpr int nGradMapColStep = 4;
+    const int nGradMapRows = oInputSize.height+nNMSHalfWinSize*2;
+    const int nGradMapRowStep = (oInputSize.width+nNMSHalfWinSize*2)*nGradMapColStep;
+    lvDbgAssert(m_vuLBSPGradMapData.size()==size_t(nGradMapRows*nGradMapRowStep));
+    const auto lGradPtr = [&](int nGradMapRowIdx, int nColIter) {
+        // neighbors are clamped to the padded gradient map bounds
+        nGradMapRowIdx = std::min(std::max(nGradMapRowIdx,0),nGradMapRows-1);
+        nColIter = std::min(std::max(nColIter,-nNMSHalfWinSize),oInputSize.width+nNMSHalfWinSize-1);
+        return m_vuLBSPGradMapData.data()+nGradMapRowIdx*nGradMapRowStep+(nColIter+nNMSHalfWinSize)*nGradMapColStep;
+    };
+    const float fTan22 = float(std::tan(CV_PI/8)), fTan67 = float(std::tan(CV_PI*3/8));
+    for(int nRowIter=0; nRowIter<oInputSize.height; ++nRowIter) {
+        // the nms pass writes labels with a half-window row lag w.r.t. the gradient map (see apply_internal_nms)
+        const int nGradMapRowIdx = nRowIter+nNMSHalfWinSize*2;
+        const uchar* const anEdgeMaskRow = oEdgeMask.ptr<uchar>(nRowIter);
+        float* const afOrientRow = oOrientMap.ptr<float>(nRowIter);
+        cv::Vec2f* const avSubPixOffsetRow = oSubPixOffsetMap.ptr<cv::Vec2f>(nRowIter);
+        for(int nColIter=0; nColIter<oInputSize.width; ++nColIter) {
+            const uchar* const anGrad = lGradPtr(nGradMapRowIdx,nColIter);
+            const float fGradX = float((char)anGrad[0]), fGradY = float((char)anGrad[1]);
+            afOrientRow[nColIter] = std::atan2(fGradY,fGradX);
+            avSubPixOffsetRow[nColIter] = cv::Vec2f(0.0f,0.0f);
+            if(!anEdgeMaskRow[nColIter] || (fGradX==0.0f && fGradY==0.0f))
+                continue;
+            // gradient axis quantized to the 8-neighborhood, then a parabola is fit on the three magnitudes along it
+            const float fAbsGradX = std::abs(fGradX), fAbsGradY = std::abs(fGradY);
+            const int nAxisX = (fAbsGradY>fAbsGradX*fTan67)?0:(fGradX>0?1:-1);
+            const int nAxisY = (fAbsGradY<fAbsGradX*fTan22)?0:(fGradY>0?1:-1);
+            const float fPrevMag = float(lGradPtr(nGradMapRowIdx-nAxisY,nColIter-nAxisX)[2]);
+            const float fCurrMag = float(anGrad[2]);
+            const float fNextMag = float(lGradPtr(nGradMapRowIdx+nAxisY,nColIter+nAxisX)[2]);
+            const float fCurvature = fPrevMag-2*fCurrMag+fNextMag;
+            if(fCurvature>=0.0f) // not a strict peak along the axis
+                continue;
+            const float fOffset = std::min(std::max(0.5f*(fPrevMag-fNextMag)/fCurvature,-0.5f),0.5f);
+            avSubPixOffsetRow[nColIter] = cv::Vec2f(fOffset*nAxisX,fOffset*nAxisY);
+        }
+    }
+}
+
+void EdgeDetectorLBSP::applyBatch(const std::vector<cv::Mat>& vInputImages, std::vector<cv::Mat>& vEdgeMasks, double dThreshold) {
+    const size_t nLanes = std::min(getThreadCount(),vInputImages.size());
+    if(m_nTileSize>0 || !m_pThreadPool || nLanes<=1) {
+        // tiled images already spread their work over all lanes
+        IEdgeDetector::applyBatch(vInputImages,vEdgeMasks,dThreshold);
+        return;
+    }
+    vEdgeMasks.resize(vInputImages.size());
+    initLaneDetectors(nLanes);
+    // each lane gets a contiguous chunk of the size-sorted batch, so its detector rarely has to resize its buffers
+    const std::vector<size_t> vnImageIdxs = getBatchSizeOrder(vInputImages);
+    const auto lLaneProcess = [&](size_t nLaneIdx) {
+        EdgeDetectorLBSP& oLaneDetector = *m_vpTileDetectors[nLaneIdx];
+        const size_t nChunkBegin = nLaneIdx*vnImageIdxs.size()/nLanes;
+        const size_t nChunkEnd = (nLaneIdx+1)*vnImageIdxs.size()/nLanes;
+        for(size_t nChunkIter=nChunkBegin; nChunkIter<nChunkEnd; ++nChunkIter) {
+            const size_t nImageIdx = vnImageIdxs[nChunkIter];
+            if(dThreshold<0) {
+                oLaneDetector.apply(vInputImages[nImageIdx],vEdgeMasks[nImageIdx]);
+                if(m_bNormalizeOutput)
+                    cv::normalize(vEdgeMasks[nImageIdx],vEdgeMasks[nImageIdx],0,UCHAR_MAX,cv::NORM_MINMAX);
+            }
+            else
+                oLaneDetector.apply_threshold(vInputImages[nImageIdx],vEdgeMasks[nImageIdx],dThreshold);
+        }
+    };
+    m_pThreadPool->parallel_for(nLanes,lLaneProcess);
+}
+
+#if HAVE_GLSL
+
+EdgeDetectorLBSP_GLSL::EdgeDetectorLBSP_(size_t nLevels, double dHystLowThrshFactor) :
+        IEdgeDetector_GLSL(1,nLevels+3,0,1,3,0,-1,false,EDGLBSP_GLSL_USE_TIMERS,true),
+        m_nPyrLevels(nLevels),
+        m_dHystLowThrshFactor(dHystLowThrshFactor),
+        m_nImgChannels(0),
+        m_nLastHystIterCount(0) {
+    lvAssert_(m_dHystLowThrshFactor>0 && m_dHystLowThrshFactor<1,"lower hysteresis threshold factor must be between 0 and 1");
+    lvAssert_(m_nPyrLevels>0,"number of pyramid levels must be positive");
+    m_nROIBorderSize = LBSP::PATCH_SIZE/2;
+}
+
+void EdgeDetectorLBSP_GLSL::initialize_gl(const cv::Mat& oInitInput, const cv::Mat& oROI) {
+    lvDbgExceptionWatch;
+    lvAssert_(!oInitInput.empty() && oInitInput.isContinuous(),"input image must be non-empty and continuous");
+    lvAssert_(oInitInput.type()==CV_8UC1 || oInitInput.type()==CV_8UC4,"input image type must be 8UC1 or 8UC4 (pad 3-channel images to 4 bytes)");
+    m_nImgChannels = size_t(oInitInput.channels());
+    m_voMapSizeList.resize(m_nPyrLevels);
+    m_vnPyrAtlasOffsets.resize(m_nPyrLevels);
+    m_voMapSizeList[0] = oInitInput.size();
+    m_vnPyrAtlasOffsets[0] = 0;
+    int nPyrAtlasWidth = 0;
+    for(size_t nLevelIter=1; nLevelIter<m_nPyrLevels; ++nLevelIter) {
+        m_voMapSizeList[nLevelIter] = cv::Size((m_voMapSizeList[nLevelIter-1].width+1)/2,(m_voMapSizeList[nLevelIter-1].height+1)/2);
+        m_vnPyrAtlasOffsets[nLevelIter] = nPyrAtlasWidth;
+        nPyrAtlasWidth += m_voMapSizeList[nLevelIter].width;
+    }
+    GLImageProcAlgo::initialize_gl(oInitInput,oROI);
+    if(m_nPyrLevels>1)
+        m_pPyrAtlasTexture = std::make_unique<GLTexture2D>(1,cv::Mat(cv::Size(nPyrAtlasWidth,m_voMapSizeList[1].height),oInitInput.type(),cv::Scalar::all(0)),true);
+    m_pGradTexture = std::make_unique<GLTexture2D>(1,cv::Mat(m_oFrameSize,CV_32SC1,cv::Scalar_<int>(0)),true);
+    m_pLevelTexture = std::make_unique<GLTexture2D>(1,cv::Mat(m_oFrameSize,CV_32SC1,cv::Scalar_<int>(0)),true);
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER,getACBOId(LBSPEdgeAtomicCounterBuffer_HystUpdateBinding));
+    glBufferData(GL_ATOMIC_COUNTER_BUFFER,sizeof(GLuint),NULL,GL_DYNAMIC_READ);
+    glClearBufferData(GL_ATOMIC_COUNTER_BUFFER,GL_R32UI,GL_RED_INTEGER,GL_INT,NULL);
+    glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER,LBSPEdgeAtomicCounterBuffer_HystUpdateBinding,getACBOId(LBSPEdgeAtomicCounterBuffer_HystUpdateBinding));
+    glErrorCheck;
+}
+
+std::string EdgeDetectorLBSP_GLSL::getComputeShaderSource_Pyramid(size_t nLevel) const {
+    lvDbgExceptionWatch;
+    lvDbgAssert(nLevel>0 && nLevel<m_nPyrLevels);
+    const char* sFormatName = (m_nImgChannels==4?"rgba8ui":"r8ui");
+    const cv::Size& oSrcSize = m_voMapSizeList[nLevel-1];
+    const cv::Size& oDstSize = m_voMapSizeList[nLevel];
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "#version 430\n"
+             "#define BORDER_SIZE " << LBSP::PATCH_SIZE/2 << "\n"
+             "#define SRC_SIZE ivec2(" << oSrcSize.width << "," << oSrcSize.height << ")\n"
+             "#define SRC_OFFSET ivec2(" << (nLevel>1?m_vnPyrAtlasOffsets[nLevel-1]:0) << ",0)\n"
+             "#define DST_SIZE ivec2(" << oDstSize.width << "," << oDstSize.height << ")\n"
+             "#define DST_OFFSET ivec2(" << m_vnPyrAtlasOffsets[nLevel] << ",0)\n"
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n";
+    if(nLevel==1) ssSrc <<
+             "layout(binding=" << GLImageProcAlgo::Image_InputBinding << ", " << sFormatName << ") readonly uniform uimage2D mInput;\n"
+             "#define mSrc mInput\n";
+    else ssSrc <<
+             "#define mSrc mPyrAtlas\n";
+    ssSrc << "layout(binding=" << EdgeDetectorLBSP_::LBSPEdgeImage_PyrAtlasBinding << ", " << sFormatName << ") uniform uimage2D mPyrAtlas;\n"
+             "const ivec2 avDBCrossOffsets[16] = ivec2[16](" << s_sDBCrossOffsets_glsl << ");\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "void main() {\n"
+             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    if(any(greaterThanEqual(vImgCoords,DST_SIZE)))\n"
+             "        return;\n"
+             "    ivec2 vSrcCoords = vImgCoords*2;\n"
+             "    uvec4 vPyrVal;\n"
+             // inner pixels are downscaled using their LBSP lookup mean (as in the cpu impl), border pixels are copied
+             "    if(all(greaterThanEqual(vSrcCoords,ivec2(BORDER_SIZE))) && all(lessThan(vSrcCoords,SRC_SIZE-ivec2(BORDER_SIZE)))) {\n"
+             "        uvec4 vLUTSum = uvec4(0);\n"
+             "        for(int n=0; n<16; ++n)\n"
+             "            vLUTSum += imageLoad(mSrc,SRC_OFFSET+vSrcCoords+avDBCrossOffsets[n]);\n"
+             "        vPyrVal = vLUTSum/16u;\n"
+             "    }\n"
+             "    else\n"
+             "        vPyrVal = imageLoad(mSrc,SRC_OFFSET+vSrcCoords);\n"
+             "    imageStore(mPyrAtlas,DST_OFFSET+vImgCoords,vPyrVal);\n"
+             "}\n";
+    return ssSrc.str();
+}
+
+std::string EdgeDetectorLBSP_GLSL::getComputeShaderSource_Gradient() const {
+    lvDbgExceptionWatch;
+    const char* sFormatName = (m_nImgChannels==4?"rgba8ui":"r8ui");
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "#version 430\n"
+             "#define BORDER_SIZE " << LBSP::PATCH_SIZE/2 << "\n"
+             "#define FRAME_SIZE ivec2(" << m_oFrameSize.width << "," << m_oFrameSize.height << ")\n"
+             "#define GRADX_POS_MASK " << s_nDBCrossGradX_Pos << "u\n"
+             "#define GRADX_NEG_MASK " << s_nDBCrossGradX_Neg << "u\n"
+             "#define GRADY_POS_MASK " << s_nDBCrossGradY_Pos << "u\n"
+             "#define GRADY_NEG_MASK " << s_nDBCrossGradY_Neg << "u\n"
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_InputBinding << ", " << sFormatName << ") readonly uniform uimage2D mInput;\n";
+    if(m_nPyrLevels>1) ssSrc <<
+             "layout(binding=" << EdgeDetectorLBSP_::LBSPEdgeImage_PyrAtlasBinding << ", " << sFormatName << ") readonly uniform uimage2D mPyrAtlas;\n";
+    ssSrc << "layout(binding=" << EdgeDetectorLBSP_::LBSPEdgeImage_GradBinding << ", r32ui) writeonly uniform uimage2D mGrad;\n" <<
+             LBSP::getShaderFunctionSource(m_nImgChannels,false,m_vDefaultWorkGroupSize) <<
+             // mirrors LBSP::computeDescriptor_gradient: the channel with the strongest pattern gives the gradient (ties keep the first one)
+             "ivec3 getGradient(in uvec3 vDesc) {\n"
+             "    uint nDesc = 0u, nGradMag = 0u;\n"
+             "    for(int c=0; c<3; ++c) {\n"
+             "        uint nCurrGradMag = uint(bitCount(vDesc[c]));\n"
+             "        if(nCurrGradMag>nGradMag) {\n"
+             "            nGradMag = nCurrGradMag;\n"
+             "            nDesc = vDesc[c];\n"
+             "        }\n"
+             "    }\n"
+             "    return ivec3(bitCount(nDesc&GRADX_POS_MASK)-bitCount(nDesc&GRADX_NEG_MASK),bitCount(nDesc&GRADY_POS_MASK)-bitCount(nDesc&GRADY_NEG_MASK),int(nGradMag));\n"
+             "}\n"
+             // mirrors the cpu impl's coarse-to-fine 'min grad orient' accumulation (finer levels win ties)
+             "ivec3 mergeGradient(in ivec3 vGrad, in ivec3 vLevelGrad) {\n"
+             "    return ivec3(abs(vGrad.x)<abs(vLevelGrad.x)?vGrad.x:vLevelGrad.x,abs(vGrad.y)<abs(vLevelGrad.y)?vGrad.y:vLevelGrad.y,min(vGrad.z,vLevelGrad.z));\n"
+             "}\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "void main() {\n"
+             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    if(any(greaterThanEqual(vImgCoords,FRAME_SIZE)))\n"
+             "        return;\n"
+             "    ivec3 vGrad = ivec3(127,127,255);\n";
+    for(int nLevelIter=(int)m_nPyrLevels-1; nLevelIter>=0; --nLevelIter) {
+        const cv::Size& oLevelSize = m_voMapSizeList[nLevelIter];
+        const char* sLevelImgName = nLevelIter?"mPyrAtlas":"mInput";
+        ssSrc << "    {\n"
+                 "        ivec2 vLevelCoords = vImgCoords>>" << nLevelIter << ";\n"
+                 "        ivec3 vLevelGrad = ivec3(0);\n"
+                 "        if(all(greaterThanEqual(vLevelCoords,ivec2(BORDER_SIZE))) && all(lessThan(vLevelCoords,ivec2(" << oLevelSize.width << "," << oLevelSize.height << ")-ivec2(BORDER_SIZE)))) {\n"
+                 "            ivec2 vAtlasCoords = vLevelCoords+ivec2(" << m_vnPyrAtlasOffsets[nLevelIter] << ",0);\n"
+                 "            uvec3 vRef = imageLoad(" << sLevelImgName << ",vAtlasCoords).rgb;\n"
+                 "            vLevelGrad = getGradient(lbsp(((vRef>>2)+20u)/2u,vRef," << sLevelImgName << ",vAtlasCoords));\n"
+                 "        }\n"
+                 "        vGrad = mergeGradient(vGrad,vLevelGrad);\n"
+                 "    }\n";
+    }
+    ssSrc << "    imageStore(mGrad,vImgCoords,uvec4(uint(vGrad.x+128)|(uint(vGrad.y+128)<<8)|(uint(vGrad.z)<<16)));\n"
+             "}\n";
+    return ssSrc.str();
+}
+
+std::string EdgeDetectorLBSP_GLSL::getComputeShaderSource_NMS() const {
+    lvDbgExceptionWatch;
+    constexpr size_t nNMSHalfWinSize = (USE_5x5_NON_MAX_SUPP?LBSP::PATCH_SIZE:3)>>1;
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "#version 430\n"
+             "#define NMS_HALF_WIN_SIZE " << nNMSHalfWinSize << "\n"
+             "#define FRAME_SIZE ivec2(" << m_oFrameSize.width << "," << m_oFrameSize.height << ")\n"
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
+             "layout(binding=" << EdgeDetectorLBSP_::LBSPEdgeImage_GradBinding << ", r32ui) readonly uniform uimage2D mGrad;\n"
+             "layout(binding=" << EdgeDetectorLBSP_::LBSPEdgeImage_LevelBinding << ", r32ui) writeonly uniform uimage2D mLevels;\n"
+             // highest threshold t for which a given magnitude still passes the low hysteresis threshold (same as the cpu sweep's lut)
+             "const uint anPassLevelLUT[256] = uint[256](";
+    for(size_t nGradMag=0; nGradMag<=UCHAR_MAX; ++nGradMag) {
+        size_t nMaxThreshold = 0;
+        while(nMaxThreshold+1<=LBSP::MAX_GRAD_MAG && (uchar)((nMaxThreshold+1)*m_dHystLowThrshFactor)<=nGradMag)
+            ++nMaxThreshold;
+        ssSrc << nMaxThreshold << (nGradMag<UCHAR_MAX?"u,":"u);\n");
+    }
+    ssSrc << "uint getGradMag(in ivec2 vCoords) {\n"
+             "    return (imageLoad(mGrad,vCoords).r>>16)&255u;\n"
+             "}\n"
+             "bool isLocalMaximum(in ivec2 vCoords, in uint nGradMag, in ivec2 vStep) {\n"
+             "    for(int n=1; n<=NMS_HALF_WIN_SIZE; ++n)\n"
+             "        if(nGradMag<=getGradMag(vCoords-vStep*n) || nGradMag<getGradMag(vCoords+vStep*n))\n"
+             "            return false;\n"
+             "    return true;\n"
+             "}\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "void main() {\n"
+             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    if(any(greaterThanEqual(vImgCoords,FRAME_SIZE)))\n"
+             "        return;\n"
+             // mirrors the cpu impl's half-window row lag between the gradient map & the label map
+             "    ivec2 vGradCoords = vImgCoords+ivec2(0,NMS_HALF_WIN_SIZE);\n"
+             "    uint nGrad = imageLoad(mGrad,vGradCoords).r;\n"
+             "    int nGradX = int(nGrad&255u)-128, nGradY = int((nGrad>>8)&255u)-128;\n"
+             "    uint nGradMag = (nGrad>>16)&255u;\n"
+             // 3-axis oriented local maximum check, as in lv::isLocalMaximum_Oriented (tan(pi/8) in 17.15 fixed point)
+             "    uint nGradX_abs = uint(abs(nGradX)), nGradY_abs = uint(abs(nGradY))<<15;\n"
+             "    uint nTG22GradX = nGradX_abs*13573u;\n"
+             "    bool bLocalMax;\n"
+             "    if(nGradY_abs<nTG22GradX)\n"
+             "        bLocalMax = isLocalMaximum(vGradCoords,nGradMag,ivec2(1,0));\n"
+             "    else if(nGradY_abs>nTG22GradX+(nGradX_abs<<16))\n"
+             "        bLocalMax = isLocalMaximum(vGradCoords,nGradMag,ivec2(0,1));\n"
+             "    else if(nGradX!=0 || nGradY!=0)\n"
+             "        bLocalMax = isLocalMaximum(vGradCoords,nGradMag,(nGradX^nGradY)>=0?ivec2(-1,1):ivec2(1,1));\n"
+             "    else\n"
+             "        bLocalMax = isLocalMaximum(vGradCoords,nGradMag,ivec2(-1,1)) || isLocalMaximum(vGradCoords,nGradMag,ivec2(1,1));\n"
+             // packed level: pass level in bits 8+, (survival level + 1) in bits 0-7 (initialized from the pixel's own seed level), or 0 if not an edge
+             "    uint nPassLevel = anPassLevelLUT[nGradMag];\n"
+             "    imageStore(mLevels,vImgCoords,uvec4(bLocalMax?((nPassLevel<<8)|(min(nGradMag,nPassLevel)+1u)):0u));\n"
+             "}\n";
+    return ssSrc.str();
+}
+
+std::string EdgeDetectorLBSP_GLSL::getComputeShaderSource_Hysteresis() const {
+    lvDbgExceptionWatch;
+    const glm::uvec2 vTileSize = m_vDefaultWorkGroupSize+glm::uvec2(2);
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "#version 430\n"
+             "#define TILE_WIDTH " << vTileSize.x << "\n"
+             "#define TILE_AREA " << vTileSize.x*vTileSize.y << "\n"
+             "#define WORKGROUP_AREA " << m_vDefaultWorkGroupSize.x*m_vDefaultWorkGroupSize.y << "\n"
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
+             "layout(binding=" << EdgeDetectorLBSP_::LBSPEdgeImage_LevelBinding << ", r32ui) coherent uniform uimage2D mLevels;\n"
+             "layout(binding=" << EdgeDetectorLBSP_::LBSPEdgeAtomicCounterBuffer_HystUpdateBinding << ", offset=0) uniform atomic_uint nUpdateCount;\n"
+             "shared uint anTile[" << vTileSize.y << "][" << vTileSize.x << "];\n"
+             "shared bool bTileUpdated;\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // each px keeps the best level among its 8-neighbors' (capped by its own pass level); levels only increase, so
+    // stale reads across workgroups are harmless, and tiles are first relaxed locally (in shared mem) until stable
+    ssSrc << "void main() {\n"
+             "    ivec2 vTileOrigin = ivec2(gl_WorkGroupID.xy*gl_WorkGroupSize.xy)-ivec2(1);\n"
+             "    for(uint n=gl_LocalInvocationIndex; n<TILE_AREA; n+=WORKGROUP_AREA)\n"
+             "        anTile[n/TILE_WIDTH][n%TILE_WIDTH] = imageLoad(mLevels,vTileOrigin+ivec2(n%TILE_WIDTH,n/TILE_WIDTH)).r;\n"
+             "    if(gl_LocalInvocationIndex==0)\n"
+             "        bTileUpdated = false;\n"
+             "    memoryBarrierShared();\n"
+             "    barrier();\n"
+             "    ivec2 vTileCoords = ivec2(gl_LocalInvocationID.xy)+ivec2(1);\n"
+             "    uint nInitVal = anTile[vTileCoords.y][vTileCoords.x];\n"
+             "    uint nPassLevel = (nInitVal>>8)+1u;\n"
+             "    for(uint nIter=0; nIter<WORKGROUP_AREA; ++nIter) {\n"
+             "        uint nCurrVal = anTile[vTileCoords.y][vTileCoords.x];\n"
+             "        if(nCurrVal!=0u) {\n"
+             "            uint nLevel = nCurrVal&255u;\n"
+             "            for(int y=-1; y<=1; ++y)\n"
+             "                for(int x=-1; x<=1; ++x)\n"
+             "                    nLevel = max(nLevel,min(anTile[vTileCoords.y+y][vTileCoords.x+x]&255u,nPassLevel));\n"
+             "            if(nLevel>(nCurrVal&255u)) {\n"
+             "                anTile[vTileCoords.y][vTileCoords.x] = (nCurrVal&~255u)|nLevel;\n"
+             "                bTileUpdated = true;\n"
+             "            }\n"
+             "        }\n"
+             "        memoryBarrierShared();\n"
+             "        barrier();\n"
+             "        bool bUpdated = bTileUpdated;\n"
+             "        barrier();\n"
+             "        if(!bUpdated)\n"
+             "            break;\n"
+             "        if(gl_LocalInvocationIndex==0)\n"
+             "            bTileUpdated = false;\n"
+             "        memoryBarrierShared();\n"
+             "        barrier();\n"
+             "    }\n"
+             "    uint nFinalVal = anTile[vTileCoords.y][vTileCoords.x];\n"
+             "    if(nFinalVal!=nInitVal) {\n"
+             "        imageStore(mLevels,vTileOrigin+vTileCoords,uvec4(nFinalVal));\n"
+             "        atomicCounterIncrement(nUpdateCount);\n"
+             "    }\n"
+             "}\n";
+    return ssSrc.str();
+}
+
+std::string EdgeDetectorLBSP_GLSL::getComputeShaderSource_Output() const {
+    lvDbgExceptionWatch;
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "#version 430\n"
+             "#define FRAME_SIZE ivec2(" << m_oFrameSize.width << "," << m_oFrameSize.height << ")\n"
+             "#define THRESHOLD_STEP " << cvRound(double(UCHAR_MAX)/LBSP::MAX_GRAD_MAG) << "\n"
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
+             "layout(binding=" << EdgeDetectorLBSP_::LBSPEdgeImage_LevelBinding << ", r32ui) readonly uniform uimage2D mLevels;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_OutputBinding << ", r8ui) writeonly uniform uimage2D mOutput;\n"
+             "uniform int nDetThreshold;\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "void main() {\n"
+             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    if(any(greaterThanEqual(vImgCoords,FRAME_SIZE)))\n"
+             "        return;\n"
+             "    int nLevel = int(imageLoad(mLevels,vImgCoords).r&255u)-1;\n"
+             // binary mask if a threshold is given, or confidence mask (same steps as the cpu impl's sweep output) otherwise
+             "    uint nOutput = nDetThreshold>=0?(nLevel>=nDetThreshold?255u:0u):uint(clamp((nLevel+1)*THRESHOLD_STEP,0,255));\n"
+             "    imageStore(mOutput,vImgCoords,uvec4(nOutput));\n"
+             "}\n";
+    return ssSrc.str();
+}
+
+std::string EdgeDetectorLBSP_GLSL::getComputeShaderSource(size_t nStage) const {
+    lvDbgExceptionWatch;
+    lvAssert_(!m_voMapSizeList.empty(),"algo must be initialized first");
+    lvAssert_(nStage<m_nComputeStages,"required compute stage does not exist");
+    if(nStage+1<m_nPyrLevels)
+        return getComputeShaderSource_Pyramid(nStage+1);
+    else if(nStage+1==m_nPyrLevels)
+        return getComputeShaderSource_Gradient();
+    else if(nStage==m_nPyrLevels)
+        return getComputeShaderSource_NMS();
+    else if(nStage==m_nPyrLevels+1)
+        return getComputeShaderSource_Hysteresis();
+    else //nStage==m_nPyrLevels+2
+        return getComputeShaderSource_Output();
+}
+
+void EdgeDetectorLBSP_GLSL::dispatch(size_t nStage, GLShader& oShader) {
+    lvDbgExceptionWatch;
+    lvAssert_(nStage<m_nComputeStages,"required compute stage does not exist");
+    const auto lDispatch = [&](const cv::Size& oSize) {
+        glDispatchCompute((GLuint)ceil((float)oSize.width/m_vDefaultWorkGroupSize.x),(GLuint)ceil((float)oSize.height/m_vDefaultWorkGroupSize.y),1);
+    };
+    if(nStage==0) {
+        if(m_pPyrAtlasTexture)
+            m_pPyrAtlasTexture->bindToImage(EdgeDetectorLBSP_::LBSPEdgeImage_PyrAtlasBinding,0,GL_READ_WRITE);
+        m_pGradTexture->bindToImage(EdgeDetectorLBSP_::LBSPEdgeImage_GradBinding,0,GL_READ_WRITE);
+        m_pLevelTexture->bindToImage(EdgeDetectorLBSP_::LBSPEdgeImage_LevelBinding,0,GL_READ_WRITE);
+    }
+    else
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    if(nStage+1<m_nPyrLevels)
+        lDispatch(m_voMapSizeList[nStage+1]);
+    else if(nStage==m_nPyrLevels+1) {
+        // propagation dispatches are batched between convergence checks, as each counter readback stalls the pipeline
+        const GLuint nACBOId = getACBOId(EdgeDetectorLBSP_::LBSPEdgeAtomicCounterBuffer_HystUpdateBinding);
+        const size_t nMaxIterCount = size_t(m_oFrameSize.area())*(LBSP::MAX_GRAD_MAG+1); // levels only increase, so this can never be reached
+        glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER,EdgeDetectorLBSP_::LBSPEdgeAtomicCounterBuffer_HystUpdateBinding,nACBOId);
+        m_nLastHystIterCount = 0;
+        GLuint nUpdateCount = 0;
+        do {
+            glBindBuffer(GL_ATOMIC_COUNTER_BUFFER,nACBOId);
+            glClearBufferData(GL_ATOMIC_COUNTER_BUFFER,GL_R32UI,GL_RED_INTEGER,GL_INT,NULL);
+            glMemoryBarrier(GL_ATOMIC_COUNTER_BARRIER_BIT);
+            for(size_t nIter=0; nIter<EDGLBSP_GLSL_HYST_CHECK_INTERVAL; ++nIter) {
+                lDispatch(m_oFrameSize);
+                glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+            }
+            m_nLastHystIterCount += EDGLBSP_GLSL_HYST_CHECK_INTERVAL;
+            glMemoryBarrier(GL_ATOMIC_COUNTER_BARRIER_BIT|GL_BUFFER_UPDATE_BARRIER_BIT);
+            glGetBufferSubData(GL_ATOMIC_COUNTER_BUFFER,0,sizeof(GLuint),&nUpdateCount);
+        } while(nUpdateCount>0 && m_nLastHystIterCount<nMaxIterCount);
+    }
+    else if(nStage==m_nPyrLevels+2) {
+        if(m_dCurrThreshold<0)
+            oShader.setUniform1i("nDetThreshold",-1);
+        else
+            oShader.setUniform1i("nDetThreshold",(GLint)((m_dCurrThreshold>1?getDefaultThreshold():m_dCurrThreshold)*LBSP::MAX_GRAD_MAG));
+        lDispatch(m_oFrameSize);
+    }
+    else
+        lDispatch(m_oFrameSize);
+    glErrorCheck;
+}
+
+#endif //HAVE_GLSL
@@ -0,0 +1,220 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/imgproc/MultimodalRegistrator.hpp"
+#include <opencv2/calib3d.hpp>
+
+namespace {
+
+    /// resamples a closed contour uniformly (by arc length), starting from its topmost point
+    template<size_t nSamples>
+    void resampleContour(const std::vector<cv::Point>& voContour, std::array<cv::Point2f,nSamples>& aSamples) {
+        lvDbgAssert(!voContour.empty());
+        const size_t nPts = voContour.size();
+        size_t nStartIdx = 0;
+        for(size_t nPtIdx=1; nPtIdx<nPts; ++nPtIdx)
+            if(voContour[nPtIdx].y<voContour[nStartIdx].y || (voContour[nPtIdx].y==voContour[nStartIdx].y && voContour[nPtIdx].x<voContour[nStartIdx].x))
+                nStartIdx = nPtIdx;
+        const double dPerimeter = cv::arcLength(voContour,true);
+        const double dStep = dPerimeter/nSamples;
+        double dCurrLength = 0.0, dNextSampleLength = 0.0;
+        size_t nSampleIdx = 0;
+        for(size_t nOffset=0; nOffset<nPts && nSampleIdx<nSamples; ++nOffset) {
+            const cv::Point2f oCurrPt = voContour[(nStartIdx+nOffset)%nPts];
+            const cv::Point2f oNextPt = voContour[(nStartIdx+nOffset+1)%nPts];
+            const double dSegLength = cv::norm(oNextPt-oCurrPt);
+            while(nSampleIdx<nSamples && dNextSampleLength<=dCurrLength+dSegLength) {
+                const float fAlpha = dSegLength>0?float((dNextSampleLength-dCurrLength)/dSegLength):0.0f;
+                aSamples[nSampleIdx++] = oCurrPt+(oNextPt-oCurrPt)*fAlpha;
+                dNextSampleLength += dStep;
+            }
+            dCurrLength += dSegLength;
+        }
+        // degenerate (e.g. single-pixel) contours might leave trailing samples unset
+        for(; nSampleIdx<nSamples; ++nSampleIdx)
+            aSamples[nSampleIdx] = voContour[nStartIdx];
+    }
+
+    inline cv::Point2f projectPoint(const cv::Matx33d& oHomography, const cv::Point2f& oPt) {
+        const cv::Vec3d vPt = oHomography*cv::Vec3d(oPt.x,oPt.y,1.0);
+        return (vPt[2]!=0.0)?cv::Point2f(float(vPt[0]/vPt[2]),float(vPt[1]/vPt[2])):cv::Point2f(FLT_MAX,FLT_MAX);
+    }
+
+} // namespace
+
+lv::MultimodalRegistrator::MultimodalRegistrator() :
+        m_oTransformMatx(cv::Matx33d::eye()),
+        m_nTransformVersion(0) {}
+
+bool lv::MultimodalRegistrator::process(const cv::Mat& oForeground0, const cv::Mat& oForeground1) {
+    lvAssert_(!oForeground0.empty() && oForeground0.type()==CV_8UC1 && !oForeground1.empty() && oForeground1.type()==CV_8UC1,"foreground masks must be non-empty 8UC1 images");
+    const std::array<const cv::Mat*,s_nModalityCount> apForegrounds = {&oForeground0,&oForeground1};
+    // contour extraction dominates the per-frame cost, and modalities are independent
+    const auto lExtractTask = [&](size_t nModalityIdx) {extractBlobs(nModalityIdx,*apForegrounds[nModalityIdx]);};
+    m_oWorkerPool.submitBulk(s_nModalityCount,lExtractTask,m_oWorkerLatch);
+    m_oWorkerLatch.wait();
+    if(!matchBlobs(m_oCurrCorresp) || !isNewCorrespSet(m_oCurrCorresp))
+        return false;
+    m_vLastCentroids0.clear();
+    m_vLastCentroids1.clear();
+    for(size_t nPairIdx=0; nPairIdx<m_oCurrCorresp.vPts0.size()/(MMREGISTR_CONTOUR_SAMPLE_COUNT+1); ++nPairIdx) {
+        m_vLastCentroids0.push_back(m_oCurrCorresp.vPts0[nPairIdx*(MMREGISTR_CONTOUR_SAMPLE_COUNT+1)]);
+        m_vLastCentroids1.push_back(m_oCurrCorresp.vPts1[nPairIdx*(MMREGISTR_CONTOUR_SAMPLE_COUNT+1)]);
+    }
+    if(m_qoReservoir.size()>=MMREGISTR_RESERVOIR_SIZE)
+        m_qoReservoir.pop_front();
+    m_qoReservoir.push_back(m_oCurrCorresp);
+    // new correspondences that agree with the current homography only reinforce the reservoir
+    if(!m_oTransform.empty() && getReprojError(m_oCurrCorresp)<MMREGISTR_REFIT_MIN_REPROJ_ERROR)
+        return false;
+    return refitTransform();
+}
+
+const std::vector<std::vector<cv::Point>>& lv::MultimodalRegistrator::getContours(size_t nModalityIdx) const {
+    lvAssert_(nModalityIdx<s_nModalityCount,"modality index out of range");
+    return m_avvoContours[nModalityIdx];
+}
+
+void lv::MultimodalRegistrator::warp(const cv::Mat& oInput, cv::Mat& oOutput, const cv::Size& oOutputSize, int nInterpFlag, bool bCropToContent) {
+    lvAssert_(!m_oTransform.empty(),"homography must be estimated first");
+    lvAssert_(nInterpFlag==cv::INTER_NEAREST || nInterpFlag==cv::INTER_LINEAR,"only nearest and linear interpolations are supported");
+    lv::PerspectiveWarper& oWarper = m_aoWarpers[nInterpFlag==cv::INTER_LINEAR];
+    oWarper.setTransform(m_oTransform,oOutputSize,nInterpFlag|cv::WARP_INVERSE_MAP); // no-op unless re-fitted (or resized) since the last call
+    oWarper.apply(oInput,oOutput,bCropToContent);
+}
+
+void lv::MultimodalRegistrator::reset() {
+    m_qoReservoir.clear();
+    m_vLastCentroids0.clear();
+    m_vLastCentroids1.clear();
+    m_oTransform.release();
+    m_oTransform_inv.release();
+    m_oTransformMatx = cv::Matx33d::eye();
+    ++m_nTransformVersion;
+}
+
+void lv::MultimodalRegistrator::extractBlobs(size_t nModalityIdx, const cv::Mat& oForeground) {
+    cv::Mat& oBuffer = m_aoForegroundBuffers[nModalityIdx];
+    cv::compare(oForeground,0,oBuffer,cv::CMP_GT); // copy, as findContours may modify its input
+    std::vector<std::vector<cv::Point>>& vvoContours = m_avvoContours[nModalityIdx];
+    cv::findContours(oBuffer,vvoContours,cv::RETR_EXTERNAL,cv::CHAIN_APPROX_NONE);
+    std::vector<BlobInfo>& voBlobs = m_avoBlobs[nModalityIdx];
+    voBlobs.clear();
+    for(const std::vector<cv::Point>& voContour : vvoContours) {
+        const cv::Moments oMoments = cv::moments(voContour);
+        if(oMoments.m00<MMREGISTR_MIN_BLOB_AREA)
+            continue;
+        voBlobs.emplace_back();
+        BlobInfo& oBlob = voBlobs.back();
+        oBlob.oCentroid = cv::Point2f(float(oMoments.m10/oMoments.m00),float(oMoments.m01/oMoments.m00));
+        oBlob.dArea = oMoments.m00;
+        resampleContour(voContour,oBlob.aContourSamples);
+    }
+    std::sort(voBlobs.begin(),voBlobs.end(),[](const BlobInfo& a, const BlobInfo& b){return a.dArea>b.dArea;});
+    if(voBlobs.size()>MMREGISTR_MAX_BLOB_COUNT)
+        voBlobs.resize(MMREGISTR_MAX_BLOB_COUNT);
+}
+
+bool lv::MultimodalRegistrator::matchBlobs(CorrespSet& oCorresp) const {
+    oCorresp.vPts0.clear();
+    oCorresp.vPts1.clear();
+    const std::vector<BlobInfo>& voBlobs0 = m_avoBlobs[0];
+    const std::vector<BlobInfo>& voBlobs1 = m_avoBlobs[1];
+    if(voBlobs0.empty() || voBlobs1.empty())
+        return false;
+    std::vector<std::pair<size_t,size_t>> vPairs;
+    if(!m_oTransform.empty()) {
+        // once the homography is known, each modality #1 blob is paired w/ the projected nearest modality #0 blob (w/o reuse)
+        std::vector<bool> vbUsed0(voBlobs0.size(),false);
+        for(size_t nBlobIdx1=0; nBlobIdx1<voBlobs1.size(); ++nBlobIdx1) {
+            const cv::Point2f oProjCentroid = projectPoint(m_oTransformMatx,voBlobs1[nBlobIdx1].oCentroid);
+            size_t nBestIdx0 = SIZE_MAX;
+            double dBestDist = std::sqrt(voBlobs0[0].dArea); // blobs farther than a blob 'radius' are never paired
+            for(size_t nBlobIdx0=0; nBlobIdx0<voBlobs0.size(); ++nBlobIdx0) {
+                const double dDist = cv::norm(voBlobs0[nBlobIdx0].oCentroid-oProjCentroid);
+                if(!vbUsed0[nBlobIdx0] && dDist<dBestDist) {
+                    dBestDist = dDist;
+                    nBestIdx0 = nBlobIdx0;
+                }
+            }
+            if(nBestIdx0!=SIZE_MAX) {
+                vbUsed0[nBestIdx0] = true;
+                vPairs.emplace_back(nBestIdx0,nBlobIdx1);
+            }
+        }
+    }
+    else if(voBlobs0.size()==voBlobs1.size()) {
+        // without a homography, only unambiguous frames (same blob count) are used, w/ blobs paired in horizontal order
+        std::vector<size_t> vIdxs0(voBlobs0.size()),vIdxs1(voBlobs1.size());
+        std::iota(vIdxs0.begin(),vIdxs0.end(),size_t(0));
+        std::iota(vIdxs1.begin(),vIdxs1.end(),size_t(0));
+        std::sort(vIdxs0.begin(),vIdxs0.end(),[&](size_t a, size_t b){return voBlobs0[a].oCentroid.x<voBlobs0[b].oCentroid.x;});
+        std::sort(vIdxs1.begin(),vIdxs1.end(),[&](size_t a, size_t b){return voBlobs1[a].oCentroid.x<voBlobs1[b].oCentroid.x;});
+        for(size_t nPairIdx=0; nPairIdx<vIdxs0.size(); ++nPairIdx)
+            vPairs.emplace_back(vIdxs0[nPairIdx],vIdxs1[nPairIdx]);
+    }
+    // each pair contributes its centroids first (used for change detection), then its contour samples
+    for(const auto& oPair : vPairs) {
+        const BlobInfo& oBlob0 = voBlobs0[oPair.first];
+        const BlobInfo& oBlob1 = voBlobs1[oPair.second];
+        oCorresp.vPts0.push_back(oBlob0.oCentroid);
+        oCorresp.vPts1.push_back(oBlob1.oCentroid);
+        oCorresp.vPts0.insert(oCorresp.vPts0.end(),oBlob0.aContourSamples.begin(),oBlob0.aContourSamples.end());
+        oCorresp.vPts1.insert(oCorresp.vPts1.end(),oBlob1.aContourSamples.begin(),oBlob1.aContourSamples.end());
+    }
+    return !vPairs.empty();
+}
+
+bool lv::MultimodalRegistrator::isNewCorrespSet(const CorrespSet& oCorresp) const {
+    const size_t nPairs = oCorresp.vPts0.size()/(MMREGISTR_CONTOUR_SAMPLE_COUNT+1);
+    if(nPairs!=m_vLastCentroids0.size())
+        return true;
+    for(size_t nPairIdx=0; nPairIdx<nPairs; ++nPairIdx) {
+        const size_t nCentroidIdx = nPairIdx*(MMREGISTR_CONTOUR_SAMPLE_COUNT+1);
+        if(cv::norm(oCorresp.vPts0[nCentroidIdx]-m_vLastCentroids0[nPairIdx])>=MMREGISTR_CHANGE_MIN_DISPLACEMENT ||
+           cv::norm(oCorresp.vPts1[nCentroidIdx]-m_vLastCentroids1[nPairIdx])>=MMREGISTR_CHANGE_MIN_DISPLACEMENT)
+            return true;
+    }
+    return false;
+}
+
+double lv::MultimodalRegistrator::getReprojError(const CorrespSet& oCorresp) const {
+    lvDbgAssert(!oCorresp.vPts0.empty() && oCorresp.vPts0.size()==oCorresp.vPts1.size());
+    double dErrorSum = 0.0;
+    for(size_t nPtIdx=0; nPtIdx<oCorresp.vPts0.size(); ++nPtIdx)
+        dErrorSum += cv::norm(projectPoint(m_oTransformMatx,oCorresp.vPts1[nPtIdx])-oCorresp.vPts0[nPtIdx]);
+    return dErrorSum/oCorresp.vPts0.size();
+}
+
+bool lv::MultimodalRegistrator::refitTransform() {
+    m_oReservoirPts.vPts0.clear();
+    m_oReservoirPts.vPts1.clear();
+    for(const CorrespSet& oCorresp : m_qoReservoir) {
+        m_oReservoirPts.vPts0.insert(m_oReservoirPts.vPts0.end(),oCorresp.vPts0.begin(),oCorresp.vPts0.end());
+        m_oReservoirPts.vPts1.insert(m_oReservoirPts.vPts1.end(),oCorresp.vPts1.begin(),oCorresp.vPts1.end());
+    }
+    if(m_oReservoirPts.vPts0.size()<4)
+        return false;
+    const cv::Mat oTransform = cv::findHomography(m_oReservoirPts.vPts1,m_oReservoirPts.vPts0,cv::RANSAC,MMREGISTR_RANSAC_REPROJ_THRESHOLD);
+    if(oTransform.empty())
+        return false;
+    oTransform.convertTo(m_oTransform,CV_64F);
+    m_oTransformMatx = m_oTransform;
+    m_oTransform_inv = cv::Mat(m_oTransformMatx.inv(),true);
+    ++m_nTransformVersion;
+    return true;
+}
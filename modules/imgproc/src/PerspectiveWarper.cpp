@@ -0,0 +1,94 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/imgproc/PerspectiveWarper.hpp"
+
+lv::PerspectiveWarper::PerspectiveWarper() :
+        m_oHomography_inv(cv::Matx33d::eye()),
+        m_oHomography(cv::Matx33d::eye()),
+        m_nInterpFlag(cv::INTER_LINEAR) {}
+
+void lv::PerspectiveWarper::setTransform(const cv::Mat& oHomography, const cv::Size& oOutputSize, int nFlags) {
+    lvAssert_(oHomography.rows==3 && oHomography.cols==3,"homography must be a 3x3 matrix");
+    lvAssert_(oOutputSize.area()>0,"output size must be non-null");
+    const int nInterpFlag = nFlags&cv::INTER_MAX;
+    lvAssert_(nInterpFlag==cv::INTER_NEAREST || nInterpFlag==cv::INTER_LINEAR,"only nearest and linear interpolations are supported");
+    cv::Matx33d oHomography_inv;
+    oHomography.convertTo(oHomography_inv,CV_64F);
+    if(!(nFlags&cv::WARP_INVERSE_MAP))
+        oHomography_inv = oHomography_inv.inv();
+    if(isInitialized() && oOutputSize==m_oOutputSize && nInterpFlag==m_nInterpFlag && oHomography_inv==m_oHomography_inv)
+        return;
+    m_oHomography_inv = oHomography_inv;
+    m_oHomography = oHomography_inv.inv();
+    m_oOutputSize = oOutputSize;
+    m_nInterpFlag = nInterpFlag;
+    m_oMapX.create(oOutputSize,CV_32FC1);
+    m_oMapY.create(oOutputSize,CV_32FC1);
+    for(int nRowIter=0; nRowIter<oOutputSize.height; ++nRowIter) {
+        float* const afMapXRow = m_oMapX.ptr<float>(nRowIter);
+        float* const afMapYRow = m_oMapY.ptr<float>(nRowIter);
+        for(int nColIter=0; nColIter<oOutputSize.width; ++nColIter) {
+            const cv::Vec3d vPt = m_oHomography_inv*cv::Vec3d(nColIter,nRowIter,1);
+            const double dInvW = vPt[2]!=0?1.0/vPt[2]:0.0; // points at infinity map outside (to the constant border)
+            afMapXRow[nColIter] = float(vPt[2]!=0?vPt[0]*dInvW:-1);
+            afMapYRow[nColIter] = float(vPt[2]!=0?vPt[1]*dInvW:-1);
+        }
+    }
+    cv::convertMaps(m_oMapX,m_oMapY,m_oMapXY,m_oMapInterp,CV_16SC2,nInterpFlag==cv::INTER_NEAREST);
+}
+
+void lv::PerspectiveWarper::apply(const cv::Mat& oInput, cv::Mat& oOutput, bool bCropToContent) {
+    lvAssert_(isInitialized(),"transform must be set first");
+    lvAssert_(!oInput.empty(),"input image must be non-empty");
+    oOutput.create(m_oOutputSize,oInput.type());
+    cv::Rect oOutputROI(cv::Point(0,0),m_oOutputSize);
+    if(bCropToContent && oInput.depth()==CV_8U) {
+        std::vector<cv::Point> voNonZeroPts;
+        cv::findNonZero(oInput.reshape(1),voNonZeroPts);
+        if(voNonZeroPts.empty()) {
+            oOutput = cv::Scalar::all(0);
+            return;
+        }
+        const cv::Rect oElemRect = cv::boundingRect(voNonZeroPts);
+        const int nChannels = oInput.channels();
+        // the input region is grown by one pixel for interpolation support, and its corners are projected in the output
+        const cv::Rect oInputRect(cv::Point(oElemRect.x/nChannels-1,oElemRect.y-1),cv::Point((oElemRect.x+oElemRect.width-1)/nChannels+2,oElemRect.br().y+1));
+        const std::array<cv::Point2d,4> aoCorners = {cv::Point2d(oInputRect.tl()),cv::Point2d(oInputRect.br().x,oInputRect.y),cv::Point2d(oInputRect.br()),cv::Point2d(oInputRect.x,oInputRect.br().y)};
+        double dMinX=DBL_MAX, dMinY=DBL_MAX, dMaxX=-DBL_MAX, dMaxY=-DBL_MAX;
+        bool bValidProj = true;
+        for(const cv::Point2d& oCorner : aoCorners) {
+            const cv::Vec3d vPt = m_oHomography*cv::Vec3d(oCorner.x,oCorner.y,1);
+            if(vPt[2]<=0) { // region crosses the horizon line, projected bounds are meaningless
+                bValidProj = false;
+                break;
+            }
+            dMinX = std::min(dMinX,vPt[0]/vPt[2]); dMaxX = std::max(dMaxX,vPt[0]/vPt[2]);
+            dMinY = std::min(dMinY,vPt[1]/vPt[2]); dMaxY = std::max(dMaxY,vPt[1]/vPt[2]);
+        }
+        if(bValidProj) {
+            const cv::Point oTL((int)std::max(std::floor(dMinX)-1,-1.0),(int)std::max(std::floor(dMinY)-1,-1.0));
+            const cv::Point oBR((int)std::min(std::ceil(dMaxX)+2,double(m_oOutputSize.width)+1),(int)std::min(std::ceil(dMaxY)+2,double(m_oOutputSize.height)+1));
+            oOutputROI &= cv::Rect(oTL,oBR);
+            oOutput = cv::Scalar::all(0);
+            if(oOutputROI.area()==0)
+                return;
+        }
+    }
+    cv::Mat oOutputROIMat = oOutput(oOutputROI);
+    cv::remap(oInput,oOutputROIMat,m_oMapXY(oOutputROI),m_oMapInterp.empty()?cv::Mat():m_oMapInterp(oOutputROI),m_nInterpFlag,cv::BORDER_CONSTANT);
+}
@@ -18,135 +18,222 @@
 #include "litiv/imgproc.hpp"
 #include "litiv/utils/cxx.hpp"
 
-void thinning_internal_ZhangSuen(cv::Mat& oInput, cv::Mat& oTempMarker, bool bIter) {
-    oTempMarker.create(oInput.size(),CV_8UC1);
-    oTempMarker = cv::Scalar_<uchar>(0);
+#define THINNING_ROW_BAND_SIZE 32 // number of rows evaluated per parallel (Zhang-Suen) thinning task
 
-    const uchar* pAbove = nullptr;
-    const uchar* pCurr = oInput.ptr<uchar>(0);
-    const uchar* pBelow = oInput.ptr<uchar>(1);
-    const uchar* nw, *no, *ne;
-    const uchar* we, *me, *ea;
-    const uchar* sw, *so, *se;
+namespace {
 
-    for(int y=1; y<oInput.rows-1; ++y) {
-        // shift the rows up by one
-        pAbove = pCurr;
-        pCurr  = pBelow;
-        pBelow = oInput.ptr<uchar>(y+1);
-        uchar* pDst = oTempMarker.ptr<uchar>(y);
+    /// neighborhood code bit offsets, in (N,NE,E,SE,S,SW,W,NW) order
+    constexpr int s_anThinningOffsets_x[8] = { 0, 1, 1, 1, 0,-1,-1,-1};
+    constexpr int s_anThinningOffsets_y[8] = {-1,-1, 0, 1, 1, 1, 0,-1};
 
-        // initialize col pointers
-        no = &(pAbove[0]);
-        ne = &(pAbove[1]);
-        me = &(pCurr[0]);
-        ea = &(pCurr[1]);
-        so = &(pBelow[0]);
-        se = &(pBelow[1]);
+    /// returns the 256-entry pixel deletion LUT (indexed by neighborhood code) for a given thinning mode and sub-iteration
+    const std::array<uchar,256>& getThinningLUT(lv::ThinningMode eMode, bool bIter) {
+        static const std::array<std::array<std::array<uchar,256>,2>,2> s_aaanLUTs = [](){
+            std::array<std::array<std::array<uchar,256>,2>,2> aaanLUTs;
+            for(size_t nCode=0; nCode<256; ++nCode) {
+                const auto lBit = [&](size_t nBitIdx){return uchar((nCode>>nBitIdx)&1);};
+                const uchar no=lBit(0), ne=lBit(1), ea=lBit(2), se=lBit(3), so=lBit(4), sw=lBit(5), we=lBit(6), nw=lBit(7);
+                // Zhang-Suen conditions
+                const int A = (!no && ne) + (!ne && ea) + (!ea && se) + (!se && so) +
+                              (!so && sw) + (!sw && we) + (!we && nw) + (!nw && no);
+                const int B = no+ne+ea+se+so+sw+we+nw;
+                for(size_t nIter=0; nIter<2; ++nIter) {
+                    const int m1 = !nIter?(no*ea*so):(no*ea*we);
+                    const int m2 = !nIter?(ea*so*we):(no*so*we);
+                    aaanLUTs[lv::ThinningMode_ZhangSuen][nIter][nCode] = uchar(A==1 && B>=2 && B<=6 && !m1 && !m2);
+                }
+                // Lam-Lee-Suen conditions (neighbors listed in S,SW,W,NW,N,NE,E,SE order)
+                const std::array<uchar,9> anLUT{so,sw,we,nw,no,ne,ea,se,
+#if defined(_MSC_VER) || USE_IMGPROC_THINNING_MATLAB_IMPL_FIX
+                    so // wraps around to x_1
+#else //(!defined(_MSC_VER) && !USE_IMGPROC_THINNING_MATLAB_IMPL_FIX)
+                    0 // the former per-pixel impl read past its 8-element neighbor array here; background is used instead
+#endif //(!defined(_MSC_VER) && !USE_IMGPROC_THINNING_MATLAB_IMPL_FIX)
+                };
+                size_t x_h = 0, n1 = 0, n2 = 0;
+                for(size_t k=0; k<4; ++k) {
+                    // G1:
+                    x_h += bool(!anLUT[2*k] && (anLUT[2*k+1] || anLUT[2*k+2]));
+                    // G2:
+                    n1 += bool(anLUT[2*k] || anLUT[2*k+1]);
+                    n2 += bool(anLUT[2*k+1] || anLUT[2*k+2]);
+                }
+                const size_t n_min = std::min(n1,n2);
+                const bool bG12 = (x_h==1 && n_min>=2 && n_min<=3);
+                // G3 || G3' :
+                aaanLUTs[lv::ThinningMode_LamLeeSuen][0][nCode] = uchar(bG12 && !((anLUT[1] || anLUT[2] || !anLUT[7]) && anLUT[0]));
+                aaanLUTs[lv::ThinningMode_LamLeeSuen][1][nCode] = uchar(bG12 && !((anLUT[5] || anLUT[6] || !anLUT[3]) && anLUT[4]));
+            }
+            return aaanLUTs;
+        }();
+        return s_aaanLUTs[eMode][bIter];
+    }
 
-        for(int x=1; x<oInput.cols-1; ++x) {
-            // shift col pointers left by one (scan left to right)
-            nw = no;
-            no = ne;
-            ne = &(pAbove[x+1]);
-            we = me;
-            me = ea;
-            ea = &(pCurr[x+1]);
-            sw = so;
-            so = se;
-            se = &(pBelow[x+1]);
+    /// returns the 8-bit neighborhood code of a pixel (see s_anThinningOffsets_x/y for bit order)
+    inline uchar getThinningCode(const uchar* const anCurr, const ptrdiff_t nRowStep) {
+        uint nCode = 0;
+        lv::unroll<8>([&](int n){
+            nCode |= uint(anCurr[nRowStep*s_anThinningOffsets_y[n]+s_anThinningOffsets_x[n]]!=0)<<n;
+        });
+        return uchar(nCode);
+    }
 
-            int A  = (!*no && *ne>0) + (!*ne && *ea>0) +
-                     (!*ea && *se>0) + (!*se && *so>0) +
-                     (!*so && *sw>0) + (!*sw && *we>0) +
-                     (!*we && *nw>0) + (!*nw && *no>0);
-            int B  = (*no>0)+(*ne>0)+(*ea>0)+(*se>0)+(*so>0)+(*sw>0)+(*we>0)+(*nw>0);
-            int m1 = !bIter?((*no>0)*(*ea>0)*(*so>0)):((*no>0)*(*ea>0)*(*we>0));
-            int m2 = !bIter?((*ea>0)*(*so>0)*(*we>0)):((*no>0)*(*so>0)*(*we>0));
-            if(A==1 && B>=2 && B<=6 && !m1 && !m2)
-                pDst[x] = UCHAR_MAX;
-        }
+#if HAVE_SSE2
+    /// computes the 8-bit neighborhood codes of 16 consecutive pixels at once
+    inline void getThinningCodes_16(const uchar* const anCurr, const ptrdiff_t nRowStep, uchar* anCodes) {
+        const __m128i _anZero = _mm_setzero_si128();
+        __m128i _anCodes = _anZero;
+        lv::unroll<8>([&](int n){
+            const __m128i _anVals = _mm_loadu_si128((const __m128i*)(anCurr+nRowStep*s_anThinningOffsets_y[n]+s_anThinningOffsets_x[n]));
+            _anCodes = _mm_or_si128(_anCodes,_mm_andnot_si128(_mm_cmpeq_epi8(_anVals,_anZero),_mm_set1_epi8(char(1<<n))));
+        });
+        _mm_storeu_si128((__m128i*)anCodes,_anCodes);
     }
-    oInput &= ~oTempMarker;
-}
 
-void thinning_internal_LamLeeSuen(cv::Mat& oInput, bool bIter) {
-    for(int i=1; i<oInput.rows-1; ++i) {
-        for(int j=1; j<oInput.cols-1; ++j) {
-            if(!oInput.at<uchar>(i,j))
-                continue;
-            const std::array<uchar,8> anLUT{
-                oInput.at<uchar>(i+1,j  ),
-                oInput.at<uchar>(i+1,j-1),
-                oInput.at<uchar>(i  ,j-1),
-                oInput.at<uchar>(i-1,j-1),
-                oInput.at<uchar>(i-1,j  ),
-                oInput.at<uchar>(i-1,j+1),
-                oInput.at<uchar>(i  ,j+1),
-                oInput.at<uchar>(i+1,j+1)
+    /// returns whether 16 consecutive frontier flags are all cleared
+    inline bool isThinningFrontierEmpty_16(const uchar* const anFlags) {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)anFlags),_mm_setzero_si128()))==0xFFFF;
+    }
+#endif //HAVE_SSE2
+
+    /// iterates thinning sub-passes in-place on a continuous 8UC1 map until convergence; only pixels whose neighborhood changed since
+    /// their last evaluation in the same sub-iteration (the 'frontier') are revisited, so results match full-frame passes exactly
+    void thinning_internal(uchar* const anData, const int nRows, const int nCols, lv::ThinningMode eMode, lv::ThreadPool* pThreadPool) {
+        // per sub-iteration frontier maps & row flags, and per-band deletion lists, reused across calls
+        thread_local std::array<std::vector<uchar>,2> s_avuFrontierMaps;
+        thread_local std::array<std::vector<uchar>,2> s_avuFrontierRows;
+        thread_local std::vector<std::vector<int>> s_vvnDeletions;
+        // note: thread-local names inside the tasks below would resolve to the worker's own (empty) instances, so bind them here
+        std::array<std::vector<uchar>,2>& avuFrontierMaps = s_avuFrontierMaps;
+        std::array<std::vector<uchar>,2>& avuFrontierRows = s_avuFrontierRows;
+        std::vector<std::vector<int>>& vvnDeletions = s_vvnDeletions;
+        const size_t nPixels = size_t(nRows)*nCols;
+        for(size_t nIter=0; nIter<2; ++nIter) {
+            avuFrontierMaps[nIter].assign(nPixels,0);
+            avuFrontierRows[nIter].assign(size_t(nRows),0);
+            for(int nRowIter=1; nRowIter<nRows-1; ++nRowIter) {
+                avuFrontierRows[nIter][nRowIter] = 1;
+                for(int nColIter=1; nColIter<nCols-1; ++nColIter)
+                    avuFrontierMaps[nIter][nRowIter*nCols+nColIter] = uchar(anData[nRowIter*nCols+nColIter]!=0);
+            }
+        }
+        const auto lDelete = [&](int nIdx) {
+            anData[nIdx] = 0;
+            const int nRowIter = nIdx/nCols, nColIter = nIdx%nCols;
+            for(int nRowOffset=-1; nRowOffset<=1; ++nRowOffset) {
+                if(nRowIter+nRowOffset<1 || nRowIter+nRowOffset>=nRows-1)
+                    continue;
+                for(int nColOffset=-1; nColOffset<=1; ++nColOffset) {
+                    const int nNeighbIdx = nIdx+nRowOffset*nCols+nColOffset;
+                    if(nColIter+nColOffset<1 || nColIter+nColOffset>=nCols-1 || !anData[nNeighbIdx])
+                        continue;
+                    for(size_t nIter=0; nIter<2; ++nIter) {
+                        avuFrontierMaps[nIter][nNeighbIdx] = 1;
+                        avuFrontierRows[nIter][nRowIter+nRowOffset] = 1;
+                    }
+                }
+            }
+        };
+        const size_t nBands = (size_t(nRows)+THINNING_ROW_BAND_SIZE-1)/THINNING_ROW_BAND_SIZE;
+        vvnDeletions.resize(nBands);
+        // zhang-suen sub-iterations only read the previous state, so row bands are evaluated in parallel; deletions are applied afterwards
+        const auto lZhangSuenPass = [&](bool bIter) {
+            const std::array<uchar,256>& anLUT = getThinningLUT(eMode,bIter);
+            const auto lBandPass = [&](size_t nBandIdx) {
+                std::vector<int>& vnDeletions = vvnDeletions[nBandIdx];
+                vnDeletions.clear();
+                const int nRowBegin = std::max(int(nBandIdx*THINNING_ROW_BAND_SIZE),1);
+                const int nRowEnd = std::min(int((nBandIdx+1)*THINNING_ROW_BAND_SIZE),nRows-1);
+                for(int nRowIter=nRowBegin; nRowIter<nRowEnd; ++nRowIter) {
+                    if(!avuFrontierRows[bIter][nRowIter])
+                        continue;
+                    avuFrontierRows[bIter][nRowIter] = 0;
+                    uchar* const anFrontierRow = avuFrontierMaps[bIter].data()+nRowIter*nCols;
+                    const uchar* const anRow = anData+nRowIter*nCols;
+                    int nColIter = 1;
+#if HAVE_SSE2
+                    for(; nColIter+17<=nCols; nColIter+=16) {
+                        if(isThinningFrontierEmpty_16(anFrontierRow+nColIter))
+                            continue;
+                        alignas(16) uchar anCodes[16];
+                        getThinningCodes_16(anRow+nColIter,nCols,anCodes);
+                        for(int n=0; n<16; ++n) {
+                            if(anFrontierRow[nColIter+n]) {
+                                anFrontierRow[nColIter+n] = 0;
+                                if(anRow[nColIter+n] && anLUT[anCodes[n]])
+                                    vnDeletions.push_back(nRowIter*nCols+nColIter+n);
+                            }
+                        }
+                    }
+#endif //HAVE_SSE2
+                    for(; nColIter<nCols-1; ++nColIter) {
+                        if(anFrontierRow[nColIter]) {
+                            anFrontierRow[nColIter] = 0;
+                            if(anRow[nColIter] && anLUT[getThinningCode(anRow+nColIter,nCols)])
+                                vnDeletions.push_back(nRowIter*nCols+nColIter);
+                        }
+                    }
+                }
             };
-            size_t x_h = 0, n1 = 0, n2 = 0;
-            for(size_t k=0; k<4; ++k) {
-#if defined(_MSC_VER) || USE_IMGPROC_THINNING_MATLAB_IMPL_FIX
-                // G1:
-                x_h += bool(!anLUT[2*(k+1)-2] && (anLUT[2*(k+1)-1] || anLUT[(2*(k+1))%8]));
-                // G2:
-                n1 += bool(anLUT[2*(k+1)-2] || anLUT[2*(k+1)-1]);
-                n2 += bool(anLUT[2*(k+1)-1] || anLUT[(2*(k+1))%8]);
-#else //(!defined(_MSC_VER) && !USE_IMGPROC_THINNING_MATLAB_IMPL_FIX)
-#ifdef __clang__
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wmaybe-uninitialized"
-#endif //__clang__
-#if (defined(__GNUC__) || defined(__GNUG__))
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
-#endif //(defined(__GNUC__) || defined(__GNUG__))
-                // G1:
-                x_h += bool(!anLUT[2*(k+1)-2] && (anLUT[2*(k+1)-1] || anLUT[2*(k+1)]));
-                // G2:
-                n1 += bool(anLUT[2*(k+1)-2] || anLUT[2*(k+1)-1]);
-                n2 += bool(anLUT[2*(k+1)-1] || anLUT[2*(k+1)]);
-#if (defined(__GNUC__) || defined(__GNUG__))
-#pragma GCC diagnostic pop
-#endif //(defined(__GNUC__) || defined(__GNUG__))
-#ifdef __clang__
-#pragma clang diagnostic pop
-#endif //__clang__
-#endif //(!defined(_MSC_VER) && !USE_IMGPROC_THINNING_MATLAB_IMPL_FIX)
+            if(pThreadPool && nBands>1)
+                pThreadPool->parallel_for(nBands,lBandPass);
+            else
+                for(size_t nBandIdx=0; nBandIdx<nBands; ++nBandIdx)
+                    lBandPass(nBandIdx);
+            size_t nDeleted = 0;
+            for(const std::vector<int>& vnDeletions : vvnDeletions) {
+                for(const int nIdx : vnDeletions)
+                    lDelete(nIdx);
+                nDeleted += vnDeletions.size();
             }
-            size_t n_min = std::min(n1,n2);
-            if(x_h==1 && n_min>=2 && n_min<=3) {
-                // G3 || G3' :
-                if( (!bIter && !((anLUT[1] || anLUT[2] || !anLUT[7]) && anLUT[0])) ||
-                    (bIter && !((anLUT[5] || anLUT[6] || !anLUT[3]) && anLUT[4]))) {
-                    oInput.at<uchar>(i,j) = 0;
+            return nDeleted;
+        };
+        // lam-lee-suen sub-iterations delete pixels in-place in raster order (later pixels see earlier deletions), so they stay sequential
+        const auto lLamLeeSuenPass = [&](bool bIter) {
+            const std::array<uchar,256>& anLUT = getThinningLUT(eMode,bIter);
+            size_t nDeleted = 0;
+            for(int nRowIter=1; nRowIter<nRows-1; ++nRowIter) {
+                if(!avuFrontierRows[bIter][nRowIter])
+                    continue;
+                avuFrontierRows[bIter][nRowIter] = 0;
+                uchar* const anFrontierRow = avuFrontierMaps[bIter].data()+nRowIter*nCols;
+                for(int nColIter=1; nColIter<nCols-1; ++nColIter) {
+#if HAVE_SSE2
+                    if(nColIter+16<=nCols-1 && isThinningFrontierEmpty_16(anFrontierRow+nColIter)) {
+                        nColIter += 15;
+                        continue;
+                    }
+#endif //HAVE_SSE2
+                    if(anFrontierRow[nColIter]) {
+                        anFrontierRow[nColIter] = 0;
+                        const int nIdx = nRowIter*nCols+nColIter;
+                        if(anData[nIdx] && anLUT[getThinningCode(anData+nIdx,nCols)]) {
+                            lDelete(nIdx);
+                            ++nDeleted;
+                        }
+                    }
                 }
             }
+            return nDeleted;
+        };
+        size_t nDeleted;
+        do {
+            if(eMode==lv::ThinningMode_ZhangSuen)
+                nDeleted = lZhangSuenPass(false)+lZhangSuenPass(true);
+            else //eMode==ThinningMode_LamLeeSuen
+                nDeleted = lLamLeeSuenPass(false)+lLamLeeSuenPass(true);
         }
+        while(nDeleted>0);
     }
-}
 
-void lv::thinning(const cv::Mat& oInput, cv::Mat& oOutput, ThinningMode eMode) {
+} // anonymous namespace
+
+void lv::thinning(const cv::Mat& oInput, cv::Mat& oOutput, ThinningMode eMode, lv::ThreadPool* pThreadPool) {
     lvAssert_(!oInput.empty() && oInput.isContinuous(),"input image must be non-empty and continuous");
     lvAssert_(oInput.type()==CV_8UC1,"input image type must be 8UC1");
     lvAssert_(oInput.rows>3 && oInput.cols>3,"input image size must be greater than 3x3");
     oOutput.create(oInput.size(),CV_8UC1);
     oInput.copyTo(oOutput);
-    cv::Mat oPrevious(oInput.size(),CV_8UC1,cv::Scalar_<uchar>(0));
-    cv::Mat oTempMarker;
-    bool bEq;
-    do {
-        if(eMode==ThinningMode_ZhangSuen) {
-            thinning_internal_ZhangSuen(oOutput,oTempMarker,false);
-            thinning_internal_ZhangSuen(oOutput,oTempMarker,true);
-        }
-        else { //eMode==ThinningMode_LamLeeSuen
-            thinning_internal_LamLeeSuen(oOutput,false);
-            thinning_internal_LamLeeSuen(oOutput,true);
-        }
-        bEq = std::equal(oOutput.begin<uchar>(),oOutput.end<uchar>(),oPrevious.begin<uchar>());
-        oOutput.copyTo(oPrevious);
-    }
-    while(!bEq);
+    lvAssert_(oOutput.isContinuous(),"output image must be continuous");
+    thinning_internal(oOutput.data,oOutput.rows,oOutput.cols,eMode,pThreadPool);
 }
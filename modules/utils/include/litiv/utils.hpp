@@ -22,6 +22,8 @@
 #include "litiv/utils/parallel.hpp"
 #include "litiv/utils/distances.hpp"
 #include "litiv/utils/platform.hpp"
+#include "litiv/utils/profiler.hpp"
+#include "litiv/utils/random.hpp"
 #include "litiv/utils/console.hpp"
 #include "litiv/utils/opencv.hpp"
 #if HAVE_GLSL
@@ -29,10 +31,5 @@
 #include "litiv/utils/opengl-draw.hpp"
 #include "litiv/utils/opengl-shaders.hpp"
 #include "litiv/utils/opengl-imgproc.hpp"
+#include "litiv/utils/opengl-compute.hpp"
 #endif //HAVE_GLSL
-#if HAVE_CUDA
-// ... @@@
-#endif //HAVE_CUDA
-#if HAVE_OPENCL
-// ... @@@
-#endif //HAVE_OPENCL
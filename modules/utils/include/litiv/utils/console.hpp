@@ -41,6 +41,29 @@
 #include <string>
 #include <sstream>
 
+#ifndef LV_LOG_MIN_LEVEL
+/// minimum level of log messages compiled in (0=debug, 1=info, 2=warning, 3=error); logging calls below it expand to nothing
+#define LV_LOG_MIN_LEVEL 0
+#endif //ndef LV_LOG_MIN_LEVEL
+/// queues a printf-style message in the async logger if its level is enabled at runtime (arguments are not even evaluated otherwise)
+#define lvLog(eLevel,...) do {if(lv::AsyncLogger::isEnabled(eLevel)) lv::AsyncLogger::log(eLevel,__VA_ARGS__);} while(0)
+#if LV_LOG_MIN_LEVEL<=0
+#define lvLogDebug(...) lvLog(lv::LogLevel_Debug,__VA_ARGS__)
+#else //!(LV_LOG_MIN_LEVEL<=0)
+#define lvLogDebug(...) do {} while(0)
+#endif //!(LV_LOG_MIN_LEVEL<=0)
+#if LV_LOG_MIN_LEVEL<=1
+#define lvLogInfo(...) lvLog(lv::LogLevel_Info,__VA_ARGS__)
+#else //!(LV_LOG_MIN_LEVEL<=1)
+#define lvLogInfo(...) do {} while(0)
+#endif //!(LV_LOG_MIN_LEVEL<=1)
+#if LV_LOG_MIN_LEVEL<=2
+#define lvLogWarning(...) lvLog(lv::LogLevel_Warning,__VA_ARGS__)
+#else //!(LV_LOG_MIN_LEVEL<=2)
+#define lvLogWarning(...) do {} while(0)
+#endif //!(LV_LOG_MIN_LEVEL<=2)
+#define lvLogError(...) lvLog(lv::LogLevel_Error,__VA_ARGS__)
+
 #ifdef _WIN32
 #include <windows.h>  // for WinAPI and Sleep()
 #define _NO_OLDNAMES  // for MinGW compatibility
@@ -479,7 +502,7 @@ namespace lv {
 
 #if defined(_MSC_VER)
     /// sets the console window to a certain size (with optional buffer resizing)
-    void SetConsoleWindowSize(int x, int y, int buffer_lines=-1) {
+    inline void SetConsoleWindowSize(int x, int y, int buffer_lines=-1) {
         // derived from http://www.cplusplus.com/forum/windows/121444/
         HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
         if(h==INVALID_HANDLE_VALUE)
@@ -511,7 +534,7 @@ namespace lv {
 #endif //defined(_MSC_VER)
 
     /// shows a progression bar in the console
-    void updateConsoleProgressBar(const std::string& sMsg, float fCompletion, size_t nBarCols=20) {
+    inline void updateConsoleProgressBar(const std::string& sMsg, float fCompletion, size_t nBarCols=20) {
         if(nBarCols==0)
             return;
         const int nRows = rlutil::trows();
@@ -545,7 +568,7 @@ namespace lv {
     }
 
     /// cleans a specific row from the console (default=last)
-    void cleanConsoleRow(int nRowIdx=INT_MAX) {
+    inline void cleanConsoleRow(int nRowIdx=INT_MAX) {
         if(nRowIdx<0)
             return;
         const int nRows = rlutil::trows();
@@ -557,4 +580,164 @@ namespace lv {
         fflush(stdout);
     }
 
+    /// log message severity levels (also used as indices of the LV_LOG_MIN_LEVEL compile-time filter)
+    enum LogLevel {
+        LogLevel_Debug=0,
+        LogLevel_Info=1,
+        LogLevel_Warning=2,
+        LogLevel_Error=3,
+    };
+
+    /// asynchronous printf-style logger; callers only copy their raw arguments into a per-thread lock-free ring, and all formatting & output
+    /// is done by a background thread (messages of all threads are written in timestamp order, one line each, so they never interleave)
+    struct AsyncLogger {
+        /// size (in bytes) of a single log record, including its header; string arguments are truncated to fit
+        static constexpr size_t s_nRecordSize = 256;
+        /// number of records per thread ring (debug/info messages are dropped while it is full, warnings/errors wait for space)
+        static constexpr size_t s_nRingSize = 1024;
+        /// sets the minimum level of messages kept at runtime (default: LogLevel_Info)
+        static void setLevel(LogLevel eLevel);
+        /// returns the minimum level of messages kept at runtime
+        static LogLevel getLevel();
+        /// returns whether messages of the given level are kept at runtime (a single relaxed load, checked before any argument is copied)
+        static inline bool isEnabled(LogLevel eLevel) {return int(eLevel)>=s_nLevel.load(std::memory_order_relaxed);}
+        /// redirects the output of the background thread (nullptr = std::cout); the stream must stay valid until the next flush
+        static void setOutputStream(std::ostream* pStream);
+        /// blocks until all messages queued (by any thread) before this call have been written
+        static void flush();
+        /// queues a message; only arithmetic, enum, pointer, c-string and std::string arguments are supported (strings are copied, and printed via '%s')
+        /// note: the format string is not copied, and must have static storage duration (e.g. a string literal)
+        template<typename... TArgs>
+        static void log(LogLevel eLevel, const char* sFormat, const TArgs&... aArgs);
+        /// header found at the beginning of each record, followed by the encoded arguments
+        struct RecordHeader {
+            /// formats the record arguments with its format string, and appends the result to sOutput
+            using DecodeFunc = void(*)(const char* sFormat, const uchar* pArgs, std::string& sOutput);
+            DecodeFunc pDecoder;
+            const char* sFormat;
+            int64_t nTimestamp_ns;
+            LogLevel eLevel;
+        };
+        /// maximum size (in bytes) of the encoded arguments of a single record
+        static constexpr size_t s_nMaxArgsSize = s_nRecordSize-sizeof(RecordHeader);
+    private:
+        /// encoding/decoding of a single argument type (sizes are in bytes, and the min size is used to reserve space for later arguments)
+        template<typename T, typename=void>
+        struct ArgCodec;
+        template<typename... TArgs>
+        struct ArgsMinSize;
+        template<typename... TArgs>
+        struct ArgsDecoder;
+        template<typename TArg, typename... TArgs>
+        static uchar* encodeArgs(uchar* pArgs, uchar* pArgsEnd, const TArg& oArg, const TArgs&... aArgs);
+        static inline uchar* encodeArgs(uchar* pArgs, uchar* /*pArgsEnd*/) {return pArgs;}
+        /// returns a free record slot in the calling thread's ring (or nullptr if it is full and the message should be dropped)
+        static uchar* acquireRecord(LogLevel eLevel);
+        /// publishes the record last acquired by the calling thread
+        static void commitRecord();
+        /// returns the logger's clock time, in nanoseconds
+        static int64_t getTimestamp_ns();
+        static std::atomic<int> s_nLevel;
+    };
+
 } // namespace lv
+
+template<typename T>
+struct lv::AsyncLogger::ArgCodec<T,std::enable_if_t<std::is_arithmetic<T>::value || std::is_enum<T>::value || (std::is_pointer<T>::value && !std::is_same<std::remove_cv_t<std::remove_pointer_t<T>>,char>::value)>> {
+    using Decoded = std::conditional_t<std::is_enum<T>::value,int,std::conditional_t<std::is_same<T,bool>::value,int,T>>;
+    static constexpr size_t s_nMinSize = sizeof(T);
+    static uchar* encode(uchar* pArgs, uchar* /*pArgsEnd*/, const T& oArg) {
+        memcpy(pArgs,&oArg,sizeof(T));
+        return pArgs+sizeof(T);
+    }
+    static Decoded decode(const uchar*& pArgs) {
+        T oArg;
+        memcpy(&oArg,pArgs,sizeof(T));
+        pArgs += sizeof(T);
+        return Decoded(oArg);
+    }
+};
+
+template<typename T>
+struct lv::AsyncLogger::ArgCodec<T,std::enable_if_t<std::is_same<T,std::string>::value || (std::is_pointer<T>::value && std::is_same<std::remove_cv_t<std::remove_pointer_t<T>>,char>::value)>> {
+    using Decoded = const char*;
+    static constexpr size_t s_nMinSize = sizeof(uint16_t)+1;
+    static uchar* encode(uchar* pArgs, uchar* pArgsEnd, const T& oArg) {
+        const char* sArg = getData(oArg);
+        const size_t nLength = std::min(sArg?strlen(sArg):size_t(0),size_t(pArgsEnd-pArgs)-s_nMinSize);
+        const uint16_t nStoredLength = uint16_t(nLength);
+        memcpy(pArgs,&nStoredLength,sizeof(uint16_t));
+        memcpy(pArgs+sizeof(uint16_t),sArg,nLength);
+        pArgs[sizeof(uint16_t)+nLength] = '\0';
+        return pArgs+sizeof(uint16_t)+nLength+1;
+    }
+    static Decoded decode(const uchar*& pArgs) {
+        uint16_t nStoredLength;
+        memcpy(&nStoredLength,pArgs,sizeof(uint16_t));
+        const char* sArg = (const char*)pArgs+sizeof(uint16_t);
+        pArgs += sizeof(uint16_t)+nStoredLength+1;
+        return sArg;
+    }
+private:
+    static const char* getData(const std::string& sArg) {return sArg.c_str();}
+    static const char* getData(const char* sArg) {return sArg;}
+};
+
+template<typename... TArgs>
+struct lv::AsyncLogger::ArgsMinSize {
+    static constexpr size_t value = 0;
+};
+
+template<typename TArg, typename... TArgs>
+struct lv::AsyncLogger::ArgsMinSize<TArg,TArgs...> {
+    static constexpr size_t value = ArgCodec<TArg>::s_nMinSize+ArgsMinSize<TArgs...>::value;
+};
+
+template<typename... TArgs>
+struct lv::AsyncLogger::ArgsDecoder {
+    static void decode(const char* sFormat, const uchar* pArgs, std::string& sOutput) {
+        // braced init lists are evaluated left-to-right, so the arguments are read back in encoding order
+        const std::tuple<typename ArgCodec<TArgs>::Decoded...> aArgs{ArgCodec<TArgs>::decode(pArgs)...};
+        format(sFormat,aArgs,sOutput,std::index_sequence_for<TArgs...>());
+    }
+private:
+    template<size_t... anIndices>
+    static void format(const char* sFormat, const std::tuple<typename ArgCodec<TArgs>::Decoded...>& aArgs, std::string& sOutput, std::index_sequence<anIndices...>) {
+        char acBuffer[512];
+        const int nLength = snprintf(acBuffer,sizeof(acBuffer),sFormat,std::get<anIndices>(aArgs)...);
+        if(nLength<0)
+            return;
+        if(size_t(nLength)<sizeof(acBuffer)) {
+            sOutput.append(acBuffer,size_t(nLength));
+            return;
+        }
+        const size_t nOffset = sOutput.size();
+        sOutput.resize(nOffset+size_t(nLength)+1);
+        snprintf(&sOutput[nOffset],size_t(nLength)+1,sFormat,std::get<anIndices>(aArgs)...);
+        sOutput.resize(nOffset+size_t(nLength));
+    }
+};
+
+template<typename TArg, typename... TArgs>
+uchar* lv::AsyncLogger::encodeArgs(uchar* pArgs, uchar* pArgsEnd, const TArg& oArg, const TArgs&... aArgs) {
+    // variable-size arguments can only use the space not reserved by the arguments that follow them
+    pArgs = ArgCodec<std::decay_t<const TArg>>::encode(pArgs,pArgsEnd-ArgsMinSize<std::decay_t<const TArgs>...>::value,oArg);
+    return encodeArgs(pArgs,pArgsEnd,aArgs...);
+}
+
+template<typename... TArgs>
+void lv::AsyncLogger::log(LogLevel eLevel, const char* sFormat, const TArgs&... aArgs) {
+    // note: arguments are decayed w/ their constness, so that string literals are handled as c-strings
+    static_assert(ArgsMinSize<std::decay_t<const TArgs>...>::value<=s_nMaxArgsSize,"log message arguments do not fit in a single record");
+    uchar* pRecord = acquireRecord(eLevel);
+    if(!pRecord)
+        return;
+    RecordHeader oHeader;
+    oHeader.pDecoder = &ArgsDecoder<std::decay_t<const TArgs>...>::decode;
+    oHeader.sFormat = sFormat;
+    oHeader.nTimestamp_ns = getTimestamp_ns();
+    oHeader.eLevel = eLevel;
+    memcpy(pRecord,&oHeader,sizeof(RecordHeader));
+    encodeArgs(pRecord+sizeof(RecordHeader),pRecord+s_nRecordSize,aArgs...);
+    commitRecord();
+}
@@ -44,6 +44,8 @@
 #include <cassert>
 #include <ctime>
 #include <numeric>
+#include <random>
+#include <typeinfo>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -281,21 +283,147 @@ namespace lv {
         return vfResult;
     }
 
+    /// move-only type-erased 'void()' callable stored in a fixed inline buffer (never allocates; oversized callables are rejected at compile time)
+    template<size_t nBufferSize=48>
+    struct SmallTask {
+        SmallTask() noexcept :
+                m_pInvoke(nullptr),
+                m_pRelocate(nullptr) {}
+        template<typename Tfunc, typename=std::enable_if_t<!std::is_same<std::decay_t<Tfunc>,SmallTask>::value>>
+        SmallTask(Tfunc&& lFunc) {
+            using TStored = std::decay_t<Tfunc>;
+            static_assert(sizeof(TStored)<=nBufferSize && alignof(TStored)<=alignof(std::max_align_t),"callable does not fit in the task buffer");
+            new(&m_oBuffer) TStored(std::forward<Tfunc>(lFunc));
+            m_pInvoke = [](void* pFunc) {(*(TStored*)pFunc)();};
+            m_pRelocate = [](void* pDst, void* pSrc) { // moves to pDst (if not null), then destroys pSrc
+                if(pDst)
+                    new(pDst) TStored(std::move(*(TStored*)pSrc));
+                ((TStored*)pSrc)->~TStored();
+            };
+        }
+        SmallTask(SmallTask&& oTask) noexcept :
+                m_pInvoke(oTask.m_pInvoke),
+                m_pRelocate(oTask.m_pRelocate) {
+            if(m_pRelocate)
+                m_pRelocate(&m_oBuffer,&oTask.m_oBuffer);
+            oTask.m_pInvoke = nullptr;
+            oTask.m_pRelocate = nullptr;
+        }
+        SmallTask& operator=(SmallTask&& oTask) noexcept {
+            if(this!=&oTask) {
+                reset();
+                if(oTask.m_pRelocate)
+                    oTask.m_pRelocate(&m_oBuffer,&oTask.m_oBuffer);
+                std::swap(m_pInvoke,oTask.m_pInvoke);
+                std::swap(m_pRelocate,oTask.m_pRelocate);
+            }
+            return *this;
+        }
+        ~SmallTask() {
+            reset();
+        }
+        /// destroys the stored callable (if any)
+        void reset() noexcept {
+            if(m_pRelocate)
+                m_pRelocate(nullptr,&m_oBuffer);
+            m_pInvoke = nullptr;
+            m_pRelocate = nullptr;
+        }
+        explicit operator bool() const noexcept {
+            return m_pInvoke!=nullptr;
+        }
+        void operator()() {
+            m_pInvoke(&m_oBuffer);
+        }
+        SmallTask(const SmallTask&) = delete;
+        SmallTask& operator=(const SmallTask&) = delete;
+    private:
+        std::aligned_storage_t<nBufferSize,alignof(std::max_align_t)> m_oBuffer;
+        void(*m_pInvoke)(void*);
+        void(*m_pRelocate)(void*,void*);
+    };
+
+    /// single-use countdown latch; 'wait' blocks until 'count_down' was called the expected number of times, and rethrows the first reported exception
+    struct CountdownLatch {
+        explicit CountdownLatch(size_t nCount=0) :
+                m_nCount(nCount) {}
+        /// resets the expected count (must not be called while threads are waiting)
+        void reset(size_t nCount) {
+            std::lock_guard<std::mutex> oLock(m_oMutex);
+            m_nCount = nCount;
+            m_pException = nullptr;
+        }
+        /// adds nCount to the expected count (before the corresponding tasks are submitted)
+        void add(size_t nCount) {
+            std::lock_guard<std::mutex> oLock(m_oMutex);
+            m_nCount += nCount;
+        }
+        /// decrements the count, optionally reporting the exception that interrupted the task
+        void count_down(std::exception_ptr pException=nullptr) {
+            std::lock_guard<std::mutex> oLock(m_oMutex);
+            if(pException && !m_pException)
+                m_pException = pException;
+            if(m_nCount>0 && --m_nCount==0)
+                m_oCondVar.notify_all();
+        }
+        /// blocks until the count reaches zero
+        void wait() {
+            std::unique_lock<std::mutex> oLock(m_oMutex);
+            m_oCondVar.wait(oLock,[&]{return m_nCount==0;});
+            if(m_pException)
+                std::rethrow_exception(m_pException);
+        }
+        CountdownLatch(const CountdownLatch&) = delete;
+        CountdownLatch& operator=(const CountdownLatch&) = delete;
+    private:
+        std::condition_variable m_oCondVar;
+        std::mutex m_oMutex;
+        size_t m_nCount;
+        std::exception_ptr m_pException;
+    };
+
+    /// thread roles used to look up cpu placement policies (see lv::SetThreadPlacementPolicy in platform.hpp)
+    enum ThreadRole {
+        ThreadRole_Worker, ///< generic worker pool threads (lv::WorkerPool, parallel utils)
+        ThreadRole_Precacher, ///< data precaching, decoding & capture threads
+        ThreadRole_Writer, ///< data writer threads
+        ThreadRole_Analysis, ///< per-batch algorithm threads (e.g. the apps' 'Analyze' workers)
+        nThreadRoleCount,
+    };
+
+    /// applies the placement policy registered for the given role to the calling thread; returns false if any part of it could not be applied
+    bool ApplyThreadPlacementPolicy(ThreadRole eRole);
+
     template<size_t nWorkers>
     struct WorkerPool {
         static_assert(nWorkers>0,"Worker pool must have at least one work thread");
-        WorkerPool();
+        /// task type stored in the queue (inline buffer, so fire-and-forget submissions never allocate)
+        using Task = SmallTask<48>;
+        /// starts all work threads, which apply the placement policy of the given role before fetching tasks
+        WorkerPool(ThreadRole eRole=ThreadRole_Worker);
         ~WorkerPool();
+        /// queues a task and returns a future to its result (allocates a shared packaged task; prefer 'submit'/'submitBulk' in hot loops)
         template<typename Tfunc, typename... Targs>
         std::future<std::result_of_t<Tfunc(Targs...)>> queueTask(Tfunc&& lTaskEntryPoint, Targs&&... args);
+        /// queues a fire-and-forget task (must fit in the task buffer, and must not throw)
+        template<typename Tfunc>
+        void submit(Tfunc&& lTask);
+        /// queues lTask(nTaskIdx) for all nTaskIdx in [0,nTasks) without per-task allocation; oLatch is counted up by nTasks, then down as tasks end
+        /// (lTask must stay alive until oLatch.wait() returns; exceptions are forwarded to oLatch)
+        template<typename Tfunc>
+        void submitBulk(size_t nTasks, const Tfunc& lTask, CountdownLatch& oLatch);
     protected:
-        std::queue<std::function<void()>> m_qTasks;
+        /// appends a task to the ring buffer (which only grows, so the steady state never allocates); must be called w/ m_oSyncMutex locked
+        void pushTask(Task&& oTask);
+        /// pre-allocated task ring buffer (m_nTaskCount tasks starting at m_nTaskHead)
+        std::vector<Task> m_vTaskRing;
+        size_t m_nTaskHead,m_nTaskCount;
         std::vector<std::thread> m_vhWorkers;
         std::mutex m_oSyncMutex;
         std::condition_variable m_oSyncVar;
         std::atomic_bool m_bIsActive;
     private:
-        void entry();
+        void entry(ThreadRole eRole);
         WorkerPool(const WorkerPool&) = delete;
         WorkerPool& operator=(const WorkerPool&) = delete;
     };
@@ -321,6 +449,84 @@ namespace lv {
     template<int... anIndices>
     struct MetaIdxConcatenator<0, anIndices...> : MetaIdxConcat<anIndices...> {};
 
+    /// small & fast 32-bit permuted congruential generator (PCG-XSH-RR, see O'Neill 2014), usable as a per-instance/per-thread std URBG
+    struct PCG32 {
+        typedef uint32_t result_type;
+        /// default constructor (uses a fixed seed, so default-constructed generators always produce the same sequence)
+        PCG32() {seed(0x853C49E6748FEA9BULL);}
+        /// seeding constructor (different stream ids yield independent sequences for the same seed)
+        explicit PCG32(uint64_t nSeed, uint64_t nStreamId=0) {seed(nSeed,nStreamId);}
+        /// reseeds the generator state
+        inline void seed(uint64_t nSeed, uint64_t nStreamId=0) {
+            m_nState = 0u;
+            m_nInc = (nStreamId<<1u)|1u;
+            (*this)();
+            m_nState += nSeed;
+            (*this)();
+        }
+        /// returns the next 32-bit random value of the sequence
+        inline result_type operator()() {
+            const uint64_t nOldState = m_nState;
+            m_nState = nOldState*6364136223846793005ULL+m_nInc;
+            const uint32_t nXorShifted = uint32_t(((nOldState>>18u)^nOldState)>>27u);
+            const uint32_t nRot = uint32_t(nOldState>>59u);
+            return (nXorShifted>>nRot)|(nXorShifted<<((-nRot)&31u));
+        }
+        static constexpr result_type min() {return 0u;}
+        static constexpr result_type max() {return UINT32_MAX;}
+    private:
+        uint64_t m_nState,m_nInc;
+    };
+
+    /// writes the raw bytes of a trivially copyable object to a binary stream
+    template<typename T>
+    inline void writeBinary(std::ostream& oStream, const T& oVal) {
+        static_assert(std::is_trivially_copyable<T>::value,"raw binary serialization requires a trivially copyable type");
+        oStream.write((const char*)&oVal,sizeof(T));
+    }
+
+    /// writes the size and raw content of a vector of trivially copyable objects to a binary stream
+    template<typename T, typename TAlloc>
+    inline void writeBinary(std::ostream& oStream, const std::vector<T,TAlloc>& vVals) {
+        static_assert(std::is_trivially_copyable<T>::value,"raw binary serialization requires a trivially copyable type");
+        writeBinary(oStream,(uint64_t)vVals.size());
+        oStream.write((const char*)vVals.data(),std::streamsize(vVals.size()*sizeof(T)));
+    }
+
+    /// writes the size and content of a string to a binary stream
+    inline void writeBinary(std::ostream& oStream, const std::string& sVal) {
+        writeBinary(oStream,(uint64_t)sVal.size());
+        oStream.write(sVal.data(),std::streamsize(sVal.size()));
+    }
+
+    /// reads the raw bytes of a trivially copyable object from a binary stream
+    template<typename T>
+    inline void readBinary(std::istream& oStream, T& oVal) {
+        static_assert(std::is_trivially_copyable<T>::value,"raw binary serialization requires a trivially copyable type");
+        oStream.read((char*)&oVal,sizeof(T));
+        lvAssert_(oStream.good(),"failed to read from binary stream (truncated data?)");
+    }
+
+    /// reads a vector of trivially copyable objects written via writeBinary from a binary stream
+    template<typename T, typename TAlloc>
+    inline void readBinary(std::istream& oStream, std::vector<T,TAlloc>& vVals) {
+        static_assert(std::is_trivially_copyable<T>::value,"raw binary serialization requires a trivially copyable type");
+        uint64_t nSize;
+        readBinary(oStream,nSize);
+        vVals.resize((size_t)nSize);
+        oStream.read((char*)vVals.data(),std::streamsize(vVals.size()*sizeof(T)));
+        lvAssert_(oStream.good(),"failed to read from binary stream (truncated data?)");
+    }
+
+    /// reads a string written via writeBinary from a binary stream
+    inline void readBinary(std::istream& oStream, std::string& sVal) {
+        uint64_t nSize;
+        readBinary(oStream,nSize);
+        sVal.resize((size_t)nSize);
+        oStream.read(&sVal[0],std::streamsize(sVal.size()));
+        lvAssert_(oStream.good(),"failed to read from binary stream (truncated data?)");
+    }
+
     struct StopWatch {
         StopWatch() {tick();}
         inline void tick() {m_nTick = std::chrono::high_resolution_clock::now();}
@@ -503,6 +709,254 @@ namespace lv {
         size_t m_nCount;
     };
 
+    /// assumed size of a cache line, used to pad data written by different threads (avoids false sharing)
+    /// note: padding is done with explicit members instead of alignas, as over-aligned heap allocations are only supported from c++17 on
+    constexpr size_t s_nCacheLineSize = 64;
+
+    /// wait strategies for the bounded queues below (blocking parks the thread on a condvar; spinning busy-waits, so it hands over
+    /// elements with much lower latency, but burns a core per waiting thread and should only be used when threads <= cores)
+    enum QueueWaitStrategy {
+        QueueWait_Block,
+        QueueWait_Spin,
+    };
+
+    /// busy-waits until lPred returns true, yielding the thread's timeslice once the first few iterations fail
+    template<typename TPred>
+    inline void spin_wait(TPred&& lPred) {
+        for(size_t nIter=0; !lPred(); ++nIter)
+            if(nIter>=64)
+                std::this_thread::yield();
+    }
+
+    /// bounded single-producer/single-consumer queue with back-pressure; the ring is lock-free, and the mutex is only used to park a blocked side
+    /// (also keeps occupancy stats to help locate the bottleneck of a pipeline: a full queue means its consumer is slower than its producer)
+    template<typename T, QueueWaitStrategy eWaitStrategy=QueueWait_Block>
+    struct BoundedSPSCQueue {
+        explicit BoundedSPSCQueue(size_t nCapacity) :
+                m_vRing(std::max(nCapacity,size_t(1))+1),m_nTail(0),m_nCachedHead(0),m_nPushCount(0),m_nOccupancySum(0),m_nFullWaitCount(0),
+                m_nHead(0),m_nCachedTail(0),m_nEmptyWaitCount(0),m_nWaiters(0),m_bClosed(false) {}
+        /// moves an element at the end of the queue, blocking while it is full; returns false (dropping the element) if the queue was closed
+        bool push(T&& oElem) {
+            const size_t nTail = m_nTail.load(std::memory_order_relaxed);
+            const size_t nNextTail = (nTail+1)%m_vRing.size();
+            if(nNextTail==m_nCachedHead && nNextTail==(m_nCachedHead=m_nHead.load(std::memory_order_acquire))) {
+                ++m_nFullWaitCount;
+                wait([&]{return nNextTail!=m_nHead.load() || m_bClosed;});
+                m_nCachedHead = m_nHead.load(std::memory_order_acquire);
+            }
+            if(m_bClosed)
+                return false;
+            m_vRing[nTail] = std::move(oElem);
+            m_nOccupancySum += (nTail+m_vRing.size()-m_nHead.load(std::memory_order_relaxed))%m_vRing.size()+1;
+            ++m_nPushCount;
+            m_nTail.store(nNextTail,std::memory_order_seq_cst);
+            notify();
+            return true;
+        }
+        /// moves the first element of the queue into oElem, blocking while it is empty; returns false once the queue is closed and drained
+        bool pop(T& oElem) {
+            const size_t nHead = m_nHead.load(std::memory_order_relaxed);
+            if(nHead==m_nCachedTail && nHead==(m_nCachedTail=m_nTail.load(std::memory_order_acquire))) {
+                ++m_nEmptyWaitCount;
+                wait([&]{return nHead!=m_nTail.load() || m_bClosed;});
+                if(nHead==(m_nCachedTail=m_nTail.load(std::memory_order_acquire)))
+                    return false;
+            }
+            oElem = std::move(m_vRing[nHead]);
+            m_vRing[nHead] = T();
+            m_nHead.store((nHead+1)%m_vRing.size(),std::memory_order_seq_cst);
+            notify();
+            return true;
+        }
+        /// closes the queue; the consumer still receives the queued elements, but blocked or later pushes fail (can be called from any thread)
+        void close() {
+            {
+                std::lock_guard<std::mutex> oLock(m_oMutex);
+                m_bClosed = true;
+            }
+            m_oCondVar.notify_all();
+        }
+        /// returns the maximum number of queued elements
+        size_t capacity() const {return m_vRing.size()-1;}
+        /// returns the average number of queued elements (including the new one) seen by push calls, relative to capacity
+        double getAvgOccupancy() const {return m_nPushCount?double(m_nOccupancySum)/m_nPushCount/capacity():0.0;}
+        /// returns the number of push calls that blocked on a full queue (consumer-bound)
+        size_t getFullWaitCount() const {return m_nFullWaitCount;}
+        /// returns the number of pop calls that blocked on an empty queue (producer-bound)
+        size_t getEmptyWaitCount() const {return m_nEmptyWaitCount;}
+        BoundedSPSCQueue(const BoundedSPSCQueue&) = delete;
+        BoundedSPSCQueue& operator=(const BoundedSPSCQueue&) = delete;
+    private:
+        template<typename TPred>
+        void wait(TPred&& lPred) {
+            if(eWaitStrategy==QueueWait_Spin)
+                return spin_wait(lPred);
+            std::unique_lock<std::mutex> oLock(m_oMutex);
+            ++m_nWaiters; // seq_cst, paired with the index stores: either the waiter sees the update, or the notifier sees the waiter
+            m_oCondVar.wait(oLock,lPred);
+            --m_nWaiters;
+        }
+        void notify() {
+            if(eWaitStrategy==QueueWait_Block && m_nWaiters.load()>0) {
+                std::lock_guard<std::mutex> oLock(m_oMutex);
+                m_oCondVar.notify_all();
+            }
+        }
+        std::vector<T> m_vRing;
+        char m_acPadding0[s_nCacheLineSize];
+        // producer-side data (the cached head only gets reloaded when the ring looks full, so the consumer's line is rarely touched)
+        std::atomic_size_t m_nTail;
+        size_t m_nCachedHead;
+        std::atomic_size_t m_nPushCount,m_nOccupancySum;
+        std::atomic_size_t m_nFullWaitCount;
+        char m_acPadding1[s_nCacheLineSize];
+        // consumer-side data (same, with the cached tail reloaded only when the ring looks empty)
+        std::atomic_size_t m_nHead;
+        size_t m_nCachedTail;
+        std::atomic_size_t m_nEmptyWaitCount;
+        char m_acPadding2[s_nCacheLineSize];
+        // shared sync data (only touched by blocked sides, or when closing)
+        std::atomic_size_t m_nWaiters;
+        std::atomic_bool m_bClosed;
+        std::mutex m_oMutex;
+        std::condition_variable m_oCondVar;
+    };
+
+    /// bounded multi-producer/multi-consumer queue (sequence-numbered ring slots, see Vyukov's bounded mpmc queue); try_push/try_pop are
+    /// lock-free, and the blocking calls follow the given wait strategy (capacity is rounded up to a power of two)
+    template<typename T, QueueWaitStrategy eWaitStrategy=QueueWait_Block>
+    struct BoundedMPMCQueue {
+        explicit BoundedMPMCQueue(size_t nCapacity) :
+                m_nSlotMask(get_next_pow2(std::max(nCapacity,size_t(2)))-1),m_aSlots(new Slot[m_nSlotMask+1]),
+                m_nPushPos(0),m_nPopPos(0),m_nWaiters(0),m_bClosed(false) {
+            for(size_t nSlotIdx=0; nSlotIdx<=m_nSlotMask; ++nSlotIdx)
+                m_aSlots[nSlotIdx].nSeq.store(nSlotIdx,std::memory_order_relaxed);
+        }
+        /// moves an element at the end of the queue if a slot is free (oElem is left untouched otherwise); pnTicket receives its queue position
+        bool try_push(T&& oElem, size_t* pnTicket=nullptr) {
+            size_t nPos = m_nPushPos.load(std::memory_order_relaxed);
+            while(true) {
+                Slot& oSlot = m_aSlots[nPos&m_nSlotMask];
+                const ptrdiff_t nSeqDiff = ptrdiff_t(oSlot.nSeq.load(std::memory_order_acquire))-ptrdiff_t(nPos);
+                if(nSeqDiff==0 && m_nPushPos.compare_exchange_weak(nPos,nPos+1,std::memory_order_relaxed)) {
+                    oSlot.oElem = std::move(oElem);
+                    oSlot.nSeq.store(nPos+1,std::memory_order_seq_cst);
+                    if(pnTicket)
+                        *pnTicket = nPos;
+                    notify();
+                    return true;
+                }
+                else if(nSeqDiff<0) // all slots are in use
+                    return false;
+                else if(nSeqDiff>0) // another producer claimed this position
+                    nPos = m_nPushPos.load(std::memory_order_relaxed);
+            }
+        }
+        /// moves the first element of the queue into oElem if there is one; pnTicket receives its queue position (i.e. its push ticket)
+        bool try_pop(T& oElem, size_t* pnTicket=nullptr) {
+            size_t nPos = m_nPopPos.load(std::memory_order_relaxed);
+            while(true) {
+                Slot& oSlot = m_aSlots[nPos&m_nSlotMask];
+                const ptrdiff_t nSeqDiff = ptrdiff_t(oSlot.nSeq.load(std::memory_order_acquire))-ptrdiff_t(nPos+1);
+                if(nSeqDiff==0 && m_nPopPos.compare_exchange_weak(nPos,nPos+1,std::memory_order_relaxed)) {
+                    oElem = std::move(oSlot.oElem);
+                    oSlot.oElem = T();
+                    oSlot.nSeq.store(nPos+m_nSlotMask+1,std::memory_order_seq_cst);
+                    if(pnTicket)
+                        *pnTicket = nPos;
+                    notify();
+                    return true;
+                }
+                else if(nSeqDiff<0) // queue is empty
+                    return false;
+                else if(nSeqDiff>0) // another consumer claimed this position
+                    nPos = m_nPopPos.load(std::memory_order_relaxed);
+            }
+        }
+        /// moves an element at the end of the queue, blocking while it is full; returns false (dropping the element) if the queue was closed
+        bool push(T&& oElem, size_t* pnTicket=nullptr) {
+            while(!m_bClosed) {
+                if(try_push(std::move(oElem),pnTicket))
+                    return true;
+                wait([&]{return !isFull() || m_bClosed;});
+            }
+            return false;
+        }
+        /// moves the first element of the queue into oElem, blocking while it is empty; returns false once the queue is closed and drained
+        bool pop(T& oElem, size_t* pnTicket=nullptr) {
+            while(true) {
+                if(try_pop(oElem,pnTicket))
+                    return true;
+                if(m_bClosed && isEmpty())
+                    return false;
+                wait([&]{return !isEmpty() || m_bClosed;});
+            }
+        }
+        /// closes the queue; consumers still receive the queued elements, but blocked or later pushes fail (can be called from any thread)
+        void close() {
+            {
+                std::lock_guard<std::mutex> oLock(m_oMutex);
+                m_bClosed = true;
+            }
+            m_oCondVar.notify_all();
+        }
+        /// returns the maximum number of queued elements
+        size_t capacity() const {return m_nSlotMask+1;}
+        /// returns the number of elements pushed so far (i.e. the ticket of the next pushed element)
+        size_t getPushCount() const {return m_nPushPos.load(std::memory_order_relaxed);}
+        /// returns the number of elements popped so far
+        size_t getPopCount() const {return m_nPopPos.load(std::memory_order_relaxed);}
+        BoundedMPMCQueue(const BoundedMPMCQueue&) = delete;
+        BoundedMPMCQueue& operator=(const BoundedMPMCQueue&) = delete;
+    private:
+        /// ring slot, padded so that neighboring producers/consumers rarely share a line; its sequence number tells whether it is free or filled for a given position
+        struct Slot {
+            std::atomic_size_t nSeq;
+            T oElem;
+            char acPadding[s_nCacheLineSize-(sizeof(std::atomic_size_t)+sizeof(T))%s_nCacheLineSize];
+        };
+        static size_t get_next_pow2(size_t n) {
+            size_t nPow2 = 1;
+            while(nPow2<n)
+                nPow2 <<= 1;
+            return nPow2;
+        }
+        bool isFull() const {
+            const size_t nPos = m_nPushPos.load();
+            return ptrdiff_t(m_aSlots[nPos&m_nSlotMask].nSeq.load())-ptrdiff_t(nPos)<0;
+        }
+        bool isEmpty() const {
+            const size_t nPos = m_nPopPos.load();
+            return ptrdiff_t(m_aSlots[nPos&m_nSlotMask].nSeq.load())-ptrdiff_t(nPos+1)<0;
+        }
+        template<typename TPred>
+        void wait(TPred&& lPred) {
+            if(eWaitStrategy==QueueWait_Spin)
+                return spin_wait(lPred);
+            std::unique_lock<std::mutex> oLock(m_oMutex);
+            ++m_nWaiters; // seq_cst, paired with the slot sequence stores: either the waiter sees the update, or the notifier sees the waiter
+            m_oCondVar.wait(oLock,lPred);
+            --m_nWaiters;
+        }
+        void notify() {
+            if(eWaitStrategy==QueueWait_Block && m_nWaiters.load()>0) {
+                std::lock_guard<std::mutex> oLock(m_oMutex);
+                m_oCondVar.notify_all();
+            }
+        }
+        const size_t m_nSlotMask;
+        const std::unique_ptr<Slot[]> m_aSlots;
+        char m_acPadding0[s_nCacheLineSize];
+        std::atomic_size_t m_nPushPos;
+        char m_acPadding1[s_nCacheLineSize-sizeof(std::atomic_size_t)];
+        std::atomic_size_t m_nPopPos;
+        char m_acPadding2[s_nCacheLineSize-sizeof(std::atomic_size_t)];
+        std::atomic_size_t m_nWaiters;
+        std::atomic_bool m_bClosed;
+        mutable std::mutex m_oMutex;
+        std::condition_variable m_oCondVar;
+    };
+
 } // namespace lv
 
 namespace std { // extending std
@@ -516,8 +970,8 @@ namespace std { // extending std
 } // namespace std
 
 template<size_t nWorkers>
-lv::WorkerPool<nWorkers>::WorkerPool() : m_bIsActive(true) {
-    lv::unroll<nWorkers>([this](size_t){m_vhWorkers.emplace_back(std::bind(&WorkerPool::entry,this));});
+lv::WorkerPool<nWorkers>::WorkerPool(ThreadRole eRole) : m_vTaskRing(16), m_nTaskHead(0), m_nTaskCount(0), m_bIsActive(true) {
+    lv::unroll<nWorkers>([this,eRole](size_t){m_vhWorkers.emplace_back(std::bind(&WorkerPool::entry,this,eRole));});
 }
 
 template<size_t nWorkers>
@@ -538,21 +992,71 @@ std::future<std::result_of_t<Tfunc(Targs...)>> lv::WorkerPool<nWorkers>::queueTa
     std::future<task_return_t> oTaskRes = pSharableTask->get_future();
     {
         std::mutex_lock_guard sync_lock(m_oSyncMutex);
-        m_qTasks.emplace([pSharableTask](){(*pSharableTask)();}); // lambda keeps a copy of the task in the queue
+        pushTask([pSharableTask](){(*pSharableTask)();}); // lambda keeps a copy of the task in the queue
     }
     m_oSyncVar.notify_one();
     return oTaskRes;
 }
 
 template<size_t nWorkers>
-void lv::WorkerPool<nWorkers>::entry() {
+template<typename Tfunc>
+void lv::WorkerPool<nWorkers>::submit(Tfunc&& lTask) {
+    {
+        std::mutex_lock_guard sync_lock(m_oSyncMutex);
+        pushTask(std::forward<Tfunc>(lTask));
+    }
+    m_oSyncVar.notify_one();
+}
+
+template<size_t nWorkers>
+template<typename Tfunc>
+void lv::WorkerPool<nWorkers>::submitBulk(size_t nTasks, const Tfunc& lTask, CountdownLatch& oLatch) {
+    if(nTasks==0)
+        return;
+    oLatch.add(nTasks);
+    {
+        std::mutex_lock_guard sync_lock(m_oSyncMutex);
+        for(size_t nTaskIdx=0; nTaskIdx<nTasks; ++nTaskIdx) {
+            // only pointers & the index are stored, so the task always fits in the inline buffer
+            pushTask([plTask=&lTask,nTaskIdx,pLatch=&oLatch]() {
+                try {
+                    (*plTask)(nTaskIdx);
+                }
+                catch(...) {
+                    pLatch->count_down(std::current_exception());
+                    return;
+                }
+                pLatch->count_down();
+            });
+        }
+    }
+    m_oSyncVar.notify_all();
+}
+
+template<size_t nWorkers>
+void lv::WorkerPool<nWorkers>::pushTask(Task&& oTask) {
+    if(m_nTaskCount==m_vTaskRing.size()) {
+        std::vector<Task> vNewTaskRing(m_vTaskRing.size()*2);
+        for(size_t nTaskIdx=0; nTaskIdx<m_nTaskCount; ++nTaskIdx)
+            vNewTaskRing[nTaskIdx] = std::move(m_vTaskRing[(m_nTaskHead+nTaskIdx)%m_vTaskRing.size()]);
+        m_vTaskRing = std::move(vNewTaskRing);
+        m_nTaskHead = 0;
+    }
+    m_vTaskRing[(m_nTaskHead+m_nTaskCount)%m_vTaskRing.size()] = std::move(oTask);
+    ++m_nTaskCount;
+}
+
+template<size_t nWorkers>
+void lv::WorkerPool<nWorkers>::entry(ThreadRole eRole) {
+    lv::ApplyThreadPlacementPolicy(eRole);
     std::mutex_unique_lock sync_lock(m_oSyncMutex);
-    while(m_bIsActive || !m_qTasks.empty()) {
-        if(m_qTasks.empty())
+    while(m_bIsActive || m_nTaskCount>0) {
+        if(m_nTaskCount==0)
             m_oSyncVar.wait(sync_lock);
-        if(!m_qTasks.empty()) {
-            std::function<void()> task = std::move(m_qTasks.front());
-            m_qTasks.pop();
+        if(m_nTaskCount>0) {
+            Task task = std::move(m_vTaskRing[m_nTaskHead]);
+            m_nTaskHead = (m_nTaskHead+1)%m_vTaskRing.size();
+            --m_nTaskCount;
             std::unlock_guard<std::mutex_unique_lock> oUnlock(sync_lock);
             task();
         }
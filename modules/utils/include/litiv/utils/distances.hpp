@@ -63,11 +63,34 @@ namespace lv {
         return L1dist<nChannels>(a,b.data());
     }
 
+    /// computes the L1 distance between two 8-bit unsigned arrays of any length (vectorized when possible, channel-agnostic)
+    inline size_t L1dist_8ub(const uchar* const a, const uchar* const b, size_t nTotElements) {
+        size_t nResult = 0, n = 0;
+#if HAVE_NEON
+        uint64x2_t _anAccum = vdupq_n_u64(0);
+        for(; n+16<=nTotElements; n+=16)
+            _anAccum = vpadalq_u32(_anAccum,vpaddlq_u16(vpaddlq_u8(vabdq_u8(vld1q_u8(a+n),vld1q_u8(b+n)))));
+        nResult = (size_t)(vgetq_lane_u64(_anAccum,0)+vgetq_lane_u64(_anAccum,1));
+#elif HAVE_SSE2
+        __m128i _anAccum = _mm_setzero_si128();
+        for(; n+16<=nTotElements; n+=16)
+            _anAccum = _mm_add_epi64(_anAccum,_mm_sad_epu8(_mm_loadu_si128((const __m128i*)(a+n)),_mm_loadu_si128((const __m128i*)(b+n))));
+        alignas(16) uint64_t anAccum[2];
+        _mm_store_si128((__m128i*)anAccum,_anAccum);
+        nResult = (size_t)(anAccum[0]+anAccum[1]);
+#endif //HAVE_SSE2
+        for(; n<nTotElements; ++n)
+            nResult += L1dist(a[n],b[n]);
+        return nResult;
+    }
+
     /// computes the L1 distance between two generic arrays
     template<size_t nChannels, typename T>
     inline auto L1dist(const T* const a, const T* const b, size_t nElements, const uchar* m=NULL) -> decltype(L1dist<nChannels>(a,b)) {
         decltype(L1dist<nChannels>(a,b)) gResult = 0;
         size_t nTotElements = nElements*nChannels;
+        if(std::is_same<T,uchar>::value && !m)
+            return (decltype(L1dist<nChannels>(a,b)))L1dist_8ub((const uchar*)a,(const uchar*)b,nTotElements);
         if(m) {
             for(size_t n=0,i=0; n<nTotElements; n+=nChannels,++i)
                 if(m[i])
@@ -104,6 +127,150 @@ namespace lv {
         return L1dist<nChannels>(a_array,b_array);
     }
 
+    /// computes the L1 distances between one 8-bit query and up to 16 candidates (nCandStride bytes apart), and returns the bitmask of those within nMaxDist (totals are also written to anTotDists[16] if provided)
+    template<size_t nChannels>
+    inline uint L1dist_block_8ub(const uchar* const q, const uchar* const c, size_t nCands, size_t nCandStride, size_t nMaxDist, ushort* const anTotDists=nullptr) {
+        static_assert(nChannels>0 && nChannels<=4,"block distance function only defined for 1 to 4 channels");
+        lvDbgAssert(nCands>0 && nCands<=16);
+        const uint nValidMask = (nCands==16)?0xFFFFu:((1u<<nCands)-1);
+#if (HAVE_SSE2 || HAVE_NEON)
+        // candidates are gathered channel-wise in a block buffer unless they are already packed (same approach as the BGS sample matchers)
+        const bool bContiguous = (nChannels==1 && nCandStride==1 && nCands==16);
+        alignas(16) std::array<uchar,16> anBlockVals = {};
+#if HAVE_SSE2
+        const __m128i _anZero = _mm_setzero_si128();
+        __m128i _anTotDist_lo = _anZero, _anTotDist_hi = _anZero;
+        for(size_t nChIdx=0; nChIdx<nChannels; ++nChIdx) {
+            if(!bContiguous)
+                for(size_t nCandIdx=0; nCandIdx<nCands; ++nCandIdx)
+                    anBlockVals[nCandIdx] = c[nCandIdx*nCandStride+nChIdx];
+            const __m128i _anCandVals = bContiguous?_mm_loadu_si128((const __m128i*)c):_mm_load_si128((const __m128i*)anBlockVals.data());
+            const __m128i _anQueryVal = _mm_set1_epi8((char)q[nChIdx]);
+            const __m128i _anDist = _mm_or_si128(_mm_subs_epu8(_anCandVals,_anQueryVal),_mm_subs_epu8(_anQueryVal,_anCandVals));
+            _anTotDist_lo = _mm_add_epi16(_anTotDist_lo,_mm_unpacklo_epi8(_anDist,_anZero));
+            _anTotDist_hi = _mm_add_epi16(_anTotDist_hi,_mm_unpackhi_epi8(_anDist,_anZero));
+        }
+        if(anTotDists) {
+            _mm_storeu_si128((__m128i*)anTotDists,_anTotDist_lo);
+            _mm_storeu_si128((__m128i*)(anTotDists+8),_anTotDist_hi);
+        }
+        const __m128i _anMaxDist = _mm_set1_epi16((short)std::min(nMaxDist,(size_t)SHRT_MAX));
+        const __m128i _anMismatch = _mm_packs_epi16(_mm_cmpgt_epi16(_anTotDist_lo,_anMaxDist),_mm_cmpgt_epi16(_anTotDist_hi,_anMaxDist));
+        return uint(~_mm_movemask_epi8(_anMismatch))&nValidMask;
+#else //HAVE_NEON
+        uint16x8_t _anTotDist_lo = vdupq_n_u16(0), _anTotDist_hi = vdupq_n_u16(0);
+        for(size_t nChIdx=0; nChIdx<nChannels; ++nChIdx) {
+            if(!bContiguous)
+                for(size_t nCandIdx=0; nCandIdx<nCands; ++nCandIdx)
+                    anBlockVals[nCandIdx] = c[nCandIdx*nCandStride+nChIdx];
+            const uint8x16_t _anDist = vabdq_u8(vld1q_u8(bContiguous?c:anBlockVals.data()),vdupq_n_u8(q[nChIdx]));
+            _anTotDist_lo = vaddw_u8(_anTotDist_lo,vget_low_u8(_anDist));
+            _anTotDist_hi = vaddw_u8(_anTotDist_hi,vget_high_u8(_anDist));
+        }
+        if(anTotDists) {
+            vst1q_u16(anTotDists,_anTotDist_lo);
+            vst1q_u16(anTotDists+8,_anTotDist_hi);
+        }
+        const uint16x8_t _anMaxDist = vdupq_n_u16((ushort)std::min(nMaxDist,(size_t)USHRT_MAX));
+        return lv::movemask_16ub(vcombine_u8(vmovn_u16(vcleq_u16(_anTotDist_lo,_anMaxDist)),vmovn_u16(vcleq_u16(_anTotDist_hi,_anMaxDist))))&nValidMask;
+#endif //HAVE_NEON
+#else //(!HAVE_SSE2 && !HAVE_NEON)
+        uint nMatchMask = 0;
+        for(size_t nCandIdx=0; nCandIdx<nCands; ++nCandIdx) {
+            const size_t nTotDist = L1dist<nChannels>(q,c+nCandIdx*nCandStride);
+            if(anTotDists)
+                anTotDists[nCandIdx] = (ushort)nTotDist;
+            if(nTotDist<=nMaxDist)
+                nMatchMask |= (1u<<nCandIdx);
+        }
+        return nMatchMask&nValidMask;
+#endif //(!HAVE_SSE2 && !HAVE_NEON)
+    }
+
+    /// computes the L1 distances between one query and nCands candidates, the i-th one starting at c+i*nCandStride (packed by default)
+    template<size_t nChannels, typename T, typename TDist>
+    inline void L1dist_batch(const T* const q, const T* const c, size_t nCands, TDist* const out, size_t nCandStride=nChannels) {
+        if(std::is_same<T,uchar>::value) {
+            alignas(16) std::array<ushort,16> anTotDists;
+            for(size_t nCandIdx=0; nCandIdx<nCands; nCandIdx+=16) {
+                const size_t nBlockSize = std::min(nCands-nCandIdx,size_t(16));
+                L1dist_block_8ub<nChannels>((const uchar*)q,(const uchar*)(c+nCandIdx*nCandStride),nBlockSize,nCandStride,0,anTotDists.data());
+                for(size_t nBlockIdx=0; nBlockIdx<nBlockSize; ++nBlockIdx)
+                    out[nCandIdx+nBlockIdx] = (TDist)anTotDists[nBlockIdx];
+            }
+            return;
+        }
+        for(size_t nCandIdx=0; nCandIdx<nCands; ++nCandIdx)
+            out[nCandIdx] = (TDist)L1dist<nChannels>(q,c+nCandIdx*nCandStride);
+    }
+
+    /// returns the number of candidates (see L1dist_batch) whose L1 distance to the query is at most tMaxDist
+    template<size_t nChannels, typename T, typename TDist>
+    inline size_t L1dist_batch_count(const T* const q, const T* const c, size_t nCands, TDist tMaxDist, size_t nCandStride=nChannels) {
+        size_t nCount = 0;
+        if(std::is_same<T,uchar>::value) {
+            if(tMaxDist<TDist(0))
+                return 0;
+            for(size_t nCandIdx=0; nCandIdx<nCands; nCandIdx+=16)
+                for(uint nMatchMask=L1dist_block_8ub<nChannels>((const uchar*)q,(const uchar*)(c+nCandIdx*nCandStride),std::min(nCands-nCandIdx,size_t(16)),nCandStride,(size_t)tMaxDist); nMatchMask; nMatchMask&=nMatchMask-1)
+                    ++nCount; // popcount helpers are only declared below
+            return nCount;
+        }
+        for(size_t nCandIdx=0; nCandIdx<nCands; ++nCandIdx)
+            nCount += (L1dist<nChannels>(q,c+nCandIdx*nCandStride)<=tMaxDist);
+        return nCount;
+    }
+
+    /// computes the elementwise L1 distances between two arrays of nElements (masked-out elements get a null distance)
+    template<size_t nChannels, typename T, typename TDist>
+    inline void L1dist_elemwise(const T* const a, const T* const b, size_t nElements, TDist* const out, const uchar* m=NULL) {
+        size_t n = 0;
+#if HAVE_SSE2
+        if(nChannels==1 && std::is_same<T,uchar>::value && std::is_same<TDist,uchar>::value) {
+            const uchar* const a8 = (const uchar*)a, * const b8 = (const uchar*)b;
+            uchar* const out8 = (uchar*)out;
+            const __m128i _anZero = _mm_setzero_si128();
+            for(; n+16<=nElements; n+=16) {
+                const __m128i _anA = _mm_loadu_si128((const __m128i*)(a8+n)), _anB = _mm_loadu_si128((const __m128i*)(b8+n));
+                __m128i _anDist = _mm_or_si128(_mm_subs_epu8(_anA,_anB),_mm_subs_epu8(_anB,_anA));
+                if(m)
+                    _anDist = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(m+n)),_anZero),_anDist);
+                _mm_storeu_si128((__m128i*)(out8+n),_anDist);
+            }
+        }
+        else if(nChannels==1 && std::is_same<T,float>::value && std::is_same<TDist,float>::value) {
+            const float* const a32 = (const float*)a, * const b32 = (const float*)b;
+            float* const out32 = (float*)out;
+            const __m128 _afAbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+            for(; n+4<=nElements; n+=4) {
+                __m128 _afDist = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(a32+n),_mm_loadu_ps(b32+n)),_afAbsMask);
+                if(m) {
+                    int nMaskBytes;
+                    std::memcpy(&nMaskBytes,m+n,sizeof(int));
+                    const __m128i _anMask8 = _mm_cvtsi32_si128(nMaskBytes), _anZero = _mm_setzero_si128();
+                    const __m128i _anMask32 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_anMask8,_anZero),_anZero);
+                    _afDist = _mm_andnot_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_anMask32,_anZero)),_afDist);
+                }
+                _mm_storeu_ps(out32+n,_afDist);
+            }
+        }
+#elif HAVE_NEON
+        if(nChannels==1 && std::is_same<T,uchar>::value && std::is_same<TDist,uchar>::value) {
+            const uchar* const a8 = (const uchar*)a, * const b8 = (const uchar*)b;
+            uchar* const out8 = (uchar*)out;
+            for(; n+16<=nElements; n+=16) {
+                uint8x16_t _anDist = vabdq_u8(vld1q_u8(a8+n),vld1q_u8(b8+n));
+                if(m)
+                    _anDist = vandq_u8(_anDist,vtstq_u8(vld1q_u8(m+n),vld1q_u8(m+n)));
+                vst1q_u8(out8+n,_anDist);
+            }
+        }
+#endif //HAVE_NEON
+        // remaining elements (and all other types/channel counts) use a branchless loop the compiler can vectorize
+        for(; n<nElements; ++n)
+            out[n] = (m && !m[n])?TDist(0):(TDist)L1dist<nChannels>(a+n*nChannels,b+n*nChannels);
+    }
+
     ///////////////////////////////////////////////////////////////////////////////////////////////////
 
     /// computes the squared L2 distance between two generic variables
@@ -182,6 +349,29 @@ namespace lv {
         return L2sqrdist<nChannels>(a_array,b_array);
     }
 
+    /// computes the squared L2 distances between one query and nCands candidates, the i-th one starting at c+i*nCandStride (packed by default)
+    template<size_t nChannels, typename T, typename TDist>
+    inline void L2sqrdist_batch(const T* const q, const T* const c, size_t nCands, TDist* const out, size_t nCandStride=nChannels) {
+        for(size_t nCandIdx=0; nCandIdx<nCands; ++nCandIdx)
+            out[nCandIdx] = (TDist)L2sqrdist<nChannels>(q,c+nCandIdx*nCandStride);
+    }
+
+    /// returns the number of candidates (see L2sqrdist_batch) whose squared L2 distance to the query is at most tMaxDist
+    template<size_t nChannels, typename T, typename TDist>
+    inline size_t L2sqrdist_batch_count(const T* const q, const T* const c, size_t nCands, TDist tMaxDist, size_t nCandStride=nChannels) {
+        size_t nCount = 0;
+        for(size_t nCandIdx=0; nCandIdx<nCands; ++nCandIdx)
+            nCount += (L2sqrdist<nChannels>(q,c+nCandIdx*nCandStride)<=tMaxDist);
+        return nCount;
+    }
+
+    /// computes the elementwise squared L2 distances between two arrays of nElements (masked-out elements get a null distance)
+    template<size_t nChannels, typename T, typename TDist>
+    inline void L2sqrdist_elemwise(const T* const a, const T* const b, size_t nElements, TDist* const out, const uchar* m=NULL) {
+        for(size_t n=0; n<nElements; ++n)
+            out[n] = (m && !m[n])?TDist(0):(TDist)L2sqrdist<nChannels>(a+n*nChannels,b+n*nChannels);
+    }
+
     /// computes the L2 distance between two generic arrays
     template<size_t nChannels, typename T>
     inline float L2dist(const T* const a, const T* const b) {
@@ -376,6 +566,180 @@ namespace lv {
         return cdist<nChannels>(a_array,b_array);
     }
 
+    /// returns whether the color distortion between two integer arrays is at most nMaxDist (exact w.r.t. cdist for 8-bit inputs, but checked in the squared domain without division/sqrt)
+    template<size_t nChannels, typename T>
+    inline std::enable_if_t<std::is_integral<T>::value,bool> cdist_within(const T* const curr, const T* const bg, size_t nMaxDist) {
+        static_assert(nChannels>1,"vectors should have more than one channel");
+        // since cdist returns floor(sqrt(D)) with D = |curr|^2 - floor(mix^2/|bg|^2), we have cdist<=t <=> D<(t+1)^2 <=> mix^2 >= (|curr|^2-(t+1)^2+1)*|bg|^2;
+        // constant or identical inputs need no special case (D is then exactly null), and only the null-bg fallback of cdist has to be replicated
+        uint64_t curr_sqr = 0;
+        uint64_t bg_sqr = 0;
+        uint64_t mix = 0;
+        for(size_t c=0; c<nChannels; ++c) {
+            curr_sqr += uint64_t(curr[c])*curr[c];
+            bg_sqr += uint64_t(bg[c])*bg[c];
+            mix += uint64_t(curr[c])*bg[c];
+        }
+        if(!bg_sqr) {
+            bool bNonConstCurr = false;
+            size_t nulldist = curr[0];
+            for(size_t c=1; c<nChannels; ++c) {
+                bNonConstCurr |= (curr[c]!=curr[c-1]);
+                nulldist += curr[c];
+            }
+            return !bNonConstCurr || nulldist<=nMaxDist;
+        }
+        const uint64_t nMaxDistSqr = uint64_t(std::min(nMaxDist,(size_t)UINT32_MAX-1)+1)*(std::min(nMaxDist,(size_t)UINT32_MAX-1)+1);
+        return curr_sqr<nMaxDistSqr || mix*mix>=(curr_sqr-nMaxDistSqr+1)*bg_sqr;
+    }
+
+    /// returns whether the color distortion between two generic arrays is at most nMaxDist (see cdist_within)
+    template<size_t nChannels, typename T>
+    inline bool cdist_within(const std::array<T,nChannels>& a, const std::array<T,nChannels>& b, size_t nMaxDist) {
+        return cdist_within<nChannels>(a.data(),b.data(),nMaxDist);
+    }
+
+    /// returns whether the color distortion between two generic arrays is at most nMaxDist (see cdist_within)
+    template<size_t nChannels, typename T>
+    inline bool cdist_within(const std::array<T,nChannels>& a, const T* const b, size_t nMaxDist) {
+        return cdist_within<nChannels>(a.data(),b,nMaxDist);
+    }
+
+    /// returns whether the color distortion between two generic arrays is at most nMaxDist (see cdist_within)
+    template<size_t nChannels, typename T>
+    inline bool cdist_within(const T* const a, const std::array<T,nChannels>& b, size_t nMaxDist) {
+        return cdist_within<nChannels>(a,b.data(),nMaxDist);
+    }
+
+    /// computes the color distortions between one 8-bit query and up to 16 candidates (nCandStride bytes apart), and returns the bitmask of those within nMaxDist (exact w.r.t. cdist, see cdist_within)
+    template<size_t nChannels>
+    inline uint cdist_block_8ub(const uchar* const q, const uchar* const c, size_t nCands, size_t nCandStride, size_t nMaxDist) {
+        static_assert(nChannels>1 && nChannels<=4,"block distance function only defined for 2 to 4 channels");
+        lvDbgAssert(nCands>0 && nCands<=16);
+        const uint nValidMask = (nCands==16)?0xFFFFu:((1u<<nCands)-1);
+        // 8-bit distortions cannot exceed 4*255 (null-bg fallback), which also keeps all squared terms below 2^37
+        if(nMaxDist>=nChannels*UCHAR_MAX)
+            return nValidMask;
+#if (HAVE_SSE2 || HAVE_NEON)
+        size_t nQuerySqr = 0, nQuerySum = 0;
+        bool bNonConstQuery = false;
+        for(size_t nChIdx=0; nChIdx<nChannels; ++nChIdx) {
+            nQuerySqr += size_t(q[nChIdx])*q[nChIdx];
+            nQuerySum += q[nChIdx];
+            bNonConstQuery |= (nChIdx>0 && q[nChIdx]!=q[nChIdx-1]);
+        }
+        // null-bg candidates always pass the squared-domain test below, so they are only masked out if cdist's fallback would reject them
+        const bool bNullBGMatch = !bNonConstQuery || nQuerySum<=nMaxDist;
+        const uint nK1 = (uint)std::max((ptrdiff_t)nQuerySqr-(ptrdiff_t)((nMaxDist+1)*(nMaxDist+1))+1,(ptrdiff_t)0);
+        alignas(16) std::array<uchar,16> anBlockVals = {};
+#if HAVE_SSE2
+        const __m128i _anZero = _mm_setzero_si128();
+        __m128i _anBGSqr[4] = {_anZero,_anZero,_anZero,_anZero}, _anMix[4] = {_anZero,_anZero,_anZero,_anZero};
+        for(size_t nChIdx=0; nChIdx<nChannels; ++nChIdx) {
+            for(size_t nCandIdx=0; nCandIdx<nCands; ++nCandIdx)
+                anBlockVals[nCandIdx] = c[nCandIdx*nCandStride+nChIdx];
+            const __m128i _anCandVals = _mm_load_si128((const __m128i*)anBlockVals.data());
+            const __m128i _anQueryVal = _mm_set1_epi16((short)q[nChIdx]);
+            for(size_t nHalfIdx=0; nHalfIdx<2; ++nHalfIdx) {
+                // all 8-bit products fit in unsigned 16-bit lanes, and are then widened for accumulation
+                const __m128i _anVals = nHalfIdx?_mm_unpackhi_epi8(_anCandVals,_anZero):_mm_unpacklo_epi8(_anCandVals,_anZero);
+                const __m128i _anSqr = _mm_mullo_epi16(_anVals,_anVals), _anProd = _mm_mullo_epi16(_anVals,_anQueryVal);
+                _anBGSqr[nHalfIdx*2] = _mm_add_epi32(_anBGSqr[nHalfIdx*2],_mm_unpacklo_epi16(_anSqr,_anZero));
+                _anBGSqr[nHalfIdx*2+1] = _mm_add_epi32(_anBGSqr[nHalfIdx*2+1],_mm_unpackhi_epi16(_anSqr,_anZero));
+                _anMix[nHalfIdx*2] = _mm_add_epi32(_anMix[nHalfIdx*2],_mm_unpacklo_epi16(_anProd,_anZero));
+                _anMix[nHalfIdx*2+1] = _mm_add_epi32(_anMix[nHalfIdx*2+1],_mm_unpackhi_epi16(_anProd,_anZero));
+            }
+        }
+        const __m128i _anK1 = _mm_set1_epi32((int)nK1);
+        uint nMismatchMask = 0;
+        for(size_t nQuadIdx=0; nQuadIdx<4; ++nQuadIdx) {
+            // mismatch <=> mix^2-K1*|bg|^2 < 0, tested via the sign bits of the 64-bit differences (even lanes first, then odd ones)
+            const __m128i _anMix_odd = _mm_srli_epi64(_anMix[nQuadIdx],32);
+            const uint nMismatch_even = (uint)_mm_movemask_pd(_mm_castsi128_pd(_mm_sub_epi64(_mm_mul_epu32(_anMix[nQuadIdx],_anMix[nQuadIdx]),_mm_mul_epu32(_anBGSqr[nQuadIdx],_anK1))));
+            const uint nMismatch_odd = (uint)_mm_movemask_pd(_mm_castsi128_pd(_mm_sub_epi64(_mm_mul_epu32(_anMix_odd,_anMix_odd),_mm_mul_epu32(_mm_srli_epi64(_anBGSqr[nQuadIdx],32),_anK1))));
+            uint nQuadMismatch = (nMismatch_even&1)|((nMismatch_odd&1)<<1)|((nMismatch_even&2)<<1)|((nMismatch_odd&2)<<2);
+            if(!bNullBGMatch)
+                nQuadMismatch |= (uint)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_anBGSqr[nQuadIdx],_anZero)));
+            nMismatchMask |= nQuadMismatch<<(nQuadIdx*4);
+        }
+        return ~nMismatchMask&nValidMask;
+#else //HAVE_NEON
+        uint32x4_t _anBGSqr[4], _anMix[4];
+        for(size_t nQuadIdx=0; nQuadIdx<4; ++nQuadIdx)
+            _anBGSqr[nQuadIdx] = _anMix[nQuadIdx] = vdupq_n_u32(0);
+        for(size_t nChIdx=0; nChIdx<nChannels; ++nChIdx) {
+            for(size_t nCandIdx=0; nCandIdx<nCands; ++nCandIdx)
+                anBlockVals[nCandIdx] = c[nCandIdx*nCandStride+nChIdx];
+            const uint8x16_t _anCandVals = vld1q_u8(anBlockVals.data());
+            const uint16x4_t _anQueryVal = vdup_n_u16((ushort)q[nChIdx]);
+            for(size_t nHalfIdx=0; nHalfIdx<2; ++nHalfIdx) {
+                const uint16x8_t _anVals = vmovl_u8(nHalfIdx?vget_high_u8(_anCandVals):vget_low_u8(_anCandVals));
+                _anBGSqr[nHalfIdx*2] = vmlal_u16(_anBGSqr[nHalfIdx*2],vget_low_u16(_anVals),vget_low_u16(_anVals));
+                _anBGSqr[nHalfIdx*2+1] = vmlal_u16(_anBGSqr[nHalfIdx*2+1],vget_high_u16(_anVals),vget_high_u16(_anVals));
+                _anMix[nHalfIdx*2] = vmlal_u16(_anMix[nHalfIdx*2],vget_low_u16(_anVals),_anQueryVal);
+                _anMix[nHalfIdx*2+1] = vmlal_u16(_anMix[nHalfIdx*2+1],vget_high_u16(_anVals),_anQueryVal);
+            }
+        }
+        const uint32x2_t _anK1 = vdup_n_u32(nK1);
+        uint16x4_t _anMismatch[4];
+        for(size_t nQuadIdx=0; nQuadIdx<4; ++nQuadIdx) {
+            // mismatch <=> mix^2-K1*|bg|^2 < 0, tested via the sign bits of the 64-bit differences
+            const uint64x2_t _anDiff_lo = vsubq_u64(vmull_u32(vget_low_u32(_anMix[nQuadIdx]),vget_low_u32(_anMix[nQuadIdx])),vmull_u32(vget_low_u32(_anBGSqr[nQuadIdx]),_anK1));
+            const uint64x2_t _anDiff_hi = vsubq_u64(vmull_u32(vget_high_u32(_anMix[nQuadIdx]),vget_high_u32(_anMix[nQuadIdx])),vmull_u32(vget_high_u32(_anBGSqr[nQuadIdx]),_anK1));
+            uint32x4_t _anQuadMismatch = vcombine_u32(vmovn_u64(vshrq_n_u64(_anDiff_lo,63)),vmovn_u64(vshrq_n_u64(_anDiff_hi,63)));
+            _anQuadMismatch = vtstq_u32(_anQuadMismatch,_anQuadMismatch);
+            if(!bNullBGMatch)
+                _anQuadMismatch = vorrq_u32(_anQuadMismatch,vceqq_u32(_anBGSqr[nQuadIdx],vdupq_n_u32(0)));
+            _anMismatch[nQuadIdx] = vmovn_u32(_anQuadMismatch);
+        }
+        const uint8x16_t _anMismatchMask = vcombine_u8(vmovn_u16(vcombine_u16(_anMismatch[0],_anMismatch[1])),vmovn_u16(vcombine_u16(_anMismatch[2],_anMismatch[3])));
+        return ~lv::movemask_16ub(_anMismatchMask)&nValidMask;
+#endif //HAVE_NEON
+#else //(!HAVE_SSE2 && !HAVE_NEON)
+        uint nMatchMask = 0;
+        for(size_t nCandIdx=0; nCandIdx<nCands; ++nCandIdx)
+            if(cdist_within<nChannels>(q,c+nCandIdx*nCandStride,nMaxDist))
+                nMatchMask |= (1u<<nCandIdx);
+        return nMatchMask&nValidMask;
+#endif //(!HAVE_SSE2 && !HAVE_NEON)
+    }
+
+    /// computes the color distortions between one query (as 'curr') and nCands candidates (as 'bg'), the i-th one starting at c+i*nCandStride (packed by default)
+    template<size_t nChannels, typename T, typename TDist>
+    inline void cdist_batch(const T* const q, const T* const c, size_t nCands, TDist* const out, size_t nCandStride=nChannels) {
+        for(size_t nCandIdx=0; nCandIdx<nCands; ++nCandIdx)
+            out[nCandIdx] = (TDist)cdist<nChannels>(q,c+nCandIdx*nCandStride);
+    }
+
+    /// returns the number of candidates (see cdist_batch) whose color distortion w.r.t. the query is at most tMaxDist
+    template<size_t nChannels, typename T, typename TDist>
+    inline size_t cdist_batch_count(const T* const q, const T* const c, size_t nCands, TDist tMaxDist, size_t nCandStride=nChannels) {
+        size_t nCount = 0;
+        for(size_t nCandIdx=0; nCandIdx<nCands; ++nCandIdx)
+            nCount += (cdist<nChannels>(q,c+nCandIdx*nCandStride)<=tMaxDist);
+        return nCount;
+    }
+
+    /// returns the number of 8-bit candidates (see cdist_batch) whose color distortion w.r.t. the query is at most tMaxDist (processed in blocks of 16, see cdist_block_8ub)
+    template<size_t nChannels, typename TDist>
+    inline size_t cdist_batch_count(const uchar* const q, const uchar* const c, size_t nCands, TDist tMaxDist, size_t nCandStride=nChannels) {
+        if(tMaxDist<TDist(0))
+            return 0;
+        const size_t nMaxDist = (size_t)std::min(tMaxDist,(TDist)(nChannels*UCHAR_MAX));
+        size_t nCount = 0;
+        for(size_t nCandIdx=0; nCandIdx<nCands; nCandIdx+=16)
+            for(uint nMatchMask=cdist_block_8ub<nChannels>(q,c+nCandIdx*nCandStride,std::min(nCands-nCandIdx,(size_t)16),nCandStride,nMaxDist); nMatchMask; nMatchMask&=nMatchMask-1)
+                ++nCount;
+        return nCount;
+    }
+
+    /// computes the elementwise color distortions between two arrays of nElements (masked-out elements get a null distortion)
+    template<size_t nChannels, typename T, typename TDist>
+    inline void cdist_elemwise(const T* const a, const T* const b, size_t nElements, TDist* const out, const uchar* m=NULL) {
+        for(size_t n=0; n<nElements; ++n)
+            out[n] = (m && !m[n])?TDist(0):(TDist)cdist<nChannels>(a+n*nChannels,b+n*nChannels);
+    }
+
     /// computes a color distortion-distance mix using two generic distances
     template<typename T>
     inline T cmixdist(T oL1Distance, T oCDistortion) {
@@ -388,6 +752,43 @@ namespace lv {
         return cmixdist(L1dist<nChannels>(curr,bg),cdist<nChannels>(curr,bg));
     }
 
+    /// returns whether the color distortion-distance mix for a precomputed L1 distance is at most nMaxMixDist, without computing the exact distortion (see cdist_within)
+    template<size_t nChannels, typename T>
+    inline bool cmixdist_within(size_t nL1Distance, const T* const curr, const T* const bg, size_t nMaxMixDist) {
+        // integer mix is L1/2+cdist*4, so its bound translates to cdist<=(max-L1/2)/4 (floored)
+        return nL1Distance/2<=nMaxMixDist && cdist_within<nChannels>(curr,bg,(nMaxMixDist-nL1Distance/2)/4);
+    }
+
+    /// returns whether the color distortion-distance mix using two generic arrays is at most nMaxMixDist (see cdist_within)
+    template<size_t nChannels, typename T>
+    inline bool cmixdist_within(const T* const curr, const T* const bg, size_t nMaxMixDist) {
+        return cmixdist_within<nChannels>(L1dist<nChannels>(curr,bg),curr,bg,nMaxMixDist);
+    }
+
+    /// returns whether the color distortion-distance mix using two generic arrays is at most nMaxMixDist (see cdist_within)
+    template<size_t nChannels, typename T>
+    inline bool cmixdist_within(const std::array<T,nChannels>& a, const std::array<T,nChannels>& b, size_t nMaxMixDist) {
+        return cmixdist_within<nChannels>(a.data(),b.data(),nMaxMixDist);
+    }
+
+    /// returns whether the color distortion-distance mix using two generic arrays is at most nMaxMixDist (see cdist_within)
+    template<size_t nChannels, typename T>
+    inline bool cmixdist_within(const std::array<T,nChannels>& a, const T* const b, size_t nMaxMixDist) {
+        return cmixdist_within<nChannels>(a.data(),b,nMaxMixDist);
+    }
+
+    /// returns whether the color distortion-distance mix using two generic arrays is at most nMaxMixDist (see cdist_within)
+    template<size_t nChannels, typename T>
+    inline bool cmixdist_within(const T* const a, const std::array<T,nChannels>& b, size_t nMaxMixDist) {
+        return cmixdist_within<nChannels>(a,b.data(),nMaxMixDist);
+    }
+
+    /// returns whether the color distortion-distance mix for a precomputed L1 distance is at most nMaxMixDist (see cdist_within)
+    template<size_t nChannels, typename T>
+    inline bool cmixdist_within(size_t nL1Distance, const T* const a, const std::array<T,nChannels>& b, size_t nMaxMixDist) {
+        return cmixdist_within<nChannels>(nL1Distance,a,b.data(),nMaxMixDist);
+    }
+
     /// computes a color distortion-distance mix using two generic arrays
     template<size_t nChannels, typename T>
     inline auto cmixdist(const std::array<T,nChannels>& a, const std::array<T,nChannels>& b) -> decltype(cmixdist<nChannels>(a.data(),b.data())) {
@@ -428,6 +829,8 @@ namespace lv {
         4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8,
     };
 
+    // note: the popcount overloads below are called per descriptor and must inline, so they stay selected by the global instruction
+    // set flags; bulk loops that need runtime selection go through per-TU kernels instead (see lv::hdist_bulk or the metrics kernels)
     /// computes the population count of an 8-bit vector using an 8-bit popcount LUT
     template<typename T>
     inline std::enable_if_t<(sizeof(T)==1),size_t> popcount(const T x) {
@@ -451,7 +854,17 @@ namespace lv {
         return _mm_popcnt_u64((uint64)x);
     }
 
-#else //(!HAVE_POPCNT)
+#elif HAVE_NEON
+
+    /// computes the population count of a 2-, 4- or 8-byte vector using the NEON per-byte bit count instruction
+    template<typename T>
+    inline std::enable_if_t<(sizeof(T)>1 && sizeof(T)<=8),size_t> popcount(const T x) {
+        static_assert(std::is_integral<T>::value,"type must be integral");
+        const uint8x8_t _anBitCounts = vcnt_u8(vcreate_u8((uint64_t)(std::make_unsigned_t<T>)x));
+        return (size_t)vget_lane_u64(vpaddl_u32(vpaddl_u16(vpaddl_u8(_anBitCounts))),0);
+    }
+
+#else //(!HAVE_POPCNT && !HAVE_NEON)
 
     /// computes the population count of an N-byte vector using an 8-bit popcount LUT
     template<typename T>
@@ -463,7 +876,7 @@ namespace lv {
         return nResult;
     }
 
-#endif //(!HAVE_POPCNT)
+#endif //(!HAVE_POPCNT && !HAVE_NEON)
 
     /// computes the population count of a (nChannels*N)-byte vector
     template<size_t nChannels, typename T>
@@ -522,6 +935,12 @@ namespace lv {
         return hdist<nChannels>(a,b.data());
     }
 
+    /// computes the hamming distances between n pairs of 16-bit descriptors in bulk (runtime-dispatched SIMD implementation)
+    void hdist_bulk(const ushort* a, const ushort* b, size_t n, uchar* out);
+
+    /// counts the pairs of 16-bit descriptors (out of n) with a hamming distance under or equal to nMaxDist (runtime-dispatched SIMD implementation)
+    size_t hdist_bulk_count(const ushort* a, const ushort* b, size_t n, size_t nMaxDist);
+
     /// computes the gradient magnitude distance between two (nChannels*N)-byte vectors
     template<size_t nChannels, typename T>
     inline size_t gdist(const T* const a, const T* const b) {
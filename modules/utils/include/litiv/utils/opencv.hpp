@@ -21,12 +21,68 @@
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 #include "litiv/utils/cxx.hpp"
+#include "litiv/utils/platform.hpp"
 
 namespace cv { // extending cv
 
     struct DisplayHelper;
     using DisplayHelperPtr = std::shared_ptr<DisplayHelper>;
 
+    /// cv::MatAllocator adapter handing out lv::FrameArena memory (headers included); matrices must be released before the arena is reset
+    struct ArenaMatAllocator : public MatAllocator {
+#if CV_VERSION_MAJOR>=4
+        using AccessFlagType = AccessFlag;
+#else //(CV_VERSION_MAJOR<4)
+        using AccessFlagType = int;
+#endif //(CV_VERSION_MAJOR<4)
+        /// creates an adapter over the given arena (which must outlive it)
+        explicit ArenaMatAllocator(lv::FrameArena& oArena) : m_oArena(oArena), m_nLiveCount(0) {}
+        virtual UMatData* allocate(int nDims, const int* anSizes, int nType, void* pData, size_t* anSteps, AccessFlagType nFlags, UMatUsageFlags eUsageFlags) const override;
+        virtual bool allocate(UMatData* pData, AccessFlagType nAccessFlags, UMatUsageFlags eUsageFlags) const override;
+        virtual void deallocate(UMatData* pData) const override;
+        /// returns a new matrix of the given size & type stored in the arena
+        cv::Mat create(const cv::Size& oSize, int nType) const;
+        /// returns the number of arena-backed matrices still alive
+        size_t getLiveCount() const {return m_nLiveCount;}
+        /// resets the underlying arena (all matrices allocated through this adapter must already be released)
+        void reset();
+    private:
+        lv::FrameArena& m_oArena;
+        mutable size_t m_nLiveCount;
+    };
+
+    /// cv::MatAllocator for large long-lived matrices (e.g. per-pixel models), backed by lv::AllocLargeMem (huge pages + NUMA node binding)
+    struct LargePageMatAllocator : public MatAllocator {
+        using AccessFlagType = ArenaMatAllocator::AccessFlagType;
+        virtual UMatData* allocate(int nDims, const int* anSizes, int nType, void* pData, size_t* anSteps, AccessFlagType nFlags, UMatUsageFlags eUsageFlags) const override;
+        virtual bool allocate(UMatData* pData, AccessFlagType nAccessFlags, UMatUsageFlags eUsageFlags) const override;
+        virtual void deallocate(UMatData* pData) const override;
+        /// returns the NUMA node the allocations are bound to (-1 = default policy)
+        int getNUMANode() const {return m_nNUMANode;}
+        /// returns the (process-wide) allocator instance bound to the given NUMA node (-1 = default policy)
+        static LargePageMatAllocator* get(int nNUMANode=-1);
+        /// makes oDst a copy of oSrc sharing its pages in copy-on-write mode (see lv::ShareLargeMemCOW); returns false (leaving both untouched) if oSrc
+        /// does not own a whole large page allocation, or if the platform does not support it, in which case callers should fall back to a deep copy
+        static bool shareCOW(cv::Mat& oSrc, cv::Mat& oDst);
+    private:
+        explicit LargePageMatAllocator(int nNUMANode) : m_nNUMANode(nNUMANode) {}
+        const int m_nNUMANode;
+    };
+
+    /// cv::MatAllocator mirroring cv::StdMatAllocator, but attributing each allocation to the calling thread's lv::MemoryTracker tag
+    struct TrackingMatAllocator : public MatAllocator {
+        using AccessFlagType = ArenaMatAllocator::AccessFlagType;
+        virtual UMatData* allocate(int nDims, const int* anSizes, int nType, void* pData, size_t* anSteps, AccessFlagType nFlags, UMatUsageFlags eUsageFlags) const override;
+        virtual bool allocate(UMatData* pData, AccessFlagType nAccessFlags, UMatUsageFlags eUsageFlags) const override;
+        virtual void deallocate(UMatData* pData) const override;
+        /// returns the (process-wide) allocator instance
+        static TrackingMatAllocator* get();
+        /// installs (or uninstalls) the tracking allocator as the default allocator of all new cv::Mat objects
+        static void setAsDefault(bool bEnable=true);
+    private:
+        TrackingMatAllocator() = default;
+    };
+
     /// returns pixel coordinates clamped to the given image & border size
     inline void clampImageCoords(int& nSampleCoord_X,int& nSampleCoord_Y,const int nBorderSize,const cv::Size& oImageSize) {
         if(nSampleCoord_X<nBorderSize)
@@ -39,12 +95,12 @@ namespace cv { // extending cv
             nSampleCoord_Y = oImageSize.height-nBorderSize-1;
     }
 
-    /// returns a random init/sampling position for the specified pixel position, given a predefined kernel; also guards against out-of-bounds values via image/border size check.
-    template<int nKernelHeight,int nKernelWidth>
+    /// returns a random init/sampling position for the specified pixel position, given a predefined kernel and a random number generator functor; also guards against out-of-bounds values via image/border size check.
+    template<int nKernelHeight,int nKernelWidth,typename TRNG>
     inline void getRandSamplePosition(const std::array<std::array<int,nKernelWidth>,nKernelHeight>& anSamplesInitPattern,
                                              const int nSamplesInitPatternTot,int& nSampleCoord_X,int& nSampleCoord_Y,
-                                             const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize) {
-        int r = 1+rand()%nSamplesInitPatternTot;
+                                             const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize,TRNG&& oRNG) {
+        int r = 1+int(size_t(oRNG())%nSamplesInitPatternTot);
         for(nSampleCoord_X=0; nSampleCoord_X<nKernelWidth; ++nSampleCoord_X) {
             for(nSampleCoord_Y=0; nSampleCoord_Y<nKernelHeight; ++nSampleCoord_Y) {
                 r -= anSamplesInitPattern[nSampleCoord_Y][nSampleCoord_X];
@@ -59,7 +115,8 @@ namespace cv { // extending cv
     }
 
     /// returns a random init/sampling position for the specified pixel position; also guards against out-of-bounds values via image/border size check.
-    inline void getRandSamplePosition_3x3_std1(int& nSampleCoord_X,int& nSampleCoord_Y,const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize) {
+    template<typename TRNG>
+    inline void getRandSamplePosition_3x3_std1(int& nSampleCoord_X,int& nSampleCoord_Y,const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize,TRNG&& oRNG) {
         // based on 'floor(fspecial('gaussian',3,1)*256)'
         static_assert(sizeof(std::array<int,3>)==sizeof(int)*3,"bad std::array stl impl");
         static const int s_nSamplesInitPatternTot = 256;
@@ -68,11 +125,17 @@ namespace cv { // extending cv
                 std::array<int,3>{32,52,32,},
                 std::array<int,3>{19,32,19,},
         };
-        getRandSamplePosition<3,3>(s_anSamplesInitPattern,s_nSamplesInitPatternTot,nSampleCoord_X,nSampleCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize);
+        getRandSamplePosition<3,3>(s_anSamplesInitPattern,s_nSamplesInitPatternTot,nSampleCoord_X,nSampleCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize,std::forward<TRNG>(oRNG));
+    }
+
+    /// returns a random init/sampling position for the specified pixel position using the global (C) random number generator; also guards against out-of-bounds values via image/border size check.
+    inline void getRandSamplePosition_3x3_std1(int& nSampleCoord_X,int& nSampleCoord_Y,const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize) {
+        getRandSamplePosition_3x3_std1(nSampleCoord_X,nSampleCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize,[](){return rand();});
     }
 
     /// returns a random init/sampling position for the specified pixel position; also guards against out-of-bounds values via image/border size check.
-    inline void getRandSamplePosition_7x7_std2(int& nSampleCoord_X,int& nSampleCoord_Y,const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize) {
+    template<typename TRNG>
+    inline void getRandSamplePosition_7x7_std2(int& nSampleCoord_X,int& nSampleCoord_Y,const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize,TRNG&& oRNG) {
         // based on 'floor(fspecial('gaussian',7,2)*512)'
         static_assert(sizeof(std::array<int,7>)==sizeof(int)*7,"bad std::array stl impl");
         static const int s_nSamplesInitPatternTot = 512;
@@ -85,34 +148,46 @@ namespace cv { // extending cv
                 std::array<int,7>{ 4, 8,12,14,12, 8, 4,},
                 std::array<int,7>{ 2, 4, 6, 7, 6, 4, 2,},
         };
-        getRandSamplePosition<7,7>(s_anSamplesInitPattern,s_nSamplesInitPatternTot,nSampleCoord_X,nSampleCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize);
+        getRandSamplePosition<7,7>(s_anSamplesInitPattern,s_nSamplesInitPatternTot,nSampleCoord_X,nSampleCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize,std::forward<TRNG>(oRNG));
+    }
+
+    /// returns a random init/sampling position for the specified pixel position using the global (C) random number generator; also guards against out-of-bounds values via image/border size check.
+    inline void getRandSamplePosition_7x7_std2(int& nSampleCoord_X,int& nSampleCoord_Y,const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize) {
+        getRandSamplePosition_7x7_std2(nSampleCoord_X,nSampleCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize,[](){return rand();});
     }
 
-    /// returns a random neighbor position for the specified pixel position, given a predefined neighborhood; also guards against out-of-bounds values via image/border size check.
-    template<int nNeighborCount>
+    /// returns a random neighbor position for the specified pixel position, given a predefined neighborhood and a random number generator functor; also guards against out-of-bounds values via image/border size check.
+    template<int nNeighborCount, typename TRNG>
     inline void getRandNeighborPosition(const std::array<std::array<int,2>,nNeighborCount>& anNeighborPattern,
                                                int& nNeighborCoord_X,int& nNeighborCoord_Y,
                                                const int nOrigCoord_X,const int nOrigCoord_Y,
-                                               const int nBorderSize,const cv::Size& oImageSize) {
-        int r = rand()%nNeighborCount;
+                                               const int nBorderSize,const cv::Size& oImageSize,TRNG&& oRNG) {
+        const int r = int(size_t(oRNG())%nNeighborCount);
         nNeighborCoord_X = nOrigCoord_X+anNeighborPattern[r][0];
         nNeighborCoord_Y = nOrigCoord_Y+anNeighborPattern[r][1];
         clampImageCoords(nNeighborCoord_X,nNeighborCoord_Y,nBorderSize,oImageSize);
     }
 
     /// returns a random neighbor position for the specified pixel position; also guards against out-of-bounds values via image/border size check.
-    inline void getRandNeighborPosition_3x3(int& nNeighborCoord_X,int& nNeighborCoord_Y,const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize) {
+    template<typename TRNG>
+    inline void getRandNeighborPosition_3x3(int& nNeighborCoord_X,int& nNeighborCoord_Y,const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize,TRNG&& oRNG) {
         typedef std::array<int,2> Nb;
         static const std::array<std::array<int,2>,8> s_anNeighborPattern ={
                 Nb{-1, 1},Nb{0, 1},Nb{1, 1},
                 Nb{-1, 0},         Nb{1, 0},
                 Nb{-1,-1},Nb{0,-1},Nb{1,-1},
         };
-        getRandNeighborPosition<8>(s_anNeighborPattern,nNeighborCoord_X,nNeighborCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize);
+        getRandNeighborPosition<8>(s_anNeighborPattern,nNeighborCoord_X,nNeighborCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize,std::forward<TRNG>(oRNG));
+    }
+
+    /// returns a random neighbor position for the specified pixel position using the global (C) random number generator; also guards against out-of-bounds values via image/border size check.
+    inline void getRandNeighborPosition_3x3(int& nNeighborCoord_X,int& nNeighborCoord_Y,const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize) {
+        getRandNeighborPosition_3x3(nNeighborCoord_X,nNeighborCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize,[](){return rand();});
     }
 
     /// returns a random neighbor position for the specified pixel position; also guards against out-of-bounds values via image/border size check.
-    inline void getRandNeighborPosition_5x5(int& nNeighborCoord_X,int& nNeighborCoord_Y,const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize) {
+    template<typename TRNG>
+    inline void getRandNeighborPosition_5x5(int& nNeighborCoord_X,int& nNeighborCoord_Y,const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize,TRNG&& oRNG) {
         typedef std::array<int,2> Nb;
         static const std::array<std::array<int,2>,24> s_anNeighborPattern ={
                 Nb{-2, 2},Nb{-1, 2},Nb{0, 2},Nb{1, 2},Nb{2, 2},
@@ -121,9 +196,109 @@ namespace cv { // extending cv
                 Nb{-2,-1},Nb{-1,-1},Nb{0,-1},Nb{1,-1},Nb{2,-1},
                 Nb{-2,-2},Nb{-1,-2},Nb{0,-2},Nb{1,-2},Nb{2,-2},
         };
-        getRandNeighborPosition<24>(s_anNeighborPattern,nNeighborCoord_X,nNeighborCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize);
+        getRandNeighborPosition<24>(s_anNeighborPattern,nNeighborCoord_X,nNeighborCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize,std::forward<TRNG>(oRNG));
+    }
+
+    /// returns a random neighbor position for the specified pixel position using the global (C) random number generator; also guards against out-of-bounds values via image/border size check.
+    inline void getRandNeighborPosition_5x5(int& nNeighborCoord_X,int& nNeighborCoord_Y,const int nOrigCoord_X,const int nOrigCoord_Y,const int nBorderSize,const cv::Size& oImageSize) {
+        getRandNeighborPosition_5x5(nNeighborCoord_X,nNeighborCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize,[](){return rand();});
     }
 
+    /// random sample/neighbor selection patterns supported by RandPxOffsetLUT (same distributions as the coordinate-based functions above)
+    enum RandPxPattern {
+        RandPxPattern_Sample3x3Std1, ///< see getRandSamplePosition_3x3_std1
+        RandPxPattern_Sample7x7Std2, ///< see getRandSamplePosition_7x7_std2
+        RandPxPattern_Neighbor3x3, ///< see getRandNeighborPosition_3x3
+        RandPxPattern_Neighbor5x5, ///< see getRandNeighborPosition_5x5
+    };
+
+    /// precomputed linear offset tables for random sample/neighbor selection, so that each draw costs one table lookup and one add; interior pixels
+    /// share a single table, and border pixels use pre-clamped ones (for a given RNG state, results are identical to the coordinate-based functions)
+    template<RandPxPattern ePattern>
+    struct RandPxOffsetLUT {
+        /// number of table entries per pixel class (i.e. the modulo applied to random draws)
+        static constexpr size_t s_nDrawCount = (ePattern==RandPxPattern_Sample3x3Std1)?256:(ePattern==RandPxPattern_Sample7x7Std2)?512:(ePattern==RandPxPattern_Neighbor3x3)?8:24;
+        /// max absolute coordinate offset of the pattern
+        static constexpr int s_nRadius = (ePattern==RandPxPattern_Sample7x7Std2)?3:(ePattern==RandPxPattern_Neighbor5x5)?2:1;
+        /// (re)builds the tables for the given image & border size (with the same clamping as clampImageCoords)
+        void initialize(const cv::Size& oImageSize, int nBorderSize) {
+            lvAssert_(oImageSize.area()>0 && nBorderSize>=0 && oImageSize.width>2*nBorderSize && oImageSize.height>2*nBorderSize,"bad image/border size");
+            // clamping is separable, so pixels are classified by the clamped offsets of their column & row (interior pixels all fall in one class)
+            const auto lClassify = [&](int nCoordCount, std::vector<int>& vnClassIdxs, std::vector<int>& vnClassCoords) {
+                std::map<std::vector<int>,int> mnClassIdxs;
+                vnClassIdxs.resize((size_t)nCoordCount);
+                vnClassCoords.clear();
+                for(int nCoord=0; nCoord<nCoordCount; ++nCoord) {
+                    std::vector<int> vnClampedOffsets;
+                    for(int nOffset=-s_nRadius; nOffset<=s_nRadius; ++nOffset)
+                        vnClampedOffsets.push_back(std::min(std::max(nCoord+nOffset,nBorderSize),nCoordCount-nBorderSize-1)-nCoord);
+                    auto pClassIter = mnClassIdxs.find(vnClampedOffsets);
+                    if(pClassIter==mnClassIdxs.end()) {
+                        pClassIter = mnClassIdxs.insert(std::make_pair(vnClampedOffsets,(int)vnClassCoords.size())).first;
+                        vnClassCoords.push_back(nCoord);
+                    }
+                    vnClassIdxs[nCoord] = pClassIter->second;
+                }
+            };
+            std::vector<int> vnColClassIdxs,vnColClassCoords,vnRowClassIdxs,vnRowClassCoords;
+            lClassify(oImageSize.width,vnColClassIdxs,vnColClassCoords);
+            lClassify(oImageSize.height,vnRowClassIdxs,vnRowClassCoords);
+            const size_t nColClasses = vnColClassCoords.size(), nRowClasses = vnRowClassCoords.size();
+            m_vnOffsets.resize(nColClasses*nRowClasses*s_nDrawCount);
+            for(size_t nRowClassIdx=0; nRowClassIdx<nRowClasses; ++nRowClassIdx) {
+                for(size_t nColClassIdx=0; nColClassIdx<nColClasses; ++nColClassIdx) {
+                    const int nOrigCoord_X = vnColClassCoords[nColClassIdx], nOrigCoord_Y = vnRowClassCoords[nRowClassIdx];
+                    int* anClassOffsets = m_vnOffsets.data()+(nRowClassIdx*nColClasses+nColClassIdx)*s_nDrawCount;
+                    for(size_t nDrawIdx=0; nDrawIdx<s_nDrawCount; ++nDrawIdx) {
+                        // tables are filled by replaying every possible draw through the reference implementation
+                        const auto lDraw = [nDrawIdx](){return nDrawIdx;};
+                        int nCoord_X, nCoord_Y;
+                        if(ePattern==RandPxPattern_Sample3x3Std1)
+                            getRandSamplePosition_3x3_std1(nCoord_X,nCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize,lDraw);
+                        else if(ePattern==RandPxPattern_Sample7x7Std2)
+                            getRandSamplePosition_7x7_std2(nCoord_X,nCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize,lDraw);
+                        else if(ePattern==RandPxPattern_Neighbor3x3)
+                            getRandNeighborPosition_3x3(nCoord_X,nCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize,lDraw);
+                        else
+                            getRandNeighborPosition_5x5(nCoord_X,nCoord_Y,nOrigCoord_X,nOrigCoord_Y,nBorderSize,oImageSize,lDraw);
+                        anClassOffsets[nDrawIdx] = (nCoord_Y-nOrigCoord_Y)*oImageSize.width+(nCoord_X-nOrigCoord_X);
+                    }
+                }
+            }
+            m_vnTableBases.resize((size_t)oImageSize.area());
+            for(int nRowIdx=0; nRowIdx<oImageSize.height; ++nRowIdx)
+                for(int nColIdx=0; nColIdx<oImageSize.width; ++nColIdx)
+                    m_vnTableBases[(size_t)nRowIdx*oImageSize.width+nColIdx] = uint32_t((vnRowClassIdxs[nRowIdx]*nColClasses+vnColClassIdxs[nColIdx])*s_nDrawCount);
+            m_oImageSize = oImageSize;
+        }
+        /// returns whether the tables have been built or not
+        inline bool empty() const {return m_vnTableBases.empty();}
+        /// returns the image size the tables were built for
+        inline const cv::Size& size() const {return m_oImageSize;}
+        /// returns a random sample/neighbor linear pixel index for the given linear pixel index, using the given random number generator functor
+        template<typename TRNG>
+        inline size_t getRandIdx(size_t nPxIdx, TRNG&& oRNG) const {
+            lvDbgAssert(nPxIdx<m_vnTableBases.size());
+            return size_t(ptrdiff_t(nPxIdx)+m_vnOffsets[m_vnTableBases[nPxIdx]+size_t(oRNG())%s_nDrawCount]);
+        }
+    private:
+        /// per-class linear offsets, indexed by table base + draw
+        std::vector<int> m_vnOffsets;
+        /// per-pixel table base (i.e. class index times draw count)
+        std::vector<uint32_t> m_vnTableBases;
+        /// image size the tables were built for
+        cv::Size m_oImageSize;
+    };
+
+    /// random init/sampling position LUT (see getRandSamplePosition_3x3_std1)
+    using RandSampleLUT_3x3_std1 = RandPxOffsetLUT<RandPxPattern_Sample3x3Std1>;
+    /// random init/sampling position LUT (see getRandSamplePosition_7x7_std2)
+    using RandSampleLUT_7x7_std2 = RandPxOffsetLUT<RandPxPattern_Sample7x7Std2>;
+    /// random neighbor position LUT (see getRandNeighborPosition_3x3)
+    using RandNeighborLUT_3x3 = RandPxOffsetLUT<RandPxPattern_Neighbor3x3>;
+    /// random neighbor position LUT (see getRandNeighborPosition_5x5)
+    using RandNeighborLUT_5x5 = RandPxOffsetLUT<RandPxPattern_Neighbor5x5>;
+
     /// writes a given text string on an image using the original cv::putText (this function only acts as a simplification wrapper)
     inline void putText(cv::Mat& oImg, const std::string& sText, const cv::Scalar& vColor, bool bBottom=false, const cv::Point2i& oOffset=cv::Point2i(4,15), int nThickness=2, double dScale=1.2) {
         cv::putText(oImg,sText,cv::Point(oOffset.x,bBottom?(oImg.rows-oOffset.y):oOffset.y),cv::FONT_HERSHEY_PLAIN,dScale,vColor,nThickness,cv::LINE_AA);
@@ -142,23 +317,30 @@ namespace cv { // extending cv
         voKPs = voNewKPs;
     }
 
+    /// writes the header and raw data of a (2D) matrix to a binary stream
+    void writeBinary(std::ostream& oStream, const cv::Mat& oMat);
+    /// reads a matrix written via writeBinary from a binary stream (the output matrix is reallocated only if needed)
+    void readBinary(std::istream& oStream, cv::Mat& oMat);
+
     /// helper struct for image display & callback management (must be created via DisplayHelper::create due to enable_shared_from_this interface)
     struct DisplayHelper : public lv::enable_shared_from_this<DisplayHelper> {
 
-        /// by default, comes with a filestorage algorithms can use for debug
+        /// by default, comes with a filestorage algorithms can use for debug; async helpers render from their own UI thread at a capped rate
         static DisplayHelperPtr create(const std::string& sDisplayName,
                                        const std::string& sDebugFSDirPath="./",
                                        const cv::Size& oMaxSize=cv::Size(1920,1080),
-                                       int nWindowFlags=cv::WINDOW_AUTOSIZE);
-        /// will reformat the given image, print the index and mouse cursor point on it, and show it
+                                       int nWindowFlags=cv::WINDOW_AUTOSIZE,
+                                       bool bAsync=true,
+                                       double dMaxRefreshRate=30.0);
+        /// will reformat the given image, print the index and mouse cursor point on it, and show it (async: only snapshots it, latest frame wins)
         void display(const cv::Mat& oImage, size_t nIdx);
-        /// will reformat the given images, print the index and mouse cursor point on them, and show them horizontally concatenated
+        /// will reformat the given images, print the index and mouse cursor point on them, and show them horizontally concatenated (async: only snapshots them, latest frame wins)
         void display(const cv::Mat& oInputImg, const cv::Mat& oDebugImg, const cv::Mat& oOutputImg, size_t nIdx);
         // @@@ add matvector-based display function for extra flexibility?
 
-        /// will call cv::waitKey and block if m_bContinuousUpdates is false, and loop otherwise (also returns cv::waitKey's captured value)
+        /// will call cv::waitKey and block if m_bContinuousUpdates is false, and loop otherwise (also returns cv::waitKey's captured value; async: returns the last key caught by the UI thread)
         int waitKey(int nDefaultSleepDelay=1);
-        /// desctructor automatically closes its window
+        /// desctructor automatically closes its window (and joins the UI thread, if any)
         ~DisplayHelper();
 
         const std::string m_sDisplayName;
@@ -176,13 +358,33 @@ namespace cv { // extending cv
         DisplayHelper(const std::string& sDisplayName,
                       const std::string& sDebugFSDirPath,
                       const cv::Size& oMaxSize,
-                      int nWindowFlags);
+                      int nWindowFlags,
+                      bool bAsync,
+                      double dMaxRefreshRate);
+        /// reformats the given image for display (on the rendering thread)
+        cv::Mat render(const cv::Mat& oImage, size_t nIdx);
+        /// reformats & concatenates the given images for display (on the rendering thread)
+        cv::Mat render(const cv::Mat& oInputImg, const cv::Mat& oDebugImg, const cv::Mat& oOutputImg, size_t nIdx);
+        /// UI thread entrypoint (owns the window, renders the latest snapshot & pumps events at the capped rate)
+        void uiEntry();
+        const int m_nWindowFlags;
+        const bool m_bAsync;
+        const int m_nRefreshPeriod_ms;
         cv::Size m_oLastDisplaySize;
         bool m_bContinuousUpdates;
         bool m_bFirstDisplay;
         std::function<void(int,int,int,int)> m_oMouseEventCallback;
         void onMouseEventCallback(int nEvent, int x, int y, int nFlags);
         static void onMouseEvent(int nEvent, int x, int y, int nFlags, void* pData);
+        std::mutex m_oSnapshotMutex;
+        std::condition_variable m_oKeyCondVar;
+        std::array<cv::Mat,3> m_aoSnapshotImgs; ///< latest snapshot handed by display(), guarded by m_oSnapshotMutex
+        size_t m_nSnapshotImgCount,m_nSnapshotIdx;
+        bool m_bSnapshotPending;
+        int m_nLastKeyPressed; ///< last key caught by the UI thread (-1 if none), guarded by m_oSnapshotMutex
+        std::chrono::steady_clock::time_point m_nLastSnapshotTime;
+        std::atomic<bool> m_bUIThreadActive;
+        std::thread m_hUIThread;
     };
 
     /// always-empty-mat, which allows functions to return const-references to an empty mat without dangling ref issues
@@ -195,3 +397,121 @@ namespace cv { // extending cv
     inline const cv::Size& emptySize() {return g_oEmptySize;}
 
 } // namespace cv
+
+namespace lv {
+
+    /// max number of moving average maps updated at once by 'updateRollingAverages'
+    constexpr size_t s_nMaxRollingAverageMaps = 4;
+
+    /// updates several moving average maps from one input in a single (vectorized) pass, i.e. M_i = M_i*(1-a_i) + X*s_i*a_i, where
+    /// 'a' are the per-map factors, and 's' the optional per-map input scales (default = 1); maps must be CV_32F or fixed-point CV_16U,
+    /// and share the input's size & channel count (input is CV_8U, CV_16U or CV_32F); if a CV_8UC1 mask is given, only its non-zero pixels are updated
+    void updateRollingAverages(std::initializer_list<cv::Mat*> lpMaps, std::initializer_list<float> lfFactors, const cv::Mat& oInput,
+                               const cv::Mat& oMask=cv::Mat(), std::initializer_list<float> lfInputScales={});
+
+    /// median-blurs a binary CV_8UC1 mask (values >=128 are positive) with an odd nKernelSize, using replicated borders like cv::medianBlur;
+    /// the output (0 or 255) is a box count of positives against (k*k)/2, obtained via running column & row sums in O(1) per pixel for any kernel size
+    void binaryMedianBlur(const cv::Mat& oInput, cv::Mat& oOutput, int nKernelSize);
+
+    /// bit-packed binary mask (1 bit per pixel, LSB-first in raster order, without row padding), which needs 8x less memory than its CV_8UC1 equivalent;
+    /// the bit buffer holds 64-bit words (trailing bits are always cleared), and its bytes follow the '.lvbit' archiver layout on little-endian platforms
+    struct PackedBinaryMask {
+        /// default constructor (the mask is empty)
+        PackedBinaryMask() = default;
+        /// packs the given CV_8UC1 mask (see 'pack')
+        explicit PackedBinaryMask(const cv::Mat& oMask) {pack(oMask);}
+        /// (re)allocates the mask for the given size, with all bits cleared
+        void create(const cv::Size& oSize);
+        /// packs the given CV_8UC1 mask, where non-zero values become set bits (the bit buffer is only reallocated if the size changed)
+        void pack(const cv::Mat& oMask);
+        /// unpacks the mask to CV_8UC1, where set bits become nPositiveVal and others become zero
+        void unpack(cv::Mat& oMask, uchar nPositiveVal=UCHAR_MAX) const;
+        /// returns the number of set bits
+        size_t countNonZero() const;
+        /// returns the value of a single pixel
+        inline bool get(int nRowIdx, int nColIdx) const {
+            const size_t nPxIdx = size_t(nRowIdx)*m_oSize.width+size_t(nColIdx);
+            return (m_vnWords[nPxIdx/64]>>(nPxIdx%64))&1;
+        }
+        /// sets the value of a single pixel
+        inline void set(int nRowIdx, int nColIdx, bool bVal) {
+            const size_t nPxIdx = size_t(nRowIdx)*m_oSize.width+size_t(nColIdx);
+            m_vnWords[nPxIdx/64] = (m_vnWords[nPxIdx/64]&~(uint64_t(1)<<(nPxIdx%64)))|(uint64_t(bVal)<<(nPxIdx%64));
+        }
+        /// computes the bitwise AND with another mask of the same size, in-place
+        PackedBinaryMask& operator&=(const PackedBinaryMask& oMask);
+        /// computes the bitwise OR with another mask of the same size, in-place
+        PackedBinaryMask& operator|=(const PackedBinaryMask& oMask);
+        /// computes the bitwise XOR with another mask of the same size, in-place
+        PackedBinaryMask& operator^=(const PackedBinaryMask& oMask);
+        /// returns the mask size (in pixels)
+        inline const cv::Size& size() const {return m_oSize;}
+        /// returns whether the mask was allocated or not
+        inline bool empty() const {return m_vnWords.empty();}
+        /// returns the number of 64-bit words in the bit buffer
+        inline size_t getWordCount() const {return m_vnWords.size();}
+        /// returns the number of bytes in the bit buffer which actually hold pixels
+        inline size_t getByteCount() const {return (size_t(m_oSize.area())+7)/8;}
+        /// returns a pointer to the bit buffer
+        inline const uint64_t* words() const {return m_vnWords.data();}
+        /// returns a pointer to the bit buffer
+        inline uint64_t* words() {return m_vnWords.data();}
+    private:
+        /// mask size (in pixels)
+        cv::Size m_oSize;
+        /// bit buffer, with (area+63)/64 words
+        std::vector<uint64_t> m_vnWords;
+    };
+
+    /// bit-packed binary mask with word-aligned rows (1 bit per pixel, LSB-first, each row padded to whole 64-bit words with cleared bits), used by
+    /// row-parallel binary morphology kernels where shifting a row by one pixel is a handful of 64-bit shifts
+    struct PackedBinaryRows {
+        /// default constructor (the mask is empty)
+        PackedBinaryRows() = default;
+        /// packs the given CV_8UC1 mask (see 'pack')
+        explicit PackedBinaryRows(const cv::Mat& oMask) {pack(oMask);}
+        /// (re)allocates the mask for the given size, with all bits cleared
+        void create(const cv::Size& oSize);
+        /// packs the given CV_8UC1 mask (which may be non-continuous), where non-zero values become set bits (the bit buffer is only reallocated if the size changed)
+        void pack(const cv::Mat& oMask);
+        /// unpacks the mask to CV_8UC1, where set bits become nPositiveVal and others become zero (pre-allocated views of the right size are written in-place)
+        void unpack(cv::Mat& oMask, uchar nPositiveVal=UCHAR_MAX) const;
+        /// returns the number of set bits
+        size_t countNonZero() const;
+        /// returns the value of a single pixel
+        inline bool get(int nRowIdx, int nColIdx) const {return (row(nRowIdx)[nColIdx/64]>>(nColIdx%64))&1;}
+        /// returns a pointer to the words of the given row
+        inline const uint64_t* row(int nRowIdx) const {return m_vnWords.data()+size_t(nRowIdx)*m_nRowWords;}
+        /// returns a pointer to the words of the given row
+        inline uint64_t* row(int nRowIdx) {return m_vnWords.data()+size_t(nRowIdx)*m_nRowWords;}
+        /// returns the mask size (in pixels)
+        inline const cv::Size& size() const {return m_oSize;}
+        /// returns whether the mask was allocated or not
+        inline bool empty() const {return m_vnWords.empty();}
+        /// returns the number of 64-bit words per row
+        inline size_t getRowWordCount() const {return m_nRowWords;}
+        /// returns the mask of valid (non-padding) bits in the last word of each row
+        inline uint64_t getLastWordMask() const {return (m_oSize.width%64)?((uint64_t(1)<<(m_oSize.width%64))-1):~uint64_t(0);}
+    private:
+        /// mask size (in pixels)
+        cv::Size m_oSize;
+        /// number of 64-bit words per row
+        size_t m_nRowWords = 0;
+        /// bit buffer, with m_nRowWords*height words
+        std::vector<uint64_t> m_vnWords;
+    };
+
+    /// erodes a bit-packed mask nIters times with a 3x3 square kernel (out-of-bounds pixels are considered set, as in cv::erode with default args); in-place calls are allowed
+    void binaryErode(const PackedBinaryRows& oInput, PackedBinaryRows& oOutput, int nIters=1);
+    /// dilates a bit-packed mask nIters times with a 3x3 square kernel (out-of-bounds pixels are considered cleared, as in cv::dilate with default args); in-place calls are allowed
+    void binaryDilate(const PackedBinaryRows& oInput, PackedBinaryRows& oOutput, int nIters=1);
+    /// sets all cleared pixels 4-connected to oSeed (if it is cleared itself) in a bit-packed mask, filling whole row runs at once and sweeping rows until stable
+    void binaryFloodFill(PackedBinaryRows& oMask, const cv::Point& oSeed);
+    /// erodes a binary CV_8UC1 mask (non-zero values are positive) via 'binaryErode' on bit-packed rows; the output (0 or 255) matches cv::erode(oInput,oOutput,cv::Mat(),cv::Point(-1,-1),nIters) on 0/255 masks
+    void binaryErode(const cv::Mat& oInput, cv::Mat& oOutput, int nIters=1);
+    /// dilates a binary CV_8UC1 mask (non-zero values are positive) via 'binaryDilate' on bit-packed rows; the output (0 or 255) matches cv::dilate(oInput,oOutput,cv::Mat(),cv::Point(-1,-1),nIters) on 0/255 masks
+    void binaryDilate(const cv::Mat& oInput, cv::Mat& oOutput, int nIters=1);
+    /// flood-fills a binary CV_8UC1 mask in-place via 'binaryFloodFill' on bit-packed rows; the output (0 or 255) matches cv::floodFill(oMask,oSeed,UCHAR_MAX) on 0/255 masks
+    void binaryFloodFill(cv::Mat& oMask, const cv::Point& oSeed);
+
+} // namespace lv
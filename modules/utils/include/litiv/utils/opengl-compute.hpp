@@ -0,0 +1,104 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/utils/opengl-shaders.hpp"
+
+#define GLCOMPUTE_DEFAULT_SCAN_ROW_SIZE    512 // must be a power of two; image row scans are processed in blocks of this size
+#define GLCOMPUTE_DEFAULT_TRANSPOSE_BLOCK  32
+#define GLCOMPUTE_DEFAULT_WORKGROUP_SIZE   256 // must be a power of two; used by all 1D buffer primitives
+#define GLCOMPUTE_DEFAULT_WORKGROUP_SIZE_2D 16 // used (squared) by all 2D image primitives
+
+/// shader storage buffer object wrapper; contents are tightly packed (std430) 32-bit words for all compute primitives
+struct GLShaderStorageBuffer {
+    GLShaderStorageBuffer(size_t nByteSize, const GLvoid* pInitData=nullptr, GLenum eBufferUsage=GL_DYNAMIC_COPY);
+    ~GLShaderStorageBuffer();
+    inline GLuint getSSBOId() const {return m_nSSBO;}
+    inline size_t size() const {return m_nByteSize;}
+    /// binds the whole buffer to the given indexed shader storage binding point
+    void bind(GLuint nBinding) const;
+    /// uploads nByteSize bytes at nByteOffset (the range must lie inside the buffer)
+    bool updateBuffer(const GLvoid* pData, size_t nByteSize, size_t nByteOffset=0);
+    /// downloads nByteSize bytes from nByteOffset (blocks until all previous GPU writes are done)
+    bool fetchBuffer(GLvoid* pData, size_t nByteSize, size_t nByteOffset=0) const;
+    /// fills the whole buffer with a 32-bit word
+    void fill(GLuint nVal);
+    const GLenum m_eBufferUsage;
+private:
+    GLShaderStorageBuffer& operator=(const GLShaderStorageBuffer&) = delete;
+    GLShaderStorageBuffer(const GLShaderStorageBuffer&) = delete;
+    GLuint m_nSSBO;
+    const size_t m_nByteSize;
+};
+
+/// reusable GPU scan/reduce/histogram/compaction primitives; compiled programs are cached per instance (which must stay tied to a single GL context)
+class GLComputePrimitives {
+public:
+    enum ReductionOpList {
+        ReductionOp_Sum,
+        ReductionOp_Min,
+        ReductionOp_Max,
+        nReductionOpsCount,
+    };
+    enum BufferBindingList {
+        Buffer_InputBinding,
+        Buffer_OutputBinding,
+        Buffer_AuxBinding,
+        Buffer_ResultBinding,
+        nBufferBindingsCount,
+    };
+    GLComputePrimitives(size_t nScanRowSize=GLCOMPUTE_DEFAULT_SCAN_ROW_SIZE, size_t nWorkGroupSize=GLCOMPUTE_DEFAULT_WORKGROUP_SIZE);
+
+    /// exclusive row-wise prefix sum of all channels of an integral image (optionally counting non-zero pixels only); in-place allowed
+    void scanRows(GLTexture2D& oInput, GLTexture2D& oOutput, bool bBinaryProc=false);
+    /// transposes an image into another one (of transposed size & same format)
+    void transpose(GLTexture2D& oInput, GLTexture2D& oOutput);
+    /// exclusive prefix sum of the first nCount uints of the input buffer; in-place allowed
+    void scan(const GLShaderStorageBuffer& oInput, GLShaderStorageBuffer& oOutput, size_t nCount);
+    /// reduces the first nCount uints of the input buffer (sums wrap around on overflow)
+    GLuint reduce(const GLShaderStorageBuffer& oInput, size_t nCount, ReductionOpList eOp);
+    /// reduces the first channel of an integral image (sums wrap around on overflow)
+    GLuint reduce(GLTexture2D& oInput, ReductionOpList eOp);
+    /// counts the values of the first channel of an integral image in nBins bins (values above the last bin are clamped to it)
+    void histogram(GLTexture2D& oInput, GLShaderStorageBuffer& oBins, size_t nBins, bool bAccumulate=false);
+    /// writes the indices of all non-zero input uints in order, and returns their count
+    size_t compact(const GLShaderStorageBuffer& oInput, size_t nCount, GLShaderStorageBuffer& oOutput);
+    /// writes the packed coords (x|y<<16) of all pixels with a non-zero first channel in no particular order, and returns their count (elements past the output capacity are dropped)
+    size_t compact(GLTexture2D& oInput, GLShaderStorageBuffer& oOutput);
+
+    /// returns the number of programs compiled so far by this instance
+    inline size_t getCachedProgramCount() const {return m_mPrograms.size();}
+    const size_t m_nScanRowSize;
+    const size_t m_nWorkGroupSize;
+
+private:
+    /// returns the linked program for the given compute shader source, compiling it on first use
+    GLShader& getProgram(const std::string& sSource);
+    /// activates the program, dispatches it, and sets up barriers for all later buffer/image accesses
+    void dispatch(GLShader& oProgram, const glm::uvec3& vDispatchSize);
+    /// recursive buffer scan step over a given block-sum level (flag inputs are scanned as 0/1 values)
+    void scan(const GLShaderStorageBuffer& oInput, GLShaderStorageBuffer& oOutput, size_t nCount, size_t nLevel, bool bFlagInput);
+    /// returns a scratch buffer of at least nByteSize bytes from the given pool slot
+    GLShaderStorageBuffer& getScratchBuffer(std::vector<std::unique_ptr<GLShaderStorageBuffer>>& vpPool, size_t nIdx, size_t nByteSize);
+    GLComputePrimitives& operator=(const GLComputePrimitives&) = delete;
+    GLComputePrimitives(const GLComputePrimitives&) = delete;
+    std::map<std::string,std::unique_ptr<GLShader>> m_mPrograms;
+    std::vector<std::unique_ptr<GLShaderStorageBuffer>> m_vpScanBlockSums;
+    std::vector<std::unique_ptr<GLShaderStorageBuffer>> m_vpScratchBuffers;
+    GLShaderStorageBuffer m_oResultBuffer;
+};
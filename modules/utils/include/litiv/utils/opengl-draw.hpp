@@ -18,6 +18,9 @@
 #pragma once
 
 #include "litiv/utils/opengl.hpp"
+#if HAVE_CUDA
+#include <cuda_gl_interop.h>
+#endif //HAVE_CUDA
 
 #define GLScreenBillboard_FLIP_TEX_Y_COORDS 1
 
@@ -56,22 +59,39 @@ private:
 };
 
 struct GLPixelBufferObject {
-    GLPixelBufferObject(const cv::Mat& oInitBufferData, GLenum eBufferTarget, GLenum eBufferUsage);
+    /// if nPersistentSlots>0 and ARB_buffer_storage is available, the pbo is allocated as a persistently mapped coherent ring of N frame slots (otherwise, regular map/unmap is used)
+    GLPixelBufferObject(const cv::Mat& oInitBufferData, GLenum eBufferTarget, GLenum eBufferUsage, size_t nPersistentSlots=0);
     ~GLPixelBufferObject();
     inline GLuint getPBOId() const {return m_nPBO;}
     inline int type() const {return m_nFrameType;}
     inline cv::Size size() const {return m_oFrameSize;}
     bool updateBuffer(const cv::Mat& oBufferData, bool bRealloc=false, bool bRebindAll=false);
     bool fetchBuffer(cv::Mat& oBufferData, bool bRebindAll=false);
+    /// returns whether the pbo storage is persistently mapped (i.e. whether the slot ring is in use)
+    inline bool isPersistent() const {return m_pMappedData!=nullptr;}
+    /// returns the number of frame slots in the ring (always 1 for regular pbos)
+    inline size_t getSlotCount() const {return std::max(m_vpSlotFences.size(),size_t(1));}
+    /// returns the byte offset of the current slot in the buffer, to be used as the pixel data 'pointer' of pbo transfers (always 0 for regular pbos)
+    inline size_t getCurrSlotOffset() const {return m_nCurrSlot*m_nSlotStride;}
+    /// moves to the next slot in the ring, waits for the gpu to release it, and returns a header over its mapped memory so producers can write into it directly (returns an empty mat for regular pbos)
+    cv::Mat acquireNextSlot();
+    /// inserts a fence after the gpu commands that read from (or write to) the current slot (no-op for regular pbos)
+    void fenceCurrSlot();
     const GLenum m_eBufferTarget;
     const GLenum m_eBufferUsage;
 private:
     GLPixelBufferObject& operator=(const GLPixelBufferObject&) = delete;
     GLPixelBufferObject(const GLPixelBufferObject&) = delete;
+    void waitSlotFence(size_t nSlot);
     GLuint m_nPBO;
     const int m_nBufferSize;
     const int m_nFrameType;
     const cv::Size m_oFrameSize;
+    const size_t m_nSlotStride;
+    uchar* m_pMappedData;
+    std::vector<GLsync> m_vpSlotFences;
+    size_t m_nCurrSlot;
+    bool m_bCurrSlotAcquired;
 };
 
 struct GLTexture {
@@ -152,6 +172,20 @@ private:
     cv::Mat m_oTextureArrayFetchBuffer;
 };
 
+#if HAVE_CUDA
+
+/// single-level 2D texture registered with CUDA, updated directly from device memory (e.g. from a hardware video decoder; 1/2/4-channel types only)
+struct GLCUDAInteropTexture2D : GLTexture2D {
+    GLCUDAInteropTexture2D(const cv::Size& oSize, int nType, bool bUseIntegralFormat);
+    virtual ~GLCUDAInteropTexture2D();
+    /// copies a pitched device buffer of the texture's size & type to the texture (device-to-device, async on nStream)
+    void updateTexture(const void* pDevData, size_t nDevPitch, cudaStream_t nStream=0);
+private:
+    cudaGraphicsResource_t m_pResource;
+};
+
+#endif //HAVE_CUDA
+
 struct GLScreenBillboard : GLVertexArrayObject {
     GLScreenBillboard();
     virtual ~GLScreenBillboard();
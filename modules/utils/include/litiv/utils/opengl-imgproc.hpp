@@ -25,7 +25,14 @@
 #define GLUTILS_IMGPROC_USE_TEXTURE_ARRAYS          0
 #define GLUTILS_IMGPROC_USE_DOUBLE_PBO_INPUT        0
 #define GLUTILS_IMGPROC_USE_DOUBLE_PBO_OUTPUT       1
+#define GLUTILS_IMGPROC_USE_PACKED_3CH_INPUT        1
+#define GLUTILS_IMGPROC_PERSISTENT_PBO_SLOTS        2 // 0 = regular map/unmap pbos
 #define GLUTILS_IMGPROC_USE_PBO_UPDATE_REALLOC      1 // @@@@@ unused?
+#define GLUTILS_IMGPROC_TIMER_QUERY_LATENCY         3
+#define GLUTILS_IMGPROC_TIMER_AVG_FACTOR            0.05
+#define GLUTILS_IMGPROC_PRINT_TIMERS                0
+#define GLUTILS_IMGPROC_AUTOTUNE_FRAMES_PER_CONFIG  8
+#define GLUTILS_IMGPROC_DEFAULT_AUTOTUNE_CACHE_PATH "litiv_glimgproc_autotune.txt"
 
 // @@@@ switch all 'frames' for 'images'?
 // @@@@ rewrite all classes as part of lv::gl namespace?
@@ -42,8 +49,17 @@ public:
 
     inline bool setOutputFetching(bool b) {return (m_bFetchingOutput=(b&&m_bUsingOutput));}
     inline bool setDebugFetching(bool b) {return (m_bFetchingDebug=(b&&m_bUsingDebug));}
+    /// toggles fenced async readback: 'fetchLast*' then return the result queued by the previous 'apply_gl' call instead of stalling on the current one (adds one frame of latency)
+    inline bool setAsyncFetching(bool b) {return (m_bAsyncFetching=(b&&(m_bUsingOutputPBOs||m_bUsingDebugPBOs)));}
+    inline bool getIsAsyncFetching() const {return m_bAsyncFetching;}
     inline bool getIsUsingDisplay() const {return m_bUsingDisplay;}
     inline bool getIsGLInitialized() const {return m_bGLInitialized;}
+    /// returns whether 8-bit 3-channel inputs are uploaded as raw packed bytes & expanded to rgba on the gpu (only known after initialization)
+    inline bool getIsUsingPackedInput() const {return m_bUsingPackedInput;}
+    /// toggles work group size & shader variant autotuning (must be set before initialization; winners are cached on disk per gpu, algo type & frame size)
+    void setAutotuning(bool bEnabled, const std::string& sCacheFilePath=GLUTILS_IMGPROC_DEFAULT_AUTOTUNE_CACHE_PATH);
+    /// returns whether the autotuning benchmark is still running (i.e. whether the first frames are still being used to time candidate configs)
+    inline bool getIsAutotuning() const {return m_bAutotuning;}
     inline GLuint getACBOId(size_t n) const {lvAssert(n<m_nACBOs); return m_vnACBO[n];}
     inline GLuint getSSBOId(size_t n) const {lvAssert(n<m_nSSBOs); return m_vnSSBO[n];}
     inline size_t getTextureBinding(size_t nLayer, size_t eTexID) const {return (m_bUsingTexArrays?0:nLayer)*m_nTextures+eTexID;}
@@ -67,7 +83,8 @@ public:
     const bool m_bUsingTexArrays;
     const bool m_bUsingTimers;
     const bool m_bUsingIntegralFormat;
-    const glm::uvec2 m_vDefaultWorkGroupSize; // make dynamic? @@@@@
+    /// work group size used by all compute shaders (may only change via autotuning, in which case shaders are rebuilt & dispatch sizes must be recomputed)
+    glm::uvec2 m_vDefaultWorkGroupSize;
 
     enum ImageDefaultLayoutList {
         Image_OutputBinding,
@@ -89,6 +106,7 @@ public:
     };
 
     enum StorageBufferDefaultBindingList {
+        StorageBuffer_PackedInputBinding,
         // reserved here
         nStorageBufferDefaultBindingsCount
     };
@@ -106,11 +124,23 @@ public:
         nGLTimersCount
     };
 
+    /// returns the gpu time (in ms) of the given timer on the latest read-back frame, or its rolling average if required (results lag by up to GLUTILS_IMGPROC_TIMER_QUERY_LATENCY frames)
+    double getGPUTime_ms(GLTimersList eTimer, bool bAverage=true) const;
+    /// returns the gpu time (in ms) of the given compute stage on the latest read-back frame, or its rolling average if required
+    double getGPUStageTime_ms(size_t nStage, bool bAverage=true) const;
+    /// returns the total gpu time (in ms) of all timed operations on the latest read-back frame, or its rolling average if required
+    double getGPUTotalTime_ms(bool bAverage=true) const;
+    /// returns the number of frames for which gpu timer results have been read back so far
+    inline size_t getGPUTimerSampleCount() const {return m_nGLTimerSampleCount;}
+
 protected:
     /// initialize internal texture arrays and shader programs; should be called in top-level algo init function
     virtual void initialize_gl(const cv::Mat& oInitInput, const cv::Mat& oROI);
     /// uploads the next input texture to GPU, processes the input texture currently on GPU, and fetches (if required) the last output texture
     virtual void apply_gl(const cv::Mat& oNextInput, bool bRebindAll=false);
+    /// same as 'apply_gl', but the next input is copied on the gpu from the given 2D texture (e.g. written by a hardware decoder via cuda/egl interop) instead of being uploaded from host memory
+    /// (the texture must match the input size, and use a format of the same size class as the input layers: R8* for 1-ch inputs, RGBA8* in rgba byte order for 3/4-ch inputs)
+    void apply_gl_device(GLuint nNextInputTex, bool bRebindAll=false);
 
     bool m_bUsingDisplay;
     bool m_bGLInitialized;
@@ -121,8 +151,14 @@ protected:
     cv::Mat m_oLastOutput, m_oLastDebug;
     size_t m_nNextLayer,m_nCurrLayer,m_nLastLayer;
     size_t m_nCurrPBO, m_nNextPBO;
-    std::array<GLuint,nGLTimersCount> m_nGLTimers;
-    std::array<GLuint64,nGLTimersCount> m_nGLTimerVals;
+    /// timer query ring with one query set per in-flight frame (texture update, display update, then one query per compute stage)
+    std::vector<GLuint> m_vnGLTimers;
+    /// in-flight timer query set flags (results pending readback, and display query issued)
+    std::array<bool,GLUTILS_IMGPROC_TIMER_QUERY_LATENCY> m_abGLTimersPending, m_abGLTimersDisplayed;
+    size_t m_nCurrGLTimerSet, m_nGLTimerSampleCount;
+    /// latest read-back timer values (in ns) and their rolling averages, using the same slot layout as a single query set
+    std::vector<GLuint64> m_vnGLTimerVals;
+    std::vector<double> m_vdGLTimerAvgVals;
     std::vector<std::unique_ptr<GLDynamicTexture2D>> m_vpInputArray;
     std::vector<std::unique_ptr<GLDynamicTexture2D>> m_vpDebugArray;
     std::vector<std::unique_ptr<GLDynamicTexture2D>> m_vpOutputArray;
@@ -133,6 +169,15 @@ protected:
     std::unique_ptr<GLPixelBufferObject> m_apInputPBOs[2];
     std::unique_ptr<GLPixelBufferObject> m_apDebugPBOs[2];
     std::unique_ptr<GLPixelBufferObject> m_apOutputPBOs[2];
+    /// async fetching mode toggle, and readback fences/internal frame indices for each output/debug pbo slot
+    bool m_bAsyncFetching;
+    std::array<GLsync,2> m_apReadbackFences;
+    std::array<size_t,2> m_anOutputPBOInternalIdx, m_anDebugPBOInternalIdx;
+    /// packed input mode toggle (set for 8-bit 3-channel inputs without input pbos), and the compute shader expanding the packed bytes into the rgba input layers
+    bool m_bUsingPackedInput;
+    std::unique_ptr<GLShader> m_pInputUnpackShader;
+    /// device-side texture the next input is copied from during an 'apply_gl_device' call (0 otherwise)
+    GLuint m_nNextInputTex;
     std::unique_ptr<GLTexture2D> m_pROITexture;
     std::unique_ptr<GLTexture2D> m_apCustomTextures[3];
     GLScreenBillboard m_oDisplayBillboard;
@@ -141,6 +186,22 @@ protected:
     const int m_nDebugType;
 
     virtual void dispatch(size_t nStage, GLShader& oShader);
+    /// returns the number of shader variants (e.g. with/without shared mem preloading) that 'getComputeShaderSource' can generate based on 'm_nShaderVariant'
+    virtual size_t getShaderVariantCount() const {return 1;}
+    /// (re)builds all compute stage shaders with the current work group size & shader variant; returns false if any of them fails to link
+    bool buildImgProcShaders();
+    /// shader variant index used by 'getComputeShaderSource' (in [0,getShaderVariantCount()), 0 = default)
+    size_t m_nShaderVariant;
+    /// uploads the given 3-channel input as raw packed bytes & expands it into the given input layer on the gpu (only used in packed input mode)
+    void unpackInput(const cv::Mat& oInput, size_t nLayer);
+    /// copies the given device-side texture into the given input layer on the gpu (only used via 'apply_gl_device')
+    void copyInputTexture(GLuint nSrcTex, size_t nLayer);
+    /// inserts a fence after the pbo readbacks queued for the given slot (only used in async fetching mode)
+    void insertReadbackFence(size_t nPBO);
+    /// blocks until the readbacks queued for the given slot are complete (no-op if no fence was inserted)
+    void waitReadbackFence(size_t nPBO) const;
+    /// reads back the given timer query set & updates the timer averages; returns false if 'bWait' is not set and results are not available yet
+    bool fetchGLTimers(size_t nSet, bool bWait);
     static const char* getCurrTextureLayerUniformName();
     static const char* getLastTextureLayerUniformName();
     static const char* getFrameIndexUniformName();
@@ -149,9 +210,25 @@ private:
     GLImageProcAlgo& operator=(const GLImageProcAlgo&) = delete;
     GLImageProcAlgo(const GLImageProcAlgo&) = delete;
     friend class GLImageProcEvaluatorAlgo;
+    friend class GLImageProcPipeline;
+    /// if set, the output image of this algo is bound as input at each 'apply_gl' call instead of uploading a host-side input (see GLImageProcPipeline)
+    std::shared_ptr<GLImageProcAlgo> m_pLinkedInput;
     std::vector<GLuint> m_vnSSBO;
     std::vector<GLuint> m_vnACBO;
     int m_nInputType;
+    /// starts autotuning (or applies its cached result); called by 'initialize_gl' before shaders are built
+    void initAutotuning();
+    /// accumulates the compute time of the last frame for the current candidate, and moves to the next one (or to the winner) once enough frames are timed
+    void updateAutotuning();
+    /// returns the key identifying the current gpu, algo type & frame size in the autotuning cache
+    std::string getAutotuningCacheKey() const;
+    /// autotuning toggle & state (requested, in progress), cache path and candidate configs with their accumulated compute times (in ns)
+    bool m_bUsingAutotuning, m_bAutotuning;
+    std::string m_sAutotuningCacheFilePath;
+    std::vector<std::pair<glm::uvec2,size_t>> m_vAutotuningConfigs;
+    std::vector<GLuint64> m_vnAutotuningTimes;
+    size_t m_nAutotuningConfigIdx, m_nAutotuningFrameCount;
+    GLuint m_nAutotuningQuery;
 };
 
 class GLImageProcEvaluatorAlgo : public GLImageProcAlgo {
@@ -185,6 +262,27 @@ private:
     cv::Mat m_oEvalQueryBuffer;
 };
 
+/// chains image processing algos on the GPU: each appended stage directly reads the latest output image of the previous one (no host round-trip)
+class GLImageProcPipeline {
+public:
+    /// the head algo keeps its own interface for initialization & input upload (e.g. background subtractors)
+    explicit GLImageProcPipeline(const std::shared_ptr<GLImageProcAlgo>& pHead);
+    /// appends a stage which will read the output of the current last stage as its input (the stage must use an input of the matching type)
+    void addStage(const std::shared_ptr<GLImageProcAlgo>& pStage);
+    /// initializes all appended stages (the head must already be initialized); only the last stage keeps cpu-side output fetching
+    void initialize_gl(const cv::Mat& oROI);
+    /// processes the latest output of the head through all appended stages; should be called right after the head's own 'apply_gl'
+    void apply_gl();
+    /// returns the head algo of the pipeline
+    inline const std::shared_ptr<GLImageProcAlgo>& getHead() const {return m_vpStages.front();}
+    /// returns the last stage of the pipeline (e.g. to be used as parent of a GLImageProcEvaluatorAlgo)
+    inline const std::shared_ptr<GLImageProcAlgo>& getLastStage() const {return m_vpStages.back();}
+    /// fetches the last output of the final stage (same semantics as 'GLImageProcAlgo::fetchLastOutput')
+    size_t fetchLastOutput(cv::Mat& oOutput) const;
+private:
+    std::vector<std::shared_ptr<GLImageProcAlgo>> m_vpStages;
+};
+
 class GLImagePassThroughAlgo : public GLImageProcAlgo {
 public:
     GLImagePassThroughAlgo(int nFrameType, bool bUseDisplay, bool bUseTimers, bool bUseIntegralFormat);
@@ -48,6 +48,11 @@ public:
     std::string getUniformNameFromLoc(GLint nLoc);
     GLint getUniformLocFromName(const std::string& sName);
 
+    /// toggles the program binary cache used by link() (enabled by default; programs are always shared in-process when enabled)
+    static void setProgramCacheEnabled(bool bEnabled);
+    /// sets the directory where linked program binaries are persisted across runs (empty = in-process cache only, default)
+    static void setProgramCacheDirPath(const std::string& sDirPath);
+
     bool isCompiled()  {return m_bIsCompiled;}
     bool isLinked()    {return m_bIsLinked;}
     bool isActive()    {return m_bIsActive;}
@@ -68,18 +73,27 @@ public:
     static std::string getFragmentShaderSource_PassThrough_SxSImgLoad(bool bUseTopLeftFragCoordOrigin, GLenum eInternalFormat, const std::vector<GLuint> vnImageBindings, GLint nImageLayer, bool bUseIntegralFormat); // @@@ to be tested
     static std::string getFragmentShaderSource_PassThrough_SxSImgArrayLoad(bool bUseTopLeftFragCoordOrigin, GLenum eInternalFormat, GLuint nImageBinding, GLint nImageCount, bool bUseIntegralFormat);
     static std::string getComputeShaderSource_PassThrough_ImgLoadCopy(const glm::uvec2& vWorkGroupSize, GLenum eInternalFormat, GLuint nInputImageBinding, GLuint nOutputImageBinding, bool bUseIntegralFormat);
+    /// returns the source of a compute shader which expands packed 8-bit BGR bytes (read as uints from a storage buffer) into an rgba8(ui) image, as a GL_BGR texture upload would
+    static std::string getComputeShaderSource_UnpackBGR8(const glm::uvec2& vWorkGroupSize, const cv::Size& oFrameSize, GLuint nInputStorageBufferBinding, GLuint nOutputImageBinding, bool bUseIntegralFormat);
     static std::string getComputeShaderSource_ParallelPrefixSum(size_t nMaxRowSize, bool bBinaryProc, GLenum eInternalFormat, GLuint nInputImageBinding, GLuint nOutputImageBinding);
     static std::string getComputeShaderSource_ParallelPrefixSum_BlockMerge(size_t nColumns, size_t nMaxRowSize, size_t nRows, GLenum eInternalFormat, GLuint nImageBinding);
     static std::string getComputeShaderSource_Transpose(size_t nBlockSize, GLenum eInternalFormat, GLuint nInputImageBinding, GLuint nOutputImageBinding);
     static std::string getComputeShaderFunctionSource_SharedDataPreLoad(size_t nChannels, const glm::uvec2& vWorkGroupSize, size_t nExternalBorderSize);
     static std::string getComputeShaderFunctionSource_BinaryMedianBlur(size_t nKernelSize, bool bUseSharedDataPreload, const glm::uvec2& vWorkGroupSize);
     static std::string getShaderFunctionSource_getRandNeighbor3x3(size_t nBorderSize,const cv::Size& oFrameSize);
+    static std::string getShaderFunctionSource_getRandNeighbor5x5(size_t nBorderSize,const cv::Size& oFrameSize);
     static std::string getShaderFunctionSource_frand();
     static std::string getShaderFunctionSource_urand();
     static std::string getShaderFunctionSource_urand_tinymt32();
 
 private:
     static bool useShaderProgram(GLShader* pNewShader);
+    /// returns the cache key of the current sources (also covers the driver/GPU identification strings)
+    uint64_t getProgramCacheKey() const;
+    /// tries to link the program from a cached binary; returns false if none is available or if the driver rejects it
+    bool loadProgramBinary(uint64_t nKey);
+    /// stores the binary of the (freshly linked) program in the caches
+    void storeProgramBinary(uint64_t nKey);
     GLShader& operator=(const GLShader&) = delete;
     GLShader(const GLShader&) = delete;
     std::map<GLuint,std::string> m_mShaderSources;
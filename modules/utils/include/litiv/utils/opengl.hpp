@@ -27,6 +27,7 @@
 #include <opencv2/opencv.hpp>
 #include "litiv/utils/cxx.hpp"
 #include "litiv/utils/platform.hpp"
+#include "litiv/utils/random.hpp"
 
 #if HAVE_GLFW
 #include <GLFW/glfw3.h>
@@ -55,18 +56,39 @@ struct glutWindowDeleter {
     typedef glutHandle pointer;
 };
 #endif //HAVE_FREEGLUT
+#if HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif //HAVE_EGL
 
 namespace lv {
 
     namespace gl {
 
+        /// gl context backend list; 'auto' picks the window manager if a display is available, and EGL otherwise
+        enum ContextBackend {
+            ContextBackend_Auto,
+            ContextBackend_Window,
+            ContextBackend_EGL,
+        };
+
         class Context {
         public:
+            /// creates & activates a new context; for EGL contexts, the window name & visibility are ignored, and nDeviceIdx selects the GPU
             Context(const cv::Size& oWinSize,
                     const std::string& sWinName,
                     bool bHide=true,
                     size_t nGLVerMajor=TARGET_GL_VER_MAJOR,
-                    size_t nGLVerMinor=TARGET_GL_VER_MINOR);
+                    size_t nGLVerMinor=TARGET_GL_VER_MINOR,
+                    ContextBackend eBackend=ContextBackend_Auto,
+                    size_t nDeviceIdx=0);
+            ~Context();
+            /// returns the backend actually used by this context
+            ContextBackend getBackend() const {return m_eBackend;}
+            /// returns the number of GPUs that can host headless EGL contexts (0 if EGL is unavailable)
+            static size_t getEGLDeviceCount();
+            /// returns the backend that 'auto' resolves to in the current environment
+            static ContextBackend getDefaultBackend();
             void setAsActive();
             void setWindowVisibility(bool bVal);
             void setWindowSize(const cv::Size& oSize, bool bUpdateViewport=true);
@@ -90,6 +112,14 @@ namespace lv {
 #elif HAVE_FREEGLUT
             std::unique_ptr<glutHandle,glutWindowDeleter> m_oWindowHandle;
 #endif //HAVE_FREEGLUT
+#if HAVE_EGL
+            EGLDisplay m_pEGLDisplay;
+            EGLConfig m_pEGLConfig;
+            EGLContext m_pEGLContext;
+            EGLSurface m_pEGLSurface; ///< pbuffer of the 'window' size, or EGL_NO_SURFACE for surfaceless contexts
+            void createEGLSurface(const cv::Size& oSize);
+#endif //HAVE_EGL
+            const ContextBackend m_eBackend;
             const size_t m_nGLVerMajor;
             const size_t m_nGLVerMinor;
             static std::once_flag s_oInitFlag;
@@ -97,16 +127,28 @@ namespace lv {
             Context(const Context&) = delete;
         };
 
+        /// multi-gpu context manager; each worker thread owns at most one context, created on the device it is assigned to, and kept current across tasks
+        struct DeviceContextManager {
+            /// returns the number of devices worker contexts can be spread over (number of EGL devices if available, 1 otherwise)
+            static size_t getDeviceCount();
+            /// returns the calling thread's context, (re)creating it on the given device if needed, and making it current; headless contexts are used if more than one device is available
+            static Context& getThreadContext(size_t nDeviceIdx, const cv::Size& oSize, const std::string& sName=std::string(), bool bHide=true);
+            /// destroys the calling thread's context, if any (also done automatically when the thread exits)
+            static void releaseThreadContext();
+        };
+
         inline bool isInternalFormatSupported(GLenum eInternalFormat) {
             switch(eInternalFormat) {
                 case GL_R8:
                 case GL_R8UI:
+                case GL_R16UI:
                 case GL_R32UI:
                 case GL_R32F:
                 case GL_RGB32UI:
                 case GL_RGB32F:
                 case GL_RGBA8:
                 case GL_RGBA8UI:
+                case GL_RGBA16UI:
                 case GL_RGBA32UI:
                 case GL_RGBA32F:
                     return true;
@@ -120,6 +162,9 @@ namespace lv {
                 case CV_8UC1:
                 case CV_8UC3:
                 case CV_8UC4:
+                case CV_16UC1:
+                case CV_16UC3:
+                case CV_16UC4:
                 case CV_32FC1:
                 case CV_32FC3:
                 case CV_32FC4:
@@ -139,6 +184,11 @@ namespace lv {
                 case CV_8UC3:
                 case CV_8UC4:
                     return bUseIntegralFormat?GL_RGBA8UI:GL_RGBA8;
+                case CV_16UC1:
+                    return bUseIntegralFormat?GL_R16UI:lvError("opencv mat input format type cannot be matched to a predefined setup");
+                case CV_16UC3:
+                case CV_16UC4:
+                    return bUseIntegralFormat?GL_RGBA16UI:lvError("opencv mat input format type cannot be matched to a predefined setup");
                 case CV_32FC1:
                     return GL_R32F;
                 case CV_32FC3:
@@ -168,8 +218,10 @@ namespace lv {
                 case GL_RGB32F:
                 case GL_RGBA32F:
                     return eInternalFormat;
+                case GL_R16UI:
                 case GL_R32UI:
                 case GL_RGB32UI:
+                case GL_RGBA16UI:
                 case GL_RGBA32UI:
                 default:
                     lvError("input internal format did not match any predefined normalized format");
@@ -183,8 +235,10 @@ namespace lv {
                 case GL_RGBA8:
                     return GL_RGBA8UI;
                 case GL_R8UI:
+                case GL_R16UI:
                 case GL_R32UI:
                 case GL_RGBA8UI:
+                case GL_RGBA16UI:
                 case GL_RGB32UI:
                 case GL_RGBA32UI:
                     return eInternalFormat;
@@ -207,6 +261,10 @@ namespace lv {
                     return "rgba8ui";
                 case GL_RGBA8:
                     return "rgba8";
+                case GL_R16UI:
+                    return "r16ui";
+                case GL_RGBA16UI:
+                    return "rgba16ui";
                 case GL_R32F:
                     return "r32f";
                 case GL_RGB32F:
@@ -227,8 +285,10 @@ namespace lv {
         inline bool isInternalFormatIntegral(GLenum eInternalFormat) {
             switch(eInternalFormat) {
                 case GL_R8UI:
+                case GL_R16UI:
                 case GL_R32UI:
                 case GL_RGBA8UI:
+                case GL_RGBA16UI:
                 case GL_RGB32UI:
                 case GL_RGBA32UI:
                     return true;
@@ -251,6 +311,10 @@ namespace lv {
                 case GL_RGBA8UI:
                 case GL_RGBA8:
                     return CV_8UC4;
+                case GL_R16UI:
+                    return CV_16UC1;
+                case GL_RGBA16UI:
+                    return CV_16UC4;
                 case GL_R32F:
                     return CV_32FC1;
                 case GL_RGB32F:
@@ -302,6 +366,8 @@ namespace lv {
             switch(nTextureDepth) {
                 case CV_8U:
                     return nTextureChannels==4?GL_UNSIGNED_INT_8_8_8_8_REV:GL_UNSIGNED_BYTE;
+                case CV_16U:
+                    return GL_UNSIGNED_SHORT;
                 case CV_32F:
                     return GL_FLOAT;
                 case CV_32S:
@@ -316,6 +382,8 @@ namespace lv {
                 case GL_UNSIGNED_BYTE:
                 case GL_UNSIGNED_INT_8_8_8_8_REV:
                     return CV_8U;
+                case GL_UNSIGNED_SHORT:
+                    return CV_16U;
                 case GL_FLOAT:
                     return CV_32F;
                 case GL_UNSIGNED_INT:
@@ -329,6 +397,8 @@ namespace lv {
             switch(nDepth) {
                 case CV_8U:
                     return 1;
+                case CV_16U:
+                    return 2;
                 case CV_32F:
                 case CV_32S:
                     return 4;
@@ -340,14 +410,17 @@ namespace lv {
         inline int getChannelsFromMatType(int nType) {
             switch(nType) {
                 case CV_8UC1:
+                case CV_16UC1:
                 case CV_32FC1:
                 case CV_32SC1:
                     return 1;
                 case CV_8UC3:
+                case CV_16UC3:
                 case CV_32FC3:
                 case CV_32SC3:
                     return 3;
                 case CV_8UC4:
+                case CV_16UC4:
                 case CV_32FC4:
                 case CV_32SC4:
                     return 4;
@@ -360,6 +433,7 @@ namespace lv {
             switch(eInternalFormat) {
                 case GL_R8:
                 case GL_R8UI:
+                case GL_R16UI:
                 case GL_R32F:
                 case GL_R32UI:
                     return 1;
@@ -368,6 +442,7 @@ namespace lv {
                     return 3;
                 case GL_RGBA8:
                 case GL_RGBA8UI:
+                case GL_RGBA16UI:
                 case GL_RGBA32F:
                 case GL_RGBA32UI:
                     return 4;
@@ -406,7 +481,10 @@ namespace lv {
             uint mat2;
             uint tmat;
             uint pad;
+            /// inits all generators in the given layout using rand() seeds (one per generator)
             static void initTinyMT32Generators(glm::uvec3 vGeneratorLayout,std::aligned_vector<TMT32GenParams,32>& voData);
+            /// inits all generators in the given layout so that they match a CPU-side 'lv::TinyMT32Bank' of the same size & seed (for bit-exact validation)
+            static void initTinyMT32Generators(glm::uvec3 vGeneratorLayout,std::aligned_vector<TMT32GenParams,32>& voData,uint32_t nSeed);
         };
 
     } // namespace gl
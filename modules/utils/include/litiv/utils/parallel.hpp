@@ -25,10 +25,14 @@
 #include "litiv/utils/opengl-imgproc.hpp"
 #endif //HAVE_GLSL
 #if HAVE_CUDA
-#include @@@@@
+#include <cuda_runtime.h>
 #endif //HAVE_CUDA
 #if HAVE_OPENCL
-#include @@@@@
+#if defined(__APPLE__)
+#include <OpenCL/opencl.h>
+#else //(!defined(__APPLE__))
+#include <CL/cl.h>
+#endif //(!defined(__APPLE__))
 #endif //HAVE_OPENCL
 #if defined(_MSC_VER)
 #include <intrin.h>
@@ -37,9 +41,12 @@
 #undef HAVE_MMX
 #define HAVE_MMX 0
 #endif //TARGET_PLATFORM_x64 && HAVE_MMX
-#else //(!defined(_MSC_VER))
+#elif defined(__x86_64__) || defined(__i386__)
 #include <x86intrin.h>
 #endif //(!defined(_MSC_VER))
+#if HAVE_NEON
+#include <arm_neon.h>
+#endif //HAVE_NEON
 
 namespace lv {
 
@@ -90,15 +97,15 @@ namespace lv {
     using IParallelAlgo_CUDA = IParallelAlgo_<CUDA>;
 #endif //HAVE_CUDA
 
-#if HAVE_CUDA
+#if HAVE_OPENCL
     template<>
-    struct IParallelAlgo_<OpenCL> : /*public OpenCLImageProcAlgo,*/ public IIParallelAlgo {
+    struct IParallelAlgo_<OpenCL> : /*public CLImageProcAlgo,*/ public IIParallelAlgo {
         static_assert(false,"Missing OpenCL impl");
         virtual bool isParallel() {return true;}
         virtual ParallelAlgoType getParallelAlgoType() {return OpenCL;}
     };
     using IParallelAlgo_OpenCL = IParallelAlgo_<OpenCL>;
-#endif //HAVE_CUDA
+#endif //HAVE_OPENCL
 
     template<>
     struct IParallelAlgo_<NonParallel> : public IIParallelAlgo {
@@ -108,6 +115,42 @@ namespace lv {
     };
     using NonParallelAlgo = IParallelAlgo_<NonParallel>;
 
+    /// list of SIMD instruction sets that kernels can be dispatched to at runtime (ordered by increasing support level)
+    enum SIMDInstrSet {
+        SIMD_None,
+        SIMD_SSE2,
+        SIMD_SSE4_1,
+        SIMD_AVX2,
+        SIMD_AVX512BW
+    };
+
+    /// returns the most advanced SIMD instruction set supported by the current CPU (queried once, independently of compile-time HAVE_* flags)
+    SIMDInstrSet getSupportedSIMDInstrSet();
+
+    /// handle on the process-wide work-stealing scheduler used to run blocking data-parallel loops (the calling thread also takes part in the work);
+    /// all pools share the same worker threads (one per hardware thread), so nested or concurrent loops never oversubscribe cores
+    struct ThreadPool {
+        /// creates a pool handle using at most nThreads threads per loop in total, including the caller (0 = one per hardware thread)
+        explicit ThreadPool(size_t nThreads=0);
+        /// returns the maximum number of threads used in parallel_for calls (including the caller)
+        size_t getThreadCount() const {return m_nThreadCount;}
+        /// runs lTask(nTaskIdx) for all nTaskIdx in [0,nTasks) and blocks until done; the first exception thrown by a task is rethrown here (reentrant)
+        void parallel_for(size_t nTasks, const std::function<void(size_t)>& lTask);
+        /// runs lRangeTask(nChunkBegin,nChunkEnd) over [nBegin,nEnd) split in chunks of nGrain indices and blocks until done (same rules as above)
+        void parallel_for(size_t nBegin, size_t nEnd, size_t nGrain, const std::function<void(size_t,size_t)>& lRangeTask);
+        /// returns the default pool handle (one thread per hardware thread)
+        static ThreadPool& getShared();
+    private:
+        size_t m_nThreadCount;
+    };
+
+    /// runs lRangeTask(nChunkBegin,nChunkEnd) over [nBegin,nEnd) split in chunks of nGrain indices on the shared pool, and blocks until done
+    void parallel_for(size_t nBegin, size_t nEnd, size_t nGrain, const std::function<void(size_t,size_t)>& lRangeTask);
+    /// runs lBlockTask(oBlock) over oRange split in blocks of (at most) oGrain size on the shared pool, and blocks until done
+    void parallel_for_2d(const cv::Rect& oRange, const cv::Size& oGrain, const std::function<void(const cv::Rect&)>& lBlockTask);
+
+    // note: the register-level helpers below take intrinsic vector types and are meant to be inlined, so they stay selected by
+    // the global instruction set flags; hot loops that need runtime selection go through per-TU kernels instead (e.g. the litiv_datasets metrics kernels)
 #if HAVE_MMX
     /// returns the (horizontal) sum of the provided 8-unsigned-byte array
     inline uint hsum_8ub(const __m64& anBuffer) {
@@ -160,4 +203,22 @@ namespace lv {
     }
 #endif //HAVE_SSE4_1
 
+#if HAVE_NEON
+    /// returns a mask built from the most significant bit of each byte of the provided 16-unsigned-byte array (equivalent to _mm_movemask_epi8)
+    inline uint movemask_16ub(const uint8x16_t& anBuffer) {
+        alignas(16) static const uchar s_anBitWeights[16] = {1,2,4,8,16,32,64,128,1,2,4,8,16,32,64,128};
+        const uint8x16_t _anBits = vandq_u8(vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(anBuffer),7)),vld1q_u8(s_anBitWeights));
+        uint8x8_t _anRes = vpadd_u8(vget_low_u8(_anBits),vget_high_u8(_anBits));
+        _anRes = vpadd_u8(_anRes,_anRes);
+        _anRes = vpadd_u8(_anRes,_anRes);
+        return uint(vget_lane_u16(vreinterpret_u16_u8(_anRes),0));
+    }
+
+    /// returns the (horizontal) sum of the provided 16-unsigned-byte array
+    inline uint hsum_16ub(const uint8x16_t& anBuffer) {
+        const uint64x2_t _anRes = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(anBuffer)));
+        return uint(vgetq_lane_u64(_anRes,0)+vgetq_lane_u64(_anRes,1));
+    }
+#endif //HAVE_NEON
+
 } // namespace lv
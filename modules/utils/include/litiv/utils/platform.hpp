@@ -25,6 +25,8 @@
 #include <stdint.h>
 #include <direct.h>
 #include <psapi.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 template<class T>
 void SafeRelease(T **ppT) {if(*ppT) {(*ppT)->Release();*ppT = nullptr;}}
 #if !USE_KINECTSDK_STANDALONE
@@ -36,6 +38,10 @@ void SafeRelease(T **ppT) {if(*ppT) {(*ppT)->Release();*ppT = nullptr;}}
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <stdio.h>
 #endif //(!defined(_MSC_VER))
 #include "litiv/utils/cxx.hpp"
@@ -48,9 +54,157 @@ namespace lv {
     void GetSubDirsFromDir(const std::string& sDirPath, std::vector<std::string>& vsSubDirPaths);
     void FilterFilePaths(std::vector<std::string>& vsFilePaths, const std::vector<std::string>& vsRemoveTokens, const std::vector<std::string>& vsKeepTokens);
     bool CreateDirIfNotExist(const std::string& sDirPath);
+    bool GetFileStats(const std::string& sPath, int64_t& nModifTime, int64_t& nSize);
     std::fstream CreateBinFileWithPrealloc(const std::string& sFilePath, size_t nPreallocBytes, bool bZeroInit=false);
     void RegisterAllConsoleSignals(void(*lHandler)(int));
     size_t GetCurrentPhysMemBytesUsed();
+    /// returns the peak physical memory (resident set) used by the process since its start or since the last reset (0 if unknown)
+    size_t GetPeakPhysMemBytesUsed();
+    /// resets the peak physical memory counter to the current usage; returns false if unsupported (the peak then stays process-wide)
+    bool ResetPeakPhysMemBytesUsed();
+    /// returns the number of NUMA nodes available on the system (1 if unknown or non-NUMA)
+    size_t GetNUMANodeCount();
+    /// returns the NUMA node of the processor the calling thread currently runs on (-1 if unknown)
+    int GetCurrentNUMANode();
+    /// allocates page-aligned memory for large buffers, backed by huge pages when possible (explicit, then transparent), and bound to a NUMA node if nNUMANode>=0
+    void* AllocLargeMem(size_t nBytes, int nNUMANode=-1, bool bUseHugePages=true);
+    /// releases memory obtained via AllocLargeMem (nBytes must match the allocation size)
+    void FreeLargeMem(void* pMem, size_t nBytes);
+    /// turns a block obtained via AllocLargeMem into a copy-on-write fork, and returns a second block (to be released via FreeLargeMem) sharing its pages;
+    /// both keep the current contents, and a page is only duplicated when first written by either block (returns nullptr if unsupported, e.g. outside linux)
+    void* ShareLargeMemCOW(void* pMem, size_t nBytes);
+
+    /// cpu affinity & scheduling priority applied to all threads of a given role (see lv::ThreadRole)
+    struct ThreadPlacementPolicy {
+        /// logical cpu indices the threads may run on (empty = inherit the process affinity)
+        std::vector<size_t> vnCPUs;
+        /// relative scheduling priority in [-2,2] (0 = unchanged; raising it may require elevated privileges)
+        int nPriority = 0;
+    };
+    /// restricts the calling thread to the given logical cpus (on windows, only cpus in the processor group of the first one are kept); returns false on failure
+    bool SetCurrentThreadAffinity(const std::vector<size_t>& vnCPUs);
+    /// sets the relative scheduling priority of the calling thread in [-2,2] (per-thread nice value on linux); returns false on failure
+    bool SetCurrentThreadPriority(int nPriority);
+    /// parses a cpu list such as "0-3,8,10-11" into logical cpu indices (throws if malformed)
+    std::vector<size_t> ParseCPUList(const std::string& sCPUList);
+    /// registers the placement policy of a thread role (only affects threads started afterwards)
+    void SetThreadPlacementPolicy(ThreadRole eRole, const ThreadPlacementPolicy& oPolicy);
+    /// returns the placement policy of a thread role (initialized from the LITIV_THREAD_AFFINITY_<ROLE> and LITIV_THREAD_PRIORITY_<ROLE> env vars if never set)
+    ThreadPlacementPolicy GetThreadPlacementPolicy(ThreadRole eRole);
+
+    /// read-only memory-mapped file view (unmapped on destruction)
+    struct MappedFile {
+        /// maps the entire file at the given path (throws if it cannot be opened or mapped)
+        MappedFile(const std::string& sFilePath);
+        /// unmaps the file and closes its handle(s)
+        ~MappedFile();
+        /// returns a pointer to the beginning of the mapped file data
+        inline const uint8_t* data() const {return m_pData;}
+        /// returns the size of the mapped file, in bytes
+        inline size_t size() const {return m_nSize;}
+    private:
+        const uint8_t* m_pData;
+        size_t m_nSize;
+#if defined(_MSC_VER)
+        HANDLE m_hFile,m_hMapping;
+#else //(!defined(_MSC_VER))
+        int m_nFileDesc;
+#endif //(!defined(_MSC_VER))
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(const MappedFile&) = delete;
+    };
+
+    /// exclusive inter-process advisory lock held on a file (created if missing) for the lifetime of the object
+    struct FileLock {
+        /// opens the lock file at the given path and blocks until the lock is acquired (throws if the file cannot be opened)
+        FileLock(const std::string& sLockFilePath);
+        /// releases the lock and closes the lock file handle (the file itself is left in place)
+        ~FileLock();
+    private:
+#if defined(_MSC_VER)
+        HANDLE m_hFile;
+#else //(!defined(_MSC_VER))
+        int m_nFileDesc;
+#endif //(!defined(_MSC_VER))
+        FileLock& operator=(const FileLock&) = delete;
+        FileLock(const FileLock&) = delete;
+    };
+
+    /// named inter-process shared memory segment, mapped read-write (the name is removed by the creator on destruction, mappings stay valid until unmapped)
+    struct SharedMemorySegment {
+        /// creates (fails if the name is already used) or opens a named segment; names must be short and slash-free, and nSize is ignored when opening
+        SharedMemorySegment(const std::string& sName, size_t nSize, bool bCreate);
+        /// unmaps the segment (and removes its name if it was created here)
+        ~SharedMemorySegment();
+        /// returns a pointer to the beginning of the mapped segment (zero-initialized on creation)
+        inline uint8_t* data() const {return m_pData;}
+        /// returns the size of the mapped segment, in bytes
+        inline size_t size() const {return m_nSize;}
+        /// returns the name of the segment
+        inline const std::string& getName() const {return m_sName;}
+        /// returns whether this segment was created here (i.e. whether its name is removed on destruction)
+        inline bool isOwner() const {return m_bOwner;}
+    private:
+        const std::string m_sName;
+        const bool m_bOwner;
+        uint8_t* m_pData;
+        size_t m_nSize;
+#if defined(_MSC_VER)
+        HANDLE m_hMapping;
+#endif //defined(_MSC_VER)
+        SharedMemorySegment& operator=(const SharedMemorySegment&) = delete;
+        SharedMemorySegment(const SharedMemorySegment&) = delete;
+    };
+
+    /// process-wide memory accounting; allocations made through tracking allocators (AlignedMemAllocator, cv::TrackingMatAllocator,
+    /// cv::LargePageMatAllocator) are attributed to the tag set by the innermost MemoryTracker::Scope of the allocating thread
+    struct MemoryTracker {
+        /// accounting tag (e.g. one per algorithm instance, precacher or writer); kept alive by its owners, scopes, and all allocations attributed to it
+        struct Tag {
+            const std::string m_sName;
+            std::atomic_size_t m_nCurrBytes,m_nPeakBytes,m_nAllocCount;
+            std::atomic_size_t m_nRefCount;
+        private:
+            explicit Tag(const std::string& sName) : m_sName(sName),m_nCurrBytes(0),m_nPeakBytes(0),m_nAllocCount(0),m_nRefCount(1) {}
+            friend struct MemoryTracker;
+        };
+        /// owner handle to a tag (the tag itself outlives the handle until all allocations attributed to it are released)
+        using TagPtr = std::shared_ptr<Tag>;
+        /// snapshot of the usage counters of a single tag
+        struct Usage {
+            std::string sName;
+            size_t nCurrBytes,nPeakBytes,nAllocCount;
+        };
+        /// name of the pseudo-tag that untagged allocations are attributed to
+        static constexpr const char* s_sUntaggedName = "untagged";
+        /// creates a new tag, optionally suffixed by its owner's address (names do not need to be unique, but make reports easier to read if they are)
+        static TagPtr createTag(const std::string& sName, const void* pOwner=nullptr);
+        /// returns the tag allocations of the calling thread are currently attributed to (nullptr = untagged)
+        static Tag* getCurrentTag();
+        /// adds a new allocation to the given tag's usage (or to the untagged usage if null), and returns the tag it needs to be released from
+        static Tag* onAlloc(Tag* pTag, size_t nBytes);
+        /// removes an allocation from the given tag's usage (or from the untagged usage if null)
+        static void onFree(Tag* pTag, size_t nBytes);
+        /// returns the usage counters of all live tags (sorted by name), followed by the untagged usage
+        static std::vector<Usage> getUsage();
+        /// returns the usage counters of a single tag
+        static Usage getUsage(const Tag& oTag);
+        /// returns a human-readable summary of all usage counters
+        static std::string getReport();
+        /// attributes all tracked allocations of the calling thread to the given tag until destruction (scopes can be nested)
+        struct Scope {
+            explicit Scope(const TagPtr& pTag);
+            ~Scope();
+        private:
+            Tag* const m_pTag;
+            Tag* const m_pPrevTag;
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+        };
+    private:
+        static void addRef(Tag* pTag);
+        static void releaseRef(Tag* pTag);
+    };
 
     template<typename T, std::size_t nByteAlign>
     class AlignedMemAllocator {
@@ -70,6 +224,8 @@ namespace lv {
         inline ~AlignedMemAllocator() throw() {}
         inline pointer address(reference r) {return std::addressof(r);}
         inline const_pointer address(const_reference r) const noexcept {return std::addressof(r);}
+        // note: each block is prefixed by one alignment unit holding the memory tracker tag it was attributed to
+        static_assert(nByteAlign>=sizeof(MemoryTracker::Tag*) && (nByteAlign&(nByteAlign-1))==0,"alignment must be a power of two large enough to store the tracker tag");
 #ifdef _MSC_VER
         inline pointer allocate(size_type n) {
             const size_type alignment = static_cast<size_type>(nByteAlign);
@@ -78,12 +234,12 @@ namespace lv {
                 alloc_size += alignment - alloc_size%alignment;
                 lvDbgAssert((alloc_size%alignment)==0);
             }
-            void* ptr = _aligned_malloc(alloc_size,nByteAlign);
+            void* ptr = _aligned_malloc(alloc_size+alignment,nByteAlign);
             if(ptr==nullptr)
                 throw std::bad_alloc();
-            return reinterpret_cast<pointer>(ptr);
+            return attach(ptr,n);
         }
-        inline void deallocate(pointer p, size_type) noexcept {_aligned_free(p);}
+        inline void deallocate(pointer p, size_type n) noexcept {_aligned_free(detach(p,n));}
         inline void destroy(pointer p) {p->~value_type();p;}
 #else //(!def(_MSC_VER))
         inline pointer allocate(size_type n) {
@@ -93,12 +249,12 @@ namespace lv {
                 alloc_size += alignment - alloc_size%alignment;
                 lvDbgAssert((alloc_size%alignment)==0);
             }
-            void* ptr = aligned_alloc(alignment,alloc_size);
+            void* ptr = aligned_alloc(alignment,alloc_size+alignment);
             if(ptr==nullptr)
                 throw std::bad_alloc();
-            return reinterpret_cast<pointer>(ptr);
+            return attach(ptr,n);
         }
-        inline void deallocate(pointer p, size_type) noexcept {free(p);}
+        inline void deallocate(pointer p, size_type n) noexcept {free(detach(p,n));}
         inline void destroy(pointer p) {p->~value_type();}
 #endif //(!def(_MSC_VER))
         template<typename T2, typename... Targs> inline void construct(T2* p, Targs&&... args) {::new(reinterpret_cast<void*>(p)) T2(std::forward<Targs>(args)...);}
@@ -106,6 +262,74 @@ namespace lv {
         inline size_type max_size() const noexcept {return (size_type(~0)-size_type(nByteAlign))/sizeof(value_type);}
         bool operator!=(const AlignedMemAllocator<T,nByteAlign>& other) const {return !(*this==other);}
         bool operator==(const AlignedMemAllocator<T,nByteAlign>& other) const {return true;}
+    private:
+        /// attributes a new block to the calling thread's current tag, and returns its user part
+        static inline pointer attach(void* ptr, size_type n) {
+            MemoryTracker::Tag* pTag = MemoryTracker::onAlloc(MemoryTracker::getCurrentTag(),n*sizeof(value_type));
+            uint8_t* pData = reinterpret_cast<uint8_t*>(ptr)+nByteAlign;
+            memcpy(pData-sizeof(pTag),&pTag,sizeof(pTag));
+            return reinterpret_cast<pointer>(pData);
+        }
+        /// releases a block from the tag it was attributed to, and returns its original address
+        static inline void* detach(pointer p, size_type n) noexcept {
+            uint8_t* pData = reinterpret_cast<uint8_t*>(p);
+            MemoryTracker::Tag* pTag;
+            memcpy(&pTag,pData-sizeof(pTag),sizeof(pTag));
+            MemoryTracker::onFree(pTag,n*sizeof(value_type));
+            return pData-nByteAlign;
+        }
+    };
+
+    /// sibling of AlignedMemAllocator for large buffers (e.g. per-pixel models); memory is page-aligned, huge-page backed when possible, and bound to the given NUMA node (-1 = default policy)
+    template<typename T>
+    class LargePageMemAllocator {
+    public:
+        typedef T value_type;
+        typedef T* pointer;
+        typedef const T* const_pointer;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::true_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+        template<typename T2> struct rebind {typedef LargePageMemAllocator<T2> other;};
+    public:
+        inline explicit LargePageMemAllocator(int nNUMANode=-1) noexcept : m_nNUMANode(nNUMANode) {}
+        template<typename T2> inline LargePageMemAllocator(const LargePageMemAllocator<T2>& other) noexcept : m_nNUMANode(other.getNUMANode()) {}
+        inline pointer allocate(size_type n) {return reinterpret_cast<pointer>(AllocLargeMem(n*sizeof(value_type),m_nNUMANode));}
+        inline void deallocate(pointer p, size_type n) noexcept {FreeLargeMem(p,n*sizeof(value_type));}
+        inline int getNUMANode() const noexcept {return m_nNUMANode;}
+        template<typename T2> bool operator!=(const LargePageMemAllocator<T2>& other) const {return !(*this==other);}
+        template<typename T2> bool operator==(const LargePageMemAllocator<T2>& other) const {return m_nNUMANode==other.getNUMANode();}
+    private:
+        int m_nNUMANode;
+    };
+
+    /// bump allocator for per-call scratch memory; all allocations are released at once on reset, and blocks used since the previous
+    /// reset are merged into a single one, so a steady-state frame loop never hits the heap (not thread-safe, use one arena per worker)
+    struct FrameArena {
+        /// creates an arena whose first block holds nInitBlockSize bytes
+        explicit FrameArena(size_t nInitBlockSize=size_t(1)<<20);
+        /// returns nBytes of uninitialized scratch memory aligned to nByteAlign (a power of two, at most 64)
+        void* allocate(size_t nBytes, size_t nByteAlign=32);
+        /// releases all allocations (previously returned pointers become invalid)
+        void reset();
+        /// returns the number of bytes handed out (including alignment padding) since the last reset
+        size_t getUsedBytes() const {return m_nUsedBytes;}
+        /// returns the total number of bytes currently allocated by the arena
+        size_t getCapacity() const;
+    protected:
+        using Block = std::vector<uint8_t,AlignedMemAllocator<uint8_t,64>>;
+        /// memory blocks; only the first one is left after a reset
+        std::vector<Block> m_vBlocks;
+        /// index of the block currently being filled, and its fill offset
+        size_t m_nCurrBlockIdx,m_nCurrBlockOffset;
+        /// number of bytes handed out since the last reset
+        size_t m_nUsedBytes;
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
     };
 
     template<typename T>
@@ -0,0 +1,87 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/utils/cxx.hpp"
+
+#if USE_PROFILER
+/// profiles the rest of the current scope under the given name (must be a string literal or otherwise have static storage duration)
+#define LV_PROFILE_SCOPE(name) static const lv::Profiler::Site XSTR_CONCAT(__oLVProfSite_,__LINE__)(name); const lv::Profiler::Scope XSTR_CONCAT(__oLVProfScope_,__LINE__)(XSTR_CONCAT(__oLVProfSite_,__LINE__))
+/// profiles the rest of the current function under its (undecorated) name
+#define LV_PROFILE_FUNCTION() LV_PROFILE_SCOPE(__func__)
+/// sets the name of the calling thread as shown in profiling traces & reports
+#define LV_PROFILE_THREAD_NAME(name) lv::Profiler::setThreadName(name)
+#else //(!USE_PROFILER)
+#define LV_PROFILE_SCOPE(name)
+#define LV_PROFILE_FUNCTION()
+#define LV_PROFILE_THREAD_NAME(name)
+#endif //(!USE_PROFILER)
+
+namespace lv {
+
+    /// hierarchical scope profiler; per-thread buffers are only ever written by their owner, so the hot path holds no locks
+    struct Profiler {
+        /// maximum number of distinct profiled scopes (sites past this limit are silently ignored)
+        static constexpr size_t s_nMaxSites = 512;
+        /// number of scope events kept per thread for trace exports (older events are overwritten)
+        static constexpr size_t s_nRingBufferSize = size_t(1)<<14;
+        /// number of log2-spaced bins (in nanoseconds) in per-scope time histograms
+        static constexpr size_t s_nHistBins = 32;
+        /// aggregated statistics of a single scope, across all threads
+        struct ScopeStats {
+            std::string sName,sParentName; ///< scope name, and name of the last scope it was observed under (empty if root)
+            uint64_t nCallCount; ///< number of completed calls
+            double dTotalTime_sec,dMinTime_sec,dMaxTime_sec; ///< total/min/max time spent in the scope
+            std::array<uint64_t,s_nHistBins> anHistogram; ///< call counts per [2^i,2^(i+1)) nanosecond bins
+            /// returns an upper bound estimate (in seconds) of the given call time quantile, based on the histogram
+            double getQuantileTime_sec(double dQuantile) const;
+        };
+        /// toggles profiling at runtime (enabled by default when compiled in; no effect if compiled without USE_PROFILER)
+        static void setEnabled(bool bEnabled);
+        /// returns whether profiling is currently enabled at runtime
+        static bool isEnabled();
+        /// discards all recorded statistics & events (each thread clears its own data on its next profiled scope)
+        static void reset();
+        /// sets the name of the calling thread as shown in traces & reports
+        static void setThreadName(const std::string& sName);
+        /// returns the aggregated per-scope statistics of all threads
+        static std::vector<ScopeStats> getStats();
+        /// returns a human-readable hierarchical summary of all scope statistics
+        static std::string getReport();
+        /// writes the buffered scope events of all threads in chrome trace JSON format (see chrome://tracing)
+        static void writeChromeTrace(std::ostream& oStream);
+        /// writes the buffered scope events of all threads in chrome trace JSON format to the given file
+        static void writeChromeTrace(const std::string& sFilePath);
+        /// static registration of a profiled scope (instantiated once per LV_PROFILE_SCOPE call site)
+        struct Site {
+            explicit Site(const char* sName);
+            const int m_nId;
+        };
+        /// records an externally measured duration (e.g. a gpu timer readback) as a call of the given site, nested under the current scope of the calling thread
+        static void addSample(const Site& oSite, uint64_t nTime_ns);
+        /// profiled scope instance; records its duration on destruction
+        struct Scope {
+            explicit Scope(const Site& oSite);
+            ~Scope();
+        private:
+            int64_t m_nStart_ns;
+            int m_nSiteId,m_nParentId;
+        };
+    };
+
+} // namespace lv
@@ -0,0 +1,96 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/utils/platform.hpp"
+
+namespace lv {
+
+    /// 32-bit Tiny Mersenne Twister (see Saito & Matsumoto 2011), with the same state layout, parameters & seeding as the GLSL 'urand_tinymt32' generators
+    struct TinyMT32 {
+        typedef uint32_t result_type;
+        /// parameter set used by all generators (tinymt32dc:cecf43a2417bd5c41e5d6f80cf2ce903,32,1337,f20d1b78,ff90ffe5,30fbdfff,65,0)
+        static constexpr uint32_t s_nMat1 = 0xF20D1B78, s_nMat2 = 0xFF90FFE5, s_nTMat = 0x30FBDFFF;
+        /// default constructor (uses a fixed seed, so default-constructed generators always produce the same sequence)
+        TinyMT32() {seed(0);}
+        /// seeding constructor
+        explicit TinyMT32(uint32_t nSeed) {seed(nSeed);}
+        /// reseeds the generator state (matches lv::gl::TMT32GenParams::initTinyMT32Generators for the same per-generator seed)
+        inline void seed(uint32_t nSeed) {
+            status[0] = nSeed;
+            status[1] = mat1 = s_nMat1;
+            status[2] = mat2 = s_nMat2;
+            status[3] = tmat = s_nTMat;
+            pad = 1337;
+            for(int nLoop=1; nLoop<8; ++nLoop)
+                status[nLoop&3] ^= nLoop+UINT32_C(1812433253)*(status[(nLoop-1)&3]^(status[(nLoop-1)&3]>>30));
+            for(int nLoop=0; nLoop<8; ++nLoop)
+                nextState();
+        }
+        /// returns the next 32-bit random value of the sequence
+        inline result_type operator()() {
+            nextState();
+            uint32_t t0 = status[3];
+            const uint32_t t1 = status[0]+(status[2]>>8);
+            t0 ^= t1;
+            t0 ^= (0u-(t1&1u))&tmat;
+            return t0;
+        }
+        static constexpr result_type min() {return 0u;}
+        static constexpr result_type max() {return UINT32_MAX;}
+        uint32_t status[4];
+        uint32_t mat1,mat2,tmat,pad;
+    private:
+        inline void nextState() {
+            uint32_t s0 = status[3];
+            uint32_t s1 = (status[0]&UINT32_C(0x7fffffff))^status[1]^status[2];
+            s1 ^= (s1<<1);
+            s0 ^= (s0>>1)^s1;
+            status[0] = status[1];
+            status[1] = status[2];
+            status[2] = s1^(s0<<10);
+            status[3] = s0;
+            status[1] ^= (0u-(s0&1u))&mat1;
+            status[2] ^= (0u-(s0&1u))&mat2;
+        }
+    };
+
+    /// bank of independent TinyMT32 generators (e.g. one per pixel) stored in 8-lane blocks, so that consecutive generators are advanced together
+    /// using SIMD instructions; generator i is seeded with the i-th output of PCG32(nSeed), like seeded lv::gl::TMT32GenParams generators
+    struct TinyMT32Bank {
+        /// number of generators per SIMD block
+        static constexpr size_t s_nBlockSize = 8;
+        /// default constructor (empty bank)
+        TinyMT32Bank() : m_nGenerators(0) {}
+        /// creates & seeds a bank of nGenerators generators
+        TinyMT32Bank(size_t nGenerators, uint32_t nSeed) {init(nGenerators,nSeed);}
+        /// (re)creates & seeds a bank of nGenerators generators
+        void init(size_t nGenerators, uint32_t nSeed);
+        /// returns the number of generators in the bank
+        inline size_t size() const {return m_nGenerators;}
+        /// advances generators [nBeginIdx,nBeginIdx+nCount) by one step each, writing their outputs (in generator order) to anOutput
+        void generate(size_t nBeginIdx, size_t nCount, uint32_t* anOutput);
+        /// returns a copy of the given generator (e.g. to compare its state with a GPU-side generator)
+        TinyMT32 getGenerator(size_t nIdx) const;
+    private:
+        size_t m_nGenerators;
+        /// per block: status[0..3] of each lane, stored as 4 consecutive rows of s_nBlockSize values
+        std::aligned_vector<uint32_t,32> m_vnStatus;
+    };
+
+} // namespace lv
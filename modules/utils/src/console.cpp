@@ -0,0 +1,215 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/utils/console.hpp"
+
+#define ASYNCLOGGER_POLL_PERIOD_MS 20 // max delay between a message being queued and it being written, if nobody flushes
+
+namespace {
+
+    typedef std::chrono::steady_clock LoggerClock;
+
+    /// single-producer/single-consumer ring of fixed-size log records, owned by a single logging thread
+    struct ThreadRing {
+        struct Record {
+            alignas(8) uchar acData[lv::AsyncLogger::s_nRecordSize];
+        };
+        explicit ThreadRing(size_t nThreadId) :
+                m_nThreadId(nThreadId),
+                m_aRecords(new Record[lv::AsyncLogger::s_nRingSize]),
+                m_nHead(0),
+                m_nTail(0),
+                m_nDropCount(0),
+                m_bOrphaned(false) {}
+        const size_t m_nThreadId;
+        std::unique_ptr<Record[]> m_aRecords;
+        std::atomic_size_t m_nHead; ///< only written by the logger thread
+        char m_acPadding[lv::s_nCacheLineSize];
+        std::atomic_size_t m_nTail; ///< only written by the owner thread
+        std::atomic_size_t m_nDropCount; ///< only written by the owner thread, and reset by the logger thread
+        std::atomic_bool m_bOrphaned; ///< set once the owner thread has exited (the ring is then released once drained)
+    };
+
+    /// global registry of thread rings & background writer thread (only locked on registration, flushes and drain passes)
+    struct Registry {
+        Registry() :
+                m_pOutputStream(nullptr),
+                m_nNextThreadId(0),
+                m_nFlushReqCount(0),
+                m_nFlushDoneCount(0),
+                m_bActive(true),
+                m_nOrigin(LoggerClock::now()) {}
+        ~Registry() {
+            {
+                std::mutex_lock_guard oLock(m_oMutex);
+                m_bActive = false;
+            }
+            m_oCondVar.notify_all();
+            if(m_oWorker.joinable())
+                m_oWorker.join();
+        }
+        /// returns a new ring for the calling thread (the background thread is started on the first registration)
+        std::shared_ptr<ThreadRing> registerThread() {
+            std::mutex_lock_guard oLock(m_oMutex);
+            m_vpRings.push_back(std::make_shared<ThreadRing>(m_nNextThreadId++));
+            if(!m_oWorker.joinable())
+                m_oWorker = std::thread(&Registry::entry,this);
+            return m_vpRings.back();
+        }
+        void entry() {
+            std::vector<std::pair<int64_t,std::string>> vMessages;
+            std::string sOutput;
+            std::mutex_unique_lock oLock(m_oMutex);
+            while(true) {
+                m_oCondVar.wait_for(oLock,std::chrono::milliseconds(ASYNCLOGGER_POLL_PERIOD_MS),[&]{return !m_bActive || m_nFlushReqCount!=m_nFlushDoneCount;});
+                const size_t nFlushReqCount = m_nFlushReqCount;
+                const bool bActive = m_bActive;
+                // rings are drained while holding the registry lock (which only blocks new threads & flushes); formatting is the slow part, but it
+                // must happen before the slots are released, and copying records out first would not be faster
+                vMessages.clear();
+                for(auto ppRing=m_vpRings.begin(); ppRing!=m_vpRings.end();) {
+                    ThreadRing& oRing = **ppRing;
+                    const bool bOrphaned = oRing.m_bOrphaned.load(); // checked first, so that the last records of an exited thread are not missed
+                    drain(oRing,vMessages);
+                    if(bOrphaned)
+                        ppRing = m_vpRings.erase(ppRing);
+                    else
+                        ++ppRing;
+                }
+                if(!vMessages.empty()) {
+                    std::stable_sort(vMessages.begin(),vMessages.end(),[](const auto& a, const auto& b) {return a.first<b.first;});
+                    sOutput.clear();
+                    for(const auto& oMessage : vMessages)
+                        sOutput += oMessage.second;
+                    std::ostream& oStream = m_pOutputStream?*m_pOutputStream:std::cout;
+                    oStream << sOutput;
+                    oStream.flush();
+                }
+                m_nFlushDoneCount = nFlushReqCount;
+                m_oFlushCondVar.notify_all();
+                if(!bActive)
+                    break;
+            }
+        }
+        /// formats all published records of a ring (w/ a prefix for non-info messages), and releases their slots
+        void drain(ThreadRing& oRing, std::vector<std::pair<int64_t,std::string>>& vMessages) {
+            const size_t nTail = oRing.m_nTail.load(std::memory_order_acquire);
+            size_t nHead = oRing.m_nHead.load(std::memory_order_relaxed);
+            const size_t nDropCount = oRing.m_nDropCount.exchange(0);
+            if(nDropCount>0)
+                vMessages.emplace_back(std::chrono::duration_cast<std::chrono::nanoseconds>(LoggerClock::now().time_since_epoch()).count(),cv::format("[lvLog: T%d dropped %d message(s), ring was full]\n",(int)oRing.m_nThreadId,(int)nDropCount));
+            static const char* s_asLevelNames[] = {"debug","info","warning","error"};
+            for(; nHead!=nTail; ++nHead) {
+                const uchar* pRecord = oRing.m_aRecords[nHead%lv::AsyncLogger::s_nRingSize].acData;
+                lv::AsyncLogger::RecordHeader oHeader;
+                memcpy(&oHeader,pRecord,sizeof(oHeader));
+                std::string sMessage;
+                if(oHeader.eLevel!=lv::LogLevel_Info)
+                    sMessage = cv::format("[lvLog @ %.3fs, T%d, %s] ",double(oHeader.nTimestamp_ns-getOrigin_ns())/1e9,(int)oRing.m_nThreadId,s_asLevelNames[oHeader.eLevel]);
+                oHeader.pDecoder(oHeader.sFormat,pRecord+sizeof(oHeader),sMessage);
+                if(sMessage.empty() || sMessage.back()!='\n')
+                    sMessage += '\n';
+                vMessages.emplace_back(oHeader.nTimestamp_ns,std::move(sMessage));
+                oRing.m_nHead.store(nHead+1,std::memory_order_release);
+            }
+        }
+        int64_t getOrigin_ns() const {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(m_nOrigin.time_since_epoch()).count();
+        }
+        std::mutex m_oMutex;
+        std::condition_variable m_oCondVar,m_oFlushCondVar;
+        std::vector<std::shared_ptr<ThreadRing>> m_vpRings;
+        std::ostream* m_pOutputStream;
+        size_t m_nNextThreadId;
+        size_t m_nFlushReqCount,m_nFlushDoneCount;
+        bool m_bActive;
+        std::thread m_oWorker;
+        const LoggerClock::time_point m_nOrigin;
+    };
+
+    Registry& getRegistry() {
+        static Registry s_oRegistry;
+        return s_oRegistry;
+    }
+
+    /// thread-local handle to the calling thread's ring; flags it as orphaned when the thread exits
+    struct ThreadRingHandle {
+        ~ThreadRingHandle() {
+            if(m_pRing)
+                m_pRing->m_bOrphaned = true;
+        }
+        ThreadRing& get() {
+            if(!m_pRing)
+                m_pRing = getRegistry().registerThread();
+            return *m_pRing;
+        }
+        std::shared_ptr<ThreadRing> m_pRing;
+    };
+
+    thread_local ThreadRingHandle g_oThreadRing;
+
+} // anonymous namespace
+
+std::atomic<int> lv::AsyncLogger::s_nLevel(lv::LogLevel_Info);
+
+void lv::AsyncLogger::setLevel(LogLevel eLevel) {
+    s_nLevel.store(int(eLevel),std::memory_order_relaxed);
+}
+
+lv::LogLevel lv::AsyncLogger::getLevel() {
+    return LogLevel(s_nLevel.load(std::memory_order_relaxed));
+}
+
+void lv::AsyncLogger::setOutputStream(std::ostream* pStream) {
+    flush();
+    Registry& oRegistry = getRegistry();
+    std::mutex_lock_guard oLock(oRegistry.m_oMutex);
+    oRegistry.m_pOutputStream = pStream;
+}
+
+void lv::AsyncLogger::flush() {
+    Registry& oRegistry = getRegistry();
+    std::mutex_unique_lock oLock(oRegistry.m_oMutex);
+    if(!oRegistry.m_oWorker.joinable())
+        return; // nothing was ever logged
+    const size_t nFlushReqIdx = ++oRegistry.m_nFlushReqCount;
+    oRegistry.m_oCondVar.notify_all();
+    oRegistry.m_oFlushCondVar.wait(oLock,[&]{return oRegistry.m_nFlushDoneCount>=nFlushReqIdx;});
+}
+
+uchar* lv::AsyncLogger::acquireRecord(LogLevel eLevel) {
+    ThreadRing& oRing = g_oThreadRing.get();
+    const size_t nTail = oRing.m_nTail.load(std::memory_order_relaxed);
+    if(nTail-oRing.m_nHead.load(std::memory_order_acquire)>=s_nRingSize) {
+        if(eLevel<LogLevel_Warning) {
+            oRing.m_nDropCount.fetch_add(1,std::memory_order_relaxed);
+            return nullptr;
+        }
+        getRegistry().m_oCondVar.notify_all();
+        lv::spin_wait([&]{return nTail-oRing.m_nHead.load(std::memory_order_acquire)<s_nRingSize;});
+    }
+    return oRing.m_aRecords[nTail%s_nRingSize].acData;
+}
+
+void lv::AsyncLogger::commitRecord() {
+    ThreadRing& oRing = g_oThreadRing.get();
+    oRing.m_nTail.store(oRing.m_nTail.load(std::memory_order_relaxed)+1,std::memory_order_release);
+}
+
+int64_t lv::AsyncLogger::getTimestamp_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(LoggerClock::now().time_since_epoch()).count();
+}
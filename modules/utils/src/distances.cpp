@@ -0,0 +1,68 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/utils/distances.hpp"
+#include "distances_kernels.hpp"
+
+namespace {
+
+    dist_impl::HDistBulkKernel getHDistBulkKernel() {
+#if DIST_KERNELS_X86
+        switch(lv::getSupportedSIMDInstrSet()) {
+            case lv::SIMD_AVX512BW: return &dist_impl::hdistBulk_AVX512BW;
+            case lv::SIMD_AVX2: return &dist_impl::hdistBulk_AVX2;
+            case lv::SIMD_SSE4_1:
+            case lv::SIMD_SSE2: return &dist_impl::hdistBulk_SSE2;
+            default: break;
+        }
+#elif DIST_KERNELS_NEON
+        return &dist_impl::hdistBulk_NEON;
+#endif //DIST_KERNELS_NEON
+        return &dist_impl::hdistBulk_Scalar;
+    }
+
+    dist_impl::HDistCountKernel getHDistCountKernel() {
+#if DIST_KERNELS_X86
+        switch(lv::getSupportedSIMDInstrSet()) {
+            case lv::SIMD_AVX512BW: return &dist_impl::hdistCount_AVX512BW;
+            case lv::SIMD_AVX2: return &dist_impl::hdistCount_AVX2;
+            case lv::SIMD_SSE4_1:
+            case lv::SIMD_SSE2: return &dist_impl::hdistCount_SSE2;
+            default: break;
+        }
+#elif DIST_KERNELS_NEON
+        return &dist_impl::hdistCount_NEON;
+#endif //DIST_KERNELS_NEON
+        return &dist_impl::hdistCount_Scalar;
+    }
+
+} // namespace
+
+void lv::hdist_bulk(const ushort* a, const ushort* b, size_t n, uchar* out) {
+    static_assert(sizeof(ushort)==sizeof(unsigned short) && sizeof(uchar)==sizeof(unsigned char),"bad kernel type assumptions");
+    lvDbgAssert(n==0 || (a && b && out));
+    static const dist_impl::HDistBulkKernel s_pKernel = getHDistBulkKernel();
+    s_pKernel(a,b,n,out);
+}
+
+size_t lv::hdist_bulk_count(const ushort* a, const ushort* b, size_t n, size_t nMaxDist) {
+    lvDbgAssert(n==0 || (a && b));
+    if(nMaxDist>=sizeof(ushort)*8)
+        return n; // all 16-bit pairs match, no need to look at the data
+    static const dist_impl::HDistCountKernel s_pKernel = getHDistCountKernel();
+    return s_pKernel(a,b,n,(unsigned short)nMaxDist);
+}
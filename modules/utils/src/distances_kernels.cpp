@@ -0,0 +1,144 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "distances_kernels.hpp"
+
+namespace {
+
+    inline unsigned int hdist16_Scalar(unsigned short nDesc1, unsigned short nDesc2) {
+        unsigned int nBits = (unsigned int)(nDesc1^nDesc2);
+        nBits = nBits-((nBits>>1)&0x5555u);
+        nBits = (nBits&0x3333u)+((nBits>>2)&0x3333u);
+        nBits = (nBits+(nBits>>4))&0x0F0Fu;
+        return (nBits+(nBits>>8))&0x1Fu;
+    }
+
+#if DIST_KERNELS_X86 && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2))
+    inline __m128i hdist16_SSE2(const __m128i& vnDesc1, const __m128i& vnDesc2) {
+        __m128i vnBits = _mm_xor_si128(vnDesc1,vnDesc2);
+        vnBits = _mm_sub_epi16(vnBits,_mm_and_si128(_mm_srli_epi16(vnBits,1),_mm_set1_epi16(0x5555)));
+        vnBits = _mm_add_epi16(_mm_and_si128(vnBits,_mm_set1_epi16(0x3333)),_mm_and_si128(_mm_srli_epi16(vnBits,2),_mm_set1_epi16(0x3333)));
+        vnBits = _mm_and_si128(_mm_add_epi16(vnBits,_mm_srli_epi16(vnBits,4)),_mm_set1_epi16(0x0F0F));
+        return _mm_srli_epi16(_mm_add_epi16(vnBits,_mm_slli_epi16(vnBits,8)),8);
+    }
+
+    inline size_t hdistBulk_SSE2_impl(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+        size_t nElemIdx = 0;
+        for(; nElemIdx+16<=nElems; nElemIdx+=16) {
+            const __m128i vnDistLow = hdist16_SSE2(_mm_loadu_si128((const __m128i*)(anDesc1+nElemIdx)),_mm_loadu_si128((const __m128i*)(anDesc2+nElemIdx)));
+            const __m128i vnDistHigh = hdist16_SSE2(_mm_loadu_si128((const __m128i*)(anDesc1+nElemIdx+8)),_mm_loadu_si128((const __m128i*)(anDesc2+nElemIdx+8)));
+            _mm_storeu_si128((__m128i*)(anOutput+nElemIdx),_mm_packus_epi16(vnDistLow,vnDistHigh));
+        }
+        return nElemIdx;
+    }
+
+    inline size_t hdistCount_SSE2_impl(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist, size_t& nCount) {
+        const __m128i vnMaxDist = _mm_set1_epi16((short)nMaxDist), vnOnes = _mm_set1_epi16(1);
+        __m128i vnCounts = _mm_setzero_si128(); // 32-bit lanes, decremented by 2 per pair of matches (madd of -1 masks)
+        size_t nElemIdx = 0;
+        for(; nElemIdx+8<=nElems; nElemIdx+=8) {
+            const __m128i vnDist = hdist16_SSE2(_mm_loadu_si128((const __m128i*)(anDesc1+nElemIdx)),_mm_loadu_si128((const __m128i*)(anDesc2+nElemIdx)));
+            const __m128i vbMatch = _mm_cmpeq_epi16(_mm_cmpgt_epi16(vnDist,vnMaxDist),_mm_setzero_si128());
+            vnCounts = _mm_sub_epi32(vnCounts,_mm_madd_epi16(vbMatch,vnOnes));
+        }
+        alignas(16) int anCounts[4];
+        _mm_store_si128((__m128i*)anCounts,vnCounts);
+        nCount += size_t(anCounts[0])+size_t(anCounts[1])+size_t(anCounts[2])+size_t(anCounts[3]);
+        return nElemIdx;
+    }
+#define DIST_KERNELS_SSE2 1
+#endif //DIST_KERNELS_X86 && __SSE2__
+
+#if DIST_KERNELS_NEON
+    inline uint16x8_t hdist16_NEON(const uint16x8_t& vnDesc1, const uint16x8_t& vnDesc2) {
+        return vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u16(veorq_u16(vnDesc1,vnDesc2))));
+    }
+
+    inline size_t hdistBulk_NEON_impl(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+        size_t nElemIdx = 0;
+        for(; nElemIdx+16<=nElems; nElemIdx+=16) {
+            const uint16x8_t vnDistLow = hdist16_NEON(vld1q_u16(anDesc1+nElemIdx),vld1q_u16(anDesc2+nElemIdx));
+            const uint16x8_t vnDistHigh = hdist16_NEON(vld1q_u16(anDesc1+nElemIdx+8),vld1q_u16(anDesc2+nElemIdx+8));
+            vst1q_u8(anOutput+nElemIdx,vcombine_u8(vqmovn_u16(vnDistLow),vqmovn_u16(vnDistHigh)));
+        }
+        return nElemIdx;
+    }
+
+    inline size_t hdistCount_NEON_impl(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist, size_t& nCount) {
+        const uint16x8_t vnMaxDist = vdupq_n_u16(nMaxDist);
+        uint32x4_t vnCounts = vdupq_n_u32(0);
+        size_t nElemIdx = 0;
+        for(; nElemIdx+8<=nElems; nElemIdx+=8) {
+            const uint16x8_t vnDist = hdist16_NEON(vld1q_u16(anDesc1+nElemIdx),vld1q_u16(anDesc2+nElemIdx));
+            vnCounts = vpadalq_u16(vnCounts,vshrq_n_u16(vcleq_u16(vnDist,vnMaxDist),15));
+        }
+        nCount += size_t(vgetq_lane_u32(vnCounts,0))+size_t(vgetq_lane_u32(vnCounts,1))+size_t(vgetq_lane_u32(vnCounts,2))+size_t(vgetq_lane_u32(vnCounts,3));
+        return nElemIdx;
+    }
+#endif //DIST_KERNELS_NEON
+
+} // namespace
+
+void dist_impl::hdistBulk_Scalar(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+    for(size_t nElemIdx=0; nElemIdx<nElems; ++nElemIdx)
+        anOutput[nElemIdx] = (unsigned char)hdist16_Scalar(anDesc1[nElemIdx],anDesc2[nElemIdx]);
+}
+
+size_t dist_impl::hdistCount_Scalar(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist) {
+    size_t nCount = 0;
+    for(size_t nElemIdx=0; nElemIdx<nElems; ++nElemIdx)
+        nCount += (hdist16_Scalar(anDesc1[nElemIdx],anDesc2[nElemIdx])<=nMaxDist);
+    return nCount;
+}
+
+void dist_impl::hdistBulk_SSE2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+#if DIST_KERNELS_SSE2
+    const size_t nDone = hdistBulk_SSE2_impl(anDesc1,anDesc2,nElems,anOutput);
+    hdistBulk_Scalar(anDesc1+nDone,anDesc2+nDone,nElems-nDone,anOutput+nDone);
+#else //(!DIST_KERNELS_SSE2)
+    hdistBulk_Scalar(anDesc1,anDesc2,nElems,anOutput);
+#endif //(!DIST_KERNELS_SSE2)
+}
+
+size_t dist_impl::hdistCount_SSE2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist) {
+#if DIST_KERNELS_SSE2
+    size_t nCount = 0;
+    const size_t nDone = hdistCount_SSE2_impl(anDesc1,anDesc2,nElems,nMaxDist,nCount);
+    return nCount+hdistCount_Scalar(anDesc1+nDone,anDesc2+nDone,nElems-nDone,nMaxDist);
+#else //(!DIST_KERNELS_SSE2)
+    return hdistCount_Scalar(anDesc1,anDesc2,nElems,nMaxDist);
+#endif //(!DIST_KERNELS_SSE2)
+}
+
+void dist_impl::hdistBulk_NEON(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+#if DIST_KERNELS_NEON
+    const size_t nDone = hdistBulk_NEON_impl(anDesc1,anDesc2,nElems,anOutput);
+    hdistBulk_Scalar(anDesc1+nDone,anDesc2+nDone,nElems-nDone,anOutput+nDone);
+#else //(!DIST_KERNELS_NEON)
+    hdistBulk_Scalar(anDesc1,anDesc2,nElems,anOutput);
+#endif //(!DIST_KERNELS_NEON)
+}
+
+size_t dist_impl::hdistCount_NEON(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist) {
+#if DIST_KERNELS_NEON
+    size_t nCount = 0;
+    const size_t nDone = hdistCount_NEON_impl(anDesc1,anDesc2,nElems,nMaxDist,nCount);
+    return nCount+hdistCount_Scalar(anDesc1+nDone,anDesc2+nDone,nElems-nDone,nMaxDist);
+#else //(!DIST_KERNELS_NEON)
+    return hdistCount_Scalar(anDesc1,anDesc2,nElems,nMaxDist);
+#endif //(!DIST_KERNELS_NEON)
+}
@@ -0,0 +1,71 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// note: this header is shared by the runtime-dispatched distance kernel translation units, which are compiled with
+// different instruction set flags; it must stay free of any inline code coming from other headers (e.g. std/cv/lv),
+// as the linker could otherwise pick an instantiation that uses instructions not supported by the current CPU
+
+#include <cstddef>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DIST_KERNELS_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else //(!defined(_MSC_VER))
+#include <x86intrin.h>
+#endif //(!defined(_MSC_VER))
+#else //(!x86)
+#define DIST_KERNELS_X86 0
+#endif //(!x86)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define DIST_KERNELS_NEON 1
+#include <arm_neon.h>
+#else //(!NEON)
+#define DIST_KERNELS_NEON 0
+#endif //(!NEON)
+
+namespace dist_impl {
+
+    /// signature of the bulk 16-bit hamming distance kernels (one distance per element pair, written as 8-bit values)
+    typedef void(*HDistBulkKernel)(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput);
+    /// signature of the bulk 16-bit hamming distance counting kernels (returns the number of element pairs whose distance is at most nMaxDist)
+    typedef size_t(*HDistCountKernel)(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist);
+
+    /// baseline implementation, always available
+    void hdistBulk_Scalar(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput);
+    /// SSE2 implementation (16 elements per iteration, SWAR popcount, falls back to scalar if not compiled in)
+    void hdistBulk_SSE2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput);
+    /// AVX2 implementation (32 elements per iteration, nibble-LUT popcount, falls back to SSE2 if not compiled in)
+    void hdistBulk_AVX2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput);
+    /// NEON implementation (16 elements per iteration, falls back to scalar if not compiled in)
+    void hdistBulk_NEON(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput);
+    /// AVX-512BW implementation (64 elements per iteration, nibble-LUT popcount, falls back to AVX2 if not compiled in)
+    void hdistBulk_AVX512BW(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput);
+
+    /// baseline implementation, always available
+    size_t hdistCount_Scalar(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist);
+    /// SSE2 implementation (8 elements per iteration, SWAR popcount, falls back to scalar if not compiled in)
+    size_t hdistCount_SSE2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist);
+    /// AVX2 implementation (16 elements per iteration, nibble-LUT popcount, falls back to SSE2 if not compiled in)
+    size_t hdistCount_AVX2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist);
+    /// NEON implementation (8 elements per iteration, falls back to scalar if not compiled in)
+    size_t hdistCount_NEON(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist);
+    /// AVX-512BW implementation (32 elements per iteration, nibble-LUT popcount, falls back to AVX2 if not compiled in)
+    size_t hdistCount_AVX512BW(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist);
+
+} // namespace dist_impl
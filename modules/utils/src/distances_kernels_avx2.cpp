@@ -0,0 +1,76 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// note: this translation unit is compiled with AVX2 enabled (see CMakeLists.txt); its kernels are only called when the
+// current CPU supports the instruction set, so nothing else than the kernels themselves should ever be defined here
+
+#include "distances_kernels.hpp"
+
+#if DIST_KERNELS_X86 && defined(__AVX2__)
+
+namespace {
+
+    inline __m256i hdist16_AVX2(const __m256i& vnDesc1, const __m256i& vnDesc2) {
+        const __m256i vnNibbleLUT = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+        const __m256i vnNibbleMask = _mm256_set1_epi8(0x0F);
+        const __m256i vnBits = _mm256_xor_si256(vnDesc1,vnDesc2);
+        const __m256i vnByteCounts = _mm256_add_epi8(_mm256_shuffle_epi8(vnNibbleLUT,_mm256_and_si256(vnBits,vnNibbleMask)),
+                                                     _mm256_shuffle_epi8(vnNibbleLUT,_mm256_and_si256(_mm256_srli_epi16(vnBits,4),vnNibbleMask)));
+        return _mm256_maddubs_epi16(vnByteCounts,_mm256_set1_epi8(1));
+    }
+
+} // namespace
+
+void dist_impl::hdistBulk_AVX2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+    size_t nElemIdx = 0;
+    for(; nElemIdx+32<=nElems; nElemIdx+=32) {
+        const __m256i vnDistLow = hdist16_AVX2(_mm256_loadu_si256((const __m256i*)(anDesc1+nElemIdx)),_mm256_loadu_si256((const __m256i*)(anDesc2+nElemIdx)));
+        const __m256i vnDistHigh = hdist16_AVX2(_mm256_loadu_si256((const __m256i*)(anDesc1+nElemIdx+16)),_mm256_loadu_si256((const __m256i*)(anDesc2+nElemIdx+16)));
+        // packing is done per 128-bit lane, so the 64-bit blocks must be reordered afterwards
+        _mm256_storeu_si256((__m256i*)(anOutput+nElemIdx),_mm256_permute4x64_epi64(_mm256_packus_epi16(vnDistLow,vnDistHigh),0xD8));
+    }
+    hdistBulk_SSE2(anDesc1+nElemIdx,anDesc2+nElemIdx,nElems-nElemIdx,anOutput+nElemIdx);
+}
+
+size_t dist_impl::hdistCount_AVX2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist) {
+    const __m256i vnMaxDist = _mm256_set1_epi16((short)nMaxDist), vnOnes = _mm256_set1_epi16(1);
+    __m256i vnCounts = _mm256_setzero_si256(); // 32-bit lanes, decremented by 2 per pair of matches (madd of -1 masks)
+    size_t nElemIdx = 0;
+    for(; nElemIdx+16<=nElems; nElemIdx+=16) {
+        const __m256i vnDist = hdist16_AVX2(_mm256_loadu_si256((const __m256i*)(anDesc1+nElemIdx)),_mm256_loadu_si256((const __m256i*)(anDesc2+nElemIdx)));
+        const __m256i vbMatch = _mm256_cmpeq_epi16(_mm256_cmpgt_epi16(vnDist,vnMaxDist),_mm256_setzero_si256());
+        vnCounts = _mm256_sub_epi32(vnCounts,_mm256_madd_epi16(vbMatch,vnOnes));
+    }
+    alignas(32) int anCounts[8];
+    _mm256_store_si256((__m256i*)anCounts,vnCounts);
+    size_t nCount = 0;
+    for(int nLaneIdx=0; nLaneIdx<8; ++nLaneIdx)
+        nCount += size_t(anCounts[nLaneIdx]);
+    return nCount+hdistCount_SSE2(anDesc1+nElemIdx,anDesc2+nElemIdx,nElems-nElemIdx,nMaxDist);
+}
+
+#else //!(DIST_KERNELS_X86 && defined(__AVX2__))
+
+void dist_impl::hdistBulk_AVX2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+    hdistBulk_SSE2(anDesc1,anDesc2,nElems,anOutput);
+}
+
+size_t dist_impl::hdistCount_AVX2(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist) {
+    return hdistCount_SSE2(anDesc1,anDesc2,nElems,nMaxDist);
+}
+
+#endif //!(DIST_KERNELS_X86 && defined(__AVX2__))
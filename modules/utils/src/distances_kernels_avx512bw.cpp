@@ -0,0 +1,77 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// note: this translation unit is compiled with AVX-512BW enabled (see CMakeLists.txt); its kernels are only called when the
+// current CPU supports the instruction set, so nothing else than the kernels themselves should ever be defined here
+
+#include "distances_kernels.hpp"
+
+#if DIST_KERNELS_X86 && defined(__AVX512BW__)
+
+namespace {
+
+    inline __m512i hdist16_AVX512BW(const __m512i& vnDesc1, const __m512i& vnDesc2) {
+        const __m512i vnNibbleLUT = _mm512_set_epi64(0x0403030203020201,0x0302020102010100,0x0403030203020201,0x0302020102010100,0x0403030203020201,0x0302020102010100,0x0403030203020201,0x0302020102010100);
+        const __m512i vnNibbleMask = _mm512_set1_epi8(0x0F);
+        const __m512i vnBits = _mm512_xor_si512(vnDesc1,vnDesc2);
+        const __m512i vnByteCounts = _mm512_add_epi8(_mm512_shuffle_epi8(vnNibbleLUT,_mm512_and_si512(vnBits,vnNibbleMask)),
+                                                     _mm512_shuffle_epi8(vnNibbleLUT,_mm512_and_si512(_mm512_srli_epi16(vnBits,4),vnNibbleMask)));
+        return _mm512_maddubs_epi16(vnByteCounts,_mm512_set1_epi8(1));
+    }
+
+} // namespace
+
+void dist_impl::hdistBulk_AVX512BW(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+    const __m512i vnPackOrder = _mm512_setr_epi64(0,2,4,6,1,3,5,7);
+    size_t nElemIdx = 0;
+    for(; nElemIdx+64<=nElems; nElemIdx+=64) {
+        const __m512i vnDistLow = hdist16_AVX512BW(_mm512_loadu_si512((const void*)(anDesc1+nElemIdx)),_mm512_loadu_si512((const void*)(anDesc2+nElemIdx)));
+        const __m512i vnDistHigh = hdist16_AVX512BW(_mm512_loadu_si512((const void*)(anDesc1+nElemIdx+32)),_mm512_loadu_si512((const void*)(anDesc2+nElemIdx+32)));
+        // packing is done per 128-bit lane, so the 64-bit blocks must be reordered afterwards
+        _mm512_storeu_si512((void*)(anOutput+nElemIdx),_mm512_maskz_permutexvar_epi64(0xFF,vnPackOrder,_mm512_packus_epi16(vnDistLow,vnDistHigh)));
+    }
+    hdistBulk_AVX2(anDesc1+nElemIdx,anDesc2+nElemIdx,nElems-nElemIdx,anOutput+nElemIdx);
+}
+
+size_t dist_impl::hdistCount_AVX512BW(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist) {
+    const __m512i vnMaxDist = _mm512_set1_epi16((short)nMaxDist), vnOnes = _mm512_set1_epi16(1);
+    __m512i vnCounts = _mm512_setzero_si512(); // 32-bit lanes, incremented by the number of matches in each pair of 16-bit lanes
+    size_t nElemIdx = 0;
+    for(; nElemIdx+32<=nElems; nElemIdx+=32) {
+        const __m512i vnDist = hdist16_AVX512BW(_mm512_loadu_si512((const void*)(anDesc1+nElemIdx)),_mm512_loadu_si512((const void*)(anDesc2+nElemIdx)));
+        const __mmask32 abMatch = _mm512_cmple_epu16_mask(vnDist,vnMaxDist);
+        vnCounts = _mm512_add_epi32(vnCounts,_mm512_madd_epi16(_mm512_maskz_mov_epi16(abMatch,vnOnes),vnOnes));
+    }
+    alignas(64) int anCounts[16];
+    _mm512_store_si512((void*)anCounts,vnCounts);
+    size_t nCount = 0;
+    for(int nLaneIdx=0; nLaneIdx<16; ++nLaneIdx)
+        nCount += size_t(anCounts[nLaneIdx]);
+    return nCount+hdistCount_AVX2(anDesc1+nElemIdx,anDesc2+nElemIdx,nElems-nElemIdx,nMaxDist);
+}
+
+#else //!(DIST_KERNELS_X86 && defined(__AVX512BW__))
+
+void dist_impl::hdistBulk_AVX512BW(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned char* anOutput) {
+    hdistBulk_AVX2(anDesc1,anDesc2,nElems,anOutput);
+}
+
+size_t dist_impl::hdistCount_AVX512BW(const unsigned short* anDesc1, const unsigned short* anDesc2, size_t nElems, unsigned short nMaxDist) {
+    return hdistCount_AVX2(anDesc1,anDesc2,nElems,nMaxDist);
+}
+
+#endif //!(DIST_KERNELS_X86 && defined(__AVX512BW__))
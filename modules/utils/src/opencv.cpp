@@ -17,33 +17,250 @@
 
 #include "litiv/utils/opencv.hpp"
 #include "litiv/utils/platform.hpp"
+#include "litiv/utils/parallel.hpp"
+#include "litiv/utils/distances.hpp"
 
-cv::DisplayHelperPtr cv::DisplayHelper::create(const std::string& sDisplayName, const std::string& sDebugFSDirPath, const cv::Size& oMaxSize, int nWindowFlags) {
+namespace {
+
+    /// computes matrix steps the same way cv::StdMatAllocator does, and returns the total byte count to allocate
+    size_t computeMatAllocSize(int nDims, const int* anSizes, int nType, const void* pData, size_t* anSteps) {
+        size_t nTotalBytes = CV_ELEM_SIZE(nType);
+        for(int nDimIter=nDims-1; nDimIter>=0; --nDimIter) {
+            if(anSteps) {
+                if(pData && anSteps[nDimIter]!=CV_AUTOSTEP) {
+                    lvAssert_(nTotalBytes<=anSteps[nDimIter],"bad user-provided step");
+                    nTotalBytes = anSteps[nDimIter];
+                }
+                else
+                    anSteps[nDimIter] = nTotalBytes;
+            }
+            nTotalBytes *= anSizes[nDimIter];
+        }
+        return nTotalBytes;
+    }
+
+} // anonymous namespace
+
+cv::UMatData* cv::ArenaMatAllocator::allocate(int nDims, const int* anSizes, int nType, void* pData, size_t* anSteps, AccessFlagType /*nFlags*/, UMatUsageFlags /*eUsageFlags*/) const {
+    // mirrors cv::StdMatAllocator, except that both the data and its header are carved from the arena
+    const size_t nTotalBytes = computeMatAllocSize(nDims,anSizes,nType,pData,anSteps);
+    uchar* pMatData = pData?(uchar*)pData:(uchar*)m_oArena.allocate(nTotalBytes,CV_MALLOC_ALIGN);
+    UMatData* pUMatData = new(m_oArena.allocate(sizeof(UMatData),alignof(UMatData))) UMatData(this);
+    pUMatData->data = pUMatData->origdata = pMatData;
+    pUMatData->size = nTotalBytes;
+    if(pData)
+        pUMatData->flags |= UMatData::USER_ALLOCATED;
+    ++m_nLiveCount;
+    return pUMatData;
+}
+
+bool cv::ArenaMatAllocator::allocate(UMatData* pData, AccessFlagType /*nAccessFlags*/, UMatUsageFlags /*eUsageFlags*/) const {
+    return pData!=nullptr;
+}
+
+void cv::ArenaMatAllocator::deallocate(UMatData* pData) const {
+    if(!pData)
+        return;
+    lvDbgAssert(pData->urefcount==0 && pData->refcount==0 && m_nLiveCount>0);
+    pData->origdata = nullptr; // memory itself is only reclaimed on reset
+    pData->~UMatData();
+    --m_nLiveCount;
+}
+
+cv::Mat cv::ArenaMatAllocator::create(const cv::Size& oSize, int nType) const {
+    cv::Mat oMat;
+    oMat.allocator = const_cast<ArenaMatAllocator*>(this);
+    oMat.create(oSize,nType);
+    return oMat;
+}
+
+void cv::ArenaMatAllocator::reset() {
+    lvAssert_(m_nLiveCount==0,"all arena-backed matrices must be released before resetting the arena");
+    m_oArena.reset();
+}
+
+cv::UMatData* cv::LargePageMatAllocator::allocate(int nDims, const int* anSizes, int nType, void* pData, size_t* anSteps, AccessFlagType /*nFlags*/, UMatUsageFlags /*eUsageFlags*/) const {
+    const size_t nTotalBytes = computeMatAllocSize(nDims,anSizes,nType,pData,anSteps);
+    UMatData* pUMatData = new UMatData(this);
+    pUMatData->data = pUMatData->origdata = pData?(uchar*)pData:(uchar*)lv::AllocLargeMem(std::max(nTotalBytes,size_t(1)),m_nNUMANode);
+    pUMatData->size = nTotalBytes;
+    if(pData)
+        pUMatData->flags |= UMatData::USER_ALLOCATED;
+    else
+        pUMatData->userdata = lv::MemoryTracker::onAlloc(lv::MemoryTracker::getCurrentTag(),nTotalBytes);
+    return pUMatData;
+}
+
+bool cv::LargePageMatAllocator::allocate(UMatData* pData, AccessFlagType /*nAccessFlags*/, UMatUsageFlags /*eUsageFlags*/) const {
+    return pData!=nullptr;
+}
+
+void cv::LargePageMatAllocator::deallocate(UMatData* pData) const {
+    if(!pData)
+        return;
+    lvDbgAssert(pData->urefcount==0 && pData->refcount==0);
+    if(!(pData->flags&UMatData::USER_ALLOCATED)) {
+        lv::FreeLargeMem(pData->origdata,std::max(pData->size,size_t(1)));
+        lv::MemoryTracker::onFree((lv::MemoryTracker::Tag*)pData->userdata,pData->size);
+    }
+    pData->origdata = nullptr;
+    delete pData;
+}
+
+cv::LargePageMatAllocator* cv::LargePageMatAllocator::get(int nNUMANode) {
+    // instances are never destroyed, as matrices allocated through them may outlive static destruction order
+    static const std::vector<LargePageMatAllocator*> s_vpAllocators = []() {
+        std::vector<LargePageMatAllocator*> vpAllocators;
+        for(int nNodeIdx=-1; nNodeIdx<(int)lv::GetNUMANodeCount(); ++nNodeIdx)
+            vpAllocators.push_back(new LargePageMatAllocator(nNodeIdx));
+        return vpAllocators;
+    }();
+    lvAssert_(nNUMANode>=-1 && nNUMANode+1<(int)s_vpAllocators.size(),"NUMA node index out of range");
+    return s_vpAllocators[size_t(nNUMANode+1)];
+}
+
+bool cv::LargePageMatAllocator::shareCOW(cv::Mat& oSrc, cv::Mat& oDst) {
+    if(oSrc.empty() || !oSrc.u || !dynamic_cast<const LargePageMatAllocator*>(oSrc.u->currAllocator) || (oSrc.u->flags&UMatData::USER_ALLOCATED) || oSrc.data!=oSrc.u->origdata || &oSrc==&oDst)
+        return false;
+    void* pSharedData = lv::ShareLargeMemCOW(oSrc.u->origdata,std::max(oSrc.u->size,size_t(1)));
+    if(!pSharedData)
+        return false;
+    UMatData* pUMatData = new UMatData(oSrc.u->currAllocator);
+    pUMatData->data = pUMatData->origdata = (uchar*)pSharedData;
+    pUMatData->size = oSrc.u->size;
+    pUMatData->userdata = lv::MemoryTracker::onAlloc(lv::MemoryTracker::getCurrentTag(),pUMatData->size); // tracked at full size, as pages may diverge
+    pUMatData->refcount = 1;
+    oDst.release();
+    oDst = cv::Mat(oSrc.dims,oSrc.size.p,oSrc.type(),pSharedData,oSrc.step.p);
+    oDst.u = pUMatData;
+    oDst.allocator = oSrc.allocator;
+    return true;
+}
+
+cv::UMatData* cv::TrackingMatAllocator::allocate(int nDims, const int* anSizes, int nType, void* pData, size_t* anSteps, AccessFlagType /*nFlags*/, UMatUsageFlags /*eUsageFlags*/) const {
+    const size_t nTotalBytes = computeMatAllocSize(nDims,anSizes,nType,pData,anSteps);
+    UMatData* pUMatData = new UMatData(this);
+    pUMatData->data = pUMatData->origdata = pData?(uchar*)pData:(uchar*)cv::fastMalloc(nTotalBytes);
+    pUMatData->size = nTotalBytes;
+    if(pData)
+        pUMatData->flags |= UMatData::USER_ALLOCATED;
+    else
+        pUMatData->userdata = lv::MemoryTracker::onAlloc(lv::MemoryTracker::getCurrentTag(),nTotalBytes);
+    return pUMatData;
+}
+
+bool cv::TrackingMatAllocator::allocate(UMatData* pData, AccessFlagType /*nAccessFlags*/, UMatUsageFlags /*eUsageFlags*/) const {
+    return pData!=nullptr;
+}
+
+void cv::TrackingMatAllocator::deallocate(UMatData* pData) const {
+    if(!pData)
+        return;
+    lvDbgAssert(pData->urefcount==0 && pData->refcount==0);
+    if(!(pData->flags&UMatData::USER_ALLOCATED)) {
+        cv::fastFree(pData->origdata);
+        lv::MemoryTracker::onFree((lv::MemoryTracker::Tag*)pData->userdata,pData->size);
+    }
+    pData->origdata = nullptr;
+    delete pData;
+}
+
+cv::TrackingMatAllocator* cv::TrackingMatAllocator::get() {
+    // never destroyed, as matrices allocated through it may outlive static destruction order
+    static TrackingMatAllocator* s_pAllocator = new TrackingMatAllocator();
+    return s_pAllocator;
+}
+
+void cv::TrackingMatAllocator::setAsDefault(bool bEnable) {
+    cv::Mat::setDefaultAllocator(bEnable?get():nullptr);
+}
+
+cv::DisplayHelperPtr cv::DisplayHelper::create(const std::string& sDisplayName, const std::string& sDebugFSDirPath, const cv::Size& oMaxSize, int nWindowFlags, bool bAsync, double dMaxRefreshRate) {
     struct DisplayHelperWrapper : public DisplayHelper {
-        DisplayHelperWrapper(const std::string& sDisplayName, const std::string& sDebugFSDirPath, const cv::Size& oMaxSize, int nWindowFlags) :
-                DisplayHelper(sDisplayName,sDebugFSDirPath,oMaxSize,nWindowFlags) {}
+        DisplayHelperWrapper(const std::string& sDisplayName, const std::string& sDebugFSDirPath, const cv::Size& oMaxSize, int nWindowFlags, bool bAsync, double dMaxRefreshRate) :
+                DisplayHelper(sDisplayName,sDebugFSDirPath,oMaxSize,nWindowFlags,bAsync,dMaxRefreshRate) {}
     };
-    return std::make_shared<DisplayHelperWrapper>(sDisplayName,sDebugFSDirPath,oMaxSize,nWindowFlags);
+    return std::make_shared<DisplayHelperWrapper>(sDisplayName,sDebugFSDirPath,oMaxSize,nWindowFlags,bAsync,dMaxRefreshRate);
 }
 
-cv::DisplayHelper::DisplayHelper(const std::string& sDisplayName, const std::string& sDebugFSDirPath, const cv::Size& oMaxSize, int nWindowFlags) :
+cv::DisplayHelper::DisplayHelper(const std::string& sDisplayName, const std::string& sDebugFSDirPath, const cv::Size& oMaxSize, int nWindowFlags, bool bAsync, double dMaxRefreshRate) :
         m_sDisplayName(sDisplayName),
         m_oMaxDisplaySize(oMaxSize),
         m_oDebugFS(lv::AddDirSlashIfMissing(sDebugFSDirPath)+sDisplayName+"_debug.yml",cv::FileStorage::WRITE),
+        m_nWindowFlags(nWindowFlags),
+        m_bAsync(bAsync),
+        m_nRefreshPeriod_ms(std::max(int(1000.0/dMaxRefreshRate),1)),
         m_oLastDisplaySize(cv::Size(0,0)),
         m_bContinuousUpdates(false),
         m_bFirstDisplay(true),
-        m_oMouseEventCallback(std::bind(&DisplayHelper::onMouseEventCallback,this,std::placeholders::_1,std::placeholders::_2,std::placeholders::_3,std::placeholders::_4)) {
-    cv::namedWindow(m_sDisplayName,nWindowFlags);
-    cv::setMouseCallback(m_sDisplayName,onMouseEvent,(void*)&m_oMouseEventCallback);
+        m_oMouseEventCallback(std::bind(&DisplayHelper::onMouseEventCallback,this,std::placeholders::_1,std::placeholders::_2,std::placeholders::_3,std::placeholders::_4)),
+        m_nSnapshotImgCount(0),
+        m_nSnapshotIdx(0),
+        m_bSnapshotPending(false),
+        m_nLastKeyPressed(-1),
+        m_bUIThreadActive(false) {
+    lvAssert_(dMaxRefreshRate>0.0,"max refresh rate must be positive");
+    if(m_bAsync) {
+        // the window is created, pumped and destroyed by the UI thread, as some highgui backends bind windows to their creating thread
+        m_bUIThreadActive = true;
+        m_hUIThread = std::thread(&DisplayHelper::uiEntry,this);
+    }
+    else {
+        cv::namedWindow(m_sDisplayName,m_nWindowFlags);
+        cv::setMouseCallback(m_sDisplayName,onMouseEvent,(void*)&m_oMouseEventCallback);
+    }
 }
 
 cv::DisplayHelper::~DisplayHelper() {
-    cv::destroyWindow(m_sDisplayName);
+    if(m_bAsync) {
+        m_bUIThreadActive = false;
+        if(m_hUIThread.joinable())
+            m_hUIThread.join();
+    }
+    else
+        cv::destroyWindow(m_sDisplayName);
 }
 
 void cv::DisplayHelper::display(const cv::Mat& oImage, size_t nIdx) {
     lvAssert_(!oImage.empty() && (oImage.type()==CV_8UC1 || oImage.type()==CV_8UC3 || oImage.type()==CV_8UC4),"image to display must be non-empty, and of type 8UC1/8UC3/8UC4");
+    if(!m_bAsync) {
+        cv::imshow(m_sDisplayName,render(oImage,nIdx));
+        return;
+    }
+    const std::chrono::steady_clock::time_point nNow = std::chrono::steady_clock::now();
+    if(m_bContinuousUpdates && nNow-m_nLastSnapshotTime<std::chrono::milliseconds(m_nRefreshPeriod_ms))
+        return; // would be replaced before the UI thread gets to render it anyway
+    std::mutex_lock_guard oLock(m_oSnapshotMutex);
+    oImage.copyTo(m_aoSnapshotImgs[0]); // reuses the snapshot buffers once their size is stable
+    m_nSnapshotImgCount = 1;
+    m_nSnapshotIdx = nIdx;
+    m_bSnapshotPending = true;
+    m_nLastSnapshotTime = nNow;
+}
+
+void cv::DisplayHelper::display(const cv::Mat& oInputImg, const cv::Mat& oDebugImg, const cv::Mat& oOutputImg, size_t nIdx) {
+    lvAssert_(!oInputImg.empty() && (oInputImg.type()==CV_8UC1 || oInputImg.type()==CV_8UC3 || oInputImg.type()==CV_8UC4),"input image must be 8UC1/8UC3/8UC4");
+    lvAssert_(!oDebugImg.empty() && (oDebugImg.type()==CV_8UC1 || oDebugImg.type()==CV_8UC3 || oDebugImg.type()==CV_8UC4),"debug image must be 8UC1/8UC3/8UC4");
+    lvAssert_(!oOutputImg.empty() && (oOutputImg.type()==CV_8UC1 || oOutputImg.type()==CV_8UC3 || oOutputImg.type()==CV_8UC4),"output image must be 8UC1/8UC3/8UC4");
+    lvAssert_(oOutputImg.size()==oInputImg.size() && oDebugImg.size()==oInputImg.size(),"all provided mat sizes must match");
+    if(!m_bAsync) {
+        cv::imshow(m_sDisplayName,render(oInputImg,oDebugImg,oOutputImg,nIdx));
+        return;
+    }
+    const std::chrono::steady_clock::time_point nNow = std::chrono::steady_clock::now();
+    if(m_bContinuousUpdates && nNow-m_nLastSnapshotTime<std::chrono::milliseconds(m_nRefreshPeriod_ms))
+        return; // would be replaced before the UI thread gets to render it anyway
+    std::mutex_lock_guard oLock(m_oSnapshotMutex);
+    oInputImg.copyTo(m_aoSnapshotImgs[0]); // reuses the snapshot buffers once their size is stable
+    oDebugImg.copyTo(m_aoSnapshotImgs[1]);
+    oOutputImg.copyTo(m_aoSnapshotImgs[2]);
+    m_nSnapshotImgCount = 3;
+    m_nSnapshotIdx = nIdx;
+    m_bSnapshotPending = true;
+    m_nLastSnapshotTime = nNow;
+}
+
+cv::Mat cv::DisplayHelper::render(const cv::Mat& oImage, size_t nIdx) {
     cv::Mat oImageBYTE3;
     if(oImage.channels()==1)
         cv::cvtColor(oImage,oImageBYTE3,cv::COLOR_GRAY2BGR);
@@ -75,14 +292,11 @@ void cv::DisplayHelper::display(const cv::Mat& oImage, size_t nIdx) {
         const cv::Point2i oDbgPt_rescaled(int(oCurrDisplaySize.width*(float(oDbgPt.x)/oLastDbgSize.width)),int(oCurrDisplaySize.height*(float(oDbgPt.y)/oLastDbgSize.height)));
         cv::circle(oImageBYTE3,oDbgPt_rescaled,5,cv::Scalar(255,255,255));
     }
-    cv::imshow(m_sDisplayName,oImageBYTE3);
     m_oLastDisplaySize = oCurrDisplaySize;
+    return oImageBYTE3;
 }
-void cv::DisplayHelper::display(const cv::Mat& oInputImg, const cv::Mat& oDebugImg, const cv::Mat& oOutputImg, size_t nIdx) {
-    lvAssert_(!oInputImg.empty() && (oInputImg.type()==CV_8UC1 || oInputImg.type()==CV_8UC3 || oInputImg.type()==CV_8UC4),"input image must be 8UC1/8UC3/8UC4");
-    lvAssert_(!oDebugImg.empty() && (oDebugImg.type()==CV_8UC1 || oDebugImg.type()==CV_8UC3 || oDebugImg.type()==CV_8UC4),"debug image must be 8UC1/8UC3/8UC4");
-    lvAssert_(!oOutputImg.empty() && (oOutputImg.type()==CV_8UC1 || oOutputImg.type()==CV_8UC3 || oOutputImg.type()==CV_8UC4),"output image must be 8UC1/8UC3/8UC4");
-    lvAssert_(oOutputImg.size()==oInputImg.size() && oDebugImg.size()==oInputImg.size(),"all provided mat sizes must match");
+
+cv::Mat cv::DisplayHelper::render(const cv::Mat& oInputImg, const cv::Mat& oDebugImg, const cv::Mat& oOutputImg, size_t nIdx) {
     cv::Mat oInputImgBYTE3, oDebugImgBYTE3, oOutputImgBYTE3;
     if(oInputImg.channels()==1)
         cv::cvtColor(oInputImg,oInputImgBYTE3,cv::COLOR_GRAY2BGR);
@@ -99,7 +313,7 @@ void cv::DisplayHelper::display(const cv::Mat& oInputImg, const cv::Mat& oDebugI
     if(oOutputImg.channels()==1)
         cv::cvtColor(oOutputImg,oOutputImgBYTE3,cv::COLOR_GRAY2BGR);
     else if(oOutputImg.channels()==4)
-        cv::cvtColor(oOutputImg,oDebugImgBYTE3,cv::COLOR_BGRA2BGR);
+        cv::cvtColor(oOutputImg,oOutputImgBYTE3,cv::COLOR_BGRA2BGR);
     else
         oOutputImgBYTE3 = oOutputImg;
     cv::Size oCurrDisplaySize;
@@ -135,18 +349,58 @@ void cv::DisplayHelper::display(const cv::Mat& oInputImg, const cv::Mat& oDebugI
     cv::Mat displayH;
     cv::hconcat(oInputImgBYTE3,oDebugImgBYTE3,displayH);
     cv::hconcat(displayH,oOutputImgBYTE3,displayH);
-    cv::imshow(m_sDisplayName,displayH);
     m_oLastDisplaySize = oCurrDisplaySize;
+    return displayH;
+}
+
+void cv::DisplayHelper::uiEntry() {
+    cv::namedWindow(m_sDisplayName,m_nWindowFlags);
+    cv::setMouseCallback(m_sDisplayName,onMouseEvent,(void*)&m_oMouseEventCallback);
+    std::array<cv::Mat,3> aoImgs;
+    while(m_bUIThreadActive) {
+        size_t nImgCount = 0, nIdx = 0;
+        {
+            std::mutex_lock_guard oLock(m_oSnapshotMutex);
+            if(m_bSnapshotPending) {
+                std::swap(aoImgs,m_aoSnapshotImgs); // old buffers are handed back for the next snapshot
+                nImgCount = m_nSnapshotImgCount;
+                nIdx = m_nSnapshotIdx;
+                m_bSnapshotPending = false;
+            }
+        }
+        if(nImgCount==1)
+            cv::imshow(m_sDisplayName,render(aoImgs[0],nIdx));
+        else if(nImgCount==3)
+            cv::imshow(m_sDisplayName,render(aoImgs[0],aoImgs[1],aoImgs[2],nIdx));
+        int nKeyPressed = cv::waitKey(m_nRefreshPeriod_ms); // pumps window events & caps the refresh rate
+        if(nKeyPressed!=-1) {
+            nKeyPressed %= (UCHAR_MAX+1); // fixes return val bug in some opencv versions
+            std::mutex_lock_guard oLock(m_oSnapshotMutex);
+            m_nLastKeyPressed = nKeyPressed;
+            m_oKeyCondVar.notify_all();
+        }
+    }
+    cv::destroyWindow(m_sDisplayName);
 }
 
 int cv::DisplayHelper::waitKey(int nDefaultSleepDelay) {
     int nKeyPressed;
-    if(m_bContinuousUpdates)
-        nKeyPressed = cv::waitKey(nDefaultSleepDelay);
-    else
-        nKeyPressed = cv::waitKey(0);
-    if(nKeyPressed!=-1)
-        nKeyPressed %= (UCHAR_MAX+1); // fixes return val bug in some opencv versions
+    if(m_bAsync) {
+        // never sleeps while updates are continuous, the UI thread catches keys on its own time
+        std::mutex_unique_lock sync_lock(m_oSnapshotMutex);
+        if(!m_bContinuousUpdates)
+            m_oKeyCondVar.wait(sync_lock,[&]{return m_nLastKeyPressed!=-1;});
+        nKeyPressed = m_nLastKeyPressed;
+        m_nLastKeyPressed = -1;
+    }
+    else {
+        if(m_bContinuousUpdates)
+            nKeyPressed = cv::waitKey(nDefaultSleepDelay);
+        else
+            nKeyPressed = cv::waitKey(0);
+        if(nKeyPressed!=-1)
+            nKeyPressed %= (UCHAR_MAX+1); // fixes return val bug in some opencv versions
+    }
     if(nKeyPressed==' ')
         m_bContinuousUpdates = !m_bContinuousUpdates;
     return nKeyPressed;
@@ -163,3 +417,494 @@ void cv::DisplayHelper::onMouseEventCallback(int nEvent, int x, int y, int nFlag
 void cv::DisplayHelper::onMouseEvent(int nEvent, int x, int y, int nFlags, void* pData) {
     (*(std::function<void(int,int,int,int)>*)pData)(nEvent,x,y,nFlags);
 }
+
+void cv::writeBinary(std::ostream& oStream, const cv::Mat& oMat) {
+    lvAssert_(oMat.dims<=2,"binary serialization only supports 2D matrices");
+    lv::writeBinary(oStream,(int32_t)oMat.rows);
+    lv::writeBinary(oStream,(int32_t)oMat.cols);
+    lv::writeBinary(oStream,(int32_t)oMat.type());
+    const size_t nRowSize = oMat.cols*oMat.elemSize();
+    for(int nRowIdx=0; nRowIdx<oMat.rows; ++nRowIdx)
+        oStream.write((const char*)oMat.ptr(nRowIdx),std::streamsize(nRowSize));
+}
+
+void cv::readBinary(std::istream& oStream, cv::Mat& oMat) {
+    int32_t nRows,nCols,nType;
+    lv::readBinary(oStream,nRows);
+    lv::readBinary(oStream,nCols);
+    lv::readBinary(oStream,nType);
+    lvAssert_(nRows>=0 && nCols>=0 && nType==CV_MAT_TYPE(nType),"bad matrix header in binary stream");
+    oMat.create(nRows,nCols,nType);
+    const size_t nRowSize = oMat.cols*oMat.elemSize();
+    for(int nRowIdx=0; nRowIdx<oMat.rows; ++nRowIdx)
+        oStream.read((char*)oMat.ptr(nRowIdx),std::streamsize(nRowSize));
+    lvAssert_(oStream.good(),"failed to read matrix from binary stream (truncated data?)");
+}
+
+namespace {
+
+#if HAVE_SSE2 || HAVE_NEON
+    /// loads 4 consecutive bytes without alignment requirements
+    inline uint32_t loadPacked4(const uchar* anData) {
+        uint32_t nVal;
+        memcpy(&nVal,anData,sizeof(nVal));
+        return nVal;
+    }
+#endif //HAVE_SSE2 || HAVE_NEON
+
+    /// rolling average kernel for a single row of nElems elements (nChannels per pixel), with fused updates of all nMaps maps
+    template<typename TInput>
+    void updateRollingAverageRow(float** apfMaps, ushort** apnMaps, const float* afFactors, const float* afInputFactors, size_t nMaps,
+                                 const TInput* aInput, const uchar* anMask, size_t nElems, size_t nChannels) {
+        size_t nElemIdx = 0;
+#if HAVE_SSE2 || HAVE_NEON
+        // float maps are updated 4 elements at a time (mask lanes are only contiguous in per-pixel order for single-channel data)
+        if(std::is_same<TInput,uchar>::value && (!anMask || nChannels==1)) {
+            bool bAllFloatMaps = true;
+            for(size_t nMapIdx=0; nMapIdx<nMaps; ++nMapIdx)
+                bAllFloatMaps &= (apfMaps[nMapIdx]!=nullptr);
+            if(bAllFloatMaps) {
+                for(; nElemIdx+4<=nElems; nElemIdx+=4) {
+                    const uchar* anCurrInput = (const uchar*)aInput+nElemIdx;
+#if HAVE_NEON
+                    const float32x4_t vfInput = vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(vcreate_u8((uint64_t)loadPacked4(anCurrInput))))));
+                    const uint32x4_t vbMask = anMask?vtstq_u32(vmovl_u16(vget_low_u16(vmovl_u8(vcreate_u8((uint64_t)loadPacked4(anMask+nElemIdx))))),vdupq_n_u32(0xFF)):vdupq_n_u32(0xFFFFFFFF);
+                    for(size_t nMapIdx=0; nMapIdx<nMaps; ++nMapIdx) {
+                        const float32x4_t vfOld = vld1q_f32(apfMaps[nMapIdx]+nElemIdx);
+                        const float32x4_t vfNew = vmlaq_f32(vmulq_n_f32(vfOld,1.0f-afFactors[nMapIdx]),vfInput,vdupq_n_f32(afInputFactors[nMapIdx]));
+                        vst1q_f32(apfMaps[nMapIdx]+nElemIdx,vbslq_f32(vbMask,vfNew,vfOld));
+                    }
+#else //HAVE_SSE2
+                    const __m128i vnZero = _mm_setzero_si128();
+                    const __m128 vfInput = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)loadPacked4(anCurrInput)),vnZero),vnZero));
+                    const __m128 vbMask = anMask?_mm_castsi128_ps(_mm_cmpgt_epi32(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)loadPacked4(anMask+nElemIdx)),vnZero),vnZero),vnZero)):_mm_castsi128_ps(_mm_set1_epi32(-1));
+                    for(size_t nMapIdx=0; nMapIdx<nMaps; ++nMapIdx) {
+                        const __m128 vfOld = _mm_loadu_ps(apfMaps[nMapIdx]+nElemIdx);
+                        const __m128 vfNew = _mm_add_ps(_mm_mul_ps(vfOld,_mm_set1_ps(1.0f-afFactors[nMapIdx])),_mm_mul_ps(vfInput,_mm_set1_ps(afInputFactors[nMapIdx])));
+                        _mm_storeu_ps(apfMaps[nMapIdx]+nElemIdx,_mm_or_ps(_mm_and_ps(vbMask,vfNew),_mm_andnot_ps(vbMask,vfOld)));
+                    }
+#endif //HAVE_SSE2
+                }
+            }
+        }
+#endif //HAVE_SSE2 || HAVE_NEON
+        for(; nElemIdx<nElems; ++nElemIdx) {
+            if(anMask && !anMask[nElemIdx/nChannels])
+                continue;
+            const float fInput = (float)aInput[nElemIdx];
+            for(size_t nMapIdx=0; nMapIdx<nMaps; ++nMapIdx) {
+                if(apfMaps[nMapIdx])
+                    apfMaps[nMapIdx][nElemIdx] = apfMaps[nMapIdx][nElemIdx]*(1.0f-afFactors[nMapIdx])+fInput*afInputFactors[nMapIdx];
+                else
+                    apnMaps[nMapIdx][nElemIdx] = cv::saturate_cast<ushort>(apnMaps[nMapIdx][nElemIdx]*(1.0f-afFactors[nMapIdx])+fInput*afInputFactors[nMapIdx]);
+            }
+        }
+    }
+
+} // anonymous namespace
+
+void lv::updateRollingAverages(std::initializer_list<cv::Mat*> lpMaps, std::initializer_list<float> lfFactors, const cv::Mat& oInput,
+                               const cv::Mat& oMask, std::initializer_list<float> lfInputScales) {
+    const size_t nMaps = lpMaps.size();
+    lvAssert_(nMaps>0 && nMaps<=s_nMaxRollingAverageMaps,"bad moving average map count");
+    lvAssert_(lfFactors.size()==nMaps && (lfInputScales.size()==0 || lfInputScales.size()==nMaps),"factor/scale count must match map count");
+    lvAssert_(!oInput.empty() && (oInput.depth()==CV_8U || oInput.depth()==CV_16U || oInput.depth()==CV_32F),"input must be non-empty, and of depth 8U, 16U or 32F");
+    lvAssert_(oMask.empty() || (oMask.type()==CV_8UC1 && oMask.size()==oInput.size()),"mask must be empty, or 8UC1 and of the same size as the input");
+    std::array<float,s_nMaxRollingAverageMaps> afFactors,afInputFactors;
+    std::array<cv::Mat*,s_nMaxRollingAverageMaps> apMaps;
+    for(size_t nMapIdx=0; nMapIdx<nMaps; ++nMapIdx) {
+        apMaps[nMapIdx] = *(lpMaps.begin()+nMapIdx);
+        lvAssert_(apMaps[nMapIdx] && apMaps[nMapIdx]->size()==oInput.size() && apMaps[nMapIdx]->channels()==oInput.channels(),"maps must be of the same size & channel count as the input");
+        lvAssert_(apMaps[nMapIdx]->depth()==CV_32F || apMaps[nMapIdx]->depth()==CV_16U,"maps must be of depth 32F or 16U");
+        afFactors[nMapIdx] = *(lfFactors.begin()+nMapIdx);
+        afInputFactors[nMapIdx] = afFactors[nMapIdx]*(lfInputScales.size()?*(lfInputScales.begin()+nMapIdx):1.0f);
+    }
+    const size_t nChannels = (size_t)oInput.channels(), nElems = (size_t)oInput.cols*nChannels;
+    std::array<float*,s_nMaxRollingAverageMaps> apfMaps;
+    std::array<ushort*,s_nMaxRollingAverageMaps> apnMaps;
+    for(int nRowIdx=0; nRowIdx<oInput.rows; ++nRowIdx) {
+        for(size_t nMapIdx=0; nMapIdx<nMaps; ++nMapIdx) {
+            const bool bFloatMap = apMaps[nMapIdx]->depth()==CV_32F;
+            apfMaps[nMapIdx] = bFloatMap?apMaps[nMapIdx]->ptr<float>(nRowIdx):nullptr;
+            apnMaps[nMapIdx] = bFloatMap?nullptr:apMaps[nMapIdx]->ptr<ushort>(nRowIdx);
+        }
+        const uchar* anMask = oMask.empty()?nullptr:oMask.ptr<uchar>(nRowIdx);
+        if(oInput.depth()==CV_8U)
+            updateRollingAverageRow(apfMaps.data(),apnMaps.data(),afFactors.data(),afInputFactors.data(),nMaps,oInput.ptr<uchar>(nRowIdx),anMask,nElems,nChannels);
+        else if(oInput.depth()==CV_16U)
+            updateRollingAverageRow(apfMaps.data(),apnMaps.data(),afFactors.data(),afInputFactors.data(),nMaps,oInput.ptr<ushort>(nRowIdx),anMask,nElems,nChannels);
+        else
+            updateRollingAverageRow(apfMaps.data(),apnMaps.data(),afFactors.data(),afInputFactors.data(),nMaps,oInput.ptr<float>(nRowIdx),anMask,nElems,nChannels);
+    }
+}
+
+namespace {
+
+    /// adds the positive flags (>=128) of a row to the binary median column counts, and optionally removes those of another row
+    inline void updateBinaryMedianColCounts(ushort* anColCounts, const uchar* anAddRow, const uchar* anSubRow, size_t nCols) {
+        size_t nColIdx = 0;
+#if HAVE_NEON
+        for(; nColIdx+16<=nCols; nColIdx+=16) {
+            const uint8x16_t anAddFlags = vshrq_n_u8(vld1q_u8(anAddRow+nColIdx),7);
+            const uint8x16_t anSubFlags = anSubRow?vshrq_n_u8(vld1q_u8(anSubRow+nColIdx),7):vdupq_n_u8(0);
+            vst1q_u16(anColCounts+nColIdx,vsubw_u8(vaddw_u8(vld1q_u16(anColCounts+nColIdx),vget_low_u8(anAddFlags)),vget_low_u8(anSubFlags)));
+            vst1q_u16(anColCounts+nColIdx+8,vsubw_u8(vaddw_u8(vld1q_u16(anColCounts+nColIdx+8),vget_high_u8(anAddFlags)),vget_high_u8(anSubFlags)));
+        }
+#elif HAVE_SSE2
+        const __m128i anZero = _mm_setzero_si128(), anOnes = _mm_set1_epi8(1);
+        for(; nColIdx+16<=nCols; nColIdx+=16) {
+            const __m128i anAddFlags = _mm_and_si128(_mm_srli_epi16(_mm_loadu_si128((const __m128i*)(anAddRow+nColIdx)),7),anOnes);
+            const __m128i anSubFlags = anSubRow?_mm_and_si128(_mm_srli_epi16(_mm_loadu_si128((const __m128i*)(anSubRow+nColIdx)),7),anOnes):anZero;
+            __m128i* pCounts = (__m128i*)(anColCounts+nColIdx);
+            _mm_storeu_si128(pCounts,_mm_sub_epi16(_mm_add_epi16(_mm_loadu_si128(pCounts),_mm_unpacklo_epi8(anAddFlags,anZero)),_mm_unpacklo_epi8(anSubFlags,anZero)));
+            _mm_storeu_si128(pCounts+1,_mm_sub_epi16(_mm_add_epi16(_mm_loadu_si128(pCounts+1),_mm_unpackhi_epi8(anAddFlags,anZero)),_mm_unpackhi_epi8(anSubFlags,anZero)));
+        }
+#endif //HAVE_SSE2
+        for(; nColIdx<nCols; ++nColIdx)
+            anColCounts[nColIdx] = ushort(anColCounts[nColIdx]+(anAddRow[nColIdx]>>7)-(anSubRow?(anSubRow[nColIdx]>>7):0));
+    }
+
+} // anonymous namespace
+
+void lv::binaryMedianBlur(const cv::Mat& oInput, cv::Mat& oOutput, int nKernelSize) {
+    lvAssert_(!oInput.empty() && oInput.type()==CV_8UC1,"input must be a non-empty 8UC1 binary mask");
+    lvAssert_(nKernelSize>0 && (nKernelSize%2)==1 && nKernelSize<=(int)USHRT_MAX,"kernel size must be a positive odd value");
+    if(nKernelSize==1) {
+        oInput.copyTo(oOutput);
+        return;
+    }
+    // rows above the current one are still read once written, so in-place calls work on a copy of the input
+    const cv::Mat oSrc = (oInput.data==oOutput.data)?oInput.clone():oInput;
+    oOutput.create(oSrc.size(),CV_8UC1);
+    const int nRows = oSrc.rows, nCols = oSrc.cols, nHalfKernelSize = nKernelSize/2;
+    const int nMajorityCount = (nKernelSize*nKernelSize)/2;
+    const auto lClampRow = [&](int nRowIdx) {return oSrc.ptr<uchar>(std::min(std::max(nRowIdx,0),nRows-1));};
+    // column counts are padded on both sides with replicated border values, so the row pass needs no clamping
+    std::vector<ushort> vnColCounts(size_t(nCols+nHalfKernelSize*2),ushort(0));
+    ushort* anColCounts = vnColCounts.data()+nHalfKernelSize;
+    for(int nRowOffset=-nHalfKernelSize; nRowOffset<=nHalfKernelSize; ++nRowOffset)
+        updateBinaryMedianColCounts(anColCounts,lClampRow(nRowOffset),nullptr,size_t(nCols));
+    for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
+        std::fill(vnColCounts.begin(),vnColCounts.begin()+nHalfKernelSize,anColCounts[0]);
+        std::fill(vnColCounts.end()-nHalfKernelSize,vnColCounts.end(),anColCounts[nCols-1]);
+        uchar* anOutput = oOutput.ptr<uchar>(nRowIdx);
+        int nBoxCount = 0;
+        for(int nColOffset=0; nColOffset<nKernelSize; ++nColOffset)
+            nBoxCount += vnColCounts[nColOffset];
+        for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
+            anOutput[nColIdx] = (nBoxCount>nMajorityCount)?UCHAR_MAX:uchar(0);
+            if(nColIdx<nCols-1)
+                nBoxCount += int(vnColCounts[nColIdx+nKernelSize])-int(vnColCounts[nColIdx]);
+        }
+        if(nRowIdx<nRows-1)
+            updateBinaryMedianColCounts(anColCounts,lClampRow(nRowIdx+1+nHalfKernelSize),lClampRow(nRowIdx-nHalfKernelSize),size_t(nCols));
+    }
+}
+
+namespace {
+
+    /// packs 64 consecutive bytes into a 64-bit word (LSB-first), where non-zero bytes become set bits
+    inline uint64_t packBinaryMaskWord(const uchar* anData) {
+#if HAVE_NEON
+        alignas(16) static const uchar s_anBitWeights[16] = {1,2,4,8,16,32,64,128,1,2,4,8,16,32,64,128};
+        const uint8x16_t anBitWeights = vld1q_u8(s_anBitWeights);
+        uint64_t nWord = 0;
+        for(size_t nBlockIdx=0; nBlockIdx<4; ++nBlockIdx) {
+            const uint8x16_t anVals = vld1q_u8(anData+nBlockIdx*16);
+            const uint8x16_t anBits = vandq_u8(vtstq_u8(anVals,anVals),anBitWeights);
+            uint8x8_t anSums = vpadd_u8(vget_low_u8(anBits),vget_high_u8(anBits));
+            anSums = vpadd_u8(anSums,anSums);
+            anSums = vpadd_u8(anSums,anSums);
+            nWord |= uint64_t(vget_lane_u16(vreinterpret_u16_u8(anSums),0))<<(nBlockIdx*16);
+        }
+        return nWord;
+#elif HAVE_SSE2
+        const __m128i anZero = _mm_setzero_si128();
+        uint64_t nWord = 0;
+        for(size_t nBlockIdx=0; nBlockIdx<4; ++nBlockIdx)
+            nWord |= uint64_t(uint16_t(~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(anData+nBlockIdx*16)),anZero))))<<(nBlockIdx*16);
+        return nWord;
+#else //(!HAVE_NEON && !HAVE_SSE2)
+        uint64_t nWord = 0;
+        for(size_t nBitIdx=0; nBitIdx<64; ++nBitIdx)
+            nWord |= uint64_t(anData[nBitIdx]!=0)<<nBitIdx;
+        return nWord;
+#endif //(!HAVE_NEON && !HAVE_SSE2)
+    }
+
+} // anonymous namespace
+
+void lv::PackedBinaryMask::create(const cv::Size& oSize) {
+    lvAssert_(oSize.width>=0 && oSize.height>=0,"bad mask size");
+    m_oSize = oSize;
+    m_vnWords.assign((size_t(oSize.area())+63)/64,uint64_t(0));
+}
+
+void lv::PackedBinaryMask::pack(const cv::Mat& oMask) {
+    lvAssert_(oMask.empty() || (oMask.dims==2 && oMask.type()==CV_8UC1),"binary masks must be of type 8UC1");
+    const cv::Mat oContMask = oMask.isContinuous()?oMask:oMask.clone();
+    if(m_oSize!=oContMask.size() || m_vnWords.size()!=(size_t(oContMask.total())+63)/64) {
+        m_oSize = oContMask.size();
+        m_vnWords.resize((size_t(oContMask.total())+63)/64);
+    }
+    const size_t nTotPxCount = oContMask.total();
+    const size_t nFullWords = nTotPxCount/64;
+    for(size_t nWordIdx=0; nWordIdx<nFullWords; ++nWordIdx)
+        m_vnWords[nWordIdx] = packBinaryMaskWord(oContMask.data+nWordIdx*64);
+    if(nFullWords<m_vnWords.size()) {
+        uint64_t nWord = 0;
+        for(size_t nPxIdx=nFullWords*64; nPxIdx<nTotPxCount; ++nPxIdx)
+            nWord |= uint64_t(oContMask.data[nPxIdx]!=0)<<(nPxIdx%64);
+        m_vnWords[nFullWords] = nWord;
+    }
+}
+
+void lv::PackedBinaryMask::unpack(cv::Mat& oMask, uchar nPositiveVal) const {
+    oMask.create(m_oSize,CV_8UC1);
+    lvDbgAssert(oMask.isContinuous());
+    const size_t nTotPxCount = size_t(m_oSize.area());
+    for(size_t nWordIdx=0; nWordIdx<m_vnWords.size(); ++nWordIdx) {
+        const uint64_t nWord = m_vnWords[nWordIdx];
+        uchar* const anData = oMask.data+nWordIdx*64;
+        const size_t nBits = std::min(nTotPxCount-nWordIdx*64,size_t(64));
+        if(nWord==0)
+            std::fill_n(anData,nBits,uchar(0));
+        else if(nWord==~uint64_t(0))
+            std::fill_n(anData,nBits,nPositiveVal);
+        else
+            for(size_t nBitIdx=0; nBitIdx<nBits; ++nBitIdx)
+                anData[nBitIdx] = ((nWord>>nBitIdx)&1)?nPositiveVal:uchar(0);
+    }
+}
+
+size_t lv::PackedBinaryMask::countNonZero() const {
+    size_t nCount = 0;
+    for(const uint64_t nWord : m_vnWords)
+        nCount += lv::popcount(nWord);
+    return nCount;
+}
+
+lv::PackedBinaryMask& lv::PackedBinaryMask::operator&=(const PackedBinaryMask& oMask) {
+    lvAssert_(oMask.m_oSize==m_oSize,"mask sizes must match");
+    for(size_t nWordIdx=0; nWordIdx<m_vnWords.size(); ++nWordIdx)
+        m_vnWords[nWordIdx] &= oMask.m_vnWords[nWordIdx];
+    return *this;
+}
+
+lv::PackedBinaryMask& lv::PackedBinaryMask::operator|=(const PackedBinaryMask& oMask) {
+    lvAssert_(oMask.m_oSize==m_oSize,"mask sizes must match");
+    for(size_t nWordIdx=0; nWordIdx<m_vnWords.size(); ++nWordIdx)
+        m_vnWords[nWordIdx] |= oMask.m_vnWords[nWordIdx];
+    return *this;
+}
+
+lv::PackedBinaryMask& lv::PackedBinaryMask::operator^=(const PackedBinaryMask& oMask) {
+    lvAssert_(oMask.m_oSize==m_oSize,"mask sizes must match");
+    for(size_t nWordIdx=0; nWordIdx<m_vnWords.size(); ++nWordIdx)
+        m_vnWords[nWordIdx] ^= oMask.m_vnWords[nWordIdx];
+    return *this;
+}
+
+void lv::PackedBinaryRows::create(const cv::Size& oSize) {
+    lvAssert_(oSize.width>=0 && oSize.height>=0,"bad mask size");
+    m_oSize = oSize;
+    m_nRowWords = (size_t(oSize.width)+63)/64;
+    m_vnWords.assign(m_nRowWords*size_t(oSize.height),uint64_t(0));
+}
+
+void lv::PackedBinaryRows::pack(const cv::Mat& oMask) {
+    lvAssert_(oMask.empty() || (oMask.dims==2 && oMask.type()==CV_8UC1),"binary masks must be of type 8UC1");
+    if(m_oSize!=oMask.size() || m_vnWords.size()!=m_nRowWords*size_t(oMask.rows))
+        create(oMask.size());
+    const size_t nFullWords = size_t(m_oSize.width)/64;
+    for(int nRowIdx=0; nRowIdx<m_oSize.height; ++nRowIdx) {
+        const uchar* const anData = oMask.ptr<uchar>(nRowIdx);
+        uint64_t* const anWords = row(nRowIdx);
+        for(size_t nWordIdx=0; nWordIdx<nFullWords; ++nWordIdx)
+            anWords[nWordIdx] = packBinaryMaskWord(anData+nWordIdx*64);
+        if(nFullWords<m_nRowWords) {
+            uint64_t nWord = 0;
+            for(size_t nColIdx=nFullWords*64; nColIdx<size_t(m_oSize.width); ++nColIdx)
+                nWord |= uint64_t(anData[nColIdx]!=0)<<(nColIdx%64);
+            anWords[nFullWords] = nWord;
+        }
+    }
+}
+
+void lv::PackedBinaryRows::unpack(cv::Mat& oMask, uchar nPositiveVal) const {
+    oMask.create(m_oSize,CV_8UC1);
+    for(int nRowIdx=0; nRowIdx<m_oSize.height; ++nRowIdx) {
+        uchar* const anData = oMask.ptr<uchar>(nRowIdx);
+        const uint64_t* const anWords = row(nRowIdx);
+        for(size_t nWordIdx=0; nWordIdx<m_nRowWords; ++nWordIdx) {
+            const uint64_t nWord = anWords[nWordIdx];
+            uchar* const anWordData = anData+nWordIdx*64;
+            const size_t nBits = std::min(size_t(m_oSize.width)-nWordIdx*64,size_t(64));
+            if(nWord==0)
+                std::fill_n(anWordData,nBits,uchar(0));
+            else if(nWord==~uint64_t(0))
+                std::fill_n(anWordData,nBits,nPositiveVal);
+            else
+                for(size_t nBitIdx=0; nBitIdx<nBits; ++nBitIdx)
+                    anWordData[nBitIdx] = ((nWord>>nBitIdx)&1)?nPositiveVal:uchar(0);
+        }
+    }
+}
+
+size_t lv::PackedBinaryRows::countNonZero() const {
+    size_t nCount = 0;
+    for(const uint64_t nWord : m_vnWords)
+        nCount += lv::popcount(nWord);
+    return nCount;
+}
+
+namespace {
+
+    /// runs nIters 3x3 square erosions (bErode=true) or dilations (bErode=false) on bit-packed rows; each pass ANDs/ORs the row with its
+    /// one-pixel shifts (carrying the edge bits of neighboring words), then combines each row with its upper & lower neighbors
+    template<bool bErode>
+    void packedMorph3x3(const lv::PackedBinaryRows& oInput, lv::PackedBinaryRows& oOutput, int nIters) {
+        lvAssert_(nIters>=0,"iteration count must be non-negative");
+        if(&oOutput!=&oInput)
+            oOutput = oInput;
+        if(oOutput.empty() || nIters==0)
+            return;
+        const int nRows = oOutput.size().height;
+        const size_t nRowWords = oOutput.getRowWordCount();
+        const uint64_t nLastWordMask = oOutput.getLastWordMask();
+        // out-of-bounds pixels (including row padding bits) act as set pixels for erosions, and as cleared ones for dilations
+        const uint64_t nBorderWord = bErode?~uint64_t(0):uint64_t(0);
+        std::vector<uint64_t> vnHorizWords(nRowWords*size_t(nRows));
+        for(int nIter=0; nIter<nIters; ++nIter) {
+            for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
+                const uint64_t* const anRow = oOutput.row(nRowIdx);
+                uint64_t* const anHoriz = vnHorizWords.data()+size_t(nRowIdx)*nRowWords;
+                for(size_t nWordIdx=0; nWordIdx<nRowWords; ++nWordIdx) {
+                    const bool bLastWord = (nWordIdx+1==nRowWords);
+                    const uint64_t nCurr = bLastWord?((anRow[nWordIdx]&nLastWordMask)|(nBorderWord&~nLastWordMask)):anRow[nWordIdx];
+                    const uint64_t nPrev = (nWordIdx>0)?anRow[nWordIdx-1]:nBorderWord;
+                    const uint64_t nNext = bLastWord?nBorderWord:anRow[nWordIdx+1];
+                    const uint64_t nLeft = (nCurr<<1)|(nPrev>>63), nRight = (nCurr>>1)|(nNext<<63);
+                    anHoriz[nWordIdx] = bErode?(nCurr&nLeft&nRight):(nCurr|nLeft|nRight);
+                }
+            }
+            for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
+                const uint64_t* const anHoriz = vnHorizWords.data()+size_t(nRowIdx)*nRowWords;
+                const uint64_t* const anHorizAbove = (nRowIdx>0)?anHoriz-nRowWords:anHoriz;
+                const uint64_t* const anHorizBelow = (nRowIdx+1<nRows)?anHoriz+nRowWords:anHoriz;
+                uint64_t* const anRow = oOutput.row(nRowIdx);
+                for(size_t nWordIdx=0; nWordIdx<nRowWords; ++nWordIdx)
+                    anRow[nWordIdx] = bErode?(anHoriz[nWordIdx]&anHorizAbove[nWordIdx]&anHorizBelow[nWordIdx]):(anHoriz[nWordIdx]|anHorizAbove[nWordIdx]|anHorizBelow[nWordIdx]);
+                anRow[nRowWords-1] &= nLastWordMask;
+            }
+        }
+    }
+
+    /// propagates the set bits of nSeeds towards higher bit indexes through the contiguous set bits of nFree (parallel-prefix occluded fill)
+    inline uint64_t fillRunsUp(uint64_t nSeeds, uint64_t nFree) {
+        nSeeds |= nFree&(nSeeds<<1); nFree &= nFree<<1;
+        nSeeds |= nFree&(nSeeds<<2); nFree &= nFree<<2;
+        nSeeds |= nFree&(nSeeds<<4); nFree &= nFree<<4;
+        nSeeds |= nFree&(nSeeds<<8); nFree &= nFree<<8;
+        nSeeds |= nFree&(nSeeds<<16); nFree &= nFree<<16;
+        return nSeeds|(nFree&(nSeeds<<32));
+    }
+
+    /// propagates the set bits of nSeeds towards lower bit indexes through the contiguous set bits of nFree (parallel-prefix occluded fill)
+    inline uint64_t fillRunsDown(uint64_t nSeeds, uint64_t nFree) {
+        nSeeds |= nFree&(nSeeds>>1); nFree &= nFree>>1;
+        nSeeds |= nFree&(nSeeds>>2); nFree &= nFree>>2;
+        nSeeds |= nFree&(nSeeds>>4); nFree &= nFree>>4;
+        nSeeds |= nFree&(nSeeds>>8); nFree &= nFree>>8;
+        nSeeds |= nFree&(nSeeds>>16); nFree &= nFree>>16;
+        return nSeeds|(nFree&(nSeeds>>32));
+    }
+
+} // anonymous namespace
+
+void lv::binaryErode(const PackedBinaryRows& oInput, PackedBinaryRows& oOutput, int nIters) {
+    packedMorph3x3<true>(oInput,oOutput,nIters);
+}
+
+void lv::binaryDilate(const PackedBinaryRows& oInput, PackedBinaryRows& oOutput, int nIters) {
+    packedMorph3x3<false>(oInput,oOutput,nIters);
+}
+
+void lv::binaryFloodFill(PackedBinaryRows& oMask, const cv::Point& oSeed) {
+    lvAssert_(!oMask.empty() && oSeed.x>=0 && oSeed.y>=0 && oSeed.x<oMask.size().width && oSeed.y<oMask.size().height,"seed must be inside a non-empty mask");
+    if(oMask.get(oSeed.y,oSeed.x))
+        return;
+    const int nRows = oMask.size().height;
+    const size_t nRowWords = oMask.getRowWordCount();
+    const uint64_t nLastWordMask = oMask.getLastWordMask();
+    std::vector<uint64_t> vnReachedWords(nRowWords*size_t(nRows),uint64_t(0)), vnSeedWords(nRowWords), vnInitSeedWords(nRowWords,uint64_t(0));
+    vnInitSeedWords[size_t(oSeed.x/64)] = uint64_t(1)<<(oSeed.x%64);
+    // each row gets its reached runs filled from its own & neighboring reached bits; rows are swept downwards then upwards until no run grows
+    const auto lFillRow = [&](int nRowIdx, const uint64_t* anNeighbReached) {
+        const uint64_t* const anMask = oMask.row(nRowIdx);
+        uint64_t* const anReached = vnReachedWords.data()+size_t(nRowIdx)*nRowWords;
+        bool bChanged = false;
+        for(size_t nWordIdx=0; nWordIdx<nRowWords; ++nWordIdx) {
+            const uint64_t nFree = ~anMask[nWordIdx]&((nWordIdx+1==nRowWords)?nLastWordMask:~uint64_t(0));
+            vnSeedWords[nWordIdx] = (anReached[nWordIdx]|(anNeighbReached?anNeighbReached[nWordIdx]:0))&nFree;
+            if(vnSeedWords[nWordIdx]==anReached[nWordIdx])
+                continue;
+            bChanged = true;
+        }
+        if(!bChanged)
+            return false;
+        // runs spanning several words are filled upwards then downwards, carrying the edge bits across words
+        uint64_t nCarry = 0;
+        for(size_t nWordIdx=0; nWordIdx<nRowWords; ++nWordIdx) {
+            const uint64_t nFree = ~anMask[nWordIdx]&((nWordIdx+1==nRowWords)?nLastWordMask:~uint64_t(0));
+            vnSeedWords[nWordIdx] = fillRunsUp(vnSeedWords[nWordIdx]|(nCarry&nFree),nFree);
+            nCarry = vnSeedWords[nWordIdx]>>63;
+        }
+        nCarry = 0;
+        for(size_t nWordIdx=nRowWords; nWordIdx>0; --nWordIdx) {
+            const uint64_t nFree = ~anMask[nWordIdx-1]&((nWordIdx==nRowWords)?nLastWordMask:~uint64_t(0));
+            vnSeedWords[nWordIdx-1] = fillRunsDown(vnSeedWords[nWordIdx-1]|((nCarry<<63)&nFree),nFree);
+            nCarry = vnSeedWords[nWordIdx-1]&1;
+        }
+        std::copy_n(vnSeedWords.data(),nRowWords,anReached);
+        return true;
+    };
+    lFillRow(oSeed.y,vnInitSeedWords.data());
+    for(bool bChanged=true; bChanged;) {
+        bChanged = false;
+        for(int nRowIdx=1; nRowIdx<nRows; ++nRowIdx)
+            bChanged |= lFillRow(nRowIdx,vnReachedWords.data()+size_t(nRowIdx-1)*nRowWords);
+        for(int nRowIdx=nRows-2; nRowIdx>=0; --nRowIdx)
+            bChanged |= lFillRow(nRowIdx,vnReachedWords.data()+size_t(nRowIdx+1)*nRowWords);
+    }
+    for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
+        uint64_t* const anMask = oMask.row(nRowIdx);
+        const uint64_t* const anReached = vnReachedWords.data()+size_t(nRowIdx)*nRowWords;
+        for(size_t nWordIdx=0; nWordIdx<nRowWords; ++nWordIdx)
+            anMask[nWordIdx] |= anReached[nWordIdx];
+    }
+}
+
+void lv::binaryErode(const cv::Mat& oInput, cv::Mat& oOutput, int nIters) {
+    lvAssert_(!oInput.empty() && oInput.type()==CV_8UC1,"input must be a non-empty 8UC1 binary mask");
+    thread_local PackedBinaryRows s_oPackedMask; // per-thread buffer, reused across calls
+    s_oPackedMask.pack(oInput);
+    binaryErode(s_oPackedMask,s_oPackedMask,nIters);
+    s_oPackedMask.unpack(oOutput);
+}
+
+void lv::binaryDilate(const cv::Mat& oInput, cv::Mat& oOutput, int nIters) {
+    lvAssert_(!oInput.empty() && oInput.type()==CV_8UC1,"input must be a non-empty 8UC1 binary mask");
+    thread_local PackedBinaryRows s_oPackedMask; // per-thread buffer, reused across calls
+    s_oPackedMask.pack(oInput);
+    binaryDilate(s_oPackedMask,s_oPackedMask,nIters);
+    s_oPackedMask.unpack(oOutput);
+}
+
+void lv::binaryFloodFill(cv::Mat& oMask, const cv::Point& oSeed) {
+    lvAssert_(!oMask.empty() && oMask.type()==CV_8UC1,"mask must be a non-empty 8UC1 binary mask");
+    thread_local PackedBinaryRows s_oPackedMask; // per-thread buffer, reused across calls
+    s_oPackedMask.pack(oMask);
+    binaryFloodFill(s_oPackedMask,oSeed);
+    s_oPackedMask.unpack(oMask);
+}
@@ -0,0 +1,434 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/utils/opengl-compute.hpp"
+
+namespace {
+
+    /// max workgroup count used by grid-stride primitives (the guaranteed minimum for all dims)
+    constexpr size_t s_nMaxWorkGroupCount = 65535;
+
+    /// scratch buffer pool slots
+    enum ScratchBufferList {
+        ScratchBuffer_CompactFlags,
+        nScratchBuffersCount,
+    };
+
+    inline const char* getReductionOpSource(GLComputePrimitives::ReductionOpList eOp) {
+        switch(eOp) {
+            case GLComputePrimitives::ReductionOp_Sum: return "#define reduce_op(a,b) ((a)+(b))\n#define reduce_identity 0u\n#define reduce_atomic atomicAdd\n";
+            case GLComputePrimitives::ReductionOp_Min: return "#define reduce_op(a,b) min(a,b)\n#define reduce_identity 0xFFFFFFFFu\n#define reduce_atomic atomicMin\n";
+            case GLComputePrimitives::ReductionOp_Max: return "#define reduce_op(a,b) max(a,b)\n#define reduce_identity 0u\n#define reduce_atomic atomicMax\n";
+            default: lvError("unknown reduction op"); return nullptr;
+        }
+    }
+
+    inline GLuint getReductionIdentity(GLComputePrimitives::ReductionOpList eOp) {
+        return (eOp==GLComputePrimitives::ReductionOp_Min)?0xFFFFFFFFu:0u;
+    }
+
+    /// base source for all 2D image primitives (image input bound to the default input binding, one invocation per pixel)
+    std::string getImageProcSourceHeader(GLenum eInternalFormat) {
+        lvAssert(lv::gl::isInternalFormatIntegral(eInternalFormat));
+        std::stringstream ssSrc;
+        ssSrc << "#version 430\n"
+                 "#define nInvocations " << GLCOMPUTE_DEFAULT_WORKGROUP_SIZE_2D*GLCOMPUTE_DEFAULT_WORKGROUP_SIZE_2D << "\n"
+                 "layout(local_size_x=" << GLCOMPUTE_DEFAULT_WORKGROUP_SIZE_2D << ",local_size_y=" << GLCOMPUTE_DEFAULT_WORKGROUP_SIZE_2D << ") in;\n"
+                 "layout(binding=" << GLTexture::DefaultImage_InputBinding << ", " << lv::gl::getGLSLFormatNameFromInternalFormat(eInternalFormat) << ") readonly uniform uimage2D imgInput;\n";
+        return ssSrc.str();
+    }
+
+    inline glm::uvec3 getImageProcDispatchSize(const GLTexture2D& oInput) {
+        return glm::uvec3((GLuint)ceil((float)oInput.m_nWidth/GLCOMPUTE_DEFAULT_WORKGROUP_SIZE_2D),(GLuint)ceil((float)oInput.m_nHeight/GLCOMPUTE_DEFAULT_WORKGROUP_SIZE_2D),1);
+    }
+
+} // anonymous namespace
+
+GLShaderStorageBuffer::GLShaderStorageBuffer(size_t nByteSize, const GLvoid* pInitData, GLenum eBufferUsage) :
+        m_eBufferUsage(eBufferUsage),
+        m_nByteSize(nByteSize) {
+    lvAssert(m_nByteSize>0 && (m_nByteSize%4)==0);
+    glGenBuffers(1,&m_nSSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,m_nSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER,(GLsizeiptr)m_nByteSize,pInitData,m_eBufferUsage);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,0);
+    glErrorCheck;
+}
+
+GLShaderStorageBuffer::~GLShaderStorageBuffer() {
+    glDeleteBuffers(1,&m_nSSBO);
+}
+
+void GLShaderStorageBuffer::bind(GLuint nBinding) const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,nBinding,m_nSSBO);
+}
+
+bool GLShaderStorageBuffer::updateBuffer(const GLvoid* pData, size_t nByteSize, size_t nByteOffset) {
+    lvDbgAssert(pData && nByteOffset+nByteSize<=m_nByteSize);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,m_nSSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER,(GLintptr)nByteOffset,(GLsizeiptr)nByteSize,pData);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,0);
+    return glGetError()==GL_NO_ERROR;
+}
+
+bool GLShaderStorageBuffer::fetchBuffer(GLvoid* pData, size_t nByteSize, size_t nByteOffset) const {
+    lvDbgAssert(pData && nByteOffset+nByteSize<=m_nByteSize);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,m_nSSBO);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER,(GLintptr)nByteOffset,(GLsizeiptr)nByteSize,pData);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,0);
+    return glGetError()==GL_NO_ERROR;
+}
+
+void GLShaderStorageBuffer::fill(GLuint nVal) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,m_nSSBO);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER,GL_R32UI,GL_RED_INTEGER,GL_UNSIGNED_INT,&nVal);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,0);
+    glDbgErrorCheck;
+}
+
+GLComputePrimitives::GLComputePrimitives(size_t nScanRowSize, size_t nWorkGroupSize) :
+        m_nScanRowSize(nScanRowSize),
+        m_nWorkGroupSize(nWorkGroupSize),
+        m_vpScratchBuffers(nScratchBuffersCount),
+        m_oResultBuffer(sizeof(GLuint)) {
+    lvAssert(m_nScanRowSize>1 && (m_nScanRowSize&(m_nScanRowSize-1))==0);
+    lvAssert(m_nWorkGroupSize>1 && (m_nWorkGroupSize&(m_nWorkGroupSize-1))==0);
+    lvAssert(m_nWorkGroupSize<=(size_t)lv::gl::getIntegerVal<1>(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS));
+    lvAssert(m_nWorkGroupSize*2*sizeof(GLuint)<=(size_t)lv::gl::getIntegerVal<1>(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE));
+    lvAssert((size_t)lv::gl::getIntegerVal<1>(GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS)>=nBufferBindingsCount);
+}
+
+void GLComputePrimitives::scanRows(GLTexture2D& oInput, GLTexture2D& oOutput, bool bBinaryProc) {
+    lvAssert(oInput.m_nWidth==oOutput.m_nWidth && oInput.m_nHeight==oOutput.m_nHeight);
+    lvAssert(lv::gl::isInternalFormatIntegral(oOutput.m_eInternalFormat));
+    const bool bInPlace = (&oInput==&oOutput);
+    const GLuint nOutputBinding = bInPlace?GLTexture::DefaultImage_InputBinding:GLTexture::DefaultImage_OutputBinding;
+    if(bInPlace)
+        oInput.bindToImage(GLTexture::DefaultImage_InputBinding,0,GL_READ_WRITE);
+    else {
+        oInput.bindToImage(GLTexture::DefaultImage_InputBinding,0,GL_READ_ONLY);
+        oOutput.bindToImage(GLTexture::DefaultImage_OutputBinding,0,GL_WRITE_ONLY);
+    }
+    const GLuint nBlocks = (GLuint)ceil((float)oInput.m_nWidth/m_nScanRowSize);
+    dispatch(getProgram(GLShader::getComputeShaderSource_ParallelPrefixSum(m_nScanRowSize,bBinaryProc,oInput.m_eInternalFormat,GLTexture::DefaultImage_InputBinding,nOutputBinding)),glm::uvec3(nBlocks,oInput.m_nHeight,1));
+    if(nBlocks>1) {
+        // block merge runs one invocation per row in a single workgroup
+        lvAssert(oOutput.m_nHeight<=lv::gl::getIntegerVal<3>(GL_MAX_COMPUTE_WORK_GROUP_SIZE)[1]);
+        lvAssert(oOutput.m_nHeight<=lv::gl::getIntegerVal<1>(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS));
+        if(!bInPlace)
+            oOutput.bindToImage(GLTexture::DefaultImage_OutputBinding,0,GL_READ_WRITE);
+        dispatch(getProgram(GLShader::getComputeShaderSource_ParallelPrefixSum_BlockMerge(oOutput.m_nWidth,m_nScanRowSize,oOutput.m_nHeight,oOutput.m_eInternalFormat,nOutputBinding)),glm::uvec3(1,1,1));
+    }
+}
+
+void GLComputePrimitives::transpose(GLTexture2D& oInput, GLTexture2D& oOutput) {
+    lvAssert(&oInput!=&oOutput);
+    lvAssert(oInput.m_nWidth==oOutput.m_nHeight && oInput.m_nHeight==oOutput.m_nWidth);
+    lvAssert(oInput.m_eInternalFormat==oOutput.m_eInternalFormat);
+    oInput.bindToImage(GLTexture::DefaultImage_InputBinding,0,GL_READ_ONLY);
+    oOutput.bindToImage(GLTexture::DefaultImage_OutputBinding,0,GL_WRITE_ONLY);
+    const glm::uvec3 vDispatchSize((GLuint)ceil((float)oInput.m_nWidth/GLCOMPUTE_DEFAULT_TRANSPOSE_BLOCK),(GLuint)ceil((float)oInput.m_nHeight/GLCOMPUTE_DEFAULT_TRANSPOSE_BLOCK),1);
+    dispatch(getProgram(GLShader::getComputeShaderSource_Transpose(GLCOMPUTE_DEFAULT_TRANSPOSE_BLOCK,oInput.m_eInternalFormat,GLTexture::DefaultImage_InputBinding,GLTexture::DefaultImage_OutputBinding)),vDispatchSize);
+}
+
+void GLComputePrimitives::scan(const GLShaderStorageBuffer& oInput, GLShaderStorageBuffer& oOutput, size_t nCount) {
+    lvAssert(nCount>0 && nCount*sizeof(GLuint)<=oInput.size() && nCount*sizeof(GLuint)<=oOutput.size());
+    scan(oInput,oOutput,nCount,0,false);
+}
+
+void GLComputePrimitives::scan(const GLShaderStorageBuffer& oInput, GLShaderStorageBuffer& oOutput, size_t nCount, size_t nLevel, bool bFlagInput) {
+    // each workgroup scans a block of two elements per invocation in shared memory (same up/down-sweep as the image row scan),
+    // and block totals are scanned recursively before being added back to their blocks
+    const size_t nBlockSize = m_nWorkGroupSize*2;
+    const size_t nBlocks = (nCount+nBlockSize-1)/nBlockSize;
+    lvAssert(nBlocks<=s_nMaxWorkGroupCount);
+    const bool bMultiBlock = nBlocks>1;
+    std::stringstream ssSrc;
+    ssSrc << "#version 430\n"
+             "#define nInvocations " << m_nWorkGroupSize << "\n"
+             "#define nBlockSize " << nBlockSize << "\n"
+             "layout(local_size_x=nInvocations) in;\n"
+             "layout(std430,binding=" << Buffer_InputBinding << ") buffer InputBuffer {uint anInput[];};\n"
+             "layout(std430,binding=" << Buffer_OutputBinding << ") buffer OutputBuffer {uint anOutput[];};\n";
+    if(bMultiBlock) ssSrc <<
+             "layout(std430,binding=" << Buffer_AuxBinding << ") writeonly buffer BlockSumBuffer {uint anBlockSums[];};\n";
+    ssSrc << "uniform uint nCount;\n"
+             "shared uint tmp[nBlockSize];\n"
+             "uint load_input(uint idx) {\n"
+             "    return (idx<nCount)?" << (bFlagInput?"uint(anInput[idx]!=0u)":"anInput[idx]") << ":0u;\n"
+             "}\n"
+             "void main() {\n"
+             "    uint idx = gl_WorkGroupID.x*nBlockSize+gl_LocalInvocationID.x*2;\n"
+             "    tmp[gl_LocalInvocationID.x*2] = load_input(idx);\n"
+             "    tmp[gl_LocalInvocationID.x*2+1] = load_input(idx+1);\n"
+             "    uint offset = 1;\n"
+             "    for(uint depth=nInvocations; depth>0; depth>>=1) {\n"
+             "        barrier();\n"
+             "        if(gl_LocalInvocationID.x<depth) {\n"
+             "            uint idx_lower = offset*(gl_LocalInvocationID.x*2+1)-1;\n"
+             "            uint idx_upper = offset*(gl_LocalInvocationID.x*2+2)-1;\n"
+             "            tmp[idx_upper] += tmp[idx_lower];\n"
+             "        }\n"
+             "        offset <<= 1;\n"
+             "    }\n"
+             "    if(gl_LocalInvocationID.x==0) {\n";
+    if(bMultiBlock) ssSrc <<
+             "        anBlockSums[gl_WorkGroupID.x] = tmp[nBlockSize-1];\n";
+    ssSrc << "        tmp[nBlockSize-1] = 0u;\n"
+             "    }\n"
+             "    for(uint depth=1; depth<nBlockSize; depth<<=1) {\n"
+             "        offset >>= 1;\n"
+             "        barrier();\n"
+             "        if(gl_LocalInvocationID.x<depth) {\n"
+             "            uint idx_upper = offset*(gl_LocalInvocationID.x*2+1)-1;\n"
+             "            uint idx_lower = offset*(gl_LocalInvocationID.x*2+2)-1;\n"
+             "            uint swapsum = tmp[idx_upper];\n"
+             "            tmp[idx_upper] = tmp[idx_lower];\n"
+             "            tmp[idx_lower] += swapsum;\n"
+             "        }\n"
+             "    }\n"
+             "    barrier();\n"
+             "    if(idx<nCount)\n"
+             "        anOutput[idx] = tmp[gl_LocalInvocationID.x*2];\n"
+             "    if(idx+1<nCount)\n"
+             "        anOutput[idx+1] = tmp[gl_LocalInvocationID.x*2+1];\n"
+             "}\n";
+    GLShader& oBlockScanProgram = getProgram(ssSrc.str());
+    lvAssert(oBlockScanProgram.setUniform1ui("nCount",(GLuint)nCount));
+    GLShaderStorageBuffer* pBlockSums = bMultiBlock?&getScratchBuffer(m_vpScanBlockSums,nLevel,nBlocks*sizeof(GLuint)):nullptr;
+    oInput.bind(Buffer_InputBinding);
+    oOutput.bind(Buffer_OutputBinding);
+    if(bMultiBlock)
+        pBlockSums->bind(Buffer_AuxBinding);
+    dispatch(oBlockScanProgram,glm::uvec3((GLuint)nBlocks,1,1));
+    if(bMultiBlock) {
+        scan(*pBlockSums,*pBlockSums,nBlocks,nLevel+1,false);
+        std::stringstream ssAddSrc;
+        ssAddSrc << "#version 430\n"
+                    "#define nInvocations " << m_nWorkGroupSize << "\n"
+                    "#define nBlockSize " << nBlockSize << "\n"
+                    "layout(local_size_x=nInvocations) in;\n"
+                    "layout(std430,binding=" << Buffer_OutputBinding << ") buffer OutputBuffer {uint anOutput[];};\n"
+                    "layout(std430,binding=" << Buffer_AuxBinding << ") readonly buffer BlockSumBuffer {uint anBlockSums[];};\n"
+                    "uniform uint nCount;\n"
+                    "void main() {\n"
+                    "    uint idx = gl_WorkGroupID.x*nBlockSize+gl_LocalInvocationID.x;\n"
+                    "    uint offset = anBlockSums[gl_WorkGroupID.x];\n"
+                    "    if(idx<nCount)\n"
+                    "        anOutput[idx] += offset;\n"
+                    "    if(idx+nInvocations<nCount)\n"
+                    "        anOutput[idx+nInvocations] += offset;\n"
+                    "}\n";
+        GLShader& oAddProgram = getProgram(ssAddSrc.str());
+        lvAssert(oAddProgram.setUniform1ui("nCount",(GLuint)nCount));
+        oOutput.bind(Buffer_OutputBinding);
+        pBlockSums->bind(Buffer_AuxBinding);
+        dispatch(oAddProgram,glm::uvec3((GLuint)nBlocks,1,1));
+    }
+}
+
+GLuint GLComputePrimitives::reduce(const GLShaderStorageBuffer& oInput, size_t nCount, ReductionOpList eOp) {
+    lvAssert(nCount>0 && nCount*sizeof(GLuint)<=oInput.size());
+    std::stringstream ssSrc;
+    ssSrc << "#version 430\n"
+             "#define nInvocations " << m_nWorkGroupSize << "\n"
+          << getReductionOpSource(eOp) <<
+             "layout(local_size_x=nInvocations) in;\n"
+             "layout(std430,binding=" << Buffer_InputBinding << ") readonly buffer InputBuffer {uint anInput[];};\n"
+             "layout(std430,binding=" << Buffer_ResultBinding << ") buffer ResultBuffer {uint anResult[];};\n"
+             "uniform uint nCount;\n"
+             "shared uint tmp[nInvocations];\n"
+             "void main() {\n"
+             "    uint val = reduce_identity;\n"
+             "    for(uint idx=gl_GlobalInvocationID.x; idx<nCount; idx+=gl_NumWorkGroups.x*nInvocations)\n"
+             "        val = reduce_op(val,anInput[idx]);\n"
+             "    tmp[gl_LocalInvocationID.x] = val;\n"
+             "    for(uint stride=nInvocations/2; stride>0; stride>>=1) {\n"
+             "        barrier();\n"
+             "        if(gl_LocalInvocationID.x<stride)\n"
+             "            tmp[gl_LocalInvocationID.x] = reduce_op(tmp[gl_LocalInvocationID.x],tmp[gl_LocalInvocationID.x+stride]);\n"
+             "    }\n"
+             "    if(gl_LocalInvocationID.x==0)\n"
+             "        reduce_atomic(anResult[0],tmp[0]);\n"
+             "}\n";
+    GLShader& oProgram = getProgram(ssSrc.str());
+    lvAssert(oProgram.setUniform1ui("nCount",(GLuint)nCount));
+    m_oResultBuffer.fill(getReductionIdentity(eOp));
+    oInput.bind(Buffer_InputBinding);
+    m_oResultBuffer.bind(Buffer_ResultBinding);
+    dispatch(oProgram,glm::uvec3((GLuint)std::min((nCount+m_nWorkGroupSize-1)/m_nWorkGroupSize,s_nMaxWorkGroupCount),1,1));
+    GLuint nResult;
+    lvAssert(m_oResultBuffer.fetchBuffer(&nResult,sizeof(GLuint)));
+    return nResult;
+}
+
+GLuint GLComputePrimitives::reduce(GLTexture2D& oInput, ReductionOpList eOp) {
+    std::stringstream ssSrc;
+    ssSrc << getImageProcSourceHeader(oInput.m_eInternalFormat)
+          << getReductionOpSource(eOp) <<
+             "layout(std430,binding=" << Buffer_ResultBinding << ") buffer ResultBuffer {uint anResult[];};\n"
+             "shared uint tmp[nInvocations];\n"
+             "void main() {\n"
+             "    ivec2 coord = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    tmp[gl_LocalInvocationIndex] = all(lessThan(coord,imageSize(imgInput)))?imageLoad(imgInput,coord).r:reduce_identity;\n"
+             "    for(uint stride=nInvocations/2; stride>0; stride>>=1) {\n"
+             "        barrier();\n"
+             "        if(gl_LocalInvocationIndex<stride)\n"
+             "            tmp[gl_LocalInvocationIndex] = reduce_op(tmp[gl_LocalInvocationIndex],tmp[gl_LocalInvocationIndex+stride]);\n"
+             "    }\n"
+             "    if(gl_LocalInvocationIndex==0)\n"
+             "        reduce_atomic(anResult[0],tmp[0]);\n"
+             "}\n";
+    GLShader& oProgram = getProgram(ssSrc.str());
+    m_oResultBuffer.fill(getReductionIdentity(eOp));
+    oInput.bindToImage(GLTexture::DefaultImage_InputBinding,0,GL_READ_ONLY);
+    m_oResultBuffer.bind(Buffer_ResultBinding);
+    dispatch(oProgram,getImageProcDispatchSize(oInput));
+    GLuint nResult;
+    lvAssert(m_oResultBuffer.fetchBuffer(&nResult,sizeof(GLuint)));
+    return nResult;
+}
+
+void GLComputePrimitives::histogram(GLTexture2D& oInput, GLShaderStorageBuffer& oBins, size_t nBins, bool bAccumulate) {
+    lvAssert(nBins>0 && nBins*sizeof(GLuint)<=oBins.size());
+    lvAssert(nBins*sizeof(GLuint)<=(size_t)lv::gl::getIntegerVal<1>(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE));
+    // bins are first accumulated in shared memory, so global atomics are only used once per non-empty bin per workgroup
+    std::stringstream ssSrc;
+    ssSrc << getImageProcSourceHeader(oInput.m_eInternalFormat) <<
+             "#define nBins " << nBins << "\n"
+             "layout(std430,binding=" << Buffer_OutputBinding << ") buffer BinBuffer {uint anBins[];};\n"
+             "shared uint anLocalBins[nBins];\n"
+             "void main() {\n"
+             "    for(uint bin=gl_LocalInvocationIndex; bin<nBins; bin+=nInvocations)\n"
+             "        anLocalBins[bin] = 0u;\n"
+             "    barrier();\n"
+             "    ivec2 coord = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    if(all(lessThan(coord,imageSize(imgInput))))\n"
+             "        atomicAdd(anLocalBins[min(imageLoad(imgInput,coord).r,nBins-1u)],1u);\n"
+             "    barrier();\n"
+             "    for(uint bin=gl_LocalInvocationIndex; bin<nBins; bin+=nInvocations)\n"
+             "        if(anLocalBins[bin]>0u)\n"
+             "            atomicAdd(anBins[bin],anLocalBins[bin]);\n"
+             "}\n";
+    GLShader& oProgram = getProgram(ssSrc.str());
+    if(!bAccumulate)
+        oBins.fill(0u);
+    oInput.bindToImage(GLTexture::DefaultImage_InputBinding,0,GL_READ_ONLY);
+    oBins.bind(Buffer_OutputBinding);
+    dispatch(oProgram,getImageProcDispatchSize(oInput));
+}
+
+size_t GLComputePrimitives::compact(const GLShaderStorageBuffer& oInput, size_t nCount, GLShaderStorageBuffer& oOutput) {
+    lvAssert(nCount>0 && nCount*sizeof(GLuint)<=oInput.size());
+    // output positions come from an exclusive scan of the non-zero flags, so the original element order is kept
+    GLShaderStorageBuffer& oFlagScan = getScratchBuffer(m_vpScratchBuffers,ScratchBuffer_CompactFlags,nCount*sizeof(GLuint));
+    scan(oInput,oFlagScan,nCount,0,true);
+    std::stringstream ssSrc;
+    ssSrc << "#version 430\n"
+             "layout(local_size_x=" << m_nWorkGroupSize << ") in;\n"
+             "layout(std430,binding=" << Buffer_InputBinding << ") readonly buffer InputBuffer {uint anInput[];};\n"
+             "layout(std430,binding=" << Buffer_OutputBinding << ") writeonly buffer OutputBuffer {uint anOutput[];};\n"
+             "layout(std430,binding=" << Buffer_AuxBinding << ") readonly buffer FlagScanBuffer {uint anFlagScan[];};\n"
+             "layout(std430,binding=" << Buffer_ResultBinding << ") writeonly buffer ResultBuffer {uint anResult[];};\n"
+             "uniform uint nCount;\n"
+             "uniform uint nMaxCount;\n"
+             "void main() {\n"
+             "    uint idx = gl_GlobalInvocationID.x;\n"
+             "    if(idx>=nCount)\n"
+             "        return;\n"
+             "    bool valid = anInput[idx]!=0u;\n"
+             "    if(valid && anFlagScan[idx]<nMaxCount)\n"
+             "        anOutput[anFlagScan[idx]] = idx;\n"
+             "    if(idx==nCount-1)\n"
+             "        anResult[0] = anFlagScan[idx]+uint(valid);\n"
+             "}\n";
+    GLShader& oProgram = getProgram(ssSrc.str());
+    lvAssert(oProgram.setUniform1ui("nCount",(GLuint)nCount));
+    lvAssert(oProgram.setUniform1ui("nMaxCount",(GLuint)(oOutput.size()/sizeof(GLuint))));
+    const size_t nWorkGroups = (nCount+m_nWorkGroupSize-1)/m_nWorkGroupSize;
+    lvAssert(nWorkGroups<=s_nMaxWorkGroupCount);
+    oInput.bind(Buffer_InputBinding);
+    oOutput.bind(Buffer_OutputBinding);
+    oFlagScan.bind(Buffer_AuxBinding);
+    m_oResultBuffer.bind(Buffer_ResultBinding);
+    dispatch(oProgram,glm::uvec3((GLuint)nWorkGroups,1,1));
+    GLuint nResult;
+    lvAssert(m_oResultBuffer.fetchBuffer(&nResult,sizeof(GLuint)));
+    return (size_t)nResult;
+}
+
+size_t GLComputePrimitives::compact(GLTexture2D& oInput, GLShaderStorageBuffer& oOutput) {
+    lvAssert(oInput.m_nWidth<=(1<<16) && oInput.m_nHeight<=(1<<16));
+    // workgroups reserve their output range with a single global atomic, so the element order depends on scheduling
+    std::stringstream ssSrc;
+    ssSrc << getImageProcSourceHeader(oInput.m_eInternalFormat) <<
+             "layout(std430,binding=" << Buffer_OutputBinding << ") writeonly buffer OutputBuffer {uint anOutput[];};\n"
+             "layout(std430,binding=" << Buffer_ResultBinding << ") buffer ResultBuffer {uint anResult[];};\n"
+             "uniform uint nMaxCount;\n"
+             "shared uint nLocalCount;\n"
+             "shared uint nLocalBase;\n"
+             "void main() {\n"
+             "    if(gl_LocalInvocationIndex==0)\n"
+             "        nLocalCount = 0u;\n"
+             "    barrier();\n"
+             "    ivec2 coord = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    bool valid = all(lessThan(coord,imageSize(imgInput))) && imageLoad(imgInput,coord).r!=0u;\n"
+             "    uint local_idx = valid?atomicAdd(nLocalCount,1u):0u;\n"
+             "    barrier();\n"
+             "    if(gl_LocalInvocationIndex==0)\n"
+             "        nLocalBase = atomicAdd(anResult[0],nLocalCount);\n"
+             "    barrier();\n"
+             "    if(valid && nLocalBase+local_idx<nMaxCount)\n"
+             "        anOutput[nLocalBase+local_idx] = uint(coord.x)|(uint(coord.y)<<16);\n"
+             "}\n";
+    GLShader& oProgram = getProgram(ssSrc.str());
+    lvAssert(oProgram.setUniform1ui("nMaxCount",(GLuint)(oOutput.size()/sizeof(GLuint))));
+    m_oResultBuffer.fill(0u);
+    oInput.bindToImage(GLTexture::DefaultImage_InputBinding,0,GL_READ_ONLY);
+    oOutput.bind(Buffer_OutputBinding);
+    m_oResultBuffer.bind(Buffer_ResultBinding);
+    dispatch(oProgram,getImageProcDispatchSize(oInput));
+    GLuint nResult;
+    lvAssert(m_oResultBuffer.fetchBuffer(&nResult,sizeof(GLuint)));
+    return (size_t)nResult;
+}
+
+GLShader& GLComputePrimitives::getProgram(const std::string& sSource) {
+    auto oProgramIter = m_mPrograms.find(sSource);
+    if(oProgramIter!=m_mPrograms.end())
+        return *oProgramIter->second;
+    std::unique_ptr<GLShader> pProgram = std::make_unique<GLShader>();
+    pProgram->addSource(sSource,GL_COMPUTE_SHADER);
+    if(!pProgram->link())
+        lvError("Could not link compute primitive shader");
+    return *(m_mPrograms[sSource] = std::move(pProgram));
+}
+
+void GLComputePrimitives::dispatch(GLShader& oProgram, const glm::uvec3& vDispatchSize) {
+    lvAssert(oProgram.activate());
+    glDispatchCompute(vDispatchSize.x,vDispatchSize.y,vDispatchSize.z);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT|GL_SHADER_IMAGE_ACCESS_BARRIER_BIT|GL_BUFFER_UPDATE_BARRIER_BIT|GL_TEXTURE_FETCH_BARRIER_BIT|GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glDbgErrorCheck;
+}
+
+GLShaderStorageBuffer& GLComputePrimitives::getScratchBuffer(std::vector<std::unique_ptr<GLShaderStorageBuffer>>& vpPool, size_t nIdx, size_t nByteSize) {
+    if(vpPool.size()<=nIdx)
+        vpPool.resize(nIdx+1);
+    if(!vpPool[nIdx] || vpPool[nIdx]->size()<nByteSize)
+        vpPool[nIdx] = std::make_unique<GLShaderStorageBuffer>(nByteSize);
+    return *vpPool[nIdx];
+}
@@ -25,27 +25,64 @@ GLVertexArrayObject::~GLVertexArrayObject() {
     glDeleteVertexArrays(1,&m_nVAO);
 }
 
-GLPixelBufferObject::GLPixelBufferObject(const cv::Mat& oInitBufferData, GLenum eBufferTarget, GLenum eBufferUsage) :
+#define PBO_PERSISTENT_SLOT_ALIGNMENT 256 // keeps slot offsets valid for all texel types & above GL_MIN_MAP_BUFFER_ALIGNMENT
+
+GLPixelBufferObject::GLPixelBufferObject(const cv::Mat& oInitBufferData, GLenum eBufferTarget, GLenum eBufferUsage, size_t nPersistentSlots) :
         m_eBufferTarget(eBufferTarget),
         m_eBufferUsage(eBufferUsage),
         m_nBufferSize(oInitBufferData.rows*oInitBufferData.cols*oInitBufferData.channels()*lv::gl::getByteSizeFromMatDepth(oInitBufferData.depth())),
         m_nFrameType(oInitBufferData.type()),
-        m_oFrameSize(oInitBufferData.size()) {
+        m_oFrameSize(oInitBufferData.size()),
+        m_nSlotStride(((size_t)m_nBufferSize+PBO_PERSISTENT_SLOT_ALIGNMENT-1)/PBO_PERSISTENT_SLOT_ALIGNMENT*PBO_PERSISTENT_SLOT_ALIGNMENT),
+        m_pMappedData(nullptr),
+        m_nCurrSlot(0),
+        m_bCurrSlotAcquired(false) {
     lvAssert(m_eBufferTarget==GL_PIXEL_PACK_BUFFER || (m_eBufferTarget==GL_PIXEL_UNPACK_BUFFER && oInitBufferData.isContinuous()));
     lvAssert(m_nBufferSize>0);
+    static bool s_bAlreadyWarned = false;
+    if(nPersistentSlots>0 && !glBufferStorage && !s_bAlreadyWarned) {
+        std::cout << "\tWarning: glBufferStorage not supported, falling back to regular (map/unmap) pixel buffer objects" << std::endl;
+        s_bAlreadyWarned = true;
+    }
     glGenBuffers(1,&m_nPBO);
     glBindBuffer(m_eBufferTarget,m_nPBO);
-    glBufferData(m_eBufferTarget,m_nBufferSize,(m_eBufferTarget==GL_PIXEL_PACK_BUFFER)?nullptr:oInitBufferData.data,m_eBufferUsage);
+    if(nPersistentSlots>0 && glBufferStorage) {
+        const GLbitfield nMapFlags = ((m_eBufferTarget==GL_PIXEL_PACK_BUFFER)?GL_MAP_READ_BIT:GL_MAP_WRITE_BIT)|GL_MAP_PERSISTENT_BIT|GL_MAP_COHERENT_BIT;
+        const GLsizeiptr nStorageSize = GLsizeiptr(m_nSlotStride*nPersistentSlots);
+        glBufferStorage(m_eBufferTarget,nStorageSize,nullptr,nMapFlags);
+        m_pMappedData = (uchar*)glMapBufferRange(m_eBufferTarget,0,nStorageSize,nMapFlags);
+        lvAssert_(m_pMappedData,"could not persistently map pixel buffer object storage");
+        m_vpSlotFences.resize(nPersistentSlots,nullptr);
+        if(m_eBufferTarget==GL_PIXEL_UNPACK_BUFFER)
+            memcpy(m_pMappedData,oInitBufferData.data,(size_t)m_nBufferSize);
+    }
+    else
+        glBufferData(m_eBufferTarget,m_nBufferSize,(m_eBufferTarget==GL_PIXEL_PACK_BUFFER)?nullptr:oInitBufferData.data,m_eBufferUsage);
     glBindBuffer(m_eBufferTarget,0);
 }
 
 GLPixelBufferObject::~GLPixelBufferObject() {
+    for(GLsync& pFence : m_vpSlotFences)
+        if(pFence)
+            glDeleteSync(pFence);
+    if(m_pMappedData) {
+        glBindBuffer(m_eBufferTarget,m_nPBO);
+        glUnmapBuffer(m_eBufferTarget);
+        glBindBuffer(m_eBufferTarget,0);
+    }
     glDeleteBuffers(1,&m_nPBO);
 }
 
 bool GLPixelBufferObject::updateBuffer(const cv::Mat& oBufferData, bool bRealloc, bool bRebindAll) {
     lvDbgAssert(m_eBufferTarget==GL_PIXEL_UNPACK_BUFFER);
     lvDbgAssert(oBufferData.type()==m_nFrameType && oBufferData.size()==m_oFrameSize && oBufferData.isContinuous());
+    if(m_pMappedData) {
+        // immutable storage cannot be orphaned; slot fences already prevent overwriting in-flight data
+        if(!m_bCurrSlotAcquired || oBufferData.data!=m_pMappedData+getCurrSlotOffset())
+            memcpy(acquireNextSlot().data,oBufferData.data,(size_t)m_nBufferSize);
+        m_bCurrSlotAcquired = false;
+        return true;
+    }
     glBindBuffer(m_eBufferTarget,m_nPBO);
     if(bRealloc)
         glBufferData(m_eBufferTarget,m_nBufferSize,nullptr,m_eBufferUsage);
@@ -62,6 +99,11 @@ bool GLPixelBufferObject::updateBuffer(const cv::Mat& oBufferData, bool bRealloc
 bool GLPixelBufferObject::fetchBuffer(cv::Mat& oBufferData, bool bRebindAll) {
     lvDbgAssert(m_eBufferTarget==GL_PIXEL_PACK_BUFFER);
     lvDbgAssert(oBufferData.type()==m_nFrameType && oBufferData.size()==m_oFrameSize && oBufferData.isContinuous());
+    if(m_pMappedData) {
+        waitSlotFence(m_nCurrSlot);
+        memcpy(oBufferData.data,m_pMappedData+getCurrSlotOffset(),(size_t)m_nBufferSize);
+        return true;
+    }
     glBindBuffer(m_eBufferTarget,m_nPBO);
     void* pBufferClientPtr = glMapBuffer(m_eBufferTarget,GL_READ_ONLY);
     if(pBufferClientPtr) {
@@ -73,6 +115,36 @@ bool GLPixelBufferObject::fetchBuffer(cv::Mat& oBufferData, bool bRebindAll) {
     return pBufferClientPtr!=nullptr;
 }
 
+cv::Mat GLPixelBufferObject::acquireNextSlot() {
+    if(!m_pMappedData)
+        return cv::Mat();
+    ++m_nCurrSlot %= m_vpSlotFences.size();
+    waitSlotFence(m_nCurrSlot);
+    m_bCurrSlotAcquired = true;
+    return cv::Mat(m_oFrameSize,m_nFrameType,m_pMappedData+getCurrSlotOffset());
+}
+
+void GLPixelBufferObject::fenceCurrSlot() {
+    if(!m_pMappedData)
+        return;
+    GLsync& pFence = m_vpSlotFences[m_nCurrSlot];
+    if(pFence)
+        glDeleteSync(pFence);
+    pFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+}
+
+void GLPixelBufferObject::waitSlotFence(size_t nSlot) {
+    lvDbgAssert(nSlot<m_vpSlotFences.size());
+    GLsync& pFence = m_vpSlotFences[nSlot];
+    if(!pFence)
+        return;
+    GLenum eWaitRes;
+    while((eWaitRes=glClientWaitSync(pFence,GL_SYNC_FLUSH_COMMANDS_BIT,GLuint64(1e6)))==GL_TIMEOUT_EXPIRED);
+    lvAssert_(eWaitRes!=GL_WAIT_FAILED,"pixel buffer object slot fence wait failed");
+    glDeleteSync(pFence);
+    pFence = nullptr;
+}
+
 GLTexture::GLTexture() {
     glGenTextures(1,&m_nTex);
 }
@@ -251,7 +323,7 @@ void GLDynamicTexture2D::updateTexture(const GLPixelBufferObject& oPBO, bool bRe
     if(bRebindAll)
         glBindTexture(GL_TEXTURE_2D,getTexId());
     glBindBuffer(oPBO.m_eBufferTarget,oPBO.getPBOId());
-    glTexSubImage2D(GL_TEXTURE_2D,0,0,0,m_nWidth,m_nHeight,m_eDataFormat,m_eDataType,nullptr);
+    glTexSubImage2D(GL_TEXTURE_2D,0,0,0,m_nWidth,m_nHeight,m_eDataFormat,m_eDataType,(GLvoid*)oPBO.getCurrSlotOffset());
     if(bRebindAll)
         glBindBuffer(oPBO.m_eBufferTarget,0);
 }
@@ -269,7 +341,7 @@ void GLDynamicTexture2D::fetchTexture(const GLPixelBufferObject& oPBO, bool bReb
     lvDbgAssert(oPBO.size()==m_oInitTexture.size() && oPBO.type()==m_oInitTexture.type());
     glBindTexture(GL_TEXTURE_2D,getTexId());
     glBindBuffer(oPBO.m_eBufferTarget,oPBO.getPBOId());
-    glGetTexImage(GL_TEXTURE_2D,0,m_eDataFormat,m_eDataType,nullptr);
+    glGetTexImage(GL_TEXTURE_2D,0,m_eDataFormat,m_eDataType,(GLvoid*)oPBO.getCurrSlotOffset());
     if(bRebindAll)
         glBindBuffer(oPBO.m_eBufferTarget,0);
 }
@@ -305,7 +377,7 @@ void GLDynamicTexture2DArray::updateTexture(const GLPixelBufferObject& oPBO, int
     if(bRebindAll)
         glBindTexture(GL_TEXTURE_2D_ARRAY,getTexId());
     glBindBuffer(oPBO.m_eBufferTarget,oPBO.getPBOId());
-    glTexSubImage3D(GL_TEXTURE_2D_ARRAY,0,0,0,nLayer,m_nWidth,m_nHeight,1,m_eDataFormat,m_eDataType,nullptr);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY,0,0,0,nLayer,m_nWidth,m_nHeight,1,m_eDataFormat,m_eDataType,(GLvoid*)oPBO.getCurrSlotOffset());
     if(bRebindAll)
         glBindBuffer(oPBO.m_eBufferTarget,0);
 }
@@ -330,18 +402,42 @@ void GLDynamicTexture2DArray::fetchTexture(const GLPixelBufferObject& oPBO, int
     if(glGetTextureSubImage) {
         lvDbgAssert(oPBO.size()==m_voInitTextures[0].size() && oPBO.type()==m_voInitTextures[0].type());
         glBindBuffer(oPBO.m_eBufferTarget,oPBO.getPBOId());
-        glGetTextureSubImage(getTexId(),0,0,0,nLayer,(GLsizei)m_nWidth,(GLsizei)m_nHeight,1,m_eDataFormat,m_eDataType,(GLsizei)(m_voInitTextures[0].step.p[0]*m_nHeight),nullptr);
+        glGetTextureSubImage(getTexId(),0,0,0,nLayer,(GLsizei)m_nWidth,(GLsizei)m_nHeight,1,m_eDataFormat,m_eDataType,(GLsizei)(m_voInitTextures[0].step.p[0]*m_nHeight),(GLvoid*)oPBO.getCurrSlotOffset());
     }
     else {
         lvDbgAssert(oPBO.size()==m_oTextureArrayFetchBuffer.size() && oPBO.type()==m_oTextureArrayFetchBuffer.type());
         glBindTexture(GL_TEXTURE_2D_ARRAY,getTexId());
         glBindBuffer(oPBO.m_eBufferTarget,oPBO.getPBOId());
-        glGetTexImage(GL_TEXTURE_2D_ARRAY,0,m_eDataFormat,m_eDataType,nullptr);
+        glGetTexImage(GL_TEXTURE_2D_ARRAY,0,m_eDataFormat,m_eDataType,(GLvoid*)oPBO.getCurrSlotOffset());
     }
     if(bRebindAll)
         glBindBuffer(oPBO.m_eBufferTarget,0);
 }
 
+#if HAVE_CUDA
+
+GLCUDAInteropTexture2D::GLCUDAInteropTexture2D(const cv::Size& oSize, int nType, bool bUseIntegralFormat) :
+        GLTexture2D(1,cv::Mat(oSize,nType,cv::Scalar::all(0)),bUseIntegralFormat),m_pResource(nullptr) {
+    const cudaError_t nErr = cudaGraphicsGLRegisterImage(&m_pResource,getTexId(),GL_TEXTURE_2D,cudaGraphicsRegisterFlagsWriteDiscard);
+    lvAssert_(nErr==cudaSuccess,"failed to register texture with CUDA");
+}
+
+GLCUDAInteropTexture2D::~GLCUDAInteropTexture2D() {
+    cudaGraphicsUnregisterResource(m_pResource);
+}
+
+void GLCUDAInteropTexture2D::updateTexture(const void* pDevData, size_t nDevPitch, cudaStream_t nStream) {
+    lvDbgAssert(pDevData && nDevPitch>=m_oInitTexture.cols*m_oInitTexture.elemSize());
+    lvAssert_(cudaGraphicsMapResources(1,&m_pResource,nStream)==cudaSuccess,"failed to map texture resource");
+    cudaArray_t pArray;
+    lvAssert_(cudaGraphicsSubResourceGetMappedArray(&pArray,m_pResource,0,0)==cudaSuccess,"failed to get mapped texture array");
+    const cudaError_t nErr = cudaMemcpy2DToArrayAsync(pArray,0,0,pDevData,nDevPitch,m_oInitTexture.cols*m_oInitTexture.elemSize(),m_oInitTexture.rows,cudaMemcpyDeviceToDevice,nStream);
+    lvAssert_(cudaGraphicsUnmapResources(1,&m_pResource,nStream)==cudaSuccess,"failed to unmap texture resource");
+    lvAssert_(nErr==cudaSuccess,"failed to copy device buffer to texture");
+}
+
+#endif //HAVE_CUDA
+
 GLScreenBillboard::GLScreenBillboard() : GLVertexArrayObject() {
     glBindVertexArray(getVAOId());
     glGenBuffers(1,&m_nVBO);
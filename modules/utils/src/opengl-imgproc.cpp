@@ -16,6 +16,35 @@
 // limitations under the License.
 
 #include "litiv/utils/opengl-imgproc.hpp"
+#include "litiv/utils/profiler.hpp"
+#include <fstream>
+#include <typeinfo>
+
+namespace {
+
+    /// timer query slots within a single query set (compute stage slots follow)
+    enum GLTimerSlotList {
+        GLTimerSlot_TextureUpdate,
+        GLTimerSlot_DisplayUpdate,
+        GLTimerSlot_FirstComputeStage
+    };
+
+#if USE_PROFILER
+    /// returns the profiler site used to report the gpu time of the given timer query slot (created on first use, shared by all algos)
+    const lv::Profiler::Site& getGLTimerProfilerSite(size_t nSlot) {
+        static std::mutex s_oMutex;
+        static std::deque<std::pair<std::string,std::unique_ptr<lv::Profiler::Site>>> s_voSites;
+        std::mutex_lock_guard oLock(s_oMutex);
+        while(s_voSites.size()<=nSlot) {
+            const size_t nNewSlot = s_voSites.size();
+            s_voSites.emplace_back(nNewSlot==GLTimerSlot_TextureUpdate?std::string("gpu:texture_update"):nNewSlot==GLTimerSlot_DisplayUpdate?std::string("gpu:display_update"):"gpu:compute_stage_"+std::to_string(nNewSlot-GLTimerSlot_FirstComputeStage),nullptr);
+            s_voSites.back().second = std::make_unique<lv::Profiler::Site>(s_voSites.back().first.c_str());
+        }
+        return *s_voSites[nSlot].second;
+    }
+#endif //USE_PROFILER
+
+} // namespace
 
 GLImageProcAlgo::GLImageProcAlgo( size_t nLevels, size_t nComputeStages, size_t nExtraSSBOs, size_t nExtraACBOs, size_t nExtraImages, size_t nExtraTextures,
                                   int nOutputType, int nDebugType, bool bUseInput, bool bUseDisplay, bool bUseTimers, bool bUseIntegralFormat) :
@@ -48,9 +77,25 @@ GLImageProcAlgo::GLImageProcAlgo( size_t nLevels, size_t nComputeStages, size_t
         m_nLastLayer(GLUTILS_IMGPROC_DEFAULT_LAYER_COUNT-1),
         m_nCurrPBO(0),
         m_nNextPBO(1),
+        m_nCurrGLTimerSet(0),
+        m_nGLTimerSampleCount(0),
+        m_bAsyncFetching(false),
+        m_bUsingPackedInput(false),
+        m_nNextInputTex(0),
         m_nOutputType(nOutputType),
         m_nDebugType(nDebugType),
-        m_nInputType(-1) {
+        m_nShaderVariant(0),
+        m_nInputType(-1),
+        m_bUsingAutotuning(false),
+        m_bAutotuning(false),
+        m_nAutotuningConfigIdx(0),
+        m_nAutotuningFrameCount(0),
+        m_nAutotuningQuery(0) {
+    m_apReadbackFences.fill(nullptr);
+    m_anOutputPBOInternalIdx.fill(size_t(-1));
+    m_anDebugPBOInternalIdx.fill(size_t(-1));
+    m_abGLTimersPending.fill(false);
+    m_abGLTimersDisplayed.fill(false);
     lvAssert_(m_nLevels>0,"textures must have at least one level each");
     lvAssert_(GLUTILS_IMGPROC_DEFAULT_LAYER_COUNT>1,"texture arrays must have at least one layer each");
     lvAssert_(m_nComputeStages>0,"image processing pipeline must have at least one compute stage");
@@ -73,8 +118,12 @@ GLImageProcAlgo::GLImageProcAlgo( size_t nLevels, size_t nComputeStages, size_t
         lvError("ssbo blocks limit is too small for the current impl");
     if((size_t)lv::gl::getIntegerVal<1>(GL_MAX_ATOMIC_COUNTER_BUFFER_BINDINGS)<m_nACBOs)
         lvError("atomic bo bindings limit is too small for the current impl");
-    if(m_bUsingTimers)
-        glGenQueries((GLsizei)m_nGLTimers.size(),m_nGLTimers.data());
+    if(m_bUsingTimers) {
+        m_vnGLTimers.resize(GLUTILS_IMGPROC_TIMER_QUERY_LATENCY*(GLTimerSlot_FirstComputeStage+m_nComputeStages));
+        glGenQueries((GLsizei)m_vnGLTimers.size(),m_vnGLTimers.data());
+        m_vnGLTimerVals.resize(GLTimerSlot_FirstComputeStage+m_nComputeStages,0);
+        m_vdGLTimerAvgVals.resize(GLTimerSlot_FirstComputeStage+m_nComputeStages,0.0);
+    }
     if(m_nSSBOs) {
         m_vnSSBO.resize(m_nSSBOs);
         glGenBuffers((GLsizei)m_nSSBOs,m_vnSSBO.data());
@@ -86,8 +135,13 @@ GLImageProcAlgo::GLImageProcAlgo( size_t nLevels, size_t nComputeStages, size_t
 }
 
 GLImageProcAlgo::~GLImageProcAlgo() {
+    for(GLsync& pFence : m_apReadbackFences)
+        if(pFence)
+            glDeleteSync(pFence);
     if(m_bUsingTimers)
-        glDeleteQueries((GLsizei)m_nGLTimers.size(),m_nGLTimers.data());
+        glDeleteQueries((GLsizei)m_vnGLTimers.size(),m_vnGLTimers.data());
+    if(m_nAutotuningQuery)
+        glDeleteQueries(1,&m_nAutotuningQuery);
     if(m_nACBOs)
         glDeleteBuffers((GLsizei)m_nACBOs,m_vnACBO.data());
     if(m_nSSBOs)
@@ -114,12 +168,17 @@ void GLImageProcAlgo::initialize_gl(const cv::Mat& oInitInput, const cv::Mat& oR
     if(anMaxWorkGroupCount[0]<(int)ceil((float)m_oFrameSize.width/m_vDefaultWorkGroupSize.x) || anMaxWorkGroupCount[1]<(int)ceil((float)m_oFrameSize.height/m_vDefaultWorkGroupSize.y))
         lvError("workgroup count dispatch limit is too small for the current impl");
     for(size_t nPBOIter=0; nPBOIter<2; ++nPBOIter) {
+        if(m_apReadbackFences[nPBOIter]) {
+            glDeleteSync(m_apReadbackFences[nPBOIter]);
+            m_apReadbackFences[nPBOIter] = nullptr;
+        }
+        m_anOutputPBOInternalIdx[nPBOIter] = m_anDebugPBOInternalIdx[nPBOIter] = size_t(-1);
         if(m_bUsingOutputPBOs)
-            m_apOutputPBOs[nPBOIter] = std::make_unique<GLPixelBufferObject>(cv::Mat(m_oFrameSize,m_nOutputType),GL_PIXEL_PACK_BUFFER,GL_STREAM_READ);
+            m_apOutputPBOs[nPBOIter] = std::make_unique<GLPixelBufferObject>(cv::Mat(m_oFrameSize,m_nOutputType),GL_PIXEL_PACK_BUFFER,GL_STREAM_READ,GLUTILS_IMGPROC_PERSISTENT_PBO_SLOTS);
         if(m_bUsingDebugPBOs)
-            m_apDebugPBOs[nPBOIter] = std::make_unique<GLPixelBufferObject>(cv::Mat(m_oFrameSize,m_nDebugType),GL_PIXEL_PACK_BUFFER,GL_STREAM_READ);
+            m_apDebugPBOs[nPBOIter] = std::make_unique<GLPixelBufferObject>(cv::Mat(m_oFrameSize,m_nDebugType),GL_PIXEL_PACK_BUFFER,GL_STREAM_READ,GLUTILS_IMGPROC_PERSISTENT_PBO_SLOTS);
         if(m_bUsingInputPBOs)
-            m_apInputPBOs[nPBOIter] = std::make_unique<GLPixelBufferObject>(oInitInput,GL_PIXEL_UNPACK_BUFFER,GL_STREAM_DRAW);
+            m_apInputPBOs[nPBOIter] = std::make_unique<GLPixelBufferObject>(oInitInput,GL_PIXEL_UNPACK_BUFFER,GL_STREAM_DRAW,GLUTILS_IMGPROC_PERSISTENT_PBO_SLOTS);
     }
     if(m_bUsingTexArrays) {
         if(m_bUsingOutput) {
@@ -174,19 +233,24 @@ void GLImageProcAlgo::initialize_gl(const cv::Mat& oInitInput, const cv::Mat& oR
             }
         }
     }
+    // packed bgr inputs skip the rgba expansion of regular texture uploads (done on the cpu by most drivers), and take 25% less upload bandwidth
+    m_bUsingPackedInput = GLUTILS_IMGPROC_USE_PACKED_3CH_INPUT && m_bUsingInput && !m_bUsingInputPBOs && m_nInputType==CV_8UC3;
+    m_pInputUnpackShader = nullptr;
+    if(m_bUsingPackedInput) {
+        m_pInputUnpackShader = std::make_unique<GLShader>();
+        m_pInputUnpackShader->addSource(GLShader::getComputeShaderSource_UnpackBGR8(GLUTILS_IMGPROC_DEFAULT_WORKGROUP,m_oFrameSize,GLImageProcAlgo::StorageBuffer_PackedInputBinding,GLImageProcAlgo::Image_InputBinding,m_bUsingIntegralFormat),GL_COMPUTE_SHADER);
+        if(!m_pInputUnpackShader->link())
+            lvError("Could not link input unpacking shader");
+    }
     m_pROITexture = std::make_unique<GLTexture2D>(1,oROI,m_bUsingIntegralFormat);
     m_pROITexture->bindToImage(GLImageProcAlgo::Image_ROIBinding,0,GL_READ_ONLY);
     if(!m_bUsingOutputPBOs && m_bUsingOutput)
         m_oLastOutput = cv::Mat(m_oFrameSize,m_nOutputType);
     if(!m_bUsingDebugPBOs && m_bUsingDebug)
         m_oLastDebug = cv::Mat(m_oFrameSize,m_nDebugType);
-    m_vpImgProcShaders.resize(m_nComputeStages);
-    for(size_t nCurrStageIter=0; nCurrStageIter<m_nComputeStages; ++nCurrStageIter) {
-        m_vpImgProcShaders[nCurrStageIter] = std::make_unique<GLShader>();
-        m_vpImgProcShaders[nCurrStageIter]->addSource(getComputeShaderSource(nCurrStageIter),GL_COMPUTE_SHADER);
-        if(!m_vpImgProcShaders[nCurrStageIter]->link())
-            lvError("Could not link image processing shader");
-    }
+    initAutotuning();
+    if(!buildImgProcShaders())
+        lvError("Could not link image processing shader");
     m_oDisplayShader.clear();
     m_oDisplayShader.addSource(this->getVertexShaderSource(),GL_VERTEX_SHADER);
     m_oDisplayShader.addSource(this->getFragmentShaderSource(),GL_FRAGMENT_SHADER);
@@ -200,6 +264,11 @@ void GLImageProcAlgo::initialize_gl(const cv::Mat& oInitInput, const cv::Mat& oR
 void GLImageProcAlgo::apply_gl(const cv::Mat& oNextInput, bool bRebindAll) {
     lvAssert_(m_bGLInitialized,"algo must be initialized first");
     lvAssert_(oNextInput.empty() || (oNextInput.type()==m_nInputType && oNextInput.size()==m_oFrameSize && oNextInput.isContinuous()),"input must be the same size/type as initially provided, and continuous");
+    lvAssert_(!m_pLinkedInput || oNextInput.empty(),"algos with a linked input cannot also receive host-side inputs");
+    lvAssert_(!m_nNextInputTex || (oNextInput.empty() && m_bUsingInput && !m_pLinkedInput),"device-side inputs cannot be combined with host-side or linked inputs");
+    const bool bUploadingInput = m_bUsingInput && !m_pLinkedInput;
+    // device-side inputs bypass the input pbos entirely (the copy goes straight into the next input layer)
+    const bool bUploadingInputPBOs = m_bUsingInputPBOs && !m_pLinkedInput && !m_nNextInputTex;
     m_nLastLayer = m_nCurrLayer;
     m_nCurrLayer = m_nNextLayer;
     ++m_nNextLayer %= GLUTILS_IMGPROC_DEFAULT_LAYER_COUNT;
@@ -212,10 +281,17 @@ void GLImageProcAlgo::apply_gl(const cv::Mat& oNextInput, bool bRebindAll) {
             glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER,(GLuint)nACBOIter,m_vnACBO[nACBOIter]);
         // rebind extra images, textures? @@@@@
     }
-    if(m_bUsingTimers)
-        glBeginQuery(GL_TIME_ELAPSED,m_nGLTimers[GLImageProcAlgo::GLTimer_TextureUpdate]);
-    if(m_bUsingInputPBOs && !oNextInput.empty())
+    const size_t nGLTimerSetOffset = m_nCurrGLTimerSet*(GLTimerSlot_FirstComputeStage+m_nComputeStages);
+    if(m_bUsingTimers) {
+        fetchGLTimers(m_nCurrGLTimerSet,true); // set is about to be reused; its results should be long available by now
+        glBeginQuery(GL_TIME_ELAPSED,m_vnGLTimers[nGLTimerSetOffset+GLTimerSlot_TextureUpdate]);
+    }
+    if(bUploadingInputPBOs && !oNextInput.empty())
         m_apInputPBOs[m_nNextPBO]->updateBuffer(oNextInput,false,bRebindAll);
+    if(bUploadingInput && m_bUsingPackedInput && !oNextInput.empty())
+        unpackInput(oNextInput,m_nNextLayer);
+    if(m_nNextInputTex)
+        copyInputTexture(m_nNextInputTex,m_nNextLayer);
     if(m_bUsingTexArrays) {
         if(m_bUsingOutput) {
             if(bRebindAll)
@@ -227,10 +303,10 @@ void GLImageProcAlgo::apply_gl(const cv::Mat& oNextInput, bool bRebindAll) {
                 m_pDebugArray->bindToSamplerArray(GLImageProcAlgo::Texture_DebugBinding);
             m_pDebugArray->bindToImage(GLImageProcAlgo::Image_DebugBinding,0,(int)m_nCurrLayer,GL_WRITE_ONLY);
         }
-        if(m_bUsingInput) {
+        if(bUploadingInput) {
             if(bRebindAll || !m_bUsingInputPBOs) {
                 m_pInputArray->bindToSamplerArray(GLImageProcAlgo::Texture_InputBinding);
-                if(!m_bUsingInputPBOs && !oNextInput.empty())
+                if(!m_bUsingInputPBOs && !m_bUsingPackedInput && !oNextInput.empty())
                     m_pInputArray->updateTexture(oNextInput,(int)m_nNextLayer,bRebindAll);
             }
             m_pInputArray->bindToImage(GLImageProcAlgo::Image_InputBinding,0,(int)m_nCurrLayer,GL_READ_ONLY);
@@ -243,13 +319,13 @@ void GLImageProcAlgo::apply_gl(const cv::Mat& oNextInput, bool bRebindAll) {
                     m_vpOutputArray[nLayerIter]->bindToSampler((GLuint)getTextureBinding(nLayerIter,GLImageProcAlgo::Texture_OutputBinding));
                 if(m_bUsingDebug)
                     m_vpDebugArray[nLayerIter]->bindToSampler((GLuint)getTextureBinding(nLayerIter,GLImageProcAlgo::Texture_DebugBinding));
-                if(m_bUsingInput)
+                if(bUploadingInput)
                     m_vpInputArray[nLayerIter]->bindToSampler((GLuint)getTextureBinding(nLayerIter,GLImageProcAlgo::Texture_InputBinding));
             }
-            if(nLayerIter==m_nNextLayer && !m_bUsingInputPBOs) {
+            if(nLayerIter==m_nNextLayer && bUploadingInput && !m_bUsingInputPBOs) {
                 if(!bRebindAll)
                     m_vpInputArray[m_nNextLayer]->bindToSampler((GLuint)getTextureBinding(m_nNextLayer,GLImageProcAlgo::Texture_InputBinding));
-                if(!oNextInput.empty())
+                if(!m_bUsingPackedInput && !oNextInput.empty())
                     m_vpInputArray[m_nNextLayer]->updateTexture(oNextInput,bRebindAll);
             }
             else if(nLayerIter==m_nCurrLayer) {
@@ -257,27 +333,43 @@ void GLImageProcAlgo::apply_gl(const cv::Mat& oNextInput, bool bRebindAll) {
                     m_vpOutputArray[m_nCurrLayer]->bindToImage(GLImageProcAlgo::Image_OutputBinding,0,GL_READ_WRITE);
                 if(m_bUsingDebug)
                     m_vpDebugArray[m_nCurrLayer]->bindToImage(GLImageProcAlgo::Image_DebugBinding,0,GL_WRITE_ONLY);
-                if(m_bUsingInput)
+                if(bUploadingInput)
                     m_vpInputArray[m_nCurrLayer]->bindToImage(GLImageProcAlgo::Image_InputBinding,0,GL_READ_ONLY);
             }
         }
     }
+    if(m_pLinkedInput) {
+        // the source algo has just written its current output layer; make it visible to this algo's image loads
+        if(m_pLinkedInput->m_bUsingTexArrays)
+            m_pLinkedInput->m_pOutputArray->bindToImage(GLImageProcAlgo::Image_InputBinding,0,(int)m_pLinkedInput->m_nCurrLayer,GL_READ_ONLY);
+        else
+            m_pLinkedInput->m_vpOutputArray[m_pLinkedInput->m_nCurrLayer]->bindToImage(GLImageProcAlgo::Image_InputBinding,0,GL_READ_ONLY);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
     if(bRebindAll)
         m_pROITexture->bindToImage(GLImageProcAlgo::Image_ROIBinding,0,GL_READ_ONLY);
-    if(m_bUsingTimers) {
+    if(m_bUsingTimers)
         glEndQuery(GL_TIME_ELAPSED);
-        glBeginQuery(GL_TIME_ELAPSED,m_nGLTimers[GLImageProcAlgo::GLTimer_ComputeDispatch]);
-    }
+    // the autotuning query wraps all stages, so it cannot be nested with the per-stage timers (which are then skipped for the tuning frames)
+    const bool bUsingStageTimers = m_bUsingTimers && !m_bAutotuning;
+    if(m_bAutotuning)
+        glBeginQuery(GL_TIME_ELAPSED,m_nAutotuningQuery);
     for(size_t nCurrStageIter=0; nCurrStageIter<m_nComputeStages; ++nCurrStageIter) {
+        if(bUsingStageTimers)
+            glBeginQuery(GL_TIME_ELAPSED,m_vnGLTimers[nGLTimerSetOffset+GLTimerSlot_FirstComputeStage+nCurrStageIter]);
         lvAssert(m_vpImgProcShaders[nCurrStageIter]->activate());
         m_vpImgProcShaders[nCurrStageIter]->setUniform1ui(getCurrTextureLayerUniformName(),(GLuint)m_nCurrLayer);
         m_vpImgProcShaders[nCurrStageIter]->setUniform1ui(getLastTextureLayerUniformName(),(GLuint)m_nLastLayer);
         m_vpImgProcShaders[nCurrStageIter]->setUniform1ui(getFrameIndexUniformName(),(GLuint)m_nInternalFrameIdx);
-        dispatch(nCurrStageIter,*m_vpImgProcShaders[nCurrStageIter]); // add timer for stage? can reuse the same @@@@
+        dispatch(nCurrStageIter,*m_vpImgProcShaders[nCurrStageIter]);
+        if(bUsingStageTimers)
+            glEndQuery(GL_TIME_ELAPSED);
     }
-    if(m_bUsingTimers)
+    if(m_bAutotuning) {
         glEndQuery(GL_TIME_ELAPSED);
-    if(m_bUsingInputPBOs) {
+        updateAutotuning();
+    }
+    if(bUploadingInputPBOs) {
         if(m_bUsingTexArrays) {
             m_pInputArray->bindToSamplerArray(GLImageProcAlgo::Texture_InputBinding);
             m_pInputArray->updateTexture(*m_apInputPBOs[m_nNextPBO],(int)m_nNextLayer,bRebindAll);
@@ -286,11 +378,13 @@ void GLImageProcAlgo::apply_gl(const cv::Mat& oNextInput, bool bRebindAll) {
             m_vpInputArray[m_nNextLayer]->bindToSampler((GLuint)getTextureBinding(m_nNextLayer,GLImageProcAlgo::Texture_InputBinding));
             m_vpInputArray[m_nNextLayer]->updateTexture(*m_apInputPBOs[m_nNextPBO],bRebindAll);
         }
+        m_apInputPBOs[m_nNextPBO]->fenceCurrSlot();
     }
     if(m_bFetchingDebug) {
         m_nLastDebugInternalIdx = m_nInternalFrameIdx;
         glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
         if(m_bUsingDebugPBOs) {
+            m_apDebugPBOs[m_nNextPBO]->acquireNextSlot();
             if(m_bUsingTexArrays) {
                 m_pDebugArray->bindToSamplerArray(GLImageProcAlgo::Texture_DebugBinding);
                 m_pDebugArray->fetchTexture(*m_apDebugPBOs[m_nNextPBO],(int)m_nCurrLayer,bRebindAll);
@@ -299,6 +393,8 @@ void GLImageProcAlgo::apply_gl(const cv::Mat& oNextInput, bool bRebindAll) {
                 m_vpDebugArray[m_nCurrLayer]->bindToSampler((GLuint)getTextureBinding(m_nCurrLayer,GLImageProcAlgo::Texture_DebugBinding));
                 m_vpDebugArray[m_nCurrLayer]->fetchTexture(*m_apDebugPBOs[m_nNextPBO],bRebindAll);
             }
+            m_apDebugPBOs[m_nNextPBO]->fenceCurrSlot();
+            m_anDebugPBOInternalIdx[m_nNextPBO] = m_nInternalFrameIdx;
         }
         else {
             if(m_bUsingTexArrays) {
@@ -316,6 +412,7 @@ void GLImageProcAlgo::apply_gl(const cv::Mat& oNextInput, bool bRebindAll) {
         if(!m_bFetchingDebug)
             glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
         if(m_bUsingOutputPBOs) {
+            m_apOutputPBOs[m_nNextPBO]->acquireNextSlot();
             if(m_bUsingTexArrays) {
                 m_pOutputArray->bindToSamplerArray(GLImageProcAlgo::Texture_OutputBinding);
                 m_pOutputArray->fetchTexture(*m_apOutputPBOs[m_nNextPBO],(int)m_nCurrLayer,bRebindAll);
@@ -324,6 +421,8 @@ void GLImageProcAlgo::apply_gl(const cv::Mat& oNextInput, bool bRebindAll) {
                 m_vpOutputArray[m_nCurrLayer]->bindToSampler((GLuint)getTextureBinding(m_nCurrLayer,GLImageProcAlgo::Texture_OutputBinding));
                 m_vpOutputArray[m_nCurrLayer]->fetchTexture(*m_apOutputPBOs[m_nNextPBO],bRebindAll);
             }
+            m_apOutputPBOs[m_nNextPBO]->fenceCurrSlot();
+            m_anOutputPBOInternalIdx[m_nNextPBO] = m_nInternalFrameIdx;
         }
         else {
             if(m_bUsingTexArrays) {
@@ -336,6 +435,8 @@ void GLImageProcAlgo::apply_gl(const cv::Mat& oNextInput, bool bRebindAll) {
             }
         }
     }
+    if(m_bAsyncFetching && (m_bFetchingOutput || m_bFetchingDebug))
+        insertReadbackFence(m_nNextPBO);
     if(m_bUsingDisplay) {
         glMemoryBarrier(GL_ALL_BARRIER_BITS);
         if(m_bUsingDebug) {
@@ -351,7 +452,7 @@ void GLImageProcAlgo::apply_gl(const cv::Mat& oNextInput, bool bRebindAll) {
                 m_vpOutputArray[m_nCurrLayer]->bindToSampler((GLuint)getTextureBinding(m_nCurrLayer,GLImageProcAlgo::Texture_OutputBinding));
         }
         if(m_bUsingTimers)
-            glBeginQuery(GL_TIME_ELAPSED,m_nGLTimers[GLImageProcAlgo::GLTimer_DisplayUpdate]);
+            glBeginQuery(GL_TIME_ELAPSED,m_vnGLTimers[nGLTimerSetOffset+GLTimerSlot_DisplayUpdate]);
         lvAssert(m_oDisplayShader.activate());
         m_oDisplayShader.setUniform1ui(getCurrTextureLayerUniformName(),(GLuint)m_nCurrLayer);
         m_oDisplayBillboard.render();
@@ -359,28 +460,90 @@ void GLImageProcAlgo::apply_gl(const cv::Mat& oNextInput, bool bRebindAll) {
             glEndQuery(GL_TIME_ELAPSED);
     }
     if(m_bUsingTimers) {
-        GLuint64 nGLTimerValTot = 0;
-        std::cout << "\t\tGPU: ";
-        glGetQueryObjectui64v(m_nGLTimers[GLImageProcAlgo::GLTimer_TextureUpdate],GL_QUERY_RESULT,&m_nGLTimerVals[GLImageProcAlgo::GLTimer_TextureUpdate]);
-        std::cout << "TextureUpdate=" << m_nGLTimerVals[GLImageProcAlgo::GLTimer_TextureUpdate]*1.e-6 << "ms,  ";
-        nGLTimerValTot += m_nGLTimerVals[GLImageProcAlgo::GLTimer_TextureUpdate];
-        glGetQueryObjectui64v(m_nGLTimers[GLImageProcAlgo::GLTimer_ComputeDispatch],GL_QUERY_RESULT,&m_nGLTimerVals[GLImageProcAlgo::GLTimer_ComputeDispatch]);
-        std::cout << "ComputeDispatch=" << m_nGLTimerVals[GLImageProcAlgo::GLTimer_ComputeDispatch]*1.e-6 << "ms,  ";
-        nGLTimerValTot += m_nGLTimerVals[GLImageProcAlgo::GLTimer_ComputeDispatch];
-        if(m_bUsingDisplay) {
-            glGetQueryObjectui64v(m_nGLTimers[GLImageProcAlgo::GLTimer_DisplayUpdate],GL_QUERY_RESULT,&m_nGLTimerVals[GLImageProcAlgo::GLTimer_DisplayUpdate]);
-            std::cout << "DisplayUpdate=" << m_nGLTimerVals[GLImageProcAlgo::GLTimer_DisplayUpdate]*1.e-6 << "ms,  ";
-            nGLTimerValTot += m_nGLTimerVals[GLImageProcAlgo::GLTimer_DisplayUpdate];
-        }
-        std::cout << " tot=" << nGLTimerValTot*1.e-6 << "ms" << std::endl;
+        m_abGLTimersPending[m_nCurrGLTimerSet] = true;
+        m_abGLTimersDisplayed[m_nCurrGLTimerSet] = m_bUsingDisplay;
+        ++m_nCurrGLTimerSet %= GLUTILS_IMGPROC_TIMER_QUERY_LATENCY;
+        // poll older sets without stalling (from the oldest one, so that results are processed in order)
+        for(size_t nSetIter=0; nSetIter<GLUTILS_IMGPROC_TIMER_QUERY_LATENCY && fetchGLTimers((m_nCurrGLTimerSet+nSetIter)%GLUTILS_IMGPROC_TIMER_QUERY_LATENCY,false); ++nSetIter);
+#if GLUTILS_IMGPROC_PRINT_TIMERS
+        std::cout << "\t\tGPU: TextureUpdate=" << getGPUTime_ms(GLTimer_TextureUpdate) << "ms,  ComputeDispatch=" << getGPUTime_ms(GLTimer_ComputeDispatch) << "ms,  ";
+        if(m_bUsingDisplay)
+            std::cout << "DisplayUpdate=" << getGPUTime_ms(GLTimer_DisplayUpdate) << "ms,  ";
+        std::cout << " tot=" << getGPUTotalTime_ms() << "ms" << std::endl;
+#endif //GLUTILS_IMGPROC_PRINT_TIMERS
     }
     ++m_nInternalFrameIdx;
 }
 
+bool GLImageProcAlgo::fetchGLTimers(size_t nSet, bool bWait) {
+    lvDbgAssert(m_bUsingTimers && nSet<GLUTILS_IMGPROC_TIMER_QUERY_LATENCY);
+    if(!m_abGLTimersPending[nSet])
+        return true;
+    const size_t nSlots = GLTimerSlot_FirstComputeStage+m_nComputeStages;
+    const GLuint* pnQueries = m_vnGLTimers.data()+nSet*nSlots;
+    const bool bDisplayed = m_abGLTimersDisplayed[nSet];
+    if(!bWait) {
+        // queries of a set complete in submission order, so only the last issued one is checked
+        GLuint nAvailable = GL_FALSE;
+        glGetQueryObjectuiv(pnQueries[bDisplayed?(size_t)GLTimerSlot_DisplayUpdate:nSlots-1],GL_QUERY_RESULT_AVAILABLE,&nAvailable);
+        if(nAvailable==GL_FALSE)
+            return false;
+    }
+    const double dAvgFactor = std::max(1.0/(m_nGLTimerSampleCount+1),GLUTILS_IMGPROC_TIMER_AVG_FACTOR);
+    for(size_t nSlotIter=0; nSlotIter<nSlots; ++nSlotIter) {
+        if(nSlotIter==GLTimerSlot_DisplayUpdate && !bDisplayed) {
+            m_vnGLTimerVals[nSlotIter] = 0;
+            continue;
+        }
+        glGetQueryObjectui64v(pnQueries[nSlotIter],GL_QUERY_RESULT,&m_vnGLTimerVals[nSlotIter]);
+        m_vdGLTimerAvgVals[nSlotIter] += (double(m_vnGLTimerVals[nSlotIter])-m_vdGLTimerAvgVals[nSlotIter])*dAvgFactor;
+#if USE_PROFILER
+        lv::Profiler::addSample(getGLTimerProfilerSite(nSlotIter),m_vnGLTimerVals[nSlotIter]);
+#endif //USE_PROFILER
+    }
+    m_abGLTimersPending[nSet] = false;
+    ++m_nGLTimerSampleCount;
+    return true;
+}
+
+double GLImageProcAlgo::getGPUTime_ms(GLTimersList eTimer, bool bAverage) const {
+    lvAssert_(m_bUsingTimers,"algo is not configured to use gpu timers");
+    if(eTimer==GLTimer_ComputeDispatch) {
+        double dTot_ms = 0.0;
+        for(size_t nStageIter=0; nStageIter<m_nComputeStages; ++nStageIter)
+            dTot_ms += getGPUStageTime_ms(nStageIter,bAverage);
+        return dTot_ms;
+    }
+    lvAssert_(eTimer==GLTimer_TextureUpdate || eTimer==GLTimer_DisplayUpdate,"bad gpu timer index");
+    const size_t nSlot = (eTimer==GLTimer_TextureUpdate)?GLTimerSlot_TextureUpdate:GLTimerSlot_DisplayUpdate;
+    return (bAverage?m_vdGLTimerAvgVals[nSlot]:double(m_vnGLTimerVals[nSlot]))*1.e-6;
+}
+
+double GLImageProcAlgo::getGPUStageTime_ms(size_t nStage, bool bAverage) const {
+    lvAssert_(m_bUsingTimers,"algo is not configured to use gpu timers");
+    lvAssert_(nStage<m_nComputeStages,"bad compute stage index");
+    const size_t nSlot = GLTimerSlot_FirstComputeStage+nStage;
+    return (bAverage?m_vdGLTimerAvgVals[nSlot]:double(m_vnGLTimerVals[nSlot]))*1.e-6;
+}
+
+double GLImageProcAlgo::getGPUTotalTime_ms(bool bAverage) const {
+    return getGPUTime_ms(GLTimer_TextureUpdate,bAverage)+getGPUTime_ms(GLTimer_ComputeDispatch,bAverage)+getGPUTime_ms(GLTimer_DisplayUpdate,bAverage);
+}
+
 size_t GLImageProcAlgo::fetchLastOutput(cv::Mat& oOutput) const {
     lvAssert_(m_bFetchingOutput,"algo is not configured for cpu-side output mat fetching");
     oOutput.create(m_oFrameSize,m_nOutputType);
-    if(m_bUsingOutputPBOs)
+    if(m_bUsingOutputPBOs && m_bAsyncFetching) {
+        // the slot filled during the previous apply_gl call is the one that will be overwritten next
+        if(m_anOutputPBOInternalIdx[m_nCurrPBO]==size_t(-1)) {
+            oOutput = cv::Scalar::all(0);
+            return size_t(-1);
+        }
+        waitReadbackFence(m_nCurrPBO);
+        m_apOutputPBOs[m_nCurrPBO]->fetchBuffer(oOutput,true);
+        return m_anOutputPBOInternalIdx[m_nCurrPBO];
+    }
+    else if(m_bUsingOutputPBOs)
         m_apOutputPBOs[m_nNextPBO]->fetchBuffer(oOutput,true);
     else
         m_oLastOutput.copyTo(oOutput);
@@ -390,13 +553,180 @@ size_t GLImageProcAlgo::fetchLastOutput(cv::Mat& oOutput) const {
 size_t GLImageProcAlgo::fetchLastDebug(cv::Mat& oDebug) const {
     lvAssert_(m_bFetchingDebug,"algo is not configured for cpu-side debug mat fetching");
     oDebug.create(m_oFrameSize,m_nDebugType);
-    if(m_bUsingDebugPBOs)
+    if(m_bUsingDebugPBOs && m_bAsyncFetching) {
+        if(m_anDebugPBOInternalIdx[m_nCurrPBO]==size_t(-1)) {
+            oDebug = cv::Scalar::all(0);
+            return size_t(-1);
+        }
+        waitReadbackFence(m_nCurrPBO);
+        m_apDebugPBOs[m_nCurrPBO]->fetchBuffer(oDebug,true);
+        return m_anDebugPBOInternalIdx[m_nCurrPBO];
+    }
+    else if(m_bUsingDebugPBOs)
         m_apDebugPBOs[m_nNextPBO]->fetchBuffer(oDebug,true);
     else
         m_oLastDebug.copyTo(oDebug);
     return m_nLastDebugInternalIdx;
 }
 
+void GLImageProcAlgo::insertReadbackFence(size_t nPBO) {
+    lvDbgAssert(nPBO<m_apReadbackFences.size());
+    if(m_apReadbackFences[nPBO])
+        glDeleteSync(m_apReadbackFences[nPBO]);
+    m_apReadbackFences[nPBO] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+    glFlush(); // makes sure the readback commands are submitted before the next cpu-side wait
+}
+
+void GLImageProcAlgo::waitReadbackFence(size_t nPBO) const {
+    lvDbgAssert(nPBO<m_apReadbackFences.size());
+    if(!m_apReadbackFences[nPBO])
+        return;
+    GLenum eWaitRes;
+    while((eWaitRes=glClientWaitSync(m_apReadbackFences[nPBO],GL_SYNC_FLUSH_COMMANDS_BIT,GLuint64(1e6)))==GL_TIMEOUT_EXPIRED);
+    lvAssert_(eWaitRes!=GL_WAIT_FAILED,"readback fence wait failed");
+}
+
+void GLImageProcAlgo::setAutotuning(bool bEnabled, const std::string& sCacheFilePath) {
+    lvAssert_(!m_bGLInitialized,"autotuning must be toggled before initialization");
+    m_bUsingAutotuning = bEnabled;
+    m_sAutotuningCacheFilePath = sCacheFilePath;
+}
+
+bool GLImageProcAlgo::buildImgProcShaders() {
+    m_vpImgProcShaders.resize(m_nComputeStages);
+    for(size_t nCurrStageIter=0; nCurrStageIter<m_nComputeStages; ++nCurrStageIter) {
+        m_vpImgProcShaders[nCurrStageIter] = std::make_unique<GLShader>();
+        m_vpImgProcShaders[nCurrStageIter]->addSource(getComputeShaderSource(nCurrStageIter),GL_COMPUTE_SHADER);
+        if(!m_vpImgProcShaders[nCurrStageIter]->link())
+            return false;
+    }
+    return true;
+}
+
+std::string GLImageProcAlgo::getAutotuningCacheKey() const {
+    std::stringstream ssKey;
+    ssKey << (const char*)glGetString(GL_VENDOR) << "|" << (const char*)glGetString(GL_RENDERER) << "|" << typeid(*this).name() << "|" << m_oFrameSize.width << "x" << m_oFrameSize.height;
+    return ssKey.str();
+}
+
+void GLImageProcAlgo::initAutotuning() {
+    m_bAutotuning = false;
+    m_vAutotuningConfigs.clear();
+    if(!m_bUsingAutotuning)
+        return;
+    // cache entries are stored one per line as "<key>\t<x> <y> <variant>"; the last entry for a key wins
+    const std::string sKey = getAutotuningCacheKey();
+    std::ifstream oCacheFile(m_sAutotuningCacheFilePath);
+    bool bFoundCachedConfig = false;
+    for(std::string sLine; std::getline(oCacheFile,sLine);) {
+        const size_t nSepPos = sLine.rfind('\t');
+        if(nSepPos!=sKey.size() || sLine.compare(0,nSepPos,sKey)!=0)
+            continue;
+        std::stringstream ssConfig(sLine.substr(nSepPos+1));
+        glm::uvec2 vWorkGroupSize;
+        size_t nShaderVariant;
+        if((ssConfig >> vWorkGroupSize.x >> vWorkGroupSize.y >> nShaderVariant) && vWorkGroupSize.x>0 && vWorkGroupSize.y>0 && nShaderVariant<getShaderVariantCount()) {
+            m_vDefaultWorkGroupSize = vWorkGroupSize;
+            m_nShaderVariant = nShaderVariant;
+            bFoundCachedConfig = true;
+        }
+    }
+    if(bFoundCachedConfig)
+        return;
+    const std::array<int,3> anMaxWorkGroupSize = lv::gl::getIntegerVal<3>(GL_MAX_COMPUTE_WORK_GROUP_SIZE);
+    const size_t nMaxInvocs = (size_t)lv::gl::getIntegerVal<1>(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS);
+    const std::array<glm::uvec2,7> avCandidateSizes = {glm::uvec2(8,8),glm::uvec2(12,8),glm::uvec2(16,8),glm::uvec2(16,16),glm::uvec2(32,4),glm::uvec2(32,8),glm::uvec2(64,4)};
+    for(size_t nVariant=0; nVariant<getShaderVariantCount(); ++nVariant) {
+        // the default config is always timed first, so that it is the one used until a faster config is found
+        m_vAutotuningConfigs.emplace_back(GLUTILS_IMGPROC_DEFAULT_WORKGROUP,nVariant);
+        for(const glm::uvec2& vSize : avCandidateSizes)
+            if(vSize!=GLUTILS_IMGPROC_DEFAULT_WORKGROUP && (int)vSize.x<=anMaxWorkGroupSize[0] && (int)vSize.y<=anMaxWorkGroupSize[1] && size_t(vSize.x*vSize.y)<=nMaxInvocs)
+                m_vAutotuningConfigs.emplace_back(vSize,nVariant);
+    }
+    m_vnAutotuningTimes.assign(m_vAutotuningConfigs.size(),std::numeric_limits<GLuint64>::max());
+    m_nAutotuningConfigIdx = m_nAutotuningFrameCount = 0;
+    m_vDefaultWorkGroupSize = m_vAutotuningConfigs[0].first;
+    m_nShaderVariant = m_vAutotuningConfigs[0].second;
+    if(!m_nAutotuningQuery)
+        glGenQueries(1,&m_nAutotuningQuery);
+    m_bAutotuning = true;
+}
+
+void GLImageProcAlgo::updateAutotuning() {
+    lvDbgAssert(m_bAutotuning && m_nAutotuningConfigIdx<m_vAutotuningConfigs.size());
+    // waiting on the query result stalls the pipeline, but only for the few frames used to tune
+    GLuint64 nElapsedTime;
+    glGetQueryObjectui64v(m_nAutotuningQuery,GL_QUERY_RESULT,&nElapsedTime);
+    // the first frame of each config is skipped, as it includes shader warm-up
+    if(m_nAutotuningFrameCount++>0)
+        m_vnAutotuningTimes[m_nAutotuningConfigIdx] = (m_nAutotuningFrameCount==2)?nElapsedTime:m_vnAutotuningTimes[m_nAutotuningConfigIdx]+nElapsedTime;
+    if(m_nAutotuningFrameCount<GLUTILS_IMGPROC_AUTOTUNE_FRAMES_PER_CONFIG)
+        return;
+    m_nAutotuningFrameCount = 0;
+    // configs that fail to link (e.g. because their shared mem footprint is too big) are skipped, and keep their max time
+    while(++m_nAutotuningConfigIdx<m_vAutotuningConfigs.size()) {
+        m_vDefaultWorkGroupSize = m_vAutotuningConfigs[m_nAutotuningConfigIdx].first;
+        m_nShaderVariant = m_vAutotuningConfigs[m_nAutotuningConfigIdx].second;
+        if(buildImgProcShaders())
+            return;
+    }
+    const size_t nBestConfigIdx = size_t(std::min_element(m_vnAutotuningTimes.begin(),m_vnAutotuningTimes.end())-m_vnAutotuningTimes.begin());
+    m_vDefaultWorkGroupSize = m_vAutotuningConfigs[nBestConfigIdx].first;
+    m_nShaderVariant = m_vAutotuningConfigs[nBestConfigIdx].second;
+    if(!buildImgProcShaders())
+        lvError("Could not rebuild image processing shaders with the autotuned config");
+    m_bAutotuning = false;
+    std::ofstream oCacheFile(m_sAutotuningCacheFilePath,std::ios::app);
+    if(oCacheFile)
+        oCacheFile << getAutotuningCacheKey() << "\t" << m_vDefaultWorkGroupSize.x << " " << m_vDefaultWorkGroupSize.y << " " << m_nShaderVariant << "\n";
+}
+
+void GLImageProcAlgo::unpackInput(const cv::Mat& oInput, size_t nLayer) {
+    lvDbgAssert(m_bUsingPackedInput && m_pInputUnpackShader);
+    lvDbgAssert(oInput.type()==CV_8UC3 && oInput.size()==m_oFrameSize && oInput.isContinuous());
+    // the buffer is respecified (orphaned) at each upload, so the driver never has to wait on the previous unpacking dispatch
+    const GLuint nPackedInputSSBO = getSSBOId(GLImageProcAlgo::StorageBuffer_PackedInputBinding);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,nPackedInputSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER,(GLsizeiptr)(((oInput.total()*3+3)/4)*4),nullptr,GL_STREAM_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER,0,(GLsizeiptr)(oInput.total()*3),oInput.data);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,GLImageProcAlgo::StorageBuffer_PackedInputBinding,nPackedInputSSBO);
+    if(m_bUsingTexArrays)
+        m_pInputArray->bindToImage(GLImageProcAlgo::Image_InputBinding,0,(int)nLayer,GL_WRITE_ONLY);
+    else
+        m_vpInputArray[nLayer]->bindToImage(GLImageProcAlgo::Image_InputBinding,0,GL_WRITE_ONLY);
+    lvAssert(m_pInputUnpackShader->activate());
+    const glm::uvec2 vWorkGroupSize = GLUTILS_IMGPROC_DEFAULT_WORKGROUP;
+    glDispatchCompute((GLuint)ceil((float)m_oFrameSize.width/vWorkGroupSize.x),(GLuint)ceil((float)m_oFrameSize.height/vWorkGroupSize.y),1);
+    // the unpacked layer is read via image loads by the algo stages (their input binding is restored by 'apply_gl'), or sampled after mipmap regen
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT|GL_TEXTURE_FETCH_BARRIER_BIT|GL_TEXTURE_UPDATE_BARRIER_BIT);
+    if(!m_bUsingTexArrays && m_nLevels>1) {
+        m_vpInputArray[nLayer]->bindToSampler((GLuint)getTextureBinding(nLayer,GLImageProcAlgo::Texture_InputBinding));
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+}
+
+void GLImageProcAlgo::apply_gl_device(GLuint nNextInputTex, bool bRebindAll) {
+    lvAssert_(nNextInputTex,"bad device-side input texture");
+    m_nNextInputTex = nNextInputTex;
+    apply_gl(cv::Mat(),bRebindAll);
+    m_nNextInputTex = 0;
+}
+
+void GLImageProcAlgo::copyInputTexture(GLuint nSrcTex, size_t nLayer) {
+    lvDbgAssert(m_bUsingInput && nSrcTex);
+    // size & format class mismatches are reported by the copy itself (as GL_INVALID_VALUE/GL_INVALID_OPERATION), and caught by the error check below
+    if(m_bUsingTexArrays)
+        glCopyImageSubData(nSrcTex,GL_TEXTURE_2D,0,0,0,0,m_pInputArray->getTexId(),GL_TEXTURE_2D_ARRAY,0,0,0,(GLint)nLayer,m_oFrameSize.width,m_oFrameSize.height,1);
+    else {
+        glCopyImageSubData(nSrcTex,GL_TEXTURE_2D,0,0,0,0,m_vpInputArray[nLayer]->getTexId(),GL_TEXTURE_2D,0,0,0,0,m_oFrameSize.width,m_oFrameSize.height,1);
+        if(m_nLevels>1) {
+            m_vpInputArray[nLayer]->bindToSampler((GLuint)getTextureBinding(nLayer,GLImageProcAlgo::Texture_InputBinding));
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+    }
+    glErrorCheck;
+}
+
 void GLImageProcAlgo::dispatch(size_t nStage, GLShader&) {
     lvAssert_(nStage<m_nComputeStages,"required compute stage does not exist");
     glDispatchCompute((GLuint)ceil((float)m_oFrameSize.width/m_vDefaultWorkGroupSize.x),(GLuint)ceil((float)m_oFrameSize.height/m_vDefaultWorkGroupSize.y),1);
@@ -761,6 +1091,7 @@ void GLImageProcEvaluatorAlgo::apply_gl(const cv::Mat& oNextGT, bool bRebindAll)
                 m_vpDebugArray[m_nCurrLayer]->bindToSampler((GLuint)getTextureBinding(m_nCurrLayer,GLImageProcAlgo::Texture_DebugBinding));
                 m_vpDebugArray[m_nCurrLayer]->fetchTexture(*m_apDebugPBOs[m_nNextPBO],bRebindAll);
             }
+            m_anDebugPBOInternalIdx[m_nNextPBO] = m_nInternalFrameIdx;
         }
         else {
             if(m_bUsingTexArrays) {
@@ -773,6 +1104,8 @@ void GLImageProcEvaluatorAlgo::apply_gl(const cv::Mat& oNextGT, bool bRebindAll)
             }
         }
     }
+    if(m_bAsyncFetching && m_bFetchingDebug)
+        insertReadbackFence(m_nNextPBO);
     if(m_bUsingDisplay) {
         glMemoryBarrier(GL_ALL_BARRIER_BITS);
         if(m_bUsingDebug) {
@@ -789,6 +1122,45 @@ void GLImageProcEvaluatorAlgo::apply_gl(const cv::Mat& oNextGT, bool bRebindAll)
     ++m_nInternalFrameIdx;
 }
 
+GLImageProcPipeline::GLImageProcPipeline(const std::shared_ptr<GLImageProcAlgo>& pHead) {
+    lvAssert_(pHead && pHead->m_bUsingOutput,"pipeline head must be a valid algo with an output image");
+    m_vpStages.push_back(pHead);
+}
+
+void GLImageProcPipeline::addStage(const std::shared_ptr<GLImageProcAlgo>& pStage) {
+    lvAssert_(pStage && pStage!=m_vpStages.back(),"pipeline stages must be valid & distinct from the previous stage");
+    lvAssert_(pStage->m_bUsingInput && pStage->m_bUsingOutput,"pipeline stages must use both input and output images");
+    lvAssert_(!pStage->m_pLinkedInput,"algo is already linked to another pipeline source");
+    pStage->m_pLinkedInput = m_vpStages.back();
+    m_vpStages.push_back(pStage);
+}
+
+void GLImageProcPipeline::initialize_gl(const cv::Mat& oROI) {
+    lvAssert_(m_vpStages.front()->m_bGLInitialized,"pipeline head must be initialized first");
+    lvAssert_(oROI.empty() || oROI.size()==m_vpStages.front()->m_oFrameSize,"pipeline ROI size must match the head's frame size");
+    const cv::Mat oCurrROI = oROI.empty()?cv::Mat(m_vpStages.front()->m_oFrameSize,CV_8UC1,cv::Scalar_<uchar>(255)):oROI;
+    for(size_t nStageIdx=1; nStageIdx<m_vpStages.size(); ++nStageIdx) {
+        const std::shared_ptr<GLImageProcAlgo>& pSource = m_vpStages[nStageIdx-1];
+        // the init input only provides the input type here, actual inputs will always come from the linked source
+        m_vpStages[nStageIdx]->initialize_gl(cv::Mat(pSource->m_oFrameSize,pSource->m_nOutputType,cv::Scalar::all(0)),oCurrROI);
+    }
+    // intermediate outputs never leave the gpu
+    for(size_t nStageIdx=0; nStageIdx<m_vpStages.size()-1; ++nStageIdx)
+        m_vpStages[nStageIdx]->setOutputFetching(false);
+    m_vpStages.back()->setOutputFetching(true);
+    glErrorCheck;
+}
+
+void GLImageProcPipeline::apply_gl() {
+    // image/buffer bindings are shared by all stages, so each one must rebind its own state
+    for(size_t nStageIdx=1; nStageIdx<m_vpStages.size(); ++nStageIdx)
+        m_vpStages[nStageIdx]->apply_gl(cv::Mat(),true);
+}
+
+size_t GLImageProcPipeline::fetchLastOutput(cv::Mat& oOutput) const {
+    return m_vpStages.back()->fetchLastOutput(oOutput);
+}
+
 GLImagePassThroughAlgo::GLImagePassThroughAlgo(int nFrameType, bool bUseDisplay, bool bUseTimers, bool bUseIntegralFormat) :
         GLImageProcAlgo(1,1,0,0,0,0,nFrameType,-1,true,bUseDisplay,bUseTimers,bUseIntegralFormat) {
     lvAssert_(nFrameType>=0,"must provide a valid frame type for pass-through usage");
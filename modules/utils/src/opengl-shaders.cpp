@@ -17,8 +17,167 @@
 
 #include "litiv/utils/opengl-shaders.hpp"
 
+#define GLSHADER_PROGRAM_BINARY_MAGIC  0x4C56474C50524F47ULL // "LVGLPROG", prefixes cached program binary files
+
 GLShader* GLShader::s_pCurrActiveShader = nullptr;
 
+namespace {
+
+    /// cached program binary, along with its driver-specific format
+    struct ProgramBinary {
+        GLenum eFormat;
+        std::vector<char> vcData;
+    };
+
+    /// process-wide program binary cache (shared by all shader instances & contexts)
+    struct ProgramCache {
+        ProgramCache() : bEnabled(true) {}
+        std::mutex oMutex;
+        bool bEnabled;
+        std::string sDirPath;
+        std::map<uint64_t,ProgramBinary> mBinaries;
+    };
+
+    ProgramCache& getProgramCache() {
+        static ProgramCache s_oCache;
+        return s_oCache;
+    }
+
+    /// 64-bit FNV-1a hash, stable across runs & platforms (unlike std::hash) so disk cache keys remain valid
+    inline uint64_t hashFNV1a(const char* acData, size_t nSize, uint64_t nHash=0xCBF29CE484222325ULL) {
+        for(size_t nIdx=0; nIdx<nSize; ++nIdx)
+            nHash = (nHash^(uint64_t)(uchar)acData[nIdx])*0x100000001B3ULL;
+        return nHash;
+    }
+
+    inline uint64_t hashFNV1a(const std::string& sData, uint64_t nHash) {
+        return hashFNV1a(sData.data(),sData.size(),nHash);
+    }
+
+    std::string getProgramCacheFilePath(const std::string& sDirPath, uint64_t nKey) {
+        std::stringstream ssPath;
+        ssPath << lv::AddDirSlashIfMissing(sDirPath) << std::hex << std::setw(16) << std::setfill('0') << nKey << ".glprog";
+        return ssPath.str();
+    }
+
+    /// clears pending gl errors without throwing (glProgramBinary is allowed to fail on driver updates)
+    inline void clearGLErrors() {
+        while(glGetError()!=GL_NO_ERROR);
+    }
+
+} // namespace
+
+void GLShader::setProgramCacheEnabled(bool bEnabled) {
+    ProgramCache& oCache = getProgramCache();
+    std::mutex_lock_guard oLock(oCache.oMutex);
+    oCache.bEnabled = bEnabled;
+}
+
+void GLShader::setProgramCacheDirPath(const std::string& sDirPath) {
+    ProgramCache& oCache = getProgramCache();
+    if(!sDirPath.empty())
+        lvAssert_(lv::CreateDirIfNotExist(sDirPath),"could not create program cache directory");
+    std::mutex_lock_guard oLock(oCache.oMutex);
+    oCache.sDirPath = sDirPath;
+}
+
+uint64_t GLShader::getProgramCacheKey() const {
+    uint64_t nKey = 0xCBF29CE484222325ULL;
+    for(GLenum eStr : {GL_VENDOR,GL_RENDERER,GL_VERSION,GL_SHADING_LANGUAGE_VERSION}) {
+        const GLubyte* acStr = glGetString(eStr);
+        if(acStr)
+            nKey = hashFNV1a(std::string((const char*)acStr),nKey);
+    }
+    // shader ids are not stable across runs, so sources are hashed in (type,source) order instead
+    std::vector<std::pair<GLint,const std::string*>> vSources;
+    for(const auto& oSrcPair : m_mShaderSources) {
+        GLint nType;
+        glGetShaderiv(oSrcPair.first,GL_SHADER_TYPE,&nType);
+        vSources.emplace_back(nType,&oSrcPair.second);
+    }
+    std::sort(vSources.begin(),vSources.end(),[](const auto& a, const auto& b){return a.first<b.first || (a.first==b.first && *a.second<*b.second);});
+    for(const auto& oSrc : vSources) {
+        nKey = hashFNV1a((const char*)&oSrc.first,sizeof(oSrc.first),nKey);
+        nKey = hashFNV1a(*oSrc.second,nKey);
+    }
+    return nKey;
+}
+
+bool GLShader::loadProgramBinary(uint64_t nKey) {
+    ProgramCache& oCache = getProgramCache();
+    ProgramBinary oBinary;
+    {
+        std::mutex_lock_guard oLock(oCache.oMutex);
+        if(!oCache.bEnabled)
+            return false;
+        auto pBinaryIter = oCache.mBinaries.find(nKey);
+        if(pBinaryIter!=oCache.mBinaries.end())
+            oBinary = pBinaryIter->second;
+        else if(!oCache.sDirPath.empty()) {
+            std::ifstream oFile(getProgramCacheFilePath(oCache.sDirPath,nKey),std::ios::binary);
+            uint64_t nMagic = 0, nSize = 0;
+            uint32_t nFormat = 0;
+            if(!oFile.read((char*)&nMagic,sizeof(nMagic)) || nMagic!=GLSHADER_PROGRAM_BINARY_MAGIC ||
+               !oFile.read((char*)&nFormat,sizeof(nFormat)) || !oFile.read((char*)&nSize,sizeof(nSize)))
+                return false;
+            oBinary.eFormat = (GLenum)nFormat;
+            oBinary.vcData.resize((size_t)nSize);
+            if(!oFile.read(oBinary.vcData.data(),std::streamsize(nSize)))
+                return false;
+            oCache.mBinaries[nKey] = oBinary;
+        }
+        else
+            return false;
+    }
+    clearGLErrors();
+    glProgramBinary(m_nProgID,oBinary.eFormat,oBinary.vcData.data(),(GLsizei)oBinary.vcData.size());
+    GLint nLinked = GL_FALSE;
+    glGetProgramiv(m_nProgID,GL_LINK_STATUS,&nLinked);
+    if(glGetError()!=GL_NO_ERROR || nLinked==GL_FALSE) {
+        clearGLErrors();
+        std::mutex_lock_guard oLock(oCache.oMutex);
+        oCache.mBinaries.erase(nKey); // stale binary (e.g. driver update), will be replaced after the regular link
+        return false;
+    }
+    return true;
+}
+
+void GLShader::storeProgramBinary(uint64_t nKey) {
+    ProgramCache& oCache = getProgramCache();
+    {
+        std::mutex_lock_guard oLock(oCache.oMutex);
+        if(!oCache.bEnabled)
+            return;
+    }
+    GLint nSize = 0;
+    glGetProgramiv(m_nProgID,GL_PROGRAM_BINARY_LENGTH,&nSize);
+    glErrorCheck;
+    if(nSize<=0)
+        return;
+    ProgramBinary oBinary;
+    oBinary.vcData.resize((size_t)nSize);
+    glGetProgramBinary(m_nProgID,nSize,&nSize,&oBinary.eFormat,oBinary.vcData.data());
+    glErrorCheck;
+    oBinary.vcData.resize((size_t)nSize);
+    std::mutex_lock_guard oLock(oCache.oMutex);
+    if(!oCache.sDirPath.empty()) {
+        // written to a temp file first, so that concurrent processes never read partial binaries
+        const std::string sFilePath = getProgramCacheFilePath(oCache.sDirPath,nKey);
+        const std::string sTempFilePath = sFilePath+".tmp"+std::to_string(uintptr_t(this));
+        std::ofstream oFile(sTempFilePath,std::ios::binary);
+        const uint64_t nMagic = GLSHADER_PROGRAM_BINARY_MAGIC, nDataSize = oBinary.vcData.size();
+        const uint32_t nFormat = (uint32_t)oBinary.eFormat;
+        oFile.write((const char*)&nMagic,sizeof(nMagic));
+        oFile.write((const char*)&nFormat,sizeof(nFormat));
+        oFile.write((const char*)&nDataSize,sizeof(nDataSize));
+        oFile.write(oBinary.vcData.data(),std::streamsize(nDataSize));
+        oFile.close();
+        if(!oFile || std::rename(sTempFilePath.c_str(),sFilePath.c_str())!=0)
+            std::remove(sTempFilePath.c_str()); // disk caching is best-effort only
+    }
+    oCache.mBinaries[nKey] = std::move(oBinary);
+}
+
 bool GLShader::useShaderProgram(GLShader* pNewShader) {
     if(pNewShader) {
         if(pNewShader->m_bIsActive && s_pCurrActiveShader==pNewShader)
@@ -130,10 +289,22 @@ bool GLShader::compile() {
 bool GLShader::link(bool bDiscardSources) {
     if(!m_nProgID)
         return true;
+    const uint64_t nCacheKey = m_mShaderSources.empty()?0:getProgramCacheKey();
+    if(nCacheKey && loadProgramBinary(nCacheKey)) {
+        // driver-side compilation is skipped entirely for cached programs
+        m_mShaderUniformLocations.clear();
+        if(bDiscardSources) {
+            while(!m_mShaderSources.empty())
+                removeSource(m_mShaderSources.begin()->first);
+        }
+        return (m_bIsLinked=true);
+    }
     if(!compile() && !m_bIsEmpty)
         return false;
     if(m_bIsLinked && m_bIsEmpty)
         return true;
+    if(nCacheKey)
+        glProgramParameteri(m_nProgID,GL_PROGRAM_BINARY_RETRIEVABLE_HINT,GL_TRUE);
     for(auto oSrcIter=m_mShaderSources.begin(); oSrcIter!=m_mShaderSources.end(); ++oSrcIter) {
         glAttachShader(m_nProgID,oSrcIter->first);
         glErrorCheck;
@@ -150,7 +321,9 @@ bool GLShader::link(bool bDiscardSources) {
         glGetProgramInfoLog(m_nProgID, nLogSize, &nLogSize, &vcLog[0]);
         lvError_("shader link error in program #%d:\n%s\n",m_nProgID,&vcLog[0]);
     }
-    else if(bDiscardSources) {
+    if(nCacheKey)
+        storeProgramBinary(nCacheKey);
+    if(bDiscardSources) {
         while(!m_mShaderSources.empty())
             removeSource(m_mShaderSources.begin()->first);
     }
@@ -575,6 +748,38 @@ std::string GLShader::getComputeShaderSource_PassThrough_ImgLoadCopy(const glm::
     return ssSrc.str();
 }
 
+std::string GLShader::getComputeShaderSource_UnpackBGR8(const glm::uvec2& vWorkGroupSize, const cv::Size& oFrameSize, GLuint nInputStorageBufferBinding, GLuint nOutputImageBinding, bool bUseIntegralFormat) {
+    // dispatch must use x=ceil(nColumns/vWorkGroupSize.x), y=ceil(nRows/vWorkGroupSize.y), z=1
+    lvAssert(oFrameSize.area()>0);
+    std::stringstream ssSrc;
+    ssSrc << "#version 430\n"
+             "#define nFrameWidth " << oFrameSize.width << "u\n"
+             "#define nFrameHeight " << oFrameSize.height << "u\n"
+             "layout(local_size_x=" << vWorkGroupSize.x << ",local_size_y=" << vWorkGroupSize.y << ") in;\n"
+             "layout(binding=" << nInputStorageBufferBinding << ", std430) readonly buffer bPackedInput {\n"
+             "    uint anPackedInput[];\n"
+             "};\n";
+    if(bUseIntegralFormat) ssSrc <<
+             "layout(binding=" << nOutputImageBinding << ", rgba8ui) writeonly uniform uimage2D imgOutput;\n";
+    else ssSrc <<
+             "layout(binding=" << nOutputImageBinding << ", rgba8) writeonly uniform image2D imgOutput;\n";
+    ssSrc << "uint getPackedByte(in uint nByteIdx) {\n"
+             "    return (anPackedInput[nByteIdx>>2]>>((nByteIdx&3u)<<3))&0xFFu;\n"
+             "}\n"
+             "void main() {\n"
+             "    uvec2 vImgCoords = gl_GlobalInvocationID.xy;\n"
+             "    if(vImgCoords.x>=nFrameWidth || vImgCoords.y>=nFrameHeight)\n"
+             "        return;\n"
+             "    uint nByteIdx = (vImgCoords.y*nFrameWidth+vImgCoords.x)*3u;\n"
+             "    uvec3 vColor = uvec3(getPackedByte(nByteIdx+2u),getPackedByte(nByteIdx+1u),getPackedByte(nByteIdx));\n";
+    if(bUseIntegralFormat) ssSrc <<
+             "    imageStore(imgOutput,ivec2(vImgCoords),uvec4(vColor,1u));\n";
+    else ssSrc <<
+             "    imageStore(imgOutput,ivec2(vImgCoords),vec4(vec3(vColor)/255.0,1.0));\n";
+    ssSrc << "}\n";
+    return ssSrc.str();
+}
+
 std::string GLShader::getComputeShaderSource_ParallelPrefixSum(size_t nMaxRowSize, bool bBinaryProc, GLenum eInternalFormat, GLuint nInputImageBinding, GLuint nOutputImageBinding) {
     // dispatch must use x=ceil(ceil(nColumns/2)/nMaxRowSize), y=nRows, z=1
     lvAssert(lv::gl::isInternalFormatIntegral(eInternalFormat));
@@ -750,19 +955,40 @@ std::string GLShader::getComputeShaderFunctionSource_BinaryMedianBlur(size_t nKe
              "    const uint nMajorityCount = uint(nKernelSize*nKernelSize)/2;\n"
              "    return uint(nPositiveCount>nMajorityCount)*255;"
              "}\n";
-    else ssSrc <<
-             GLShader::getComputeShaderFunctionSource_SharedDataPreLoad(1,vWorkGroupSize,nKernelSize/2) <<
+    else {
+        // the preloaded tile is turned into a (zero-padded) integral image of positives in shared mem, so each box count takes four lookups
+        const glm::uvec2 vPreloadSize = vWorkGroupSize+glm::uvec2(uint(nKernelSize/2)*2);
+        ssSrc << GLShader::getComputeShaderFunctionSource_SharedDataPreLoad(1,vWorkGroupSize,nKernelSize/2) <<
+             "shared uint anMedianIntegral[" << vPreloadSize.y+1 << "][" << vPreloadSize.x+1 << "];\n"
              "uint BinaryMedianBlur(in ivec2 vCoords) {\n"
              "    const int nKernelSize = " << nKernelSize << ";\n"
-             "    const int nHalfKernelSize = nKernelSize/2;\n"
-             "    uint nPositiveCount = 0;\n"
-             "    ivec2 vLocalCoords = vCoords-ivec2(gl_GlobalInvocationID.xy)+ivec2(gl_LocalInvocationID.xy)+ivec2(nHalfKernelSize);\n"
-             "    for(int y=-nHalfKernelSize; y<=nHalfKernelSize; ++y)\n"
-             "        for(int x=-nHalfKernelSize; x<=nHalfKernelSize; ++x)\n"
-             "            nPositiveCount += uint(avPreloadData[vLocalCoords.y+y][vLocalCoords.x+x].r>128);\n"
+             "    const uvec2 vPreloadSize = uvec2(" << vPreloadSize.x << "," << vPreloadSize.y << ");\n"
+             "    const uint nInvocCount = gl_WorkGroupSize.x*gl_WorkGroupSize.y;\n"
+             "    const uint nInvocIdx = gl_LocalInvocationID.y*gl_WorkGroupSize.x+gl_LocalInvocationID.x;\n"
+             "    for(uint x=nInvocIdx; x<=vPreloadSize.x; x+=nInvocCount) {\n"
+             "        uint nColSum = 0;\n"
+             "        anMedianIntegral[0][x] = 0;\n"
+             "        for(uint y=0; y<vPreloadSize.y; ++y) {\n"
+             "            nColSum += (x>0)?uint(avPreloadData[y][x-1].r>128):0;\n"
+             "            anMedianIntegral[y+1][x] = nColSum;\n"
+             "        }\n"
+             "    }\n"
+             "    barrier();\n"
+             "    for(uint y=nInvocIdx; y<=vPreloadSize.y; y+=nInvocCount) {\n"
+             "        uint nRowSum = 0;\n"
+             "        for(uint x=1; x<=vPreloadSize.x; ++x) {\n"
+             "            nRowSum += anMedianIntegral[y][x];\n"
+             "            anMedianIntegral[y][x] = nRowSum;\n"
+             "        }\n"
+             "    }\n"
+             "    barrier();\n"
+             "    ivec2 vLocalCoords = vCoords-ivec2(gl_GlobalInvocationID.xy)+ivec2(gl_LocalInvocationID.xy);\n"
+             "    uint nPositiveCount = anMedianIntegral[vLocalCoords.y+nKernelSize][vLocalCoords.x+nKernelSize]-anMedianIntegral[vLocalCoords.y][vLocalCoords.x+nKernelSize]\n"
+             "                         -anMedianIntegral[vLocalCoords.y+nKernelSize][vLocalCoords.x]+anMedianIntegral[vLocalCoords.y][vLocalCoords.x];\n"
              "    const uint nMajorityCount = uint(nKernelSize*nKernelSize)/2;\n"
              "    return uint(nPositiveCount>nMajorityCount)*255;"
              "}\n";
+    }
     return ssSrc.str();
 }
 
@@ -780,9 +1006,33 @@ std::string GLShader::getShaderFunctionSource_getRandNeighbor3x3(size_t nBorderS
             "    const int nFrameHeight = " << oFrameSize.height << ";\n"
             "    ivec2 vNeighborPos = vCurrPos+_avNeighborPattern3x3[nRandVal%8];\n";
     if(nBorderSize>0) ssSrc <<
-                      "    clamp(vNeighborPos,ivec2(nBorderSize),ivec2(nFrameWidth-nBorderSize-1,nFrameHeight-nBorderSize-1));\n";
+                      "    vNeighborPos = clamp(vNeighborPos,ivec2(nBorderSize),ivec2(nFrameWidth-nBorderSize-1,nFrameHeight-nBorderSize-1));\n";
+    else ssSrc <<
+         "    vNeighborPos = clamp(vNeighborPos,ivec2(0),ivec2(nFrameWidth-1,nFrameHeight-1));\n";
+    ssSrc << "    return vNeighborPos;\n"
+            "}\n";
+    return ssSrc.str();
+}
+
+std::string GLShader::getShaderFunctionSource_getRandNeighbor5x5(size_t nBorderSize,const cv::Size& oFrameSize) {
+    std::stringstream ssSrc;
+    ssSrc << "const ivec2 _avNeighborPattern5x5[24] = ivec2[24](\n"
+            "    ivec2(-2, 2),ivec2(-1, 2),ivec2(0, 2),ivec2(1, 2),ivec2(2, 2),\n"
+            "    ivec2(-2, 1),ivec2(-1, 1),ivec2(0, 1),ivec2(1, 1),ivec2(2, 1),\n"
+            "    ivec2(-2, 0),ivec2(-1, 0),            ivec2(1, 0),ivec2(2, 0),\n"
+            "    ivec2(-2,-1),ivec2(-1,-1),ivec2(0,-1),ivec2(1,-1),ivec2(2,-1),\n"
+            "    ivec2(-2,-2),ivec2(-1,-2),ivec2(0,-2),ivec2(1,-2),ivec2(2,-2)\n"
+            ");\n"
+            "ivec2 getRandNeighbor5x5(in ivec2 vCurrPos, in uint nRandVal) {\n";
+    if(nBorderSize>0) ssSrc <<
+                      "    const int nBorderSize = " << nBorderSize << ";\n";
+    ssSrc << "    const int nFrameWidth = " << oFrameSize.width << ";\n"
+            "    const int nFrameHeight = " << oFrameSize.height << ";\n"
+            "    ivec2 vNeighborPos = vCurrPos+_avNeighborPattern5x5[nRandVal%24];\n";
+    if(nBorderSize>0) ssSrc <<
+                      "    vNeighborPos = clamp(vNeighborPos,ivec2(nBorderSize),ivec2(nFrameWidth-nBorderSize-1,nFrameHeight-nBorderSize-1));\n";
     else ssSrc <<
-         "    clamp(vNeighborPos,ivec2(0),ivec2(nFrameWidth-1,nFrameHeight-1));\n";
+         "    vNeighborPos = clamp(vNeighborPos,ivec2(0),ivec2(nFrameWidth-1,nFrameHeight-1));\n";
     ssSrc << "    return vNeighborPos;\n"
             "}\n";
     return ssSrc.str();
@@ -21,13 +21,151 @@ std::mutex lv::gl::Context::s_oGLFWErrorMessageMutex;
 std::string lv::gl::Context::s_sLatestGLFWErrorMessage;
 std::once_flag lv::gl::Context::s_oInitFlag;
 
+namespace {
+
+#if HAVE_EGL
+    /// returns the (lazily initialized) EGL display of the given device; displays are shared by all contexts & never terminated
+    EGLDisplay getEGLDisplay(size_t nDeviceIdx) {
+        static std::mutex s_oMutex;
+        static std::map<size_t,EGLDisplay> s_mDisplays;
+        std::lock_guard<std::mutex> oLock(s_oMutex);
+        auto pDisplayIter = s_mDisplays.find(nDeviceIdx);
+        if(pDisplayIter!=s_mDisplays.end())
+            return pDisplayIter->second;
+        EGLDisplay pDisplay = EGL_NO_DISPLAY;
+        const auto pQueryDevices = (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
+        const auto pGetPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if(pQueryDevices && pGetPlatformDisplay) {
+            EGLint nDevices = 0;
+            std::vector<EGLDeviceEXT> vpDevices(16);
+            if(pQueryDevices((EGLint)vpDevices.size(),vpDevices.data(),&nDevices) && nDeviceIdx<size_t(nDevices))
+                pDisplay = pGetPlatformDisplay(EGL_PLATFORM_DEVICE_EXT,vpDevices[nDeviceIdx],nullptr);
+        }
+        if(pDisplay==EGL_NO_DISPLAY && nDeviceIdx==0)
+            pDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY); // no device enumeration support, fall back to the default device
+        if(pDisplay==EGL_NO_DISPLAY)
+            lvError_("Failed to get EGL display for device #%d",(int)nDeviceIdx);
+        EGLint nVerMajor,nVerMinor;
+        if(!eglInitialize(pDisplay,&nVerMajor,&nVerMinor))
+            lvError_("Failed to init EGL display for device #%d [code=0x%x]",(int)nDeviceIdx,eglGetError());
+        s_mDisplays[nDeviceIdx] = pDisplay;
+        return pDisplay;
+    }
+#endif //HAVE_EGL
+
+    /// context owned by the calling thread via DeviceContextManager, with the device & size it was last set up for
+    struct ThreadContextData {
+        std::unique_ptr<lv::gl::Context> pContext;
+        size_t nDeviceIdx;
+        cv::Size oSize;
+    };
+
+    thread_local ThreadContextData t_oThreadContext;
+
+    template<typename TSeedGen>
+    void initTinyMT32Generators_internal(glm::uvec3 vGeneratorLayout, std::aligned_vector<lv::gl::TMT32GenParams,32>& voData, TSeedGen&& lSeedGen) {
+        static_assert(sizeof(lv::gl::TMT32GenParams)==sizeof(uint)*8 && sizeof(lv::TinyMT32)==sizeof(lv::gl::TMT32GenParams),"Hmmm...?");
+        lvAssert(vGeneratorLayout.x>0 && vGeneratorLayout.y>0 && vGeneratorLayout.z>0);
+        voData.resize(vGeneratorLayout.x*vGeneratorLayout.y*vGeneratorLayout.z);
+        // generators are stored in x-major order, and share their state layout & seeding with lv::TinyMT32
+        for(lv::gl::TMT32GenParams& oGenParams : voData) {
+            const lv::TinyMT32 oGen((uint32_t)lSeedGen());
+            std::copy(oGen.status,oGen.status+4,oGenParams.status);
+            oGenParams.mat1 = oGen.mat1;
+            oGenParams.mat2 = oGen.mat2;
+            oGenParams.tmat = oGen.tmat;
+            oGenParams.pad = oGen.pad;
+        }
+    }
+
+} // namespace
+
+size_t lv::gl::Context::getEGLDeviceCount() {
+#if HAVE_EGL
+    const auto pQueryDevices = (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
+    EGLint nDevices = 0;
+    if(pQueryDevices && pQueryDevices(0,nullptr,&nDevices))
+        return size_t(nDevices);
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY)!=EGL_NO_DISPLAY?1:0;
+#else //(!HAVE_EGL)
+    return 0;
+#endif //(!HAVE_EGL)
+}
+
+lv::gl::ContextBackend lv::gl::Context::getDefaultBackend() {
+#if HAVE_EGL
+#if !(HAVE_GLFW || HAVE_FREEGLUT)
+    return ContextBackend_EGL;
+#elif defined(__linux__)
+    if(!std::getenv("DISPLAY") && !std::getenv("WAYLAND_DISPLAY"))
+        return ContextBackend_EGL; // window managers cannot init without a display server
+#endif //defined(__linux__)
+#endif //HAVE_EGL
+    return ContextBackend_Window;
+}
+
 lv::gl::Context::Context(const cv::Size& oWinSize,
                          const std::string& sWinName,
                          bool bHide,
                          size_t nGLVerMajor,
-                         size_t nGLVerMinor) :
+                         size_t nGLVerMinor,
+                         ContextBackend eBackend,
+                         size_t nDeviceIdx) :
+#if HAVE_EGL
+        m_pEGLDisplay(EGL_NO_DISPLAY),
+        m_pEGLConfig(nullptr),
+        m_pEGLContext(EGL_NO_CONTEXT),
+        m_pEGLSurface(EGL_NO_SURFACE),
+#endif //HAVE_EGL
+        m_eBackend(eBackend==ContextBackend_Auto?getDefaultBackend():eBackend),
         m_nGLVerMajor(nGLVerMajor),
         m_nGLVerMinor(nGLVerMinor) {
+    if(m_eBackend==ContextBackend_EGL) {
+#if HAVE_EGL
+        m_pEGLDisplay = getEGLDisplay(nDeviceIdx);
+        if(!eglBindAPI(EGL_OPENGL_API))
+            lvError_("Failed to bind desktop GL API via EGL [code=0x%x]",eglGetError());
+        const EGLint anConfigAttribs[] = {
+            EGL_SURFACE_TYPE,EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE,EGL_OPENGL_BIT,
+            EGL_RED_SIZE,8,EGL_GREEN_SIZE,8,EGL_BLUE_SIZE,8,EGL_ALPHA_SIZE,8,
+            EGL_DEPTH_SIZE,24,
+            EGL_NONE
+        };
+        const EGLint anSurfacelessConfigAttribs[] = {
+            EGL_RENDERABLE_TYPE,EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        EGLint nConfigs = 0;
+        bool bUsePBuffer = eglChooseConfig(m_pEGLDisplay,anConfigAttribs,&m_pEGLConfig,1,&nConfigs) && nConfigs>0;
+        if(!bUsePBuffer) {
+            const char* acExtensions = eglQueryString(m_pEGLDisplay,EGL_EXTENSIONS);
+            if(!acExtensions || !std::strstr(acExtensions,"EGL_KHR_surfaceless_context"))
+                lvError("EGL display supports neither pbuffer surfaces nor surfaceless contexts");
+            if(!eglChooseConfig(m_pEGLDisplay,anSurfacelessConfigAttribs,&m_pEGLConfig,1,&nConfigs) || nConfigs<=0)
+                lvError_("Failed to find a desktop GL-renderable EGL config [code=0x%x]",eglGetError());
+        }
+        const EGLint anContextAttribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION,EGLint(nGLVerMajor),
+            EGL_CONTEXT_MINOR_VERSION,EGLint(nGLVerMinor),
+            EGL_CONTEXT_OPENGL_PROFILE_MASK,(nGLVerMajor>3 || (nGLVerMajor==3 && nGLVerMinor>=2))?EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT:EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+            EGL_NONE
+        };
+        m_pEGLContext = eglCreateContext(m_pEGLDisplay,m_pEGLConfig,EGL_NO_CONTEXT,anContextAttribs);
+        if(m_pEGLContext==EGL_NO_CONTEXT)
+            lvError_("Failed to create EGL context for core GL profile v%d.%d [code=0x%x]",(int)nGLVerMajor,(int)nGLVerMinor,eglGetError());
+        if(bUsePBuffer)
+            createEGLSurface(oWinSize);
+        setAsActive();
+        initGLEW(m_nGLVerMajor,m_nGLVerMinor);
+        return;
+#else //(!HAVE_EGL)
+        lvError("Framework was not compiled with EGL support");
+#endif //(!HAVE_EGL)
+    }
+#if !(HAVE_GLFW || HAVE_FREEGLUT)
+    lvError("Framework was not compiled with window manager support (only EGL contexts are available)");
+#endif //!(HAVE_GLFW || HAVE_FREEGLUT)
 #if HAVE_GLFW
     std::call_once(s_oInitFlag,[](){
         glfwSetErrorCallback(onGLFWErrorCallback);
@@ -64,7 +202,51 @@ lv::gl::Context::Context(const cv::Size& oWinSize,
     initGLEW(m_nGLVerMajor,m_nGLVerMinor);
 }
 
+lv::gl::Context::~Context() {
+#if HAVE_EGL
+    if(m_eBackend==ContextBackend_EGL) {
+        if(eglGetCurrentContext()==m_pEGLContext)
+            eglMakeCurrent(m_pEGLDisplay,EGL_NO_SURFACE,EGL_NO_SURFACE,EGL_NO_CONTEXT);
+        if(m_pEGLSurface!=EGL_NO_SURFACE)
+            eglDestroySurface(m_pEGLDisplay,m_pEGLSurface);
+        if(m_pEGLContext!=EGL_NO_CONTEXT)
+            eglDestroyContext(m_pEGLDisplay,m_pEGLContext);
+    }
+#endif //HAVE_EGL
+}
+
+#if HAVE_EGL
+void lv::gl::Context::createEGLSurface(const cv::Size& oSize) {
+    const EGLint anPBufferAttribs[] = {
+        EGL_WIDTH,std::max(oSize.width,1),
+        EGL_HEIGHT,std::max(oSize.height,1),
+        EGL_NONE
+    };
+    EGLSurface pNewSurface = eglCreatePbufferSurface(m_pEGLDisplay,m_pEGLConfig,anPBufferAttribs);
+    if(pNewSurface==EGL_NO_SURFACE)
+        lvError_("Failed to create [%d,%d] EGL pbuffer surface [code=0x%x]",oSize.width,oSize.height,eglGetError());
+    const bool bWasActive = m_pEGLSurface!=EGL_NO_SURFACE && eglGetCurrentContext()==m_pEGLContext;
+    if(m_pEGLSurface!=EGL_NO_SURFACE) {
+        if(bWasActive)
+            eglMakeCurrent(m_pEGLDisplay,EGL_NO_SURFACE,EGL_NO_SURFACE,EGL_NO_CONTEXT);
+        eglDestroySurface(m_pEGLDisplay,m_pEGLSurface);
+    }
+    m_pEGLSurface = pNewSurface;
+    if(bWasActive)
+        setAsActive();
+}
+#endif //HAVE_EGL
+
 void lv::gl::Context::setAsActive() {
+#if HAVE_EGL
+    if(m_eBackend==ContextBackend_EGL) {
+        // the bound API & current context are both per-thread EGL states
+        eglBindAPI(EGL_OPENGL_API);
+        if(!eglMakeCurrent(m_pEGLDisplay,m_pEGLSurface,m_pEGLSurface,m_pEGLContext))
+            lvError_("Failed to make EGL context current [code=0x%x]",eglGetError());
+        return;
+    }
+#endif //HAVE_EGL
 #if HAVE_GLFW
     glfwMakeContextCurrent(m_pWindowHandle.get());
 #elif HAVE_FREEGLUT
@@ -73,6 +255,8 @@ void lv::gl::Context::setAsActive() {
 }
 
 void lv::gl::Context::setWindowVisibility(bool bVal) {
+    if(m_eBackend==ContextBackend_EGL)
+        return; // headless, nothing to show
 #if HAVE_GLFW
     if(bVal)
         glfwShowWindow(m_pWindowHandle.get());
@@ -88,12 +272,21 @@ void lv::gl::Context::setWindowVisibility(bool bVal) {
 }
 
 void lv::gl::Context::setWindowSize(const cv::Size& oSize, bool bUpdateViewport) {
+#if HAVE_EGL
+    if(m_eBackend==ContextBackend_EGL) {
+        if(m_pEGLSurface!=EGL_NO_SURFACE)
+            createEGLSurface(oSize);
+    }
+    else
+#endif //HAVE_EGL
+    {
 #if HAVE_GLFW
     glfwSetWindowSize(m_pWindowHandle.get(),oSize.width,oSize.height);
 #elif HAVE_FREEGLUT
     glutSetWindow(m_oWindowHandle.get().m_nHandle);
         glutReshapeWindow(oSize.width,oSize.height);
 #endif //HAVE_FREEGLUT
+    }
     if(bUpdateViewport)
         glViewport(0,0,oSize.width,oSize.height);
 }
@@ -104,44 +297,69 @@ std::string lv::gl::Context::getLatestErrorMessage() { // also clears the latest
     std::string sErrMsg;
     std::swap(sErrMsg,s_sLatestGLFWErrorMessage);
     return sErrMsg;
-#elif HAVE_FREEGLUT
-    return std::string(); // glut gives no custom error messages...
-#endif //HAVE_FREEGLUT
+#else //(!HAVE_GLFW)
+    return std::string(); // glut/egl give no custom error messages...
+#endif //(!HAVE_GLFW)
 }
 
 bool lv::gl::Context::pollEventsAndCheckIfShouldClose() {
+    if(m_eBackend==ContextBackend_EGL)
+        return false; // no window, no events
 #if HAVE_GLFW
     glfwPollEvents();
     return glfwWindowShouldClose(m_pWindowHandle.get())!=0;
 #elif HAVE_FREEGLUT
     return glutGetWindow()!=0; // not ideal, but there is nothing else...
-#endif //HAVE_FREEGLUT
+#else //!(HAVE_GLFW || HAVE_FREEGLUT)
+    return false;
+#endif //!(HAVE_GLFW || HAVE_FREEGLUT)
 }
 
 bool lv::gl::Context::getKeyPressed(char nKeyID) {
+    if(m_eBackend==ContextBackend_EGL)
+        return false;
 #if HAVE_GLFW
     return glfwGetKey(m_pWindowHandle.get(),nKeyID)==GLFW_PRESS; // will not capture special keys (need custom define)
-#elif HAVE_FREEGLUT
+#else //(!HAVE_GLFW)
+    lvIgnore(nKeyID);
     return false; // seriously, ditch glut
-#endif //HAVE_FREEGLUT
+#endif //(!HAVE_GLFW)
 }
 
 void lv::gl::Context::swapBuffers(int nClearFlags) {
+#if HAVE_EGL
+    if(m_eBackend==ContextBackend_EGL) {
+        if(m_pEGLSurface!=EGL_NO_SURFACE)
+            eglSwapBuffers(m_pEGLDisplay,m_pEGLSurface); // no-op for pbuffers, but keeps frame pacing semantics
+    }
+    else
+#endif //HAVE_EGL
+    {
 #if HAVE_GLFW
     glfwSwapBuffers(m_pWindowHandle.get());
 #elif HAVE_FREEGLUT
     glutSetWindow(m_oWindowHandle.get().m_nHandle);
         glutSwapBuffers();
 #endif //HAVE_FREEGLUT
+    }
     if(nClearFlags!=0)
         glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
 }
 
 void lv::gl::Context::initGLEW(size_t nGLVerMajor, size_t nGLVerMinor) {
     glErrorCheck;
+    // glew entrypoints are process-wide, and contexts may be created by several worker threads at once
+    static std::mutex s_oGLEWInitMutex;
+    std::mutex_lock_guard oLock(s_oGLEWInitMutex);
     glewExperimental = GLEW_EXPERIMENTAL?GL_TRUE:GL_FALSE;
     const GLenum glewerrn = glewInit();
-    if(glewerrn!=GLEW_OK)
+#if HAVE_EGL && defined(GLEW_ERROR_NO_GLX_DISPLAY)
+    // GLX-based glew builds complain when contexts come from EGL, but core/ext entrypoints are still loaded fine
+    const bool bGLEWInitOK = (glewerrn==GLEW_OK) || (glewerrn==GLEW_ERROR_NO_GLX_DISPLAY && eglGetCurrentContext()!=EGL_NO_CONTEXT);
+#else //!(HAVE_EGL && defined(GLEW_ERROR_NO_GLX_DISPLAY))
+    const bool bGLEWInitOK = (glewerrn==GLEW_OK);
+#endif //!(HAVE_EGL && defined(GLEW_ERROR_NO_GLX_DISPLAY))
+    if(!bGLEWInitOK)
         lvError_("Failed to init GLEW [code=%d, msg=%s]",glewerrn,glewGetErrorString(glewerrn));
     const GLenum errn = glGetError();
     // see glew init GL_INVALID_ENUM bug discussion at https://www.opengl.org/wiki/OpenGL_Loading_Library
@@ -152,6 +370,33 @@ void lv::gl::Context::initGLEW(size_t nGLVerMajor, size_t nGLVerMinor) {
         lvError_("Bad GL core/ext version detected (target is %s)",sGLEWVersionString.c_str());
 }
 
+size_t lv::gl::DeviceContextManager::getDeviceCount() {
+    return std::max(Context::getEGLDeviceCount(),size_t(1));
+}
+
+lv::gl::Context& lv::gl::DeviceContextManager::getThreadContext(size_t nDeviceIdx, const cv::Size& oSize, const std::string& sName, bool bHide) {
+    ThreadContextData& oData = t_oThreadContext;
+    if(!oData.pContext || oData.nDeviceIdx!=nDeviceIdx) {
+        const size_t nDevices = getDeviceCount();
+        lvAssert_(nDeviceIdx<nDevices,"gl device index out of range");
+        oData.pContext = nullptr; // previous context must be released before the new one becomes current
+        oData.pContext = std::make_unique<Context>(oSize,sName,bHide,TARGET_GL_VER_MAJOR,TARGET_GL_VER_MINOR,nDevices>1?ContextBackend_EGL:ContextBackend_Auto,nDeviceIdx);
+        oData.nDeviceIdx = nDeviceIdx;
+        oData.oSize = oSize;
+        return *oData.pContext;
+    }
+    oData.pContext->setAsActive();
+    if(oData.oSize!=oSize) {
+        oData.pContext->setWindowSize(oSize);
+        oData.oSize = oSize;
+    }
+    return *oData.pContext;
+}
+
+void lv::gl::DeviceContextManager::releaseThreadContext() {
+    t_oThreadContext.pContext = nullptr;
+}
+
 cv::Mat lv::gl::deepCopyImage(GLsizei nWidth,GLsizei nHeight,GLvoid* pData,GLenum eDataFormat,GLenum eDataType) {
     lvAssert(nWidth>0 && nHeight>0 && pData);
     const int nDepth = getMatDepthFromDataType(eDataType);
@@ -197,38 +442,10 @@ std::string lv::gl::addLineNumbersToString(const std::string& sSrc, bool bPrefix
 }
 
 void lv::gl::TMT32GenParams::initTinyMT32Generators(glm::uvec3 vGeneratorLayout,std::aligned_vector<lv::gl::TMT32GenParams,32>& voData) {
-    static_assert(sizeof(TMT32GenParams)==sizeof(uint)*8,"Hmmm...?");
-    lvAssert(vGeneratorLayout.x>0 && vGeneratorLayout.y>0 && vGeneratorLayout.z>0);
-    voData.resize(vGeneratorLayout.x*vGeneratorLayout.y*vGeneratorLayout.z);
-    TMT32GenParams* pData = voData.data();
-    // tinymt32dc:cecf43a2417bd5c41e5d6f80cf2ce903,32,1337,f20d1b78,ff90ffe5,30fbdfff,65,0
-    for(size_t z=0; z<vGeneratorLayout.z; ++z) {
-        const size_t nStepSize_Z = z*vGeneratorLayout.y*vGeneratorLayout.x;
-        for(size_t y=0; y<vGeneratorLayout.y; ++y) {
-            const size_t nStepSize_Y = y*vGeneratorLayout.x + nStepSize_Z;
-            for(size_t x=0; x<vGeneratorLayout.x; ++x) {
-                const size_t nStepSize_X = x + nStepSize_Y;
-                TMT32GenParams* pCurrGenParams = pData+nStepSize_X;
-                pCurrGenParams->status[0] = (uint)rand();
-                pCurrGenParams->status[1] = pCurrGenParams->mat1 = 0xF20D1B78;
-                pCurrGenParams->status[2] = pCurrGenParams->mat2 = 0xFF90FFE5;
-                pCurrGenParams->status[3] = pCurrGenParams->tmat = 0x30FBDFFF;
-                pCurrGenParams->pad = 1337;
-                for(int nLoop=1; nLoop<8; ++nLoop)
-                    pCurrGenParams->status[nLoop&3] ^= nLoop+UINT32_C(1812433253)*((pCurrGenParams->status[(nLoop-1)&3])^(pCurrGenParams->status[(nLoop-1)&3]>>30));
-                for(int nLoop=0; nLoop<8; ++nLoop) {
-                    uint s0 = pCurrGenParams->status[3];
-                    uint s1 = (pCurrGenParams->status[0]&UINT32_C(0x7fffffff))^(pCurrGenParams->status[1])^(pCurrGenParams->status[2]);
-                    s1 ^= (s1<<1);
-                    s0 ^= (s0>>1)^s1;
-                    pCurrGenParams->status[0] = pCurrGenParams->status[1];
-                    pCurrGenParams->status[1] = pCurrGenParams->status[2];
-                    pCurrGenParams->status[2] = s1^(s0<<10);
-                    pCurrGenParams->status[3] = s0;
-                    pCurrGenParams->status[1] ^= -((int)(s0&1))&(pCurrGenParams->mat1);
-                    pCurrGenParams->status[2] ^= -((int)(s0&1))&(pCurrGenParams->mat2);
-                }
-            }
-        }
-    }
+    initTinyMT32Generators_internal(vGeneratorLayout,voData,[](){return (uint)rand();});
+}
+
+void lv::gl::TMT32GenParams::initTinyMT32Generators(glm::uvec3 vGeneratorLayout,std::aligned_vector<lv::gl::TMT32GenParams,32>& voData,uint32_t nSeed) {
+    lv::PCG32 oSeedGen(nSeed);
+    initTinyMT32Generators_internal(vGeneratorLayout,voData,oSeedGen);
 }
@@ -0,0 +1,256 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/utils/parallel.hpp"
+
+lv::SIMDInstrSet lv::getSupportedSIMDInstrSet() {
+    static const SIMDInstrSet s_eInstrSet = []() {
+        if(cv::checkHardwareSupport(CV_CPU_AVX_512BW))
+            return SIMD_AVX512BW;
+        if(cv::checkHardwareSupport(CV_CPU_AVX2))
+            return SIMD_AVX2;
+        if(cv::checkHardwareSupport(CV_CPU_SSE4_1))
+            return SIMD_SSE4_1;
+        if(cv::checkHardwareSupport(CV_CPU_SSE2))
+            return SIMD_SSE2;
+        return SIMD_None;
+    }();
+    return s_eInstrSet;
+}
+
+namespace {
+
+    /// packs a [begin,end) chunk index range in a single 64-bit word (so it can be popped/stolen w/ a single compare-and-swap)
+    constexpr uint64_t packRange(uint64_t nBegin, uint64_t nEnd) {return (nBegin<<32)|nEnd;}
+
+    /// per-participant range of unclaimed chunks (padded to a cache line to avoid false sharing between owners & thieves)
+    struct RangeSlot {
+        std::atomic<uint64_t> nRange;
+        char anPadding[64-sizeof(std::atomic<uint64_t>)];
+    };
+
+    /// data-parallel loop shared by its caller & helpers; lives on the caller's stack until all helpers detach
+    struct ParallelJob {
+        const std::function<void(size_t,size_t)>* plRangeTask;
+        size_t nBegin,nEnd,nGrain;
+        std::vector<RangeSlot> vSlots;
+        size_t nMaxHelpers; ///< max number of attached helpers (pool thread count minus the caller)
+        size_t nHelpers; ///< number of currently attached helpers (guarded by the scheduler mutex)
+        std::atomic_bool bCancelled;
+        std::exception_ptr pException; ///< first exception thrown by a task (guarded by the scheduler mutex)
+    };
+
+    /// process-wide work-stealing scheduler; jobs are split in per-participant chunk ranges that are popped by their owners and halved by thieves
+    struct WorkStealingScheduler {
+        WorkStealingScheduler() :
+                m_nJobEpoch(0),
+                m_bIsActive(true) {
+            const size_t nWorkers = std::max((size_t)std::thread::hardware_concurrency(),size_t(1))-1;
+            for(size_t nWorkerIdx=0; nWorkerIdx<nWorkers; ++nWorkerIdx)
+                m_vhWorkers.emplace_back(&WorkStealingScheduler::entry,this,int(nWorkerIdx));
+        }
+        ~WorkStealingScheduler() {
+            {
+                std::mutex_lock_guard oLock(m_oSyncMutex);
+                m_bIsActive = false;
+            }
+            m_oWorkSyncVar.notify_all();
+            for(std::thread& oWorker : m_vhWorkers)
+                oWorker.join();
+        }
+        size_t getWorkerCount() const {
+            return m_vhWorkers.size();
+        }
+        void run(ParallelJob& oJob) {
+            if(oJob.nMaxHelpers>0) {
+                {
+                    std::mutex_lock_guard oLock(m_oSyncMutex);
+                    m_vpJobs.push_back(&oJob);
+                    ++m_nJobEpoch;
+                }
+                m_oWorkSyncVar.notify_all();
+            }
+            work(oJob,0); // the caller always owns the first slot
+            if(oJob.nMaxHelpers>0) {
+                // helpers may still be running private (stolen) ranges; the job must outlive them
+                std::mutex_unique_lock oLock(m_oSyncMutex);
+                m_vpJobs.erase(std::find(m_vpJobs.begin(),m_vpJobs.end(),&oJob));
+                m_oDoneSyncVar.wait(oLock,[&]{return oJob.nHelpers==0;});
+            }
+            if(oJob.pException)
+                std::rethrow_exception(oJob.pException);
+        }
+    private:
+        static bool hasWork(const ParallelJob& oJob) {
+            for(const RangeSlot& oSlot : oJob.vSlots) {
+                const uint64_t nRange = oSlot.nRange.load(std::memory_order_relaxed);
+                if((nRange>>32)<(nRange&0xFFFFFFFF))
+                    return true;
+            }
+            return false;
+        }
+        /// claims chunks for the given slot owner: pops one chunk from its own slot, or steals half of another slot's range
+        static bool claim(ParallelJob& oJob, size_t nSlotIdx, size_t& nFirstChunk, size_t& nLastChunk) {
+            std::atomic<uint64_t>& nOwnRange = oJob.vSlots[nSlotIdx].nRange;
+            uint64_t nRange = nOwnRange.load();
+            while((nRange>>32)<(nRange&0xFFFFFFFF)) {
+                if(nOwnRange.compare_exchange_weak(nRange,packRange((nRange>>32)+1,nRange&0xFFFFFFFF))) {
+                    nFirstChunk = size_t(nRange>>32);
+                    nLastChunk = nFirstChunk+1;
+                    return true;
+                }
+            }
+            const size_t nSlots = oJob.vSlots.size();
+            for(size_t nVictimOffset=1; nVictimOffset<nSlots; ++nVictimOffset) {
+                std::atomic<uint64_t>& nVictimRange = oJob.vSlots[(nSlotIdx+nVictimOffset)%nSlots].nRange;
+                uint64_t nVictimVal = nVictimRange.load();
+                while((nVictimVal>>32)<(nVictimVal&0xFFFFFFFF)) {
+                    const uint64_t nBegin = nVictimVal>>32, nEnd = nVictimVal&0xFFFFFFFF;
+                    const uint64_t nStolenBegin = nEnd-(nEnd-nBegin+1)/2;
+                    if(nVictimRange.compare_exchange_weak(nVictimVal,packRange(nBegin,nStolenBegin))) {
+                        nFirstChunk = size_t(nStolenBegin);
+                        nLastChunk = size_t(nEnd);
+                        // all but the first stolen chunk are republished in the (empty) own slot, so they can be stolen in turn
+                        uint64_t nEmptyRange = nOwnRange.load();
+                        if(nLastChunk-nFirstChunk>1 && (nEmptyRange>>32)>=(nEmptyRange&0xFFFFFFFF) &&
+                           nOwnRange.compare_exchange_strong(nEmptyRange,packRange(nStolenBegin+1,nEnd)))
+                            nLastChunk = nFirstChunk+1;
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+        void work(ParallelJob& oJob, size_t nSlotIdx) {
+            size_t nFirstChunk, nLastChunk;
+            while(claim(oJob,nSlotIdx,nFirstChunk,nLastChunk)) {
+                for(size_t nChunkIdx=nFirstChunk; nChunkIdx<nLastChunk; ++nChunkIdx) {
+                    if(oJob.bCancelled.load(std::memory_order_relaxed))
+                        break;
+                    const size_t nChunkBegin = oJob.nBegin+nChunkIdx*oJob.nGrain;
+                    try {
+                        (*oJob.plRangeTask)(nChunkBegin,std::min(nChunkBegin+oJob.nGrain,oJob.nEnd));
+                    }
+                    catch(...) {
+                        std::mutex_lock_guard oLock(m_oSyncMutex);
+                        if(!oJob.pException)
+                            oJob.pException = std::current_exception();
+                        oJob.bCancelled = true;
+                    }
+                }
+            }
+        }
+        void entry(int nWorkerIdx) {
+            lv::ApplyThreadPlacementPolicy(lv::ThreadRole_Worker);
+            std::mutex_unique_lock oLock(m_oSyncMutex);
+            size_t nLastJobEpoch = 0;
+            while(true) {
+                nLastJobEpoch = m_nJobEpoch;
+                ParallelJob* pJob = nullptr;
+                for(ParallelJob* pCurrJob : m_vpJobs) {
+                    if(pCurrJob->nHelpers<pCurrJob->nMaxHelpers && hasWork(*pCurrJob)) {
+                        pJob = pCurrJob;
+                        break;
+                    }
+                }
+                if(!pJob) {
+                    m_oWorkSyncVar.wait(oLock,[&]{return !m_bIsActive || m_nJobEpoch!=nLastJobEpoch;});
+                    if(!m_bIsActive)
+                        return;
+                    continue;
+                }
+                ++pJob->nHelpers;
+                {
+                    std::unlock_guard<std::mutex_unique_lock> oUnlock(oLock);
+                    // helpers share the non-caller slots (all slot operations are compare-and-swaps, so sharing is safe)
+                    work(*pJob,pJob->vSlots.size()>1?1+(size_t(nWorkerIdx)%(pJob->vSlots.size()-1)):0);
+                }
+                if(--pJob->nHelpers==0)
+                    m_oDoneSyncVar.notify_all();
+            }
+        }
+        std::vector<std::thread> m_vhWorkers;
+        std::mutex m_oSyncMutex;
+        std::condition_variable m_oWorkSyncVar,m_oDoneSyncVar;
+        std::vector<ParallelJob*> m_vpJobs;
+        size_t m_nJobEpoch;
+        bool m_bIsActive;
+    };
+
+    WorkStealingScheduler& getScheduler() {
+        static WorkStealingScheduler s_oScheduler;
+        return s_oScheduler;
+    }
+
+} // anonymous namespace
+
+lv::ThreadPool::ThreadPool(size_t nThreads) :
+        m_nThreadCount(nThreads?nThreads:std::max((size_t)std::thread::hardware_concurrency(),size_t(1))) {}
+
+void lv::ThreadPool::parallel_for(size_t nTasks, const std::function<void(size_t)>& lTask) {
+    parallel_for(0,nTasks,1,[&](size_t nTaskBegin, size_t nTaskEnd) {
+        for(size_t nTaskIdx=nTaskBegin; nTaskIdx<nTaskEnd; ++nTaskIdx)
+            lTask(nTaskIdx);
+    });
+}
+
+void lv::ThreadPool::parallel_for(size_t nBegin, size_t nEnd, size_t nGrain, const std::function<void(size_t,size_t)>& lRangeTask) {
+    lvAssert_(nGrain>0,"grain size must be positive");
+    if(nEnd<=nBegin)
+        return;
+    const size_t nChunks = (nEnd-nBegin+nGrain-1)/nGrain;
+    lvAssert_(nChunks<size_t(UINT32_MAX),"too many chunks for packed chunk ranges");
+    WorkStealingScheduler& oScheduler = getScheduler();
+    const size_t nSlots = std::min(std::min(m_nThreadCount,oScheduler.getWorkerCount()+1),nChunks);
+    if(nSlots<=1) {
+        lRangeTask(nBegin,nEnd);
+        return;
+    }
+    ParallelJob oJob;
+    oJob.plRangeTask = &lRangeTask;
+    oJob.nBegin = nBegin;
+    oJob.nEnd = nEnd;
+    oJob.nGrain = nGrain;
+    oJob.vSlots = std::vector<RangeSlot>(nSlots);
+    for(size_t nSlotIdx=0; nSlotIdx<nSlots; ++nSlotIdx) // chunks are initially split evenly between participants
+        oJob.vSlots[nSlotIdx].nRange = packRange(nSlotIdx*nChunks/nSlots,(nSlotIdx+1)*nChunks/nSlots);
+    oJob.nMaxHelpers = nSlots-1;
+    oJob.nHelpers = 0;
+    oJob.bCancelled = false;
+    oScheduler.run(oJob);
+}
+
+lv::ThreadPool& lv::ThreadPool::getShared() {
+    static ThreadPool s_oSharedPool(0);
+    return s_oSharedPool;
+}
+
+void lv::parallel_for(size_t nBegin, size_t nEnd, size_t nGrain, const std::function<void(size_t,size_t)>& lRangeTask) {
+    ThreadPool::getShared().parallel_for(nBegin,nEnd,nGrain,lRangeTask);
+}
+
+void lv::parallel_for_2d(const cv::Rect& oRange, const cv::Size& oGrain, const std::function<void(const cv::Rect&)>& lBlockTask) {
+    lvAssert_(oGrain.width>0 && oGrain.height>0,"grain size must be positive");
+    if(oRange.area()<=0)
+        return;
+    const int nBlockCols = (oRange.width+oGrain.width-1)/oGrain.width;
+    const int nBlockRows = (oRange.height+oGrain.height-1)/oGrain.height;
+    ThreadPool::getShared().parallel_for(size_t(nBlockCols*nBlockRows),[&](size_t nBlockIdx) {
+        const cv::Rect oBlock(oRange.x+int(nBlockIdx%nBlockCols)*oGrain.width,oRange.y+int(nBlockIdx/nBlockCols)*oGrain.height,oGrain.width,oGrain.height);
+        lBlockTask(oBlock&oRange);
+    });
+}
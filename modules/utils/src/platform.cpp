@@ -16,6 +16,199 @@
 // limitations under the License.
 
 #include "litiv/utils/platform.hpp"
+#if !defined(_MSC_VER)
+#include <sys/syscall.h>
+#include <pthread.h>
+#include <sched.h>
+#endif //(!defined(_MSC_VER))
+
+// local define used to specify the huge page size targeted by large allocations on non-windows platforms
+#define LARGE_MEM_HUGE_PAGE_SIZE (size_t(2)<<20)
+// local define used to specify the max NUMA node count supported for memory binding
+#define LARGE_MEM_MAX_NUMA_NODES (64)
+
+lv::FrameArena::FrameArena(size_t nInitBlockSize) :
+        m_nCurrBlockIdx(0),
+        m_nCurrBlockOffset(0),
+        m_nUsedBytes(0) {
+    m_vBlocks.emplace_back(std::max(nInitBlockSize,size_t(64)));
+}
+
+namespace {
+
+    /// registry of all live memory tracker tags, along with the untagged usage counters
+    struct MemoryTrackerRegistry {
+        std::mutex m_oMutex;
+        std::set<lv::MemoryTracker::Tag*> m_spTags;
+        std::atomic_size_t m_nUntaggedCurrBytes{0},m_nUntaggedPeakBytes{0},m_nUntaggedAllocCount{0};
+    };
+
+    MemoryTrackerRegistry& getMemoryTrackerRegistry() {
+        // never destroyed, as tracked blocks may be released during static destruction
+        static MemoryTrackerRegistry* s_pRegistry = new MemoryTrackerRegistry();
+        return *s_pRegistry;
+    }
+
+    thread_local lv::MemoryTracker::Tag* g_pCurrMemoryTag = nullptr;
+
+    /// adds nBytes to a current usage counter, and raises the associated peak if needed
+    void addMemoryUsage(std::atomic_size_t& nCurrBytes, std::atomic_size_t& nPeakBytes, size_t nBytes) {
+        const size_t nNewBytes = nCurrBytes.fetch_add(nBytes,std::memory_order_relaxed)+nBytes;
+        size_t nPrevPeakBytes = nPeakBytes.load(std::memory_order_relaxed);
+        while(nNewBytes>nPrevPeakBytes && !nPeakBytes.compare_exchange_weak(nPrevPeakBytes,nNewBytes,std::memory_order_relaxed));
+    }
+
+    /// process-wide thread placement policies, lazily initialized from the environment
+    struct ThreadPlacementRegistry {
+        std::mutex m_oMutex;
+        std::array<lv::ThreadPlacementPolicy,lv::nThreadRoleCount> m_aPolicies;
+        std::array<bool,lv::nThreadRoleCount> m_abInitialized{};
+    };
+
+    ThreadPlacementRegistry& getThreadPlacementRegistry() {
+        static ThreadPlacementRegistry s_oRegistry;
+        return s_oRegistry;
+    }
+
+    /// suffixes used for the LITIV_THREAD_AFFINITY_<ROLE> and LITIV_THREAD_PRIORITY_<ROLE> env vars
+    const char* getThreadRoleEnvName(lv::ThreadRole eRole) {
+        static const std::array<const char*,lv::nThreadRoleCount> s_asNames = {"WORKER","PRECACHER","WRITER","ANALYSIS"};
+        return s_asNames[eRole];
+    }
+
+} // anonymous namespace
+
+constexpr const char* lv::MemoryTracker::s_sUntaggedName;
+
+lv::MemoryTracker::TagPtr lv::MemoryTracker::createTag(const std::string& sName, const void* pOwner) {
+    MemoryTrackerRegistry& oRegistry = getMemoryTrackerRegistry();
+    std::array<char,32> acOwnerBuffer = {};
+    if(pOwner)
+        snprintf(acOwnerBuffer.data(),acOwnerBuffer.size()," [%p]",pOwner);
+    Tag* pTag = new Tag(sName+acOwnerBuffer.data());
+    {
+        std::mutex_lock_guard oLock(oRegistry.m_oMutex);
+        oRegistry.m_spTags.insert(pTag);
+    }
+    return TagPtr(pTag,&MemoryTracker::releaseRef); // the handle owns the initial reference
+}
+
+lv::MemoryTracker::Tag* lv::MemoryTracker::getCurrentTag() {
+    return g_pCurrMemoryTag;
+}
+
+lv::MemoryTracker::Tag* lv::MemoryTracker::onAlloc(Tag* pTag, size_t nBytes) {
+    if(pTag) {
+        addRef(pTag);
+        addMemoryUsage(pTag->m_nCurrBytes,pTag->m_nPeakBytes,nBytes);
+        pTag->m_nAllocCount.fetch_add(1,std::memory_order_relaxed);
+    }
+    else {
+        MemoryTrackerRegistry& oRegistry = getMemoryTrackerRegistry();
+        addMemoryUsage(oRegistry.m_nUntaggedCurrBytes,oRegistry.m_nUntaggedPeakBytes,nBytes);
+        oRegistry.m_nUntaggedAllocCount.fetch_add(1,std::memory_order_relaxed);
+    }
+    return pTag;
+}
+
+void lv::MemoryTracker::onFree(Tag* pTag, size_t nBytes) {
+    if(pTag) {
+        pTag->m_nCurrBytes.fetch_sub(nBytes,std::memory_order_relaxed);
+        releaseRef(pTag);
+    }
+    else
+        getMemoryTrackerRegistry().m_nUntaggedCurrBytes.fetch_sub(nBytes,std::memory_order_relaxed);
+}
+
+std::vector<lv::MemoryTracker::Usage> lv::MemoryTracker::getUsage() {
+    MemoryTrackerRegistry& oRegistry = getMemoryTrackerRegistry();
+    std::vector<Usage> voUsage;
+    {
+        std::mutex_lock_guard oLock(oRegistry.m_oMutex);
+        for(Tag* pTag : oRegistry.m_spTags)
+            voUsage.push_back(getUsage(*pTag));
+    }
+    std::stable_sort(voUsage.begin(),voUsage.end(),[](const Usage& a, const Usage& b){return a.sName<b.sName;});
+    voUsage.push_back(Usage{s_sUntaggedName,oRegistry.m_nUntaggedCurrBytes.load(std::memory_order_relaxed),oRegistry.m_nUntaggedPeakBytes.load(std::memory_order_relaxed),oRegistry.m_nUntaggedAllocCount.load(std::memory_order_relaxed)});
+    return voUsage;
+}
+
+lv::MemoryTracker::Usage lv::MemoryTracker::getUsage(const Tag& oTag) {
+    return Usage{oTag.m_sName,oTag.m_nCurrBytes.load(std::memory_order_relaxed),oTag.m_nPeakBytes.load(std::memory_order_relaxed),oTag.m_nAllocCount.load(std::memory_order_relaxed)};
+}
+
+std::string lv::MemoryTracker::getReport() {
+    std::stringstream ssStr;
+    ssStr << std::fixed << std::setprecision(2);
+    for(const Usage& oUsage : getUsage())
+        ssStr << std::setw(40) << std::left << oUsage.sName << std::right << " : " << std::setw(10) << double(oUsage.nCurrBytes)/(1024*1024) << " mb (peak = " << std::setw(10) << double(oUsage.nPeakBytes)/(1024*1024) << " mb, " << oUsage.nAllocCount << " allocations)\n";
+    return ssStr.str();
+}
+
+lv::MemoryTracker::Scope::Scope(const TagPtr& pTag) :
+        m_pTag(pTag.get()),
+        m_pPrevTag(g_pCurrMemoryTag) {
+    if(m_pTag)
+        addRef(m_pTag);
+    g_pCurrMemoryTag = m_pTag;
+}
+
+lv::MemoryTracker::Scope::~Scope() {
+    g_pCurrMemoryTag = m_pPrevTag;
+    if(m_pTag)
+        releaseRef(m_pTag);
+}
+
+void lv::MemoryTracker::addRef(Tag* pTag) {
+    pTag->m_nRefCount.fetch_add(1,std::memory_order_relaxed);
+}
+
+void lv::MemoryTracker::releaseRef(Tag* pTag) {
+    if(pTag->m_nRefCount.fetch_sub(1,std::memory_order_acq_rel)==1) {
+        MemoryTrackerRegistry& oRegistry = getMemoryTrackerRegistry();
+        {
+            std::mutex_lock_guard oLock(oRegistry.m_oMutex);
+            oRegistry.m_spTags.erase(pTag);
+        }
+        delete pTag;
+    }
+}
+
+void* lv::FrameArena::allocate(size_t nBytes, size_t nByteAlign) {
+    lvDbgAssert(nByteAlign>0 && nByteAlign<=64 && (nByteAlign&(nByteAlign-1))==0);
+    while(true) {
+        Block& vBlock = m_vBlocks[m_nCurrBlockIdx];
+        const size_t nAlignedOffset = (m_nCurrBlockOffset+nByteAlign-1)&~(nByteAlign-1);
+        if(nAlignedOffset+nBytes<=vBlock.size()) {
+            m_nUsedBytes += nAlignedOffset+nBytes-m_nCurrBlockOffset;
+            m_nCurrBlockOffset = nAlignedOffset+nBytes;
+            return vBlock.data()+nAlignedOffset;
+        }
+        // the current block tail is wasted until the next reset, which merges all used blocks
+        m_nUsedBytes += vBlock.size()-m_nCurrBlockOffset;
+        m_nCurrBlockOffset = 0;
+        if(++m_nCurrBlockIdx==m_vBlocks.size())
+            m_vBlocks.emplace_back(std::max(nBytes,m_vBlocks.back().size()*2));
+    }
+}
+
+void lv::FrameArena::reset() {
+    if(m_nCurrBlockIdx>0) {
+        const size_t nCapacity = getCapacity();
+        m_vBlocks.clear();
+        m_vBlocks.emplace_back(nCapacity);
+    }
+    m_nCurrBlockIdx = 0;
+    m_nCurrBlockOffset = 0;
+    m_nUsedBytes = 0;
+}
+
+size_t lv::FrameArena::getCapacity() const {
+    size_t nCapacity = 0;
+    for(const Block& vBlock : m_vBlocks)
+        nCapacity += vBlock.size();
+    return nCapacity;
+}
 
 std::string lv::GetCurrentWorkDirPath() {
     static std::array<char,FILENAME_MAX> s_acCurrentPath = {};
@@ -175,6 +368,21 @@ bool lv::CreateDirIfNotExist(const std::string& sDirPath) {
 #endif //(!defined(_MSC_VER))
 }
 
+bool lv::GetFileStats(const std::string& sPath, int64_t& nModifTime, int64_t& nSize) {
+#if defined(_MSC_VER)
+    struct _stat64 st;
+    if(_stat64(sPath.c_str(),&st)!=0)
+        return false;
+#else //(!defined(_MSC_VER))
+    struct stat st;
+    if(stat(sPath.c_str(),&st)!=0)
+        return false;
+#endif //(!defined(_MSC_VER))
+    nModifTime = int64_t(st.st_mtime);
+    nSize = int64_t(st.st_size);
+    return true;
+}
+
 std::fstream lv::CreateBinFileWithPrealloc(const std::string & sFilePath, size_t nPreallocBytes, bool bZeroInit) {
     std::fstream ssFile(sFilePath,std::ios::out|std::ios::in|std::ios::ate|std::ios::binary);
     if(!ssFile.is_open())
@@ -198,6 +406,134 @@ std::fstream lv::CreateBinFileWithPrealloc(const std::string & sFilePath, size_t
     return ssFile;
 }
 
+lv::MappedFile::MappedFile(const std::string& sFilePath) :
+        m_pData(nullptr),m_nSize(0) {
+#if defined(_MSC_VER)
+    m_hFile = CreateFileA(sFilePath.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL|FILE_FLAG_RANDOM_ACCESS,nullptr);
+    lvAssert__(m_hFile!=INVALID_HANDLE_VALUE,"could not open file at '%s'",sFilePath.c_str());
+    LARGE_INTEGER nFileSize;
+    lvAssert__(GetFileSizeEx(m_hFile,&nFileSize) && nFileSize.QuadPart>0,"could not query size of file at '%s'",sFilePath.c_str());
+    m_nSize = size_t(nFileSize.QuadPart);
+    m_hMapping = CreateFileMapping(m_hFile,nullptr,PAGE_READONLY,0,0,nullptr);
+    lvAssert__(m_hMapping!=nullptr,"could not create mapping for file at '%s'",sFilePath.c_str());
+    m_pData = (const uint8_t*)MapViewOfFile(m_hMapping,FILE_MAP_READ,0,0,0);
+    lvAssert__(m_pData!=nullptr,"could not map file at '%s'",sFilePath.c_str());
+#else //(!defined(_MSC_VER))
+    m_nFileDesc = open(sFilePath.c_str(),O_RDONLY);
+    lvAssert__(m_nFileDesc!=-1,"could not open file at '%s'",sFilePath.c_str());
+    struct stat sb;
+    lvAssert__(fstat(m_nFileDesc,&sb)==0 && sb.st_size>0,"could not query size of file at '%s'",sFilePath.c_str());
+    m_nSize = size_t(sb.st_size);
+    void* pData = mmap(nullptr,m_nSize,PROT_READ,MAP_PRIVATE,m_nFileDesc,0);
+    lvAssert__(pData!=MAP_FAILED,"could not map file at '%s'",sFilePath.c_str());
+    m_pData = (const uint8_t*)pData;
+#endif //(!defined(_MSC_VER))
+}
+
+lv::MappedFile::~MappedFile() {
+#if defined(_MSC_VER)
+    if(m_pData)
+        UnmapViewOfFile(m_pData);
+    if(m_hMapping)
+        CloseHandle(m_hMapping);
+    if(m_hFile!=INVALID_HANDLE_VALUE)
+        CloseHandle(m_hFile);
+#else //(!defined(_MSC_VER))
+    if(m_pData)
+        munmap((void*)m_pData,m_nSize);
+    if(m_nFileDesc!=-1)
+        close(m_nFileDesc);
+#endif //(!defined(_MSC_VER))
+}
+
+lv::FileLock::FileLock(const std::string& sLockFilePath) {
+#if defined(_MSC_VER)
+    m_hFile = CreateFileA(sLockFilePath.c_str(),GENERIC_READ|GENERIC_WRITE,FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE,nullptr,OPEN_ALWAYS,FILE_ATTRIBUTE_NORMAL,nullptr);
+    lvAssert__(m_hFile!=INVALID_HANDLE_VALUE,"could not open lock file at '%s'",sLockFilePath.c_str());
+    OVERLAPPED oOverlapped = {};
+    lvAssert__(LockFileEx(m_hFile,LOCKFILE_EXCLUSIVE_LOCK,0,MAXDWORD,MAXDWORD,&oOverlapped),"could not acquire lock on file at '%s'",sLockFilePath.c_str());
+#else //(!defined(_MSC_VER))
+    m_nFileDesc = open(sLockFilePath.c_str(),O_RDWR|O_CREAT,0666);
+    lvAssert__(m_nFileDesc!=-1,"could not open lock file at '%s'",sLockFilePath.c_str());
+    int nRes;
+    while((nRes=flock(m_nFileDesc,LOCK_EX))==-1 && errno==EINTR);
+    lvAssert__(nRes==0,"could not acquire lock on file at '%s'",sLockFilePath.c_str());
+#endif //(!defined(_MSC_VER))
+}
+
+lv::FileLock::~FileLock() {
+#if defined(_MSC_VER)
+    OVERLAPPED oOverlapped = {};
+    UnlockFileEx(m_hFile,0,MAXDWORD,MAXDWORD,&oOverlapped);
+    CloseHandle(m_hFile);
+#else //(!defined(_MSC_VER))
+    flock(m_nFileDesc,LOCK_UN);
+    close(m_nFileDesc);
+#endif //(!defined(_MSC_VER))
+}
+
+lv::SharedMemorySegment::SharedMemorySegment(const std::string& sName, size_t nSize, bool bCreate) :
+        m_sName(sName),m_bOwner(bCreate),m_pData(nullptr),m_nSize(nSize) {
+    lvAssert_(!sName.empty() && sName.find_first_of("/\\")==std::string::npos,"shared memory segment name must be non-empty and slash-free");
+    lvAssert_(!bCreate || nSize>0,"shared memory segment size must be positive");
+#if defined(_MSC_VER)
+    const std::string sMappingName = std::string("Local\\")+sName;
+    if(bCreate) {
+        m_hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE,nullptr,PAGE_READWRITE,DWORD(uint64_t(nSize)>>32),DWORD(nSize&0xFFFFFFFF),sMappingName.c_str());
+        lvAssert__(m_hMapping!=nullptr && GetLastError()!=ERROR_ALREADY_EXISTS,"could not create shared memory segment '%s'",sName.c_str());
+    }
+    else {
+        m_hMapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS,FALSE,sMappingName.c_str());
+        lvAssert__(m_hMapping!=nullptr,"could not open shared memory segment '%s'",sName.c_str());
+    }
+    m_pData = (uint8_t*)MapViewOfFile(m_hMapping,FILE_MAP_ALL_ACCESS,0,0,0);
+    lvAssert__(m_pData!=nullptr,"could not map shared memory segment '%s'",sName.c_str());
+    MEMORY_BASIC_INFORMATION oMemInfo;
+    lvAssert_(VirtualQuery(m_pData,&oMemInfo,sizeof(oMemInfo))!=0,"could not query shared memory segment size");
+    m_nSize = bCreate?nSize:size_t(oMemInfo.RegionSize); // note: opened segment sizes are rounded up to the page size
+#else //(!defined(_MSC_VER))
+    const std::string sObjectName = std::string("/")+sName;
+    const int nFileDesc = shm_open(sObjectName.c_str(),bCreate?(O_RDWR|O_CREAT|O_EXCL):O_RDWR,0666);
+    lvAssert__(nFileDesc!=-1,"could not %s shared memory segment '%s'",bCreate?"create":"open",sName.c_str());
+    if(bCreate) {
+        if(ftruncate(nFileDesc,off_t(nSize))!=0) {
+            close(nFileDesc);
+            shm_unlink(sObjectName.c_str());
+            lvError_("could not resize shared memory segment '%s'",sName.c_str());
+        }
+    }
+    else {
+        struct stat sb;
+        const bool bGotStats = fstat(nFileDesc,&sb)==0 && sb.st_size>0;
+        if(!bGotStats)
+            close(nFileDesc);
+        lvAssert__(bGotStats,"could not query size of shared memory segment '%s'",sName.c_str());
+        m_nSize = size_t(sb.st_size);
+    }
+    void* pData = mmap(nullptr,m_nSize,PROT_READ|PROT_WRITE,MAP_SHARED,nFileDesc,0);
+    close(nFileDesc); // the mapping keeps its own reference on the object
+    if(pData==MAP_FAILED && bCreate)
+        shm_unlink(sObjectName.c_str());
+    lvAssert__(pData!=MAP_FAILED,"could not map shared memory segment '%s'",sName.c_str());
+    m_pData = (uint8_t*)pData;
+#endif //(!defined(_MSC_VER))
+}
+
+lv::SharedMemorySegment::~SharedMemorySegment() {
+#if defined(_MSC_VER)
+    // windows mappings are removed along with their last handle, so the owner flag has no effect here
+    if(m_pData)
+        UnmapViewOfFile(m_pData);
+    if(m_hMapping)
+        CloseHandle(m_hMapping);
+#else //(!defined(_MSC_VER))
+    if(m_pData)
+        munmap(m_pData,m_nSize);
+    if(m_bOwner)
+        shm_unlink((std::string("/")+m_sName).c_str());
+#endif //(!defined(_MSC_VER))
+}
+
 void lv::RegisterAllConsoleSignals(void(*lHandler)(int)) {
     signal(SIGINT,lHandler);
     signal(SIGTERM,lHandler);
@@ -206,6 +542,216 @@ void lv::RegisterAllConsoleSignals(void(*lHandler)(int)) {
 #endif //def(SIGBREAK)
 }
 
+size_t lv::GetNUMANodeCount() {
+    static const size_t s_nNodeCount = []() {
+#if defined(_MSC_VER)
+        ULONG nHighestNodeIdx = 0;
+        return GetNumaHighestNodeNumber(&nHighestNodeIdx)?size_t(nHighestNodeIdx+1):size_t(1);
+#else //(!defined(_MSC_VER))
+        size_t nNodes = 0;
+        std::vector<std::string> vsSubDirPaths;
+        lv::GetSubDirsFromDir("/sys/devices/system/node",vsSubDirPaths);
+        for(const std::string& sSubDirPath : vsSubDirPaths) {
+            const size_t nNamePos = sSubDirPath.find_last_of('/')+1;
+            if(sSubDirPath.compare(nNamePos,4,"node")==0 && sSubDirPath.size()>nNamePos+4 && std::isdigit(sSubDirPath[nNamePos+4]))
+                ++nNodes;
+        }
+        return std::max(nNodes,size_t(1));
+#endif //(!defined(_MSC_VER))
+    }();
+    return s_nNodeCount;
+}
+
+int lv::GetCurrentNUMANode() {
+#if defined(_MSC_VER)
+    PROCESSOR_NUMBER oProcNumber;
+    GetCurrentProcessorNumberEx(&oProcNumber);
+    USHORT nNodeIdx = 0;
+    return GetNumaProcessorNodeEx(&oProcNumber,&nNodeIdx)?int(nNodeIdx):-1;
+#elif defined(SYS_getcpu)
+    unsigned int nCPUIdx = 0, nNodeIdx = 0;
+    return (syscall(SYS_getcpu,&nCPUIdx,&nNodeIdx,nullptr)==0)?int(nNodeIdx):-1;
+#else //(!defined(SYS_getcpu))
+    return -1;
+#endif //(!defined(SYS_getcpu))
+}
+
+bool lv::SetCurrentThreadAffinity(const std::vector<size_t>& vnCPUs) {
+    if(vnCPUs.empty())
+        return false;
+#if defined(_MSC_VER)
+    GROUP_AFFINITY oAffinity = {};
+    oAffinity.Group = WORD(vnCPUs[0]/64); // threads can only be bound within a single 64-cpu processor group
+    for(size_t nCPUIdx : vnCPUs)
+        if(nCPUIdx/64==oAffinity.Group)
+            oAffinity.Mask |= KAFFINITY(1)<<(nCPUIdx%64);
+    return SetThreadGroupAffinity(GetCurrentThread(),&oAffinity,nullptr)!=0;
+#elif defined(__linux__)
+    cpu_set_t oCPUSet;
+    CPU_ZERO(&oCPUSet);
+    for(size_t nCPUIdx : vnCPUs)
+        if(nCPUIdx<size_t(CPU_SETSIZE))
+            CPU_SET(nCPUIdx,&oCPUSet);
+    return pthread_setaffinity_np(pthread_self(),sizeof(oCPUSet),&oCPUSet)==0;
+#else //!defined(__linux__)
+    return false;
+#endif //!defined(__linux__)
+}
+
+bool lv::SetCurrentThreadPriority(int nPriority) {
+    lvAssert_(nPriority>=-2 && nPriority<=2,"thread priority must be in [-2,2]");
+#if defined(_MSC_VER)
+    const std::array<int,5> anPriorities = {THREAD_PRIORITY_LOWEST,THREAD_PRIORITY_BELOW_NORMAL,THREAD_PRIORITY_NORMAL,THREAD_PRIORITY_ABOVE_NORMAL,THREAD_PRIORITY_HIGHEST};
+    return SetThreadPriority(GetCurrentThread(),anPriorities[nPriority+2])!=0;
+#elif defined(__linux__)
+    // linux threads have their own nice value under SCHED_OTHER; each priority step maps to 5 nice levels
+    return setpriority(PRIO_PROCESS,(id_t)syscall(SYS_gettid),-5*nPriority)==0;
+#else //!defined(__linux__)
+    return false;
+#endif //!defined(__linux__)
+}
+
+std::vector<size_t> lv::ParseCPUList(const std::string& sCPUList) {
+    std::vector<size_t> vnCPUs;
+    std::istringstream ssCPUList(sCPUList);
+    std::string sRange;
+    while(std::getline(ssCPUList,sRange,',')) {
+        if(sRange.empty())
+            continue;
+        const size_t nDashPos = sRange.find('-');
+        try {
+            const size_t nFirstCPUIdx = std::stoul(sRange.substr(0,nDashPos));
+            const size_t nLastCPUIdx = (nDashPos==std::string::npos)?nFirstCPUIdx:std::stoul(sRange.substr(nDashPos+1));
+            lvAssert_(nFirstCPUIdx<=nLastCPUIdx,"bad cpu range '%s'",sRange.c_str());
+            for(size_t nCPUIdx=nFirstCPUIdx; nCPUIdx<=nLastCPUIdx; ++nCPUIdx)
+                vnCPUs.push_back(nCPUIdx);
+        }
+        catch(const std::logic_error&) {
+            lvError_("could not parse cpu list '%s'",sCPUList.c_str());
+        }
+    }
+    return vnCPUs;
+}
+
+void lv::SetThreadPlacementPolicy(ThreadRole eRole, const ThreadPlacementPolicy& oPolicy) {
+    lvAssert_(eRole>=0 && eRole<nThreadRoleCount,"bad thread role");
+    lvAssert_(oPolicy.nPriority>=-2 && oPolicy.nPriority<=2,"thread priority must be in [-2,2]");
+    ThreadPlacementRegistry& oRegistry = getThreadPlacementRegistry();
+    std::mutex_lock_guard oLock(oRegistry.m_oMutex);
+    oRegistry.m_aPolicies[eRole] = oPolicy;
+    oRegistry.m_abInitialized[eRole] = true;
+}
+
+lv::ThreadPlacementPolicy lv::GetThreadPlacementPolicy(ThreadRole eRole) {
+    lvAssert_(eRole>=0 && eRole<nThreadRoleCount,"bad thread role");
+    ThreadPlacementRegistry& oRegistry = getThreadPlacementRegistry();
+    std::mutex_lock_guard oLock(oRegistry.m_oMutex);
+    if(!oRegistry.m_abInitialized[eRole]) {
+        const std::string sRoleName = getThreadRoleEnvName(eRole);
+        if(const char* sCPUList = std::getenv(("LITIV_THREAD_AFFINITY_"+sRoleName).c_str()))
+            oRegistry.m_aPolicies[eRole].vnCPUs = ParseCPUList(sCPUList);
+        if(const char* sPriority = std::getenv(("LITIV_THREAD_PRIORITY_"+sRoleName).c_str()))
+            oRegistry.m_aPolicies[eRole].nPriority = std::max(std::min(std::atoi(sPriority),2),-2);
+        oRegistry.m_abInitialized[eRole] = true;
+    }
+    return oRegistry.m_aPolicies[eRole];
+}
+
+bool lv::ApplyThreadPlacementPolicy(ThreadRole eRole) {
+    const ThreadPlacementPolicy oPolicy = GetThreadPlacementPolicy(eRole);
+    bool bSuccess = true;
+    if(!oPolicy.vnCPUs.empty())
+        bSuccess &= SetCurrentThreadAffinity(oPolicy.vnCPUs);
+    if(oPolicy.nPriority!=0)
+        bSuccess &= SetCurrentThreadPriority(oPolicy.nPriority);
+    return bSuccess;
+}
+
+void* lv::AllocLargeMem(size_t nBytes, int nNUMANode, bool bUseHugePages) {
+    lvAssert_(nBytes>0,"allocation size must be positive");
+    lvAssert_(nNUMANode<(int)GetNUMANodeCount(),"NUMA node index out of range");
+#if defined(_MSC_VER)
+    // large pages require the 'lock pages in memory' privilege; regular pages are used if they cannot be obtained
+    const DWORD nPreferredNode = (nNUMANode>=0)?DWORD(nNUMANode):NUMA_NO_PREFERRED_NODE;
+    const size_t nLargePageSize = GetLargePageMinimum();
+    void* pMem = nullptr;
+    if(bUseHugePages && nLargePageSize>0 && (nBytes%nLargePageSize)==0)
+        pMem = VirtualAllocExNuma(GetCurrentProcess(),nullptr,nBytes,MEM_RESERVE|MEM_COMMIT|MEM_LARGE_PAGES,PAGE_READWRITE,nPreferredNode);
+    if(!pMem)
+        pMem = VirtualAllocExNuma(GetCurrentProcess(),nullptr,nBytes,MEM_RESERVE|MEM_COMMIT,PAGE_READWRITE,nPreferredNode);
+    if(!pMem)
+        throw std::bad_alloc();
+    return pMem;
+#else //(!defined(_MSC_VER))
+    // mappings above one huge page are always rounded to a multiple of it, so that FreeLargeMem can derive the mapped size
+    const size_t nMapBytes = (nBytes>=LARGE_MEM_HUGE_PAGE_SIZE)?((nBytes+LARGE_MEM_HUGE_PAGE_SIZE-1)/LARGE_MEM_HUGE_PAGE_SIZE)*LARGE_MEM_HUGE_PAGE_SIZE:nBytes;
+    void* pMem = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+    if(bUseHugePages && nBytes>=LARGE_MEM_HUGE_PAGE_SIZE)
+        pMem = mmap(nullptr,nMapBytes,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB,-1,0); // fails unless hugetlbfs pages are reserved
+#endif //defined(MAP_HUGETLB)
+    if(pMem==MAP_FAILED) {
+        pMem = mmap(nullptr,nMapBytes,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+        if(pMem==MAP_FAILED)
+            throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+        if(bUseHugePages && nBytes>=LARGE_MEM_HUGE_PAGE_SIZE)
+            madvise(pMem,nMapBytes,MADV_HUGEPAGE); // transparent huge pages (best effort)
+#endif //defined(MADV_HUGEPAGE)
+    }
+#if defined(SYS_mbind)
+    if(nNUMANode>=0 && GetNUMANodeCount()>1 && nNUMANode<LARGE_MEM_MAX_NUMA_NODES) {
+        // pages are not touched yet, so the (preferred) policy decides where they land on first access; done via syscall to avoid a libnuma dependency
+        constexpr int nMPOL_PREFERRED = 1;
+        const unsigned long nNodeMask = 1UL<<nNUMANode;
+        syscall(SYS_mbind,pMem,nMapBytes,nMPOL_PREFERRED,&nNodeMask,(unsigned long)LARGE_MEM_MAX_NUMA_NODES+1,0U);
+    }
+#endif //defined(SYS_mbind)
+    return pMem;
+#endif //(!defined(_MSC_VER))
+}
+
+void lv::FreeLargeMem(void* pMem, size_t nBytes) {
+    if(!pMem)
+        return;
+#if defined(_MSC_VER)
+    lvIgnore(nBytes);
+    VirtualFree(pMem,0,MEM_RELEASE);
+#else //(!defined(_MSC_VER))
+    const size_t nMapBytes = (nBytes>=LARGE_MEM_HUGE_PAGE_SIZE)?((nBytes+LARGE_MEM_HUGE_PAGE_SIZE-1)/LARGE_MEM_HUGE_PAGE_SIZE)*LARGE_MEM_HUGE_PAGE_SIZE:nBytes;
+    munmap(pMem,nMapBytes);
+#endif //(!defined(_MSC_VER))
+}
+
+void* lv::ShareLargeMemCOW(void* pMem, size_t nBytes) {
+    lvAssert_(pMem && nBytes>0,"shared block must be non-null and non-empty");
+#if defined(__linux__) && defined(SYS_memfd_create)
+    const size_t nMapBytes = (nBytes>=LARGE_MEM_HUGE_PAGE_SIZE)?((nBytes+LARGE_MEM_HUGE_PAGE_SIZE-1)/LARGE_MEM_HUGE_PAGE_SIZE)*LARGE_MEM_HUGE_PAGE_SIZE:nBytes;
+    // the current contents are moved to an anonymous file, which both blocks then map privately (so writes stay local to each block)
+    constexpr unsigned int nMFD_CLOEXEC = 1U;
+    const int nFD = (int)syscall(SYS_memfd_create,"litiv-cow",nMFD_CLOEXEC);
+    if(nFD<0)
+        return nullptr;
+    bool bSuccess = (ftruncate(nFD,(off_t)nMapBytes)==0);
+    for(size_t nWrittenBytes=0; bSuccess && nWrittenBytes<nMapBytes;) {
+        const ssize_t nCurrBytes = write(nFD,(const char*)pMem+nWrittenBytes,nMapBytes-nWrittenBytes);
+        bSuccess = (nCurrBytes>0);
+        nWrittenBytes += bSuccess?size_t(nCurrBytes):size_t(0);
+    }
+    void* pSharedMem = bSuccess?mmap(nullptr,nMapBytes,PROT_READ|PROT_WRITE,MAP_PRIVATE,nFD,0):MAP_FAILED;
+    if(pSharedMem!=MAP_FAILED && mmap(pMem,nMapBytes,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_FIXED,nFD,0)==MAP_FAILED) {
+        munmap(pSharedMem,nMapBytes);
+        pSharedMem = MAP_FAILED;
+    }
+    close(nFD); // the file is kept alive by its mappings only, and released with the last of them
+    return (pSharedMem==MAP_FAILED)?nullptr:pSharedMem;
+#else //!(defined(__linux__) && defined(SYS_memfd_create))
+    lvIgnore(pMem);
+    lvIgnore(nBytes);
+    return nullptr;
+#endif //!(defined(__linux__) && defined(SYS_memfd_create))
+}
+
 size_t lv::GetCurrentPhysMemBytesUsed() {
 #if defined(_MSC_VER)
     PROCESS_MEMORY_COUNTERS info;
@@ -224,3 +770,45 @@ size_t lv::GetCurrentPhysMemBytesUsed() {
     return size_t(nMemUsed*sysconf(_SC_PAGESIZE));
 #endif //ndef(_MSC_VER)
 }
+
+size_t lv::GetPeakPhysMemBytesUsed() {
+#if defined(_MSC_VER)
+    PROCESS_MEMORY_COUNTERS info;
+    GetProcessMemoryInfo(GetCurrentProcess(),&info,sizeof(info));
+    return (size_t)info.PeakWorkingSetSize;
+#else //ndef(_MSC_VER)
+    // VmHWM follows resets via clear_refs, while getrusage's maxrss does not
+    FILE* fp = nullptr;
+    if((fp=fopen("/proc/self/status","r"))) {
+        char acLine[256];
+        size_t nPeakKB = 0;
+        while(fgets(acLine,sizeof(acLine),fp)) {
+            if(sscanf(acLine,"VmHWM: %zu kB",&nPeakKB)==1) {
+                fclose(fp);
+                return nPeakKB*1024;
+            }
+        }
+        fclose(fp);
+    }
+    struct rusage oUsage;
+    if(getrusage(RUSAGE_SELF,&oUsage)!=0)
+        return size_t(0);
+#if defined(__APPLE__)
+    return size_t(oUsage.ru_maxrss); // already in bytes
+#else //ndef(__APPLE__)
+    return size_t(oUsage.ru_maxrss)*1024;
+#endif //ndef(__APPLE__)
+#endif //ndef(_MSC_VER)
+}
+
+bool lv::ResetPeakPhysMemBytesUsed() {
+#if defined(__linux__)
+    FILE* fp = nullptr;
+    if(!(fp=fopen("/proc/self/clear_refs","w")))
+        return false;
+    const bool bSuccess = fputs("5",fp)>=0; // '5' resets the peak resident set size (linux>=4.0)
+    return (fclose(fp)==0) && bSuccess;
+#else //ndef(__linux__)
+    return false;
+#endif //ndef(__linux__)
+}
@@ -0,0 +1,349 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/utils/profiler.hpp"
+
+#if USE_PROFILER
+
+namespace {
+
+    typedef std::chrono::steady_clock ProfilerClock;
+
+    /// per-thread statistics of a single scope (only written by the owner thread, hence plain relaxed load/store updates)
+    struct SiteStats {
+        std::atomic<uint64_t> nCallCount,nTotalTime_ns,nMinTime_ns,nMaxTime_ns;
+        std::atomic<int> nParentId;
+        std::array<std::atomic<uint64_t>,lv::Profiler::s_nHistBins> anHistogram;
+        void clear() {
+            nCallCount.store(0,std::memory_order_relaxed);
+            nTotalTime_ns.store(0,std::memory_order_relaxed);
+            nMinTime_ns.store(UINT64_MAX,std::memory_order_relaxed);
+            nMaxTime_ns.store(0,std::memory_order_relaxed);
+            nParentId.store(-1,std::memory_order_relaxed);
+            for(auto& nBinCount : anHistogram)
+                nBinCount.store(0,std::memory_order_relaxed);
+        }
+    };
+
+    /// single trace event slot in a per-thread ring buffer
+    struct TraceEvent {
+        std::atomic<int64_t> nStart_ns,nEnd_ns;
+        std::atomic<int> nSiteId;
+    };
+
+    /// per-thread profiling data; kept alive after its thread exits so that its results can still be reported
+    struct ThreadData {
+        ThreadData(int nThreadId) :
+                m_nThreadId(nThreadId),
+                m_nCurrSiteId(-1),
+                m_aSiteStats(new SiteStats[lv::Profiler::s_nMaxSites]),
+                m_aEvents(new TraceEvent[lv::Profiler::s_nRingBufferSize]) {
+            clear(0);
+        }
+        void clear(size_t nEpoch) {
+            for(size_t nSiteIdx=0; nSiteIdx<lv::Profiler::s_nMaxSites; ++nSiteIdx)
+                m_aSiteStats[nSiteIdx].clear();
+            for(size_t nEventIdx=0; nEventIdx<lv::Profiler::s_nRingBufferSize; ++nEventIdx)
+                m_aEvents[nEventIdx].nSiteId.store(-1,std::memory_order_relaxed);
+            m_nEventCount.store(0,std::memory_order_relaxed);
+            m_nEpoch.store(nEpoch,std::memory_order_release);
+        }
+        const int m_nThreadId;
+        int m_nCurrSiteId; ///< only ever accessed by the owner thread
+        std::string m_sName; ///< guarded by the registry mutex
+        std::atomic<size_t> m_nEpoch;
+        std::atomic<uint64_t> m_nEventCount;
+        std::unique_ptr<SiteStats[]> m_aSiteStats;
+        std::unique_ptr<TraceEvent[]> m_aEvents;
+    };
+
+    /// global registry of profiled sites & threads (only locked on registration and when dumping results)
+    struct Registry {
+        Registry() : m_bEnabled(true), m_nEpoch(1), m_nOrigin(ProfilerClock::now()) {}
+        std::mutex m_oMutex;
+        std::vector<const char*> m_vsSiteNames;
+        std::vector<std::shared_ptr<ThreadData>> m_vpThreads;
+        std::atomic<bool> m_bEnabled;
+        std::atomic<size_t> m_nEpoch;
+        const ProfilerClock::time_point m_nOrigin;
+    };
+
+    Registry& getRegistry() {
+        static Registry s_oRegistry;
+        return s_oRegistry;
+    }
+
+    ThreadData& getThreadData() {
+        thread_local std::shared_ptr<ThreadData> t_pData = []() {
+            Registry& oRegistry = getRegistry();
+            std::lock_guard<std::mutex> oLock(oRegistry.m_oMutex);
+            oRegistry.m_vpThreads.push_back(std::make_shared<ThreadData>((int)oRegistry.m_vpThreads.size()));
+            return oRegistry.m_vpThreads.back();
+        }();
+        return *t_pData;
+    }
+
+    inline int64_t getTime_ns() {
+        return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(ProfilerClock::now()-getRegistry().m_nOrigin).count();
+    }
+
+    inline size_t getHistBin(uint64_t nTime_ns) {
+        size_t nBin = 0;
+        if(nTime_ns>>16) {nTime_ns >>= 16; nBin += 16;}
+        if(nTime_ns>>8) {nTime_ns >>= 8; nBin += 8;}
+        if(nTime_ns>>4) {nTime_ns >>= 4; nBin += 4;}
+        if(nTime_ns>>2) {nTime_ns >>= 2; nBin += 2;}
+        if(nTime_ns>>1) {nBin += 1;}
+        return std::min(nBin,lv::Profiler::s_nHistBins-1);
+    }
+
+    inline void addRelaxed(std::atomic<uint64_t>& nVal, uint64_t nInc) {
+        nVal.store(nVal.load(std::memory_order_relaxed)+nInc,std::memory_order_relaxed);
+    }
+
+    /// records a completed scope call in the given thread's statistics & trace ring buffer (only called by the owner thread)
+    void recordEvent(ThreadData& oData, int nSiteId, int nParentId, int64_t nStart_ns, int64_t nEnd_ns) {
+        const size_t nEpoch = getRegistry().m_nEpoch.load(std::memory_order_relaxed);
+        if(oData.m_nEpoch.load(std::memory_order_relaxed)!=nEpoch)
+            oData.clear(nEpoch); // reset was requested since our last record
+        const uint64_t nTime_ns = uint64_t(nEnd_ns-nStart_ns);
+        SiteStats& oStats = oData.m_aSiteStats[nSiteId];
+        addRelaxed(oStats.nCallCount,1);
+        addRelaxed(oStats.nTotalTime_ns,nTime_ns);
+        if(nTime_ns<oStats.nMinTime_ns.load(std::memory_order_relaxed))
+            oStats.nMinTime_ns.store(nTime_ns,std::memory_order_relaxed);
+        if(nTime_ns>oStats.nMaxTime_ns.load(std::memory_order_relaxed))
+            oStats.nMaxTime_ns.store(nTime_ns,std::memory_order_relaxed);
+        oStats.nParentId.store(nParentId,std::memory_order_relaxed);
+        addRelaxed(oStats.anHistogram[getHistBin(nTime_ns)],1);
+        const uint64_t nEventIdx = oData.m_nEventCount.load(std::memory_order_relaxed);
+        TraceEvent& oEvent = oData.m_aEvents[nEventIdx%lv::Profiler::s_nRingBufferSize];
+        oEvent.nSiteId.store(-1,std::memory_order_relaxed);
+        oEvent.nStart_ns.store(nStart_ns,std::memory_order_relaxed);
+        oEvent.nEnd_ns.store(nEnd_ns,std::memory_order_relaxed);
+        oEvent.nSiteId.store(nSiteId,std::memory_order_release);
+        oData.m_nEventCount.store(nEventIdx+1,std::memory_order_release);
+    }
+
+    std::string escapeJSON(const std::string& sStr) {
+        std::string sOutput;
+        sOutput.reserve(sStr.size());
+        for(char c : sStr) {
+            if(c=='"' || c=='\\')
+                sOutput += '\\';
+            if((unsigned char)c>=0x20)
+                sOutput += c;
+        }
+        return sOutput;
+    }
+
+} // namespace
+
+lv::Profiler::Site::Site(const char* sName) :
+        m_nId([sName]() {
+            lvDbgAssert(sName);
+            Registry& oRegistry = getRegistry();
+            std::lock_guard<std::mutex> oLock(oRegistry.m_oMutex);
+            if(oRegistry.m_vsSiteNames.size()>=s_nMaxSites)
+                return -1;
+            oRegistry.m_vsSiteNames.push_back(sName);
+            return int(oRegistry.m_vsSiteNames.size()-1);
+        }()) {}
+
+lv::Profiler::Scope::Scope(const Site& oSite) :
+        m_nStart_ns(0),
+        m_nSiteId(-1),
+        m_nParentId(-1) {
+    if(oSite.m_nId<0 || !getRegistry().m_bEnabled.load(std::memory_order_relaxed))
+        return;
+    ThreadData& oData = getThreadData();
+    m_nSiteId = oSite.m_nId;
+    m_nParentId = oData.m_nCurrSiteId;
+    oData.m_nCurrSiteId = m_nSiteId;
+    m_nStart_ns = getTime_ns();
+}
+
+lv::Profiler::Scope::~Scope() {
+    if(m_nSiteId<0)
+        return;
+    const int64_t nEnd_ns = getTime_ns();
+    ThreadData& oData = getThreadData();
+    oData.m_nCurrSiteId = m_nParentId;
+    recordEvent(oData,m_nSiteId,m_nParentId,m_nStart_ns,nEnd_ns);
+}
+
+void lv::Profiler::addSample(const Site& oSite, uint64_t nTime_ns) {
+    if(oSite.m_nId<0 || !getRegistry().m_bEnabled.load(std::memory_order_relaxed))
+        return;
+    ThreadData& oData = getThreadData();
+    const int64_t nEnd_ns = getTime_ns();
+    recordEvent(oData,oSite.m_nId,oData.m_nCurrSiteId,nEnd_ns-(int64_t)nTime_ns,nEnd_ns);
+}
+
+void lv::Profiler::setEnabled(bool bEnabled) {
+    getRegistry().m_bEnabled = bEnabled;
+}
+
+bool lv::Profiler::isEnabled() {
+    return getRegistry().m_bEnabled;
+}
+
+void lv::Profiler::reset() {
+    ++getRegistry().m_nEpoch;
+}
+
+void lv::Profiler::setThreadName(const std::string& sName) {
+    ThreadData& oData = getThreadData();
+    std::lock_guard<std::mutex> oLock(getRegistry().m_oMutex);
+    oData.m_sName = sName;
+}
+
+std::vector<lv::Profiler::ScopeStats> lv::Profiler::getStats() {
+    Registry& oRegistry = getRegistry();
+    std::lock_guard<std::mutex> oLock(oRegistry.m_oMutex);
+    const size_t nEpoch = oRegistry.m_nEpoch.load();
+    const size_t nSites = oRegistry.m_vsSiteNames.size();
+    std::vector<ScopeStats> voStats(nSites);
+    std::vector<int> vnParentIds(nSites,-1);
+    for(size_t nSiteIdx=0; nSiteIdx<nSites; ++nSiteIdx) {
+        voStats[nSiteIdx].sName = oRegistry.m_vsSiteNames[nSiteIdx];
+        voStats[nSiteIdx].nCallCount = 0;
+        voStats[nSiteIdx].dTotalTime_sec = voStats[nSiteIdx].dMaxTime_sec = 0.0;
+        voStats[nSiteIdx].dMinTime_sec = std::numeric_limits<double>::infinity();
+        voStats[nSiteIdx].anHistogram.fill(0);
+    }
+    for(const auto& pData : oRegistry.m_vpThreads) {
+        if(pData->m_nEpoch.load(std::memory_order_acquire)!=nEpoch)
+            continue; // data predates the last reset
+        for(size_t nSiteIdx=0; nSiteIdx<nSites; ++nSiteIdx) {
+            const SiteStats& oSiteStats = pData->m_aSiteStats[nSiteIdx];
+            const uint64_t nCallCount = oSiteStats.nCallCount.load(std::memory_order_relaxed);
+            if(nCallCount==0)
+                continue;
+            ScopeStats& oStats = voStats[nSiteIdx];
+            oStats.nCallCount += nCallCount;
+            oStats.dTotalTime_sec += oSiteStats.nTotalTime_ns.load(std::memory_order_relaxed)*1e-9;
+            oStats.dMinTime_sec = std::min(oStats.dMinTime_sec,oSiteStats.nMinTime_ns.load(std::memory_order_relaxed)*1e-9);
+            oStats.dMaxTime_sec = std::max(oStats.dMaxTime_sec,oSiteStats.nMaxTime_ns.load(std::memory_order_relaxed)*1e-9);
+            for(size_t nBinIdx=0; nBinIdx<s_nHistBins; ++nBinIdx)
+                oStats.anHistogram[nBinIdx] += oSiteStats.anHistogram[nBinIdx].load(std::memory_order_relaxed);
+            const int nParentId = oSiteStats.nParentId.load(std::memory_order_relaxed);
+            if(nParentId>=0 && nParentId<(int)nSites && nParentId!=(int)nSiteIdx)
+                vnParentIds[nSiteIdx] = nParentId;
+        }
+    }
+    for(size_t nSiteIdx=0; nSiteIdx<nSites; ++nSiteIdx) {
+        if(voStats[nSiteIdx].nCallCount==0)
+            voStats[nSiteIdx].dMinTime_sec = 0.0;
+        if(vnParentIds[nSiteIdx]>=0)
+            voStats[nSiteIdx].sParentName = voStats[vnParentIds[nSiteIdx]].sName;
+    }
+    return voStats;
+}
+
+std::string lv::Profiler::getReport() {
+    const std::vector<ScopeStats> voStats = getStats();
+    std::multimap<std::string,size_t> mChildren; // parent name to child index (names are unique enough for reporting)
+    for(size_t nSiteIdx=0; nSiteIdx<voStats.size(); ++nSiteIdx)
+        if(voStats[nSiteIdx].nCallCount)
+            mChildren.emplace(voStats[nSiteIdx].sParentName,nSiteIdx);
+    std::stringstream ssReport;
+    ssReport << std::setw(48) << std::left << "scope" << std::right << std::setw(10) << "calls" << std::setw(12) << "total(ms)"
+             << std::setw(12) << "mean(us)" << std::setw(12) << "min(us)" << std::setw(12) << "p99(us)" << std::setw(12) << "max(us)" << "\n";
+    std::vector<bool> vbVisited(voStats.size(),false);
+    std::function<void(const std::string&,size_t)> lPrintChildren = [&](const std::string& sParent, size_t nDepth) {
+        const auto oRange = mChildren.equal_range(sParent);
+        for(auto pIter=oRange.first; pIter!=oRange.second; ++pIter) {
+            const ScopeStats& oStats = voStats[pIter->second];
+            if(vbVisited[pIter->second])
+                continue; // guards against parent cycles from recursive scopes
+            vbVisited[pIter->second] = true;
+            ssReport << std::setw(48) << std::left << (std::string(nDepth*2,' ')+oStats.sName) << std::right << std::setw(10) << oStats.nCallCount
+                     << std::fixed << std::setprecision(3) << std::setw(12) << oStats.dTotalTime_sec*1e3 << std::setw(12) << oStats.dTotalTime_sec*1e6/oStats.nCallCount
+                     << std::setw(12) << oStats.dMinTime_sec*1e6 << std::setw(12) << oStats.getQuantileTime_sec(0.99)*1e6 << std::setw(12) << oStats.dMaxTime_sec*1e6 << "\n";
+            lPrintChildren(oStats.sName,nDepth+1);
+        }
+    };
+    lPrintChildren(std::string(),0);
+    for(size_t nSiteIdx=0; nSiteIdx<voStats.size(); ++nSiteIdx) // orphans (whose parent went unreported)
+        if(voStats[nSiteIdx].nCallCount && !vbVisited[nSiteIdx])
+            lPrintChildren(voStats[nSiteIdx].sParentName,0);
+    return ssReport.str();
+}
+
+void lv::Profiler::writeChromeTrace(std::ostream& oStream) {
+    Registry& oRegistry = getRegistry();
+    std::lock_guard<std::mutex> oLock(oRegistry.m_oMutex);
+    const size_t nEpoch = oRegistry.m_nEpoch.load();
+    const int nSites = (int)oRegistry.m_vsSiteNames.size();
+    oStream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool bFirst = true;
+    for(const auto& pData : oRegistry.m_vpThreads) {
+        if(pData->m_nEpoch.load(std::memory_order_acquire)!=nEpoch)
+            continue;
+        if(!pData->m_sName.empty()) {
+            oStream << (bFirst?"":",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << pData->m_nThreadId << ",\"args\":{\"name\":\"" << escapeJSON(pData->m_sName) << "\"}}";
+            bFirst = false;
+        }
+        const uint64_t nEventCount = pData->m_nEventCount.load(std::memory_order_acquire);
+        for(uint64_t nEventIdx=(nEventCount>s_nRingBufferSize?nEventCount-s_nRingBufferSize:0); nEventIdx<nEventCount; ++nEventIdx) {
+            const TraceEvent& oEvent = pData->m_aEvents[nEventIdx%s_nRingBufferSize];
+            const int nSiteId = oEvent.nSiteId.load(std::memory_order_acquire);
+            const int64_t nStart_ns = oEvent.nStart_ns.load(std::memory_order_relaxed);
+            const int64_t nEnd_ns = oEvent.nEnd_ns.load(std::memory_order_relaxed);
+            if(nSiteId<0 || nSiteId>=nSites || nEnd_ns<nStart_ns)
+                continue; // slot is being overwritten by its owner
+            oStream << (bFirst?"":",\n") << "{\"name\":\"" << escapeJSON(oRegistry.m_vsSiteNames[nSiteId]) << "\",\"cat\":\"lv\",\"ph\":\"X\",\"pid\":0,\"tid\":" << pData->m_nThreadId
+                    << std::fixed << std::setprecision(3) << ",\"ts\":" << nStart_ns*1e-3 << ",\"dur\":" << (nEnd_ns-nStart_ns)*1e-3 << "}";
+            bFirst = false;
+        }
+    }
+    oStream << "\n]}\n";
+}
+
+#else //(!USE_PROFILER)
+
+lv::Profiler::Site::Site(const char*) : m_nId(-1) {}
+lv::Profiler::Scope::Scope(const Site&) : m_nStart_ns(0), m_nSiteId(-1), m_nParentId(-1) {}
+lv::Profiler::Scope::~Scope() {}
+void lv::Profiler::addSample(const Site&, uint64_t) {}
+void lv::Profiler::setEnabled(bool) {}
+bool lv::Profiler::isEnabled() {return false;}
+void lv::Profiler::reset() {}
+void lv::Profiler::setThreadName(const std::string&) {}
+std::vector<lv::Profiler::ScopeStats> lv::Profiler::getStats() {return std::vector<ScopeStats>();}
+std::string lv::Profiler::getReport() {return std::string();}
+void lv::Profiler::writeChromeTrace(std::ostream& oStream) {oStream << "{\"traceEvents\":[]}\n";}
+
+#endif //(!USE_PROFILER)
+
+double lv::Profiler::ScopeStats::getQuantileTime_sec(double dQuantile) const {
+    const uint64_t nTarget = uint64_t(std::ceil(dQuantile*nCallCount));
+    uint64_t nCumulCount = 0;
+    for(size_t nBinIdx=0; nBinIdx<s_nHistBins; ++nBinIdx) {
+        nCumulCount += anHistogram[nBinIdx];
+        if(nCumulCount>=nTarget && nCumulCount>0)
+            return std::min(double(uint64_t(2)<<nBinIdx)*1e-9,dMaxTime_sec);
+    }
+    return dMaxTime_sec;
+}
+
+void lv::Profiler::writeChromeTrace(const std::string& sFilePath) {
+    std::ofstream oFile(sFilePath);
+    lvAssert_(oFile.is_open(),"could not open trace file for writing");
+    writeChromeTrace(oFile);
+}
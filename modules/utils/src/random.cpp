@@ -0,0 +1,96 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/utils/random.hpp"
+#include "litiv/utils/parallel.hpp"
+#include "random_kernels.hpp"
+
+namespace {
+
+    rand_impl::TinyMT32BlockKernel getTinyMT32BlockKernel() {
+#if RAND_KERNELS_X86
+        switch(lv::getSupportedSIMDInstrSet()) {
+            case lv::SIMD_AVX512BW:
+            case lv::SIMD_AVX2: return &rand_impl::tinymt32Blocks_AVX2;
+            case lv::SIMD_SSE4_1:
+            case lv::SIMD_SSE2: return &rand_impl::tinymt32Blocks_SSE2;
+            default: break;
+        }
+#elif RAND_KERNELS_NEON
+        return &rand_impl::tinymt32Blocks_NEON;
+#endif //RAND_KERNELS_NEON
+        return &rand_impl::tinymt32Blocks_Scalar;
+    }
+
+} // namespace
+
+void lv::TinyMT32Bank::init(size_t nGenerators, uint32_t nSeed) {
+    static_assert(s_nBlockSize==rand_impl::s_nTMT32BlockSize,"bad block size");
+    m_nGenerators = nGenerators;
+    m_vnStatus.assign(((nGenerators+s_nBlockSize-1)/s_nBlockSize)*s_nBlockSize*4,0u);
+    lv::PCG32 oSeedGen(nSeed);
+    for(size_t nGenIdx=0; nGenIdx<nGenerators; ++nGenIdx) {
+        const TinyMT32 oGen(oSeedGen());
+        uint32_t* anLaneStatus = m_vnStatus.data()+(nGenIdx/s_nBlockSize)*s_nBlockSize*4+(nGenIdx%s_nBlockSize);
+        for(size_t nWordIdx=0; nWordIdx<4; ++nWordIdx)
+            anLaneStatus[nWordIdx*s_nBlockSize] = oGen.status[nWordIdx];
+    }
+}
+
+void lv::TinyMT32Bank::generate(size_t nBeginIdx, size_t nCount, uint32_t* anOutput) {
+    static_assert(sizeof(uint32_t)==sizeof(unsigned int),"bad kernel type assumptions");
+    lvDbgAssert(nBeginIdx+nCount<=m_nGenerators && (nCount==0 || anOutput));
+    static const rand_impl::TinyMT32BlockKernel s_pKernel = getTinyMT32BlockKernel();
+    const size_t nEndIdx = nBeginIdx+nCount;
+    // partial blocks at both ends are stepped lane by lane (through a single-block scratch copy, to keep the other lanes untouched)
+    const auto lStepPartialBlock = [&](size_t nFirstIdx, size_t nLastIdx) {
+        const size_t nBlockIdx = nFirstIdx/s_nBlockSize;
+        uint32_t* anBlockStatus = m_vnStatus.data()+nBlockIdx*s_nBlockSize*4;
+        alignas(32) uint32_t anScratchStatus[s_nBlockSize*4], anScratchOutput[s_nBlockSize];
+        std::copy(anBlockStatus,anBlockStatus+s_nBlockSize*4,anScratchStatus);
+        rand_impl::tinymt32Blocks_Scalar(anScratchStatus,1,TinyMT32::s_nMat1,TinyMT32::s_nMat2,TinyMT32::s_nTMat,anScratchOutput);
+        for(size_t nGenIdx=nFirstIdx; nGenIdx<nLastIdx; ++nGenIdx) {
+            const size_t nLaneIdx = nGenIdx%s_nBlockSize;
+            for(size_t nWordIdx=0; nWordIdx<4; ++nWordIdx)
+                anBlockStatus[nWordIdx*s_nBlockSize+nLaneIdx] = anScratchStatus[nWordIdx*s_nBlockSize+nLaneIdx];
+            *anOutput++ = anScratchOutput[nLaneIdx];
+        }
+    };
+    size_t nCurrIdx = nBeginIdx;
+    if(nCurrIdx<nEndIdx && (nCurrIdx%s_nBlockSize)!=0) {
+        const size_t nHeadEndIdx = std::min(nEndIdx,((nCurrIdx/s_nBlockSize)+1)*s_nBlockSize);
+        lStepPartialBlock(nCurrIdx,nHeadEndIdx);
+        nCurrIdx = nHeadEndIdx;
+    }
+    const size_t nFullBlocks = (nEndIdx-nCurrIdx)/s_nBlockSize;
+    if(nFullBlocks>0) {
+        s_pKernel(m_vnStatus.data()+nCurrIdx*4,nFullBlocks,TinyMT32::s_nMat1,TinyMT32::s_nMat2,TinyMT32::s_nTMat,anOutput);
+        anOutput += nFullBlocks*s_nBlockSize;
+        nCurrIdx += nFullBlocks*s_nBlockSize;
+    }
+    if(nCurrIdx<nEndIdx)
+        lStepPartialBlock(nCurrIdx,nEndIdx);
+}
+
+lv::TinyMT32 lv::TinyMT32Bank::getGenerator(size_t nIdx) const {
+    lvAssert_(nIdx<m_nGenerators,"generator index out of range");
+    TinyMT32 oGen;
+    const uint32_t* anLaneStatus = m_vnStatus.data()+(nIdx/s_nBlockSize)*s_nBlockSize*4+(nIdx%s_nBlockSize);
+    for(size_t nWordIdx=0; nWordIdx<4; ++nWordIdx)
+        oGen.status[nWordIdx] = anLaneStatus[nWordIdx*s_nBlockSize];
+    return oGen;
+}
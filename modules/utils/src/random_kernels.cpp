@@ -0,0 +1,117 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "random_kernels.hpp"
+
+namespace {
+
+    inline unsigned int tinymt32Step_Scalar(unsigned int* anLaneStatus, unsigned int nMat1, unsigned int nMat2, unsigned int nTMat) {
+        // lane status words are strided by the block size (see random_kernels.hpp)
+        unsigned int& nStatus0 = anLaneStatus[0];
+        unsigned int& nStatus1 = anLaneStatus[rand_impl::s_nTMT32BlockSize];
+        unsigned int& nStatus2 = anLaneStatus[rand_impl::s_nTMT32BlockSize*2];
+        unsigned int& nStatus3 = anLaneStatus[rand_impl::s_nTMT32BlockSize*3];
+        unsigned int s0 = nStatus3;
+        unsigned int s1 = (nStatus0&0x7fffffffu)^nStatus1^nStatus2;
+        s1 ^= (s1<<1);
+        s0 ^= (s0>>1)^s1;
+        nStatus0 = nStatus1;
+        nStatus1 = nStatus2^((0u-(s0&1u))&nMat1);
+        nStatus2 = (s1^(s0<<10))^((0u-(s0&1u))&nMat2);
+        nStatus3 = s0;
+        unsigned int t0 = nStatus3;
+        const unsigned int t1 = nStatus0+(nStatus2>>8);
+        t0 ^= t1;
+        return t0^((0u-(t1&1u))&nTMat);
+    }
+
+#if RAND_KERNELS_X86 && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2))
+    inline void tinymt32Step_SSE2(unsigned int* anStatus, const __m128i& vnMat1, const __m128i& vnMat2, const __m128i& vnTMat, unsigned int* anOutput) {
+        const __m128i vnOne = _mm_set1_epi32(1);
+        const __m128i vnStatus0 = _mm_loadu_si128((const __m128i*)(anStatus));
+        const __m128i vnStatus1 = _mm_loadu_si128((const __m128i*)(anStatus+rand_impl::s_nTMT32BlockSize));
+        const __m128i vnStatus2 = _mm_loadu_si128((const __m128i*)(anStatus+rand_impl::s_nTMT32BlockSize*2));
+        __m128i s0 = _mm_loadu_si128((const __m128i*)(anStatus+rand_impl::s_nTMT32BlockSize*3));
+        __m128i s1 = _mm_xor_si128(_mm_xor_si128(_mm_and_si128(vnStatus0,_mm_set1_epi32(0x7fffffff)),vnStatus1),vnStatus2);
+        s1 = _mm_xor_si128(s1,_mm_slli_epi32(s1,1));
+        s0 = _mm_xor_si128(s0,_mm_xor_si128(_mm_srli_epi32(s0,1),s1));
+        const __m128i vnMask = _mm_sub_epi32(_mm_setzero_si128(),_mm_and_si128(s0,vnOne));
+        const __m128i vnNewStatus0 = vnStatus1;
+        const __m128i vnNewStatus2 = _mm_xor_si128(_mm_xor_si128(s1,_mm_slli_epi32(s0,10)),_mm_and_si128(vnMask,vnMat2));
+        _mm_storeu_si128((__m128i*)(anStatus),vnNewStatus0);
+        _mm_storeu_si128((__m128i*)(anStatus+rand_impl::s_nTMT32BlockSize),_mm_xor_si128(vnStatus2,_mm_and_si128(vnMask,vnMat1)));
+        _mm_storeu_si128((__m128i*)(anStatus+rand_impl::s_nTMT32BlockSize*2),vnNewStatus2);
+        _mm_storeu_si128((__m128i*)(anStatus+rand_impl::s_nTMT32BlockSize*3),s0);
+        const __m128i t1 = _mm_add_epi32(vnNewStatus0,_mm_srli_epi32(vnNewStatus2,8));
+        const __m128i t0 = _mm_xor_si128(s0,t1);
+        _mm_storeu_si128((__m128i*)anOutput,_mm_xor_si128(t0,_mm_and_si128(_mm_sub_epi32(_mm_setzero_si128(),_mm_and_si128(t1,vnOne)),vnTMat)));
+    }
+#endif //RAND_KERNELS_X86 && SSE2
+
+#if RAND_KERNELS_NEON
+    inline void tinymt32Step_NEON(unsigned int* anStatus, const uint32x4_t& vnMat1, const uint32x4_t& vnMat2, const uint32x4_t& vnTMat, unsigned int* anOutput) {
+        const uint32x4_t vnOne = vdupq_n_u32(1);
+        const uint32x4_t vnStatus0 = vld1q_u32(anStatus);
+        const uint32x4_t vnStatus1 = vld1q_u32(anStatus+rand_impl::s_nTMT32BlockSize);
+        const uint32x4_t vnStatus2 = vld1q_u32(anStatus+rand_impl::s_nTMT32BlockSize*2);
+        uint32x4_t s0 = vld1q_u32(anStatus+rand_impl::s_nTMT32BlockSize*3);
+        uint32x4_t s1 = veorq_u32(veorq_u32(vandq_u32(vnStatus0,vdupq_n_u32(0x7fffffff)),vnStatus1),vnStatus2);
+        s1 = veorq_u32(s1,vshlq_n_u32(s1,1));
+        s0 = veorq_u32(s0,veorq_u32(vshrq_n_u32(s0,1),s1));
+        const uint32x4_t vnMask = vtstq_u32(s0,vnOne);
+        const uint32x4_t vnNewStatus0 = vnStatus1;
+        const uint32x4_t vnNewStatus2 = veorq_u32(veorq_u32(s1,vshlq_n_u32(s0,10)),vandq_u32(vnMask,vnMat2));
+        vst1q_u32(anStatus,vnNewStatus0);
+        vst1q_u32(anStatus+rand_impl::s_nTMT32BlockSize,veorq_u32(vnStatus2,vandq_u32(vnMask,vnMat1)));
+        vst1q_u32(anStatus+rand_impl::s_nTMT32BlockSize*2,vnNewStatus2);
+        vst1q_u32(anStatus+rand_impl::s_nTMT32BlockSize*3,s0);
+        const uint32x4_t t1 = vaddq_u32(vnNewStatus0,vshrq_n_u32(vnNewStatus2,8));
+        vst1q_u32(anOutput,veorq_u32(veorq_u32(s0,t1),vandq_u32(vtstq_u32(t1,vnOne),vnTMat)));
+    }
+#endif //RAND_KERNELS_NEON
+
+} // namespace
+
+void rand_impl::tinymt32Blocks_Scalar(unsigned int* anStatus, size_t nBlocks, unsigned int nMat1, unsigned int nMat2, unsigned int nTMat, unsigned int* anOutput) {
+    for(size_t nBlockIdx=0; nBlockIdx<nBlocks; ++nBlockIdx, anStatus+=s_nTMT32BlockSize*4, anOutput+=s_nTMT32BlockSize)
+        for(size_t nLaneIdx=0; nLaneIdx<s_nTMT32BlockSize; ++nLaneIdx)
+            anOutput[nLaneIdx] = tinymt32Step_Scalar(anStatus+nLaneIdx,nMat1,nMat2,nTMat);
+}
+
+void rand_impl::tinymt32Blocks_SSE2(unsigned int* anStatus, size_t nBlocks, unsigned int nMat1, unsigned int nMat2, unsigned int nTMat, unsigned int* anOutput) {
+#if RAND_KERNELS_X86 && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2))
+    const __m128i vnMat1 = _mm_set1_epi32((int)nMat1), vnMat2 = _mm_set1_epi32((int)nMat2), vnTMat = _mm_set1_epi32((int)nTMat);
+    for(size_t nBlockIdx=0; nBlockIdx<nBlocks; ++nBlockIdx, anStatus+=s_nTMT32BlockSize*4, anOutput+=s_nTMT32BlockSize) {
+        tinymt32Step_SSE2(anStatus,vnMat1,vnMat2,vnTMat,anOutput);
+        tinymt32Step_SSE2(anStatus+4,vnMat1,vnMat2,vnTMat,anOutput+4);
+    }
+#else //!(RAND_KERNELS_X86 && SSE2)
+    tinymt32Blocks_Scalar(anStatus,nBlocks,nMat1,nMat2,nTMat,anOutput);
+#endif //!(RAND_KERNELS_X86 && SSE2)
+}
+
+void rand_impl::tinymt32Blocks_NEON(unsigned int* anStatus, size_t nBlocks, unsigned int nMat1, unsigned int nMat2, unsigned int nTMat, unsigned int* anOutput) {
+#if RAND_KERNELS_NEON
+    const uint32x4_t vnMat1 = vdupq_n_u32(nMat1), vnMat2 = vdupq_n_u32(nMat2), vnTMat = vdupq_n_u32(nTMat);
+    for(size_t nBlockIdx=0; nBlockIdx<nBlocks; ++nBlockIdx, anStatus+=s_nTMT32BlockSize*4, anOutput+=s_nTMT32BlockSize) {
+        tinymt32Step_NEON(anStatus,vnMat1,vnMat2,vnTMat,anOutput);
+        tinymt32Step_NEON(anStatus+4,vnMat1,vnMat2,vnTMat,anOutput+4);
+    }
+#else //(!RAND_KERNELS_NEON)
+    tinymt32Blocks_Scalar(anStatus,nBlocks,nMat1,nMat2,nTMat,anOutput);
+#endif //(!RAND_KERNELS_NEON)
+}
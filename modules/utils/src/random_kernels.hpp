@@ -0,0 +1,58 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// note: this header is shared by the runtime-dispatched random number kernel translation units, which are compiled with
+// different instruction set flags; it must stay free of any inline code coming from other headers (see distances_kernels.hpp)
+
+#include <cstddef>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RAND_KERNELS_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else //(!defined(_MSC_VER))
+#include <x86intrin.h>
+#endif //(!defined(_MSC_VER))
+#else //(!x86)
+#define RAND_KERNELS_X86 0
+#endif //(!x86)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RAND_KERNELS_NEON 1
+#include <arm_neon.h>
+#else //(!NEON)
+#define RAND_KERNELS_NEON 0
+#endif //(!NEON)
+
+namespace rand_impl {
+
+    /// number of generators per state block (each block stores the 4 status words of its generators as 4 rows of 8 values)
+    constexpr size_t s_nTMT32BlockSize = 8;
+
+    /// signature of the TinyMT32 block kernels (advances all generators of nBlocks consecutive blocks by one step, and writes one output per generator)
+    typedef void(*TinyMT32BlockKernel)(unsigned int* anStatus, size_t nBlocks, unsigned int nMat1, unsigned int nMat2, unsigned int nTMat, unsigned int* anOutput);
+
+    /// baseline implementation, always available
+    void tinymt32Blocks_Scalar(unsigned int* anStatus, size_t nBlocks, unsigned int nMat1, unsigned int nMat2, unsigned int nTMat, unsigned int* anOutput);
+    /// SSE2 implementation (two 4-lane halves per block, falls back to scalar if not compiled in)
+    void tinymt32Blocks_SSE2(unsigned int* anStatus, size_t nBlocks, unsigned int nMat1, unsigned int nMat2, unsigned int nTMat, unsigned int* anOutput);
+    /// AVX2 implementation (one 8-lane vector per block, falls back to SSE2 if not compiled in)
+    void tinymt32Blocks_AVX2(unsigned int* anStatus, size_t nBlocks, unsigned int nMat1, unsigned int nMat2, unsigned int nTMat, unsigned int* anOutput);
+    /// NEON implementation (two 4-lane halves per block, falls back to scalar if not compiled in)
+    void tinymt32Blocks_NEON(unsigned int* anStatus, size_t nBlocks, unsigned int nMat1, unsigned int nMat2, unsigned int nTMat, unsigned int* anOutput);
+
+} // namespace rand_impl
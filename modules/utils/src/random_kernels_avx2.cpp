@@ -0,0 +1,55 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// note: this translation unit is compiled with AVX2 enabled (see CMakeLists.txt); its kernels are only called when the
+// current CPU supports the instruction set, so nothing else than the kernels themselves should ever be defined here
+
+#include "random_kernels.hpp"
+
+#if RAND_KERNELS_X86 && defined(__AVX2__)
+
+void rand_impl::tinymt32Blocks_AVX2(unsigned int* anStatus, size_t nBlocks, unsigned int nMat1, unsigned int nMat2, unsigned int nTMat, unsigned int* anOutput) {
+    static_assert(s_nTMT32BlockSize==8,"AVX2 kernel expects one 8-lane vector per block row");
+    const __m256i vnMat1 = _mm256_set1_epi32((int)nMat1), vnMat2 = _mm256_set1_epi32((int)nMat2), vnTMat = _mm256_set1_epi32((int)nTMat);
+    const __m256i vnOne = _mm256_set1_epi32(1), vnMSBMask = _mm256_set1_epi32(0x7fffffff);
+    for(size_t nBlockIdx=0; nBlockIdx<nBlocks; ++nBlockIdx, anStatus+=s_nTMT32BlockSize*4, anOutput+=s_nTMT32BlockSize) {
+        const __m256i vnStatus0 = _mm256_loadu_si256((const __m256i*)(anStatus));
+        const __m256i vnStatus1 = _mm256_loadu_si256((const __m256i*)(anStatus+s_nTMT32BlockSize));
+        const __m256i vnStatus2 = _mm256_loadu_si256((const __m256i*)(anStatus+s_nTMT32BlockSize*2));
+        __m256i s0 = _mm256_loadu_si256((const __m256i*)(anStatus+s_nTMT32BlockSize*3));
+        __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(vnStatus0,vnMSBMask),vnStatus1),vnStatus2);
+        s1 = _mm256_xor_si256(s1,_mm256_slli_epi32(s1,1));
+        s0 = _mm256_xor_si256(s0,_mm256_xor_si256(_mm256_srli_epi32(s0,1),s1));
+        const __m256i vnMask = _mm256_sub_epi32(_mm256_setzero_si256(),_mm256_and_si256(s0,vnOne));
+        const __m256i vnNewStatus2 = _mm256_xor_si256(_mm256_xor_si256(s1,_mm256_slli_epi32(s0,10)),_mm256_and_si256(vnMask,vnMat2));
+        _mm256_storeu_si256((__m256i*)(anStatus),vnStatus1);
+        _mm256_storeu_si256((__m256i*)(anStatus+s_nTMT32BlockSize),_mm256_xor_si256(vnStatus2,_mm256_and_si256(vnMask,vnMat1)));
+        _mm256_storeu_si256((__m256i*)(anStatus+s_nTMT32BlockSize*2),vnNewStatus2);
+        _mm256_storeu_si256((__m256i*)(anStatus+s_nTMT32BlockSize*3),s0);
+        const __m256i t1 = _mm256_add_epi32(vnStatus1,_mm256_srli_epi32(vnNewStatus2,8));
+        const __m256i t0 = _mm256_xor_si256(s0,t1);
+        _mm256_storeu_si256((__m256i*)anOutput,_mm256_xor_si256(t0,_mm256_and_si256(_mm256_sub_epi32(_mm256_setzero_si256(),_mm256_and_si256(t1,vnOne)),vnTMat)));
+    }
+}
+
+#else //!(RAND_KERNELS_X86 && defined(__AVX2__))
+
+void rand_impl::tinymt32Blocks_AVX2(unsigned int* anStatus, size_t nBlocks, unsigned int nMat1, unsigned int nMat2, unsigned int nTMat, unsigned int* anOutput) {
+    tinymt32Blocks_SSE2(anStatus,nBlocks,nMat1,nMat2,nTMat,anOutput);
+}
+
+#endif //!(RAND_KERNELS_X86 && defined(__AVX2__))
@@ -0,0 +1,365 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "litiv/video/BackgroundSubtractionUtils.hpp"
+#include "litiv/utils/platform.hpp"
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <cstring>
+#include <map>
+
+/// defines the default number of frame slots in each stream's shared-memory ring
+#define BGSSERVICE_DEFAULT_RING_SLOTS (4)
+/// defines the max length (including the null terminator) of paths & messages exchanged through the control segment
+#define BGSSERVICE_MAX_STRING_LENGTH (256)
+/// defines the default timeout of control requests sent by clients, in seconds
+#define BGSSERVICE_DEFAULT_REQUEST_TIMEOUT (5.0)
+/// defines the number of idle dispatcher iterations spent yielding before sleeping between polls
+#define BGSSERVICE_IDLE_SPIN_ITERS (64)
+/// defines the sleep duration of idle dispatcher iterations (once done spinning), in microseconds
+#define BGSSERVICE_IDLE_SLEEP_USEC (100)
+
+static_assert(ATOMIC_LLONG_LOCK_FREE==2 && ATOMIC_INT_LOCK_FREE==2,"shared-memory rings require address-free (lock-free) atomics");
+
+/*!
+    Shared-memory frame ring of a background subtraction service stream (one client producing frames, one service consuming them)
+
+    Each slot holds one input frame and its FG mask. The client writes a frame in the next free slot and submits it, the
+    service segments submitted frames in order (writing masks in place) and completes them, and the client reads completed
+    masks and releases their slots. Slot ownership only depends on three monotonic counters (submitted >= completed >=
+    released) written by a single side each, so no locks or copies are involved on either side.
+ */
+struct BGSFrameRing {
+    /// creates the ring segment (service side) for frames of the given size & type (8UC1/3/4 or 16UC1)
+    BGSFrameRing(const std::string& sSegmentName, const cv::Size& oFrameSize, int nFrameType, size_t nSlots);
+    /// opens an existing ring segment (client side)
+    explicit BGSFrameRing(const std::string& sSegmentName);
+    /// returns the size of the ring's frames & masks
+    cv::Size getFrameSize() const;
+    /// returns the type of the ring's frames (masks are always 8UC1)
+    int getFrameType() const;
+    /// returns the number of frame slots in the ring
+    size_t getSlotCount() const;
+    /// client side: returns a view of the next free frame slot to fill (or an empty mat if all slots are in use)
+    cv::Mat getNextFrameSlot();
+    /// client side: submits the frame written in the slot returned by 'getNextFrameSlot' (timestamps are in seconds, <0 = untimed)
+    void submitFrame(double dTimestamp=-1.0);
+    /// client side: returns a view of the oldest completed mask not yet released (or an empty mat if none), with its frame index & failure state
+    cv::Mat getNextMask(size_t* pnFrameIdx=nullptr, bool* pbFailed=nullptr);
+    /// client side: releases the slot of the mask returned by 'getNextMask'
+    void releaseMask();
+    /// service side: returns whether a submitted frame is waiting to be segmented
+    bool hasPendingFrame() const;
+    /// service side: returns views of the oldest submitted frame and of its mask, or false if no frame is pending
+    bool getPendingFrame(cv::Mat& oFrame, cv::Mat& oMask, size_t& nFrameIdx, double& dTimestamp);
+    /// service side: marks the frame returned by 'getPendingFrame' as segmented (failed frames get an all-zero mask)
+    void completeFrame(bool bFailed=false);
+protected:
+    /// ring layout header, at the beginning of the segment
+    struct Header;
+    /// per-slot header, at the beginning of each slot
+    struct SlotHeader;
+    /// returns the ring layout header
+    Header& getHeader() const;
+    /// returns the slot used by the frame of the given index
+    uint8_t* getSlot(uint64_t nFrameIdx) const;
+    /// mapped ring segment
+    std::unique_ptr<lv::SharedMemorySegment> m_pSegment;
+    /// whether a frame slot (client side), a mask (client side) or a pending frame (service side) is currently held
+    bool m_bSlotHeld;
+};
+
+/// control requests handled by a background subtraction service (sent through its control segment)
+enum BGSServiceCommand : uint32_t {
+    BGSServiceCommand_None,
+    BGSServiceCommand_CreateStream, ///< creates a stream & its frame ring (its model is restored from the given snapshot path, if any)
+    BGSServiceCommand_DestroyStream, ///< destroys a stream & removes its frame ring name
+    BGSServiceCommand_SnapshotStream, ///< writes a model snapshot of a stream to the given path
+};
+
+/*!
+    Control segment of a background subtraction service; carries a single request/reply mailbox serialized between
+    clients via a spin lock (requests are rare, so the service simply polls it along with the frame rings).
+ */
+struct BGSServiceControl {
+    /// request sent by a client
+    struct Request {
+        BGSServiceCommand eCommand;
+        uint32_t nStreamID;
+        int32_t nRows,nCols,nFrameType;
+        uint32_t nSlots;
+        char acPath[BGSSERVICE_MAX_STRING_LENGTH];
+    };
+    /// reply sent back by the service
+    struct Reply {
+        uint32_t bSuccess;
+        uint32_t nStreamID;
+        char acMessage[BGSSERVICE_MAX_STRING_LENGTH];
+    };
+    /// creates (service side) or opens (client side) the control segment of the named service
+    BGSServiceControl(const std::string& sServiceName, bool bCreate);
+    /// client side: sends a request and blocks until the service replies (throws on timeout, or if the service is stopped)
+    Reply call(const Request& oRequest, double dTimeout);
+    /// service side: returns whether a request is pending (and copies it if so)
+    bool getPendingRequest(Request& oRequest) const;
+    /// service side: answers the pending request
+    void reply(const Reply& oReply);
+    /// service side: flags the service as (not) accepting requests
+    void setServiceAlive(bool bAlive);
+    /// returns the name of the frame ring segment of a given stream
+    static std::string getStreamSegmentName(const std::string& sServiceName, size_t nStreamID);
+protected:
+    /// control layout header, at the beginning of the segment
+    struct Header;
+    /// returns the control layout header
+    Header& getHeader() const;
+    /// mapped control segment
+    std::unique_ptr<lv::SharedMemorySegment> m_pSegment;
+};
+
+/*!
+    Client of a background subtraction service; streams are created/destroyed/snapshotted through the control API, and
+    their frames & masks go through the frame rings mapped here (see BGSFrameRing, which is not thread-safe per stream).
+ */
+struct BackgroundSubtractorServiceClient {
+    /// connects to the named service (throws if it is not running)
+    explicit BackgroundSubtractorServiceClient(const std::string& sServiceName, double dRequestTimeout=BGSSERVICE_DEFAULT_REQUEST_TIMEOUT);
+    /// creates a stream for frames of the given size & type (optionally restoring its model from a snapshot file), maps its ring, and returns its id
+    size_t createStream(const cv::Size& oFrameSize, int nFrameType, size_t nSlots=BGSSERVICE_DEFAULT_RING_SLOTS, const std::string& sSnapshotPath=std::string());
+    /// unmaps the ring of a stream & destroys it
+    void destroyStream(size_t nStreamID);
+    /// writes a model snapshot of a stream to the given path (on the service's file system)
+    void snapshotStream(size_t nStreamID, const std::string& sSnapshotPath);
+    /// returns the frame ring of a stream created by this client
+    BGSFrameRing& getStreamRing(size_t nStreamID);
+protected:
+    /// sends a request, and throws with the service's message if it fails
+    BGSServiceControl::Reply call(const BGSServiceControl::Request& oRequest);
+    /// name of the service
+    const std::string m_sServiceName;
+    /// timeout of control requests, in seconds
+    const double m_dRequestTimeout;
+    /// control segment of the service
+    BGSServiceControl m_oControl;
+    /// frame rings of the streams created by this client
+    std::map<size_t,std::unique_ptr<BGSFrameRing>> m_mpStreamRings;
+};
+
+/*!
+    Background subtraction service; hosts many streams of the same algorithm type (all built with the same parameters)
+    in one process, fed by clients (possibly from other processes) through per-stream shared-memory frame rings.
+
+    A dispatcher thread polls the control segment and the frame rings, and schedules the oldest pending frame of each
+    idle stream on a shared worker pool (frames of a given stream are always processed in order, one at a time). A
+    stream's model is initialized with its first frame, unless it was restored from a snapshot on creation.
+ */
+template<typename TBackgroundSubtractor, size_t nWorkers=4>
+struct BackgroundSubtractorService {
+    static_assert(std::is_base_of<IBackgroundSubtractor,TBackgroundSubtractor>::value,"service mode requires non-parallel background subtractor impls");
+    /// creates the service control segment; streams are created with the given algorithm parameters
+    template<typename... TArgs>
+    explicit BackgroundSubtractorService(const std::string& sServiceName, const TArgs&... args) :
+            m_sServiceName(sServiceName),
+            m_oControl(sServiceName,true),
+            m_lAlgoFactory([=](){return std::make_unique<TBackgroundSubtractor>(args...);}),
+            m_bStopRequested(false),
+            m_nNextStreamID(0),
+            m_nFailedFrames(0) {}
+    /// stops the service, and waits for ongoing jobs to end before releasing the streams
+    ~BackgroundSubtractorService() {
+        stop();
+    }
+    /// starts the dispatcher thread (clients can send requests from then on)
+    void start() {
+        lvAssert_(!m_oDispatcher.joinable(),"service is already running");
+        m_bStopRequested = false;
+        m_oControl.setServiceAlive(true);
+        m_oDispatcher = std::thread([this](){dispatch();});
+    }
+    /// stops the dispatcher thread (pending requests time out on the client side) and waits for ongoing jobs to end
+    void stop() {
+        m_oControl.setServiceAlive(false);
+        m_bStopRequested = true;
+        if(m_oDispatcher.joinable())
+            m_oDispatcher.join();
+        std::mutex_lock_guard oLock(m_oMutex);
+        for(const auto& oStreamPair : m_mpStreams)
+            while(oStreamPair.second->bBusy.load(std::memory_order_acquire))
+                std::this_thread::yield();
+    }
+    /// creates a stream directly (same as a client CreateStream request), and returns its id
+    size_t createStream(const cv::Size& oFrameSize, int nFrameType, size_t nSlots=BGSSERVICE_DEFAULT_RING_SLOTS, const std::string& sSnapshotPath=std::string()) {
+        std::shared_ptr<StreamData> pStream = std::make_shared<StreamData>();
+        pStream->pAlgo = m_lAlgoFactory();
+        if(!sSnapshotPath.empty()) {
+            std::ifstream oSnapshotFile(sSnapshotPath,std::ios::binary);
+            lvAssert__(oSnapshotFile.is_open(),"could not open snapshot file at '%s'",sSnapshotPath.c_str());
+            pStream->pAlgo->loadModel(oSnapshotFile);
+            pStream->bInitialized = true;
+        }
+        std::mutex_lock_guard oLock(m_oMutex);
+        const size_t nStreamID = m_nNextStreamID++;
+        pStream->pRing = std::make_unique<BGSFrameRing>(BGSServiceControl::getStreamSegmentName(m_sServiceName,nStreamID),oFrameSize,nFrameType,nSlots);
+        m_mpStreams.emplace(nStreamID,std::move(pStream));
+        return nStreamID;
+    }
+    /// destroys a stream directly (same as a client DestroyStream request); an ongoing job keeps it alive until it ends
+    void destroyStream(size_t nStreamID) {
+        std::mutex_lock_guard oLock(m_oMutex);
+        lvAssert__(m_mpStreams.erase(nStreamID)==1,"unknown stream id (%d)",(int)nStreamID);
+    }
+    /// writes a model snapshot of a stream directly (same as a client SnapshotStream request)
+    void snapshotStream(size_t nStreamID, const std::string& sSnapshotPath) {
+        const std::shared_ptr<StreamData> pStream = getStream(nStreamID);
+        std::mutex_lock_guard oAlgoLock(pStream->oAlgoMutex);
+        lvAssert_(pStream->bInitialized,"stream model is not initialized yet (no frame was processed)");
+        std::ofstream oSnapshotFile(sSnapshotPath,std::ios::binary);
+        lvAssert__(oSnapshotFile.is_open(),"could not create snapshot file at '%s'",sSnapshotPath.c_str());
+        pStream->pAlgo->saveModel(oSnapshotFile);
+    }
+    /// returns the number of streams currently hosted
+    size_t getStreamCount() const {
+        std::mutex_lock_guard oLock(m_oMutex);
+        return m_mpStreams.size();
+    }
+    /// returns the number of frames that could not be segmented since the service was created (their masks are flagged as failed)
+    size_t getFailedFrameCount() const {
+        return m_nFailedFrames.load();
+    }
+
+protected:
+    /// per-stream algorithm instance & frame ring
+    struct StreamData {
+        std::unique_ptr<BGSFrameRing> pRing;
+        std::unique_ptr<TBackgroundSubtractor> pAlgo;
+        /// guards the algorithm instance (jobs vs snapshots)
+        std::mutex oAlgoMutex;
+        /// whether a job is queued or running for this stream (only toggled by the dispatcher & the job itself)
+        std::atomic<bool> bBusy{false};
+        /// whether the model was initialized (by the first frame, or from a snapshot)
+        bool bInitialized = false;
+    };
+    /// returns a stream by id (throws if unknown)
+    std::shared_ptr<StreamData> getStream(size_t nStreamID) const {
+        std::mutex_lock_guard oLock(m_oMutex);
+        auto pStreamIter = m_mpStreams.find(nStreamID);
+        lvAssert__(pStreamIter!=m_mpStreams.end(),"unknown stream id (%d)",(int)nStreamID);
+        return pStreamIter->second;
+    }
+    /// dispatcher loop; serves control requests and schedules pending frames until stopped
+    void dispatch() {
+        size_t nIdleIters = 0;
+        while(!m_bStopRequested.load()) {
+            bool bWorkDone = serveControlRequest();
+            {
+                std::mutex_lock_guard oLock(m_oMutex);
+                for(const auto& oStreamPair : m_mpStreams) {
+                    StreamData& oStream = *oStreamPair.second;
+                    if(!oStream.bBusy.load(std::memory_order_acquire) && oStream.pRing->hasPendingFrame()) {
+                        oStream.bBusy.store(true,std::memory_order_relaxed);
+                        std::shared_ptr<StreamData> pStream = oStreamPair.second;
+                        m_oWorkerPool.submit([this,pStream](){processFrame(*pStream);});
+                        bWorkDone = true;
+                    }
+                }
+            }
+            if(bWorkDone)
+                nIdleIters = 0;
+            else if(++nIdleIters<BGSSERVICE_IDLE_SPIN_ITERS)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(BGSSERVICE_IDLE_SLEEP_USEC));
+        }
+    }
+    /// serves the pending control request (if any); returns whether one was served
+    bool serveControlRequest() {
+        BGSServiceControl::Request oRequest;
+        if(!m_oControl.getPendingRequest(oRequest))
+            return false;
+        BGSServiceControl::Reply oReply = {};
+        try {
+            const std::string sPath(oRequest.acPath,strnlen(oRequest.acPath,BGSSERVICE_MAX_STRING_LENGTH));
+            if(oRequest.eCommand==BGSServiceCommand_CreateStream)
+                oReply.nStreamID = (uint32_t)createStream(cv::Size(oRequest.nCols,oRequest.nRows),oRequest.nFrameType,oRequest.nSlots,sPath);
+            else if(oRequest.eCommand==BGSServiceCommand_DestroyStream)
+                destroyStream(oRequest.nStreamID);
+            else if(oRequest.eCommand==BGSServiceCommand_SnapshotStream)
+                snapshotStream(oRequest.nStreamID,sPath);
+            else
+                lvError_("unknown control command (%d)",(int)oRequest.eCommand);
+            oReply.bSuccess = 1;
+        }
+        catch(const std::exception& e) {
+            strncpy(oReply.acMessage,e.what(),BGSSERVICE_MAX_STRING_LENGTH-1);
+        }
+        m_oControl.reply(oReply);
+        return true;
+    }
+    /// job body; segments the oldest pending frame of a stream in place, and completes it
+    void processFrame(StreamData& oStream) {
+        cv::Mat oFrame,oMask;
+        size_t nFrameIdx;
+        double dTimestamp;
+        if(oStream.pRing->getPendingFrame(oFrame,oMask,nFrameIdx,dTimestamp)) {
+            bool bFailed = false;
+            try {
+                std::mutex_lock_guard oAlgoLock(oStream.oAlgoMutex);
+                if(!oStream.bInitialized) {
+                    // the ring slot is recycled by the client, and the algo may hold on to its init image
+                    oStream.pAlgo->initialize(oFrame.clone());
+                    oStream.bInitialized = true;
+                }
+                uchar* const pMaskData = oMask.data;
+                if(dTimestamp>=0)
+                    oStream.pAlgo->applyTimestamped(oFrame,oMask,dTimestamp);
+                else
+                    oStream.pAlgo->apply(oFrame,oMask);
+                bFailed = (oMask.data!=pMaskData); // mask must be written in the ring slot
+            }
+            catch(...) {
+                bFailed = true;
+            }
+            if(bFailed)
+                ++m_nFailedFrames;
+            oStream.pRing->completeFrame(bFailed);
+        }
+        oStream.bBusy.store(false,std::memory_order_release);
+    }
+    /// name of the service (prefix of all segment names)
+    const std::string m_sServiceName;
+    /// control segment of the service
+    BGSServiceControl m_oControl;
+    /// algorithm instance factory (binds the constructor parameters)
+    const std::function<std::unique_ptr<TBackgroundSubtractor>()> m_lAlgoFactory;
+    /// hosted streams, by id
+    std::map<size_t,std::shared_ptr<StreamData>> m_mpStreams;
+    /// guards the stream map & id counter (mutable for const queries)
+    mutable std::mutex m_oMutex;
+    /// dispatcher stop flag & thread
+    std::atomic<bool> m_bStopRequested;
+    std::thread m_oDispatcher;
+    /// next stream id to assign (ids are never reused)
+    size_t m_nNextStreamID;
+    /// number of frames that could not be segmented
+    std::atomic<size_t> m_nFailedFrames;
+    /// worker pool running the frame jobs (declared last, so it is joined before the streams are released)
+    lv::WorkerPool<nWorkers> m_oWorkerPool;
+};
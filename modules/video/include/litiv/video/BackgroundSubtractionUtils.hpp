@@ -19,8 +19,76 @@
 
 #include "litiv/utils/parallel.hpp"
 #include "litiv/utils/opencv.hpp"
+#include "litiv/utils/profiler.hpp"
 #include <opencv2/video/background_segm.hpp>
 
+/// defines the default tile size (in pixels, power of two >= 16) used by the change gate of IIBackgroundSubtractor
+#define BGS_DEFAULT_CHANGE_GATE_TILE_SIZE (16)
+/// defines the default refresh rate of change-gated tiles (one pixel out of N is still segmented per frame)
+#define BGS_DEFAULT_CHANGE_GATE_REFRESH_RATE (16)
+
+/// per-stage timers & counters registry filled by background subtractors when instrumentation is enabled (all values accumulate until reset)
+struct BGSInstrumentation {
+    /// list of timed processing stages (stages interleaved per pixel are timed as a whole via Stage_PixelLoop)
+    enum Stage {
+        Stage_PixelLoop, ///< descriptor extraction, model matching & stochastic model update
+        Stage_PostProc, ///< frame-level FG mask post-processing (morphology, hole filling, median blur)
+        Stage_MotionAnalysis, ///< frame-level motion/camera change analysis & automatic model reset
+        Stage_Total, ///< full 'apply' call
+        nStageCount
+    };
+    /// list of accumulated counters
+    enum Counter {
+        Counter_Frames, ///< number of instrumented 'apply' calls
+        Counter_Pixels, ///< number of pixels processed in the pixel loop
+        Counter_SamplesTested, ///< number of model samples/words fully compared with input pixels
+        Counter_EarlyExits, ///< number of pixels for which matching stopped before scanning the whole model
+        nCounterCount
+    };
+    /// default constructor (all timers & counters start at zero)
+    BGSInstrumentation() {reset();}
+    /// resets all timers & counters to zero
+    void reset();
+    /// returns the name of the given stage (for metric export)
+    static const char* getStageName(Stage eStage);
+    /// returns the total time spent in the given stage (in seconds)
+    double getStageTime(Stage eStage) const {return m_adStageTimes[eStage];}
+    /// returns the average time spent in the given stage per frame (in seconds)
+    double getAvgStageTime(Stage eStage) const {return m_anCounters[Counter_Frames]?m_adStageTimes[eStage]/m_anCounters[Counter_Frames]:0.0;}
+    /// returns the current value of the given counter
+    uint64_t getCounter(Counter eCounter) const {return m_anCounters[eCounter];}
+    /// returns the average number of samples tested per processed pixel
+    double getAvgSamplesTestedPerPx() const {return m_anCounters[Counter_Pixels]?double(m_anCounters[Counter_SamplesTested])/m_anCounters[Counter_Pixels]:0.0;}
+    /// returns the fraction of processed pixels for which matching stopped early
+    double getEarlyExitRatio() const {return m_anCounters[Counter_Pixels]?double(m_anCounters[Counter_EarlyExits])/m_anCounters[Counter_Pixels]:0.0;}
+    /// adds the given time (in seconds) to a stage timer
+    void addStageTime(Stage eStage, double dTime) {m_adStageTimes[eStage] += dTime;}
+    /// adds the given value to a counter
+    void addCount(Counter eCounter, uint64_t nCount) {m_anCounters[eCounter] += nCount;}
+    /// scoped stage timer (no-op if constructed with a null registry)
+    struct ScopedTimer {
+        ScopedTimer(BGSInstrumentation* pInstr, Stage eStage) : m_pInstr(pInstr), m_eStage(eStage) {}
+        ~ScopedTimer() {if(m_pInstr) m_pInstr->addStageTime(m_eStage,m_oStopWatch.tock());}
+    private:
+        BGSInstrumentation* const m_pInstr;
+        const Stage m_eStage;
+        lv::StopWatch m_oStopWatch;
+    };
+private:
+    std::array<double,nStageCount> m_adStageTimes;
+    std::array<uint64_t,nCounterCount> m_anCounters;
+};
+
+#if USE_BGS_INSTRUMENTATION
+/// times the rest of the current scope as the given stage of the current algo's registry (if instrumentation is enabled at runtime)
+#define BGS_INSTR_SCOPED_TIMER(stage) BGSInstrumentation::ScopedTimer XSTR_CONCAT(__oBGSInstrTimer_,__LINE__)(this->getActiveInstrumentation(),BGSInstrumentation::stage)
+/// adds the given value to a counter of the current algo's registry (if instrumentation is enabled at runtime)
+#define BGS_INSTR_ADD_COUNT(counter,val) {if(BGSInstrumentation* __pBGSInstr=this->getActiveInstrumentation()) __pBGSInstr->addCount(BGSInstrumentation::counter,(uint64_t)(val));}
+#else //(!USE_BGS_INSTRUMENTATION)
+#define BGS_INSTR_SCOPED_TIMER(stage)
+#define BGS_INSTR_ADD_COUNT(counter,val) lvIgnore(val)
+#endif //(!USE_BGS_INSTRUMENTATION)
+
 struct IIBackgroundSubtractor : public cv::BackgroundSubtractor {
 
     // @@@ add refresh model as virtual pure func here?
@@ -33,12 +101,102 @@ struct IIBackgroundSubtractor : public cv::BackgroundSubtractor {
     virtual double getDefaultLearningRate() const = 0;
     /// turns automatic model reset on or off
     virtual void setAutomaticModelReset(bool);
+    /// reseeds the internal random number generator used for model updates (instances use a fixed default seed)
+    virtual void setRandomSeed(uint64_t nSeed);
     /// modifies the given ROI so it will not cause lookup errors near borders when used in the processing step
     virtual void validateROI(cv::Mat& oROI) const;
     /// sets the ROI to be used for input analysis (note: this function will reinit the model and return the validated ROI)
     virtual void setROI(cv::Mat& oROI);
+    /// updates the ROI of a running model incrementally when supported (only newly added pixels are initialized, from their nearest previous ROI pixels), and falls back to 'setROI' otherwise; returns the validated ROI
+    void updateROI(cv::Mat& oROI);
     /// returns a copy of the ROI used for input analysis
     virtual cv::Mat getROICopy() const;
+    /// toggles ROI-compacted processing, where frame-level post-processing only covers the (padded) bounding box of the ROI instead of the full frame
+    void setROICompactedProcessing(bool bEnabled);
+    /// toggles the fused (strip-based, cache-resident) version of the frame-level FG mask post-processing chain (has no effect on algos without such a chain)
+    void setFusedPostProcessing(bool bEnabled);
+    /// sets the scale factor in ]0,1] applied to input frames before modeling (FG masks are upsampled back to input size); applies on next 'initialize' call
+    void setProcessingScale(double dScale);
+    /// returns the scale factor applied to input frames before modeling
+    double getProcessingScale() const;
+    /// layouts of the frames given to 'initialize'/'apply' (YUV 4:2:0 frames are single-channel 8-bit mats of (3/2*height)xwidth, as emitted by hardware decoders)
+    enum InputFormat {
+        InputFormat_Default, ///< BGR(A), grayscale or 16-bit frames, used as-is
+        InputFormat_NV12, ///< full luma plane followed by a half-resolution interleaved UV plane
+        InputFormat_I420, ///< full luma plane followed by half-resolution U and V planes
+    };
+    /// sets the input frame layout; YUV frames are either converted to BGR internally (in a single fused pass when the processing scale is 1/2), or reduced to their luma plane without any conversion if bLumaOnly is set (must be called before 'initialize')
+    void setInputFormat(InputFormat eFormat, bool bLumaOnly=false);
+    /// returns the input frame layout
+    InputFormat getInputFormat() const {return m_eInputFormat;}
+    /// sets the NUMA node large model buffers are bound to (-1 = node of the thread calling 'initialize', i.e. the worker processing the stream in batched mode); applies on next 'initialize' call
+    void setModelNUMANode(int nNUMANode);
+    /// returns the NUMA node large model buffers are currently bound to (-1 if unknown or not initialized)
+    int getModelNUMANode() const;
+    /// toggles temporal decimation for timestamped inputs: gaps w.r.t. the nominal frame interval (in seconds) are compensated, and only one frame out of nUpdateStride updates the model
+    void setTemporalDecimation(bool bEnabled, double dNominalFrameInterval=1.0/30, size_t nUpdateStride=1);
+    /// model update/segmentation function for timestamped frames (in seconds); in temporal decimation mode, skipped intervals are compensated, and non-update frames are only classified
+    void applyTimestamped(cv::InputArray oImage, cv::OutputArray oFGMask, double dTimestamp, double dLearningRate=-1);
+    /// toggles change gating for mostly idle cameras: tiles whose mean abs difference w.r.t. their last fully segmented content stays under an adaptive noise floor reuse their
+    /// previous FG labels, and only 1/nRefreshRate of their pixels are segmented (and update the model) per frame (8-bit inputs only; applies on next 'initialize' call; no effect on impls without gating support)
+    void setChangeGating(bool bEnabled, size_t nTileSize=BGS_DEFAULT_CHANGE_GATE_TILE_SIZE, size_t nRefreshRate=BGS_DEFAULT_CHANGE_GATE_REFRESH_RATE);
+    /// returns whether change gating is enabled
+    bool isUsingChangeGating() const {return m_bUsingChangeGating;}
+    /// returns the fraction of tiles flagged as changed by the change gate during the last 'apply' call (1 if gating was not used)
+    double getLastChangedTileFraction() const;
+    /// model update/segmentation function with a bit-packed (1bpp) FG mask output, e.g. for streams keeping long mask histories
+    void applyPacked(cv::InputArray oImage, lv::PackedBinaryMask& oFGMask, double dLearningRate=-1);
+    /// runtime cost/quality knobs of a governor level (impls ignore the knobs they do not have)
+    struct QualityKnobs {
+        double dSampleFraction; ///< fraction of the model samples tested & updated per pixel (never less than the required match count)
+        bool bForce3x3Spread; ///< whether BG neighbor updates are forced to the 3x3 spread (which updates neighbors half as often as the 5x5 one)
+        int nMaxMedianBlurKernelSize; ///< upper bound on the FG mask post-processing median blur kernel size
+        double dUpdateRateFactor; ///< factor (>=1) applied to finite model update rates (i.e. fewer model updates)
+        double dProcessingScaleFactor; ///< factor (<=1) applied to the processing scale (only used if rescaling is allowed, as it reinitializes the model)
+    };
+    /// returns the number of governor quality levels (level 0 = full quality, i.e. the algo's own parameters)
+    static size_t getGovernorLevelCount();
+    /// toggles the quality/performance governor, which steps the quality level down when the average 'apply' time exceeds the given budget (in seconds), and back up when there is headroom
+    void setGovernor(bool bEnabled, double dFrameTimeBudget=1.0/30, bool bAllowRescaling=false);
+    /// returns whether the quality/performance governor is enabled
+    bool isUsingGovernor() const {return m_bUsingGovernor;}
+    /// sets the governor quality level directly (e.g. from a live scheduler degradation callback); if the governor is enabled, it keeps adjusting it from there
+    void setGovernorLevel(size_t nLevel);
+    /// returns the current governor quality level
+    size_t getGovernorLevel() const {return m_nGovernorLevel;}
+    /// returns the knobs of the current governor quality level
+    const QualityKnobs& getQualityKnobs() const {return m_oQualityKnobs;}
+    /// returns the moving average of the 'apply' times measured by the governor (in seconds)
+    double getGovernorAvgFrameTime() const {return m_dGovernorAvgFrameTime;}
+    /// writes a versioned binary snapshot of the current model (including frame counters & random state) to the given stream
+    void saveModel(std::ostream& oStream) const;
+    /// restores a model snapshot written by saveModel (the algorithm must be of the same type, and constructed with the same parameters)
+    void loadModel(std::istream& oStream);
+    /// returns a new instance with the same parameters, settings & model state (large sample buffers are shared copy-on-write where supported, so memory only grows as the instances diverge)
+    std::shared_ptr<IIBackgroundSubtractor> clone();
+    /// toggles per-stage timers & counters at runtime (no effect if compiled without USE_BGS_INSTRUMENTATION)
+    void setInstrumentation(bool bEnabled);
+    /// returns the per-stage timers & counters registry (accumulated since the last reset)
+    const BGSInstrumentation& getInstrumentation() const {return m_oInstrumentation;}
+    /// resets all per-stage timers & counters
+    void resetInstrumentation() {m_oInstrumentation.reset();}
+    /// returns the memory tracker tag of this instance (wrap init/apply calls in a lv::MemoryTracker::Scope over it to attribute their allocations)
+    const lv::MemoryTracker::TagPtr& getMemoryTag() const {return m_pMemoryTag;}
+    /// returns the memory usage currently attributed to this instance
+    lv::MemoryTracker::Usage getMemoryUsage() const;
+    /// FG blob (8-connected component of the final FG mask) info returned by 'getLastBlobs'
+    struct FGBlob {
+        /// bounding box of the blob (in input frame coordinates)
+        cv::Rect oBBox;
+        /// number of FG pixels in the blob (in input frame scale)
+        size_t nArea;
+    };
+    /// toggles FG blob extraction during the final FG mask post-processing pass, with an optional label map (see 'getLastBlobs' & 'getLastBlobLabels')
+    void setBlobOutput(bool bEnabled, bool bWithLabelMap=false);
+    /// returns the FG blobs of the mask produced by the last 'apply' or 'classify' call, in raster order (empty if blob output is disabled)
+    const std::vector<FGBlob>& getLastBlobs() const {return m_voLastBlobs;}
+    /// returns the blob label map (CV_32SC1 at processing size, 0 = BG, n = blob n-1) of the mask produced by the last 'apply' or 'classify' call (empty if not requested)
+    const cv::Mat& getLastBlobLabels() const {return m_oLastBlobLabels;}
     /// required for derived class destruction from this interface
     virtual ~IIBackgroundSubtractor() {}
 
@@ -47,6 +205,105 @@ protected:
     IIBackgroundSubtractor();
     /// common (re)initiaization method for all impl types (should be called in impl-specific initialize func)
     virtual void initialize_common(const cv::Mat& oInitImg, const cv::Mat& oROI);
+    /// writes the impl-specific model state to a snapshot stream (default impl throws, as snapshots are not supported)
+    virtual void writeModelState(std::ostream& oStream) const;
+    /// reads the impl-specific model state from a snapshot stream (called once the model is reinitialized for the snapshot's frame size & ROI)
+    virtual void readModelState(std::istream& oStream);
+    /// applies a new (internal, validated) ROI to the running model without reinitializing it; returns false if incremental ROI updates are not supported (default), in which case the model is reinitialized instead
+    virtual bool updateModelROI(const cv::Mat& oNewROI, size_t nOrigROIPxCount);
+    /// returns a new (uninitialized) instance constructed with the same parameters & impl-specific settings as this one (default impl throws, as cloning is not supported)
+    virtual std::shared_ptr<IIBackgroundSubtractor> createInstance() const;
+    /// replaces the internal ROI and rebuilds its counts, bounding box & pixel lookup tables without touching the model or last frames
+    void setInternalROI(const cv::Mat& oNewROI, size_t nOrigROIPxCount);
+    /// returns the (added px idx, source px idx) pairs of pixels in oNewROI but not in oPrevROI, where each source is the nearest (in 8-connected steps) oPrevROI pixel
+    void getAddedROIPxSources(const cv::Mat& oPrevROI, const cv::Mat& oNewROI, std::vector<std::pair<size_t,size_t>>& vAddedPxSources) const;
+    /// copies the values of source pixels to added pixels in the given continuous per-pixel map (see 'getAddedROIPxSources')
+    static void copyAddedROIPxData(cv::Mat& oMap, const std::vector<std::pair<size_t,size_t>>& vAddedPxSources);
+    /// returns the region covered by frame-level post-processing (the ROI bounding box padded by nMargin in compacted mode, or the full frame otherwise)
+    cv::Rect getPostProcessingRect(int nMargin) const;
+    /// row-by-row 8-connected component labeler fed with the final FG mask rows during post-processing (rows must be fed in order, once each)
+    struct FGBlobLabeler {
+        /// resets the labeler for a mask of the given size (labels are written to the given CV_32SC1 map if not null, and only kept per row pair otherwise)
+        void reset(const cv::Size& oSize, cv::Mat* pLabelMap);
+        /// labels the [nRowBegin,nRowEnd) rows of the given mask, merging provisional labels on the fly via union-find
+        void processRows(const cv::Mat& oFGMask, int nRowBegin, int nRowEnd);
+        /// resolves provisional labels into blobs shifted by oOffset & rescaled by 1/dScale (clipped to oFullSize), and relabels the label map if used
+        void finalize(std::vector<FGBlob>& voBlobs, const cv::Point& oOffset, double dScale, const cv::Size& oFullSize);
+    private:
+        struct BlobStats {int nMinX,nMinY,nMaxX,nMaxY; size_t nArea;};
+        int findRoot(int nLabel);
+        int unite(int nLabelA, int nLabelB);
+        cv::Size m_oSize;
+        cv::Mat m_oLabelMap;
+        int m_nNextRow;
+        std::array<std::vector<int>,2> m_avnRowLabels;
+        std::vector<int> m_vnParents, m_vnBlobIdxs;
+        std::vector<BlobStats> m_voStats;
+    };
+    /// returns the blob labeler to feed with the final FG mask rows of the given post-processing rect, or nullptr if blob output is disabled
+    FGBlobLabeler* beginBlobExtraction(const cv::Rect& oPostProcRect);
+    /// resolves the blobs fed to the labeler since the last 'beginBlobExtraction' call (clears the blob list if blob output is disabled)
+    void endBlobExtraction(const cv::Rect& oPostProcRect);
+    /// fused, strip-based version of the blink masking, hole filling, morphology & median blur FG mask post-processing chain (same output as the
+    /// sequential version, except that the temp pre-flood & flooded masks are left in their intermediate state, and the inverted dilated mask is not updated)
+    static void postProcessFGMask_fused(cv::Mat& oCurrFGMask, cv::Mat& oLastFGMask, cv::Mat& oLastRawFGMask, cv::Mat& oCurrRawFGBlinkMask,
+                                        cv::Mat& oLastRawFGBlinkMask, cv::Mat& oBlinksFrame, cv::Mat& oFGMask_PreFlood, cv::Mat& oFGMask_FloodedHoles,
+                                        cv::Mat& oLastFGMask_dilated, const cv::Mat& oLastFGMask_dilated_inverted, const cv::Mat& oMorphExStructElement,
+                                        int nMedianBlurKernelSize, FGBlobLabeler* pBlobLabeler=nullptr);
+    /// scales the frame & ROI given to 'initialize' to the processing size (no-op if the processing scale is 1; should be called first in impl-specific initialize func)
+    void scaleInitData(const cv::Mat& oInitImg, const cv::Mat& oROI, cv::Mat& oScaledInitImg, cv::Mat& oScaledROI);
+    /// returns the input frame to use for modeling (decoded from YUV if needed, and downsampled to the processing size via INTER_AREA if needed)
+    cv::Mat getScaledInput(const cv::Mat& oInputImg);
+    /// converts a YUV 4:2:0 input frame to the given size (luma plane view/resize, or BGR conversion, fused with 2x2 averaging for half-size outputs)
+    cv::Mat decodeYUVInput(const cv::Mat& oInputImg, const cv::Size& oOutputSize, cv::Mat& oOutputImg);
+    /// returns the FG mask to fill during modeling (the output mask itself, or an internal buffer at processing size if downsampling)
+    cv::Mat getScaledOutputMask(cv::OutputArray oFGMask);
+    /// upsamples the internal FG mask to input size using joint bilateral refinement on mask borders (no-op if the processing scale is 1)
+    void upscaleOutputMask(const cv::Mat& oScaledFGMask, cv::OutputArray oFGMask, const cv::Mat& oInputImg) const;
+    /// runs the change gate over a new input frame (at processing size): flags changed tiles, refreshes their reference content & adapts the noise floor; returns whether unchanged tiles can be gated
+    bool updateChangeGate(const cv::Mat& oInputImg);
+    /// returns whether the given ROI pixel lies in a tile flagged as unchanged by the last 'updateChangeGate' call
+    bool isChangeGatedPx(size_t nPxIdx) const {
+        lvDbgAssert(!m_oChangeGateTileMask.empty() && nPxIdx<m_voPxInfoLUT.size());
+        const PxInfoBase& oPxInfo = m_voPxInfoLUT[nPxIdx];
+        return !m_oChangeGateTileMask.data[(oPxInfo.nImgCoord_Y>>m_nChangeGateTileSizeBits)*m_oChangeGateTileMask.cols+(oPxInfo.nImgCoord_X>>m_nChangeGateTileSizeBits)];
+    }
+    /// returns the moving average factor equivalent to applying the given one once per nominal frame covered by the current 'apply' call
+    float getCompensatedRollAvgFactor(float fRollAvgFactor) const;
+    /// returns the (1/N) update rate equivalent to applying the given one once per nominal frame since the last model update
+    double getCompensatedLearningRate(double dLearningRate) const;
+    /// scoped governor frame timer; must be declared before the model lock in impl-specific 'apply' funcs, as the model may be reinitialized (for rescaling) on scope exit
+    struct GovernorScope {
+        GovernorScope(IIBackgroundSubtractor* pAlgo, cv::InputArray oImage);
+        ~GovernorScope();
+    private:
+        IIBackgroundSubtractor* const m_pAlgo;
+        const cv::Mat m_oImage;
+        lv::StopWatch m_oStopWatch;
+    };
+    /// updates the moving average 'apply' time with a new measurement, and steps the governor quality level if needed
+    void updateGovernor(double dFrameTime);
+    /// reinitializes the model from the given input frame if the processing scale factor of the governor level changed
+    void updateGovernorScale(const cv::Mat& oInputImg);
+    /// returns the given update rate scaled by the governor (infinite & non-positive rates are returned as-is)
+    double getGovernedLearningRate(double dLearningRate) const {return (dLearningRate>0 && !std::isinf(dLearningRate))?dLearningRate*m_oQualityKnobs.dUpdateRateFactor:dLearningRate;}
+    /// returns the number of samples to test & update per pixel at the current governor level for a model of nSamples samples requiring nRequiredSamples matches
+    size_t getGovernedSampleCount(size_t nSamples, size_t nRequiredSamples) const;
+    /// returns the median blur kernel size to use at the current governor level
+    int getGovernedMedianBlurKernelSize(int nKernelSize) const {return std::min(nKernelSize,m_oQualityKnobs.nMaxMedianBlurKernelSize);}
+    /// returns the registry to fill if instrumentation is enabled, or nullptr otherwise
+    BGSInstrumentation* getActiveInstrumentation() {return m_bUsingInstrumentation?&m_oInstrumentation:nullptr;}
+    /// slot indices of the transient scratch buffers borrowed during 'apply' & 'classify' (see getScratchBuffer)
+    enum ScratchBufferSlot {
+        ScratchBuffer_FGMask_PreFlood,
+        ScratchBuffer_FGMask_FloodedHoles,
+        ScratchBuffer_LastFGMask_dilated,
+        ScratchBuffer_CurrRawFGBlinkMask,
+        ScratchBuffer_FGMask_Blurred, ///< only used by 'classify' (which cannot blur into the last FG mask)
+        nScratchBufferCount
+    };
+    /// returns a transient buffer of the given size & type owned by the calling thread and shared by all instances (contents are undefined, and only stay valid until the slot is borrowed again)
+    static cv::Mat getScratchBuffer(ScratchBufferSlot eSlot, const cv::Size& oSize, int nType);
 
     /// basic info struct used in px model LUTs
     struct PxInfoBase {
@@ -70,6 +327,36 @@ protected:
     size_t m_nOrigROIPxCount, m_nFinalROIPxCount;
     /// current frame index, frame count since last model reset & model reset cooldown counters
     size_t m_nFrameIdx, m_nFramesSinceLastReset, m_nModelResetCooldown;
+    /// number of nominal frames covered by the current 'apply' call, and since the last model update (both always 1 outside temporal decimation mode)
+    size_t m_nCurrFrameStride, m_nCurrUpdateStride;
+    /// temporal decimation mode toggle, nominal frame interval, model update stride & bookkeeping for timestamped inputs
+    bool m_bUsingTemporalDecimation;
+    double m_dNominalFrameInterval;
+    size_t m_nDecimationUpdateStride, m_nFramesSinceLastUpdate;
+    double m_dLastFrameTimestamp, m_dLastUpdateTimestamp;
+    /// change gating toggle, tile size (as a power of two) & refresh rate of gated tiles
+    bool m_bUsingChangeGating;
+    size_t m_nChangeGateTileSizeBits, m_nChangeGateRefreshRate;
+    /// per-tile change flags of the last gated frame (1 = changed), and reference frame holding the last fully segmented content of each tile
+    cv::Mat m_oChangeGateTileMask, m_oChangeGateRefFrame;
+    /// change gate noise floor (moving average of the mean abs difference per channel in unchanged tiles), and number of tiles flagged as changed in the last frame
+    double m_dChangeGateNoiseFloor;
+    size_t m_nChangeGateChangedTiles;
+    /// per-tile abs difference sums of the tile row being tested by the change gate
+    std::vector<uint64_t> m_vnChangeGateTileSADs;
+    /// original input image size (before scaling to the processing size)
+    cv::Size m_oInputSize;
+    /// scale factor applied to input frames before modeling
+    double m_dProcessingScale;
+    /// downsampled input frame & FG mask buffers used when the processing scale is not 1
+    cv::Mat m_oScaledInputFrame, m_oScaledFGMask;
+    /// input frame layout, and whether YUV inputs are reduced to their luma plane or not
+    InputFormat m_eInputFormat;
+    bool m_bUsingLumaOnlyInput;
+    /// full-size BGR frame buffer used when YUV inputs cannot be decoded & downsampled in a single pass
+    cv::Mat m_oDecodedInputFrame;
+    /// bounding box of all relevant ROI pixels
+    cv::Rect m_oROIBoundingRect;
     /// internal pixel index LUT for all relevant analysis regions (based on the provided ROI)
     std::vector<size_t> m_vnPxIdxLUT;
     /// internal pixel info LUT for all possible pixel indexes
@@ -82,10 +369,48 @@ protected:
     bool m_bAutoModelResetEnabled;
     /// specifies whether the camera is considered moving or not
     bool m_bUsingMovingCamera;
+    /// specifies whether frame-level post-processing is restricted to the ROI bounding box or not
+    bool m_bUsingROICompactedProcessing;
+    /// specifies whether the fused frame-level post-processing chain is used or not
+    bool m_bUsingFusedPostProcessing;
+    /// specifies whether FG blobs (and their label map) are extracted during post-processing or not
+    bool m_bUsingBlobOutput, m_bUsingBlobLabelMap;
+    /// FG blob labeler, blobs & label map of the last processed frame
+    FGBlobLabeler m_oBlobLabeler;
+    std::vector<FGBlob> m_voLastBlobs;
+    cv::Mat m_oLastBlobLabels;
     /// the foreground mask generated by the method at [t-1]
     cv::Mat m_oLastFGMask;
+    /// intermediary (unpacked) FG mask buffer used by 'applyPacked'
+    cv::Mat m_oUnpackedFGMask;
     /// copy of latest pixel intensities (used when refreshing model)
     cv::Mat m_oLastColorFrame;
+    /// per-instance random number generator used for model init/updates (avoids the global lock of rand())
+    lv::PCG32 m_oRNG;
+    /// specifies whether per-stage timers & counters are updated or not
+    bool m_bUsingInstrumentation;
+    /// per-stage timers & counters registry
+    BGSInstrumentation m_oInstrumentation;
+    /// governor toggle, per-frame time budget & rescaling permission
+    bool m_bUsingGovernor;
+    double m_dGovernorFrameTimeBudget;
+    bool m_bGovernorRescalingAllowed;
+    /// governor quality level & its knobs, and processing scale factor the current model was built with
+    size_t m_nGovernorLevel;
+    QualityKnobs m_oQualityKnobs;
+    double m_dGovernorAppliedScaleFactor;
+    /// moving average of 'apply' times, frame count since the last level change & current upgrade delay (doubled when upgrades overload)
+    double m_dGovernorAvgFrameTime;
+    size_t m_nGovernorFramesSinceChange, m_nGovernorUpgradeDelay;
+    bool m_bGovernorLastChangeWasUpgrade;
+    /// NUMA node requested for model buffers (-1 = initializing thread's node), and node resolved by the last 'initialize' call
+    int m_nRequestedModelNUMANode, m_nModelNUMANode;
+    /// returns the matrix allocator to be used for large per-pixel model buffers (huge pages, bound to the model NUMA node)
+    cv::MatAllocator* getModelMatAllocator() const {return cv::LargePageMatAllocator::get(m_nModelNUMANode);}
+    /// memory tracker tag all allocations made on behalf of this instance are attributed to
+    const lv::MemoryTracker::TagPtr m_pMemoryTag;
+    /// instance being cloned while 'clone' writes & reads back the model snapshot (set on both instances, so impls can share buffers instead of streaming them)
+    IIBackgroundSubtractor* m_pModelCloneSource;
 
 private:
     IIBackgroundSubtractor& operator=(const IIBackgroundSubtractor&) = delete;
@@ -102,16 +427,18 @@ struct IBackgroundSubtractor_<lv::GLSL> :
         public IIBackgroundSubtractor {
     /// required for derived class destruction from this interface
     virtual ~IBackgroundSubtractor_() {}
-    /// returns a copy of the latest foreground mask
-    void getLatestForegroundMask(cv::OutputArray oLastFGMask);
+    /// returns a copy of the latest foreground mask, and the internal index of the 'apply_gl' call that produced it (see 'setAsyncFetching' for latency)
+    size_t getLatestForegroundMask(cv::OutputArray oLastFGMask);
     /// (re)initiaization method (asynchronous version w/ gl interface); needs to be called before starting background subtraction
     virtual void initialize_gl(const cv::Mat& oInitImg, const cv::Mat& oROI) override;
     /// overloads 'initialize' from IIBackgroundSubtractor and redirects it to 'initialize_gl'
     virtual void initialize(const cv::Mat& oInitImg, const cv::Mat& oROI) override final;
     /// model update/segmentation function (asynchronous version w/ gl interface); the learning param is used to override the internal learning speed
     void apply_gl(cv::InputArray oNextImage, bool bRebindAll=false, double dLearningRate=-1);
-    /// model update/segmentation function (asynchronous version w/ gl interface); the learning param is used to override the internal learning speed
+    /// model update/segmentation function (asynchronous version w/ gl interface); the returned mask lags one call behind the input, or two if async fetching is enabled
     void apply_gl(cv::InputArray oNextImage, cv::OutputArray oLastFGMask, bool bRebindAll=false, double dLearningRate=-1);
+    /// model update/segmentation function (asynchronous version w/ gl interface) for images already on the gpu, e.g. decoded via cuda/egl interop (see GLImageProcAlgo::apply_gl_device); the host-side copy of the last image is left as-is
+    void apply_gl_device(GLuint nNextImageTex, bool bRebindAll=false, double dLearningRate=-1);
     /// overloads 'apply' from IIBackgroundSubtractor and redirects it to 'apply_gl'
     virtual void apply(cv::InputArray oNextImage, cv::OutputArray oLastFGMask, double dLearningRate=-1) override final;
 
@@ -144,3 +471,344 @@ struct IBackgroundSubtractor_<lv::NonParallel> :
 };
 
 using IBackgroundSubtractor = IBackgroundSubtractor_<lv::NonParallel>;
+
+/*!
+    Batch runner for non-parallel background subtractors; owns one algorithm instance per video stream (all of the same
+    type and built with the same parameters), and runs them over a batch of frames (one per stream) in a single call on a
+    shared worker pool. Streams processed by the same worker share its scratch buffers (see IIBackgroundSubtractor::getScratchBuffer),
+    but models are never packed together; GLSL impls are not supported, as each of them is bound to its own pipeline.
+    Output masks provided by the caller are reused across calls if their size & type match.
+ */
+template<typename TBackgroundSubtractor>
+struct BackgroundSubtractorBatch {
+    static_assert(std::is_base_of<IBackgroundSubtractor,TBackgroundSubtractor>::value,"batched processing requires non-parallel background subtractor impls");
+    /// creates nStreams algorithm instances constructed with the given parameters, processed using nThreads threads (0 = one per hardware thread)
+    template<typename... TArgs>
+    explicit BackgroundSubtractorBatch(size_t nStreams, size_t nThreads, const TArgs&... args) {
+        lvAssert_(nStreams>0,"batch must contain at least one stream");
+        for(size_t nStreamIdx=0; nStreamIdx<nStreams; ++nStreamIdx)
+            m_vpStreams.push_back(std::make_unique<TBackgroundSubtractor>(args...));
+        setThreadCount(nThreads);
+    }
+    /// (re)initializes all streams using one init image (and optionally one ROI) per stream
+    void initialize(const std::vector<cv::Mat>& voInitImgs, const std::vector<cv::Mat>& voROIs=std::vector<cv::Mat>()) {
+        lvAssert_(voInitImgs.size()==m_vpStreams.size(),"init image count must match stream count");
+        lvAssert_(voROIs.empty() || voROIs.size()==m_vpStreams.size(),"ROI count must match stream count");
+        dispatch([&](size_t nStreamIdx) {
+            m_vpStreams[nStreamIdx]->initialize(voInitImgs[nStreamIdx],voROIs.empty()?cv::Mat():voROIs[nStreamIdx]);
+        });
+    }
+    /// processes one frame per stream and returns the matching foreground masks (a negative learning rate means that each stream uses its default)
+    void applyBatch(const std::vector<cv::Mat>& voImages, std::vector<cv::Mat>& voFGMasks, double dLearningRate=-1) {
+        lvAssert_(voImages.size()==m_vpStreams.size(),"image count must match stream count");
+        voFGMasks.resize(m_vpStreams.size());
+        dispatch([&](size_t nStreamIdx) {
+            TBackgroundSubtractor& oStream = *m_vpStreams[nStreamIdx];
+            oStream.apply(voImages[nStreamIdx],voFGMasks[nStreamIdx],(dLearningRate<0)?oStream.getDefaultLearningRate():dLearningRate);
+        });
+    }
+    /// sets the number of threads used to process streams in parallel (1 = sequential; 0 = one per hardware thread, up to the stream count)
+    void setThreadCount(size_t nThreads) {
+        if(nThreads==0)
+            nThreads = std::max((size_t)std::thread::hardware_concurrency(),size_t(1));
+        nThreads = std::min(nThreads,m_vpStreams.size());
+        if(nThreads==1)
+            m_pThreadPool = nullptr;
+        else if(!m_pThreadPool || m_pThreadPool->getThreadCount()!=nThreads)
+            m_pThreadPool = std::make_unique<lv::ThreadPool>(nThreads);
+    }
+    /// returns the number of threads used to process streams in parallel
+    size_t getThreadCount() const {return m_pThreadPool?m_pThreadPool->getThreadCount():size_t(1);}
+    /// returns the number of streams in the batch
+    size_t getStreamCount() const {return m_vpStreams.size();}
+    /// returns the algorithm instance of a given stream (e.g. for per-stream configuration or model snapshots)
+    TBackgroundSubtractor& getStream(size_t nStreamIdx) {
+        lvAssert_(nStreamIdx<m_vpStreams.size(),"stream index out of range");
+        return *m_vpStreams[nStreamIdx];
+    }
+
+protected:
+    /// runs the given task once per stream, using the worker pool if available
+    void dispatch(const std::function<void(size_t)>& lTask) {
+        if(m_pThreadPool)
+            m_pThreadPool->parallel_for(m_vpStreams.size(),lTask);
+        else
+            for(size_t nStreamIdx=0; nStreamIdx<m_vpStreams.size(); ++nStreamIdx)
+                lTask(nStreamIdx);
+    }
+    /// per-stream algorithm instances
+    std::vector<std::unique_ptr<TBackgroundSubtractor>> m_vpStreams;
+    /// worker pool shared by all streams (only allocated when more than one thread is used)
+    std::unique_ptr<lv::ThreadPool> m_pThreadPool;
+};
+
+/**
+    Live multi-stream background subtraction scheduler; owns one algorithm instance per video stream, and turns each
+    frame submitted for a stream into a job whose deadline is its arrival time plus the stream's frame period. Jobs are
+    run earliest-deadline-first on a shared worker pool (frames of a given stream are always processed in order, one at
+    a time), and the overload policy decides what to do with jobs that are predicted to miss their deadline based on the
+    stream's measured processing time. Results are reported through a callback invoked from the worker threads.
+ */
+template<typename TBackgroundSubtractor, size_t nWorkers=4>
+struct BackgroundSubtractorLiveScheduler {
+    static_assert(std::is_base_of<IBackgroundSubtractor,TBackgroundSubtractor>::value,"live scheduling requires non-parallel background subtractor impls");
+    /// actions taken for jobs that are predicted to miss their deadline
+    enum OverloadPolicy {
+        OverloadPolicy_None, ///< always process frames fully, and only record deadline misses
+        OverloadPolicy_DeferUpdate, ///< classify late frames without updating the model
+        OverloadPolicy_Decimate, ///< drop late frames if a newer frame of the same stream is already queued (otherwise, defer their model update)
+        OverloadPolicy_Degrade, ///< process late frames fully, and notify the degradation callback on overload state changes (e.g. to lower quality via a governor)
+    };
+    /// per-job report given to the result callback (the mask is empty for dropped frames)
+    struct JobResult {
+        size_t nStreamIdx; ///< index of the stream the frame was submitted for
+        size_t nFrameIdx; ///< submission index of the frame in its stream
+        bool bDropped; ///< whether the frame was dropped without being processed
+        bool bUpdateDeferred; ///< whether the frame was classified without updating the model
+        bool bDeadlineMissed; ///< whether processing ended after the job deadline (always true for dropped frames)
+        double dLatency; ///< time elapsed between frame submission and the end of its processing, in seconds
+    };
+    /// per-stream scheduling statistics (accumulated since the last reset)
+    struct StreamStats {
+        size_t nSubmittedFrames = 0; ///< number of frames submitted
+        size_t nProcessedFrames = 0; ///< number of frames processed (including deferred updates)
+        size_t nDroppedFrames = 0; ///< number of frames dropped (by decimation or queue overflow)
+        size_t nDeferredUpdates = 0; ///< number of frames classified without model update
+        size_t nMissedDeadlines = 0; ///< number of jobs that ended after their deadline (including dropped frames)
+        double dAvgProcTime = 0.0; ///< moving average of the 'apply' call duration, in seconds
+        double dAvgLatency = 0.0; ///< moving average of the submission-to-result latency of processed frames, in seconds
+        double dMaxLateness = 0.0; ///< largest (positive) time by which a processed frame missed its deadline, in seconds
+    };
+    /// result callback; invoked from a worker thread after each job, or from 'submitFrame' for frames dropped on queue overflow (the mask is only valid during the call)
+    using ResultCallback = std::function<void(const JobResult&, const cv::Mat& oFGMask)>;
+    /// degradation callback; invoked from a worker thread with exclusive access to the stream when it enters (or leaves) the overloaded state
+    using DegradeCallback = std::function<void(size_t nStreamIdx, TBackgroundSubtractor& oStream, bool bOverloaded)>;
+    /// creates nStreams algorithm instances constructed with the given parameters (all streams default to a 30 fps frame period)
+    template<typename... TArgs>
+    explicit BackgroundSubtractorLiveScheduler(size_t nStreams, const TArgs&... args) :
+            m_eOverloadPolicy(OverloadPolicy_DeferUpdate),
+            m_nMaxQueuedFrames(4),
+            m_vStreams(nStreams) {
+        lvAssert_(nStreams>0,"scheduler must handle at least one stream");
+        for(StreamData& oStream : m_vStreams)
+            oStream.pAlgo = std::make_unique<TBackgroundSubtractor>(args...);
+    }
+    /// waits for all queued jobs to end before releasing the streams
+    ~BackgroundSubtractorLiveScheduler() {
+        std::mutex_unique_lock oLock(m_oMutex);
+        m_oIdleCondVar.wait(oLock,[&]{return isIdle();});
+    }
+    /// (re)initializes all streams using one init image (and optionally one ROI) per stream; must not be called while jobs are queued
+    void initialize(const std::vector<cv::Mat>& voInitImgs, const std::vector<cv::Mat>& voROIs=std::vector<cv::Mat>()) {
+        lvAssert_(voInitImgs.size()==m_vStreams.size(),"init image count must match stream count");
+        lvAssert_(voROIs.empty() || voROIs.size()==m_vStreams.size(),"ROI count must match stream count");
+        std::mutex_lock_guard oLock(m_oMutex);
+        lvAssert_(isIdle(),"streams cannot be reinitialized while jobs are queued");
+        for(size_t nStreamIdx=0; nStreamIdx<m_vStreams.size(); ++nStreamIdx)
+            m_vStreams[nStreamIdx].pAlgo->initialize(voInitImgs[nStreamIdx],voROIs.empty()?cv::Mat():voROIs[nStreamIdx]);
+    }
+    /// sets the callback that receives all job results (must be set before submitting frames)
+    void setResultCallback(ResultCallback lCallback) {
+        std::mutex_lock_guard oLock(m_oMutex);
+        m_lResultCallback = std::move(lCallback);
+    }
+    /// sets the callback notified of per-stream overload state changes (only used with OverloadPolicy_Degrade)
+    void setDegradeCallback(DegradeCallback lCallback) {
+        std::mutex_lock_guard oLock(m_oMutex);
+        m_lDegradeCallback = std::move(lCallback);
+    }
+    /// sets the policy applied to jobs that are predicted to miss their deadline
+    void setOverloadPolicy(OverloadPolicy ePolicy) {
+        std::mutex_lock_guard oLock(m_oMutex);
+        m_eOverloadPolicy = ePolicy;
+    }
+    /// sets the frame period (i.e. relative job deadline, in seconds) of a stream
+    void setStreamFramePeriod(size_t nStreamIdx, double dFramePeriod) {
+        lvAssert_(nStreamIdx<m_vStreams.size(),"stream index out of range");
+        lvAssert_(dFramePeriod>0,"frame period must be positive");
+        std::mutex_lock_guard oLock(m_oMutex);
+        m_vStreams[nStreamIdx].dFramePeriod = dFramePeriod;
+    }
+    /// sets the max number of frames queued per stream; the oldest queued frame is dropped when a new one overflows the queue
+    void setMaxQueuedFrames(size_t nMaxQueuedFrames) {
+        lvAssert_(nMaxQueuedFrames>0,"streams must be able to queue at least one frame");
+        std::mutex_lock_guard oLock(m_oMutex);
+        m_nMaxQueuedFrames = nMaxQueuedFrames;
+    }
+    /// queues a frame for the given stream, with a deadline one frame period from now (the frame is referenced, not copied; producers reusing buffers must pass clones)
+    void submitFrame(size_t nStreamIdx, const cv::Mat& oFrame) {
+        lvAssert_(nStreamIdx<m_vStreams.size(),"stream index out of range");
+        lvAssert_(!oFrame.empty(),"frame must not be empty");
+        std::vector<JobResult> vDroppedJobs;
+        {
+            std::mutex_lock_guard oLock(m_oMutex);
+            lvAssert_(m_lResultCallback,"result callback must be set before submitting frames");
+            StreamData& oStream = m_vStreams[nStreamIdx];
+            const Clock::time_point tNow = Clock::now();
+            oStream.qJobs.push_back(Job{oFrame,oStream.oStats.nSubmittedFrames++,tNow,tNow+toDuration(oStream.dFramePeriod)});
+            while(oStream.qJobs.size()>m_nMaxQueuedFrames) {
+                vDroppedJobs.push_back(dropJob(nStreamIdx,oStream.qJobs.front(),tNow));
+                oStream.qJobs.pop_front();
+            }
+        }
+        for(const JobResult& oResult : vDroppedJobs)
+            m_lResultCallback(oResult,cv::Mat());
+        m_oWorkerPool.submit([this](){runReadyJobs();});
+    }
+    /// blocks until all queued jobs are done, and rethrows the first exception thrown by a job (if any)
+    void flush() {
+        std::mutex_unique_lock oLock(m_oMutex);
+        m_oIdleCondVar.wait(oLock,[&]{return isIdle();});
+        if(m_pException) {
+            std::exception_ptr pException = m_pException;
+            m_pException = nullptr;
+            std::rethrow_exception(pException);
+        }
+    }
+    /// returns a copy of the scheduling statistics of a stream
+    StreamStats getStreamStats(size_t nStreamIdx) const {
+        lvAssert_(nStreamIdx<m_vStreams.size(),"stream index out of range");
+        std::mutex_lock_guard oLock(m_oMutex);
+        return m_vStreams[nStreamIdx].oStats;
+    }
+    /// resets the scheduling statistics of all streams (submission indices keep increasing)
+    void resetStreamStats() {
+        std::mutex_lock_guard oLock(m_oMutex);
+        for(StreamData& oStream : m_vStreams) {
+            const size_t nSubmittedFrames = oStream.oStats.nSubmittedFrames;
+            oStream.oStats = StreamStats();
+            oStream.oStats.nSubmittedFrames = nSubmittedFrames;
+        }
+    }
+    /// returns the number of streams handled by the scheduler
+    size_t getStreamCount() const {return m_vStreams.size();}
+    /// returns the algorithm instance of a given stream (must only be modified while no jobs are queued, or from the degradation callback)
+    TBackgroundSubtractor& getStream(size_t nStreamIdx) {
+        lvAssert_(nStreamIdx<m_vStreams.size(),"stream index out of range");
+        return *m_vStreams[nStreamIdx].pAlgo;
+    }
+
+protected:
+    using Clock = std::chrono::steady_clock;
+    /// queued frame along with its scheduling info
+    struct Job {
+        cv::Mat oFrame;
+        size_t nFrameIdx;
+        Clock::time_point tArrival,tDeadline;
+    };
+    /// per-stream algorithm instance, job queue & scheduling state
+    struct StreamData {
+        std::unique_ptr<TBackgroundSubtractor> pAlgo;
+        std::deque<Job> qJobs;
+        cv::Mat oFGMask;
+        double dFramePeriod = 1.0/30;
+        bool bBusy = false;
+        bool bOverloaded = false;
+        StreamStats oStats;
+    };
+    static Clock::duration toDuration(double dSeconds) {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(dSeconds));
+    }
+    static double toSeconds(Clock::duration oDuration) {
+        return std::chrono::duration<double>(oDuration).count();
+    }
+    /// returns whether no job is queued or running (must be called w/ m_oMutex locked)
+    bool isIdle() const {
+        return std::all_of(m_vStreams.begin(),m_vStreams.end(),[](const StreamData& oStream){return !oStream.bBusy && oStream.qJobs.empty();});
+    }
+    /// returns the index of the idle stream with the earliest queued job deadline, or SIZE_MAX if none (must be called w/ m_oMutex locked)
+    size_t getEarliestDeadlineStreamIdx() const {
+        size_t nBestStreamIdx = SIZE_MAX;
+        for(size_t nStreamIdx=0; nStreamIdx<m_vStreams.size(); ++nStreamIdx) {
+            const StreamData& oStream = m_vStreams[nStreamIdx];
+            if(!oStream.bBusy && !oStream.qJobs.empty() && (nBestStreamIdx==SIZE_MAX || oStream.qJobs.front().tDeadline<m_vStreams[nBestStreamIdx].qJobs.front().tDeadline))
+                nBestStreamIdx = nStreamIdx;
+        }
+        return nBestStreamIdx;
+    }
+    /// records a dropped job in the stream stats and returns its report (must be called w/ m_oMutex locked)
+    JobResult dropJob(size_t nStreamIdx, const Job& oJob, Clock::time_point tNow) {
+        StreamStats& oStats = m_vStreams[nStreamIdx].oStats;
+        ++oStats.nDroppedFrames;
+        ++oStats.nMissedDeadlines;
+        return JobResult{nStreamIdx,oJob.nFrameIdx,true,false,true,toSeconds(tNow-oJob.tArrival)};
+    }
+    /// pool task entry point; runs ready jobs earliest-deadline-first until none is left (there may be more tasks than jobs, in which case some return immediately)
+    void runReadyJobs() {
+        static constexpr double s_dAvgFactor = 0.1;
+        std::mutex_unique_lock oLock(m_oMutex);
+        size_t nStreamIdx;
+        while((nStreamIdx=getEarliestDeadlineStreamIdx())!=SIZE_MAX) {
+            StreamData& oStream = m_vStreams[nStreamIdx];
+            oStream.bBusy = true;
+            Job oJob = std::move(oStream.qJobs.front());
+            oStream.qJobs.pop_front();
+            const Clock::time_point tStart = Clock::now();
+            const bool bPredictedLate = tStart+toDuration(oStream.oStats.dAvgProcTime)>oJob.tDeadline;
+            const OverloadPolicy ePolicy = m_eOverloadPolicy;
+            if(ePolicy==OverloadPolicy_Decimate && bPredictedLate && !oStream.qJobs.empty()) {
+                const JobResult oResult = dropJob(nStreamIdx,oJob,tStart);
+                std::unlock_guard<std::mutex_unique_lock> oUnlock(oLock);
+                m_lResultCallback(oResult,cv::Mat());
+            }
+            else {
+                const bool bDeferUpdate = bPredictedLate && (ePolicy==OverloadPolicy_DeferUpdate || ePolicy==OverloadPolicy_Decimate);
+                const bool bNotifyDegrade = ePolicy==OverloadPolicy_Degrade && m_lDegradeCallback && bPredictedLate!=oStream.bOverloaded;
+                oStream.bOverloaded = bPredictedLate;
+                JobResult oResult{nStreamIdx,oJob.nFrameIdx,false,bDeferUpdate,false,0.0};
+                Clock::time_point tEnd;
+                {
+                    std::unlock_guard<std::mutex_unique_lock> oUnlock(oLock);
+                    try {
+                        TBackgroundSubtractor& oAlgo = *oStream.pAlgo;
+                        if(bNotifyDegrade)
+                            m_lDegradeCallback(nStreamIdx,oAlgo,bPredictedLate);
+                        const Clock::time_point tApplyStart = Clock::now();
+                        // same finite 'never update' override as in temporal decimation mode (not all impls support infinite rates)
+                        oAlgo.apply(oJob.oFrame,oStream.oFGMask,bDeferUpdate?(double)UINT_MAX:oAlgo.getDefaultLearningRate());
+                        tEnd = Clock::now();
+                        oResult.dLatency = toSeconds(tEnd-oJob.tArrival);
+                        oResult.bDeadlineMissed = tEnd>oJob.tDeadline;
+                        {
+                            std::mutex_lock_guard oStatsLock(m_oMutex);
+                            StreamStats& oStats = oStream.oStats;
+                            oStats.dAvgProcTime = (oStats.nProcessedFrames==0)?toSeconds(tEnd-tApplyStart):(1-s_dAvgFactor)*oStats.dAvgProcTime+s_dAvgFactor*toSeconds(tEnd-tApplyStart);
+                            oStats.dAvgLatency = (oStats.nProcessedFrames==0)?oResult.dLatency:(1-s_dAvgFactor)*oStats.dAvgLatency+s_dAvgFactor*oResult.dLatency;
+                            ++oStats.nProcessedFrames;
+                            oStats.nDeferredUpdates += size_t(bDeferUpdate);
+                            if(oResult.bDeadlineMissed) {
+                                ++oStats.nMissedDeadlines;
+                                oStats.dMaxLateness = std::max(oStats.dMaxLateness,toSeconds(tEnd-oJob.tDeadline));
+                            }
+                        }
+                        m_lResultCallback(oResult,oStream.oFGMask);
+                    }
+                    catch(...) {
+                        std::mutex_lock_guard oExceptionLock(m_oMutex);
+                        if(!m_pException)
+                            m_pException = std::current_exception();
+                    }
+                }
+            }
+            oStream.bBusy = false;
+            if(isIdle())
+                m_oIdleCondVar.notify_all();
+        }
+    }
+    /// policy applied to jobs predicted to miss their deadline
+    OverloadPolicy m_eOverloadPolicy;
+    /// max number of frames queued per stream
+    size_t m_nMaxQueuedFrames;
+    /// per-stream algorithm instances & scheduling state
+    std::vector<StreamData> m_vStreams;
+    /// result & degradation callbacks
+    ResultCallback m_lResultCallback;
+    DegradeCallback m_lDegradeCallback;
+    /// first exception thrown by a job (rethrown in 'flush')
+    std::exception_ptr m_pException;
+    /// guards all scheduling state (mutable for const stats queries)
+    mutable std::mutex m_oMutex;
+    std::condition_variable m_oIdleCondVar;
+    /// worker pool running the EDF dispatch tasks (declared last, so it is joined before the streams are released)
+    lv::WorkerPool<nWorkers> m_oWorkerPool;
+};
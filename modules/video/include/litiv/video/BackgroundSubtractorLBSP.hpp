@@ -26,6 +26,246 @@
 #define BGSLBSP_DEFAULT_LBSP_OFFSET_SIMILARITY_THRESHOLD (0)
 /// defines the default value for BackgroundSubtractorLBSP::m_nDefaultMedianBlurKernelSize
 #define BGSLBSP_DEFAULT_MEDIAN_BLUR_KERNEL_SIZE (9)
+/// defines the scale factor applied to 8-bit intensity parameters (LBSP offsets, color distance thresholds) for 16-bit inputs
+#define BGSLBSP_16BIT_INTENSITY_SCALE (256)
+/// defines the default number of distinct values stored per pixel when the deduplicated sample model layout is enabled (one match block)
+#define BGSLBSP_DEFAULT_DEDUP_SAMPLE_SLOTS (16)
+
+/*!
+    Background sample model storage for sample-based LBSP methods (one color and one descriptor per channel per sample).
+
+    Two memory layouts are supported: planar (one full image per sample, i.e. the original layout) and interleaved (all
+    samples of a pixel stored contiguously, with each pixel block aligned to 16 elements). Both share the same element
+    addressing scheme (pixel stride + sample stride), so model access code does not need to know which one is used.
+
+    A third, deduplicated layout (8-bit only) stores a fixed number of value slots per pixel in interleaved blocks, each
+    with a weight (the number of samples currently holding that value) and a per-sample slot index. Matching code then
+    iterates over slots and accumulates weights instead of counting matches, which cuts both memory and matching cost on
+    static pixels, where most samples are identical. Samples keep their indices for updates (see 'setSample').
+
+    The planar & interleaved layouts can also keep a bit-sliced (transposed) mirror of the descriptor samples: for each
+    pixel, block of 64 samples and channel, bit k of all descriptors is stored in one 64-bit word. The hamming distances
+    between a query descriptor and all samples of a block are then evaluated at once with bitwise ops and an adder tree
+    (see 'getDescMatchMask'), which lets matching code skip the samples that cannot pass a descriptor distance threshold.
+ */
+struct LBSPSampleModel {
+    /// max number of samples tested at once by getColorMatchMask
+    static constexpr size_t MATCH_BLOCK_SIZE = 16;
+    /// size (in pixels) of the square tiles used to track which parts of the mean images are out of date
+    static constexpr int MEAN_TILE_SIZE = 16;
+    /// number of mean image buffers whose out-of-date tiles are tracked separately (one flag bit per buffer, see 'updateMeanImages')
+    static constexpr size_t MEAN_BUFFER_COUNT = 2;
+    /// default constructor (model must be created before use)
+    LBSPSampleModel();
+    /// max number of distinct values (slots) stored per pixel in the deduplicated layout
+    static constexpr size_t MAX_SLOTS = UCHAR_MAX;
+    /// max number of samples tested at once by getDescMatchMask (one bit per sample in each bit-sliced descriptor plane)
+    static constexpr size_t DESC_PLANE_BLOCK_SIZE = 64;
+    /// (re)allocates and zeroes the model for the given frame size, channel count, sample count, memory layout and color depth (CV_8U or CV_16U), optionally using a custom allocator
+    /// (if nSlots>0, the 8-bit deduplicated layout is used: each pixel stores up to nSlots distinct values in interleaved blocks, with the multiplicity of each value among the samples as its weight)
+    void create(const cv::Size& oImgSize, size_t nChannels, size_t nSamples, bool bInterleaved, int nColorDepth=CV_8U, cv::MatAllocator* pAllocator=nullptr, size_t nSlots=0);
+    /// returns a pointer to the color values (one per channel) of the given sample (or slot, in deduplicated layout) at the given pixel index (8-bit models only)
+    inline uchar* color(size_t nSampleIdx, size_t nPxIdx) {return m_oColorData.data+nPxIdx*m_nPxStride+nSampleIdx*m_nSampleStride;}
+    /// returns a pointer to the color values (one per channel) of the given sample (or slot, in deduplicated layout) at the given pixel index (8-bit models only)
+    inline const uchar* color(size_t nSampleIdx, size_t nPxIdx) const {return m_oColorData.data+nPxIdx*m_nPxStride+nSampleIdx*m_nSampleStride;}
+    /// returns a pointer to the color values (one per channel) of the given sample at the given pixel index (16-bit models only)
+    inline ushort* color16(size_t nSampleIdx, size_t nPxIdx) {return ((ushort*)m_oColorData.data)+nPxIdx*m_nPxStride+nSampleIdx*m_nSampleStride;}
+    /// returns a pointer to the color values (one per channel) of the given sample at the given pixel index (16-bit models only)
+    inline const ushort* color16(size_t nSampleIdx, size_t nPxIdx) const {return ((const ushort*)m_oColorData.data)+nPxIdx*m_nPxStride+nSampleIdx*m_nSampleStride;}
+    /// returns a pointer to the color values (one per channel) of the given sample (or slot) at the given pixel index, typed after the model color depth (uchar or ushort)
+    template<typename TColor>
+    inline const TColor* colorAs(size_t nSampleIdx, size_t nPxIdx) const {
+        static_assert(std::is_same<TColor,uchar>::value || std::is_same<TColor,ushort>::value,"unsupported sample color type");
+        lvDbgAssert(m_nColorDepth==cv::DataType<TColor>::depth);
+        return ((const TColor*)m_oColorData.data)+nPxIdx*m_nPxStride+nSampleIdx*m_nSampleStride;
+    }
+    /// returns a pointer to the descriptors (one per channel) of the given sample (or slot, in deduplicated layout) at the given pixel index
+    inline ushort* desc(size_t nSampleIdx, size_t nPxIdx) {return ((ushort*)m_oDescData.data)+nPxIdx*m_nPxStride+nSampleIdx*m_nSampleStride;}
+    /// returns a pointer to the descriptors (one per channel) of the given sample (or slot, in deduplicated layout) at the given pixel index
+    inline const ushort* desc(size_t nSampleIdx, size_t nPxIdx) const {return ((const ushort*)m_oDescData.data)+nPxIdx*m_nPxStride+nSampleIdx*m_nSampleStride;}
+    /// returns the number of samples sharing the value of the given slot at the given pixel index (always 1 outside the deduplicated layout, where slots are samples)
+    inline size_t weight(size_t nSlotIdx, size_t nPxIdx) const {return m_oSlotWeights.empty()?size_t(1):(size_t)m_oSlotWeights.data[nPxIdx*m_nSlotWeightStride+nSlotIdx];}
+    /// returns the index of the slot holding the value of the given sample at the given pixel index (identity outside the deduplicated layout)
+    inline size_t slot(size_t nSampleIdx, size_t nPxIdx) const {return m_oSampleSlots.empty()?nSampleIdx:(size_t)m_oSampleSlots.data[nPxIdx*m_nSamples+nSampleIdx];}
+    /// overwrites the color & descriptor values of the given sample at the given pixel index (8-bit models only) while keeping the running sums up to date
+    /// (in deduplicated layout, the sample is merged with an identical slot if possible, or takes a free slot, or is merged with its nearest slot if all slots are in use)
+    template<size_t nChannels>
+    inline void setSample(size_t nSampleIdx, size_t nPxIdx, const uchar* anColor, const ushort* anDesc) {
+        lvDbgAssert(nChannels==m_nChannels && m_nColorDepth==CV_8U);
+        if(!m_oSampleSlots.empty()) {
+            setDeduplicatedSample(nSampleIdx,nPxIdx,anColor,anDesc);
+            return;
+        }
+        uchar* const anSampleColor = color(nSampleIdx,nPxIdx);
+        ushort* const anSampleDesc = desc(nSampleIdx,nPxIdx);
+        int* const anColorSums = ((int*)m_oColorSums.data)+nPxIdx*nChannels;
+        int* const anDescSums = ((int*)m_oDescSums.data)+nPxIdx*nChannels;
+        for(size_t c=0; c<nChannels; ++c) {
+            anColorSums[c] += (int)anColor[c]-(int)anSampleColor[c];
+            anDescSums[c] += (int)anDesc[c]-(int)anSampleDesc[c];
+            anSampleColor[c] = anColor[c];
+            anSampleDesc[c] = anDesc[c];
+            if(!m_oDescPlanes.empty())
+                setDescPlaneBits(nSampleIdx,nPxIdx,c,anDesc[c]);
+        }
+        setTileDirty(nPxIdx);
+    }
+    /// overwrites the color & descriptor values of the given sample at the given pixel index (16-bit single-channel models only) while keeping the running sums up to date
+    inline void setSample16(size_t nSampleIdx, size_t nPxIdx, ushort nColor, ushort nDesc) {
+        lvDbgAssert(m_nChannels==1 && m_nColorDepth==CV_16U && m_oSampleSlots.empty());
+        ushort& nSampleColor = *color16(nSampleIdx,nPxIdx);
+        ushort& nSampleDesc = *desc(nSampleIdx,nPxIdx);
+        ((int*)m_oColorSums.data)[nPxIdx] += (int)nColor-(int)nSampleColor;
+        ((int*)m_oDescSums.data)[nPxIdx] += (int)nDesc-(int)nSampleDesc;
+        nSampleColor = nColor;
+        nSampleDesc = nDesc;
+        if(!m_oDescPlanes.empty())
+            setDescPlaneBits(nSampleIdx,nPxIdx,0,nDesc);
+        setTileDirty(nPxIdx);
+    }
+    /// overwrites the color & descriptor values of the given sample at the given pixel index (16-bit single-channel models only; overload of setSample for generic pixel type code)
+    template<size_t nChannels>
+    inline void setSample(size_t nSampleIdx, size_t nPxIdx, const ushort* anColor, const ushort* anDesc) {
+        static_assert(nChannels==1,"16-bit models only support single-channel samples");
+        setSample16(nSampleIdx,nPxIdx,*anColor,*anDesc);
+    }
+    /// overwrites all samples (and running sums) of the given destination pixel with those of the given source pixel
+    void copyPixel(size_t nDstPxIdx, size_t nSrcPxIdx);
+    /// recomputes the running sums (and bit-sliced descriptors, if used) from all samples and flags all mean image tiles as out of date (required after writing to 'color'/'desc' pointers directly)
+    void resetMeanSums();
+    /// brings the given mean color & descriptor images up to date using the running sums, only touching tiles modified since the last call for the same buffer index (images are reallocated if needed)
+    void updateMeanImages(cv::Mat& oMeanColorImg, cv::Mat& oMeanDescImg, size_t nBufferIdx=0) const;
+    /// returns the color image of a single sample (a view in planar layout, a copy in interleaved layout)
+    cv::Mat getColorSample(size_t nSampleIdx) const;
+    /// returns the descriptor image of a single sample (a view in planar layout, a copy in interleaved layout)
+    cv::Mat getDescSample(size_t nSampleIdx) const;
+    /// computes the per-pixel average of all color samples (CV_8UC(nChannels) output)
+    void getMeanColorImage(cv::OutputArray oMeanImg) const;
+    /// computes the per-pixel average of all descriptor samples (CV_16UC(nChannels) output)
+    void getMeanDescImage(cv::OutputArray oMeanImg) const;
+    /// returns a bitmask (8-bit models only) of the samples (or non-empty slots) in [nSampleIdx,nSampleIdx+nSampleCount) whose colors are within nMaxChannelDist of anColor on all channels, and within nMaxTotDist overall
+    uint getColorMatchMask(size_t nPxIdx, size_t nSampleIdx, size_t nSampleCount, const uchar* anColor, size_t nMaxChannelDist, size_t nMaxTotDist) const;
+    /// returns a bitmask (16-bit single-channel models only) of the samples in [nSampleIdx,nSampleIdx+nSampleCount) whose colors are within min(nMaxChannelDist,nMaxTotDist) of anColor
+    uint getColorMatchMask(size_t nPxIdx, size_t nSampleIdx, size_t nSampleCount, const ushort* anColor, size_t nMaxChannelDist, size_t nMaxTotDist) const;
+    /// toggles the bit-sliced descriptor mirror used by getDescMatchMask (kept across layout changes, but never allocated in deduplicated layout)
+    void setBitSlicedDescriptors(bool bEnabled);
+    /// returns whether the bit-sliced descriptor mirror is currently allocated (i.e. whether getDescMatchMask can be used)
+    inline bool isUsingBitSlicedDescriptors() const {return !m_oDescPlanes.empty();}
+    /// returns a bitmask of the samples in [nSampleIdx,nSampleIdx+nSampleCount) whose descriptors are within a total hamming distance of nMaxTotDist of anDesc over the first nDescChannels channels (nSampleIdx must be a multiple of DESC_PLANE_BLOCK_SIZE)
+    uint64_t getDescMatchMask(size_t nPxIdx, size_t nSampleIdx, size_t nSampleCount, const ushort* anDesc, size_t nDescChannels, size_t nMaxTotDist) const;
+    /// shifts all samples by the given integer translation (pixels uncovered at frame borders replicate the nearest shifted ones)
+    void translate(const cv::Point& oShift);
+    /// changes the number of samples per pixel in-place; when shrinking, the most redundant samples of each pixel are dropped first, and when growing, new slots are filled with copies of existing samples (an optional CV_16UC1 per-pixel sample index map is remapped accordingly)
+    void resizeSamples(size_t nSamples, cv::Mat* pSampleIdxMap=nullptr);
+    /// converts the model in-place to the given layout (nSlots>0 selects the deduplicated layout, with bInterleaved ignored); the sample values are kept, unless more distinct values than slots exist for a pixel
+    void setLayout(bool bInterleaved, size_t nSlots);
+    /// writes the model layout & samples to a binary stream
+    void write(std::ostream& oStream) const;
+    /// reads a model written via 'write' from a binary stream (the layout is restored as well)
+    void read(std::istream& oStream);
+    /// copies the whole model into the given one, sharing the sample buffers copy-on-write when they were allocated via cv::LargePageMatAllocator (deep copies otherwise)
+    void cloneCOW(LBSPSampleModel& oClone);
+    /// returns whether the model was allocated or not
+    inline bool empty() const {return m_oColorData.empty();}
+    /// returns the number of samples per pixel
+    inline size_t samples() const {return m_nSamples;}
+    /// returns the number of value slots per pixel (equal to the sample count outside the deduplicated layout)
+    inline size_t slots() const {return m_nSlots;}
+    /// returns whether the deduplicated layout is used or not
+    inline bool isDeduplicated() const {return !m_oSampleSlots.empty();}
+    /// returns the number of channels per sample
+    inline size_t channels() const {return m_nChannels;}
+    /// returns whether the interleaved (per-pixel) layout is used or not
+    inline bool isInterleaved() const {return m_bInterleaved;}
+    /// returns the depth of color samples (CV_8U or CV_16U)
+    inline int colorDepth() const {return m_nColorDepth;}
+    /// returns the stride (in elements) between the blocks of two consecutive pixels
+    inline size_t getPxStride() const {return m_nPxStride;}
+    /// returns the stride (in elements) between two consecutive samples of a pixel
+    inline size_t getSampleStride() const {return m_nSampleStride;}
+protected:
+    /// flags the mean image tile containing the given pixel index as out of date for all buffers (relaxed atomic store, as rows of concurrent bands may share a tile)
+    inline void setTileDirty(size_t nPxIdx) {
+        const size_t nRowIdx = nPxIdx/m_oImgSize.width, nColIdx = nPxIdx-nRowIdx*m_oImgSize.width;
+        m_vnDirtyTiles[(nRowIdx/MEAN_TILE_SIZE)*m_nDirtyTileCols+nColIdx/MEAN_TILE_SIZE].store(uchar((1<<MEAN_BUFFER_COUNT)-1),std::memory_order_relaxed);
+    }
+    /// (re)allocates the dirty tile flags for the current frame size, and flags all tiles as out of date for all buffers
+    void resetDirtyTiles();
+    /// deduplicated layout version of 'setSample' (not inlined, as model updates are much less frequent than matches)
+    void setDeduplicatedSample(size_t nSampleIdx, size_t nPxIdx, const uchar* anColor, const ushort* anDesc);
+    /// returns a pointer to the bit-sliced descriptor planes (LBSP::DESC_SIZE_BITS words per channel) of the given sample block at the given pixel index
+    inline uint64_t* descPlanes(size_t nBlockIdx, size_t nPxIdx) {return ((uint64_t*)m_oDescPlanes.data)+(nPxIdx*m_nDescPlaneBlocks+nBlockIdx)*m_nChannels*LBSP::DESC_SIZE_BITS;}
+    /// returns a pointer to the bit-sliced descriptor planes (LBSP::DESC_SIZE_BITS words per channel) of the given sample block at the given pixel index
+    inline const uint64_t* descPlanes(size_t nBlockIdx, size_t nPxIdx) const {return ((const uint64_t*)m_oDescPlanes.data)+(nPxIdx*m_nDescPlaneBlocks+nBlockIdx)*m_nChannels*LBSP::DESC_SIZE_BITS;}
+    /// overwrites the bits of the given sample in the bit-sliced descriptor planes of the given pixel index & channel
+    inline void setDescPlaneBits(size_t nSampleIdx, size_t nPxIdx, size_t nChannelIdx, ushort nDesc) {
+        uint64_t* const anPlanes = descPlanes(nSampleIdx/DESC_PLANE_BLOCK_SIZE,nPxIdx)+nChannelIdx*LBSP::DESC_SIZE_BITS;
+        const uint64_t nSampleBit = uint64_t(1)<<(nSampleIdx%DESC_PLANE_BLOCK_SIZE);
+        for(size_t k=0; k<LBSP::DESC_SIZE_BITS; ++k)
+            anPlanes[k] ^= (anPlanes[k]^(uint64_t(0)-((nDesc>>k)&1)))&nSampleBit;
+    }
+    /// (re)allocates the bit-sliced descriptor planes if needed for the current layout, and fills them from the descriptor samples
+    void resetDescPlanes();
+    /// raw color/descriptor sample buffers (single-row, continuous)
+    cv::Mat m_oColorData,m_oDescData;
+    /// per-pixel running sums of all color/descriptor samples (CV_32SC(nChannels), used to update mean images incrementally)
+    cv::Mat m_oColorSums,m_oDescSums;
+    /// per-pixel slot weights (padded to m_nSlotWeightStride) & per-sample slot indices, only allocated in deduplicated layout (single-row, continuous, CV_8UC1)
+    cv::Mat m_oSlotWeights,m_oSampleSlots;
+    /// bit-sliced descriptor sample mirror (single-row, continuous, one 64-bit word per element), only allocated if enabled & outside deduplicated layout
+    cv::Mat m_oDescPlanes;
+    /// number of 64-sample blocks per pixel in the bit-sliced descriptor planes
+    size_t m_nDescPlaneBlocks;
+    /// specifies whether the bit-sliced descriptor mirror should be kept or not (persists across 'create' calls)
+    bool m_bUsingDescPlanes;
+    /// per-tile flags for mean image regions modified since the last 'updateMeanImages' call (bit n set = out of date for buffer n)
+    mutable std::vector<std::atomic<uchar>> m_vnDirtyTiles;
+    /// number of tiles per row in the dirty tile flags
+    size_t m_nDirtyTileCols;
+    /// frame size used to create the model
+    cv::Size m_oImgSize;
+    /// channel & sample counts used to create the model
+    size_t m_nChannels,m_nSamples;
+    /// value slot count per pixel & stride between the slot weights of two consecutive pixels
+    size_t m_nSlots,m_nSlotWeightStride;
+    /// element strides between pixels & samples (identical for color & descriptor buffers)
+    size_t m_nPxStride,m_nSampleStride;
+    /// specifies whether the interleaved layout is used or not
+    bool m_bInterleaved;
+    /// depth of color samples (CV_8U or CV_16U)
+    int m_nColorDepth;
+};
+
+/*!
+    Double-buffered mean color & descriptor images of an LBSPSampleModel (i.e. the background images of its owner).
+
+    The model owner refreshes the back buffer (which only touches the tiles modified since that buffer was last refreshed)
+    and swaps it in via 'publish' while it holds its own model lock; readers then copy the front buffer under a short
+    internal lock, and never have to wait for a model update to complete.
+ */
+struct LBSPMeanImageBuffer {
+    /// default constructor (nothing is published until the first 'publish' call)
+    LBSPMeanImageBuffer();
+    /// refreshes the back buffer from the given model and swaps it in as the front one (must not run concurrently with updates of the model or with another 'publish' call)
+    void publish(const LBSPSampleModel& oModel);
+    /// publishes the given model's mean images if its owner's lock can be taken right away (or if nothing was published yet), so that model changes made outside of update passes also show up
+    void publishIfIdle(const LBSPSampleModel& oModel, std::mutex& oModelMutex);
+    /// returns whether a pair of images was published yet
+    bool isPublished() const;
+    /// copies the last published mean color image into the given output
+    void getColorImage(cv::OutputArray oMeanColorImg) const;
+    /// copies the last published mean descriptor image into the given output
+    void getDescImage(cv::OutputArray oMeanDescImg) const;
+protected:
+    /// mean color & descriptor image buffers (the front one is m_nFrontIdx if m_bPublished is set)
+    std::array<cv::Mat,LBSPSampleModel::MEAN_BUFFER_COUNT> m_aoMeanColorImgs,m_aoMeanDescImgs;
+    /// index of the last published buffer
+    size_t m_nFrontIdx;
+    /// specifies whether a buffer was published yet
+    bool m_bPublished;
+    /// guards the front buffer index & copies of the front buffer
+    mutable std::mutex m_oFrontMutex;
+};
 
 /*!
     Local Binary Similarity Pattern (LBSP) algorithm interface for FG/BG video segmentation via change detection.
@@ -40,6 +280,14 @@ struct IBackgroundSubtractorLBSP_ : public IBackgroundSubtractor_<eImpl> {
 
     /// returns a copy of the latest reconstructed background descriptors image
     virtual void getBackgroundDescriptorsImage(cv::OutputArray oBGDescImg) const = 0;
+    /// toggles the reuse of last frame's intra-LBSP descriptors for 5x5 patches whose pixels all changed by at most nNoiseFloor (0 = exact reuse only)
+    void setDescriptorCache(bool bEnabled, size_t nNoiseFloor=0);
+    /// toggles the vectorized block-wise color prefiltering of BG samples during matching (always used with the interleaved sample layout)
+    void setBlockSampleMatching(bool bEnabled);
+    /// segmentation-only pass: classifies the given frame against the current model without updating it (samples, states & RNGs are left untouched)
+    virtual void classify(cv::InputArray oImage, cv::OutputArray oFGMask);
+    /// model update pass: adapts the model to the given frame (which may lag behind 'classify' calls) without producing a segmentation mask (negative rate = default; not supported by feedback-driven algorithms)
+    virtual void update(cv::InputArray oImage, double dLearningRate=-1);
 
 protected:
     /// default impl constructor (defined here as MSVC is very prude with template-class-template-cstor-definitions)
@@ -50,7 +298,11 @@ protected:
                                std::enable_if_t<eImplTemp==lv::NonParallel>* /*pUnused*/=0) :
             m_nLBSPThresholdOffset(nLBSPThresholdOffset),
             m_fRelLBSPThreshold(fRelLBSPThreshold),
-            m_nDefaultMedianBlurKernelSize(nDefaultMedianBlurKernelSize) {
+            m_nDefaultMedianBlurKernelSize(nDefaultMedianBlurKernelSize),
+            m_bUsingDescCache(false),
+            m_nDescCacheNoiseFloor(0),
+            m_bDescCacheReady(false),
+            m_bUsingBlockMatching(false) {
         lvAssert_(m_fRelLBSPThreshold>=0,"relative threshold for LBSP features must be non-negative");
         IIBackgroundSubtractor::m_nROIBorderSize = LBSP::PATCH_SIZE/2;
     }
@@ -67,7 +319,11 @@ protected:
             IBackgroundSubtractor_GLSL(nLevels,nComputeStages,nExtraSSBOs,nExtraACBOs,nExtraImages,nExtraTextures,nDebugType,bUseDisplay,bUseTimers,bUseIntegralFormat),
             m_nLBSPThresholdOffset(nLBSPThresholdOffset),
             m_fRelLBSPThreshold(fRelLBSPThreshold),
-            m_nDefaultMedianBlurKernelSize(nDefaultMedianBlurKernelSize) {
+            m_nDefaultMedianBlurKernelSize(nDefaultMedianBlurKernelSize),
+            m_bUsingDescCache(false),
+            m_nDescCacheNoiseFloor(0),
+            m_bDescCacheReady(false),
+            m_bUsingBlockMatching(false) {
         lvAssert_(m_fRelLBSPThreshold>=0,"relative threshold for LBSP features must be non-negative");
         IIBackgroundSubtractor::m_nROIBorderSize = LBSP::PATCH_SIZE/2;
     }
@@ -77,11 +333,11 @@ protected:
 #endif //HAVE_GLSL
 #if HAVE_CUDA
     // ... @@@ add impl later
-    static_assert(eImpl!=lv::CUDA),"Missing impl");
+    static_assert(eImpl!=lv::CUDA,"Missing impl");
 #endif //HAVE_CUDA
 #if HAVE_OPENCL
     // ... @@@ add impl later
-    static_assert(eImpl!=lv::OpenCL),"Missing impl");
+    static_assert(eImpl!=lv::OpenCL,"Missing impl");
 #endif //HAVE_OPENCL
 
     /// required for derived class destruction from this interface
@@ -94,10 +350,56 @@ protected:
     const float m_fRelLBSPThreshold;
     /// pre-allocated internal LBSP threshold values LUT for all possible 8-bit intensities
     std::array<uchar,UCHAR_MAX+1> m_anLBSPThreshold_8bitLUT;
+    /// pre-allocated internal LBSP threshold values LUT for all possible 16-bit intensities (only filled for 16-bit inputs)
+    std::vector<ushort> m_vnLBSPThreshold_16bitLUT;
+    /// returns the LBSP threshold of the given 8-bit reference intensity
+    inline uchar getLBSPThreshold(uchar nColor) const {return m_anLBSPThreshold_8bitLUT[nColor];}
+    /// returns the LBSP threshold of the given 16-bit reference intensity (16-bit inputs only)
+    inline ushort getLBSPThreshold(ushort nColor) const {lvDbgAssert(!m_vnLBSPThreshold_16bitLUT.empty()); return m_vnLBSPThreshold_16bitLUT[nColor];}
+    /// returns the scale factor applied to 8-bit color distance thresholds for inputs of the given pixel type
+    template<typename TColor>
+    static constexpr size_t getColorDistScale() {return std::is_same<TColor,ushort>::value?BGSLBSP_16BIT_INTENSITY_SCALE:1;}
     /// default kernel size for median blur post-proc filtering
     const int m_nDefaultMedianBlurKernelSize;
     /// copy of latest descriptors (used when refreshing model)
     cv::Mat m_oLastDescFrame;
+    /// returns the number of input channels compared in color/desc distances (the 4th channel of 4-byte aligned inputs is only padding)
+    static constexpr size_t getMatchChannelCount(size_t nChannels) {return nChannels==4?3:nChannels;}
+    /// fills the LBSP lookup values of all compared channels of an nChannels input at the given position (padding channel is skipped)
+    template<size_t nChannels, size_t nMatchChannels, typename TVal>
+    static inline void computeMatchLookupVals(const cv::Mat& oInputImg, const int nX, const int nY, std::array<std::array<TVal,LBSP::DESC_SIZE_BITS>,nMatchChannels>& aanVals) {
+        static_assert(nMatchChannels==getMatchChannelCount(nChannels),"bad lookup array size for input channel count");
+        lv::unroll<nMatchChannels>([&](size_t c) {
+            LBSP::computeDescriptor_lookup<nChannels>(oInputImg,nX,nY,c,aanVals[c]);
+        });
+    }
+    /// updates the descriptor cache validity mask using the new input frame (should be called before any m_oLastDescFrame update)
+    void updateDescriptorCache(const cv::Mat& oInputImg);
+    /// invalidates all cached descriptors for the next frame (should be called whenever an LBSP threshold LUT changes)
+    void invalidateDescriptorCache();
+    /// writes the LBSP-related model state (threshold LUT & last descriptors) to a snapshot stream (for impl-specific writeModelState use)
+    void writeLBSPModelState(std::ostream& oStream) const;
+    /// reads the LBSP-related model state (threshold LUT & last descriptors) from a snapshot stream (for impl-specific readModelState use)
+    void readLBSPModelState(std::istream& oStream);
+    /// specifies whether intra-LBSP descriptors of unchanged patches should be reused from m_oLastDescFrame
+    bool m_bUsingDescCache;
+    /// max per-pixel absolute color difference still considered as 'unchanged' by the descriptor cache
+    size_t m_nDescCacheNoiseFloor;
+    /// specifies whether m_oLastDescFrame holds descriptors computed with the current LUT from m_oDescCacheLastInput
+    bool m_bDescCacheReady;
+    /// per-pixel descriptor cache validity mask (non-zero = the whole 5x5 patch is unchanged since last frame)
+    cv::Mat m_oDescCacheValidMask;
+    /// reference frame used by the descriptor cache; pixels are only refreshed when they change by more than the noise floor (which also invalidates all descriptors covering them)
+    cv::Mat m_oDescCacheLastInput;
+    /// temporary abs-diff buffer & changed pixel mask used by the descriptor cache
+    cv::Mat m_oDescCacheDiffBuffer, m_oDescCacheChangedMask;
+    /// specifies whether BG samples should be color-prefiltered in vectorized blocks during matching
+    bool m_bUsingBlockMatching;
+    /// random sample position LUT used for model (re)initialization (clamped to the LBSP patch border)
+    cv::RandSampleLUT_7x7_std2 m_oRandSampleLUT;
+    /// random neighbor position LUTs used for model updates (clamped to the LBSP patch border)
+    cv::RandNeighborLUT_3x3 m_oRandNeighborLUT_3x3;
+    cv::RandNeighborLUT_5x5 m_oRandNeighborLUT_5x5;
 };
 
 #if HAVE_GLSL
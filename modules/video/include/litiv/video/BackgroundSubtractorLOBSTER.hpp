@@ -18,6 +18,9 @@
 #pragma once
 
 #include "litiv/video/BackgroundSubtractorLBSP.hpp"
+#if HAVE_GLSL
+#include "litiv/utils/opengl-compute.hpp"
+#endif //HAVE_GLSL
 
 /// defines the default value for IBackgroundSubtractorLOBSTER_::m_nDescDistThreshold
 #define BGSLOBSTER_DEFAULT_DESC_DIST_THRESHOLD (4)
@@ -35,6 +38,7 @@
 #define BGSLOBSTER_GLSL_USE_BASIC_IMPL 0
 #define BGSLOBSTER_GLSL_USE_SHAREDMEM  1
 #define BGSLOBSTER_GLSL_USE_POSTPROC   1
+#define BGSLOBSTER_GLSL_USE_ROI_TILES  1
 
 /*!
     LOcal Binary Similarity segmenTER (LOBSTER) algorithm for FG/BG video segmentation via change detection.
@@ -61,8 +65,8 @@ protected:
     const size_t m_nColorDistThreshold;
     /// absolute descriptor distance threshold
     const size_t m_nDescDistThreshold;
-    /// number of different samples per pixel/block to be taken from input frames to build the background model
-    const size_t m_nBGSamples;
+    /// number of different samples per pixel/block to be taken from input frames to build the background model (can be changed via 'setModelCapacity' in the CPU impl)
+    size_t m_nBGSamples;
     /// number of similar samples needed to consider the current pixel/block as 'background'
     const size_t m_nRequiredBGSamples;
 };
@@ -102,6 +106,14 @@ protected:
     std::string getComputeShaderSource_PostProc() const;
     /// custom dispatch call function to adjust in-stage uniforms, batch workgroup size & other parameters
     virtual void dispatch(size_t nStage, GLShader& oShader) override;
+    /// returns the number of shader variants available for autotuning (default shared mem preloading setting, and its opposite)
+    virtual size_t getShaderVariantCount() const override {return 2;}
+    /// returns whether the current shader variant preloads image data in shared mem or not
+    bool getIsUsingSharedMem() const {return (m_nShaderVariant==0)==bool(BGSLOBSTER_GLSL_USE_SHAREDMEM);}
+    /// rebuilds the compacted list of work group tiles overlapping the ROI for the current work group size, and its indirect dispatch args
+    void updateActiveTiles();
+    /// remaps the invocation coords of a compute shader source onto the active tile list (used when only active tiles are dispatched)
+    std::string getActiveTileMappedSource(const std::string& sSrc) const;
 
     size_t m_nTMT32ModelSize;
     size_t m_nSampleStepSize;
@@ -112,9 +124,18 @@ protected:
     size_t m_nBGModelSize;
     std::aligned_vector<uint,32> m_vnBGModelData;
     std::aligned_vector<lv::gl::TMT32GenParams,32> m_voTMT32ModelData;
+    /// defines whether only the work group tiles overlapping the ROI are dispatched (set at init if the ROI does not cover the full frame)
+    bool m_bUsingActiveTiles;
+    /// work group size for which the active tile list was last built
+    glm::uvec2 m_vActiveTileSize;
+    /// active tile count, compacted active tile list (linear tile indices, in raster order), and indirect dispatch args
+    size_t m_nActiveTileCount;
+    std::unique_ptr<GLShaderStorageBuffer> m_pActiveTileList;
+    std::unique_ptr<GLShaderStorageBuffer> m_pActiveTileDispatchArgs;
     enum LOBSTERStorageBufferBindingList {
         LOBSTERStorageBuffer_BGModelBinding = GLImageProcAlgo::nStorageBufferDefaultBindingsCount,
         LOBSTERStorageBuffer_TMT32ModelBinding,
+        LOBSTERStorageBuffer_ActiveTileListBinding,
         nLOBSTERStorageBufferBindingsCount
     };
 };
@@ -141,16 +162,55 @@ public:
     virtual void initialize(const cv::Mat& oInitImg, const cv::Mat& oROI) override;
     /// model update/segmentation function (synchronous version); the learning param is reinterpreted as an integer and should be > 0 (smaller values == faster adaptation)
     virtual void apply(cv::InputArray oImage, cv::OutputArray oFGMask, double dLearningRate=BGSLOBSTER_DEFAULT_LEARNING_RATE) override;
+    /// segmentation-only pass (raw matching & median blur); the model, RNG & last frame copies are left untouched
+    virtual void classify(cv::InputArray oImage, cv::OutputArray oFGMask) override;
+    /// update-only pass: each pixel first draws its two stochastic updates, and only pixels picked for one are matched (as BG samples must match to be replaced); no mask is produced or post-processed
+    virtual void update(cv::InputArray oImage, double dLearningRate=-1) override;
     /// returns a copy of the latest reconstructed background image
     virtual void getBackgroundImage(cv::OutputArray oBGImg) const override;
     /// returns a copy of the latest reconstructed background descriptors image
     virtual void getBackgroundDescriptorsImage(cv::OutputArray oBGDescImg) const override;
+    /// toggles the interleaved (per-pixel) background sample layout, which is faster for large frames (the model is converted if already initialized)
+    void setInterleavedSampleModel(bool bInterleaved);
+    /// toggles the deduplicated (8-bit only) background sample layout, which stores up to nMaxDistinctSamples distinct values per pixel with their multiplicities (the model is converted if already initialized)
+    void setDeduplicatedSampleModel(bool bEnabled, size_t nMaxDistinctSamples=BGSLBSP_DEFAULT_DEDUP_SAMPLE_SLOTS);
+    /// changes the number of samples per pixel in the background model (the learned model is kept; the most redundant samples of each pixel are dropped first when shrinking)
+    void setModelCapacity(size_t nBGSamples);
+    /// returns the number of samples per pixel in the background model
+    size_t getModelCapacity() const {return m_nBGSamples;}
 
 protected:
-    /// background model pixel intensity samples
-    std::vector<cv::Mat> m_voBGColorSamples;
-    /// background model descriptors samples
-    std::vector<cv::Mat> m_voBGDescSamples;
+    /// matches all ROI pixels of the (scaled) input frame against the model to fill the raw FG mask, and updates BG pixel samples if required (most pixels of tiles left unchanged by the change gate reuse their last raw labels if bUseChangeGate is set)
+    /// (in update-only mode, pixels only get matched if one of their update draws succeeds, and the FG mask must be considered garbage)
+    void segment(const cv::Mat& oInputImg, cv::Mat& oCurrFGMask, size_t nLearningRate, bool bUpdateModel, bool bUseChangeGate=false, bool bUpdateOnly=false);
+    /// matching & update loop of 'segment', specialized on the input pixel type & channel count (matching stats are accumulated in the last two args)
+    template<typename TColor, size_t nChannels>
+    void segmentPixels(const cv::Mat& oInputImg, cv::Mat& oCurrFGMask, size_t nLearningRate, bool bUpdateModel, bool bUseChangeGate, bool bUpdateOnly, size_t& nSamplesTested, size_t& nEarlyExits);
+    /// recomputes the last frame descriptors & copies up to nModelSamplesToRefresh samples (starting at nRefreshSampleStartPos) into the model, specialized on the input pixel type & channel count
+    template<typename TColor, size_t nChannels>
+    void refreshModelSamples(size_t nModelSamplesToRefresh, size_t nRefreshSampleStartPos, bool bForceFGUpdate);
+    /// returns a new (uninitialized) instance with the same parameters & settings
+    virtual std::shared_ptr<IIBackgroundSubtractor> createInstance() const override;
+    /// writes the impl-specific model state (samples & last descriptors) to a snapshot stream
+    virtual void writeModelState(std::ostream& oStream) const override;
+    /// reads the impl-specific model state (samples & last descriptors) from a snapshot stream
+    virtual void readModelState(std::istream& oStream) override;
+    /// applies a new ROI to the running model, initializing samples of added pixels from their nearest previous ROI pixels
+    virtual bool updateModelROI(const cv::Mat& oNewROI, size_t nOrigROIPxCount) override;
+    /// specifies whether the background model uses the interleaved (per-pixel) sample layout or not
+    bool m_bUsingInterleavedSamples = false;
+    /// number of distinct value slots per pixel in the deduplicated sample layout (0 = disabled)
+    size_t m_nDedupSampleSlots = 0;
+    /// background model pixel intensity & descriptor samples
+    LBSPSampleModel m_oBGSamples;
+    /// mean background color & descriptor images, refreshed (only where samples changed) & published at the end of each model update, and read by 'getBackground...Image' calls
+    mutable LBSPMeanImageBuffer m_oBGMeanImgs;
+    /// raw FG mask of the last 'apply' call (only kept in change gating mode, where gated pixels reuse its labels)
+    cv::Mat m_oLastRawFGMask;
+    /// scratch raw FG mask written by 'update' passes (never returned)
+    cv::Mat m_oUpdateFGMask;
+    /// guards the background model against concurrent updates (and 'getBackground...Image' calls refreshing the mean images while no update runs)
+    mutable std::mutex m_oModelMutex;
 };
 
 using BackgroundSubtractorLOBSTER = BackgroundSubtractorLOBSTER_<lv::NonParallel>;
@@ -63,6 +63,18 @@ public:
     virtual void getBackgroundDescriptorsImage(cv::OutputArray backgroundDescImage) const override;
     /// returns the default learning rate value used in 'apply'
     virtual double getDefaultLearningRate() const override {return 0;}
+    /// reseeds the internal random number generators used for model updates (including per-band ones)
+    virtual void setRandomSeed(uint64_t nSeed) override;
+    /// sets the number of threads used to process row bands in 'apply' (1 = sequential, as by default; 0 = one per hardware thread)
+    void setThreadCount(size_t nThreads);
+    /// returns the number of threads used to process row bands in 'apply'
+    size_t getThreadCount() const;
+    /// changes the max number of local (per-pixel) & global words (the learned model is kept; the lowest-weight words are dropped first when shrinking)
+    void setModelCapacity(size_t nMaxLocalWords, size_t nMaxGlobalWords);
+    /// returns the max number of local (per-pixel) words
+    size_t getMaxLocalWordCount() const {return m_nMaxLocalWords;}
+    /// returns the max number of global words
+    size_t getMaxGlobalWordCount() const {return m_nMaxGlobalWords;}
 
 protected:
     template<size_t nChannels>
@@ -70,31 +82,42 @@ protected:
         std::array<uchar,nChannels> anColor;
         std::array<ushort,nChannels> anDesc;
     };
-    struct LocalWordBase {
+    /// local word occurrence stats (stored apart from local word features, see m_voLocalWordStats)
+    struct LocalWordStats {
         size_t nFirstOcc;
         size_t nLastOcc;
         size_t nOccurrences;
     };
-    template<typename T>
-    struct LocalWord : LocalWordBase {
-        T oFeature;
-    };
     struct GlobalWordBase {
         float fLatestWeight;
         cv::Mat oSpatioOccMap;
+        /// per-cell decay counts the spatio-occurrence map was last caught up with (see m_oGlobalWordDecayCounts)
+        cv::Mat oSpatioOccStamps;
         uchar nDescBITS;
     };
     template<typename T>
     struct GlobalWord : GlobalWordBase {
         T oFeature;
     };
-    typedef LocalWord<ColorLBSPFeature<1>> LocalWord_1ch;
-    typedef LocalWord<ColorLBSPFeature<3>> LocalWord_3ch;
     typedef GlobalWord<ColorLBSPFeature<1>> GlobalWord_1ch;
     typedef GlobalWord<ColorLBSPFeature<3>> GlobalWord_3ch;
+    /// global dictionary updates buffered by a single row band (merged once all bands are processed, the whole frame being one band in sequential mode)
+    struct GlobalDictBandDelta {
+        /// global word weight increments, indexed like the global word list
+        std::vector<float> vfWeightIncrs;
+        /// whether the band requested the replacement of the weakest global word (only its latest request is kept)
+        bool bReplaceWeakestWord;
+        /// replacement global word feature (only the first channel is used for grayscale input)
+        ColorLBSPFeature<3> oReplacementFeature;
+        /// replacement global word descriptor bit count
+        uchar nReplacementDescBITS;
+        /// spatio-occurrence map lookup index & weight of the pixel which requested the replacement
+        size_t nReplacementLookupIdx;
+        float fReplacementWeight;
+    };
     struct PxInfo_PAWCS : PxInfoBase {
         size_t nGlobalWordMapLookupIdx;
-        std::vector<GlobalWordBase*> vpGlobalDictSortLUT;
+        GlobalWordBase** apGlobalDictSortLUT;
     };
     /// absolute minimal color distance threshold ('R' or 'radius' in the original ViBe paper, used as the default/initial 'R(x)' value here)
     const size_t m_nMinColorDistThreshold;
@@ -119,18 +142,43 @@ protected:
     /// current local word weight offset
     size_t m_nLocalWordWeightOffset;
 
-    /// word lists & dictionaries
-    std::vector<LocalWordBase*> m_vpLocalWordDict;
-    std::vector<LocalWord_1ch> m_voLocalWordList_1ch;
-    std::vector<LocalWord_3ch> m_voLocalWordList_3ch;
-    std::vector<LocalWord_1ch>::iterator m_pLocalWordListIter_1ch;
-    std::vector<LocalWord_3ch>::iterator m_pLocalWordListIter_3ch;
+    /// local word storage type (the per-pixel word arrays are the bulk of the model, so they use huge pages bound to the model NUMA node)
+    template<typename T> using LocalWordList = std::vector<T,lv::LargePageMemAllocator<T>>;
+    /// local word arena: each pixel owns a block of 'm_nCurrLocalWords' contiguous slots (starting at nModelIdx*m_nCurrLocalWords), split in feature & stats arrays
+    LocalWordList<ColorLBSPFeature<1>> m_voLocalWordFeatures_1ch;
+    LocalWordList<ColorLBSPFeature<3>> m_voLocalWordFeatures_3ch;
+    LocalWordList<LocalWordStats> m_voLocalWordStats;
+    /// local dictionaries: per-pixel word slots (relative to the pixel's block) sorted by weight, with LWORD_UNINIT_SLOT marking unassigned entries
+    std::vector<ushort> m_vnLocalWordDict;
+    /// global word lists & dictionaries
     std::vector<GlobalWordBase*> m_vpGlobalWordDict;
     std::vector<GlobalWord_1ch> m_voGlobalWordList_1ch;
     std::vector<GlobalWord_3ch> m_voGlobalWordList_3ch;
     std::vector<GlobalWord_1ch>::iterator m_pGlobalWordListIter_1ch;
     std::vector<GlobalWord_3ch>::iterator m_pGlobalWordListIter_3ch;
     std::vector<PxInfo_PAWCS> m_voPxInfoLUT_PAWCS;
+    /// contiguous arena holding all global word sort LUTs (one 'm_nCurrGlobalWords'-sized slice per lookup map cell, shared by all pixels of the cell)
+    std::vector<GlobalWordBase*> m_vpGlobalDictSortLUTArena;
+    /// number of lookup map cells covered by the global word sort LUTs & indexes
+    size_t m_nGlobalWordLookupCells;
+    /// number of color & descriptor bit count buckets in each per-cell global word index
+    size_t m_nGlobalWordIndexColorBuckets, m_nGlobalWordIndexDescBITSBuckets;
+    /// per-cell global word indexes: sort LUT ranks grouped by bucket (in LUT order) and bucket start offsets (with an extra end element per cell)
+    std::vector<ushort> m_vnGlobalWordIndexRanks, m_vnGlobalWordIndexOffsets;
+    /// per-cell global word index stamps (an index is stale when its stamp differs from the current one)
+    std::vector<size_t> m_vnGlobalWordIndexCellStamps;
+    /// current global word index stamp (incremented whenever global word features change)
+    size_t m_nGlobalWordIndexStamp;
+    /// contiguous 3D buffer holding all global word spatio-occurrence maps (each word's map is a 2D header over one plane)
+    cv::Mat m_oGlobalWordSpatioOccMaps;
+    /// contiguous 3D buffer holding all global word spatio-occurrence map stamps (laid out like the maps)
+    cv::Mat m_oGlobalWordSpatioOccStamps;
+    /// per-cell count of global decay rounds spent in the background (local weights of global words decay lazily, by the count increase since their stamp)
+    cv::Mat m_oGlobalWordDecayCounts;
+    /// number of global decay rounds since the global word spatio-occurrence maps were last blurred
+    size_t m_nPendingGlobalWordBlurs;
+    /// per-cell flags marking the global word sort LUTs whose local weights were incremented since their last sort pass
+    std::vector<uchar> m_vbDirtyGlobalWordLUTCells;
 
     /// a lookup map used to keep track of regions where illumination recently changed
     cv::Mat m_oIllumUpdtRegionMask;
@@ -157,18 +205,60 @@ protected:
     /// the foreground mask generated by the method at t-1 (without post-proc, used for blinking px detection)
     cv::Mat m_oLastRawFGMask;
 
-    /// pre-allocated CV_8UC1 matrices used to speed up morph ops
-    cv::Mat m_oFGMask_PreFlood;
-    cv::Mat m_oFGMask_FloodedHoles;
+    /// pre-allocated CV_8UC1 matrices used to speed up morph ops (transient ones are borrowed from the per-thread scratch buffers)
     cv::Mat m_oLastFGMask_dilated;
     cv::Mat m_oLastFGMask_dilated_inverted;
-    cv::Mat m_oCurrRawFGBlinkMask;
     cv::Mat m_oLastRawFGBlinkMask;
-    cv::Mat m_oTempGlobalWordWeightDiffFactor;
     cv::Mat m_oMorphExStructElement;
 
+    /// number of threads used to process row bands in 'apply' (1 = sequential)
+    size_t m_nThreadCount;
+    /// worker pool used to process row bands (only allocated when m_nThreadCount!=1)
+    std::unique_ptr<lv::ThreadPool> m_pThreadPool;
+    /// first model iter of each row band (with an extra end element)
+    std::vector<size_t> m_vnBandModelIterLUT;
+    /// per-band random number generators (kept per band so results do not depend on thread scheduling)
+    std::vector<lv::PCG32> m_voBandRNGs;
+    /// per-band buffered global dictionary updates (a single one is used in sequential mode)
+    std::vector<GlobalDictBandDelta> m_voBandGlobalDictDeltas;
+
+    /// rebuilds the row band LUT and per-band RNGs used for multi-threaded processing
+    void updateBandLUT();
+    /// applies the global word weight updates & replacement buffered by all row bands during the last pass (in sequential or multi-threaded mode)
+    void mergeBandGlobalDictDeltas();
+    /// runs one bubble sort pass over each dirty cell's global word LUT based on local weights, and rebuilds the cell's index
+    void sortGlobalWordLUTs();
+    /// returns the local weight of a global word in the given spatio-occurrence map cell, with its pending decay applied on the fly
+    float getGlobalWordLocalWeight(const GlobalWordBase& oGlobalWord, size_t nGlobalWordMapLookupIdx) const;
+    /// applies the pending decay of a global word's local weight in the given spatio-occurrence map cell, and returns a reference to it
+    float& updateGlobalWordLocalWeight(GlobalWordBase& oGlobalWord, size_t nGlobalWordMapLookupIdx);
+    /// applies the pending decay of all local weights in a global word's spatio-occurrence map
+    void updateGlobalWordSpatioOccMap(GlobalWordBase& oGlobalWord);
+    /// applies all pending global word decays, and resets the per-cell decay counts & map stamps (used before maps are rebuilt)
+    void resetGlobalWordDecayCounts();
+    /// rebuilds the global word index of the given lookup map cell from its sort LUT
+    template<size_t nChannels>
+    void updateGlobalWordIndex(size_t nCellIdx);
+    /// rebuilds all stale global word indexes (must be called before concurrent lookups)
+    void updateGlobalWordIndexes();
+    /// returns the first word of the cell's global word LUT matching the given color & descriptor bit count, or nullptr if none does
+    template<size_t nChannels>
+    GlobalWordBase* findGlobalWord(size_t nCellIdx, const uchar* anColor, uchar nDescBITS, size_t nColorDistThreshold, size_t nDescBITSDistThreshold);
+    /// returns a new (uninitialized) instance with the same parameters & settings (global word lists hold internal pointers, so clones get deep copies through the snapshot)
+    virtual std::shared_ptr<IIBackgroundSubtractor> createInstance() const override;
+    /// writes the impl-specific model state (word lists & dictionaries, state maps, masks & RNGs) to a snapshot stream
+    virtual void writeModelState(std::ostream& oStream) const override;
+    /// reads the impl-specific model state (word lists & dictionaries, state maps, masks & RNGs) from a snapshot stream
+    virtual void readModelState(std::istream& oStream) override;
+    /// applies a new ROI to the running model, rebuilding the (compact) local dictionaries so that removed pixels are freed and added ones copy their nearest previous ROI pixels
+    virtual bool updateModelROI(const cv::Mat& oNewROI, size_t nOrigROIPxCount) override;
+    /// returns the arena index of the word held by the given local dictionary entry
+    inline size_t getLocalWordSlotIdx(size_t nLocalDictIdx, size_t nLocalWordIdx) const {
+        lvDbgAssert(m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]<m_nCurrLocalWords);
+        return nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx];
+    }
     /// internal weight lookup function for local words
-    static float GetLocalWordWeight(const LocalWordBase& w, size_t nCurrFrame, size_t nOffset);
+    static float GetLocalWordWeight(const LocalWordStats& w, size_t nCurrFrame, size_t nOffset);
     /// internal weight lookup function for global words
     static float GetGlobalWordWeight(const GlobalWordBase& w);
 };
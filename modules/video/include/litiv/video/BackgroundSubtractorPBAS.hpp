@@ -36,7 +36,11 @@
 //
 // @@@@@@@@
 
+#include "litiv/utils/cxx.hpp"
 #include <opencv2/video/background_segm.hpp>
+#if HAVE_GLSL
+#include "litiv/video/BackgroundSubtractionUtils.hpp"
+#endif //HAVE_GLSL
 
 /// defines the internal threshold adjustment factor to use when determining if the variation of a single channel is enough to declare the pixel as foreground
 #define BGSPBAS_USE_SELF_DIFFUSION 1
@@ -86,6 +90,10 @@
 /// defines whether we should use single channel variation checks for fg/bg segmentation validation or not
 #define BGSPBAS_USE_SC_THRS_VALIDATION 0
 
+#define BGSPBAS_GLSL_USE_TIMERS    0
+#define BGSPBAS_GLSL_USE_SHAREDMEM 1
+#define BGSPBAS_GLSL_USE_POSTPROC  1
+
 /*!
     PBAS foreground-background segmentation algorithm (abstract version).
 
@@ -106,6 +114,8 @@ public:
     virtual void apply(cv::InputArray image, cv::OutputArray fgmask, double learningRateOverride=BGSPBAS_DEFAULT_LEARNING_RATE_OVERRIDE) = 0;
     /// returns a copy of the latest reconstructed background image
     void getBackgroundImage(cv::OutputArray backgroundImage) const;
+    /// reseeds the internal random number generator used for model init/updates (instances use a fixed default seed)
+    void setRandomSeed(uint64_t nSeed);
 
 protected:
     /// number of different samples per pixel/block to be taken from input frames to build the background model ('N' in the original ViBe/PBAS papers)
@@ -138,6 +148,8 @@ protected:
     cv::Mat m_oUpdateRateFrame;
     /// defines whether or not the subtractor is fully initialized
     bool m_bInitialized;
+    /// per-instance random number generator used for model init/updates (avoids the global lock of rand())
+    lv::PCG32 m_oRNG;
 };
 
 /*!
@@ -175,3 +187,72 @@ public:
     /// primary model update function; the learning param is used to override the internal learning speed (ignored when <= 0)
     virtual void apply(cv::InputArray image, cv::OutputArray fgmask, double learningRateOverride=BGSPBAS_DEFAULT_LEARNING_RATE_OVERRIDE);
 };
+
+#if HAVE_GLSL
+/*!
+    PBAS foreground-background segmentation algorithm (GLSL version, for 1ch/3ch images).
+
+    Note: input gradients are computed in a first stage (same 3x3 gaussian blur + scharr filters as the CPU impls), and
+    the mean gradient distance of non-matching samples is accumulated on the gpu and used one frame later, so no readback
+    is ever needed. R2 acceleration & advanced morphological operations are not supported; random draws come from a
+    per-pixel TinyMT32 generator, so results are not identical to the CPU impls.
+ */
+class BackgroundSubtractorPBAS_GLSL : public IBackgroundSubtractor_GLSL {
+public:
+    /// full constructor
+    BackgroundSubtractorPBAS_GLSL(size_t nInitColorDistThreshold=BGSPBAS_DEFAULT_COLOR_DIST_THRESHOLD,
+                                  float fInitUpdateRate=BGSPBAS_DEFAULT_LEARNING_RATE,
+                                  size_t nBGSamples=BGSPBAS_DEFAULT_NB_BG_SAMPLES,
+                                  size_t nRequiredBGSamples=BGSPBAS_DEFAULT_REQUIRED_NB_BG_SAMPLES);
+    /// refreshes all samples (colors & gradients) based on the last analyzed frame
+    void refreshModel(float fSamplesRefreshFrac, bool bForceFGUpdate=false);
+    /// (re)initiaization method; needs to be called before starting background subtraction
+    virtual void initialize_gl(const cv::Mat& oInitImg, const cv::Mat& oROI) override;
+    /// returns the GLSL compute shader source code to run for a given algo stage
+    virtual std::string getComputeShaderSource(size_t nStage) const override;
+    /// returns a copy of the latest reconstructed background image
+    virtual void getBackgroundImage(cv::OutputArray oBGImg) const override;
+    /// returns the default learning rate value used in 'apply' (negative, i.e. the per-pixel update rates are used)
+    virtual double getDefaultLearningRate() const override {return BGSPBAS_DEFAULT_LEARNING_RATE_OVERRIDE;}
+
+protected:
+    /// returns the GLSL compute shader source code to run for the input gradient stage
+    std::string getComputeShaderSource_Gradient() const;
+    /// returns the GLSL compute shader source code to run for the main processing stage
+    std::string getComputeShaderSource_PBAS() const;
+    /// returns the GLSL compute shader source code to run the post-processing stage (median blur)
+    std::string getComputeShaderSource_PostProc() const;
+    /// custom dispatch call function to adjust in-stage uniforms & memory barriers
+    virtual void dispatch(size_t nStage, GLShader& oShader) override;
+    /// absolute color distance threshold (the default 'R(x)' value in the original PBAS paper)
+    const size_t m_nDefaultColorDistThreshold;
+    /// absolute default update rate threshold (the default 'T(x)' value in the original PBAS paper)
+    const float m_fDefaultUpdateRate;
+    /// number of different samples per pixel to be taken from input frames to build the background model ('N' in the original ViBe/PBAS papers)
+    const size_t m_nBGSamples;
+    /// number of similar samples needed to consider the current pixel as 'background' ('#_min' in the original ViBe/PBAS papers)
+    const size_t m_nRequiredBGSamples;
+    /// index of the gradient distance stats slot accumulated by the next frame (slots are rotated over three frames)
+    size_t m_nGradDistStatsSlotIdx;
+    size_t m_nTMT32ModelSize;
+    size_t m_nSampleStepSize;
+    size_t m_nPxModelSize;
+    size_t m_nPxModelPadding;
+    size_t m_nColStepSize;
+    size_t m_nRowStepSize;
+    size_t m_nBGModelSize;
+    size_t m_nPxStateSize;
+    size_t m_nGradFrameSize;
+    std::aligned_vector<uint,32> m_vnBGModelData;
+    std::aligned_vector<float,32> m_vfPxStateData;
+    std::aligned_vector<lv::gl::TMT32GenParams,32> m_voTMT32ModelData;
+    enum PBASStorageBufferBindingList {
+        PBASStorageBuffer_BGModelBinding = GLImageProcAlgo::nStorageBufferDefaultBindingsCount,
+        PBASStorageBuffer_PxStateBinding,
+        PBASStorageBuffer_GradFrameBinding,
+        PBASStorageBuffer_GradDistStatsBinding,
+        PBASStorageBuffer_TMT32ModelBinding,
+        nPBASStorageBufferBindingsCount
+    };
+};
+#endif //HAVE_GLSL
@@ -29,14 +29,35 @@
 #define BGSSUBSENSE_DEFAULT_REQUIRED_NB_BG_SAMPLES (2)
 /// defines the default value for BackgroundSubtractorSuBSENSE::m_nSamplesForMovingAvgs
 #define BGSSUBSENSE_DEFAULT_N_SAMPLES_FOR_MV_AVGS (100)
+/// defines the default value for BackgroundSubtractorSuBSENSE::m_nStabilityMinBGStreak
+#define BGSSUBSENSE_DEFAULT_STABILITY_MIN_BG_STREAK (100)
+/// defines the default value for BackgroundSubtractorSuBSENSE::m_fStabilityMaxMeanLastDist
+#define BGSSUBSENSE_DEFAULT_STABILITY_MAX_MEAN_LAST_DIST (0.02f)
+/// defines the default value for BackgroundSubtractorSuBSENSE::m_nC2FCoarseStride
+#define BGSSUBSENSE_DEFAULT_C2F_COARSE_STRIDE (2)
+/// defines the default value for BackgroundSubtractorSuBSENSE::m_nC2FRefineMargin
+#define BGSSUBSENSE_DEFAULT_C2F_REFINE_MARGIN (1)
+
+#define BGSSUBSENSE_GLSL_USE_DEBUG     0
+#define BGSSUBSENSE_GLSL_USE_TIMERS    0
+#define BGSSUBSENSE_GLSL_USE_SHAREDMEM 1
+/// defines the number of horizontal+vertical sweep pairs used to propagate the border flood fill in the GLSL hole filling stages
+#define BGSSUBSENSE_GLSL_HOLEFILL_SWEEP_ROUNDS 4
 
 /*!
     Self-Balanced Sensitivity segmenTER (SuBSENSE) algorithm for FG/BG video segmentation via change detection.
 
     Note: both grayscale and RGB/BGR images may be used with this extractor (parameters are adjusted automatically).
-    For optimal grayscale results, use CV_8UC1 frames instead of CV_8UC3.
+    For optimal grayscale results, use CV_8UC1 frames instead of CV_8UC3. Single-channel 16-bit (CV_16UC1) frames are also
+    supported by the CPU implementation, with all color distance thresholds scaled to the 16-bit intensity range.
 
-    For now, only the algorithm's default CPU implementation is offered here.
+    The GLSL implementation (experimental, not used by default in the apps) keeps the model and per-pixel feedback state
+    in SSBOs, and runs segmentation, morphological hole filling, median blur post-processing and blink/final segmentation
+    feedback as compute stages. Hole filling floods the closed mask from its top-left corner with a fixed number of row/column
+    sweeps (see BGSSUBSENSE_GLSL_HOLEFILL_SWEEP_ROUNDS), so very convoluted background regions may be filled in as holes.
+    Frame-level (camera motion) learning rate adjustments and LBSP threshold adaptation run on the host between frames (so,
+    as in the CPU version, they affect the next frame), and automatic model resets refresh background samples with their own last value instead of a neighbor's.
+    PAWCS has no GLSL implementation.
 
     For more details on the different parameters or on the algorithm itself, see P.-L. St-Charles et al.,
     "Flexible Background Subtraction With Self-Balanced Local Sensitivity", in CVPRW 2014, or "SuBSENSE: A Universal
@@ -45,6 +66,123 @@
 template<lv::ParallelAlgoType eImpl>
 struct BackgroundSubtractorSuBSENSE_;
 
+#if HAVE_GLSL
+template<>
+struct BackgroundSubtractorSuBSENSE_<lv::GLSL> : public IBackgroundSubtractorLBSP_GLSL {
+public:
+    /// full constructor
+    BackgroundSubtractorSuBSENSE_(size_t nDescDistThresholdOffset=BGSSUBSENSE_DEFAULT_DESC_DIST_THRESHOLD_OFFSET,
+                                  size_t nMinColorDistThreshold=BGSSUBSENSE_DEFAULT_MIN_COLOR_DIST_THRESHOLD,
+                                  size_t nBGSamples=BGSSUBSENSE_DEFAULT_NB_BG_SAMPLES,
+                                  size_t nRequiredBGSamples=BGSSUBSENSE_DEFAULT_REQUIRED_NB_BG_SAMPLES,
+                                  size_t nSamplesForMovingAvgs=BGSSUBSENSE_DEFAULT_N_SAMPLES_FOR_MV_AVGS,
+                                  float fRelLBSPThreshold=BGSLBSP_DEFAULT_LBSP_REL_SIMILARITY_THRESHOLD);
+    /// refreshes all samples based on the last analyzed frame
+    void refreshModel(float fSamplesRefreshFrac, bool bForceFGUpdate=false);
+    /// (re)initiaization method; needs to be called before starting background subtraction
+    void initialize_gl(const cv::Mat& oInitImg, const cv::Mat& oROI) override;
+    /// returns the GLSL compute shader source code to run for a given algo stage
+    virtual std::string getComputeShaderSource(size_t nStage) const override;
+    /// returns a copy of the latest reconstructed background image
+    virtual void getBackgroundImage(cv::OutputArray oBGImg) const override;
+    /// returns a copy of the latest reconstructed background descriptors image
+    virtual void getBackgroundDescriptorsImage(cv::OutputArray oBGDescImg) const override;
+    /// returns the default learning rate value used in 'apply'
+    virtual double getDefaultLearningRate() const override {return 0;}
+
+protected:
+    /// returns the GLSL compute shader source code to run for the main processing stage (segmentation & model/state updates)
+    std::string getComputeShaderSource_SuBSENSE() const;
+    /// returns the GLSL compute shader source code to run the given morphological hole filling stage (dilation, erosion, flood sweeps or combination)
+    std::string getComputeShaderSource_HoleFill(size_t nStage) const;
+    /// returns the GLSL compute shader source code to run the post-processing stage (median blur)
+    std::string getComputeShaderSource_PostProc() const;
+    /// returns the GLSL compute shader source code to run the feedback stage (blink detection & final segm res averages)
+    std::string getComputeShaderSource_Feedback() const;
+    /// custom dispatch call function to adjust in-stage uniforms, batch workgroup size & other parameters
+    virtual void dispatch(size_t nStage, GLShader& oShader) override;
+    /// absolute minimal color distance threshold ('R' or 'radius' in the original ViBe paper, used as the default/initial 'R(x)' value here)
+    const size_t m_nMinColorDistThreshold;
+    /// absolute descriptor distance threshold offset
+    const size_t m_nDescDistThresholdOffset;
+    /// number of different samples per pixel/block to be taken from input frames to build the background model (same as 'N' in ViBe/PBAS)
+    const size_t m_nBGSamples;
+    /// number of similar samples needed to consider the current pixel/block as 'background' (same as '#_min' in ViBe/PBAS)
+    const size_t m_nRequiredBGSamples;
+    /// number of samples to use to compute the learning rate of moving averages
+    const size_t m_nSamplesForMovingAvgs;
+    /// current learning rate caps
+    float m_fCurrLearningRateLowerCap, m_fCurrLearningRateUpperCap;
+    /// current kernel size for median blur post-proc filtering
+    int m_nMedianBlurKernelSize;
+    /// specifies the px update spread range
+    bool m_bUse3x3Spread;
+    /// specifies whether learning rate caps are adjusted based on frame-level (camera motion) analysis
+    bool m_bLearningRateScalingEnabled;
+    /// copy of the non-zero LBSP descriptor ratio of the previous frame (used to adapt LBSP thresholds)
+    float m_fLastNonZeroDescRatio;
+    /// number of background samples to refresh with their last value in the next segmentation stage (0 if no model reset is pending)
+    size_t m_nPendingResetSampleCount;
+    /// downsampled frame size used for frame-level analysis
+    cv::Size m_oDownSampledFrameSize;
+    /// pre-allocated matrices used for frame-level analysis (downsampled input & its rolling averages)
+    cv::Mat m_oDownSampledFrame_MotionAnalysis, m_oMeanDownSampledLastDistFrame_LT, m_oMeanDownSampledLastDistFrame_ST;
+    /// packed hole filling mask bits (raw, dilated, closed & flooded) for the current frame
+    std::unique_ptr<GLTexture2D> m_pHoleFillTexture;
+
+    /// per-pixel feedback state, mirrored as-is (std430 layout) in the state SSBO
+    struct PxState {
+        float fLearningRate, fDistThresholdFactor, fVariationFactor, fMeanLastDist;
+        float fMeanMinDist_LT, fMeanMinDist_ST, fMeanRawSegmRes_LT, fMeanRawSegmRes_ST;
+        float fMeanFinalSegmRes_LT, fMeanFinalSegmRes_ST;
+        uint nLastColor, anLastIntraDesc[2], nFlags;
+    };
+    size_t m_nTMT32ModelSize;
+    size_t m_nSampleStepSize;
+    size_t m_nPxModelSize;
+    size_t m_nPxModelPadding;
+    size_t m_nColStepSize;
+    size_t m_nRowStepSize;
+    size_t m_nBGModelSize;
+    std::aligned_vector<uint,32> m_vnBGModelData;
+    std::aligned_vector<PxState,32> m_voPxStateData;
+    std::aligned_vector<lv::gl::TMT32GenParams,32> m_voTMT32ModelData;
+    enum SuBSENSEStorageBufferBindingList {
+        SuBSENSEStorageBuffer_BGModelBinding = GLImageProcAlgo::nStorageBufferDefaultBindingsCount,
+        SuBSENSEStorageBuffer_PxStateBinding,
+        SuBSENSEStorageBuffer_TMT32ModelBinding,
+        SuBSENSEStorageBuffer_LBSPThresLUTBinding,
+        nSuBSENSEStorageBufferBindingsCount
+    };
+    enum SuBSENSEAtomicCounterBufferBindingList {
+        SuBSENSEAtomicCounterBuffer_NonZeroDescCountBinding = GLImageProcAlgo::nAtomicCounterBufferDefaultBindingsCount,
+        nSuBSENSEAtomicCounterBufferBindingsCount
+    };
+    enum SuBSENSEImageBindingList {
+        SuBSENSEImage_HoleFillBinding = GLImageProcAlgo::nImageDefaultBindingsCount,
+        nSuBSENSEImageBindingsCount
+    };
+    enum SuBSENSEComputeStageList {
+        SuBSENSEStage_Segmentation,
+        SuBSENSEStage_Dilation,
+        SuBSENSEStage_Erosion,
+        SuBSENSEStage_FirstFloodSweep,
+        SuBSENSEStage_Combination = SuBSENSEStage_FirstFloodSweep+BGSSUBSENSE_GLSL_HOLEFILL_SWEEP_ROUNDS*2,
+        SuBSENSEStage_MedianBlur,
+        SuBSENSEStage_Feedback,
+        nSuBSENSEStagesCount
+    };
+    /// uploads the current LBSP threshold LUT to its ssbo
+    void uploadLBSPThresholdLUT();
+    /// adapts LBSP thresholds based on the non-zero descriptor count of the last segmented frame (read back from its atomic counter)
+    void updateLBSPThresholds(size_t nNonZeroDescCount);
+    /// adapts learning rate caps & schedules model resets based on frame-level (camera motion) analysis of the given (just dispatched) frame
+    void updateFrameLevelAnalysis(const cv::Mat& oInputImg, float fRollAvgFactor_LT, float fRollAvgFactor_ST);
+};
+
+using BackgroundSubtractorSuBSENSE_GLSL = BackgroundSubtractorSuBSENSE_<lv::GLSL>;
+#endif //HAVE_GLSL
+
 template<>
 struct BackgroundSubtractorSuBSENSE_<lv::NonParallel> : public IBackgroundSubtractorLBSP {
 public:
@@ -61,20 +199,99 @@ public:
     virtual void initialize(const cv::Mat& oInitImg, const cv::Mat& oROI) override;
     /// primary model update function; the learning param is used to override the internal learning thresholds (ignored when <= 0)
     virtual void apply(cv::InputArray image, cv::OutputArray fgmask, double learningRateOverride=0) override;
+    /// segmentation-only pass using the current samples & thresholds (post-processed like 'apply'); no model, state, mask or RNG is updated
+    virtual void classify(cv::InputArray image, cv::OutputArray fgmask) override;
     /// returns a copy of the latest reconstructed background image
     void getBackgroundImage(cv::OutputArray backgroundImage) const override;
     /// returns a copy of the latest reconstructed background descriptors image
     void getBackgroundDescriptorsImage(cv::OutputArray backgroundDescImage) const override;
     /// returns the default learning rate value used in 'apply'
     virtual double getDefaultLearningRate() const override {return 0;}
+    /// toggles the interleaved (per-pixel) background sample layout, which is faster for large frames (the model is converted if already initialized)
+    void setInterleavedSampleModel(bool bInterleaved);
+    /// toggles the deduplicated (8-bit only) background sample layout, which stores up to nMaxDistinctSamples distinct values per pixel with their multiplicities (the model is converted if already initialized)
+    void setDeduplicatedSampleModel(bool bEnabled, size_t nMaxDistinctSamples=BGSLBSP_DEFAULT_DEDUP_SAMPLE_SLOTS);
+    /// toggles the bit-sliced descriptor mirror of the background samples, used to prefilter samples 64 at a time on their intra-LBSP descriptor distance (ignored in deduplicated layout)
+    void setBitSlicedDescriptors(bool bEnabled);
+    /// toggles the compact (16-bit fixed-point) storage of per-pixel state maps, which halves their memory footprint at a small precision cost (maps are converted if already initialized)
+    void setCompactStateMaps(bool bEnabled);
+    /// changes the number of samples per pixel in the background model (the learned model is kept; the most redundant samples of each pixel are dropped first when shrinking)
+    void setModelCapacity(size_t nBGSamples);
+    /// returns the number of samples per pixel in the background model
+    size_t getModelCapacity() const {return m_nBGSamples;}
+    /// reseeds the internal random number generators used for model updates (including per-band ones)
+    virtual void setRandomSeed(uint64_t nSeed) override;
+    /// sets the number of threads used to process row bands in 'apply' (1 = sequential, as by default; 0 = one per hardware thread)
+    void setThreadCount(size_t nThreads);
+    /// returns the number of threads used to process row bands in 'apply'
+    size_t getThreadCount() const;
+    /// spreads automatic model resets over the given number of consecutive frames instead of refreshing all pixels at once (0 or 1 = immediate reset, as by default)
+    void setIncrementalModelReset(size_t nFrames);
+    /// toggles global motion compensation, where the frame-to-frame camera translation is estimated and used to warp the model instead of resetting it
+    void setGlobalMotionCompensation(bool bEnabled);
+    /// returns the (full-resolution) translation applied to the model in the last 'apply' call by global motion compensation
+    cv::Point getLastGlobalMotion() const {return m_oLastGlobalMotion;}
+    /// toggles the stability shortcut, where pixels classified as BG for at least 'nMinBGStreak' frames with a low mean frame-to-frame distance are only checked against their last best-matching sample
+    void setStabilityShortcut(bool bEnabled, size_t nMinBGStreak=BGSSUBSENSE_DEFAULT_STABILITY_MIN_BG_STREAK, float fMaxMeanLastDist=BGSSUBSENSE_DEFAULT_STABILITY_MAX_MEAN_LAST_DIST);
+    /// toggles coarse-to-fine classification in 'classify', where only a 1/nCoarseStride grid is matched first, and full-res matching is limited to coarse FG cells dilated by nRefineMargin cells
+    void setCoarseToFineClassification(bool bEnabled, size_t nCoarseStride=BGSSUBSENSE_DEFAULT_C2F_COARSE_STRIDE, size_t nRefineMargin=BGSSUBSENSE_DEFAULT_C2F_REFINE_MARGIN);
 
 protected:
+    /// processes the model pixels in [nModelIterBegin,nModelIterEnd) of the current frame using the given RNG, and returns their non-zero desc count (matching stats are accumulated in the last two args)
+    template<typename TColor, size_t nChannels, typename TRNG>
+    size_t applyBand(const cv::Mat& oInputImg, cv::Mat& oCurrFGMask, double learningRateOverride, float fRollAvgFactor_LT,
+                     float fRollAvgFactor_ST, size_t nModelIterBegin, size_t nModelIterEnd, TRNG& oRNG,
+                     size_t& nSamplesTested, size_t& nEarlyExits);
+    /// classifies the model pixels in [nModelIterBegin,nModelIterEnd) of the given frame into the raw FG mask without touching the model (pixels null in pnPxMask are skipped, if given)
+    template<typename TColor, size_t nChannels>
+    void classifyBand(const cv::Mat& oInputImg, cv::Mat& oCurrFGMask, size_t nModelIterBegin, size_t nModelIterEnd, const uchar* pnPxMask=nullptr) const;
+    /// returns the per-channel color distance threshold of a pixel (halved for single-channel inputs) in the intensity range of TColor; shared by 'applyBand' & 'classifyBand' so both segment identically
+    template<typename TColor, size_t nMatchChannels>
+    size_t getColorDistThreshold(float fDistThresholdFactor, bool bUnstableRegion) const;
+    /// returns the per-channel descriptor distance threshold of a pixel; shared by 'applyBand' & 'classifyBand' so both segment identically
+    size_t getDescDistThreshold(float fDistThresholdFactor, bool bUnstableRegion) const;
+    /// running state of the sample matching kernel for a single pixel (min distances & best sample are only tracked by the update policy)
+    struct PxMatchState {
+        size_t nGoodSamplesCount; ///< weighted number of matching samples found so far
+        size_t nSampleIdx; ///< index of the next sample (or slot) block to test
+        size_t nMinTotDescDist; ///< min total descriptor distance of all matching samples
+        size_t nMinTotSumDist; ///< min total color+descriptor distance of all matching samples
+        size_t nBestSampleIdx; ///< index of the sample reaching nMinTotSumDist
+    };
+    /// sample matching kernel shared by 'applyBand' (bUpdatePolicy=true, min distances tracked for the feedback loop) and 'classifyBand' (bUpdatePolicy=false);
+    /// tests samples from oMatch.nSampleIdx on until nRequiredBGSamples matches are found, computing the LBSP lookup values lazily if bLBSPLookupValsReady is unset
+    template<typename TColor, size_t nChannels, bool bUpdatePolicy>
+    void matchPixel(const cv::Mat& oInputImg, size_t nPxIter, size_t nMatchSlots, const TColor* anCurrColor, const ushort* anCurrIntraDesc,
+                    std::array<std::array<TColor,LBSP::DESC_SIZE_BITS>,getMatchChannelCount(nChannels)>& aanLBSPLookupVals, bool& bLBSPLookupValsReady,
+                    size_t nCurrSCColorDistThreshold, size_t nCurrTotColorDistThreshold, size_t nCurrTotDescDistThreshold,
+                    PxMatchState& oMatch, size_t& nSamplesTested) const;
+    /// refreshes the samples of the model pixels in [nModelIterBegin,nModelIterEnd) based on the last analyzed frame (row bands are processed concurrently if threading is enabled)
+    void refreshModelRange(float fSamplesRefreshFrac, bool bForceFGUpdate, size_t nModelIterBegin, size_t nModelIterEnd);
+    /// copies up to nModelSamplesToRefresh samples (starting at nRefreshSampleStartPos) from the last analyzed frame into the model pixels in [nModelIterBegin,nModelIterEnd)
+    template<typename TColor, size_t nChannels, typename TRNG>
+    void refreshModelBand(size_t nModelSamplesToRefresh, size_t nRefreshSampleStartPos, bool bForceFGUpdate, size_t nModelIterBegin, size_t nModelIterEnd, TRNG& oRNG);
+    /// estimates the translation between the last & current frames via coarse-to-fine phase correlation (returns a null shift if unreliable)
+    cv::Point estimateGlobalMotion(const cv::Mat& oInputImg);
+    /// shifts the samples, state maps & last frame masks by the given (full-resolution) translation
+    void translateModel(const cv::Point& oShift);
+    /// rebuilds the row band LUT and per-band RNGs used for multi-threaded processing based on the current ROI and thread count
+    void updateBandLUT();
+    /// returns pointers to the full-resolution per-pixel state maps which can be stored in compact format (T, R, v, D_last, D_min LT/ST, raw & final segm res LT/ST)
+    std::array<cv::Mat*,10> getStateMaps();
+    /// returns a new (uninitialized) instance with the same parameters & settings
+    virtual std::shared_ptr<IIBackgroundSubtractor> createInstance() const override;
+    /// writes the impl-specific model state (samples, state maps, masks & RNGs) to a snapshot stream
+    virtual void writeModelState(std::ostream& oStream) const override;
+    /// reads the impl-specific model state (samples, state maps, masks & RNGs) from a snapshot stream
+    virtual void readModelState(std::istream& oStream) override;
+    /// applies a new ROI to the running model, initializing samples & state maps of added pixels from their nearest previous ROI pixels
+    virtual bool updateModelROI(const cv::Mat& oNewROI, size_t nOrigROIPxCount) override;
     /// absolute minimal color distance threshold ('R' or 'radius' in the original ViBe paper, used as the default/initial 'R(x)' value here)
     const size_t m_nMinColorDistThreshold;
     /// absolute descriptor distance threshold offset
     const size_t m_nDescDistThresholdOffset;
-    /// number of different samples per pixel/block to be taken from input frames to build the background model (same as 'N' in ViBe/PBAS)
-    const size_t m_nBGSamples;
+    /// number of different samples per pixel/block to be taken from input frames to build the background model (same as 'N' in ViBe/PBAS; can be changed via 'setModelCapacity')
+    size_t m_nBGSamples;
     /// number of similar samples needed to consider the current pixel/block as 'background' (same as '#_min' in ViBe/PBAS)
     const size_t m_nRequiredBGSamples;
     /// number of samples to use to compute the learning rate of moving averages
@@ -92,11 +309,21 @@ protected:
     /// specifies the downsampled frame size used for cam motion analysis
     cv::Size m_oDownSampledFrameSize;
 
-    /// background model pixel color intensity samples (equivalent to 'B(x)' in PBAS)
-    std::vector<cv::Mat> m_voBGColorSamples;
-    /// background model descriptors samples
-    std::vector<cv::Mat> m_voBGDescSamples;
+    /// specifies whether the background model uses the interleaved (per-pixel) sample layout or not
+    bool m_bUsingInterleavedSamples;
+    /// number of distinct value slots per pixel in the deduplicated sample layout (0 = disabled)
+    size_t m_nDedupSampleSlots;
+    /// specifies whether the background model keeps a bit-sliced descriptor mirror for block-wise descriptor prefiltering or not
+    bool m_bUsingBitSlicedDescs;
+    /// background model pixel color intensity & descriptor samples (equivalent to 'B(x)' in PBAS)
+    LBSPSampleModel m_oBGSamples;
+    /// mean background color & descriptor images, refreshed (only where samples changed) & published at the end of each model update, and read by 'getBackground...Image' calls
+    mutable LBSPMeanImageBuffer m_oBGMeanImgs;
+    /// guards the background model against concurrent updates (and 'getBackground...Image' calls refreshing the mean images while no update runs)
+    mutable std::mutex m_oModelMutex;
 
+    /// specifies whether per-pixel state maps are stored as 16-bit fixed-point values (CV_16UC1) instead of floats (CV_32FC1)
+    bool m_bUsingCompactStateMaps;
     /// per-pixel update rates ('T(x)' in PBAS, which contains pixel-level 'sigmas', as referred to in ViBe)
     cv::Mat m_oUpdateRateFrame;
     /// per-pixel distance thresholds (equivalent to 'R(x)' in PBAS, but used as a relative value to determine both intensity and descriptor variation thresholds)
@@ -122,14 +349,50 @@ protected:
     /// the foreground mask generated by the method at [t-1] (without post-proc, used for blinking px detection)
     cv::Mat m_oLastRawFGMask;
 
-    /// pre-allocated CV_8UC1 matrices used to speed up morph ops
-    cv::Mat m_oFGMask_PreFlood;
-    cv::Mat m_oFGMask_FloodedHoles;
-    cv::Mat m_oLastFGMask_dilated;
+    /// pre-allocated CV_8UC1 matrices used to speed up morph ops (transient ones are borrowed from the per-thread scratch buffers)
     cv::Mat m_oLastFGMask_dilated_inverted;
-    cv::Mat m_oCurrRawFGBlinkMask;
     cv::Mat m_oLastRawFGBlinkMask;
     cv::Mat m_oMorphExStructElement;
+
+    /// number of threads used to process row bands in 'apply' (1 = sequential)
+    size_t m_nThreadCount;
+    /// worker pool used to process row bands (only allocated when m_nThreadCount!=1)
+    std::unique_ptr<lv::ThreadPool> m_pThreadPool;
+    /// first model iter of each row band (with an extra end element)
+    std::vector<size_t> m_vnBandModelIterLUT;
+    /// per-band random number generators (kept per band so results do not depend on thread scheduling)
+    std::vector<lv::PCG32> m_voBandRNGs;
+    /// number of frames over which automatic model resets are spread (<=1 = immediate)
+    size_t m_nIncrementalResetFrames;
+    /// number of frames left in the current incremental model reset
+    size_t m_nPendingResetFrames;
+    /// specifies whether global motion compensation is used or not
+    bool m_bUsingGlobalMotionCompensation;
+    /// last grayscale frames used for global motion estimation (coarse & fine pyramid levels, CV_32FC1)
+    cv::Mat m_oLastGMCFrame_Coarse, m_oLastGMCFrame_Fine;
+    /// Hanning windows used for phase correlation at both pyramid levels
+    cv::Mat m_oGMCWindow_Coarse, m_oGMCWindow_Fine;
+    /// translation applied to the model in the last 'apply' call
+    cv::Point m_oLastGlobalMotion;
+    /// specifies whether the stability shortcut is used or not
+    bool m_bUsingStabilityShortcut;
+    /// minimum number of consecutive BG classifications before a pixel may use the stability shortcut
+    size_t m_nStabilityMinBGStreak;
+    /// maximum (normalized) mean frame-to-frame distance below which a pixel may use the stability shortcut
+    float m_fStabilityMaxMeanLastDist;
+    /// per-pixel consecutive BG classification count (CV_16UC1, saturated)
+    cv::Mat m_oBGStreakFrame;
+    /// per-pixel index of the last best-matching BG sample (CV_16UC1)
+    cv::Mat m_oStableSampleIdxFrame;
+    /// specifies whether coarse-to-fine classification is used or not
+    bool m_bUsingCoarseToFineClassification;
+    /// coarse grid stride (in pixels) & refinement margin (in coarse cells) used for coarse-to-fine classification
+    size_t m_nC2FCoarseStride, m_nC2FRefineMargin;
+    /// coarse grid pixel mask, coarse FG cell mask & full-res refinement mask used for coarse-to-fine classification
+    cv::Mat m_oC2FGridMask, m_oC2FCoarseFGMask, m_oC2FRefineMask;
+    /// scratch arena (reset after each model translation) and its matrix allocator adapter, used for temporary warped maps
+    lv::FrameArena m_oFrameArena;
+    cv::ArenaMatAllocator m_oFrameArenaAllocator;
 };
 
 using BackgroundSubtractorSuBSENSE = BackgroundSubtractorSuBSENSE_<lv::NonParallel>;
@@ -21,9 +21,12 @@
 //
 // Video Background Extractor (ViBe); originally proposed by O. Barnich and M. Van Droogenbroeck.
 //
-// CAUTION: this implementation of ViBe is very naive, and not optimized at all. It was used as a
-// code sandbox for early versions of LOBSTER. If you want a well-implemented, fully vectorized
-// version for testing/evaluation, contact the original authors via http://www.vibeinmotion.com/
+// CAUTION: the default implementation of ViBe is very naive, and not optimized at all. It was used
+// as a code sandbox for early versions of LOBSTER. An optimized path (block-interleaved samples,
+// SSE2 classification) can be toggled via setOptimizedImpl; it gives the exact same results as
+// the naive one for a given random seed. A GLSL impl (BackgroundSubtractorViBe_GLSL) is also
+// available. If you want the original authors' well-implemented version for testing/evaluation,
+// contact them via http://www.vibeinmotion.com/
 //
 // Note that ViBe is patented in the US, Europe and Japan; this implementation is offered for
 // testing purposes only. For commercial use, refer to the original author's licensing guide on
@@ -36,7 +39,11 @@
 //
 // @@@@@@@@
 
+#include "litiv/utils/cxx.hpp"
 #include <opencv2/video/background_segm.hpp>
+#if HAVE_GLSL
+#include "litiv/video/BackgroundSubtractionUtils.hpp"
+#endif //HAVE_GLSL
 
 /// defines the default value for BackgroundSubtractorViBe::m_nColorDistThreshold
 #define BGSVIBE_DEFAULT_COLOR_DIST_THRESHOLD (20)
@@ -53,6 +60,8 @@
 /// defines whether we should use L1 distance or L2 distance for change detection
 #define BGSVIBE_USE_L1_DISTANCE_CHECK 0
 
+#define BGSVIBE_GLSL_USE_TIMERS 0
+
 /*!
     ViBe foreground-background segmentation algorithm (abstract version).
  */
@@ -70,20 +79,41 @@ public:
     virtual void apply(cv::InputArray image, cv::OutputArray fgmask, double learningRate=BGSVIBE_DEFAULT_LEARNING_RATE) = 0;
     /// returns a copy of the latest reconstructed background image
     void getBackgroundImage(cv::OutputArray backgroundImage) const;
+    /// reseeds the internal random number generator used for model init/updates (instances use a fixed default seed)
+    void setRandomSeed(uint64_t nSeed);
+    /// toggles the optimized implementation (block-interleaved model, vectorized classification); results are identical to the naive one
+    void setOptimizedImpl(bool bEnabled);
 
 protected:
+    /// converts the background model between the per-sample image layout and the block-interleaved one used by the optimized impl
+    template<size_t nChannels>
+    void convertModelLayout(bool bToBlocks);
+    /// returns whether the given input color matches enough samples of the block-interleaved model at the given pixel index
+    template<size_t nChannels>
+    bool isBackgroundPx_optimized(const uchar* anInputColor, size_t nPxIdx) const;
+    /// optimized model update function; classifies pixels in blocks, and updates them in the same order as the naive impl
+    template<size_t nChannels>
+    void apply_optimized(const cv::Mat& oInputImg, cv::Mat& oFGMask, size_t nLearningRate);
     /// number of different samples per pixel/block to be taken from input frames to build the background model ('N' in the original ViBe paper)
     const size_t m_nBGSamples;
     /// number of similar samples needed to consider the current pixel/block as 'background' ('#_min' in the original ViBe paper)
     const size_t m_nRequiredBGSamples;
     /// background model pixel intensity samples
     std::vector<cv::Mat> m_voBGImg;
+    /// background model pixel intensity samples, block-interleaved (used instead of m_voBGImg by the optimized impl)
+    std::vector<uchar> m_vuBGSampleBlocks;
+    /// input image channel count (set on initialization)
+    size_t m_nImgChannels;
     /// input image size
     cv::Size m_oImgSize;
     /// absolute color distance threshold ('R' or 'radius' in the original ViBe paper)
     const size_t m_nColorDistThreshold;
     /// defines whether or not the subtractor is fully initialized
     bool m_bInitialized;
+    /// defines whether the optimized implementation is in use or not
+    bool m_bUsingOptimizedImpl;
+    /// per-instance random number generator used for model init/updates (avoids the global lock of rand())
+    lv::PCG32 m_oRNG;
 };
 
 /*!
@@ -119,3 +149,53 @@ public:
     /// primary model update function; the learning param is reinterpreted as an integer and should be > 0 (smaller values == faster adaptation)
     virtual void apply(cv::InputArray image, cv::OutputArray fgmask, double learningRate=BGSVIBE_DEFAULT_LEARNING_RATE);
 };
+
+#if HAVE_GLSL
+/*!
+    ViBe foreground-background segmentation algorithm (GLSL version, for 1ch/3ch images).
+
+    Note: each pixel is matched & updated by its own shader invocation using a per-pixel TinyMT32 generator; the
+    matching rules are the same as in the CPU impls, but random draws (and thus results) are not identical.
+ */
+class BackgroundSubtractorViBe_GLSL : public IBackgroundSubtractor_GLSL {
+public:
+    /// full constructor
+    BackgroundSubtractorViBe_GLSL(size_t nColorDistThreshold=BGSVIBE_DEFAULT_COLOR_DIST_THRESHOLD,
+                                  size_t nBGSamples=BGSVIBE_DEFAULT_NB_BG_SAMPLES,
+                                  size_t nRequiredBGSamples=BGSVIBE_DEFAULT_REQUIRED_NB_BG_SAMPLES);
+    /// refreshes all samples based on the last analyzed frame
+    void refreshModel(float fSamplesRefreshFrac, bool bForceFGUpdate=false);
+    /// (re)initiaization method; needs to be called before starting background subtraction
+    virtual void initialize_gl(const cv::Mat& oInitImg, const cv::Mat& oROI) override;
+    /// returns the GLSL compute shader source code to run for a given algo stage
+    virtual std::string getComputeShaderSource(size_t nStage) const override;
+    /// returns a copy of the latest reconstructed background image
+    virtual void getBackgroundImage(cv::OutputArray oBGImg) const override;
+    /// returns the default learning rate value used in 'apply' (the 'subsampling' factor in the original ViBe paper)
+    virtual double getDefaultLearningRate() const override {return BGSVIBE_DEFAULT_LEARNING_RATE;}
+
+protected:
+    /// custom dispatch call function to adjust in-stage uniforms
+    virtual void dispatch(size_t nStage, GLShader& oShader) override;
+    /// absolute color distance threshold ('R' or 'radius' in the original ViBe paper)
+    const size_t m_nColorDistThreshold;
+    /// number of different samples per pixel to be taken from input frames to build the background model ('N' in the original ViBe paper)
+    const size_t m_nBGSamples;
+    /// number of similar samples needed to consider the current pixel as 'background' ('#_min' in the original ViBe paper)
+    const size_t m_nRequiredBGSamples;
+    size_t m_nTMT32ModelSize;
+    size_t m_nSampleStepSize;
+    size_t m_nPxModelSize;
+    size_t m_nPxModelPadding;
+    size_t m_nColStepSize;
+    size_t m_nRowStepSize;
+    size_t m_nBGModelSize;
+    std::aligned_vector<uint,32> m_vnBGModelData;
+    std::aligned_vector<lv::gl::TMT32GenParams,32> m_voTMT32ModelData;
+    enum ViBeStorageBufferBindingList {
+        ViBeStorageBuffer_BGModelBinding = GLImageProcAlgo::nStorageBufferDefaultBindingsCount,
+        ViBeStorageBuffer_TMT32ModelBinding,
+        nViBeStorageBufferBindingsCount
+    };
+};
+#endif //HAVE_GLSL
@@ -0,0 +1,329 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "litiv/video/BackgroundSubtractionService.hpp"
+
+// local define used to identify (& version) ring and control segments
+#define BGSSERVICE_SEGMENT_MAGIC (0x4C564253) // 'LVBS'
+#define BGSSERVICE_SEGMENT_VERSION (1)
+// local define used to align ring slots & their frame/mask buffers (cache line size)
+#define BGSSERVICE_SLOT_ALIGNMENT (size_t(64))
+
+struct BGSFrameRing::Header {
+    uint32_t nMagic,nVersion;
+    int32_t nRows,nCols,nFrameType;
+    uint32_t nSlots;
+    uint64_t nFrameByteSize,nMaskByteSize,nSlotStride;
+    /// monotonic counters, each written by a single side (kept on separate cache lines to avoid false sharing)
+    alignas(64) std::atomic<uint64_t> nSubmitted; ///< written by the client once a frame is written
+    alignas(64) std::atomic<uint64_t> nCompleted; ///< written by the service once a mask is written
+    alignas(64) std::atomic<uint64_t> nReleased; ///< written by the client once a mask is read
+};
+
+struct BGSFrameRing::SlotHeader {
+    uint64_t nFrameIdx;
+    double dTimestamp;
+    uint32_t bFailed;
+};
+
+namespace {
+
+    inline size_t alignSlotSize(size_t nSize) {
+        return ((nSize+BGSSERVICE_SLOT_ALIGNMENT-1)/BGSSERVICE_SLOT_ALIGNMENT)*BGSSERVICE_SLOT_ALIGNMENT;
+    }
+
+} // anonymous namespace
+
+BGSFrameRing::BGSFrameRing(const std::string& sSegmentName, const cv::Size& oFrameSize, int nFrameType, size_t nSlots) :
+        m_bSlotHeld(false) {
+    lvAssert_(oFrameSize.area()>0,"frame size must be non-null");
+    lvAssert_(nFrameType==CV_8UC1 || nFrameType==CV_8UC3 || nFrameType==CV_8UC4 || nFrameType==CV_16UC1,"frame type must be 8UC1/3/4 or 16UC1");
+    lvAssert_(nSlots>0,"ring must have at least one slot");
+    const size_t nFrameByteSize = size_t(oFrameSize.area())*CV_ELEM_SIZE(nFrameType);
+    const size_t nMaskByteSize = size_t(oFrameSize.area());
+    const size_t nSlotStride = alignSlotSize(sizeof(SlotHeader))+alignSlotSize(nFrameByteSize)+alignSlotSize(nMaskByteSize);
+    m_pSegment = std::make_unique<lv::SharedMemorySegment>(sSegmentName,alignSlotSize(sizeof(Header))+nSlotStride*nSlots,true);
+    Header* pHeader = new(m_pSegment->data()) Header();
+    pHeader->nRows = oFrameSize.height;
+    pHeader->nCols = oFrameSize.width;
+    pHeader->nFrameType = nFrameType;
+    pHeader->nSlots = (uint32_t)nSlots;
+    pHeader->nFrameByteSize = nFrameByteSize;
+    pHeader->nMaskByteSize = nMaskByteSize;
+    pHeader->nSlotStride = nSlotStride;
+    pHeader->nSubmitted = 0;
+    pHeader->nCompleted = 0;
+    pHeader->nReleased = 0;
+    pHeader->nVersion = BGSSERVICE_SEGMENT_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    pHeader->nMagic = BGSSERVICE_SEGMENT_MAGIC;
+}
+
+BGSFrameRing::BGSFrameRing(const std::string& sSegmentName) :
+        m_pSegment(std::make_unique<lv::SharedMemorySegment>(sSegmentName,0,false)),
+        m_bSlotHeld(false) {
+    lvAssert__(m_pSegment->size()>=sizeof(Header) && getHeader().nMagic==BGSSERVICE_SEGMENT_MAGIC,"segment '%s' is not a frame ring",sSegmentName.c_str());
+    std::atomic_thread_fence(std::memory_order_acquire);
+    lvAssert__(getHeader().nVersion==BGSSERVICE_SEGMENT_VERSION,"frame ring '%s' version mismatch",sSegmentName.c_str());
+    lvAssert__(m_pSegment->size()>=alignSlotSize(sizeof(Header))+getHeader().nSlotStride*getHeader().nSlots,"frame ring '%s' is truncated",sSegmentName.c_str());
+}
+
+cv::Size BGSFrameRing::getFrameSize() const {
+    return cv::Size(getHeader().nCols,getHeader().nRows);
+}
+
+int BGSFrameRing::getFrameType() const {
+    return getHeader().nFrameType;
+}
+
+size_t BGSFrameRing::getSlotCount() const {
+    return getHeader().nSlots;
+}
+
+cv::Mat BGSFrameRing::getNextFrameSlot() {
+    lvDbgAssert_(!m_bSlotHeld,"previous frame slot was not submitted");
+    Header& oHeader = getHeader();
+    // submitted & released counts are only written on this side
+    const uint64_t nSubmitted = oHeader.nSubmitted.load(std::memory_order_relaxed);
+    if(nSubmitted-oHeader.nReleased.load(std::memory_order_relaxed)>=oHeader.nSlots)
+        return cv::Mat();
+    m_bSlotHeld = true;
+    return cv::Mat(oHeader.nRows,oHeader.nCols,oHeader.nFrameType,getSlot(nSubmitted)+alignSlotSize(sizeof(SlotHeader)));
+}
+
+void BGSFrameRing::submitFrame(double dTimestamp) {
+    lvAssert_(m_bSlotHeld,"a frame slot must be obtained via 'getNextFrameSlot' before submitting");
+    Header& oHeader = getHeader();
+    const uint64_t nSubmitted = oHeader.nSubmitted.load(std::memory_order_relaxed);
+    SlotHeader& oSlotHeader = *reinterpret_cast<SlotHeader*>(getSlot(nSubmitted));
+    oSlotHeader.nFrameIdx = nSubmitted;
+    oSlotHeader.dTimestamp = dTimestamp;
+    oSlotHeader.bFailed = 0;
+    oHeader.nSubmitted.store(nSubmitted+1,std::memory_order_release);
+    m_bSlotHeld = false;
+}
+
+cv::Mat BGSFrameRing::getNextMask(size_t* pnFrameIdx, bool* pbFailed) {
+    Header& oHeader = getHeader();
+    const uint64_t nReleased = oHeader.nReleased.load(std::memory_order_relaxed);
+    if(nReleased>=oHeader.nCompleted.load(std::memory_order_acquire))
+        return cv::Mat();
+    uint8_t* pSlot = getSlot(nReleased);
+    const SlotHeader& oSlotHeader = *reinterpret_cast<const SlotHeader*>(pSlot);
+    if(pnFrameIdx)
+        *pnFrameIdx = (size_t)oSlotHeader.nFrameIdx;
+    if(pbFailed)
+        *pbFailed = oSlotHeader.bFailed!=0;
+    return cv::Mat(oHeader.nRows,oHeader.nCols,CV_8UC1,pSlot+alignSlotSize(sizeof(SlotHeader))+alignSlotSize((size_t)oHeader.nFrameByteSize));
+}
+
+void BGSFrameRing::releaseMask() {
+    Header& oHeader = getHeader();
+    const uint64_t nReleased = oHeader.nReleased.load(std::memory_order_relaxed);
+    lvAssert_(nReleased<oHeader.nCompleted.load(std::memory_order_acquire),"no completed mask to release");
+    oHeader.nReleased.store(nReleased+1,std::memory_order_release);
+}
+
+bool BGSFrameRing::hasPendingFrame() const {
+    const Header& oHeader = getHeader();
+    return oHeader.nCompleted.load(std::memory_order_relaxed)<oHeader.nSubmitted.load(std::memory_order_acquire);
+}
+
+bool BGSFrameRing::getPendingFrame(cv::Mat& oFrame, cv::Mat& oMask, size_t& nFrameIdx, double& dTimestamp) {
+    Header& oHeader = getHeader();
+    // completed count is only written on this side
+    const uint64_t nCompleted = oHeader.nCompleted.load(std::memory_order_relaxed);
+    if(nCompleted>=oHeader.nSubmitted.load(std::memory_order_acquire))
+        return false;
+    uint8_t* pSlot = getSlot(nCompleted);
+    const SlotHeader& oSlotHeader = *reinterpret_cast<const SlotHeader*>(pSlot);
+    nFrameIdx = (size_t)oSlotHeader.nFrameIdx;
+    dTimestamp = oSlotHeader.dTimestamp;
+    pSlot += alignSlotSize(sizeof(SlotHeader));
+    oFrame = cv::Mat(oHeader.nRows,oHeader.nCols,oHeader.nFrameType,pSlot);
+    oMask = cv::Mat(oHeader.nRows,oHeader.nCols,CV_8UC1,pSlot+alignSlotSize((size_t)oHeader.nFrameByteSize));
+    m_bSlotHeld = true;
+    return true;
+}
+
+void BGSFrameRing::completeFrame(bool bFailed) {
+    lvAssert_(m_bSlotHeld,"a pending frame must be obtained via 'getPendingFrame' before completing it");
+    Header& oHeader = getHeader();
+    const uint64_t nCompleted = oHeader.nCompleted.load(std::memory_order_relaxed);
+    uint8_t* pSlot = getSlot(nCompleted);
+    if(bFailed)
+        std::fill_n(pSlot+alignSlotSize(sizeof(SlotHeader))+alignSlotSize((size_t)oHeader.nFrameByteSize),(size_t)oHeader.nMaskByteSize,uint8_t(0));
+    reinterpret_cast<SlotHeader*>(pSlot)->bFailed = bFailed?1:0;
+    oHeader.nCompleted.store(nCompleted+1,std::memory_order_release);
+    m_bSlotHeld = false;
+}
+
+BGSFrameRing::Header& BGSFrameRing::getHeader() const {
+    return *reinterpret_cast<Header*>(m_pSegment->data());
+}
+
+uint8_t* BGSFrameRing::getSlot(uint64_t nFrameIdx) const {
+    const Header& oHeader = getHeader();
+    return m_pSegment->data()+alignSlotSize(sizeof(Header))+(nFrameIdx%oHeader.nSlots)*oHeader.nSlotStride;
+}
+
+struct BGSServiceControl::Header {
+    uint32_t nMagic,nVersion;
+    std::atomic<uint32_t> bServiceAlive;
+    /// spin lock serializing clients (0 = free)
+    std::atomic<uint32_t> nClientLock;
+    /// mailbox state (0 = idle, 1 = request pending, 2 = reply ready)
+    std::atomic<uint32_t> nState;
+    Request oRequest;
+    Reply oReply;
+};
+
+BGSServiceControl::BGSServiceControl(const std::string& sServiceName, bool bCreate) :
+        m_pSegment(std::make_unique<lv::SharedMemorySegment>(sServiceName,sizeof(Header),bCreate)) {
+    if(bCreate) {
+        Header* pHeader = new(m_pSegment->data()) Header();
+        pHeader->bServiceAlive = 0;
+        pHeader->nClientLock = 0;
+        pHeader->nState = 0;
+        pHeader->nVersion = BGSSERVICE_SEGMENT_VERSION;
+        std::atomic_thread_fence(std::memory_order_release);
+        pHeader->nMagic = BGSSERVICE_SEGMENT_MAGIC;
+    }
+    else {
+        lvAssert__(m_pSegment->size()>=sizeof(Header) && getHeader().nMagic==BGSSERVICE_SEGMENT_MAGIC,"segment '%s' is not a service control segment",sServiceName.c_str());
+        std::atomic_thread_fence(std::memory_order_acquire);
+        lvAssert__(getHeader().nVersion==BGSSERVICE_SEGMENT_VERSION,"service '%s' version mismatch",sServiceName.c_str());
+    }
+}
+
+BGSServiceControl::Reply BGSServiceControl::call(const Request& oRequest, double dTimeout) {
+    Header& oHeader = getHeader();
+    lvAssert_(oHeader.bServiceAlive.load(),"service is not running");
+    const auto tDeadline = std::chrono::steady_clock::now()+std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(dTimeout));
+    const auto lWaitStep = [&]() {
+        lvAssert_(std::chrono::steady_clock::now()<tDeadline,"timed out waiting for the service");
+        std::this_thread::sleep_for(std::chrono::microseconds(BGSSERVICE_IDLE_SLEEP_USEC));
+    };
+    uint32_t nExpectedLock = 0;
+    while(!oHeader.nClientLock.compare_exchange_weak(nExpectedLock,1,std::memory_order_acquire)) {
+        nExpectedLock = 0;
+        lWaitStep();
+    }
+    try {
+        oHeader.oRequest = oRequest;
+        oHeader.nState.store(1,std::memory_order_release);
+        while(oHeader.nState.load(std::memory_order_acquire)!=2) {
+            try {
+                lWaitStep();
+            }
+            catch(...) {
+                // cancels the request, unless the service replied in the meantime
+                uint32_t nExpectedState = 1;
+                if(!oHeader.nState.compare_exchange_strong(nExpectedState,0))
+                    oHeader.nState.store(0);
+                throw;
+            }
+        }
+        const Reply oReply = oHeader.oReply;
+        oHeader.nState.store(0,std::memory_order_relaxed);
+        oHeader.nClientLock.store(0,std::memory_order_release);
+        return oReply;
+    }
+    catch(...) {
+        oHeader.nClientLock.store(0,std::memory_order_release);
+        throw;
+    }
+}
+
+bool BGSServiceControl::getPendingRequest(Request& oRequest) const {
+    const Header& oHeader = getHeader();
+    if(oHeader.nState.load(std::memory_order_acquire)!=1)
+        return false;
+    oRequest = oHeader.oRequest;
+    return true;
+}
+
+void BGSServiceControl::reply(const Reply& oReply) {
+    Header& oHeader = getHeader();
+    oHeader.oReply = oReply;
+    // the request may have been cancelled by a client timeout in the meantime, in which case the reply is dropped
+    uint32_t nExpectedState = 1;
+    oHeader.nState.compare_exchange_strong(nExpectedState,2,std::memory_order_acq_rel);
+}
+
+void BGSServiceControl::setServiceAlive(bool bAlive) {
+    getHeader().bServiceAlive.store(bAlive?1:0);
+}
+
+std::string BGSServiceControl::getStreamSegmentName(const std::string& sServiceName, size_t nStreamID) {
+    return sServiceName+"_stream"+std::to_string(nStreamID);
+}
+
+BGSServiceControl::Header& BGSServiceControl::getHeader() const {
+    return *reinterpret_cast<Header*>(m_pSegment->data());
+}
+
+BackgroundSubtractorServiceClient::BackgroundSubtractorServiceClient(const std::string& sServiceName, double dRequestTimeout) :
+        m_sServiceName(sServiceName),
+        m_dRequestTimeout(dRequestTimeout),
+        m_oControl(sServiceName,false) {
+    lvAssert_(dRequestTimeout>0,"request timeout must be positive");
+}
+
+size_t BackgroundSubtractorServiceClient::createStream(const cv::Size& oFrameSize, int nFrameType, size_t nSlots, const std::string& sSnapshotPath) {
+    lvAssert_(sSnapshotPath.size()<BGSSERVICE_MAX_STRING_LENGTH,"snapshot path is too long");
+    BGSServiceControl::Request oRequest = {};
+    oRequest.eCommand = BGSServiceCommand_CreateStream;
+    oRequest.nRows = oFrameSize.height;
+    oRequest.nCols = oFrameSize.width;
+    oRequest.nFrameType = nFrameType;
+    oRequest.nSlots = (uint32_t)nSlots;
+    std::copy(sSnapshotPath.begin(),sSnapshotPath.end(),oRequest.acPath);
+    const size_t nStreamID = call(oRequest).nStreamID;
+    m_mpStreamRings[nStreamID] = std::make_unique<BGSFrameRing>(BGSServiceControl::getStreamSegmentName(m_sServiceName,nStreamID));
+    return nStreamID;
+}
+
+void BackgroundSubtractorServiceClient::destroyStream(size_t nStreamID) {
+    lvAssert__(m_mpStreamRings.erase(nStreamID)==1,"unknown stream id (%d)",(int)nStreamID);
+    BGSServiceControl::Request oRequest = {};
+    oRequest.eCommand = BGSServiceCommand_DestroyStream;
+    oRequest.nStreamID = (uint32_t)nStreamID;
+    call(oRequest);
+}
+
+void BackgroundSubtractorServiceClient::snapshotStream(size_t nStreamID, const std::string& sSnapshotPath) {
+    lvAssert_(!sSnapshotPath.empty() && sSnapshotPath.size()<BGSSERVICE_MAX_STRING_LENGTH,"snapshot path must be non-empty, and not too long");
+    BGSServiceControl::Request oRequest = {};
+    oRequest.eCommand = BGSServiceCommand_SnapshotStream;
+    oRequest.nStreamID = (uint32_t)nStreamID;
+    std::copy(sSnapshotPath.begin(),sSnapshotPath.end(),oRequest.acPath);
+    call(oRequest);
+}
+
+BGSFrameRing& BackgroundSubtractorServiceClient::getStreamRing(size_t nStreamID) {
+    auto pRingIter = m_mpStreamRings.find(nStreamID);
+    lvAssert__(pRingIter!=m_mpStreamRings.end(),"unknown stream id (%d)",(int)nStreamID);
+    return *pRingIter->second;
+}
+
+BGSServiceControl::Reply BackgroundSubtractorServiceClient::call(const BGSServiceControl::Request& oRequest) {
+    const BGSServiceControl::Reply oReply = m_oControl.call(oRequest,m_dRequestTimeout);
+    lvAssert__(oReply.bSuccess,"service request failed: %s",std::string(oReply.acMessage,strnlen(oReply.acMessage,BGSSERVICE_MAX_STRING_LENGTH)).c_str());
+    return oReply;
+}
@@ -17,6 +17,86 @@
 
 #include "litiv/video/BackgroundSubtractionUtils.hpp"
 
+// local define used to identify model snapshot streams
+#define MODEL_SNAPSHOT_MAGIC "LVBGSMDL"
+// local define used to specify the current model snapshot format version (must be bumped when any impl changes its state layout)
+#define MODEL_SNAPSHOT_VERSION (5)
+// local define used to specify the row count of the strips processed at once in the fused post-processing chain
+#define FUSED_POSTPROC_STRIP_ROWS (64)
+// local define used to specify the (per-channel) color range sigma used for joint bilateral FG mask upsampling
+#define UPSCALE_RANGE_SIGMA (12.0f)
+// local define used to specify the scale factor between 16-bit input intensities and the 8-bit guide images used for FG mask upsampling
+#define UPSCALE_16BIT_GUIDE_SCALE (256)
+// local define used to specify the fixed-point precision of the (BT.601, limited range) YUV to BGR conversion coefficients
+#define YUV2BGR_SHIFT (20)
+// local define used to specify the moving average factor of the 'apply' times measured by the governor
+#define GOVERNOR_AVG_FACTOR (0.1)
+// local define used to specify the min number of frames between a governor level change and a downgrade
+#define GOVERNOR_MIN_DOWNGRADE_DELAY (8)
+// local define used to specify the initial (and max) number of frames between a governor level change and an upgrade
+#define GOVERNOR_MIN_UPGRADE_DELAY (60)
+#define GOVERNOR_MAX_UPGRADE_DELAY (1920)
+// local define used to specify the fraction of the frame time budget under which the governor considers it has headroom
+#define GOVERNOR_HEADROOM_RATIO (0.6)
+// local define used to specify the factor applied to the change gate noise floor to obtain the tile change threshold, and the threshold's lower bound (mean abs difference per channel)
+#define CHANGE_GATE_NOISE_FLOOR_FACTOR (2.0)
+#define CHANGE_GATE_MIN_THRESHOLD (2.0)
+// local define used to specify the moving average factor of the change gate noise floor
+#define CHANGE_GATE_NOISE_AVG_FACTOR (0.05)
+
+namespace {
+
+    /// governor quality levels, from full quality to the cheapest setup (the last one rescales, and is only used if allowed)
+    const std::array<IIBackgroundSubtractor::QualityKnobs,6> s_aoGovernorLevels = {{
+        {1.00,false,INT_MAX,1.0,1.0},
+        {0.75,false,INT_MAX,1.0,1.0},
+        {0.75,true,5,1.0,1.0},
+        {0.50,true,5,2.0,1.0},
+        {0.50,true,3,4.0,1.0},
+        {0.50,true,3,4.0,0.5},
+    }};
+
+    /// returns the sum of absolute differences between two byte arrays
+    inline uint64_t sumAbsDiff_8u(const uchar* anA, const uchar* anB, size_t nBytes) {
+        uint64_t nSAD = 0;
+        size_t nIdx = 0;
+#if HAVE_NEON
+        uint32x4_t _anSAD = vdupq_n_u32(0);
+        for(; nIdx+16<=nBytes; nIdx+=16)
+            _anSAD = vpadalq_u16(_anSAD,vpaddlq_u8(vabdq_u8(vld1q_u8(anA+nIdx),vld1q_u8(anB+nIdx))));
+        nSAD += uint64_t(vgetq_lane_u32(_anSAD,0))+vgetq_lane_u32(_anSAD,1)+vgetq_lane_u32(_anSAD,2)+vgetq_lane_u32(_anSAD,3);
+#elif HAVE_SSE2
+        __m128i _anSAD = _mm_setzero_si128();
+        for(; nIdx+16<=nBytes; nIdx+=16)
+            _anSAD = _mm_add_epi64(_anSAD,_mm_sad_epu8(_mm_loadu_si128((const __m128i*)(anA+nIdx)),_mm_loadu_si128((const __m128i*)(anB+nIdx))));
+        nSAD += uint64_t(_mm_cvtsi128_si32(_anSAD))+uint64_t(_mm_cvtsi128_si32(_mm_srli_si128(_anSAD,8)));
+#endif //HAVE_SSE2
+        for(; nIdx<nBytes; ++nIdx)
+            nSAD += (uint64_t)std::abs(int(anA[nIdx])-int(anB[nIdx]));
+        return nSAD;
+    }
+
+} // anonymous namespace
+
+void BGSInstrumentation::reset() {
+    m_adStageTimes.fill(0.0);
+    m_anCounters.fill(0);
+}
+
+const char* BGSInstrumentation::getStageName(Stage eStage) {
+    static const std::array<const char*,nStageCount> s_asStageNames = {"pixel_loop","post_proc","motion_analysis","total"};
+    lvAssert_(eStage<nStageCount,"stage index out of range");
+    return s_asStageNames[eStage];
+}
+
+void IIBackgroundSubtractor::setInstrumentation(bool bEnabled) {
+#if USE_BGS_INSTRUMENTATION
+    m_bUsingInstrumentation = bEnabled;
+#else //(!USE_BGS_INSTRUMENTATION)
+    lvIgnore(bEnabled);
+#endif //(!USE_BGS_INSTRUMENTATION)
+}
+
 void IIBackgroundSubtractor::initialize(const cv::Mat& oInitImg) {
     initialize(oInitImg,cv::Mat());
 }
@@ -25,6 +105,10 @@ void IIBackgroundSubtractor::setAutomaticModelReset(bool bVal) {
     m_bAutoModelResetEnabled = bVal;
 }
 
+void IIBackgroundSubtractor::setRandomSeed(uint64_t nSeed) {
+    m_oRNG.seed(nSeed);
+}
+
 void IIBackgroundSubtractor::validateROI(cv::Mat& oROI) const {
     lvAssert_(!oROI.empty() && oROI.type()==CV_8UC1,"provided ROI must be non-empty and of type 8UC1");
     if(m_nROIBorderSize>0) {
@@ -41,16 +125,860 @@ void IIBackgroundSubtractor::setROI(cv::Mat& oROI) {
     if(m_bInitialized) {
         cv::Mat oLatestBackgroundImage;
         getBackgroundImage(oLatestBackgroundImage);
+        if(m_dProcessingScale!=1.0) // initialize expects frames at input size
+            cv::resize(oLatestBackgroundImage,oLatestBackgroundImage,m_oInputSize,0,0,cv::INTER_LINEAR);
+        // the background image is already decoded, so the input format is bypassed for this initialization only
+        const InputFormat eInputFormat = m_eInputFormat;
+        m_eInputFormat = InputFormat_Default;
         initialize(oLatestBackgroundImage,oROI);
+        m_eInputFormat = eInputFormat;
     }
     else
         m_oROI = oROI.clone();
 }
 
+void IIBackgroundSubtractor::updateROI(cv::Mat& oROI) {
+    validateROI(oROI);
+    lvAssert_(cv::countNonZero(oROI)>0,"provided ROI must have at least one valid pixel");
+    if(!m_bInitialized) {
+        m_oROI = oROI.clone();
+        return;
+    }
+    lvAssert_(oROI.size()==m_oInputSize && oROI.type()==CV_8UC1,"provided ROI mat size must be equal to the input frame size, and its type must be 8UC1");
+    lvAssert_(cv::countNonZero((oROI<UCHAR_MAX)&(oROI>0))==0,"provided ROI mat values must be 0 or 255 only");
+    cv::Mat oNewBGROI;
+    if(m_dProcessingScale!=1.0)
+        cv::resize(oROI,oNewBGROI,m_oImgSize,0,0,cv::INTER_NEAREST);
+    else
+        oNewBGROI = oROI.clone();
+    // internal ROI is built exactly as in 'initialize_common' (border pixels are flagged as UCHAR_MAX/2)
+    cv::Mat oTempROI;
+    cv::dilate(oNewBGROI,oTempROI,cv::Mat(),cv::Point(-1,-1),(int)m_nROIBorderSize);
+    cv::bitwise_or(oNewBGROI,oTempROI/2,oNewBGROI);
+    const size_t nOrigROIPxCount = (size_t)cv::countNonZero(oNewBGROI);
+    validateROI(oNewBGROI);
+    lvAssert_(cv::countNonZero(oNewBGROI)>0,"provided ROI mat contains no useful pixels away from borders (descriptors will hit image bounds)");
+    if(!updateModelROI(oNewBGROI,nOrigROIPxCount))
+        setROI(oROI);
+}
+
+bool IIBackgroundSubtractor::updateModelROI(const cv::Mat&, size_t) {
+    return false;
+}
+
+void IIBackgroundSubtractor::setInternalROI(const cv::Mat& oNewROI, size_t nOrigROIPxCount) {
+    lvAssert_(oNewROI.size()==m_oImgSize && oNewROI.type()==CV_8UC1 && oNewROI.isContinuous(),"internal ROI must be a continuous 8UC1 mat of the model frame size");
+    m_oROI = oNewROI.clone();
+    m_nOrigROIPxCount = nOrigROIPxCount;
+    m_nFinalROIPxCount = (size_t)cv::countNonZero(m_oROI);
+    lvAssert_(m_nFinalROIPxCount>0,"provided ROI mat contains no useful pixels");
+    m_nTotRelevantPxCount = m_nFinalROIPxCount;
+    m_oROIBoundingRect = cv::boundingRect(m_oROI);
+    m_vnPxIdxLUT.resize(m_nTotRelevantPxCount);
+    m_voPxInfoLUT.resize(m_nTotPxCount);
+    for(size_t nPxIter=0, nModelIter=0; nPxIter<m_nTotPxCount; ++nPxIter) {
+        if(m_oROI.data[nPxIter]) {
+            m_vnPxIdxLUT[nModelIter] = nPxIter;
+            m_voPxInfoLUT[nPxIter].nImgCoord_Y = (int)nPxIter/m_oImgSize.width;
+            m_voPxInfoLUT[nPxIter].nImgCoord_X = (int)nPxIter%m_oImgSize.width;
+            m_voPxInfoLUT[nPxIter].nModelIdx = nModelIter;
+            ++nModelIter;
+        }
+    }
+}
+
+void IIBackgroundSubtractor::getAddedROIPxSources(const cv::Mat& oPrevROI, const cv::Mat& oNewROI, std::vector<std::pair<size_t,size_t>>& vAddedPxSources) const {
+    lvAssert_(oPrevROI.size()==m_oImgSize && oNewROI.size()==m_oImgSize && oPrevROI.isContinuous() && oNewROI.isContinuous(),"ROI mats must be continuous and of the model frame size");
+    vAddedPxSources.clear();
+    size_t nRemainingAddedPxCount = 0;
+    for(size_t nPxIter=0; nPxIter<m_nTotPxCount; ++nPxIter)
+        nRemainingAddedPxCount += (oNewROI.data[nPxIter] && !oPrevROI.data[nPxIter]);
+    if(nRemainingAddedPxCount==0)
+        return;
+    vAddedPxSources.reserve(nRemainingAddedPxCount);
+    // multi-source breadth-first search from all previous ROI pixels, stopped once every added pixel is reached
+    std::vector<size_t> vnSourcePxIdxs(m_nTotPxCount,SIZE_MAX), vnQueue;
+    vnQueue.reserve(m_nTotPxCount);
+    for(size_t nPxIter=0; nPxIter<m_nTotPxCount; ++nPxIter) {
+        if(oPrevROI.data[nPxIter]) {
+            vnSourcePxIdxs[nPxIter] = nPxIter;
+            vnQueue.push_back(nPxIter);
+        }
+    }
+    lvAssert_(!vnQueue.empty(),"previous ROI contains no pixels to initialize new ones from");
+    const int nRows = m_oImgSize.height, nCols = m_oImgSize.width;
+    for(size_t nQueueIter=0; nQueueIter<vnQueue.size() && nRemainingAddedPxCount>0; ++nQueueIter) {
+        const size_t nPxIter = vnQueue[nQueueIter];
+        const int nRowIdx = int(nPxIter/nCols), nColIdx = int(nPxIter%nCols);
+        for(int nOffsetY=-1; nOffsetY<=1; ++nOffsetY) {
+            for(int nOffsetX=-1; nOffsetX<=1; ++nOffsetX) {
+                const int nNeighbRowIdx = nRowIdx+nOffsetY, nNeighbColIdx = nColIdx+nOffsetX;
+                if(nNeighbRowIdx<0 || nNeighbRowIdx>=nRows || nNeighbColIdx<0 || nNeighbColIdx>=nCols)
+                    continue;
+                const size_t nNeighbPxIdx = size_t(nNeighbRowIdx*nCols+nNeighbColIdx);
+                if(vnSourcePxIdxs[nNeighbPxIdx]!=SIZE_MAX)
+                    continue;
+                vnSourcePxIdxs[nNeighbPxIdx] = vnSourcePxIdxs[nPxIter];
+                vnQueue.push_back(nNeighbPxIdx);
+                if(oNewROI.data[nNeighbPxIdx]) {
+                    vAddedPxSources.emplace_back(nNeighbPxIdx,vnSourcePxIdxs[nPxIter]);
+                    --nRemainingAddedPxCount;
+                }
+            }
+        }
+    }
+    lvDbgAssert(nRemainingAddedPxCount==0);
+    std::sort(vAddedPxSources.begin(),vAddedPxSources.end()); // keeps later per-pixel copies in raster order
+}
+
+void IIBackgroundSubtractor::copyAddedROIPxData(cv::Mat& oMap, const std::vector<std::pair<size_t,size_t>>& vAddedPxSources) {
+    if(oMap.empty())
+        return;
+    lvDbgAssert(oMap.isContinuous());
+    const size_t nElemSize = oMap.elemSize();
+    for(const auto& oAddedPx : vAddedPxSources)
+        std::copy_n(oMap.data+oAddedPx.second*nElemSize,nElemSize,oMap.data+oAddedPx.first*nElemSize);
+}
+
 cv::Mat IIBackgroundSubtractor::getROICopy() const {
     return m_oROI.clone();
 }
 
+void IIBackgroundSubtractor::setROICompactedProcessing(bool bEnabled) {
+    m_bUsingROICompactedProcessing = bEnabled;
+}
+
+cv::Rect IIBackgroundSubtractor::getPostProcessingRect(int nMargin) const {
+    const cv::Rect oFullRect(cv::Point(0,0),m_oImgSize);
+    if(!m_bUsingROICompactedProcessing)
+        return oFullRect;
+    lvDbgAssert(nMargin>=0);
+    return cv::Rect(m_oROIBoundingRect.x-nMargin,m_oROIBoundingRect.y-nMargin,m_oROIBoundingRect.width+nMargin*2,m_oROIBoundingRect.height+nMargin*2)&oFullRect;
+}
+
+cv::Mat IIBackgroundSubtractor::getScratchBuffer(ScratchBufferSlot eSlot, const cv::Size& oSize, int nType) {
+    // buffers only grow, so that interleaving streams of different sizes on one worker thread does not cause reallocations
+    thread_local std::array<cv::Mat,nScratchBufferCount> s_aoScratchBuffers;
+    lvDbgAssert(eSlot<nScratchBufferCount && oSize.width>0 && oSize.height>0);
+    cv::Mat& oBuffer = s_aoScratchBuffers[eSlot];
+    if(oBuffer.type()!=nType || oBuffer.rows<oSize.height || oBuffer.cols<oSize.width)
+        oBuffer.create(std::max(oBuffer.rows,oSize.height),std::max(oBuffer.cols,oSize.width),nType);
+    return oBuffer(cv::Rect(cv::Point(0,0),oSize));
+}
+
+void IIBackgroundSubtractor::setFusedPostProcessing(bool bEnabled) {
+    m_bUsingFusedPostProcessing = bEnabled;
+}
+
+void IIBackgroundSubtractor::setBlobOutput(bool bEnabled, bool bWithLabelMap) {
+    m_bUsingBlobOutput = bEnabled;
+    m_bUsingBlobLabelMap = bEnabled && bWithLabelMap;
+    if(!m_bUsingBlobOutput)
+        m_voLastBlobs.clear();
+    if(!m_bUsingBlobLabelMap)
+        m_oLastBlobLabels.release();
+}
+
+void IIBackgroundSubtractor::setTemporalDecimation(bool bEnabled, double dNominalFrameInterval, size_t nUpdateStride) {
+    lvAssert_(dNominalFrameInterval>0.0,"nominal frame interval must be positive");
+    lvAssert_(nUpdateStride>0,"model update stride must be positive");
+    m_bUsingTemporalDecimation = bEnabled;
+    m_dNominalFrameInterval = dNominalFrameInterval;
+    m_nDecimationUpdateStride = nUpdateStride;
+}
+
+void IIBackgroundSubtractor::setChangeGating(bool bEnabled, size_t nTileSize, size_t nRefreshRate) {
+    lvAssert_(nTileSize>=16 && (nTileSize&(nTileSize-1))==0,"change gate tile size must be a power of two, and at least 16");
+    lvAssert_(nRefreshRate>0,"change gate refresh rate must be positive");
+    m_bUsingChangeGating = bEnabled;
+    m_nChangeGateTileSizeBits = 0;
+    while((size_t(1)<<m_nChangeGateTileSizeBits)<nTileSize)
+        ++m_nChangeGateTileSizeBits;
+    m_nChangeGateRefreshRate = nRefreshRate;
+}
+
+double IIBackgroundSubtractor::getLastChangedTileFraction() const {
+    return m_oChangeGateTileMask.empty()?1.0:double(m_nChangeGateChangedTiles)/m_oChangeGateTileMask.total();
+}
+
+bool IIBackgroundSubtractor::updateChangeGate(const cv::Mat& oInputImg) {
+    if(m_oChangeGateRefFrame.empty())
+        return false; // disabled at init, or 16-bit input
+    lvDbgAssert(oInputImg.size()==m_oChangeGateRefFrame.size() && oInputImg.type()==m_oChangeGateRefFrame.type() && oInputImg.isContinuous());
+    const size_t nTileSize = size_t(1)<<m_nChangeGateTileSizeBits;
+    const size_t nCols = size_t(oInputImg.cols), nRows = size_t(oInputImg.rows);
+    const size_t nPxBytes = oInputImg.elemSize();
+    const size_t nTileCols = size_t(m_oChangeGateTileMask.cols);
+    const double dThreshold = std::max(CHANGE_GATE_MIN_THRESHOLD,CHANGE_GATE_NOISE_FLOOR_FACTOR*m_dChangeGateNoiseFloor);
+    double dUnchangedDiffSum = 0.0;
+    size_t nUnchangedTiles = 0;
+    m_nChangeGateChangedTiles = 0;
+    m_vnChangeGateTileSADs.resize(nTileCols);
+    for(size_t nTileRowIdx=0; nTileRowIdx<size_t(m_oChangeGateTileMask.rows); ++nTileRowIdx) {
+        const size_t nRowBegin = nTileRowIdx*nTileSize, nRowEnd = std::min(nRowBegin+nTileSize,nRows);
+        std::fill(m_vnChangeGateTileSADs.begin(),m_vnChangeGateTileSADs.end(),uint64_t(0));
+        for(size_t nRowIdx=nRowBegin; nRowIdx<nRowEnd; ++nRowIdx) {
+            const uchar* const anInputRow = oInputImg.ptr<uchar>(int(nRowIdx));
+            const uchar* const anRefRow = m_oChangeGateRefFrame.ptr<uchar>(int(nRowIdx));
+            for(size_t nTileColIdx=0; nTileColIdx<nTileCols; ++nTileColIdx) {
+                const size_t nColBegin = nTileColIdx*nTileSize, nColEnd = std::min(nColBegin+nTileSize,nCols);
+                m_vnChangeGateTileSADs[nTileColIdx] += sumAbsDiff_8u(anInputRow+nColBegin*nPxBytes,anRefRow+nColBegin*nPxBytes,(nColEnd-nColBegin)*nPxBytes);
+            }
+        }
+        uchar* const anTileMaskRow = m_oChangeGateTileMask.ptr<uchar>(int(nTileRowIdx));
+        for(size_t nTileColIdx=0; nTileColIdx<nTileCols; ++nTileColIdx) {
+            const size_t nColBegin = nTileColIdx*nTileSize, nColEnd = std::min(nColBegin+nTileSize,nCols);
+            const double dMeanDiff = double(m_vnChangeGateTileSADs[nTileColIdx])/((nRowEnd-nRowBegin)*(nColEnd-nColBegin)*nPxBytes);
+            anTileMaskRow[nTileColIdx] = uchar(dMeanDiff>dThreshold);
+            if(anTileMaskRow[nTileColIdx]) {
+                // changed tiles are fully segmented in this frame, so they become the new reference for their content
+                for(size_t nRowIdx=nRowBegin; nRowIdx<nRowEnd; ++nRowIdx)
+                    std::copy_n(oInputImg.ptr<uchar>(int(nRowIdx))+nColBegin*nPxBytes,(nColEnd-nColBegin)*nPxBytes,m_oChangeGateRefFrame.ptr<uchar>(int(nRowIdx))+nColBegin*nPxBytes);
+                ++m_nChangeGateChangedTiles;
+            }
+            else {
+                dUnchangedDiffSum += dMeanDiff;
+                ++nUnchangedTiles;
+            }
+        }
+    }
+    if(nUnchangedTiles)
+        m_dChangeGateNoiseFloor += CHANGE_GATE_NOISE_AVG_FACTOR*(dUnchangedDiffSum/nUnchangedTiles-m_dChangeGateNoiseFloor);
+    return m_nChangeGateChangedTiles<m_oChangeGateTileMask.total();
+}
+
+void IIBackgroundSubtractor::applyPacked(cv::InputArray oImage, lv::PackedBinaryMask& oFGMask, double dLearningRate) {
+    apply(oImage,m_oUnpackedFGMask,dLearningRate);
+    oFGMask.pack(m_oUnpackedFGMask);
+}
+
+void IIBackgroundSubtractor::applyTimestamped(cv::InputArray oImage, cv::OutputArray oFGMask, double dTimestamp, double dLearningRate) {
+    lvAssert_(m_bInitialized && m_bModelInitialized,"algo & model must be initialized first");
+    if(!m_bUsingTemporalDecimation) {
+        apply(oImage,oFGMask,dLearningRate);
+        m_dLastFrameTimestamp = m_dLastUpdateTimestamp = dTimestamp;
+        return;
+    }
+    const bool bFirstFrame = std::isnan(m_dLastFrameTimestamp);
+    lvAssert_(bFirstFrame || dTimestamp>m_dLastFrameTimestamp,"frame timestamps must be strictly increasing");
+    const auto lGetElapsedFrames = [&](double dLastTimestamp) {
+        return bFirstFrame?size_t(1):std::max(size_t(1),(size_t)std::round((dTimestamp-dLastTimestamp)/m_dNominalFrameInterval));
+    };
+    const size_t nElapsedFrames = lGetElapsedFrames(m_dLastFrameTimestamp);
+    // the frame counter must still account for all nominal frames (used in moving average warmups, word weights, etc.)
+    m_nFrameIdx += nElapsedFrames-1;
+    const bool bUpdatingModel = bFirstFrame || ++m_nFramesSinceLastUpdate>=m_nDecimationUpdateStride;
+    // moving averages are still updated in classify-only frames, so they only compensate for the frames since the last call
+    m_nCurrFrameStride = nElapsedFrames;
+    if(bUpdatingModel) {
+        // model updates must compensate for all nominal frames since the last update (not only since the last frame)
+        m_nCurrUpdateStride = lGetElapsedFrames(m_dLastUpdateTimestamp);
+        m_nFramesSinceLastUpdate = 0;
+        m_dLastUpdateTimestamp = dTimestamp;
+        const double dBaseLearningRate = dLearningRate>0?dLearningRate:getDefaultLearningRate();
+        if(dBaseLearningRate>0 && !std::isinf(dBaseLearningRate))
+            dLearningRate = getCompensatedLearningRate(dBaseLearningRate);
+    }
+    else {
+        m_nCurrUpdateStride = 1;
+        dLearningRate = (double)UINT_MAX; // finite 'never update' override (not all impls support infinite rates)
+    }
+    m_dLastFrameTimestamp = dTimestamp;
+    apply(oImage,oFGMask,dLearningRate);
+    m_nCurrFrameStride = 1;
+    m_nCurrUpdateStride = 1;
+}
+
+float IIBackgroundSubtractor::getCompensatedRollAvgFactor(float fRollAvgFactor) const {
+    lvDbgAssert(fRollAvgFactor>=0.0f && fRollAvgFactor<=1.0f);
+    if(m_nCurrFrameStride<=1)
+        return fRollAvgFactor;
+    return 1.0f-std::pow(1.0f-fRollAvgFactor,(float)m_nCurrFrameStride);
+}
+
+double IIBackgroundSubtractor::getCompensatedLearningRate(double dLearningRate) const {
+    lvDbgAssert(dLearningRate>0);
+    if(m_nCurrUpdateStride<=1 || std::isinf(dLearningRate) || dLearningRate<=1.0)
+        return dLearningRate;
+    // probability of at least one update over the covered frames, converted back to a 1/N rate
+    return std::max(1.0,1.0/(1.0-std::pow(1.0-1.0/dLearningRate,(double)m_nCurrUpdateStride)));
+}
+
+void IIBackgroundSubtractor::setProcessingScale(double dScale) {
+    lvAssert_(dScale>0.0 && dScale<=1.0,"processing scale must be in ]0,1]");
+    m_dProcessingScale = dScale;
+}
+
+double IIBackgroundSubtractor::getProcessingScale() const {
+    return m_dProcessingScale;
+}
+
+size_t IIBackgroundSubtractor::getGovernorLevelCount() {
+    return s_aoGovernorLevels.size();
+}
+
+void IIBackgroundSubtractor::setGovernor(bool bEnabled, double dFrameTimeBudget, bool bAllowRescaling) {
+    lvAssert_(dFrameTimeBudget>0,"frame time budget must be positive");
+    m_bUsingGovernor = bEnabled;
+    m_dGovernorFrameTimeBudget = dFrameTimeBudget;
+    m_bGovernorRescalingAllowed = bAllowRescaling;
+    m_nGovernorUpgradeDelay = GOVERNOR_MIN_UPGRADE_DELAY;
+    m_bGovernorLastChangeWasUpgrade = false;
+    if(!bEnabled || (!bAllowRescaling && m_oQualityKnobs.dProcessingScaleFactor!=1.0))
+        setGovernorLevel(0); // rescaled levels are left on the next 'apply' call
+    m_nGovernorFramesSinceChange = 0;
+}
+
+void IIBackgroundSubtractor::setGovernorLevel(size_t nLevel) {
+    lvAssert_(nLevel<s_aoGovernorLevels.size(),"governor level out of range");
+    m_nGovernorLevel = nLevel;
+    m_oQualityKnobs = s_aoGovernorLevels[nLevel];
+    if(!m_bGovernorRescalingAllowed)
+        m_oQualityKnobs.dProcessingScaleFactor = 1.0;
+    m_nGovernorFramesSinceChange = 0;
+}
+
+size_t IIBackgroundSubtractor::getGovernedSampleCount(size_t nSamples, size_t nRequiredSamples) const {
+    lvDbgAssert(nRequiredSamples<=nSamples);
+    if(m_oQualityKnobs.dSampleFraction>=1.0)
+        return nSamples;
+    return std::max(std::max((size_t)std::round(nSamples*m_oQualityKnobs.dSampleFraction),nRequiredSamples),size_t(1));
+}
+
+void IIBackgroundSubtractor::updateGovernor(double dFrameTime) {
+    m_dGovernorAvgFrameTime = (m_nGovernorFramesSinceChange==0)?dFrameTime:(1-GOVERNOR_AVG_FACTOR)*m_dGovernorAvgFrameTime+GOVERNOR_AVG_FACTOR*dFrameTime;
+    const size_t nFramesSinceChange = ++m_nGovernorFramesSinceChange;
+    const size_t nMaxLevel = s_aoGovernorLevels.size()-(m_bGovernorRescalingAllowed?1:2);
+    if(m_dGovernorAvgFrameTime>m_dGovernorFrameTimeBudget && nFramesSinceChange>=GOVERNOR_MIN_DOWNGRADE_DELAY && m_nGovernorLevel<nMaxLevel) {
+        // upgrades that overload right away are retried later and later, so that the governor does not oscillate around the budget
+        if(m_bGovernorLastChangeWasUpgrade && nFramesSinceChange<m_nGovernorUpgradeDelay)
+            m_nGovernorUpgradeDelay = std::min(m_nGovernorUpgradeDelay*2,size_t(GOVERNOR_MAX_UPGRADE_DELAY));
+        setGovernorLevel(m_nGovernorLevel+1);
+        m_bGovernorLastChangeWasUpgrade = false;
+    }
+    else if(m_dGovernorAvgFrameTime<m_dGovernorFrameTimeBudget*GOVERNOR_HEADROOM_RATIO && nFramesSinceChange>=m_nGovernorUpgradeDelay && m_nGovernorLevel>0) {
+        setGovernorLevel(m_nGovernorLevel-1);
+        m_bGovernorLastChangeWasUpgrade = true;
+    }
+    else if(!m_bGovernorLastChangeWasUpgrade && nFramesSinceChange>=GOVERNOR_MAX_UPGRADE_DELAY)
+        m_nGovernorUpgradeDelay = GOVERNOR_MIN_UPGRADE_DELAY; // load went down for good, upgrades can be fast again
+}
+
+void IIBackgroundSubtractor::updateGovernorScale(const cv::Mat& oInputImg) {
+    if(m_oQualityKnobs.dProcessingScaleFactor==m_dGovernorAppliedScaleFactor)
+        return;
+    // the model is rebuilt from the current frame at the new processing size (the ROI is brought back to input size first)
+    const double dNewScale = std::min(m_dProcessingScale*m_oQualityKnobs.dProcessingScaleFactor/m_dGovernorAppliedScaleFactor,1.0);
+    m_dGovernorAppliedScaleFactor = m_oQualityKnobs.dProcessingScaleFactor;
+    cv::Mat oInputROI;
+    if(!m_oROI.empty())
+        cv::resize(m_oROI,oInputROI,m_oInputSize,0,0,cv::INTER_NEAREST);
+    m_dProcessingScale = dNewScale;
+    initialize(oInputImg,oInputROI);
+    m_nGovernorFramesSinceChange = 0;
+}
+
+IIBackgroundSubtractor::GovernorScope::GovernorScope(IIBackgroundSubtractor* pAlgo, cv::InputArray oImage) :
+        m_pAlgo(pAlgo),
+        m_oImage(oImage.getMat()) {}
+
+IIBackgroundSubtractor::GovernorScope::~GovernorScope() {
+    // frames that threw are not measured (and the model is left as-is)
+    if(std::uncaught_exception())
+        return;
+    try {
+        if(m_pAlgo->m_bUsingGovernor)
+            m_pAlgo->updateGovernor(m_oStopWatch.tock());
+        // rescaled levels are also left here once the governor is disabled
+        m_pAlgo->updateGovernorScale(m_oImage);
+    }
+    catch(...) {
+        m_pAlgo->m_bUsingGovernor = false;
+    }
+}
+
+void IIBackgroundSubtractor::setInputFormat(InputFormat eFormat, bool bLumaOnly) {
+    lvAssert_(!m_bInitialized,"input format must be set before initialization");
+    lvAssert_(eFormat==InputFormat_Default || eFormat==InputFormat_NV12 || eFormat==InputFormat_I420,"unknown input format");
+    m_eInputFormat = eFormat;
+    m_bUsingLumaOnlyInput = bLumaOnly;
+}
+
+void IIBackgroundSubtractor::setModelNUMANode(int nNUMANode) {
+    lvAssert_(nNUMANode>=-1 && nNUMANode<(int)lv::GetNUMANodeCount(),"NUMA node index out of range");
+    m_nRequestedModelNUMANode = nNUMANode;
+}
+
+int IIBackgroundSubtractor::getModelNUMANode() const {
+    return m_nModelNUMANode;
+}
+
+void IIBackgroundSubtractor::scaleInitData(const cv::Mat& oInitImg, const cv::Mat& oROI, cv::Mat& oScaledInitImg, cv::Mat& oScaledROI) {
+    lvAssert_(!oInitImg.empty(),"provided image for initialization must be non-empty");
+    if(m_eInputFormat!=InputFormat_Default) {
+        lvAssert_(oInitImg.type()==CV_8UC1 && oInitImg.isContinuous() && (oInitImg.rows%6)==0 && (oInitImg.cols%2)==0,"YUV 4:2:0 frames must be continuous 8UC1 mats with even luma plane dimensions");
+        m_oInputSize = cv::Size(oInitImg.cols,oInitImg.rows*2/3);
+    }
+    else
+        m_oInputSize = oInitImg.size();
+    if(m_dProcessingScale==1.0) {
+        oScaledInitImg = (m_eInputFormat!=InputFormat_Default)?decodeYUVInput(oInitImg,m_oInputSize,oScaledInitImg):oInitImg;
+        oScaledROI = oROI;
+        return;
+    }
+    const cv::Size oScaledSize(std::max((int)std::round(m_oInputSize.width*m_dProcessingScale),1),std::max((int)std::round(m_oInputSize.height*m_dProcessingScale),1));
+    if(m_eInputFormat!=InputFormat_Default)
+        oScaledInitImg = decodeYUVInput(oInitImg,oScaledSize,oScaledInitImg);
+    else
+        cv::resize(oInitImg,oScaledInitImg,oScaledSize,0,0,cv::INTER_AREA);
+    // a ROI set at input size before initialization is scaled as well (ROIs at processing size are reused as-is by initialize_common)
+    const cv::Mat& oInputROI = (oROI.empty() && m_oROI.size()==m_oInputSize)?m_oROI:oROI;
+    if(!oInputROI.empty()) {
+        lvAssert_(oInputROI.size()==m_oInputSize,"provided ROI mat size must be equal to the init frame size");
+        cv::resize(oInputROI,oScaledROI,oScaledSize,0,0,cv::INTER_NEAREST); // keeps binary values
+    }
+    else
+        oScaledROI = cv::Mat();
+}
+
+cv::Mat IIBackgroundSubtractor::getScaledInput(const cv::Mat& oInputImg) {
+    if(m_eInputFormat!=InputFormat_Default) {
+        lvAssert_(oInputImg.type()==CV_8UC1 && oInputImg.isContinuous() && oInputImg.size()==cv::Size(m_oInputSize.width,m_oInputSize.height*3/2),"YUV input frame type/size mismatch with initialization size");
+        return decodeYUVInput(oInputImg,m_oImgSize,m_oScaledInputFrame);
+    }
+    if(m_dProcessingScale==1.0)
+        return oInputImg;
+    lvAssert_(oInputImg.size()==m_oInputSize,"input image size mismatch with initialization size");
+    cv::resize(oInputImg,m_oScaledInputFrame,m_oImgSize,0,0,cv::INTER_AREA);
+    return m_oScaledInputFrame;
+}
+
+cv::Mat IIBackgroundSubtractor::decodeYUVInput(const cv::Mat& oInputImg, const cv::Size& oOutputSize, cv::Mat& oOutputImg) {
+    lvDbgAssert(m_eInputFormat!=InputFormat_Default && oInputImg.type()==CV_8UC1 && oInputImg.isContinuous());
+    const cv::Size oLumaSize(oInputImg.cols,oInputImg.rows*2/3);
+    const cv::Mat oLumaPlane = oInputImg.rowRange(0,oLumaSize.height); // stays continuous (full rows)
+    if(m_bUsingLumaOnlyInput) {
+        if(oOutputSize==oLumaSize)
+            return oLumaPlane; // zero-copy: the model directly reads the decoder's luma plane
+        cv::resize(oLumaPlane,oOutputImg,oOutputSize,0,0,cv::INTER_AREA);
+        return oOutputImg;
+    }
+    const bool bNV12 = (m_eInputFormat==InputFormat_NV12);
+    if(oOutputSize*2!=oLumaSize) {
+        if(oOutputSize==oLumaSize) {
+            cv::cvtColor(oInputImg,oOutputImg,bNV12?cv::COLOR_YUV2BGR_NV12:cv::COLOR_YUV2BGR_I420);
+            return oOutputImg;
+        }
+        cv::cvtColor(oInputImg,m_oDecodedInputFrame,bNV12?cv::COLOR_YUV2BGR_NV12:cv::COLOR_YUV2BGR_I420);
+        cv::resize(m_oDecodedInputFrame,oOutputImg,oOutputSize,0,0,cv::INTER_AREA);
+        return oOutputImg;
+    }
+    // half-size outputs match the chroma resolution: each output pixel averages its 2x2 luma block and uses its chroma sample as-is,
+    // so the full-size BGR frame is never materialized (same BT.601 limited range coefficients as cv::cvtColor)
+    static constexpr int s_nCY = 1220542, s_nCUB = 2116026, s_nCUG = -409993, s_nCVG = -852492, s_nCVR = 1673527;
+    static constexpr int s_nRoundOffset = 1<<(YUV2BGR_SHIFT-1);
+    oOutputImg.create(oOutputSize,CV_8UC3);
+    const uchar* const pnChromaData = oInputImg.data+oLumaSize.area();
+    const size_t nChromaPlaneSize = size_t(oOutputSize.area());
+    for(int nRowIdx=0; nRowIdx<oOutputSize.height; ++nRowIdx) {
+        const uchar* const pnLumaRow0 = oLumaPlane.ptr<uchar>(nRowIdx*2);
+        const uchar* const pnLumaRow1 = oLumaPlane.ptr<uchar>(nRowIdx*2+1);
+        const uchar* const pnURow = bNV12?(pnChromaData+nRowIdx*oLumaSize.width):(pnChromaData+nRowIdx*oOutputSize.width);
+        const uchar* const pnVRow = bNV12?(pnURow+1):(pnURow+nChromaPlaneSize);
+        const size_t nChromaStep = bNV12?2:1;
+        uchar* const pnOutputRow = oOutputImg.ptr<uchar>(nRowIdx);
+        for(int nColIdx=0; nColIdx<oOutputSize.width; ++nColIdx) {
+            const int nLuma = (pnLumaRow0[nColIdx*2]+pnLumaRow0[nColIdx*2+1]+pnLumaRow1[nColIdx*2]+pnLumaRow1[nColIdx*2+1]+2)/4;
+            const int nY = std::max(nLuma-16,0)*s_nCY, nU = int(pnURow[nColIdx*nChromaStep])-128, nV = int(pnVRow[nColIdx*nChromaStep])-128;
+            uchar* const anOutputColor = pnOutputRow+nColIdx*3;
+            anOutputColor[0] = cv::saturate_cast<uchar>((nY+s_nCUB*nU+s_nRoundOffset)>>YUV2BGR_SHIFT);
+            anOutputColor[1] = cv::saturate_cast<uchar>((nY+s_nCUG*nU+s_nCVG*nV+s_nRoundOffset)>>YUV2BGR_SHIFT);
+            anOutputColor[2] = cv::saturate_cast<uchar>((nY+s_nCVR*nV+s_nRoundOffset)>>YUV2BGR_SHIFT);
+        }
+    }
+    return oOutputImg;
+}
+
+cv::Mat IIBackgroundSubtractor::getScaledOutputMask(cv::OutputArray oFGMask) {
+    if(m_dProcessingScale==1.0) {
+        oFGMask.create(m_oImgSize,CV_8UC1);
+        return oFGMask.getMat();
+    }
+    m_oScaledFGMask.create(m_oImgSize,CV_8UC1);
+    return m_oScaledFGMask;
+}
+
+void IIBackgroundSubtractor::upscaleOutputMask(const cv::Mat& oScaledFGMask, cv::OutputArray _oFGMask, const cv::Mat& oInputImg) const {
+    if(m_dProcessingScale==1.0)
+        return;
+    const bool bYUVInput = (m_eInputFormat!=InputFormat_Default);
+    lvDbgAssert(oScaledFGMask.size()==m_oImgSize && oScaledFGMask.type()==CV_8UC1 && (bYUVInput || oInputImg.size()==m_oInputSize));
+    lvDbgAssert(m_oScaledInputFrame.size()==m_oImgSize && (bYUVInput || m_oScaledInputFrame.type()==oInputImg.type()));
+    _oFGMask.create(m_oInputSize,CV_8UC1);
+    cv::Mat oFGMask = _oFGMask.getMat();
+    // pixels whose bilinear neighborhood is uniform in the low-res mask are copied as-is; the others (mask borders) are decided by a vote of their
+    // 2x2 low-res neighbors weighted by bilinear distance & color similarity between the full-res pixel and the low-res neighbor (joint bilateral upsampling)
+    cv::resize(oScaledFGMask,oFGMask,m_oInputSize,0,0,cv::INTER_LINEAR);
+    // 16-bit inputs are compared at 8-bit precision (the range sigma is given in 8-bit units)
+    cv::Mat oGuideImg = oInputImg, oScaledGuideImg = m_oScaledInputFrame;
+    if(bYUVInput) {
+        // YUV inputs are guided by their luma plane only (full-size BGR frames are never materialized)
+        oGuideImg = oInputImg.rowRange(0,m_oInputSize.height);
+        if(!m_bUsingLumaOnlyInput)
+            cv::resize(oGuideImg,oScaledGuideImg,m_oImgSize,0,0,cv::INTER_AREA);
+    }
+    else if(oInputImg.depth()==CV_16U) {
+        oInputImg.convertTo(oGuideImg,CV_8U,1.0/UPSCALE_16BIT_GUIDE_SCALE);
+        m_oScaledInputFrame.convertTo(oScaledGuideImg,CV_8U,1.0/UPSCALE_16BIT_GUIDE_SCALE);
+    }
+    const int nChannels = oGuideImg.channels();
+    std::vector<float> vfRangeWeightLUT(size_t(UCHAR_MAX*nChannels+1));
+    for(size_t nDist=0; nDist<vfRangeWeightLUT.size(); ++nDist) {
+        const float fNormDist = (float)nDist/(UPSCALE_RANGE_SIGMA*nChannels);
+        vfRangeWeightLUT[nDist] = std::exp(-0.5f*fNormDist*fNormDist);
+    }
+    const float fScaleX = (float)m_oImgSize.width/m_oInputSize.width, fScaleY = (float)m_oImgSize.height/m_oInputSize.height;
+    for(int nRowIdx=0; nRowIdx<m_oInputSize.height; ++nRowIdx) {
+        uchar* pnMaskRow = oFGMask.ptr<uchar>(nRowIdx);
+        const uchar* pnInputRow = oGuideImg.ptr<uchar>(nRowIdx);
+        const float fLowResY = std::max((nRowIdx+0.5f)*fScaleY-0.5f,0.0f);
+        const int nLowResY0 = std::min((int)fLowResY,m_oImgSize.height-1), nLowResY1 = std::min(nLowResY0+1,m_oImgSize.height-1);
+        const float fWeightY1 = std::min(fLowResY-nLowResY0,1.0f);
+        for(int nColIdx=0; nColIdx<m_oInputSize.width; ++nColIdx) {
+            if(pnMaskRow[nColIdx]==0 || pnMaskRow[nColIdx]==UCHAR_MAX)
+                continue;
+            const float fLowResX = std::max((nColIdx+0.5f)*fScaleX-0.5f,0.0f);
+            const int nLowResX0 = std::min((int)fLowResX,m_oImgSize.width-1), nLowResX1 = std::min(nLowResX0+1,m_oImgSize.width-1);
+            const float fWeightX1 = std::min(fLowResX-nLowResX0,1.0f);
+            const uchar* const anCurrColor = pnInputRow+nColIdx*nChannels;
+            float fFGWeight = 0.0f, fTotWeight = 0.0f;
+            for(int nNeighbIdx=0; nNeighbIdx<4; ++nNeighbIdx) {
+                const int nLowResY = (nNeighbIdx&2)?nLowResY1:nLowResY0, nLowResX = (nNeighbIdx&1)?nLowResX1:nLowResX0;
+                const float fSpatialWeight = ((nNeighbIdx&2)?fWeightY1:1.0f-fWeightY1)*((nNeighbIdx&1)?fWeightX1:1.0f-fWeightX1);
+                const uchar* const anNeighbColor = oScaledGuideImg.ptr<uchar>(nLowResY)+nLowResX*nChannels;
+                size_t nColorDist = 0;
+                for(int c=0; c<nChannels; ++c)
+                    nColorDist += (size_t)std::abs((int)anCurrColor[c]-(int)anNeighbColor[c]);
+                const float fWeight = fSpatialWeight*vfRangeWeightLUT[nColorDist];
+                fTotWeight += fWeight;
+                if(oScaledFGMask.at<uchar>(nLowResY,nLowResX))
+                    fFGWeight += fWeight;
+            }
+            pnMaskRow[nColIdx] = (fTotWeight>std::numeric_limits<float>::epsilon())?((fFGWeight*2>fTotWeight)?UCHAR_MAX:0):((pnMaskRow[nColIdx]>UCHAR_MAX/2)?UCHAR_MAX:0);
+        }
+    }
+}
+
+void IIBackgroundSubtractor::FGBlobLabeler::reset(const cv::Size& oSize, cv::Mat* pLabelMap) {
+    lvDbgAssert(oSize.area()>0 && (!pLabelMap || (pLabelMap->type()==CV_32SC1 && pLabelMap->size()==oSize)));
+    m_oSize = oSize;
+    m_nNextRow = 0;
+    if(pLabelMap)
+        m_oLabelMap = *pLabelMap;
+    else {
+        m_oLabelMap.release();
+        for(auto& vnRowLabels : m_avnRowLabels)
+            vnRowLabels.resize((size_t)oSize.width);
+    }
+    // label #0 is reserved for BG pixels, and is never united with anything
+    m_vnParents.assign(1,0);
+    m_voStats.assign(1,BlobStats{0,0,0,0,0});
+}
+
+int IIBackgroundSubtractor::FGBlobLabeler::findRoot(int nLabel) {
+    while(m_vnParents[nLabel]!=nLabel)
+        nLabel = m_vnParents[nLabel] = m_vnParents[m_vnParents[nLabel]]; // path halving
+    return nLabel;
+}
+
+int IIBackgroundSubtractor::FGBlobLabeler::unite(int nLabelA, int nLabelB) {
+    const int nRootA = findRoot(nLabelA), nRootB = findRoot(nLabelB);
+    // the smallest root is always kept, so that roots remain the first label assigned in raster order
+    const int nRoot = std::min(nRootA,nRootB);
+    m_vnParents[nRootA] = m_vnParents[nRootB] = nRoot;
+    return nRoot;
+}
+
+void IIBackgroundSubtractor::FGBlobLabeler::processRows(const cv::Mat& oFGMask, int nRowBegin, int nRowEnd) {
+    lvDbgAssert(oFGMask.type()==CV_8UC1 && oFGMask.size()==m_oSize && nRowBegin==m_nNextRow && nRowEnd<=m_oSize.height);
+    const int nCols = m_oSize.width;
+    for(int nRowIdx=nRowBegin; nRowIdx<nRowEnd; ++nRowIdx) {
+        const uchar* pnMaskRow = oFGMask.ptr<uchar>(nRowIdx);
+        int* pnCurrLabels = m_oLabelMap.empty()?m_avnRowLabels[nRowIdx%2].data():m_oLabelMap.ptr<int>(nRowIdx);
+        const int* pnPrevLabels = (nRowIdx==0)?nullptr:m_oLabelMap.empty()?m_avnRowLabels[(nRowIdx+1)%2].data():m_oLabelMap.ptr<int>(nRowIdx-1);
+        for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
+            if(!pnMaskRow[nColIdx]) {
+                pnCurrLabels[nColIdx] = 0;
+                continue;
+            }
+            // 8-connectivity only requires the left neighbor & the three neighbors of the previous row
+            int nLabel = (nColIdx>0)?pnCurrLabels[nColIdx-1]:0;
+            if(pnPrevLabels) {
+                const int nColBegin = std::max(nColIdx-1,0), nColEnd = std::min(nColIdx+2,nCols);
+                for(int nNeighbColIdx=nColBegin; nNeighbColIdx<nColEnd; ++nNeighbColIdx)
+                    if(pnPrevLabels[nNeighbColIdx])
+                        nLabel = nLabel?unite(nLabel,pnPrevLabels[nNeighbColIdx]):pnPrevLabels[nNeighbColIdx];
+            }
+            if(!nLabel) {
+                nLabel = (int)m_vnParents.size();
+                m_vnParents.push_back(nLabel);
+                m_voStats.push_back(BlobStats{nColIdx,nRowIdx,nColIdx,nRowIdx,0});
+            }
+            pnCurrLabels[nColIdx] = nLabel;
+            BlobStats& oStats = m_voStats[nLabel];
+            oStats.nMinX = std::min(oStats.nMinX,nColIdx);
+            oStats.nMaxX = std::max(oStats.nMaxX,nColIdx);
+            oStats.nMaxY = nRowIdx; // rows are fed in order
+            ++oStats.nArea;
+        }
+    }
+    m_nNextRow = nRowEnd;
+}
+
+void IIBackgroundSubtractor::FGBlobLabeler::finalize(std::vector<FGBlob>& voBlobs, const cv::Point& oOffset, double dScale, const cv::Size& oFullSize) {
+    lvDbgAssert(m_nNextRow==m_oSize.height && dScale>0.0);
+    const int nLabels = (int)m_vnParents.size();
+    m_vnBlobIdxs.assign((size_t)nLabels,0);
+    voBlobs.clear();
+    // roots are always the smallest label of their set, so they are met before their children, and blobs come out in raster order
+    for(int nLabel=1; nLabel<nLabels; ++nLabel) {
+        const int nRoot = findRoot(nLabel);
+        if(nRoot==nLabel) {
+            m_vnBlobIdxs[nLabel] = (int)voBlobs.size();
+            voBlobs.emplace_back();
+        }
+        else {
+            m_vnBlobIdxs[nLabel] = m_vnBlobIdxs[nRoot];
+            BlobStats& oRootStats = m_voStats[nRoot];
+            const BlobStats& oStats = m_voStats[nLabel];
+            oRootStats.nMinX = std::min(oRootStats.nMinX,oStats.nMinX);
+            oRootStats.nMinY = std::min(oRootStats.nMinY,oStats.nMinY);
+            oRootStats.nMaxX = std::max(oRootStats.nMaxX,oStats.nMaxX);
+            oRootStats.nMaxY = std::max(oRootStats.nMaxY,oStats.nMaxY);
+            oRootStats.nArea += oStats.nArea;
+        }
+    }
+    const double dInvScale = 1.0/dScale;
+    const cv::Rect oFullRect(cv::Point(0,0),oFullSize);
+    for(int nLabel=1; nLabel<nLabels; ++nLabel) {
+        if(m_vnParents[nLabel]!=nLabel)
+            continue;
+        const BlobStats& oStats = m_voStats[nLabel];
+        const cv::Point oTL((int)std::floor((oStats.nMinX+oOffset.x)*dInvScale),(int)std::floor((oStats.nMinY+oOffset.y)*dInvScale));
+        const cv::Point oBR((int)std::ceil((oStats.nMaxX+oOffset.x+1)*dInvScale),(int)std::ceil((oStats.nMaxY+oOffset.y+1)*dInvScale));
+        FGBlob& oBlob = voBlobs[m_vnBlobIdxs[nLabel]];
+        oBlob.oBBox = cv::Rect(oTL,oBR)&oFullRect;
+        oBlob.nArea = (dScale==1.0)?oStats.nArea:(size_t)std::round(oStats.nArea*dInvScale*dInvScale);
+    }
+    if(!m_oLabelMap.empty()) {
+        for(int nRowIdx=0; nRowIdx<m_oSize.height; ++nRowIdx) {
+            int* pnLabels = m_oLabelMap.ptr<int>(nRowIdx);
+            for(int nColIdx=0; nColIdx<m_oSize.width; ++nColIdx)
+                if(pnLabels[nColIdx])
+                    pnLabels[nColIdx] = m_vnBlobIdxs[pnLabels[nColIdx]]+1;
+        }
+    }
+}
+
+IIBackgroundSubtractor::FGBlobLabeler* IIBackgroundSubtractor::beginBlobExtraction(const cv::Rect& oPostProcRect) {
+    if(!m_bUsingBlobOutput) {
+        m_voLastBlobs.clear();
+        return nullptr;
+    }
+    cv::Mat oLabelMap;
+    if(m_bUsingBlobLabelMap) {
+        m_oLastBlobLabels.create(m_oImgSize,CV_32SC1);
+        if(oPostProcRect.size()!=m_oImgSize)
+            m_oLastBlobLabels = cv::Scalar_<int>(0); // pixels outside the post-processing rect are never labeled
+        oLabelMap = m_oLastBlobLabels(oPostProcRect);
+    }
+    m_oBlobLabeler.reset(oPostProcRect.size(),m_bUsingBlobLabelMap?&oLabelMap:nullptr);
+    return &m_oBlobLabeler;
+}
+
+void IIBackgroundSubtractor::endBlobExtraction(const cv::Rect& oPostProcRect) {
+    if(m_bUsingBlobOutput)
+        m_oBlobLabeler.finalize(m_voLastBlobs,oPostProcRect.tl(),m_dProcessingScale,m_oInputSize);
+}
+
+void IIBackgroundSubtractor::postProcessFGMask_fused(cv::Mat& oCurrFGMask, cv::Mat& oLastFGMask, cv::Mat& oLastRawFGMask, cv::Mat& oCurrRawFGBlinkMask,
+                                                     cv::Mat& oLastRawFGBlinkMask, cv::Mat& oBlinksFrame, cv::Mat& oFGMask_PreFlood, cv::Mat& oFGMask_FloodedHoles,
+                                                     cv::Mat& oLastFGMask_dilated, const cv::Mat& oLastFGMask_dilated_inverted, const cv::Mat& oMorphExStructElement,
+                                                     int nMedianBlurKernelSize, FGBlobLabeler* pBlobLabeler) {
+    lvDbgAssert(oCurrFGMask.type()==CV_8UC1 && oLastFGMask.size()==oCurrFGMask.size() && oFGMask_PreFlood.size()==oCurrFGMask.size());
+    lvDbgAssert(nMedianBlurKernelSize>0 && (nMedianBlurKernelSize%2)==1);
+    // each op of the chain is applied to strip buffers extended by the cumulated footprint of the ops that follow it; rows of these buffers
+    // that are affected by strip borders are never kept, and strip buffers that touch the frame borders behave just like full frames
+    const int nRows = oCurrFGMask.rows;
+    const int nCloseHalo = (oMorphExStructElement.rows/2)*2;
+    const int nMorphIters = 3; // erosion/dilation below use 3 iterations of a 3x3 kernel (i.e. a 3 row footprint)
+    const int nDilateHalo = nMorphIters, nMedianHalo = nDilateHalo+nMedianBlurKernelSize/2, nErodeHalo = nMedianHalo+nMorphIters;
+    cv::Mat oClosedBuffer,oErodedBuffer,oPreMedianBuffer,oMedianBuffer,oDilatedBuffer;
+    // pass #1: blink masks & morphological closing
+    for(int nStripBegin=0; nStripBegin<nRows; nStripBegin+=FUSED_POSTPROC_STRIP_ROWS) {
+        const int nStripEnd = std::min(nStripBegin+FUSED_POSTPROC_STRIP_ROWS,nRows);
+        const cv::Range oStripRows(nStripBegin,nStripEnd);
+        cv::Mat oCurrFGMask_Strip = oCurrFGMask.rowRange(oStripRows), oCurrRawFGBlinkMask_Strip = oCurrRawFGBlinkMask.rowRange(oStripRows);
+        cv::Mat oLastRawFGMask_Strip = oLastRawFGMask.rowRange(oStripRows), oLastRawFGBlinkMask_Strip = oLastRawFGBlinkMask.rowRange(oStripRows);
+        cv::Mat oBlinksFrame_Strip = oBlinksFrame.rowRange(oStripRows);
+        cv::bitwise_xor(oCurrFGMask_Strip,oLastRawFGMask_Strip,oCurrRawFGBlinkMask_Strip);
+        cv::bitwise_or(oCurrRawFGBlinkMask_Strip,oLastRawFGBlinkMask_Strip,oBlinksFrame_Strip);
+        oCurrRawFGBlinkMask_Strip.copyTo(oLastRawFGBlinkMask_Strip);
+        oCurrFGMask_Strip.copyTo(oLastRawFGMask_Strip);
+        const int nCloseBegin = std::max(nStripBegin-nCloseHalo,0), nCloseEnd = std::min(nStripEnd+nCloseHalo,nRows);
+        cv::morphologyEx(oCurrFGMask.rowRange(nCloseBegin,nCloseEnd),oClosedBuffer,cv::MORPH_CLOSE,oMorphExStructElement);
+        oClosedBuffer.rowRange(nStripBegin-nCloseBegin,nStripEnd-nCloseBegin).copyTo(oFGMask_PreFlood.rowRange(oStripRows));
+    }
+    // hole detection relies on global connectivity, and cannot be split in strips (holes are the non-flooded pixels)
+    oFGMask_PreFlood.copyTo(oFGMask_FloodedHoles);
+    cv::floodFill(oFGMask_FloodedHoles,cv::Point(0,0),UCHAR_MAX);
+    // pass #2: hole filling, erosion, median blur, dilation & blink masking (the input mask is overwritten with a lag, as it is read in strip halos)
+    int nNextCopyRow = 0;
+    for(int nStripBegin=0; nStripBegin<nRows; nStripBegin+=FUSED_POSTPROC_STRIP_ROWS) {
+        const int nStripEnd = std::min(nStripBegin+FUSED_POSTPROC_STRIP_ROWS,nRows);
+        const cv::Range oStripRows(nStripBegin,nStripEnd);
+        const int nErodeBegin = std::max(nStripBegin-nErodeHalo,0), nErodeEnd = std::min(nStripEnd+nErodeHalo,nRows);
+        const int nMedianBegin = std::max(nStripBegin-nMedianHalo,0), nMedianEnd = std::min(nStripEnd+nMedianHalo,nRows);
+        const int nDilateBegin = std::max(nStripBegin-nDilateHalo,0), nDilateEnd = std::min(nStripEnd+nDilateHalo,nRows);
+        cv::erode(oFGMask_PreFlood.rowRange(nErodeBegin,nErodeEnd),oErodedBuffer,cv::Mat(),cv::Point(-1,-1),nMorphIters);
+        cv::bitwise_not(oFGMask_FloodedHoles.rowRange(nMedianBegin,nMedianEnd),oPreMedianBuffer);
+        cv::bitwise_or(oPreMedianBuffer,oCurrFGMask.rowRange(nMedianBegin,nMedianEnd),oPreMedianBuffer);
+        cv::bitwise_or(oPreMedianBuffer,oErodedBuffer.rowRange(nMedianBegin-nErodeBegin,nMedianEnd-nErodeBegin),oPreMedianBuffer);
+        lv::binaryMedianBlur(oPreMedianBuffer,oMedianBuffer,nMedianBlurKernelSize);
+        cv::dilate(oMedianBuffer.rowRange(nDilateBegin-nMedianBegin,nDilateEnd-nMedianBegin),oDilatedBuffer,cv::Mat(),cv::Point(-1,-1),nMorphIters);
+        oMedianBuffer.rowRange(nStripBegin-nMedianBegin,nStripEnd-nMedianBegin).copyTo(oLastFGMask.rowRange(oStripRows));
+        if(pBlobLabeler) // final mask rows are labeled while still hot in cache
+            pBlobLabeler->processRows(oLastFGMask,nStripBegin,nStripEnd);
+        oDilatedBuffer.rowRange(nStripBegin-nDilateBegin,nStripEnd-nDilateBegin).copyTo(oLastFGMask_dilated.rowRange(oStripRows));
+        cv::Mat oBlinksFrame_Strip = oBlinksFrame.rowRange(oStripRows);
+        cv::bitwise_and(oBlinksFrame_Strip,oLastFGMask_dilated_inverted.rowRange(oStripRows),oBlinksFrame_Strip);
+        oBlinksFrame_Strip.setTo(cv::Scalar_<uchar>(0),oLastFGMask_dilated.rowRange(oStripRows)); // same as masking with the new inverted dilated mask
+        const int nCopyEnd = (nStripEnd==nRows)?nRows:std::max(nStripEnd-nMedianHalo,nNextCopyRow);
+        oLastFGMask.rowRange(nNextCopyRow,nCopyEnd).copyTo(oCurrFGMask.rowRange(nNextCopyRow,nCopyEnd));
+        nNextCopyRow = nCopyEnd;
+    }
+}
+
+void IIBackgroundSubtractor::saveModel(std::ostream& oStream) const {
+    lvAssert_(m_bInitialized && m_bModelInitialized,"algo & model must be initialized first");
+    oStream.write(MODEL_SNAPSHOT_MAGIC,sizeof(MODEL_SNAPSHOT_MAGIC)-1);
+    lv::writeBinary(oStream,(uint32_t)MODEL_SNAPSHOT_VERSION);
+    lv::writeBinary(oStream,std::string(typeid(*this).name()));
+    lv::writeBinary(oStream,m_dProcessingScale);
+    lv::writeBinary(oStream,(int32_t)m_oInputSize.width);
+    lv::writeBinary(oStream,(int32_t)m_oInputSize.height);
+    cv::writeBinary(oStream,m_oROI);
+    cv::writeBinary(oStream,m_oLastColorFrame);
+    cv::writeBinary(oStream,m_oLastFGMask);
+    lv::writeBinary(oStream,(uint64_t)m_nFrameIdx);
+    lv::writeBinary(oStream,(uint64_t)m_nFramesSinceLastReset);
+    lv::writeBinary(oStream,(uint64_t)m_nModelResetCooldown);
+    lv::writeBinary(oStream,m_bAutoModelResetEnabled);
+    lv::writeBinary(oStream,m_bUsingMovingCamera);
+    lv::writeBinary(oStream,m_oRNG);
+    writeModelState(oStream);
+    lvAssert_(oStream.good(),"failed to write model snapshot to stream");
+}
+
+void IIBackgroundSubtractor::loadModel(std::istream& oStream) {
+    std::array<char,sizeof(MODEL_SNAPSHOT_MAGIC)-1> acMagic;
+    oStream.read(acMagic.data(),acMagic.size());
+    lvAssert_(oStream.good() && std::equal(acMagic.begin(),acMagic.end(),MODEL_SNAPSHOT_MAGIC),"stream does not contain a model snapshot");
+    uint32_t nVersion;
+    lv::readBinary(oStream,nVersion);
+    lvAssert_(nVersion==MODEL_SNAPSHOT_VERSION,"unsupported model snapshot version");
+    std::string sTypeName;
+    lv::readBinary(oStream,sTypeName);
+    lvAssert_(sTypeName==typeid(*this).name(),"model snapshot was created by another algorithm type");
+    double dProcessingScale;
+    int32_t nInputWidth,nInputHeight;
+    lv::readBinary(oStream,dProcessingScale);
+    lv::readBinary(oStream,nInputWidth);
+    lv::readBinary(oStream,nInputHeight);
+    lvAssert_(dProcessingScale>0.0 && dProcessingScale<=1.0 && nInputWidth>0 && nInputHeight>0,"bad processing scale in model snapshot");
+    cv::Mat oROI,oLastColorFrame;
+    cv::readBinary(oStream,oROI);
+    cv::readBinary(oStream,oLastColorFrame);
+    lvAssert_(!oROI.empty() && oROI.type()==CV_8UC1 && oROI.size()==oLastColorFrame.size(),"bad ROI/frame in model snapshot");
+    // the snapshot ROI is already validated, so it is reused as-is (initialize only reuses the current ROI if no new one is given)
+    m_oROI = oROI;
+    m_dProcessingScale = 1.0; // the snapshot frame & ROI are already at processing size
+    const InputFormat eInputFormat = m_eInputFormat;
+    m_eInputFormat = InputFormat_Default; // ...and already decoded
+    initialize(oLastColorFrame,cv::Mat());
+    m_dProcessingScale = dProcessingScale;
+    m_dGovernorAppliedScaleFactor = m_oQualityKnobs.dProcessingScaleFactor; // the snapshot scale is kept as-is for the current level
+    m_eInputFormat = eInputFormat;
+    m_oInputSize = cv::Size(nInputWidth,nInputHeight);
+    lvAssert_(cv::countNonZero(m_oROI!=oROI)==0,"model snapshot ROI could not be restored");
+    oLastColorFrame.copyTo(m_oLastColorFrame);
+    cv::readBinary(oStream,m_oLastFGMask);
+    lvAssert_(m_oLastFGMask.size()==m_oImgSize && m_oLastFGMask.type()==CV_8UC1,"bad foreground mask in model snapshot");
+    uint64_t nFrameIdx,nFramesSinceLastReset,nModelResetCooldown;
+    lv::readBinary(oStream,nFrameIdx);
+    lv::readBinary(oStream,nFramesSinceLastReset);
+    lv::readBinary(oStream,nModelResetCooldown);
+    m_nFrameIdx = (size_t)nFrameIdx;
+    m_nFramesSinceLastReset = (size_t)nFramesSinceLastReset;
+    m_nModelResetCooldown = (size_t)nModelResetCooldown;
+    lv::readBinary(oStream,m_bAutoModelResetEnabled);
+    lv::readBinary(oStream,m_bUsingMovingCamera);
+    lv::readBinary(oStream,m_oRNG);
+    readModelState(oStream);
+}
+
+std::shared_ptr<IIBackgroundSubtractor> IIBackgroundSubtractor::clone() {
+    lvAssert_(m_bInitialized && m_bModelInitialized,"algo & model must be initialized first");
+    std::shared_ptr<IIBackgroundSubtractor> pClone = createInstance();
+    lvAssert_(pClone && typeid(*pClone)==typeid(*this),"cloned instance must be of the same algorithm type");
+    // settings which are not part of model snapshots are carried over as-is
+    pClone->m_bUsingTemporalDecimation = m_bUsingTemporalDecimation;
+    pClone->m_dNominalFrameInterval = m_dNominalFrameInterval;
+    pClone->m_nDecimationUpdateStride = m_nDecimationUpdateStride;
+    pClone->m_eInputFormat = m_eInputFormat;
+    pClone->m_bUsingLumaOnlyInput = m_bUsingLumaOnlyInput;
+    pClone->m_bUsingROICompactedProcessing = m_bUsingROICompactedProcessing;
+    pClone->m_bUsingFusedPostProcessing = m_bUsingFusedPostProcessing;
+    pClone->m_bUsingBlobOutput = m_bUsingBlobOutput;
+    pClone->m_bUsingBlobLabelMap = m_bUsingBlobLabelMap;
+    pClone->m_bUsingInstrumentation = m_bUsingInstrumentation;
+    pClone->m_bUsingGovernor = m_bUsingGovernor;
+    pClone->m_dGovernorFrameTimeBudget = m_dGovernorFrameTimeBudget;
+    pClone->m_bGovernorRescalingAllowed = m_bGovernorRescalingAllowed;
+    pClone->m_nGovernorLevel = m_nGovernorLevel;
+    pClone->m_oQualityKnobs = m_oQualityKnobs;
+    pClone->m_dGovernorAvgFrameTime = m_dGovernorAvgFrameTime;
+    pClone->m_nGovernorFramesSinceChange = m_nGovernorFramesSinceChange;
+    pClone->m_nGovernorUpgradeDelay = m_nGovernorUpgradeDelay;
+    pClone->m_bGovernorLastChangeWasUpgrade = m_bGovernorLastChangeWasUpgrade;
+    pClone->m_nRequestedModelNUMANode = m_nRequestedModelNUMANode;
+    // the model itself goes through a snapshot, with impls free to share their large buffers when the clone source is set
+    m_pModelCloneSource = pClone->m_pModelCloneSource = this;
+    try {
+        std::stringstream ssSnapshot(std::ios::in|std::ios::out|std::ios::binary);
+        saveModel(ssSnapshot);
+        pClone->loadModel(ssSnapshot);
+    }
+    catch(...) {
+        m_pModelCloneSource = pClone->m_pModelCloneSource = nullptr;
+        throw;
+    }
+    m_pModelCloneSource = pClone->m_pModelCloneSource = nullptr;
+    return pClone;
+}
+
+std::shared_ptr<IIBackgroundSubtractor> IIBackgroundSubtractor::createInstance() const {
+    lvError("cloning is not supported by this algorithm");
+}
+
+void IIBackgroundSubtractor::writeModelState(std::ostream& /*oStream*/) const {
+    lvError("model snapshots are not supported by this algorithm");
+}
+
+void IIBackgroundSubtractor::readModelState(std::istream& /*oStream*/) {
+    lvError("model snapshots are not supported by this algorithm");
+}
+
 IIBackgroundSubtractor::IIBackgroundSubtractor() :
         m_nROIBorderSize(0),
         m_nImgChannels(0),
@@ -62,13 +990,56 @@ IIBackgroundSubtractor::IIBackgroundSubtractor() :
         m_nFrameIdx(SIZE_MAX),
         m_nFramesSinceLastReset(0),
         m_nModelResetCooldown(0),
+        m_nCurrFrameStride(1),
+        m_nCurrUpdateStride(1),
+        m_bUsingTemporalDecimation(false),
+        m_dNominalFrameInterval(1.0/30),
+        m_nDecimationUpdateStride(1),
+        m_nFramesSinceLastUpdate(0),
+        m_dLastFrameTimestamp(std::numeric_limits<double>::quiet_NaN()),
+        m_dLastUpdateTimestamp(std::numeric_limits<double>::quiet_NaN()),
+        m_bUsingChangeGating(false),
+        m_nChangeGateTileSizeBits(4),
+        m_nChangeGateRefreshRate(BGS_DEFAULT_CHANGE_GATE_REFRESH_RATE),
+        m_dChangeGateNoiseFloor(0.0),
+        m_nChangeGateChangedTiles(0),
+        m_dProcessingScale(1.0),
+        m_eInputFormat(InputFormat_Default),
+        m_bUsingLumaOnlyInput(false),
         m_bInitialized(false),
         m_bModelInitialized(false),
         m_bAutoModelResetEnabled(true),
-        m_bUsingMovingCamera(false) {}
+        m_bUsingMovingCamera(false),
+        m_bUsingROICompactedProcessing(false),
+        m_bUsingFusedPostProcessing(false),
+        m_bUsingBlobOutput(false),
+        m_bUsingBlobLabelMap(false),
+        m_bUsingInstrumentation(false),
+        m_bUsingGovernor(false),
+        m_dGovernorFrameTimeBudget(1.0/30),
+        m_bGovernorRescalingAllowed(false),
+        m_nGovernorLevel(0),
+        m_oQualityKnobs(s_aoGovernorLevels[0]),
+        m_dGovernorAppliedScaleFactor(1.0),
+        m_dGovernorAvgFrameTime(0.0),
+        m_nGovernorFramesSinceChange(0),
+        m_nGovernorUpgradeDelay(GOVERNOR_MIN_UPGRADE_DELAY),
+        m_bGovernorLastChangeWasUpgrade(false),
+        m_nRequestedModelNUMANode(-1),
+        m_nModelNUMANode(-1),
+        m_pMemoryTag(lv::MemoryTracker::createTag("bgs algo",this)),
+        m_pModelCloneSource(nullptr) {}
+
+lv::MemoryTracker::Usage IIBackgroundSubtractor::getMemoryUsage() const {
+    return lv::MemoryTracker::getUsage(*m_pMemoryTag);
+}
 
 void IIBackgroundSubtractor::initialize_common(const cv::Mat& oInitImg, const cv::Mat& oROI) {
-    lvAssert_(!oInitImg.empty() && oInitImg.isContinuous() && (oInitImg.type()==CV_8UC1 || oInitImg.type()==CV_8UC3 || oInitImg.type()==CV_8UC4),"provided image for initialization must be non-empty, continuous, and of type 8UC1/3/4");
+    lvAssert_(!oInitImg.empty() && oInitImg.isContinuous() && (oInitImg.type()==CV_8UC1 || oInitImg.type()==CV_8UC3 || oInitImg.type()==CV_8UC4 || oInitImg.type()==CV_16UC1),"provided image for initialization must be non-empty, continuous, and of type 8UC1/3/4 or 16UC1");
+    // model buffers are (re)allocated by the derived initialize call right after this, so they are pinned to the stream's current worker
+    m_nModelNUMANode = (m_nRequestedModelNUMANode>=0)?m_nRequestedModelNUMANode:lv::GetCurrentNUMANode();
+    if(lv::GetNUMANodeCount()<=1 && m_nRequestedModelNUMANode<0)
+        m_nModelNUMANode = -1; // no binding needed on non-NUMA systems
     if(oInitImg.channels()>1) {
         std::vector<cv::Mat> voInitImgs;
         cv::split(oInitImg,voInitImgs);
@@ -107,24 +1078,44 @@ void IIBackgroundSubtractor::initialize_common(const cv::Mat& oInitImg, const cv
     m_nImgChannels = oInitImg.channels();
     m_nTotPxCount = m_oImgSize.area();
     m_nTotRelevantPxCount = m_nFinalROIPxCount;
+    m_oROIBoundingRect = cv::boundingRect(m_oROI);
     m_nFrameIdx = 0;
     m_nFramesSinceLastReset = 0;
+    m_nCurrFrameStride = 1;
+    m_nCurrUpdateStride = 1;
+    m_nFramesSinceLastUpdate = 0;
+    m_dLastFrameTimestamp = m_dLastUpdateTimestamp = std::numeric_limits<double>::quiet_NaN();
     m_nModelResetCooldown = 0;
     m_oLastFGMask.create(m_oImgSize,CV_8UC1);
     m_oLastFGMask = cv::Scalar_<uchar>(0);
-    m_oLastColorFrame.create(m_oImgSize,CV_8UC((int)m_nImgChannels));
-    m_oLastColorFrame = cv::Scalar_<uchar>::all(0);
+    m_oLastColorFrame.create(m_oImgSize,m_nImgType);
+    m_oLastColorFrame = cv::Scalar::all(0);
+    if(m_bUsingChangeGating && oInitImg.depth()==CV_8U) {
+        const int nTileSize = 1<<m_nChangeGateTileSizeBits;
+        m_oChangeGateTileMask.create((m_oImgSize.height+nTileSize-1)/nTileSize,(m_oImgSize.width+nTileSize-1)/nTileSize,CV_8UC1);
+        m_oChangeGateTileMask = cv::Scalar_<uchar>(1);
+        m_oChangeGateRefFrame = oInitImg.clone();
+        m_dChangeGateNoiseFloor = CHANGE_GATE_MIN_THRESHOLD/CHANGE_GATE_NOISE_FLOOR_FACTOR;
+        m_nChangeGateChangedTiles = m_oChangeGateTileMask.total();
+    }
+    else {
+        m_oChangeGateTileMask.release();
+        m_oChangeGateRefFrame.release();
+    }
     m_vnPxIdxLUT.resize(m_nTotRelevantPxCount);
     m_voPxInfoLUT.resize(m_nTotPxCount);
     if(m_nImgChannels==1) {
-        lvAssert(m_oLastColorFrame.step.p[0]==(size_t)m_oImgSize.width && m_oLastColorFrame.step.p[1]==1);
+        lvAssert(m_oLastColorFrame.step.p[0]==(size_t)m_oImgSize.width*m_oLastColorFrame.elemSize() && m_oLastColorFrame.step.p[1]==m_oLastColorFrame.elemSize());
         for(size_t nPxIter=0, nModelIter=0; nPxIter<m_nTotPxCount; ++nPxIter) {
             if(m_oROI.data[nPxIter]) {
                 m_vnPxIdxLUT[nModelIter] = nPxIter;
                 m_voPxInfoLUT[nPxIter].nImgCoord_Y = (int)nPxIter/m_oImgSize.width;
                 m_voPxInfoLUT[nPxIter].nImgCoord_X = (int)nPxIter%m_oImgSize.width;
                 m_voPxInfoLUT[nPxIter].nModelIdx = nModelIter;
-                m_oLastColorFrame.data[nPxIter] = oInitImg.data[nPxIter];
+                if(m_nImgType==CV_16UC1)
+                    ((ushort*)m_oLastColorFrame.data)[nPxIter] = ((const ushort*)oInitImg.data)[nPxIter];
+                else
+                    m_oLastColorFrame.data[nPxIter] = oInitImg.data[nPxIter];
                 ++nModelIter;
             }
         }
@@ -158,14 +1149,14 @@ IBackgroundSubtractor_GLSL::IBackgroundSubtractor_(size_t nLevels, size_t nCompu
         lv::IParallelAlgo_GLSL(nLevels,nComputeStages,nExtraSSBOs,nExtraACBOs,nExtraImages,nExtraTextures,CV_8UC1,nDebugType,true,bUseDisplay,bUseTimers,bUseIntegralFormat),
         m_dCurrLearningRate(-1) {}
 
-void IBackgroundSubtractor_GLSL::getLatestForegroundMask(cv::OutputArray _oLastFGMask) {
+size_t IBackgroundSubtractor_GLSL::getLatestForegroundMask(cv::OutputArray _oLastFGMask) {
     lvAssert_(GLImageProcAlgo::m_bFetchingOutput || GLImageProcAlgo::setOutputFetching(true),"algo not initialized with mat output support")
     _oLastFGMask.create(m_oImgSize,CV_8UC1);
     cv::Mat oLastFGMask = _oLastFGMask.getMat();
     if(GLImageProcAlgo::m_nInternalFrameIdx>0)
-        GLImageProcAlgo::fetchLastOutput(oLastFGMask);
-    else
-        oLastFGMask = cv::Scalar_<uchar>(0);
+        return GLImageProcAlgo::fetchLastOutput(oLastFGMask);
+    oLastFGMask = cv::Scalar_<uchar>(0);
+    return size_t(-1);
 }
 
 void IBackgroundSubtractor_GLSL::initialize_gl(const cv::Mat& oInitImg, const cv::Mat& oROI) {
@@ -177,6 +1168,7 @@ void IBackgroundSubtractor_GLSL::initialize_gl(const cv::Mat& oInitImg, const cv
 }
 
 void IBackgroundSubtractor_GLSL::initialize(const cv::Mat& oInitImg, const cv::Mat& oROI) {
+    lvAssert_(m_eInputFormat==InputFormat_Default,"GLSL impls do not support YUV input formats");
     initialize_gl(oInitImg,oROI);
 }
 
@@ -191,6 +1183,13 @@ void IBackgroundSubtractor_GLSL::apply_gl(cv::InputArray _oNextImage, bool bRebi
     oNextInputImg.copyTo(m_oLastColorFrame);
 }
 
+void IBackgroundSubtractor_GLSL::apply_gl_device(GLuint nNextImageTex, bool bRebindAll, double dLearningRate) {
+    lvAssert_(m_bInitialized && m_bModelInitialized,"algo must be initialized first");
+    m_dCurrLearningRate = dLearningRate;
+    ++m_nFrameIdx;
+    GLImageProcAlgo::apply_gl_device(nNextImageTex,bRebindAll);
+}
+
 void IBackgroundSubtractor_GLSL::apply_gl(cv::InputArray oNextImage, cv::OutputArray oLastFGMask, bool bRebindAll, double dLearningRate) {
     apply_gl(oNextImage,bRebindAll,dLearningRate);
     getLatestForegroundMask(oLastFGMask);
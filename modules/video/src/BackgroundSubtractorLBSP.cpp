@@ -17,13 +17,779 @@
 
 #include "litiv/video/BackgroundSubtractorLBSP.hpp"
 
+// local define used to specify the alignment (in elements) of per-pixel sample blocks in interleaved layout
+#define SAMPLE_BLOCK_ALIGNMENT (16)
+// local define used to specify the weight of descriptor hamming distances relative to L1 color distances when pruning redundant samples
+#define SAMPLE_PRUNING_DESC_DIST_WEIGHT (8)
+
+constexpr size_t LBSPSampleModel::MATCH_BLOCK_SIZE;
+constexpr int LBSPSampleModel::MEAN_TILE_SIZE;
+constexpr size_t LBSPSampleModel::MEAN_BUFFER_COUNT;
+constexpr size_t LBSPSampleModel::MAX_SLOTS;
+constexpr size_t LBSPSampleModel::DESC_PLANE_BLOCK_SIZE;
+
+namespace {
+
+    /// adds two bit-sliced unsigned integers of nBits bits each (one plane per bit, LSB first), writing nBits+1 planes to anSum (which may alias anA)
+    template<size_t nBits>
+    inline void addBitSliced(const uint64_t* anA, const uint64_t* anB, uint64_t* anSum) {
+        uint64_t nCarry = 0;
+        for(size_t k=0; k<nBits; ++k) {
+            const uint64_t nXor = anA[k]^anB[k];
+            const uint64_t nNewCarry = (anA[k]&anB[k])|(nXor&nCarry);
+            anSum[k] = nXor^nCarry;
+            nCarry = nNewCarry;
+        }
+        anSum[nBits] = nCarry;
+    }
+
+} // namespace
+
+LBSPSampleModel::LBSPSampleModel() :
+        m_nChannels(0),
+        m_nSamples(0),
+        m_nSlots(0),
+        m_nSlotWeightStride(0),
+        m_nPxStride(0),
+        m_nSampleStride(0),
+        m_nDescPlaneBlocks(0),
+        m_bUsingDescPlanes(false),
+        m_nDirtyTileCols(0),
+        m_bInterleaved(false),
+        m_nColorDepth(CV_8U) {}
+
+void LBSPSampleModel::create(const cv::Size& oImgSize, size_t nChannels, size_t nSamples, bool bInterleaved, int nColorDepth, cv::MatAllocator* pAllocator, size_t nSlots) {
+    lvAssert_(oImgSize.area()>0 && nChannels>0 && nSamples>0,"bad sample model size");
+    lvAssert_(nColorDepth==CV_8U || nColorDepth==CV_16U,"sample colors must be 8-bit or 16-bit unsigned values");
+    lvAssert_(nSlots==0 || (nColorDepth==CV_8U && nSamples<=MAX_SLOTS && nSlots<=MAX_SLOTS),"deduplicated layout requires 8-bit colors and at most 255 samples & slots per pixel");
+    m_oImgSize = oImgSize;
+    m_nChannels = nChannels;
+    m_nSamples = nSamples;
+    m_nSlots = nSlots?nSlots:nSamples;
+    m_bInterleaved = bInterleaved || nSlots>0; // slots are always stored in per-pixel blocks
+    m_nColorDepth = nColorDepth;
+    const size_t nTotPxCount = (size_t)oImgSize.area();
+    if(m_bInterleaved) {
+        m_nSampleStride = nChannels;
+        m_nPxStride = ((m_nSlots*nChannels+SAMPLE_BLOCK_ALIGNMENT-1)/SAMPLE_BLOCK_ALIGNMENT)*SAMPLE_BLOCK_ALIGNMENT;
+    }
+    else {
+        m_nPxStride = nChannels;
+        m_nSampleStride = nTotPxCount*nChannels;
+    }
+    const int nTotElemCount = int(m_bInterleaved?nTotPxCount*m_nPxStride:nSamples*m_nSampleStride);
+    if(m_oColorData.allocator!=pAllocator) {
+        // buffers are only reused if they come from the same allocator (e.g. the same NUMA node)
+        m_oColorData.release();
+        m_oDescData.release();
+        m_oSlotWeights.release();
+        m_oSampleSlots.release();
+        m_oDescPlanes.release();
+        m_oColorData.allocator = m_oDescData.allocator = m_oSlotWeights.allocator = m_oSampleSlots.allocator = m_oDescPlanes.allocator = pAllocator;
+    }
+    m_oColorData.create(1,nTotElemCount,CV_MAKETYPE(m_nColorDepth,1));
+    m_oColorData = cv::Scalar(0);
+    m_oDescData.create(1,nTotElemCount,CV_16UC1);
+    m_oDescData = cv::Scalar_<ushort>(0);
+    if(nSlots>0) {
+        m_nSlotWeightStride = ((m_nSlots+SAMPLE_BLOCK_ALIGNMENT-1)/SAMPLE_BLOCK_ALIGNMENT)*SAMPLE_BLOCK_ALIGNMENT;
+        // one extra block is allocated at the end so that weights can always be loaded by full blocks
+        m_oSlotWeights.create(1,int((nTotPxCount+1)*m_nSlotWeightStride),CV_8UC1);
+        m_oSlotWeights = cv::Scalar_<uchar>(0);
+        m_oSampleSlots.create(1,int(nTotPxCount*m_nSamples),CV_8UC1);
+        m_oSampleSlots = cv::Scalar_<uchar>(0);
+        // all samples start zeroed, i.e. sharing the first slot
+        for(size_t nPxIdx=0; nPxIdx<nTotPxCount; ++nPxIdx)
+            m_oSlotWeights.data[nPxIdx*m_nSlotWeightStride] = (uchar)m_nSamples;
+    }
+    else {
+        m_nSlotWeightStride = 0;
+        m_oSlotWeights.release();
+        m_oSampleSlots.release();
+    }
+    m_oColorSums.create(m_oImgSize,CV_32SC((int)m_nChannels));
+    m_oColorSums = cv::Scalar_<int>::all(0);
+    m_oDescSums.create(m_oImgSize,CV_32SC((int)m_nChannels));
+    m_oDescSums = cv::Scalar_<int>::all(0);
+    resetDirtyTiles();
+    m_nDescPlaneBlocks = (m_nSamples+DESC_PLANE_BLOCK_SIZE-1)/DESC_PLANE_BLOCK_SIZE;
+    if(m_bUsingDescPlanes && nSlots==0) {
+        // all descriptors start zeroed, and so do their bit planes
+        m_oDescPlanes.create(1,int(nTotPxCount*m_nDescPlaneBlocks*m_nChannels*LBSP::DESC_SIZE_BITS),CV_32SC2);
+        m_oDescPlanes = cv::Scalar_<int>::all(0);
+    }
+    else
+        m_oDescPlanes.release();
+}
+
+void LBSPSampleModel::copyPixel(size_t nDstPxIdx, size_t nSrcPxIdx) {
+    lvDbgAssert(!empty() && nDstPxIdx<(size_t)m_oImgSize.area() && nSrcPxIdx<(size_t)m_oImgSize.area());
+    const size_t nColorElemSize = m_oColorData.elemSize();
+    for(size_t s=0; s<m_nSlots; ++s) {
+        const size_t nDstElemIdx = nDstPxIdx*m_nPxStride+s*m_nSampleStride, nSrcElemIdx = nSrcPxIdx*m_nPxStride+s*m_nSampleStride;
+        std::copy_n(m_oColorData.data+nSrcElemIdx*nColorElemSize,m_nChannels*nColorElemSize,m_oColorData.data+nDstElemIdx*nColorElemSize);
+        std::copy_n(((const ushort*)m_oDescData.data)+nSrcElemIdx,m_nChannels,((ushort*)m_oDescData.data)+nDstElemIdx);
+    }
+    if(isDeduplicated()) {
+        std::copy_n(m_oSlotWeights.data+nSrcPxIdx*m_nSlotWeightStride,m_nSlotWeightStride,m_oSlotWeights.data+nDstPxIdx*m_nSlotWeightStride);
+        std::copy_n(m_oSampleSlots.data+nSrcPxIdx*m_nSamples,m_nSamples,m_oSampleSlots.data+nDstPxIdx*m_nSamples);
+    }
+    if(isUsingBitSlicedDescriptors())
+        std::copy_n(descPlanes(0,nSrcPxIdx),m_nDescPlaneBlocks*m_nChannels*LBSP::DESC_SIZE_BITS,descPlanes(0,nDstPxIdx));
+    std::copy_n(((const int*)m_oColorSums.data)+nSrcPxIdx*m_nChannels,m_nChannels,((int*)m_oColorSums.data)+nDstPxIdx*m_nChannels);
+    std::copy_n(((const int*)m_oDescSums.data)+nSrcPxIdx*m_nChannels,m_nChannels,((int*)m_oDescSums.data)+nDstPxIdx*m_nChannels);
+    setTileDirty(nDstPxIdx);
+}
+
+void LBSPSampleModel::resetMeanSums() {
+    lvAssert_(!empty(),"sample model must be created first");
+    m_oColorSums = cv::Scalar_<int>::all(0);
+    m_oDescSums = cv::Scalar_<int>::all(0);
+    const size_t nTotPxCount = (size_t)m_oImgSize.area();
+    for(size_t nPxIdx=0; nPxIdx<nTotPxCount; ++nPxIdx) {
+        int* const anColorSums = ((int*)m_oColorSums.data)+nPxIdx*m_nChannels;
+        int* const anDescSums = ((int*)m_oDescSums.data)+nPxIdx*m_nChannels;
+        for(size_t s=0; s<m_nSlots; ++s) {
+            const int nWeight = (int)weight(s,nPxIdx);
+            const ushort* const anBGDesc = desc(s,nPxIdx);
+            for(size_t c=0; c<m_nChannels; ++c) {
+                anColorSums[c] += nWeight*((m_nColorDepth==CV_8U)?color(s,nPxIdx)[c]:color16(s,nPxIdx)[c]);
+                anDescSums[c] += nWeight*anBGDesc[c];
+            }
+        }
+    }
+    resetDirtyTiles();
+    resetDescPlanes();
+}
+
+void LBSPSampleModel::resetDirtyTiles() {
+    const size_t nTileRows = size_t((m_oImgSize.height+MEAN_TILE_SIZE-1)/MEAN_TILE_SIZE);
+    m_nDirtyTileCols = size_t((m_oImgSize.width+MEAN_TILE_SIZE-1)/MEAN_TILE_SIZE);
+    if(m_vnDirtyTiles.size()!=nTileRows*m_nDirtyTileCols)
+        m_vnDirtyTiles = std::vector<std::atomic<uchar>>(nTileRows*m_nDirtyTileCols);
+    for(std::atomic<uchar>& nTileFlags : m_vnDirtyTiles)
+        nTileFlags.store(uchar((1<<MEAN_BUFFER_COUNT)-1),std::memory_order_relaxed);
+}
+
+void LBSPSampleModel::resetDescPlanes() {
+    if(!m_bUsingDescPlanes || isDeduplicated()) {
+        m_oDescPlanes.release();
+        return;
+    }
+    const size_t nTotPxCount = (size_t)m_oImgSize.area();
+    m_oDescPlanes.create(1,int(nTotPxCount*m_nDescPlaneBlocks*m_nChannels*LBSP::DESC_SIZE_BITS),CV_32SC2);
+    m_oDescPlanes = cv::Scalar_<int>::all(0); // bits of the padding samples in the last block stay null
+    for(size_t nPxIdx=0; nPxIdx<nTotPxCount; ++nPxIdx)
+        for(size_t s=0; s<m_nSamples; ++s)
+            for(size_t c=0; c<m_nChannels; ++c)
+                setDescPlaneBits(s,nPxIdx,c,desc(s,nPxIdx)[c]);
+}
+
+void LBSPSampleModel::setBitSlicedDescriptors(bool bEnabled) {
+    if(m_bUsingDescPlanes==bEnabled)
+        return;
+    m_bUsingDescPlanes = bEnabled;
+    if(!empty())
+        resetDescPlanes();
+}
+
+void LBSPSampleModel::updateMeanImages(cv::Mat& oMeanColorImg, cv::Mat& oMeanDescImg, size_t nBufferIdx) const {
+    lvAssert_(!empty(),"sample model must be created first");
+    lvAssert_(nBufferIdx<MEAN_BUFFER_COUNT,"bad mean image buffer index");
+    const uchar nBufferBit = uchar(1<<nBufferIdx);
+    const int nColorType = CV_MAKETYPE(m_nColorDepth,(int)m_nChannels), nDescType = CV_16UC((int)m_nChannels);
+    if(oMeanColorImg.size()!=m_oImgSize || oMeanColorImg.type()!=nColorType || oMeanDescImg.size()!=m_oImgSize || oMeanDescImg.type()!=nDescType) {
+        oMeanColorImg.create(m_oImgSize,nColorType);
+        oMeanDescImg.create(m_oImgSize,nDescType);
+        for(std::atomic<uchar>& nTileFlags : m_vnDirtyTiles)
+            nTileFlags.fetch_or(nBufferBit,std::memory_order_relaxed);
+    }
+    lvDbgAssert(oMeanColorImg.isContinuous() && oMeanDescImg.isContinuous());
+    // sums are rounded to the nearest integer to match the output of the float-based 'getMean...Image' functions
+    const int nHalfSamples = int(m_nSamples/2), nSamples = (int)m_nSamples;
+    const int nTileRows = int(m_vnDirtyTiles.size()/m_nDirtyTileCols), nTileCols = int(m_nDirtyTileCols);
+    for(int nTileRowIdx=0; nTileRowIdx<nTileRows; ++nTileRowIdx) {
+        for(int nTileColIdx=0; nTileColIdx<nTileCols; ++nTileColIdx) {
+            // flags are only set concurrently by model updates, which never overlap with this call
+            if(!(m_vnDirtyTiles[nTileRowIdx*nTileCols+nTileColIdx].fetch_and(uchar(~nBufferBit),std::memory_order_relaxed)&nBufferBit))
+                continue;
+            const int nRowEnd = std::min((nTileRowIdx+1)*MEAN_TILE_SIZE,m_oImgSize.height), nColEnd = std::min((nTileColIdx+1)*MEAN_TILE_SIZE,m_oImgSize.width);
+            for(int nRowIdx=nTileRowIdx*MEAN_TILE_SIZE; nRowIdx<nRowEnd; ++nRowIdx) {
+                for(int nColIdx=nTileColIdx*MEAN_TILE_SIZE; nColIdx<nColEnd; ++nColIdx) {
+                    const size_t nElemIdx = (size_t(m_oImgSize.width*nRowIdx+nColIdx))*m_nChannels;
+                    const int* const anColorSums = ((const int*)m_oColorSums.data)+nElemIdx;
+                    const int* const anDescSums = ((const int*)m_oDescSums.data)+nElemIdx;
+                    for(size_t c=0; c<m_nChannels; ++c) {
+                        const int nMeanColor = (anColorSums[c]+nHalfSamples)/nSamples;
+                        if(m_nColorDepth==CV_8U)
+                            oMeanColorImg.data[nElemIdx+c] = (uchar)nMeanColor;
+                        else
+                            ((ushort*)oMeanColorImg.data)[nElemIdx+c] = (ushort)nMeanColor;
+                        ((ushort*)oMeanDescImg.data)[nElemIdx+c] = (ushort)((anDescSums[c]+nHalfSamples)/nSamples);
+                    }
+                }
+            }
+        }
+    }
+}
+
+cv::Mat LBSPSampleModel::getColorSample(size_t nSampleIdx) const {
+    lvAssert_(!empty() && nSampleIdx<m_nSamples,"bad sample index");
+    const size_t nElemSize = m_oColorData.elemSize1();
+    cv::Mat oSample(m_oImgSize,CV_MAKETYPE(m_nColorDepth,(int)m_nChannels),(void*)(m_oColorData.data+nSampleIdx*m_nSampleStride*nElemSize));
+    if(!m_bInterleaved)
+        return oSample;
+    oSample = cv::Mat(m_oImgSize,CV_MAKETYPE(m_nColorDepth,(int)m_nChannels));
+    const size_t nTotPxCount = (size_t)m_oImgSize.area();
+    for(size_t nPxIdx=0; nPxIdx<nTotPxCount; ++nPxIdx)
+        std::copy_n(m_oColorData.data+(nPxIdx*m_nPxStride+slot(nSampleIdx,nPxIdx)*m_nSampleStride)*nElemSize,m_nChannels*nElemSize,oSample.data+nPxIdx*m_nChannels*nElemSize);
+    return oSample;
+}
+
+cv::Mat LBSPSampleModel::getDescSample(size_t nSampleIdx) const {
+    lvAssert_(!empty() && nSampleIdx<m_nSamples,"bad sample index");
+    cv::Mat oSample(m_oImgSize,CV_16UC((int)m_nChannels),(void*)desc(nSampleIdx,0));
+    if(!m_bInterleaved)
+        return oSample;
+    oSample = cv::Mat(m_oImgSize,CV_16UC((int)m_nChannels));
+    const size_t nTotPxCount = (size_t)m_oImgSize.area();
+    for(size_t nPxIdx=0; nPxIdx<nTotPxCount; ++nPxIdx)
+        std::copy_n(desc(slot(nSampleIdx,nPxIdx),nPxIdx),m_nChannels,((ushort*)oSample.data)+nPxIdx*m_nChannels);
+    return oSample;
+}
+
+void LBSPSampleModel::getMeanColorImage(cv::OutputArray oMeanImg) const {
+    lvAssert_(!empty(),"sample model must be created first");
+    cv::Mat_<float> oAvgBGImg((int)m_oImgSize.area(),(int)m_nChannels,0.0f);
+    const size_t nTotPxCount = (size_t)m_oImgSize.area();
+    for(size_t s=0; s<m_nSlots; ++s) {
+        for(size_t nPxIdx=0; nPxIdx<nTotPxCount; ++nPxIdx) {
+            float* pfAvgBGImg = oAvgBGImg.ptr<float>((int)nPxIdx);
+            const float fWeight = (float)weight(s,nPxIdx);
+            for(size_t c=0; c<m_nChannels; ++c)
+                pfAvgBGImg[c] += fWeight*((float)((m_nColorDepth==CV_8U)?color(s,nPxIdx)[c]:color16(s,nPxIdx)[c]))/m_nSamples;
+        }
+    }
+    oAvgBGImg.reshape((int)m_nChannels,m_oImgSize.height).convertTo(oMeanImg,m_nColorDepth);
+}
+
+void LBSPSampleModel::getMeanDescImage(cv::OutputArray oMeanImg) const {
+    lvAssert_(!empty(),"sample model must be created first");
+    cv::Mat_<float> oAvgBGDesc((int)m_oImgSize.area(),(int)m_nChannels,0.0f);
+    const size_t nTotPxCount = (size_t)m_oImgSize.area();
+    for(size_t s=0; s<m_nSlots; ++s) {
+        for(size_t nPxIdx=0; nPxIdx<nTotPxCount; ++nPxIdx) {
+            float* pfAvgBGDesc = oAvgBGDesc.ptr<float>((int)nPxIdx);
+            const float fWeight = (float)weight(s,nPxIdx);
+            const ushort* const anBGDesc = desc(s,nPxIdx);
+            for(size_t c=0; c<m_nChannels; ++c)
+                pfAvgBGDesc[c] += fWeight*((float)anBGDesc[c])/m_nSamples;
+        }
+    }
+    oAvgBGDesc.reshape((int)m_nChannels,m_oImgSize.height).convertTo(oMeanImg,CV_16U);
+}
+
+void LBSPSampleModel::translate(const cv::Point& oShift) {
+    lvAssert_(!empty(),"sample model must be created first");
+    if(oShift==cv::Point(0,0))
+        return;
+    const cv::Mat oOldColorData = m_oColorData.clone(), oOldDescData = m_oDescData.clone();
+    const cv::Mat oOldSlotWeights = m_oSlotWeights.clone(), oOldSampleSlots = m_oSampleSlots.clone();
+    const size_t nColorElemSize = m_oColorData.elemSize1();
+    const ushort* const pOldDescData = (const ushort*)oOldDescData.data;
+    for(int nRowIdx=0; nRowIdx<m_oImgSize.height; ++nRowIdx) {
+        const int nSrcRowIdx = std::min(std::max(nRowIdx-oShift.y,0),m_oImgSize.height-1);
+        for(int nColIdx=0; nColIdx<m_oImgSize.width; ++nColIdx) {
+            const int nSrcColIdx = std::min(std::max(nColIdx-oShift.x,0),m_oImgSize.width-1);
+            const size_t nPxIdx = size_t(m_oImgSize.width*nRowIdx+nColIdx), nSrcPxIdx = size_t(m_oImgSize.width*nSrcRowIdx+nSrcColIdx);
+            for(size_t nSampleIdx=0; nSampleIdx<m_nSlots; ++nSampleIdx) {
+                const size_t nOffset = nPxIdx*m_nPxStride+nSampleIdx*m_nSampleStride, nSrcOffset = nSrcPxIdx*m_nPxStride+nSampleIdx*m_nSampleStride;
+                std::copy_n(oOldColorData.data+nSrcOffset*nColorElemSize,m_nChannels*nColorElemSize,m_oColorData.data+nOffset*nColorElemSize);
+                std::copy_n(pOldDescData+nSrcOffset,m_nChannels,((ushort*)m_oDescData.data)+nOffset);
+            }
+            if(isDeduplicated()) {
+                std::copy_n(oOldSlotWeights.data+nSrcPxIdx*m_nSlotWeightStride,m_nSlotWeightStride,m_oSlotWeights.data+nPxIdx*m_nSlotWeightStride);
+                std::copy_n(oOldSampleSlots.data+nSrcPxIdx*m_nSamples,m_nSamples,m_oSampleSlots.data+nPxIdx*m_nSamples);
+            }
+        }
+    }
+    resetMeanSums();
+}
+
+void LBSPSampleModel::resizeSamples(size_t nSamples, cv::Mat* pSampleIdxMap) {
+    lvAssert_(!empty(),"sample model must be created first");
+    lvAssert_(nSamples>0,"bad sample count");
+    lvAssert_(!pSampleIdxMap || (pSampleIdxMap->size()==m_oImgSize && pSampleIdxMap->type()==CV_16UC1 && pSampleIdxMap->isContinuous()),"bad sample index map");
+    if(nSamples==m_nSamples)
+        return;
+    if(isDeduplicated()) {
+        // samples are pruned/copied in the expanded layout, and deduplicated again afterwards (index map entries are slot indices in this layout)
+        const size_t nSlots = m_nSlots, nTotPxCount = (size_t)m_oImgSize.area();
+        for(size_t nPxIdx=0; pSampleIdxMap && nPxIdx<nTotPxCount; ++nPxIdx) {
+            ushort& nSlotIdx = ((ushort*)pSampleIdxMap->data)[nPxIdx];
+            const uchar* const pnSampleSlot = std::find(m_oSampleSlots.data+nPxIdx*m_nSamples,m_oSampleSlots.data+(nPxIdx+1)*m_nSamples,(uchar)nSlotIdx);
+            nSlotIdx = ushort(nSlotIdx<m_nSlots?(pnSampleSlot-(m_oSampleSlots.data+nPxIdx*m_nSamples))%m_nSamples:0);
+        }
+        setLayout(true,0);
+        resizeSamples(nSamples,pSampleIdxMap);
+        setLayout(true,nSlots);
+        for(size_t nPxIdx=0; pSampleIdxMap && nPxIdx<nTotPxCount; ++nPxIdx) {
+            ushort& nSampleIdx = ((ushort*)pSampleIdxMap->data)[nPxIdx];
+            nSampleIdx = ushort(slot(nSampleIdx,nPxIdx));
+        }
+        return;
+    }
+    LBSPSampleModel oNewModel;
+    oNewModel.m_bUsingDescPlanes = m_bUsingDescPlanes;
+    oNewModel.create(m_oImgSize,m_nChannels,nSamples,m_bInterleaved,m_nColorDepth,m_oColorData.allocator);
+    const size_t nTotPxCount = (size_t)m_oImgSize.area();
+    const size_t nColorElemSize = m_oColorData.elemSize1();
+    const size_t nColorScale = (m_nColorDepth==CV_8U)?1:BGSLBSP_16BIT_INTENSITY_SCALE;
+    const size_t nKeptSamples = std::min(nSamples,m_nSamples);
+    std::vector<size_t> vnDists(m_nSamples*m_nSamples), vnNNDists(m_nSamples), vnNNIdxs(m_nSamples), vnKeptIdxs(nKeptSamples);
+    std::vector<uchar> vbKept(m_nSamples);
+    std::vector<ushort> vnIdxRemap(m_nSamples);
+    for(size_t nPxIdx=0; nPxIdx<nTotPxCount; ++nPxIdx) {
+        if(nSamples<m_nSamples) {
+            // greedily drops the sample closest to its nearest (kept) neighbor until the new count is reached
+            for(size_t a=0; a<m_nSamples; ++a) {
+                vnDists[a*m_nSamples+a] = SIZE_MAX;
+                for(size_t b=a+1; b<m_nSamples; ++b) {
+                    size_t nDist = 0;
+                    for(size_t c=0; c<m_nChannels; ++c) {
+                        const int nColorA = (m_nColorDepth==CV_8U)?color(a,nPxIdx)[c]:color16(a,nPxIdx)[c];
+                        const int nColorB = (m_nColorDepth==CV_8U)?color(b,nPxIdx)[c]:color16(b,nPxIdx)[c];
+                        nDist += (size_t)std::abs(nColorA-nColorB)/nColorScale+lv::hdist(desc(a,nPxIdx)[c],desc(b,nPxIdx)[c])*SAMPLE_PRUNING_DESC_DIST_WEIGHT;
+                    }
+                    vnDists[a*m_nSamples+b] = vnDists[b*m_nSamples+a] = nDist;
+                }
+            }
+            const auto lUpdateNN = [&](size_t a) {
+                vnNNDists[a] = SIZE_MAX;
+                for(size_t b=0; b<m_nSamples; ++b) {
+                    if(vbKept[b] && vnDists[a*m_nSamples+b]<vnNNDists[a]) {
+                        vnNNDists[a] = vnDists[a*m_nSamples+b];
+                        vnNNIdxs[a] = b;
+                    }
+                }
+            };
+            std::fill(vbKept.begin(),vbKept.end(),uchar(1));
+            for(size_t a=0; a<m_nSamples; ++a)
+                lUpdateNN(a);
+            for(size_t nDropped=0; nDropped<m_nSamples-nSamples; ++nDropped) {
+                size_t nDropIdx = SIZE_MAX;
+                for(size_t a=0; a<m_nSamples; ++a)
+                    if(vbKept[a] && (nDropIdx==SIZE_MAX || vnNNDists[a]<vnNNDists[nDropIdx]))
+                        nDropIdx = a;
+                vbKept[nDropIdx] = 0;
+                for(size_t a=0; a<m_nSamples; ++a)
+                    if(vbKept[a] && vnNNIdxs[a]==nDropIdx)
+                        lUpdateNN(a);
+            }
+            for(size_t a=0, nNewIdx=0; a<m_nSamples; ++a) {
+                if(vbKept[a]) {
+                    vnIdxRemap[a] = (ushort)nNewIdx;
+                    vnKeptIdxs[nNewIdx++] = a;
+                }
+            }
+            if(pSampleIdxMap) {
+                ushort& nSampleIdx = ((ushort*)pSampleIdxMap->data)[nPxIdx];
+                if(nSampleIdx<m_nSamples) {
+                    if(!vbKept[nSampleIdx])
+                        lUpdateNN(nSampleIdx);
+                    nSampleIdx = vbKept[nSampleIdx]?vnIdxRemap[nSampleIdx]:vnIdxRemap[vnNNIdxs[nSampleIdx]];
+                }
+                else
+                    nSampleIdx = 0;
+            }
+        }
+        else
+            std::iota(vnKeptIdxs.begin(),vnKeptIdxs.end(),size_t(0));
+        for(size_t nNewIdx=0; nNewIdx<nSamples; ++nNewIdx) {
+            // new slots (when growing) are filled with copies of the existing samples, in order
+            const size_t nOldIdx = vnKeptIdxs[nNewIdx%nKeptSamples];
+            const size_t nOffset = nPxIdx*oNewModel.m_nPxStride+nNewIdx*oNewModel.m_nSampleStride, nOldOffset = nPxIdx*m_nPxStride+nOldIdx*m_nSampleStride;
+            std::copy_n(m_oColorData.data+nOldOffset*nColorElemSize,m_nChannels*nColorElemSize,oNewModel.m_oColorData.data+nOffset*nColorElemSize);
+            std::copy_n(desc(nOldIdx,nPxIdx),m_nChannels,((ushort*)oNewModel.m_oDescData.data)+nOffset);
+        }
+    }
+    *this = std::move(oNewModel);
+    resetMeanSums();
+}
+
+void LBSPSampleModel::write(std::ostream& oStream) const {
+    lvAssert_(!empty(),"sample model must be created first");
+    lv::writeBinary(oStream,(int32_t)m_oImgSize.width);
+    lv::writeBinary(oStream,(int32_t)m_oImgSize.height);
+    lv::writeBinary(oStream,(uint64_t)m_nChannels);
+    lv::writeBinary(oStream,(uint64_t)m_nSamples);
+    lv::writeBinary(oStream,m_bInterleaved);
+    lv::writeBinary(oStream,(uint64_t)(isDeduplicated()?m_nSlots:0));
+    cv::writeBinary(oStream,m_oColorData);
+    cv::writeBinary(oStream,m_oDescData);
+    if(isDeduplicated()) {
+        cv::writeBinary(oStream,m_oSlotWeights);
+        cv::writeBinary(oStream,m_oSampleSlots);
+    }
+}
+
+void LBSPSampleModel::read(std::istream& oStream) {
+    int32_t nWidth,nHeight;
+    uint64_t nChannels,nSamples,nSlots;
+    bool bInterleaved;
+    lv::readBinary(oStream,nWidth);
+    lv::readBinary(oStream,nHeight);
+    lv::readBinary(oStream,nChannels);
+    lv::readBinary(oStream,nSamples);
+    lv::readBinary(oStream,bInterleaved);
+    lv::readBinary(oStream,nSlots);
+    create(cv::Size(nWidth,nHeight),(size_t)nChannels,(size_t)nSamples,bInterleaved,CV_8U,m_oColorData.allocator,(size_t)nSlots);
+    const cv::Size oColorDataSize = m_oColorData.size(), oDescDataSize = m_oDescData.size();
+    cv::readBinary(oStream,m_oColorData);
+    cv::readBinary(oStream,m_oDescData);
+    lvAssert_(m_oColorData.size()==oColorDataSize && (m_oColorData.type()==CV_8UC1 || m_oColorData.type()==CV_16UC1) && m_oDescData.size()==oDescDataSize && m_oDescData.type()==CV_16UC1,"bad sample data in binary stream");
+    if(nSlots>0) {
+        const cv::Size oSlotWeightsSize = m_oSlotWeights.size(), oSampleSlotsSize = m_oSampleSlots.size();
+        cv::readBinary(oStream,m_oSlotWeights);
+        cv::readBinary(oStream,m_oSampleSlots);
+        lvAssert_(m_oColorData.type()==CV_8UC1 && m_oSlotWeights.size()==oSlotWeightsSize && m_oSlotWeights.type()==CV_8UC1 && m_oSampleSlots.size()==oSampleSlotsSize && m_oSampleSlots.type()==CV_8UC1,"bad sample slot data in binary stream");
+    }
+    m_nColorDepth = m_oColorData.depth();
+    resetMeanSums();
+}
+
+void LBSPSampleModel::cloneCOW(LBSPSampleModel& oClone) {
+    lvAssert_(!empty() && &oClone!=this,"source model must be allocated, and distinct from the clone");
+    if(!cv::LargePageMatAllocator::shareCOW(m_oColorData,oClone.m_oColorData))
+        m_oColorData.copyTo(oClone.m_oColorData);
+    if(!cv::LargePageMatAllocator::shareCOW(m_oDescData,oClone.m_oDescData))
+        m_oDescData.copyTo(oClone.m_oDescData);
+    if(!cv::LargePageMatAllocator::shareCOW(m_oSlotWeights,oClone.m_oSlotWeights))
+        m_oSlotWeights.copyTo(oClone.m_oSlotWeights);
+    if(!cv::LargePageMatAllocator::shareCOW(m_oSampleSlots,oClone.m_oSampleSlots))
+        m_oSampleSlots.copyTo(oClone.m_oSampleSlots);
+    if(!cv::LargePageMatAllocator::shareCOW(m_oDescPlanes,oClone.m_oDescPlanes))
+        m_oDescPlanes.copyTo(oClone.m_oDescPlanes);
+    m_oColorSums.copyTo(oClone.m_oColorSums);
+    m_oDescSums.copyTo(oClone.m_oDescSums);
+    oClone.m_oImgSize = m_oImgSize;
+    oClone.resetDirtyTiles(); // the clone's mean images start from scratch
+    oClone.m_nChannels = m_nChannels;
+    oClone.m_nSamples = m_nSamples;
+    oClone.m_nSlots = m_nSlots;
+    oClone.m_nSlotWeightStride = m_nSlotWeightStride;
+    oClone.m_nPxStride = m_nPxStride;
+    oClone.m_nSampleStride = m_nSampleStride;
+    oClone.m_nDescPlaneBlocks = m_nDescPlaneBlocks;
+    oClone.m_bUsingDescPlanes = m_bUsingDescPlanes;
+    oClone.m_bInterleaved = m_bInterleaved;
+    oClone.m_nColorDepth = m_nColorDepth;
+}
+
+void LBSPSampleModel::setLayout(bool bInterleaved, size_t nSlots) {
+    lvAssert_(!empty(),"sample model must be created first");
+    if(nSlots>0?(isDeduplicated() && m_nSlots==nSlots):(!isDeduplicated() && m_bInterleaved==bInterleaved))
+        return;
+    LBSPSampleModel oNewModel;
+    oNewModel.m_bUsingDescPlanes = m_bUsingDescPlanes;
+    oNewModel.create(m_oImgSize,m_nChannels,m_nSamples,bInterleaved,m_nColorDepth,m_oColorData.allocator,nSlots);
+    const size_t nTotPxCount = (size_t)m_oImgSize.area();
+    const size_t nColorElemSize = m_oColorData.elemSize1();
+    for(size_t nPxIdx=0; nPxIdx<nTotPxCount; ++nPxIdx) {
+        for(size_t s=0; s<m_nSamples; ++s) {
+            const size_t nOldIdx = slot(s,nPxIdx);
+            if(oNewModel.isDeduplicated())
+                oNewModel.setDeduplicatedSample(s,nPxIdx,color(nOldIdx,nPxIdx),desc(nOldIdx,nPxIdx));
+            else {
+                const size_t nOffset = nPxIdx*oNewModel.m_nPxStride+s*oNewModel.m_nSampleStride, nOldOffset = nPxIdx*m_nPxStride+nOldIdx*m_nSampleStride;
+                std::copy_n(m_oColorData.data+nOldOffset*nColorElemSize,m_nChannels*nColorElemSize,oNewModel.m_oColorData.data+nOffset*nColorElemSize);
+                std::copy_n(desc(nOldIdx,nPxIdx),m_nChannels,((ushort*)oNewModel.m_oDescData.data)+nOffset);
+            }
+        }
+    }
+    *this = std::move(oNewModel);
+    resetMeanSums();
+}
+
+void LBSPSampleModel::setDeduplicatedSample(size_t nSampleIdx, size_t nPxIdx, const uchar* anColor, const ushort* anDesc) {
+    lvDbgAssert(isDeduplicated() && nSampleIdx<m_nSamples);
+    uchar& nSampleSlot = m_oSampleSlots.data[nPxIdx*m_nSamples+nSampleIdx];
+    uchar* const anWeights = m_oSlotWeights.data+nPxIdx*m_nSlotWeightStride;
+    int* const anColorSums = ((int*)m_oColorSums.data)+nPxIdx*m_nChannels;
+    int* const anDescSums = ((int*)m_oDescSums.data)+nPxIdx*m_nChannels;
+    // the old value is removed first, as its slot may be reused below if the sample was its last user
+    for(size_t c=0; c<m_nChannels; ++c) {
+        anColorSums[c] -= (int)color(nSampleSlot,nPxIdx)[c];
+        anDescSums[c] -= (int)desc(nSampleSlot,nPxIdx)[c];
+    }
+    lvDbgAssert(anWeights[nSampleSlot]>0);
+    --anWeights[nSampleSlot];
+    size_t nNewSlot = SIZE_MAX, nFreeSlot = SIZE_MAX, nNearestSlot = 0, nNearestDist = SIZE_MAX;
+    for(size_t k=0; k<m_nSlots; ++k) {
+        if(!anWeights[k]) {
+            if(nFreeSlot==SIZE_MAX)
+                nFreeSlot = k;
+            continue;
+        }
+        const uchar* const anSlotColor = color(k,nPxIdx);
+        const ushort* const anSlotDesc = desc(k,nPxIdx);
+        size_t nDist = 0;
+        for(size_t c=0; c<m_nChannels; ++c)
+            nDist += lv::L1dist(anColor[c],anSlotColor[c])+lv::hdist(anDesc[c],anSlotDesc[c])*SAMPLE_PRUNING_DESC_DIST_WEIGHT;
+        if(nDist==0) {
+            nNewSlot = k;
+            break;
+        }
+        if(nDist<nNearestDist) {
+            nNearestDist = nDist;
+            nNearestSlot = k;
+        }
+    }
+    if(nNewSlot==SIZE_MAX) {
+        if(nFreeSlot!=SIZE_MAX) {
+            nNewSlot = nFreeSlot;
+            std::copy_n(anColor,m_nChannels,color(nNewSlot,nPxIdx));
+            std::copy_n(anDesc,m_nChannels,desc(nNewSlot,nPxIdx));
+        }
+        else // all slots hold the values of other samples, so the new value is merged with its nearest one
+            nNewSlot = nNearestSlot;
+    }
+    ++anWeights[nNewSlot];
+    nSampleSlot = (uchar)nNewSlot;
+    for(size_t c=0; c<m_nChannels; ++c) {
+        anColorSums[c] += (int)color(nNewSlot,nPxIdx)[c];
+        anDescSums[c] += (int)desc(nNewSlot,nPxIdx)[c];
+    }
+    setTileDirty(nPxIdx);
+}
+
+uint LBSPSampleModel::getColorMatchMask(size_t nPxIdx, size_t nSampleIdx, size_t nSampleCount, const uchar* anColor, size_t nMaxChannelDist, size_t nMaxTotDist) const {
+    static_assert(MATCH_BLOCK_SIZE==16,"bad assumptions in impl below");
+    lvDbgAssert(!empty() && m_nColorDepth==CV_8U && nSampleCount>0 && nSampleCount<=MATCH_BLOCK_SIZE && nSampleIdx+nSampleCount<=m_nSlots);
+    const uint nValidMask = (1u<<nSampleCount)-1;
+#if (HAVE_SSE2 || HAVE_NEON)
+    // samples are gathered channel-wise in a block buffer, unless they are already contiguous (interleaved 1ch layout, padded to block size)
+    const bool bContiguous = m_bInterleaved && m_nChannels==1 && (nSampleIdx%MATCH_BLOCK_SIZE)==0;
+    alignas(16) std::array<uchar,MATCH_BLOCK_SIZE> anBlockColors = {};
+#if HAVE_SSE2
+    const __m128i _anZero = _mm_setzero_si128();
+    const __m128i _anMaxChannelDist = _mm_set1_epi8((char)std::min(nMaxChannelDist,(size_t)UCHAR_MAX));
+    const __m128i _anMaxTotDist = _mm_set1_epi16((short)std::min(nMaxTotDist,(size_t)SHRT_MAX));
+    __m128i _anChannelMatch = _mm_cmpeq_epi8(_anZero,_anZero);
+    __m128i _anTotDist_lo = _anZero, _anTotDist_hi = _anZero;
+    for(size_t c=0; c<m_nChannels; ++c) {
+        if(!bContiguous)
+            for(size_t s=0; s<nSampleCount; ++s)
+                anBlockColors[s] = color(nSampleIdx+s,nPxIdx)[c];
+        const __m128i _anSampleColors = bContiguous?_mm_loadu_si128((const __m128i*)color(nSampleIdx,nPxIdx)):_mm_load_si128((const __m128i*)anBlockColors.data());
+        const __m128i _anCurrColor = _mm_set1_epi8((char)anColor[c]);
+        const __m128i _anDist = _mm_or_si128(_mm_subs_epu8(_anSampleColors,_anCurrColor),_mm_subs_epu8(_anCurrColor,_anSampleColors));
+        _anChannelMatch = _mm_and_si128(_anChannelMatch,_mm_cmpeq_epi8(_mm_min_epu8(_anDist,_anMaxChannelDist),_anDist));
+        _anTotDist_lo = _mm_add_epi16(_anTotDist_lo,_mm_unpacklo_epi8(_anDist,_anZero));
+        _anTotDist_hi = _mm_add_epi16(_anTotDist_hi,_mm_unpackhi_epi8(_anDist,_anZero));
+    }
+    const __m128i _anTotMismatch = _mm_packs_epi16(_mm_cmpgt_epi16(_anTotDist_lo,_anMaxTotDist),_mm_cmpgt_epi16(_anTotDist_hi,_anMaxTotDist));
+    uint nMatchMask = uint(_mm_movemask_epi8(_mm_andnot_si128(_anTotMismatch,_anChannelMatch)))&nValidMask;
+    if(!m_oSlotWeights.empty()) // empty slots (with zero weight) never match
+        nMatchMask &= ~uint(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(m_oSlotWeights.data+nPxIdx*m_nSlotWeightStride+nSampleIdx)),_anZero)));
+    return nMatchMask;
+#else //HAVE_NEON
+    const uint8x16_t _anMaxChannelDist = vdupq_n_u8((uchar)std::min(nMaxChannelDist,(size_t)UCHAR_MAX));
+    const uint16x8_t _anMaxTotDist = vdupq_n_u16((ushort)std::min(nMaxTotDist,(size_t)USHRT_MAX));
+    uint8x16_t _anChannelMatch = vdupq_n_u8(UCHAR_MAX);
+    uint16x8_t _anTotDist_lo = vdupq_n_u16(0), _anTotDist_hi = vdupq_n_u16(0);
+    for(size_t c=0; c<m_nChannels; ++c) {
+        if(!bContiguous)
+            for(size_t s=0; s<nSampleCount; ++s)
+                anBlockColors[s] = color(nSampleIdx+s,nPxIdx)[c];
+        const uint8x16_t _anSampleColors = vld1q_u8(bContiguous?color(nSampleIdx,nPxIdx):anBlockColors.data());
+        const uint8x16_t _anDist = vabdq_u8(_anSampleColors,vdupq_n_u8(anColor[c]));
+        _anChannelMatch = vandq_u8(_anChannelMatch,vcleq_u8(_anDist,_anMaxChannelDist));
+        _anTotDist_lo = vaddw_u8(_anTotDist_lo,vget_low_u8(_anDist));
+        _anTotDist_hi = vaddw_u8(_anTotDist_hi,vget_high_u8(_anDist));
+    }
+    const uint8x16_t _anTotMatch = vcombine_u8(vmovn_u16(vcleq_u16(_anTotDist_lo,_anMaxTotDist)),vmovn_u16(vcleq_u16(_anTotDist_hi,_anMaxTotDist)));
+    uint nMatchMask = lv::movemask_16ub(vandq_u8(_anTotMatch,_anChannelMatch))&nValidMask;
+    if(!m_oSlotWeights.empty()) { // empty slots (with zero weight) never match
+        const uint8x16_t _anWeights = vld1q_u8(m_oSlotWeights.data+nPxIdx*m_nSlotWeightStride+nSampleIdx);
+        nMatchMask &= lv::movemask_16ub(vtstq_u8(_anWeights,_anWeights));
+    }
+    return nMatchMask;
+#endif //HAVE_NEON
+#else //(!HAVE_SSE2 && !HAVE_NEON)
+    uint nMatchMask = 0;
+    for(size_t s=0; s<nSampleCount; ++s) {
+        if(!weight(nSampleIdx+s,nPxIdx))
+            continue;
+        const uchar* const anBGColor = color(nSampleIdx+s,nPxIdx);
+        size_t nTotDist = 0;
+        bool bChannelMatch = true;
+        for(size_t c=0; c<m_nChannels; ++c) {
+            const size_t nDist = lv::L1dist(anColor[c],anBGColor[c]);
+            bChannelMatch &= (nDist<=nMaxChannelDist);
+            nTotDist += nDist;
+        }
+        if(bChannelMatch && nTotDist<=nMaxTotDist)
+            nMatchMask |= (1u<<s);
+    }
+    return nMatchMask;
+#endif //(!HAVE_SSE2 && !HAVE_NEON)
+}
+
+uint LBSPSampleModel::getColorMatchMask(size_t nPxIdx, size_t nSampleIdx, size_t nSampleCount, const ushort* anColor, size_t nMaxChannelDist, size_t nMaxTotDist) const {
+    static_assert(MATCH_BLOCK_SIZE==16,"bad assumptions in impl below");
+    lvDbgAssert(!empty() && m_nColorDepth==CV_16U && m_nChannels==1 && m_oSlotWeights.empty() && nSampleCount>0 && nSampleCount<=MATCH_BLOCK_SIZE && nSampleIdx+nSampleCount<=m_nSamples);
+    const uint nValidMask = (1u<<nSampleCount)-1;
+    const ushort nMaxDist = (ushort)std::min(std::min(nMaxChannelDist,nMaxTotDist),(size_t)USHRT_MAX);
+#if (HAVE_SSE2 || HAVE_NEON)
+    // samples are gathered in a block buffer, unless they are already contiguous (interleaved layout, padded to block size)
+    const bool bContiguous = m_bInterleaved && (nSampleIdx%MATCH_BLOCK_SIZE)==0;
+    alignas(16) std::array<ushort,MATCH_BLOCK_SIZE> anBlockColors = {};
+    if(!bContiguous)
+        for(size_t s=0; s<nSampleCount; ++s)
+            anBlockColors[s] = *color16(nSampleIdx+s,nPxIdx);
+    const ushort* const anSampleColors = bContiguous?color16(nSampleIdx,nPxIdx):anBlockColors.data();
+#if HAVE_SSE2
+    // SSE2 has no unsigned 16-bit compare; a saturated subtraction of the threshold is null iff the distance is within it
+    const __m128i _anZero = _mm_setzero_si128();
+    const __m128i _anMaxDist = _mm_set1_epi16((short)nMaxDist);
+    const __m128i _anCurrColor = _mm_set1_epi16((short)anColor[0]);
+    const __m128i _anSampleColors_lo = _mm_loadu_si128((const __m128i*)anSampleColors);
+    const __m128i _anSampleColors_hi = _mm_loadu_si128((const __m128i*)(anSampleColors+MATCH_BLOCK_SIZE/2));
+    const __m128i _anDist_lo = _mm_or_si128(_mm_subs_epu16(_anSampleColors_lo,_anCurrColor),_mm_subs_epu16(_anCurrColor,_anSampleColors_lo));
+    const __m128i _anDist_hi = _mm_or_si128(_mm_subs_epu16(_anSampleColors_hi,_anCurrColor),_mm_subs_epu16(_anCurrColor,_anSampleColors_hi));
+    const __m128i _anMatch_lo = _mm_cmpeq_epi16(_mm_subs_epu16(_anDist_lo,_anMaxDist),_anZero);
+    const __m128i _anMatch_hi = _mm_cmpeq_epi16(_mm_subs_epu16(_anDist_hi,_anMaxDist),_anZero);
+    return uint(_mm_movemask_epi8(_mm_packs_epi16(_anMatch_lo,_anMatch_hi)))&nValidMask;
+#else //HAVE_NEON
+    const uint16x8_t _anMaxDist = vdupq_n_u16(nMaxDist);
+    const uint16x8_t _anCurrColor = vdupq_n_u16(anColor[0]);
+    const uint16x8_t _anMatch_lo = vcleq_u16(vabdq_u16(vld1q_u16(anSampleColors),_anCurrColor),_anMaxDist);
+    const uint16x8_t _anMatch_hi = vcleq_u16(vabdq_u16(vld1q_u16(anSampleColors+MATCH_BLOCK_SIZE/2),_anCurrColor),_anMaxDist);
+    return lv::movemask_16ub(vcombine_u8(vmovn_u16(_anMatch_lo),vmovn_u16(_anMatch_hi)))&nValidMask;
+#endif //HAVE_NEON
+#else //(!HAVE_SSE2 && !HAVE_NEON)
+    uint nMatchMask = 0;
+    for(size_t s=0; s<nSampleCount; ++s)
+        if(lv::L1dist(anColor[0],*color16(nSampleIdx+s,nPxIdx))<=nMaxDist)
+            nMatchMask |= (1u<<s);
+    return nMatchMask&nValidMask;
+#endif //(!HAVE_SSE2 && !HAVE_NEON)
+}
+
+uint64_t LBSPSampleModel::getDescMatchMask(size_t nPxIdx, size_t nSampleIdx, size_t nSampleCount, const ushort* anDesc, size_t nDescChannels, size_t nMaxTotDist) const {
+    static_assert(DESC_PLANE_BLOCK_SIZE==64 && LBSP::DESC_SIZE_BITS==16,"bad assumptions in impl below");
+    lvDbgAssert(isUsingBitSlicedDescriptors() && (nSampleIdx%DESC_PLANE_BLOCK_SIZE)==0 && nSampleCount>0 && nSampleCount<=DESC_PLANE_BLOCK_SIZE && nSampleIdx+nSampleCount<=m_nSamples);
+    lvDbgAssert(nDescChannels>0 && nDescChannels<=m_nChannels && nDescChannels<=4);
+    const uint64_t nValidMask = (nSampleCount==DESC_PLANE_BLOCK_SIZE)?~uint64_t(0):((uint64_t(1)<<nSampleCount)-1);
+    if(nMaxTotDist>=nDescChannels*LBSP::DESC_SIZE_BITS)
+        return nValidMask;
+    const uint64_t* const anPlanes = descPlanes(nSampleIdx/DESC_PLANE_BLOCK_SIZE,nPxIdx);
+    // per-sample total distances, bit-sliced (7 planes hold up to 4x16 differing bits)
+    std::array<uint64_t,7> anTotDist = {};
+    for(size_t c=0; c<nDescChannels; ++c) {
+        const uint64_t* const anChannelPlanes = anPlanes+c*LBSP::DESC_SIZE_BITS;
+        std::array<uint64_t,16> anDiffBits;
+        for(size_t k=0; k<LBSP::DESC_SIZE_BITS; ++k)
+            anDiffBits[k] = anChannelPlanes[k]^(uint64_t(0)-((anDesc[c]>>k)&1));
+        // adder tree (popcount of the 16 difference planes): 8x 2-bit, 4x 3-bit, 2x 4-bit, then 1x 5-bit sums
+        std::array<uint64_t,16> anSums2;
+        for(size_t i=0; i<8; ++i)
+            addBitSliced<1>(&anDiffBits[2*i],&anDiffBits[2*i+1],&anSums2[2*i]);
+        std::array<uint64_t,12> anSums3;
+        for(size_t i=0; i<4; ++i)
+            addBitSliced<2>(&anSums2[4*i],&anSums2[4*i+2],&anSums3[3*i]);
+        std::array<uint64_t,8> anSums4;
+        for(size_t i=0; i<2; ++i)
+            addBitSliced<3>(&anSums3[6*i],&anSums3[6*i+3],&anSums4[4*i]);
+        std::array<uint64_t,6> anSums5 = {};
+        addBitSliced<4>(&anSums4[0],&anSums4[4],anSums5.data());
+        // the running total is always below 64 before the last channel is added, so its 7th plane is still null here
+        addBitSliced<6>(anTotDist.data(),anSums5.data(),anTotDist.data());
+    }
+    // bit-sliced 'anTotDist<=nMaxTotDist' comparison, from the most significant plane down
+    uint64_t nGreaterMask = 0, nEqualMask = ~uint64_t(0);
+    for(size_t k=anTotDist.size(); k-->0;) {
+        if((nMaxTotDist>>k)&1)
+            nEqualMask &= anTotDist[k];
+        else {
+            nGreaterMask |= nEqualMask&anTotDist[k];
+            nEqualMask &= ~anTotDist[k];
+        }
+    }
+    return ~nGreaterMask&nValidMask;
+}
+
+LBSPMeanImageBuffer::LBSPMeanImageBuffer() :
+        m_nFrontIdx(0),
+        m_bPublished(false) {}
+
+void LBSPMeanImageBuffer::publish(const LBSPSampleModel& oModel) {
+    // the back buffer is never read while it is being refreshed: readers only copy the front one, and only 'publish' swaps them
+    const size_t nBackIdx = m_bPublished?(m_nFrontIdx+1)%LBSPSampleModel::MEAN_BUFFER_COUNT:m_nFrontIdx;
+    oModel.updateMeanImages(m_aoMeanColorImgs[nBackIdx],m_aoMeanDescImgs[nBackIdx],nBackIdx);
+    std::mutex_lock_guard oFrontLock(m_oFrontMutex);
+    m_nFrontIdx = nBackIdx;
+    m_bPublished = true;
+}
+
+void LBSPMeanImageBuffer::publishIfIdle(const LBSPSampleModel& oModel, std::mutex& oModelMutex) {
+    std::mutex_unique_lock oModelLock(oModelMutex,std::try_to_lock);
+    if(!oModelLock.owns_lock() && !isPublished())
+        oModelLock.lock();
+    if(oModelLock.owns_lock())
+        publish(oModel);
+}
+
+bool LBSPMeanImageBuffer::isPublished() const {
+    std::mutex_lock_guard oFrontLock(m_oFrontMutex);
+    return m_bPublished;
+}
+
+void LBSPMeanImageBuffer::getColorImage(cv::OutputArray oMeanColorImg) const {
+    std::mutex_lock_guard oFrontLock(m_oFrontMutex);
+    lvAssert_(m_bPublished,"no mean image published yet");
+    m_aoMeanColorImgs[m_nFrontIdx].copyTo(oMeanColorImg);
+}
+
+void LBSPMeanImageBuffer::getDescImage(cv::OutputArray oMeanDescImg) const {
+    std::mutex_lock_guard oFrontLock(m_oFrontMutex);
+    lvAssert_(m_bPublished,"no mean image published yet");
+    m_aoMeanDescImgs[m_nFrontIdx].copyTo(oMeanDescImg);
+}
+
 template<lv::ParallelAlgoType eImpl>
 void IBackgroundSubtractorLBSP_<eImpl>::initialize_common(const cv::Mat& oInitImg, const cv::Mat& oROI) {
     lvDbgExceptionWatch;
     IIBackgroundSubtractor::initialize_common(oInitImg,oROI);
     m_oLastDescFrame.create(this->m_oImgSize,CV_16UC((int)this->m_nImgChannels));
     m_oLastDescFrame = cv::Scalar_<ushort>::all(0);
+    m_oDescCacheValidMask.create(this->m_oImgSize,CV_8UC1);
+    m_oDescCacheValidMask = cv::Scalar_<uchar>(0);
+    m_oDescCacheLastInput.release();
+    m_bDescCacheReady = false; // border descriptors are not all computed here, first apply must fill them
     const int nLBSPBorderSize = (int)LBSP::PATCH_SIZE/2;
+    if(m_oRandSampleLUT.size()!=this->m_oImgSize) {
+        m_oRandSampleLUT.initialize(this->m_oImgSize,nLBSPBorderSize);
+        m_oRandNeighborLUT_3x3.initialize(this->m_oImgSize,nLBSPBorderSize);
+        m_oRandNeighborLUT_5x5.initialize(this->m_oImgSize,nLBSPBorderSize);
+    }
+    m_vnLBSPThreshold_16bitLUT.clear();
+    if(oInitImg.depth()==CV_16U) {
+        lvAssert_(this->m_nImgChannels==1,"16-bit inputs must be single-channel");
+        m_vnLBSPThreshold_16bitLUT.resize(USHRT_MAX+1);
+        for(size_t t=0; t<=USHRT_MAX; ++t)
+            m_vnLBSPThreshold_16bitLUT[t] = cv::saturate_cast<ushort>((t*m_fRelLBSPThreshold+m_nLBSPThresholdOffset*BGSLBSP_16BIT_INTENSITY_SCALE)/3);
+        for(size_t nPxIter=0; nPxIter<this->m_nTotPxCount; ++nPxIter) {
+            const int nImgCoord_X = this->m_voPxInfoLUT[nPxIter].nImgCoord_X;
+            const int nImgCoord_Y = this->m_voPxInfoLUT[nPxIter].nImgCoord_Y;
+            if(this->m_oROI.data[nPxIter] && nImgCoord_X>nLBSPBorderSize && nImgCoord_Y>nLBSPBorderSize && nImgCoord_X<oInitImg.cols-nLBSPBorderSize && nImgCoord_Y<oInitImg.rows-nLBSPBorderSize) {
+                const ushort nInitColor = ((const ushort*)oInitImg.data)[nPxIter];
+                LBSP::computeDescriptor<1>(oInitImg,nInitColor,nImgCoord_X,nImgCoord_Y,0,m_vnLBSPThreshold_16bitLUT[nInitColor],((ushort*)m_oLastDescFrame.data)[nPxIter]);
+            }
+        }
+        return;
+    }
     if(this->m_nImgChannels==1) {
         lvAssert(m_oLastDescFrame.step.p[0]==this->m_oLastColorFrame.step.p[0]*2 && m_oLastDescFrame.step.p[1]==this->m_oLastColorFrame.step.p[1]*2);
         for(size_t t=0; t<=UCHAR_MAX; ++t)
@@ -64,6 +830,84 @@ void IBackgroundSubtractorLBSP_<eImpl>::initialize_common(const cv::Mat& oInitIm
     }
 }
 
+template<lv::ParallelAlgoType eImpl>
+void IBackgroundSubtractorLBSP_<eImpl>::setDescriptorCache(bool bEnabled, size_t nNoiseFloor) {
+    lvAssert_(nNoiseFloor<=UCHAR_MAX,"descriptor cache noise floor must fit in 8-bit range");
+    m_bUsingDescCache = bEnabled;
+    m_nDescCacheNoiseFloor = nNoiseFloor;
+    invalidateDescriptorCache();
+}
+
+template<lv::ParallelAlgoType eImpl>
+void IBackgroundSubtractorLBSP_<eImpl>::setBlockSampleMatching(bool bEnabled) {
+    m_bUsingBlockMatching = bEnabled;
+}
+
+template<lv::ParallelAlgoType eImpl>
+void IBackgroundSubtractorLBSP_<eImpl>::classify(cv::InputArray /*oImage*/, cv::OutputArray /*oFGMask*/) {
+    lvError("classification-only pass not supported by this algorithm");
+}
+
+template<lv::ParallelAlgoType eImpl>
+void IBackgroundSubtractorLBSP_<eImpl>::update(cv::InputArray /*oImage*/, double /*dLearningRate*/) {
+    // note: algorithms whose model update depends on their own segmentation feedback (e.g. SuBSENSE, PAWCS) can only be updated via 'apply'
+    lvError("decoupled model update pass not supported by this algorithm");
+}
+
+template<lv::ParallelAlgoType eImpl>
+void IBackgroundSubtractorLBSP_<eImpl>::writeLBSPModelState(std::ostream& oStream) const {
+    lv::writeBinary(oStream,m_anLBSPThreshold_8bitLUT);
+    lv::writeBinary(oStream,m_vnLBSPThreshold_16bitLUT);
+    cv::writeBinary(oStream,m_oLastDescFrame);
+}
+
+template<lv::ParallelAlgoType eImpl>
+void IBackgroundSubtractorLBSP_<eImpl>::readLBSPModelState(std::istream& oStream) {
+    lv::readBinary(oStream,m_anLBSPThreshold_8bitLUT);
+    lv::readBinary(oStream,m_vnLBSPThreshold_16bitLUT);
+    lvAssert_(m_vnLBSPThreshold_16bitLUT.size()==((this->m_nImgType==CV_16UC1)?size_t(USHRT_MAX+1):size_t(0)),"bad 16-bit threshold LUT in model snapshot");
+    cv::readBinary(oStream,m_oLastDescFrame);
+    lvAssert_(m_oLastDescFrame.size()==this->m_oImgSize && m_oLastDescFrame.type()==CV_16UC((int)this->m_nImgChannels),"bad descriptor frame in model snapshot");
+    invalidateDescriptorCache();
+}
+
+template<lv::ParallelAlgoType eImpl>
+void IBackgroundSubtractorLBSP_<eImpl>::invalidateDescriptorCache() {
+    m_bDescCacheReady = false;
+}
+
+template<lv::ParallelAlgoType eImpl>
+void IBackgroundSubtractorLBSP_<eImpl>::updateDescriptorCache(const cv::Mat& oInputImg) {
+    lvDbgExceptionWatch;
+    if(!m_bUsingDescCache)
+        return;
+    lvDbgAssert(oInputImg.type()==this->m_nImgType && oInputImg.size()==this->m_oImgSize && oInputImg.isContinuous());
+    if(m_bDescCacheReady && !m_oDescCacheLastInput.empty()) {
+        cv::absdiff(oInputImg,m_oDescCacheLastInput,m_oDescCacheDiffBuffer);
+        cv::Mat oMaxDiff = m_oDescCacheDiffBuffer;
+        if(this->m_nImgChannels>1) {
+            // max over channels (reduce works on the per-pixel row view of the interleaved data, and writes in-place in the mask)
+            cv::Mat oValidMaskCol = m_oDescCacheValidMask.reshape(1,(int)this->m_nTotPxCount);
+            cv::reduce(m_oDescCacheDiffBuffer.reshape(1,(int)this->m_nTotPxCount),oValidMaskCol,1,cv::REDUCE_MAX);
+            oMaxDiff = m_oDescCacheValidMask;
+        }
+        // the noise floor is given in 8-bit intensity units (16-bit inputs are single-channel, so their diffs never go through the 8-bit mask)
+        const size_t nNoiseFloor = m_nDescCacheNoiseFloor*((oInputImg.depth()==CV_16U)?BGSLBSP_16BIT_INTENSITY_SCALE:1);
+        cv::compare(oMaxDiff,cv::Scalar((double)nNoiseFloor),m_oDescCacheChangedMask,cv::CMP_GT);
+        cv::bitwise_not(m_oDescCacheChangedMask,m_oDescCacheValidMask);
+        // a descriptor can only be reused if its whole patch is unchanged
+        cv::erode(m_oDescCacheValidMask,m_oDescCacheValidMask,cv::getStructuringElement(cv::MORPH_RECT,cv::Size((int)LBSP::PATCH_SIZE,(int)LBSP::PATCH_SIZE)));
+        // only changed pixels become the new reference (all descriptors covering them are recomputed); the others keep the value
+        // they were last compared against, so slow drifts below the noise floor still end up invalidating their descriptors
+        oInputImg.copyTo(m_oDescCacheLastInput,m_oDescCacheChangedMask);
+    }
+    else {
+        m_oDescCacheValidMask = cv::Scalar_<uchar>(0);
+        oInputImg.copyTo(m_oDescCacheLastInput);
+    }
+    m_bDescCacheReady = true;
+}
+
 #if HAVE_GLSL
 
 template<>
@@ -49,7 +49,7 @@ void BackgroundSubtractorLOBSTER_GLSL::refreshModel(float fSamplesRefreshFrac, b
     lvAssert_(m_bInitialized,"algo must be initialized first");
     lvAssert_(fSamplesRefreshFrac>0.0f && fSamplesRefreshFrac<=1.0f,"model refresh must be given as a non-null fraction");
     const size_t nModelSamplesToRefresh = fSamplesRefreshFrac<1.0f?(size_t)(fSamplesRefreshFrac*m_nBGSamples):m_nBGSamples;
-    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?rand()%m_nBGSamples:0;
+    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?m_oRNG()%m_nBGSamples:0;
     if(!bForceFGUpdate)
         getLatestForegroundMask(m_oLastFGMask);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(BackgroundSubtractorLOBSTER_::LOBSTERStorageBuffer_BGModelBinding));
@@ -98,11 +98,13 @@ void BackgroundSubtractorLOBSTER_GLSL::refreshModel(float fSamplesRefreshFrac, b
 void BackgroundSubtractorLOBSTER_GLSL::initialize_gl(const cv::Mat& oInitImg, const cv::Mat& oROI) {
     lvDbgExceptionWatch;
     // == init
+    lvAssert_(oInitImg.depth()==CV_8U,"GLSL impl only supports 8-bit inputs");
     initialize_common(oInitImg,oROI);
     // not considering relevant pixels via LUT: it would ruin shared mem usage
     m_nTMT32ModelSize = size_t(m_oROI.cols*m_oROI.rows);
-    m_nSampleStepSize = m_nImgChannels;
-    m_nPxModelSize = m_nImgChannels*m_nBGSamples*2;
+    // 3-channel inputs are expanded to rgba layers on the gpu (see GLImageProcAlgo's packed input mode), so they share the 4-channel model layout
+    m_nSampleStepSize = (m_nImgChannels==1)?1:4;
+    m_nPxModelSize = m_nSampleStepSize*m_nBGSamples*2;
     m_nPxModelPadding = (m_nPxModelSize%4)?4-m_nPxModelSize%4:0;
     m_nColStepSize = m_nPxModelSize+m_nPxModelPadding;
     m_nRowStepSize = m_nColStepSize*m_oROI.cols;
@@ -111,8 +113,24 @@ void BackgroundSubtractorLOBSTER_GLSL::initialize_gl(const cv::Mat& oInitImg, co
     lvAssert_(nMaxSSBOBlockSize>(int)(m_nBGModelSize*sizeof(uint)) && nMaxSSBOBlockSize>(int)(m_nTMT32ModelSize*sizeof(lv::gl::TMT32GenParams)),"max ssbo block size is tool small for the predicted model size");
     m_vnBGModelData.resize(m_nBGModelSize,0);
     lv::gl::TMT32GenParams::initTinyMT32Generators(glm::uvec3(uint(m_oROI.cols),uint(m_oROI.rows),1),m_voTMT32ModelData);
+    // the active tile list itself depends on the work group size (which may change during autotuning), so it is built on first dispatch
+    m_bUsingActiveTiles = BGSLOBSTER_GLSL_USE_ROI_TILES && cv::countNonZero(m_oROI)<(int)m_oROI.total();
+    m_vActiveTileSize = glm::uvec2(0,0);
+    m_nActiveTileCount = 0;
+    m_pActiveTileList = nullptr;
+    m_pActiveTileDispatchArgs = nullptr;
     m_bInitialized = true;
     GLImageProcAlgo::initialize_gl(oInitImg,m_oROI);
+    if(m_bUsingActiveTiles) {
+        // tiles outside the ROI are never dispatched, so their output is cleared once for all layers here
+        const cv::Mat oEmptyOutput(m_oFrameSize,m_nOutputType,cv::Scalar::all(0));
+        for(size_t nLayerIter=0; nLayerIter<GLUTILS_IMGPROC_DEFAULT_LAYER_COUNT; ++nLayerIter) {
+            if(m_bUsingTexArrays)
+                m_pOutputArray->updateTexture(oEmptyOutput,(int)nLayerIter);
+            else
+                m_vpOutputArray[nLayerIter]->updateTexture(oEmptyOutput);
+        }
+    }
     glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(BackgroundSubtractorLOBSTER_::LOBSTERStorageBuffer_TMT32ModelBinding));
     glBufferData(GL_SHADER_STORAGE_BUFFER,m_nTMT32ModelSize*sizeof(lv::gl::TMT32GenParams),m_voTMT32ModelData.data(),GL_STATIC_COPY);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER,BackgroundSubtractorLOBSTER_::LOBSTERStorageBuffer_TMT32ModelBinding,getSSBOId(BackgroundSubtractorLOBSTER_::LOBSTERStorageBuffer_TMT32ModelBinding));
@@ -122,10 +140,12 @@ void BackgroundSubtractorLOBSTER_GLSL::initialize_gl(const cv::Mat& oInitImg, co
 
 std::string BackgroundSubtractorLOBSTER_GLSL::getComputeShaderSource_LOBSTER() const {
     lvDbgExceptionWatch;
+    const bool bUsingSharedMem = getIsUsingSharedMem();
+    const bool b4ch = (m_nImgChannels!=1); // 3-channel inputs are also bound as rgba images
     std::stringstream ssSrc;
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     ssSrc << "#version 430\n";
-    if(m_nImgChannels==4) { ssSrc <<
+    if(b4ch) { ssSrc <<
              "#define COLOR_DIST_THRESHOLD    " << m_nColorDistThreshold*3 << "\n"
              "#define DESC_DIST_THRESHOLD     " << m_nDescDistThreshold*3 << "\n"
              "#define COLOR_DIST_SC_THRESHOLD (COLOR_DIST_THRESHOLD/2)\n"
@@ -140,24 +160,22 @@ std::string BackgroundSubtractorLOBSTER_GLSL::getComputeShaderSource_LOBSTER() c
              "#define MODEL_STEP_SIZE         " << m_oFrameSize.width << "\n"
              "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
              "layout(binding=" << GLImageProcAlgo::Image_ROIBinding << ", r8ui) readonly uniform uimage2D mROI;\n"
-             "layout(binding=" << GLImageProcAlgo::Image_InputBinding << ", " << (m_nImgChannels==4?"rgba8ui":"r8ui") << ") readonly uniform uimage2D mInput;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_InputBinding << ", " << (b4ch?"rgba8ui":"r8ui") << ") readonly uniform uimage2D mInput;\n"
 #if BGSLOBSTER_GLSL_USE_DEBUG
              //"layout(binding=" << GLImageProcAlgo::Image_DebugBinding << ", rgba8) writeonly uniform image2D mDebug;\n"
              "layout(binding=" << GLImageProcAlgo::Image_DebugBinding << ", rgba8ui) writeonly uniform uimage2D mDebug;\n"
 #endif //BGSLOBSTER_GLSL_USE_DEBUG
              "layout(binding=" << GLImageProcAlgo::Image_OutputBinding << ", r8ui) writeonly uniform uimage2D mOutput;\n" <<
-             (m_nImgChannels==4?lv::getShaderFunctionSource_L1dist():std::string())+lv::getShaderFunctionSource_absdiff(true) <<
+             (b4ch?lv::getShaderFunctionSource_L1dist():std::string())+lv::getShaderFunctionSource_absdiff(true) <<
              lv::getShaderFunctionSource_hdist() <<
              GLShader::getShaderFunctionSource_urand_tinymt32() <<
              GLShader::getShaderFunctionSource_getRandNeighbor3x3(0,m_oFrameSize) <<
              IBackgroundSubtractorLBSP_GLSL::getLBSPThresholdLUTShaderSource() <<
-             LBSP::getShaderFunctionSource(m_nImgChannels,BGSLOBSTER_GLSL_USE_SHAREDMEM,m_vDefaultWorkGroupSize) <<
-#if !BGSLOBSTER_GLSL_USE_SHAREDMEM
-             "#define lbsp(t,ref,vCoords) lbsp(t,ref,mInput,vCoords)\n"
-#endif //(!BGSLOBSTER_GLSL_USE_SHAREDMEM)
+             LBSP::getShaderFunctionSource(b4ch?4:1,bUsingSharedMem,m_vDefaultWorkGroupSize) <<
+             (bUsingSharedMem?"":"#define lbsp(t,ref,vCoords) lbsp(t,ref,mInput,vCoords)\n") <<
              "struct PxModel {\n"
-             "    " << (m_nImgChannels==4?"uvec4":"uint") << " color_samples[" << m_nBGSamples << "];\n"
-             "    " << (m_nImgChannels==4?"uvec4":"uint") << " lbsp_samples[" << m_nBGSamples << "];\n";
+             "    " << (b4ch?"uvec4":"uint") << " color_samples[" << m_nBGSamples << "];\n"
+             "    " << (b4ch?"uvec4":"uint") << " lbsp_samples[" << m_nBGSamples << "];\n";
     if(m_nPxModelPadding>0) ssSrc <<
              "    uint pad[" << m_nPxModelPadding << "];\n";
     ssSrc << "};\n"
@@ -171,10 +189,10 @@ std::string BackgroundSubtractorLOBSTER_GLSL::getComputeShaderSource_LOBSTER() c
              "uniform uint nFrameIdx;\n"
              "uniform uint nResamplingRate;\n";
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-    ssSrc << "void main() {\n"
-#if BGSLOBSTER_GLSL_USE_SHAREDMEM
+    ssSrc << "void main() {\n";
+    if(bUsingSharedMem) ssSrc <<
              "    preload_data(mInput);\n"
-             "    barrier();\n"
+             "    barrier();\n";
              //"        if(uvec2(gl_LocalInvocationID.xy)==uvec2(0,0)) {\n"
              //"            for(int y=0; y<" << m_vDefaultWorkGroupSize.y+(LBSP::PATCH_SIZE/2)*2 << "; ++y) {\n"
              //"                for(int x=0; x<" << m_vDefaultWorkGroupSize.x+(LBSP::PATCH_SIZE/2)*2 << "; ++x) {\n"
@@ -184,8 +202,7 @@ std::string BackgroundSubtractorLOBSTER_GLSL::getComputeShaderSource_LOBSTER() c
              //"                }\n"
              //"            }\n"
              //"        }\n"
-#endif //BGSLOBSTER_GLSL_USE_SHAREDMEM
-             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+    ssSrc << "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
              "    uvec4 vSegmResult = uvec4(0);\n"
              "    uint nROIVal = imageLoad(mROI,vImgCoords).r;\n"
              "    uint nModelIdx = gl_GlobalInvocationID.y*MODEL_STEP_SIZE + gl_GlobalInvocationID.x;\n"
@@ -195,7 +212,7 @@ std::string BackgroundSubtractorLOBSTER_GLSL::getComputeShaderSource_LOBSTER() c
              "    uint nGoodSamplesCount=0, nSampleIdx=0;\n"
              "    if(bool(nROIVal)) {\n"
              "        while(/*nGoodSamplesCount<NB_REQ_SAMPLES && */nSampleIdx<NB_SAMPLES) {\n"; // NOTE: CHECKING TWO CONDITIONS AT ONCE IN WHILE EXPRESSION STILL BROKEN AS F*CK (prop 4.4.0 NVIDIA 331.113)
-    if(m_nImgChannels==4) { ssSrc <<
+    if(b4ch) { ssSrc <<
              "            uvec3 vCurrBGColorSample = aoPxModels[nModelIdx].color_samples[nSampleIdx].rgb;\n"
              "            uvec3 vCurrBGIntraDescSample = aoPxModels[nModelIdx].lbsp_samples[nSampleIdx].rgb;\n"
              "            uvec3 vCurrColorDist = absdiff(vInputColor,vCurrBGColorSample);\n"
@@ -273,35 +290,90 @@ std::string BackgroundSubtractorLOBSTER_GLSL::getComputeShaderSource_LOBSTER() c
              "    imageStore(mOutput,vImgCoords,vSegmResult);\n"
              "}\n";
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-    return ssSrc.str();
+    return m_bUsingActiveTiles?getActiveTileMappedSource(ssSrc.str()):ssSrc.str();
 }
 
 std::string BackgroundSubtractorLOBSTER_GLSL::getComputeShaderSource_PostProc() const {
     lvDbgExceptionWatch;
     lvAssert_(m_nDefaultMedianBlurKernelSize>0,"postproc median blur kernel size must be positive");
+    const bool bUsingSharedMem = getIsUsingSharedMem();
     std::stringstream ssSrc;
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     ssSrc << "#version 430\n"
              "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
              //"layout(binding=" << GLImageProcAlgo::Image_ROIBinding << ", r8ui) readonly uniform uimage2D mROI;\n"
              "layout(binding=" << GLImageProcAlgo::Image_OutputBinding << ", r8ui) uniform uimage2D mOutput;\n" <<
-             GLShader::getComputeShaderFunctionSource_BinaryMedianBlur(size_t(m_nDefaultMedianBlurKernelSize),BGSLOBSTER_GLSL_USE_SHAREDMEM,m_vDefaultWorkGroupSize);
+             GLShader::getComputeShaderFunctionSource_BinaryMedianBlur(size_t(m_nDefaultMedianBlurKernelSize),bUsingSharedMem,m_vDefaultWorkGroupSize);
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     ssSrc << "void main() {\n"
-             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n";
            //"    uint nROIVal = imageLoad(mROI,vImgCoords).r;\n"
-#if BGSLOBSTER_GLSL_USE_SHAREDMEM
+    if(bUsingSharedMem) ssSrc <<
              "    preload_data(mOutput);\n"
              "    barrier();\n"
-             "    uint nFinalSegmRes = BinaryMedianBlur(vImgCoords);\n"
-#else //(!BGSLOBSTER_GLSL_USE_SHAREDMEM)
+             "    uint nFinalSegmRes = BinaryMedianBlur(vImgCoords);\n";
+    else ssSrc <<
              "    uint nFinalSegmRes = BinaryMedianBlur(mOutput,vImgCoords);\n"
-             "    barrier();\n"
-#endif //(!BGSLOBSTER_GLSL_USE_SHAREDMEM)
-             "    imageStore(mOutput,vImgCoords,uvec4(nFinalSegmRes));\n"
+             "    barrier();\n";
+    ssSrc << "    imageStore(mOutput,vImgCoords,uvec4(nFinalSegmRes));\n"
              "}\n";
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-    return ssSrc.str();
+    return m_bUsingActiveTiles?getActiveTileMappedSource(ssSrc.str()):ssSrc.str();
+}
+
+std::string BackgroundSubtractorLOBSTER_GLSL::getActiveTileMappedSource(const std::string& sSrc) const {
+    lvDbgExceptionWatch;
+    // all invocation coords (including those used by shared mem preloading & lbsp lookups) are redirected to a global remapped once per invocation
+    const std::string sInvocIDName = "gl_GlobalInvocationID";
+    const std::string sMainDecl = "void main() {\n";
+    const size_t nTileCountX = (m_oFrameSize.width+m_vDefaultWorkGroupSize.x-1)/m_vDefaultWorkGroupSize.x;
+    std::string sMappedSrc = sSrc;
+    for(size_t nPos=sMappedSrc.find(sInvocIDName); nPos!=std::string::npos; nPos=sMappedSrc.find(sInvocIDName,nPos))
+        sMappedSrc.replace(nPos,sInvocIDName.size(),"vTileInvocationID");
+    const size_t nVersionEndPos = sMappedSrc.find('\n');
+    const size_t nMainPos = sMappedSrc.find(sMainDecl);
+    lvAssert_(nVersionEndPos!=std::string::npos && nMainPos!=std::string::npos,"unexpected compute shader source layout");
+    std::stringstream ssMainSrc;
+    ssMainSrc << sMainDecl <<
+             "    uint nTileIdx = anActiveTiles[gl_WorkGroupID.x];\n"
+             "    vTileInvocationID = uvec3(uvec2(nTileIdx%" << nTileCountX << "u,nTileIdx/" << nTileCountX << "u)*gl_WorkGroupSize.xy+gl_LocalInvocationID.xy,0);\n";
+    sMappedSrc.replace(nMainPos,sMainDecl.size(),ssMainSrc.str());
+    std::stringstream ssDeclSrc;
+    ssDeclSrc << "layout(binding=" << BackgroundSubtractorLOBSTER_::LOBSTERStorageBuffer_ActiveTileListBinding << ", std430) readonly buffer bActiveTiles {\n"
+                 "    uint anActiveTiles[];\n"
+                 "};\n"
+                 "uvec3 vTileInvocationID;\n";
+    sMappedSrc.insert(nVersionEndPos+1,ssDeclSrc.str());
+    return sMappedSrc;
+}
+
+void BackgroundSubtractorLOBSTER_GLSL::updateActiveTiles() {
+    lvDbgExceptionWatch;
+    lvDbgAssert(m_bUsingActiveTiles);
+    const size_t nTileCountX = (m_oFrameSize.width+m_vDefaultWorkGroupSize.x-1)/m_vDefaultWorkGroupSize.x;
+    const size_t nTileCountY = (m_oFrameSize.height+m_vDefaultWorkGroupSize.y-1)/m_vDefaultWorkGroupSize.y;
+    const size_t nTileCount = nTileCountX*nTileCountY;
+    // tile flags are only evaluated once per work group size, so they are computed on the cpu, and compacted on the gpu
+    std::vector<GLuint> vnTileFlags(nTileCount);
+    for(size_t nTileRowIdx=0; nTileRowIdx<nTileCountY; ++nTileRowIdx) {
+        for(size_t nTileColIdx=0; nTileColIdx<nTileCountX; ++nTileColIdx) {
+            const cv::Rect oTileRect = cv::Rect(int(nTileColIdx*m_vDefaultWorkGroupSize.x),int(nTileRowIdx*m_vDefaultWorkGroupSize.y),int(m_vDefaultWorkGroupSize.x),int(m_vDefaultWorkGroupSize.y))&cv::Rect(cv::Point(),m_oFrameSize);
+            vnTileFlags[nTileRowIdx*nTileCountX+nTileColIdx] = GLuint(cv::countNonZero(m_oROI(oTileRect))>0);
+        }
+    }
+    const GLShaderStorageBuffer oTileFlags(nTileCount*sizeof(GLuint),vnTileFlags.data(),GL_STATIC_DRAW);
+    m_pActiveTileList = std::make_unique<GLShaderStorageBuffer>(nTileCount*sizeof(GLuint));
+    {
+        GLComputePrimitives oPrimitives;
+        m_nActiveTileCount = oPrimitives.compact(oTileFlags,nTileCount,*m_pActiveTileList);
+    }
+    const std::array<GLuint,3> anDispatchArgs = {(GLuint)m_nActiveTileCount,1,1};
+    m_pActiveTileDispatchArgs = std::make_unique<GLShaderStorageBuffer>(sizeof(anDispatchArgs),anDispatchArgs.data(),GL_STATIC_DRAW);
+    m_vActiveTileSize = m_vDefaultWorkGroupSize;
+    // compute primitives use their own bindings, which overlap the model buffer bindings
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,BackgroundSubtractorLOBSTER_::LOBSTERStorageBuffer_BGModelBinding,getSSBOId(BackgroundSubtractorLOBSTER_::LOBSTERStorageBuffer_BGModelBinding));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,BackgroundSubtractorLOBSTER_::LOBSTERStorageBuffer_TMT32ModelBinding,getSSBOId(BackgroundSubtractorLOBSTER_::LOBSTERStorageBuffer_TMT32ModelBinding));
+    glErrorCheck;
 }
 
 std::string BackgroundSubtractorLOBSTER_GLSL::getComputeShaderSource(size_t nStage) const {
@@ -317,6 +389,10 @@ std::string BackgroundSubtractorLOBSTER_GLSL::getComputeShaderSource(size_t nSta
 void BackgroundSubtractorLOBSTER_GLSL::dispatch(size_t nStage, GLShader& oShader) {
     lvDbgExceptionWatch;
     lvAssert_(nStage<m_nComputeStages,"required compute stage does not exist");
+    if(m_bUsingActiveTiles && m_vActiveTileSize!=m_vDefaultWorkGroupSize) {
+        updateActiveTiles();
+        lvAssert(oShader.activate());
+    }
     if(nStage==0) {
         if(m_dCurrLearningRate>0)
             oShader.setUniform1ui("nResamplingRate",(GLuint)ceil(m_dCurrLearningRate));
@@ -325,7 +401,13 @@ void BackgroundSubtractorLOBSTER_GLSL::dispatch(size_t nStage, GLShader& oShader
     }
     else //nStage==1 && BGSLOBSTER_GLSL_USE_POSTPROC
         glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-    glDispatchCompute((GLuint)ceil((float)m_oFrameSize.width/m_vDefaultWorkGroupSize.x),(GLuint)ceil((float)m_oFrameSize.height/m_vDefaultWorkGroupSize.y),1);
+    if(m_bUsingActiveTiles) {
+        m_pActiveTileList->bind(BackgroundSubtractorLOBSTER_::LOBSTERStorageBuffer_ActiveTileListBinding);
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER,m_pActiveTileDispatchArgs->getSSBOId());
+        glDispatchComputeIndirect(0);
+    }
+    else
+        glDispatchCompute((GLuint)ceil((float)m_oFrameSize.width/m_vDefaultWorkGroupSize.x),(GLuint)ceil((float)m_oFrameSize.height/m_vDefaultWorkGroupSize.y),1);
 }
 
 void BackgroundSubtractorLOBSTER_GLSL::getBackgroundImage(cv::OutputArray oBGImg) const {
@@ -413,44 +495,66 @@ void BackgroundSubtractorLOBSTER::refreshModel(float fSamplesRefreshFrac, bool b
     lvAssert_(m_bInitialized,"algo must be initialized first");
     lvAssert_(fSamplesRefreshFrac>0.0f && fSamplesRefreshFrac<=1.0f,"model refresh must be given as a non-null fraction");
     const size_t nModelSamplesToRefresh = fSamplesRefreshFrac<1.0f?(size_t)(fSamplesRefreshFrac*m_nBGSamples):m_nBGSamples;
-    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?rand()%m_nBGSamples:0;
+    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?m_oRNG()%m_nBGSamples:0;
+    // pixel type & channel count are resolved once here, so that the descriptor & sample loops below are fully specialized
+    if(m_nImgType==CV_16UC1)
+        refreshModelSamples<ushort,1>(nModelSamplesToRefresh,nRefreshSampleStartPos,bForceFGUpdate);
+    else if(m_nImgChannels==1)
+        refreshModelSamples<uchar,1>(nModelSamplesToRefresh,nRefreshSampleStartPos,bForceFGUpdate);
+    else if(m_nImgChannels==3)
+        refreshModelSamples<uchar,3>(nModelSamplesToRefresh,nRefreshSampleStartPos,bForceFGUpdate);
+    else //m_nImgChannels==4
+        refreshModelSamples<uchar,4>(nModelSamplesToRefresh,nRefreshSampleStartPos,bForceFGUpdate);
+}
+
+template<typename TColor, size_t nChannels>
+void BackgroundSubtractorLOBSTER::refreshModelSamples(size_t nModelSamplesToRefresh, size_t nRefreshSampleStartPos, bool bForceFGUpdate) {
+    static_assert(nChannels==1 || nChannels==3 || nChannels==4,"unsupported channel count");
+    static_assert(std::is_same<TColor,uchar>::value || (std::is_same<TColor,ushort>::value && nChannels==1),"unsupported pixel type");
+    lvDbgAssert(m_oLastColorFrame.type()==CV_MAKETYPE(cv::DataType<TColor>::depth,(int)nChannels) && m_oBGSamples.channels()==nChannels);
+    constexpr size_t nMatchChannels = getMatchChannelCount(nChannels);
+    const TColor* const anLastColors = (const TColor*)m_oLastColorFrame.data;
+    // descriptors are computed once for every samplable pixel of the last frame instead of once per drawn sample
+    const int nBorderSize = (int)LBSP::PATCH_SIZE/2;
+    for(int nRowIdx=nBorderSize; nRowIdx<m_oImgSize.height-nBorderSize; ++nRowIdx) {
+        for(int nColIdx=nBorderSize; nColIdx<m_oImgSize.width-nBorderSize; ++nColIdx) {
+            const size_t nPxIter = m_oImgSize.width*nRowIdx + nColIdx;
+            // the padding channel of 4-byte aligned inputs keeps the (null) descriptors computed in initialize_common
+            lv::unroll<nMatchChannels>([&](size_t c) {
+                const TColor nColor = anLastColors[nPxIter*nChannels+c];
+                ushort& nDesc = ((ushort*)m_oLastDescFrame.data)[nPxIter*nChannels+c];
+                LBSP::computeDescriptor<nChannels>(m_oLastColorFrame,nColor,nColIdx,nRowIdx,c,getLBSPThreshold(nColor),nDesc);
+            });
+        }
+    }
     for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
         const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
         if(bForceFGUpdate || !m_oLastFGMask.data[nPxIter]) {
             for(size_t nCurrModelSampleIdx=nRefreshSampleStartPos; nCurrModelSampleIdx<nRefreshSampleStartPos+nModelSamplesToRefresh; ++nCurrModelSampleIdx) {
-                int nSampleImgCoord_Y, nSampleImgCoord_X;
-                cv::getRandSamplePosition_7x7_std2(nSampleImgCoord_X,nSampleImgCoord_Y,m_voPxInfoLUT[nPxIter].nImgCoord_X,m_voPxInfoLUT[nPxIter].nImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
+                const size_t nSamplePxIdx = m_oRandSampleLUT.getRandIdx(nPxIter,m_oRNG);
                 if(bForceFGUpdate || !m_oLastFGMask.data[nSamplePxIdx]) {
                     const size_t nCurrRealModelSampleIdx = nCurrModelSampleIdx%m_nBGSamples;
-                    for(size_t c=0; c<m_nImgChannels; ++c) {
-                        m_voBGColorSamples[nCurrRealModelSampleIdx].data[nPxIter*m_nImgChannels+c] = m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c];
-                        if(m_nImgChannels==1)
-                            LBSP::computeDescriptor<1>(m_oLastColorFrame,m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c],nSampleImgCoord_X,nSampleImgCoord_Y,0,m_anLBSPThreshold_8bitLUT[m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c]],*((ushort*)(m_oLastDescFrame.data+(nSamplePxIdx*m_nImgChannels+c)*2)));
-                        else if(m_nImgChannels==3)
-                            LBSP::computeDescriptor<3>(m_oLastColorFrame,m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c],nSampleImgCoord_X,nSampleImgCoord_Y,c,m_anLBSPThreshold_8bitLUT[m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c]],*((ushort*)(m_oLastDescFrame.data+(nSamplePxIdx*m_nImgChannels+c)*2)));
-                        else //m_nImgChannels==4
-                            LBSP::computeDescriptor<4>(m_oLastColorFrame,m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c],nSampleImgCoord_X,nSampleImgCoord_Y,c,m_anLBSPThreshold_8bitLUT[m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c]],*((ushort*)(m_oLastDescFrame.data+(nSamplePxIdx*m_nImgChannels+c)*2)));
-                        *((ushort*)(m_voBGDescSamples[nCurrRealModelSampleIdx].data+(nPxIter*m_nImgChannels+c)*2)) = *((ushort*)(m_oLastDescFrame.data+(nSamplePxIdx*m_nImgChannels+c)*2));
-                    }
+                    m_oBGSamples.setSample<nChannels>(nCurrRealModelSampleIdx,nPxIter,anLastColors+nSamplePxIdx*nChannels,((const ushort*)m_oLastDescFrame.data)+nSamplePxIdx*nChannels);
                 }
             }
         }
     }
 }
 
-void BackgroundSubtractorLOBSTER::initialize(const cv::Mat& oInitImg, const cv::Mat& oROI) {
+void BackgroundSubtractorLOBSTER::initialize(const cv::Mat& _oInitImg, const cv::Mat& _oROI) {
     lvDbgExceptionWatch;
     // == init
+    cv::Mat oInitImg,oROI;
+    scaleInitData(_oInitImg,_oROI,oInitImg,oROI);
+    lvAssert_(oInitImg.depth()==CV_8U || oInitImg.type()==CV_16UC1,"16-bit inputs must be single-channel");
     IBackgroundSubtractorLBSP::initialize_common(oInitImg,oROI);
-    m_voBGColorSamples.resize(m_nBGSamples);
-    m_voBGDescSamples.resize(m_nBGSamples);
-    for(size_t s=0; s<m_nBGSamples; ++s) {
-        m_voBGColorSamples[s].create(m_oImgSize,CV_8UC((int)m_nImgChannels));
-        m_voBGColorSamples[s] = cv::Scalar_<uchar>::all(0);
-        m_voBGDescSamples[s].create(m_oImgSize,CV_16UC((int)m_nImgChannels));
-        m_voBGDescSamples[s] = cv::Scalar_<ushort>::all(0);
+    m_oBGSamples.create(m_oImgSize,m_nImgChannels,m_nBGSamples,m_bUsingInterleavedSamples,oInitImg.depth(),getModelMatAllocator(),(oInitImg.depth()==CV_8U)?m_nDedupSampleSlots:0);
+    if(m_bUsingChangeGating) {
+        m_oLastRawFGMask.create(m_oImgSize,CV_8UC1);
+        m_oLastRawFGMask = cv::Scalar_<uchar>(0);
     }
+    else
+        m_oLastRawFGMask.release();
     m_bInitialized = true;
     refreshModel(1.0f,true);
     m_bModelInitialized = true;
@@ -461,162 +565,350 @@ void BackgroundSubtractorLOBSTER::apply(cv::InputArray _oInputImg, cv::OutputArr
     // == process_sync
     lvAssert_(m_bInitialized && m_bModelInitialized,"algo & model must be initialized first");
     lvAssert_(dLearningRate>0,"learning rate must be a positive value; faster learning is achieved with smaller values");
-    cv::Mat oInputImg = _oInputImg.getMat();
+    LV_PROFILE_SCOPE("LOBSTER::apply");
+    const GovernorScope oGovernorScope(this,_oInputImg);
+    std::mutex_lock_guard oModelLock(m_oModelMutex);
+    BGS_INSTR_SCOPED_TIMER(Stage_Total);
+    BGS_INSTR_ADD_COUNT(Counter_Frames,1);
+    const cv::Mat oOrigInputImg = _oInputImg.getMat();
+    cv::Mat oInputImg = getScaledInput(oOrigInputImg);
     lvAssert_(oInputImg.type()==m_nImgType && oInputImg.size()==m_oImgSize,"input image type/size mismatch with initialization type/size");
     lvAssert_(oInputImg.isContinuous(),"input image data must be continuous");
-    _oFGMask.create(m_oImgSize,CV_8UC1);
-    cv::Mat oCurrFGMask = _oFGMask.getMat();
+    cv::Mat oCurrFGMask = getScaledOutputMask(_oFGMask);
     oCurrFGMask = cv::Scalar_<uchar>(0);
-    const size_t nLearningRate = std::isinf(dLearningRate)?SIZE_MAX:(size_t)ceil(dLearningRate);
-    if(m_nImgChannels==1) {
+    const size_t nLearningRate = std::isinf(dLearningRate)?SIZE_MAX:(size_t)ceil(getGovernedLearningRate(dLearningRate));
+    bool bRawMaskUnchanged = false;
+    {
+        BGS_INSTR_SCOPED_TIMER(Stage_PixelLoop);
+        const bool bUseChangeGate = updateChangeGate(oInputImg);
+        segment(oInputImg,oCurrFGMask,nLearningRate,true,bUseChangeGate);
+        if(!m_oLastRawFGMask.empty()) {
+            // whole-frame gate: if no tile changed and no refreshed pixel flipped, the last post-processed mask is still valid
+            bRawMaskUnchanged = bUseChangeGate && m_nChangeGateChangedTiles==0 && cv::norm(oCurrFGMask,m_oLastRawFGMask,cv::NORM_INF)==0;
+            oCurrFGMask.copyTo(m_oLastRawFGMask);
+        }
+    }
+    {
+        BGS_INSTR_SCOPED_TIMER(Stage_PostProc);
+        if(!bRawMaskUnchanged)
+            lv::binaryMedianBlur(oCurrFGMask,m_oLastFGMask,getGovernedMedianBlurKernelSize(m_nDefaultMedianBlurKernelSize));
+        const cv::Rect oPostProcRect(cv::Point(0,0),m_oImgSize);
+        if(FGBlobLabeler* pBlobLabeler = beginBlobExtraction(oPostProcRect))
+            pBlobLabeler->processRows(m_oLastFGMask,0,m_oLastFGMask.rows);
+        endBlobExtraction(oPostProcRect);
+        m_oLastFGMask.copyTo(oCurrFGMask);
+    }
+    oInputImg.copyTo(m_oLastColorFrame);
+    // background images are refreshed while the model lock is held anyway, so that readers never have to wait for a whole frame
+    m_oBGMeanImgs.publish(m_oBGSamples);
+    upscaleOutputMask(oCurrFGMask,_oFGMask,oOrigInputImg);
+}
+
+void BackgroundSubtractorLOBSTER::classify(cv::InputArray _oInputImg, cv::OutputArray _oFGMask) {
+    lvDbgExceptionWatch;
+    lvAssert_(m_bInitialized && m_bModelInitialized,"algo & model must be initialized first");
+    const cv::Mat oOrigInputImg = _oInputImg.getMat();
+    cv::Mat oInputImg = getScaledInput(oOrigInputImg);
+    lvAssert_(oInputImg.type()==m_nImgType && oInputImg.size()==m_oImgSize,"input image type/size mismatch with initialization type/size");
+    lvAssert_(oInputImg.isContinuous(),"input image data must be continuous");
+    cv::Mat oCurrFGMask = getScaledOutputMask(_oFGMask);
+    oCurrFGMask = cv::Scalar_<uchar>(0);
+    segment(oInputImg,oCurrFGMask,SIZE_MAX,false);
+    cv::Mat oBlurredFGMask = getScratchBuffer(ScratchBuffer_FGMask_Blurred,m_oImgSize,CV_8UC1);
+    lv::binaryMedianBlur(oCurrFGMask,oBlurredFGMask,getGovernedMedianBlurKernelSize(m_nDefaultMedianBlurKernelSize));
+    const cv::Rect oPostProcRect(cv::Point(0,0),m_oImgSize);
+    if(FGBlobLabeler* pBlobLabeler = beginBlobExtraction(oPostProcRect))
+        pBlobLabeler->processRows(oBlurredFGMask,0,oBlurredFGMask.rows);
+    endBlobExtraction(oPostProcRect);
+    oBlurredFGMask.copyTo(oCurrFGMask);
+    upscaleOutputMask(oCurrFGMask,_oFGMask,oOrigInputImg);
+}
+
+void BackgroundSubtractorLOBSTER::update(cv::InputArray _oInputImg, double dLearningRate) {
+    lvDbgExceptionWatch;
+    lvAssert_(m_bInitialized && m_bModelInitialized,"algo & model must be initialized first");
+    if(dLearningRate<0)
+        dLearningRate = getDefaultLearningRate();
+    lvAssert_(dLearningRate>0,"learning rate must be a positive value; faster learning is achieved with smaller values");
+    LV_PROFILE_SCOPE("LOBSTER::update");
+    std::mutex_lock_guard oModelLock(m_oModelMutex);
+    const cv::Mat oInputImg = getScaledInput(_oInputImg.getMat());
+    lvAssert_(oInputImg.type()==m_nImgType && oInputImg.size()==m_oImgSize,"input image type/size mismatch with initialization type/size");
+    lvAssert_(oInputImg.isContinuous(),"input image data must be continuous");
+    const size_t nLearningRate = std::isinf(dLearningRate)?SIZE_MAX:(size_t)ceil(getGovernedLearningRate(dLearningRate));
+    if(nLearningRate!=SIZE_MAX) {
+        m_oUpdateFGMask.create(m_oImgSize,CV_8UC1);
+        segment(oInputImg,m_oUpdateFGMask,nLearningRate,true,false,true);
+    }
+    // the last frame is kept for model refreshes, as in 'apply' (the last FG mask is left as is, since no segmentation is done here)
+    oInputImg.copyTo(m_oLastColorFrame);
+    m_oBGMeanImgs.publish(m_oBGSamples);
+}
+
+void BackgroundSubtractorLOBSTER::segment(const cv::Mat& oInputImg, cv::Mat& oCurrFGMask, size_t nLearningRate, bool bUpdateModel, bool bUseChangeGate, bool bUpdateOnly) {
+    size_t nSamplesTested = 0, nEarlyExits = 0;
+    if(m_nImgType==CV_16UC1)
+        segmentPixels<ushort,1>(oInputImg,oCurrFGMask,nLearningRate,bUpdateModel,bUseChangeGate,bUpdateOnly,nSamplesTested,nEarlyExits);
+    else if(m_nImgChannels==1)
+        segmentPixels<uchar,1>(oInputImg,oCurrFGMask,nLearningRate,bUpdateModel,bUseChangeGate,bUpdateOnly,nSamplesTested,nEarlyExits);
+    else if(m_nImgChannels==3)
+        segmentPixels<uchar,3>(oInputImg,oCurrFGMask,nLearningRate,bUpdateModel,bUseChangeGate,bUpdateOnly,nSamplesTested,nEarlyExits);
+    else //m_nImgChannels==4
+        segmentPixels<uchar,4>(oInputImg,oCurrFGMask,nLearningRate,bUpdateModel,bUseChangeGate,bUpdateOnly,nSamplesTested,nEarlyExits);
+    BGS_INSTR_ADD_COUNT(Counter_Pixels,m_nTotRelevantPxCount);
+    BGS_INSTR_ADD_COUNT(Counter_SamplesTested,nSamplesTested);
+    BGS_INSTR_ADD_COUNT(Counter_EarlyExits,nEarlyExits);
+}
+
+template<typename TColor, size_t nChannels>
+void BackgroundSubtractorLOBSTER::segmentPixels(const cv::Mat& oInputImg, cv::Mat& oCurrFGMask, size_t nLearningRate, bool bUpdateModel, bool bUseChangeGate, bool bUpdateOnly, size_t& nSamplesTested, size_t& nEarlyExits) {
+    static_assert(nChannels==1 || nChannels==3 || nChannels==4,"unsupported channel count");
+    static_assert(std::is_same<TColor,uchar>::value || (std::is_same<TColor,ushort>::value && nChannels==1),"unsupported pixel type");
+    lvDbgAssert(oInputImg.type()==CV_MAKETYPE(cv::DataType<TColor>::depth,(int)nChannels) && m_oBGSamples.channels()==nChannels);
+    lvDbgAssert(!bUseChangeGate || m_oLastRawFGMask.size()==oCurrFGMask.size());
+    lvDbgAssert(!bUpdateOnly || (bUpdateModel && !bUseChangeGate));
+    // pixels of unchanged tiles keep their last raw label, except for a random subset which is segmented (and updates the model) as usual
+    const auto lIsGatedPx = [&](size_t nPxIter) {
+        return bUseChangeGate && isChangeGatedPx(nPxIter) && (m_oRNG()%m_nChangeGateRefreshRate)!=0;
+    };
+    // in update-only mode, both update draws of a pixel are made before matching it, and pixels with no successful draw are skipped
+    bool bUpdateSelf = false, bUpdateNeighbor = false;
+    const auto lIsSkippedPx = [&]() {
+        if(!bUpdateOnly)
+            return false;
+        bUpdateSelf = (m_oRNG()%nLearningRate)==0;
+        bUpdateNeighbor = (m_oRNG()%nLearningRate)==0;
+        return !bUpdateSelf && !bUpdateNeighbor;
+    };
+    const auto lDrawUpdate = [&](bool bPreDrawnUpdate) {
+        return bUpdateOnly?bPreDrawnUpdate:(m_oRNG()%nLearningRate)==0;
+    };
+    const bool bUsingBlockMatching = m_bUsingBlockMatching || m_oBGSamples.isInterleaved();
+    // under load, the governor restricts matching & updates to the first samples of the model
+    const size_t nActiveSamples = getGovernedSampleCount(m_nBGSamples,m_nRequiredBGSamples);
+    // in deduplicated layout, all slots are matched (each one counting as many matches as it holds samples), and the governor only restricts updates
+    const bool bDeduplicated = m_oBGSamples.isDeduplicated();
+    const size_t nMatchSlots = bDeduplicated?m_oBGSamples.slots():nActiveSamples;
+    if(nChannels==1) {
+        // the color threshold is scaled up from its 8-bit equivalent for 16-bit inputs
+        const size_t nCurrColorDistThreshold = (m_nColorDistThreshold/2)*getColorDistScale<TColor>();
         for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
             const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
-            const size_t nDescIter = nPxIter*2;
+            if(lIsGatedPx(nPxIter)) {
+                oCurrFGMask.data[nPxIter] = m_oLastRawFGMask.data[nPxIter];
+                continue;
+            }
+            if(lIsSkippedPx())
+                continue;
             const int nCurrImgCoord_X = m_voPxInfoLUT[nPxIter].nImgCoord_X;
             const int nCurrImgCoord_Y = m_voPxInfoLUT[nPxIter].nImgCoord_Y;
-            const uchar nCurrColor = oInputImg.data[nPxIter];
-            alignas(16) std::array<uchar,LBSP::DESC_SIZE_BITS> anLBSPLookupVals;
+            const TColor nCurrColor = ((const TColor*)oInputImg.data)[nPxIter];
+            alignas(16) std::array<TColor,LBSP::DESC_SIZE_BITS> anLBSPLookupVals;
             LBSP::computeDescriptor_lookup<1>(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,0,anLBSPLookupVals);
             size_t nGoodSamplesCount=0, nModelIdx=0;
-            while(nGoodSamplesCount<m_nRequiredBGSamples && nModelIdx<m_nBGSamples) {
-                const uchar nBGColor = m_voBGColorSamples[nModelIdx].data[nPxIter];
-                {
-                    const size_t nColorDist = lv::L1dist(nCurrColor,nBGColor);
-                    if(nColorDist>m_nColorDistThreshold/2)
-                        goto failedcheck1ch;
-                    const ushort nCurrInputDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nBGColor,m_anLBSPThreshold_8bitLUT[nBGColor]);
-                    const size_t nDescDist = lv::hdist(nCurrInputDesc,*((ushort*)(m_voBGDescSamples[nModelIdx].data+nDescIter)));
-                    if(nDescDist>m_nDescDistThreshold)
-                        goto failedcheck1ch;
-                    nGoodSamplesCount++;
+            while(nGoodSamplesCount<m_nRequiredBGSamples && nModelIdx<nMatchSlots) {
+                const size_t nBlockSampleCount = std::min(LBSPSampleModel::MATCH_BLOCK_SIZE,nMatchSlots-nModelIdx);
+                uint nCandidateMask = bUsingBlockMatching?m_oBGSamples.getColorMatchMask(nPxIter,nModelIdx,nBlockSampleCount,&nCurrColor,nCurrColorDistThreshold,nCurrColorDistThreshold):((1u<<nBlockSampleCount)-1);
+                if(!bDeduplicated && nGoodSamplesCount+lv::popcount(nCandidateMask)+(nActiveSamples-nModelIdx-nBlockSampleCount)<m_nRequiredBGSamples)
+                    break; // not enough candidates left to classify as background
+                while(nCandidateMask && nGoodSamplesCount<m_nRequiredBGSamples) {
+                    const size_t nCandidateIdx = nModelIdx+lv::popcount((nCandidateMask&(~nCandidateMask+1))-1);
+                    nCandidateMask &= nCandidateMask-1;
+                    ++nSamplesTested;
+                    const TColor nBGColor = *m_oBGSamples.colorAs<TColor>(nCandidateIdx,nPxIter);
+                    {
+                        const size_t nColorDist = lv::L1dist(nCurrColor,nBGColor);
+                        if(nColorDist>nCurrColorDistThreshold)
+                            goto failedcheck1ch;
+                        const ushort nCurrInputDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nBGColor,getLBSPThreshold(nBGColor));
+                        const size_t nDescDist = lv::hdist(nCurrInputDesc,*m_oBGSamples.desc(nCandidateIdx,nPxIter));
+                        if(nDescDist>m_nDescDistThreshold)
+                            goto failedcheck1ch;
+                        nGoodSamplesCount += m_oBGSamples.weight(nCandidateIdx,nPxIter);
+                    }
+                    failedcheck1ch:;
                 }
-                failedcheck1ch:
-                nModelIdx++;
+                nModelIdx += nBlockSampleCount;
             }
+            if(nModelIdx<nMatchSlots)
+                ++nEarlyExits;
             if(nGoodSamplesCount<m_nRequiredBGSamples)
                 oCurrFGMask.data[nPxIter] = UCHAR_MAX;
-            else {
-                if((rand()%nLearningRate)==0) {
-                    const size_t nSampleModelIdx = rand()%m_nBGSamples;
-                    ushort& nRandInputDesc = *((ushort*)(m_voBGDescSamples[nSampleModelIdx].data+nDescIter));
-                    nRandInputDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nCurrColor,m_anLBSPThreshold_8bitLUT[nCurrColor]);
-                    m_voBGColorSamples[nSampleModelIdx].data[nPxIter] = nCurrColor;
+            else if(bUpdateModel) {
+                if(lDrawUpdate(bUpdateSelf)) {
+                    const size_t nSampleModelIdx = m_oRNG()%nActiveSamples;
+                    const ushort nRandInputDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nCurrColor,getLBSPThreshold(nCurrColor));
+                    m_oBGSamples.setSample<1>(nSampleModelIdx,nPxIter,&nCurrColor,&nRandInputDesc);
                 }
-                if((rand()%nLearningRate)==0) {
-                    int nSampleImgCoord_Y, nSampleImgCoord_X;
-                    cv::getRandNeighborPosition_3x3(nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                    const size_t nSampleModelIdx = rand()%m_nBGSamples;
-                    ushort& nRandInputDesc = m_voBGDescSamples[nSampleModelIdx].at<ushort>(nSampleImgCoord_Y,nSampleImgCoord_X);
-                    nRandInputDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nCurrColor,m_anLBSPThreshold_8bitLUT[nCurrColor]);
-                    m_voBGColorSamples[nSampleModelIdx].at<uchar>(nSampleImgCoord_Y,nSampleImgCoord_X) = nCurrColor;
+                if(lDrawUpdate(bUpdateNeighbor)) {
+                    const size_t nSamplePxIdx = m_oRandNeighborLUT_3x3.getRandIdx(nPxIter,m_oRNG);
+                    const size_t nSampleModelIdx = m_oRNG()%nActiveSamples;
+                    const ushort nRandInputDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nCurrColor,getLBSPThreshold(nCurrColor));
+                    m_oBGSamples.setSample<1>(nSampleModelIdx,nSamplePxIdx,&nCurrColor,&nRandInputDesc);
                 }
             }
         }
     }
-    else { //m_nImgChannels==3
-        const size_t nCurrDescDistThreshold = m_nDescDistThreshold*3;
-        const size_t nCurrColorDistThreshold = m_nColorDistThreshold*3;
+    else { //nChannels==3 || nChannels==4
+        constexpr size_t nMatchChannels = getMatchChannelCount(nChannels);
+        const size_t nCurrDescDistThreshold = m_nDescDistThreshold*nMatchChannels;
+        const size_t nCurrColorDistThreshold = m_nColorDistThreshold*nMatchChannels;
         const size_t nCurrSCDescDistThreshold = nCurrDescDistThreshold/2;
         const size_t nCurrSCColorDistThreshold = nCurrColorDistThreshold/2;
-        const size_t desc_row_step = m_voBGDescSamples[0].step.p[0];
-        const size_t img_row_step = m_voBGColorSamples[0].step.p[0];
         for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
             const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
+            if(lIsGatedPx(nPxIter)) {
+                oCurrFGMask.data[nPxIter] = m_oLastRawFGMask.data[nPxIter];
+                continue;
+            }
+            if(lIsSkippedPx())
+                continue;
             const int nCurrImgCoord_X = m_voPxInfoLUT[nPxIter].nImgCoord_X;
             const int nCurrImgCoord_Y = m_voPxInfoLUT[nPxIter].nImgCoord_Y;
-            const size_t nPxIterRGB = nPxIter*3;
-            const size_t nDescIterRGB = nPxIterRGB*2;
+            const size_t nPxIterRGB = nPxIter*nChannels;
             const uchar* const anCurrColor = oInputImg.data+nPxIterRGB;
-            alignas(16) std::array<std::array<uchar,LBSP::DESC_SIZE_BITS>,3> aanLBSPLookupVals;
-            LBSP::computeDescriptor_lookup(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,aanLBSPLookupVals);
+            alignas(16) std::array<std::array<uchar,LBSP::DESC_SIZE_BITS>,nMatchChannels> aanLBSPLookupVals;
+            computeMatchLookupVals<nChannels>(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,aanLBSPLookupVals);
             size_t nGoodSamplesCount=0, nModelIdx=0;
-            while(nGoodSamplesCount<m_nRequiredBGSamples && nModelIdx<m_nBGSamples) {
-                const ushort* const anBGDesc = (ushort*)(m_voBGDescSamples[nModelIdx].data+nDescIterRGB);
-                const uchar* const anBGColor = m_voBGColorSamples[nModelIdx].data+nPxIterRGB;
-                size_t nTotColorDist = 0;
-                size_t nTotDescDist = 0;
-                for(size_t c=0;c<3; ++c) {
-                    const size_t nColorDist = lv::L1dist(anCurrColor[c],anBGColor[c]);
-                    if(nColorDist>nCurrSCColorDistThreshold)
-                        goto failedcheck3ch;
-                    const ushort nCurrInputDesc = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anBGColor[c],m_anLBSPThreshold_8bitLUT[anBGColor[c]]);
-                    const size_t nDescDist = lv::hdist(nCurrInputDesc,anBGDesc[c]);
-                    if(nDescDist>nCurrSCDescDistThreshold)
-                        goto failedcheck3ch;
-                    nTotColorDist += nColorDist;
-                    nTotDescDist += nDescDist;
+            while(nGoodSamplesCount<m_nRequiredBGSamples && nModelIdx<nMatchSlots) {
+                const size_t nBlockSampleCount = std::min(LBSPSampleModel::MATCH_BLOCK_SIZE,nMatchSlots-nModelIdx);
+                uint nCandidateMask = bUsingBlockMatching?m_oBGSamples.getColorMatchMask(nPxIter,nModelIdx,nBlockSampleCount,anCurrColor,nCurrSCColorDistThreshold,nCurrColorDistThreshold):((1u<<nBlockSampleCount)-1);
+                if(!bDeduplicated && nGoodSamplesCount+lv::popcount(nCandidateMask)+(nActiveSamples-nModelIdx-nBlockSampleCount)<m_nRequiredBGSamples)
+                    break; // not enough candidates left to classify as background
+                while(nCandidateMask && nGoodSamplesCount<m_nRequiredBGSamples) {
+                    const size_t nCandidateIdx = nModelIdx+lv::popcount((nCandidateMask&(~nCandidateMask+1))-1);
+                    nCandidateMask &= nCandidateMask-1;
+                    ++nSamplesTested;
+                    const ushort* const anBGDesc = m_oBGSamples.desc(nCandidateIdx,nPxIter);
+                    const uchar* const anBGColor = m_oBGSamples.color(nCandidateIdx,nPxIter);
+                    size_t nTotColorDist = 0;
+                    size_t nTotDescDist = 0;
+                    for(size_t c=0; c<nMatchChannels; ++c) {
+                        const size_t nColorDist = lv::L1dist(anCurrColor[c],anBGColor[c]);
+                        if(nColorDist>nCurrSCColorDistThreshold)
+                            goto failedcheck3ch;
+                        const ushort nCurrInputDesc = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anBGColor[c],m_anLBSPThreshold_8bitLUT[anBGColor[c]]);
+                        const size_t nDescDist = lv::hdist(nCurrInputDesc,anBGDesc[c]);
+                        if(nDescDist>nCurrSCDescDistThreshold)
+                            goto failedcheck3ch;
+                        nTotColorDist += nColorDist;
+                        nTotDescDist += nDescDist;
+                    }
+                    if(nTotDescDist<=nCurrDescDistThreshold && nTotColorDist<=nCurrColorDistThreshold)
+                        nGoodSamplesCount += m_oBGSamples.weight(nCandidateIdx,nPxIter);
+                    failedcheck3ch:;
                 }
-                if(nTotDescDist<=nCurrDescDistThreshold && nTotColorDist<=nCurrColorDistThreshold)
-                    nGoodSamplesCount++;
-                failedcheck3ch:
-                nModelIdx++;
+                nModelIdx += nBlockSampleCount;
             }
+            if(nModelIdx<nMatchSlots)
+                ++nEarlyExits;
             if(nGoodSamplesCount<m_nRequiredBGSamples)
                 oCurrFGMask.data[nPxIter] = UCHAR_MAX;
-            else {
-                if((rand()%nLearningRate)==0) {
-                    const size_t nSampleModelIdx = rand()%m_nBGSamples;
-                    ushort* anRandInputDesc = ((ushort*)(m_voBGDescSamples[nSampleModelIdx].data+nDescIterRGB));
-                    for(size_t c=0; c<3; ++c) {
-                        *(m_voBGColorSamples[nSampleModelIdx].data+nPxIterRGB+c) = anCurrColor[c];
+            else if(bUpdateModel) {
+                if(lDrawUpdate(bUpdateSelf)) {
+                    const size_t nSampleModelIdx = m_oRNG()%nActiveSamples;
+                    std::array<ushort,nChannels> anRandInputDesc = {}; // padding channel descriptors stay null
+                    for(size_t c=0; c<nMatchChannels; ++c)
                         anRandInputDesc[c] = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anCurrColor[c],m_anLBSPThreshold_8bitLUT[anCurrColor[c]]);
-                    }
+                    m_oBGSamples.setSample<nChannels>(nSampleModelIdx,nPxIter,anCurrColor,anRandInputDesc.data());
                 }
-                if((rand()%nLearningRate)==0) {
-                    int nSampleImgCoord_Y, nSampleImgCoord_X;
-                    cv::getRandNeighborPosition_3x3(nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                    const size_t nSampleModelIdx = rand()%m_nBGSamples;
-                    ushort* anRandInputDesc = ((ushort*)(m_voBGDescSamples[nSampleModelIdx].data + desc_row_step*nSampleImgCoord_Y + 6*nSampleImgCoord_X));
-                    for(size_t c=0; c<3; ++c) {
-                        *(m_voBGColorSamples[nSampleModelIdx].data+img_row_step*nSampleImgCoord_Y+3*nSampleImgCoord_X+c) = anCurrColor[c];
+                if(lDrawUpdate(bUpdateNeighbor)) {
+                    const size_t nSamplePxIdx = m_oRandNeighborLUT_3x3.getRandIdx(nPxIter,m_oRNG);
+                    const size_t nSampleModelIdx = m_oRNG()%nActiveSamples;
+                    std::array<ushort,nChannels> anRandInputDesc = {}; // padding channel descriptors stay null
+                    for(size_t c=0; c<nMatchChannels; ++c)
                         anRandInputDesc[c] = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anCurrColor[c],m_anLBSPThreshold_8bitLUT[anCurrColor[c]]);
-                    }
+                    m_oBGSamples.setSample<nChannels>(nSampleModelIdx,nSamplePxIdx,anCurrColor,anRandInputDesc.data());
                 }
             }
         }
     }
-    cv::medianBlur(oCurrFGMask,m_oLastFGMask,m_nDefaultMedianBlurKernelSize);
-    m_oLastFGMask.copyTo(oCurrFGMask);
-    oInputImg.copyTo(m_oLastColorFrame);
 }
 
 void BackgroundSubtractorLOBSTER::getBackgroundImage(cv::OutputArray oBGImg) const {
     lvDbgExceptionWatch;
     lvAssert_(m_bInitialized,"algo must be initialized first");
-    cv::Mat oAvgBGImg = cv::Mat::zeros(m_oImgSize,CV_32FC((int)m_nImgChannels));
-    for(size_t s=0; s<m_nBGSamples; ++s) {
-        for(int y=0; y<m_oImgSize.height; ++y) {
-            for(int x=0; x<m_oImgSize.width; ++x) {
-                const size_t idx_nimg = m_voBGColorSamples[s].step.p[0]*y + m_voBGColorSamples[s].step.p[1]*x;
-                const size_t idx_flt32 = idx_nimg*4;
-                float* oAvgBgImgPtr = (float*)(oAvgBGImg.data+idx_flt32);
-                const uchar* const oBGImgPtr = m_voBGColorSamples[s].data+idx_nimg;
-                for(size_t c=0; c<m_nImgChannels; ++c)
-                    oAvgBgImgPtr[c] += ((float)oBGImgPtr[c])/m_nBGSamples;
-            }
-        }
-    }
-    oAvgBGImg.convertTo(oBGImg,CV_8U);
+    // if 'apply' or 'update' is running, the images published at the end of the previous call are returned without waiting on it
+    m_oBGMeanImgs.publishIfIdle(m_oBGSamples,m_oModelMutex);
+    m_oBGMeanImgs.getColorImage(oBGImg);
 }
 
 void BackgroundSubtractorLOBSTER::getBackgroundDescriptorsImage(cv::OutputArray oBGDescImg) const {
     static_assert(LBSP::DESC_SIZE==2,"bad assumptions in impl below");
     lvDbgExceptionWatch;
     lvAssert_(m_bInitialized,"algo must be initialized first");
-    cv::Mat oAvgBGDesc = cv::Mat::zeros(m_oImgSize,CV_32FC((int)m_nImgChannels));
-    for(size_t n=0; n<m_voBGDescSamples.size(); ++n) {
-        for(int y=0; y<m_oImgSize.height; ++y) {
-            for(int x=0; x<m_oImgSize.width; ++x) {
-                const size_t idx_ndesc = m_voBGDescSamples[n].step.p[0]*y + m_voBGDescSamples[n].step.p[1]*x;
-                const size_t idx_flt32 = idx_ndesc*2;
-                float* oAvgBgDescPtr = (float*)(oAvgBGDesc.data+idx_flt32);
-                const ushort* const oBGDescPtr = (ushort*)(m_voBGDescSamples[n].data+idx_ndesc);
-                for(size_t c=0; c<m_nImgChannels; ++c)
-                    oAvgBgDescPtr[c] += ((float)oBGDescPtr[c])/m_voBGDescSamples.size();
-            }
-        }
+    m_oBGMeanImgs.publishIfIdle(m_oBGSamples,m_oModelMutex);
+    m_oBGMeanImgs.getDescImage(oBGDescImg);
+}
+
+void BackgroundSubtractorLOBSTER::setInterleavedSampleModel(bool bInterleaved) {
+    m_bUsingInterleavedSamples = bInterleaved;
+    if(m_bInitialized) {
+        // converts the current model in-place if its layout differs (16-bit models always keep the regular layout)
+        std::mutex_lock_guard oModelLock(m_oModelMutex);
+        m_oBGSamples.setLayout(m_bUsingInterleavedSamples,(m_oBGSamples.colorDepth()==CV_8U)?m_nDedupSampleSlots:0);
     }
-    oAvgBGDesc.convertTo(oBGDescImg,CV_16U);
+}
+
+void BackgroundSubtractorLOBSTER::setDeduplicatedSampleModel(bool bEnabled, size_t nMaxDistinctSamples) {
+    lvAssert_(!bEnabled || (nMaxDistinctSamples>0 && nMaxDistinctSamples<=LBSPSampleModel::MAX_SLOTS && m_nBGSamples<=LBSPSampleModel::MAX_SLOTS),"bad distinct sample count (or too many samples per pixel for deduplication)");
+    m_nDedupSampleSlots = bEnabled?nMaxDistinctSamples:0;
+    setInterleavedSampleModel(m_bUsingInterleavedSamples);
+}
+
+void BackgroundSubtractorLOBSTER::setModelCapacity(size_t nBGSamples) {
+    lvAssert_(nBGSamples>0 && m_nRequiredBGSamples<=nBGSamples,"algo cannot require more sample matches than sample count in model");
+    lvAssert_(!m_nDedupSampleSlots || nBGSamples<=LBSPSampleModel::MAX_SLOTS,"deduplicated sample layout supports at most 255 samples per pixel");
+    std::mutex_lock_guard oModelLock(m_oModelMutex);
+    if(m_bInitialized && nBGSamples!=m_nBGSamples)
+        m_oBGSamples.resizeSamples(nBGSamples);
+    m_nBGSamples = nBGSamples;
+}
+
+std::shared_ptr<IIBackgroundSubtractor> BackgroundSubtractorLOBSTER::createInstance() const {
+    auto pClone = std::make_shared<BackgroundSubtractorLOBSTER>(m_nDescDistThreshold,m_nColorDistThreshold,m_nBGSamples,m_nRequiredBGSamples,m_nLBSPThresholdOffset,m_fRelLBSPThreshold);
+    pClone->setDescriptorCache(m_bUsingDescCache,m_nDescCacheNoiseFloor);
+    pClone->setBlockSampleMatching(m_bUsingBlockMatching);
+    pClone->setInterleavedSampleModel(m_bUsingInterleavedSamples);
+    pClone->setDeduplicatedSampleModel(m_nDedupSampleSlots>0,m_nDedupSampleSlots?m_nDedupSampleSlots:BGSLBSP_DEFAULT_DEDUP_SAMPLE_SLOTS);
+    return pClone;
+}
+
+void BackgroundSubtractorLOBSTER::writeModelState(std::ostream& oStream) const {
+    writeLBSPModelState(oStream);
+    if(!m_pModelCloneSource) // samples are shared directly with clones instead
+        m_oBGSamples.write(oStream);
+}
+
+void BackgroundSubtractorLOBSTER::readModelState(std::istream& oStream) {
+    lvAssert_(m_bInitialized,"algorithm must be initialized before its model state is read");
+    readLBSPModelState(oStream);
+    if(m_pModelCloneSource) {
+        BackgroundSubtractorLOBSTER* const pSource = static_cast<BackgroundSubtractorLOBSTER*>(m_pModelCloneSource);
+        std::mutex_lock_guard oModelLock(pSource->m_oModelMutex);
+        pSource->m_oBGSamples.cloneCOW(m_oBGSamples);
+    }
+    else
+        m_oBGSamples.read(oStream);
+    lvAssert_(m_oBGSamples.samples()>=m_nRequiredBGSamples && m_oBGSamples.channels()==m_nImgChannels && m_oBGSamples.colorDepth()==CV_MAT_DEPTH(m_nImgType),"model snapshot sample count mismatch");
+    m_nBGSamples = m_oBGSamples.samples();
+    setInterleavedSampleModel(m_bUsingInterleavedSamples);
+}
+
+bool BackgroundSubtractorLOBSTER::updateModelROI(const cv::Mat& oNewROI, size_t nOrigROIPxCount) {
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    std::mutex_lock_guard oModelLock(m_oModelMutex);
+    std::vector<std::pair<size_t,size_t>> vAddedPxSources;
+    getAddedROIPxSources(m_oROI,oNewROI,vAddedPxSources);
+    setInternalROI(oNewROI,nOrigROIPxCount);
+    // removed pixels are simply dropped from the LUTs, as the (frame-sized) model keeps their storage
+    for(const auto& oAddedPx : vAddedPxSources)
+        m_oBGSamples.copyPixel(oAddedPx.first,oAddedPx.second);
+    copyAddedROIPxData(m_oLastColorFrame,vAddedPxSources);
+    copyAddedROIPxData(m_oLastDescFrame,vAddedPxSources);
+    m_oLastFGMask = cv::Scalar_<uchar>(0);
+    invalidateDescriptorCache();
+    return true;
 }
 
 template struct BackgroundSubtractorLOBSTER_<lv::NonParallel>;
@@ -47,6 +47,12 @@
 #define GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO (2)
 #define GWORD_DEFAULT_NB_INIT_SAMPL_PASSES (2)
 #define GWORD_DESC_THRES_BITS_MATCH_FACTOR (4)
+// per-channel color range & descriptor bit count range covered by a single bucket of the per-cell global word indexes
+#define GWORD_INDEX_COLOR_BUCKET_SIZE (64)
+#define GWORD_INDEX_DESCBITS_BUCKET_SIZE (8)
+// decay factor applied to global word weights (and to their background map cells) on every global update, and size of the lazy decay factor LUT (longer pending decays erase weights)
+#define GWORD_DECAY_FACTOR (0.9f)
+#define GWORD_DECAY_LUT_SIZE (256)
 
 // local define used to toggle debug information display [on/off]
 #define DISPLAY_PAWCS_DEBUG_INFO 0
@@ -74,6 +80,18 @@
 #define UNSTAB_DESC_DIST_OFFSET (m_nDescDistThresholdOffset)
 // local define used to specify the min descriptor bit count for flat regions
 #define FLAT_REGION_BIT_COUNT (s_nDescMaxDataRange_1ch/8)
+// local define used to specify the period (in frames) of the sort pass over the unscanned tail of each local dictionary (staggered across pixels)
+#define LWORD_TAIL_SORT_PERIOD (4)
+// local define used to mark local dictionary entries which are not assigned to a word slot yet
+#define LWORD_UNINIT_SLOT (USHRT_MAX)
+// local define used to specify the post-processing region padding (on top of the median blur radius) used in ROI-compacted mode
+#define POSTPROC_RECT_MARGIN (8)
+// local define used to specify the minimum row band height for multi-threaded processing (must be >4 for 5x5 neighbor spread, and a multiple of the gword lookup map downsample ratio)
+#define MIN_BAND_ROWS (8)
+// local define used to specify the number of row bands created per thread for multi-threaded processing (for load balancing)
+#define BANDS_PER_THREAD (4)
+// local define used to toggle multi-threaded band processing (debug displays & internal HRCs rely on shared per-frame state, and force sequential processing)
+#define ALLOW_BAND_THREADING (!DISPLAY_PAWCS_DEBUG_INFO && !USE_INTERNAL_HRCS)
 
 #if USE_INTERNAL_HRCS
 #include <chrono>
@@ -83,6 +101,28 @@ static const size_t s_nColorMaxDataRange_1ch = UCHAR_MAX;
 static const size_t s_nDescMaxDataRange_1ch = LBSP::DESC_SIZE_BITS;
 static const size_t s_nColorMaxDataRange_3ch = s_nColorMaxDataRange_1ch*3;
 static const size_t s_nDescMaxDataRange_3ch = s_nDescMaxDataRange_1ch*3;
+static const std::array<float,GWORD_DECAY_LUT_SIZE> s_afGlobalWordDecayLUT = [](){
+    std::array<float,GWORD_DECAY_LUT_SIZE> afDecayLUT;
+    afDecayLUT[0] = 1.0f;
+    for(size_t nDecayIdx=1; nDecayIdx<GWORD_DECAY_LUT_SIZE-1; ++nDecayIdx)
+        afDecayLUT[nDecayIdx] = afDecayLUT[nDecayIdx-1]*GWORD_DECAY_FACTOR;
+    afDecayLUT[GWORD_DECAY_LUT_SIZE-1] = 0.0f;
+    return afDecayLUT;
+}();
+
+static inline float getGlobalWordDecayFactor(int nPendingDecays) {
+    lvDbgAssert(nPendingDecays>=0);
+    return s_afGlobalWordDecayLUT[std::min((size_t)nPendingDecays,(size_t)GWORD_DECAY_LUT_SIZE-1)];
+}
+
+static inline void applyGlobalWordDecays(float* afLocalWeights, int* anStamps, const int* anDecayCounts, size_t nCells) {
+    for(size_t nCellIdx=0; nCellIdx<nCells; ++nCellIdx) {
+        if(anStamps[nCellIdx]!=anDecayCounts[nCellIdx]) {
+            afLocalWeights[nCellIdx] *= getGlobalWordDecayFactor(anDecayCounts[nCellIdx]-anStamps[nCellIdx]);
+            anStamps[nCellIdx] = anDecayCounts[nCellIdx];
+        }
+    }
+}
 
 BackgroundSubtractorPAWCS::BackgroundSubtractorPAWCS_(size_t nDescDistThresholdOffset, size_t nMinColorDistThreshold,
                                                       size_t nMaxNbWords, size_t nSamplesForMovingAvgs, float fRelLBSPThreshold) :
@@ -98,10 +138,14 @@ BackgroundSubtractorPAWCS::BackgroundSubtractorPAWCS_(size_t nDescDistThresholdO
         m_nMedianBlurKernelSize(m_nDefaultMedianBlurKernelSize),
         m_nDownSampledROIPxCount(0),
         m_nLocalWordWeightOffset(DEFAULT_LWORD_WEIGHT_OFFSET),
-        m_pLocalWordListIter_1ch(m_voLocalWordList_1ch.end()),
-        m_pLocalWordListIter_3ch(m_voLocalWordList_3ch.end()),
         m_pGlobalWordListIter_1ch(m_voGlobalWordList_1ch.end()),
-        m_pGlobalWordListIter_3ch(m_voGlobalWordList_3ch.end()) {
+        m_pGlobalWordListIter_3ch(m_voGlobalWordList_3ch.end()),
+        m_nGlobalWordLookupCells(0),
+        m_nGlobalWordIndexColorBuckets(0),
+        m_nGlobalWordIndexDescBITSBuckets(0),
+        m_nGlobalWordIndexStamp(0),
+        m_nPendingGlobalWordBlurs(0),
+        m_nThreadCount(1) {
     lvAssert_(m_nMaxLocalWords>0 && m_nMaxGlobalWords>0,"max local/global word counts must be positive");
 }
 
@@ -109,6 +153,8 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
     // == refresh
     lvAssert_(m_bInitialized,"algo must be initialized first");
     lvAssert_(fOccDecrFrac>=0.0f && fOccDecrFrac<=1.0f,"model occurrence decrementation must be given as a non-null fraction");
+    // global word maps are rebuilt below through raw accesses, which stay valid once all stamps & decay counts are zero
+    resetGlobalWordDecayCounts();
     if(m_nImgChannels==1) {
         for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
             const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
@@ -122,71 +168,75 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                 // == refresh: local decr
                 if(fOccDecrFrac>0.0f) {
                     for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                        LocalWord_1ch* pCurrLocalWord = (LocalWord_1ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
-                        if(pCurrLocalWord)
-                            pCurrLocalWord->nOccurrences -= (size_t)(fOccDecrFrac*pCurrLocalWord->nOccurrences);
+                        if(m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]!=LWORD_UNINIT_SLOT) {
+                            LocalWordStats& oCurrLocalWordStats = m_voLocalWordStats[getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx)];
+                            oCurrLocalWordStats.nOccurrences -= (size_t)(fOccDecrFrac*oCurrLocalWordStats.nOccurrences);
+                        }
                     }
                 }
                 const size_t nCurrWordOccIncr = DEFAULT_LWORD_OCC_INCR;
                 const size_t nTotLocalSamplingIterCount = 7*7*2;
                 for(size_t nLocalSamplingIter=0; nLocalSamplingIter<nTotLocalSamplingIterCount; ++nLocalSamplingIter) {
                     // == refresh: local resampling
-                    int nSampleImgCoord_Y, nSampleImgCoord_X;
-                    cv::getRandSamplePosition_7x7_std2(nSampleImgCoord_X,nSampleImgCoord_Y,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                    const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
+                    const size_t nSamplePxIdx = m_oRandSampleLUT.getRandIdx(nPxIter,m_oRNG);
                     if(bForceFGUpdate || !m_oLastFGMask_dilated.data[nSamplePxIdx]) {
                         const uchar nSampleColor = m_oLastColorFrame.data[nSamplePxIdx];
                         const size_t nSampleDescIdx = nSamplePxIdx*2;
                         const ushort nSampleIntraDesc = *((ushort*)(m_oLastDescFrame.data+nSampleDescIdx));
-                        bool bFoundUninitd = false;
+                        // assigned dictionary entries always come first (new words bubble up from the end), and own the first slots of the pixel
                         size_t nLocalWordIdx;
-                        for(nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                            LocalWord_1ch* pCurrLocalWord = (LocalWord_1ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
-                            if(pCurrLocalWord
-                               && lv::L1dist(nSampleColor,pCurrLocalWord->oFeature.anColor[0])<=nCurrColorDistThreshold
-                               && lv::hdist(nSampleIntraDesc,pCurrLocalWord->oFeature.anDesc[0])<=nCurrDescDistThreshold) {
-                                pCurrLocalWord->nOccurrences += nCurrWordOccIncr;
-                                pCurrLocalWord->nLastOcc = m_nFrameIdx;
+                        for(nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords && m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]!=LWORD_UNINIT_SLOT; ++nLocalWordIdx) {
+                            const size_t nCurrLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx);
+                            const ColorLBSPFeature<1>& oCurrLocalWordFeature = m_voLocalWordFeatures_1ch[nCurrLocalWordSlotIdx];
+                            if(lv::L1dist(nSampleColor,oCurrLocalWordFeature.anColor[0])<=nCurrColorDistThreshold
+                               && lv::hdist(nSampleIntraDesc,oCurrLocalWordFeature.anDesc[0])<=nCurrDescDistThreshold) {
+                                LocalWordStats& oCurrLocalWordStats = m_voLocalWordStats[nCurrLocalWordSlotIdx];
+                                oCurrLocalWordStats.nOccurrences += nCurrWordOccIncr;
+                                oCurrLocalWordStats.nLastOcc = m_nFrameIdx;
                                 break;
                             }
-                            else if(!pCurrLocalWord)
-                                bFoundUninitd = true;
                         }
-                        if(nLocalWordIdx==m_nCurrLocalWords) {
+                        if(nLocalWordIdx==m_nCurrLocalWords || m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]==LWORD_UNINIT_SLOT) {
+                            // the first free slot is used if there is one, and the weakest word is replaced otherwise
+                            const size_t nCurrLocalWordSlot = (nLocalWordIdx<m_nCurrLocalWords)?nLocalWordIdx:m_vnLocalWordDict[nLocalDictIdx+m_nCurrLocalWords-1];
                             nLocalWordIdx = m_nCurrLocalWords-1;
-                            LocalWord_1ch& oCurrLocalWord = bFoundUninitd?*m_pLocalWordListIter_1ch++:*(LocalWord_1ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
-                            oCurrLocalWord.oFeature.anColor[0] = nSampleColor;
-                            oCurrLocalWord.oFeature.anDesc[0] = nSampleIntraDesc;
-                            oCurrLocalWord.nOccurrences = nBaseOccCount;
-                            oCurrLocalWord.nFirstOcc = m_nFrameIdx;
-                            oCurrLocalWord.nLastOcc = m_nFrameIdx;
-                            m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx] = &oCurrLocalWord;
+                            m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx] = (ushort)nCurrLocalWordSlot;
+                            ColorLBSPFeature<1>& oCurrLocalWordFeature = m_voLocalWordFeatures_1ch[nLocalDictIdx+nCurrLocalWordSlot];
+                            LocalWordStats& oCurrLocalWordStats = m_voLocalWordStats[nLocalDictIdx+nCurrLocalWordSlot];
+                            oCurrLocalWordFeature.anColor[0] = nSampleColor;
+                            oCurrLocalWordFeature.anDesc[0] = nSampleIntraDesc;
+                            oCurrLocalWordStats.nOccurrences = nBaseOccCount;
+                            oCurrLocalWordStats.nFirstOcc = m_nFrameIdx;
+                            oCurrLocalWordStats.nLastOcc = m_nFrameIdx;
                         }
-                        while(nLocalWordIdx>0 && (!m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1] || GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_nFrameIdx,m_nLocalWordWeightOffset)>GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1],m_nFrameIdx,m_nLocalWordWeightOffset))) {
-                            std::swap(m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
+                        while(nLocalWordIdx>0 && (m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]==LWORD_UNINIT_SLOT || GetLocalWordWeight(m_voLocalWordStats[getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx)],m_nFrameIdx,m_nLocalWordWeightOffset)>GetLocalWordWeight(m_voLocalWordStats[getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx-1)],m_nFrameIdx,m_nLocalWordWeightOffset))) {
+                            std::swap(m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
                             --nLocalWordIdx;
                         }
                     }
                 }
-                lvDbgAssert(m_vpLocalWordDict[nLocalDictIdx]);
+                lvDbgAssert(m_vnLocalWordDict[nLocalDictIdx]!=LWORD_UNINIT_SLOT);
                 for(size_t nLocalWordIdx=1; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
                     // == refresh: local random resampling
-                    if(!(LocalWord_1ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx]) {
-                        const size_t nRandLocalWordIdx = (rand()%nLocalWordIdx);
-                        const LocalWord_1ch& oRefLocalWord = *(LocalWord_1ch*)m_vpLocalWordDict[nLocalDictIdx+nRandLocalWordIdx];
-                        const int nRandColorOffset = (rand()%(nCurrColorDistThreshold+1))-(int)nCurrColorDistThreshold/2;
-                        LocalWord_1ch& oCurrNewLocalWord = *m_pLocalWordListIter_1ch++;
-                        oCurrNewLocalWord.oFeature.anColor[0] = cv::saturate_cast<uchar>((int)oRefLocalWord.oFeature.anColor[0]+nRandColorOffset);
-                        oCurrNewLocalWord.oFeature.anDesc[0] = oRefLocalWord.oFeature.anDesc[0];
-                        oCurrNewLocalWord.nOccurrences = std::max((size_t)(oRefLocalWord.nOccurrences*((float)(m_nCurrLocalWords-nLocalWordIdx)/m_nCurrLocalWords)),(size_t)1);
-                        oCurrNewLocalWord.nFirstOcc = m_nFrameIdx;
-                        oCurrNewLocalWord.nLastOcc = m_nFrameIdx;
-                        m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx] = &oCurrNewLocalWord;
+                    if(m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]==LWORD_UNINIT_SLOT) {
+                        const size_t nRandLocalWordIdx = (m_oRNG()%nLocalWordIdx);
+                        const size_t nRefLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,nRandLocalWordIdx);
+                        const ColorLBSPFeature<1>& oRefLocalWordFeature = m_voLocalWordFeatures_1ch[nRefLocalWordSlotIdx];
+                        const LocalWordStats& oRefLocalWordStats = m_voLocalWordStats[nRefLocalWordSlotIdx];
+                        const int nRandColorOffset = (m_oRNG()%(nCurrColorDistThreshold+1))-(int)nCurrColorDistThreshold/2;
+                        // this is the first unassigned entry, so its word gets the slot of the same index
+                        m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx] = (ushort)nLocalWordIdx;
+                        ColorLBSPFeature<1>& oCurrNewLocalWordFeature = m_voLocalWordFeatures_1ch[nLocalDictIdx+nLocalWordIdx];
+                        LocalWordStats& oCurrNewLocalWordStats = m_voLocalWordStats[nLocalDictIdx+nLocalWordIdx];
+                        oCurrNewLocalWordFeature.anColor[0] = cv::saturate_cast<uchar>((int)oRefLocalWordFeature.anColor[0]+nRandColorOffset);
+                        oCurrNewLocalWordFeature.anDesc[0] = oRefLocalWordFeature.anDesc[0];
+                        oCurrNewLocalWordStats.nOccurrences = std::max((size_t)(oRefLocalWordStats.nOccurrences*((float)(m_nCurrLocalWords-nLocalWordIdx)/m_nCurrLocalWords)),(size_t)1);
+                        oCurrNewLocalWordStats.nFirstOcc = m_nFrameIdx;
+                        oCurrNewLocalWordStats.nLastOcc = m_nFrameIdx;
                     }
                 }
             }
         }
-        lvDbgAssert(m_voLocalWordList_1ch.end()==m_pLocalWordListIter_1ch);
         cv::Mat oGlobalDictPresenceLookupMap(m_oImgSize,CV_8UC1,cv::Scalar_<uchar>(0));
         size_t nPxIterIncr = std::max(m_nTotPxCount/m_nCurrGlobalWords,(size_t)1);
         for(size_t nSamplingPasses=0; nSamplingPasses<GWORD_DEFAULT_NB_INIT_SAMPL_PASSES; ++nSamplingPasses) {
@@ -202,16 +252,16 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                         const float fCurrDistThresholdFactor = *(float*)(m_oDistThresholdFrame.data+nFloatIter);
                         const size_t nCurrColorDistThreshold = (size_t)(sqrt(fCurrDistThresholdFactor)*m_nMinColorDistThreshold)/2;
                         const size_t nCurrDescDistThreshold = ((size_t)1<<((size_t)floor(fCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(bCurrRegionIsUnstable*UNSTAB_DESC_DIST_OFFSET);
-                        lvDbgAssert(m_vpLocalWordDict[nLocalDictIdx]);
-                        const LocalWord_1ch& oRefBestLocalWord = *(LocalWord_1ch*)m_vpLocalWordDict[nLocalDictIdx];
-                        const float fRefBestLocalWordWeight = GetLocalWordWeight(oRefBestLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
-                        const uchar nRefBestLocalWordDescBITS = (uchar)lv::popcount(oRefBestLocalWord.oFeature.anDesc[0]);
+                        const size_t nRefBestLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,0);
+                        const ColorLBSPFeature<1>& oRefBestLocalWordFeature = m_voLocalWordFeatures_1ch[nRefBestLocalWordSlotIdx];
+                        const float fRefBestLocalWordWeight = GetLocalWordWeight(m_voLocalWordStats[nRefBestLocalWordSlotIdx],m_nFrameIdx,m_nLocalWordWeightOffset);
+                        const uchar nRefBestLocalWordDescBITS = (uchar)lv::popcount(oRefBestLocalWordFeature.anDesc[0]);
                         bool bFoundUninitd = false;
                         size_t nGlobalWordIdx;
                         for(nGlobalWordIdx=0; nGlobalWordIdx<m_nCurrGlobalWords; ++nGlobalWordIdx) {
                             GlobalWord_1ch* pCurrGlobalWord = (GlobalWord_1ch*)m_vpGlobalWordDict[nGlobalWordIdx];
                             if(pCurrGlobalWord
-                               && lv::L1dist(pCurrGlobalWord->oFeature.anColor[0],oRefBestLocalWord.oFeature.anColor[0])<=nCurrColorDistThreshold
+                               && lv::L1dist(pCurrGlobalWord->oFeature.anColor[0],oRefBestLocalWordFeature.anColor[0])<=nCurrColorDistThreshold
                                && lv::L1dist(nRefBestLocalWordDescBITS,pCurrGlobalWord->nDescBITS)<=nCurrDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR)
                                 break;
                             else if(!pCurrGlobalWord)
@@ -220,10 +270,9 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                         if(nGlobalWordIdx==m_nCurrGlobalWords) {
                             nGlobalWordIdx = m_nCurrGlobalWords-1;
                             GlobalWord_1ch& oCurrGlobalWord = bFoundUninitd?*m_pGlobalWordListIter_1ch++:*(GlobalWord_1ch*)m_vpGlobalWordDict[nGlobalWordIdx];
-                            oCurrGlobalWord.oFeature.anColor[0] = oRefBestLocalWord.oFeature.anColor[0];
-                            oCurrGlobalWord.oFeature.anDesc[0] = oRefBestLocalWord.oFeature.anDesc[0];
+                            oCurrGlobalWord.oFeature.anColor[0] = oRefBestLocalWordFeature.anColor[0];
+                            oCurrGlobalWord.oFeature.anDesc[0] = oRefBestLocalWordFeature.anDesc[0];
                             oCurrGlobalWord.nDescBITS = nRefBestLocalWordDescBITS;
-                            oCurrGlobalWord.oSpatioOccMap.create(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1);
                             oCurrGlobalWord.oSpatioOccMap = cv::Scalar(0.0f);
                             oCurrGlobalWord.fLatestWeight = 0.0f;
                             m_vpGlobalWordDict[nGlobalWordIdx] = &oCurrGlobalWord;
@@ -249,7 +298,6 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                 oCurrNewGlobalWord.oFeature.anColor[0] = 0;
                 oCurrNewGlobalWord.oFeature.anDesc[0] = 0;
                 oCurrNewGlobalWord.nDescBITS = 0;
-                oCurrNewGlobalWord.oSpatioOccMap.create(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1);
                 oCurrNewGlobalWord.oSpatioOccMap = cv::Scalar(0.0f);
                 oCurrNewGlobalWord.fLatestWeight = 0.0f;
                 m_vpGlobalWordDict[nGlobalWordIdx] = &oCurrNewGlobalWord;
@@ -270,76 +318,80 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                 // == refresh: local decr
                 if(fOccDecrFrac>0.0f) {
                     for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                        LocalWord_3ch* pCurrLocalWord = (LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
-                        if(pCurrLocalWord)
-                            pCurrLocalWord->nOccurrences -= (size_t)(fOccDecrFrac*pCurrLocalWord->nOccurrences);
+                        if(m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]!=LWORD_UNINIT_SLOT) {
+                            LocalWordStats& oCurrLocalWordStats = m_voLocalWordStats[getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx)];
+                            oCurrLocalWordStats.nOccurrences -= (size_t)(fOccDecrFrac*oCurrLocalWordStats.nOccurrences);
+                        }
                     }
                 }
                 const size_t nCurrWordOccIncr = DEFAULT_LWORD_OCC_INCR;
                 const size_t nTotLocalSamplingIterCount = 7*7*2;
                 for(size_t nLocalSamplingIter=0; nLocalSamplingIter<nTotLocalSamplingIterCount; ++nLocalSamplingIter) {
                     // == refresh: local resampling
-                    int nSampleImgCoord_Y, nSampleImgCoord_X;
-                    cv::getRandSamplePosition_7x7_std2(nSampleImgCoord_X,nSampleImgCoord_Y,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                    const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
+                    const size_t nSamplePxIdx = m_oRandSampleLUT.getRandIdx(nPxIter,m_oRNG);
                     if(bForceFGUpdate || !m_oLastFGMask_dilated.data[nSamplePxIdx]) {
                         const size_t nSamplePxRGBIdx = nSamplePxIdx*3;
                         const size_t nSampleDescRGBIdx = nSamplePxRGBIdx*2;
                         const uchar* const anSampleColor = m_oLastColorFrame.data+nSamplePxRGBIdx;
                         const ushort* const anSampleIntraDesc = ((ushort*)(m_oLastDescFrame.data+nSampleDescRGBIdx));
-                        bool bFoundUninitd = false;
+                        // assigned dictionary entries always come first (new words bubble up from the end), and own the first slots of the pixel
                         size_t nLocalWordIdx;
-                        for(nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                            LocalWord_3ch* pCurrLocalWord = (LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
-                            if(pCurrLocalWord
-                               && lv::cmixdist(anSampleColor,pCurrLocalWord->oFeature.anColor)<=nCurrTotColorDistThreshold
-                               && lv::hdist(anSampleIntraDesc,pCurrLocalWord->oFeature.anDesc)<=nCurrTotDescDistThreshold) {
-                                pCurrLocalWord->nOccurrences += nCurrWordOccIncr;
-                                pCurrLocalWord->nLastOcc = m_nFrameIdx;
+                        for(nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords && m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]!=LWORD_UNINIT_SLOT; ++nLocalWordIdx) {
+                            const size_t nCurrLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx);
+                            const ColorLBSPFeature<3>& oCurrLocalWordFeature = m_voLocalWordFeatures_3ch[nCurrLocalWordSlotIdx];
+                            if(lv::cmixdist_within(anSampleColor,oCurrLocalWordFeature.anColor,nCurrTotColorDistThreshold)
+                               && lv::hdist(anSampleIntraDesc,oCurrLocalWordFeature.anDesc)<=nCurrTotDescDistThreshold) {
+                                LocalWordStats& oCurrLocalWordStats = m_voLocalWordStats[nCurrLocalWordSlotIdx];
+                                oCurrLocalWordStats.nOccurrences += nCurrWordOccIncr;
+                                oCurrLocalWordStats.nLastOcc = m_nFrameIdx;
                                 break;
                             }
-                            else if(!pCurrLocalWord)
-                                bFoundUninitd = true;
                         }
-                        if(nLocalWordIdx==m_nCurrLocalWords) {
+                        if(nLocalWordIdx==m_nCurrLocalWords || m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]==LWORD_UNINIT_SLOT) {
+                            // the first free slot is used if there is one, and the weakest word is replaced otherwise
+                            const size_t nCurrLocalWordSlot = (nLocalWordIdx<m_nCurrLocalWords)?nLocalWordIdx:m_vnLocalWordDict[nLocalDictIdx+m_nCurrLocalWords-1];
                             nLocalWordIdx = m_nCurrLocalWords-1;
-                            LocalWord_3ch& oCurrLocalWord = bFoundUninitd?*m_pLocalWordListIter_3ch++:*(LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
+                            m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx] = (ushort)nCurrLocalWordSlot;
+                            ColorLBSPFeature<3>& oCurrLocalWordFeature = m_voLocalWordFeatures_3ch[nLocalDictIdx+nCurrLocalWordSlot];
+                            LocalWordStats& oCurrLocalWordStats = m_voLocalWordStats[nLocalDictIdx+nCurrLocalWordSlot];
                             for(size_t c=0; c<3; ++c) {
-                                oCurrLocalWord.oFeature.anColor[c] = anSampleColor[c];
-                                oCurrLocalWord.oFeature.anDesc[c] = anSampleIntraDesc[c];
+                                oCurrLocalWordFeature.anColor[c] = anSampleColor[c];
+                                oCurrLocalWordFeature.anDesc[c] = anSampleIntraDesc[c];
                             }
-                            oCurrLocalWord.nOccurrences = nBaseOccCount;
-                            oCurrLocalWord.nFirstOcc = m_nFrameIdx;
-                            oCurrLocalWord.nLastOcc = m_nFrameIdx;
-                            m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx] = &oCurrLocalWord;
+                            oCurrLocalWordStats.nOccurrences = nBaseOccCount;
+                            oCurrLocalWordStats.nFirstOcc = m_nFrameIdx;
+                            oCurrLocalWordStats.nLastOcc = m_nFrameIdx;
                         }
-                        while(nLocalWordIdx>0 && (!m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1] || GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_nFrameIdx,m_nLocalWordWeightOffset)>GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1],m_nFrameIdx,m_nLocalWordWeightOffset))) {
-                            std::swap(m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
+                        while(nLocalWordIdx>0 && (m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]==LWORD_UNINIT_SLOT || GetLocalWordWeight(m_voLocalWordStats[getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx)],m_nFrameIdx,m_nLocalWordWeightOffset)>GetLocalWordWeight(m_voLocalWordStats[getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx-1)],m_nFrameIdx,m_nLocalWordWeightOffset))) {
+                            std::swap(m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
                             --nLocalWordIdx;
                         }
                     }
                 }
-                lvDbgAssert(m_vpLocalWordDict[nLocalDictIdx]);
+                lvDbgAssert(m_vnLocalWordDict[nLocalDictIdx]!=LWORD_UNINIT_SLOT);
                 for(size_t nLocalWordIdx=1; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
                     // == refresh: local random resampling
-                    if(!(LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx]) {
-                        const size_t nRandLocalWordIdx = (rand()%nLocalWordIdx);
-                        const LocalWord_3ch& oRefLocalWord = *(LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx+nRandLocalWordIdx];
-                        const int nRandColorOffset = (rand()%(nCurrTotColorDistThreshold/3+1))-(int)(nCurrTotColorDistThreshold/6);
-                        LocalWord_3ch& oCurrNewLocalWord = *m_pLocalWordListIter_3ch++;
+                    if(m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]==LWORD_UNINIT_SLOT) {
+                        const size_t nRandLocalWordIdx = (m_oRNG()%nLocalWordIdx);
+                        const size_t nRefLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,nRandLocalWordIdx);
+                        const ColorLBSPFeature<3>& oRefLocalWordFeature = m_voLocalWordFeatures_3ch[nRefLocalWordSlotIdx];
+                        const LocalWordStats& oRefLocalWordStats = m_voLocalWordStats[nRefLocalWordSlotIdx];
+                        const int nRandColorOffset = (m_oRNG()%(nCurrTotColorDistThreshold/3+1))-(int)(nCurrTotColorDistThreshold/6);
+                        // this is the first unassigned entry, so its word gets the slot of the same index
+                        m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx] = (ushort)nLocalWordIdx;
+                        ColorLBSPFeature<3>& oCurrNewLocalWordFeature = m_voLocalWordFeatures_3ch[nLocalDictIdx+nLocalWordIdx];
+                        LocalWordStats& oCurrNewLocalWordStats = m_voLocalWordStats[nLocalDictIdx+nLocalWordIdx];
                         for(size_t c=0; c<3; ++c) {
-                            oCurrNewLocalWord.oFeature.anColor[c] = cv::saturate_cast<uchar>((int)oRefLocalWord.oFeature.anColor[c]+nRandColorOffset);
-                            oCurrNewLocalWord.oFeature.anDesc[c] = oRefLocalWord.oFeature.anDesc[c];
+                            oCurrNewLocalWordFeature.anColor[c] = cv::saturate_cast<uchar>((int)oRefLocalWordFeature.anColor[c]+nRandColorOffset);
+                            oCurrNewLocalWordFeature.anDesc[c] = oRefLocalWordFeature.anDesc[c];
                         }
-                        oCurrNewLocalWord.nOccurrences = std::max((size_t)(oRefLocalWord.nOccurrences*((float)(m_nCurrLocalWords-nLocalWordIdx)/m_nCurrLocalWords)),(size_t)1);
-                        oCurrNewLocalWord.nFirstOcc = m_nFrameIdx;
-                        oCurrNewLocalWord.nLastOcc = m_nFrameIdx;
-                        m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx] = &oCurrNewLocalWord;
+                        oCurrNewLocalWordStats.nOccurrences = std::max((size_t)(oRefLocalWordStats.nOccurrences*((float)(m_nCurrLocalWords-nLocalWordIdx)/m_nCurrLocalWords)),(size_t)1);
+                        oCurrNewLocalWordStats.nFirstOcc = m_nFrameIdx;
+                        oCurrNewLocalWordStats.nLastOcc = m_nFrameIdx;
                     }
                 }
             }
         }
-        lvDbgAssert(m_voLocalWordList_3ch.end()==m_pLocalWordListIter_3ch);
         cv::Mat oGlobalDictPresenceLookupMap(m_oImgSize,CV_8UC1,cv::Scalar_<uchar>(0));
         size_t nPxIterIncr = std::max(m_nTotPxCount/m_nCurrGlobalWords,(size_t)1);
         for(size_t nSamplingPasses=0; nSamplingPasses<GWORD_DEFAULT_NB_INIT_SAMPL_PASSES; ++nSamplingPasses) {
@@ -355,17 +407,17 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                         const float fCurrDistThresholdFactor = *(float*)(m_oDistThresholdFrame.data+nFloatIter);
                         const size_t nCurrTotColorDistThreshold = (size_t)(sqrt(fCurrDistThresholdFactor)*m_nMinColorDistThreshold)*3;
                         const size_t nCurrTotDescDistThreshold = (((size_t)1<<((size_t)floor(fCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(bCurrRegionIsUnstable*UNSTAB_DESC_DIST_OFFSET))*3;
-                        lvDbgAssert(m_vpLocalWordDict[nLocalDictIdx]);
-                        const LocalWord_3ch& oRefBestLocalWord = *(LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx];
-                        const float fRefBestLocalWordWeight = GetLocalWordWeight(oRefBestLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
-                        const uchar nRefBestLocalWordDescBITS = (uchar)lv::popcount(oRefBestLocalWord.oFeature.anDesc);
+                        const size_t nRefBestLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,0);
+                        const ColorLBSPFeature<3>& oRefBestLocalWordFeature = m_voLocalWordFeatures_3ch[nRefBestLocalWordSlotIdx];
+                        const float fRefBestLocalWordWeight = GetLocalWordWeight(m_voLocalWordStats[nRefBestLocalWordSlotIdx],m_nFrameIdx,m_nLocalWordWeightOffset);
+                        const uchar nRefBestLocalWordDescBITS = (uchar)lv::popcount(oRefBestLocalWordFeature.anDesc);
                         bool bFoundUninitd = false;
                         size_t nGlobalWordIdx;
                         for(nGlobalWordIdx=0; nGlobalWordIdx<m_nCurrGlobalWords; ++nGlobalWordIdx) {
                             GlobalWord_3ch* pCurrGlobalWord = (GlobalWord_3ch*)m_vpGlobalWordDict[nGlobalWordIdx];
                             if(pCurrGlobalWord
                                && lv::L1dist(nRefBestLocalWordDescBITS,pCurrGlobalWord->nDescBITS)<=nCurrTotDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR
-                               && lv::cmixdist(oRefBestLocalWord.oFeature.anColor,pCurrGlobalWord->oFeature.anColor)<=nCurrTotColorDistThreshold)
+                               && lv::cmixdist_within(oRefBestLocalWordFeature.anColor,pCurrGlobalWord->oFeature.anColor,nCurrTotColorDistThreshold))
                                 break;
                             else if(!pCurrGlobalWord)
                                 bFoundUninitd = true;
@@ -374,11 +426,10 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                             nGlobalWordIdx = m_nCurrGlobalWords-1;
                             GlobalWord_3ch& oCurrGlobalWord = bFoundUninitd?*m_pGlobalWordListIter_3ch++:*(GlobalWord_3ch*)m_vpGlobalWordDict[nGlobalWordIdx];
                             for(size_t c=0; c<3; ++c) {
-                                oCurrGlobalWord.oFeature.anColor[c] = oRefBestLocalWord.oFeature.anColor[c];
-                                oCurrGlobalWord.oFeature.anDesc[c] = oRefBestLocalWord.oFeature.anDesc[c];
+                                oCurrGlobalWord.oFeature.anColor[c] = oRefBestLocalWordFeature.anColor[c];
+                                oCurrGlobalWord.oFeature.anDesc[c] = oRefBestLocalWordFeature.anDesc[c];
                             }
                             oCurrGlobalWord.nDescBITS = nRefBestLocalWordDescBITS;
-                            oCurrGlobalWord.oSpatioOccMap.create(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1);
                             oCurrGlobalWord.oSpatioOccMap = cv::Scalar(0.0f);
                             oCurrGlobalWord.fLatestWeight = 0.0f;
                             m_vpGlobalWordDict[nGlobalWordIdx] = &oCurrGlobalWord;
@@ -406,7 +457,6 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                     oCurrNewGlobalWord.oFeature.anDesc[c] = 0;
                 }
                 oCurrNewGlobalWord.nDescBITS = 0;
-                oCurrNewGlobalWord.oSpatioOccMap.create(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1);
                 oCurrNewGlobalWord.oSpatioOccMap = cv::Scalar(0.0f);
                 oCurrNewGlobalWord.fLatestWeight = 0.0f;
                 m_vpGlobalWordDict[nGlobalWordIdx] = &oCurrNewGlobalWord;
@@ -414,29 +464,23 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
         }
         lvDbgAssert(m_voGlobalWordList_3ch.end()==m_pGlobalWordListIter_3ch);
     }
-    for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
-        // == refresh: per-px global word sort
-        const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
-        const size_t nGlobalWordMapLookupIdx = m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx;
-        float fLastGlobalWordLocalWeight = *(float*)(m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[0]->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
-        for(size_t nGlobalWordLUTIdx=1; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx) {
-            const float fCurrGlobalWordLocalWeight = *(float*)(m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx]->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
-            if(fCurrGlobalWordLocalWeight>fLastGlobalWordLocalWeight)
-                std::swap(m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx],m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx-1]);
-            else
-                fLastGlobalWordLocalWeight = fCurrGlobalWordLocalWeight;
-        }
-    }
+    // == refresh: per-cell global word sort (global word features were modified above, so all indexes are rebuilt)
+    std::fill(m_vbDirtyGlobalWordLUTCells.begin(),m_vbDirtyGlobalWordLUTCells.end(),uchar(1));
+    ++m_nGlobalWordIndexStamp;
+    sortGlobalWordLUTs();
 }
 
-void BackgroundSubtractorPAWCS::initialize(const cv::Mat& oInitImg, const cv::Mat& oROI) {
+void BackgroundSubtractorPAWCS::initialize(const cv::Mat& _oInitImg, const cv::Mat& _oROI) {
     // == init
+    lvAssert_(_oInitImg.depth()==CV_8U,"PAWCS only supports 8-bit inputs");
+    cv::Mat oInitImg,oROI;
+    scaleInitData(_oInitImg,_oROI,oInitImg,oROI);
     IBackgroundSubtractorLBSP::initialize_common(oInitImg,oROI);
     m_bModelInitialized = false;
-    m_voLocalWordList_1ch.clear();
-    m_pLocalWordListIter_1ch = m_voLocalWordList_1ch.end();
-    m_voLocalWordList_3ch.clear();
-    m_pLocalWordListIter_3ch = m_voLocalWordList_3ch.end();
+    // local word arrays are rebuilt with an allocator bound to the (possibly new) model NUMA node
+    m_voLocalWordFeatures_1ch = LocalWordList<ColorLBSPFeature<1>>(lv::LargePageMemAllocator<ColorLBSPFeature<1>>(m_nModelNUMANode));
+    m_voLocalWordFeatures_3ch = LocalWordList<ColorLBSPFeature<3>>(lv::LargePageMemAllocator<ColorLBSPFeature<3>>(m_nModelNUMANode));
+    m_voLocalWordStats = LocalWordList<LocalWordStats>(lv::LargePageMemAllocator<LocalWordStats>(m_nModelNUMANode));
     m_voGlobalWordList_1ch.clear();
     m_pGlobalWordListIter_1ch = m_voGlobalWordList_1ch.end();
     m_voGlobalWordList_3ch.clear();
@@ -502,56 +546,81 @@ void BackgroundSubtractorPAWCS::initialize(const cv::Mat& oInitImg, const cv::Ma
     m_oLastFGMask_dilated = cv::Scalar_<uchar>(0);
     m_oLastFGMask_dilated_inverted.create(m_oImgSize,CV_8UC1);
     m_oLastFGMask_dilated_inverted = cv::Scalar_<uchar>(0);
-    m_oFGMask_FloodedHoles.create(m_oImgSize,CV_8UC1);
-    m_oFGMask_FloodedHoles = cv::Scalar_<uchar>(0);
-    m_oFGMask_PreFlood.create(m_oImgSize,CV_8UC1);
-    m_oFGMask_PreFlood = cv::Scalar_<uchar>(0);
-    m_oCurrRawFGBlinkMask.create(m_oImgSize,CV_8UC1);
-    m_oCurrRawFGBlinkMask = cv::Scalar_<uchar>(0);
     m_oLastRawFGBlinkMask.create(m_oImgSize,CV_8UC1);
     m_oLastRawFGBlinkMask = cv::Scalar_<uchar>(0);
-    m_oTempGlobalWordWeightDiffFactor.create(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1);
-    m_oTempGlobalWordWeightDiffFactor = cv::Scalar(-0.1f);
+    m_oGlobalWordDecayCounts.create(m_oDownSampledFrameSize_GlobalWordLookup,CV_32SC1);
+    m_oGlobalWordDecayCounts = cv::Scalar(0);
+    m_nPendingGlobalWordBlurs = 0;
     m_oMorphExStructElement = cv::getStructuringElement(cv::MORPH_RECT,cv::Size(3,3));
     m_voPxInfoLUT_PAWCS.resize(m_nTotPxCount);
-    m_vpLocalWordDict.resize(m_nTotRelevantPxCount*m_nCurrLocalWords,nullptr);
+    lvAssert_(m_nCurrLocalWords<LWORD_UNINIT_SLOT,"local word count too large for slot-indexed local dictionaries");
+    m_vnLocalWordDict.assign(m_nTotRelevantPxCount*m_nCurrLocalWords,LWORD_UNINIT_SLOT);
+    m_voLocalWordStats.resize(m_nTotRelevantPxCount*m_nCurrLocalWords);
     m_vpGlobalWordDict.resize(m_nCurrGlobalWords,nullptr);
+    lvAssert_(m_nCurrGlobalWords<=USHRT_MAX,"global word count too large for per-cell global word indexes");
+    // all pixels of a lookup map cell share the same local global word weights, and thus the same sort LUT & index
+    m_nGlobalWordLookupCells = 0;
+    for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
+        const int nImgCoord_Y = (int)m_vnPxIdxLUT[nModelIter]/m_oImgSize.width, nImgCoord_X = (int)m_vnPxIdxLUT[nModelIter]%m_oImgSize.width;
+        m_nGlobalWordLookupCells = std::max(m_nGlobalWordLookupCells,(size_t)((nImgCoord_Y/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO)*m_oDownSampledFrameSize_GlobalWordLookup.width+(nImgCoord_X/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO))+1);
+    }
+    m_nGlobalWordIndexColorBuckets = UCHAR_MAX/GWORD_INDEX_COLOR_BUCKET_SIZE+1;
+    m_nGlobalWordIndexDescBITSBuckets = (s_nDescMaxDataRange_1ch*m_nImgChannels)/GWORD_INDEX_DESCBITS_BUCKET_SIZE+1;
+    m_vpGlobalDictSortLUTArena.assign(m_nGlobalWordLookupCells*m_nCurrGlobalWords,nullptr);
+    m_vnGlobalWordIndexRanks.assign(m_nGlobalWordLookupCells*m_nCurrGlobalWords,0);
+    m_vnGlobalWordIndexOffsets.assign(m_nGlobalWordLookupCells*(m_nGlobalWordIndexColorBuckets*m_nGlobalWordIndexDescBITSBuckets+1),0);
+    m_vnGlobalWordIndexCellStamps.assign(m_nGlobalWordLookupCells,m_nGlobalWordIndexStamp++);
+    const int anSpatioOccMapsDims[3] = {(int)m_nCurrGlobalWords,m_oDownSampledFrameSize_GlobalWordLookup.height,m_oDownSampledFrameSize_GlobalWordLookup.width};
+    m_oGlobalWordSpatioOccMaps.create(3,anSpatioOccMapsDims,CV_32FC1);
+    m_oGlobalWordSpatioOccMaps = cv::Scalar(0.0f);
+    m_oGlobalWordSpatioOccStamps.create(3,anSpatioOccMapsDims,CV_32SC1);
+    m_oGlobalWordSpatioOccStamps = cv::Scalar(0);
+    m_vbDirtyGlobalWordLUTCells.assign(m_nGlobalWordLookupCells,uchar(1));
     if(m_nImgChannels==1) {
-        m_voLocalWordList_1ch.resize(m_nTotRelevantPxCount*m_nCurrLocalWords);
-        m_pLocalWordListIter_1ch = m_voLocalWordList_1ch.begin();
+        m_voLocalWordFeatures_1ch.resize(m_nTotRelevantPxCount*m_nCurrLocalWords);
         m_voGlobalWordList_1ch.resize(m_nCurrGlobalWords);
         m_pGlobalWordListIter_1ch = m_voGlobalWordList_1ch.begin();
+        for(size_t nGlobalWordIdxIter=0; nGlobalWordIdxIter<m_nCurrGlobalWords; ++nGlobalWordIdxIter) {
+            m_voGlobalWordList_1ch[nGlobalWordIdxIter].oSpatioOccMap = cv::Mat(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1,m_oGlobalWordSpatioOccMaps.ptr((int)nGlobalWordIdxIter));
+            m_voGlobalWordList_1ch[nGlobalWordIdxIter].oSpatioOccStamps = cv::Mat(m_oDownSampledFrameSize_GlobalWordLookup,CV_32SC1,m_oGlobalWordSpatioOccStamps.ptr((int)nGlobalWordIdxIter));
+        }
         for(size_t nPxIter=0, nModelIter=0; nPxIter<m_nTotPxCount; ++nPxIter) {
             if(m_oROI.data[nPxIter]) {
                 m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y = (int)nPxIter/m_oImgSize.width;
                 m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X = (int)nPxIter%m_oImgSize.width;
                 m_voPxInfoLUT_PAWCS[nPxIter].nModelIdx = nModelIter;
                 m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx = (size_t)((m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO)*m_oDownSampledFrameSize_GlobalWordLookup.width+(m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO))*4;
-                m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT.resize(m_nCurrGlobalWords);
-                for(size_t nGlobalWordIdxIter=0; nGlobalWordIdxIter<m_nCurrGlobalWords; ++nGlobalWordIdxIter)
-                    m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordIdxIter] = &m_voGlobalWordList_1ch[nGlobalWordIdxIter];
+                m_voPxInfoLUT_PAWCS[nPxIter].apGlobalDictSortLUT = m_vpGlobalDictSortLUTArena.data()+(m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx/4)*m_nCurrGlobalWords;
                 ++nModelIter;
             }
         }
+        for(size_t nCellIdx=0; nCellIdx<m_nGlobalWordLookupCells; ++nCellIdx)
+            for(size_t nGlobalWordIdxIter=0; nGlobalWordIdxIter<m_nCurrGlobalWords; ++nGlobalWordIdxIter)
+                m_vpGlobalDictSortLUTArena[nCellIdx*m_nCurrGlobalWords+nGlobalWordIdxIter] = &m_voGlobalWordList_1ch[nGlobalWordIdxIter];
     }
     else { //m_nImgChannels==3
-        m_voLocalWordList_3ch.resize(m_nTotRelevantPxCount*m_nCurrLocalWords);
-        m_pLocalWordListIter_3ch = m_voLocalWordList_3ch.begin();
+        m_voLocalWordFeatures_3ch.resize(m_nTotRelevantPxCount*m_nCurrLocalWords);
         m_voGlobalWordList_3ch.resize(m_nCurrGlobalWords);
         m_pGlobalWordListIter_3ch = m_voGlobalWordList_3ch.begin();
+        for(size_t nGlobalWordIdxIter=0; nGlobalWordIdxIter<m_nCurrGlobalWords; ++nGlobalWordIdxIter) {
+            m_voGlobalWordList_3ch[nGlobalWordIdxIter].oSpatioOccMap = cv::Mat(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1,m_oGlobalWordSpatioOccMaps.ptr((int)nGlobalWordIdxIter));
+            m_voGlobalWordList_3ch[nGlobalWordIdxIter].oSpatioOccStamps = cv::Mat(m_oDownSampledFrameSize_GlobalWordLookup,CV_32SC1,m_oGlobalWordSpatioOccStamps.ptr((int)nGlobalWordIdxIter));
+        }
         for(size_t nPxIter=0, nModelIter=0; nPxIter<m_nTotPxCount; ++nPxIter) {
             if(m_oROI.data[nPxIter]) {
                 m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y = (int)nPxIter/m_oImgSize.width;
                 m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X = (int)nPxIter%m_oImgSize.width;
                 m_voPxInfoLUT_PAWCS[nPxIter].nModelIdx = nModelIter;
                 m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx = (size_t)((m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO)*m_oDownSampledFrameSize_GlobalWordLookup.width+(m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO))*4;
-                m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT.resize(m_nCurrGlobalWords);
-                for(size_t nGlobalWordIdxIter=0; nGlobalWordIdxIter<m_nCurrGlobalWords; ++nGlobalWordIdxIter)
-                    m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordIdxIter] = &m_voGlobalWordList_3ch[nGlobalWordIdxIter];
+                m_voPxInfoLUT_PAWCS[nPxIter].apGlobalDictSortLUT = m_vpGlobalDictSortLUTArena.data()+(m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx/4)*m_nCurrGlobalWords;
                 ++nModelIter;
             }
         }
+        for(size_t nCellIdx=0; nCellIdx<m_nGlobalWordLookupCells; ++nCellIdx)
+            for(size_t nGlobalWordIdxIter=0; nGlobalWordIdxIter<m_nCurrGlobalWords; ++nGlobalWordIdxIter)
+                m_vpGlobalDictSortLUTArena[nCellIdx*m_nCurrGlobalWords+nGlobalWordIdxIter] = &m_voGlobalWordList_3ch[nGlobalWordIdxIter];
     }
+    updateBandLUT();
     m_bInitialized = true;
     refreshModel(1,0);
     m_bModelInitialized = true;
@@ -560,18 +629,23 @@ void BackgroundSubtractorPAWCS::initialize(const cv::Mat& oInitImg, const cv::Ma
 void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fgmask, double learningRateOverride) {
     // == process
     lvAssert_(m_bInitialized && m_bModelInitialized,"algo & model must be initialized first");
-    cv::Mat oInputImg = _image.getMat();
+    LV_PROFILE_SCOPE("PAWCS::apply");
+    const GovernorScope oGovernorScope(this,_image);
+    learningRateOverride = getGovernedLearningRate(learningRateOverride);
+    BGS_INSTR_SCOPED_TIMER(Stage_Total);
+    BGS_INSTR_ADD_COUNT(Counter_Frames,1);
+    const cv::Mat oOrigInputImg = _image.getMat();
+    cv::Mat oInputImg = getScaledInput(oOrigInputImg);
     lvAssert_(oInputImg.type()==m_nImgType && oInputImg.size()==m_oImgSize,"input image type/size mismatch with initialization type/size");
     lvAssert_(oInputImg.isContinuous(),"input image data must be continuous");
-    _fgmask.create(m_oImgSize,CV_8UC1);
-    cv::Mat oCurrFGMask = _fgmask.getMat();
+    cv::Mat oCurrFGMask = getScaledOutputMask(_fgmask);
     memset(oCurrFGMask.data,0,oCurrFGMask.cols*oCurrFGMask.rows);
     const bool bBootstrapping = ++m_nFrameIdx<=DEFAULT_BOOTSTRAP_WIN_SIZE;
     const size_t nCurrSamplesForMovingAvg_LT = bBootstrapping?m_nSamplesForMovingAvgs/2:m_nSamplesForMovingAvgs;
     const size_t nCurrSamplesForMovingAvg_ST = nCurrSamplesForMovingAvg_LT/4;
-    const float fRollAvgFactor_LT = 1.0f/std::min(m_nFrameIdx,nCurrSamplesForMovingAvg_LT);
-    const float fRollAvgFactor_ST = 1.0f/std::min(m_nFrameIdx,nCurrSamplesForMovingAvg_ST);
-    const size_t nCurrGlobalWordUpdateRate = bBootstrapping?DEFAULT_RESAMPLING_RATE/2:DEFAULT_RESAMPLING_RATE;
+    const float fRollAvgFactor_LT = getCompensatedRollAvgFactor(1.0f/std::min(m_nFrameIdx,nCurrSamplesForMovingAvg_LT));
+    const float fRollAvgFactor_ST = getCompensatedRollAvgFactor(1.0f/std::min(m_nFrameIdx,nCurrSamplesForMovingAvg_ST));
+    const size_t nCurrGlobalWordUpdateRate = (size_t)ceil(getGovernedLearningRate(bBootstrapping?DEFAULT_RESAMPLING_RATE/2:DEFAULT_RESAMPLING_RATE));
     size_t nFlatRegionCount = 0;
 #if DISPLAY_PAWCS_DEBUG_INFO
     std::vector<std::string> vsWordModList(m_nTotRelevantPxCount*m_nCurrLocalWords);
@@ -606,326 +680,381 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
     std::chrono::high_resolution_clock::time_point post_lastKP = std::chrono::high_resolution_clock::now();
     std::chrono::high_resolution_clock::time_point pre_gword_calcs;
 #endif //USE_INTERNAL_HRCS
+    // in multi-threaded mode, row bands are processed in two phases (even, then odd) so that concurrently processed bands are always
+    // separated by a full band; in all modes, global word weight updates & replacements are buffered per band (the whole frame being a
+    // single band in sequential mode), and merged in raster order once all pixels are done, so both paths share the same semantics
+    // local word scan stats are accumulated once per band (bands may run concurrently)
+    std::atomic_size_t nSamplesTested(0), nEarlyExits(0);
+    const auto processBands = [&](const auto& lApplyBand) -> size_t {
+        BGS_INSTR_SCOPED_TIMER(Stage_PixelLoop);
+        const bool bUsingBands = m_nThreadCount!=1 && ALLOW_BAND_THREADING;
+        const size_t nBands = bUsingBands?m_voBandRNGs.size():1;
+        m_voBandGlobalDictDeltas.resize(nBands);
+        for(GlobalDictBandDelta& oBandDelta : m_voBandGlobalDictDeltas) {
+            oBandDelta.vfWeightIncrs.assign(m_nCurrGlobalWords,0.0f);
+            oBandDelta.bReplaceWeakestWord = false;
+        }
+        if(!bUsingBands) {
+            const size_t nFlatRegionCount = lApplyBand(0,m_nTotRelevantPxCount,m_oRNG,m_voBandGlobalDictDeltas[0]);
+            mergeBandGlobalDictDeltas();
+            return nFlatRegionCount;
+        }
+        lvDbgAssert(m_pThreadPool && m_vnBandModelIterLUT.size()>=2 && m_voBandRNGs.size()==m_vnBandModelIterLUT.size()-1);
+        updateGlobalWordIndexes(); // stale indexes are otherwise rebuilt lazily, which is not thread-safe
+        std::vector<size_t> vnBandFlatRegionCounts(nBands,0);
+        for(size_t nPhase=0; nPhase<2; ++nPhase) {
+            m_pThreadPool->parallel_for((nBands+1-nPhase)/2,[&](size_t nTaskIdx) {
+                const size_t nBandIdx = nTaskIdx*2+nPhase;
+                vnBandFlatRegionCounts[nBandIdx] = lApplyBand(m_vnBandModelIterLUT[nBandIdx],m_vnBandModelIterLUT[nBandIdx+1],m_voBandRNGs[nBandIdx],m_voBandGlobalDictDeltas[nBandIdx]);
+            });
+        }
+        mergeBandGlobalDictDeltas();
+        return std::accumulate(vnBandFlatRegionCounts.begin(),vnBandFlatRegionCounts.end(),size_t(0));
+    };
     if(m_nImgChannels==1) {
 #if USE_INTERNAL_HRCS
         std::chrono::high_resolution_clock::time_point pre_loop = std::chrono::high_resolution_clock::now();
 #endif //USE_INTERNAL_HRCS
-        for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
+        const auto lApplyBand = [&](size_t nModelIterBegin, size_t nModelIterEnd, lv::PCG32& oRNG, GlobalDictBandDelta& oBandDelta) {
+            size_t nBandFlatRegionCount = 0, nBandSamplesTested = 0, nBandEarlyExits = 0;
+            for(size_t nModelIter=nModelIterBegin; nModelIter<nModelIterEnd; ++nModelIter) {
 #if USE_INTERNAL_HRCS
-            std::chrono::high_resolution_clock::time_point pre_currKP = std::chrono::high_resolution_clock::now();
-            fInterKPsTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(pre_currKP-post_lastKP).count())/1000000;
-            std::chrono::high_resolution_clock::time_point pre_prep = std::chrono::high_resolution_clock::now();
+                std::chrono::high_resolution_clock::time_point pre_currKP = std::chrono::high_resolution_clock::now();
+                fInterKPsTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(pre_currKP-post_lastKP).count())/1000000;
+                std::chrono::high_resolution_clock::time_point pre_prep = std::chrono::high_resolution_clock::now();
 #endif //USE_INTERNAL_HRCS
-            const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
-            const size_t nDescIter = nPxIter*2;
-            const size_t nFloatIter = nPxIter*4;
-            const size_t nLocalDictIdx = nModelIter*m_nCurrLocalWords;
-            const size_t nGlobalWordMapLookupIdx = m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx;
-            const uchar nCurrColor = oInputImg.data[nPxIter];
-            uchar& nLastColor = m_oLastColorFrame.data[nPxIter];
-            ushort& nLastIntraDesc = *((ushort*)(m_oLastDescFrame.data+nDescIter));
-            size_t nMinColorDist = s_nColorMaxDataRange_1ch;
-            size_t nMinDescDist = s_nDescMaxDataRange_1ch;
-            float& fCurrMeanRawSegmRes_LT = *(float*)(m_oMeanRawSegmResFrame_LT.data+nFloatIter);
-            float& fCurrMeanRawSegmRes_ST = *(float*)(m_oMeanRawSegmResFrame_ST.data+nFloatIter);
-            float& fCurrMeanFinalSegmRes_LT = *(float*)(m_oMeanFinalSegmResFrame_LT.data+nFloatIter);
-            float& fCurrMeanFinalSegmRes_ST = *(float*)(m_oMeanFinalSegmResFrame_ST.data+nFloatIter);
-            float& fCurrDistThresholdFactor = *(float*)(m_oDistThresholdFrame.data+nFloatIter);
+                const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
+                const size_t nDescIter = nPxIter*2;
+                const size_t nFloatIter = nPxIter*4;
+                const size_t nLocalDictIdx = nModelIter*m_nCurrLocalWords;
+                const size_t nGlobalWordMapLookupIdx = m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx;
+                const uchar nCurrColor = oInputImg.data[nPxIter];
+                uchar& nLastColor = m_oLastColorFrame.data[nPxIter];
+                ushort& nLastIntraDesc = *((ushort*)(m_oLastDescFrame.data+nDescIter));
+                size_t nMinColorDist = s_nColorMaxDataRange_1ch;
+                size_t nMinDescDist = s_nDescMaxDataRange_1ch;
+                float& fCurrMeanRawSegmRes_LT = *(float*)(m_oMeanRawSegmResFrame_LT.data+nFloatIter);
+                float& fCurrMeanRawSegmRes_ST = *(float*)(m_oMeanRawSegmResFrame_ST.data+nFloatIter);
+                float& fCurrMeanFinalSegmRes_LT = *(float*)(m_oMeanFinalSegmResFrame_LT.data+nFloatIter);
+                float& fCurrMeanFinalSegmRes_ST = *(float*)(m_oMeanFinalSegmResFrame_ST.data+nFloatIter);
+                float& fCurrDistThresholdFactor = *(float*)(m_oDistThresholdFrame.data+nFloatIter);
 #if USE_FEEDBACK_ADJUSTMENTS
-            float& fCurrDistThresholdVariationFactor = *(float*)(m_oDistThresholdVariationFrame.data+nFloatIter);
-            float& fCurrLearningRate = *(float*)(m_oUpdateRateFrame.data+nFloatIter);
-            float& fCurrMeanMinDist_LT = *(float*)(m_oMeanMinDistFrame_LT.data+nFloatIter);
-            float& fCurrMeanMinDist_ST = *(float*)(m_oMeanMinDistFrame_ST.data+nFloatIter);
+                float& fCurrDistThresholdVariationFactor = *(float*)(m_oDistThresholdVariationFrame.data+nFloatIter);
+                float& fCurrLearningRate = *(float*)(m_oUpdateRateFrame.data+nFloatIter);
+                float& fCurrMeanMinDist_LT = *(float*)(m_oMeanMinDistFrame_LT.data+nFloatIter);
+                float& fCurrMeanMinDist_ST = *(float*)(m_oMeanMinDistFrame_ST.data+nFloatIter);
 #endif //USE_FEEDBACK_ADJUSTMENTS
-            const float fBestLocalWordWeight = GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx],m_nFrameIdx,m_nLocalWordWeightOffset);
-            const float fLocalWordsWeightSumThreshold = fBestLocalWordWeight/(fCurrDistThresholdFactor*2);
-            uchar& bCurrRegionIsUnstable = m_oUnstableRegionMask.data[nPxIter];
-            uchar& nCurrRegionIllumUpdtVal = m_oIllumUpdtRegionMask.data[nPxIter];
-            uchar& nCurrRegionSegmVal = oCurrFGMask.data[nPxIter];
-            const bool bCurrRegionIsROIBorder = m_oROI.data[nPxIter]<UCHAR_MAX;
+                const float fBestLocalWordWeight = GetLocalWordWeight(m_voLocalWordStats[getLocalWordSlotIdx(nLocalDictIdx,0)],m_nFrameIdx,m_nLocalWordWeightOffset);
+                const float fLocalWordsWeightSumThreshold = fBestLocalWordWeight/(fCurrDistThresholdFactor*2);
+                uchar& bCurrRegionIsUnstable = m_oUnstableRegionMask.data[nPxIter];
+                uchar& nCurrRegionIllumUpdtVal = m_oIllumUpdtRegionMask.data[nPxIter];
+                uchar& nCurrRegionSegmVal = oCurrFGMask.data[nPxIter];
+                const bool bCurrRegionIsROIBorder = m_oROI.data[nPxIter]<UCHAR_MAX;
 #if DISPLAY_PAWCS_DEBUG_INFO
-            oDBGWeightThresholds.at<float>(m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X) = fLocalWordsWeightSumThreshold;
+                oDBGWeightThresholds.at<float>(m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X) = fLocalWordsWeightSumThreshold;
 #endif //DISPLAY_PAWCS_DEBUG_INFO
-            const int nCurrImgCoord_X = m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X;
-            const int nCurrImgCoord_Y = m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y;
-            alignas(16) std::array<uchar,LBSP::DESC_SIZE_BITS> anLBSPLookupVals;
-            LBSP::computeDescriptor_lookup<1>(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,0,anLBSPLookupVals);
-            const ushort nCurrIntraDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nCurrColor,m_anLBSPThreshold_8bitLUT[nCurrColor]);
-            const uchar nCurrIntraDescBITS = (uchar)lv::popcount(nCurrIntraDesc);
-            const bool bCurrRegionIsFlat = nCurrIntraDescBITS<FLAT_REGION_BIT_COUNT;
-            if(bCurrRegionIsFlat)
-                ++nFlatRegionCount;
-            const size_t nCurrWordOccIncr = (DEFAULT_LWORD_OCC_INCR+m_nModelResetCooldown)<<int(bCurrRegionIsFlat||bBootstrapping);
+                const int nCurrImgCoord_X = m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X;
+                const int nCurrImgCoord_Y = m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y;
+                alignas(16) std::array<uchar,LBSP::DESC_SIZE_BITS> anLBSPLookupVals;
+                LBSP::computeDescriptor_lookup<1>(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,0,anLBSPLookupVals);
+                const ushort nCurrIntraDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nCurrColor,m_anLBSPThreshold_8bitLUT[nCurrColor]);
+                const uchar nCurrIntraDescBITS = (uchar)lv::popcount(nCurrIntraDesc);
+                const bool bCurrRegionIsFlat = nCurrIntraDescBITS<FLAT_REGION_BIT_COUNT;
+                if(bCurrRegionIsFlat)
+                    ++nBandFlatRegionCount;
+                const size_t nCurrWordOccIncr = (DEFAULT_LWORD_OCC_INCR+m_nModelResetCooldown)<<int(bCurrRegionIsFlat||bBootstrapping);
 #if USE_FEEDBACK_ADJUSTMENTS
-            const size_t nCurrLocalWordUpdateRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):bCurrRegionIsFlat?(size_t)ceil(fCurrLearningRate+FEEDBACK_T_LOWER)/2:(size_t)ceil(fCurrLearningRate));
+                const size_t nCurrLocalWordUpdateRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):bCurrRegionIsFlat?(size_t)ceil(getGovernedLearningRate(getCompensatedLearningRate(fCurrLearningRate+FEEDBACK_T_LOWER)))/2:(size_t)ceil(getGovernedLearningRate(getCompensatedLearningRate(fCurrLearningRate))));
 #else //(!USE_FEEDBACK_ADJUSTMENTS)
-            const size_t nCurrLocalWordUpdateRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)DEFAULT_RESAMPLING_RATE);
+                const size_t nCurrLocalWordUpdateRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)ceil(getGovernedLearningRate(DEFAULT_RESAMPLING_RATE)));
 #endif //(!USE_FEEDBACK_ADJUSTMENTS)
-            const size_t nCurrColorDistThreshold = (size_t)(sqrt(fCurrDistThresholdFactor)*m_nMinColorDistThreshold)/2;
-            const size_t nCurrDescDistThreshold = ((size_t)1<<((size_t)floor(fCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(bCurrRegionIsUnstable*UNSTAB_DESC_DIST_OFFSET);
-            size_t nLocalWordIdx = 0;
-            float fPotentialLocalWordsWeightSum = 0.0f;
-            float fLastLocalWordWeight = FLT_MAX;
+                const size_t nCurrColorDistThreshold = (size_t)(sqrt(fCurrDistThresholdFactor)*m_nMinColorDistThreshold)/2;
+                const size_t nCurrDescDistThreshold = ((size_t)1<<((size_t)floor(fCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(bCurrRegionIsUnstable*UNSTAB_DESC_DIST_OFFSET);
+                size_t nLocalWordIdx = 0;
+                float fPotentialLocalWordsWeightSum = 0.0f;
+                float fLastLocalWordWeight = FLT_MAX;
 #if USE_INTERNAL_HRCS
-            std::chrono::high_resolution_clock::time_point post_prep = std::chrono::high_resolution_clock::now();
-            fPrepTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_prep-pre_prep).count())/1000000;
+                std::chrono::high_resolution_clock::time_point post_prep = std::chrono::high_resolution_clock::now();
+                fPrepTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_prep-pre_prep).count())/1000000;
 #endif //USE_INTERNAL_HRCS
-            while(nLocalWordIdx<m_nCurrLocalWords && fPotentialLocalWordsWeightSum<fLocalWordsWeightSumThreshold) {
-                LocalWord_1ch& oCurrLocalWord = (LocalWord_1ch&)*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
-                const float fCurrLocalWordWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
-                {
-                    const size_t nColorDist = lv::L1dist(nCurrColor,oCurrLocalWord.oFeature.anColor[0]);
-                    const size_t nIntraDescDist = lv::hdist(nCurrIntraDesc,oCurrLocalWord.oFeature.anDesc[0]);
-                    const ushort nCurrInterDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,oCurrLocalWord.oFeature.anColor[0],m_anLBSPThreshold_8bitLUT[oCurrLocalWord.oFeature.anColor[0]]);
-                    const size_t nInterDescDist = lv::hdist(nCurrInterDesc,oCurrLocalWord.oFeature.anDesc[0]);
-                    const size_t nDescDist = (nIntraDescDist+nInterDescDist)/2;
-                    if( (!bCurrRegionIsUnstable || bCurrRegionIsFlat || bCurrRegionIsROIBorder)
-                            && nColorDist<=nCurrColorDistThreshold
-                            && nColorDist>=nCurrColorDistThreshold/2
-                            && nIntraDescDist<=nCurrDescDistThreshold/2
-                            && (rand()%(nCurrRegionIllumUpdtVal?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate))==0) {
-                        // == illum updt
-                        oCurrLocalWord.oFeature.anColor[0] = nCurrColor;
-                        oCurrLocalWord.oFeature.anDesc[0] = nCurrIntraDesc;
-                        m_oIllumUpdtRegionMask.data[nPxIter-1] = 1&m_oROI.data[nPxIter-1];
-                        m_oIllumUpdtRegionMask.data[nPxIter+1] = 1&m_oROI.data[nPxIter+1];
-                        m_oIllumUpdtRegionMask.data[nPxIter] = 2;
+                while(nLocalWordIdx<m_nCurrLocalWords && fPotentialLocalWordsWeightSum<fLocalWordsWeightSumThreshold) {
+                    ++nBandSamplesTested;
+                    const size_t nCurrLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx);
+                    ColorLBSPFeature<1>& oCurrLocalWordFeature = m_voLocalWordFeatures_1ch[nCurrLocalWordSlotIdx];
+                    LocalWordStats& oCurrLocalWordStats = m_voLocalWordStats[nCurrLocalWordSlotIdx];
+                    const float fCurrLocalWordWeight = GetLocalWordWeight(oCurrLocalWordStats,m_nFrameIdx,m_nLocalWordWeightOffset);
+                    {
+                        const size_t nColorDist = lv::L1dist(nCurrColor,oCurrLocalWordFeature.anColor[0]);
+                        const size_t nIntraDescDist = lv::hdist(nCurrIntraDesc,oCurrLocalWordFeature.anDesc[0]);
+                        // the shared lookup values are only re-thresholded for color-matched words (and before any illum update of the word)
+                        size_t nDescDist = SIZE_MAX;
+                        if(nColorDist<=nCurrColorDistThreshold) {
+                            const ushort nCurrInterDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,oCurrLocalWordFeature.anColor[0],m_anLBSPThreshold_8bitLUT[oCurrLocalWordFeature.anColor[0]]);
+                            nDescDist = (nIntraDescDist+lv::hdist(nCurrInterDesc,oCurrLocalWordFeature.anDesc[0]))/2;
+                        }
+                        if( (!bCurrRegionIsUnstable || bCurrRegionIsFlat || bCurrRegionIsROIBorder)
+                                && nColorDist<=nCurrColorDistThreshold
+                                && nColorDist>=nCurrColorDistThreshold/2
+                                && nIntraDescDist<=nCurrDescDistThreshold/2
+                                && (oRNG()%(nCurrRegionIllumUpdtVal?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate))==0) {
+                            // == illum updt
+                            oCurrLocalWordFeature.anColor[0] = nCurrColor;
+                            oCurrLocalWordFeature.anDesc[0] = nCurrIntraDesc;
+                            m_oIllumUpdtRegionMask.data[nPxIter-1] = 1&m_oROI.data[nPxIter-1];
+                            m_oIllumUpdtRegionMask.data[nPxIter+1] = 1&m_oROI.data[nPxIter+1];
+                            m_oIllumUpdtRegionMask.data[nPxIter] = 2;
 #if DISPLAY_PAWCS_DEBUG_INFO
-                        vsWordModList[nLocalDictIdx+nLocalWordIdx] += "UPDATED ";
+                            vsWordModList[nLocalDictIdx+nLocalWordIdx] += "UPDATED ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
-                    }
-                    if(nDescDist<=nCurrDescDistThreshold && nColorDist<=nCurrColorDistThreshold) {
-                        fPotentialLocalWordsWeightSum += fCurrLocalWordWeight;
-                        oCurrLocalWord.nLastOcc = m_nFrameIdx;
-                        if((!m_oLastFGMask.data[nPxIter] || m_bUsingMovingCamera) && fCurrLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
-                            oCurrLocalWord.nOccurrences += nCurrWordOccIncr;
-                        nMinColorDist = std::min(nMinColorDist,nColorDist);
-                        nMinDescDist = std::min(nMinDescDist,nDescDist);
+                        }
+                        if(nDescDist<=nCurrDescDistThreshold && nColorDist<=nCurrColorDistThreshold) {
+                            fPotentialLocalWordsWeightSum += fCurrLocalWordWeight;
+                            oCurrLocalWordStats.nLastOcc = m_nFrameIdx;
+                            if((!m_oLastFGMask.data[nPxIter] || m_bUsingMovingCamera) && fCurrLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
+                                oCurrLocalWordStats.nOccurrences += nCurrWordOccIncr;
+                            nMinColorDist = std::min(nMinColorDist,nColorDist);
+                            nMinDescDist = std::min(nMinDescDist,nDescDist);
 #if DISPLAY_PAWCS_DEBUG_INFO
-                        vsWordModList[nLocalDictIdx+nLocalWordIdx] += "MATCHED ";
+                            vsWordModList[nLocalDictIdx+nLocalWordIdx] += "MATCHED ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
+                        }
                     }
-                }
-                if(fCurrLocalWordWeight>fLastLocalWordWeight) {
-                    std::swap(m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
+                    if(fCurrLocalWordWeight>fLastLocalWordWeight) {
+                        std::swap(m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
 #if DISPLAY_PAWCS_DEBUG_INFO
-                    std::swap(vsWordModList[nLocalDictIdx+nLocalWordIdx],vsWordModList[nLocalDictIdx+nLocalWordIdx-1]);
+                        std::swap(vsWordModList[nLocalDictIdx+nLocalWordIdx],vsWordModList[nLocalDictIdx+nLocalWordIdx-1]);
 #endif //DISPLAY_PAWCS_DEBUG_INFO
+                    }
+                    else
+                        fLastLocalWordWeight = fCurrLocalWordWeight;
+                    ++nLocalWordIdx;
                 }
-                else
-                    fLastLocalWordWeight = fCurrLocalWordWeight;
-                ++nLocalWordIdx;
-            }
-            while(nLocalWordIdx<m_nCurrLocalWords) {
-                const float fCurrLocalWordWeight = GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_nFrameIdx,m_nLocalWordWeightOffset);
-                if(fCurrLocalWordWeight>fLastLocalWordWeight) {
-                    std::swap(m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
+                if(nLocalWordIdx<m_nCurrLocalWords)
+                    ++nBandEarlyExits;
+                // unscanned words were not matched, so their (time-stamped) weights only decayed; their sort pass is amortized over frames,
+                // and only forced when a new word takes the last slot (the full pass is what moves the weakest word there)
+                const auto lSortLocalWordDictTail = [&]() {
+                    while(nLocalWordIdx<m_nCurrLocalWords) {
+                        const float fCurrLocalWordWeight = GetLocalWordWeight(m_voLocalWordStats[getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx)],m_nFrameIdx,m_nLocalWordWeightOffset);
+                        if(fCurrLocalWordWeight>fLastLocalWordWeight) {
+                            std::swap(m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
 #if DISPLAY_PAWCS_DEBUG_INFO
-                    std::swap(vsWordModList[nLocalDictIdx+nLocalWordIdx],vsWordModList[nLocalDictIdx+nLocalWordIdx-1]);
+                            std::swap(vsWordModList[nLocalDictIdx+nLocalWordIdx],vsWordModList[nLocalDictIdx+nLocalWordIdx-1]);
 #endif //DISPLAY_PAWCS_DEBUG_INFO
-                }
-                else
-                    fLastLocalWordWeight = fCurrLocalWordWeight;
-                ++nLocalWordIdx;
-            }
+                        }
+                        else
+                            fLastLocalWordWeight = fCurrLocalWordWeight;
+                        ++nLocalWordIdx;
+                    }
+                };
+                if(((m_nFrameIdx+nModelIter)%LWORD_TAIL_SORT_PERIOD)==0)
+                    lSortLocalWordDictTail();
 #if USE_INTERNAL_HRCS
-            std::chrono::high_resolution_clock::time_point post_ldictscan = std::chrono::high_resolution_clock::now();
-            fLDictScanTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_ldictscan-post_prep).count())/1000000;
+                std::chrono::high_resolution_clock::time_point post_ldictscan = std::chrono::high_resolution_clock::now();
+                fLDictScanTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_ldictscan-post_prep).count())/1000000;
 #endif //USE_INTERNAL_HRCS
-            if(fPotentialLocalWordsWeightSum>=fLocalWordsWeightSumThreshold || bCurrRegionIsROIBorder) {
-                // == background
+                if(fPotentialLocalWordsWeightSum>=fLocalWordsWeightSumThreshold || bCurrRegionIsROIBorder) {
+                    // == background
 #if USE_FEEDBACK_ADJUSTMENTS
-                const float fNormalizedMinDist = std::max((float)nMinColorDist/s_nColorMaxDataRange_1ch,(float)nMinDescDist/s_nDescMaxDataRange_1ch);
-                fCurrMeanMinDist_LT = fCurrMeanMinDist_LT*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
-                fCurrMeanMinDist_ST = fCurrMeanMinDist_ST*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
+                    const float fNormalizedMinDist = std::max((float)nMinColorDist/s_nColorMaxDataRange_1ch,(float)nMinDescDist/s_nDescMaxDataRange_1ch);
+                    fCurrMeanMinDist_LT = fCurrMeanMinDist_LT*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
+                    fCurrMeanMinDist_ST = fCurrMeanMinDist_ST*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
 #endif //USE_FEEDBACK_ADJUSTMENTS
-                fCurrMeanRawSegmRes_LT = fCurrMeanRawSegmRes_LT*(1.0f-fRollAvgFactor_LT);
-                fCurrMeanRawSegmRes_ST = fCurrMeanRawSegmRes_ST*(1.0f-fRollAvgFactor_ST);
-                if((rand()%nCurrLocalWordUpdateRate)==0) {
-                    size_t nGlobalWordLUTIdx;
-                    GlobalWord_1ch* pCurrGlobalWord = nullptr;
-                    for(nGlobalWordLUTIdx=0; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx) {
-                        pCurrGlobalWord = (GlobalWord_1ch*)m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx];
-                        if(lv::L1dist(pCurrGlobalWord->oFeature.anColor[0],nCurrColor)<=nCurrColorDistThreshold &&
-                           lv::L1dist(nCurrIntraDescBITS,pCurrGlobalWord->nDescBITS)<=nCurrDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR)
-                            break;
-                    }
-                    if(nGlobalWordLUTIdx!=m_nCurrGlobalWords || (rand()%(nCurrLocalWordUpdateRate*2))==0) {
-                        if(nGlobalWordLUTIdx==m_nCurrGlobalWords) {
-                            pCurrGlobalWord = (GlobalWord_1ch*)m_vpGlobalWordDict[m_nCurrGlobalWords-1];
-                            pCurrGlobalWord->oFeature.anColor[0] = nCurrColor;
-                            pCurrGlobalWord->oFeature.anDesc[0] = nCurrIntraDesc;
-                            pCurrGlobalWord->nDescBITS = nCurrIntraDescBITS;
-                            pCurrGlobalWord->oSpatioOccMap = cv::Scalar(0.0f);
-                            pCurrGlobalWord->fLatestWeight = 0.0f;
-                        }
-                        float& fCurrGlobalWordLocalWeight = *(float*)(pCurrGlobalWord->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
-                        if(fCurrGlobalWordLocalWeight<fPotentialLocalWordsWeightSum) {
-                            pCurrGlobalWord->fLatestWeight += fPotentialLocalWordsWeightSum;
-                            fCurrGlobalWordLocalWeight += fPotentialLocalWordsWeightSum;
+                    fCurrMeanRawSegmRes_LT = fCurrMeanRawSegmRes_LT*(1.0f-fRollAvgFactor_LT);
+                    fCurrMeanRawSegmRes_ST = fCurrMeanRawSegmRes_ST*(1.0f-fRollAvgFactor_ST);
+                    if((oRNG()%nCurrLocalWordUpdateRate)==0) {
+                        GlobalWord_1ch* pCurrGlobalWord = (GlobalWord_1ch*)findGlobalWord<1>(nGlobalWordMapLookupIdx/4,&nCurrColor,nCurrIntraDescBITS,nCurrColorDistThreshold,nCurrDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR);
+                        if(pCurrGlobalWord || (oRNG()%(nCurrLocalWordUpdateRate*2))==0) {
+                            if(!pCurrGlobalWord) {
+                                // replacing the weakest global word affects all bands, so it is deferred to the end of the frame
+                                oBandDelta.bReplaceWeakestWord = true;
+                                oBandDelta.oReplacementFeature.anColor[0] = nCurrColor;
+                                oBandDelta.oReplacementFeature.anDesc[0] = nCurrIntraDesc;
+                                oBandDelta.nReplacementDescBITS = nCurrIntraDescBITS;
+                                oBandDelta.nReplacementLookupIdx = nGlobalWordMapLookupIdx;
+                                oBandDelta.fReplacementWeight = fPotentialLocalWordsWeightSum;
+                            }
+                            else {
+                                float& fCurrGlobalWordLocalWeight = updateGlobalWordLocalWeight(*pCurrGlobalWord,nGlobalWordMapLookupIdx);
+                                if(fCurrGlobalWordLocalWeight<fPotentialLocalWordsWeightSum) {
+                                    oBandDelta.vfWeightIncrs[size_t(pCurrGlobalWord-m_voGlobalWordList_1ch.data())] += fPotentialLocalWordsWeightSum;
+                                    fCurrGlobalWordLocalWeight += fPotentialLocalWordsWeightSum;
+                                    // lookup map cells never straddle row bands, so each band only flags its own cells
+                                    m_vbDirtyGlobalWordLUTCells[nGlobalWordMapLookupIdx/4] = 1;
+                                }
+                            }
                         }
                     }
                 }
-            }
-            else {
-                // == foreground
+                else {
+                    // == foreground
 #if USE_FEEDBACK_ADJUSTMENTS
-                const float fNormalizedMinDist = std::max(std::max((float)nMinColorDist/s_nColorMaxDataRange_1ch,(float)nMinDescDist/s_nDescMaxDataRange_1ch),(fLocalWordsWeightSumThreshold-fPotentialLocalWordsWeightSum)/fLocalWordsWeightSumThreshold);
-                fCurrMeanMinDist_LT = fCurrMeanMinDist_LT*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
-                fCurrMeanMinDist_ST = fCurrMeanMinDist_ST*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
+                    const float fNormalizedMinDist = std::max(std::max((float)nMinColorDist/s_nColorMaxDataRange_1ch,(float)nMinDescDist/s_nDescMaxDataRange_1ch),(fLocalWordsWeightSumThreshold-fPotentialLocalWordsWeightSum)/fLocalWordsWeightSumThreshold);
+                    fCurrMeanMinDist_LT = fCurrMeanMinDist_LT*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
+                    fCurrMeanMinDist_ST = fCurrMeanMinDist_ST*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
 #endif //USE_FEEDBACK_ADJUSTMENTS
-                fCurrMeanRawSegmRes_LT = fCurrMeanRawSegmRes_LT*(1.0f-fRollAvgFactor_LT) + fRollAvgFactor_LT;
-                fCurrMeanRawSegmRes_ST = fCurrMeanRawSegmRes_ST*(1.0f-fRollAvgFactor_ST) + fRollAvgFactor_ST;
-                if(bCurrRegionIsFlat || (rand()%nCurrLocalWordUpdateRate)==0) {
-                    size_t nGlobalWordLUTIdx;
-                    GlobalWord_1ch* pCurrGlobalWord = nullptr;
-                    for(nGlobalWordLUTIdx=0; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx) {
-                        pCurrGlobalWord = (GlobalWord_1ch*)m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx];
-                        if(lv::L1dist(pCurrGlobalWord->oFeature.anColor[0],nCurrColor)<=nCurrColorDistThreshold &&
-                           lv::L1dist(nCurrIntraDescBITS,pCurrGlobalWord->nDescBITS)<=nCurrDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR)
-                            break;
-                    }
-                    if(nGlobalWordLUTIdx==m_nCurrGlobalWords)
-                        nCurrRegionSegmVal = UCHAR_MAX;
-                    else {
-                        const float fGlobalWordLocalizedWeight = *(float*)(pCurrGlobalWord->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
-                        if(fPotentialLocalWordsWeightSum+fGlobalWordLocalizedWeight/(bCurrRegionIsFlat?2:4)<fLocalWordsWeightSumThreshold)
+                    fCurrMeanRawSegmRes_LT = fCurrMeanRawSegmRes_LT*(1.0f-fRollAvgFactor_LT) + fRollAvgFactor_LT;
+                    fCurrMeanRawSegmRes_ST = fCurrMeanRawSegmRes_ST*(1.0f-fRollAvgFactor_ST) + fRollAvgFactor_ST;
+                    if(bCurrRegionIsFlat || (oRNG()%nCurrLocalWordUpdateRate)==0) {
+                        GlobalWord_1ch* pCurrGlobalWord = (GlobalWord_1ch*)findGlobalWord<1>(nGlobalWordMapLookupIdx/4,&nCurrColor,nCurrIntraDescBITS,nCurrColorDistThreshold,nCurrDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR);
+                        if(!pCurrGlobalWord)
                             nCurrRegionSegmVal = UCHAR_MAX;
-                    }
+                        else {
+                            const float fGlobalWordLocalizedWeight = getGlobalWordLocalWeight(*pCurrGlobalWord,nGlobalWordMapLookupIdx);
+                            if(fPotentialLocalWordsWeightSum+fGlobalWordLocalizedWeight/(bCurrRegionIsFlat?2:4)<fLocalWordsWeightSumThreshold)
+                                nCurrRegionSegmVal = UCHAR_MAX;
+                        }
 #if DISPLAY_PAWCS_DEBUG_INFO
-                    if(!nCurrRegionSegmVal && m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y==oDbgPt.y && m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X==oDbgPt.x) {
-                        bDBGMaskModifiedByGDict = true;
-                        pDBGGlobalWordModifier = pCurrGlobalWord;
-                        fDBGGlobalWordModifierLocalWeight = *(float*)(pCurrGlobalWord->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
+                        if(!nCurrRegionSegmVal && m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y==oDbgPt.y && m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X==oDbgPt.x) {
+                            bDBGMaskModifiedByGDict = true;
+                            pDBGGlobalWordModifier = pCurrGlobalWord;
+                            fDBGGlobalWordModifierLocalWeight = getGlobalWordLocalWeight(*pCurrGlobalWord,nGlobalWordMapLookupIdx);
+                        }
+#endif //DISPLAY_PAWCS_DEBUG_INFO
                     }
+                    else
+                        nCurrRegionSegmVal = UCHAR_MAX;
+                    if(fPotentialLocalWordsWeightSum<DEFAULT_LWORD_INIT_WEIGHT) {
+                        lSortLocalWordDictTail();
+                        const size_t nNewLocalWordIdx = m_nCurrLocalWords-1;
+                        const size_t nNewLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,nNewLocalWordIdx);
+                        ColorLBSPFeature<1>& oNewLocalWordFeature = m_voLocalWordFeatures_1ch[nNewLocalWordSlotIdx];
+                        LocalWordStats& oNewLocalWordStats = m_voLocalWordStats[nNewLocalWordSlotIdx];
+                        oNewLocalWordFeature.anColor[0] = nCurrColor;
+                        oNewLocalWordFeature.anDesc[0] = nCurrIntraDesc;
+                        oNewLocalWordStats.nOccurrences = nCurrWordOccIncr;
+                        oNewLocalWordStats.nFirstOcc = m_nFrameIdx;
+                        oNewLocalWordStats.nLastOcc = m_nFrameIdx;
+#if DISPLAY_PAWCS_DEBUG_INFO
+                        vsWordModList[nLocalDictIdx+nNewLocalWordIdx] += "NEW ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
-                }
-                else
-                    nCurrRegionSegmVal = UCHAR_MAX;
-                if(fPotentialLocalWordsWeightSum<DEFAULT_LWORD_INIT_WEIGHT) {
-                    const size_t nNewLocalWordIdx = m_nCurrLocalWords-1;
-                    LocalWord_1ch& oNewLocalWord = (LocalWord_1ch&)*m_vpLocalWordDict[nLocalDictIdx+nNewLocalWordIdx];
-                    oNewLocalWord.oFeature.anColor[0] = nCurrColor;
-                    oNewLocalWord.oFeature.anDesc[0] = nCurrIntraDesc;
-                    oNewLocalWord.nOccurrences = nCurrWordOccIncr;
-                    oNewLocalWord.nFirstOcc = m_nFrameIdx;
-                    oNewLocalWord.nLastOcc = m_nFrameIdx;
+                        // the new word is ranked right away, as it would otherwise only move up by one position per (amortized) sort pass
+                        const float fNewLocalWordWeight = GetLocalWordWeight(oNewLocalWordStats,m_nFrameIdx,m_nLocalWordWeightOffset);
+                        size_t nNewLocalWordRank = nNewLocalWordIdx;
+                        while(nNewLocalWordRank>0 && fNewLocalWordWeight>GetLocalWordWeight(m_voLocalWordStats[getLocalWordSlotIdx(nLocalDictIdx,nNewLocalWordRank-1)],m_nFrameIdx,m_nLocalWordWeightOffset)) {
+                            std::swap(m_vnLocalWordDict[nLocalDictIdx+nNewLocalWordRank],m_vnLocalWordDict[nLocalDictIdx+nNewLocalWordRank-1]);
 #if DISPLAY_PAWCS_DEBUG_INFO
-                    vsWordModList[nLocalDictIdx+nNewLocalWordIdx] += "NEW ";
+                            std::swap(vsWordModList[nLocalDictIdx+nNewLocalWordRank],vsWordModList[nLocalDictIdx+nNewLocalWordRank-1]);
 #endif //DISPLAY_PAWCS_DEBUG_INFO
+                            --nNewLocalWordRank;
+                        }
+                    }
                 }
-            }
 #if USE_INTERNAL_HRCS
-            std::chrono::high_resolution_clock::time_point post_rawdecision = std::chrono::high_resolution_clock::now();
-            if(nCurrRegionSegmVal)
-                fFGRawTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_rawdecision-post_ldictscan).count())/1000000;
-            else
-                fBGRawTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_rawdecision-post_ldictscan).count())/1000000;
-#endif //USE_INTERNAL_HRCS
-            // == neighb updt
-            if((!nCurrRegionSegmVal && (rand()%nCurrLocalWordUpdateRate)==0) || bCurrRegionIsROIBorder || m_bUsingMovingCamera) {
-            //if((!nCurrRegionSegmVal && (rand()%(nCurrRegionIllumUpdtVal?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate))==0) || bCurrRegionIsROIBorder) {
-                int nSampleImgCoord_Y, nSampleImgCoord_X;
-                if(bCurrRegionIsFlat || bCurrRegionIsROIBorder || m_bUsingMovingCamera)
-                    cv::getRandNeighborPosition_5x5(nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                std::chrono::high_resolution_clock::time_point post_rawdecision = std::chrono::high_resolution_clock::now();
+                if(nCurrRegionSegmVal)
+                    fFGRawTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_rawdecision-post_ldictscan).count())/1000000;
                 else
-                    cv::getRandNeighborPosition_3x3(nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
-                if(m_oROI.data[nSamplePxIdx]) {
-                    const size_t nNeighborLocalDictIdx = m_voPxInfoLUT_PAWCS[nSamplePxIdx].nModelIdx*m_nCurrLocalWords;
-                    size_t nNeighborLocalWordIdx = 0;
-                    float fNeighborPotentialLocalWordsWeightSum = 0.0f;
-                    while(nNeighborLocalWordIdx<m_nCurrLocalWords && fNeighborPotentialLocalWordsWeightSum<fLocalWordsWeightSumThreshold) {
-                        LocalWord_1ch oNeighborLocalWord = (LocalWord_1ch&)*m_vpLocalWordDict[nNeighborLocalDictIdx+nNeighborLocalWordIdx];
-                        const size_t nNeighborColorDist = lv::L1dist(nCurrColor,oNeighborLocalWord.oFeature.anColor[0]);
-                        const size_t nNeighborIntraDescDist = lv::hdist(nCurrIntraDesc,oNeighborLocalWord.oFeature.anDesc[0]);
-                        const bool bNeighborRegionIsFlat = lv::popcount(oNeighborLocalWord.oFeature.anDesc[0])<FLAT_REGION_BIT_COUNT;
-                        const size_t nNeighborWordOccIncr = bNeighborRegionIsFlat?nCurrWordOccIncr*2:nCurrWordOccIncr;
-                        if(nNeighborColorDist<=nCurrColorDistThreshold && nNeighborIntraDescDist<=nCurrDescDistThreshold) {
-                            const float fNeighborLocalWordWeight = GetLocalWordWeight(oNeighborLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
-                            fNeighborPotentialLocalWordsWeightSum += fNeighborLocalWordWeight;
-                            oNeighborLocalWord.nLastOcc = m_nFrameIdx;
-                            if(fNeighborLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
-                                oNeighborLocalWord.nOccurrences += nNeighborWordOccIncr;
-#if DISPLAY_PAWCS_DEBUG_INFO
-                            vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "MATCHED(NEIGHBOR) ";
-#endif //DISPLAY_PAWCS_DEBUG_INFO
-                        }
-                        else if(!oCurrFGMask.data[nSamplePxIdx] && bCurrRegionIsFlat && (bBootstrapping || (rand()%nCurrLocalWordUpdateRate)==0)) {
-                            const size_t nSampleDescIdx = nSamplePxIdx*2;
-                            ushort& nNeighborLastIntraDesc = *((ushort*)(m_oLastDescFrame.data+nSampleDescIdx));
-                            const size_t nNeighborLastIntraDescDist = lv::hdist(nCurrIntraDesc,nNeighborLastIntraDesc);
-                            if(nNeighborColorDist<=nCurrColorDistThreshold && nNeighborLastIntraDescDist<=nCurrDescDistThreshold/2) {
-                                const float fNeighborLocalWordWeight = GetLocalWordWeight(oNeighborLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
+                    fBGRawTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_rawdecision-post_ldictscan).count())/1000000;
+#endif //USE_INTERNAL_HRCS
+                // == neighb updt
+                if((!nCurrRegionSegmVal && (oRNG()%nCurrLocalWordUpdateRate)==0) || bCurrRegionIsROIBorder || m_bUsingMovingCamera) {
+                //if((!nCurrRegionSegmVal && (oRNG()%(nCurrRegionIllumUpdtVal?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate))==0) || bCurrRegionIsROIBorder) {
+                    const size_t nSamplePxIdx = (bCurrRegionIsFlat || bCurrRegionIsROIBorder || m_bUsingMovingCamera)?m_oRandNeighborLUT_5x5.getRandIdx(nPxIter,oRNG):m_oRandNeighborLUT_3x3.getRandIdx(nPxIter,oRNG);
+                    if(m_oROI.data[nSamplePxIdx]) {
+                        const size_t nNeighborLocalDictIdx = m_voPxInfoLUT_PAWCS[nSamplePxIdx].nModelIdx*m_nCurrLocalWords;
+                        size_t nNeighborLocalWordIdx = 0;
+                        float fNeighborPotentialLocalWordsWeightSum = 0.0f;
+                        while(nNeighborLocalWordIdx<m_nCurrLocalWords && fNeighborPotentialLocalWordsWeightSum<fLocalWordsWeightSumThreshold) {
+                            const size_t nNeighborLocalWordSlotIdx = getLocalWordSlotIdx(nNeighborLocalDictIdx,nNeighborLocalWordIdx);
+                            ColorLBSPFeature<1> oNeighborLocalWordFeature = m_voLocalWordFeatures_1ch[nNeighborLocalWordSlotIdx];
+                            LocalWordStats oNeighborLocalWordStats = m_voLocalWordStats[nNeighborLocalWordSlotIdx];
+                            const size_t nNeighborColorDist = lv::L1dist(nCurrColor,oNeighborLocalWordFeature.anColor[0]);
+                            const size_t nNeighborIntraDescDist = lv::hdist(nCurrIntraDesc,oNeighborLocalWordFeature.anDesc[0]);
+                            const bool bNeighborRegionIsFlat = lv::popcount(oNeighborLocalWordFeature.anDesc[0])<FLAT_REGION_BIT_COUNT;
+                            const size_t nNeighborWordOccIncr = bNeighborRegionIsFlat?nCurrWordOccIncr*2:nCurrWordOccIncr;
+                            if(nNeighborColorDist<=nCurrColorDistThreshold && nNeighborIntraDescDist<=nCurrDescDistThreshold) {
+                                const float fNeighborLocalWordWeight = GetLocalWordWeight(oNeighborLocalWordStats,m_nFrameIdx,m_nLocalWordWeightOffset);
                                 fNeighborPotentialLocalWordsWeightSum += fNeighborLocalWordWeight;
-                                oNeighborLocalWord.nLastOcc = m_nFrameIdx;
+                                oNeighborLocalWordStats.nLastOcc = m_nFrameIdx;
                                 if(fNeighborLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
-                                    oNeighborLocalWord.nOccurrences += nNeighborWordOccIncr;
-                                oNeighborLocalWord.oFeature.anDesc[0] = nCurrIntraDesc;
+                                    oNeighborLocalWordStats.nOccurrences += nNeighborWordOccIncr;
+#if DISPLAY_PAWCS_DEBUG_INFO
+                                vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "MATCHED(NEIGHBOR) ";
+#endif //DISPLAY_PAWCS_DEBUG_INFO
+                            }
+                            else if(!oCurrFGMask.data[nSamplePxIdx] && bCurrRegionIsFlat && (bBootstrapping || (oRNG()%nCurrLocalWordUpdateRate)==0)) {
+                                const size_t nSampleDescIdx = nSamplePxIdx*2;
+                                ushort& nNeighborLastIntraDesc = *((ushort*)(m_oLastDescFrame.data+nSampleDescIdx));
+                                const size_t nNeighborLastIntraDescDist = lv::hdist(nCurrIntraDesc,nNeighborLastIntraDesc);
+                                if(nNeighborColorDist<=nCurrColorDistThreshold && nNeighborLastIntraDescDist<=nCurrDescDistThreshold/2) {
+                                    const float fNeighborLocalWordWeight = GetLocalWordWeight(oNeighborLocalWordStats,m_nFrameIdx,m_nLocalWordWeightOffset);
+                                    fNeighborPotentialLocalWordsWeightSum += fNeighborLocalWordWeight;
+                                    oNeighborLocalWordStats.nLastOcc = m_nFrameIdx;
+                                    if(fNeighborLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
+                                        oNeighborLocalWordStats.nOccurrences += nNeighborWordOccIncr;
+                                    oNeighborLocalWordFeature.anDesc[0] = nCurrIntraDesc;
 #if DISPLAY_PAWCS_DEBUG_INFO
-                                vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "UPDATED1(NEIGHBOR) ";
+                                    vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "UPDATED1(NEIGHBOR) ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
+                                }
                             }
+                            ++nNeighborLocalWordIdx;
                         }
-                        ++nNeighborLocalWordIdx;
-                    }
-                    if(fNeighborPotentialLocalWordsWeightSum<DEFAULT_LWORD_INIT_WEIGHT) {
-                        nNeighborLocalWordIdx = m_nCurrLocalWords-1;
-                        LocalWord_1ch& oNeighborLocalWord = (LocalWord_1ch&)*m_vpLocalWordDict[nNeighborLocalDictIdx+nNeighborLocalWordIdx];
-                        oNeighborLocalWord.oFeature.anColor[0] = nCurrColor;
-                        oNeighborLocalWord.oFeature.anDesc[0] = nCurrIntraDesc;
-                        oNeighborLocalWord.nOccurrences = nCurrWordOccIncr;
-                        oNeighborLocalWord.nFirstOcc = m_nFrameIdx;
-                        oNeighborLocalWord.nLastOcc = m_nFrameIdx;
+                        if(fNeighborPotentialLocalWordsWeightSum<DEFAULT_LWORD_INIT_WEIGHT) {
+                            nNeighborLocalWordIdx = m_nCurrLocalWords-1;
+                            const size_t nNeighborLocalWordSlotIdx = getLocalWordSlotIdx(nNeighborLocalDictIdx,nNeighborLocalWordIdx);
+                            ColorLBSPFeature<1>& oNeighborLocalWordFeature = m_voLocalWordFeatures_1ch[nNeighborLocalWordSlotIdx];
+                            LocalWordStats& oNeighborLocalWordStats = m_voLocalWordStats[nNeighborLocalWordSlotIdx];
+                            oNeighborLocalWordFeature.anColor[0] = nCurrColor;
+                            oNeighborLocalWordFeature.anDesc[0] = nCurrIntraDesc;
+                            oNeighborLocalWordStats.nOccurrences = nCurrWordOccIncr;
+                            oNeighborLocalWordStats.nFirstOcc = m_nFrameIdx;
+                            oNeighborLocalWordStats.nLastOcc = m_nFrameIdx;
 #if DISPLAY_PAWCS_DEBUG_INFO
-                        vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "NEW(NEIGHBOR) ";
+                            vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "NEW(NEIGHBOR) ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
+                        }
                     }
                 }
-            }
 #if USE_INTERNAL_HRCS
-            std::chrono::high_resolution_clock::time_point post_neighbupdt = std::chrono::high_resolution_clock::now();
-            fNeighbUpdtTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_neighbupdt-post_rawdecision).count())/1000000;
+                std::chrono::high_resolution_clock::time_point post_neighbupdt = std::chrono::high_resolution_clock::now();
+                fNeighbUpdtTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_neighbupdt-post_rawdecision).count())/1000000;
 #endif //USE_INTERNAL_HRCS
-            if(nCurrRegionIllumUpdtVal)
-                nCurrRegionIllumUpdtVal -= 1;
-            // == feedback adj
-            bCurrRegionIsUnstable = fCurrDistThresholdFactor>UNSTABLE_REG_RDIST_MIN || (fCurrMeanRawSegmRes_LT-fCurrMeanFinalSegmRes_LT)>UNSTABLE_REG_RATIO_MIN || (fCurrMeanRawSegmRes_ST-fCurrMeanFinalSegmRes_ST)>UNSTABLE_REG_RATIO_MIN;
+                if(nCurrRegionIllumUpdtVal)
+                    nCurrRegionIllumUpdtVal -= 1;
+                // == feedback adj
+                bCurrRegionIsUnstable = fCurrDistThresholdFactor>UNSTABLE_REG_RDIST_MIN || (fCurrMeanRawSegmRes_LT-fCurrMeanFinalSegmRes_LT)>UNSTABLE_REG_RATIO_MIN || (fCurrMeanRawSegmRes_ST-fCurrMeanFinalSegmRes_ST)>UNSTABLE_REG_RATIO_MIN;
 #if USE_FEEDBACK_ADJUSTMENTS
-            if(m_oLastFGMask.data[nPxIter] || (std::min(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)<UNSTABLE_REG_RATIO_MIN && nCurrRegionSegmVal))
-                fCurrLearningRate = std::min(fCurrLearningRate+FEEDBACK_T_INCR/(std::max(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)*fCurrDistThresholdVariationFactor),FEEDBACK_T_UPPER);
-            else
-                fCurrLearningRate = std::max(fCurrLearningRate-FEEDBACK_T_DECR*fCurrDistThresholdVariationFactor/std::max(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST),FEEDBACK_T_LOWER);
-            if(std::max(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)>UNSTABLE_REG_RATIO_MIN && m_oBlinksFrame.data[nPxIter])
-                (fCurrDistThresholdVariationFactor) += bBootstrapping?FEEDBACK_V_INCR*2:FEEDBACK_V_INCR;
-            else
-                fCurrDistThresholdVariationFactor = std::max(fCurrDistThresholdVariationFactor-FEEDBACK_V_DECR*((bBootstrapping||bCurrRegionIsFlat)?2:m_oLastFGMask.data[nPxIter]?0.5f:1),FEEDBACK_V_DECR);
-            if(fCurrDistThresholdFactor<std::pow(1.0f+std::min(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)*2,2))
-                fCurrDistThresholdFactor += FEEDBACK_R_VAR*(fCurrDistThresholdVariationFactor-FEEDBACK_V_DECR);
-            else
-                fCurrDistThresholdFactor = std::max(fCurrDistThresholdFactor-FEEDBACK_R_VAR/fCurrDistThresholdVariationFactor,1.0f);
+                if(m_oLastFGMask.data[nPxIter] || (std::min(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)<UNSTABLE_REG_RATIO_MIN && nCurrRegionSegmVal))
+                    fCurrLearningRate = std::min(fCurrLearningRate+FEEDBACK_T_INCR/(std::max(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)*fCurrDistThresholdVariationFactor),FEEDBACK_T_UPPER);
+                else
+                    fCurrLearningRate = std::max(fCurrLearningRate-FEEDBACK_T_DECR*fCurrDistThresholdVariationFactor/std::max(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST),FEEDBACK_T_LOWER);
+                if(std::max(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)>UNSTABLE_REG_RATIO_MIN && m_oBlinksFrame.data[nPxIter])
+                    (fCurrDistThresholdVariationFactor) += bBootstrapping?FEEDBACK_V_INCR*2:FEEDBACK_V_INCR;
+                else
+                    fCurrDistThresholdVariationFactor = std::max(fCurrDistThresholdVariationFactor-FEEDBACK_V_DECR*((bBootstrapping||bCurrRegionIsFlat)?2:m_oLastFGMask.data[nPxIter]?0.5f:1),FEEDBACK_V_DECR);
+                if(fCurrDistThresholdFactor<std::pow(1.0f+std::min(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)*2,2))
+                    fCurrDistThresholdFactor += FEEDBACK_R_VAR*(fCurrDistThresholdVariationFactor-FEEDBACK_V_DECR);
+                else
+                    fCurrDistThresholdFactor = std::max(fCurrDistThresholdFactor-FEEDBACK_R_VAR/fCurrDistThresholdVariationFactor,1.0f);
 #endif //USE_FEEDBACK_ADJUSTMENTS
-            nLastIntraDesc = nCurrIntraDesc;
-            nLastColor = nCurrColor;
+                nLastIntraDesc = nCurrIntraDesc;
+                nLastColor = nCurrColor;
 #if USE_INTERNAL_HRCS
-            std::chrono::high_resolution_clock::time_point post_varupdt = std::chrono::high_resolution_clock::now();
-            fVarUpdtTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_varupdt-post_neighbupdt).count())/1000000;
-            post_lastKP = std::chrono::high_resolution_clock::now();
-            fIntraKPsTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_lastKP-pre_currKP).count())/1000000;
+                std::chrono::high_resolution_clock::time_point post_varupdt = std::chrono::high_resolution_clock::now();
+                fVarUpdtTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_varupdt-post_neighbupdt).count())/1000000;
+                post_lastKP = std::chrono::high_resolution_clock::now();
+                fIntraKPsTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_lastKP-pre_currKP).count())/1000000;
 #endif //USE_INTERNAL_HRCS
 #if DISPLAY_PAWCS_DEBUG_INFO
-            if(m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y==oDbgPt.y && m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X==oDbgPt.x) {
-                for(size_t c=0; c<3; ++c) {
-                    anDBGColor[c] = nCurrColor;
-                    anDBGIntraDesc[c] = nCurrIntraDesc;
+                if(m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y==oDbgPt.y && m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X==oDbgPt.x) {
+                    for(size_t c=0; c<3; ++c) {
+                        anDBGColor[c] = nCurrColor;
+                        anDBGIntraDesc[c] = nCurrIntraDesc;
+                    }
+                    fDBGLocalWordsWeightSumThreshold = fLocalWordsWeightSumThreshold;
+                    bDBGMaskResult = (nCurrRegionSegmVal==UCHAR_MAX);
+                    nLocalDictDBGIdx = nLocalDictIdx;
+                    nDBGWordOccIncr = std::max(nDBGWordOccIncr,nCurrWordOccIncr);
                 }
-                fDBGLocalWordsWeightSumThreshold = fLocalWordsWeightSumThreshold;
-                bDBGMaskResult = (nCurrRegionSegmVal==UCHAR_MAX);
-                nLocalDictDBGIdx = nLocalDictIdx;
-                nDBGWordOccIncr = std::max(nDBGWordOccIncr,nCurrWordOccIncr);
-            }
 #endif //DISPLAY_PAWCS_DEBUG_INFO
-        }
+            }
+            nSamplesTested += nBandSamplesTested;
+            nEarlyExits += nBandEarlyExits;
+            return nBandFlatRegionCount;
+        };
+        nFlatRegionCount = processBands(lApplyBand);
 #if USE_INTERNAL_HRCS
         std::chrono::high_resolution_clock::time_point post_loop = std::chrono::high_resolution_clock::now();
         fInterKPsTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_loop-post_lastKP).count())/1000000;
@@ -937,360 +1066,383 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
 #if USE_INTERNAL_HRCS
         std::chrono::high_resolution_clock::time_point pre_loop = std::chrono::high_resolution_clock::now();
 #endif //USE_INTERNAL_HRCS
-        for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
+        const auto lApplyBand = [&](size_t nModelIterBegin, size_t nModelIterEnd, lv::PCG32& oRNG, GlobalDictBandDelta& oBandDelta) {
+            size_t nBandFlatRegionCount = 0, nBandSamplesTested = 0, nBandEarlyExits = 0;
+            for(size_t nModelIter=nModelIterBegin; nModelIter<nModelIterEnd; ++nModelIter) {
 #if USE_INTERNAL_HRCS
-            std::chrono::high_resolution_clock::time_point pre_currKP = std::chrono::high_resolution_clock::now();
-            fInterKPsTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(pre_currKP-post_lastKP).count())/1000000;
-            std::chrono::high_resolution_clock::time_point pre_prep = std::chrono::high_resolution_clock::now();
+                std::chrono::high_resolution_clock::time_point pre_currKP = std::chrono::high_resolution_clock::now();
+                fInterKPsTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(pre_currKP-post_lastKP).count())/1000000;
+                std::chrono::high_resolution_clock::time_point pre_prep = std::chrono::high_resolution_clock::now();
 #endif //USE_INTERNAL_HRCS
-            const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
-            const size_t nPxRGBIter = nPxIter*3;
-            const size_t nDescRGBIter = nPxRGBIter*2;
-            const size_t nFloatIter = nPxIter*4;
-            const size_t nLocalDictIdx = nModelIter*m_nCurrLocalWords;
-            const size_t nGlobalWordMapLookupIdx = m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx;
-            const uchar* const anCurrColor = oInputImg.data+nPxRGBIter;
-            uchar* anLastColor = m_oLastColorFrame.data+nPxRGBIter;
-            ushort* anLastIntraDesc = ((ushort*)(m_oLastDescFrame.data+nDescRGBIter));
-            size_t nMinTotColorDist = s_nColorMaxDataRange_3ch;
-            size_t nMinTotDescDist = s_nDescMaxDataRange_3ch;
-            float& fCurrMeanRawSegmRes_LT = *(float*)(m_oMeanRawSegmResFrame_LT.data+nFloatIter);
-            float& fCurrMeanRawSegmRes_ST = *(float*)(m_oMeanRawSegmResFrame_ST.data+nFloatIter);
-            float& fCurrMeanFinalSegmRes_LT = *(float*)(m_oMeanFinalSegmResFrame_LT.data+nFloatIter);
-            float& fCurrMeanFinalSegmRes_ST = *(float*)(m_oMeanFinalSegmResFrame_ST.data+nFloatIter);
-            float& fCurrDistThresholdFactor = *(float*)(m_oDistThresholdFrame.data+nFloatIter);
+                const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
+                const size_t nPxRGBIter = nPxIter*3;
+                const size_t nDescRGBIter = nPxRGBIter*2;
+                const size_t nFloatIter = nPxIter*4;
+                const size_t nLocalDictIdx = nModelIter*m_nCurrLocalWords;
+                const size_t nGlobalWordMapLookupIdx = m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx;
+                const uchar* const anCurrColor = oInputImg.data+nPxRGBIter;
+                uchar* anLastColor = m_oLastColorFrame.data+nPxRGBIter;
+                ushort* anLastIntraDesc = ((ushort*)(m_oLastDescFrame.data+nDescRGBIter));
+                size_t nMinTotColorDist = s_nColorMaxDataRange_3ch;
+                size_t nMinTotDescDist = s_nDescMaxDataRange_3ch;
+                float& fCurrMeanRawSegmRes_LT = *(float*)(m_oMeanRawSegmResFrame_LT.data+nFloatIter);
+                float& fCurrMeanRawSegmRes_ST = *(float*)(m_oMeanRawSegmResFrame_ST.data+nFloatIter);
+                float& fCurrMeanFinalSegmRes_LT = *(float*)(m_oMeanFinalSegmResFrame_LT.data+nFloatIter);
+                float& fCurrMeanFinalSegmRes_ST = *(float*)(m_oMeanFinalSegmResFrame_ST.data+nFloatIter);
+                float& fCurrDistThresholdFactor = *(float*)(m_oDistThresholdFrame.data+nFloatIter);
 #if USE_FEEDBACK_ADJUSTMENTS
-            float& fCurrDistThresholdVariationFactor = *(float*)(m_oDistThresholdVariationFrame.data+nFloatIter);
-            float& fCurrLearningRate = *(float*)(m_oUpdateRateFrame.data+nFloatIter);
-            float& fCurrMeanMinDist_LT = *(float*)(m_oMeanMinDistFrame_LT.data+nFloatIter);
-            float& fCurrMeanMinDist_ST = *(float*)(m_oMeanMinDistFrame_ST.data+nFloatIter);
+                float& fCurrDistThresholdVariationFactor = *(float*)(m_oDistThresholdVariationFrame.data+nFloatIter);
+                float& fCurrLearningRate = *(float*)(m_oUpdateRateFrame.data+nFloatIter);
+                float& fCurrMeanMinDist_LT = *(float*)(m_oMeanMinDistFrame_LT.data+nFloatIter);
+                float& fCurrMeanMinDist_ST = *(float*)(m_oMeanMinDistFrame_ST.data+nFloatIter);
 #endif //USE_FEEDBACK_ADJUSTMENTS
-            const float fBestLocalWordWeight = GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx],m_nFrameIdx,m_nLocalWordWeightOffset);
-            const float fLocalWordsWeightSumThreshold = fBestLocalWordWeight/(fCurrDistThresholdFactor*2);
-            uchar& bCurrRegionIsUnstable = m_oUnstableRegionMask.data[nPxIter];
-            uchar& nCurrRegionIllumUpdtVal = m_oIllumUpdtRegionMask.data[nPxIter];
-            uchar& nCurrRegionSegmVal = oCurrFGMask.data[nPxIter];
-            const bool bCurrRegionIsROIBorder = m_oROI.data[nPxIter]<UCHAR_MAX;
+                const float fBestLocalWordWeight = GetLocalWordWeight(m_voLocalWordStats[getLocalWordSlotIdx(nLocalDictIdx,0)],m_nFrameIdx,m_nLocalWordWeightOffset);
+                const float fLocalWordsWeightSumThreshold = fBestLocalWordWeight/(fCurrDistThresholdFactor*2);
+                uchar& bCurrRegionIsUnstable = m_oUnstableRegionMask.data[nPxIter];
+                uchar& nCurrRegionIllumUpdtVal = m_oIllumUpdtRegionMask.data[nPxIter];
+                uchar& nCurrRegionSegmVal = oCurrFGMask.data[nPxIter];
+                const bool bCurrRegionIsROIBorder = m_oROI.data[nPxIter]<UCHAR_MAX;
 #if DISPLAY_PAWCS_DEBUG_INFO
-            oDBGWeightThresholds.at<float>(m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X) = fLocalWordsWeightSumThreshold;
+                oDBGWeightThresholds.at<float>(m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X) = fLocalWordsWeightSumThreshold;
 #endif //DISPLAY_PAWCS_DEBUG_INFO
-            const int nCurrImgCoord_X = m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X;
-            const int nCurrImgCoord_Y = m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y;
-            alignas(16) std::array<std::array<uchar,LBSP::DESC_SIZE_BITS>,3> aanLBSPLookupVals;
-            LBSP::computeDescriptor_lookup(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,aanLBSPLookupVals);
-            std::array<ushort,3> anCurrIntraDesc;
-            for(size_t c=0; c<3; ++c)
-                anCurrIntraDesc[c] = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anCurrColor[c],m_anLBSPThreshold_8bitLUT[anCurrColor[c]]);
-            const uchar nCurrIntraDescBITS = (uchar)lv::popcount(anCurrIntraDesc);
-            const bool bCurrRegionIsFlat = nCurrIntraDescBITS<FLAT_REGION_BIT_COUNT*2;
-            if(bCurrRegionIsFlat)
-                ++nFlatRegionCount;
-            const size_t nCurrWordOccIncr = (DEFAULT_LWORD_OCC_INCR+m_nModelResetCooldown)<<int(bCurrRegionIsFlat||bBootstrapping);
+                const int nCurrImgCoord_X = m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X;
+                const int nCurrImgCoord_Y = m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y;
+                alignas(16) std::array<std::array<uchar,LBSP::DESC_SIZE_BITS>,3> aanLBSPLookupVals;
+                LBSP::computeDescriptor_lookup(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,aanLBSPLookupVals);
+                std::array<ushort,3> anCurrIntraDesc;
+                for(size_t c=0; c<3; ++c)
+                    anCurrIntraDesc[c] = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anCurrColor[c],m_anLBSPThreshold_8bitLUT[anCurrColor[c]]);
+                const uchar nCurrIntraDescBITS = (uchar)lv::popcount(anCurrIntraDesc);
+                const bool bCurrRegionIsFlat = nCurrIntraDescBITS<FLAT_REGION_BIT_COUNT*2;
+                if(bCurrRegionIsFlat)
+                    ++nBandFlatRegionCount;
+                const size_t nCurrWordOccIncr = (DEFAULT_LWORD_OCC_INCR+m_nModelResetCooldown)<<int(bCurrRegionIsFlat||bBootstrapping);
 #if USE_FEEDBACK_ADJUSTMENTS
-            const size_t nCurrLocalWordUpdateRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):bCurrRegionIsFlat?(size_t)ceil(fCurrLearningRate+FEEDBACK_T_LOWER)/2:(size_t)ceil(fCurrLearningRate));
+                const size_t nCurrLocalWordUpdateRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):bCurrRegionIsFlat?(size_t)ceil(getGovernedLearningRate(getCompensatedLearningRate(fCurrLearningRate+FEEDBACK_T_LOWER)))/2:(size_t)ceil(getGovernedLearningRate(getCompensatedLearningRate(fCurrLearningRate))));
 #else //(!USE_FEEDBACK_ADJUSTMENTS)
-            const size_t nCurrLocalWordUpdateRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)DEFAULT_RESAMPLING_RATE);
+                const size_t nCurrLocalWordUpdateRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)ceil(getGovernedLearningRate(DEFAULT_RESAMPLING_RATE)));
 #endif //(!USE_FEEDBACK_ADJUSTMENTS)
-            const size_t nCurrTotColorDistThreshold = (size_t)(sqrt(fCurrDistThresholdFactor)*m_nMinColorDistThreshold)*3;
-            const size_t nCurrTotDescDistThreshold = (((size_t)1<<((size_t)floor(fCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(bCurrRegionIsUnstable*UNSTAB_DESC_DIST_OFFSET))*3;
-            size_t nLocalWordIdx = 0;
-            float fPotentialLocalWordsWeightSum = 0.0f;
-            float fLastLocalWordWeight = FLT_MAX;
+                const size_t nCurrTotColorDistThreshold = (size_t)(sqrt(fCurrDistThresholdFactor)*m_nMinColorDistThreshold)*3;
+                const size_t nCurrTotDescDistThreshold = (((size_t)1<<((size_t)floor(fCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(bCurrRegionIsUnstable*UNSTAB_DESC_DIST_OFFSET))*3;
+                size_t nLocalWordIdx = 0;
+                float fPotentialLocalWordsWeightSum = 0.0f;
+                float fLastLocalWordWeight = FLT_MAX;
 #if USE_INTERNAL_HRCS
-            std::chrono::high_resolution_clock::time_point post_prep = std::chrono::high_resolution_clock::now();
-            fPrepTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_prep-pre_prep).count())/1000000;
+                std::chrono::high_resolution_clock::time_point post_prep = std::chrono::high_resolution_clock::now();
+                fPrepTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_prep-pre_prep).count())/1000000;
 #endif //USE_INTERNAL_HRCS
-            while(nLocalWordIdx<m_nCurrLocalWords && fPotentialLocalWordsWeightSum<fLocalWordsWeightSumThreshold) {
-                LocalWord_3ch& oCurrLocalWord = (LocalWord_3ch&)*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
-                const float fCurrLocalWordWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
-                {
-                    const size_t nTotColorL1Dist = lv::L1dist(anCurrColor,oCurrLocalWord.oFeature.anColor);
-                    const size_t nColorDistortion = lv::cdist(anCurrColor,oCurrLocalWord.oFeature.anColor);
-                    const size_t nTotColorMixDist = lv::cmixdist(nTotColorL1Dist,nColorDistortion);
-                    const size_t nTotIntraDescDist = lv::hdist(anCurrIntraDesc,oCurrLocalWord.oFeature.anDesc);
-                    std::array<ushort,3> anCurrInterDesc;
-                    for(size_t c=0; c<3; ++c)
-                        anCurrInterDesc[c] = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],oCurrLocalWord.oFeature.anColor[c],m_anLBSPThreshold_8bitLUT[oCurrLocalWord.oFeature.anColor[c]]);
-                    const size_t nTotInterDescDist = lv::hdist(anCurrInterDesc,oCurrLocalWord.oFeature.anDesc);
-                    const size_t nTotDescDist = (nTotIntraDescDist+nTotInterDescDist)/2;
-                    if( (!bCurrRegionIsUnstable || bCurrRegionIsFlat || bCurrRegionIsROIBorder)
-                            && nTotColorMixDist<=nCurrTotColorDistThreshold
-                            && nTotColorL1Dist>=nCurrTotColorDistThreshold/2
-                            && nTotIntraDescDist<=nCurrTotDescDistThreshold/2
-                            && (rand()%(nCurrRegionIllumUpdtVal?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate))==0) {
-                        // == illum updt
-                        for(size_t c=0; c<3; ++c) {
-                            oCurrLocalWord.oFeature.anColor[c] = anCurrColor[c];
-                            oCurrLocalWord.oFeature.anDesc[c] = anCurrIntraDesc[c];
+                while(nLocalWordIdx<m_nCurrLocalWords && fPotentialLocalWordsWeightSum<fLocalWordsWeightSumThreshold) {
+                    ++nBandSamplesTested;
+                    const size_t nCurrLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx);
+                    ColorLBSPFeature<3>& oCurrLocalWordFeature = m_voLocalWordFeatures_3ch[nCurrLocalWordSlotIdx];
+                    LocalWordStats& oCurrLocalWordStats = m_voLocalWordStats[nCurrLocalWordSlotIdx];
+                    const float fCurrLocalWordWeight = GetLocalWordWeight(oCurrLocalWordStats,m_nFrameIdx,m_nLocalWordWeightOffset);
+                    {
+                        const size_t nTotColorL1Dist = lv::L1dist(anCurrColor,oCurrLocalWordFeature.anColor);
+                        // the exact distortion is only needed for matched words, the threshold check itself is done in the squared domain
+                        const bool bColorMatched = lv::cmixdist_within(nTotColorL1Dist,anCurrColor,oCurrLocalWordFeature.anColor,nCurrTotColorDistThreshold);
+                        const size_t nTotIntraDescDist = lv::hdist(anCurrIntraDesc,oCurrLocalWordFeature.anDesc);
+                        // the shared lookup values are only re-thresholded for color-matched words (and before any illum update of the word)
+                        size_t nTotDescDist = SIZE_MAX;
+                        if(bColorMatched) {
+                            std::array<ushort,3> anCurrInterDesc;
+                            for(size_t c=0; c<3; ++c)
+                                anCurrInterDesc[c] = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],oCurrLocalWordFeature.anColor[c],m_anLBSPThreshold_8bitLUT[oCurrLocalWordFeature.anColor[c]]);
+                            nTotDescDist = (nTotIntraDescDist+lv::hdist(anCurrInterDesc,oCurrLocalWordFeature.anDesc))/2;
                         }
-                        m_oIllumUpdtRegionMask.data[nPxIter-1] = 1&m_oROI.data[nPxIter-1];
-                        m_oIllumUpdtRegionMask.data[nPxIter+1] = 1&m_oROI.data[nPxIter+1];
-                        m_oIllumUpdtRegionMask.data[nPxIter] = 2;
+                        if( (!bCurrRegionIsUnstable || bCurrRegionIsFlat || bCurrRegionIsROIBorder)
+                                && bColorMatched
+                                && nTotColorL1Dist>=nCurrTotColorDistThreshold/2
+                                && nTotIntraDescDist<=nCurrTotDescDistThreshold/2
+                                && (oRNG()%(nCurrRegionIllumUpdtVal?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate))==0) {
+                            // == illum updt
+                            for(size_t c=0; c<3; ++c) {
+                                oCurrLocalWordFeature.anColor[c] = anCurrColor[c];
+                                oCurrLocalWordFeature.anDesc[c] = anCurrIntraDesc[c];
+                            }
+                            m_oIllumUpdtRegionMask.data[nPxIter-1] = 1&m_oROI.data[nPxIter-1];
+                            m_oIllumUpdtRegionMask.data[nPxIter+1] = 1&m_oROI.data[nPxIter+1];
+                            m_oIllumUpdtRegionMask.data[nPxIter] = 2;
 #if DISPLAY_PAWCS_DEBUG_INFO
-                        vsWordModList[nLocalDictIdx+nLocalWordIdx] += "UPDATED ";
+                            vsWordModList[nLocalDictIdx+nLocalWordIdx] += "UPDATED ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
-                    }
-                    if(nTotDescDist<=nCurrTotDescDistThreshold && nTotColorMixDist<=nCurrTotColorDistThreshold) {
-                        fPotentialLocalWordsWeightSum += fCurrLocalWordWeight;
-                        oCurrLocalWord.nLastOcc = m_nFrameIdx;
-                        if((!m_oLastFGMask.data[nPxIter] || m_bUsingMovingCamera) && fCurrLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
-                            oCurrLocalWord.nOccurrences += nCurrWordOccIncr;
-                        nMinTotColorDist = std::min(nMinTotColorDist,nTotColorMixDist);
-                        nMinTotDescDist = std::min(nMinTotDescDist,nTotDescDist);
+                        }
+                        if(nTotDescDist<=nCurrTotDescDistThreshold && bColorMatched) {
+                            fPotentialLocalWordsWeightSum += fCurrLocalWordWeight;
+                            oCurrLocalWordStats.nLastOcc = m_nFrameIdx;
+                            if((!m_oLastFGMask.data[nPxIter] || m_bUsingMovingCamera) && fCurrLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
+                                oCurrLocalWordStats.nOccurrences += nCurrWordOccIncr;
+                            nMinTotColorDist = std::min(nMinTotColorDist,lv::cmixdist(nTotColorL1Dist,lv::cdist(anCurrColor,oCurrLocalWordFeature.anColor)));
+                            nMinTotDescDist = std::min(nMinTotDescDist,nTotDescDist);
 #if DISPLAY_PAWCS_DEBUG_INFO
-                        vsWordModList[nLocalDictIdx+nLocalWordIdx] += "MATCHED ";
+                            vsWordModList[nLocalDictIdx+nLocalWordIdx] += "MATCHED ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
+                        }
                     }
-                }
-                if(fCurrLocalWordWeight>fLastLocalWordWeight) {
-                    std::swap(m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
+                    if(fCurrLocalWordWeight>fLastLocalWordWeight) {
+                        std::swap(m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
 #if DISPLAY_PAWCS_DEBUG_INFO
-                    std::swap(vsWordModList[nLocalDictIdx+nLocalWordIdx],vsWordModList[nLocalDictIdx+nLocalWordIdx-1]);
+                        std::swap(vsWordModList[nLocalDictIdx+nLocalWordIdx],vsWordModList[nLocalDictIdx+nLocalWordIdx-1]);
 #endif //DISPLAY_PAWCS_DEBUG_INFO
+                    }
+                    else
+                        fLastLocalWordWeight = fCurrLocalWordWeight;
+                    ++nLocalWordIdx;
                 }
-                else
-                    fLastLocalWordWeight = fCurrLocalWordWeight;
-                ++nLocalWordIdx;
-            }
-            while(nLocalWordIdx<m_nCurrLocalWords) {
-                const float fCurrLocalWordWeight = GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_nFrameIdx,m_nLocalWordWeightOffset);
-                if(fCurrLocalWordWeight>fLastLocalWordWeight) {
-                    std::swap(m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
+                if(nLocalWordIdx<m_nCurrLocalWords)
+                    ++nBandEarlyExits;
+                // unscanned words were not matched, so their (time-stamped) weights only decayed; their sort pass is amortized over frames,
+                // and only forced when a new word takes the last slot (the full pass is what moves the weakest word there)
+                const auto lSortLocalWordDictTail = [&]() {
+                    while(nLocalWordIdx<m_nCurrLocalWords) {
+                        const float fCurrLocalWordWeight = GetLocalWordWeight(m_voLocalWordStats[getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx)],m_nFrameIdx,m_nLocalWordWeightOffset);
+                        if(fCurrLocalWordWeight>fLastLocalWordWeight) {
+                            std::swap(m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
 #if DISPLAY_PAWCS_DEBUG_INFO
-                    std::swap(vsWordModList[nLocalDictIdx+nLocalWordIdx],vsWordModList[nLocalDictIdx+nLocalWordIdx-1]);
+                            std::swap(vsWordModList[nLocalDictIdx+nLocalWordIdx],vsWordModList[nLocalDictIdx+nLocalWordIdx-1]);
 #endif //DISPLAY_PAWCS_DEBUG_INFO
-                }
-                else
-                    fLastLocalWordWeight = fCurrLocalWordWeight;
-                ++nLocalWordIdx;
-            }
+                        }
+                        else
+                            fLastLocalWordWeight = fCurrLocalWordWeight;
+                        ++nLocalWordIdx;
+                    }
+                };
+                if(((m_nFrameIdx+nModelIter)%LWORD_TAIL_SORT_PERIOD)==0)
+                    lSortLocalWordDictTail();
 #if USE_INTERNAL_HRCS
-            std::chrono::high_resolution_clock::time_point post_ldictscan = std::chrono::high_resolution_clock::now();
-            fLDictScanTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_ldictscan-post_prep).count())/1000000;
+                std::chrono::high_resolution_clock::time_point post_ldictscan = std::chrono::high_resolution_clock::now();
+                fLDictScanTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_ldictscan-post_prep).count())/1000000;
 #endif //USE_INTERNAL_HRCS
-            if(fPotentialLocalWordsWeightSum>=fLocalWordsWeightSumThreshold || bCurrRegionIsROIBorder) {
-                // == background
+                if(fPotentialLocalWordsWeightSum>=fLocalWordsWeightSumThreshold || bCurrRegionIsROIBorder) {
+                    // == background
 #if USE_FEEDBACK_ADJUSTMENTS
-                const float fNormalizedMinDist = std::max((float)nMinTotColorDist/s_nColorMaxDataRange_3ch,(float)nMinTotDescDist/s_nDescMaxDataRange_3ch);
-                fCurrMeanMinDist_LT = fCurrMeanMinDist_LT*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
-                fCurrMeanMinDist_ST = fCurrMeanMinDist_ST*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
+                    const float fNormalizedMinDist = std::max((float)nMinTotColorDist/s_nColorMaxDataRange_3ch,(float)nMinTotDescDist/s_nDescMaxDataRange_3ch);
+                    fCurrMeanMinDist_LT = fCurrMeanMinDist_LT*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
+                    fCurrMeanMinDist_ST = fCurrMeanMinDist_ST*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
 #endif //USE_FEEDBACK_ADJUSTMENTS
-                fCurrMeanRawSegmRes_LT = fCurrMeanRawSegmRes_LT*(1.0f-fRollAvgFactor_LT);
-                fCurrMeanRawSegmRes_ST = fCurrMeanRawSegmRes_ST*(1.0f-fRollAvgFactor_ST);
-                if((rand()%nCurrLocalWordUpdateRate)==0) {
-                    size_t nGlobalWordLUTIdx;
-                    GlobalWord_3ch* pCurrGlobalWord = nullptr;
-                    for(nGlobalWordLUTIdx=0; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx) {
-                        pCurrGlobalWord = (GlobalWord_3ch*)m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx];
-                        if(lv::L1dist(nCurrIntraDescBITS,pCurrGlobalWord->nDescBITS)<=nCurrTotDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR &&
-                           lv::cmixdist(anCurrColor,pCurrGlobalWord->oFeature.anColor)<=nCurrTotColorDistThreshold)
-                            break;
-                    }
-                    if(nGlobalWordLUTIdx!=m_nCurrGlobalWords || (rand()%(nCurrLocalWordUpdateRate*2))==0) {
-                        if(nGlobalWordLUTIdx==m_nCurrGlobalWords) {
-                            pCurrGlobalWord = (GlobalWord_3ch*)m_vpGlobalWordDict[m_nCurrGlobalWords-1];
-                            for(size_t c=0; c<3; ++c) {
-                                pCurrGlobalWord->oFeature.anColor[c] = anCurrColor[c];
-                                pCurrGlobalWord->oFeature.anDesc[c] = anCurrIntraDesc[c];
+                    fCurrMeanRawSegmRes_LT = fCurrMeanRawSegmRes_LT*(1.0f-fRollAvgFactor_LT);
+                    fCurrMeanRawSegmRes_ST = fCurrMeanRawSegmRes_ST*(1.0f-fRollAvgFactor_ST);
+                    if((oRNG()%nCurrLocalWordUpdateRate)==0) {
+                        GlobalWord_3ch* pCurrGlobalWord = (GlobalWord_3ch*)findGlobalWord<3>(nGlobalWordMapLookupIdx/4,anCurrColor,nCurrIntraDescBITS,nCurrTotColorDistThreshold,nCurrTotDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR);
+                        if(pCurrGlobalWord || (oRNG()%(nCurrLocalWordUpdateRate*2))==0) {
+                            if(!pCurrGlobalWord) {
+                                // replacing the weakest global word affects all bands, so it is deferred to the end of the frame
+                                oBandDelta.bReplaceWeakestWord = true;
+                                for(size_t c=0; c<3; ++c) {
+                                    oBandDelta.oReplacementFeature.anColor[c] = anCurrColor[c];
+                                    oBandDelta.oReplacementFeature.anDesc[c] = anCurrIntraDesc[c];
+                                }
+                                oBandDelta.nReplacementDescBITS = nCurrIntraDescBITS;
+                                oBandDelta.nReplacementLookupIdx = nGlobalWordMapLookupIdx;
+                                oBandDelta.fReplacementWeight = fPotentialLocalWordsWeightSum;
+                            }
+                            else {
+                                float& fCurrGlobalWordLocalWeight = updateGlobalWordLocalWeight(*pCurrGlobalWord,nGlobalWordMapLookupIdx);
+                                if(fCurrGlobalWordLocalWeight<fPotentialLocalWordsWeightSum) {
+                                    oBandDelta.vfWeightIncrs[size_t(pCurrGlobalWord-m_voGlobalWordList_3ch.data())] += fPotentialLocalWordsWeightSum;
+                                    fCurrGlobalWordLocalWeight += fPotentialLocalWordsWeightSum;
+                                    // lookup map cells never straddle row bands, so each band only flags its own cells
+                                    m_vbDirtyGlobalWordLUTCells[nGlobalWordMapLookupIdx/4] = 1;
+                                }
                             }
-                            pCurrGlobalWord->nDescBITS = nCurrIntraDescBITS;
-                            pCurrGlobalWord->oSpatioOccMap = cv::Scalar(0.0f);
-                            pCurrGlobalWord->fLatestWeight = 0.0f;
-                        }
-                        float& fCurrGlobalWordLocalWeight = *(float*)(pCurrGlobalWord->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
-                        if(fCurrGlobalWordLocalWeight<fPotentialLocalWordsWeightSum) {
-                            pCurrGlobalWord->fLatestWeight += fPotentialLocalWordsWeightSum;
-                            fCurrGlobalWordLocalWeight += fPotentialLocalWordsWeightSum;
                         }
                     }
                 }
-            }
-            else {
-                // == foreground
+                else {
+                    // == foreground
 #if USE_FEEDBACK_ADJUSTMENTS
-                const float fNormalizedMinDist = std::max(std::max((float)nMinTotColorDist/s_nColorMaxDataRange_3ch,(float)nMinTotDescDist/s_nDescMaxDataRange_3ch),(fLocalWordsWeightSumThreshold-fPotentialLocalWordsWeightSum)/fLocalWordsWeightSumThreshold);
-                fCurrMeanMinDist_LT = fCurrMeanMinDist_LT*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
-                fCurrMeanMinDist_ST = fCurrMeanMinDist_ST*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
+                    const float fNormalizedMinDist = std::max(std::max((float)nMinTotColorDist/s_nColorMaxDataRange_3ch,(float)nMinTotDescDist/s_nDescMaxDataRange_3ch),(fLocalWordsWeightSumThreshold-fPotentialLocalWordsWeightSum)/fLocalWordsWeightSumThreshold);
+                    fCurrMeanMinDist_LT = fCurrMeanMinDist_LT*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
+                    fCurrMeanMinDist_ST = fCurrMeanMinDist_ST*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
 #endif //USE_FEEDBACK_ADJUSTMENTS
-                fCurrMeanRawSegmRes_LT = fCurrMeanRawSegmRes_LT*(1.0f-fRollAvgFactor_LT) + fRollAvgFactor_LT;
-                fCurrMeanRawSegmRes_ST = fCurrMeanRawSegmRes_ST*(1.0f-fRollAvgFactor_ST) + fRollAvgFactor_ST;
-                if(bCurrRegionIsFlat || (rand()%nCurrLocalWordUpdateRate)==0) {
-                    size_t nGlobalWordLUTIdx;
-                    GlobalWord_3ch* pCurrGlobalWord = nullptr;
-                    for(nGlobalWordLUTIdx=0; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx) {
-                        pCurrGlobalWord = (GlobalWord_3ch*)m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx];
-                        if(lv::L1dist(nCurrIntraDescBITS,pCurrGlobalWord->nDescBITS)<=nCurrTotDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR &&
-                           lv::cmixdist(anCurrColor,pCurrGlobalWord->oFeature.anColor)<=nCurrTotColorDistThreshold)
-                            break;
-                    }
-                    if(nGlobalWordLUTIdx==m_nCurrGlobalWords)
-                        nCurrRegionSegmVal = UCHAR_MAX;
-                    else {
-                        const float fGlobalWordLocalizedWeight = *(float*)(pCurrGlobalWord->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
-                        if(fPotentialLocalWordsWeightSum+fGlobalWordLocalizedWeight/(bCurrRegionIsFlat?2:4)<fLocalWordsWeightSumThreshold)
+                    fCurrMeanRawSegmRes_LT = fCurrMeanRawSegmRes_LT*(1.0f-fRollAvgFactor_LT) + fRollAvgFactor_LT;
+                    fCurrMeanRawSegmRes_ST = fCurrMeanRawSegmRes_ST*(1.0f-fRollAvgFactor_ST) + fRollAvgFactor_ST;
+                    if(bCurrRegionIsFlat || (oRNG()%nCurrLocalWordUpdateRate)==0) {
+                        GlobalWord_3ch* pCurrGlobalWord = (GlobalWord_3ch*)findGlobalWord<3>(nGlobalWordMapLookupIdx/4,anCurrColor,nCurrIntraDescBITS,nCurrTotColorDistThreshold,nCurrTotDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR);
+                        if(!pCurrGlobalWord)
                             nCurrRegionSegmVal = UCHAR_MAX;
-                    }
+                        else {
+                            const float fGlobalWordLocalizedWeight = getGlobalWordLocalWeight(*pCurrGlobalWord,nGlobalWordMapLookupIdx);
+                            if(fPotentialLocalWordsWeightSum+fGlobalWordLocalizedWeight/(bCurrRegionIsFlat?2:4)<fLocalWordsWeightSumThreshold)
+                                nCurrRegionSegmVal = UCHAR_MAX;
+                        }
 #if DISPLAY_PAWCS_DEBUG_INFO
-                    if(!nCurrRegionSegmVal && m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y==oDbgPt.y && m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X==oDbgPt.x) {
-                        bDBGMaskModifiedByGDict = true;
-                        pDBGGlobalWordModifier = pCurrGlobalWord;
-                        fDBGGlobalWordModifierLocalWeight = *(float*)(pCurrGlobalWord->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
-                    }
+                        if(!nCurrRegionSegmVal && m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y==oDbgPt.y && m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X==oDbgPt.x) {
+                            bDBGMaskModifiedByGDict = true;
+                            pDBGGlobalWordModifier = pCurrGlobalWord;
+                            fDBGGlobalWordModifierLocalWeight = getGlobalWordLocalWeight(*pCurrGlobalWord,nGlobalWordMapLookupIdx);
+                        }
 #endif //DISPLAY_PAWCS_DEBUG_INFO
-                }
-                else
-                    nCurrRegionSegmVal = UCHAR_MAX;
-                if(fPotentialLocalWordsWeightSum<DEFAULT_LWORD_INIT_WEIGHT) {
-                    const size_t nNewLocalWordIdx = m_nCurrLocalWords-1;
-                    LocalWord_3ch* pNewLocalWord = (LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx+nNewLocalWordIdx];
-                    for(size_t c=0; c<3; ++c) {
-                        pNewLocalWord->oFeature.anColor[c] = anCurrColor[c];
-                        pNewLocalWord->oFeature.anDesc[c] = anCurrIntraDesc[c];
                     }
-                    pNewLocalWord->nOccurrences = nCurrWordOccIncr;
-                    pNewLocalWord->nFirstOcc = m_nFrameIdx;
-                    pNewLocalWord->nLastOcc = m_nFrameIdx;
+                    else
+                        nCurrRegionSegmVal = UCHAR_MAX;
+                    if(fPotentialLocalWordsWeightSum<DEFAULT_LWORD_INIT_WEIGHT) {
+                        lSortLocalWordDictTail();
+                        const size_t nNewLocalWordIdx = m_nCurrLocalWords-1;
+                        const size_t nNewLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,nNewLocalWordIdx);
+                        ColorLBSPFeature<3>& oNewLocalWordFeature = m_voLocalWordFeatures_3ch[nNewLocalWordSlotIdx];
+                        LocalWordStats& oNewLocalWordStats = m_voLocalWordStats[nNewLocalWordSlotIdx];
+                        for(size_t c=0; c<3; ++c) {
+                            oNewLocalWordFeature.anColor[c] = anCurrColor[c];
+                            oNewLocalWordFeature.anDesc[c] = anCurrIntraDesc[c];
+                        }
+                        oNewLocalWordStats.nOccurrences = nCurrWordOccIncr;
+                        oNewLocalWordStats.nFirstOcc = m_nFrameIdx;
+                        oNewLocalWordStats.nLastOcc = m_nFrameIdx;
 #if DISPLAY_PAWCS_DEBUG_INFO
-                    vsWordModList[nLocalDictIdx+nNewLocalWordIdx] += "NEW ";
+                        vsWordModList[nLocalDictIdx+nNewLocalWordIdx] += "NEW ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
-                }
-            }
-#if USE_INTERNAL_HRCS
-            std::chrono::high_resolution_clock::time_point post_rawdecision = std::chrono::high_resolution_clock::now();
-            if(nCurrRegionSegmVal)
-                fFGRawTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_rawdecision-post_ldictscan).count())/1000000;
-            else
-                fBGRawTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_rawdecision-post_ldictscan).count())/1000000;
-#endif //USE_INTERNAL_HRCS
-            // == neighb updt
-            if((!nCurrRegionSegmVal && (rand()%nCurrLocalWordUpdateRate)==0) || bCurrRegionIsROIBorder || m_bUsingMovingCamera) {
-            //if((!nCurrRegionSegmVal && (rand()%(nCurrRegionIllumUpdtVal?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate))==0) || bCurrRegionIsROIBorder) {
-                int nSampleImgCoord_Y, nSampleImgCoord_X;
-                if(bCurrRegionIsFlat || bCurrRegionIsROIBorder || m_bUsingMovingCamera)
-                    cv::getRandNeighborPosition_5x5(nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                else
-                    cv::getRandNeighborPosition_3x3(nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
-                if(m_oROI.data[nSamplePxIdx]) {
-                    const size_t nNeighborLocalDictIdx = m_voPxInfoLUT_PAWCS[nSamplePxIdx].nModelIdx*m_nCurrLocalWords;
-                    size_t nNeighborLocalWordIdx = 0;
-                    float fNeighborPotentialLocalWordsWeightSum = 0.0f;
-                    while(nNeighborLocalWordIdx<m_nCurrLocalWords && fNeighborPotentialLocalWordsWeightSum<fLocalWordsWeightSumThreshold) {
-                        LocalWord_3ch& oNeighborLocalWord = (LocalWord_3ch&)*m_vpLocalWordDict[nNeighborLocalDictIdx+nNeighborLocalWordIdx];
-                        const size_t nNeighborTotColorL1Dist = lv::L1dist(anCurrColor,oNeighborLocalWord.oFeature.anColor);
-                        const size_t nNeighborColorDistortion = lv::cdist(anCurrColor,oNeighborLocalWord.oFeature.anColor);
-                        const size_t nNeighborTotColorMixDist = lv::cmixdist(nNeighborTotColorL1Dist,nNeighborColorDistortion);
-                        const size_t nNeighborTotIntraDescDist = lv::hdist(anCurrIntraDesc,oNeighborLocalWord.oFeature.anDesc);
-                        const bool bNeighborRegionIsFlat = lv::popcount(oNeighborLocalWord.oFeature.anDesc)<FLAT_REGION_BIT_COUNT*2;
-                        const size_t nNeighborWordOccIncr = bNeighborRegionIsFlat?nCurrWordOccIncr*2:nCurrWordOccIncr;
-                        if(nNeighborTotColorMixDist<=nCurrTotColorDistThreshold && nNeighborTotIntraDescDist<=nCurrTotDescDistThreshold) {
-                            const float fNeighborLocalWordWeight = GetLocalWordWeight(oNeighborLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
-                            fNeighborPotentialLocalWordsWeightSum += fNeighborLocalWordWeight;
-                            oNeighborLocalWord.nLastOcc = m_nFrameIdx;
-                            if(fNeighborLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
-                                oNeighborLocalWord.nOccurrences += nNeighborWordOccIncr;
+                        // the new word is ranked right away, as it would otherwise only move up by one position per (amortized) sort pass
+                        const float fNewLocalWordWeight = GetLocalWordWeight(oNewLocalWordStats,m_nFrameIdx,m_nLocalWordWeightOffset);
+                        size_t nNewLocalWordRank = nNewLocalWordIdx;
+                        while(nNewLocalWordRank>0 && fNewLocalWordWeight>GetLocalWordWeight(m_voLocalWordStats[getLocalWordSlotIdx(nLocalDictIdx,nNewLocalWordRank-1)],m_nFrameIdx,m_nLocalWordWeightOffset)) {
+                            std::swap(m_vnLocalWordDict[nLocalDictIdx+nNewLocalWordRank],m_vnLocalWordDict[nLocalDictIdx+nNewLocalWordRank-1]);
 #if DISPLAY_PAWCS_DEBUG_INFO
-                            vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "MATCHED(NEIGHBOR) ";
+                            std::swap(vsWordModList[nLocalDictIdx+nNewLocalWordRank],vsWordModList[nLocalDictIdx+nNewLocalWordRank-1]);
 #endif //DISPLAY_PAWCS_DEBUG_INFO
+                            --nNewLocalWordRank;
                         }
-                        else if(!oCurrFGMask.data[nSamplePxIdx] && bCurrRegionIsFlat && (bBootstrapping || (rand()%nCurrLocalWordUpdateRate)==0)) {
-                            const size_t nSamplePxRGBIdx = nSamplePxIdx*3;
-                            const size_t nSampleDescRGBIdx = nSamplePxRGBIdx*2;
-                            ushort* anNeighborLastIntraDesc = ((ushort*)(m_oLastDescFrame.data+nSampleDescRGBIdx));
-                            const size_t nNeighborTotLastIntraDescDist = lv::hdist(anCurrIntraDesc,anNeighborLastIntraDesc);
-                            if(nNeighborTotColorMixDist<=nCurrTotColorDistThreshold && nNeighborTotLastIntraDescDist<=nCurrTotDescDistThreshold/2) {
-                                const float fNeighborLocalWordWeight = GetLocalWordWeight(oNeighborLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
+                    }
+                }
+#if USE_INTERNAL_HRCS
+                std::chrono::high_resolution_clock::time_point post_rawdecision = std::chrono::high_resolution_clock::now();
+                if(nCurrRegionSegmVal)
+                    fFGRawTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_rawdecision-post_ldictscan).count())/1000000;
+                else
+                    fBGRawTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_rawdecision-post_ldictscan).count())/1000000;
+#endif //USE_INTERNAL_HRCS
+                // == neighb updt
+                if((!nCurrRegionSegmVal && (oRNG()%nCurrLocalWordUpdateRate)==0) || bCurrRegionIsROIBorder || m_bUsingMovingCamera) {
+                //if((!nCurrRegionSegmVal && (oRNG()%(nCurrRegionIllumUpdtVal?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate))==0) || bCurrRegionIsROIBorder) {
+                    const size_t nSamplePxIdx = (bCurrRegionIsFlat || bCurrRegionIsROIBorder || m_bUsingMovingCamera)?m_oRandNeighborLUT_5x5.getRandIdx(nPxIter,oRNG):m_oRandNeighborLUT_3x3.getRandIdx(nPxIter,oRNG);
+                    if(m_oROI.data[nSamplePxIdx]) {
+                        const size_t nNeighborLocalDictIdx = m_voPxInfoLUT_PAWCS[nSamplePxIdx].nModelIdx*m_nCurrLocalWords;
+                        size_t nNeighborLocalWordIdx = 0;
+                        float fNeighborPotentialLocalWordsWeightSum = 0.0f;
+                        while(nNeighborLocalWordIdx<m_nCurrLocalWords && fNeighborPotentialLocalWordsWeightSum<fLocalWordsWeightSumThreshold) {
+                            const size_t nNeighborLocalWordSlotIdx = getLocalWordSlotIdx(nNeighborLocalDictIdx,nNeighborLocalWordIdx);
+                            ColorLBSPFeature<3>& oNeighborLocalWordFeature = m_voLocalWordFeatures_3ch[nNeighborLocalWordSlotIdx];
+                            LocalWordStats& oNeighborLocalWordStats = m_voLocalWordStats[nNeighborLocalWordSlotIdx];
+                            const size_t nNeighborTotColorL1Dist = lv::L1dist(anCurrColor,oNeighborLocalWordFeature.anColor);
+                            const bool bNeighborColorMatched = lv::cmixdist_within(nNeighborTotColorL1Dist,anCurrColor,oNeighborLocalWordFeature.anColor,nCurrTotColorDistThreshold);
+                            const size_t nNeighborTotIntraDescDist = lv::hdist(anCurrIntraDesc,oNeighborLocalWordFeature.anDesc);
+                            const bool bNeighborRegionIsFlat = lv::popcount(oNeighborLocalWordFeature.anDesc)<FLAT_REGION_BIT_COUNT*2;
+                            const size_t nNeighborWordOccIncr = bNeighborRegionIsFlat?nCurrWordOccIncr*2:nCurrWordOccIncr;
+                            if(bNeighborColorMatched && nNeighborTotIntraDescDist<=nCurrTotDescDistThreshold) {
+                                const float fNeighborLocalWordWeight = GetLocalWordWeight(oNeighborLocalWordStats,m_nFrameIdx,m_nLocalWordWeightOffset);
                                 fNeighborPotentialLocalWordsWeightSum += fNeighborLocalWordWeight;
-                                oNeighborLocalWord.nLastOcc = m_nFrameIdx;
+                                oNeighborLocalWordStats.nLastOcc = m_nFrameIdx;
                                 if(fNeighborLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
-                                    oNeighborLocalWord.nOccurrences += nNeighborWordOccIncr;
-                                for(size_t c=0; c<3; ++c)
-                                    oNeighborLocalWord.oFeature.anDesc[c] = anCurrIntraDesc[c];
+                                    oNeighborLocalWordStats.nOccurrences += nNeighborWordOccIncr;
 #if DISPLAY_PAWCS_DEBUG_INFO
-                                vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "UPDATED1(NEIGHBOR) ";
+                                vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "MATCHED(NEIGHBOR) ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
                             }
-                            else {
-                                const bool bNeighborLastRegionIsFlat = lv::popcount<3>(anNeighborLastIntraDesc)<FLAT_REGION_BIT_COUNT*2;
-                                if(bNeighborLastRegionIsFlat && bCurrRegionIsFlat &&
-                                    nNeighborTotLastIntraDescDist+nNeighborTotIntraDescDist<=nCurrTotDescDistThreshold &&
-                                    nNeighborColorDistortion<=nCurrTotColorDistThreshold/4) {
-                                        const float fNeighborLocalWordWeight = GetLocalWordWeight(oNeighborLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
-                                        fNeighborPotentialLocalWordsWeightSum += fNeighborLocalWordWeight;
-                                        oNeighborLocalWord.nLastOcc = m_nFrameIdx;
-                                        if(fNeighborLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
-                                            oNeighborLocalWord.nOccurrences += nNeighborWordOccIncr;
-                                        for(size_t c=0; c<3; ++c)
-                                            oNeighborLocalWord.oFeature.anColor[c] = anCurrColor[c];
+                            else if(!oCurrFGMask.data[nSamplePxIdx] && bCurrRegionIsFlat && (bBootstrapping || (oRNG()%nCurrLocalWordUpdateRate)==0)) {
+                                const size_t nSamplePxRGBIdx = nSamplePxIdx*3;
+                                const size_t nSampleDescRGBIdx = nSamplePxRGBIdx*2;
+                                ushort* anNeighborLastIntraDesc = ((ushort*)(m_oLastDescFrame.data+nSampleDescRGBIdx));
+                                const size_t nNeighborTotLastIntraDescDist = lv::hdist(anCurrIntraDesc,anNeighborLastIntraDesc);
+                                if(bNeighborColorMatched && nNeighborTotLastIntraDescDist<=nCurrTotDescDistThreshold/2) {
+                                    const float fNeighborLocalWordWeight = GetLocalWordWeight(oNeighborLocalWordStats,m_nFrameIdx,m_nLocalWordWeightOffset);
+                                    fNeighborPotentialLocalWordsWeightSum += fNeighborLocalWordWeight;
+                                    oNeighborLocalWordStats.nLastOcc = m_nFrameIdx;
+                                    if(fNeighborLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
+                                        oNeighborLocalWordStats.nOccurrences += nNeighborWordOccIncr;
+                                    for(size_t c=0; c<3; ++c)
+                                        oNeighborLocalWordFeature.anDesc[c] = anCurrIntraDesc[c];
 #if DISPLAY_PAWCS_DEBUG_INFO
-                                        vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "UPDATED2(NEIGHBOR) ";
+                                    vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "UPDATED1(NEIGHBOR) ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
                                 }
+                                else {
+                                    const bool bNeighborLastRegionIsFlat = lv::popcount<3>(anNeighborLastIntraDesc)<FLAT_REGION_BIT_COUNT*2;
+                                    if(bNeighborLastRegionIsFlat && bCurrRegionIsFlat &&
+                                        nNeighborTotLastIntraDescDist+nNeighborTotIntraDescDist<=nCurrTotDescDistThreshold &&
+                                        lv::cdist_within(anCurrColor,oNeighborLocalWordFeature.anColor,nCurrTotColorDistThreshold/4)) {
+                                            const float fNeighborLocalWordWeight = GetLocalWordWeight(oNeighborLocalWordStats,m_nFrameIdx,m_nLocalWordWeightOffset);
+                                            fNeighborPotentialLocalWordsWeightSum += fNeighborLocalWordWeight;
+                                            oNeighborLocalWordStats.nLastOcc = m_nFrameIdx;
+                                            if(fNeighborLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
+                                                oNeighborLocalWordStats.nOccurrences += nNeighborWordOccIncr;
+                                            for(size_t c=0; c<3; ++c)
+                                                oNeighborLocalWordFeature.anColor[c] = anCurrColor[c];
+#if DISPLAY_PAWCS_DEBUG_INFO
+                                            vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "UPDATED2(NEIGHBOR) ";
+#endif //DISPLAY_PAWCS_DEBUG_INFO
+                                    }
+                                }
                             }
+                            ++nNeighborLocalWordIdx;
                         }
-                        ++nNeighborLocalWordIdx;
-                    }
-                    if(fNeighborPotentialLocalWordsWeightSum<DEFAULT_LWORD_INIT_WEIGHT) {
-                        nNeighborLocalWordIdx = m_nCurrLocalWords-1;
-                        LocalWord_3ch& oNeighborLocalWord = (LocalWord_3ch&)*m_vpLocalWordDict[nNeighborLocalDictIdx+nNeighborLocalWordIdx];
-                        for(size_t c=0; c<3; ++c) {
-                            oNeighborLocalWord.oFeature.anColor[c] = anCurrColor[c];
-                            oNeighborLocalWord.oFeature.anDesc[c] = anCurrIntraDesc[c];
-                        }
-                        oNeighborLocalWord.nOccurrences = nCurrWordOccIncr;
-                        oNeighborLocalWord.nFirstOcc = m_nFrameIdx;
-                        oNeighborLocalWord.nLastOcc = m_nFrameIdx;
+                        if(fNeighborPotentialLocalWordsWeightSum<DEFAULT_LWORD_INIT_WEIGHT) {
+                            nNeighborLocalWordIdx = m_nCurrLocalWords-1;
+                            const size_t nNeighborLocalWordSlotIdx = getLocalWordSlotIdx(nNeighborLocalDictIdx,nNeighborLocalWordIdx);
+                            ColorLBSPFeature<3>& oNeighborLocalWordFeature = m_voLocalWordFeatures_3ch[nNeighborLocalWordSlotIdx];
+                            LocalWordStats& oNeighborLocalWordStats = m_voLocalWordStats[nNeighborLocalWordSlotIdx];
+                            for(size_t c=0; c<3; ++c) {
+                                oNeighborLocalWordFeature.anColor[c] = anCurrColor[c];
+                                oNeighborLocalWordFeature.anDesc[c] = anCurrIntraDesc[c];
+                            }
+                            oNeighborLocalWordStats.nOccurrences = nCurrWordOccIncr;
+                            oNeighborLocalWordStats.nFirstOcc = m_nFrameIdx;
+                            oNeighborLocalWordStats.nLastOcc = m_nFrameIdx;
 #if DISPLAY_PAWCS_DEBUG_INFO
-                        vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "NEW(NEIGHBOR) ";
+                            vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "NEW(NEIGHBOR) ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
+                        }
                     }
                 }
-            }
 #if USE_INTERNAL_HRCS
-            std::chrono::high_resolution_clock::time_point post_neighbupdt = std::chrono::high_resolution_clock::now();
-            fNeighbUpdtTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_neighbupdt-post_rawdecision).count())/1000000;
+                std::chrono::high_resolution_clock::time_point post_neighbupdt = std::chrono::high_resolution_clock::now();
+                fNeighbUpdtTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_neighbupdt-post_rawdecision).count())/1000000;
 #endif //USE_INTERNAL_HRCS
-            if(nCurrRegionIllumUpdtVal)
-                nCurrRegionIllumUpdtVal -= 1;
-            // == feedback adj
-            bCurrRegionIsUnstable = fCurrDistThresholdFactor>UNSTABLE_REG_RDIST_MIN || (fCurrMeanRawSegmRes_LT-fCurrMeanFinalSegmRes_LT)>UNSTABLE_REG_RATIO_MIN || (fCurrMeanRawSegmRes_ST-fCurrMeanFinalSegmRes_ST)>UNSTABLE_REG_RATIO_MIN;
+                if(nCurrRegionIllumUpdtVal)
+                    nCurrRegionIllumUpdtVal -= 1;
+                // == feedback adj
+                bCurrRegionIsUnstable = fCurrDistThresholdFactor>UNSTABLE_REG_RDIST_MIN || (fCurrMeanRawSegmRes_LT-fCurrMeanFinalSegmRes_LT)>UNSTABLE_REG_RATIO_MIN || (fCurrMeanRawSegmRes_ST-fCurrMeanFinalSegmRes_ST)>UNSTABLE_REG_RATIO_MIN;
 #if USE_FEEDBACK_ADJUSTMENTS
-            if(m_oLastFGMask.data[nPxIter] || (std::min(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)<UNSTABLE_REG_RATIO_MIN && nCurrRegionSegmVal))
-                fCurrLearningRate = std::min(fCurrLearningRate+FEEDBACK_T_INCR/(std::max(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)*fCurrDistThresholdVariationFactor),FEEDBACK_T_UPPER);
-            else
-                fCurrLearningRate = std::max(fCurrLearningRate-FEEDBACK_T_DECR*fCurrDistThresholdVariationFactor/std::max(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST),FEEDBACK_T_LOWER);
-            if(std::max(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)>UNSTABLE_REG_RATIO_MIN && m_oBlinksFrame.data[nPxIter])
-                (fCurrDistThresholdVariationFactor) += bBootstrapping?FEEDBACK_V_INCR*2:FEEDBACK_V_INCR;
-            else
-                fCurrDistThresholdVariationFactor = std::max(fCurrDistThresholdVariationFactor-FEEDBACK_V_DECR*((bBootstrapping||bCurrRegionIsFlat)?2:m_oLastFGMask.data[nPxIter]?0.5f:1),FEEDBACK_V_DECR);
-            if(fCurrDistThresholdFactor<std::pow(1.0f+std::min(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)*2,2))
-                fCurrDistThresholdFactor += FEEDBACK_R_VAR*(fCurrDistThresholdVariationFactor-FEEDBACK_V_DECR);
-            else
-                fCurrDistThresholdFactor = std::max(fCurrDistThresholdFactor-FEEDBACK_R_VAR/fCurrDistThresholdVariationFactor,1.0f);
+                if(m_oLastFGMask.data[nPxIter] || (std::min(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)<UNSTABLE_REG_RATIO_MIN && nCurrRegionSegmVal))
+                    fCurrLearningRate = std::min(fCurrLearningRate+FEEDBACK_T_INCR/(std::max(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)*fCurrDistThresholdVariationFactor),FEEDBACK_T_UPPER);
+                else
+                    fCurrLearningRate = std::max(fCurrLearningRate-FEEDBACK_T_DECR*fCurrDistThresholdVariationFactor/std::max(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST),FEEDBACK_T_LOWER);
+                if(std::max(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)>UNSTABLE_REG_RATIO_MIN && m_oBlinksFrame.data[nPxIter])
+                    (fCurrDistThresholdVariationFactor) += bBootstrapping?FEEDBACK_V_INCR*2:FEEDBACK_V_INCR;
+                else
+                    fCurrDistThresholdVariationFactor = std::max(fCurrDistThresholdVariationFactor-FEEDBACK_V_DECR*((bBootstrapping||bCurrRegionIsFlat)?2:m_oLastFGMask.data[nPxIter]?0.5f:1),FEEDBACK_V_DECR);
+                if(fCurrDistThresholdFactor<std::pow(1.0f+std::min(fCurrMeanMinDist_LT,fCurrMeanMinDist_ST)*2,2))
+                    fCurrDistThresholdFactor += FEEDBACK_R_VAR*(fCurrDistThresholdVariationFactor-FEEDBACK_V_DECR);
+                else
+                    fCurrDistThresholdFactor = std::max(fCurrDistThresholdFactor-FEEDBACK_R_VAR/fCurrDistThresholdVariationFactor,1.0f);
 #endif //USE_FEEDBACK_ADJUSTMENTS
-            for(size_t c=0; c<3; ++c) {
-                anLastIntraDesc[c] = anCurrIntraDesc[c];
-                anLastColor[c] = anCurrColor[c];
-            }
+                for(size_t c=0; c<3; ++c) {
+                    anLastIntraDesc[c] = anCurrIntraDesc[c];
+                    anLastColor[c] = anCurrColor[c];
+                }
 #if USE_INTERNAL_HRCS
-            std::chrono::high_resolution_clock::time_point post_varupdt = std::chrono::high_resolution_clock::now();
-            fVarUpdtTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_varupdt-post_neighbupdt).count())/1000000;
-            post_lastKP = std::chrono::high_resolution_clock::now();
-            fIntraKPsTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_lastKP-pre_currKP).count())/1000000;
+                std::chrono::high_resolution_clock::time_point post_varupdt = std::chrono::high_resolution_clock::now();
+                fVarUpdtTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_varupdt-post_neighbupdt).count())/1000000;
+                post_lastKP = std::chrono::high_resolution_clock::now();
+                fIntraKPsTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_lastKP-pre_currKP).count())/1000000;
 #endif //USE_INTERNAL_HRCS
 #if DISPLAY_PAWCS_DEBUG_INFO
-            if(m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y==oDbgPt.y && m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X==oDbgPt.x) {
-                for(size_t c=0; c<3; ++c) {
-                    anDBGColor[c] = anCurrColor[c];
-                    anDBGIntraDesc[c] = anCurrIntraDesc[c];
+                if(m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y==oDbgPt.y && m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X==oDbgPt.x) {
+                    for(size_t c=0; c<3; ++c) {
+                        anDBGColor[c] = anCurrColor[c];
+                        anDBGIntraDesc[c] = anCurrIntraDesc[c];
+                    }
+                    fDBGLocalWordsWeightSumThreshold = fLocalWordsWeightSumThreshold;
+                    bDBGMaskResult = (nCurrRegionSegmVal==UCHAR_MAX);
+                    nLocalDictDBGIdx = nLocalDictIdx;
+                    nDBGWordOccIncr = std::max(nDBGWordOccIncr,nCurrWordOccIncr);
                 }
-                fDBGLocalWordsWeightSumThreshold = fLocalWordsWeightSumThreshold;
-                bDBGMaskResult = (nCurrRegionSegmVal==UCHAR_MAX);
-                nLocalDictDBGIdx = nLocalDictIdx;
-                nDBGWordOccIncr = std::max(nDBGWordOccIncr,nCurrWordOccIncr);
-            }
 #endif //DISPLAY_PAWCS_DEBUG_INFO
-        }
+            }
+            nSamplesTested += nBandSamplesTested;
+            nEarlyExits += nBandEarlyExits;
+            return nBandFlatRegionCount;
+        };
+        nFlatRegionCount = processBands(lApplyBand);
 #if USE_INTERNAL_HRCS
         std::chrono::high_resolution_clock::time_point post_loop = std::chrono::high_resolution_clock::now();
         fInterKPsTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_loop-post_lastKP).count())/1000000;
@@ -1298,41 +1450,43 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
         pre_gword_calcs = std::chrono::high_resolution_clock::now();
 #endif //USE_INTERNAL_HRCS
     }
+    BGS_INSTR_ADD_COUNT(Counter_Pixels,m_nTotRelevantPxCount);
+    BGS_INSTR_ADD_COUNT(Counter_SamplesTested,nSamplesTested.load());
+    BGS_INSTR_ADD_COUNT(Counter_EarlyExits,nEarlyExits.load());
     const bool bRecalcGlobalWords = !(m_nFrameIdx%(nCurrGlobalWordUpdateRate<<5));
     const bool bUpdateGlobalWords = !(m_nFrameIdx%(nCurrGlobalWordUpdateRate));
-    cv::Mat oLastFGMask_dilated_inverted_downscaled;
-    if(bUpdateGlobalWords)
+    if(bUpdateGlobalWords) {
+        // global word maps decay lazily: background cells only count their decay rounds, and local weights catch up with them on access
+        cv::Mat oLastFGMask_dilated_inverted_downscaled;
         cv::resize(m_oLastFGMask_dilated_inverted,oLastFGMask_dilated_inverted_downscaled,m_oDownSampledFrameSize_GlobalWordLookup,0,0,cv::INTER_NEAREST);
+        cv::add(m_oGlobalWordDecayCounts,cv::Scalar(1),m_oGlobalWordDecayCounts,oLastFGMask_dilated_inverted_downscaled);
+        ++m_nPendingGlobalWordBlurs;
+    }
+    // the spatial spread of global words is only refreshed on recalc, with one blur covering all 3x3 box blurs it replaces (i.e. with the same variance)
+    const double dGlobalWordBlurSigma = std::sqrt(m_nPendingGlobalWordBlurs*2.0/3);
     for(size_t nGlobalWordIdx=0; nGlobalWordIdx<m_nCurrGlobalWords; ++nGlobalWordIdx) {
         if(bRecalcGlobalWords && m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight>0.0f) {
+            updateGlobalWordSpatioOccMap(*m_vpGlobalWordDict[nGlobalWordIdx]);
+            cv::GaussianBlur(m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap,m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap,cv::Size(0,0),dGlobalWordBlurSigma,dGlobalWordBlurSigma,cv::BORDER_REPLICATE);
             m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight = GetGlobalWordWeight(*m_vpGlobalWordDict[nGlobalWordIdx]);
             if(m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight<1.0f) {
                 m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight = 0.0f;
                 m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap = cv::Scalar(0.0f);
             }
         }
-        if(bUpdateGlobalWords && m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight>0.0f) {
-            cv::accumulateProduct(m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap,m_oTempGlobalWordWeightDiffFactor,m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap,oLastFGMask_dilated_inverted_downscaled);
-            m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight *= 0.9f;
-            cv::blur(m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap,m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap,cv::Size(3,3),cv::Point(-1,-1),cv::BORDER_REPLICATE);
-        }
+        // all latest weights decay by the same factor, so this does not affect their order
+        if(bUpdateGlobalWords)
+            m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight *= GWORD_DECAY_FACTOR;
         if(nGlobalWordIdx>0 && m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight>m_vpGlobalWordDict[nGlobalWordIdx-1]->fLatestWeight)
             std::swap(m_vpGlobalWordDict[nGlobalWordIdx],m_vpGlobalWordDict[nGlobalWordIdx-1]);
     }
-    if(bUpdateGlobalWords) {
-        for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
-            const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
-            const size_t nGlobalWordMapLookupIdx = m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx;
-            float fLastGlobalWordLocalWeight = *(float*)(m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[0]->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
-            for(size_t nGlobalWordLUTIdx=1; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx) {
-                const float fCurrGlobalWordLocalWeight = *(float*)(m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx]->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
-                if(fCurrGlobalWordLocalWeight>fLastGlobalWordLocalWeight)
-                    std::swap(m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx],m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx-1]);
-                else
-                    fLastGlobalWordLocalWeight = fCurrGlobalWordLocalWeight;
-            }
-        }
+    if(bRecalcGlobalWords) {
+        // blurring changes the local weight order of all cells
+        m_nPendingGlobalWordBlurs = 0;
+        std::fill(m_vbDirtyGlobalWordLUTCells.begin(),m_vbDirtyGlobalWordLUTCells.end(),uchar(1));
     }
+    if(bUpdateGlobalWords)
+        sortGlobalWordLUTs();
 #if USE_INTERNAL_HRCS
     std::chrono::high_resolution_clock::time_point post_gword_calcs = std::chrono::high_resolution_clock::now();
     std::cout << "t=" << m_nFrameIdx << " : ";
@@ -1351,8 +1505,10 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
         std::cout << std::endl;
         cv::Point dbgpt(oDbgPt.x,oDbgPt.y);
         cv::Mat oGlobalWordsCoverageMap(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1,cv::Scalar(0.0f));
-        for(size_t nDBGWordIdx=0; nDBGWordIdx<m_nCurrGlobalWords; ++nDBGWordIdx)
+        for(size_t nDBGWordIdx=0; nDBGWordIdx<m_nCurrGlobalWords; ++nDBGWordIdx) {
+            updateGlobalWordSpatioOccMap(*m_vpGlobalWordDict[nDBGWordIdx]);
             cv::max(oGlobalWordsCoverageMap,m_vpGlobalWordDict[nDBGWordIdx]->oSpatioOccMap,oGlobalWordsCoverageMap);
+        }
         cv::resize(oGlobalWordsCoverageMap,oGlobalWordsCoverageMap,DEFAULT_FRAME_SIZE,0,0,cv::INTER_NEAREST);
         cv::imshow("oGlobalWordsCoverageMap",oGlobalWordsCoverageMap);
         printf("\nDBG[%2d,%2d] : \n",oDbgPt.x,oDbgPt.y);
@@ -1373,13 +1529,15 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
         printf("----\n");
         printf("DBG_LDICT : (%lu occincr per match)\n",nDBGWordOccIncr);
         for(size_t nDBGWordIdx=0; nDBGWordIdx<m_nCurrLocalWords; ++nDBGWordIdx) {
+            const size_t nDBGLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictDBGIdx,nDBGWordIdx);
+            const float fDBGLocalWordWeight = GetLocalWordWeight(m_voLocalWordStats[nDBGLocalWordSlotIdx],m_nFrameIdx,m_nLocalWordWeightOffset);
             if(m_nImgChannels==1) {
-                LocalWord_1ch* pDBGLocalWord = (LocalWord_1ch*)m_vpLocalWordDict[nLocalDictDBGIdx+nDBGWordIdx];
-                printf("\t [%02lu] : weight=[%02.03f], nColor=[%03d], nDescBITS=[%02lu]  %s\n",nDBGWordIdx,GetLocalWordWeight(*pDBGLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset),(int)pDBGLocalWord->oFeature.anColor[0],lv::popcount(pDBGLocalWord->oFeature.anDesc[0]),vsWordModList[nLocalDictDBGIdx+nDBGWordIdx].c_str());
+                const ColorLBSPFeature<1>& oDBGLocalWordFeature = m_voLocalWordFeatures_1ch[nDBGLocalWordSlotIdx];
+                printf("\t [%02lu] : weight=[%02.03f], nColor=[%03d], nDescBITS=[%02lu]  %s\n",nDBGWordIdx,fDBGLocalWordWeight,(int)oDBGLocalWordFeature.anColor[0],lv::popcount(oDBGLocalWordFeature.anDesc[0]),vsWordModList[nLocalDictDBGIdx+nDBGWordIdx].c_str());
             }
             else { //m_nImgChannels==3
-                LocalWord_3ch* pDBGLocalWord = (LocalWord_3ch*)m_vpLocalWordDict[nLocalDictDBGIdx+nDBGWordIdx];
-                printf("\t [%02lu] : weight=[%02.03f], anColor=[%03d,%03d,%03d], anDescBITS=[%02lu,%02lu,%02lu]  %s\n",nDBGWordIdx,GetLocalWordWeight(*pDBGLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset),(int)pDBGLocalWord->oFeature.anColor[0],(int)pDBGLocalWord->oFeature.anColor[1],(int)pDBGLocalWord->oFeature.anColor[2],lv::popcount(pDBGLocalWord->oFeature.anDesc[0]),lv::popcount(pDBGLocalWord->oFeature.anDesc[1]),lv::popcount(pDBGLocalWord->oFeature.anDesc[2]),vsWordModList[nLocalDictDBGIdx+nDBGWordIdx].c_str());
+                const ColorLBSPFeature<3>& oDBGLocalWordFeature = m_voLocalWordFeatures_3ch[nDBGLocalWordSlotIdx];
+                printf("\t [%02lu] : weight=[%02.03f], anColor=[%03d,%03d,%03d], anDescBITS=[%02lu,%02lu,%02lu]  %s\n",nDBGWordIdx,fDBGLocalWordWeight,(int)oDBGLocalWordFeature.anColor[0],(int)oDBGLocalWordFeature.anColor[1],(int)oDBGLocalWordFeature.anColor[2],lv::popcount(oDBGLocalWordFeature.anDesc[0]),lv::popcount(oDBGLocalWordFeature.anDesc[1]),lv::popcount(oDBGLocalWordFeature.anDesc[2]),vsWordModList[nLocalDictDBGIdx+nDBGWordIdx].c_str());
             }
         }
         std::cout << std::fixed << std::setprecision(5) << " w_thrs(" << dbgpt << ") = " << fDBGLocalWordsWeightSumThreshold << std::endl;
@@ -1441,80 +1599,107 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
         cv::imshow("m_oIllumUpdtRegionMask",oIllumUpdtRegionMaskNormalized);
     }
 #endif //DISPLAY_PAWCS_DEBUG_INFO
-    cv::bitwise_xor(oCurrFGMask,m_oLastRawFGMask,m_oCurrRawFGBlinkMask);
-    cv::bitwise_or(m_oCurrRawFGBlinkMask,m_oLastRawFGBlinkMask,m_oBlinksFrame);
-    m_oCurrRawFGBlinkMask.copyTo(m_oLastRawFGBlinkMask);
-    oCurrFGMask.copyTo(m_oLastRawFGMask);
-    cv::morphologyEx(oCurrFGMask,m_oFGMask_PreFlood,cv::MORPH_CLOSE,m_oMorphExStructElement);
-    m_oFGMask_PreFlood.copyTo(m_oFGMask_FloodedHoles);
-    cv::floodFill(m_oFGMask_FloodedHoles,cv::Point(0,0),UCHAR_MAX);
-    cv::bitwise_not(m_oFGMask_FloodedHoles,m_oFGMask_FloodedHoles);
-    cv::erode(m_oFGMask_PreFlood,m_oFGMask_PreFlood,cv::Mat(),cv::Point(-1,-1),3);
-    cv::bitwise_or(oCurrFGMask,m_oFGMask_FloodedHoles,oCurrFGMask);
-    cv::bitwise_or(oCurrFGMask,m_oFGMask_PreFlood,oCurrFGMask);
-    cv::medianBlur(oCurrFGMask,m_oLastFGMask,m_nMedianBlurKernelSize);
-    cv::dilate(m_oLastFGMask,m_oLastFGMask_dilated,cv::Mat(),cv::Point(-1,-1),3);
-    cv::bitwise_and(m_oBlinksFrame,m_oLastFGMask_dilated_inverted,m_oBlinksFrame);
-    cv::bitwise_not(m_oLastFGMask_dilated,m_oLastFGMask_dilated_inverted);
-    cv::bitwise_and(m_oBlinksFrame,m_oLastFGMask_dilated_inverted,m_oBlinksFrame);
-    m_oLastFGMask.copyTo(oCurrFGMask);
-    cv::addWeighted(m_oMeanFinalSegmResFrame_LT,(1.0f-fRollAvgFactor_LT),m_oLastFGMask,(1.0/UCHAR_MAX)*fRollAvgFactor_LT,0,m_oMeanFinalSegmResFrame_LT,CV_32F);
-    cv::addWeighted(m_oMeanFinalSegmResFrame_ST,(1.0f-fRollAvgFactor_ST),m_oLastFGMask,(1.0/UCHAR_MAX)*fRollAvgFactor_ST,0,m_oMeanFinalSegmResFrame_ST,CV_32F);
-    const float fCurrNonFlatRegionRatio = (float)(m_nTotRelevantPxCount-nFlatRegionCount)/m_nTotRelevantPxCount;
-    if(fCurrNonFlatRegionRatio<LBSPDESC_RATIO_MIN && m_fLastNonFlatRegionRatio<LBSPDESC_RATIO_MIN) {
-        for(size_t t=0; t<=UCHAR_MAX; ++t)
-            if(m_anLBSPThreshold_8bitLUT[t]>cv::saturate_cast<uchar>((m_nLBSPThresholdOffset+t*m_fRelLBSPThreshold)/4))
-                --m_anLBSPThreshold_8bitLUT[t];
-    }
-    else if(fCurrNonFlatRegionRatio>LBSPDESC_RATIO_MAX && m_fLastNonFlatRegionRatio>LBSPDESC_RATIO_MAX) {
-        for(size_t t=0; t<=UCHAR_MAX; ++t)
-            if(m_anLBSPThreshold_8bitLUT[t]<cv::saturate_cast<uchar>(m_nLBSPThresholdOffset+UCHAR_MAX*m_fRelLBSPThreshold))
-                ++m_anLBSPThreshold_8bitLUT[t];
+    {
+        BGS_INSTR_SCOPED_TIMER(Stage_PostProc);
+        // in ROI-compacted mode, post-processing only covers the ROI bounding box padded by more than the max op footprint; all masks
+        // stay null outside of it, so the results are identical (the inverted dilated mask is still updated everywhere, it is used frame-wide)
+        const cv::Rect oPostProcRect = getPostProcessingRect(m_nMedianBlurKernelSize/2+POSTPROC_RECT_MARGIN);
+        cv::Mat oCurrFGMask_PP = oCurrFGMask(oPostProcRect), oLastFGMask_PP = m_oLastFGMask(oPostProcRect);
+        cv::Mat oLastRawFGMask_PP = m_oLastRawFGMask(oPostProcRect), oBlinksFrame_PP = m_oBlinksFrame(oPostProcRect);
+        cv::Mat oCurrRawFGBlinkMask_PP = getScratchBuffer(ScratchBuffer_CurrRawFGBlinkMask,oPostProcRect.size(),CV_8UC1), oLastRawFGBlinkMask_PP = m_oLastRawFGBlinkMask(oPostProcRect);
+        cv::Mat oFGMask_PreFlood_PP = getScratchBuffer(ScratchBuffer_FGMask_PreFlood,oPostProcRect.size(),CV_8UC1);
+        cv::Mat oFGMask_FloodedHoles_PP = getScratchBuffer(ScratchBuffer_FGMask_FloodedHoles,oPostProcRect.size(),CV_8UC1);
+        cv::Mat oLastFGMask_dilated_PP = m_oLastFGMask_dilated(oPostProcRect), oLastFGMask_dilated_inverted_PP = m_oLastFGMask_dilated_inverted(oPostProcRect);
+        FGBlobLabeler* pBlobLabeler = beginBlobExtraction(oPostProcRect);
+        if(m_bUsingFusedPostProcessing) {
+            postProcessFGMask_fused(oCurrFGMask_PP,oLastFGMask_PP,oLastRawFGMask_PP,oCurrRawFGBlinkMask_PP,oLastRawFGBlinkMask_PP,oBlinksFrame_PP,oFGMask_PreFlood_PP,
+                                    oFGMask_FloodedHoles_PP,oLastFGMask_dilated_PP,oLastFGMask_dilated_inverted_PP,m_oMorphExStructElement,getGovernedMedianBlurKernelSize(m_nMedianBlurKernelSize),pBlobLabeler);
+            cv::bitwise_not(m_oLastFGMask_dilated,m_oLastFGMask_dilated_inverted);
+        }
+        else {
+            cv::bitwise_xor(oCurrFGMask_PP,oLastRawFGMask_PP,oCurrRawFGBlinkMask_PP);
+            cv::bitwise_or(oCurrRawFGBlinkMask_PP,oLastRawFGBlinkMask_PP,oBlinksFrame_PP);
+            oCurrRawFGBlinkMask_PP.copyTo(oLastRawFGBlinkMask_PP);
+            oCurrFGMask_PP.copyTo(oLastRawFGMask_PP);
+            lv::binaryDilate(oCurrFGMask_PP,oFGMask_PreFlood_PP);
+            lv::binaryErode(oFGMask_PreFlood_PP,oFGMask_PreFlood_PP);
+            oFGMask_PreFlood_PP.copyTo(oFGMask_FloodedHoles_PP);
+            lv::binaryFloodFill(oFGMask_FloodedHoles_PP,cv::Point(0,0));
+            cv::bitwise_not(oFGMask_FloodedHoles_PP,oFGMask_FloodedHoles_PP);
+            lv::binaryErode(oFGMask_PreFlood_PP,oFGMask_PreFlood_PP,3);
+            cv::bitwise_or(oCurrFGMask_PP,oFGMask_FloodedHoles_PP,oCurrFGMask_PP);
+            cv::bitwise_or(oCurrFGMask_PP,oFGMask_PreFlood_PP,oCurrFGMask_PP);
+            lv::binaryMedianBlur(oCurrFGMask_PP,oLastFGMask_PP,getGovernedMedianBlurKernelSize(m_nMedianBlurKernelSize));
+            if(pBlobLabeler)
+                pBlobLabeler->processRows(oLastFGMask_PP,0,oLastFGMask_PP.rows);
+            lv::binaryDilate(oLastFGMask_PP,oLastFGMask_dilated_PP,3);
+            cv::bitwise_and(oBlinksFrame_PP,oLastFGMask_dilated_inverted_PP,oBlinksFrame_PP);
+            cv::bitwise_not(m_oLastFGMask_dilated,m_oLastFGMask_dilated_inverted);
+            cv::bitwise_and(oBlinksFrame_PP,oLastFGMask_dilated_inverted_PP,oBlinksFrame_PP);
+            oLastFGMask_PP.copyTo(oCurrFGMask_PP);
+        }
+        endBlobExtraction(oPostProcRect);
+        cv::Mat oMeanFinalSegmResFrame_LT_PP = m_oMeanFinalSegmResFrame_LT(oPostProcRect), oMeanFinalSegmResFrame_ST_PP = m_oMeanFinalSegmResFrame_ST(oPostProcRect);
+        lv::updateRollingAverages({&oMeanFinalSegmResFrame_LT_PP,&oMeanFinalSegmResFrame_ST_PP},{fRollAvgFactor_LT,fRollAvgFactor_ST},oLastFGMask_PP,cv::Mat(),{1.0f/UCHAR_MAX,1.0f/UCHAR_MAX});
     }
-    m_fLastNonFlatRegionRatio = fCurrNonFlatRegionRatio;
+    {
+        BGS_INSTR_SCOPED_TIMER(Stage_MotionAnalysis);
+        const float fCurrNonFlatRegionRatio = (float)(m_nTotRelevantPxCount-nFlatRegionCount)/m_nTotRelevantPxCount;
+        if(fCurrNonFlatRegionRatio<LBSPDESC_RATIO_MIN && m_fLastNonFlatRegionRatio<LBSPDESC_RATIO_MIN) {
+            for(size_t t=0; t<=UCHAR_MAX; ++t)
+                if(m_anLBSPThreshold_8bitLUT[t]>cv::saturate_cast<uchar>((m_nLBSPThresholdOffset+t*m_fRelLBSPThreshold)/4))
+                    --m_anLBSPThreshold_8bitLUT[t];
+        }
+        else if(fCurrNonFlatRegionRatio>LBSPDESC_RATIO_MAX && m_fLastNonFlatRegionRatio>LBSPDESC_RATIO_MAX) {
+            for(size_t t=0; t<=UCHAR_MAX; ++t)
+                if(m_anLBSPThreshold_8bitLUT[t]<cv::saturate_cast<uchar>(m_nLBSPThresholdOffset+UCHAR_MAX*m_fRelLBSPThreshold))
+                    ++m_anLBSPThreshold_8bitLUT[t];
+        }
+        m_fLastNonFlatRegionRatio = fCurrNonFlatRegionRatio;
 #if USE_AUTO_MODEL_RESET
-    cv::resize(oInputImg,m_oDownSampledFrame_MotionAnalysis,m_oDownSampledFrameSize_MotionAnalysis,0,0,cv::INTER_AREA);
-    cv::accumulateWeighted(m_oDownSampledFrame_MotionAnalysis,m_oMeanDownSampledLastDistFrame_LT,fRollAvgFactor_LT);
-    cv::accumulateWeighted(m_oDownSampledFrame_MotionAnalysis,m_oMeanDownSampledLastDistFrame_ST,fRollAvgFactor_ST);
-    const float fCurrMeanL1DistRatio = lv::L1dist((float*)m_oMeanDownSampledLastDistFrame_LT.data,(float*)m_oMeanDownSampledLastDistFrame_ST.data,m_oMeanDownSampledLastDistFrame_LT.total(),m_nImgChannels,m_oDownSampledROI_MotionAnalysis.data)/m_nDownSampledROIPxCount;
-    if(!m_bAutoModelResetEnabled && fCurrMeanL1DistRatio>=FRAMELEVEL_MIN_L1DIST_THRES*2)
-        m_bAutoModelResetEnabled = true;
-    if(m_bAutoModelResetEnabled || m_bUsingMovingCamera) {
-        if((m_nFrameIdx%DEFAULT_BOOTSTRAP_WIN_SIZE)==0) {
-            cv::Mat oCurrBackgroundImg, oDownSampledBackgroundImg;
-            getBackgroundImage(oCurrBackgroundImg);
-            cv::resize(oCurrBackgroundImg,oDownSampledBackgroundImg,m_oDownSampledFrameSize_MotionAnalysis,0,0,cv::INTER_AREA);
-            cv::Mat oDownSampledBackgroundImg_32F; oDownSampledBackgroundImg.convertTo(oDownSampledBackgroundImg_32F,CV_32F);
-            const float fCurrModelL1DistRatio = lv::L1dist((float*)m_oMeanDownSampledLastDistFrame_LT.data,(float*)oDownSampledBackgroundImg_32F.data,m_oMeanDownSampledLastDistFrame_LT.total(),m_nImgChannels,cv::Mat(m_oDownSampledROI_MotionAnalysis==UCHAR_MAX).data)/m_nDownSampledROIPxCount;
-            const float fCurrModelCDistRatio = lv::cdist((float*)m_oMeanDownSampledLastDistFrame_LT.data,(float*)oDownSampledBackgroundImg_32F.data,m_oMeanDownSampledLastDistFrame_LT.total(),m_nImgChannels,cv::Mat(m_oDownSampledROI_MotionAnalysis==UCHAR_MAX).data)/m_nDownSampledROIPxCount;
-            if(m_bUsingMovingCamera && fCurrModelL1DistRatio<FRAMELEVEL_MIN_L1DIST_THRES/4 && fCurrModelCDistRatio<FRAMELEVEL_MIN_CDIST_THRES/4) {
-                if(m_pDisplayHelper) m_pDisplayHelper->m_oDebugFS << m_pDisplayHelper->m_sDisplayName << "{:" << "deactivated low offset mode at" << (int)m_nFrameIdx << "}";
-                m_nLocalWordWeightOffset = DEFAULT_LWORD_WEIGHT_OFFSET;
-                m_bUsingMovingCamera = false;
-                refreshModel(1,1,true);
+        cv::resize(oInputImg,m_oDownSampledFrame_MotionAnalysis,m_oDownSampledFrameSize_MotionAnalysis,0,0,cv::INTER_AREA);
+        lv::updateRollingAverages({&m_oMeanDownSampledLastDistFrame_LT,&m_oMeanDownSampledLastDistFrame_ST},{fRollAvgFactor_LT,fRollAvgFactor_ST},m_oDownSampledFrame_MotionAnalysis);
+        const float fCurrMeanL1DistRatio = lv::L1dist((float*)m_oMeanDownSampledLastDistFrame_LT.data,(float*)m_oMeanDownSampledLastDistFrame_ST.data,m_oMeanDownSampledLastDistFrame_LT.total(),m_nImgChannels,m_oDownSampledROI_MotionAnalysis.data)/m_nDownSampledROIPxCount;
+        if(!m_bAutoModelResetEnabled && fCurrMeanL1DistRatio>=FRAMELEVEL_MIN_L1DIST_THRES*2)
+            m_bAutoModelResetEnabled = true;
+        if(m_bAutoModelResetEnabled || m_bUsingMovingCamera) {
+            if((m_nFrameIdx%DEFAULT_BOOTSTRAP_WIN_SIZE)==0) {
+                cv::Mat oCurrBackgroundImg, oDownSampledBackgroundImg;
+                getBackgroundImage(oCurrBackgroundImg);
+                cv::resize(oCurrBackgroundImg,oDownSampledBackgroundImg,m_oDownSampledFrameSize_MotionAnalysis,0,0,cv::INTER_AREA);
+                cv::Mat oDownSampledBackgroundImg_32F; oDownSampledBackgroundImg.convertTo(oDownSampledBackgroundImg_32F,CV_32F);
+                const float fCurrModelL1DistRatio = lv::L1dist((float*)m_oMeanDownSampledLastDistFrame_LT.data,(float*)oDownSampledBackgroundImg_32F.data,m_oMeanDownSampledLastDistFrame_LT.total(),m_nImgChannels,cv::Mat(m_oDownSampledROI_MotionAnalysis==UCHAR_MAX).data)/m_nDownSampledROIPxCount;
+                const float fCurrModelCDistRatio = lv::cdist((float*)m_oMeanDownSampledLastDistFrame_LT.data,(float*)oDownSampledBackgroundImg_32F.data,m_oMeanDownSampledLastDistFrame_LT.total(),m_nImgChannels,cv::Mat(m_oDownSampledROI_MotionAnalysis==UCHAR_MAX).data)/m_nDownSampledROIPxCount;
+                if(m_bUsingMovingCamera && fCurrModelL1DistRatio<FRAMELEVEL_MIN_L1DIST_THRES/4 && fCurrModelCDistRatio<FRAMELEVEL_MIN_CDIST_THRES/4) {
+                    if(m_pDisplayHelper) m_pDisplayHelper->m_oDebugFS << m_pDisplayHelper->m_sDisplayName << "{:" << "deactivated low offset mode at" << (int)m_nFrameIdx << "}";
+                    m_nLocalWordWeightOffset = DEFAULT_LWORD_WEIGHT_OFFSET;
+                    m_bUsingMovingCamera = false;
+                    refreshModel(1,1,true);
+                }
+                else if(bBootstrapping && !m_bUsingMovingCamera && (fCurrModelL1DistRatio>=FRAMELEVEL_MIN_L1DIST_THRES || fCurrModelCDistRatio>=FRAMELEVEL_MIN_CDIST_THRES)) {
+                    if(m_pDisplayHelper) m_pDisplayHelper->m_oDebugFS << m_pDisplayHelper->m_sDisplayName << "{:" << "activated low offset mode at" << (int)m_nFrameIdx << "}";
+                    m_nLocalWordWeightOffset = 5;
+                    m_bUsingMovingCamera = true;
+                    refreshModel(1,1,true);
+                }
             }
-            else if(bBootstrapping && !m_bUsingMovingCamera && (fCurrModelL1DistRatio>=FRAMELEVEL_MIN_L1DIST_THRES || fCurrModelCDistRatio>=FRAMELEVEL_MIN_CDIST_THRES)) {
-                if(m_pDisplayHelper) m_pDisplayHelper->m_oDebugFS << m_pDisplayHelper->m_sDisplayName << "{:" << "activated low offset mode at" << (int)m_nFrameIdx << "}";
-                m_nLocalWordWeightOffset = 5;
-                m_bUsingMovingCamera = true;
-                refreshModel(1,1,true);
+            if(m_nFramesSinceLastReset>DEFAULT_BOOTSTRAP_WIN_SIZE*2)
+                m_bAutoModelResetEnabled = false;
+            else if(fCurrMeanL1DistRatio>=FRAMELEVEL_MIN_L1DIST_THRES && m_nModelResetCooldown==0) {
+                if(m_pDisplayHelper) m_pDisplayHelper->m_oDebugFS << m_pDisplayHelper->m_sDisplayName << "{:" << "triggered model reset at" << (int)m_nFrameIdx << "}";
+                m_nFramesSinceLastReset = 0;
+                refreshModel(m_nLocalWordWeightOffset/8,0,true);
+                m_nModelResetCooldown = nCurrSamplesForMovingAvg_ST;
+                m_oUpdateRateFrame = cv::Scalar(1.0f);
             }
+            else if(!bBootstrapping)
+                ++m_nFramesSinceLastReset;
         }
-        if(m_nFramesSinceLastReset>DEFAULT_BOOTSTRAP_WIN_SIZE*2)
-            m_bAutoModelResetEnabled = false;
-        else if(fCurrMeanL1DistRatio>=FRAMELEVEL_MIN_L1DIST_THRES && m_nModelResetCooldown==0) {
-            if(m_pDisplayHelper) m_pDisplayHelper->m_oDebugFS << m_pDisplayHelper->m_sDisplayName << "{:" << "triggered model reset at" << (int)m_nFrameIdx << "}";
-            m_nFramesSinceLastReset = 0;
-            refreshModel(m_nLocalWordWeightOffset/8,0,true);
-            m_nModelResetCooldown = nCurrSamplesForMovingAvg_ST;
-            m_oUpdateRateFrame = cv::Scalar(1.0f);
-        }
-        else if(!bBootstrapping)
-            ++m_nFramesSinceLastReset;
-    }
-    if(m_nModelResetCooldown>0)
-        --m_nModelResetCooldown;
+        if(m_nModelResetCooldown>0)
+            --m_nModelResetCooldown;
 #endif //USE_AUTO_MODEL_RESET
+    }
+    upscaleOutputMask(oCurrFGMask,_fgmask,oOrigInputImg);
 #if USE_INTERNAL_HRCS
     std::chrono::high_resolution_clock::time_point post_morphops = std::chrono::high_resolution_clock::now();
     std::cout << "morphops=" << std::fixed << std::setprecision(1) << (float)(std::chrono::duration_cast<std::chrono::microseconds>(post_morphops-post_gword_calcs).count())/1000 << ", ";
@@ -1523,6 +1708,213 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
 #endif //USE_INTERNAL_HRCS
 }
 
+void BackgroundSubtractorPAWCS::setThreadCount(size_t nThreads) {
+    m_nThreadCount = nThreads;
+    if(m_nThreadCount==1)
+        m_pThreadPool = nullptr;
+    else if(!m_pThreadPool || m_pThreadPool->getThreadCount()!=getThreadCount())
+        m_pThreadPool = std::make_unique<lv::ThreadPool>(m_nThreadCount);
+    if(m_bInitialized)
+        updateBandLUT();
+}
+
+void BackgroundSubtractorPAWCS::setRandomSeed(uint64_t nSeed) {
+    IBackgroundSubtractorLBSP::setRandomSeed(nSeed);
+    if(m_bInitialized)
+        updateBandLUT(); // band RNGs are seeded from the main RNG
+}
+
+size_t BackgroundSubtractorPAWCS::getThreadCount() const {
+    return m_nThreadCount?m_nThreadCount:std::max((size_t)std::thread::hardware_concurrency(),size_t(1));
+}
+
+void BackgroundSubtractorPAWCS::updateBandLUT() {
+    m_vnBandModelIterLUT.clear();
+    m_voBandRNGs.clear();
+    if(m_nThreadCount==1)
+        return;
+    const size_t nRows = (size_t)m_oImgSize.height;
+    size_t nBandRows = std::max(nRows/(getThreadCount()*BANDS_PER_THREAD),(size_t)MIN_BAND_ROWS);
+    // bands must start on gword lookup map rows so that each spatio-occurrence map cell is only ever updated by a single band
+    nBandRows -= nBandRows%GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO;
+    // the model pixel LUT is sorted by image index, so each band of rows maps to a contiguous range of model iters
+    for(size_t nRowIdx=0; nRowIdx<nRows; nRowIdx+=nBandRows) {
+        const size_t nBandStartPxIdx = nRowIdx*(size_t)m_oImgSize.width;
+        m_vnBandModelIterLUT.push_back(size_t(std::lower_bound(m_vnPxIdxLUT.begin(),m_vnPxIdxLUT.begin()+m_nTotRelevantPxCount,nBandStartPxIdx)-m_vnPxIdxLUT.begin()));
+        // the last band absorbs leftover rows if they are too few to be a band of their own
+        if(nRows-nRowIdx<nBandRows*2)
+            break;
+    }
+    m_vnBandModelIterLUT.push_back(m_nTotRelevantPxCount);
+    const size_t nBands = m_vnBandModelIterLUT.size()-1;
+    m_voBandRNGs.reserve(nBands);
+    for(size_t nBandIdx=0; nBandIdx<nBands; ++nBandIdx)
+        m_voBandRNGs.emplace_back(m_oRNG(),nBandIdx);
+}
+
+void BackgroundSubtractorPAWCS::mergeBandGlobalDictDeltas() {
+    lvDbgAssert(!m_voBandGlobalDictDeltas.empty());
+    const GlobalDictBandDelta* pReplacementDelta = nullptr;
+    for(const GlobalDictBandDelta& oBandDelta : m_voBandGlobalDictDeltas) {
+        lvDbgAssert(oBandDelta.vfWeightIncrs.size()==m_nCurrGlobalWords);
+        for(size_t nGlobalWordIdx=0; nGlobalWordIdx<m_nCurrGlobalWords; ++nGlobalWordIdx) {
+            if(m_nImgChannels==1)
+                m_voGlobalWordList_1ch[nGlobalWordIdx].fLatestWeight += oBandDelta.vfWeightIncrs[nGlobalWordIdx];
+            else //m_nImgChannels==3
+                m_voGlobalWordList_3ch[nGlobalWordIdx].fLatestWeight += oBandDelta.vfWeightIncrs[nGlobalWordIdx];
+        }
+        // sequential processing keeps the last replacement in raster order, i.e. the one from the last band that requested it
+        if(oBandDelta.bReplaceWeakestWord)
+            pReplacementDelta = &oBandDelta;
+    }
+    if(pReplacementDelta) {
+        GlobalWordBase* pWeakestGlobalWord = m_vpGlobalWordDict[m_nCurrGlobalWords-1];
+        if(m_nImgChannels==1) {
+            ((GlobalWord_1ch*)pWeakestGlobalWord)->oFeature.anColor[0] = pReplacementDelta->oReplacementFeature.anColor[0];
+            ((GlobalWord_1ch*)pWeakestGlobalWord)->oFeature.anDesc[0] = pReplacementDelta->oReplacementFeature.anDesc[0];
+        }
+        else //m_nImgChannels==3
+            ((GlobalWord_3ch*)pWeakestGlobalWord)->oFeature = pReplacementDelta->oReplacementFeature;
+        pWeakestGlobalWord->nDescBITS = pReplacementDelta->nReplacementDescBITS;
+        // cleared map cells have no pending decay left to apply, whatever their stamps
+        pWeakestGlobalWord->oSpatioOccMap = cv::Scalar(0.0f);
+        pWeakestGlobalWord->fLatestWeight = pReplacementDelta->fReplacementWeight;
+        updateGlobalWordLocalWeight(*pWeakestGlobalWord,pReplacementDelta->nReplacementLookupIdx) = pReplacementDelta->fReplacementWeight;
+        m_vbDirtyGlobalWordLUTCells[pReplacementDelta->nReplacementLookupIdx/4] = 1;
+        ++m_nGlobalWordIndexStamp;
+    }
+}
+
+void BackgroundSubtractorPAWCS::sortGlobalWordLUTs() {
+    lvDbgAssert(m_vbDirtyGlobalWordLUTCells.size()==m_nGlobalWordLookupCells);
+    for(size_t nCellIdx=0; nCellIdx<m_nGlobalWordLookupCells; ++nCellIdx) {
+        // decay is uniform over the words of a cell, so only cells with incremented (or blurred) local weights can be out of order
+        if(!m_vbDirtyGlobalWordLUTCells[nCellIdx])
+            continue;
+        m_vbDirtyGlobalWordLUTCells[nCellIdx] = 0;
+        GlobalWordBase** apGlobalDictSortLUT = m_vpGlobalDictSortLUTArena.data()+nCellIdx*m_nCurrGlobalWords;
+        const size_t nGlobalWordMapLookupIdx = nCellIdx*4;
+        float fLastGlobalWordLocalWeight = getGlobalWordLocalWeight(*apGlobalDictSortLUT[0],nGlobalWordMapLookupIdx);
+        for(size_t nGlobalWordLUTIdx=1; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx) {
+            const float fCurrGlobalWordLocalWeight = getGlobalWordLocalWeight(*apGlobalDictSortLUT[nGlobalWordLUTIdx],nGlobalWordMapLookupIdx);
+            if(fCurrGlobalWordLocalWeight>fLastGlobalWordLocalWeight)
+                std::swap(apGlobalDictSortLUT[nGlobalWordLUTIdx],apGlobalDictSortLUT[nGlobalWordLUTIdx-1]);
+            else
+                fLastGlobalWordLocalWeight = fCurrGlobalWordLocalWeight;
+        }
+        if(m_nImgChannels==1)
+            updateGlobalWordIndex<1>(nCellIdx);
+        else //m_nImgChannels==3
+            updateGlobalWordIndex<3>(nCellIdx);
+    }
+}
+
+float BackgroundSubtractorPAWCS::getGlobalWordLocalWeight(const GlobalWordBase& oGlobalWord, size_t nGlobalWordMapLookupIdx) const {
+    // decay counts & stamps are 32-bit ints, so they share the float lookup indexes of the maps
+    const int nPendingDecays = *(const int*)(m_oGlobalWordDecayCounts.data+nGlobalWordMapLookupIdx)-*(const int*)(oGlobalWord.oSpatioOccStamps.data+nGlobalWordMapLookupIdx);
+    const float fLocalWeight = *(const float*)(oGlobalWord.oSpatioOccMap.data+nGlobalWordMapLookupIdx);
+    return nPendingDecays?fLocalWeight*getGlobalWordDecayFactor(nPendingDecays):fLocalWeight;
+}
+
+float& BackgroundSubtractorPAWCS::updateGlobalWordLocalWeight(GlobalWordBase& oGlobalWord, size_t nGlobalWordMapLookupIdx) {
+    float* pfLocalWeight = (float*)(oGlobalWord.oSpatioOccMap.data+nGlobalWordMapLookupIdx);
+    applyGlobalWordDecays(pfLocalWeight,(int*)(oGlobalWord.oSpatioOccStamps.data+nGlobalWordMapLookupIdx),(const int*)(m_oGlobalWordDecayCounts.data+nGlobalWordMapLookupIdx),1);
+    return *pfLocalWeight;
+}
+
+void BackgroundSubtractorPAWCS::updateGlobalWordSpatioOccMap(GlobalWordBase& oGlobalWord) {
+    lvDbgAssert(oGlobalWord.oSpatioOccMap.isContinuous() && oGlobalWord.oSpatioOccStamps.isContinuous() && m_oGlobalWordDecayCounts.isContinuous());
+    applyGlobalWordDecays((float*)oGlobalWord.oSpatioOccMap.data,(int*)oGlobalWord.oSpatioOccStamps.data,(const int*)m_oGlobalWordDecayCounts.data,m_oGlobalWordDecayCounts.total());
+}
+
+void BackgroundSubtractorPAWCS::resetGlobalWordDecayCounts() {
+    lvDbgAssert(m_oGlobalWordSpatioOccMaps.size[0]==m_oGlobalWordSpatioOccStamps.size[0]);
+    for(int nGlobalWordIdx=0; nGlobalWordIdx<m_oGlobalWordSpatioOccMaps.size[0]; ++nGlobalWordIdx)
+        applyGlobalWordDecays((float*)m_oGlobalWordSpatioOccMaps.ptr(nGlobalWordIdx),(int*)m_oGlobalWordSpatioOccStamps.ptr(nGlobalWordIdx),(const int*)m_oGlobalWordDecayCounts.data,m_oGlobalWordDecayCounts.total());
+    m_oGlobalWordSpatioOccStamps = cv::Scalar(0);
+    m_oGlobalWordDecayCounts = cv::Scalar(0);
+}
+
+template<size_t nChannels>
+void BackgroundSubtractorPAWCS::updateGlobalWordIndex(size_t nCellIdx) {
+    const size_t nBuckets = m_nGlobalWordIndexColorBuckets*m_nGlobalWordIndexDescBITSBuckets;
+    GlobalWordBase* const* const apGlobalDictSortLUT = m_vpGlobalDictSortLUTArena.data()+nCellIdx*m_nCurrGlobalWords;
+    ushort* const anRanks = m_vnGlobalWordIndexRanks.data()+nCellIdx*m_nCurrGlobalWords;
+    ushort* const anOffsets = m_vnGlobalWordIndexOffsets.data()+nCellIdx*(nBuckets+1);
+    const auto lGetBucketIdx = [&](const GlobalWordBase* pGlobalWord) {
+        const GlobalWord<ColorLBSPFeature<nChannels>>& oGlobalWord = *(const GlobalWord<ColorLBSPFeature<nChannels>>*)pGlobalWord;
+        size_t nColorSum = 0;
+        for(size_t c=0; c<nChannels; ++c)
+            nColorSum += oGlobalWord.oFeature.anColor[c];
+        return (nColorSum/(GWORD_INDEX_COLOR_BUCKET_SIZE*nChannels))*m_nGlobalWordIndexDescBITSBuckets+oGlobalWord.nDescBITS/GWORD_INDEX_DESCBITS_BUCKET_SIZE;
+    };
+    // counting sort by bucket; filling in reverse LUT order leaves each bucket in LUT order, with its start offset in anOffsets
+    std::fill_n(anOffsets,nBuckets+1,ushort(0));
+    for(size_t nGlobalWordLUTIdx=0; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx)
+        ++anOffsets[lGetBucketIdx(apGlobalDictSortLUT[nGlobalWordLUTIdx])];
+    for(size_t nBucketIdx=1; nBucketIdx<=nBuckets; ++nBucketIdx)
+        anOffsets[nBucketIdx] += anOffsets[nBucketIdx-1];
+    for(size_t nGlobalWordLUTIdx=m_nCurrGlobalWords; nGlobalWordLUTIdx>0; --nGlobalWordLUTIdx)
+        anRanks[--anOffsets[lGetBucketIdx(apGlobalDictSortLUT[nGlobalWordLUTIdx-1])]] = (ushort)(nGlobalWordLUTIdx-1);
+    m_vnGlobalWordIndexCellStamps[nCellIdx] = m_nGlobalWordIndexStamp;
+}
+
+void BackgroundSubtractorPAWCS::updateGlobalWordIndexes() {
+    for(size_t nCellIdx=0; nCellIdx<m_nGlobalWordLookupCells; ++nCellIdx) {
+        if(m_vnGlobalWordIndexCellStamps[nCellIdx]!=m_nGlobalWordIndexStamp) {
+            if(m_nImgChannels==1)
+                updateGlobalWordIndex<1>(nCellIdx);
+            else //m_nImgChannels==3
+                updateGlobalWordIndex<3>(nCellIdx);
+        }
+    }
+}
+
+// global word color distances are plain L1 distances for grayscale, and color distortion-distance mixes for RGB
+template<size_t nChannels>
+static inline std::enable_if_t<(nChannels==1),size_t> getGlobalWordColorDist(const uchar* const anCurrColor, const uchar* const anBGColor) {
+    return lv::L1dist(anCurrColor[0],anBGColor[0]);
+}
+
+template<size_t nChannels>
+static inline std::enable_if_t<(nChannels>1),size_t> getGlobalWordColorDist(const uchar* const anCurrColor, const uchar* const anBGColor) {
+    return lv::cmixdist<nChannels>(anCurrColor,anBGColor);
+}
+
+template<size_t nChannels>
+BackgroundSubtractorPAWCS::GlobalWordBase* BackgroundSubtractorPAWCS::findGlobalWord(size_t nCellIdx, const uchar* anColor, uchar nDescBITS, size_t nColorDistThreshold, size_t nDescBITSDistThreshold) {
+    lvDbgAssert(nCellIdx<m_nGlobalWordLookupCells);
+    if(m_vnGlobalWordIndexCellStamps[nCellIdx]!=m_nGlobalWordIndexStamp)
+        updateGlobalWordIndex<nChannels>(nCellIdx);
+    GlobalWordBase* const* const apGlobalDictSortLUT = m_vpGlobalDictSortLUTArena.data()+nCellIdx*m_nCurrGlobalWords;
+    const ushort* const anRanks = m_vnGlobalWordIndexRanks.data()+nCellIdx*m_nCurrGlobalWords;
+    const ushort* const anOffsets = m_vnGlobalWordIndexOffsets.data()+nCellIdx*(m_nGlobalWordIndexColorBuckets*m_nGlobalWordIndexDescBITSBuckets+1);
+    // the color distance is bounded below by the summed color difference (halved for RGB, see lv::cmixdist), which gives the color bucket range to scan
+    size_t nColorSum = 0;
+    for(size_t c=0; c<nChannels; ++c)
+        nColorSum += anColor[c];
+    const size_t nColorSumRange = (nChannels==1)?nColorDistThreshold:nColorDistThreshold*2;
+    const size_t nColorBucketBegin = (nColorSum>nColorSumRange?nColorSum-nColorSumRange:0)/(GWORD_INDEX_COLOR_BUCKET_SIZE*nChannels);
+    const size_t nColorBucketEnd = std::min((nColorSum+nColorSumRange)/(GWORD_INDEX_COLOR_BUCKET_SIZE*nChannels)+1,m_nGlobalWordIndexColorBuckets);
+    const size_t nDescBITSBucketBegin = ((size_t)nDescBITS>nDescBITSDistThreshold?nDescBITS-nDescBITSDistThreshold:0)/GWORD_INDEX_DESCBITS_BUCKET_SIZE;
+    const size_t nDescBITSBucketEnd = std::min((nDescBITS+nDescBITSDistThreshold)/GWORD_INDEX_DESCBITS_BUCKET_SIZE+1,m_nGlobalWordIndexDescBITSBuckets);
+    // the first match of each bucket is its best (buckets are in LUT order), so only bucket heads up to the best rank so far are checked
+    size_t nBestGlobalWordLUTIdx = m_nCurrGlobalWords;
+    for(size_t nColorBucketIdx=nColorBucketBegin; nColorBucketIdx<nColorBucketEnd; ++nColorBucketIdx) {
+        for(size_t nDescBITSBucketIdx=nDescBITSBucketBegin; nDescBITSBucketIdx<nDescBITSBucketEnd; ++nDescBITSBucketIdx) {
+            const size_t nBucketIdx = nColorBucketIdx*m_nGlobalWordIndexDescBITSBuckets+nDescBITSBucketIdx;
+            for(size_t nOffset=anOffsets[nBucketIdx]; nOffset<anOffsets[nBucketIdx+1] && anRanks[nOffset]<nBestGlobalWordLUTIdx; ++nOffset) {
+                const GlobalWord<ColorLBSPFeature<nChannels>>& oGlobalWord = *(const GlobalWord<ColorLBSPFeature<nChannels>>*)apGlobalDictSortLUT[anRanks[nOffset]];
+                if(lv::L1dist(nDescBITS,oGlobalWord.nDescBITS)<=nDescBITSDistThreshold && getGlobalWordColorDist<nChannels>(anColor,oGlobalWord.oFeature.anColor.data())<=nColorDistThreshold) {
+                    nBestGlobalWordLUTIdx = anRanks[nOffset];
+                    break;
+                }
+            }
+        }
+    }
+    return (nBestGlobalWordLUTIdx<m_nCurrGlobalWords)?apGlobalDictSortLUT[nBestGlobalWordLUTIdx]:nullptr;
+}
+
 void BackgroundSubtractorPAWCS::getBackgroundImage(cv::OutputArray backgroundImage) const { // @@@ add option to reconstruct from gwords?
     lvAssert_(m_bInitialized,"algo must be initialized first");
     cv::Mat oAvgBGImg = cv::Mat::zeros(m_oImgSize,CV_32FC((int)m_nImgChannels));
@@ -1535,9 +1927,11 @@ void BackgroundSubtractorPAWCS::getBackgroundImage(cv::OutputArray backgroundIma
             float fTotWeight = 0.0f;
             float fTotColor = 0.0f;
             for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                const LocalWord_1ch& oCurrLocalWord = (LocalWord_1ch&)*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
-                float fCurrWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
-                fTotColor += (float)oCurrLocalWord.oFeature.anColor[0]*fCurrWeight;
+                const size_t nCurrLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx);
+                const ColorLBSPFeature<1>& oCurrLocalWordFeature = m_voLocalWordFeatures_1ch[nCurrLocalWordSlotIdx];
+                const LocalWordStats& oCurrLocalWordStats = m_voLocalWordStats[nCurrLocalWordSlotIdx];
+                float fCurrWeight = GetLocalWordWeight(oCurrLocalWordStats,m_nFrameIdx,m_nLocalWordWeightOffset);
+                fTotColor += (float)oCurrLocalWordFeature.anColor[0]*fCurrWeight;
                 fTotWeight += fCurrWeight;
             }
             oAvgBGImg.at<float>(nCurrImgCoord_Y,nCurrImgCoord_X) = fTotColor/fTotWeight;
@@ -1546,10 +1940,12 @@ void BackgroundSubtractorPAWCS::getBackgroundImage(cv::OutputArray backgroundIma
             float fTotWeight = 0.0f;
             std::array<float,3> fTotColor = {0.0f,0.0f,0.0f};
             for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                const LocalWord_3ch& oCurrLocalWord = (LocalWord_3ch&)*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
-                float fCurrWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
+                const size_t nCurrLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx);
+                const ColorLBSPFeature<3>& oCurrLocalWordFeature = m_voLocalWordFeatures_3ch[nCurrLocalWordSlotIdx];
+                const LocalWordStats& oCurrLocalWordStats = m_voLocalWordStats[nCurrLocalWordSlotIdx];
+                float fCurrWeight = GetLocalWordWeight(oCurrLocalWordStats,m_nFrameIdx,m_nLocalWordWeightOffset);
                 for(size_t c=0; c<3; ++c)
-                    fTotColor[c] += (float)oCurrLocalWord.oFeature.anColor[c]*fCurrWeight;
+                    fTotColor[c] += (float)oCurrLocalWordFeature.anColor[c]*fCurrWeight;
                 fTotWeight += fCurrWeight;
             }
             oAvgBGImg.at<cv::Vec3f>(nCurrImgCoord_Y,nCurrImgCoord_X) = cv::Vec3f(fTotColor[0]/fTotWeight,fTotColor[1]/fTotWeight,fTotColor[2]/fTotWeight);
@@ -1571,9 +1967,11 @@ void BackgroundSubtractorPAWCS::getBackgroundDescriptorsImage(cv::OutputArray ba
             float fTotWeight = 0.0f;
             float fTotDesc = 0.0f;
             for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                const LocalWord_1ch& oCurrLocalWord = (LocalWord_1ch&)*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
-                float fCurrWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
-                fTotDesc += (float)oCurrLocalWord.oFeature.anDesc[0]*fCurrWeight;
+                const size_t nCurrLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx);
+                const ColorLBSPFeature<1>& oCurrLocalWordFeature = m_voLocalWordFeatures_1ch[nCurrLocalWordSlotIdx];
+                const LocalWordStats& oCurrLocalWordStats = m_voLocalWordStats[nCurrLocalWordSlotIdx];
+                float fCurrWeight = GetLocalWordWeight(oCurrLocalWordStats,m_nFrameIdx,m_nLocalWordWeightOffset);
+                fTotDesc += (float)oCurrLocalWordFeature.anDesc[0]*fCurrWeight;
                 fTotWeight += fCurrWeight;
             }
             oAvgBGDescImg.at<float>(nCurrImgCoord_Y,nCurrImgCoord_X) = fTotDesc/fTotWeight;
@@ -1582,10 +1980,12 @@ void BackgroundSubtractorPAWCS::getBackgroundDescriptorsImage(cv::OutputArray ba
             float fTotWeight = 0.0f;
             std::array<float,3> fTotDesc = {0.0f,0.0f,0.0f};
             for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                const LocalWord_3ch& oCurrLocalWord = (LocalWord_3ch&)*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
-                float fCurrWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
+                const size_t nCurrLocalWordSlotIdx = getLocalWordSlotIdx(nLocalDictIdx,nLocalWordIdx);
+                const ColorLBSPFeature<3>& oCurrLocalWordFeature = m_voLocalWordFeatures_3ch[nCurrLocalWordSlotIdx];
+                const LocalWordStats& oCurrLocalWordStats = m_voLocalWordStats[nCurrLocalWordSlotIdx];
+                float fCurrWeight = GetLocalWordWeight(oCurrLocalWordStats,m_nFrameIdx,m_nLocalWordWeightOffset);
                 for(size_t c=0; c<3; ++c)
-                    fTotDesc[c] += (float)oCurrLocalWord.oFeature.anDesc[c]*fCurrWeight;
+                    fTotDesc[c] += (float)oCurrLocalWordFeature.anDesc[c]*fCurrWeight;
                 fTotWeight += fCurrWeight;
             }
             oAvgBGDescImg.at<cv::Vec3f>(nCurrImgCoord_Y,nCurrImgCoord_X) = cv::Vec3f(fTotDesc[0]/fTotWeight,fTotDesc[1]/fTotWeight,fTotDesc[2]/fTotWeight);
@@ -1594,10 +1994,359 @@ void BackgroundSubtractorPAWCS::getBackgroundDescriptorsImage(cv::OutputArray ba
     oAvgBGDescImg.convertTo(backgroundDescImage,CV_16U);
 }
 
-float BackgroundSubtractorPAWCS::GetLocalWordWeight(const LocalWordBase& w, size_t nCurrFrame, size_t nOffset) {
+void BackgroundSubtractorPAWCS::setModelCapacity(size_t nMaxLocalWords, size_t nMaxGlobalWords) {
+    lvAssert_(nMaxLocalWords>0 && nMaxGlobalWords>0,"max local/global word counts must be positive");
+    if(!m_bInitialized) {
+        m_nMaxLocalWords = nMaxLocalWords;
+        m_nMaxGlobalWords = nMaxGlobalWords;
+        return;
+    }
+    // current word counts are scaled the same way as the max counts (they were derived from them in 'initialize')
+    const size_t nNewLocalWords = std::min(std::max((size_t)std::round((double)m_nCurrLocalWords*nMaxLocalWords/m_nMaxLocalWords),(size_t)1),nMaxLocalWords);
+    const size_t nNewGlobalWords = std::min(std::max((size_t)std::round((double)m_nCurrGlobalWords*nMaxGlobalWords/m_nMaxGlobalWords),(size_t)1),nMaxGlobalWords);
+    lvAssert_(nNewLocalWords<LWORD_UNINIT_SLOT,"local word count too large for slot-indexed local dictionaries");
+    lvAssert_(nNewGlobalWords<=USHRT_MAX,"global word count too large for per-cell global word indexes");
+    m_nMaxLocalWords = nMaxLocalWords;
+    m_nMaxGlobalWords = nMaxGlobalWords;
+    if(nNewLocalWords==m_nCurrLocalWords && nNewGlobalWords==m_nCurrGlobalWords)
+        return;
+    // global word maps are copied as-is below, so their pending decays are applied first
+    resetGlobalWordDecayCounts();
+    auto lResizeWords = [&](auto& voLocalWordFeatures, auto& voGlobalWordList, auto& pGlobalWordListIter) {
+        using TGlobalWord = typename std::decay_t<decltype(voGlobalWordList)>::value_type;
+        // == resize: local dictionaries (words are re-sorted by weight, and the strongest ones are kept in the first slots of the new blocks)
+        std::decay_t<decltype(voLocalWordFeatures)> voNewLocalWordFeatures(voLocalWordFeatures.get_allocator());
+        voNewLocalWordFeatures.resize(m_nTotRelevantPxCount*nNewLocalWords);
+        LocalWordList<LocalWordStats> voNewLocalWordStats(m_voLocalWordStats.get_allocator());
+        voNewLocalWordStats.resize(m_nTotRelevantPxCount*nNewLocalWords);
+        std::vector<ushort> vnNewLocalWordDict(m_nTotRelevantPxCount*nNewLocalWords,LWORD_UNINIT_SLOT);
+        std::vector<ushort> vnCurrLocalWordSlots(m_nCurrLocalWords);
+        for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
+            const size_t nLocalDictIdx = nModelIter*m_nCurrLocalWords;
+            const auto lLocalWordComp = [&](ushort a, ushort b) {
+                return a!=LWORD_UNINIT_SLOT && (b==LWORD_UNINIT_SLOT || GetLocalWordWeight(m_voLocalWordStats[nLocalDictIdx+a],m_nFrameIdx,m_nLocalWordWeightOffset)>GetLocalWordWeight(m_voLocalWordStats[nLocalDictIdx+b],m_nFrameIdx,m_nLocalWordWeightOffset));
+            };
+            std::copy_n(m_vnLocalWordDict.begin()+nLocalDictIdx,m_nCurrLocalWords,vnCurrLocalWordSlots.begin());
+            std::stable_sort(vnCurrLocalWordSlots.begin(),vnCurrLocalWordSlots.end(),lLocalWordComp);
+            const size_t nKeptLocalWords = std::min((size_t)(std::find(vnCurrLocalWordSlots.begin(),vnCurrLocalWordSlots.end(),LWORD_UNINIT_SLOT)-vnCurrLocalWordSlots.begin()),nNewLocalWords);
+            const size_t nNewLocalDictIdx = nModelIter*nNewLocalWords;
+            for(size_t nLocalWordIdx=0; nLocalWordIdx<nKeptLocalWords; ++nLocalWordIdx) {
+                voNewLocalWordFeatures[nNewLocalDictIdx+nLocalWordIdx] = voLocalWordFeatures[nLocalDictIdx+vnCurrLocalWordSlots[nLocalWordIdx]];
+                voNewLocalWordStats[nNewLocalDictIdx+nLocalWordIdx] = m_voLocalWordStats[nLocalDictIdx+vnCurrLocalWordSlots[nLocalWordIdx]];
+                vnNewLocalWordDict[nNewLocalDictIdx+nLocalWordIdx] = (ushort)nLocalWordIdx;
+            }
+            for(size_t nLocalWordIdx=nKeptLocalWords; nKeptLocalWords>0 && nLocalWordIdx<nNewLocalWords; ++nLocalWordIdx) {
+                // new slots are filled with weak copies of the kept words (as in 'refreshModel'), and will be replaced quickly if not relevant
+                voNewLocalWordFeatures[nNewLocalDictIdx+nLocalWordIdx] = voNewLocalWordFeatures[nNewLocalDictIdx+(nLocalWordIdx%nKeptLocalWords)];
+                LocalWordStats& oCurrNewLocalWordStats = voNewLocalWordStats[nNewLocalDictIdx+nLocalWordIdx];
+                oCurrNewLocalWordStats = voNewLocalWordStats[nNewLocalDictIdx+(nLocalWordIdx%nKeptLocalWords)];
+                oCurrNewLocalWordStats.nOccurrences = std::max((size_t)(oCurrNewLocalWordStats.nOccurrences*((float)(nNewLocalWords-nLocalWordIdx)/nNewLocalWords)),(size_t)1);
+                oCurrNewLocalWordStats.nFirstOcc = m_nFrameIdx;
+                oCurrNewLocalWordStats.nLastOcc = m_nFrameIdx;
+                vnNewLocalWordDict[nNewLocalDictIdx+nLocalWordIdx] = (ushort)nLocalWordIdx;
+            }
+        }
+        voLocalWordFeatures = std::move(voNewLocalWordFeatures);
+        m_voLocalWordStats = std::move(voNewLocalWordStats);
+        m_vnLocalWordDict = std::move(vnNewLocalWordDict);
+        // == resize: global dictionary (words are re-sorted by latest weight, and the strongest ones are kept)
+        std::vector<GlobalWordBase*> vpCurrGlobalWords(m_vpGlobalWordDict);
+        std::stable_sort(vpCurrGlobalWords.begin(),vpCurrGlobalWords.end(),[](const GlobalWordBase* a, const GlobalWordBase* b) {
+            return a && (!b || a->fLatestWeight>b->fLatestWeight);
+        });
+        const size_t nKeptGlobalWords = std::min((size_t)(std::find(vpCurrGlobalWords.begin(),vpCurrGlobalWords.end(),nullptr)-vpCurrGlobalWords.begin()),nNewGlobalWords);
+        const int anSpatioOccMapsDims[3] = {(int)nNewGlobalWords,m_oDownSampledFrameSize_GlobalWordLookup.height,m_oDownSampledFrameSize_GlobalWordLookup.width};
+        cv::Mat oNewGlobalWordSpatioOccMaps(3,anSpatioOccMapsDims,CV_32FC1,cv::Scalar(0.0f));
+        cv::Mat oNewGlobalWordSpatioOccStamps(3,anSpatioOccMapsDims,CV_32SC1,cv::Scalar(0));
+        std::vector<TGlobalWord> voNewGlobalWordList(nNewGlobalWords);
+        std::vector<int> vnGlobalWordIdxRemap(voGlobalWordList.size(),-1);
+        m_vpGlobalWordDict.assign(nNewGlobalWords,nullptr);
+        for(size_t nGlobalWordIdx=0; nGlobalWordIdx<nNewGlobalWords; ++nGlobalWordIdx) {
+            TGlobalWord& oCurrNewGlobalWord = voNewGlobalWordList[nGlobalWordIdx];
+            if(nGlobalWordIdx<nKeptGlobalWords) {
+                const TGlobalWord& oOldGlobalWord = *(TGlobalWord*)vpCurrGlobalWords[nGlobalWordIdx];
+                oCurrNewGlobalWord.oFeature = oOldGlobalWord.oFeature;
+                oCurrNewGlobalWord.nDescBITS = oOldGlobalWord.nDescBITS;
+                oCurrNewGlobalWord.fLatestWeight = oOldGlobalWord.fLatestWeight;
+                vnGlobalWordIdxRemap[size_t(&oOldGlobalWord-voGlobalWordList.data())] = (int)nGlobalWordIdx;
+            }
+            else {
+                // new slots are filled with empty words (as in 'refreshModel')
+                std::fill(oCurrNewGlobalWord.oFeature.anColor.begin(),oCurrNewGlobalWord.oFeature.anColor.end(),uchar(0));
+                std::fill(oCurrNewGlobalWord.oFeature.anDesc.begin(),oCurrNewGlobalWord.oFeature.anDesc.end(),ushort(0));
+                oCurrNewGlobalWord.nDescBITS = 0;
+                oCurrNewGlobalWord.fLatestWeight = 0.0f;
+            }
+            oCurrNewGlobalWord.oSpatioOccMap = cv::Mat(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1,oNewGlobalWordSpatioOccMaps.ptr((int)nGlobalWordIdx));
+            oCurrNewGlobalWord.oSpatioOccStamps = cv::Mat(m_oDownSampledFrameSize_GlobalWordLookup,CV_32SC1,oNewGlobalWordSpatioOccStamps.ptr((int)nGlobalWordIdx));
+            if(nGlobalWordIdx<nKeptGlobalWords)
+                vpCurrGlobalWords[nGlobalWordIdx]->oSpatioOccMap.copyTo(oCurrNewGlobalWord.oSpatioOccMap);
+            m_vpGlobalWordDict[nGlobalWordIdx] = &oCurrNewGlobalWord;
+        }
+        // per-cell sort LUTs keep their current order for kept words, with new words appended at the end
+        std::vector<GlobalWordBase*> vpNewGlobalDictSortLUTArena(m_nGlobalWordLookupCells*nNewGlobalWords,nullptr);
+        std::vector<uchar> vbGlobalWordInLUT(nNewGlobalWords);
+        for(size_t nCellIdx=0; nCellIdx<m_nGlobalWordLookupCells; ++nCellIdx) {
+            GlobalWordBase** apNewGlobalDictSortLUT = vpNewGlobalDictSortLUTArena.data()+nCellIdx*nNewGlobalWords;
+            std::fill(vbGlobalWordInLUT.begin(),vbGlobalWordInLUT.end(),uchar(0));
+            size_t nLUTIdx = 0;
+            for(size_t nOldLUTIdx=0; nOldLUTIdx<m_nCurrGlobalWords; ++nOldLUTIdx) {
+                const GlobalWordBase* pOldGlobalWord = m_vpGlobalDictSortLUTArena[nCellIdx*m_nCurrGlobalWords+nOldLUTIdx];
+                const int nNewGlobalWordIdx = pOldGlobalWord?vnGlobalWordIdxRemap[size_t((const TGlobalWord*)pOldGlobalWord-voGlobalWordList.data())]:-1;
+                if(nNewGlobalWordIdx>=0 && !vbGlobalWordInLUT[(size_t)nNewGlobalWordIdx]) {
+                    vbGlobalWordInLUT[(size_t)nNewGlobalWordIdx] = 1;
+                    apNewGlobalDictSortLUT[nLUTIdx++] = &voNewGlobalWordList[(size_t)nNewGlobalWordIdx];
+                }
+            }
+            for(size_t nGlobalWordIdx=0; nGlobalWordIdx<nNewGlobalWords; ++nGlobalWordIdx)
+                if(!vbGlobalWordInLUT[nGlobalWordIdx])
+                    apNewGlobalDictSortLUT[nLUTIdx++] = &voNewGlobalWordList[nGlobalWordIdx];
+            lvDbgAssert(nLUTIdx==nNewGlobalWords);
+        }
+        voGlobalWordList = std::move(voNewGlobalWordList);
+        pGlobalWordListIter = voGlobalWordList.end();
+        m_oGlobalWordSpatioOccMaps = oNewGlobalWordSpatioOccMaps;
+        m_oGlobalWordSpatioOccStamps = oNewGlobalWordSpatioOccStamps;
+        m_vpGlobalDictSortLUTArena = std::move(vpNewGlobalDictSortLUTArena);
+        for(size_t nPxIter=0; nPxIter<m_nTotPxCount; ++nPxIter)
+            if(m_oROI.data[nPxIter])
+                m_voPxInfoLUT_PAWCS[nPxIter].apGlobalDictSortLUT = m_vpGlobalDictSortLUTArena.data()+(m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx/4)*nNewGlobalWords;
+        m_vnGlobalWordIndexRanks.assign(m_nGlobalWordLookupCells*nNewGlobalWords,0);
+        ++m_nGlobalWordIndexStamp;
+    };
+    if(m_nImgChannels==1)
+        lResizeWords(m_voLocalWordFeatures_1ch,m_voGlobalWordList_1ch,m_pGlobalWordListIter_1ch);
+    else //m_nImgChannels==3
+        lResizeWords(m_voLocalWordFeatures_3ch,m_voGlobalWordList_3ch,m_pGlobalWordListIter_3ch);
+    m_nCurrLocalWords = nNewLocalWords;
+    m_nCurrGlobalWords = nNewGlobalWords;
+}
+
+bool BackgroundSubtractorPAWCS::updateModelROI(const cv::Mat& oNewROI, size_t nOrigROIPxCount) {
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    std::vector<std::pair<size_t,size_t>> vAddedPxSources;
+    getAddedROIPxSources(m_oROI,oNewROI,vAddedPxSources);
+    // previous model indexes are looked up before the LUTs are rebuilt (added pixels borrow those of their sources)
+    std::vector<size_t> vnPrevModelIdxs(m_nTotPxCount,SIZE_MAX);
+    for(size_t nPxIter=0; nPxIter<m_nTotPxCount; ++nPxIter)
+        if(m_oROI.data[nPxIter])
+            vnPrevModelIdxs[nPxIter] = m_voPxInfoLUT_PAWCS[nPxIter].nModelIdx;
+    for(const auto& oAddedPx : vAddedPxSources)
+        vnPrevModelIdxs[oAddedPx.first] = vnPrevModelIdxs[oAddedPx.second];
+    setInternalROI(oNewROI,nOrigROIPxCount);
+    size_t nNewGlobalWordLookupCells = m_nGlobalWordLookupCells;
+    for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
+        const int nImgCoord_Y = (int)m_vnPxIdxLUT[nModelIter]/m_oImgSize.width, nImgCoord_X = (int)m_vnPxIdxLUT[nModelIter]%m_oImgSize.width;
+        nNewGlobalWordLookupCells = std::max(nNewGlobalWordLookupCells,(size_t)((nImgCoord_Y/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO)*m_oDownSampledFrameSize_GlobalWordLookup.width+(nImgCoord_X/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO))+1);
+    }
+    auto lRemapWords = [&](auto& voLocalWordFeatures, auto& voGlobalWordList) {
+        // == remap: local dictionaries (the word arrays only cover the new ROI, so memory of removed pixels is released)
+        std::decay_t<decltype(voLocalWordFeatures)> voNewLocalWordFeatures(voLocalWordFeatures.get_allocator());
+        voNewLocalWordFeatures.resize(m_nTotRelevantPxCount*m_nCurrLocalWords);
+        LocalWordList<LocalWordStats> voNewLocalWordStats(m_voLocalWordStats.get_allocator());
+        voNewLocalWordStats.resize(m_nTotRelevantPxCount*m_nCurrLocalWords);
+        std::vector<ushort> vnNewLocalWordDict(m_nTotRelevantPxCount*m_nCurrLocalWords);
+        for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
+            // dictionaries hold slots relative to their pixel's block, so whole blocks are copied as-is
+            const size_t nPrevLocalDictIdx = vnPrevModelIdxs[m_vnPxIdxLUT[nModelIter]]*m_nCurrLocalWords, nNewLocalDictIdx = nModelIter*m_nCurrLocalWords;
+            std::copy_n(voLocalWordFeatures.begin()+nPrevLocalDictIdx,m_nCurrLocalWords,voNewLocalWordFeatures.begin()+nNewLocalDictIdx);
+            std::copy_n(m_voLocalWordStats.begin()+nPrevLocalDictIdx,m_nCurrLocalWords,voNewLocalWordStats.begin()+nNewLocalDictIdx);
+            std::copy_n(m_vnLocalWordDict.begin()+nPrevLocalDictIdx,m_nCurrLocalWords,vnNewLocalWordDict.begin()+nNewLocalDictIdx);
+        }
+        voLocalWordFeatures = std::move(voNewLocalWordFeatures);
+        m_voLocalWordStats = std::move(voNewLocalWordStats);
+        m_vnLocalWordDict = std::move(vnNewLocalWordDict);
+        // == remap: global word sort LUTs (new lookup map cells start with all global words in dictionary order)
+        if(nNewGlobalWordLookupCells>m_nGlobalWordLookupCells) {
+            m_vpGlobalDictSortLUTArena.resize(nNewGlobalWordLookupCells*m_nCurrGlobalWords);
+            for(size_t nCellIdx=m_nGlobalWordLookupCells; nCellIdx<nNewGlobalWordLookupCells; ++nCellIdx)
+                for(size_t nGlobalWordIdxIter=0; nGlobalWordIdxIter<m_nCurrGlobalWords; ++nGlobalWordIdxIter)
+                    m_vpGlobalDictSortLUTArena[nCellIdx*m_nCurrGlobalWords+nGlobalWordIdxIter] = &voGlobalWordList[nGlobalWordIdxIter];
+        }
+    };
+    if(m_nImgChannels==1)
+        lRemapWords(m_voLocalWordFeatures_1ch,m_voGlobalWordList_1ch);
+    else //m_nImgChannels==3
+        lRemapWords(m_voLocalWordFeatures_3ch,m_voGlobalWordList_3ch);
+    if(nNewGlobalWordLookupCells>m_nGlobalWordLookupCells) {
+        m_nGlobalWordLookupCells = nNewGlobalWordLookupCells;
+        m_vnGlobalWordIndexRanks.assign(m_nGlobalWordLookupCells*m_nCurrGlobalWords,0);
+        m_vnGlobalWordIndexOffsets.assign(m_nGlobalWordLookupCells*(m_nGlobalWordIndexColorBuckets*m_nGlobalWordIndexDescBITSBuckets+1),0);
+        m_vnGlobalWordIndexCellStamps.resize(m_nGlobalWordLookupCells);
+        m_vbDirtyGlobalWordLUTCells.resize(m_nGlobalWordLookupCells,uchar(1));
+        ++m_nGlobalWordIndexStamp;
+    }
+    for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
+        const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
+        m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y = (int)nPxIter/m_oImgSize.width;
+        m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X = (int)nPxIter%m_oImgSize.width;
+        m_voPxInfoLUT_PAWCS[nPxIter].nModelIdx = nModelIter;
+        m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx = (size_t)((m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO)*m_oDownSampledFrameSize_GlobalWordLookup.width+(m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO))*4;
+        m_voPxInfoLUT_PAWCS[nPxIter].apGlobalDictSortLUT = m_vpGlobalDictSortLUTArena.data()+(m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx/4)*m_nCurrGlobalWords;
+    }
+    for(cv::Mat* pStateMap : {&m_oUpdateRateFrame,&m_oDistThresholdFrame,&m_oDistThresholdVariationFrame,&m_oMeanMinDistFrame_LT,&m_oMeanMinDistFrame_ST,
+                              &m_oMeanRawSegmResFrame_LT,&m_oMeanRawSegmResFrame_ST,&m_oMeanFinalSegmResFrame_LT,&m_oMeanFinalSegmResFrame_ST,&m_oLastColorFrame,&m_oLastDescFrame})
+        copyAddedROIPxData(*pStateMap,vAddedPxSources);
+    // masks are transient, and restart as in 'initialize'
+    for(cv::Mat* pMask : {&m_oLastFGMask,&m_oIllumUpdtRegionMask,&m_oUnstableRegionMask,&m_oBlinksFrame,&m_oLastRawFGMask,&m_oLastFGMask_dilated,&m_oLastFGMask_dilated_inverted,&m_oLastRawFGBlinkMask})
+        *pMask = cv::Scalar_<uchar>(0);
+    cv::resize(m_oROI,m_oDownSampledROI_MotionAnalysis,m_oDownSampledFrameSize_MotionAnalysis,0,0,cv::INTER_AREA);
+    if(m_nOrigROIPxCount>=m_nTotPxCount/2 && (int)m_nTotPxCount>=DEFAULT_FRAME_SIZE.area())
+        m_oDownSampledROI_MotionAnalysis |= UCHAR_MAX/2;
+    m_nDownSampledROIPxCount = (size_t)cv::countNonZero(m_oDownSampledROI_MotionAnalysis);
+    updateBandLUT();
+    invalidateDescriptorCache();
+    return true;
+}
+
+float BackgroundSubtractorPAWCS::GetLocalWordWeight(const LocalWordStats& w, size_t nCurrFrame, size_t nOffset) {
     return (float)(w.nOccurrences)/((w.nLastOcc-w.nFirstOcc)+(nCurrFrame-w.nLastOcc)*2+nOffset);
 }
 
 float BackgroundSubtractorPAWCS::GetGlobalWordWeight(const GlobalWordBase& w) {
     return (float)cv::sum(w.oSpatioOccMap).val[0];
 }
+
+std::shared_ptr<IIBackgroundSubtractor> BackgroundSubtractorPAWCS::createInstance() const {
+    auto pClone = std::make_shared<BackgroundSubtractorPAWCS>(m_nDescDistThresholdOffset,m_nMinColorDistThreshold,m_nMaxLocalWords,m_nSamplesForMovingAvgs,m_fRelLBSPThreshold);
+    pClone->setDescriptorCache(m_bUsingDescCache,m_nDescCacheNoiseFloor);
+    pClone->setBlockSampleMatching(m_bUsingBlockMatching);
+    pClone->setThreadCount(m_nThreadCount);
+    pClone->setModelCapacity(m_nMaxLocalWords,m_nMaxGlobalWords);
+    return pClone;
+}
+
+void BackgroundSubtractorPAWCS::writeModelState(std::ostream& oStream) const {
+    writeLBSPModelState(oStream);
+    lv::writeBinary(oStream,(uint64_t)m_nCurrLocalWords);
+    lv::writeBinary(oStream,(uint64_t)m_nCurrGlobalWords);
+    lv::writeBinary(oStream,m_fLastNonFlatRegionRatio);
+    lv::writeBinary(oStream,(int32_t)m_nMedianBlurKernelSize);
+    lv::writeBinary(oStream,(uint64_t)m_nLocalWordWeightOffset);
+    lv::writeBinary(oStream,(uint64_t)m_nPendingGlobalWordBlurs);
+    // local dictionaries already hold slot indices, and global word pointers are written as indices in their (contiguous) list, with -1 marking unassigned dictionary slots
+    auto lGetWordIdx = [](const auto* pWord, const auto& voWordList) -> int64_t {
+        return pWord?int64_t(static_cast<decltype(voWordList.data())>(pWord)-voWordList.data()):int64_t(-1);
+    };
+    auto lWriteWords = [&](const auto& voLocalWordFeatures, const auto& voGlobalWordList, const auto& pGlobalWordListIter) {
+        lv::writeBinary(oStream,voLocalWordFeatures);
+        lv::writeBinary(oStream,m_voLocalWordStats);
+        lv::writeBinary(oStream,m_vnLocalWordDict);
+        lv::writeBinary(oStream,(uint64_t)voGlobalWordList.size());
+        for(const auto& oGlobalWord : voGlobalWordList) {
+            lv::writeBinary(oStream,oGlobalWord.fLatestWeight);
+            lv::writeBinary(oStream,oGlobalWord.nDescBITS);
+            lv::writeBinary(oStream,oGlobalWord.oFeature);
+            cv::writeBinary(oStream,oGlobalWord.oSpatioOccMap);
+            cv::writeBinary(oStream,oGlobalWord.oSpatioOccStamps);
+        }
+        lv::writeBinary(oStream,(uint64_t)(pGlobalWordListIter-voGlobalWordList.begin()));
+        std::vector<int64_t> vnWordIdxs(m_vpGlobalWordDict.size());
+        for(size_t nDictIdx=0; nDictIdx<m_vpGlobalWordDict.size(); ++nDictIdx)
+            vnWordIdxs[nDictIdx] = lGetWordIdx(m_vpGlobalWordDict[nDictIdx],voGlobalWordList);
+        lv::writeBinary(oStream,vnWordIdxs);
+        for(size_t nPxIter=0; nPxIter<m_nTotPxCount; ++nPxIter) {
+            if(m_oROI.data[nPxIter]) {
+                GlobalWordBase* const* apGlobalDictSortLUT = m_voPxInfoLUT_PAWCS[nPxIter].apGlobalDictSortLUT;
+                vnWordIdxs.resize(m_nCurrGlobalWords);
+                for(size_t nLUTIdx=0; nLUTIdx<m_nCurrGlobalWords; ++nLUTIdx)
+                    vnWordIdxs[nLUTIdx] = lGetWordIdx(apGlobalDictSortLUT[nLUTIdx],voGlobalWordList);
+                lv::writeBinary(oStream,vnWordIdxs);
+            }
+        }
+    };
+    if(m_nImgChannels==1)
+        lWriteWords(m_voLocalWordFeatures_1ch,m_voGlobalWordList_1ch,m_pGlobalWordListIter_1ch);
+    else //m_nImgChannels==3
+        lWriteWords(m_voLocalWordFeatures_3ch,m_voGlobalWordList_3ch,m_pGlobalWordListIter_3ch);
+    for(const cv::Mat* pMap : {&m_oIllumUpdtRegionMask,&m_oUpdateRateFrame,&m_oDistThresholdFrame,&m_oDistThresholdVariationFrame,
+                               &m_oMeanMinDistFrame_LT,&m_oMeanMinDistFrame_ST,&m_oMeanDownSampledLastDistFrame_LT,&m_oMeanDownSampledLastDistFrame_ST,
+                               &m_oMeanRawSegmResFrame_LT,&m_oMeanRawSegmResFrame_ST,&m_oMeanFinalSegmResFrame_LT,&m_oMeanFinalSegmResFrame_ST,
+                               &m_oUnstableRegionMask,&m_oBlinksFrame,&m_oLastRawFGMask,&m_oLastFGMask_dilated_inverted,&m_oLastRawFGBlinkMask,
+                               &m_oGlobalWordDecayCounts})
+        cv::writeBinary(oStream,*pMap);
+    lv::writeBinary(oStream,m_vbDirtyGlobalWordLUTCells);
+    lv::writeBinary(oStream,m_voBandRNGs);
+}
+
+void BackgroundSubtractorPAWCS::readModelState(std::istream& oStream) {
+    lvAssert_(m_bInitialized,"algorithm must be initialized before its model state is read");
+    readLBSPModelState(oStream);
+    uint64_t nCurrLocalWords,nCurrGlobalWords,nLocalWordWeightOffset,nPendingGlobalWordBlurs;
+    lv::readBinary(oStream,nCurrLocalWords);
+    lv::readBinary(oStream,nCurrGlobalWords);
+    lvAssert_((size_t)nCurrLocalWords==m_nCurrLocalWords && (size_t)nCurrGlobalWords==m_nCurrGlobalWords,"model snapshot word count mismatch");
+    lv::readBinary(oStream,m_fLastNonFlatRegionRatio);
+    int32_t nMedianBlurKernelSize;
+    lv::readBinary(oStream,nMedianBlurKernelSize);
+    m_nMedianBlurKernelSize = (int)nMedianBlurKernelSize;
+    lv::readBinary(oStream,nLocalWordWeightOffset);
+    m_nLocalWordWeightOffset = (size_t)nLocalWordWeightOffset;
+    lv::readBinary(oStream,nPendingGlobalWordBlurs);
+    m_nPendingGlobalWordBlurs = (size_t)nPendingGlobalWordBlurs;
+    auto lGetWordPtr = [](int64_t nWordIdx, auto& voWordList) -> decltype(voWordList.data()) {
+        lvAssert_(nWordIdx>=-1 && nWordIdx<(int64_t)voWordList.size(),"bad word index in model snapshot");
+        return (nWordIdx>=0)?&voWordList[(size_t)nWordIdx]:nullptr;
+    };
+    auto lReadWords = [&](auto& voLocalWordFeatures, auto& voGlobalWordList, auto& pGlobalWordListIter) {
+        const size_t nLocalWordCount = voLocalWordFeatures.size();
+        lv::readBinary(oStream,voLocalWordFeatures);
+        lv::readBinary(oStream,m_voLocalWordStats);
+        lvAssert_(voLocalWordFeatures.size()==nLocalWordCount && m_voLocalWordStats.size()==nLocalWordCount,"model snapshot local word count mismatch");
+        const size_t nLocalDictSize = m_vnLocalWordDict.size();
+        lv::readBinary(oStream,m_vnLocalWordDict);
+        lvAssert_(m_vnLocalWordDict.size()==nLocalDictSize,"model snapshot local dictionary size mismatch");
+        for(const ushort nLocalWordSlot : m_vnLocalWordDict)
+            lvAssert_(nLocalWordSlot<m_nCurrLocalWords || nLocalWordSlot==LWORD_UNINIT_SLOT,"bad local word slot in model snapshot");
+        std::vector<int64_t> vnWordIdxs;
+        uint64_t nListOffset;
+        uint64_t nGlobalWordCount;
+        lv::readBinary(oStream,nGlobalWordCount);
+        lvAssert_((size_t)nGlobalWordCount==voGlobalWordList.size(),"model snapshot global word count mismatch");
+        for(auto& oGlobalWord : voGlobalWordList) {
+            lv::readBinary(oStream,oGlobalWord.fLatestWeight);
+            lv::readBinary(oStream,oGlobalWord.nDescBITS);
+            lv::readBinary(oStream,oGlobalWord.oFeature);
+            cv::readBinary(oStream,oGlobalWord.oSpatioOccMap);
+            cv::readBinary(oStream,oGlobalWord.oSpatioOccStamps);
+        }
+        lv::readBinary(oStream,nListOffset);
+        lvAssert_((size_t)nListOffset<=voGlobalWordList.size(),"bad global word list offset in model snapshot");
+        pGlobalWordListIter = voGlobalWordList.begin()+(ptrdiff_t)nListOffset;
+        lv::readBinary(oStream,vnWordIdxs);
+        lvAssert_(vnWordIdxs.size()==m_vpGlobalWordDict.size(),"model snapshot global dictionary size mismatch");
+        for(size_t nDictIdx=0; nDictIdx<m_vpGlobalWordDict.size(); ++nDictIdx)
+            m_vpGlobalWordDict[nDictIdx] = lGetWordPtr(vnWordIdxs[nDictIdx],voGlobalWordList);
+        for(size_t nPxIter=0; nPxIter<m_nTotPxCount; ++nPxIter) {
+            if(m_oROI.data[nPxIter]) {
+                GlobalWordBase** apGlobalDictSortLUT = m_voPxInfoLUT_PAWCS[nPxIter].apGlobalDictSortLUT;
+                lv::readBinary(oStream,vnWordIdxs);
+                lvAssert_(vnWordIdxs.size()==m_nCurrGlobalWords,"model snapshot global word LUT size mismatch");
+                for(size_t nLUTIdx=0; nLUTIdx<m_nCurrGlobalWords; ++nLUTIdx)
+                    apGlobalDictSortLUT[nLUTIdx] = lGetWordPtr(vnWordIdxs[nLUTIdx],voGlobalWordList);
+            }
+        }
+        ++m_nGlobalWordIndexStamp;
+    };
+    if(m_nImgChannels==1)
+        lReadWords(m_voLocalWordFeatures_1ch,m_voGlobalWordList_1ch,m_pGlobalWordListIter_1ch);
+    else //m_nImgChannels==3
+        lReadWords(m_voLocalWordFeatures_3ch,m_voGlobalWordList_3ch,m_pGlobalWordListIter_3ch);
+    for(cv::Mat* pMap : {&m_oIllumUpdtRegionMask,&m_oUpdateRateFrame,&m_oDistThresholdFrame,&m_oDistThresholdVariationFrame,
+                         &m_oMeanMinDistFrame_LT,&m_oMeanMinDistFrame_ST,&m_oMeanDownSampledLastDistFrame_LT,&m_oMeanDownSampledLastDistFrame_ST,
+                         &m_oMeanRawSegmResFrame_LT,&m_oMeanRawSegmResFrame_ST,&m_oMeanFinalSegmResFrame_LT,&m_oMeanFinalSegmResFrame_ST,
+                         &m_oUnstableRegionMask,&m_oBlinksFrame,&m_oLastRawFGMask,&m_oLastFGMask_dilated_inverted,&m_oLastRawFGBlinkMask,
+                         &m_oGlobalWordDecayCounts}) {
+        const cv::Size oMapSize = pMap->size();
+        const int nMapType = pMap->type();
+        cv::readBinary(oStream,*pMap);
+        lvAssert_(pMap->size()==oMapSize && pMap->type()==nMapType,"bad state map in model snapshot");
+    }
+    lv::readBinary(oStream,m_vbDirtyGlobalWordLUTCells);
+    lvAssert_(m_vbDirtyGlobalWordLUTCells.size()==m_nGlobalWordLookupCells,"model snapshot global word LUT cell count mismatch");
+    std::vector<lv::PCG32> voBandRNGs;
+    lv::readBinary(oStream,voBandRNGs);
+    // band RNGs can only be restored if the thread count (and thus the band count) did not change since the snapshot
+    if(voBandRNGs.size()==m_voBandRNGs.size())
+        m_voBandRNGs = voBandRNGs;
+}
@@ -34,6 +34,10 @@ BackgroundSubtractorPBAS::BackgroundSubtractorPBAS(size_t nInitColorDistThreshol
 
 BackgroundSubtractorPBAS::~BackgroundSubtractorPBAS() {}
 
+void BackgroundSubtractorPBAS::setRandomSeed(uint64_t nSeed) {
+    m_oRNG.seed(nSeed);
+}
+
 void BackgroundSubtractorPBAS::getBackgroundImage(cv::OutputArray backgroundImage) const {
     lvAssert(m_bInitialized);
     cv::Mat oAvgBGImg = cv::Mat::zeros(m_oImgSize,CV_32FC(m_voBGImg[0].channels()));
@@ -97,7 +101,7 @@ void BackgroundSubtractorPBAS_1ch::initialize(const cv::Mat& oInitImg) {
         for(int y=0; y<m_oImgSize.height; ++y) {
             for(int x=0; x<m_oImgSize.width; ++x) {
                 int x_sample,y_sample;
-                cv::getRandSamplePosition_7x7_std2(x_sample,y_sample,x,y,0,m_oImgSize);
+                cv::getRandSamplePosition_7x7_std2(x_sample,y_sample,x,y,0,m_oImgSize,m_oRNG);
                 m_voBGImg[s].at<uchar>(y,x) = oInitImg.at<uchar>(y_sample,x_sample);
                 m_voBGGrad[s].at<uchar>(y,x) = oBlurredInitImg_AbsGrad.at<uchar>(y_sample,x_sample);
             }
@@ -172,15 +176,15 @@ void BackgroundSubtractorPBAS_1ch::apply(cv::InputArray _image, cv::OutputArray
             }
             else {
                 const size_t nLearningRate = learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)ceil((*pfCurrLearningRate));
-                if((rand()%nLearningRate)==0) {
-                    const size_t s_rand = rand()%m_nBGSamples;
+                if((m_oRNG()%nLearningRate)==0) {
+                    const size_t s_rand = m_oRNG()%m_nBGSamples;
                     m_voBGImg[s_rand].data[idx_uchar] = oInputImg.data[idx_uchar];
                     m_voBGGrad[s_rand].data[idx_uchar] = oBlurredInputImg_AbsGrad.data[idx_uchar];
                 }
-                if((rand()%nLearningRate)==0) {
+                if((m_oRNG()%nLearningRate)==0) {
                     int x_rand,y_rand;
-                    cv::getRandNeighborPosition_3x3(x_rand,y_rand,x,y,0,m_oImgSize);
-                    const size_t s_rand = rand()%m_nBGSamples;
+                    cv::getRandNeighborPosition_3x3(x_rand,y_rand,x,y,0,m_oImgSize,m_oRNG);
+                    const size_t s_rand = m_oRNG()%m_nBGSamples;
 #if BGSPBAS_USE_SELF_DIFFUSION
                     m_voBGImg[s_rand].at<uchar>(y_rand,x_rand) = oInputImg.at<uchar>(y_rand,x_rand);
                     m_voBGGrad[s_rand].at<uchar>(y_rand,x_rand) = oBlurredInputImg_AbsGrad.at<uchar>(y_rand,x_rand);
@@ -247,7 +251,7 @@ void BackgroundSubtractorPBAS_1ch::apply(cv::InputArray _image, cv::OutputArray
 #endif //BGSPBAS_USE_ADVANCED_MORPH_OPS || BGSPBAS_USE_R2_ACCELERATION
 #if BGSPBAS_USE_ADVANCED_MORPH_OPS
     //cv::imshow("pure seg",oFGMask);
-    cv::medianBlur(oFGMask,oFGMask,3);
+    lv::binaryMedianBlur(oFGMask,oFGMask,3);
     //cv::imshow("median3",oFGMask);
     oFGMask.copyTo(m_oFloodedFGMask);
     cv::dilate(m_oFloodedFGMask,m_oFloodedFGMask,cv::Mat());
@@ -259,11 +263,11 @@ void BackgroundSubtractorPBAS_1ch::apply(cv::InputArray _image, cv::OutputArray
     //cv::imshow("median3 de3 fill region",m_oFloodedFGMask);
     cv::bitwise_or(m_oFloodedFGMask,m_oLastFGMask,oFGMask);
     //cv::imshow("median3 post-fill",oFGMask);
-    cv::medianBlur(oFGMask,oFGMask,9);
+    lv::binaryMedianBlur(oFGMask,oFGMask,9);
     //cv::imshow("median3 post-fill, +median9 ",oFGMask);
     //cv::waitKey(0);
 #else //(!BGSPBAS_USE_ADVANCED_MORPH_OPS)
-    cv::medianBlur(oFGMask,oFGMask,9);
+    lv::binaryMedianBlur(oFGMask,oFGMask,9);
 #endif //(!BGSPBAS_USE_ADVANCED_MORPH_OPS)
 }
 
@@ -316,7 +320,7 @@ void BackgroundSubtractorPBAS_3ch::initialize(const cv::Mat& oInitImg) {
         for(int y=0; y<m_oImgSize.height; ++y) {
             for(int x=0; x<m_oImgSize.width; ++x) {
                 int x_sample,y_sample;
-                cv::getRandSamplePosition_7x7_std2(x_sample,y_sample,x,y,0,m_oImgSize);
+                cv::getRandSamplePosition_7x7_std2(x_sample,y_sample,x,y,0,m_oImgSize,m_oRNG);
                 m_voBGImg[s].at<cv::Vec3b>(y,x) = oInitImgRGB.at<cv::Vec3b>(y_sample,x_sample);
                 m_voBGGrad[s].at<cv::Vec3b>(y,x) = oBlurredInitImg_AbsGrad.at<cv::Vec3b>(y_sample,x_sample);
             }
@@ -400,15 +404,15 @@ void BackgroundSubtractorPBAS_3ch::apply(cv::InputArray _image, cv::OutputArray
             }
             else {
                 const size_t nLearningRate = learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)ceil((*pfCurrLearningRate));
-                if((rand()%nLearningRate)==0) {
-                    const size_t s_rand = rand()%m_nBGSamples;
+                if((m_oRNG()%nLearningRate)==0) {
+                    const size_t s_rand = m_oRNG()%m_nBGSamples;
                     m_voBGImg[s_rand].at<cv::Vec3b>(y,x) = oInputImgRGB.at<cv::Vec3b>(y,x);
                     m_voBGGrad[s_rand].at<cv::Vec3b>(y,x) = oBlurredInputImg_AbsGrad.at<cv::Vec3b>(y,x);
                 }
-                if((rand()%nLearningRate)==0) {
+                if((m_oRNG()%nLearningRate)==0) {
                     int x_rand,y_rand;
-                    cv::getRandNeighborPosition_3x3(x_rand,y_rand,x,y,0,m_oImgSize);
-                    const size_t s_rand = rand()%m_nBGSamples;
+                    cv::getRandNeighborPosition_3x3(x_rand,y_rand,x,y,0,m_oImgSize,m_oRNG);
+                    const size_t s_rand = m_oRNG()%m_nBGSamples;
 #if BGSPBAS_USE_SELF_DIFFUSION
                     m_voBGImg[s_rand].at<cv::Vec3b>(y_rand,x_rand) = oInputImgRGB.at<cv::Vec3b>(y_rand,x_rand);
                     m_voBGGrad[s_rand].at<cv::Vec3b>(y_rand,x_rand) = oBlurredInputImg_AbsGrad.at<cv::Vec3b>(y_rand,x_rand);
@@ -475,7 +479,7 @@ void BackgroundSubtractorPBAS_3ch::apply(cv::InputArray _image, cv::OutputArray
 #endif //BGSPBAS_USE_ADVANCED_MORPH_OPS || BGSPBAS_USE_R2_ACCELERATION
 #if BGSPBAS_USE_ADVANCED_MORPH_OPS
     //cv::imshow("pure seg",oFGMask);
-    cv::medianBlur(oFGMask,oFGMask,3);
+    lv::binaryMedianBlur(oFGMask,oFGMask,3);
     //cv::imshow("median3",oFGMask);
     oFGMask.copyTo(m_oFloodedFGMask);
     cv::dilate(m_oFloodedFGMask,m_oFloodedFGMask,cv::Mat());
@@ -487,10 +491,427 @@ void BackgroundSubtractorPBAS_3ch::apply(cv::InputArray _image, cv::OutputArray
     //cv::imshow("median3 de3 fill region",m_oFloodedFGMask);
     cv::bitwise_or(m_oFloodedFGMask,m_oLastFGMask,oFGMask);
     //cv::imshow("median3 post-fill",oFGMask);
-    cv::medianBlur(oFGMask,oFGMask,9);
+    lv::binaryMedianBlur(oFGMask,oFGMask,9);
     //cv::imshow("median3 post-fill, +median9 ",oFGMask);
     //cv::waitKey(0);
 #else //(!BGSPBAS_USE_ADVANCED_MORPH_OPS)
-    cv::medianBlur(oFGMask,oFGMask,9);
+    lv::binaryMedianBlur(oFGMask,oFGMask,9);
 #endif //(!BGSPBAS_USE_ADVANCED_MORPH_OPS)
 }
+
+#if HAVE_GLSL
+
+BackgroundSubtractorPBAS_GLSL::BackgroundSubtractorPBAS_GLSL(size_t nInitColorDistThreshold, float fInitUpdateRate, size_t nBGSamples, size_t nRequiredBGSamples) :
+        IBackgroundSubtractor_GLSL(1,2+BGSPBAS_GLSL_USE_POSTPROC,5,0,0,0,-1,false,BGSPBAS_GLSL_USE_TIMERS,true),
+        m_nDefaultColorDistThreshold(nInitColorDistThreshold),
+        m_fDefaultUpdateRate(fInitUpdateRate),
+        m_nBGSamples(nBGSamples),
+        m_nRequiredBGSamples(nRequiredBGSamples),
+        m_nGradDistStatsSlotIdx(0) {
+    lvAssert_(m_nBGSamples>0 && m_nRequiredBGSamples<=m_nBGSamples,"algo cannot require more sample matches than sample count in model");
+    lvAssert_(m_nDefaultColorDistThreshold>0 && m_fDefaultUpdateRate>0.0f,"default distance threshold & update rate must be positive values");
+    glErrorCheck;
+}
+
+void BackgroundSubtractorPBAS_GLSL::refreshModel(float fSamplesRefreshFrac, bool bForceFGUpdate) {
+    lvDbgExceptionWatch;
+    // == refresh
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    lvAssert_(fSamplesRefreshFrac>0.0f && fSamplesRefreshFrac<=1.0f,"model refresh must be given as a non-null fraction");
+    const size_t nModelSamplesToRefresh = fSamplesRefreshFrac<1.0f?(size_t)(fSamplesRefreshFrac*m_nBGSamples):m_nBGSamples;
+    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?m_oRNG()%m_nBGSamples:0;
+    if(!bForceFGUpdate)
+        getLatestForegroundMask(m_oLastFGMask);
+    // gradients are computed the same way as in the gpu gradient stage (and in the CPU impls)
+    cv::Mat oBlurredImg;
+    cv::GaussianBlur(m_oLastColorFrame,oBlurredImg,cv::Size(3,3),0,0,cv::BORDER_DEFAULT);
+    cv::Mat oBlurredImg_GradX, oBlurredImg_GradY;
+    cv::Scharr(oBlurredImg,oBlurredImg_GradX,CV_16S,1,0,1,0,cv::BORDER_DEFAULT);
+    cv::Scharr(oBlurredImg,oBlurredImg_GradY,CV_16S,0,1,1,0,cv::BORDER_DEFAULT);
+    cv::Mat oBlurredImg_AbsGradX, oBlurredImg_AbsGradY;
+    cv::convertScaleAbs(oBlurredImg_GradX,oBlurredImg_AbsGradX);
+    cv::convertScaleAbs(oBlurredImg_GradY,oBlurredImg_AbsGradY);
+    cv::Mat oBlurredImg_AbsGrad;
+    cv::addWeighted(oBlurredImg_AbsGradX,0.5,oBlurredImg_AbsGradY,0.5,0,oBlurredImg_AbsGrad);
+    lvDbgAssert(oBlurredImg_AbsGrad.isContinuous() && oBlurredImg_AbsGrad.type()==m_oLastColorFrame.type());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(PBASStorageBuffer_BGModelBinding));
+    for(size_t nRowIdx=0; nRowIdx<(size_t)m_oImgSize.height; ++nRowIdx) {
+        const size_t nRowOffset = nRowIdx*m_oImgSize.width;
+        const size_t nModelRowOffset = nRowIdx*m_nRowStepSize;
+        for(size_t nColIdx=0; nColIdx<(size_t)m_oImgSize.width; ++nColIdx) {
+            const size_t nColOffset = nColIdx+nRowOffset;
+            const size_t nModelColOffset = nColIdx*m_nColStepSize+nModelRowOffset;
+            if(bForceFGUpdate || !m_oLastFGMask.data[nColOffset]) {
+                for(size_t nCurrModelSampleIdx=nRefreshSampleStartPos; nCurrModelSampleIdx<nRefreshSampleStartPos+nModelSamplesToRefresh; ++nCurrModelSampleIdx) {
+                    int nSampleRowIdx, nSampleColIdx;
+                    cv::getRandSamplePosition_7x7_std2(nSampleColIdx,nSampleRowIdx,(int)nColIdx,(int)nRowIdx,0,m_oImgSize,m_oRNG);
+                    const size_t nSamplePxIdx = nSampleColIdx + nSampleRowIdx*m_oImgSize.width;
+                    if(bForceFGUpdate || !m_oLastFGMask.data[nSamplePxIdx]) {
+                        const size_t nSampleOffset = nSamplePxIdx*m_nImgChannels;
+                        const size_t nModelPxOffset_color = (nCurrModelSampleIdx%m_nBGSamples)*m_nSampleStepSize+nModelColOffset;
+                        const size_t nModelPxOffset_grad = nModelPxOffset_color+(m_nBGSamples*m_nSampleStepSize);
+                        for(size_t nChannelIdx=0; nChannelIdx<m_nImgChannels; ++nChannelIdx) {
+                            // gpu-side samples are stored in rgb(a) order
+                            const size_t nSampleChannelIdx = (m_nImgChannels==1)?nChannelIdx:2-nChannelIdx;
+                            m_vnBGModelData[nModelPxOffset_color+nChannelIdx] = (uint)m_oLastColorFrame.data[nSampleOffset+nSampleChannelIdx];
+                            m_vnBGModelData[nModelPxOffset_grad+nChannelIdx] = (uint)oBlurredImg_AbsGrad.data[nSampleOffset+nSampleChannelIdx];
+                        }
+                    }
+                }
+            }
+        }
+    }
+    glBufferData(GL_SHADER_STORAGE_BUFFER,m_nBGModelSize*sizeof(uint),m_vnBGModelData.data(),GL_STATIC_COPY);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,PBASStorageBuffer_BGModelBinding,getSSBOId(PBASStorageBuffer_BGModelBinding));
+    glErrorCheck;
+}
+
+void BackgroundSubtractorPBAS_GLSL::initialize_gl(const cv::Mat& oInitImg, const cv::Mat& oROI) {
+    lvDbgExceptionWatch;
+    // == init
+    lvAssert_(oInitImg.type()==CV_8UC1 || oInitImg.type()==CV_8UC3,"algo only supports 8UC1 & 8UC3 images");
+    initialize_common(oInitImg,oROI);
+    m_nTMT32ModelSize = size_t(m_oROI.cols*m_oROI.rows);
+    // 3-channel inputs are expanded to rgba layers on the gpu (see GLImageProcAlgo's packed input mode), so samples are stored as uvec4s
+    m_nSampleStepSize = (m_nImgChannels==1)?1:4;
+    m_nPxModelSize = m_nSampleStepSize*m_nBGSamples*2;
+    m_nPxModelPadding = (m_nPxModelSize%4)?4-m_nPxModelSize%4:0;
+    m_nColStepSize = m_nPxModelSize+m_nPxModelPadding;
+    m_nRowStepSize = m_nColStepSize*m_oROI.cols;
+    m_nBGModelSize = m_nRowStepSize*m_oROI.rows;
+    // per-pixel states hold R(x), T(x), D(x) & padding
+    m_nPxStateSize = m_nTMT32ModelSize*4;
+    m_nGradFrameSize = m_nTMT32ModelSize*m_nSampleStepSize;
+    const int nMaxSSBOBlockSize = lv::gl::getIntegerVal<1>(GL_MAX_SHADER_STORAGE_BLOCK_SIZE);
+    lvAssert_(nMaxSSBOBlockSize>(int)(m_nBGModelSize*sizeof(uint)) && nMaxSSBOBlockSize>(int)(m_nTMT32ModelSize*sizeof(lv::gl::TMT32GenParams)),"max ssbo block size is tool small for the predicted model size");
+    m_vnBGModelData.resize(m_nBGModelSize,0);
+    m_vfPxStateData.resize(m_nPxStateSize);
+    for(size_t nPxIdx=0; nPxIdx<m_nTMT32ModelSize; ++nPxIdx) {
+        m_vfPxStateData[nPxIdx*4+0] = 1.0f;
+        m_vfPxStateData[nPxIdx*4+1] = m_fDefaultUpdateRate;
+        m_vfPxStateData[nPxIdx*4+2] = 0.0f;
+        m_vfPxStateData[nPxIdx*4+3] = 0.0f;
+    }
+    lv::gl::TMT32GenParams::initTinyMT32Generators(glm::uvec3(uint(m_oROI.cols),uint(m_oROI.rows),1),m_voTMT32ModelData);
+    m_nGradDistStatsSlotIdx = 0;
+    m_bInitialized = true;
+    GLImageProcAlgo::initialize_gl(oInitImg,m_oROI);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(PBASStorageBuffer_PxStateBinding));
+    glBufferData(GL_SHADER_STORAGE_BUFFER,m_nPxStateSize*sizeof(float),m_vfPxStateData.data(),GL_STATIC_COPY);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,PBASStorageBuffer_PxStateBinding,getSSBOId(PBASStorageBuffer_PxStateBinding));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(PBASStorageBuffer_GradFrameBinding));
+    glBufferData(GL_SHADER_STORAGE_BUFFER,m_nGradFrameSize*sizeof(uint),nullptr,GL_DYNAMIC_COPY);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,PBASStorageBuffer_GradFrameBinding,getSSBOId(PBASStorageBuffer_GradFrameBinding));
+    // three slots of {sum_lo,sum_hi,count,pad}: accumulated by the current frame, read by the current frame (last frame's), and cleared for the next frame
+    const std::array<uint,12> anGradDistStats = {};
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(PBASStorageBuffer_GradDistStatsBinding));
+    glBufferData(GL_SHADER_STORAGE_BUFFER,sizeof(anGradDistStats),anGradDistStats.data(),GL_DYNAMIC_COPY);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,PBASStorageBuffer_GradDistStatsBinding,getSSBOId(PBASStorageBuffer_GradDistStatsBinding));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(PBASStorageBuffer_TMT32ModelBinding));
+    glBufferData(GL_SHADER_STORAGE_BUFFER,m_nTMT32ModelSize*sizeof(lv::gl::TMT32GenParams),m_voTMT32ModelData.data(),GL_STATIC_COPY);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,PBASStorageBuffer_TMT32ModelBinding,getSSBOId(PBASStorageBuffer_TMT32ModelBinding));
+    refreshModel(1.0f,true);
+    m_bModelInitialized = true;
+}
+
+std::string BackgroundSubtractorPBAS_GLSL::getComputeShaderSource_Gradient() const {
+    lvDbgExceptionWatch;
+    const bool b3ch = (m_nImgChannels!=1);
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "#version 430\n"
+             "#define FRAME_WIDTH  " << m_oFrameSize.width << "\n"
+             "#define FRAME_HEIGHT " << m_oFrameSize.height << "\n"
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_InputBinding << ", " << (b3ch?"rgba8ui":"r8ui") << ") readonly uniform uimage2D mInput;\n"
+             "layout(binding=" << PBASStorageBuffer_GradFrameBinding << ", std430) writeonly buffer bGradFrame {\n"
+             "    " << (b3ch?"uvec4":"uint") << " anGradFrame[];\n"
+             "};\n"
+             "ivec2 reflect101(in ivec2 vCoords) {\n" // same as cv::BORDER_DEFAULT
+             "    const ivec2 vMaxCoords = ivec2(FRAME_WIDTH-1,FRAME_HEIGHT-1);\n"
+             "    return vMaxCoords-abs(vMaxCoords-abs(vCoords));\n"
+             "}\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "void main() {\n"
+             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    if(all(lessThan(vImgCoords,ivec2(FRAME_WIDTH,FRAME_HEIGHT)))) {\n"
+             "        ivec3 avPatch[5][5];\n"
+             "        for(int y=0; y<5; ++y)\n"
+             "            for(int x=0; x<5; ++x)\n"
+             "                avPatch[y][x] = ivec3(imageLoad(mInput,reflect101(vImgCoords+ivec2(x-2,y-2))).rgb);\n"
+             // 3x3 gaussian blur ([1 2 1]/4 separable kernel, rounded as in cv::GaussianBlur)
+             "        ivec3 avBlurred[3][3];\n"
+             "        for(int y=0; y<3; ++y) {\n"
+             "            for(int x=0; x<3; ++x) {\n"
+             "                ivec3 vRowSum0 = avPatch[y][x]+2*avPatch[y][x+1]+avPatch[y][x+2];\n"
+             "                ivec3 vRowSum1 = avPatch[y+1][x]+2*avPatch[y+1][x+1]+avPatch[y+1][x+2];\n"
+             "                ivec3 vRowSum2 = avPatch[y+2][x]+2*avPatch[y+2][x+1]+avPatch[y+2][x+2];\n"
+             "                avBlurred[y][x] = (vRowSum0+2*vRowSum1+vRowSum2+8)>>4;\n"
+             "            }\n"
+             "        }\n"
+             // scharr filters, then saturated abs values mixed with equal weights (as in the CPU impls)
+             "        ivec3 vGradX = 3*(avBlurred[0][2]-avBlurred[0][0])+10*(avBlurred[1][2]-avBlurred[1][0])+3*(avBlurred[2][2]-avBlurred[2][0]);\n"
+             "        ivec3 vGradY = 3*(avBlurred[2][0]-avBlurred[0][0])+10*(avBlurred[2][1]-avBlurred[0][1])+3*(avBlurred[2][2]-avBlurred[0][2]);\n"
+             "        ivec3 vAbsGradSum = min(abs(vGradX),ivec3(255))+min(abs(vGradY),ivec3(255));\n"
+             "        uvec3 vAbsGrad = uvec3(roundEven(vec3(vAbsGradSum)*0.5));\n"
+             "        anGradFrame[vImgCoords.y*FRAME_WIDTH+vImgCoords.x] = " << (b3ch?"uvec4(vAbsGrad,0)":"vAbsGrad.r") << ";\n"
+             "    }\n"
+             "}\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    return ssSrc.str();
+}
+
+std::string BackgroundSubtractorPBAS_GLSL::getComputeShaderSource_PBAS() const {
+    lvDbgExceptionWatch;
+    const bool b3ch = (m_nImgChannels!=1);
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "#version 430\n"
+             "#define COLOR_DIST_THRESHOLD " << std::to_string((float)m_nDefaultColorDistThreshold) << "\n"
+             "#define NB_SAMPLES           " << m_nBGSamples << "\n"
+             "#define NB_REQ_SAMPLES       " << m_nRequiredBGSamples << "\n"
+             "#define N_SAMPLES_FOR_MEAN   " << std::to_string((float)BGSPBAS_N_SAMPLES_FOR_MEAN) << "\n"
+             "#define GRAD_WEIGHT_ALPHA    " << std::to_string(BGSPBAS_GRAD_WEIGHT_ALPHA) << "\n"
+             "#define R_OFFST              " << std::to_string(BGSPBAS_R_OFFST) << "\n"
+             "#define R_SCALE              " << std::to_string(BGSPBAS_R_SCALE) << "\n"
+             "#define R_INCR               " << std::to_string(BGSPBAS_R_INCR) << "\n"
+             "#define R_DECR               " << std::to_string(BGSPBAS_R_DECR) << "\n"
+             "#define R_LOWER              " << std::to_string(BGSPBAS_R_LOWER) << "\n"
+             "#define R_UPPER              " << std::to_string(BGSPBAS_R_UPPER) << "\n"
+             "#define T_OFFST              " << std::to_string(BGSPBAS_T_OFFST) << "\n"
+             "#define T_SCALE              " << std::to_string(BGSPBAS_T_SCALE) << "\n"
+             "#define T_DECR               " << std::to_string(BGSPBAS_T_DECR) << "\n"
+             "#define T_INCR               " << std::to_string(BGSPBAS_T_INCR) << "\n"
+             "#define T_LOWER              " << std::to_string(BGSPBAS_T_LOWER) << "\n"
+             "#define T_UPPER              " << std::to_string(BGSPBAS_T_UPPER) << "\n"
+             "#define MODEL_STEP_SIZE      " << m_oFrameSize.width << "\n"
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_ROIBinding << ", r8ui) readonly uniform uimage2D mROI;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_InputBinding << ", " << (b3ch?"rgba8ui":"r8ui") << ") readonly uniform uimage2D mInput;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_OutputBinding << ", r8ui) writeonly uniform uimage2D mOutput;\n" <<
+             (b3ch?std::string():lv::getShaderFunctionSource_absdiff(true)) <<
+             GLShader::getShaderFunctionSource_urand_tinymt32() <<
+             GLShader::getShaderFunctionSource_getRandNeighbor3x3(0,m_oFrameSize) <<
+             "struct PxModel {\n"
+             "    " << (b3ch?"uvec4":"uint") << " color_samples[" << m_nBGSamples << "];\n"
+             "    " << (b3ch?"uvec4":"uint") << " grad_samples[" << m_nBGSamples << "];\n";
+    if(m_nPxModelPadding>0) ssSrc <<
+             "    uint pad[" << m_nPxModelPadding << "];\n";
+    ssSrc << "};\n"
+             "struct PxState {\n"
+             "    float fDistThreshold;\n" // R(x)
+             "    float fUpdateRate;\n" // T(x)
+             "    float fMeanMinDist;\n" // D(x)
+             "    float fPad;\n"
+             "};\n"
+             "struct GradDistStats {\n"
+             "    uint nSumLo;\n"
+             "    uint nSumHi;\n"
+             "    uint nCount;\n"
+             "    uint nPad;\n"
+             "};\n"
+             "layout(binding=" << PBASStorageBuffer_BGModelBinding << ", std430) coherent buffer bBGModel {\n"
+             "    PxModel aoPxModels[];\n"
+             "};\n"
+             "layout(binding=" << PBASStorageBuffer_PxStateBinding << ", std430) buffer bPxStates {\n"
+             "    PxState aoPxStates[];\n"
+             "};\n"
+             "layout(binding=" << PBASStorageBuffer_GradFrameBinding << ", std430) readonly buffer bGradFrame {\n"
+             "    " << (b3ch?"uvec4":"uint") << " anGradFrame[];\n"
+             "};\n"
+             "layout(binding=" << PBASStorageBuffer_GradDistStatsBinding << ", std430) coherent buffer bGradDistStats {\n"
+             "    GradDistStats aoGradDistStats[3];\n"
+             "};\n"
+             "layout(binding=" << PBASStorageBuffer_TMT32ModelBinding << ", std430) buffer bTMT32Model {\n"
+             "    TMT32Model aoTMT32Models[];\n"
+             "};\n"
+             "#define urand() urand(aoTMT32Models[nModelIdx])\n"
+             "uniform uint nLearningRateOverride;\n" // 0 = use T(x)
+             "uniform uint nGradDistStatsSlotIdx;\n"
+             "shared uint nGroupGradDistSum;\n"
+             "shared uint nGroupBadSamplesCount;\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "void main() {\n"
+             "    if(gl_LocalInvocationIndex==0) {\n"
+             "        nGroupGradDistSum = 0;\n"
+             "        nGroupBadSamplesCount = 0;\n"
+             "    }\n"
+             "    memoryBarrierShared();\n"
+             "    barrier();\n"
+             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    uvec4 vSegmResult = uvec4(0);\n"
+             "    uint nROIVal = imageLoad(mROI,vImgCoords).r;\n"
+             "    uint nModelIdx = gl_GlobalInvocationID.y*MODEL_STEP_SIZE + gl_GlobalInvocationID.x;\n"
+             "    uint nFrameGradDistSum=0, nFrameBadSamplesCount=0;\n"
+             "    if(bool(nROIVal)) {\n"
+             "        GradDistStats oLastStats = aoGradDistStats[(nGradDistStatsSlotIdx+2)%3];\n"
+             "        float fFormerMeanGradDist = max((float(oLastStats.nSumHi)*4294967296.0+float(oLastStats.nSumLo))/float(oLastStats.nCount+1),20.0);\n"
+             "        float fGradDistWeight = GRAD_WEIGHT_ALPHA/fFormerMeanGradDist;\n"
+             "        uvec3 vInputColor = imageLoad(mInput,vImgCoords).rgb;\n"
+             "        uvec3 vInputGrad = " << (b3ch?"anGradFrame[nModelIdx].rgb":"uvec3(anGradFrame[nModelIdx])") << ";\n"
+             "        PxState oState = aoPxStates[nModelIdx];\n"
+             "        float fCurrDistThreshold = oState.fDistThreshold*COLOR_DIST_THRESHOLD;\n"
+             "        float fMinDist = 255.0;\n"
+             "        uint nGoodSamplesCount=0, nSampleIdx=0;\n"
+             "        while(nSampleIdx<NB_SAMPLES) {\n";
+    if(b3ch) ssSrc <<
+             "            float fColorDist = distance(vec3(vInputColor),vec3(aoPxModels[nModelIdx].color_samples[nSampleIdx].rgb));\n"
+             "            float fGradDist = distance(vec3(vInputGrad),vec3(aoPxModels[nModelIdx].grad_samples[nSampleIdx].rgb));\n";
+    else ssSrc <<
+             "            float fColorDist = float(absdiff(vInputColor.r,aoPxModels[nModelIdx].color_samples[nSampleIdx]));\n"
+             "            float fGradDist = float(absdiff(vInputGrad.r,aoPxModels[nModelIdx].grad_samples[nSampleIdx]));\n";
+    ssSrc << "            float fSumDist = min(fGradDistWeight*fGradDist+fColorDist,255.0);\n"
+             "            if(fSumDist<=fCurrDistThreshold) {\n"
+             "                fMinDist = min(fMinDist,fSumDist);\n"
+             "                ++nGoodSamplesCount;\n"
+             "            }\n"
+             "            else {\n"
+             "                nFrameGradDistSum += uint(round(fGradDist));\n"
+             "                ++nFrameBadSamplesCount;\n"
+             "            }\n"
+             "            ++nSampleIdx;\n"
+             "            if(nGoodSamplesCount>=NB_REQ_SAMPLES)\n"
+             "                break;\n"
+             "        }\n"
+             "        oState.fMeanMinDist = (oState.fMeanMinDist*(N_SAMPLES_FOR_MEAN-1.0)+(fMinDist/255.0))/N_SAMPLES_FOR_MEAN;\n"
+             "        if(nGoodSamplesCount<NB_REQ_SAMPLES) {\n"
+             "            vSegmResult.r = 255;\n"
+             "            oState.fUpdateRate = min(oState.fUpdateRate+T_INCR/(oState.fMeanMinDist*T_SCALE+T_OFFST),T_UPPER);\n"
+             "        }\n"
+             "        else {\n"
+             "            uint nLearningRate = (nLearningRateOverride>0)?nLearningRateOverride:uint(ceil(oState.fUpdateRate));\n"
+             "            if((urand()%nLearningRate)==0) {\n"
+             "                uint nRandSampleIdx = urand()%NB_SAMPLES;\n"
+             "                aoPxModels[nModelIdx].color_samples[nRandSampleIdx] = " << (b3ch?"uvec4(vInputColor,0);\n":"vInputColor.r;\n") <<
+             "                aoPxModels[nModelIdx].grad_samples[nRandSampleIdx] = " << (b3ch?"uvec4(vInputGrad,0);\n":"vInputGrad.r;\n") <<
+             "                memoryBarrier();\n"
+             "            }\n"
+             "            if((urand()%nLearningRate)==0) {\n"
+             "                ivec2 vNeighbCoords = getRandNeighbor3x3(vImgCoords,urand());\n"
+             "                uint nNeighbPxModelIdx = uint(vNeighbCoords.y)*MODEL_STEP_SIZE + uint(vNeighbCoords.x);\n"
+             "                uint nRandSampleIdx = urand()%NB_SAMPLES;\n";
+#if BGSPBAS_USE_SELF_DIFFUSION
+    ssSrc << "                aoPxModels[nNeighbPxModelIdx].color_samples[nRandSampleIdx] = " << (b3ch?"uvec4(imageLoad(mInput,vNeighbCoords).rgb,0);\n":"imageLoad(mInput,vNeighbCoords).r;\n") <<
+             "                aoPxModels[nNeighbPxModelIdx].grad_samples[nRandSampleIdx] = anGradFrame[nNeighbPxModelIdx];\n";
+#else //(!BGSPBAS_USE_SELF_DIFFUSION)
+    ssSrc << "                aoPxModels[nNeighbPxModelIdx].color_samples[nRandSampleIdx] = " << (b3ch?"uvec4(vInputColor,0);\n":"vInputColor.r;\n") <<
+             "                aoPxModels[nNeighbPxModelIdx].grad_samples[nRandSampleIdx] = " << (b3ch?"uvec4(vInputGrad,0);\n":"vInputGrad.r;\n");
+#endif //(!BGSPBAS_USE_SELF_DIFFUSION)
+    ssSrc << "                memoryBarrier();\n"
+             "            }\n"
+             "            oState.fUpdateRate = max(oState.fUpdateRate-T_DECR/(oState.fMeanMinDist*T_SCALE+T_OFFST),T_LOWER);\n"
+             "        }\n"
+             "        if(oState.fDistThreshold<R_LOWER+oState.fMeanMinDist*R_SCALE+R_OFFST) {\n"
+             "            if(oState.fDistThreshold<R_UPPER)\n"
+             "                oState.fDistThreshold *= R_INCR;\n"
+             "        }\n"
+             "        else if(oState.fDistThreshold>R_LOWER)\n"
+             "            oState.fDistThreshold *= R_DECR;\n"
+             "        aoPxStates[nModelIdx] = oState;\n"
+             "    }\n"
+             // gradient distances of non-matching samples are summed per work group first, then added to the 64-bit frame total
+             "    if(nFrameBadSamplesCount>0) {\n"
+             "        atomicAdd(nGroupGradDistSum,nFrameGradDistSum);\n"
+             "        atomicAdd(nGroupBadSamplesCount,nFrameBadSamplesCount);\n"
+             "    }\n"
+             "    memoryBarrierShared();\n"
+             "    barrier();\n"
+             "    if(gl_LocalInvocationIndex==0) {\n"
+             "        if(nGroupBadSamplesCount>0) {\n"
+             "            uint nPrevSumLo = atomicAdd(aoGradDistStats[nGradDistStatsSlotIdx].nSumLo,nGroupGradDistSum);\n"
+             "            if(nPrevSumLo>0xFFFFFFFFu-nGroupGradDistSum)\n"
+             "                atomicAdd(aoGradDistStats[nGradDistStatsSlotIdx].nSumHi,1u);\n"
+             "            atomicAdd(aoGradDistStats[nGradDistStatsSlotIdx].nCount,nGroupBadSamplesCount);\n"
+             "        }\n"
+             "        if(gl_WorkGroupID.xy==uvec2(0))\n"
+             "            aoGradDistStats[(nGradDistStatsSlotIdx+1)%3] = GradDistStats(0u,0u,0u,0u);\n"
+             "    }\n"
+             "    imageStore(mOutput,vImgCoords,vSegmResult);\n"
+             "}\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    return ssSrc.str();
+}
+
+std::string BackgroundSubtractorPBAS_GLSL::getComputeShaderSource_PostProc() const {
+    lvDbgExceptionWatch;
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "#version 430\n"
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_OutputBinding << ", r8ui) uniform uimage2D mOutput;\n" <<
+             GLShader::getComputeShaderFunctionSource_BinaryMedianBlur(9,BGSPBAS_GLSL_USE_SHAREDMEM,m_vDefaultWorkGroupSize);
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "void main() {\n"
+             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n";
+#if BGSPBAS_GLSL_USE_SHAREDMEM
+    ssSrc << "    preload_data(mOutput);\n"
+             "    barrier();\n"
+             "    uint nFinalSegmRes = BinaryMedianBlur(vImgCoords);\n";
+#else //(!BGSPBAS_GLSL_USE_SHAREDMEM)
+    ssSrc << "    uint nFinalSegmRes = BinaryMedianBlur(mOutput,vImgCoords);\n"
+             "    barrier();\n";
+#endif //(!BGSPBAS_GLSL_USE_SHAREDMEM)
+    ssSrc << "    imageStore(mOutput,vImgCoords,uvec4(nFinalSegmRes));\n"
+             "}\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    return ssSrc.str();
+}
+
+std::string BackgroundSubtractorPBAS_GLSL::getComputeShaderSource(size_t nStage) const {
+    lvDbgExceptionWatch;
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    lvAssert_(nStage<m_nComputeStages,"required compute stage does not exist");
+    if(nStage==0)
+        return getComputeShaderSource_Gradient();
+    else if(nStage==1)
+        return getComputeShaderSource_PBAS();
+    else //nStage==2 && BGSPBAS_GLSL_USE_POSTPROC
+        return getComputeShaderSource_PostProc();
+}
+
+void BackgroundSubtractorPBAS_GLSL::dispatch(size_t nStage, GLShader& oShader) {
+    lvDbgExceptionWatch;
+    lvAssert_(nStage<m_nComputeStages,"required compute stage does not exist");
+    if(nStage==0) // the gradient frame is overwritten, so the last frame's reads must be done
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    else if(nStage==1) {
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        oShader.setUniform1ui("nLearningRateOverride",(m_dCurrLearningRate>0)?(GLuint)std::min(ceil(m_dCurrLearningRate),(double)UINT_MAX):0u);
+        oShader.setUniform1ui("nGradDistStatsSlotIdx",(GLuint)m_nGradDistStatsSlotIdx);
+        m_nGradDistStatsSlotIdx = (m_nGradDistStatsSlotIdx+1)%3;
+    }
+    else //nStage==2 && BGSPBAS_GLSL_USE_POSTPROC
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    glDispatchCompute((GLuint)ceil((float)m_oFrameSize.width/m_vDefaultWorkGroupSize.x),(GLuint)ceil((float)m_oFrameSize.height/m_vDefaultWorkGroupSize.y),1);
+}
+
+void BackgroundSubtractorPBAS_GLSL::getBackgroundImage(cv::OutputArray oBGImg) const {
+    lvDbgExceptionWatch;
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    lvAssert_(m_bGLInitialized && !m_vnBGModelData.empty(),"algo gpu bg model not initialized");
+    oBGImg.create(m_oImgSize,CV_8UC(int(m_nImgChannels)));
+    cv::Mat oOutputImg = oBGImg.getMatRef();
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(PBASStorageBuffer_BGModelBinding));
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER,0,m_nBGModelSize*sizeof(uint),(void*)m_vnBGModelData.data());
+    glErrorCheck;
+    for(size_t nRowIdx=0; nRowIdx<(size_t)m_oImgSize.height; ++nRowIdx) {
+        const size_t nModelRowOffset = nRowIdx*m_nRowStepSize;
+        const size_t nImgRowOffset = nRowIdx*oOutputImg.step.p[0];
+        for(size_t nColIdx=0; nColIdx<(size_t)m_oImgSize.width; ++nColIdx) {
+            const size_t nModelColOffset = nColIdx*m_nColStepSize+nModelRowOffset;
+            const size_t nImgColOffset = nColIdx*oOutputImg.step.p[1]+nImgRowOffset;
+            std::array<float,3> afCurrPxSum = {0.0f,0.0f,0.0f};
+            for(size_t nSampleIdx=0; nSampleIdx<m_nBGSamples; ++nSampleIdx) {
+                const size_t nModelPxOffset = nSampleIdx*m_nSampleStepSize+nModelColOffset;
+                for(size_t nChannelIdx=0; nChannelIdx<m_nImgChannels; ++nChannelIdx)
+                    afCurrPxSum[nChannelIdx] += m_vnBGModelData[nChannelIdx+nModelPxOffset];
+            }
+            for(size_t nChannelIdx=0; nChannelIdx<m_nImgChannels; ++nChannelIdx) {
+                const size_t nSampleChannelIdx = (m_nImgChannels==1)?nChannelIdx:2-nChannelIdx;
+                oOutputImg.data[nSampleChannelIdx+nImgColOffset] = (uchar)(afCurrPxSum[nChannelIdx]/m_nBGSamples);
+            }
+        }
+    }
+}
+
+#endif //HAVE_GLSL
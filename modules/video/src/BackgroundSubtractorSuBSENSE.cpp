@@ -53,12 +53,859 @@
 #define STAB_COLOR_DIST_OFFSET (m_nMinColorDistThreshold/5)
 // local define used to specify the desc dist threshold offset used for unstable regions
 #define UNSTAB_DESC_DIST_OFFSET (m_nDescDistThresholdOffset)
+// local define used to specify the minimum row band height for multi-threaded processing (must be >4 for 5x5 neighbor spread)
+#define MIN_BAND_ROWS (8)
+// local define used to specify the number of row bands created per thread for multi-threaded processing (for load balancing)
+#define BANDS_PER_THREAD (4)
+// local define used to specify the number of per-pixel state maps which can be stored in compact format
+#define STATE_MAP_COUNT (10)
+// local define used to specify the post-processing region padding (on top of the median blur radius) used in ROI-compacted mode
+#define POSTPROC_RECT_MARGIN (8)
+// defines the downsampling ratio of the fine pyramid level used for global motion estimation (the coarse one is the frame-level analysis size)
+#define GMC_FINE_DOWNSAMPLE_RATIO (2)
+// defines the minimal phase correlation response for a global motion estimate to be considered reliable
+#define GMC_MIN_PHASECORR_RESPONSE (0.050)
+// defines the maximal global motion estimate (relative to frame size) that is compensated by warping the model (larger ones are left to model resets)
+#define GMC_MAX_SHIFT_RATIO (0.25)
+
+// local indices of per-pixel state maps (same order as in getStateMaps)
+enum StateMapIdx {
+    STATE_UPDATE_RATE,
+    STATE_DIST_THRESHOLD,
+    STATE_VARIATION_MODULATOR,
+    STATE_MEAN_LAST_DIST,
+    STATE_MEAN_MIN_DIST_LT,
+    STATE_MEAN_MIN_DIST_ST,
+    STATE_MEAN_RAW_SEGM_RES_LT,
+    STATE_MEAN_RAW_SEGM_RES_ST,
+    STATE_MEAN_FINAL_SEGM_RES_LT,
+    STATE_MEAN_FINAL_SEGM_RES_ST,
+};
+// fixed-point scales of per-pixel state maps in compact format (T in [1,512), R in [1,64), v in [0.1,256), moving averages in [0,1])
+static const float s_afCompactStateScales[STATE_MAP_COUNT] = {128.0f,1024.0f,256.0f,65536.0f,65536.0f,65536.0f,65536.0f,65536.0f,65536.0f,65536.0f};
+
+// returns the multiplier used to convert real state values to the storage format of the given map (1 for float maps)
+static inline float getStateMapScale(const cv::Mat& oMap, size_t nStateIdx) {
+    return (oMap.depth()==CV_16U)?s_afCompactStateScales[nStateIdx]:1.0f;
+}
+
+// reads a real state value from the given map at the given pixel index, regardless of its storage format
+static inline float getStateValue(const cv::Mat& oMap, size_t nStateIdx, size_t nPxIdx) {
+    return (oMap.depth()==CV_16U)?((const ushort*)oMap.data)[nPxIdx]/s_afCompactStateScales[nStateIdx]:((const float*)oMap.data)[nPxIdx];
+}
+
+// (re)allocates a state map in the given storage format, and fills it with the given real value
+static inline void createStateMap(cv::Mat& oMap, size_t nStateIdx, const cv::Size& oSize, bool bCompact, float fInitVal) {
+    oMap.create(oSize,bCompact?CV_16UC1:CV_32FC1);
+    oMap = cv::Scalar(fInitVal*getStateMapScale(oMap,nStateIdx));
+}
 
 static const size_t s_nColorMaxDataRange_1ch = UCHAR_MAX;
 static const size_t s_nDescMaxDataRange_1ch = LBSP::DESC_SIZE_BITS;
 static const size_t s_nColorMaxDataRange_3ch = s_nColorMaxDataRange_1ch*3;
 static const size_t s_nDescMaxDataRange_3ch = s_nDescMaxDataRange_1ch*3;
 
+#if HAVE_GLSL
+
+// local bit flags stored in the per-pixel state of the GLSL impl
+enum PxStateFlag {
+    PXSTATE_FLAG_UNSTABLE = 1,
+    PXSTATE_FLAG_CURR_RAW = 2,
+    PXSTATE_FLAG_LAST_RAW = 4,
+    PXSTATE_FLAG_LAST_RAW_BLINK = 8,
+    PXSTATE_FLAG_BLINK = 16,
+    PXSTATE_FLAG_LAST_FINAL = 32,
+    PXSTATE_FLAG_LAST_FINAL_DILATED = 64,
+};
+
+// local bit flags stored in the hole filling mask of the GLSL impl (each stage only adds its own bit to its own pixel)
+enum HoleFillFlag {
+    HOLEFILL_FLAG_RAW = 1,
+    HOLEFILL_FLAG_DILATED = 2,
+    HOLEFILL_FLAG_CLOSED = 4,
+    HOLEFILL_FLAG_FLOODED = 8,
+};
+
+// local define used to specify the work group size of the GLSL flood fill sweeps (one invocation per row/column)
+#define HOLEFILL_SWEEP_WORKGROUP_SIZE (64)
+
+// returns a float value formatted as a GLSL float literal (always with a decimal point)
+static inline std::string getShaderFloatLiteral(float fVal) {
+    return std::to_string(fVal);
+}
+
+// returns the GLSL source for the per-pixel state struct, flags & buffer shared by all stages
+static std::string getShaderSource_PxState(GLuint nBinding) {
+    std::stringstream ssSrc;
+    ssSrc << "#define FLAG_UNSTABLE           " << PXSTATE_FLAG_UNSTABLE << "u\n"
+             "#define FLAG_CURR_RAW           " << PXSTATE_FLAG_CURR_RAW << "u\n"
+             "#define FLAG_LAST_RAW           " << PXSTATE_FLAG_LAST_RAW << "u\n"
+             "#define FLAG_LAST_RAW_BLINK     " << PXSTATE_FLAG_LAST_RAW_BLINK << "u\n"
+             "#define FLAG_BLINK              " << PXSTATE_FLAG_BLINK << "u\n"
+             "#define FLAG_LAST_FINAL         " << PXSTATE_FLAG_LAST_FINAL << "u\n"
+             "#define FLAG_LAST_FINAL_DILATED " << PXSTATE_FLAG_LAST_FINAL_DILATED << "u\n"
+             "struct PxState {\n"
+             "    float fLearningRate, fDistThresholdFactor, fVariationFactor, fMeanLastDist;\n"
+             "    float fMeanMinDist_LT, fMeanMinDist_ST, fMeanRawSegmRes_LT, fMeanRawSegmRes_ST;\n"
+             "    float fMeanFinalSegmRes_LT, fMeanFinalSegmRes_ST;\n"
+             "    uint nLastColor, anLastIntraDesc[2], nFlags;\n"
+             "};\n"
+             "layout(binding=" << nBinding << ", std430) coherent buffer bPxState {\n"
+             "    PxState aoPxStates[];\n"
+             "};\n";
+    return ssSrc.str();
+}
+
+BackgroundSubtractorSuBSENSE_GLSL::BackgroundSubtractorSuBSENSE_(size_t nDescDistThresholdOffset, size_t nMinColorDistThreshold, size_t nBGSamples,
+                                                                 size_t nRequiredBGSamples, size_t nSamplesForMovingAvgs, float fRelLBSPThreshold) :
+        IBackgroundSubtractorLBSP_GLSL(1,nSuBSENSEStagesCount,4,1,1,0,BGSSUBSENSE_GLSL_USE_DEBUG?CV_8UC4:-1,BGSSUBSENSE_GLSL_USE_DEBUG,BGSSUBSENSE_GLSL_USE_TIMERS,true,fRelLBSPThreshold),
+        m_nMinColorDistThreshold(nMinColorDistThreshold),
+        m_nDescDistThresholdOffset(nDescDistThresholdOffset),
+        m_nBGSamples(nBGSamples),
+        m_nRequiredBGSamples(nRequiredBGSamples),
+        m_nSamplesForMovingAvgs(nSamplesForMovingAvgs),
+        m_fCurrLearningRateLowerCap(FEEDBACK_T_LOWER),
+        m_fCurrLearningRateUpperCap(FEEDBACK_T_UPPER),
+        m_nMedianBlurKernelSize(m_nDefaultMedianBlurKernelSize),
+        m_bUse3x3Spread(true),
+        m_bLearningRateScalingEnabled(false),
+        m_fLastNonZeroDescRatio(0.0f),
+        m_nPendingResetSampleCount(0) {
+    lvAssert_(m_nBGSamples>0 && m_nRequiredBGSamples>0 && m_nRequiredBGSamples<=m_nBGSamples,"algo cannot require more sample matches than sample count in model");
+    lvAssert_(m_nMinColorDistThreshold>0 || m_nDescDistThresholdOffset>0,"distance thresholds must be positive values");
+    lvAssert_(m_nSamplesForMovingAvgs>=4,"moving averages need at least four samples");
+    static_assert(nSuBSENSEStorageBufferBindingsCount-GLImageProcAlgo::nStorageBufferDefaultBindingsCount==4,"extra ssbo count must match the binding list");
+    static_assert(nSuBSENSEAtomicCounterBufferBindingsCount-GLImageProcAlgo::nAtomicCounterBufferDefaultBindingsCount==1,"extra acbo count must match the binding list");
+    static_assert(nSuBSENSEImageBindingsCount-GLImageProcAlgo::nImageDefaultBindingsCount==1,"extra image count must match the binding list");
+    static_assert(sizeof(PxState)==sizeof(uint)*14,"px state struct layout must match its std430 glsl counterpart");
+    glErrorCheck;
+}
+
+void BackgroundSubtractorSuBSENSE_GLSL::refreshModel(float fSamplesRefreshFrac, bool bForceFGUpdate) {
+    lvDbgExceptionWatch;
+    // == refresh
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    lvAssert_(fSamplesRefreshFrac>0.0f && fSamplesRefreshFrac<=1.0f,"model refresh must be given as a non-null fraction");
+    const size_t nModelSamplesToRefresh = fSamplesRefreshFrac<1.0f?(size_t)(fSamplesRefreshFrac*m_nBGSamples):m_nBGSamples;
+    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?m_oRNG()%m_nBGSamples:0;
+    if(!bForceFGUpdate)
+        getLatestForegroundMask(m_oLastFGMask);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_BGModelBinding));
+    // partial refreshes must not revert the samples updated on the gpu since the last upload
+    if(m_bModelInitialized)
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER,0,m_nBGModelSize*sizeof(uint),(void*)m_vnBGModelData.data());
+    for(size_t nRowIdx=0; nRowIdx<(size_t)m_oFrameSize.height; ++nRowIdx) {
+        const size_t nRowOffset = nRowIdx*m_oFrameSize.width;
+        const size_t nModelRowOffset = nRowIdx*m_nRowStepSize;
+        for(size_t nColIdx=0; nColIdx<(size_t)m_oFrameSize.width; ++nColIdx) {
+            const size_t nColOffset = nColIdx+nRowOffset;
+            const size_t nModelColOffset = nColIdx*m_nColStepSize+nModelRowOffset;
+            if(bForceFGUpdate || !m_oLastFGMask.data[nColOffset]) {
+                for(size_t nCurrModelSampleIdx=nRefreshSampleStartPos; nCurrModelSampleIdx<nRefreshSampleStartPos+nModelSamplesToRefresh; ++nCurrModelSampleIdx) {
+                    int nSampleRowIdx, nSampleColIdx;
+                    cv::getRandSamplePosition_7x7_std2(nSampleColIdx,nSampleRowIdx,(int)nColIdx,(int)nRowIdx,(int)LBSP::PATCH_SIZE/2,m_oFrameSize,m_oRNG);
+                    const size_t nSamplePxIdx = nSampleColIdx + nSampleRowIdx*m_oFrameSize.width;
+                    if(bForceFGUpdate || !m_oLastFGMask.data[nSamplePxIdx]) {
+                        const size_t nCurrRealModelSampleIdx = nCurrModelSampleIdx%m_nBGSamples;
+                        const size_t nSampleOffset_color = nSampleColIdx*m_oLastColorFrame.step.p[1]+(nSampleRowIdx*m_oLastColorFrame.step.p[0]);
+                        const size_t nSampleOffset_desc = nSampleColIdx*m_oLastDescFrame.step.p[1]+(nSampleRowIdx*m_oLastDescFrame.step.p[0]);
+                        const size_t nModelPxOffset_color = nCurrRealModelSampleIdx*m_nSampleStepSize+nModelColOffset;
+                        const size_t nModelPxOffset_desc = nModelPxOffset_color+(m_nBGSamples*m_nSampleStepSize);
+                        for(size_t nChannelIdx=0; nChannelIdx<m_nImgChannels; ++nChannelIdx) {
+                            const size_t nSampleChannelIdx = ((nChannelIdx==3||m_nImgChannels==1)?nChannelIdx:2-nChannelIdx);
+                            const size_t nSampleTotOffset_color = nSampleOffset_color+nSampleChannelIdx;
+                            const size_t nSampleTotOffset_desc = nSampleOffset_desc+(nSampleChannelIdx*2);
+                            m_vnBGModelData[nChannelIdx+nModelPxOffset_color] = (uint)m_oLastColorFrame.data[nSampleTotOffset_color];
+                            // last desc frame is not kept up to date by the gpu pipeline, recompute the sample descriptor on the fly
+                            if(m_nImgChannels==1)
+                                LBSP::computeDescriptor<1>(m_oLastColorFrame,m_oLastColorFrame.data[nSampleTotOffset_color],nSampleColIdx,nSampleRowIdx,0,m_anLBSPThreshold_8bitLUT[m_oLastColorFrame.data[nSampleTotOffset_color]],*((ushort*)(m_oLastDescFrame.data+nSampleTotOffset_desc)));
+                            else if(m_nImgChannels==3)
+                                LBSP::computeDescriptor<3>(m_oLastColorFrame,m_oLastColorFrame.data[nSampleTotOffset_color],nSampleColIdx,nSampleRowIdx,nChannelIdx,m_anLBSPThreshold_8bitLUT[m_oLastColorFrame.data[nSampleTotOffset_color]],*((ushort*)(m_oLastDescFrame.data+nSampleTotOffset_desc)));
+                            else //m_nImgChannels==4
+                                LBSP::computeDescriptor<4>(m_oLastColorFrame,m_oLastColorFrame.data[nSampleTotOffset_color],nSampleColIdx,nSampleRowIdx,nChannelIdx,m_anLBSPThreshold_8bitLUT[m_oLastColorFrame.data[nSampleTotOffset_color]],*((ushort*)(m_oLastDescFrame.data+nSampleTotOffset_desc)));
+                            m_vnBGModelData[nChannelIdx+nModelPxOffset_desc] = (uint)*(ushort*)(m_oLastDescFrame.data+nSampleTotOffset_desc);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    glBufferData(GL_SHADER_STORAGE_BUFFER,m_nBGModelSize*sizeof(uint),m_vnBGModelData.data(),GL_STATIC_COPY);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_BGModelBinding,getSSBOId(BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_BGModelBinding));
+    glErrorCheck;
+}
+
+void BackgroundSubtractorSuBSENSE_GLSL::initialize_gl(const cv::Mat& oInitImg, const cv::Mat& oROI) {
+    lvDbgExceptionWatch;
+    // == init
+    lvAssert_(oInitImg.depth()==CV_8U,"GLSL impl only supports 8-bit inputs");
+    initialize_common(oInitImg,oROI);
+    m_fLastNonZeroDescRatio = 0.0f;
+    m_nPendingResetSampleCount = 0;
+    const int nTotImgPixels = m_oImgSize.height*m_oImgSize.width;
+    if(m_nOrigROIPxCount>=m_nTotPxCount/2 && (int)m_nTotPxCount>=DEFAULT_FRAME_SIZE.area()) {
+        m_bLearningRateScalingEnabled = true;
+        m_bAutoModelResetEnabled = true;
+        m_bUse3x3Spread = !(nTotImgPixels>DEFAULT_FRAME_SIZE.area()*2);
+        const int nRawMedianBlurKernelSize = std::min((int)floor((float)nTotImgPixels/DEFAULT_FRAME_SIZE.area()+0.5f)+m_nDefaultMedianBlurKernelSize,14);
+        m_nMedianBlurKernelSize = (nRawMedianBlurKernelSize%2)?nRawMedianBlurKernelSize:nRawMedianBlurKernelSize-1;
+        m_fCurrLearningRateLowerCap = FEEDBACK_T_LOWER;
+        m_fCurrLearningRateUpperCap = FEEDBACK_T_UPPER;
+    }
+    else {
+        m_bLearningRateScalingEnabled = false;
+        m_bAutoModelResetEnabled = false;
+        m_bUse3x3Spread = true;
+        m_nMedianBlurKernelSize = m_nDefaultMedianBlurKernelSize;
+        m_fCurrLearningRateLowerCap = FEEDBACK_T_LOWER*2;
+        m_fCurrLearningRateUpperCap = FEEDBACK_T_UPPER*2;
+    }
+    m_oDownSampledFrameSize = cv::Size(m_oImgSize.width/FRAMELEVEL_ANALYSIS_DOWNSAMPLE_RATIO,m_oImgSize.height/FRAMELEVEL_ANALYSIS_DOWNSAMPLE_RATIO);
+    m_oMeanDownSampledLastDistFrame_LT.create(m_oDownSampledFrameSize,CV_32FC((int)m_nImgChannels));
+    m_oMeanDownSampledLastDistFrame_LT = cv::Scalar(0.0f);
+    m_oMeanDownSampledLastDistFrame_ST.create(m_oDownSampledFrameSize,CV_32FC((int)m_nImgChannels));
+    m_oMeanDownSampledLastDistFrame_ST = cv::Scalar(0.0f);
+    m_oDownSampledFrame_MotionAnalysis.create(m_oDownSampledFrameSize,m_nImgType);
+    m_oDownSampledFrame_MotionAnalysis = cv::Scalar::all(0);
+    // not considering relevant pixels via LUT: it would ruin shared mem usage
+    m_nTMT32ModelSize = size_t(m_oROI.cols*m_oROI.rows);
+    // 3-channel inputs are expanded to rgba layers on the gpu (see GLImageProcAlgo's packed input mode), so they share the 4-channel model layout
+    m_nSampleStepSize = (m_nImgChannels==1)?1:4;
+    m_nPxModelSize = m_nSampleStepSize*m_nBGSamples*2;
+    m_nPxModelPadding = (m_nPxModelSize%4)?4-m_nPxModelSize%4:0;
+    m_nColStepSize = m_nPxModelSize+m_nPxModelPadding;
+    m_nRowStepSize = m_nColStepSize*m_oROI.cols;
+    m_nBGModelSize = m_nRowStepSize*m_oROI.rows;
+    const int nMaxSSBOBlockSize = lv::gl::getIntegerVal<1>(GL_MAX_SHADER_STORAGE_BLOCK_SIZE);
+    lvAssert_(nMaxSSBOBlockSize>(int)(m_nBGModelSize*sizeof(uint)) && nMaxSSBOBlockSize>(int)(m_nTMT32ModelSize*sizeof(PxState)) && nMaxSSBOBlockSize>(int)(m_nTMT32ModelSize*sizeof(lv::gl::TMT32GenParams)),"max ssbo block size is tool small for the predicted model size");
+    m_vnBGModelData.resize(m_nBGModelSize,0);
+    m_voPxStateData.resize(m_nTMT32ModelSize);
+    for(size_t nRowIdx=0; nRowIdx<(size_t)m_oROI.rows; ++nRowIdx) {
+        for(size_t nColIdx=0; nColIdx<(size_t)m_oROI.cols; ++nColIdx) {
+            PxState& oPxState = m_voPxStateData[nRowIdx*m_oROI.cols+nColIdx];
+            oPxState = PxState();
+            oPxState.fLearningRate = m_fCurrLearningRateLowerCap;
+            oPxState.fDistThresholdFactor = 1.0f;
+            oPxState.fVariationFactor = 10.0f; // should always be >= FEEDBACK_V_DECR
+            oPxState.nFlags = PXSTATE_FLAG_LAST_FINAL_DILATED; // cpu impl starts with a null inverted dilated mask, which masks all blinks
+            const uchar* const anLastColor = m_oLastColorFrame.ptr<uchar>((int)nRowIdx,(int)nColIdx);
+            const ushort* const anLastIntraDesc = m_oLastDescFrame.ptr<ushort>((int)nRowIdx,(int)nColIdx);
+            std::array<uint,3> anColor={0,0,0}, anIntraDesc={0,0,0};
+            for(size_t nChannelIdx=0; nChannelIdx<std::min(m_nImgChannels,size_t(3)); ++nChannelIdx) {
+                const size_t nSampleChannelIdx = (m_nImgChannels==1)?nChannelIdx:2-nChannelIdx;
+                anColor[nChannelIdx] = anLastColor[nSampleChannelIdx];
+                anIntraDesc[nChannelIdx] = anLastIntraDesc[nSampleChannelIdx];
+            }
+            oPxState.nLastColor = anColor[0]|(anColor[1]<<8)|(anColor[2]<<16);
+            oPxState.anLastIntraDesc[0] = anIntraDesc[0]|(anIntraDesc[1]<<16);
+            oPxState.anLastIntraDesc[1] = anIntraDesc[2];
+        }
+    }
+    lv::gl::TMT32GenParams::initTinyMT32Generators(glm::uvec3(uint(m_oROI.cols),uint(m_oROI.rows),1),m_voTMT32ModelData);
+    m_bInitialized = true;
+    GLImageProcAlgo::initialize_gl(oInitImg,m_oROI);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_PxStateBinding));
+    glBufferData(GL_SHADER_STORAGE_BUFFER,m_nTMT32ModelSize*sizeof(PxState),m_voPxStateData.data(),GL_STATIC_COPY);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_PxStateBinding,getSSBOId(BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_PxStateBinding));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_TMT32ModelBinding));
+    glBufferData(GL_SHADER_STORAGE_BUFFER,m_nTMT32ModelSize*sizeof(lv::gl::TMT32GenParams),m_voTMT32ModelData.data(),GL_STATIC_COPY);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_TMT32ModelBinding,getSSBOId(BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_TMT32ModelBinding));
+    uploadLBSPThresholdLUT();
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER,getACBOId(BackgroundSubtractorSuBSENSE_::SuBSENSEAtomicCounterBuffer_NonZeroDescCountBinding));
+    glBufferData(GL_ATOMIC_COUNTER_BUFFER,sizeof(GLuint),NULL,GL_DYNAMIC_READ);
+    glClearBufferData(GL_ATOMIC_COUNTER_BUFFER,GL_R32UI,GL_RED_INTEGER,GL_INT,NULL);
+    glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER,BackgroundSubtractorSuBSENSE_::SuBSENSEAtomicCounterBuffer_NonZeroDescCountBinding,getACBOId(BackgroundSubtractorSuBSENSE_::SuBSENSEAtomicCounterBuffer_NonZeroDescCountBinding));
+    m_pHoleFillTexture = std::make_unique<GLTexture2D>(1,cv::Mat(m_oFrameSize,CV_8UC1,cv::Scalar_<uchar>(0)),true);
+    glErrorCheck;
+    m_bModelInitialized = false;
+    refreshModel(1.0f,true);
+    m_bModelInitialized = true;
+}
+
+void BackgroundSubtractorSuBSENSE_GLSL::uploadLBSPThresholdLUT() {
+    lvDbgExceptionWatch;
+    std::array<GLuint,UCHAR_MAX+1> anLBSPThresLUT;
+    std::copy(m_anLBSPThreshold_8bitLUT.begin(),m_anLBSPThreshold_8bitLUT.end(),anLBSPThresLUT.begin());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_LBSPThresLUTBinding));
+    glBufferData(GL_SHADER_STORAGE_BUFFER,sizeof(anLBSPThresLUT),anLBSPThresLUT.data(),GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_LBSPThresLUTBinding,getSSBOId(BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_LBSPThresLUTBinding));
+    glErrorCheck;
+}
+
+void BackgroundSubtractorSuBSENSE_GLSL::updateLBSPThresholds(size_t nNonZeroDescCount) {
+    lvDbgExceptionWatch;
+    const float fCurrNonZeroDescRatio = (float)nNonZeroDescCount/m_nTotRelevantPxCount;
+    bool bUpdated = false;
+    if(fCurrNonZeroDescRatio<LBSPDESC_NONZERO_RATIO_MIN && m_fLastNonZeroDescRatio<LBSPDESC_NONZERO_RATIO_MIN) {
+        for(size_t t=0; t<=UCHAR_MAX; ++t) {
+            if(m_anLBSPThreshold_8bitLUT[t]>cv::saturate_cast<uchar>(m_nLBSPThresholdOffset+ceil(t*m_fRelLBSPThreshold/4))) {
+                --m_anLBSPThreshold_8bitLUT[t];
+                bUpdated = true;
+            }
+        }
+    }
+    else if(fCurrNonZeroDescRatio>LBSPDESC_NONZERO_RATIO_MAX && m_fLastNonZeroDescRatio>LBSPDESC_NONZERO_RATIO_MAX) {
+        for(size_t t=0; t<=UCHAR_MAX; ++t) {
+            if(m_anLBSPThreshold_8bitLUT[t]<cv::saturate_cast<uchar>(m_nLBSPThresholdOffset+UCHAR_MAX*m_fRelLBSPThreshold)) {
+                ++m_anLBSPThreshold_8bitLUT[t];
+                bUpdated = true;
+            }
+        }
+    }
+    m_fLastNonZeroDescRatio = fCurrNonZeroDescRatio;
+    if(bUpdated)
+        uploadLBSPThresholdLUT();
+}
+
+void BackgroundSubtractorSuBSENSE_GLSL::updateFrameLevelAnalysis(const cv::Mat& oInputImg, float fRollAvgFactor_LT, float fRollAvgFactor_ST) {
+    lvDbgExceptionWatch;
+    if(!m_bLearningRateScalingEnabled)
+        return;
+    cv::resize(oInputImg,m_oDownSampledFrame_MotionAnalysis,m_oDownSampledFrameSize,0,0,cv::INTER_AREA);
+    lv::updateRollingAverages({&m_oMeanDownSampledLastDistFrame_LT,&m_oMeanDownSampledLastDistFrame_ST},{fRollAvgFactor_LT,fRollAvgFactor_ST},m_oDownSampledFrame_MotionAnalysis);
+    size_t nTotColorDiff = 0;
+    for(int i=0; i<m_oMeanDownSampledLastDistFrame_ST.rows; ++i) {
+        const float* afMeanLastDist_ST = m_oMeanDownSampledLastDistFrame_ST.ptr<float>(i);
+        const float* afMeanLastDist_LT = m_oMeanDownSampledLastDistFrame_LT.ptr<float>(i);
+        for(int j=0; j<m_oMeanDownSampledLastDistFrame_ST.cols; ++j) {
+            const size_t nPxOffset = j*m_nImgChannels;
+            if(m_nImgChannels==1)
+                nTotColorDiff += (size_t)fabs(afMeanLastDist_ST[nPxOffset]-afMeanLastDist_LT[nPxOffset])/2;
+            else
+                nTotColorDiff += std::max((size_t)fabs(afMeanLastDist_ST[nPxOffset]-afMeanLastDist_LT[nPxOffset]),
+                                    std::max((size_t)fabs(afMeanLastDist_ST[nPxOffset+1]-afMeanLastDist_LT[nPxOffset+1]),
+                                             (size_t)fabs(afMeanLastDist_ST[nPxOffset+2]-afMeanLastDist_LT[nPxOffset+2])));
+        }
+    }
+    const float fCurrColorDiffRatio = (float)nTotColorDiff/(m_oMeanDownSampledLastDistFrame_ST.rows*m_oMeanDownSampledLastDistFrame_ST.cols);
+    if(m_bAutoModelResetEnabled) {
+        if(m_nFramesSinceLastReset>1000)
+            m_bAutoModelResetEnabled = false;
+        else if(fCurrColorDiffRatio>=FRAMELEVEL_MIN_COLOR_DIFF_THRESHOLD && m_nModelResetCooldown==0) {
+            m_nFramesSinceLastReset = 0;
+            // reset 10% of the bg model (and all learning rates) in the next segmentation stage, as the last fg mask is not available mid-pipeline
+            m_nPendingResetSampleCount = std::max((size_t)(0.1f*m_nBGSamples),size_t(1));
+            m_nModelResetCooldown = m_nSamplesForMovingAvgs/4;
+        }
+        else
+            ++m_nFramesSinceLastReset;
+    }
+    else if(fCurrColorDiffRatio>=FRAMELEVEL_MIN_COLOR_DIFF_THRESHOLD*2) {
+        m_nFramesSinceLastReset = 0;
+        m_bAutoModelResetEnabled = true;
+    }
+    if(fCurrColorDiffRatio>=FRAMELEVEL_MIN_COLOR_DIFF_THRESHOLD/2) {
+        m_fCurrLearningRateLowerCap = (float)std::max((int)FEEDBACK_T_LOWER>>(int)(fCurrColorDiffRatio/2),1);
+        m_fCurrLearningRateUpperCap = (float)std::max((int)FEEDBACK_T_UPPER>>(int)(fCurrColorDiffRatio/2),1);
+    }
+    else {
+        m_fCurrLearningRateLowerCap = FEEDBACK_T_LOWER;
+        m_fCurrLearningRateUpperCap = FEEDBACK_T_UPPER;
+    }
+    if(m_nModelResetCooldown>0)
+        --m_nModelResetCooldown;
+}
+
+std::string BackgroundSubtractorSuBSENSE_GLSL::getComputeShaderSource_SuBSENSE() const {
+    lvDbgExceptionWatch;
+    const bool b4ch = (m_nImgChannels!=1); // 3-channel inputs are also bound as rgba images
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "#version 430\n"
+             "#define NB_SAMPLES                 " << m_nBGSamples << "u\n"
+             "#define NB_REQ_SAMPLES             " << m_nRequiredBGSamples << "u\n"
+             "#define MODEL_STEP_SIZE            " << m_oFrameSize.width << "u\n"
+             "#define MIN_COLOR_DIST_THRESHOLD   " << getShaderFloatLiteral(float(m_nMinColorDistThreshold)) << "\n"
+             "#define STAB_COLOR_DIST_OFFSET     " << getShaderFloatLiteral(float(STAB_COLOR_DIST_OFFSET)) << "\n"
+             "#define DESC_DIST_THRESHOLD_OFFSET " << m_nDescDistThresholdOffset << "u\n"
+             "#define UNSTAB_DESC_DIST_OFFSET    " << UNSTAB_DESC_DIST_OFFSET << "u\n"
+             "#define COLOR_MAX_RANGE_1CH        " << s_nColorMaxDataRange_1ch << "u\n"
+             "#define DESC_MAX_RANGE_1CH         " << s_nDescMaxDataRange_1ch << "u\n"
+             "#define COLOR_MAX_RANGE            " << (b4ch?s_nColorMaxDataRange_3ch:s_nColorMaxDataRange_1ch) << "u\n"
+             "#define DESC_MAX_RANGE             " << (b4ch?s_nDescMaxDataRange_3ch:s_nDescMaxDataRange_1ch) << "u\n"
+             "#define GHOSTDET_D_MAX             " << getShaderFloatLiteral(GHOSTDET_D_MAX) << "\n"
+             "#define GHOSTDET_S_MIN             " << getShaderFloatLiteral(GHOSTDET_S_MIN) << "\n"
+             "#define FEEDBACK_R_VAR             " << getShaderFloatLiteral(FEEDBACK_R_VAR) << "\n"
+             "#define FEEDBACK_V_INCR            " << getShaderFloatLiteral(FEEDBACK_V_INCR) << "\n"
+             "#define FEEDBACK_V_DECR            " << getShaderFloatLiteral(FEEDBACK_V_DECR) << "\n"
+             "#define FEEDBACK_T_DECR            " << getShaderFloatLiteral(FEEDBACK_T_DECR) << "\n"
+             "#define FEEDBACK_T_INCR            " << getShaderFloatLiteral(FEEDBACK_T_INCR) << "\n"
+             "#define UNSTABLE_REG_RATIO_MIN     " << getShaderFloatLiteral(UNSTABLE_REG_RATIO_MIN) << "\n"
+             "#define UNSTABLE_REG_RDIST_MIN     " << getShaderFloatLiteral(UNSTABLE_REG_RDIST_MIN) << "\n"
+             "#define USE_3X3_SPREAD             " << (m_bUse3x3Spread?"true":"false") << "\n"
+             "#define HOLEFILL_FLAG_RAW          " << HOLEFILL_FLAG_RAW << "u\n"
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_ROIBinding << ", r8ui) readonly uniform uimage2D mROI;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_InputBinding << ", " << (b4ch?"rgba8ui":"r8ui") << ") readonly uniform uimage2D mInput;\n"
+             "layout(binding=" << BackgroundSubtractorSuBSENSE_::SuBSENSEImage_HoleFillBinding << ", r8ui) writeonly uniform uimage2D mHoleFill;\n"
+             "layout(binding=" << BackgroundSubtractorSuBSENSE_::SuBSENSEAtomicCounterBuffer_NonZeroDescCountBinding << ", offset=0) uniform atomic_uint nNonZeroDescCount;\n"
+             "layout(binding=" << BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_LBSPThresLUTBinding << ", std430) readonly buffer bLBSPThresLUT {\n"
+             "    uint anLBSPThresLUT[256];\n"
+             "};\n" <<
+             lv::getShaderFunctionSource_absdiff(true) <<
+             lv::getShaderFunctionSource_hdist() <<
+             GLShader::getShaderFunctionSource_urand_tinymt32() <<
+             GLShader::getShaderFunctionSource_getRandNeighbor3x3(LBSP::PATCH_SIZE/2,m_oFrameSize) <<
+             GLShader::getShaderFunctionSource_getRandNeighbor5x5(LBSP::PATCH_SIZE/2,m_oFrameSize) <<
+             LBSP::getShaderFunctionSource(b4ch?4:1,BGSSUBSENSE_GLSL_USE_SHAREDMEM,m_vDefaultWorkGroupSize) <<
+#if !BGSSUBSENSE_GLSL_USE_SHAREDMEM
+             "#define lbsp(t,ref,vCoords) lbsp(t,ref,mInput,vCoords)\n"
+#endif //(!BGSSUBSENSE_GLSL_USE_SHAREDMEM)
+             "struct PxModel {\n"
+             "    " << (b4ch?"uvec4":"uint") << " color_samples[" << m_nBGSamples << "];\n"
+             "    " << (b4ch?"uvec4":"uint") << " lbsp_samples[" << m_nBGSamples << "];\n";
+    if(m_nPxModelPadding>0) ssSrc <<
+             "    uint pad[" << m_nPxModelPadding << "];\n";
+    ssSrc << "};\n"
+             "layout(binding=" << BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_BGModelBinding << ", std430) coherent buffer bBGModel {\n"
+             "    PxModel aoPxModels[];\n"
+             "};\n" <<
+             getShaderSource_PxState(BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_PxStateBinding) <<
+             "layout(binding=" << BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_TMT32ModelBinding << ", std430) buffer bTMT32Model {\n"
+             "    TMT32Model aoTMT32Models[];\n"
+             "};\n"
+             "#define urand() urand(aoTMT32Models[nModelIdx])\n"
+             "uniform float fRollAvgFactor_LT;\n"
+             "uniform float fRollAvgFactor_ST;\n"
+             "uniform float fLearningRateLowerCap;\n"
+             "uniform float fLearningRateUpperCap;\n"
+             "uniform uint nLearningRateOverride;\n"
+             "uniform uint nModelResetSampleCount;\n"
+             "uniform uint nModelResetSampleStartIdx;\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "void main() {\n"
+#if BGSSUBSENSE_GLSL_USE_SHAREDMEM
+             "    preload_data(mInput);\n"
+             "    barrier();\n"
+#endif //BGSSUBSENSE_GLSL_USE_SHAREDMEM
+             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    uvec4 vSegmResult = uvec4(0);\n"
+             "    uint nROIVal = imageLoad(mROI,vImgCoords).r;\n"
+             "    uint nModelIdx = gl_GlobalInvocationID.y*MODEL_STEP_SIZE + gl_GlobalInvocationID.x;\n"
+             "    if(bool(nROIVal)) {\n"
+             "        PxState oState = aoPxStates[nModelIdx];\n"
+             "        uvec3 vInputColor = imageLoad(mInput,vImgCoords).rgb;\n"
+             "        uvec3 vInputDescThres = uvec3(anLBSPThresLUT[vInputColor.r],anLBSPThresLUT[vInputColor.g],anLBSPThresLUT[vInputColor.b]);\n"
+             "        uvec3 vInputIntraDesc = lbsp(vInputDescThres,vInputColor,vImgCoords);\n"
+             "        if(nModelResetSampleCount>0u) {\n" // frame-level model reset: samples of last bg pixels are refreshed with their last value
+             "            oState.fLearningRate = 1.0;\n"
+             "            if((oState.nFlags&FLAG_LAST_FINAL)==0u) {\n"
+             "                uvec3 vResetColor = uvec3(oState.nLastColor&0xFFu,(oState.nLastColor>>8)&0xFFu,(oState.nLastColor>>16)&0xFFu);\n"
+             "                uvec3 vResetIntraDesc = uvec3(oState.anLastIntraDesc[0]&0xFFFFu,oState.anLastIntraDesc[0]>>16,oState.anLastIntraDesc[1]&0xFFFFu);\n"
+             "                for(uint nResetIdx=0u; nResetIdx<nModelResetSampleCount; ++nResetIdx) {\n"
+             "                    uint nResetSampleIdx = (nModelResetSampleStartIdx+nResetIdx)%NB_SAMPLES;\n"
+             "                    aoPxModels[nModelIdx].color_samples[nResetSampleIdx] = " << (b4ch?"uvec4(vResetColor,0);\n":"vResetColor.r;\n") <<
+             "                    aoPxModels[nModelIdx].lbsp_samples[nResetSampleIdx] = " << (b4ch?"uvec4(vResetIntraDesc,0);\n":"vResetIntraDesc.r;\n") <<
+             "                }\n"
+             "            }\n"
+             "        }\n"
+             "        if(" << (b4ch?"bitCount(vInputIntraDesc.r)+bitCount(vInputIntraDesc.g)+bitCount(vInputIntraDesc.b)>=4":"bitCount(vInputIntraDesc.r)>=2") << ")\n"
+             "            atomicCounterIncrement(nNonZeroDescCount);\n"
+             "        bool bUnstable = (oState.nFlags&FLAG_UNSTABLE)!=0u;\n"
+             "        uint nCurrColorDistThreshold = uint(max(oState.fDistThresholdFactor*MIN_COLOR_DIST_THRESHOLD-(bUnstable?0.0:STAB_COLOR_DIST_OFFSET),0.0))" << (b4ch?"":"/2u") << ";\n"
+             "        uint nCurrDescDistThreshold = (1u<<uint(floor(oState.fDistThresholdFactor+0.5)))+DESC_DIST_THRESHOLD_OFFSET+(bUnstable?UNSTAB_DESC_DIST_OFFSET:0u);\n";
+    if(b4ch) { ssSrc <<
+             "        uint nCurrTotColorDistThreshold = nCurrColorDistThreshold*3u;\n"
+             "        uint nCurrTotDescDistThreshold = nCurrDescDistThreshold*3u;\n"
+             "        uint nCurrSCColorDistThreshold = nCurrTotColorDistThreshold/2u;\n";
+    }
+    ssSrc << "        bUnstable = (oState.fDistThresholdFactor>UNSTABLE_REG_RDIST_MIN || (oState.fMeanRawSegmRes_LT-oState.fMeanFinalSegmRes_LT)>UNSTABLE_REG_RATIO_MIN || (oState.fMeanRawSegmRes_ST-oState.fMeanFinalSegmRes_ST)>UNSTABLE_REG_RATIO_MIN);\n"
+             "        uint nGoodSamplesCount=0u, nSampleIdx=0u;\n"
+             "        uint nMinDescDist=DESC_MAX_RANGE, nMinSumDist=COLOR_MAX_RANGE;\n"
+             "        while(nSampleIdx<NB_SAMPLES) {\n" // NOTE: CHECKING TWO CONDITIONS AT ONCE IN WHILE EXPRESSION STILL BROKEN ON SOME DRIVERS (see LOBSTER impl)
+             "            if(nGoodSamplesCount>=NB_REQ_SAMPLES)\n"
+             "                break;\n"
+             "            uint nCurrSampleIdx = nSampleIdx++;\n";
+    if(b4ch) { ssSrc <<
+             "            uvec3 vBGColor = aoPxModels[nModelIdx].color_samples[nCurrSampleIdx].rgb;\n"
+             "            uvec3 vBGIntraDesc = aoPxModels[nModelIdx].lbsp_samples[nCurrSampleIdx].rgb;\n"
+             "            uvec3 vColorDist = absdiff(vInputColor,vBGColor);\n"
+             "            if(any(greaterThan(vColorDist,uvec3(nCurrSCColorDistThreshold))))\n"
+             "                continue;\n"
+             "            uvec3 vBGDescThres = uvec3(anLBSPThresLUT[vBGColor.r],anLBSPThresLUT[vBGColor.g],anLBSPThresLUT[vBGColor.b]);\n"
+             "            uvec3 vDescDist = (hdist(vInputIntraDesc,vBGIntraDesc)+hdist(lbsp(vBGDescThres,vBGColor,vImgCoords),vBGIntraDesc))/2u;\n"
+             "            uvec3 vSumDist = min((vDescDist/2u)*(COLOR_MAX_RANGE_1CH/DESC_MAX_RANGE_1CH)+vColorDist,uvec3(COLOR_MAX_RANGE_1CH));\n"
+             "            if(any(greaterThan(vSumDist,uvec3(nCurrSCColorDistThreshold))))\n"
+             "                continue;\n"
+             "            uint nDescDist = vDescDist.r+vDescDist.g+vDescDist.b;\n"
+             "            uint nSumDist = vSumDist.r+vSumDist.g+vSumDist.b;\n"
+             "            if(nDescDist>nCurrTotDescDistThreshold || nSumDist>nCurrTotColorDistThreshold)\n"
+             "                continue;\n";
+    }
+    else { ssSrc << //m_nImgChannels==1
+             "            uint nBGColor = aoPxModels[nModelIdx].color_samples[nCurrSampleIdx];\n"
+             "            uint nBGIntraDesc = aoPxModels[nModelIdx].lbsp_samples[nCurrSampleIdx];\n"
+             "            uint nColorDist = absdiff(vInputColor.r,nBGColor);\n"
+             "            if(nColorDist>nCurrColorDistThreshold)\n"
+             "                continue;\n"
+             "            uint nDescDist = (hdist(vInputIntraDesc.r,nBGIntraDesc)+hdist(lbsp(uvec3(anLBSPThresLUT[nBGColor]),uvec3(nBGColor),vImgCoords).r,nBGIntraDesc))/2u;\n"
+             "            if(nDescDist>nCurrDescDistThreshold)\n"
+             "                continue;\n"
+             "            uint nSumDist = min((nDescDist/4u)*(COLOR_MAX_RANGE_1CH/DESC_MAX_RANGE_1CH)+nColorDist,COLOR_MAX_RANGE_1CH);\n"
+             "            if(nSumDist>nCurrColorDistThreshold)\n"
+             "                continue;\n";
+    }
+    ssSrc << "            nMinDescDist = min(nMinDescDist,nDescDist);\n"
+             "            nMinSumDist = min(nMinSumDist,nSumDist);\n"
+             "            ++nGoodSamplesCount;\n"
+             "        }\n"
+             "        uvec3 vLastColor = uvec3(oState.nLastColor&0xFFu,(oState.nLastColor>>8)&0xFFu,(oState.nLastColor>>16)&0xFFu);\n"
+             "        uvec3 vLastIntraDesc = uvec3(oState.anLastIntraDesc[0]&0xFFFFu,oState.anLastIntraDesc[0]>>16,oState.anLastIntraDesc[1]&0xFFFFu);\n"
+             "        uvec3 vLastColorDist = absdiff(vLastColor,vInputColor);\n"
+             "        uvec3 vLastDescDist = hdist(vLastIntraDesc,vInputIntraDesc);\n";
+    if(b4ch) ssSrc <<
+             "        float fNormalizedLastDist = (float(vLastColorDist.r+vLastColorDist.g+vLastColorDist.b)/COLOR_MAX_RANGE+float(vLastDescDist.r+vLastDescDist.g+vLastDescDist.b)/DESC_MAX_RANGE)/2.0;\n";
+    else ssSrc <<
+             "        float fNormalizedLastDist = (float(vLastColorDist.r)/COLOR_MAX_RANGE+float(vLastDescDist.r)/DESC_MAX_RANGE)/2.0;\n";
+    ssSrc << "        oState.fMeanLastDist = oState.fMeanLastDist*(1.0-fRollAvgFactor_ST) + fNormalizedLastDist*fRollAvgFactor_ST;\n"
+             "        float fNormalizedMinDist = (float(nMinSumDist)/COLOR_MAX_RANGE+float(nMinDescDist)/DESC_MAX_RANGE)/2.0;\n"
+             "        if(nGoodSamplesCount<NB_REQ_SAMPLES) {\n"
+             "            // == foreground\n"
+             "            fNormalizedMinDist = min(1.0,fNormalizedMinDist+float(NB_REQ_SAMPLES-nGoodSamplesCount)/NB_REQ_SAMPLES);\n"
+             "            oState.fMeanMinDist_LT = oState.fMeanMinDist_LT*(1.0-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;\n"
+             "            oState.fMeanMinDist_ST = oState.fMeanMinDist_ST*(1.0-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;\n"
+             "            oState.fMeanRawSegmRes_LT = oState.fMeanRawSegmRes_LT*(1.0-fRollAvgFactor_LT) + fRollAvgFactor_LT;\n"
+             "            oState.fMeanRawSegmRes_ST = oState.fMeanRawSegmRes_ST*(1.0-fRollAvgFactor_ST) + fRollAvgFactor_ST;\n"
+             "            vSegmResult.r = 255;\n"
+             "        }\n"
+             "        else {\n"
+             "            // == background\n"
+             "            oState.fMeanMinDist_LT = oState.fMeanMinDist_LT*(1.0-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;\n"
+             "            oState.fMeanMinDist_ST = oState.fMeanMinDist_ST*(1.0-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;\n"
+             "            oState.fMeanRawSegmRes_LT = oState.fMeanRawSegmRes_LT*(1.0-fRollAvgFactor_LT);\n"
+             "            oState.fMeanRawSegmRes_ST = oState.fMeanRawSegmRes_ST*(1.0-fRollAvgFactor_ST);\n"
+             "            uint nLearningRate = (nLearningRateOverride>0u)?nLearningRateOverride:uint(ceil(oState.fLearningRate));\n"
+             "            if((urand()%nLearningRate)==0u) {\n"
+             "                uint nRandSampleIdx = urand()%NB_SAMPLES;\n"
+             "                aoPxModels[nModelIdx].color_samples[nRandSampleIdx] = " << (b4ch?"uvec4(vInputColor,0);\n":"vInputColor.r;\n") <<
+             "                aoPxModels[nModelIdx].lbsp_samples[nRandSampleIdx] = " << (b4ch?"uvec4(vInputIntraDesc,0);\n":"vInputIntraDesc.r;\n") <<
+             "            }\n"
+             "            bool bCurrUsing3x3Spread = USE_3X3_SPREAD && !bUnstable;\n"
+             "            ivec2 vNeighbCoords = bCurrUsing3x3Spread?getRandNeighbor3x3(vImgCoords,urand()):getRandNeighbor5x5(vImgCoords,urand());\n"
+             "            uint nRandVal = urand();\n"
+             "            uint nNeighbModelIdx = uint(vNeighbCoords.y)*MODEL_STEP_SIZE + uint(vNeighbCoords.x);\n"
+             "            float fRandMeanLastDist = aoPxStates[nNeighbModelIdx].fMeanLastDist;\n"
+             "            float fRandMeanRawSegmRes = aoPxStates[nNeighbModelIdx].fMeanRawSegmRes_ST;\n"
+             "            if((nRandVal%(bCurrUsing3x3Spread?nLearningRate:(nLearningRate/2u+1u)))==0u ||\n"
+             "               (fRandMeanRawSegmRes>GHOSTDET_S_MIN && fRandMeanLastDist<GHOSTDET_D_MAX && (nRandVal%uint(fLearningRateLowerCap))==0u)) {\n"
+             "                uint nRandSampleIdx = urand()%NB_SAMPLES;\n"
+             "                aoPxModels[nNeighbModelIdx].color_samples[nRandSampleIdx] = " << (b4ch?"uvec4(vInputColor,0);\n":"vInputColor.r;\n") <<
+             "                aoPxModels[nNeighbModelIdx].lbsp_samples[nRandSampleIdx] = " << (b4ch?"uvec4(vInputIntraDesc,0);\n":"vInputIntraDesc.r;\n") <<
+             "            }\n"
+             "            memoryBarrier();\n"
+             "        }\n"
+             "        bool bLastFinal = (oState.nFlags&FLAG_LAST_FINAL)!=0u;\n"
+             "        float fMinMeanMinDist = min(oState.fMeanMinDist_LT,oState.fMeanMinDist_ST);\n"
+             "        float fMaxMeanMinDist = max(oState.fMeanMinDist_LT,oState.fMeanMinDist_ST);\n"
+             "        if(bLastFinal || (fMinMeanMinDist<UNSTABLE_REG_RATIO_MIN && vSegmResult.r!=0u)) {\n"
+             "            if(oState.fLearningRate<fLearningRateUpperCap)\n"
+             "                oState.fLearningRate += FEEDBACK_T_INCR/(fMaxMeanMinDist*oState.fVariationFactor);\n"
+             "        }\n"
+             "        else if(oState.fLearningRate>fLearningRateLowerCap)\n"
+             "            oState.fLearningRate -= FEEDBACK_T_DECR*oState.fVariationFactor/fMaxMeanMinDist;\n"
+             "        oState.fLearningRate = clamp(oState.fLearningRate,fLearningRateLowerCap,fLearningRateUpperCap);\n"
+             "        if(fMaxMeanMinDist>UNSTABLE_REG_RATIO_MIN && (oState.nFlags&FLAG_BLINK)!=0u)\n"
+             "            oState.fVariationFactor += FEEDBACK_V_INCR;\n"
+             "        else if(oState.fVariationFactor>FEEDBACK_V_DECR)\n"
+             "            oState.fVariationFactor = max(oState.fVariationFactor-(bLastFinal?FEEDBACK_V_DECR/4.0:bUnstable?FEEDBACK_V_DECR/2.0:FEEDBACK_V_DECR),FEEDBACK_V_DECR);\n"
+             "        if(oState.fDistThresholdFactor<pow(1.0+fMinMeanMinDist*2.0,2.0))\n"
+             "            oState.fDistThresholdFactor += FEEDBACK_R_VAR*(oState.fVariationFactor-FEEDBACK_V_DECR);\n"
+             "        else\n"
+             "            oState.fDistThresholdFactor = max(oState.fDistThresholdFactor-FEEDBACK_R_VAR/oState.fVariationFactor,1.0);\n"
+             "        oState.nLastColor = vInputColor.r|(vInputColor.g<<8)|(vInputColor.b<<16);\n"
+             "        oState.anLastIntraDesc[0] = vInputIntraDesc.r|(vInputIntraDesc.g<<16);\n"
+             "        oState.anLastIntraDesc[1] = vInputIntraDesc.b;\n"
+             "        oState.nFlags = (oState.nFlags&~(FLAG_UNSTABLE|FLAG_CURR_RAW))|(bUnstable?FLAG_UNSTABLE:0u)|((vSegmResult.r!=0u)?FLAG_CURR_RAW:0u);\n"
+             "        aoPxStates[nModelIdx] = oState;\n"
+             "    }\n"
+             "    imageStore(mHoleFill,vImgCoords,uvec4((vSegmResult.r!=0u)?HOLEFILL_FLAG_RAW:0u));\n"
+             "}\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    return ssSrc.str();
+}
+
+std::string BackgroundSubtractorSuBSENSE_GLSL::getComputeShaderSource_HoleFill(size_t nStage) const {
+    lvDbgExceptionWatch;
+    lvAssert_(nStage>=SuBSENSEStage_Dilation && nStage<=SuBSENSEStage_Combination,"required stage is not a hole filling stage");
+    const bool bSweep = nStage>=SuBSENSEStage_FirstFloodSweep && nStage<SuBSENSEStage_Combination;
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "#version 430\n"
+             "#define FRAME_WIDTH           " << m_oFrameSize.width << "\n"
+             "#define FRAME_HEIGHT          " << m_oFrameSize.height << "\n"
+             "#define HOLEFILL_FLAG_RAW     " << HOLEFILL_FLAG_RAW << "u\n"
+             "#define HOLEFILL_FLAG_DILATED " << HOLEFILL_FLAG_DILATED << "u\n"
+             "#define HOLEFILL_FLAG_CLOSED  " << HOLEFILL_FLAG_CLOSED << "u\n"
+             "#define HOLEFILL_FLAG_FLOODED " << HOLEFILL_FLAG_FLOODED << "u\n";
+    if(bSweep) ssSrc <<
+             "layout(local_size_x=" << HOLEFILL_SWEEP_WORKGROUP_SIZE << ") in;\n";
+    else ssSrc <<
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n";
+    ssSrc << "layout(binding=" << BackgroundSubtractorSuBSENSE_::SuBSENSEImage_HoleFillBinding << ", r8ui) coherent uniform uimage2D mHoleFill;\n";
+    if(nStage==SuBSENSEStage_Combination) ssSrc <<
+             "layout(binding=" << GLImageProcAlgo::Image_OutputBinding << ", r8ui) writeonly uniform uimage2D mOutput;\n";
+    ssSrc << "bool isFlagSet(in ivec2 vCoords, in uint nFlag, in bool bOutOfBoundsVal) {\n"
+             "    if(any(lessThan(vCoords,ivec2(0))) || any(greaterThanEqual(vCoords,ivec2(FRAME_WIDTH,FRAME_HEIGHT))))\n"
+             "        return bOutOfBoundsVal;\n"
+             "    return (imageLoad(mHoleFill,vCoords).r&nFlag)!=0u;\n"
+             "}\n";
+    if(bSweep) ssSrc << // floods the non-closed pixels reachable from the top-left corner along a row/column (each invocation owns its own line)
+             "bool flood(in ivec2 vCoords, in bool bFlooding) {\n"
+             "    uint nFlags = imageLoad(mHoleFill,vCoords).r;\n"
+             "    if((nFlags&HOLEFILL_FLAG_CLOSED)!=0u)\n"
+             "        return false;\n"
+             "    if((nFlags&HOLEFILL_FLAG_FLOODED)!=0u)\n"
+             "        return true;\n"
+             "    if(bFlooding)\n"
+             "        imageStore(mHoleFill,vCoords,uvec4(nFlags|HOLEFILL_FLAG_FLOODED));\n"
+             "    return bFlooding;\n"
+             "}\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    if(bSweep) {
+        const bool bHorizontal = ((nStage-SuBSENSEStage_FirstFloodSweep)%2)==0;
+        const char* sLineCount = bHorizontal?"FRAME_HEIGHT":"FRAME_WIDTH";
+        const char* sLineLength = bHorizontal?"FRAME_WIDTH":"FRAME_HEIGHT";
+        const char* sCoords = bHorizontal?"ivec2(nIdx,nLineIdx)":"ivec2(nLineIdx,nIdx)";
+        ssSrc << "void main() {\n"
+                 "    int nLineIdx = int(gl_GlobalInvocationID.x);\n"
+                 "    if(nLineIdx>=" << sLineCount << ")\n"
+                 "        return;\n"
+                 "    bool bFlooding = false;\n"
+                 "    for(int nIdx=0; nIdx<" << sLineLength << "; ++nIdx)\n"
+                 "        bFlooding = flood(" << sCoords << ",bFlooding);\n"
+                 "    bFlooding = false;\n"
+                 "    for(int nIdx=" << sLineLength << "-1; nIdx>=0; --nIdx)\n"
+                 "        bFlooding = flood(" << sCoords << ",bFlooding);\n"
+                 "}\n";
+    }
+    else {
+        ssSrc << "void main() {\n"
+                 "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+                 "    if(any(greaterThanEqual(vImgCoords,ivec2(FRAME_WIDTH,FRAME_HEIGHT))))\n"
+                 "        return;\n"
+                 "    uint nFlags = imageLoad(mHoleFill,vImgCoords).r;\n";
+        if(nStage==SuBSENSEStage_Dilation) ssSrc << // 3x3 dilation of the raw mask (out-of-bounds pixels are cleared)
+                 "    bool bDilated = false;\n"
+                 "    for(int nOffsetY=-1; nOffsetY<=1; ++nOffsetY)\n"
+                 "        for(int nOffsetX=-1; nOffsetX<=1; ++nOffsetX)\n"
+                 "            bDilated = bDilated || isFlagSet(vImgCoords+ivec2(nOffsetX,nOffsetY),HOLEFILL_FLAG_RAW,false);\n"
+                 "    imageStore(mHoleFill,vImgCoords,uvec4(nFlags|(bDilated?HOLEFILL_FLAG_DILATED:0u)));\n";
+        else if(nStage==SuBSENSEStage_Erosion) ssSrc << // 3x3 erosion of the dilated mask (out-of-bounds pixels are set), and flood fill seeding
+                 "    bool bClosed = true;\n"
+                 "    for(int nOffsetY=-1; nOffsetY<=1; ++nOffsetY)\n"
+                 "        for(int nOffsetX=-1; nOffsetX<=1; ++nOffsetX)\n"
+                 "            bClosed = bClosed && isFlagSet(vImgCoords+ivec2(nOffsetX,nOffsetY),HOLEFILL_FLAG_DILATED,true);\n"
+                 "    bool bSeed = !bClosed && all(equal(vImgCoords,ivec2(0)));\n"
+                 "    imageStore(mHoleFill,vImgCoords,uvec4(nFlags|(bClosed?HOLEFILL_FLAG_CLOSED:0u)|(bSeed?HOLEFILL_FLAG_FLOODED:0u)));\n";
+        else ssSrc << // raw mask + unflooded holes + 7x7 erosion of the closed mask (i.e. three 3x3 erosions, out-of-bounds pixels are set)
+                 "    bool bFinal = (nFlags&HOLEFILL_FLAG_RAW)!=0u || (nFlags&(HOLEFILL_FLAG_CLOSED|HOLEFILL_FLAG_FLOODED))==0u;\n"
+                 "    if(!bFinal) {\n"
+                 "        bFinal = true;\n"
+                 "        for(int nOffsetY=-3; nOffsetY<=3; ++nOffsetY)\n"
+                 "            for(int nOffsetX=-3; nOffsetX<=3; ++nOffsetX)\n"
+                 "                bFinal = bFinal && isFlagSet(vImgCoords+ivec2(nOffsetX,nOffsetY),HOLEFILL_FLAG_CLOSED,true);\n"
+                 "    }\n"
+                 "    imageStore(mOutput,vImgCoords,uvec4(bFinal?255u:0u));\n";
+        ssSrc << "}\n";
+    }
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    return ssSrc.str();
+}
+
+std::string BackgroundSubtractorSuBSENSE_GLSL::getComputeShaderSource_PostProc() const {
+    lvDbgExceptionWatch;
+    lvAssert_(m_nMedianBlurKernelSize>0,"postproc median blur kernel size must be positive");
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // the median is written to the hole filling image so that no invocation overwrites the pixels its neighbors are still reading
+    ssSrc << "#version 430\n"
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_OutputBinding << ", r8ui) readonly uniform uimage2D mOutput;\n"
+             "layout(binding=" << BackgroundSubtractorSuBSENSE_::SuBSENSEImage_HoleFillBinding << ", r8ui) writeonly uniform uimage2D mHoleFill;\n" <<
+             GLShader::getComputeShaderFunctionSource_BinaryMedianBlur(size_t(m_nMedianBlurKernelSize),BGSSUBSENSE_GLSL_USE_SHAREDMEM,m_vDefaultWorkGroupSize);
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "void main() {\n"
+             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+#if BGSSUBSENSE_GLSL_USE_SHAREDMEM
+             "    preload_data(mOutput);\n"
+             "    barrier();\n"
+             "    uint nFinalSegmRes = BinaryMedianBlur(vImgCoords);\n"
+#else //(!BGSSUBSENSE_GLSL_USE_SHAREDMEM)
+             "    uint nFinalSegmRes = BinaryMedianBlur(mOutput,vImgCoords);\n"
+             "    barrier();\n"
+#endif //(!BGSSUBSENSE_GLSL_USE_SHAREDMEM)
+             "    imageStore(mHoleFill,vImgCoords,uvec4(nFinalSegmRes));\n"
+             "}\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    return ssSrc.str();
+}
+
+std::string BackgroundSubtractorSuBSENSE_GLSL::getComputeShaderSource_Feedback() const {
+    lvDbgExceptionWatch;
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "#version 430\n"
+             "#define MODEL_STEP_SIZE " << m_oFrameSize.width << "u\n"
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_ROIBinding << ", r8ui) readonly uniform uimage2D mROI;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_OutputBinding << ", r8ui) writeonly uniform uimage2D mOutput;\n"
+             "layout(binding=" << BackgroundSubtractorSuBSENSE_::SuBSENSEImage_HoleFillBinding << ", r8ui) readonly uniform uimage2D mFinal;\n" <<
+             getShaderSource_PxState(BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_PxStateBinding) <<
+             "uniform float fRollAvgFactor_LT;\n"
+             "uniform float fRollAvgFactor_ST;\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "void main() {\n"
+             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    uint nROIVal = imageLoad(mROI,vImgCoords).r;\n"
+             "    bool bCurrFinal = imageLoad(mFinal,vImgCoords).r!=0u;\n"
+             "    imageStore(mOutput,vImgCoords,uvec4(bCurrFinal?255u:0u));\n"
+             "    if(bool(nROIVal)) {\n"
+             "        uint nModelIdx = gl_GlobalInvocationID.y*MODEL_STEP_SIZE + gl_GlobalInvocationID.x;\n"
+             "        bool bCurrFinalDilated = false;\n" // equivalent to three 3x3 dilations (out-of-bounds loads return zero)
+             "        for(int nOffsetY=-3; nOffsetY<=3; ++nOffsetY)\n"
+             "            for(int nOffsetX=-3; nOffsetX<=3; ++nOffsetX)\n"
+             "                bCurrFinalDilated = bCurrFinalDilated || (imageLoad(mFinal,vImgCoords+ivec2(nOffsetX,nOffsetY)).r!=0u);\n"
+             "        uint nFlags = aoPxStates[nModelIdx].nFlags;\n"
+             "        bool bCurrRaw = (nFlags&FLAG_CURR_RAW)!=0u;\n"
+             "        bool bCurrRawBlink = bCurrRaw!=((nFlags&FLAG_LAST_RAW)!=0u);\n"
+             "        bool bBlink = (bCurrRawBlink || (nFlags&FLAG_LAST_RAW_BLINK)!=0u) && !bCurrFinalDilated && (nFlags&FLAG_LAST_FINAL_DILATED)==0u;\n"
+             "        aoPxStates[nModelIdx].nFlags = (nFlags&(FLAG_UNSTABLE|FLAG_CURR_RAW))|(bCurrRaw?FLAG_LAST_RAW:0u)|(bCurrRawBlink?FLAG_LAST_RAW_BLINK:0u)|\n"
+             "                                       (bBlink?FLAG_BLINK:0u)|(bCurrFinal?FLAG_LAST_FINAL:0u)|(bCurrFinalDilated?FLAG_LAST_FINAL_DILATED:0u);\n"
+             "        aoPxStates[nModelIdx].fMeanFinalSegmRes_LT = aoPxStates[nModelIdx].fMeanFinalSegmRes_LT*(1.0-fRollAvgFactor_LT) + (bCurrFinal?fRollAvgFactor_LT:0.0);\n"
+             "        aoPxStates[nModelIdx].fMeanFinalSegmRes_ST = aoPxStates[nModelIdx].fMeanFinalSegmRes_ST*(1.0-fRollAvgFactor_ST) + (bCurrFinal?fRollAvgFactor_ST:0.0);\n"
+             "    }\n"
+             "}\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    return ssSrc.str();
+}
+
+std::string BackgroundSubtractorSuBSENSE_GLSL::getComputeShaderSource(size_t nStage) const {
+    lvDbgExceptionWatch;
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    lvAssert_(nStage<m_nComputeStages,"required compute stage does not exist");
+    if(nStage==SuBSENSEStage_Segmentation)
+        return getComputeShaderSource_SuBSENSE();
+    else if(nStage<=SuBSENSEStage_Combination)
+        return getComputeShaderSource_HoleFill(nStage);
+    else if(nStage==SuBSENSEStage_MedianBlur)
+        return getComputeShaderSource_PostProc();
+    else //nStage==SuBSENSEStage_Feedback
+        return getComputeShaderSource_Feedback();
+}
+
+void BackgroundSubtractorSuBSENSE_GLSL::dispatch(size_t nStage, GLShader& oShader) {
+    lvDbgExceptionWatch;
+    lvAssert_(nStage<m_nComputeStages,"required compute stage does not exist");
+    lvDbgAssert(m_nFrameIdx>0);
+    const float fRollAvgFactor_LT = getCompensatedRollAvgFactor(1.0f/std::min(m_nFrameIdx,m_nSamplesForMovingAvgs));
+    const float fRollAvgFactor_ST = getCompensatedRollAvgFactor(1.0f/std::min(m_nFrameIdx,m_nSamplesForMovingAvgs/4));
+    if(nStage==SuBSENSEStage_Segmentation) {
+        const GLuint nACBOId = getACBOId(BackgroundSubtractorSuBSENSE_::SuBSENSEAtomicCounterBuffer_NonZeroDescCountBinding);
+        glBindBuffer(GL_ATOMIC_COUNTER_BUFFER,nACBOId);
+        if(m_nFrameIdx>1) {
+            // the previous frame's stages were queued during the last call, so this readback should (almost) never stall
+            GLuint nNonZeroDescCount = 0;
+            glMemoryBarrier(GL_ATOMIC_COUNTER_BARRIER_BIT|GL_BUFFER_UPDATE_BARRIER_BIT);
+            glGetBufferSubData(GL_ATOMIC_COUNTER_BUFFER,0,sizeof(GLuint),&nNonZeroDescCount);
+            updateLBSPThresholds((size_t)nNonZeroDescCount);
+        }
+        glClearBufferData(GL_ATOMIC_COUNTER_BUFFER,GL_R32UI,GL_RED_INTEGER,GL_INT,NULL);
+        glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER,BackgroundSubtractorSuBSENSE_::SuBSENSEAtomicCounterBuffer_NonZeroDescCountBinding,nACBOId);
+        m_pHoleFillTexture->bindToImage(BackgroundSubtractorSuBSENSE_::SuBSENSEImage_HoleFillBinding,0,GL_READ_WRITE);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT|GL_ATOMIC_COUNTER_BARRIER_BIT);
+        oShader.setUniform1f("fRollAvgFactor_LT",fRollAvgFactor_LT);
+        oShader.setUniform1f("fRollAvgFactor_ST",fRollAvgFactor_ST);
+        oShader.setUniform1f("fLearningRateLowerCap",m_fCurrLearningRateLowerCap);
+        oShader.setUniform1f("fLearningRateUpperCap",m_fCurrLearningRateUpperCap);
+        if(std::isinf(m_dCurrLearningRate))
+            oShader.setUniform1ui("nLearningRateOverride",UINT_MAX);
+        else
+            oShader.setUniform1ui("nLearningRateOverride",m_dCurrLearningRate>0?(GLuint)ceil(m_dCurrLearningRate):0u);
+        oShader.setUniform1ui("nModelResetSampleCount",(GLuint)m_nPendingResetSampleCount);
+        oShader.setUniform1ui("nModelResetSampleStartIdx",(GLuint)(m_nPendingResetSampleCount?m_oRNG()%m_nBGSamples:0));
+        m_nPendingResetSampleCount = 0;
+    }
+    else if(nStage==SuBSENSEStage_Feedback) {
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT|GL_SHADER_STORAGE_BARRIER_BIT);
+        oShader.setUniform1f("fRollAvgFactor_LT",fRollAvgFactor_LT);
+        oShader.setUniform1f("fRollAvgFactor_ST",fRollAvgFactor_ST);
+    }
+    else
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    if(nStage>=SuBSENSEStage_FirstFloodSweep && nStage<SuBSENSEStage_Combination) {
+        const bool bHorizontal = ((nStage-SuBSENSEStage_FirstFloodSweep)%2)==0;
+        glDispatchCompute((GLuint)ceil((float)(bHorizontal?m_oFrameSize.height:m_oFrameSize.width)/HOLEFILL_SWEEP_WORKGROUP_SIZE),1,1);
+    }
+    else
+        glDispatchCompute((GLuint)ceil((float)m_oFrameSize.width/m_vDefaultWorkGroupSize.x),(GLuint)ceil((float)m_oFrameSize.height/m_vDefaultWorkGroupSize.y),1);
+    if(nStage==SuBSENSEStage_Feedback) {
+        // the host-side copy of the last input is the frame these stages just processed (it is only replaced after this call)
+        updateFrameLevelAnalysis(m_oLastColorFrame,fRollAvgFactor_LT,fRollAvgFactor_ST);
+    }
+}
+
+void BackgroundSubtractorSuBSENSE_GLSL::getBackgroundImage(cv::OutputArray oBGImg) const {
+    lvDbgExceptionWatch;
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    lvAssert_(m_bGLInitialized && !m_vnBGModelData.empty(),"algo gpu bg model not initialized");
+    oBGImg.create(m_oFrameSize,CV_8UC(int(m_nImgChannels)));
+    cv::Mat oOutputImg = oBGImg.getMatRef();
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_BGModelBinding));
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER,0,m_nBGModelSize*sizeof(uint),(void*)m_vnBGModelData.data());
+    glErrorCheck;
+    for(size_t nRowIdx=0; nRowIdx<(size_t)m_oFrameSize.height; ++nRowIdx) {
+        const size_t nModelRowOffset = nRowIdx*m_nRowStepSize;
+        const size_t nImgRowOffset = nRowIdx*oOutputImg.step.p[0];
+        for(size_t nColIdx=0; nColIdx<(size_t)m_oFrameSize.width; ++nColIdx) {
+            const size_t nModelColOffset = nColIdx*m_nColStepSize+nModelRowOffset;
+            const size_t nImgColOffset = nColIdx*oOutputImg.step.p[1]+nImgRowOffset;
+            std::array<float,4> afCurrPxSum = {0.0f,0.0f,0.0f,0.0f};
+            for(size_t nSampleIdx=0; nSampleIdx<m_nBGSamples; ++nSampleIdx) {
+                const size_t nModelPxOffset = nSampleIdx*m_nSampleStepSize+nModelColOffset;
+                for(size_t nChannelIdx=0; nChannelIdx<m_nImgChannels; ++nChannelIdx)
+                    afCurrPxSum[nChannelIdx] += m_vnBGModelData[nChannelIdx+nModelPxOffset];
+            }
+            for(size_t nChannelIdx=0; nChannelIdx<m_nImgChannels; ++nChannelIdx) {
+                const size_t nSampleChannelIdx = ((nChannelIdx==3||m_nImgChannels==1)?nChannelIdx:2-nChannelIdx);
+                oOutputImg.data[nSampleChannelIdx+nImgColOffset] = (uchar)(afCurrPxSum[nChannelIdx]/m_nBGSamples);
+            }
+        }
+    }
+}
+
+void BackgroundSubtractorSuBSENSE_GLSL::getBackgroundDescriptorsImage(cv::OutputArray oBGDescImg) const {
+    lvDbgExceptionWatch;
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    lvAssert_(m_bGLInitialized && !m_vnBGModelData.empty(),"algo gpu bg model not initialized");
+    static_assert(LBSP::DESC_SIZE==2,"Some assumptions are breaking below");
+    oBGDescImg.create(m_oFrameSize,CV_16UC(int(m_nImgChannels)));
+    cv::Mat oOutputImg = oBGDescImg.getMatRef();
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(BackgroundSubtractorSuBSENSE_::SuBSENSEStorageBuffer_BGModelBinding));
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER,0,m_nBGModelSize*sizeof(uint),(void*)m_vnBGModelData.data());
+    glErrorCheck;
+    for(size_t nRowIdx=0; nRowIdx<(size_t)m_oFrameSize.height; ++nRowIdx) {
+        const size_t nModelRowOffset = nRowIdx*m_nRowStepSize;
+        const size_t nImgRowOffset = nRowIdx*oOutputImg.step.p[0];
+        for(size_t nColIdx=0; nColIdx<(size_t)m_oFrameSize.width; ++nColIdx) {
+            const size_t nModelColOffset = nColIdx*m_nColStepSize+nModelRowOffset;
+            const size_t nImgColOffset = nColIdx*oOutputImg.step.p[1]+nImgRowOffset;
+            std::array<float,4> afCurrPxSum = {0.0f,0.0f,0.0f,0.0f};
+            for(size_t nSampleIdx=0; nSampleIdx<m_nBGSamples; ++nSampleIdx) {
+                const size_t nModelPxOffset_desc = nSampleIdx*m_nSampleStepSize+nModelColOffset+(m_nBGSamples*m_nSampleStepSize);
+                for(size_t nChannelIdx=0; nChannelIdx<m_nImgChannels; ++nChannelIdx)
+                    afCurrPxSum[nChannelIdx] += m_vnBGModelData[nChannelIdx+nModelPxOffset_desc];
+            }
+            for(size_t nChannelIdx=0; nChannelIdx<m_nImgChannels; ++nChannelIdx) {
+                const size_t nSampleChannelIdx = ((nChannelIdx==3||m_nImgChannels==1)?nChannelIdx:2-nChannelIdx);
+                *(ushort*)(oOutputImg.data+nSampleChannelIdx*2+nImgColOffset) = (ushort)(afCurrPxSum[nChannelIdx]/m_nBGSamples);
+            }
+        }
+    }
+}
+
+template struct BackgroundSubtractorSuBSENSE_<lv::GLSL>;
+#endif //HAVE_GLSL
+
 BackgroundSubtractorSuBSENSE::BackgroundSubtractorSuBSENSE_(size_t nDescDistThresholdOffset, size_t nMinColorDistThreshold, size_t nBGSamples,
                                                             size_t nRequiredBGSamples, size_t nSamplesForMovingAvgs, float fRelLBSPThreshold) :
         IBackgroundSubtractorLBSP(fRelLBSPThreshold),
@@ -72,7 +919,23 @@ BackgroundSubtractorSuBSENSE::BackgroundSubtractorSuBSENSE_(size_t nDescDistThre
         m_fCurrLearningRateLowerCap(FEEDBACK_T_LOWER),
         m_fCurrLearningRateUpperCap(FEEDBACK_T_UPPER),
         m_nMedianBlurKernelSize(m_nDefaultMedianBlurKernelSize),
-        m_bUse3x3Spread(true) {
+        m_bUse3x3Spread(true),
+        m_bUsingInterleavedSamples(false),
+        m_nDedupSampleSlots(0),
+        m_bUsingBitSlicedDescs(false),
+        m_bUsingCompactStateMaps(false),
+        m_nThreadCount(1),
+        m_nIncrementalResetFrames(0),
+        m_nPendingResetFrames(0),
+        m_bUsingGlobalMotionCompensation(false),
+        m_oLastGlobalMotion(0,0),
+        m_bUsingStabilityShortcut(false),
+        m_nStabilityMinBGStreak(BGSSUBSENSE_DEFAULT_STABILITY_MIN_BG_STREAK),
+        m_fStabilityMaxMeanLastDist(BGSSUBSENSE_DEFAULT_STABILITY_MAX_MEAN_LAST_DIST),
+        m_bUsingCoarseToFineClassification(false),
+        m_nC2FCoarseStride(BGSSUBSENSE_DEFAULT_C2F_COARSE_STRIDE),
+        m_nC2FRefineMargin(BGSSUBSENSE_DEFAULT_C2F_REFINE_MARGIN),
+        m_oFrameArenaAllocator(m_oFrameArena) {
     lvAssert_(m_nBGSamples>0 && m_nRequiredBGSamples<=m_nBGSamples,"algo cannot require more sample matches than sample count in model");
     lvAssert_(m_nMinColorDistThreshold>0 || m_nDescDistThresholdOffset>0,"distance thresholds must be positive values");
 }
@@ -80,32 +943,62 @@ BackgroundSubtractorSuBSENSE::BackgroundSubtractorSuBSENSE_(size_t nDescDistThre
 void BackgroundSubtractorSuBSENSE::refreshModel(float fSamplesRefreshFrac, bool bForceFGUpdate) {
     // == refresh
     lvAssert_(m_bInitialized,"algo must be initialized first");
+    m_nPendingResetFrames = 0; // a full refresh supersedes any pending incremental reset
+    refreshModelRange(fSamplesRefreshFrac,bForceFGUpdate,0,m_nTotRelevantPxCount);
+}
+
+void BackgroundSubtractorSuBSENSE::refreshModelRange(float fSamplesRefreshFrac, bool bForceFGUpdate, size_t nModelIterBegin, size_t nModelIterEnd) {
     lvAssert_(fSamplesRefreshFrac>0.0f && fSamplesRefreshFrac<=1.0f,"model refresh must be given as a non-null fraction");
-    lvDbgAssert(!m_voBGColorSamples.empty() && !m_voBGColorSamples[0].empty());
+    lvDbgAssert(!m_oBGSamples.empty() && nModelIterBegin<=nModelIterEnd && nModelIterEnd<=m_nTotRelevantPxCount);
     const size_t nModelSamplesToRefresh = fSamplesRefreshFrac<1.0f?(size_t)(fSamplesRefreshFrac*m_nBGSamples):m_nBGSamples;
-    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?rand()%m_nBGSamples:0;
-    const size_t nChannels = m_voBGColorSamples[0].channels();
-    for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
+    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?m_oRNG()%m_nBGSamples:0;
+    // pixel type & channel count are resolved once here, so that the per-sample copies below are fully specialized
+    const auto pRefreshModelBand = (m_nImgType==CV_16UC1)?&BackgroundSubtractorSuBSENSE::refreshModelBand<ushort,1,lv::PCG32>:
+                                   (m_nImgChannels==1)?&BackgroundSubtractorSuBSENSE::refreshModelBand<uchar,1,lv::PCG32>:
+                                   (m_nImgChannels==3)?&BackgroundSubtractorSuBSENSE::refreshModelBand<uchar,3,lv::PCG32>:
+                                                       &BackgroundSubtractorSuBSENSE::refreshModelBand<uchar,4,lv::PCG32>;
+    const auto lRefreshBand = [&](size_t nBandModelIterBegin, size_t nBandModelIterEnd, lv::PCG32& oRNG) {
+        (this->*pRefreshModelBand)(nModelSamplesToRefresh,nRefreshSampleStartPos,bForceFGUpdate,nBandModelIterBegin,nBandModelIterEnd,oRNG);
+    };
+    if(m_nThreadCount==1)
+        lRefreshBand(nModelIterBegin,nModelIterEnd,m_oRNG);
+    else {
+        lvDbgAssert(m_pThreadPool && m_vnBandModelIterLUT.size()>=2 && m_voBandRNGs.size()==m_vnBandModelIterLUT.size()-1);
+        m_pThreadPool->parallel_for(m_voBandRNGs.size(),[&](size_t nBandIdx) {
+            const size_t nBandModelIterBegin = std::max(nModelIterBegin,m_vnBandModelIterLUT[nBandIdx]);
+            const size_t nBandModelIterEnd = std::min(nModelIterEnd,m_vnBandModelIterLUT[nBandIdx+1]);
+            if(nBandModelIterBegin<nBandModelIterEnd)
+                lRefreshBand(nBandModelIterBegin,nBandModelIterEnd,m_voBandRNGs[nBandIdx]);
+        });
+    }
+}
+
+template<typename TColor, size_t nChannels, typename TRNG>
+void BackgroundSubtractorSuBSENSE::refreshModelBand(size_t nModelSamplesToRefresh, size_t nRefreshSampleStartPos, bool bForceFGUpdate, size_t nModelIterBegin, size_t nModelIterEnd, TRNG& oRNG) {
+    lvDbgAssert(m_oBGSamples.channels()==nChannels && m_oLastColorFrame.channels()==(int)nChannels);
+    // samples are copied from the dense color & descriptor maps of the last frame, so each pixel only writes to its own model
+    const TColor* const anLastColors = (const TColor*)m_oLastColorFrame.data;
+    const ushort* const anLastDescs = (const ushort*)m_oLastDescFrame.data;
+    for(size_t nModelIter=nModelIterBegin; nModelIter<nModelIterEnd; ++nModelIter) {
         const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
         if(bForceFGUpdate || !m_oLastFGMask.data[nPxIter]) {
+            ((ushort*)m_oBGStreakFrame.data)[nPxIter] = 0; // refreshed samples invalidate the stability shortcut
             for(size_t nCurrModelSampleIdx=nRefreshSampleStartPos; nCurrModelSampleIdx<nRefreshSampleStartPos+nModelSamplesToRefresh; ++nCurrModelSampleIdx) {
-                int nSampleImgCoord_Y, nSampleImgCoord_X;
-                cv::getRandSamplePosition_7x7_std2(nSampleImgCoord_X,nSampleImgCoord_Y,m_voPxInfoLUT[nPxIter].nImgCoord_X,m_voPxInfoLUT[nPxIter].nImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
+                const size_t nSamplePxIdx = m_oRandSampleLUT.getRandIdx(nPxIter,oRNG);
                 if(bForceFGUpdate || !m_oLastFGMask.data[nSamplePxIdx]) {
                     const size_t nCurrRealModelSampleIdx = nCurrModelSampleIdx%m_nBGSamples;
-                    for(size_t c=0; c<nChannels; ++c) {
-                        m_voBGColorSamples[nCurrRealModelSampleIdx].data[nPxIter*nChannels+c] = m_oLastColorFrame.data[nSamplePxIdx*nChannels+c];
-                        *((ushort*)(m_voBGDescSamples[nCurrRealModelSampleIdx].data+(nPxIter*nChannels+c)*2)) = *((ushort*)(m_oLastDescFrame.data+(nSamplePxIdx*nChannels+c)*2));
-                    }
+                    m_oBGSamples.setSample<nChannels>(nCurrRealModelSampleIdx,nPxIter,anLastColors+nSamplePxIdx*nChannels,anLastDescs+nSamplePxIdx*nChannels);
                 }
             }
         }
     }
 }
 
-void BackgroundSubtractorSuBSENSE::initialize(const cv::Mat& oInitImg, const cv::Mat& oROI) {
+void BackgroundSubtractorSuBSENSE::initialize(const cv::Mat& _oInitImg, const cv::Mat& _oROI) {
     // == init
+    lvAssert_(_oInitImg.depth()==CV_8U || _oInitImg.type()==CV_16UC1,"SuBSENSE only supports 8-bit or single-channel 16-bit inputs");
+    cv::Mat oInitImg,oROI;
+    scaleInitData(_oInitImg,_oROI,oInitImg,oROI);
     IBackgroundSubtractorLBSP::initialize_common(oInitImg,oROI);
     m_fLastNonZeroDescRatio = 0.0f;
     const int nTotImgPixels = m_oImgSize.height*m_oImgSize.width;
@@ -126,177 +1019,246 @@ void BackgroundSubtractorSuBSENSE::initialize(const cv::Mat& oInitImg, const cv:
         m_fCurrLearningRateLowerCap = FEEDBACK_T_LOWER*2;
         m_fCurrLearningRateUpperCap = FEEDBACK_T_UPPER*2;
     }
-    m_oUpdateRateFrame.create(m_oImgSize,CV_32FC1);
-    m_oUpdateRateFrame = cv::Scalar(m_fCurrLearningRateLowerCap);
-    m_oDistThresholdFrame.create(m_oImgSize,CV_32FC1);
-    m_oDistThresholdFrame = cv::Scalar(1.0f);
-    m_oVariationModulatorFrame.create(m_oImgSize,CV_32FC1);
-    m_oVariationModulatorFrame = cv::Scalar(10.0f); // should always be >= FEEDBACK_V_DECR
-    m_oMeanLastDistFrame.create(m_oImgSize,CV_32FC1);
-    m_oMeanLastDistFrame = cv::Scalar(0.0f);
-    m_oMeanMinDistFrame_LT.create(m_oImgSize,CV_32FC1);
-    m_oMeanMinDistFrame_LT = cv::Scalar(0.0f);
-    m_oMeanMinDistFrame_ST.create(m_oImgSize,CV_32FC1);
-    m_oMeanMinDistFrame_ST = cv::Scalar(0.0f);
+    createStateMap(m_oUpdateRateFrame,STATE_UPDATE_RATE,m_oImgSize,m_bUsingCompactStateMaps,m_fCurrLearningRateLowerCap);
+    createStateMap(m_oDistThresholdFrame,STATE_DIST_THRESHOLD,m_oImgSize,m_bUsingCompactStateMaps,1.0f);
+    createStateMap(m_oVariationModulatorFrame,STATE_VARIATION_MODULATOR,m_oImgSize,m_bUsingCompactStateMaps,10.0f); // should always be >= FEEDBACK_V_DECR
+    createStateMap(m_oMeanLastDistFrame,STATE_MEAN_LAST_DIST,m_oImgSize,m_bUsingCompactStateMaps,0.0f);
+    createStateMap(m_oMeanMinDistFrame_LT,STATE_MEAN_MIN_DIST_LT,m_oImgSize,m_bUsingCompactStateMaps,0.0f);
+    createStateMap(m_oMeanMinDistFrame_ST,STATE_MEAN_MIN_DIST_ST,m_oImgSize,m_bUsingCompactStateMaps,0.0f);
     m_oDownSampledFrameSize = cv::Size(m_oImgSize.width/FRAMELEVEL_ANALYSIS_DOWNSAMPLE_RATIO,m_oImgSize.height/FRAMELEVEL_ANALYSIS_DOWNSAMPLE_RATIO);
     m_oMeanDownSampledLastDistFrame_LT.create(m_oDownSampledFrameSize,CV_32FC((int)m_nImgChannels));
     m_oMeanDownSampledLastDistFrame_LT = cv::Scalar(0.0f);
     m_oMeanDownSampledLastDistFrame_ST.create(m_oDownSampledFrameSize,CV_32FC((int)m_nImgChannels));
     m_oMeanDownSampledLastDistFrame_ST = cv::Scalar(0.0f);
-    m_oMeanRawSegmResFrame_LT.create(m_oImgSize,CV_32FC1);
-    m_oMeanRawSegmResFrame_LT = cv::Scalar(0.0f);
-    m_oMeanRawSegmResFrame_ST.create(m_oImgSize,CV_32FC1);
-    m_oMeanRawSegmResFrame_ST = cv::Scalar(0.0f);
-    m_oMeanFinalSegmResFrame_LT.create(m_oImgSize,CV_32FC1);
-    m_oMeanFinalSegmResFrame_LT = cv::Scalar(0.0f);
-    m_oMeanFinalSegmResFrame_ST.create(m_oImgSize,CV_32FC1);
-    m_oMeanFinalSegmResFrame_ST = cv::Scalar(0.0f);
+    createStateMap(m_oMeanRawSegmResFrame_LT,STATE_MEAN_RAW_SEGM_RES_LT,m_oImgSize,m_bUsingCompactStateMaps,0.0f);
+    createStateMap(m_oMeanRawSegmResFrame_ST,STATE_MEAN_RAW_SEGM_RES_ST,m_oImgSize,m_bUsingCompactStateMaps,0.0f);
+    createStateMap(m_oMeanFinalSegmResFrame_LT,STATE_MEAN_FINAL_SEGM_RES_LT,m_oImgSize,m_bUsingCompactStateMaps,0.0f);
+    createStateMap(m_oMeanFinalSegmResFrame_ST,STATE_MEAN_FINAL_SEGM_RES_ST,m_oImgSize,m_bUsingCompactStateMaps,0.0f);
     m_oUnstableRegionMask.create(m_oImgSize,CV_8UC1);
     m_oUnstableRegionMask = cv::Scalar_<uchar>(0);
     m_oBlinksFrame.create(m_oImgSize,CV_8UC1);
     m_oBlinksFrame = cv::Scalar_<uchar>(0);
-    m_oDownSampledFrame_MotionAnalysis.create(m_oDownSampledFrameSize,CV_8UC((int)m_nImgChannels));
-    m_oDownSampledFrame_MotionAnalysis = cv::Scalar_<uchar>::all(0);
+    m_oDownSampledFrame_MotionAnalysis.create(m_oDownSampledFrameSize,m_nImgType);
+    m_oDownSampledFrame_MotionAnalysis = cv::Scalar::all(0);
     m_oLastRawFGMask.create(m_oImgSize,CV_8UC1);
     m_oLastRawFGMask = cv::Scalar_<uchar>(0);
-    m_oLastFGMask_dilated.create(m_oImgSize,CV_8UC1);
-    m_oLastFGMask_dilated = cv::Scalar_<uchar>(0);
     m_oLastFGMask_dilated_inverted.create(m_oImgSize,CV_8UC1);
     m_oLastFGMask_dilated_inverted = cv::Scalar_<uchar>(0);
-    m_oFGMask_FloodedHoles.create(m_oImgSize,CV_8UC1);
-    m_oFGMask_FloodedHoles = cv::Scalar_<uchar>(0);
-    m_oFGMask_PreFlood.create(m_oImgSize,CV_8UC1);
-    m_oFGMask_PreFlood = cv::Scalar_<uchar>(0);
-    m_oCurrRawFGBlinkMask.create(m_oImgSize,CV_8UC1);
-    m_oCurrRawFGBlinkMask = cv::Scalar_<uchar>(0);
     m_oLastRawFGBlinkMask.create(m_oImgSize,CV_8UC1);
     m_oLastRawFGBlinkMask = cv::Scalar_<uchar>(0);
+    m_oBGStreakFrame.create(m_oImgSize,CV_16UC1);
+    m_oBGStreakFrame = cv::Scalar_<ushort>(0);
+    m_oStableSampleIdxFrame.create(m_oImgSize,CV_16UC1);
+    m_oStableSampleIdxFrame = cv::Scalar_<ushort>(0);
     m_oMorphExStructElement = cv::getStructuringElement(cv::MORPH_RECT,cv::Size(3,3));
-    m_voBGColorSamples.resize(m_nBGSamples);
-    m_voBGDescSamples.resize(m_nBGSamples);
-    for(size_t s=0; s<m_nBGSamples; ++s) {
-        m_voBGColorSamples[s].create(m_oImgSize,CV_8UC((int)m_nImgChannels));
-        m_voBGColorSamples[s] = cv::Scalar_<uchar>::all(0);
-        m_voBGDescSamples[s].create(m_oImgSize,CV_16UC((int)m_nImgChannels));
-        m_voBGDescSamples[s] = cv::Scalar_<ushort>::all(0);
-    }
+    m_oBGSamples.setBitSlicedDescriptors(m_bUsingBitSlicedDescs);
+    // 16-bit samples are never deduplicated, as near-identical samples are much less likely over the full intensity range
+    m_oBGSamples.create(m_oImgSize,m_nImgChannels,m_nBGSamples,m_bUsingInterleavedSamples,oInitImg.depth(),getModelMatAllocator(),(oInitImg.depth()==CV_8U)?m_nDedupSampleSlots:0);
+    m_oLastGMCFrame_Coarse.release();
+    m_oLastGMCFrame_Fine.release();
+    m_oLastGlobalMotion = cv::Point(0,0);
+    updateBandLUT();
     m_bInitialized = true;
     refreshModel(1.0f);
     m_bModelInitialized = true;
 }
 
-void BackgroundSubtractorSuBSENSE::apply(cv::InputArray _image, cv::OutputArray _fgmask, double learningRateOverride) {
-    // == process
-    lvAssert_(m_bInitialized && m_bModelInitialized,"algo & model must be initialized first");
-    cv::Mat oInputImg = _image.getMat();
-    lvAssert_(oInputImg.type()==m_nImgType && oInputImg.size()==m_oImgSize,"input image type/size mismatch with initialization type/size");
-    lvAssert_(oInputImg.isContinuous(),"input image data must be continuous");
-    _fgmask.create(m_oImgSize,CV_8UC1);
-    cv::Mat oCurrFGMask = _fgmask.getMat();
-    memset(oCurrFGMask.data,0,oCurrFGMask.cols*oCurrFGMask.rows);
+template<typename TColor, size_t nMatchChannels>
+size_t BackgroundSubtractorSuBSENSE::getColorDistThreshold(float fDistThresholdFactor, bool bUnstableRegion) const {
+    // the threshold is truncated (and halved for single-channel inputs) in the 8-bit range first, then scaled to the input intensity range
+    const size_t nColorDistThreshold = (size_t)((fDistThresholdFactor*m_nMinColorDistThreshold)-((!bUnstableRegion)*STAB_COLOR_DIST_OFFSET));
+    return ((nMatchChannels==1)?nColorDistThreshold/2:nColorDistThreshold)*getColorDistScale<TColor>();
+}
+
+size_t BackgroundSubtractorSuBSENSE::getDescDistThreshold(float fDistThresholdFactor, bool bUnstableRegion) const {
+    return ((size_t)1<<((size_t)floor(fDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(bUnstableRegion*UNSTAB_DESC_DIST_OFFSET);
+}
+
+template<typename TColor, size_t nChannels, bool bUpdatePolicy>
+void BackgroundSubtractorSuBSENSE::matchPixel(const cv::Mat& oInputImg, size_t nPxIter, size_t nMatchSlots, const TColor* anCurrColor, const ushort* anCurrIntraDesc,
+                                              std::array<std::array<TColor,LBSP::DESC_SIZE_BITS>,getMatchChannelCount(nChannels)>& aanLBSPLookupVals, bool& bLBSPLookupValsReady,
+                                              size_t nCurrSCColorDistThreshold, size_t nCurrTotColorDistThreshold, size_t nCurrTotDescDistThreshold,
+                                              PxMatchState& oMatch, size_t& nSamplesTested) const {
+    constexpr size_t nMatchChannels = getMatchChannelCount(nChannels);
+    // single-channel descriptor distances weigh half as much in the color+desc sum as those of multi-channel inputs
+    constexpr size_t nSumDescDistDiv = (nMatchChannels==1)?4:2;
+    // color distances (and the desc-to-color conversion factor of summed distances) are expressed in the intensity range of the input
+    constexpr size_t nColorDistScale = getColorDistScale<TColor>();
+    constexpr size_t nColorMaxDataRange_1ch = s_nColorMaxDataRange_1ch*nColorDistScale;
+    constexpr size_t nDescToColorDistScale = (s_nColorMaxDataRange_1ch/s_nDescMaxDataRange_1ch)*nColorDistScale;
+    const bool bUsingBlockMatching = m_bUsingBlockMatching || m_oBGSamples.isInterleaved();
+    const bool bUsingBitSlicedDescs = m_oBGSamples.isUsingBitSlicedDescriptors();
+    uint64_t nDescMatchMask = 0;
+    while(oMatch.nGoodSamplesCount<m_nRequiredBGSamples && oMatch.nSampleIdx<nMatchSlots) {
+        const size_t nSampleIdx = oMatch.nSampleIdx;
+        const size_t nBlockSampleCount = std::min(LBSPSampleModel::MATCH_BLOCK_SIZE,nMatchSlots-nSampleIdx);
+        uint nCandidateMask = bUsingBlockMatching?m_oBGSamples.getColorMatchMask(nPxIter,nSampleIdx,nBlockSampleCount,anCurrColor,nCurrSCColorDistThreshold,nCurrTotColorDistThreshold):((1u<<nBlockSampleCount)-1);
+        if(bUsingBitSlicedDescs) {
+            // exact prefilter: since each channel's nDescDist is (nIntraDescDist+nInterDescDist)/2, samples whose summed nIntraDescDist exceeds 2*nCurrTotDescDistThreshold+nMatchChannels always fail
+            if((nSampleIdx%LBSPSampleModel::DESC_PLANE_BLOCK_SIZE)==0)
+                nDescMatchMask = m_oBGSamples.getDescMatchMask(nPxIter,nSampleIdx,std::min(LBSPSampleModel::DESC_PLANE_BLOCK_SIZE,nMatchSlots-nSampleIdx),anCurrIntraDesc,nMatchChannels,nCurrTotDescDistThreshold*2+nMatchChannels);
+            nCandidateMask &= uint(nDescMatchMask>>(nSampleIdx%LBSPSampleModel::DESC_PLANE_BLOCK_SIZE));
+        }
+        while(nCandidateMask && oMatch.nGoodSamplesCount<m_nRequiredBGSamples) {
+            const size_t nCandidateIdx = nSampleIdx+lv::popcount((nCandidateMask&(~nCandidateMask+1))-1);
+            nCandidateMask &= nCandidateMask-1;
+            ++nSamplesTested;
+            const ushort* const anBGIntraDesc = m_oBGSamples.desc(nCandidateIdx,nPxIter);
+            const TColor* const anBGColor = m_oBGSamples.colorAs<TColor>(nCandidateIdx,nPxIter);
+            size_t nTotDescDist = 0;
+            size_t nTotSumDist = 0;
+            for(size_t c=0; c<nMatchChannels; ++c) {
+                const size_t nColorDist = lv::L1dist(anCurrColor[c],anBGColor[c]);
+                if(nColorDist>nCurrSCColorDistThreshold)
+                    goto failedcheck;
+                const size_t nIntraDescDist = lv::hdist(anCurrIntraDesc[c],anBGIntraDesc[c]);
+                if(!bLBSPLookupValsReady) {
+                    computeMatchLookupVals<nChannels>(oInputImg,m_voPxInfoLUT[nPxIter].nImgCoord_X,m_voPxInfoLUT[nPxIter].nImgCoord_Y,aanLBSPLookupVals);
+                    bLBSPLookupValsReady = true;
+                }
+                const ushort nCurrInterDesc = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anBGColor[c],getLBSPThreshold(anBGColor[c]));
+                const size_t nDescDist = (nIntraDescDist+lv::hdist(nCurrInterDesc,anBGIntraDesc[c]))/2;
+                const size_t nSumDist = std::min((nDescDist/nSumDescDistDiv)*nDescToColorDistScale+nColorDist,nColorMaxDataRange_1ch);
+                if(nSumDist>nCurrSCColorDistThreshold)
+                    goto failedcheck;
+                nTotDescDist += nDescDist;
+                nTotSumDist += nSumDist;
+            }
+            if(nTotDescDist>nCurrTotDescDistThreshold || nTotSumDist>nCurrTotColorDistThreshold)
+                goto failedcheck;
+            if(bUpdatePolicy) {
+                if(oMatch.nMinTotDescDist>nTotDescDist)
+                    oMatch.nMinTotDescDist = nTotDescDist;
+                if(oMatch.nMinTotSumDist>nTotSumDist) {
+                    oMatch.nMinTotSumDist = nTotSumDist;
+                    oMatch.nBestSampleIdx = nCandidateIdx;
+                }
+            }
+            oMatch.nGoodSamplesCount += m_oBGSamples.weight(nCandidateIdx,nPxIter);
+            failedcheck:;
+        }
+        oMatch.nSampleIdx += nBlockSampleCount;
+    }
+}
+
+template<typename TColor, size_t nChannels, typename TRNG>
+size_t BackgroundSubtractorSuBSENSE::applyBand(const cv::Mat& oInputImg, cv::Mat& oCurrFGMask, double learningRateOverride, float fRollAvgFactor_LT,
+                                               float fRollAvgFactor_ST, size_t nModelIterBegin, size_t nModelIterEnd, TRNG& oRNG,
+                                               size_t& nSamplesTested, size_t& nEarlyExits) {
     size_t nNonZeroDescCount = 0;
-    const float fRollAvgFactor_LT = 1.0f/std::min(++m_nFrameIdx,m_nSamplesForMovingAvgs);
-    const float fRollAvgFactor_ST = 1.0f/std::min(m_nFrameIdx,m_nSamplesForMovingAvgs/4);
-    if(m_nImgChannels==1) {
-        for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
+    // under load, the governor restricts matching & updates to the first samples of the model, and forces the (cheaper) 3x3 update spread
+    const size_t nActiveSamples = getGovernedSampleCount(m_nBGSamples,m_nRequiredBGSamples);
+    // in deduplicated layout, all slots are matched (each one counting as many matches as it holds samples), and the governor only restricts updates
+    const size_t nMatchSlots = m_oBGSamples.isDeduplicated()?m_oBGSamples.slots():nActiveSamples;
+    const bool bUse3x3Spread = m_bUse3x3Spread || getQualityKnobs().bForce3x3Spread;
+    // color thresholds & distance normalizations are expressed in the intensity range of the input (16-bit inputs are single-channel only)
+    constexpr size_t nColorDistScale = getColorDistScale<TColor>();
+    constexpr size_t nColorMaxDataRange_1ch = s_nColorMaxDataRange_1ch*nColorDistScale;
+    constexpr size_t nColorMaxDataRange_3ch = s_nColorMaxDataRange_3ch*nColorDistScale;
+    constexpr size_t nDescToColorDistScale = (s_nColorMaxDataRange_1ch/s_nDescMaxDataRange_1ch)*nColorDistScale;
+    std::array<ushort*,STATE_MAP_COUNT> apnCompactStateMaps = {};
+    if(m_bUsingCompactStateMaps) {
+        const std::array<cv::Mat*,STATE_MAP_COUNT> apStateMaps = getStateMaps();
+        for(size_t n=0; n<STATE_MAP_COUNT; ++n) {
+            lvDbgAssert(apStateMaps[n]->type()==CV_16UC1);
+            apnCompactStateMaps[n] = (ushort*)apStateMaps[n]->data;
+        }
+    }
+    static_assert(nChannels==1 || nChannels==3 || nChannels==4,"unsupported channel count");
+    lvDbgAssert(oInputImg.channels()==(int)nChannels && m_oBGSamples.channels()==nChannels);
+    if(nChannels==1) {
+        for(size_t nModelIter=nModelIterBegin; nModelIter<nModelIterEnd; ++nModelIter) {
             const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
             const size_t nDescIter = nPxIter*2;
             const size_t nFloatIter = nPxIter*4;
             const int nCurrImgCoord_X = m_voPxInfoLUT[nPxIter].nImgCoord_X;
             const int nCurrImgCoord_Y = m_voPxInfoLUT[nPxIter].nImgCoord_Y;
-            const uchar nCurrColor = oInputImg.data[nPxIter];
-            size_t nMinDescDist = s_nDescMaxDataRange_1ch;
-            size_t nMinSumDist = s_nColorMaxDataRange_1ch;
-            float* pfCurrDistThresholdFactor = (float*)(m_oDistThresholdFrame.data+nFloatIter);
-            float* pfCurrVariationFactor = (float*)(m_oVariationModulatorFrame.data+nFloatIter);
-            float* pfCurrLearningRate = ((float*)(m_oUpdateRateFrame.data+nFloatIter));
-            float* pfCurrMeanLastDist = ((float*)(m_oMeanLastDistFrame.data+nFloatIter));
-            float* pfCurrMeanMinDist_LT = ((float*)(m_oMeanMinDistFrame_LT.data+nFloatIter));
-            float* pfCurrMeanMinDist_ST = ((float*)(m_oMeanMinDistFrame_ST.data+nFloatIter));
-            float* pfCurrMeanRawSegmRes_LT = ((float*)(m_oMeanRawSegmResFrame_LT.data+nFloatIter));
-            float* pfCurrMeanRawSegmRes_ST = ((float*)(m_oMeanRawSegmResFrame_ST.data+nFloatIter));
-            float* pfCurrMeanFinalSegmRes_LT = ((float*)(m_oMeanFinalSegmResFrame_LT.data+nFloatIter));
-            float* pfCurrMeanFinalSegmRes_ST = ((float*)(m_oMeanFinalSegmResFrame_ST.data+nFloatIter));
+            const TColor nCurrColor = ((const TColor*)oInputImg.data)[nPxIter];
+            // in compact mode, the state values of the current pixel are unpacked to floats here, and packed back once updated
+            std::array<float,STATE_MAP_COUNT> afCurrCompactState;
+            if(m_bUsingCompactStateMaps)
+                for(size_t n=0; n<STATE_MAP_COUNT; ++n)
+                    afCurrCompactState[n] = apnCompactStateMaps[n][nPxIter]/s_afCompactStateScales[n];
+            float* pfCurrDistThresholdFactor = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_DIST_THRESHOLD]:(float*)(m_oDistThresholdFrame.data+nFloatIter);
+            float* pfCurrVariationFactor = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_VARIATION_MODULATOR]:(float*)(m_oVariationModulatorFrame.data+nFloatIter);
+            float* pfCurrLearningRate = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_UPDATE_RATE]:((float*)(m_oUpdateRateFrame.data+nFloatIter));
+            float* pfCurrMeanLastDist = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_LAST_DIST]:((float*)(m_oMeanLastDistFrame.data+nFloatIter));
+            float* pfCurrMeanMinDist_LT = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_MIN_DIST_LT]:((float*)(m_oMeanMinDistFrame_LT.data+nFloatIter));
+            float* pfCurrMeanMinDist_ST = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_MIN_DIST_ST]:((float*)(m_oMeanMinDistFrame_ST.data+nFloatIter));
+            float* pfCurrMeanRawSegmRes_LT = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_RAW_SEGM_RES_LT]:((float*)(m_oMeanRawSegmResFrame_LT.data+nFloatIter));
+            float* pfCurrMeanRawSegmRes_ST = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_RAW_SEGM_RES_ST]:((float*)(m_oMeanRawSegmResFrame_ST.data+nFloatIter));
+            float* pfCurrMeanFinalSegmRes_LT = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_FINAL_SEGM_RES_LT]:((float*)(m_oMeanFinalSegmResFrame_LT.data+nFloatIter));
+            float* pfCurrMeanFinalSegmRes_ST = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_FINAL_SEGM_RES_ST]:((float*)(m_oMeanFinalSegmResFrame_ST.data+nFloatIter));
             ushort& nLastIntraDesc = *((ushort*)(m_oLastDescFrame.data+nDescIter));
-            uchar& nLastColor = m_oLastColorFrame.data[nPxIter];
-            const size_t nCurrColorDistThreshold = (size_t)(((*pfCurrDistThresholdFactor)*m_nMinColorDistThreshold)-((!m_oUnstableRegionMask.data[nPxIter])*STAB_COLOR_DIST_OFFSET))/2;
-            const size_t nCurrDescDistThreshold = ((size_t)1<<((size_t)floor(*pfCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(m_oUnstableRegionMask.data[nPxIter]*UNSTAB_DESC_DIST_OFFSET);
-            alignas(16) std::array<uchar,LBSP::DESC_SIZE_BITS> anLBSPLookupVals;
-            LBSP::computeDescriptor_lookup<1>(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,0,anLBSPLookupVals);
-            const ushort nCurrIntraDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nCurrColor,m_anLBSPThreshold_8bitLUT[nCurrColor]);
+            TColor& nLastColor = ((TColor*)m_oLastColorFrame.data)[nPxIter];
+            const size_t nCurrColorDistThreshold = getColorDistThreshold<TColor,1>(*pfCurrDistThresholdFactor,m_oUnstableRegionMask.data[nPxIter]!=0);
+            const size_t nCurrDescDistThreshold = getDescDistThreshold(*pfCurrDistThresholdFactor,m_oUnstableRegionMask.data[nPxIter]!=0);
+            alignas(16) std::array<std::array<TColor,LBSP::DESC_SIZE_BITS>,1> aanLBSPLookupVals;
+            const bool bUsingCachedDesc = m_bUsingDescCache && m_oDescCacheValidMask.data[nPxIter];
+            bool bLBSPLookupValsReady = !bUsingCachedDesc;
+            if(bLBSPLookupValsReady)
+                computeMatchLookupVals<1>(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,aanLBSPLookupVals);
+            const ushort nCurrIntraDesc = bUsingCachedDesc?nLastIntraDesc:LBSP::computeDescriptor_threshold(aanLBSPLookupVals[0],nCurrColor,getLBSPThreshold(nCurrColor));
             m_oUnstableRegionMask.data[nPxIter] = ((*pfCurrDistThresholdFactor)>UNSTABLE_REG_RDIST_MIN || (*pfCurrMeanRawSegmRes_LT-*pfCurrMeanFinalSegmRes_LT)>UNSTABLE_REG_RATIO_MIN || (*pfCurrMeanRawSegmRes_ST-*pfCurrMeanFinalSegmRes_ST)>UNSTABLE_REG_RATIO_MIN)?1:0;
-            size_t nGoodSamplesCount=0, nSampleIdx=0;
-            while(nGoodSamplesCount<m_nRequiredBGSamples && nSampleIdx<m_nBGSamples) {
-                const uchar& nBGColor = m_voBGColorSamples[nSampleIdx].data[nPxIter];
-                {
-                    const size_t nColorDist = lv::L1dist(nCurrColor,nBGColor);
-                    if(nColorDist>nCurrColorDistThreshold)
-                        goto failedcheck1ch;
-                    const ushort& nBGIntraDesc = *((ushort*)(m_voBGDescSamples[nSampleIdx].data+nDescIter));
-                    const size_t nIntraDescDist = lv::hdist(nCurrIntraDesc,nBGIntraDesc);
-                    const ushort nCurrInterDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nBGColor,m_anLBSPThreshold_8bitLUT[nBGColor]);
-                    const size_t nInterDescDist = lv::hdist(nCurrInterDesc,nBGIntraDesc);
-                    const size_t nDescDist = (nIntraDescDist+nInterDescDist)/2;
-                    if(nDescDist>nCurrDescDistThreshold)
-                        goto failedcheck1ch;
-                    const size_t nSumDist = std::min((nDescDist/4)*(s_nColorMaxDataRange_1ch/s_nDescMaxDataRange_1ch)+nColorDist,s_nColorMaxDataRange_1ch);
-                    if(nSumDist>nCurrColorDistThreshold)
-                        goto failedcheck1ch;
-                    if(nMinDescDist>nDescDist)
-                        nMinDescDist = nDescDist;
-                    if(nMinSumDist>nSumDist)
-                        nMinSumDist = nSumDist;
-                    nGoodSamplesCount++;
+            ushort& nCurrBGStreak = ((ushort*)m_oBGStreakFrame.data)[nPxIter];
+            ushort& nCurrStableSampleIdx = ((ushort*)m_oStableSampleIdxFrame.data)[nPxIter];
+            PxMatchState oMatch = {0,0,s_nDescMaxDataRange_1ch,nColorMaxDataRange_1ch,nCurrStableSampleIdx};
+            if(m_bUsingStabilityShortcut && nCurrBGStreak>=m_nStabilityMinBGStreak && *pfCurrMeanLastDist<=m_fStabilityMaxMeanLastDist && !m_oUnstableRegionMask.data[nPxIter] && m_oBGSamples.weight(nCurrStableSampleIdx,nPxIter)) {
+                // long-stable BG px: a tight color check against the last best-matching sample (and a free texture check against
+                // the last frame) replaces full matching; if it fails, the regular matching loop below runs as usual
+                ++nSamplesTested;
+                const TColor nBGColor = *m_oBGSamples.colorAs<TColor>(nCurrStableSampleIdx,nPxIter);
+                const size_t nColorDist = lv::L1dist(nCurrColor,nBGColor);
+                if(nColorDist<=nCurrColorDistThreshold/2 && lv::hdist(nLastIntraDesc,nCurrIntraDesc)<=nCurrDescDistThreshold/2) {
+                    oMatch.nMinTotDescDist = lv::hdist(nCurrIntraDesc,*m_oBGSamples.desc(nCurrStableSampleIdx,nPxIter));
+                    oMatch.nMinTotSumDist = std::min((oMatch.nMinTotDescDist/4)*nDescToColorDistScale+nColorDist,nColorMaxDataRange_1ch);
+                    oMatch.nGoodSamplesCount = m_nRequiredBGSamples;
                 }
-                failedcheck1ch:
-                nSampleIdx++;
             }
-            const float fNormalizedLastDist = ((float)lv::L1dist(nLastColor,nCurrColor)/s_nColorMaxDataRange_1ch+(float)lv::hdist(nLastIntraDesc,nCurrIntraDesc)/s_nDescMaxDataRange_1ch)/2;
+            matchPixel<TColor,1,true>(oInputImg,nPxIter,nMatchSlots,&nCurrColor,&nCurrIntraDesc,aanLBSPLookupVals,bLBSPLookupValsReady,
+                               nCurrColorDistThreshold,nCurrColorDistThreshold,nCurrDescDistThreshold,oMatch,nSamplesTested);
+            const size_t nGoodSamplesCount = oMatch.nGoodSamplesCount, nMinDescDist = oMatch.nMinTotDescDist, nMinSumDist = oMatch.nMinTotSumDist;
+            if(oMatch.nSampleIdx<nMatchSlots)
+                ++nEarlyExits;
+            const float fNormalizedLastDist = ((float)lv::L1dist(nLastColor,nCurrColor)/nColorMaxDataRange_1ch+(float)lv::hdist(nLastIntraDesc,nCurrIntraDesc)/s_nDescMaxDataRange_1ch)/2;
             *pfCurrMeanLastDist = (*pfCurrMeanLastDist)*(1.0f-fRollAvgFactor_ST) + fNormalizedLastDist*fRollAvgFactor_ST;
             if(nGoodSamplesCount<m_nRequiredBGSamples) {
                 // == foreground
-                const float fNormalizedMinDist = std::min(1.0f,((float)nMinSumDist/s_nColorMaxDataRange_1ch+(float)nMinDescDist/s_nDescMaxDataRange_1ch)/2 + (float)(m_nRequiredBGSamples-nGoodSamplesCount)/m_nRequiredBGSamples);
+                nCurrBGStreak = 0;
+                const float fNormalizedMinDist = std::min(1.0f,((float)nMinSumDist/nColorMaxDataRange_1ch+(float)nMinDescDist/s_nDescMaxDataRange_1ch)/2 + (float)(m_nRequiredBGSamples-nGoodSamplesCount)/m_nRequiredBGSamples);
                 *pfCurrMeanMinDist_LT = (*pfCurrMeanMinDist_LT)*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
                 *pfCurrMeanMinDist_ST = (*pfCurrMeanMinDist_ST)*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
                 *pfCurrMeanRawSegmRes_LT = (*pfCurrMeanRawSegmRes_LT)*(1.0f-fRollAvgFactor_LT) + fRollAvgFactor_LT;
                 *pfCurrMeanRawSegmRes_ST = (*pfCurrMeanRawSegmRes_ST)*(1.0f-fRollAvgFactor_ST) + fRollAvgFactor_ST;
                 oCurrFGMask.data[nPxIter] = UCHAR_MAX;
-                if(m_nModelResetCooldown && (rand()%(size_t)FEEDBACK_T_LOWER)==0) {
-                    const size_t s_rand = rand()%m_nBGSamples;
-                    *((ushort*)(m_voBGDescSamples[s_rand].data+nDescIter)) = nCurrIntraDesc;
-                    m_voBGColorSamples[s_rand].data[nPxIter] = nCurrColor;
+                if(m_nModelResetCooldown && (oRNG()%(size_t)FEEDBACK_T_LOWER)==0) {
+                    const size_t s_rand = oRNG()%nActiveSamples;
+                    m_oBGSamples.setSample<1>(s_rand,nPxIter,&nCurrColor,&nCurrIntraDesc);
                 }
             }
             else {
                 // == background
-                const float fNormalizedMinDist = ((float)nMinSumDist/s_nColorMaxDataRange_1ch+(float)nMinDescDist/s_nDescMaxDataRange_1ch)/2;
+                nCurrBGStreak = (ushort)std::min((size_t)nCurrBGStreak+1,(size_t)USHRT_MAX);
+                nCurrStableSampleIdx = (ushort)oMatch.nBestSampleIdx;
+                const float fNormalizedMinDist = ((float)nMinSumDist/nColorMaxDataRange_1ch+(float)nMinDescDist/s_nDescMaxDataRange_1ch)/2;
                 *pfCurrMeanMinDist_LT = (*pfCurrMeanMinDist_LT)*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
                 *pfCurrMeanMinDist_ST = (*pfCurrMeanMinDist_ST)*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
                 *pfCurrMeanRawSegmRes_LT = (*pfCurrMeanRawSegmRes_LT)*(1.0f-fRollAvgFactor_LT);
                 *pfCurrMeanRawSegmRes_ST = (*pfCurrMeanRawSegmRes_ST)*(1.0f-fRollAvgFactor_ST);
-                const size_t nLearningRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)ceil(*pfCurrLearningRate));
-                if((rand()%nLearningRate)==0) {
-                    const size_t s_rand = rand()%m_nBGSamples;
-                    *((ushort*)(m_voBGDescSamples[s_rand].data+nDescIter)) = nCurrIntraDesc;
-                    m_voBGColorSamples[s_rand].data[nPxIter] = nCurrColor;
+                const size_t nLearningRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)ceil(getGovernedLearningRate(getCompensatedLearningRate(*pfCurrLearningRate))));
+                if((oRNG()%nLearningRate)==0) {
+                    const size_t s_rand = oRNG()%nActiveSamples;
+                    m_oBGSamples.setSample<1>(s_rand,nPxIter,&nCurrColor,&nCurrIntraDesc);
                 }
-                int nSampleImgCoord_Y, nSampleImgCoord_X;
-                const bool bCurrUsing3x3Spread = m_bUse3x3Spread && !m_oUnstableRegionMask.data[nPxIter];
-                if(bCurrUsing3x3Spread)
-                    cv::getRandNeighborPosition_3x3(nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                else
-                    cv::getRandNeighborPosition_5x5(nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                const size_t n_rand = rand();
-                const size_t idx_rand_uchar = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
-                const size_t idx_rand_flt32 = idx_rand_uchar*4;
-                const float fRandMeanLastDist = *((float*)(m_oMeanLastDistFrame.data+idx_rand_flt32));
-                const float fRandMeanRawSegmRes = *((float*)(m_oMeanRawSegmResFrame_ST.data+idx_rand_flt32));
+                const bool bCurrUsing3x3Spread = bUse3x3Spread && !m_oUnstableRegionMask.data[nPxIter];
+                const size_t idx_rand_uchar = bCurrUsing3x3Spread?m_oRandNeighborLUT_3x3.getRandIdx(nPxIter,oRNG):m_oRandNeighborLUT_5x5.getRandIdx(nPxIter,oRNG);
+                const size_t n_rand = oRNG();
+                const float fRandMeanLastDist = getStateValue(m_oMeanLastDistFrame,STATE_MEAN_LAST_DIST,idx_rand_uchar);
+                const float fRandMeanRawSegmRes = getStateValue(m_oMeanRawSegmResFrame_ST,STATE_MEAN_RAW_SEGM_RES_ST,idx_rand_uchar);
                 if((n_rand%(bCurrUsing3x3Spread?nLearningRate:(nLearningRate/2+1)))==0
                     || (fRandMeanRawSegmRes>GHOSTDET_S_MIN && fRandMeanLastDist<GHOSTDET_D_MAX && (n_rand%((size_t)m_fCurrLearningRateLowerCap))==0)) {
-                    const size_t idx_rand_ushrt = idx_rand_uchar*2;
-                    const size_t s_rand = rand()%m_nBGSamples;
-                    *((ushort*)(m_voBGDescSamples[s_rand].data+idx_rand_ushrt)) = nCurrIntraDesc;
-                    m_voBGColorSamples[s_rand].data[idx_rand_uchar] = nCurrColor;
+                    const size_t s_rand = oRNG()%nActiveSamples;
+                    m_oBGSamples.setSample<1>(s_rand,idx_rand_uchar,&nCurrColor,&nCurrIntraDesc);
                 }
             }
             if(m_oLastFGMask.data[nPxIter] || (std::min(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)<UNSTABLE_REG_RATIO_MIN && oCurrFGMask.data[nPxIter])) {
@@ -323,129 +1285,118 @@ void BackgroundSubtractorSuBSENSE::apply(cv::InputArray _image, cv::OutputArray
                 if((*pfCurrDistThresholdFactor)<1.0f)
                     (*pfCurrDistThresholdFactor) = 1.0f;
             }
+            if(m_bUsingCompactStateMaps)
+                for(size_t n=0; n<STATE_MAP_COUNT; ++n)
+                    apnCompactStateMaps[n][nPxIter] = cv::saturate_cast<ushort>(afCurrCompactState[n]*s_afCompactStateScales[n]);
             if(lv::popcount(nCurrIntraDesc)>=2)
                 ++nNonZeroDescCount;
             nLastIntraDesc = nCurrIntraDesc;
             nLastColor = nCurrColor;
         }
     }
-    else { //m_nImgChannels==3
-        for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
+    else { //nChannels==3 || nChannels==4
+        constexpr size_t nMatchChannels = getMatchChannelCount(nChannels);
+        for(size_t nModelIter=nModelIterBegin; nModelIter<nModelIterEnd; ++nModelIter) {
             const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
             const int nCurrImgCoord_X = m_voPxInfoLUT[nPxIter].nImgCoord_X;
             const int nCurrImgCoord_Y = m_voPxInfoLUT[nPxIter].nImgCoord_Y;
-            const size_t nPxIterRGB = nPxIter*3;
+            const size_t nPxIterRGB = nPxIter*nChannels;
             const size_t nDescIterRGB = nPxIterRGB*2;
             const size_t nFloatIter = nPxIter*4;
-            const uchar* const anCurrColor = oInputImg.data+nPxIterRGB;
-            size_t nMinTotDescDist=s_nDescMaxDataRange_3ch;
-            size_t nMinTotSumDist=s_nColorMaxDataRange_3ch;
-            float* pfCurrDistThresholdFactor = (float*)(m_oDistThresholdFrame.data+nFloatIter);
-            float* pfCurrVariationFactor = (float*)(m_oVariationModulatorFrame.data+nFloatIter);
-            float* pfCurrLearningRate = ((float*)(m_oUpdateRateFrame.data+nFloatIter));
-            float* pfCurrMeanLastDist = ((float*)(m_oMeanLastDistFrame.data+nFloatIter));
-            float* pfCurrMeanMinDist_LT = ((float*)(m_oMeanMinDistFrame_LT.data+nFloatIter));
-            float* pfCurrMeanMinDist_ST = ((float*)(m_oMeanMinDistFrame_ST.data+nFloatIter));
-            float* pfCurrMeanRawSegmRes_LT = ((float*)(m_oMeanRawSegmResFrame_LT.data+nFloatIter));
-            float* pfCurrMeanRawSegmRes_ST = ((float*)(m_oMeanRawSegmResFrame_ST.data+nFloatIter));
-            float* pfCurrMeanFinalSegmRes_LT = ((float*)(m_oMeanFinalSegmResFrame_LT.data+nFloatIter));
-            float* pfCurrMeanFinalSegmRes_ST = ((float*)(m_oMeanFinalSegmResFrame_ST.data+nFloatIter));
+            const TColor* const anCurrColor = ((const TColor*)oInputImg.data)+nPxIterRGB;
+            // in compact mode, the state values of the current pixel are unpacked to floats here, and packed back once updated
+            std::array<float,STATE_MAP_COUNT> afCurrCompactState;
+            if(m_bUsingCompactStateMaps)
+                for(size_t n=0; n<STATE_MAP_COUNT; ++n)
+                    afCurrCompactState[n] = apnCompactStateMaps[n][nPxIter]/s_afCompactStateScales[n];
+            float* pfCurrDistThresholdFactor = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_DIST_THRESHOLD]:(float*)(m_oDistThresholdFrame.data+nFloatIter);
+            float* pfCurrVariationFactor = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_VARIATION_MODULATOR]:(float*)(m_oVariationModulatorFrame.data+nFloatIter);
+            float* pfCurrLearningRate = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_UPDATE_RATE]:((float*)(m_oUpdateRateFrame.data+nFloatIter));
+            float* pfCurrMeanLastDist = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_LAST_DIST]:((float*)(m_oMeanLastDistFrame.data+nFloatIter));
+            float* pfCurrMeanMinDist_LT = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_MIN_DIST_LT]:((float*)(m_oMeanMinDistFrame_LT.data+nFloatIter));
+            float* pfCurrMeanMinDist_ST = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_MIN_DIST_ST]:((float*)(m_oMeanMinDistFrame_ST.data+nFloatIter));
+            float* pfCurrMeanRawSegmRes_LT = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_RAW_SEGM_RES_LT]:((float*)(m_oMeanRawSegmResFrame_LT.data+nFloatIter));
+            float* pfCurrMeanRawSegmRes_ST = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_RAW_SEGM_RES_ST]:((float*)(m_oMeanRawSegmResFrame_ST.data+nFloatIter));
+            float* pfCurrMeanFinalSegmRes_LT = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_FINAL_SEGM_RES_LT]:((float*)(m_oMeanFinalSegmResFrame_LT.data+nFloatIter));
+            float* pfCurrMeanFinalSegmRes_ST = m_bUsingCompactStateMaps?&afCurrCompactState[STATE_MEAN_FINAL_SEGM_RES_ST]:((float*)(m_oMeanFinalSegmResFrame_ST.data+nFloatIter));
             ushort* anLastIntraDesc = ((ushort*)(m_oLastDescFrame.data+nDescIterRGB));
-            uchar* anLastColor = m_oLastColorFrame.data+nPxIterRGB;
-            const size_t nCurrColorDistThreshold = (size_t)(((*pfCurrDistThresholdFactor)*m_nMinColorDistThreshold)-((!m_oUnstableRegionMask.data[nPxIter])*STAB_COLOR_DIST_OFFSET));
-            const size_t nCurrDescDistThreshold = ((size_t)1<<((size_t)floor(*pfCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(m_oUnstableRegionMask.data[nPxIter]*UNSTAB_DESC_DIST_OFFSET);
-            const size_t nCurrTotColorDistThreshold = nCurrColorDistThreshold*3;
-            const size_t nCurrTotDescDistThreshold = nCurrDescDistThreshold*3;
+            TColor* anLastColor = ((TColor*)m_oLastColorFrame.data)+nPxIterRGB;
+            const size_t nCurrColorDistThreshold = getColorDistThreshold<TColor,nMatchChannels>(*pfCurrDistThresholdFactor,m_oUnstableRegionMask.data[nPxIter]!=0);
+            const size_t nCurrDescDistThreshold = getDescDistThreshold(*pfCurrDistThresholdFactor,m_oUnstableRegionMask.data[nPxIter]!=0);
+            const size_t nCurrTotColorDistThreshold = nCurrColorDistThreshold*nMatchChannels;
+            const size_t nCurrTotDescDistThreshold = nCurrDescDistThreshold*nMatchChannels;
             const size_t nCurrSCColorDistThreshold = nCurrTotColorDistThreshold/2;
-            alignas(16) std::array<std::array<uchar,LBSP::DESC_SIZE_BITS>,3> aanLBSPLookupVals;
-            LBSP::computeDescriptor_lookup(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,aanLBSPLookupVals);
-            std::array<ushort,3> anCurrIntraDesc;
-            for(size_t c=0; c<3; ++c)
-                anCurrIntraDesc[c] = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anCurrColor[c],m_anLBSPThreshold_8bitLUT[anCurrColor[c]]);
+            alignas(16) std::array<std::array<TColor,LBSP::DESC_SIZE_BITS>,nMatchChannels> aanLBSPLookupVals;
+            const bool bUsingCachedDesc = m_bUsingDescCache && m_oDescCacheValidMask.data[nPxIter];
+            bool bLBSPLookupValsReady = !bUsingCachedDesc;
+            std::array<ushort,nChannels> anCurrIntraDesc = {}; // padding channel descriptors stay null, as in initialize_common
+            if(bUsingCachedDesc)
+                std::copy_n(anLastIntraDesc,nChannels,anCurrIntraDesc.begin());
+            else {
+                computeMatchLookupVals<nChannels>(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,aanLBSPLookupVals);
+                for(size_t c=0; c<nMatchChannels; ++c)
+                    anCurrIntraDesc[c] = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anCurrColor[c],getLBSPThreshold(anCurrColor[c]));
+            }
             m_oUnstableRegionMask.data[nPxIter] = ((*pfCurrDistThresholdFactor)>UNSTABLE_REG_RDIST_MIN || (*pfCurrMeanRawSegmRes_LT-*pfCurrMeanFinalSegmRes_LT)>UNSTABLE_REG_RATIO_MIN || (*pfCurrMeanRawSegmRes_ST-*pfCurrMeanFinalSegmRes_ST)>UNSTABLE_REG_RATIO_MIN)?1:0;
-            size_t nGoodSamplesCount=0, nSampleIdx=0;
-            while(nGoodSamplesCount<m_nRequiredBGSamples && nSampleIdx<m_nBGSamples) {
-                const ushort* const anBGIntraDesc = (ushort*)(m_voBGDescSamples[nSampleIdx].data+nDescIterRGB);
-                const uchar* const anBGColor = m_voBGColorSamples[nSampleIdx].data+nPxIterRGB;
-                size_t nTotDescDist = 0;
-                size_t nTotSumDist = 0;
-                for(size_t c=0;c<3; ++c) {
-                    const size_t nColorDist = lv::L1dist(anCurrColor[c],anBGColor[c]);
-                    if(nColorDist>nCurrSCColorDistThreshold)
-                        goto failedcheck3ch;
-                    const size_t nIntraDescDist = lv::hdist(anCurrIntraDesc[c],anBGIntraDesc[c]);
-                    const ushort nCurrInterDesc = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anBGColor[c],m_anLBSPThreshold_8bitLUT[anBGColor[c]]);
-                    const size_t nInterDescDist = lv::hdist(nCurrInterDesc,anBGIntraDesc[c]);
-                    const size_t nDescDist = (nIntraDescDist+nInterDescDist)/2;
-                    const size_t nSumDist = std::min((nDescDist/2)*(s_nColorMaxDataRange_1ch/s_nDescMaxDataRange_1ch)+nColorDist,s_nColorMaxDataRange_1ch);
-                    if(nSumDist>nCurrSCColorDistThreshold)
-                        goto failedcheck3ch;
-                    nTotDescDist += nDescDist;
-                    nTotSumDist += nSumDist;
+            ushort& nCurrBGStreak = ((ushort*)m_oBGStreakFrame.data)[nPxIter];
+            ushort& nCurrStableSampleIdx = ((ushort*)m_oStableSampleIdxFrame.data)[nPxIter];
+            PxMatchState oMatch = {0,0,s_nDescMaxDataRange_3ch,nColorMaxDataRange_3ch,nCurrStableSampleIdx};
+            if(m_bUsingStabilityShortcut && nCurrBGStreak>=m_nStabilityMinBGStreak && *pfCurrMeanLastDist<=m_fStabilityMaxMeanLastDist && !m_oUnstableRegionMask.data[nPxIter] && m_oBGSamples.weight(nCurrStableSampleIdx,nPxIter)) {
+                // long-stable BG px: a tight color check against the last best-matching sample (and a free texture check against
+                // the last frame) replaces full matching; if it fails, the regular matching loop below runs as usual
+                ++nSamplesTested;
+                const TColor* const anBGColor = m_oBGSamples.colorAs<TColor>(nCurrStableSampleIdx,nPxIter);
+                const size_t nTotColorDist = lv::L1dist<nMatchChannels>(anCurrColor,anBGColor);
+                if(nTotColorDist<=nCurrTotColorDistThreshold/2 && lv::hdist<nMatchChannels>(anLastIntraDesc,anCurrIntraDesc.data())<=nCurrTotDescDistThreshold/2) {
+                    oMatch.nMinTotDescDist = lv::hdist<nMatchChannels>(anCurrIntraDesc.data(),m_oBGSamples.desc(nCurrStableSampleIdx,nPxIter));
+                    oMatch.nMinTotSumDist = std::min((oMatch.nMinTotDescDist/2)*nDescToColorDistScale+nTotColorDist,nColorMaxDataRange_3ch);
+                    oMatch.nGoodSamplesCount = m_nRequiredBGSamples;
                 }
-                if(nTotDescDist>nCurrTotDescDistThreshold || nTotSumDist>nCurrTotColorDistThreshold)
-                    goto failedcheck3ch;
-                if(nMinTotDescDist>nTotDescDist)
-                    nMinTotDescDist = nTotDescDist;
-                if(nMinTotSumDist>nTotSumDist)
-                    nMinTotSumDist = nTotSumDist;
-                nGoodSamplesCount++;
-                failedcheck3ch:
-                nSampleIdx++;
-            }
-            const float fNormalizedLastDist = ((float)lv::L1dist<3>(anLastColor,anCurrColor)/s_nColorMaxDataRange_3ch+(float)lv::hdist<3>(anLastIntraDesc,anCurrIntraDesc)/s_nDescMaxDataRange_3ch)/2;
+            }
+            matchPixel<TColor,nChannels,true>(oInputImg,nPxIter,nMatchSlots,anCurrColor,anCurrIntraDesc.data(),aanLBSPLookupVals,bLBSPLookupValsReady,
+                                       nCurrSCColorDistThreshold,nCurrTotColorDistThreshold,nCurrTotDescDistThreshold,oMatch,nSamplesTested);
+            const size_t nGoodSamplesCount = oMatch.nGoodSamplesCount, nMinTotDescDist = oMatch.nMinTotDescDist, nMinTotSumDist = oMatch.nMinTotSumDist;
+            if(oMatch.nSampleIdx<nMatchSlots)
+                ++nEarlyExits;
+            const float fNormalizedLastDist = ((float)lv::L1dist<nMatchChannels>(anLastColor,anCurrColor)/nColorMaxDataRange_3ch+(float)lv::hdist<nMatchChannels>(anLastIntraDesc,anCurrIntraDesc.data())/s_nDescMaxDataRange_3ch)/2;
             *pfCurrMeanLastDist = (*pfCurrMeanLastDist)*(1.0f-fRollAvgFactor_ST) + fNormalizedLastDist*fRollAvgFactor_ST;
             if(nGoodSamplesCount<m_nRequiredBGSamples) {
                 // == foreground
-                const float fNormalizedMinDist = std::min(1.0f,((float)nMinTotSumDist/s_nColorMaxDataRange_3ch+(float)nMinTotDescDist/s_nDescMaxDataRange_3ch)/2 + (float)(m_nRequiredBGSamples-nGoodSamplesCount)/m_nRequiredBGSamples);
+                nCurrBGStreak = 0;
+                const float fNormalizedMinDist = std::min(1.0f,((float)nMinTotSumDist/nColorMaxDataRange_3ch+(float)nMinTotDescDist/s_nDescMaxDataRange_3ch)/2 + (float)(m_nRequiredBGSamples-nGoodSamplesCount)/m_nRequiredBGSamples);
                 *pfCurrMeanMinDist_LT = (*pfCurrMeanMinDist_LT)*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
                 *pfCurrMeanMinDist_ST = (*pfCurrMeanMinDist_ST)*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
                 *pfCurrMeanRawSegmRes_LT = (*pfCurrMeanRawSegmRes_LT)*(1.0f-fRollAvgFactor_LT) + fRollAvgFactor_LT;
                 *pfCurrMeanRawSegmRes_ST = (*pfCurrMeanRawSegmRes_ST)*(1.0f-fRollAvgFactor_ST) + fRollAvgFactor_ST;
                 oCurrFGMask.data[nPxIter] = UCHAR_MAX;
-                if(m_nModelResetCooldown && (rand()%(size_t)FEEDBACK_T_LOWER)==0) {
-                    const size_t s_rand = rand()%m_nBGSamples;
-                    for(size_t c=0; c<3; ++c) {
-                        *((ushort*)(m_voBGDescSamples[s_rand].data+nDescIterRGB+2*c)) = anCurrIntraDesc[c];
-                        *(m_voBGColorSamples[s_rand].data+nPxIterRGB+c) = anCurrColor[c];
-                    }
+                if(m_nModelResetCooldown && (oRNG()%(size_t)FEEDBACK_T_LOWER)==0) {
+                    const size_t s_rand = oRNG()%nActiveSamples;
+                    m_oBGSamples.setSample<nChannels>(s_rand,nPxIter,anCurrColor,anCurrIntraDesc.data());
                 }
             }
             else {
                 // == background
-                const float fNormalizedMinDist = ((float)nMinTotSumDist/s_nColorMaxDataRange_3ch+(float)nMinTotDescDist/s_nDescMaxDataRange_3ch)/2;
+                nCurrBGStreak = (ushort)std::min((size_t)nCurrBGStreak+1,(size_t)USHRT_MAX);
+                nCurrStableSampleIdx = (ushort)oMatch.nBestSampleIdx;
+                const float fNormalizedMinDist = ((float)nMinTotSumDist/nColorMaxDataRange_3ch+(float)nMinTotDescDist/s_nDescMaxDataRange_3ch)/2;
                 *pfCurrMeanMinDist_LT = (*pfCurrMeanMinDist_LT)*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
                 *pfCurrMeanMinDist_ST = (*pfCurrMeanMinDist_ST)*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
                 *pfCurrMeanRawSegmRes_LT = (*pfCurrMeanRawSegmRes_LT)*(1.0f-fRollAvgFactor_LT);
                 *pfCurrMeanRawSegmRes_ST = (*pfCurrMeanRawSegmRes_ST)*(1.0f-fRollAvgFactor_ST);
-                const size_t nLearningRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)ceil(*pfCurrLearningRate));
-                if((rand()%nLearningRate)==0) {
-                    const size_t s_rand = rand()%m_nBGSamples;
-                    for(size_t c=0; c<3; ++c) {
-                        *((ushort*)(m_voBGDescSamples[s_rand].data+nDescIterRGB+2*c)) = anCurrIntraDesc[c];
-                        *(m_voBGColorSamples[s_rand].data+nPxIterRGB+c) = anCurrColor[c];
-                    }
+                const size_t nLearningRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)ceil(getGovernedLearningRate(getCompensatedLearningRate(*pfCurrLearningRate))));
+                if((oRNG()%nLearningRate)==0) {
+                    const size_t s_rand = oRNG()%nActiveSamples;
+                    m_oBGSamples.setSample<nChannels>(s_rand,nPxIter,anCurrColor,anCurrIntraDesc.data());
                 }
-                int nSampleImgCoord_Y, nSampleImgCoord_X;
-                const bool bCurrUsing3x3Spread = m_bUse3x3Spread && !m_oUnstableRegionMask.data[nPxIter];
-                if(bCurrUsing3x3Spread)
-                    cv::getRandNeighborPosition_3x3(nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                else
-                    cv::getRandNeighborPosition_5x5(nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                const size_t n_rand = rand();
-                const size_t idx_rand_uchar = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
-                const size_t idx_rand_flt32 = idx_rand_uchar*4;
-                const float fRandMeanLastDist = *((float*)(m_oMeanLastDistFrame.data+idx_rand_flt32));
-                const float fRandMeanRawSegmRes = *((float*)(m_oMeanRawSegmResFrame_ST.data+idx_rand_flt32));
+                const bool bCurrUsing3x3Spread = bUse3x3Spread && !m_oUnstableRegionMask.data[nPxIter];
+                const size_t idx_rand_uchar = bCurrUsing3x3Spread?m_oRandNeighborLUT_3x3.getRandIdx(nPxIter,oRNG):m_oRandNeighborLUT_5x5.getRandIdx(nPxIter,oRNG);
+                const size_t n_rand = oRNG();
+                const float fRandMeanLastDist = getStateValue(m_oMeanLastDistFrame,STATE_MEAN_LAST_DIST,idx_rand_uchar);
+                const float fRandMeanRawSegmRes = getStateValue(m_oMeanRawSegmResFrame_ST,STATE_MEAN_RAW_SEGM_RES_ST,idx_rand_uchar);
                 if((n_rand%(bCurrUsing3x3Spread?nLearningRate:(nLearningRate/2+1)))==0
                     || (fRandMeanRawSegmRes>GHOSTDET_S_MIN && fRandMeanLastDist<GHOSTDET_D_MAX && (n_rand%((size_t)m_fCurrLearningRateLowerCap))==0)) {
-                    const size_t idx_rand_uchar_rgb = idx_rand_uchar*3;
-                    const size_t idx_rand_ushrt_rgb = idx_rand_uchar_rgb*2;
-                    const size_t s_rand = rand()%m_nBGSamples;
-                    for(size_t c=0; c<3; ++c) {
-                        *((ushort*)(m_voBGDescSamples[s_rand].data+idx_rand_ushrt_rgb+2*c)) = anCurrIntraDesc[c];
-                        *(m_voBGColorSamples[s_rand].data+idx_rand_uchar_rgb+c) = anCurrColor[c];
-                    }
+                    const size_t s_rand = oRNG()%nActiveSamples;
+                    m_oBGSamples.setSample<nChannels>(s_rand,idx_rand_uchar,anCurrColor,anCurrIntraDesc.data());
                 }
             }
             if(m_oLastFGMask.data[nPxIter] || (std::min(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)<UNSTABLE_REG_RATIO_MIN && oCurrFGMask.data[nPxIter])) {
@@ -472,14 +1423,194 @@ void BackgroundSubtractorSuBSENSE::apply(cv::InputArray _image, cv::OutputArray
                 if((*pfCurrDistThresholdFactor)<1.0f)
                     (*pfCurrDistThresholdFactor) = 1.0f;
             }
-            if(lv::popcount<3>(anCurrIntraDesc)>=4)
+            if(m_bUsingCompactStateMaps)
+                for(size_t n=0; n<STATE_MAP_COUNT; ++n)
+                    apnCompactStateMaps[n][nPxIter] = cv::saturate_cast<ushort>(afCurrCompactState[n]*s_afCompactStateScales[n]);
+            if(lv::popcount<nMatchChannels>(anCurrIntraDesc.data())>=4)
                 ++nNonZeroDescCount;
-            for(size_t c=0; c<3; ++c) {
+            for(size_t c=0; c<nChannels; ++c) {
                 anLastIntraDesc[c] = anCurrIntraDesc[c];
                 anLastColor[c] = anCurrColor[c];
             }
         }
     }
+    return nNonZeroDescCount;
+}
+
+template<typename TColor, size_t nChannels>
+void BackgroundSubtractorSuBSENSE::classifyBand(const cv::Mat& oInputImg, cv::Mat& oCurrFGMask, size_t nModelIterBegin, size_t nModelIterEnd, const uchar* pnPxMask) const {
+    // note: this pass uses the matching kernel of 'applyBand', but reads thresholds & unstable regions as they were left by the last update
+    constexpr size_t nMatchChannels = getMatchChannelCount(nChannels);
+    const size_t nActiveSamples = getGovernedSampleCount(m_nBGSamples,m_nRequiredBGSamples);
+    const size_t nMatchSlots = m_oBGSamples.isDeduplicated()?m_oBGSamples.slots():nActiveSamples;
+    size_t nSamplesTested = 0; // not reported by this pass
+    for(size_t nModelIter=nModelIterBegin; nModelIter<nModelIterEnd; ++nModelIter) {
+        const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
+        if(pnPxMask && !pnPxMask[nPxIter])
+            continue;
+        const float fCurrDistThresholdFactor = getStateValue(m_oDistThresholdFrame,STATE_DIST_THRESHOLD,nPxIter);
+        const uchar bCurrRegionIsUnstable = m_oUnstableRegionMask.data[nPxIter];
+        const size_t nCurrColorDistThreshold = getColorDistThreshold<TColor,nMatchChannels>(fCurrDistThresholdFactor,bCurrRegionIsUnstable!=0);
+        const size_t nCurrDescDistThreshold = getDescDistThreshold(fCurrDistThresholdFactor,bCurrRegionIsUnstable!=0);
+        // as in 'applyBand', multi-channel color thresholds are summed over channels (with half of it as the per-channel max)
+        const size_t nCurrTotColorDistThreshold = (nMatchChannels==1)?nCurrColorDistThreshold:nCurrColorDistThreshold*nMatchChannels;
+        const size_t nCurrSCColorDistThreshold = (nMatchChannels==1)?nCurrTotColorDistThreshold:nCurrTotColorDistThreshold/2;
+        const size_t nCurrTotDescDistThreshold = nCurrDescDistThreshold*nMatchChannels;
+        const TColor* const anCurrColor = ((const TColor*)oInputImg.data)+nPxIter*nChannels;
+        alignas(16) std::array<std::array<TColor,LBSP::DESC_SIZE_BITS>,nMatchChannels> aanLBSPLookupVals;
+        computeMatchLookupVals<nChannels>(oInputImg,m_voPxInfoLUT[nPxIter].nImgCoord_X,m_voPxInfoLUT[nPxIter].nImgCoord_Y,aanLBSPLookupVals);
+        bool bLBSPLookupValsReady = true;
+        std::array<ushort,nMatchChannels> anCurrIntraDesc;
+        for(size_t c=0; c<nMatchChannels; ++c)
+            anCurrIntraDesc[c] = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anCurrColor[c],getLBSPThreshold(anCurrColor[c]));
+        PxMatchState oMatch = {0,0,0,0,0};
+        matchPixel<TColor,nChannels,false>(oInputImg,nPxIter,nMatchSlots,anCurrColor,anCurrIntraDesc.data(),aanLBSPLookupVals,bLBSPLookupValsReady,
+                                    nCurrSCColorDistThreshold,nCurrTotColorDistThreshold,nCurrTotDescDistThreshold,oMatch,nSamplesTested);
+        if(oMatch.nGoodSamplesCount<m_nRequiredBGSamples)
+            oCurrFGMask.data[nPxIter] = UCHAR_MAX;
+    }
+}
+
+void BackgroundSubtractorSuBSENSE::classify(cv::InputArray _image, cv::OutputArray _fgmask) {
+    lvAssert_(m_bInitialized && m_bModelInitialized,"algo & model must be initialized first");
+    const cv::Mat oOrigInputImg = _image.getMat();
+    cv::Mat oInputImg = getScaledInput(oOrigInputImg);
+    lvAssert_(oInputImg.type()==m_nImgType && oInputImg.size()==m_oImgSize,"input image type/size mismatch with initialization type/size");
+    lvAssert_(oInputImg.isContinuous(),"input image data must be continuous");
+    cv::Mat oCurrFGMask = getScaledOutputMask(_fgmask);
+    memset(oCurrFGMask.data,0,oCurrFGMask.cols*oCurrFGMask.rows);
+    const auto pClassifyBand = (m_nImgType==CV_16UC1)?&BackgroundSubtractorSuBSENSE::classifyBand<ushort,1>:
+                               (m_nImgChannels==1)?&BackgroundSubtractorSuBSENSE::classifyBand<uchar,1>:
+                               (m_nImgChannels==3)?&BackgroundSubtractorSuBSENSE::classifyBand<uchar,3>:
+                                                   &BackgroundSubtractorSuBSENSE::classifyBand<uchar,4>;
+    const auto lClassify = [&](const uchar* pnPxMask) {
+        if(m_nThreadCount==1)
+            (this->*pClassifyBand)(oInputImg,oCurrFGMask,0,m_nTotRelevantPxCount,pnPxMask);
+        else {
+            // classification only writes to the output mask, so all bands can be processed concurrently
+            lvDbgAssert(m_pThreadPool && m_vnBandModelIterLUT.size()>=2);
+            m_pThreadPool->parallel_for(m_vnBandModelIterLUT.size()-1,[&](size_t nBandIdx) {
+                (this->*pClassifyBand)(oInputImg,oCurrFGMask,m_vnBandModelIterLUT[nBandIdx],m_vnBandModelIterLUT[nBandIdx+1],pnPxMask);
+            });
+        }
+    };
+    if(!m_bUsingCoarseToFineClassification)
+        lClassify(nullptr);
+    else {
+        // coarse pass: only grid pixels are matched, each standing for the stride x stride cell it starts
+        const int nStride = (int)m_nC2FCoarseStride;
+        const cv::Size oCoarseSize((m_oImgSize.width+nStride-1)/nStride,(m_oImgSize.height+nStride-1)/nStride);
+        if(m_oC2FGridMask.size()!=m_oImgSize || m_oC2FCoarseFGMask.size()!=oCoarseSize) {
+            m_oC2FGridMask.create(m_oImgSize,CV_8UC1);
+            m_oC2FGridMask = cv::Scalar_<uchar>(0);
+            for(int nRowIdx=0; nRowIdx<m_oImgSize.height; nRowIdx+=nStride) {
+                uchar* pnGridRow = m_oC2FGridMask.ptr<uchar>(nRowIdx);
+                for(int nColIdx=0; nColIdx<m_oImgSize.width; nColIdx+=nStride)
+                    pnGridRow[nColIdx] = UCHAR_MAX;
+            }
+            m_oC2FCoarseFGMask.create(oCoarseSize,CV_8UC1);
+            m_oC2FRefineMask.create(m_oImgSize,CV_8UC1);
+        }
+        lClassify(m_oC2FGridMask.data);
+        for(int nCoarseRowIdx=0; nCoarseRowIdx<oCoarseSize.height; ++nCoarseRowIdx) {
+            const uchar* pnFGRow = oCurrFGMask.ptr<uchar>(nCoarseRowIdx*nStride);
+            uchar* pnCoarseRow = m_oC2FCoarseFGMask.ptr<uchar>(nCoarseRowIdx);
+            for(int nCoarseColIdx=0; nCoarseColIdx<oCoarseSize.width; ++nCoarseColIdx)
+                pnCoarseRow[nCoarseColIdx] = pnFGRow[nCoarseColIdx*nStride];
+        }
+        // fine pass: cells inside or near coarse FG blobs are matched at full res (minus grid pixels, already done), and the rest is left as BG
+        if(m_nC2FRefineMargin>0) {
+            const int nKernelSize = (int)m_nC2FRefineMargin*2+1;
+            cv::dilate(m_oC2FCoarseFGMask,m_oC2FCoarseFGMask,cv::getStructuringElement(cv::MORPH_RECT,cv::Size(nKernelSize,nKernelSize)));
+        }
+        for(int nRowIdx=0; nRowIdx<m_oImgSize.height; ++nRowIdx) {
+            const uchar* pnCoarseRow = m_oC2FCoarseFGMask.ptr<uchar>(nRowIdx/nStride);
+            const uchar* pnGridRow = m_oC2FGridMask.ptr<uchar>(nRowIdx);
+            uchar* pnRefineRow = m_oC2FRefineMask.ptr<uchar>(nRowIdx);
+            for(int nColIdx=0; nColIdx<m_oImgSize.width; ++nColIdx)
+                pnRefineRow[nColIdx] = pnCoarseRow[nColIdx/nStride]&~pnGridRow[nColIdx];
+        }
+        lClassify(m_oC2FRefineMask.data);
+    }
+    // same hole filling & smoothing as in 'apply' (blinking pixel analysis excluded), using the same thread-local scratch buffers
+    const cv::Rect oPostProcRect = getPostProcessingRect(m_nMedianBlurKernelSize/2+POSTPROC_RECT_MARGIN);
+    cv::Mat oCurrFGMask_PP = oCurrFGMask(oPostProcRect);
+    cv::Mat oFGMask_PreFlood = getScratchBuffer(ScratchBuffer_FGMask_PreFlood,oPostProcRect.size(),CV_8UC1);
+    cv::Mat oFGMask_FloodedHoles = getScratchBuffer(ScratchBuffer_FGMask_FloodedHoles,oPostProcRect.size(),CV_8UC1);
+    cv::Mat oFGMask_Blurred = getScratchBuffer(ScratchBuffer_FGMask_Blurred,oPostProcRect.size(),CV_8UC1);
+    lv::binaryDilate(oCurrFGMask_PP,oFGMask_PreFlood);
+    lv::binaryErode(oFGMask_PreFlood,oFGMask_PreFlood);
+    oFGMask_PreFlood.copyTo(oFGMask_FloodedHoles);
+    lv::binaryFloodFill(oFGMask_FloodedHoles,cv::Point(0,0));
+    cv::bitwise_not(oFGMask_FloodedHoles,oFGMask_FloodedHoles);
+    lv::binaryErode(oFGMask_PreFlood,oFGMask_PreFlood,3);
+    cv::bitwise_or(oCurrFGMask_PP,oFGMask_FloodedHoles,oCurrFGMask_PP);
+    cv::bitwise_or(oCurrFGMask_PP,oFGMask_PreFlood,oCurrFGMask_PP);
+    lv::binaryMedianBlur(oCurrFGMask_PP,oFGMask_Blurred,getGovernedMedianBlurKernelSize(m_nMedianBlurKernelSize));
+    if(FGBlobLabeler* pBlobLabeler = beginBlobExtraction(oPostProcRect))
+        pBlobLabeler->processRows(oFGMask_Blurred,0,oFGMask_Blurred.rows);
+    endBlobExtraction(oPostProcRect);
+    oFGMask_Blurred.copyTo(oCurrFGMask_PP);
+    upscaleOutputMask(oCurrFGMask,_fgmask,oOrigInputImg);
+}
+
+void BackgroundSubtractorSuBSENSE::apply(cv::InputArray _image, cv::OutputArray _fgmask, double learningRateOverride) {
+    // == process
+    lvAssert_(m_bInitialized && m_bModelInitialized,"algo & model must be initialized first");
+    LV_PROFILE_SCOPE("SuBSENSE::apply");
+    const GovernorScope oGovernorScope(this,_image);
+    std::mutex_lock_guard oModelLock(m_oModelMutex);
+    learningRateOverride = getGovernedLearningRate(learningRateOverride);
+    BGS_INSTR_SCOPED_TIMER(Stage_Total);
+    BGS_INSTR_ADD_COUNT(Counter_Frames,1);
+    const cv::Mat oOrigInputImg = _image.getMat();
+    cv::Mat oInputImg = getScaledInput(oOrigInputImg);
+    lvAssert_(oInputImg.type()==m_nImgType && oInputImg.size()==m_oImgSize,"input image type/size mismatch with initialization type/size");
+    lvAssert_(oInputImg.isContinuous(),"input image data must be continuous");
+    cv::Mat oCurrFGMask = getScaledOutputMask(_fgmask);
+    memset(oCurrFGMask.data,0,oCurrFGMask.cols*oCurrFGMask.rows);
+    if(m_bUsingGlobalMotionCompensation) {
+        BGS_INSTR_SCOPED_TIMER(Stage_MotionAnalysis);
+        m_oLastGlobalMotion = estimateGlobalMotion(oInputImg);
+        if(m_oLastGlobalMotion!=cv::Point(0,0))
+            translateModel(m_oLastGlobalMotion);
+    }
+    size_t nNonZeroDescCount = 0;
+    const float fRollAvgFactor_LT = getCompensatedRollAvgFactor(1.0f/std::min(++m_nFrameIdx,m_nSamplesForMovingAvgs));
+    const float fRollAvgFactor_ST = getCompensatedRollAvgFactor(1.0f/std::min(m_nFrameIdx,m_nSamplesForMovingAvgs/4));
+    size_t nSamplesTested = 0, nEarlyExits = 0;
+    {
+        BGS_INSTR_SCOPED_TIMER(Stage_PixelLoop);
+        updateDescriptorCache(oInputImg);
+        // pixel type & channel count are resolved once per frame here, so that the per-pixel loops of all bands are fully specialized
+        const auto pApplyBand = (m_nImgType==CV_16UC1)?&BackgroundSubtractorSuBSENSE::applyBand<ushort,1,lv::PCG32>:
+                                (m_nImgChannels==1)?&BackgroundSubtractorSuBSENSE::applyBand<uchar,1,lv::PCG32>:
+                                (m_nImgChannels==3)?&BackgroundSubtractorSuBSENSE::applyBand<uchar,3,lv::PCG32>:
+                                                    &BackgroundSubtractorSuBSENSE::applyBand<uchar,4,lv::PCG32>;
+        if(m_nThreadCount==1)
+            nNonZeroDescCount = (this->*pApplyBand)(oInputImg,oCurrFGMask,learningRateOverride,fRollAvgFactor_LT,fRollAvgFactor_ST,0,m_nTotRelevantPxCount,m_oRNG,nSamplesTested,nEarlyExits);
+        else {
+            // bands are processed in two phases (even, then odd) so that concurrently processed bands are always separated by a
+            // full band, and MIN_BAND_ROWS is larger than twice the max neighbor update spread (5x5 --> 2 rows)
+            lvDbgAssert(m_pThreadPool && m_vnBandModelIterLUT.size()>=2 && m_voBandRNGs.size()==m_vnBandModelIterLUT.size()-1);
+            const size_t nBands = m_voBandRNGs.size();
+            std::vector<size_t> vnBandNonZeroDescCounts(nBands,0),vnBandSamplesTested(nBands,0),vnBandEarlyExits(nBands,0);
+            for(size_t nPhase=0; nPhase<2; ++nPhase) {
+                m_pThreadPool->parallel_for((nBands+1-nPhase)/2,[&](size_t nTaskIdx) {
+                    const size_t nBandIdx = nTaskIdx*2+nPhase;
+                    vnBandNonZeroDescCounts[nBandIdx] = (this->*pApplyBand)(oInputImg,oCurrFGMask,learningRateOverride,fRollAvgFactor_LT,fRollAvgFactor_ST,
+                                                                  m_vnBandModelIterLUT[nBandIdx],m_vnBandModelIterLUT[nBandIdx+1],m_voBandRNGs[nBandIdx],
+                                                                  vnBandSamplesTested[nBandIdx],vnBandEarlyExits[nBandIdx]);
+                });
+            }
+            nNonZeroDescCount = std::accumulate(vnBandNonZeroDescCounts.begin(),vnBandNonZeroDescCounts.end(),size_t(0));
+            nSamplesTested = std::accumulate(vnBandSamplesTested.begin(),vnBandSamplesTested.end(),size_t(0));
+            nEarlyExits = std::accumulate(vnBandEarlyExits.begin(),vnBandEarlyExits.end(),size_t(0));
+        }
+    }
+    BGS_INSTR_ADD_COUNT(Counter_Pixels,m_nTotRelevantPxCount);
+    BGS_INSTR_ADD_COUNT(Counter_SamplesTested,nSamplesTested);
+    BGS_INSTR_ADD_COUNT(Counter_EarlyExits,nEarlyExits);
 #if DISPLAY_SUBSENSE_DEBUG_INFO
     cv::Point2i oDbgPt(-1,-1);
     if(m_pDisplayHelper) {
@@ -487,7 +1618,7 @@ void BackgroundSubtractorSuBSENSE::apply(cv::InputArray _image, cv::OutputArray
         const cv::Point2f& oDbgPt_rel = cv::Point2f(float(m_pDisplayHelper->m_oLatestMouseEvent.oPosition.x)/m_pDisplayHelper->m_oLatestMouseEvent.oDisplaySize.width,float(m_pDisplayHelper->m_oLatestMouseEvent.oPosition.y)/m_pDisplayHelper->m_oLatestMouseEvent.oDisplaySize.height);
         oDbgPt = cv::Point2i(int(oDbgPt_rel.x*m_oImgSize.width),int(oDbgPt_rel.y*m_oImgSize.height));
     }
-    if(oDbgPt.x>=0 && oDbgPt.x<m_oImgSize.width && oDbgPt.y>=0 && oDbgPt.y<m_oImgSize.height) {
+    if(!m_bUsingCompactStateMaps && oDbgPt.x>=0 && oDbgPt.x<m_oImgSize.width && oDbgPt.y>=0 && oDbgPt.y<m_oImgSize.height) { // debug display assumes float state maps
         std::cout << std::endl;
         cv::Mat oMeanMinDistFrameNormalized;
         m_oMeanMinDistFrame_ST.copyTo(oMeanMinDistFrameNormalized);
@@ -533,117 +1664,488 @@ void BackgroundSubtractorSuBSENSE::apply(cv::InputArray _image, cv::OutputArray
         std::cout << std::fixed << std::setprecision(5) << "      t(" << oDbgPt << ") = " << m_oUpdateRateFrame.at<float>(oDbgPt) << std::endl;
     }
 #endif //DISPLAY_SUBSENSE_DEBUG_INFO
-    cv::bitwise_xor(oCurrFGMask,m_oLastRawFGMask,m_oCurrRawFGBlinkMask);
-    cv::bitwise_or(m_oCurrRawFGBlinkMask,m_oLastRawFGBlinkMask,m_oBlinksFrame);
-    m_oCurrRawFGBlinkMask.copyTo(m_oLastRawFGBlinkMask);
-    oCurrFGMask.copyTo(m_oLastRawFGMask);
-    cv::morphologyEx(oCurrFGMask,m_oFGMask_PreFlood,cv::MORPH_CLOSE,m_oMorphExStructElement);
-    m_oFGMask_PreFlood.copyTo(m_oFGMask_FloodedHoles);
-    cv::floodFill(m_oFGMask_FloodedHoles,cv::Point(0,0),UCHAR_MAX);
-    cv::bitwise_not(m_oFGMask_FloodedHoles,m_oFGMask_FloodedHoles);
-    cv::erode(m_oFGMask_PreFlood,m_oFGMask_PreFlood,cv::Mat(),cv::Point(-1,-1),3);
-    cv::bitwise_or(oCurrFGMask,m_oFGMask_FloodedHoles,oCurrFGMask);
-    cv::bitwise_or(oCurrFGMask,m_oFGMask_PreFlood,oCurrFGMask);
-    cv::medianBlur(oCurrFGMask,m_oLastFGMask,m_nMedianBlurKernelSize);
-    cv::dilate(m_oLastFGMask,m_oLastFGMask_dilated,cv::Mat(),cv::Point(-1,-1),3);
-    cv::bitwise_and(m_oBlinksFrame,m_oLastFGMask_dilated_inverted,m_oBlinksFrame);
-    cv::bitwise_not(m_oLastFGMask_dilated,m_oLastFGMask_dilated_inverted);
-    cv::bitwise_and(m_oBlinksFrame,m_oLastFGMask_dilated_inverted,m_oBlinksFrame);
-    m_oLastFGMask.copyTo(oCurrFGMask);
-    cv::addWeighted(m_oMeanFinalSegmResFrame_LT,(1.0f-fRollAvgFactor_LT),m_oLastFGMask,(1.0/UCHAR_MAX)*fRollAvgFactor_LT,0,m_oMeanFinalSegmResFrame_LT,CV_32F);
-    cv::addWeighted(m_oMeanFinalSegmResFrame_ST,(1.0f-fRollAvgFactor_ST),m_oLastFGMask,(1.0/UCHAR_MAX)*fRollAvgFactor_ST,0,m_oMeanFinalSegmResFrame_ST,CV_32F);
-    const float fCurrNonZeroDescRatio = (float)nNonZeroDescCount/m_nTotRelevantPxCount;
-    if(fCurrNonZeroDescRatio<LBSPDESC_NONZERO_RATIO_MIN && m_fLastNonZeroDescRatio<LBSPDESC_NONZERO_RATIO_MIN) {
-        for(size_t t=0; t<=UCHAR_MAX; ++t)
-            if(m_anLBSPThreshold_8bitLUT[t]>cv::saturate_cast<uchar>(m_nLBSPThresholdOffset+ceil(t*m_fRelLBSPThreshold/4)))
-                --m_anLBSPThreshold_8bitLUT[t];
-    }
-    else if(fCurrNonZeroDescRatio>LBSPDESC_NONZERO_RATIO_MAX && m_fLastNonZeroDescRatio>LBSPDESC_NONZERO_RATIO_MAX) {
-        for(size_t t=0; t<=UCHAR_MAX; ++t)
-            if(m_anLBSPThreshold_8bitLUT[t]<cv::saturate_cast<uchar>(m_nLBSPThresholdOffset+UCHAR_MAX*m_fRelLBSPThreshold))
-                ++m_anLBSPThreshold_8bitLUT[t];
+    {
+        BGS_INSTR_SCOPED_TIMER(Stage_PostProc);
+        // in ROI-compacted mode, post-processing only covers the ROI bounding box padded by more than the max op footprint; all masks
+        // stay null outside of it, so the results are identical (the inverted dilated mask is still updated everywhere, it is used frame-wide)
+        const cv::Rect oPostProcRect = getPostProcessingRect(m_nMedianBlurKernelSize/2+POSTPROC_RECT_MARGIN);
+        cv::Mat oCurrFGMask_PP = oCurrFGMask(oPostProcRect), oLastFGMask_PP = m_oLastFGMask(oPostProcRect);
+        cv::Mat oLastRawFGMask_PP = m_oLastRawFGMask(oPostProcRect), oBlinksFrame_PP = m_oBlinksFrame(oPostProcRect);
+        cv::Mat oCurrRawFGBlinkMask_PP = getScratchBuffer(ScratchBuffer_CurrRawFGBlinkMask,oPostProcRect.size(),CV_8UC1), oLastRawFGBlinkMask_PP = m_oLastRawFGBlinkMask(oPostProcRect);
+        cv::Mat oFGMask_PreFlood_PP = getScratchBuffer(ScratchBuffer_FGMask_PreFlood,oPostProcRect.size(),CV_8UC1);
+        cv::Mat oFGMask_FloodedHoles_PP = getScratchBuffer(ScratchBuffer_FGMask_FloodedHoles,oPostProcRect.size(),CV_8UC1);
+        cv::Mat oLastFGMask_dilated_PP = getScratchBuffer(ScratchBuffer_LastFGMask_dilated,oPostProcRect.size(),CV_8UC1), oLastFGMask_dilated_inverted_PP = m_oLastFGMask_dilated_inverted(oPostProcRect);
+        // the (transient) dilated mask only covers the post-proc rect, and is considered null outside of it
+        const auto lUpdateInvertedDilatedMask = [&]() {
+            if(oPostProcRect.size()!=m_oImgSize)
+                m_oLastFGMask_dilated_inverted = cv::Scalar_<uchar>(UCHAR_MAX);
+            cv::bitwise_not(oLastFGMask_dilated_PP,oLastFGMask_dilated_inverted_PP);
+        };
+        FGBlobLabeler* pBlobLabeler = beginBlobExtraction(oPostProcRect);
+        if(m_bUsingFusedPostProcessing) {
+            postProcessFGMask_fused(oCurrFGMask_PP,oLastFGMask_PP,oLastRawFGMask_PP,oCurrRawFGBlinkMask_PP,oLastRawFGBlinkMask_PP,oBlinksFrame_PP,oFGMask_PreFlood_PP,
+                                    oFGMask_FloodedHoles_PP,oLastFGMask_dilated_PP,oLastFGMask_dilated_inverted_PP,m_oMorphExStructElement,getGovernedMedianBlurKernelSize(m_nMedianBlurKernelSize),pBlobLabeler);
+            lUpdateInvertedDilatedMask();
+        }
+        else {
+            cv::bitwise_xor(oCurrFGMask_PP,oLastRawFGMask_PP,oCurrRawFGBlinkMask_PP);
+            cv::bitwise_or(oCurrRawFGBlinkMask_PP,oLastRawFGBlinkMask_PP,oBlinksFrame_PP);
+            oCurrRawFGBlinkMask_PP.copyTo(oLastRawFGBlinkMask_PP);
+            oCurrFGMask_PP.copyTo(oLastRawFGMask_PP);
+            lv::binaryDilate(oCurrFGMask_PP,oFGMask_PreFlood_PP);
+            lv::binaryErode(oFGMask_PreFlood_PP,oFGMask_PreFlood_PP);
+            oFGMask_PreFlood_PP.copyTo(oFGMask_FloodedHoles_PP);
+            lv::binaryFloodFill(oFGMask_FloodedHoles_PP,cv::Point(0,0));
+            cv::bitwise_not(oFGMask_FloodedHoles_PP,oFGMask_FloodedHoles_PP);
+            lv::binaryErode(oFGMask_PreFlood_PP,oFGMask_PreFlood_PP,3);
+            cv::bitwise_or(oCurrFGMask_PP,oFGMask_FloodedHoles_PP,oCurrFGMask_PP);
+            cv::bitwise_or(oCurrFGMask_PP,oFGMask_PreFlood_PP,oCurrFGMask_PP);
+            lv::binaryMedianBlur(oCurrFGMask_PP,oLastFGMask_PP,getGovernedMedianBlurKernelSize(m_nMedianBlurKernelSize));
+            if(pBlobLabeler)
+                pBlobLabeler->processRows(oLastFGMask_PP,0,oLastFGMask_PP.rows);
+            lv::binaryDilate(oLastFGMask_PP,oLastFGMask_dilated_PP,3);
+            cv::bitwise_and(oBlinksFrame_PP,oLastFGMask_dilated_inverted_PP,oBlinksFrame_PP);
+            lUpdateInvertedDilatedMask();
+            cv::bitwise_and(oBlinksFrame_PP,oLastFGMask_dilated_inverted_PP,oBlinksFrame_PP);
+            oLastFGMask_PP.copyTo(oCurrFGMask_PP);
+        }
+        endBlobExtraction(oPostProcRect);
+        cv::Mat oMeanFinalSegmResFrame_LT_PP = m_oMeanFinalSegmResFrame_LT(oPostProcRect), oMeanFinalSegmResFrame_ST_PP = m_oMeanFinalSegmResFrame_ST(oPostProcRect);
+        lv::updateRollingAverages({&oMeanFinalSegmResFrame_LT_PP,&oMeanFinalSegmResFrame_ST_PP},{fRollAvgFactor_LT,fRollAvgFactor_ST},oLastFGMask_PP,cv::Mat(),
+                                  {getStateMapScale(m_oMeanFinalSegmResFrame_LT,STATE_MEAN_FINAL_SEGM_RES_LT)/UCHAR_MAX,getStateMapScale(m_oMeanFinalSegmResFrame_ST,STATE_MEAN_FINAL_SEGM_RES_ST)/UCHAR_MAX});
     }
-    m_fLastNonZeroDescRatio = fCurrNonZeroDescRatio;
-    if(m_bLearningRateScalingEnabled) {
-        cv::resize(oInputImg,m_oDownSampledFrame_MotionAnalysis,m_oDownSampledFrameSize,0,0,cv::INTER_AREA);
-        cv::accumulateWeighted(m_oDownSampledFrame_MotionAnalysis,m_oMeanDownSampledLastDistFrame_LT,fRollAvgFactor_LT);
-        cv::accumulateWeighted(m_oDownSampledFrame_MotionAnalysis,m_oMeanDownSampledLastDistFrame_ST,fRollAvgFactor_ST);
-        size_t nTotColorDiff = 0;
-        for(int i=0; i<m_oMeanDownSampledLastDistFrame_ST.rows; ++i) {
-            const size_t idx1 = m_oMeanDownSampledLastDistFrame_ST.step.p[0]*i;
-            for(int j=0; j<m_oMeanDownSampledLastDistFrame_ST.cols; ++j) {
-                const size_t idx2 = idx1+m_oMeanDownSampledLastDistFrame_ST.step.p[1]*j;
-                nTotColorDiff += (m_nImgChannels==1)?
-                    (size_t)fabs((*(float*)(m_oMeanDownSampledLastDistFrame_ST.data+idx2))-(*(float*)(m_oMeanDownSampledLastDistFrame_LT.data+idx2)))/2
-                            :  //(m_nImgChannels==3)
-                        std::max((size_t)fabs((*(float*)(m_oMeanDownSampledLastDistFrame_ST.data+idx2))-(*(float*)(m_oMeanDownSampledLastDistFrame_LT.data+idx2))),
-                            std::max((size_t)fabs((*(float*)(m_oMeanDownSampledLastDistFrame_ST.data+idx2+4))-(*(float*)(m_oMeanDownSampledLastDistFrame_LT.data+idx2+4))),
-                                        (size_t)fabs((*(float*)(m_oMeanDownSampledLastDistFrame_ST.data+idx2+8))-(*(float*)(m_oMeanDownSampledLastDistFrame_LT.data+idx2+8)))));
+    {
+        BGS_INSTR_SCOPED_TIMER(Stage_MotionAnalysis);
+        const float fCurrNonZeroDescRatio = (float)nNonZeroDescCount/m_nTotRelevantPxCount;
+        // 16-bit thresholds move by one 8-bit intensity unit at a time, within the same (scaled) bounds as 8-bit ones
+        const bool b16bitInput = !m_vnLBSPThreshold_16bitLUT.empty();
+        if(fCurrNonZeroDescRatio<LBSPDESC_NONZERO_RATIO_MIN && m_fLastNonZeroDescRatio<LBSPDESC_NONZERO_RATIO_MIN) {
+            if(b16bitInput) {
+                for(size_t t=0; t<=USHRT_MAX; ++t) {
+                    const ushort nMinThreshold = cv::saturate_cast<ushort>(m_nLBSPThresholdOffset*BGSLBSP_16BIT_INTENSITY_SCALE+ceil(t*m_fRelLBSPThreshold/4));
+                    if(m_vnLBSPThreshold_16bitLUT[t]>nMinThreshold)
+                        m_vnLBSPThreshold_16bitLUT[t] = (ushort)std::max((int)m_vnLBSPThreshold_16bitLUT[t]-BGSLBSP_16BIT_INTENSITY_SCALE,(int)nMinThreshold);
+                }
+            }
+            else {
+                for(size_t t=0; t<=UCHAR_MAX; ++t)
+                    if(m_anLBSPThreshold_8bitLUT[t]>cv::saturate_cast<uchar>(m_nLBSPThresholdOffset+ceil(t*m_fRelLBSPThreshold/4)))
+                        --m_anLBSPThreshold_8bitLUT[t];
+            }
+            invalidateDescriptorCache();
+        }
+        else if(fCurrNonZeroDescRatio>LBSPDESC_NONZERO_RATIO_MAX && m_fLastNonZeroDescRatio>LBSPDESC_NONZERO_RATIO_MAX) {
+            if(b16bitInput) {
+                const ushort nMaxThreshold = cv::saturate_cast<ushort>((m_nLBSPThresholdOffset+UCHAR_MAX*m_fRelLBSPThreshold)*BGSLBSP_16BIT_INTENSITY_SCALE);
+                for(size_t t=0; t<=USHRT_MAX; ++t)
+                    if(m_vnLBSPThreshold_16bitLUT[t]<nMaxThreshold)
+                        m_vnLBSPThreshold_16bitLUT[t] = (ushort)std::min((int)m_vnLBSPThreshold_16bitLUT[t]+BGSLBSP_16BIT_INTENSITY_SCALE,(int)nMaxThreshold);
+            }
+            else {
+                for(size_t t=0; t<=UCHAR_MAX; ++t)
+                    if(m_anLBSPThreshold_8bitLUT[t]<cv::saturate_cast<uchar>(m_nLBSPThresholdOffset+UCHAR_MAX*m_fRelLBSPThreshold))
+                        ++m_anLBSPThreshold_8bitLUT[t];
             }
+            invalidateDescriptorCache();
         }
-        const float fCurrColorDiffRatio = (float)nTotColorDiff/(m_oMeanDownSampledLastDistFrame_ST.rows*m_oMeanDownSampledLastDistFrame_ST.cols);
-        if(m_bAutoModelResetEnabled) {
-            if(m_nFramesSinceLastReset>1000)
-                m_bAutoModelResetEnabled = false;
-            else if(fCurrColorDiffRatio>=FRAMELEVEL_MIN_COLOR_DIFF_THRESHOLD && m_nModelResetCooldown==0) {
+        m_fLastNonZeroDescRatio = fCurrNonZeroDescRatio;
+        if(m_bLearningRateScalingEnabled) {
+            cv::resize(oInputImg,m_oDownSampledFrame_MotionAnalysis,m_oDownSampledFrameSize,0,0,cv::INTER_AREA);
+            lv::updateRollingAverages({&m_oMeanDownSampledLastDistFrame_LT,&m_oMeanDownSampledLastDistFrame_ST},{fRollAvgFactor_LT,fRollAvgFactor_ST},m_oDownSampledFrame_MotionAnalysis);
+            size_t nTotColorDiff = 0;
+            for(int i=0; i<m_oMeanDownSampledLastDistFrame_ST.rows; ++i) {
+                const size_t idx1 = m_oMeanDownSampledLastDistFrame_ST.step.p[0]*i;
+                for(int j=0; j<m_oMeanDownSampledLastDistFrame_ST.cols; ++j) {
+                    const size_t idx2 = idx1+m_oMeanDownSampledLastDistFrame_ST.step.p[1]*j;
+                    nTotColorDiff += (m_nImgChannels==1)?
+                        (size_t)fabs((*(float*)(m_oMeanDownSampledLastDistFrame_ST.data+idx2))-(*(float*)(m_oMeanDownSampledLastDistFrame_LT.data+idx2)))/2
+                                :  //(m_nImgChannels==3)
+                            std::max((size_t)fabs((*(float*)(m_oMeanDownSampledLastDistFrame_ST.data+idx2))-(*(float*)(m_oMeanDownSampledLastDistFrame_LT.data+idx2))),
+                                std::max((size_t)fabs((*(float*)(m_oMeanDownSampledLastDistFrame_ST.data+idx2+4))-(*(float*)(m_oMeanDownSampledLastDistFrame_LT.data+idx2+4))),
+                                            (size_t)fabs((*(float*)(m_oMeanDownSampledLastDistFrame_ST.data+idx2+8))-(*(float*)(m_oMeanDownSampledLastDistFrame_LT.data+idx2+8)))));
+                }
+            }
+            // the frame-level thresholds below are given in 8-bit intensity units
+            const float fCurrColorDiffRatio = (float)nTotColorDiff/(m_oMeanDownSampledLastDistFrame_ST.rows*m_oMeanDownSampledLastDistFrame_ST.cols)/((m_nImgType==CV_16UC1)?BGSLBSP_16BIT_INTENSITY_SCALE:1);
+            if(m_bAutoModelResetEnabled) {
+                if(m_nFramesSinceLastReset>1000)
+                    m_bAutoModelResetEnabled = false;
+                else if(fCurrColorDiffRatio>=FRAMELEVEL_MIN_COLOR_DIFF_THRESHOLD && m_nModelResetCooldown==0) {
+                    m_nFramesSinceLastReset = 0;
+                    if(m_nIncrementalResetFrames>1)
+                        m_nPendingResetFrames = m_nIncrementalResetFrames; // reset 10% of the bg model, one slice of pixels per frame
+                    else
+                        refreshModel(0.1f); // reset 10% of the bg model
+                    m_nModelResetCooldown = m_nSamplesForMovingAvgs/4;
+                    m_oUpdateRateFrame = cv::Scalar(1.0f*getStateMapScale(m_oUpdateRateFrame,STATE_UPDATE_RATE));
+                }
+                else
+                    ++m_nFramesSinceLastReset;
+            }
+            else if(fCurrColorDiffRatio>=FRAMELEVEL_MIN_COLOR_DIFF_THRESHOLD*2) {
                 m_nFramesSinceLastReset = 0;
-                refreshModel(0.1f); // reset 10% of the bg model
-                m_nModelResetCooldown = m_nSamplesForMovingAvgs/4;
-                m_oUpdateRateFrame = cv::Scalar(1.0f);
+                m_bAutoModelResetEnabled = true;
             }
-            else
-                ++m_nFramesSinceLastReset;
+            if(fCurrColorDiffRatio>=FRAMELEVEL_MIN_COLOR_DIFF_THRESHOLD/2) {
+                m_fCurrLearningRateLowerCap = (float)std::max((int)FEEDBACK_T_LOWER>>(int)(fCurrColorDiffRatio/2),1);
+                m_fCurrLearningRateUpperCap = (float)std::max((int)FEEDBACK_T_UPPER>>(int)(fCurrColorDiffRatio/2),1);
+            }
+            else {
+                m_fCurrLearningRateLowerCap = FEEDBACK_T_LOWER;
+                m_fCurrLearningRateUpperCap = FEEDBACK_T_UPPER;
+            }
+            if(m_nModelResetCooldown>0)
+                --m_nModelResetCooldown;
         }
-        else if(fCurrColorDiffRatio>=FRAMELEVEL_MIN_COLOR_DIFF_THRESHOLD*2) {
-            m_nFramesSinceLastReset = 0;
-            m_bAutoModelResetEnabled = true;
+        if(m_nPendingResetFrames>0) {
+            const size_t nSliceIdx = m_nIncrementalResetFrames-m_nPendingResetFrames--;
+            refreshModelRange(0.1f,false,(m_nTotRelevantPxCount*nSliceIdx)/m_nIncrementalResetFrames,(m_nTotRelevantPxCount*(nSliceIdx+1))/m_nIncrementalResetFrames);
         }
-        if(fCurrColorDiffRatio>=FRAMELEVEL_MIN_COLOR_DIFF_THRESHOLD/2) {
-            m_fCurrLearningRateLowerCap = (float)std::max((int)FEEDBACK_T_LOWER>>(int)(fCurrColorDiffRatio/2),1);
-            m_fCurrLearningRateUpperCap = (float)std::max((int)FEEDBACK_T_UPPER>>(int)(fCurrColorDiffRatio/2),1);
+    }
+    // background images are refreshed while the model lock is held anyway, so that readers never have to wait for a whole frame
+    m_oBGMeanImgs.publish(m_oBGSamples);
+    upscaleOutputMask(oCurrFGMask,_fgmask,oOrigInputImg);
+}
+
+void BackgroundSubtractorSuBSENSE::setCompactStateMaps(bool bEnabled) {
+    m_bUsingCompactStateMaps = bEnabled;
+    if(m_bInitialized) {
+        const std::array<cv::Mat*,STATE_MAP_COUNT> apStateMaps = getStateMaps();
+        for(size_t n=0; n<STATE_MAP_COUNT; ++n) {
+            if(bEnabled && apStateMaps[n]->depth()==CV_32F)
+                apStateMaps[n]->convertTo(*apStateMaps[n],CV_16U,s_afCompactStateScales[n]);
+            else if(!bEnabled && apStateMaps[n]->depth()==CV_16U)
+                apStateMaps[n]->convertTo(*apStateMaps[n],CV_32F,1.0/s_afCompactStateScales[n]);
         }
-        else {
-            m_fCurrLearningRateLowerCap = FEEDBACK_T_LOWER;
-            m_fCurrLearningRateUpperCap = FEEDBACK_T_UPPER;
+    }
+}
+
+std::array<cv::Mat*,STATE_MAP_COUNT> BackgroundSubtractorSuBSENSE::getStateMaps() {
+    static_assert(STATE_MAP_COUNT==10,"state map list below must match the local state indices");
+    return std::array<cv::Mat*,STATE_MAP_COUNT>{{
+        &m_oUpdateRateFrame,
+        &m_oDistThresholdFrame,
+        &m_oVariationModulatorFrame,
+        &m_oMeanLastDistFrame,
+        &m_oMeanMinDistFrame_LT,
+        &m_oMeanMinDistFrame_ST,
+        &m_oMeanRawSegmResFrame_LT,
+        &m_oMeanRawSegmResFrame_ST,
+        &m_oMeanFinalSegmResFrame_LT,
+        &m_oMeanFinalSegmResFrame_ST,
+    }};
+}
+
+void BackgroundSubtractorSuBSENSE::setThreadCount(size_t nThreads) {
+    m_nThreadCount = nThreads;
+    if(m_nThreadCount==1)
+        m_pThreadPool = nullptr;
+    else if(!m_pThreadPool || m_pThreadPool->getThreadCount()!=getThreadCount())
+        m_pThreadPool = std::make_unique<lv::ThreadPool>(m_nThreadCount);
+    if(m_bInitialized)
+        updateBandLUT();
+}
+
+void BackgroundSubtractorSuBSENSE::setRandomSeed(uint64_t nSeed) {
+    IBackgroundSubtractorLBSP::setRandomSeed(nSeed);
+    if(m_bInitialized)
+        updateBandLUT(); // band RNGs are seeded from the main RNG
+}
+
+void BackgroundSubtractorSuBSENSE::setGlobalMotionCompensation(bool bEnabled) {
+    m_bUsingGlobalMotionCompensation = bEnabled;
+    m_oLastGMCFrame_Coarse.release();
+    m_oLastGMCFrame_Fine.release();
+    m_oLastGlobalMotion = cv::Point(0,0);
+}
+
+void BackgroundSubtractorSuBSENSE::setStabilityShortcut(bool bEnabled, size_t nMinBGStreak, float fMaxMeanLastDist) {
+    lvAssert_(nMinBGStreak>0 && nMinBGStreak<=USHRT_MAX,"stability shortcut min BG streak must be in [1,USHRT_MAX]");
+    lvAssert_(fMaxMeanLastDist>=0.0f && fMaxMeanLastDist<=1.0f,"stability shortcut max mean last dist must be a normalized value");
+    m_bUsingStabilityShortcut = bEnabled;
+    m_nStabilityMinBGStreak = nMinBGStreak;
+    m_fStabilityMaxMeanLastDist = fMaxMeanLastDist;
+    if(m_bInitialized)
+        m_oBGStreakFrame = cv::Scalar_<ushort>(0);
+}
+
+void BackgroundSubtractorSuBSENSE::setCoarseToFineClassification(bool bEnabled, size_t nCoarseStride, size_t nRefineMargin) {
+    lvAssert_(nCoarseStride==2 || nCoarseStride==4,"coarse-to-fine classification stride must be 2 or 4");
+    m_bUsingCoarseToFineClassification = bEnabled;
+    m_nC2FCoarseStride = nCoarseStride;
+    m_nC2FRefineMargin = nRefineMargin;
+    m_oC2FGridMask.release(); // rebuilt on next use with the new stride
+}
+
+cv::Point BackgroundSubtractorSuBSENSE::estimateGlobalMotion(const cv::Mat& oInputImg) {
+    lvDbgAssert(oInputImg.type()==m_nImgType && oInputImg.size()==m_oImgSize);
+    const cv::Size oFineSize(m_oImgSize.width/GMC_FINE_DOWNSAMPLE_RATIO,m_oImgSize.height/GMC_FINE_DOWNSAMPLE_RATIO);
+    cv::Mat oGrayImg,oCurrFrame_Fine,oCurrFrame_Coarse;
+    if(m_nImgChannels==1)
+        oGrayImg = oInputImg;
+    else
+        cv::cvtColor(oInputImg,oGrayImg,(m_nImgChannels==3)?cv::COLOR_BGR2GRAY:cv::COLOR_BGRA2GRAY);
+    cv::resize(oGrayImg,oCurrFrame_Fine,oFineSize,0,0,cv::INTER_AREA);
+    oCurrFrame_Fine.convertTo(oCurrFrame_Fine,CV_32F);
+    cv::resize(oCurrFrame_Fine,oCurrFrame_Coarse,m_oDownSampledFrameSize,0,0,cv::INTER_AREA);
+    if(m_oGMCWindow_Fine.size()!=oFineSize || m_oGMCWindow_Coarse.size()!=m_oDownSampledFrameSize) {
+        cv::createHanningWindow(m_oGMCWindow_Fine,oFineSize,CV_32F);
+        cv::createHanningWindow(m_oGMCWindow_Coarse,m_oDownSampledFrameSize,CV_32F);
+    }
+    cv::Point oShift(0,0);
+    if(!m_oLastGMCFrame_Coarse.empty()) {
+        // the coarse level covers large displacements cheaply, and the fine level only needs to correlate the residual of the pre-shifted last frame
+        double dCoarseResponse;
+        const cv::Point2d oCoarseShift = cv::phaseCorrelate(m_oLastGMCFrame_Coarse,oCurrFrame_Coarse,m_oGMCWindow_Coarse,&dCoarseResponse);
+        if(dCoarseResponse>=GMC_MIN_PHASECORR_RESPONSE) {
+            const cv::Point2d oCoarseShift_Fine(oCoarseShift.x*oFineSize.width/m_oDownSampledFrameSize.width,oCoarseShift.y*oFineSize.height/m_oDownSampledFrameSize.height);
+            const cv::Mat oCoarseWarp = (cv::Mat_<double>(2,3) << 1.0,0.0,oCoarseShift_Fine.x,0.0,1.0,oCoarseShift_Fine.y);
+            cv::Mat oLastFrame_FineWarped;
+            cv::warpAffine(m_oLastGMCFrame_Fine,oLastFrame_FineWarped,oCoarseWarp,oFineSize,cv::INTER_LINEAR,cv::BORDER_REPLICATE);
+            double dFineResponse;
+            const cv::Point2d oResidualShift = cv::phaseCorrelate(oLastFrame_FineWarped,oCurrFrame_Fine,m_oGMCWindow_Fine,&dFineResponse);
+            const cv::Point2d oFineShift = oCoarseShift_Fine+((dFineResponse>=GMC_MIN_PHASECORR_RESPONSE)?oResidualShift:cv::Point2d(0.0,0.0));
+            const cv::Point2d oFullShift(oFineShift.x*m_oImgSize.width/oFineSize.width,oFineShift.y*m_oImgSize.height/oFineSize.height);
+            if(std::abs(oFullShift.x)<=m_oImgSize.width*GMC_MAX_SHIFT_RATIO && std::abs(oFullShift.y)<=m_oImgSize.height*GMC_MAX_SHIFT_RATIO)
+                oShift = cv::Point((int)std::round(oFullShift.x),(int)std::round(oFullShift.y));
         }
-        if(m_nModelResetCooldown>0)
-            --m_nModelResetCooldown;
     }
+    m_oLastGMCFrame_Coarse = oCurrFrame_Coarse;
+    m_oLastGMCFrame_Fine = oCurrFrame_Fine;
+    return oShift;
 }
 
-void BackgroundSubtractorSuBSENSE::getBackgroundImage(cv::OutputArray backgroundImage) const {
+void BackgroundSubtractorSuBSENSE::translateModel(const cv::Point& oShift) {
     lvAssert_(m_bInitialized,"algo must be initialized first");
-    cv::Mat oAvgBGImg = cv::Mat::zeros(m_oImgSize,CV_32FC((int)m_nImgChannels));
-    for(size_t s=0; s<m_nBGSamples; ++s) {
-        for(int y=0; y<m_oImgSize.height; ++y) {
-            for(int x=0; x<m_oImgSize.width; ++x) {
-                const size_t idx_nimg = m_voBGColorSamples[s].step.p[0]*y + m_voBGColorSamples[s].step.p[1]*x;
-                const size_t nFloatIter = idx_nimg*4;
-                float* oAvgBgImgPtr = (float*)(oAvgBGImg.data+nFloatIter);
-                const uchar* const oBGImgPtr = m_voBGColorSamples[s].data+idx_nimg;
-                for(size_t c=0; c<m_nImgChannels; ++c)
-                    oAvgBgImgPtr[c] += ((float)oBGImgPtr[c])/m_nBGSamples;
-            }
+    const cv::Mat oWarp = (cv::Mat_<double>(2,3) << 1.0,0.0,(double)oShift.x,0.0,1.0,(double)oShift.y);
+    // warped maps are written to arena-backed temporaries, then copied back in place, so the pre-allocated maps are never reallocated
+    const auto lTranslate = [&](cv::Mat& oMap, int nBorderMode, const cv::Scalar& vBorderVal) {
+        cv::Mat oTranslatedMap = m_oFrameArenaAllocator.create(oMap.size(),oMap.type());
+        cv::warpAffine(oMap,oTranslatedMap,oWarp,oMap.size(),cv::INTER_NEAREST,nBorderMode,vBorderVal);
+        oTranslatedMap.copyTo(oMap);
+    };
+    m_oBGSamples.translate(oShift);
+    for(cv::Mat* pStateMap : getStateMaps())
+        lTranslate(*pStateMap,cv::BORDER_REPLICATE,cv::Scalar());
+    lTranslate(m_oLastColorFrame,cv::BORDER_REPLICATE,cv::Scalar());
+    lTranslate(m_oLastDescFrame,cv::BORDER_REPLICATE,cv::Scalar());
+    // masks must stay null (or full, for the inverted one) outside of the post-processing rect in ROI-compacted mode
+    const cv::Rect oPostProcRect = getPostProcessingRect(m_nMedianBlurKernelSize/2+POSTPROC_RECT_MARGIN);
+    const auto lTranslateMask = [&](cv::Mat& oMask, uchar nOuterVal) {
+        lTranslate(oMask,cv::BORDER_CONSTANT,cv::Scalar_<uchar>(nOuterVal));
+        if(oPostProcRect.size()!=m_oImgSize) {
+            cv::Mat oCompactedMask = m_oFrameArenaAllocator.create(oPostProcRect.size(),CV_8UC1);
+            oMask(oPostProcRect).copyTo(oCompactedMask);
+            oMask = cv::Scalar_<uchar>(nOuterVal);
+            oCompactedMask.copyTo(oMask(oPostProcRect));
         }
+    };
+    lTranslateMask(m_oLastFGMask,0);
+    lTranslateMask(m_oLastRawFGMask,0);
+    lTranslateMask(m_oLastRawFGBlinkMask,0);
+    lTranslateMask(m_oBlinksFrame,0);
+    lTranslateMask(m_oUnstableRegionMask,0);
+    lTranslateMask(m_oLastFGMask_dilated_inverted,UCHAR_MAX);
+    // the frame-level analysis maps are shifted as well, so that compensated camera motion does not trigger model resets
+    const cv::Mat oDownSampledWarp = (cv::Mat_<double>(2,3) << 1.0,0.0,(double)oShift.x/FRAMELEVEL_ANALYSIS_DOWNSAMPLE_RATIO,0.0,1.0,(double)oShift.y/FRAMELEVEL_ANALYSIS_DOWNSAMPLE_RATIO);
+    for(cv::Mat* pDownSampledMap : {&m_oMeanDownSampledLastDistFrame_LT,&m_oMeanDownSampledLastDistFrame_ST}) {
+        cv::Mat oTranslatedMap = m_oFrameArenaAllocator.create(pDownSampledMap->size(),pDownSampledMap->type());
+        cv::warpAffine(*pDownSampledMap,oTranslatedMap,oDownSampledWarp,pDownSampledMap->size(),cv::INTER_LINEAR,cv::BORDER_REPLICATE);
+        oTranslatedMap.copyTo(*pDownSampledMap);
+    }
+    m_oFrameArenaAllocator.reset();
+    m_oBGStreakFrame = cv::Scalar_<ushort>(0); // translated samples must be re-matched before the stability shortcut applies again
+    invalidateDescriptorCache();
+}
+
+bool BackgroundSubtractorSuBSENSE::updateModelROI(const cv::Mat& oNewROI, size_t nOrigROIPxCount) {
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    std::mutex_lock_guard oModelLock(m_oModelMutex);
+    std::vector<std::pair<size_t,size_t>> vAddedPxSources;
+    getAddedROIPxSources(m_oROI,oNewROI,vAddedPxSources);
+    setInternalROI(oNewROI,nOrigROIPxCount);
+    // removed pixels are simply dropped from the LUTs, as the (frame-sized) model keeps their storage
+    for(const auto& oAddedPx : vAddedPxSources)
+        m_oBGSamples.copyPixel(oAddedPx.first,oAddedPx.second);
+    for(cv::Mat* pStateMap : getStateMaps())
+        copyAddedROIPxData(*pStateMap,vAddedPxSources);
+    copyAddedROIPxData(m_oLastColorFrame,vAddedPxSources);
+    copyAddedROIPxData(m_oLastDescFrame,vAddedPxSources);
+    copyAddedROIPxData(m_oStableSampleIdxFrame,vAddedPxSources);
+    for(const auto& oAddedPx : vAddedPxSources)
+        ((ushort*)m_oBGStreakFrame.data)[oAddedPx.first] = 0; // copied samples must be re-matched before the stability shortcut applies
+    // masks are transient, and restart as in 'initialize' (they must be null outside of the new post-processing rect in ROI-compacted mode)
+    for(cv::Mat* pMask : {&m_oLastFGMask,&m_oLastRawFGMask,&m_oLastRawFGBlinkMask,&m_oBlinksFrame,&m_oUnstableRegionMask,&m_oLastFGMask_dilated_inverted})
+        *pMask = cv::Scalar_<uchar>(0);
+    updateBandLUT();
+    invalidateDescriptorCache();
+    return true;
+}
+
+void BackgroundSubtractorSuBSENSE::setIncrementalModelReset(size_t nFrames) {
+    m_nIncrementalResetFrames = nFrames;
+    m_nPendingResetFrames = 0;
+}
+
+size_t BackgroundSubtractorSuBSENSE::getThreadCount() const {
+    return m_nThreadCount?m_nThreadCount:std::max((size_t)std::thread::hardware_concurrency(),size_t(1));
+}
+
+void BackgroundSubtractorSuBSENSE::updateBandLUT() {
+    m_vnBandModelIterLUT.clear();
+    m_voBandRNGs.clear();
+    if(m_nThreadCount==1)
+        return;
+    const size_t nRows = (size_t)m_oImgSize.height;
+    const size_t nBandRows = std::max(nRows/(getThreadCount()*BANDS_PER_THREAD),(size_t)MIN_BAND_ROWS);
+    // the model pixel LUT is sorted by image index, so each band of rows maps to a contiguous range of model iters
+    for(size_t nRowIdx=0; nRowIdx<nRows; nRowIdx+=nBandRows) {
+        const size_t nBandStartPxIdx = nRowIdx*(size_t)m_oImgSize.width;
+        m_vnBandModelIterLUT.push_back(size_t(std::lower_bound(m_vnPxIdxLUT.begin(),m_vnPxIdxLUT.begin()+m_nTotRelevantPxCount,nBandStartPxIdx)-m_vnPxIdxLUT.begin()));
+        // the last band absorbs leftover rows if they are too few to be a band of their own
+        if(nRows-nRowIdx<nBandRows*2)
+            break;
     }
-    oAvgBGImg.convertTo(backgroundImage,CV_8U);
+    m_vnBandModelIterLUT.push_back(m_nTotRelevantPxCount);
+    const size_t nBands = m_vnBandModelIterLUT.size()-1;
+    m_voBandRNGs.reserve(nBands);
+    for(size_t nBandIdx=0; nBandIdx<nBands; ++nBandIdx)
+        m_voBandRNGs.emplace_back(m_oRNG(),nBandIdx);
+}
+
+void BackgroundSubtractorSuBSENSE::getBackgroundImage(cv::OutputArray backgroundImage) const {
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    // if 'apply' is running, the images it published at the end of the previous frame are returned without waiting on it
+    m_oBGMeanImgs.publishIfIdle(m_oBGSamples,m_oModelMutex);
+    m_oBGMeanImgs.getColorImage(backgroundImage);
 }
 
 void BackgroundSubtractorSuBSENSE::getBackgroundDescriptorsImage(cv::OutputArray backgroundDescImage) const {
     static_assert(LBSP::DESC_SIZE==2,"bad assumptions in impl below");
     lvAssert_(m_bInitialized,"algo must be initialized first");
-    cv::Mat oAvgBGDesc = cv::Mat::zeros(m_oImgSize,CV_32FC((int)m_nImgChannels));
-    for(size_t n=0; n<m_voBGDescSamples.size(); ++n) {
-        for(int y=0; y<m_oImgSize.height; ++y) {
-            for(int x=0; x<m_oImgSize.width; ++x) {
-                const size_t idx_ndesc = m_voBGDescSamples[n].step.p[0]*y + m_voBGDescSamples[n].step.p[1]*x;
-                const size_t nFloatIter = idx_ndesc*2;
-                float* oAvgBgDescPtr = (float*)(oAvgBGDesc.data+nFloatIter);
-                const ushort* const oBGDescPtr = (ushort*)(m_voBGDescSamples[n].data+idx_ndesc);
-                for(size_t c=0; c<m_nImgChannels; ++c)
-                    oAvgBgDescPtr[c] += ((float)oBGDescPtr[c])/m_voBGDescSamples.size();
-            }
-        }
+    m_oBGMeanImgs.publishIfIdle(m_oBGSamples,m_oModelMutex);
+    m_oBGMeanImgs.getDescImage(backgroundDescImage);
+}
+
+void BackgroundSubtractorSuBSENSE::setInterleavedSampleModel(bool bInterleaved) {
+    m_bUsingInterleavedSamples = bInterleaved;
+    if(m_bInitialized) {
+        // converts the current model in-place if its layout differs (the deduplicated layout, if enabled, has priority)
+        std::mutex_lock_guard oModelLock(m_oModelMutex);
+        const std::pair<bool,size_t> oOldLayout(m_oBGSamples.isDeduplicated(),m_oBGSamples.slots());
+        m_oBGSamples.setLayout(m_bUsingInterleavedSamples,(m_nImgType==CV_16UC1)?0:m_nDedupSampleSlots); // as in 'initialize', 16-bit samples are never deduplicated
+        if(oOldLayout!=std::make_pair(m_oBGSamples.isDeduplicated(),m_oBGSamples.slots()))
+            m_oStableSampleIdxFrame = cv::Scalar_<ushort>(0); // stable sample indices are slot indices, and cannot be carried over
+    }
+}
+
+void BackgroundSubtractorSuBSENSE::setBitSlicedDescriptors(bool bEnabled) {
+    m_bUsingBitSlicedDescs = bEnabled;
+    std::mutex_lock_guard oModelLock(m_oModelMutex);
+    m_oBGSamples.setBitSlicedDescriptors(bEnabled);
+}
+
+void BackgroundSubtractorSuBSENSE::setDeduplicatedSampleModel(bool bEnabled, size_t nMaxDistinctSamples) {
+    lvAssert_(!bEnabled || (nMaxDistinctSamples>0 && nMaxDistinctSamples<=LBSPSampleModel::MAX_SLOTS && m_nBGSamples<=LBSPSampleModel::MAX_SLOTS),"bad distinct sample count (or too many samples per pixel for deduplication)");
+    m_nDedupSampleSlots = bEnabled?nMaxDistinctSamples:0;
+    setInterleavedSampleModel(m_bUsingInterleavedSamples);
+}
+
+void BackgroundSubtractorSuBSENSE::setModelCapacity(size_t nBGSamples) {
+    lvAssert_(nBGSamples>0 && m_nRequiredBGSamples<=nBGSamples && nBGSamples<=USHRT_MAX,"algo cannot require more sample matches than sample count in model");
+    lvAssert_(!m_nDedupSampleSlots || nBGSamples<=LBSPSampleModel::MAX_SLOTS,"deduplicated sample layout supports at most 255 samples per pixel");
+    std::mutex_lock_guard oModelLock(m_oModelMutex);
+    if(m_bInitialized && nBGSamples!=m_nBGSamples)
+        m_oBGSamples.resizeSamples(nBGSamples,&m_oStableSampleIdxFrame);
+    m_nBGSamples = nBGSamples;
+}
+
+std::shared_ptr<IIBackgroundSubtractor> BackgroundSubtractorSuBSENSE::createInstance() const {
+    auto pClone = std::make_shared<BackgroundSubtractorSuBSENSE>(m_nDescDistThresholdOffset,m_nMinColorDistThreshold,m_nBGSamples,m_nRequiredBGSamples,m_nSamplesForMovingAvgs,m_fRelLBSPThreshold);
+    pClone->setDescriptorCache(m_bUsingDescCache,m_nDescCacheNoiseFloor);
+    pClone->setBlockSampleMatching(m_bUsingBlockMatching);
+    pClone->setInterleavedSampleModel(m_bUsingInterleavedSamples);
+    pClone->setDeduplicatedSampleModel(m_nDedupSampleSlots>0,m_nDedupSampleSlots?m_nDedupSampleSlots:BGSLBSP_DEFAULT_DEDUP_SAMPLE_SLOTS);
+    pClone->setBitSlicedDescriptors(m_bUsingBitSlicedDescs);
+    pClone->setCompactStateMaps(m_bUsingCompactStateMaps);
+    pClone->setThreadCount(m_nThreadCount);
+    pClone->setIncrementalModelReset(m_nIncrementalResetFrames);
+    pClone->setGlobalMotionCompensation(m_bUsingGlobalMotionCompensation);
+    pClone->setStabilityShortcut(m_bUsingStabilityShortcut,m_nStabilityMinBGStreak,m_fStabilityMaxMeanLastDist);
+    pClone->setCoarseToFineClassification(m_bUsingCoarseToFineClassification,m_nC2FCoarseStride,m_nC2FRefineMargin);
+    return pClone;
+}
+
+void BackgroundSubtractorSuBSENSE::writeModelState(std::ostream& oStream) const {
+    writeLBSPModelState(oStream);
+    if(!m_pModelCloneSource) // samples are shared directly with clones instead
+        m_oBGSamples.write(oStream);
+    lv::writeBinary(oStream,m_fLastNonZeroDescRatio);
+    lv::writeBinary(oStream,m_bLearningRateScalingEnabled);
+    lv::writeBinary(oStream,m_fCurrLearningRateLowerCap);
+    lv::writeBinary(oStream,m_fCurrLearningRateUpperCap);
+    lv::writeBinary(oStream,(int32_t)m_nMedianBlurKernelSize);
+    lv::writeBinary(oStream,m_bUse3x3Spread);
+    // state maps are written in their current storage format (float or compact), and converted on load if needed
+    const std::array<cv::Mat*,STATE_MAP_COUNT> apStateMaps = const_cast<BackgroundSubtractorSuBSENSE*>(this)->getStateMaps();
+    for(size_t n=0; n<STATE_MAP_COUNT; ++n)
+        cv::writeBinary(oStream,*apStateMaps[n]);
+    cv::writeBinary(oStream,m_oMeanDownSampledLastDistFrame_LT);
+    cv::writeBinary(oStream,m_oMeanDownSampledLastDistFrame_ST);
+    cv::writeBinary(oStream,m_oUnstableRegionMask);
+    cv::writeBinary(oStream,m_oBlinksFrame);
+    cv::writeBinary(oStream,m_oLastRawFGMask);
+    cv::writeBinary(oStream,m_oLastFGMask_dilated_inverted);
+    cv::writeBinary(oStream,m_oLastRawFGBlinkMask);
+    lv::writeBinary(oStream,m_voBandRNGs);
+}
+
+void BackgroundSubtractorSuBSENSE::readModelState(std::istream& oStream) {
+    lvAssert_(m_bInitialized,"algorithm must be initialized before its model state is read");
+    readLBSPModelState(oStream);
+    if(m_pModelCloneSource) {
+        BackgroundSubtractorSuBSENSE* const pSource = static_cast<BackgroundSubtractorSuBSENSE*>(m_pModelCloneSource);
+        std::mutex_lock_guard oModelLock(pSource->m_oModelMutex);
+        pSource->m_oBGSamples.cloneCOW(m_oBGSamples);
+    }
+    else
+        m_oBGSamples.read(oStream);
+    lvAssert_(m_oBGSamples.samples()>=m_nRequiredBGSamples && m_oBGSamples.channels()==m_nImgChannels,"model snapshot sample count mismatch");
+    if(m_oBGSamples.samples()!=m_nBGSamples) {
+        // snapshots taken with another model capacity are adopted as-is (stable sample indices are reset, as they might be out of range)
+        m_nBGSamples = m_oBGSamples.samples();
+        m_oStableSampleIdxFrame = cv::Scalar_<ushort>(0);
+    }
+    setInterleavedSampleModel(m_bUsingInterleavedSamples);
+    m_oBGSamples.setBitSlicedDescriptors(m_bUsingBitSlicedDescs);
+    lv::readBinary(oStream,m_fLastNonZeroDescRatio);
+    lv::readBinary(oStream,m_bLearningRateScalingEnabled);
+    lv::readBinary(oStream,m_fCurrLearningRateLowerCap);
+    lv::readBinary(oStream,m_fCurrLearningRateUpperCap);
+    int32_t nMedianBlurKernelSize;
+    lv::readBinary(oStream,nMedianBlurKernelSize);
+    m_nMedianBlurKernelSize = (int)nMedianBlurKernelSize;
+    lv::readBinary(oStream,m_bUse3x3Spread);
+    const std::array<cv::Mat*,STATE_MAP_COUNT> apStateMaps = getStateMaps();
+    for(size_t n=0; n<STATE_MAP_COUNT; ++n) {
+        cv::readBinary(oStream,*apStateMaps[n]);
+        lvAssert_(apStateMaps[n]->size()==m_oImgSize && apStateMaps[n]->channels()==1,"bad state map in model snapshot");
     }
-    oAvgBGDesc.convertTo(backgroundDescImage,CV_16U);
+    setCompactStateMaps(m_bUsingCompactStateMaps);
+    cv::readBinary(oStream,m_oMeanDownSampledLastDistFrame_LT);
+    cv::readBinary(oStream,m_oMeanDownSampledLastDistFrame_ST);
+    lvAssert_(m_oMeanDownSampledLastDistFrame_LT.size()==m_oDownSampledFrameSize && m_oMeanDownSampledLastDistFrame_ST.size()==m_oDownSampledFrameSize,"bad downsampled map in model snapshot");
+    cv::readBinary(oStream,m_oUnstableRegionMask);
+    cv::readBinary(oStream,m_oBlinksFrame);
+    cv::readBinary(oStream,m_oLastRawFGMask);
+    cv::readBinary(oStream,m_oLastFGMask_dilated_inverted);
+    cv::readBinary(oStream,m_oLastRawFGBlinkMask);
+    lvAssert_(m_oUnstableRegionMask.size()==m_oImgSize && m_oBlinksFrame.size()==m_oImgSize && m_oLastRawFGMask.size()==m_oImgSize &&
+              m_oLastFGMask_dilated_inverted.size()==m_oImgSize && m_oLastRawFGBlinkMask.size()==m_oImgSize,"bad mask in model snapshot");
+    std::vector<lv::PCG32> voBandRNGs;
+    lv::readBinary(oStream,voBandRNGs);
+    // band RNGs can only be restored if the thread count (and thus the band count) did not change since the snapshot
+    if(voBandRNGs.size()==m_voBandRNGs.size())
+        m_voBandRNGs = voBandRNGs;
+    m_oBGStreakFrame = cv::Scalar_<ushort>(0); // streaks are not part of the snapshot, and must be rebuilt from the restored model
 }
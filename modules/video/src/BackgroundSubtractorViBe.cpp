@@ -18,20 +18,278 @@
 #include "litiv/video/BackgroundSubtractorViBe.hpp"
 #include "litiv/utils/distances.hpp"
 #include "litiv/utils/opencv.hpp"
+#include "litiv/utils/parallel.hpp"
+
+// local define for the number of consecutive (raster-order) pixels interleaved in a single model block
+#define SAMPLE_BLOCK_SIZE (16)
+
+namespace {
+
+    /// returns the offset of a pixel's sample (first channel) in the block-interleaved model; channels are strided by SAMPLE_BLOCK_SIZE
+    inline size_t getBlockSampleOffset(size_t nPxIdx, size_t nSampleIdx, size_t nSamples, size_t nChannels) {
+        return ((nPxIdx/SAMPLE_BLOCK_SIZE*nSamples+nSampleIdx)*nChannels)*SAMPLE_BLOCK_SIZE+nPxIdx%SAMPLE_BLOCK_SIZE;
+    }
+
+    /// returns whether an input color matches a model sample (same rules as the naive impl)
+    template<size_t nChannels>
+    inline bool isSampleMatch(const uchar* anInputColor, const uchar* anSampleColor, size_t nColorDistThreshold);
+
+    template<>
+    inline bool isSampleMatch<1>(const uchar* anInputColor, const uchar* anSampleColor, size_t nColorDistThreshold) {
+        return lv::L1dist(anInputColor[0],anSampleColor[0])<nColorDistThreshold;
+    }
+
+    template<>
+    inline bool isSampleMatch<3>(const uchar* anInputColor, const uchar* anSampleColor, size_t nColorDistThreshold) {
+#if BGSVIBE_USE_SC_THRS_VALIDATION
+        const size_t nCurrSCColorDistThreshold = (size_t)(nColorDistThreshold*BGSVIBE_SINGLECHANNEL_THRESHOLD_DIFF_FACTOR)/3;
+        for(size_t c=0; c<3; c++)
+            if(lv::L1dist(anInputColor[c],anSampleColor[c])>nCurrSCColorDistThreshold)
+                return false;
+#endif //BGSVIBE_USE_SC_THRS_VALIDATION
+#if BGSVIBE_USE_L1_DISTANCE_CHECK
+        return lv::L1dist<3>(anInputColor,anSampleColor)<nColorDistThreshold*3;
+#else //(!BGSVIBE_USE_L1_DISTANCE_CHECK)
+        return lv::L2dist<3>(anInputColor,anSampleColor)<nColorDistThreshold*3;
+#endif //(!BGSVIBE_USE_L1_DISTANCE_CHECK)
+    }
+
+#if HAVE_SSE2
+
+    /// returns the 16-lane match mask (0xFF per matching lane) of a planar input block vs a model sample block
+    template<size_t nChannels>
+    inline __m128i getSampleMatchMask(const uchar* anInputBlock, const uchar* anSampleBlock, size_t nColorDistThreshold);
+
+    template<>
+    inline __m128i getSampleMatchMask<1>(const uchar* anInputBlock, const uchar* anSampleBlock, size_t nColorDistThreshold) {
+        lvDbgAssert(nColorDistThreshold>0);
+        const __m128i vnInput = _mm_load_si128((__m128i*)anInputBlock);
+        const __m128i vnSample = _mm_loadu_si128((__m128i*)anSampleBlock);
+        const __m128i vnDist = _mm_or_si128(_mm_subs_epu8(vnInput,vnSample),_mm_subs_epu8(vnSample,vnInput));
+        const __m128i vnMaxDist = _mm_set1_epi8((char)std::min(nColorDistThreshold-1,(size_t)UCHAR_MAX));
+        return _mm_cmpeq_epi8(_mm_subs_epu8(vnDist,vnMaxDist),_mm_setzero_si128());
+    }
+
+    template<>
+    inline __m128i getSampleMatchMask<3>(const uchar* anInputBlock, const uchar* anSampleBlock, size_t nColorDistThreshold) {
+        lvDbgAssert(nColorDistThreshold>0 && nColorDistThreshold*3<=UCHAR_MAX);
+        const __m128i vnZero = _mm_setzero_si128();
+        __m128i vnDistSum_lo = vnZero, vnDistSum_hi = vnZero;
+#if BGSVIBE_USE_SC_THRS_VALIDATION
+        const size_t nCurrSCColorDistThreshold = (size_t)(nColorDistThreshold*BGSVIBE_SINGLECHANNEL_THRESHOLD_DIFF_FACTOR)/3;
+        const __m128i vnMaxSCDist = _mm_set1_epi8((char)std::min(nCurrSCColorDistThreshold,(size_t)UCHAR_MAX));
+        __m128i vnSCMatch = _mm_set1_epi8(-1);
+#endif //BGSVIBE_USE_SC_THRS_VALIDATION
+        for(size_t c=0; c<3; ++c) {
+            const __m128i vnInput = _mm_load_si128((__m128i*)(anInputBlock+c*SAMPLE_BLOCK_SIZE));
+            const __m128i vnSample = _mm_loadu_si128((__m128i*)(anSampleBlock+c*SAMPLE_BLOCK_SIZE));
+            const __m128i vnDist = _mm_or_si128(_mm_subs_epu8(vnInput,vnSample),_mm_subs_epu8(vnSample,vnInput));
+#if BGSVIBE_USE_SC_THRS_VALIDATION
+            vnSCMatch = _mm_and_si128(vnSCMatch,_mm_cmpeq_epi8(_mm_subs_epu8(vnDist,vnMaxSCDist),vnZero));
+#endif //BGSVIBE_USE_SC_THRS_VALIDATION
+            const __m128i vnDist_lo = _mm_unpacklo_epi8(vnDist,vnZero), vnDist_hi = _mm_unpackhi_epi8(vnDist,vnZero);
+#if BGSVIBE_USE_L1_DISTANCE_CHECK
+            vnDistSum_lo = _mm_adds_epu16(vnDistSum_lo,vnDist_lo);
+            vnDistSum_hi = _mm_adds_epu16(vnDistSum_hi,vnDist_hi);
+#else //(!BGSVIBE_USE_L1_DISTANCE_CHECK)
+            vnDistSum_lo = _mm_adds_epu16(vnDistSum_lo,_mm_mullo_epi16(vnDist_lo,vnDist_lo));
+            vnDistSum_hi = _mm_adds_epu16(vnDistSum_hi,_mm_mullo_epi16(vnDist_hi,vnDist_hi));
+#endif //(!BGSVIBE_USE_L1_DISTANCE_CHECK)
+        }
+#if BGSVIBE_USE_L1_DISTANCE_CHECK
+        const __m128i vnMaxDistSum = _mm_set1_epi16((short)(nColorDistThreshold*3-1));
+#else //(!BGSVIBE_USE_L1_DISTANCE_CHECK)
+        // sqrt(S)<T <=> S<=T^2-1 for integer S and T, and T^2 fits in 16 bits since T<=255
+        const __m128i vnMaxDistSum = _mm_set1_epi16((short)(nColorDistThreshold*3*nColorDistThreshold*3-1));
+#endif //(!BGSVIBE_USE_L1_DISTANCE_CHECK)
+        const __m128i vnMatch_lo = _mm_cmpeq_epi16(_mm_subs_epu16(vnDistSum_lo,vnMaxDistSum),vnZero);
+        const __m128i vnMatch_hi = _mm_cmpeq_epi16(_mm_subs_epu16(vnDistSum_hi,vnMaxDistSum),vnZero);
+#if BGSVIBE_USE_SC_THRS_VALIDATION
+        return _mm_and_si128(_mm_packs_epi16(vnMatch_lo,vnMatch_hi),vnSCMatch);
+#else //(!BGSVIBE_USE_SC_THRS_VALIDATION)
+        return _mm_packs_epi16(vnMatch_lo,vnMatch_hi);
+#endif //(!BGSVIBE_USE_SC_THRS_VALIDATION)
+    }
+
+#endif //HAVE_SSE2
+
+} // anonymous namespace
 
 BackgroundSubtractorViBe::BackgroundSubtractorViBe(size_t nColorDistThreshold, size_t nBGSamples, size_t nRequiredBGSamples) :
         m_nBGSamples(nBGSamples),
         m_nRequiredBGSamples(nRequiredBGSamples),
         m_voBGImg(nBGSamples),
+        m_nImgChannels(0),
         m_nColorDistThreshold(nColorDistThreshold),
-        m_bInitialized(false) {
+        m_bInitialized(false),
+        m_bUsingOptimizedImpl(false) {
     lvAssert(m_nBGSamples>0 && m_nRequiredBGSamples<=m_nBGSamples);
 }
 
 BackgroundSubtractorViBe::~BackgroundSubtractorViBe() {}
 
+void BackgroundSubtractorViBe::setRandomSeed(uint64_t nSeed) {
+    m_oRNG.seed(nSeed);
+}
+
+void BackgroundSubtractorViBe::setOptimizedImpl(bool bEnabled) {
+    if(bEnabled==m_bUsingOptimizedImpl)
+        return;
+    if(m_bInitialized) {
+        if(m_nImgChannels==1)
+            convertModelLayout<1>(bEnabled);
+        else
+            convertModelLayout<3>(bEnabled);
+    }
+    m_bUsingOptimizedImpl = bEnabled;
+}
+
+template<size_t nChannels>
+void BackgroundSubtractorViBe::convertModelLayout(bool bToBlocks) {
+    lvAssert(m_voBGImg.size()==m_nBGSamples);
+    const size_t nTotPxCount = (size_t)m_oImgSize.area();
+    const size_t nBlockCount = (nTotPxCount+SAMPLE_BLOCK_SIZE-1)/SAMPLE_BLOCK_SIZE;
+    if(bToBlocks) {
+        m_vuBGSampleBlocks.assign(nBlockCount*m_nBGSamples*nChannels*SAMPLE_BLOCK_SIZE,uchar(0));
+        for(size_t s=0; s<m_nBGSamples; ++s) {
+            lvAssert(m_voBGImg[s].isContinuous() && m_voBGImg[s].total()==nTotPxCount && m_voBGImg[s].channels()==int(nChannels));
+            for(size_t nPxIdx=0; nPxIdx<nTotPxCount; ++nPxIdx) {
+                uchar* anSample = m_vuBGSampleBlocks.data()+getBlockSampleOffset(nPxIdx,s,m_nBGSamples,nChannels);
+                for(size_t c=0; c<nChannels; ++c)
+                    anSample[c*SAMPLE_BLOCK_SIZE] = m_voBGImg[s].data[nPxIdx*nChannels+c];
+            }
+            m_voBGImg[s].release();
+        }
+    }
+    else {
+        lvAssert(m_vuBGSampleBlocks.size()==nBlockCount*m_nBGSamples*nChannels*SAMPLE_BLOCK_SIZE);
+        for(size_t s=0; s<m_nBGSamples; ++s) {
+            m_voBGImg[s].create(m_oImgSize,CV_8UC((int)nChannels));
+            for(size_t nPxIdx=0; nPxIdx<nTotPxCount; ++nPxIdx) {
+                const uchar* anSample = m_vuBGSampleBlocks.data()+getBlockSampleOffset(nPxIdx,s,m_nBGSamples,nChannels);
+                for(size_t c=0; c<nChannels; ++c)
+                    m_voBGImg[s].data[nPxIdx*nChannels+c] = anSample[c*SAMPLE_BLOCK_SIZE];
+            }
+        }
+        std::vector<uchar>().swap(m_vuBGSampleBlocks);
+    }
+}
+
+template<size_t nChannels>
+bool BackgroundSubtractorViBe::isBackgroundPx_optimized(const uchar* anInputColor, size_t nPxIdx) const {
+    size_t nGoodSamplesCount=0, nSampleIdx=0;
+    while(nGoodSamplesCount<m_nRequiredBGSamples && nSampleIdx<m_nBGSamples) {
+        const uchar* anSample = m_vuBGSampleBlocks.data()+getBlockSampleOffset(nPxIdx,nSampleIdx,m_nBGSamples,nChannels);
+        std::array<uchar,nChannels> anSampleColor;
+        for(size_t c=0; c<nChannels; ++c)
+            anSampleColor[c] = anSample[c*SAMPLE_BLOCK_SIZE];
+        if(isSampleMatch<nChannels>(anInputColor,anSampleColor.data(),m_nColorDistThreshold))
+            nGoodSamplesCount++;
+        nSampleIdx++;
+    }
+    return nGoodSamplesCount>=m_nRequiredBGSamples;
+}
+
+template<size_t nChannels>
+void BackgroundSubtractorViBe::apply_optimized(const cv::Mat& oInputImg, cv::Mat& oFGMask, size_t nLearningRate) {
+    lvDbgAssert(oInputImg.channels()==int(nChannels) && oInputImg.size()==m_oImgSize && oFGMask.size()==m_oImgSize);
+    const size_t nTotPxCount = (size_t)m_oImgSize.area();
+    const size_t nBlockCount = (nTotPxCount+SAMPLE_BLOCK_SIZE-1)/SAMPLE_BLOCK_SIZE;
+    const size_t nSampleBlockStep = nChannels*SAMPLE_BLOCK_SIZE;
+    lvDbgAssert(m_vuBGSampleBlocks.size()==nBlockCount*m_nBGSamples*nSampleBlockStep);
+#if HAVE_SSE2
+    const bool bUseSIMD = m_nColorDistThreshold>0 && m_nRequiredBGSamples<=UCHAR_MAX && (nChannels==1 || m_nColorDistThreshold*3<=UCHAR_MAX);
+    const __m128i vnRequiredCount = _mm_set1_epi8((char)std::min(m_nRequiredBGSamples,(size_t)UCHAR_MAX));
+    const __m128i vnOne = _mm_set1_epi8(1);
+#endif //HAVE_SSE2
+    alignas(16) std::array<uchar,nChannels*SAMPLE_BLOCK_SIZE> anInputBlock;
+    for(size_t nBlockIdx=0; nBlockIdx<nBlockCount; ++nBlockIdx) {
+        const size_t nBlockPxIdx = nBlockIdx*SAMPLE_BLOCK_SIZE;
+        const size_t nBlockPxCount = std::min(nTotPxCount-nBlockPxIdx,(size_t)SAMPLE_BLOCK_SIZE);
+        anInputBlock.fill(uchar(0));
+        for(size_t nLaneIdx=0; nLaneIdx<nBlockPxCount; ++nLaneIdx) {
+            const size_t nPxIdx = nBlockPxIdx+nLaneIdx;
+            const uchar* anInputColor = oInputImg.ptr<uchar>(int(nPxIdx/m_oImgSize.width))+(nPxIdx%m_oImgSize.width)*nChannels;
+            for(size_t c=0; c<nChannels; ++c)
+                anInputBlock[c*SAMPLE_BLOCK_SIZE+nLaneIdx] = anInputColor[c];
+        }
+        const uchar* const pSampleBlocks = m_vuBGSampleBlocks.data()+nBlockIdx*m_nBGSamples*nSampleBlockStep;
+        uint32_t nBGLaneMask = 0; // bit 'n' is set if lane 'n' is classified as background
+#if HAVE_SSE2
+        if(bUseSIMD) {
+            __m128i vnGoodSamplesCount = _mm_setzero_si128();
+            for(size_t nSampleIdx=0; nSampleIdx<m_nBGSamples; ++nSampleIdx) {
+                if(_mm_movemask_epi8(_mm_cmpeq_epi8(vnGoodSamplesCount,vnRequiredCount))==0xFFFF)
+                    break;
+                const __m128i vnMatch = getSampleMatchMask<nChannels>(anInputBlock.data(),pSampleBlocks+nSampleIdx*nSampleBlockStep,m_nColorDistThreshold);
+                vnGoodSamplesCount = _mm_min_epu8(_mm_adds_epu8(vnGoodSamplesCount,_mm_and_si128(vnMatch,vnOne)),vnRequiredCount);
+            }
+            nBGLaneMask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(vnGoodSamplesCount,vnRequiredCount));
+        }
+        else
+#endif //HAVE_SSE2
+        {
+            for(size_t nLaneIdx=0; nLaneIdx<nBlockPxCount; ++nLaneIdx) {
+                std::array<uchar,nChannels> anInputColor;
+                for(size_t c=0; c<nChannels; ++c)
+                    anInputColor[c] = anInputBlock[c*SAMPLE_BLOCK_SIZE+nLaneIdx];
+                if(isBackgroundPx_optimized<nChannels>(anInputColor.data(),nBlockPxIdx+nLaneIdx))
+                    nBGLaneMask |= (1u<<nLaneIdx);
+            }
+        }
+        // updates are applied one pixel at a time in raster order to preserve the naive impl's rng call sequence
+        for(size_t nLaneIdx=0; nLaneIdx<nBlockPxCount; ++nLaneIdx) {
+            const size_t nPxIdx = nBlockPxIdx+nLaneIdx;
+            const int x = int(nPxIdx%m_oImgSize.width), y = int(nPxIdx/m_oImgSize.width);
+            if(!(nBGLaneMask&(1u<<nLaneIdx))) {
+                oFGMask.at<uchar>(y,x) = UCHAR_MAX;
+                continue;
+            }
+            const uchar* const anInputColor = oInputImg.ptr<uchar>(y)+x*nChannels;
+            if((m_oRNG()%nLearningRate)==0) {
+                uchar* anSample = m_vuBGSampleBlocks.data()+getBlockSampleOffset(nPxIdx,m_oRNG()%m_nBGSamples,m_nBGSamples,nChannels);
+                for(size_t c=0; c<nChannels; ++c)
+                    anSample[c*SAMPLE_BLOCK_SIZE] = anInputColor[c];
+            }
+            if((m_oRNG()%nLearningRate)==0) {
+                int x_rand,y_rand;
+                cv::getRandNeighborPosition_3x3(x_rand,y_rand,x,y,0,m_oImgSize,m_oRNG);
+                const size_t nNeighborPxIdx = size_t(y_rand)*m_oImgSize.width+x_rand;
+                uchar* anSample = m_vuBGSampleBlocks.data()+getBlockSampleOffset(nNeighborPxIdx,m_oRNG()%m_nBGSamples,m_nBGSamples,nChannels);
+                for(size_t c=0; c<nChannels; ++c)
+                    anSample[c*SAMPLE_BLOCK_SIZE] = anInputColor[c];
+                // the naive impl classifies pixels after their neighbors' updates; lanes not yet visited in this block must be rechecked
+                if(nNeighborPxIdx>nPxIdx && nNeighborPxIdx<nBlockPxIdx+nBlockPxCount) {
+                    const size_t nNeighborLaneIdx = nNeighborPxIdx-nBlockPxIdx;
+                    std::array<uchar,nChannels> anNeighborColor;
+                    for(size_t c=0; c<nChannels; ++c)
+                        anNeighborColor[c] = anInputBlock[c*SAMPLE_BLOCK_SIZE+nNeighborLaneIdx];
+                    if(isBackgroundPx_optimized<nChannels>(anNeighborColor.data(),nNeighborPxIdx))
+                        nBGLaneMask |= (1u<<nNeighborLaneIdx);
+                    else
+                        nBGLaneMask &= ~(1u<<nNeighborLaneIdx);
+                }
+            }
+        }
+    }
+}
+
 void BackgroundSubtractorViBe::getBackgroundImage(cv::OutputArray backgroundImage) const {
     lvAssert(m_bInitialized);
+    if(m_bUsingOptimizedImpl) {
+        const size_t nTotPxCount = (size_t)m_oImgSize.area();
+        cv::Mat oAvgBGImg = cv::Mat::zeros(m_oImgSize,CV_32FC((int)m_nImgChannels));
+        for(size_t nPxIdx=0; nPxIdx<nTotPxCount; ++nPxIdx) {
+            float* oAvgBgImgPtr = ((float*)oAvgBGImg.data)+nPxIdx*m_nImgChannels;
+            for(size_t n=0; n<m_nBGSamples; ++n) {
+                const uchar* const anSample = m_vuBGSampleBlocks.data()+getBlockSampleOffset(nPxIdx,n,m_nBGSamples,m_nImgChannels);
+                for(size_t c=0; c<m_nImgChannels; ++c)
+                    oAvgBgImgPtr[c] += ((float)anSample[c*SAMPLE_BLOCK_SIZE])/m_nBGSamples;
+            }
+        }
+        oAvgBGImg.convertTo(backgroundImage,CV_8U);
+        return;
+    }
     cv::Mat oAvgBGImg = cv::Mat::zeros(m_oImgSize,CV_32FC(m_voBGImg[0].channels()));
     for(size_t n=0; n<m_nBGSamples; ++n) {
         for(int y=0; y<m_oImgSize.height; ++y) {
@@ -65,11 +323,14 @@ void BackgroundSubtractorViBe_1ch::initialize(const cv::Mat& oInitImg) {
         for(int y_orig=0; y_orig<m_oImgSize.height; y_orig++) {
             for(int x_orig=0; x_orig<m_oImgSize.width; x_orig++) {
                 int y_sample, x_sample;
-                cv::getRandSamplePosition_7x7_std2(x_sample,y_sample,x_orig,y_orig,0,m_oImgSize);
+                cv::getRandSamplePosition_7x7_std2(x_sample,y_sample,x_orig,y_orig,0,m_oImgSize,m_oRNG);
                 m_voBGImg[s].at<uchar>(y_orig,x_orig) = oInitImg.at<uchar>(y_sample,x_sample);
             }
         }
     }
+    m_nImgChannels = 1;
+    if(m_bUsingOptimizedImpl)
+        convertModelLayout<1>(true);
     m_bInitialized = true;
 }
 
@@ -82,6 +343,10 @@ void BackgroundSubtractorViBe_1ch::apply(cv::InputArray _image, cv::OutputArray
     cv::Mat oFGMask = _fgmask.getMat();
     oFGMask = cv::Scalar_<uchar>(0);
     const size_t nLearningRate = (size_t)ceil(learningRate);
+    if(m_bUsingOptimizedImpl) {
+        apply_optimized<1>(oInputImg,oFGMask,nLearningRate);
+        return;
+    }
     for(int y=0; y<m_oImgSize.height; y++) {
         for(int x=0; x<m_oImgSize.width; x++) {
             size_t nGoodSamplesCount=0, nSampleIdx=0;
@@ -93,12 +358,12 @@ void BackgroundSubtractorViBe_1ch::apply(cv::InputArray _image, cv::OutputArray
             if(nGoodSamplesCount<m_nRequiredBGSamples)
                 oFGMask.at<uchar>(y,x) = UCHAR_MAX;
             else {
-                if((rand()%nLearningRate)==0)
-                    m_voBGImg[rand()%m_nBGSamples].at<uchar>(y,x)=oInputImg.at<uchar>(y,x);
-                if((rand()%nLearningRate)==0) {
+                if((m_oRNG()%nLearningRate)==0)
+                    m_voBGImg[m_oRNG()%m_nBGSamples].at<uchar>(y,x)=oInputImg.at<uchar>(y,x);
+                if((m_oRNG()%nLearningRate)==0) {
                     int x_rand,y_rand;
-                    cv::getRandNeighborPosition_3x3(x_rand,y_rand,x,y,0,m_oImgSize);
-                    m_voBGImg[rand()%m_nBGSamples].at<uchar>(y_rand,x_rand) = oInputImg.at<uchar>(y,x);
+                    cv::getRandNeighborPosition_3x3(x_rand,y_rand,x,y,0,m_oImgSize,m_oRNG);
+                    m_voBGImg[m_oRNG()%m_nBGSamples].at<uchar>(y_rand,x_rand) = oInputImg.at<uchar>(y,x);
                 }
             }
         }
@@ -127,11 +392,14 @@ void BackgroundSubtractorViBe_3ch::initialize(const cv::Mat& oInitImg) {
         m_voBGImg[s] = cv::Scalar(0,0,0);
         for(int y_orig=0; y_orig<m_oImgSize.height; y_orig++) {
             for(int x_orig=0; x_orig<m_oImgSize.width; x_orig++) {
-                cv::getRandSamplePosition_7x7_std2(x_sample,y_sample,x_orig,y_orig,0,m_oImgSize);
+                cv::getRandSamplePosition_7x7_std2(x_sample,y_sample,x_orig,y_orig,0,m_oImgSize,m_oRNG);
                 m_voBGImg[s].at<cv::Vec3b>(y_orig,x_orig) = oInitImgRGB.at<cv::Vec3b>(y_sample,x_sample);
             }
         }
     }
+    m_nImgChannels = 3;
+    if(m_bUsingOptimizedImpl)
+        convertModelLayout<3>(true);
     m_bInitialized = true;
 }
 
@@ -149,6 +417,10 @@ void BackgroundSubtractorViBe_3ch::apply(cv::InputArray _image, cv::OutputArray
     cv::Mat oFGMask = _fgmask.getMat();
     oFGMask = cv::Scalar_<uchar>(0);
     const size_t nLearningRate = (size_t)ceil(learningRate);
+    if(m_bUsingOptimizedImpl) {
+        apply_optimized<3>(oInputImgRGB,oFGMask,nLearningRate);
+        return;
+    }
     for(int y=0; y<m_oImgSize.height; y++) {
         for(int x=0; x<m_oImgSize.width; x++) {
 #if BGSVIBE_USE_SC_THRS_VALIDATION
@@ -177,15 +449,210 @@ void BackgroundSubtractorViBe_3ch::apply(cv::InputArray _image, cv::OutputArray
             if(nGoodSamplesCount<m_nRequiredBGSamples)
                 oFGMask.at<uchar>(y,x) = UCHAR_MAX;
             else {
-                if((rand()%nLearningRate)==0)
-                    m_voBGImg[rand()%m_nBGSamples].at<cv::Vec3b>(y,x)=oInputImgRGB.at<cv::Vec3b>(y,x);
-                if((rand()%nLearningRate)==0) {
+                if((m_oRNG()%nLearningRate)==0)
+                    m_voBGImg[m_oRNG()%m_nBGSamples].at<cv::Vec3b>(y,x)=oInputImgRGB.at<cv::Vec3b>(y,x);
+                if((m_oRNG()%nLearningRate)==0) {
                     int x_rand,y_rand;
-                    cv::getRandNeighborPosition_3x3(x_rand,y_rand,x,y,0,m_oImgSize);
-                    const size_t s_rand = rand()%m_nBGSamples;
+                    cv::getRandNeighborPosition_3x3(x_rand,y_rand,x,y,0,m_oImgSize,m_oRNG);
+                    const size_t s_rand = m_oRNG()%m_nBGSamples;
                     m_voBGImg[s_rand].at<cv::Vec3b>(y_rand,x_rand) = oInputImgRGB.at<cv::Vec3b>(y,x);
                 }
             }
         }
     }
 }
+
+#if HAVE_GLSL
+
+BackgroundSubtractorViBe_GLSL::BackgroundSubtractorViBe_GLSL(size_t nColorDistThreshold, size_t nBGSamples, size_t nRequiredBGSamples) :
+        IBackgroundSubtractor_GLSL(1,1,2,0,0,0,-1,false,BGSVIBE_GLSL_USE_TIMERS,true),
+        m_nColorDistThreshold(nColorDistThreshold),
+        m_nBGSamples(nBGSamples),
+        m_nRequiredBGSamples(nRequiredBGSamples) {
+    lvAssert_(m_nBGSamples>0 && m_nRequiredBGSamples<=m_nBGSamples,"algo cannot require more sample matches than sample count in model");
+    lvAssert_(m_nColorDistThreshold>0,"color distance threshold must be a positive value");
+    glErrorCheck;
+}
+
+void BackgroundSubtractorViBe_GLSL::refreshModel(float fSamplesRefreshFrac, bool bForceFGUpdate) {
+    lvDbgExceptionWatch;
+    // == refresh
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    lvAssert_(fSamplesRefreshFrac>0.0f && fSamplesRefreshFrac<=1.0f,"model refresh must be given as a non-null fraction");
+    const size_t nModelSamplesToRefresh = fSamplesRefreshFrac<1.0f?(size_t)(fSamplesRefreshFrac*m_nBGSamples):m_nBGSamples;
+    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?m_oRNG()%m_nBGSamples:0;
+    if(!bForceFGUpdate)
+        getLatestForegroundMask(m_oLastFGMask);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(ViBeStorageBuffer_BGModelBinding));
+    for(size_t nRowIdx=0; nRowIdx<(size_t)m_oImgSize.height; ++nRowIdx) {
+        const size_t nRowOffset = nRowIdx*m_oImgSize.width;
+        const size_t nModelRowOffset = nRowIdx*m_nRowStepSize;
+        for(size_t nColIdx=0; nColIdx<(size_t)m_oImgSize.width; ++nColIdx) {
+            const size_t nColOffset = nColIdx+nRowOffset;
+            const size_t nModelColOffset = nColIdx*m_nColStepSize+nModelRowOffset;
+            if(bForceFGUpdate || !m_oLastFGMask.data[nColOffset]) {
+                for(size_t nCurrModelSampleIdx=nRefreshSampleStartPos; nCurrModelSampleIdx<nRefreshSampleStartPos+nModelSamplesToRefresh; ++nCurrModelSampleIdx) {
+                    int nSampleRowIdx, nSampleColIdx;
+                    cv::getRandSamplePosition_7x7_std2(nSampleColIdx,nSampleRowIdx,(int)nColIdx,(int)nRowIdx,0,m_oImgSize,m_oRNG);
+                    const size_t nSamplePxIdx = nSampleColIdx + nSampleRowIdx*m_oImgSize.width;
+                    if(bForceFGUpdate || !m_oLastFGMask.data[nSamplePxIdx]) {
+                        const size_t nSampleOffset_color = nSamplePxIdx*m_nImgChannels;
+                        const size_t nModelPxOffset_color = (nCurrModelSampleIdx%m_nBGSamples)*m_nSampleStepSize+nModelColOffset;
+                        for(size_t nChannelIdx=0; nChannelIdx<m_nImgChannels; ++nChannelIdx) {
+                            // gpu-side samples are stored in rgb(a) order
+                            const size_t nSampleChannelIdx = (m_nImgChannels==1)?nChannelIdx:2-nChannelIdx;
+                            m_vnBGModelData[nModelPxOffset_color+nChannelIdx] = (uint)m_oLastColorFrame.data[nSampleOffset_color+nSampleChannelIdx];
+                        }
+                    }
+                }
+            }
+        }
+    }
+    glBufferData(GL_SHADER_STORAGE_BUFFER,m_nBGModelSize*sizeof(uint),m_vnBGModelData.data(),GL_STATIC_COPY);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,ViBeStorageBuffer_BGModelBinding,getSSBOId(ViBeStorageBuffer_BGModelBinding));
+    glErrorCheck;
+}
+
+void BackgroundSubtractorViBe_GLSL::initialize_gl(const cv::Mat& oInitImg, const cv::Mat& oROI) {
+    lvDbgExceptionWatch;
+    // == init
+    lvAssert_(oInitImg.type()==CV_8UC1 || oInitImg.type()==CV_8UC3,"algo only supports 8UC1 & 8UC3 images");
+    initialize_common(oInitImg,oROI);
+    m_nTMT32ModelSize = size_t(m_oROI.cols*m_oROI.rows);
+    // 3-channel inputs are expanded to rgba layers on the gpu (see GLImageProcAlgo's packed input mode), so samples are stored as uvec4s
+    m_nSampleStepSize = (m_nImgChannels==1)?1:4;
+    m_nPxModelSize = m_nSampleStepSize*m_nBGSamples;
+    m_nPxModelPadding = (m_nPxModelSize%4)?4-m_nPxModelSize%4:0;
+    m_nColStepSize = m_nPxModelSize+m_nPxModelPadding;
+    m_nRowStepSize = m_nColStepSize*m_oROI.cols;
+    m_nBGModelSize = m_nRowStepSize*m_oROI.rows;
+    const int nMaxSSBOBlockSize = lv::gl::getIntegerVal<1>(GL_MAX_SHADER_STORAGE_BLOCK_SIZE);
+    lvAssert_(nMaxSSBOBlockSize>(int)(m_nBGModelSize*sizeof(uint)) && nMaxSSBOBlockSize>(int)(m_nTMT32ModelSize*sizeof(lv::gl::TMT32GenParams)),"max ssbo block size is tool small for the predicted model size");
+    m_vnBGModelData.resize(m_nBGModelSize,0);
+    lv::gl::TMT32GenParams::initTinyMT32Generators(glm::uvec3(uint(m_oROI.cols),uint(m_oROI.rows),1),m_voTMT32ModelData);
+    m_bInitialized = true;
+    GLImageProcAlgo::initialize_gl(oInitImg,m_oROI);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(ViBeStorageBuffer_TMT32ModelBinding));
+    glBufferData(GL_SHADER_STORAGE_BUFFER,m_nTMT32ModelSize*sizeof(lv::gl::TMT32GenParams),m_voTMT32ModelData.data(),GL_STATIC_COPY);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER,ViBeStorageBuffer_TMT32ModelBinding,getSSBOId(ViBeStorageBuffer_TMT32ModelBinding));
+    refreshModel(1.0f,true);
+    m_bModelInitialized = true;
+}
+
+std::string BackgroundSubtractorViBe_GLSL::getComputeShaderSource(size_t nStage) const {
+    lvDbgExceptionWatch;
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    lvAssert_(nStage<m_nComputeStages,"required compute stage does not exist");
+    const bool b3ch = (m_nImgChannels!=1);
+    std::stringstream ssSrc;
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "#version 430\n";
+    if(b3ch) ssSrc << // same as the CPU impl, i.e. L2 distance below 3x the color dist threshold (compared squared here)
+             "#define COLOR_DIST_SQR_THRESHOLD " << (m_nColorDistThreshold*3)*(m_nColorDistThreshold*3) << "\n";
+    else ssSrc <<
+             "#define COLOR_DIST_THRESHOLD     " << m_nColorDistThreshold << "\n";
+    ssSrc << "#define NB_SAMPLES               " << m_nBGSamples << "\n"
+             "#define NB_REQ_SAMPLES           " << m_nRequiredBGSamples << "\n"
+             "#define MODEL_STEP_SIZE          " << m_oFrameSize.width << "\n"
+             "layout(local_size_x=" << m_vDefaultWorkGroupSize.x << ",local_size_y=" << m_vDefaultWorkGroupSize.y << ") in;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_ROIBinding << ", r8ui) readonly uniform uimage2D mROI;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_InputBinding << ", " << (b3ch?"rgba8ui":"r8ui") << ") readonly uniform uimage2D mInput;\n"
+             "layout(binding=" << GLImageProcAlgo::Image_OutputBinding << ", r8ui) writeonly uniform uimage2D mOutput;\n" <<
+             (b3ch?std::string():lv::getShaderFunctionSource_absdiff(true)) <<
+             GLShader::getShaderFunctionSource_urand_tinymt32() <<
+             GLShader::getShaderFunctionSource_getRandNeighbor3x3(0,m_oFrameSize) <<
+             "struct PxModel {\n"
+             "    " << (b3ch?"uvec4":"uint") << " color_samples[" << m_nBGSamples << "];\n";
+    if(m_nPxModelPadding>0) ssSrc <<
+             "    uint pad[" << m_nPxModelPadding << "];\n";
+    ssSrc << "};\n"
+             "layout(binding=" << ViBeStorageBuffer_BGModelBinding << ", std430) coherent buffer bBGModel {\n"
+             "    PxModel aoPxModels[];\n"
+             "};\n"
+             "layout(binding=" << ViBeStorageBuffer_TMT32ModelBinding << ", std430) buffer bTMT32Model {\n"
+             "    TMT32Model aoTMT32Models[];\n"
+             "};\n"
+             "#define urand() urand(aoTMT32Models[nModelIdx])\n"
+             "uniform uint nResamplingRate;\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ssSrc << "void main() {\n"
+             "    ivec2 vImgCoords = ivec2(gl_GlobalInvocationID.xy);\n"
+             "    uvec4 vSegmResult = uvec4(0);\n"
+             "    uint nROIVal = imageLoad(mROI,vImgCoords).r;\n"
+             "    uint nModelIdx = gl_GlobalInvocationID.y*MODEL_STEP_SIZE + gl_GlobalInvocationID.x;\n"
+             "    uvec3 vInputColor = imageLoad(mInput,vImgCoords).rgb;\n"
+             "    if(bool(nROIVal)) {\n"
+             "        uint nGoodSamplesCount=0, nSampleIdx=0;\n"
+             "        while(nSampleIdx<NB_SAMPLES) {\n";
+    if(b3ch) ssSrc <<
+             "            ivec3 vCurrColorDiff = ivec3(vInputColor)-ivec3(aoPxModels[nModelIdx].color_samples[nSampleIdx].rgb);\n"
+             "            ivec3 vCurrColorSqrDiff = vCurrColorDiff*vCurrColorDiff;\n"
+             "            if(uint(vCurrColorSqrDiff.r+vCurrColorSqrDiff.g+vCurrColorSqrDiff.b)<COLOR_DIST_SQR_THRESHOLD)\n";
+    else ssSrc <<
+             "            if(absdiff(vInputColor.r,aoPxModels[nModelIdx].color_samples[nSampleIdx])<COLOR_DIST_THRESHOLD)\n";
+    ssSrc << "                ++nGoodSamplesCount;\n"
+             "            ++nSampleIdx;\n"
+             "            if(nGoodSamplesCount>=NB_REQ_SAMPLES)\n"
+             "                break;\n"
+             "        }\n"
+             "        if(nGoodSamplesCount<NB_REQ_SAMPLES)\n"
+             "            vSegmResult.r = 255;\n"
+             "        else {\n"
+             "            if((urand()%nResamplingRate)==0) {\n"
+             "                aoPxModels[nModelIdx].color_samples[(urand()%NB_SAMPLES)] = " << (b3ch?"uvec4(vInputColor,0);\n":"vInputColor.r;\n") <<
+             "                memoryBarrier();\n"
+             "            }\n"
+             "            if((urand()%nResamplingRate)==0) {\n"
+             "                ivec2 vNeighbCoords = getRandNeighbor3x3(vImgCoords,urand());\n"
+             "                uint nNeighbPxModelIdx = uint(vNeighbCoords.y)*MODEL_STEP_SIZE + uint(vNeighbCoords.x);\n"
+             "                aoPxModels[nNeighbPxModelIdx].color_samples[(urand()%NB_SAMPLES)] = " << (b3ch?"uvec4(vInputColor,0);\n":"vInputColor.r;\n") <<
+             "                memoryBarrier();\n"
+             "            }\n"
+             "        }\n"
+             "    }\n"
+             "    imageStore(mOutput,vImgCoords,vSegmResult);\n"
+             "}\n";
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    return ssSrc.str();
+}
+
+void BackgroundSubtractorViBe_GLSL::dispatch(size_t nStage, GLShader& oShader) {
+    lvDbgExceptionWatch;
+    lvAssert_(nStage<m_nComputeStages,"required compute stage does not exist");
+    if(m_dCurrLearningRate>0)
+        oShader.setUniform1ui("nResamplingRate",(GLuint)ceil(m_dCurrLearningRate));
+    else
+        oShader.setUniform1ui("nResamplingRate",BGSVIBE_DEFAULT_LEARNING_RATE);
+    glDispatchCompute((GLuint)ceil((float)m_oFrameSize.width/m_vDefaultWorkGroupSize.x),(GLuint)ceil((float)m_oFrameSize.height/m_vDefaultWorkGroupSize.y),1);
+}
+
+void BackgroundSubtractorViBe_GLSL::getBackgroundImage(cv::OutputArray oBGImg) const {
+    lvDbgExceptionWatch;
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    lvAssert_(m_bGLInitialized && !m_vnBGModelData.empty(),"algo gpu bg model not initialized");
+    oBGImg.create(m_oImgSize,CV_8UC(int(m_nImgChannels)));
+    cv::Mat oOutputImg = oBGImg.getMatRef();
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(ViBeStorageBuffer_BGModelBinding));
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER,0,m_nBGModelSize*sizeof(uint),(void*)m_vnBGModelData.data());
+    glErrorCheck;
+    for(size_t nRowIdx=0; nRowIdx<(size_t)m_oImgSize.height; ++nRowIdx) {
+        const size_t nModelRowOffset = nRowIdx*m_nRowStepSize;
+        const size_t nImgRowOffset = nRowIdx*oOutputImg.step.p[0];
+        for(size_t nColIdx=0; nColIdx<(size_t)m_oImgSize.width; ++nColIdx) {
+            const size_t nModelColOffset = nColIdx*m_nColStepSize+nModelRowOffset;
+            const size_t nImgColOffset = nColIdx*oOutputImg.step.p[1]+nImgRowOffset;
+            std::array<float,3> afCurrPxSum = {0.0f,0.0f,0.0f};
+            for(size_t nSampleIdx=0; nSampleIdx<m_nBGSamples; ++nSampleIdx) {
+                const size_t nModelPxOffset = nSampleIdx*m_nSampleStepSize+nModelColOffset;
+                for(size_t nChannelIdx=0; nChannelIdx<m_nImgChannels; ++nChannelIdx)
+                    afCurrPxSum[nChannelIdx] += m_vnBGModelData[nChannelIdx+nModelPxOffset];
+            }
+            for(size_t nChannelIdx=0; nChannelIdx<m_nImgChannels; ++nChannelIdx) {
+                const size_t nSampleChannelIdx = (m_nImgChannels==1)?nChannelIdx:2-nChannelIdx;
+                oOutputImg.data[nSampleChannelIdx+nImgColOffset] = (uchar)(afCurrPxSum[nChannelIdx]/m_nBGSamples);
+            }
+        }
+    }
+}
+
+#endif //HAVE_GLSL
@@ -30,6 +30,7 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/video/tracking.hpp>
+#include <array>
 #if !USE_VPTZ_STANDALONE
 #if !HAVE_GLSL
 #error "vptz requires full OpenGL support"
@@ -42,6 +43,10 @@
 #endif //(!USE_VPTZ_STANDALONE)
 
 #define VPTZ_MINIMUM_BBOX_RADIUS 3
+#define VPTZ_USE_ASYNC_DECODING  1  // decodes panoramic video frames in a background thread (overlaps with tracking/rendering)
+#define VPTZ_PANO_PBO_COUNT      2  // number of pixel unpack buffers used to stream panoramic frames to the GPU
+#define VPTZ_MAX_SEQUENTIAL_SKIP 30 // max number of frames skipped by sequential decoding before seeking instead
+#define VPTZ_VIEWPORT_PBO_COUNT  2  // number of pixel pack buffers used for asynchronous viewport readbacks
 
 namespace vptz {
 
@@ -72,7 +77,7 @@ namespace vptz {
         PTZ_CAM_EXECUTION_DELAY,
         PTZ_CAM_MOTION_DELAY,
 
-        // both get (read) and set (write), 11 properties
+        // both get (read) and set (write), 13 properties
         PTZ_CAM_FRAME_RATE,
         PTZ_CAM_FRAME_POS,
         PTZ_CAM_VERTI_FOV,
@@ -83,12 +88,15 @@ namespace vptz {
         PTZ_CAM_HORI_SPEED,
         PTZ_CAM_VERTI_SPEED,
         PTZ_CAM_EXECUTION_DELAY_RATIO,
-        PTZ_CAM_COMMUNICATION_DELAY
+        PTZ_CAM_COMMUNICATION_DELAY,
+        PTZ_CAM_SIMULATED_CLOCK,
+        PTZ_CAM_SIMULATED_EXECUTION_DELAY
     };
 
     class VPTZ_API Camera {
     public:
         /// Default Constructor; the default values are taken from the datasheet of the SONY network camera SNC-RZ50N.
+        /// note: with use_cpu_renderer, no OpenGL context is created, and viewports are rendered on the CPU via a cached remap LUT (same output as the GL path within interpolation tolerance)
         Camera( const std::string& input_file_path, // input video or image file path
                 double verti_FOV = 90.0,
                 double output_width = 640.0,
@@ -97,7 +105,8 @@ namespace vptz {
                 double verti_angle = 90.0,
                 double hori_speed = 300.0,
                 double verti_speed = 300.0,
-                double communication_delay = 0.2);
+                double communication_delay = 0.2,
+                bool use_cpu_renderer = false);
         ~Camera();
 
         /// moves the view to center the target point; throws if the point is out of image bounds. The User can also set the horizontal and vertical (pan and tilt) angles via the Set(...) function.
@@ -106,10 +115,14 @@ namespace vptz {
         void GoToPosition(cv::Point target);
         /// begins playing the video sequence; throws if the frame index is invalid.
         void BeginPlaying(int nFrameIdx=0);
-        /// simulate the response delay of a PTZ camera; returns false if the video ends before the end of the waiting period.
+        /// simulate the response delay of a PTZ camera; returns false if the video ends before the end of the waiting period (never sleeps in simulated clock mode).
         bool WaitDelay(bool bSleep=false);
         /// returns the current frame from the video sequence given the current FoV; specific frames can be obtained by using Set(...) prior to calling
         const cv::Mat& GetFrame();
+        /// renders the current frame and starts its asynchronous readback; GetFrame() reuses it if the camera state does not change in-between
+        void PrepareFrame();
+        /// renders the current frame (if needed) and returns the GL texture holding it (top row first, readable in the camera context only); returns 0 if the frame cannot be decoded (throws with the CPU renderer)
+        GLuint GetFrameTexture();
         /// manual update function to replace the panoramic image (for image mode only)
         void UpdatePanoImage(cv::Mat& image);
         /// global property Getter, see 'CameraPropertyFlag' enum for options; throws if flag is invalid.
@@ -129,9 +142,53 @@ namespace vptz {
         int m_nScenarioFrameCount;               // total number of frames of input video, 1 for image, get
         int m_nCurrFrameIdx;                     // current frame position (number, [0, frameNum-1]), get, set
         GLuint m_nTexID;
-        GLUquadricObj* m_pSphereObj;
+        GLuint m_nSphereProgID;                  // renders the panorama sphere via per-pixel ray lookups (no mesh)
+        GLuint m_nSphereVAOID;                   // empty vertex array used for the full-screen triangle draw
+        GLint m_nRayMatrixUniformLoc;            // location of the viewport-to-sphere ray matrix uniform
         cv::Mat m_oViewportFrame;
 
+        // panoramic frame streaming
+        std::array<GLuint,VPTZ_PANO_PBO_COUNT> m_anPanoPBOIDs; // ring of pixel unpack buffers used for texture updates
+        size_t m_nCurrPanoPBOIdx;                // index of the last filled unpack buffer
+        cv::Size m_oPanoTexSize;                 // size of the allocated (immutable) panorama texture storage
+        int m_nUploadedFrameIdx;                 // index of the frame currently held by the panorama texture (-1 if none/outdated)
+        int m_nDecoderCaptureIdx;                // index of the next frame the capture will read sequentially (INT_MAX if unknown)
+
+        // viewport rendering & readback
+        GLuint m_nViewportFBOID;                 // offscreen framebuffer the viewport is rendered into (vertically flipped on the GPU)
+        GLuint m_nViewportTexID;                 // color attachment of the viewport framebuffer
+        std::array<GLuint,VPTZ_VIEWPORT_PBO_COUNT> m_anViewportPBOIDs; // ring of pixel pack buffers used for readbacks
+        std::array<GLsync,VPTZ_VIEWPORT_PBO_COUNT> m_apViewportFences; // fences signaled when the matching readbacks are done
+        size_t m_nCurrViewportPBOIdx;            // index of the last readback buffer used
+        int m_nRenderedFrameIdx;                 // frame index of the last rendered viewport (-1 if none)
+        double m_dRenderedHoriAngle;             // horizontal angle of the last rendered viewport
+        double m_dRenderedVertiAngle;            // vertical angle of the last rendered viewport
+        double m_dRenderedVertiFOV;              // vertical FOV of the last rendered viewport
+        bool m_bViewportReadbackPending;         // true if the last rendered viewport is being read back
+        bool m_bViewportFrameReady;              // true if m_oViewportFrame holds the last rendered viewport
+
+        // cpu rendering (replaces all GL resources above when enabled)
+        const bool m_bUsingCPURenderer;          // true if viewports are rendered on the CPU (no GL context is created)
+        cv::Mat m_oViewportMapX, m_oViewportMapY; // viewport-to-panorama pixel coords LUT (float, rebuilt only when the camera moves)
+        cv::Mat m_oViewportMap1, m_oViewportMap2; // fixed-point version of the LUT used by cv::remap
+        cv::Mat m_oViewportFrameBGR;             // remap output for 3-channel panoramas (expanded to BGRA afterwards)
+        cv::Size m_oViewportMapPanoSize;         // panorama size the LUT was built for (empty if none)
+        double m_dViewportMapHoriAngle;          // horizontal angle the LUT was built for
+        double m_dViewportMapVertiAngle;         // vertical angle the LUT was built for
+        double m_dViewportMapVertiFOV;           // vertical FOV the LUT was built for
+#if VPTZ_USE_ASYNC_DECODING
+        std::thread m_oDecoderThread;            // background video decoder, fed via RequestFrame(...)
+        std::mutex m_oDecoderMutex;
+        std::condition_variable m_oDecoderReqCondVar;
+        std::condition_variable m_oDecoderDoneCondVar;
+        cv::Mat m_oDecodedFrame;                 // last frame published by the decoder (guarded by mutex)
+        cv::Mat m_oDecoderBuffer;                // decoder-owned work buffer (only accessed by decoder thread)
+        int m_nDecoderReqFrameIdx;               // index of the frame requested from the decoder (-1 if none)
+        int m_nDecodedFrameIdx;                  // index of the last frame published by the decoder (-1 if none)
+        bool m_bDecodedFrameValid;               // false if the last published frame could not be decoded
+        bool m_bDecoderStop;
+#endif //VPTZ_USE_ASYNC_DECODING
+
         // constant parameters for OpenGL rendering (basic parameters)
         double vertiFOV;                         // vertical FOV angle of virtual camera (degree, (0, 180)), get, set
         double outputWidth, outputHeight;        // width and height of output image (pixel, >=1), get, set
@@ -141,6 +198,8 @@ namespace vptz {
         // constant parameters for frame update
         double horiSpeed, vertiSpeed;            // horizontal (pan) and vertical (tilt) speeds of the camera (degree per second, >0), get, set
         double executionDelayRatio;              // ratio multiplied to execution delay, default value is 1.0 (>0), get, set
+        bool simulatedClock;                     // if true, execution delays are taken from simulatedExecutionDelay instead of the wall clock (deterministic), get, set
+        double simulatedExecutionDelay;          // declared execution delay of tracker per frame in simulated clock mode (second, >=0), get, set
 
         // variables for frame update
         double firstTick;                        // for playing the video
@@ -156,9 +215,27 @@ namespace vptz {
         double communicationDelay;               // communication delay (second, >=0), get, set
 
         // OpenGL internals
-        int sphereGridSize;                      // grid size of the sphere
         std::unique_ptr<lv::gl::Context> m_pContext;
 
+        /// (re)allocates immutable storage for the panorama texture
+        void AllocatePanoTexture(const cv::Size& oSize);
+        /// streams a BGR (or BGRA) panoramic frame to the texture through the unpack buffer ring
+        void UploadPanoImage(const cv::Mat& oImage);
+        /// decodes a given frame, reading sequentially from the current capture position when possible instead of seeking
+        bool DecodeFrame(int nFrameIdx, cv::Mat& oFrame);
+        /// notifies the background decoder (if any) that a frame will soon be needed
+        void RequestFrame(int nFrameIdx);
+        /// uploads the current panoramic frame & renders the viewport if the camera state changed; returns false if the frame cannot be decoded
+        bool UpdateViewport();
+        /// waits for the pending viewport readback and copies it into m_oViewportFrame
+        void FetchViewport();
+        /// renders the viewport into m_oViewportFrame on the CPU using the given ray matrix (see UpdateViewport), rebuilding the remap LUT only if the camera moved
+        void RenderViewportCPU(const cv::Matx33d& oRayToSphere);
+#if VPTZ_USE_ASYNC_DECODING
+        /// background decoder loop
+        void DecoderThread();
+#endif //VPTZ_USE_ASYNC_DECODING
+
         Camera(const Camera&) = delete;
         Camera& operator=(const Camera&) = delete;
     };
@@ -208,6 +285,10 @@ namespace vptz {
         // used to get basic ground truth
         int bgtOutputWidth, bgtOutputHeight;    // width and height of camera output image in ground truth(pixel, >=1)
         double bgtVertiFOV;                     // horizontal FOV angle of the virtual camera in ground truth (degree, (0, 180))
+
+        // bounding box corner buffers for batch transforms
+        std::vector<cv::Point2i> m_voBBoxCornersXY;
+        std::vector<cv::Point2d> m_voBBoxCornersHV;
     };
 
     class VPTZ_API Evaluator {
@@ -240,6 +321,12 @@ namespace vptz {
         void EndTesting();
         /// redirects Get(...) calls to the camera
         double GetCurrCameraProperty(CameraPropertyFlag flag);
+        /// toggles the simulated clock mode (frames advance by a declared per-frame execution cost, without sleeping) for the current & next tests
+        void SetSimulatedClock(bool bEnabled, double dExecDelay=0.0);
+        /// sets the execution cost (virtual time, in seconds) charged when requesting the next frame in simulated clock mode
+        void SetSimulatedExecutionDelay(double dExecDelay);
+        /// toggles the CPU renderer (no OpenGL context required) for the cameras created by the next SetupTesting(...) calls
+        void SetCPURendering(bool bEnabled);
         /// returns the current test sequence name (for display purposes)
         std::string GetCurrTestSequenceName();
         /// returns the maximum number of frames that could be used in the current test sequence
@@ -262,6 +349,17 @@ namespace vptz {
         void UpdateCurrentResult(cv::Rect& rCurrTargetBBox, bool bPrintResult=false);
 
     private:
+        friend class BatchEvaluator;
+        struct TestMetadata {
+            std::string sTestName;
+            std::string sInputScenarioPath;
+            std::string sInputGTSequencePath;
+            std::string sInputTargetMaskPath;
+            int nFirstTestFrameIdx;
+            int nLastTestFrameIdx;
+        };
+        /// parses the test set file (paths are made relative to the dataset root folder); throws if it cannot be opened or has no test data
+        static std::vector<TestMetadata> ReadTestSet(const std::string& sInputTestSetPath);
         void Setup( const std::string& sInputScenarioPath,
                     const std::string& sInputGTSequencePath,
                     const std::string& sInputTargetMaskPath,
@@ -271,14 +369,6 @@ namespace vptz {
         std::unique_ptr<GTTranslator> m_pTranslator;
         std::unique_ptr<Camera> m_pCamera;
         cv::FileStorage m_oOutputEvalFS;
-        struct TestMetadata {
-            std::string sTestName;
-            std::string sInputScenarioPath;
-            std::string sInputGTSequencePath;
-            std::string sInputTargetMaskPath;
-            int nFirstTestFrameIdx;
-            int nLastTestFrameIdx;
-        };
         std::vector<TestMetadata> m_voTestSet;
         std::string m_sDatasetRootPath;
         const bool m_bUsingMultiTestSet;
@@ -287,6 +377,9 @@ namespace vptz {
 
         double m_dCommDelay;
         double m_dExecDelayRatio;
+        bool m_bSimulatedClock;
+        double m_dSimulatedExecDelay;
+        bool m_bUsingCPURenderer;
         int m_nScenarioFrameCount;
         int m_nTestFrameCount;
         int m_nFirstGTSeqFrameIdx;
@@ -326,6 +419,42 @@ namespace vptz {
         int m_nTotTestFrameCount;
     };
 
+    class VPTZ_API BatchEvaluator {
+    public:
+        /// per-test callback; receives a dedicated evaluator already set up for its test, and must run BeginTesting()...EndTesting() on it
+        typedef std::function<void(Evaluator& /*oEvaluator*/, int /*nTestIdx*/)> TestFunc;
+        /// testset-based constructor; throws if it cannot open the input file or its content is invalid (nWorkers=0 uses all hardware threads, and bUseCPURenderer avoids OpenGL entirely)
+        BatchEvaluator( const std::string& sInputTestSetPath,
+                        const std::string& sOutputEvalFilePath,
+                        double dCommDelay=0.5,
+                        double dExecDelayRatio=0.0,
+                        size_t nWorkers=0,
+                        bool bUseCPURenderer=false);
+
+        /// returns the test count in the test set
+        int GetTestSetSize() const;
+        /// returns the name of a given test (for display purposes)
+        std::string GetTestSequenceName(int nTestIdx) const;
+        /// runs all tests concurrently (each on its own thread, camera & context), then writes the merged evaluation file; can only be called once
+        /// note: the output is identical to a sequential Evaluator run as long as results do not depend on wall-clock delays (i.e. with an exec delay ratio of 0)
+        void Run(const TestFunc& lTestFunc);
+
+        const std::string m_sInputTestSetPath;
+        const std::string m_sOutputEvalFilePath;
+        const double m_dCommDelay;
+        const double m_dExecDelayRatio;
+        const size_t m_nWorkers;
+        const bool m_bUsingCPURenderer;
+
+    private:
+        /// returns the path of the temporary output file used by a given test
+        std::string GetTestOutputFilePath(int nTestIdx) const;
+        const std::vector<Evaluator::TestMetadata> m_voTestSet;
+        bool m_bDone;
+        BatchEvaluator(const BatchEvaluator&) = delete;
+        BatchEvaluator& operator=(const BatchEvaluator&) = delete;
+    };
+
     /// utility function: maps a 2D point on the virtual camera image to its horizontal and vertical angles in the sphere (throws if invalid args)
     void VPTZ_API PTZPointXYtoHV( int target2dX,                 // in: x coordinate of target point on the output image (pixel, [0, camOutputWidth-1])
                                   int target2dY,                 // in: y coordinate of target point on the output image (pixel, [0, camOutputHeight-1])
@@ -344,6 +473,14 @@ namespace vptz {
                                   double camVertiFOV = 90.0,
                                   double camHoriAngle = 0.0,
                                   double camVertiAngle = 90.0);
+    /// utility function: batch version of PTZPointXYtoHV for a shared camera pose (camera terms are computed once; results are identical to the scalar version)
+    void VPTZ_API PTZPointsXYtoHV( const std::vector<cv::Point2i>& vTargetXY,
+                                   std::vector<cv::Point2d>& vTargetHV,
+                                   int camOutputWidth = 640.0,
+                                   int camOutputHeight = 480.0,
+                                   double camVertiFOV = 90.0,
+                                   double camHoriAngle = 0.0,
+                                   double camVertiAngle = 90.0);
 
     /// utility function: maps a point from its horizontal and vertical angles to its 2D coordinate on the virtual camera image (throws if invalid args)
     /// note: returns false if the direct difference between the target direction and camera direction is larger than 90 degree
@@ -365,5 +502,14 @@ namespace vptz {
                                   double camVertiFOV = 90.0,
                                   double camHoriAngle = 0.0,
                                   double camVertiAngle = 90.0);
+    /// utility function: batch version of PTZPointHVtoXY for a shared camera pose (camera terms are computed once; results are identical to the scalar version)
+    /// note: returns the number of points within 90 degrees of the camera direction; the others are set to (INT_MAX,INT_MAX)
+    int VPTZ_API PTZPointsHVtoXY( const std::vector<cv::Point2d>& vTargetHV,
+                                  std::vector<cv::Point2i>& vTargetXY,
+                                  int camOutputWidth = 640.0,
+                                  int camOutputHeight = 480.0,
+                                  double camVertiFOV = 90.0,
+                                  double camHoriAngle = 0.0,
+                                  double camVertiAngle = 90.0);
 
 } // namespace vptz
@@ -1,6 +1,151 @@
 // (see header for licensing information)
 #include "litiv/vptz/virtualptz.hpp"
 
+#if (TARGET_GL_VER_MAJOR>3 || (TARGET_GL_VER_MAJOR==3 && TARGET_GL_VER_MINOR>=2))
+#define VPTZ_GLSL_VERSION_STR "#version 150\n"
+#else //(TARGET_GL_VER<3.2)
+#define VPTZ_GLSL_VERSION_STR "#version 130\n"
+#endif //(TARGET_GL_VER<3.2)
+
+namespace {
+
+    // full-screen triangle generated from vertex ids, with its NDC coords passed as the viewport ray origin
+    const char* s_acSphereVertexShaderSource =
+        VPTZ_GLSL_VERSION_STR
+        "out vec2 vNDC;\n"
+        "void main() {\n"
+        "    vNDC = vec2(float((gl_VertexID<<1)&2),float(gl_VertexID&2))*2.0-1.0;\n"
+        "    gl_Position = vec4(vNDC,0.0,1.0);\n"
+        "}\n";
+
+    // texture coords are computed exactly as gluSphere(...) generates them (s along the azimuth from +y towards -x, t from the -z pole)
+    const char* s_acSphereFragmentShaderSource =
+        VPTZ_GLSL_VERSION_STR
+        "#define PI 3.1415926535897932\n"
+        "uniform sampler2D sPanorama;\n"
+        "uniform mat3 mRayToSphere;\n"
+        "in vec2 vNDC;\n"
+        "out vec4 vFragColor;\n"
+        "void main() {\n"
+        "    vec3 vDir = normalize(mRayToSphere*vec3(vNDC,1.0));\n"
+        "    vec2 vTexCoord = vec2(atan(-vDir.x,vDir.y)*(0.5/PI),1.0-acos(clamp(vDir.z,-1.0,1.0))/PI);\n"
+        "    vFragColor = texture(sPanorama,vTexCoord);\n"
+        "}\n";
+
+    GLuint CompileShader(GLenum eType, const char* acSource) {
+        const GLuint nShaderID = glCreateShader(eType);
+        glShaderSource(nShaderID,1,&acSource,nullptr);
+        glCompileShader(nShaderID);
+        GLint nCompiled;
+        glGetShaderiv(nShaderID,GL_COMPILE_STATUS,&nCompiled);
+        if(nCompiled==GL_FALSE) {
+            GLint nLogSize;
+            glGetShaderiv(nShaderID,GL_INFO_LOG_LENGTH,&nLogSize);
+            std::vector<char> vcLog(std::max(nLogSize,1));
+            glGetShaderInfoLog(nShaderID,nLogSize,&nLogSize,vcLog.data());
+            glDeleteShader(nShaderID);
+            lvError_("failed to compile sphere shader:\n%s",vcLog.data());
+        }
+        return nShaderID;
+    }
+
+    GLuint CreateSphereProgram() {
+        const GLuint nVertexShaderID = CompileShader(GL_VERTEX_SHADER,s_acSphereVertexShaderSource);
+        const GLuint nFragmentShaderID = CompileShader(GL_FRAGMENT_SHADER,s_acSphereFragmentShaderSource);
+        const GLuint nProgID = glCreateProgram();
+        glAttachShader(nProgID,nVertexShaderID);
+        glAttachShader(nProgID,nFragmentShaderID);
+        glBindFragDataLocation(nProgID,0,"vFragColor");
+        glLinkProgram(nProgID);
+        glDeleteShader(nVertexShaderID);
+        glDeleteShader(nFragmentShaderID);
+        GLint nLinked;
+        glGetProgramiv(nProgID,GL_LINK_STATUS,&nLinked);
+        if(nLinked==GL_FALSE) {
+            GLint nLogSize;
+            glGetProgramiv(nProgID,GL_INFO_LOG_LENGTH,&nLogSize);
+            std::vector<char> vcLog(std::max(nLogSize,1));
+            glGetProgramInfoLog(nProgID,nLogSize,&nLogSize,vcLog.data());
+            glDeleteProgram(nProgID);
+            lvError_("failed to link sphere shader program:\n%s",vcLog.data());
+        }
+        return nProgID;
+    }
+
+    inline cv::Matx33d GetRotationMatrix_X(double dAngle) {
+        const double dCos = std::cos(D2R(dAngle)), dSin = std::sin(D2R(dAngle));
+        return cv::Matx33d(1.0,0.0,0.0, 0.0,dCos,-dSin, 0.0,dSin,dCos);
+    }
+
+    inline cv::Matx33d GetRotationMatrix_Z(double dAngle) {
+        const double dCos = std::cos(D2R(dAngle)), dSin = std::sin(D2R(dAngle));
+        return cv::Matx33d(dCos,-dSin,0.0, dSin,dCos,0.0, 0.0,0.0,1.0);
+    }
+
+    /// fills the viewport-to-panorama LUT rows in parallel, using the same ray & texture coords math as the sphere fragment shader
+    class ViewportMapBuilder : public cv::ParallelLoopBody {
+    public:
+        ViewportMapBuilder(const cv::Matx33d& oRayToSphere, const cv::Size& oPanoSize, cv::Mat& oMapX, cv::Mat& oMapY) :
+                m_oRayToSphere(oRayToSphere),m_oPanoSize(oPanoSize),m_oMapX(oMapX),m_oMapY(oMapY) {}
+        virtual void operator()(const cv::Range& oRowRange) const override {
+            const double dNDCScaleX = 2.0/m_oMapX.cols, dNDCScaleY = 2.0/m_oMapX.rows;
+            for(int nRowIdx=oRowRange.start; nRowIdx<oRowRange.end; ++nRowIdx) {
+                float* pfMapX = m_oMapX.ptr<float>(nRowIdx);
+                float* pfMapY = m_oMapY.ptr<float>(nRowIdx);
+                // rows are in readback order (the ray matrix already flips the viewport upside-down)
+                const double dNDCY = (nRowIdx+0.5)*dNDCScaleY-1.0;
+                for(int nColIdx=0; nColIdx<m_oMapX.cols; ++nColIdx) {
+                    const cv::Vec3d vDir = m_oRayToSphere*cv::Vec3d((nColIdx+0.5)*dNDCScaleX-1.0,dNDCY,1.0);
+                    double dTexCoordS = std::atan2(-vDir[0],vDir[1])*(0.5/CV_PI);
+                    if(dTexCoordS<0.0)
+                        dTexCoordS += 1.0;
+                    const double dTexCoordT = 1.0-std::acos(std::max(std::min(vDir[2]/cv::norm(vDir),1.0),-1.0))/CV_PI;
+                    // texel centers are at half-pixel offsets, as for GL_LINEAR sampling
+                    pfMapX[nColIdx] = float(dTexCoordS*m_oPanoSize.width-0.5);
+                    pfMapY[nColIdx] = float(dTexCoordT*m_oPanoSize.height-0.5);
+                }
+            }
+        }
+    private:
+        const cv::Matx33d m_oRayToSphere;
+        const cv::Size m_oPanoSize;
+        cv::Mat& m_oMapX;
+        cv::Mat& m_oMapY;
+    };
+
+    std::mutex& GetContextCreationMutex() {
+        static std::mutex s_oMutex;
+        return s_oMutex;
+    }
+
+    /// writes a copy of a file node's value (maps nested in sequences are written inline, as for evaluation results)
+    void CopyFileNodeValue(cv::FileStorage& oFS, const cv::FileNode& oNode, bool bInSeq) {
+        if(oNode.isMap()) {
+            oFS << (bInSeq?"{:":"{");
+            for(auto oIter=oNode.begin(); oIter!=oNode.end(); ++oIter) {
+                oFS << (*oIter).name();
+                CopyFileNodeValue(oFS,*oIter,false);
+            }
+            oFS << "}";
+        }
+        else if(oNode.isSeq()) {
+            oFS << "[";
+            for(auto oIter=oNode.begin(); oIter!=oNode.end(); ++oIter)
+                CopyFileNodeValue(oFS,*oIter,true);
+            oFS << "]";
+        }
+        else if(oNode.isInt())
+            oFS << (int)oNode;
+        else if(oNode.isReal())
+            oFS << (double)oNode;
+        else if(oNode.isString())
+            oFS << (std::string)oNode;
+        else
+            lvError("unsupported file node type in evaluation file");
+    }
+
+} // anonymous namespace
+
 inline std::string GetRootFolderPath(const std::string& sPath) {
     const size_t nLastFrwdSlashPos = sPath.find_last_of('/');
     const size_t nLastBackSlashPos = sPath.find_last_of('\\');
@@ -12,8 +157,25 @@ inline std::string GetRootFolderPath(const std::string& sPath) {
 
 vptz::Camera::Camera( const std::string& sInputPath, double verti_FOV, double output_width,
                       double output_height, double hori_angle, double verti_angle,
-                      double hori_speed, double verti_speed, double communication_delay) :
-        m_sInputPath(sInputPath) {
+                      double hori_speed, double verti_speed, double communication_delay, bool use_cpu_renderer) :
+        m_sInputPath(sInputPath),
+        m_nTexID(0),
+        m_nCurrPanoPBOIdx(0),
+        m_nUploadedFrameIdx(-1),
+        m_nDecoderCaptureIdx(0),
+        m_nViewportFBOID(0),
+        m_nViewportTexID(0),
+        m_nCurrViewportPBOIdx(0),
+        m_nRenderedFrameIdx(-1),
+        m_dRenderedHoriAngle(0.0),
+        m_dRenderedVertiAngle(0.0),
+        m_dRenderedVertiFOV(0.0),
+        m_bViewportReadbackPending(false),
+        m_bViewportFrameReady(false),
+        m_bUsingCPURenderer(use_cpu_renderer),
+        m_dViewportMapHoriAngle(0.0),
+        m_dViewportMapVertiAngle(0.0),
+        m_dViewportMapVertiFOV(0.0) {
     lvDbgExceptionWatch;
     panoImage = cv::imread(m_sInputPath);
     isVideo = panoImage.empty();
@@ -65,7 +227,6 @@ vptz::Camera::Camera( const std::string& sInputPath, double verti_FOV, double ou
     }
     if(panoImage.empty() || panoImage.type()!=CV_8UC3)
         lvError("Fetched image (or image sequence) had wrong type");
-    cv::cvtColor(panoImage,panoImage,cv::COLOR_BGR2BGRA);
 
     // initialize the parameters
     Set(PTZ_CAM_VERTI_FOV, verti_FOV);
@@ -77,6 +238,8 @@ vptz::Camera::Camera( const std::string& sInputPath, double verti_FOV, double ou
     Set(PTZ_CAM_VERTI_SPEED, verti_speed);
     Set(PTZ_CAM_COMMUNICATION_DELAY, communication_delay);
     executionDelayRatio = 1.0;
+    simulatedClock = false;
+    simulatedExecutionDelay = 0.0;
     firstTick = 0.0;
     horiAngleChange = 0.0;
     vertiAngleChange = 0.0;
@@ -87,20 +250,97 @@ vptz::Camera::Camera( const std::string& sInputPath, double verti_FOV, double ou
     executionDelay = 0.0;
     motionDelay = 0.0;
 
-    // constants
-    sphereGridSize = 512;
+    m_oViewportFrame = cv::Mat(int(outputHeight), int(outputWidth), CV_8UC4);
+#if VPTZ_USE_ASYNC_DECODING
+    m_nDecoderReqFrameIdx = -1;
+    m_nDecodedFrameIdx = -1;
+    m_bDecodedFrameValid = false;
+    m_bDecoderStop = false;
+#endif //VPTZ_USE_ASYNC_DECODING
+    if(m_bUsingCPURenderer)
+        m_nUploadedFrameIdx = m_nCurrFrameIdx; // the panorama is sampled directly from panoImage
+    else {
+        {
+            // window toolkits & GLEW init are not thread-safe, but cameras may be created by concurrent evaluators
+            std::lock_guard<std::mutex> oLock(GetContextCreationMutex());
+            m_pContext = std::unique_ptr<lv::gl::Context>(new lv::gl::Context(cv::Size((int)outputWidth,(int)outputHeight),"VPTZ Mapper"));
+        }
 
-    m_pContext = std::unique_ptr<lv::gl::Context>(new lv::gl::Context(cv::Size((int)outputWidth,(int)outputHeight),"VPTZ Mapper"));
+        m_nSphereProgID = CreateSphereProgram();
+        m_nRayMatrixUniformLoc = glGetUniformLocation(m_nSphereProgID,"mRayToSphere");
+        lvAssert_(m_nRayMatrixUniformLoc!=-1,"could not find sphere shader ray matrix uniform");
+        glUseProgram(m_nSphereProgID);
+        glUniform1i(glGetUniformLocation(m_nSphereProgID,"sPanorama"),0);
+        glUseProgram(0);
+        glGenVertexArrays(1, &m_nSphereVAOID);
+        glErrorCheck;
+        glGenBuffers(VPTZ_PANO_PBO_COUNT,m_anPanoPBOIDs.data());
+        AllocatePanoTexture(panoImage.size());
+        UploadPanoImage(panoImage);
+        m_nUploadedFrameIdx = m_nCurrFrameIdx;
+        glGenTextures(1, &m_nViewportTexID);
+        glBindTexture(GL_TEXTURE_2D, m_nViewportTexID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        if(GLEW_ARB_texture_storage)
+            glTexStorage2D(GL_TEXTURE_2D,1,GL_RGBA8,m_oViewportFrame.cols,m_oViewportFrame.rows);
+        else
+            glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA8,m_oViewportFrame.cols,m_oViewportFrame.rows,0,GL_BGRA,GL_UNSIGNED_BYTE,nullptr);
+        glGenFramebuffers(1, &m_nViewportFBOID);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_nViewportFBOID);
+        glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,m_nViewportTexID,0);
+        lvAssert_(glCheckFramebufferStatus(GL_FRAMEBUFFER)==GL_FRAMEBUFFER_COMPLETE,"viewport framebuffer is incomplete");
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glGenBuffers(VPTZ_VIEWPORT_PBO_COUNT,m_anViewportPBOIDs.data());
+        for(GLuint nPBOID : m_anViewportPBOIDs) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER,nPBOID);
+            glBufferData(GL_PIXEL_PACK_BUFFER,(GLsizeiptr)(m_oViewportFrame.total()*m_oViewportFrame.elemSize()),nullptr,GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+        m_apViewportFences.fill(nullptr);
+        glErrorCheck;
+    }
+#if VPTZ_USE_ASYNC_DECODING
+    if(isVideo)
+        m_oDecoderThread = std::thread(&Camera::DecoderThread,this);
+#endif //VPTZ_USE_ASYNC_DECODING
+}
 
-    // set the projection transformation
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluPerspective(vertiFOV, outputWidth/outputHeight, 0.01, 10.0);
-    glErrorCheck;
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-    glEnable(GL_TEXTURE_2D);
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+vptz::Camera::~Camera() {
+    lvDbgExceptionWatch;
+#if VPTZ_USE_ASYNC_DECODING
+    if(m_oDecoderThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> oLock(m_oDecoderMutex);
+            m_bDecoderStop = true;
+        }
+        m_oDecoderReqCondVar.notify_one();
+        m_oDecoderThread.join();
+    }
+#endif //VPTZ_USE_ASYNC_DECODING
+    if(m_bUsingCPURenderer)
+        return;
+    glDeleteVertexArrays(1, &m_nSphereVAOID);
+    glDeleteProgram(m_nSphereProgID);
+    for(GLsync pFence : m_apViewportFences)
+        if(pFence)
+            glDeleteSync(pFence);
+    glDeleteBuffers(VPTZ_VIEWPORT_PBO_COUNT,m_anViewportPBOIDs.data());
+    glDeleteFramebuffers(1, &m_nViewportFBOID);
+    glDeleteTextures(1, &m_nViewportTexID);
+    glDeleteBuffers(VPTZ_PANO_PBO_COUNT,m_anPanoPBOIDs.data());
+    glDeleteTextures(1, &m_nTexID);
+}
+
+void vptz::Camera::AllocatePanoTexture(const cv::Size& oSize) {
+    lvDbgExceptionWatch;
+    lvAssert(oSize.area()>0);
+    if(m_nTexID)
+        glDeleteTextures(1, &m_nTexID);
     glGenTextures(1, &m_nTexID);
     glBindTexture(GL_TEXTURE_2D, m_nTexID);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
@@ -109,22 +349,105 @@ vptz::Camera::Camera( const std::string& sInputPath, double verti_FOV, double ou
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA8,panoImage.cols,panoImage.rows,0,GL_BGRA,GL_UNSIGNED_INT_8_8_8_8_REV,panoImage.data);
+    if(GLEW_ARB_texture_storage)
+        glTexStorage2D(GL_TEXTURE_2D,1,GL_RGBA8,oSize.width,oSize.height);
+    else
+        glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA8,oSize.width,oSize.height,0,GL_BGRA,GL_UNSIGNED_BYTE,nullptr);
     glErrorCheck;
-    m_pSphereObj = gluNewQuadric();
-    gluQuadricDrawStyle(m_pSphereObj, GLU_FILL);           // use polygon primitives
-    gluQuadricOrientation(m_pSphereObj, GLU_OUTSIDE);      // draw the normals pointing outward
-    gluQuadricTexture(m_pSphereObj, GL_TRUE);              // generate texture coordinates
-    m_oViewportFrame = cv::Mat(int(outputHeight), int(outputWidth), CV_8UC4);
+    m_oPanoTexSize = oSize;
+}
+
+void vptz::Camera::UploadPanoImage(const cv::Mat& oImage) {
+    lvDbgExceptionWatch;
+    lvDbgAssert(oImage.isContinuous() && (oImage.type()==CV_8UC3 || oImage.type()==CV_8UC4));
+    if(oImage.size()!=m_oPanoTexSize)
+        AllocatePanoTexture(oImage.size());
+    const size_t nByteSize = oImage.total()*oImage.elemSize();
+    m_nCurrPanoPBOIdx = (m_nCurrPanoPBOIdx+1)%VPTZ_PANO_PBO_COUNT;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER,m_anPanoPBOIDs[m_nCurrPanoPBOIdx]);
+    // orphaning the buffer lets the driver keep transferring the previous frame while this one is being filled
+    glBufferData(GL_PIXEL_UNPACK_BUFFER,(GLsizeiptr)nByteSize,nullptr,GL_STREAM_DRAW);
+    const GLvoid* pTexData = nullptr;
+    void* pBufferClientPtr = glMapBuffer(GL_PIXEL_UNPACK_BUFFER,GL_WRITE_ONLY);
+    if(pBufferClientPtr) {
+        memcpy(pBufferClientPtr,oImage.data,nByteSize);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    else {
+        // fallback to a regular (synchronous) client memory upload
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER,0);
+        pTexData = oImage.data;
+    }
+    glBindTexture(GL_TEXTURE_2D, m_nTexID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT,1);
+    glTexSubImage2D(GL_TEXTURE_2D,0,0,0,oImage.cols,oImage.rows,oImage.channels()==3?GL_BGR:GL_BGRA,GL_UNSIGNED_BYTE,pTexData);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER,0);
     glErrorCheck;
 }
 
-vptz::Camera::~Camera() {
+bool vptz::Camera::DecodeFrame(int nFrameIdx, cv::Mat& oFrame) {
     lvDbgExceptionWatch;
-    gluDeleteQuadric(m_pSphereObj);
-    glDeleteTextures(1, &m_nTexID);
+    lvDbgAssert(isVideo);
+    if(nFrameIdx<m_nDecoderCaptureIdx || nFrameIdx-m_nDecoderCaptureIdx>VPTZ_MAX_SEQUENTIAL_SKIP) {
+        m_nDecoderCaptureIdx = INT_MAX;
+        if(!panoCapture.set(cv::CAP_PROP_POS_FRAMES,nFrameIdx))
+            return false;
+        m_nDecoderCaptureIdx = nFrameIdx;
+    }
+    for(; m_nDecoderCaptureIdx<nFrameIdx; ++m_nDecoderCaptureIdx) {
+        if(!panoCapture.grab()) {
+            m_nDecoderCaptureIdx = INT_MAX;
+            return false;
+        }
+    }
+    if(!panoCapture.read(oFrame) || oFrame.empty()) {
+        m_nDecoderCaptureIdx = INT_MAX;
+        return false;
+    }
+    ++m_nDecoderCaptureIdx;
+    return true;
 }
 
+void vptz::Camera::RequestFrame(int nFrameIdx) {
+#if VPTZ_USE_ASYNC_DECODING
+    if(!isVideo || nFrameIdx<0 || nFrameIdx>=m_nScenarioFrameCount)
+        return;
+    {
+        std::lock_guard<std::mutex> oLock(m_oDecoderMutex);
+        m_nDecoderReqFrameIdx = nFrameIdx;
+    }
+    m_oDecoderReqCondVar.notify_one();
+#else //(!VPTZ_USE_ASYNC_DECODING)
+    lvIgnore(nFrameIdx);
+#endif //(!VPTZ_USE_ASYNC_DECODING)
+}
+
+#if VPTZ_USE_ASYNC_DECODING
+void vptz::Camera::DecoderThread() {
+    std::unique_lock<std::mutex> oLock(m_oDecoderMutex);
+    while(true) {
+        m_oDecoderReqCondVar.wait(oLock,[&]{return m_bDecoderStop || (m_nDecoderReqFrameIdx>=0 && m_nDecoderReqFrameIdx!=m_nDecodedFrameIdx);});
+        if(m_bDecoderStop)
+            break;
+        const int nFrameIdx = m_nDecoderReqFrameIdx;
+        oLock.unlock();
+        bool bValid;
+        try {
+            bValid = DecodeFrame(nFrameIdx,m_oDecoderBuffer);
+        }
+        catch(...) {
+            bValid = false;
+        }
+        oLock.lock();
+        // frames are always published, even if a newer request came in meanwhile (the loop will pick it up)
+        cv::swap(m_oDecodedFrame,m_oDecoderBuffer);
+        m_nDecodedFrameIdx = nFrameIdx;
+        m_bDecodedFrameValid = bValid;
+        m_oDecoderDoneCondVar.notify_all();
+    }
+}
+#endif //VPTZ_USE_ASYNC_DECODING
+
 void vptz::Camera::GoToPosition(int x, int y) {
     lvDbgExceptionWatch;
     double tempHoriAngle = horiAngle;
@@ -154,16 +477,28 @@ bool vptz::Camera::WaitDelay(bool bSleep) {
     lvDbgExceptionWatch;
     if(m_nCurrFrameIdx>=m_nScenarioFrameCount)
         return false;
-    // The end of other parts (tracker's analysing, get frame)
-    executionEndTime = (double(cv::getTickCount())-firstTick)/cv::getTickFrequency();
-    // two of the three kinds of delay
-    executionDelay = (executionEndTime-executionBeginTime)-getFrameOverhead;
+    if(simulatedClock)
+        executionDelay = simulatedExecutionDelay; // virtual time only, so results do not depend on machine load
+    else {
+        // The end of other parts (tracker's analysing, get frame)
+        executionEndTime = (double(cv::getTickCount())-firstTick)/cv::getTickFrequency();
+        // two of the three kinds of delay
+        executionDelay = (executionEndTime-executionBeginTime)-getFrameOverhead;
+    }
     motionDelay = abs(horiAngleChange)/horiSpeed+abs(vertiAngleChange)/vertiSpeed;
     // calculate frame position
     currentTime += executionDelayRatio*executionDelay + motionDelay + communicationDelay;
     m_nCurrFrameIdx = std::max(int(currentTime*m_dFrameRate+0.5),m_nCurrFrameIdx+1);
+    RequestFrame(m_nCurrFrameIdx); // decoding overlaps with the sleep below & with the caller's own processing
+    if(simulatedClock)
+        return m_nCurrFrameIdx<m_nScenarioFrameCount;
     if(bSleep) {
-        double waitingTime = motionDelay + communicationDelay - getFrameOverhead;
+        // the next frame is rendered & read back while the camera is 'moving'; only the remaining time is slept
+        const double dPrepareBeginTick = double(cv::getTickCount());
+        if(m_nCurrFrameIdx<m_nScenarioFrameCount)
+            PrepareFrame();
+        const double dPrepareTime = (double(cv::getTickCount())-dPrepareBeginTick)/cv::getTickFrequency();
+        double waitingTime = motionDelay + communicationDelay - getFrameOverhead - dPrepareTime;
         if(waitingTime<0.001) waitingTime = 0.001;
         cv::waitKey(int(waitingTime*1000));
     }
@@ -172,35 +507,157 @@ bool vptz::Camera::WaitDelay(bool bSleep) {
     return m_nCurrFrameIdx<m_nScenarioFrameCount;
 }
 
+bool vptz::Camera::UpdateViewport() {
+    lvDbgExceptionWatch;
+    if(m_nUploadedFrameIdx!=m_nCurrFrameIdx) {
+        if(isVideo) {
+#if VPTZ_USE_ASYNC_DECODING
+            RequestFrame(m_nCurrFrameIdx);
+            std::unique_lock<std::mutex> oLock(m_oDecoderMutex);
+            if(m_nCurrFrameIdx<m_nScenarioFrameCount)
+                m_oDecoderDoneCondVar.wait(oLock,[&]{return m_nDecodedFrameIdx==m_nCurrFrameIdx;});
+            if(m_nDecodedFrameIdx!=m_nCurrFrameIdx || !m_bDecodedFrameValid)
+                return false;
+            cv::swap(panoImage,m_oDecodedFrame);
+            oLock.unlock();
+#else //(!VPTZ_USE_ASYNC_DECODING)
+            if(!DecodeFrame(m_nCurrFrameIdx,panoImage))
+                return false;
+#endif //(!VPTZ_USE_ASYNC_DECODING)
+        }
+        if(!m_bUsingCPURenderer)
+            UploadPanoImage(panoImage);
+        m_nUploadedFrameIdx = m_nCurrFrameIdx;
+        m_nRenderedFrameIdx = -1; // the viewport must be re-rendered from the new panorama (e.g. after UpdatePanoImage)
+    }
+    if(m_nRenderedFrameIdx==m_nCurrFrameIdx && m_dRenderedHoriAngle==horiAngle && m_dRenderedVertiAngle==vertiAngle && m_dRenderedVertiFOV==vertiFOV)
+        return true;
+    // sphere-to-eye rotation (the z-axis rotation makes the center of the panoramic frame match the default camera direction (0, 90))
+    const cv::Matx33d oSphereToEye = GetRotationMatrix_X(vertiAngle-180)*GetRotationMatrix_Z(90-horiAngle)*cv::Matx33d::diag(cv::Vec3d(1.0,-1.0,-1.0))*GetRotationMatrix_Z(90.0);
+    // NDC-to-eye ray scaling, with y flipped so that the viewport is rendered upside-down (readbacks are then directly in top-row-first order)
+    const double dHalfFOVTan = std::tan(D2R(vertiFOV)/2);
+    const double dAspectRatio = double(m_oViewportFrame.cols)/m_oViewportFrame.rows;
+    const cv::Matx33d oRayToSphere = oSphereToEye.t()*cv::Matx33d::diag(cv::Vec3d(dHalfFOVTan*dAspectRatio,-dHalfFOVTan,-1.0));
+    if(m_bUsingCPURenderer)
+        RenderViewportCPU(oRayToSphere);
+    else {
+        const cv::Matx33f oRayToSphere_f(oRayToSphere);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_nViewportFBOID);
+        glViewport(0,0,m_oViewportFrame.cols,m_oViewportFrame.rows);
+        glUseProgram(m_nSphereProgID);
+        glUniformMatrix3fv(m_nRayMatrixUniformLoc,1,GL_TRUE,oRayToSphere_f.val);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_nTexID);
+        glBindVertexArray(m_nSphereVAOID);
+        glDrawArrays(GL_TRIANGLES,0,3);
+        glBindVertexArray(0);
+        glUseProgram(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glErrorCheck;
+    }
+    m_nRenderedFrameIdx = m_nCurrFrameIdx;
+    m_dRenderedHoriAngle = horiAngle;
+    m_dRenderedVertiAngle = vertiAngle;
+    m_dRenderedVertiFOV = vertiFOV;
+    m_bViewportReadbackPending = false;
+    m_bViewportFrameReady = m_bUsingCPURenderer; // cpu renders need no readback
+    return true;
+}
+
+void vptz::Camera::RenderViewportCPU(const cv::Matx33d& oRayToSphere) {
+    lvDbgExceptionWatch;
+    lvDbgAssert(m_bUsingCPURenderer && !panoImage.empty() && (panoImage.type()==CV_8UC3 || panoImage.type()==CV_8UC4));
+    if(m_oViewportMapPanoSize!=panoImage.size() || m_dViewportMapHoriAngle!=horiAngle || m_dViewportMapVertiAngle!=vertiAngle || m_dViewportMapVertiFOV!=vertiFOV) {
+        m_oViewportMapX.create(m_oViewportFrame.size(),CV_32FC1);
+        m_oViewportMapY.create(m_oViewportFrame.size(),CV_32FC1);
+        cv::parallel_for_(cv::Range(0,m_oViewportFrame.rows),ViewportMapBuilder(oRayToSphere,panoImage.size(),m_oViewportMapX,m_oViewportMapY));
+        cv::convertMaps(m_oViewportMapX,m_oViewportMapY,m_oViewportMap1,m_oViewportMap2,CV_16SC2);
+        m_oViewportMapPanoSize = panoImage.size();
+        m_dViewportMapHoriAngle = horiAngle;
+        m_dViewportMapVertiAngle = vertiAngle;
+        m_dViewportMapVertiFOV = vertiFOV;
+    }
+    // wrapping on both axes mimics the GL_REPEAT panorama texture sampling (the remap itself is parallelized internally)
+    if(panoImage.channels()==4)
+        cv::remap(panoImage,m_oViewportFrame,m_oViewportMap1,m_oViewportMap2,cv::INTER_LINEAR,cv::BORDER_WRAP);
+    else {
+        cv::remap(panoImage,m_oViewportFrameBGR,m_oViewportMap1,m_oViewportMap2,cv::INTER_LINEAR,cv::BORDER_WRAP);
+        cv::cvtColor(m_oViewportFrameBGR,m_oViewportFrame,cv::COLOR_BGR2BGRA);
+    }
+}
+
+void vptz::Camera::FetchViewport() {
+    lvDbgExceptionWatch;
+    lvDbgAssert(m_bViewportReadbackPending);
+    GLsync& pFence = m_apViewportFences[m_nCurrViewportPBOIdx];
+    if(pFence) {
+        GLenum eWaitRes;
+        while((eWaitRes=glClientWaitSync(pFence,GL_SYNC_FLUSH_COMMANDS_BIT,GLuint64(1000000000)))==GL_TIMEOUT_EXPIRED);
+        lvAssert_(eWaitRes!=GL_WAIT_FAILED,"failed to wait on viewport readback fence");
+        glDeleteSync(pFence);
+        pFence = nullptr;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER,m_anViewportPBOIDs[m_nCurrViewportPBOIdx]);
+    const void* pBufferClientPtr = glMapBuffer(GL_PIXEL_PACK_BUFFER,GL_READ_ONLY);
+    lvAssert_(pBufferClientPtr,"could not map viewport readback buffer");
+    memcpy(m_oViewportFrame.data,pBufferClientPtr,m_oViewportFrame.total()*m_oViewportFrame.elemSize());
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+    glErrorCheck;
+    m_bViewportReadbackPending = false;
+    m_bViewportFrameReady = true;
+}
+
+void vptz::Camera::PrepareFrame() {
+    lvDbgExceptionWatch;
+    if(m_pContext)
+        m_pContext->setAsActive();
+    if(!UpdateViewport() || m_bViewportReadbackPending || m_bViewportFrameReady)
+        return;
+    m_nCurrViewportPBOIdx = (m_nCurrViewportPBOIdx+1)%VPTZ_VIEWPORT_PBO_COUNT;
+    GLsync& pFence = m_apViewportFences[m_nCurrViewportPBOIdx];
+    if(pFence) {
+        // previous readback in this slot was abandoned (its viewport got re-rendered before being fetched)
+        glDeleteSync(pFence);
+        pFence = nullptr;
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_nViewportFBOID);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER,m_anViewportPBOIDs[m_nCurrViewportPBOIdx]);
+    glReadPixels(0,0,m_oViewportFrame.cols,m_oViewportFrame.rows,GL_BGRA,GL_UNSIGNED_INT_8_8_8_8_REV,nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    if(GLEW_ARB_sync)
+        pFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+    glFlush(); // starts the transfer right away, the caller can keep working until GetFrame()
+    glErrorCheck;
+    m_bViewportReadbackPending = true;
+}
+
 const cv::Mat& vptz::Camera::GetFrame() {
     lvDbgExceptionWatch;
-    m_pContext->setAsActive();
     double duration = double(cv::getTickCount());
-    if(isVideo) {
-        if(!panoCapture.set(cv::CAP_PROP_POS_FRAMES,m_nCurrFrameIdx) || !panoCapture.read(panoImage))
-            return panoImage;
-    }
-    if(panoImage.channels()==3)
-        cv::cvtColor(panoImage,panoImage,cv::COLOR_BGR2BGRA);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-    glRotatef(GLfloat(vertiAngle-180), 1, 0, 0);
-    glRotatef(GLfloat(90-horiAngle), 0, 0, 1);
-    glScalef(1.0, -1.0, -1.0);
-    glRotatef(90.0, 0, 0, 1); // z axis, to make the center of the panoramic frame match the default camera direction (0, 90)
-    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA8,panoImage.cols,panoImage.rows,0,GL_BGRA,GL_UNSIGNED_INT_8_8_8_8_REV,panoImage.data);
-    gluSphere(m_pSphereObj, 5.0, sphereGridSize, sphereGridSize);    // generate the sphe
-    glReadPixels(0,0,m_oViewportFrame.cols,m_oViewportFrame.rows,GL_BGRA,GL_UNSIGNED_INT_8_8_8_8_REV,m_oViewportFrame.data);
-    cv::flip(m_oViewportFrame,m_oViewportFrame, 0);
+    PrepareFrame();
+    if(!m_bViewportReadbackPending && !m_bViewportFrameReady)
+        return panoImage; // current frame could not be decoded
+    if(m_bViewportReadbackPending)
+        FetchViewport();
     getFrameOverhead = (double(cv::getTickCount())-duration)/cv::getTickFrequency();
-    glErrorCheck;
     return m_oViewportFrame;
 }
 
+GLuint vptz::Camera::GetFrameTexture() {
+    lvDbgExceptionWatch;
+    lvAssert_(!m_bUsingCPURenderer,"frame textures are unavailable with the CPU renderer");
+    m_pContext->setAsActive();
+    return UpdateViewport()?m_nViewportTexID:0;
+}
+
 void vptz::Camera::UpdatePanoImage(cv::Mat& image) {
     lvDbgExceptionWatch;
     lvAssert(!isVideo);
+    lvAssert(image.type()==CV_8UC3 || image.type()==CV_8UC4);
     image.copyTo(panoImage);
+    m_nUploadedFrameIdx = -1;
 }
 
 double vptz::Camera::Get(CameraPropertyFlag flag) {
@@ -222,6 +679,8 @@ double vptz::Camera::Get(CameraPropertyFlag flag) {
         case PTZ_CAM_VERTI_SPEED : return vertiSpeed;
         case PTZ_CAM_EXECUTION_DELAY_RATIO : return executionDelayRatio;
         case PTZ_CAM_COMMUNICATION_DELAY : return communicationDelay;
+        case PTZ_CAM_SIMULATED_CLOCK : return simulatedClock;
+        case PTZ_CAM_SIMULATED_EXECUTION_DELAY : return simulatedExecutionDelay;
         default : lvError("invalid flag");
     }
 }
@@ -236,6 +695,7 @@ void vptz::Camera::Set(CameraPropertyFlag flag, double value) {
             if(value>m_nScenarioFrameCount-1||value<0)
                 lvError("invalid framePos value");
             m_nCurrFrameIdx = (int)value;
+            RequestFrame(m_nCurrFrameIdx);
             break;
         case PTZ_CAM_VERTI_FOV:
             if(value>=180.0 || value<=0.0)
@@ -291,6 +751,14 @@ void vptz::Camera::Set(CameraPropertyFlag flag, double value) {
                 lvError("invalid communicationDelay value");
             communicationDelay = value;
             break;
+        case PTZ_CAM_SIMULATED_CLOCK:
+            simulatedClock = (value!=0.0);
+            break;
+        case PTZ_CAM_SIMULATED_EXECUTION_DELAY:
+            if(value<0)
+                lvError("invalid simulatedExecutionDelay value");
+            simulatedExecutionDelay = value;
+            break;
         default:
             lvError("invalid flag");
     }
@@ -367,19 +835,21 @@ bool vptz::GTTranslator::GetGTBoundingBox(double bgtHoriAngle, double bgtVertiAn
     cv::Point l_b_XY((bgtOutputWidth-bgtBBoxWidth)/2, (bgtOutputHeight+bgtBBoxHeight)/2);
     cv::Point r_t_XY((bgtOutputWidth+bgtBBoxWidth)/2, (bgtOutputHeight-bgtBBoxHeight)/2);
     cv::Point r_b_XY((bgtOutputWidth+bgtBBoxWidth)/2, (bgtOutputHeight+bgtBBoxHeight)/2);
+    m_voBBoxCornersXY.resize(4);
+    m_voBBoxCornersXY[0] = l_t_XY;
+    m_voBBoxCornersXY[1] = l_b_XY;
+    m_voBBoxCornersXY[2] = r_t_XY;
+    m_voBBoxCornersXY[3] = r_b_XY;
     // the four vertexes of bounding box on spherical surface
-    cv::Point2d l_t_HV, l_b_HV, r_t_HV, r_b_HV;
-    PTZPointXYtoHV(l_t_XY, l_t_HV, bgtOutputWidth, bgtOutputHeight, bgtVertiFOV, bgtHoriAngle, bgtVertiAngle);
-    PTZPointXYtoHV(l_b_XY, l_b_HV, bgtOutputWidth, bgtOutputHeight, bgtVertiFOV, bgtHoriAngle, bgtVertiAngle);
-    PTZPointXYtoHV(r_t_XY, r_t_HV, bgtOutputWidth, bgtOutputHeight, bgtVertiFOV, bgtHoriAngle, bgtVertiAngle);
-    PTZPointXYtoHV(r_b_XY, r_b_HV, bgtOutputWidth, bgtOutputHeight, bgtVertiFOV, bgtHoriAngle, bgtVertiAngle);
+    PTZPointsXYtoHV(m_voBBoxCornersXY, m_voBBoxCornersHV, bgtOutputWidth, bgtOutputHeight, bgtVertiFOV, bgtHoriAngle, bgtVertiAngle);
     // 2. Current Simulator Domain
     // the four vertexes of bounding box on image plane
-    if( !PTZPointHVtoXY(l_t_HV, l_t_XY, curOutputWidth, curOutputHeight, curVertiFOV, curHoriAngle, curVertiAngle) ||
-        !PTZPointHVtoXY(l_b_HV, l_b_XY, curOutputWidth, curOutputHeight, curVertiFOV, curHoriAngle, curVertiAngle) ||
-        !PTZPointHVtoXY(r_t_HV, r_t_XY, curOutputWidth, curOutputHeight, curVertiFOV, curHoriAngle, curVertiAngle) ||
-        !PTZPointHVtoXY(r_b_HV, r_b_XY, curOutputWidth, curOutputHeight, curVertiFOV, curHoriAngle, curVertiAngle))
+    if(PTZPointsHVtoXY(m_voBBoxCornersHV, m_voBBoxCornersXY, curOutputWidth, curOutputHeight, curVertiFOV, curHoriAngle, curVertiAngle)<4)
         return false;
+    l_t_XY = m_voBBoxCornersXY[0];
+    l_b_XY = m_voBBoxCornersXY[1];
+    r_t_XY = m_voBBoxCornersXY[2];
+    r_b_XY = m_voBBoxCornersXY[3];
     // rectify
     cv::Point rectLeftTop((l_t_XY.x+l_b_XY.x)/2, (l_t_XY.y+r_t_XY.y)/2);
     cv::Point rectRightBottom((r_b_XY.x+r_t_XY.x)/2, (r_b_XY.y+l_b_XY.y)/2);
@@ -401,6 +871,9 @@ vptz::Evaluator::Evaluator( const std::string& sInputScenarioPath, const std::st
     m_voTestSet.push_back(oDefaultTest);
     m_dCommDelay = dCommDelay;
     m_dExecDelayRatio = dExecDelayRatio;
+    m_bSimulatedClock = false;
+    m_dSimulatedExecDelay = 0.0;
+    m_bUsingCPURenderer = false;
     m_nCurrTestIdx = -1;
     m_oOutputEvalFS.open(sOutputEvalFilePath, cv::FileStorage::WRITE);
     if(!m_oOutputEvalFS.isOpened())
@@ -420,24 +893,13 @@ vptz::Evaluator::Evaluator( const std::string& sInputTestSetPath, const std::str
                             double dCommDelay, double dExecDelayRatio) :
         m_bUsingMultiTestSet(true) {
     lvDbgExceptionWatch;
-    cv::FileStorage oTestSet_FS(sInputTestSetPath,cv::FileStorage::READ);
-    if(!oTestSet_FS.isOpened())
-        lvError("cannot open the input test set file storage");
-    cv::FileNode voTestSet_FN = oTestSet_FS["test_set"];
-    if(voTestSet_FN.empty())
-        lvError("test set file contains no test data");
+    m_voTestSet = ReadTestSet(sInputTestSetPath);
     m_sDatasetRootPath = GetRootFolderPath(sInputTestSetPath)+"../";
-    for(auto oTestIter=voTestSet_FN.begin(); oTestIter!=voTestSet_FN.end(); ++oTestIter) {
-        TestMetadata oNewTest = { (*oTestIter)["test_name"],
-                                  m_sDatasetRootPath+(std::string)((*oTestIter)["input_scenario_path"]),
-                                  m_sDatasetRootPath+(std::string)((*oTestIter)["input_gtseq_path"]),
-                                  m_sDatasetRootPath+(std::string)((*oTestIter)["input_target_mask_path"]),
-                                  (*oTestIter)["init_frame_idx"],
-                                  (*oTestIter)["last_frame_idx"]};
-        m_voTestSet.push_back(oNewTest);
-    }
     m_dCommDelay = dCommDelay;
     m_dExecDelayRatio = dExecDelayRatio;
+    m_bSimulatedClock = false;
+    m_dSimulatedExecDelay = 0.0;
+    m_bUsingCPURenderer = false;
     m_nCurrTestIdx = -1;
     m_oOutputEvalFS.open(sOutputEvalFilePath, cv::FileStorage::WRITE);
     if(!m_oOutputEvalFS.isOpened())
@@ -473,6 +935,28 @@ vptz::Evaluator::~Evaluator() {
     }
 }
 
+std::vector<vptz::Evaluator::TestMetadata> vptz::Evaluator::ReadTestSet(const std::string& sInputTestSetPath) {
+    lvDbgExceptionWatch;
+    cv::FileStorage oTestSet_FS(sInputTestSetPath,cv::FileStorage::READ);
+    if(!oTestSet_FS.isOpened())
+        lvError("cannot open the input test set file storage");
+    cv::FileNode voTestSet_FN = oTestSet_FS["test_set"];
+    if(voTestSet_FN.empty())
+        lvError("test set file contains no test data");
+    const std::string sDatasetRootPath = GetRootFolderPath(sInputTestSetPath)+"../";
+    std::vector<TestMetadata> voTestSet;
+    for(auto oTestIter=voTestSet_FN.begin(); oTestIter!=voTestSet_FN.end(); ++oTestIter) {
+        TestMetadata oNewTest = { (*oTestIter)["test_name"],
+                                  sDatasetRootPath+(std::string)((*oTestIter)["input_scenario_path"]),
+                                  sDatasetRootPath+(std::string)((*oTestIter)["input_gtseq_path"]),
+                                  sDatasetRootPath+(std::string)((*oTestIter)["input_target_mask_path"]),
+                                  (*oTestIter)["init_frame_idx"],
+                                  (*oTestIter)["last_frame_idx"]};
+        voTestSet.push_back(oNewTest);
+    }
+    return voTestSet;
+}
+
 int vptz::Evaluator::GetTestSetSize() {
     return (int)m_voTestSet.size();
 }
@@ -525,6 +1009,8 @@ void vptz::Evaluator::BeginTesting() {
         m_nCurrTestIdx = -1;
         throw;
     }
+    if(m_bSimulatedClock)
+        m_oOutputEvalFS << "input_simulatedClock" << 1 << "input_simulatedExecDelay" << m_pCamera->Get(PTZ_CAM_SIMULATED_EXECUTION_DELAY);
     m_oOutputEvalFS << "results" << "[";
     m_nCurrOutOfViewFrameCount = 0;
     m_nCurrProcessedFrameCount = 0;
@@ -570,6 +1056,29 @@ void vptz::Evaluator::EndTesting() {
     m_nTotTestFrameCount += m_nTestFrameCount;
 }
 
+void vptz::Evaluator::SetSimulatedClock(bool bEnabled, double dExecDelay) {
+    lvDbgExceptionWatch;
+    lvAssert(!m_bRunning && dExecDelay>=0.0);
+    m_bSimulatedClock = bEnabled;
+    m_dSimulatedExecDelay = dExecDelay;
+    if(m_pCamera.get()) {
+        m_pCamera->Set(PTZ_CAM_SIMULATED_CLOCK,m_bSimulatedClock);
+        m_pCamera->Set(PTZ_CAM_SIMULATED_EXECUTION_DELAY,m_dSimulatedExecDelay);
+    }
+}
+
+void vptz::Evaluator::SetCPURendering(bool bEnabled) {
+    lvDbgExceptionWatch;
+    lvAssert(!m_bRunning);
+    m_bUsingCPURenderer = bEnabled;
+}
+
+void vptz::Evaluator::SetSimulatedExecutionDelay(double dExecDelay) {
+    lvDbgExceptionWatch;
+    lvAssert(m_bSimulatedClock && m_pCamera.get());
+    m_pCamera->Set(PTZ_CAM_SIMULATED_EXECUTION_DELAY,dExecDelay);
+}
+
 double vptz::Evaluator::GetCurrCameraProperty(CameraPropertyFlag flag) {
     lvDbgExceptionWatch;
     lvAssert(m_bReady && m_pCamera.get());
@@ -707,9 +1216,11 @@ void vptz::Evaluator::Setup( const std::string& sInputScenarioPath, const std::s
     lvAssert(nFirstTestFrameIdx<nLastTestFrameIdx && nLastTestFrameIdx>0);
     m_bReady = m_bRunning = m_bQueried = false;
     m_pCamera.reset();
-    m_pCamera = std::unique_ptr<Camera>(new Camera(sInputScenarioPath));
+    m_pCamera = std::unique_ptr<Camera>(new Camera(sInputScenarioPath,90.0,640.0,480.0,0.0,90.0,300.0,300.0,0.2,m_bUsingCPURenderer));
     m_pCamera->Set(PTZ_CAM_COMMUNICATION_DELAY,m_dCommDelay);
     m_pCamera->Set(PTZ_CAM_EXECUTION_DELAY_RATIO,m_dExecDelayRatio);
+    m_pCamera->Set(PTZ_CAM_SIMULATED_CLOCK,m_bSimulatedClock);
+    m_pCamera->Set(PTZ_CAM_SIMULATED_EXECUTION_DELAY,m_dSimulatedExecDelay);
     m_oCurrGTSequence_FS.open(sInputGTSequencePath,cv::FileStorage::READ);
     if(!m_oCurrGTSequence_FS.isOpened())
         lvError("cannot open the input gt file");
@@ -781,59 +1292,211 @@ void vptz::Evaluator::Setup( const std::string& sInputScenarioPath, const std::s
     m_bgtVertiAngle = m_bgtInitVertiAngle;
 }
 
+vptz::BatchEvaluator::BatchEvaluator( const std::string& sInputTestSetPath, const std::string& sOutputEvalFilePath,
+                                      double dCommDelay, double dExecDelayRatio, size_t nWorkers, bool bUseCPURenderer) :
+        m_sInputTestSetPath(sInputTestSetPath),
+        m_sOutputEvalFilePath(sOutputEvalFilePath),
+        m_dCommDelay(dCommDelay),
+        m_dExecDelayRatio(dExecDelayRatio),
+        m_nWorkers(nWorkers?nWorkers:std::max((size_t)std::thread::hardware_concurrency(),size_t(1))),
+        m_bUsingCPURenderer(bUseCPURenderer),
+        m_voTestSet(Evaluator::ReadTestSet(sInputTestSetPath)),
+        m_bDone(false) {
+    lvDbgExceptionWatch;
+    cv::FileStorage oOutputEvalFS(m_sOutputEvalFilePath, cv::FileStorage::WRITE);
+    if(!oOutputEvalFS.isOpened())
+        lvError("cannot open the output yml file");
+}
+
+int vptz::BatchEvaluator::GetTestSetSize() const {
+    return (int)m_voTestSet.size();
+}
+
+std::string vptz::BatchEvaluator::GetTestSequenceName(int nTestIdx) const {
+    lvDbgExceptionWatch;
+    lvAssert(nTestIdx<(int)m_voTestSet.size() && nTestIdx>=0);
+    return m_voTestSet[nTestIdx].sTestName;
+}
+
+std::string vptz::BatchEvaluator::GetTestOutputFilePath(int nTestIdx) const {
+    return m_sOutputEvalFilePath+".part"+std::to_string(nTestIdx)+".yml";
+}
+
+void vptz::BatchEvaluator::Run(const TestFunc& lTestFunc) {
+    lvDbgExceptionWatch;
+    lvAssert(!m_bDone && lTestFunc);
+    m_bDone = true;
+    const int nTestCount = (int)m_voTestSet.size();
+    // each test runs on its own single-test evaluator (with its own camera & context), writing to a temporary file
+    std::vector<std::exception_ptr> vpTestExceptions(nTestCount);
+    std::atomic<int> nNextTestIdx(0);
+    auto lWorker = [&]() {
+        for(int nTestIdx=nNextTestIdx++; nTestIdx<nTestCount; nTestIdx=nNextTestIdx++) {
+            try {
+                const Evaluator::TestMetadata& oTest = m_voTestSet[nTestIdx];
+                Evaluator oEvaluator(oTest.sInputScenarioPath,oTest.sInputGTSequencePath,oTest.sInputTargetMaskPath,GetTestOutputFilePath(nTestIdx),
+                                     m_dCommDelay,m_dExecDelayRatio,oTest.nFirstTestFrameIdx,oTest.nLastTestFrameIdx);
+                oEvaluator.m_voTestSet[0].sTestName = oTest.sTestName;
+                oEvaluator.SetCPURendering(m_bUsingCPURenderer);
+                oEvaluator.SetupTesting(0);
+                lTestFunc(oEvaluator,nTestIdx);
+                lvAssert_(!oEvaluator.m_bRunning && oEvaluator.m_nTotSeqsTested==1,"test function must run a full test (BeginTesting...EndTesting)");
+            }
+            catch(...) {
+                vpTestExceptions[nTestIdx] = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> voWorkers;
+    for(size_t nWorkerIdx=1; nWorkerIdx<std::min(m_nWorkers,(size_t)nTestCount); ++nWorkerIdx)
+        voWorkers.emplace_back(lWorker);
+    lWorker();
+    for(auto& oWorker : voWorkers)
+        oWorker.join();
+    // merge in test order, exactly as a sequential multi-test evaluator would have written it
+    cv::FileStorage oOutputEvalFS(m_sOutputEvalFilePath, cv::FileStorage::WRITE);
+    if(!oOutputEvalFS.isOpened())
+        lvError("cannot open the output yml file");
+    oOutputEvalFS << "input_testset_path" << m_sInputTestSetPath;
+    oOutputEvalFS << "sequences" << "[";
+    double dTargetPointError_FullAvg=0, dTargetPointOffset_FullAvg=0, dBBoxOverlapRatio_FullAvg=0;
+    double dTrackFragmentation_FullAvg=0, dOutOfViewFrameRatio_FullAvg=0, dProcessedFrameRatio_FullAvg=0;
+    int nTotSeqsTested=0, nTotTestFrameCount=0;
+    std::exception_ptr pFirstException;
+    for(int nTestIdx=0; nTestIdx<nTestCount; ++nTestIdx) {
+        const std::string sTestOutputFilePath = GetTestOutputFilePath(nTestIdx);
+        if(vpTestExceptions[nTestIdx]) {
+            if(!pFirstException)
+                pFirstException = vpTestExceptions[nTestIdx];
+            std::remove(sTestOutputFilePath.c_str());
+            continue;
+        }
+        {
+            cv::FileStorage oTestEvalFS(sTestOutputFilePath,cv::FileStorage::READ);
+            if(!oTestEvalFS.isOpened())
+                lvError("cannot open a temporary test output yml file");
+            const cv::FileNode oRoot = oTestEvalFS.root();
+            oOutputEvalFS << "{" << "id" << nTestIdx+1;
+            for(auto oIter=oRoot.begin(); oIter!=oRoot.end(); ++oIter) {
+                oOutputEvalFS << (*oIter).name();
+                CopyFileNodeValue(oOutputEvalFS,*oIter,false);
+            }
+            oOutputEvalFS << "}";
+            dTargetPointError_FullAvg += (double)oRoot["targetPointError_avg"];
+            dTargetPointOffset_FullAvg += (double)oRoot["targetPointOffset_avg"];
+            dBBoxOverlapRatio_FullAvg += (double)oRoot["bBoxOverlapRatio_avg"];
+            dTrackFragmentation_FullAvg += (double)oRoot["trackFragmentation"];
+            dOutOfViewFrameRatio_FullAvg += (double)oRoot["outOfViewRatio"];
+            dProcessedFrameRatio_FullAvg += (double)oRoot["processedRatio"];
+            nTotTestFrameCount += (int)oRoot["potential_frame_count"];
+            ++nTotSeqsTested;
+        }
+        std::remove(sTestOutputFilePath.c_str());
+    }
+    oOutputEvalFS << "]"
+        << "targetPointError_fullavg" << dTargetPointError_FullAvg/nTotSeqsTested
+        << "targetPointOffset_fullavg" << dTargetPointOffset_FullAvg/nTotSeqsTested
+        << "bBoxOverlapRatio_fullavg" << dBBoxOverlapRatio_FullAvg/nTotSeqsTested
+        << "trackFragmentation_fullavg" << dTrackFragmentation_FullAvg/nTotSeqsTested
+        << "outOfViewRatio_fullavg" << dOutOfViewFrameRatio_FullAvg/nTotSeqsTested
+        << "processedRatio_fullavg" << dProcessedFrameRatio_FullAvg/nTotSeqsTested
+        << "tot_potential_frame_count" << nTotTestFrameCount;
+    oOutputEvalFS.release();
+    if(pFirstException)
+        std::rethrow_exception(pFirstException);
+}
+
+namespace {
+
+    /// per-camera terms of the point transforms, computed once and shared by the scalar & batch versions (so that both give identical results)
+    struct PTZProjection {
+        /// validates the camera parameters & precomputes the view matrix; throws if invalid args
+        PTZProjection(int camOutputWidth, int camOutputHeight, double camVertiFOV, double camHoriAngle, double camVertiAngle) :
+                nOutputWidth(camOutputWidth),nOutputHeight(camOutputHeight) {
+            if(camOutputWidth<1)
+                lvError("invalid camOutputWidth");
+            else if(camOutputHeight<1)
+                lvError("invalid camOutputHeight");
+            else if(camVertiFOV<=0.0 || camVertiFOV>=180.0)
+                lvError("invalid camVertiFOV");
+            else if(camHoriAngle<=-180.0 || camHoriAngle>180.0)
+                lvError("invalid camHoriAngle");
+            else if(camVertiAngle<0.0 || camVertiAngle>180.0)
+                lvError("invalid camVertiAngle");
+            // viewMatrix (world coordinate -> camera coordinate)
+            // glRotatef(GLfloat(vertiAngle-180), 1, 0, 0);      // x axis
+            // glRotatef(GLfloat(90-horiAngle), 0, 0, 1);        // z axis
+            oViewMatrix = GetRotationMatrix_X(camVertiAngle-180)*GetRotationMatrix_Z(90-camHoriAngle);
+            oInvViewMatrix = oViewMatrix.inv();
+            dFocalLength = camOutputHeight/2.0/tan(D2R(camVertiFOV)/2.0);
+            dNormalScale = 2.0*tan(D2R(camVertiFOV)/2.0);
+            dAspectRatio = (double(camOutputWidth)/double(camOutputHeight));
+            oCameraVec3d.x = sin(D2R(camVertiAngle))*cos(D2R(camHoriAngle));
+            oCameraVec3d.y = sin(D2R(camVertiAngle))*sin(D2R(camHoriAngle));
+            oCameraVec3d.z = cos(D2R(camVertiAngle));
+            dCameraVecNorm2 = oCameraVec3d.ddot(oCameraVec3d);
+        }
+
+        /// maps a 2D image point to its horizontal and vertical angles; throws if invalid args
+        void XYtoHV(int target2dX, int target2dY, double& tarHoriAngle, double& tarVertiAngle) const {
+            if(target2dX<0 || target2dX>=nOutputWidth)
+                lvError("invalid target2dX");
+            else if(target2dY<0 || target2dY>=nOutputHeight)
+                lvError("invalid target2dY");
+            // 3d camera coordinates
+            const cv::Vec3d ray_camera(target2dX-nOutputWidth/2.0,-(target2dY-nOutputHeight/2.0),-dFocalLength);
+            // 3d world coordinate
+            const cv::Vec3d ray_world = oInvViewMatrix*ray_camera;
+            // from 3d position to horizontal & vertical angles
+            const double target3dX = ray_world[0];
+            const double target3dY = ray_world[1];
+            const double target3dZ = ray_world[2];
+            tarHoriAngle = R2D(atan2(target3dY, target3dX));     // horizontal angle
+            const double target3dR = sqrt(target3dX*target3dX+target3dY*target3dY+target3dZ*target3dZ);
+            tarVertiAngle = R2D(acos(target3dZ/target3dR));    // vertical angle
+        }
+
+        /// maps horizontal and vertical angles to a 2D image point; returns false if the target is more than 90 degrees away from the camera direction; throws if invalid args
+        bool HVtoXY(double tarHoriAngle, double tarVertiAngle, int& target2dX, int& target2dY) const {
+            if(tarHoriAngle<=-180.0 || tarHoriAngle>180.0)
+                lvError("invalid tarHoriAngle");
+            else if(tarVertiAngle<0.0 || tarVertiAngle>180.0)
+                lvError("invalid tarVertiAngle");
+            // If the direct difference between direction of target and camera is larger than 90 degrees
+            const double vAngle = D2R(tarVertiAngle);
+            const double hAngle = D2R(tarHoriAngle);
+            const cv::Point3d targetVec3d(sin(vAngle)*cos(hAngle),sin(vAngle)*sin(hAngle),cos(vAngle)); // *1.0 (unit vector)
+            const double angleDifference = R2D(acos(targetVec3d.ddot(oCameraVec3d)/(targetVec3d.ddot(targetVec3d)*dCameraVecNorm2)));
+            if(angleDifference>90.0) {
+                target2dX = INT_MAX;
+                target2dY = INT_MAX;
+                return false;
+            }
+            // 3d camera coordinates (from the 3d world coordinate on the unit sphere)
+            const cv::Vec3d ray_camera = oViewMatrix*cv::Vec3d(targetVec3d.x,targetVec3d.y,targetVec3d.z);
+            // 2d normalized coordinate, range [-0.5:0.5, -0.5:0.5]
+            const double x_normal = ray_camera[0]/(-ray_camera[2])/(dAspectRatio*dNormalScale);
+            const double y_normal = ray_camera[1]/(-ray_camera[2])/dNormalScale;
+            // 2d image coordinate, range [0:width, height:0]
+            target2dX = int((x_normal+0.5)*nOutputWidth+0.5);
+            target2dY = int((0.5-y_normal)*nOutputHeight+0.5);
+            return true;
+        }
+
+        const int nOutputWidth, nOutputHeight;
+        cv::Matx33d oViewMatrix, oInvViewMatrix;
+        double dFocalLength, dNormalScale, dAspectRatio;
+        cv::Point3d oCameraVec3d;
+        double dCameraVecNorm2;
+    };
+
+} // anonymous namespace
+
 void vptz::PTZPointXYtoHV( int target2dX, int target2dY, double& tarHoriAngle, double& tarVertiAngle,
                            int camOutputWidth, int camOutputHeight,
                            double camVertiFOV, double camHoriAngle, double camVertiAngle) {
     lvDbgExceptionWatch;
-    if(camOutputWidth<1)
-        lvError("invalid camOutputWidth");
-    else if(camOutputHeight<1)
-        lvError("invalid camOutputHeight");
-    else if(target2dX<0 || target2dX>=camOutputWidth)
-        lvError("invalid target2dX");
-    else if(target2dY<0 || target2dY>=camOutputHeight)
-        lvError("invalid target2dY");
-    else if(camVertiFOV<=0.0 || camVertiFOV>=180.0)
-        lvError("invalid camVertiFOV");
-    else if(camHoriAngle<=-180.0 || camHoriAngle>180.0)
-        lvError("invalid camHoriAngle");
-    else if(camVertiAngle<0.0 || camVertiAngle>180.0)
-        lvError("invalid camVertiAngle");
-
-    // viewMatrix (world coordinate -> camera coordinate)
-    // glRotatef(GLfloat(vertiAngle-180), 1, 0, 0);      // x axis
-    double angle = D2R(camVertiAngle-180);
-    cv::Mat rotateX = cv::Mat::eye(3, 3, CV_64FC1);
-    rotateX.at<double>(1,1) = cos(angle);
-    rotateX.at<double>(1,2) = -sin(angle);
-    rotateX.at<double>(2,1) = sin(angle);
-    rotateX.at<double>(2,2) = cos(angle);
-    // glRotatef(GLfloat(90-horiAngle), 0, 0, 1);        // z axis
-    cv::Mat rotateZ = cv::Mat::eye(3, 3, CV_64FC1);
-    angle = D2R(90-camHoriAngle);
-    rotateZ.at<double>(0,0) = cos(angle);
-    rotateZ.at<double>(0,1) = -sin(angle);
-    rotateZ.at<double>(1,0) = sin(angle);
-    rotateZ.at<double>(1,1) = cos(angle);
-    // final
-    cv::Mat viewMatrix = rotateX*rotateZ;
-
-    // 3d camera coordinates
-    cv::Mat ray_camera(3, 1, CV_64F);
-    ray_camera.at<double>(0,0) = target2dX-camOutputWidth/2.0;
-    ray_camera.at<double>(1,0) = -(target2dY-camOutputHeight/2.0);
-    ray_camera.at<double>(2,0) = -camOutputHeight/2.0/tan(D2R(camVertiFOV)/2.0);
-
-    // 3d world coordinate
-    cv::Mat ray_world = viewMatrix.inv()*ray_camera;
-
-    // from 3d position to horizontal & vertical angles
-    double target3dX = ray_world.at<double>(0,0);
-    double target3dY = ray_world.at<double>(1,0);
-    double target3dZ = ray_world.at<double>(2,0);
-    tarHoriAngle = R2D(atan2(target3dY, target3dX));     // horizontal angle
-    double target3dR = sqrt(target3dX*target3dX+target3dY*target3dY+target3dZ*target3dZ);
-    tarVertiAngle = R2D(acos(target3dZ/target3dR));    // vertical angle
+    PTZProjection(camOutputWidth,camOutputHeight,camVertiFOV,camHoriAngle,camVertiAngle).XYtoHV(target2dX,target2dY,tarHoriAngle,tarVertiAngle);
 }
 
 void vptz::PTZPointXYtoHV( cv::Point2i targetXY, cv::Point2d& targetHV, int camOutputWidth, int camOutputHeight,
@@ -842,85 +1505,20 @@ void vptz::PTZPointXYtoHV( cv::Point2i targetXY, cv::Point2d& targetHV, int camO
     PTZPointXYtoHV(targetXY.x,targetXY.y,targetHV.x,targetHV.y, camOutputWidth, camOutputHeight, camVertiFOV, camHoriAngle, camVertiAngle);
 }
 
+void vptz::PTZPointsXYtoHV( const std::vector<cv::Point2i>& vTargetXY, std::vector<cv::Point2d>& vTargetHV, int camOutputWidth, int camOutputHeight,
+                            double camVertiFOV, double camHoriAngle, double camVertiAngle) {
+    lvDbgExceptionWatch;
+    const PTZProjection oProj(camOutputWidth,camOutputHeight,camVertiFOV,camHoriAngle,camVertiAngle);
+    vTargetHV.resize(vTargetXY.size());
+    for(size_t nPointIdx=0; nPointIdx<vTargetXY.size(); ++nPointIdx)
+        oProj.XYtoHV(vTargetXY[nPointIdx].x,vTargetXY[nPointIdx].y,vTargetHV[nPointIdx].x,vTargetHV[nPointIdx].y);
+}
+
 bool vptz::PTZPointHVtoXY( double tarHoriAngle, double tarVertiAngle, int& target2dX, int& target2dY,
                            int camOutputWidth, int camOutputHeight,
                            double camVertiFOV, double camHoriAngle, double camVertiAngle) {
     lvDbgExceptionWatch;
-    if(camOutputWidth<1)
-        lvError("invalid camOutputWidth");
-    else if(camOutputHeight<1)
-        lvError("invalid camOutputHeight");
-    else if(tarHoriAngle<=-180.0 || tarHoriAngle>180.0)
-        lvError("invalid tarHoriAngle");
-    else if(tarVertiAngle<0.0 || tarVertiAngle>180.0)
-        lvError("invalid tarVertiAngle");
-    else if(camVertiFOV<=0.0 || camVertiFOV>=180.0)
-        lvError("invalid camVertiFOV");
-    else if(camHoriAngle<=-180.0 || camHoriAngle>180.0)
-        lvError("invalid camHoriAngle");
-    else if(camVertiAngle<0.0 || camVertiAngle>180.0)
-        lvError("invalid camVertiAngle");
-
-    // If the direct difference between direction of target and camera is larger than 90 degrees
-    cv::Point3d targetVec3d;
-    targetVec3d.x = sin(D2R(tarVertiAngle))*cos(D2R(tarHoriAngle));    // *1.0 (unit vector)
-    targetVec3d.y = sin(D2R(tarVertiAngle))*sin(D2R(tarHoriAngle));
-    targetVec3d.z = cos(D2R(tarVertiAngle));
-    cv::Point3d cameraVec3d;
-    cameraVec3d.x = sin(D2R(camVertiAngle))*cos(D2R(camHoriAngle));
-    cameraVec3d.y = sin(D2R(camVertiAngle))*sin(D2R(camHoriAngle));
-    cameraVec3d.z = cos(D2R(camVertiAngle));
-    double angleDifference = R2D(acos(targetVec3d.ddot(cameraVec3d)/(targetVec3d.ddot(targetVec3d)*cameraVec3d.ddot(cameraVec3d))));
-    if(angleDifference>90.0) {
-        target2dX = INT_MAX;
-        target2dY = INT_MAX;
-        return false;
-    }
-
-    // viewMatrix (world coordinate -> camera coordinate)
-    // glRotatef(GLfloat(vertiAngle-180), 1, 0, 0);    // x axis
-    double angle = D2R(camVertiAngle-180);
-    cv::Mat rotateX = cv::Mat::eye(3, 3, CV_64FC1);
-    rotateX.at<double>(1,1) = cos(angle);
-    rotateX.at<double>(1,2) = -sin(angle);
-    rotateX.at<double>(2,1) = sin(angle);
-    rotateX.at<double>(2,2) = cos(angle);
-    // glRotatef(GLfloat(90-horiAngle), 0, 0, 1);        // z axis
-    cv::Mat rotateZ = cv::Mat::eye(3, 3, CV_64FC1);
-    angle = D2R(90-camHoriAngle);
-    rotateZ.at<double>(0,0) = cos(angle);
-    rotateZ.at<double>(0,1) = -sin(angle);
-    rotateZ.at<double>(1,0) = sin(angle);
-    rotateZ.at<double>(1,1) = cos(angle);
-    // final
-    cv::Mat viewMatrix = rotateX*rotateZ;
-
-    // 3d world coordinate: from horizontal & vertical angles to 3d position
-    cv::Mat ray_world(3, 1, CV_64F);
-    double vAngle = D2R(tarVertiAngle);
-    double hAngle = D2R(tarHoriAngle);
-    ray_world.at<double>(0,0) = sin(vAngle)*cos(hAngle);    // *1.0 (on unit sphere)
-    ray_world.at<double>(1,0) = sin(vAngle)*sin(hAngle);
-    ray_world.at<double>(2,0) = cos(vAngle);
-    //cout<<"ray_world"<<ray_world<<endl;
-
-    // 3d camera coordinates
-    cv::Mat ray_camera = viewMatrix*ray_world;
-    //cout<<"ray_camera"<<ray_camera<<endl;
-
-    // 2d normalized coordinate, range [-0.5:0.5, -0.5:0.5]
-    double x_camera = ray_camera.at<double>(0,0);
-    double y_camera = ray_camera.at<double>(1,0);
-    double z_camera = ray_camera.at<double>(2,0);
-    double radio = (double(camOutputWidth)/double(camOutputHeight));
-    double x_normal = x_camera/(-z_camera)/(radio*2.0*tan(D2R(camVertiFOV)/2.0));
-    double y_normal = y_camera/(-z_camera)/(2.0*tan(D2R(camVertiFOV)/2.0));
-    //cout<<cv::Point2d(x_normal, y_normal)<<endl;
-
-    // 2d image coordinate, range [0:width, height:0]
-    target2dX = int((x_normal+0.5)*camOutputWidth+0.5);
-    target2dY = int((0.5-y_normal)*camOutputHeight+0.5);
-    return true;
+    return PTZProjection(camOutputWidth,camOutputHeight,camVertiFOV,camHoriAngle,camVertiAngle).HVtoXY(tarHoriAngle,tarVertiAngle,target2dX,target2dY);
 }
 
 bool vptz::PTZPointHVtoXY( cv::Point2d targetHV, cv::Point2i& targetXY, int camOutputWidth, int camOutputHeight,
@@ -928,3 +1526,14 @@ bool vptz::PTZPointHVtoXY( cv::Point2d targetHV, cv::Point2i& targetXY, int camO
     lvDbgExceptionWatch;
     return PTZPointHVtoXY(targetHV.x, targetHV.y, targetXY.x, targetXY.y, camOutputWidth, camOutputHeight, camVertiFOV, camHoriAngle, camVertiAngle);
 }
+
+int vptz::PTZPointsHVtoXY( const std::vector<cv::Point2d>& vTargetHV, std::vector<cv::Point2i>& vTargetXY, int camOutputWidth, int camOutputHeight,
+                           double camVertiFOV, double camHoriAngle, double camVertiAngle) {
+    lvDbgExceptionWatch;
+    const PTZProjection oProj(camOutputWidth,camOutputHeight,camVertiFOV,camHoriAngle,camVertiAngle);
+    vTargetXY.resize(vTargetHV.size());
+    int nValidPoints = 0;
+    for(size_t nPointIdx=0; nPointIdx<vTargetHV.size(); ++nPointIdx)
+        nValidPoints += (int)oProj.HVtoXY(vTargetHV[nPointIdx].x,vTargetHV[nPointIdx].y,vTargetXY[nPointIdx].x,vTargetXY[nPointIdx].y);
+    return nValidPoints;
+}
@@ -0,0 +1,64 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "litiv/world.hpp"
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+/*!
+    NumPy <-> cv::Mat bridge used by all python bindings
+
+    Note 1: no pixel data is ever copied; input arrays are wrapped in mat headers pointing at their buffers, and output
+            mats are exported as arrays holding a reference to the mat's ref-counted buffer.
+    Note 2: arrays map to mats as (rows,cols) or (rows,cols,channels); rows may be strided (e.g. for crops), but
+            pixels and channels must be packed.
+    Note 3: bindings wrap arrays while holding the GIL, then release it for the duration of the native call (the
+            caller's array references keep their buffers alive in the meantime).
+ */
+namespace lv {
+
+    namespace python {
+
+        /// returns the opencv depth matching a numpy dtype (throws for unsupported types)
+        int getMatDepth(const pybind11::dtype& oDType);
+        /// returns the numpy dtype matching an opencv depth (throws for unsupported depths)
+        pybind11::dtype getArrayDType(int nDepth);
+        /// wraps a numpy array in a mat header sharing its memory (the mat must not outlive the array)
+        cv::Mat toMat(const pybind11::array& oArray);
+        /// wraps a mat in a numpy array sharing its memory (the array keeps the mat buffer alive; read-only if bWritable is false)
+        pybind11::array toArray(const cv::Mat& oMat, bool bWritable=true);
+        /// wraps an optional, caller-provided output array in a mat header (returns an empty mat if none was given)
+        cv::Mat toOutputMat(const pybind11::object& oOutput);
+        /// returns the array to give back for an output mat: the caller-provided one (which must not have been reallocated), or a new array sharing the mat's buffer
+        pybind11::array fromOutputMat(const cv::Mat& oMat, const pybind11::object& oOutput);
+
+        /// registers the LBSP bindings in the given module
+        void registerFeatures2D(pybind11::module& oModule);
+        /// registers the edge detector bindings in the given module
+        void registerImgProc(pybind11::module& oModule);
+        /// registers the background subtractor bindings in the given module
+        void registerVideo(pybind11::module& oModule);
+        /// registers the dataset/data loader bindings in the given module
+        void registerDatasets(pybind11::module& oModule);
+
+    } // namespace python
+
+} // namespace lv
@@ -0,0 +1,114 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "bindings.hpp"
+
+namespace py = pybind11;
+
+namespace {
+
+    using CDnetDatasetType = lv::Dataset_<lv::DatasetTask_ChgDet,lv::Dataset_CDnet,lv::NonParallel>;
+    using CDnetBatchType = CDnetDatasetType::WorkBatch;
+
+    /// registers the loader/consumer methods of a dataset work batch type under the given name
+    template<typename TWorkBatch>
+    void registerWorkBatch(py::module& oModule, const char* sName) {
+        py::class_<TWorkBatch,lv::IDataHandler,std::shared_ptr<TWorkBatch>>(oModule,sName,"dataset work batch (data loader & consumer); returned packets are read-only arrays sharing the loader's ref-counted buffers")
+            .def("getInput",[](TWorkBatch& oBatch, size_t nPacketIdx) {
+                cv::Mat oPacket;
+                {
+                    py::gil_scoped_release oNoGIL;
+                    oPacket = oBatch.getInput(nPacketIdx);
+                }
+                return lv::python::toArray(oPacket,false);
+            },py::arg("idx"),"returns an input packet by index (blocks until it is loaded)")
+            .def("getGT",[](TWorkBatch& oBatch, size_t nPacketIdx) {
+                cv::Mat oPacket;
+                {
+                    py::gil_scoped_release oNoGIL;
+                    oPacket = oBatch.getGT(nPacketIdx);
+                }
+                return lv::python::toArray(oPacket,false);
+            },py::arg("idx"),"returns a gt packet by index (blocks until it is loaded)")
+            .def("getInputBatch",[](TWorkBatch& oBatch, size_t nFirstIdx, size_t nCount) {
+                std::vector<cv::Mat> voPacketViews;
+                {
+                    py::gil_scoped_release oNoGIL;
+                    oBatch.getInputBatch(nFirstIdx,nCount,&voPacketViews);
+                }
+                std::vector<py::array> voPackets;
+                voPackets.reserve(voPacketViews.size());
+                for(const cv::Mat& oPacket : voPacketViews)
+                    voPackets.push_back(lv::python::toArray(oPacket,false));
+                return voPackets;
+            },py::arg("first_idx"),py::arg("count"),"returns up to 'count' consecutive input packets, as views of a single contiguous buffer")
+            .def("getInputROI",[](const TWorkBatch& oBatch, size_t nPacketIdx) {return lv::python::toArray(oBatch.getInputROI(nPacketIdx),false);},py::arg("idx"))
+            .def("getGTROI",[](const TWorkBatch& oBatch, size_t nPacketIdx) {return lv::python::toArray(oBatch.getGTROI(nPacketIdx),false);},py::arg("idx"))
+            .def("startAsyncPrecaching",&TWorkBatch::startAsyncPrecaching,py::arg("precache_gt"),py::arg("suggested_buffer_size")=SIZE_MAX,py::call_guard<py::gil_scoped_release>())
+            .def("stopAsyncPrecaching",&TWorkBatch::stopAsyncPrecaching,py::call_guard<py::gil_scoped_release>())
+            .def("startProcessing",&TWorkBatch::startProcessing)
+            .def("stopProcessing",&TWorkBatch::stopProcessing,py::call_guard<py::gil_scoped_release>())
+            .def("push",[](TWorkBatch& oBatch, const py::array& oOutput, size_t nPacketIdx) {
+                const cv::Mat oPacket = lv::python::toMat(oOutput);
+                py::gil_scoped_release oNoGIL;
+                oBatch.push(oPacket,nPacketIdx);
+            },py::arg("output"),py::arg("idx"),"pushes a processed packet for archiving and/or evaluation (must be called between start/stopProcessing)");
+    }
+
+} // anonymous namespace
+
+void lv::python::registerDatasets(py::module& oModule) {
+    py::class_<lv::IDataHandler,std::shared_ptr<lv::IDataHandler>>(oModule,"IDataHandler","dataset work batch/group interface")
+        .def("getName",&lv::IDataHandler::getName)
+        .def("getDataPath",&lv::IDataHandler::getDataPath)
+        .def("getOutputPath",&lv::IDataHandler::getOutputPath)
+        .def("getRelativePath",&lv::IDataHandler::getRelativePath)
+        .def("getTotPackets",&lv::IDataHandler::getTotPackets)
+        .def("isGrayscale",&lv::IDataHandler::isGrayscale)
+        .def("isGroup",&lv::IDataHandler::isGroup)
+        .def("isProcessing",&lv::IDataHandler::isProcessing)
+        .def("getProcessTime",&lv::IDataHandler::getProcessTime)
+        .def("getProcessedPacketsCount",&lv::IDataHandler::getProcessedPacketsCount)
+        .def("writeEvalReport",&lv::IDataHandler::writeEvalReport);
+    registerWorkBatch<CDnetBatchType>(oModule,"CDnetWorkBatch");
+    py::class_<lv::IDataset,std::shared_ptr<lv::IDataset>>(oModule,"IDataset","dataset interface")
+        .def("getName",&lv::IDataset::getName)
+        .def("getDatasetPath",&lv::IDataset::getDatasetPath)
+        .def("getOutputPath",&lv::IDataset::getOutputPath)
+        .def("getTotPackets",&lv::IDataset::getTotPackets)
+        .def("writeEvalReport",&lv::IDataset::writeEvalReport);
+    oModule.def("createCDnet",[](const std::string& sOutputDirName, bool bSaveOutput, bool bUseEvaluator, bool bForce4ByteDataAlign, double dScaleFactor, bool b2014) {
+        lv::IDatasetPtr pDataset;
+        {
+            py::gil_scoped_release oNoGIL;
+            pDataset = lv::datasets::create<lv::DatasetTask_ChgDet,lv::Dataset_CDnet,lv::NonParallel>(sOutputDirName,bSaveOutput,bUseEvaluator,bForce4ByteDataAlign,dScaleFactor,b2014);
+        }
+        return pDataset;
+    },py::arg("output_dir_name"),py::arg("save_output")=false,py::arg("use_evaluator")=true,py::arg("force_4byte_align")=false,py::arg("scale_factor")=1.0,py::arg("cdnet2014")=true,
+      "creates the CDnet change detection dataset interface (parsed from the external data root)");
+    oModule.def("getCDnetBatches",[](const lv::IDatasetPtr& pDataset) {
+        // batches are downcast to their full type here, as the python side cannot see through the virtual data handler bases
+        std::vector<std::shared_ptr<CDnetBatchType>> vpBatches;
+        for(const lv::IDataHandlerPtr& pBatch : pDataset->getBatches(false)) {
+            auto pCDnetBatch = std::dynamic_pointer_cast<CDnetBatchType>(pBatch);
+            lvAssert_(pCDnetBatch,"dataset work batches must come from 'createCDnet'");
+            vpBatches.push_back(pCDnetBatch);
+        }
+        return vpBatches;
+    },py::arg("dataset"),"returns the (flattened) work batches of a CDnet dataset");
+}
@@ -0,0 +1,67 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "bindings.hpp"
+
+namespace py = pybind11;
+
+void lv::python::registerFeatures2D(py::module& oModule) {
+    py::class_<LBSP,std::shared_ptr<LBSP>> oLBSP(oModule,"LBSP","Local Binary Similarity Pattern (LBSP) feature extractor; descriptor maps are uint16 arrays of the input's shape");
+    oLBSP
+        .def(py::init<size_t>(),py::arg("threshold"),"absolute intensity 'similarity' threshold constructor")
+        .def(py::init<float,size_t>(),py::arg("rel_threshold"),py::arg("threshold_offset")=0,"relative intensity 'similarity' threshold constructor")
+        .def("setReference",[](LBSP& oExtractor, const py::object& oRefImage) {
+            // the extractor holds on to its reference image across calls, so it gets its own copy (the array may be recycled by the caller)
+            oExtractor.setReference(oRefImage.is_none()?cv::Mat():toMat(oRefImage.cast<py::array>()).clone());
+        },py::arg("ref_image"),"sets the 'reference' image used for inter-frame comparisons (None = intra-frame comparisons)")
+        .def("isUsingRelThreshold",&LBSP::isUsingRelThreshold)
+        .def("getRelThreshold",&LBSP::getRelThreshold)
+        .def("getAbsThreshold",&LBSP::getAbsThreshold)
+        .def("setThreadCount",&LBSP::setThreadCount,py::arg("threads"),"sets the number of threads used by batch computations (0 = use all hardware threads)")
+        .def("getThreadCount",&LBSP::getThreadCount)
+        .def("computeDense",[](const LBSP& oExtractor, const py::array& oImage, const py::object& oDescMap, const py::object& oThresholds, int nBorderType) {
+            const cv::Mat oInput = toMat(oImage);
+            const cv::Mat oThresholdMap = oThresholds.is_none()?cv::Mat():toMat(oThresholds.cast<py::array>());
+            cv::Mat oOutput = toOutputMat(oDescMap);
+            {
+                py::gil_scoped_release oNoGIL;
+                oExtractor.computeDense(oInput,oOutput,oThresholdMap,nBorderType);
+            }
+            return fromOutputMat(oOutput,oDescMap);
+        },py::arg("image"),py::arg("descmap")=py::none(),py::arg("thresholds")=py::none(),py::arg("border_type")=(int)cv::BORDER_REPLICATE,
+          "computes descriptors for all pixels, in the given (or a new) descriptor map")
+        .def_static("calcDescImgHammingDist",[](const py::array& oDesc1, const py::array& oDesc2, const py::object& oDistMap, bool bMergeChannels) {
+            const cv::Mat oInput1 = toMat(oDesc1), oInput2 = toMat(oDesc2);
+            cv::Mat oOutput = toOutputMat(oDistMap);
+            {
+                py::gil_scoped_release oNoGIL;
+                LBSP::calcDescImgHammingDist(oInput1,oInput2,oOutput,bMergeChannels);
+            }
+            return fromOutputMat(oOutput,oDistMap);
+        },py::arg("desc1"),py::arg("desc2"),py::arg("distmap")=py::none(),py::arg("merge_channels")=false,
+          "computes the per-pixel hamming distances between two descriptor maps, in the given (or a new) uint8 map")
+        .def_static("validateROI",[](const py::array& oROI) {
+            cv::Mat oValidROI = toMat(oROI);
+            LBSP::validateROI(oValidROI);
+            return toArray(oValidROI);
+        },py::arg("roi"),"returns a copy of the ROI without the pixels too close to the image border");
+    // constants are copied by value (taking their address would require out-of-line definitions)
+    oLBSP.attr("PATCH_SIZE") = size_t(LBSP::PATCH_SIZE);
+    oLBSP.attr("DESC_SIZE_BITS") = size_t(LBSP::DESC_SIZE_BITS);
+    oLBSP.attr("BORDER_SKIP") = int(LBSP::BORDER_SKIP);
+}
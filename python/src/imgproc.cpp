@@ -0,0 +1,78 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "bindings.hpp"
+
+namespace py = pybind11;
+
+void lv::python::registerImgProc(py::module& oModule) {
+    py::class_<lv::EdgeDetectorStageCache,std::shared_ptr<lv::EdgeDetectorStageCache>>(oModule,"EdgeDetectorStageCache","memoizes threshold-independent edge detection stages across calls (can be shared by several detectors & threads)")
+        .def(py::init<size_t>(),py::arg("max_byte_size")=EDGEDETECT_DEFAULT_STAGE_CACHE_SIZE)
+        .def("clear",&lv::EdgeDetectorStageCache::clear)
+        .def("setMaxByteSize",&lv::EdgeDetectorStageCache::setMaxByteSize,py::arg("max_byte_size"))
+        .def("getMaxByteSize",&lv::EdgeDetectorStageCache::getMaxByteSize)
+        .def("getByteSize",&lv::EdgeDetectorStageCache::getByteSize)
+        .def("getHitCount",&lv::EdgeDetectorStageCache::getHitCount)
+        .def("getMissCount",&lv::EdgeDetectorStageCache::getMissCount);
+    py::class_<IIEdgeDetector,std::shared_ptr<IIEdgeDetector>>(oModule,"IEdgeDetector","edge detector interface; instances are not thread-safe, but several instances can run concurrently from different python threads")
+        .def("getDefaultThreshold",&IIEdgeDetector::getDefaultThreshold)
+        .def("apply_threshold",[](IIEdgeDetector& oAlgo, const py::array& oImage, double dThreshold, const py::object& oEdgeMask) {
+            const cv::Mat oInput = toMat(oImage);
+            cv::Mat oOutput = toOutputMat(oEdgeMask);
+            {
+                py::gil_scoped_release oNoGIL;
+                oAlgo.apply_threshold(oInput,oOutput,dThreshold);
+            }
+            return fromOutputMat(oOutput,oEdgeMask);
+        },py::arg("image"),py::arg("threshold")=-1.0,py::arg("edgemask")=py::none(),
+          "binary edge detection (threshold in [0,1], default otherwise), writing the edge mask in the given (or a new) uint8 array")
+        .def("apply",[](IIEdgeDetector& oAlgo, const py::array& oImage, const py::object& oEdgeMask) {
+            const cv::Mat oInput = toMat(oImage);
+            cv::Mat oOutput = toOutputMat(oEdgeMask);
+            {
+                py::gil_scoped_release oNoGIL;
+                oAlgo.apply(oInput,oOutput);
+            }
+            return fromOutputMat(oOutput,oEdgeMask);
+        },py::arg("image"),py::arg("edgemask")=py::none(),
+          "full sensitivity sweep edge detection, writing the confidence edge map in the given (or a new) uint8 array")
+        .def("applyBatch",[](IIEdgeDetector& oAlgo, const std::vector<py::array>& voImages, double dThreshold) {
+            std::vector<cv::Mat> voInputs,voOutputs;
+            voInputs.reserve(voImages.size());
+            for(const py::array& oImage : voImages)
+                voInputs.push_back(toMat(oImage));
+            {
+                py::gil_scoped_release oNoGIL;
+                oAlgo.applyBatch(voInputs,voOutputs,dThreshold);
+            }
+            std::vector<py::array> voEdgeMasks;
+            voEdgeMasks.reserve(voOutputs.size());
+            for(const cv::Mat& oOutput : voOutputs)
+                voEdgeMasks.push_back(toArray(oOutput));
+            return voEdgeMasks;
+        },py::arg("images"),py::arg("threshold")=-1.0,"batch edge detection (threshold<0 = full sensitivity sweep), returning one edge mask per image")
+        .def("setStageCache",&IIEdgeDetector::setStageCache,py::arg("cache"),"sets the stage cache used to memoize threshold-independent stages (None = disabled)")
+        .def("getStageCache",&IIEdgeDetector::getStageCache)
+        .def("setStageCacheImageID",&IIEdgeDetector::setStageCacheImageID,py::arg("image_id"),"sets the id of the image passed to the next calls, used to key stage cache entries");
+    py::class_<EdgeDetectorCanny,IIEdgeDetector,std::shared_ptr<EdgeDetectorCanny>>(oModule,"EdgeDetectorCanny")
+        .def(py::init<double,double>(),py::arg("hyst_low_thrsh_factor")=EDGCANNY_DEFAULT_HYST_LOW_THRSH_FACT,py::arg("gaussian_kernel_sigma")=EDGCANNY_DEFAULT_GAUSSIAN_KERNEL_SIGMA);
+    py::class_<EdgeDetectorLBSP,IIEdgeDetector,std::shared_ptr<EdgeDetectorLBSP>>(oModule,"EdgeDetectorLBSP")
+        .def(py::init<size_t,double,bool>(),py::arg("levels")=EDGLBSP_DEFAULT_LEVEL_COUNT,py::arg("hyst_low_thrsh_factor")=EDGLBSP_DEFAULT_HYST_LOW_THRSH_FACT,py::arg("normalize_output")=false)
+        .def("setThreadCount",&EdgeDetectorLBSP::setThreadCount,py::arg("threads"))
+        .def("setTileSize",&EdgeDetectorLBSP::setTileSize,py::arg("tile_size"));
+}
@@ -0,0 +1,28 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "bindings.hpp"
+
+PYBIND11_MODULE(litiv,oModule) {
+    oModule.doc() = "LITIV framework bindings; images & masks are shared with numpy arrays without copies, and the GIL is released during processing calls";
+    oModule.attr("__version__") = lv::getVersionStamp();
+    lv::python::registerFeatures2D(oModule);
+    lv::python::registerImgProc(oModule);
+    lv::python::registerVideo(oModule);
+    lv::python::registerDatasets(oModule);
+}
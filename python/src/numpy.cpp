@@ -0,0 +1,105 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "bindings.hpp"
+
+namespace py = pybind11;
+
+int lv::python::getMatDepth(const py::dtype& oDType) {
+    const char cKind = oDType.kind();
+    const ssize_t nItemSize = oDType.itemsize();
+    if((cKind=='u' || cKind=='b') && nItemSize==1)
+        return CV_8U;
+    else if(cKind=='i' && nItemSize==1)
+        return CV_8S;
+    else if(cKind=='u' && nItemSize==2)
+        return CV_16U;
+    else if(cKind=='i' && nItemSize==2)
+        return CV_16S;
+    else if(cKind=='i' && nItemSize==4)
+        return CV_32S;
+    else if(cKind=='f' && nItemSize==4)
+        return CV_32F;
+    else if(cKind=='f' && nItemSize==8)
+        return CV_64F;
+    lvError_("unsupported array dtype (kind='%c', itemsize=%d)",cKind,(int)nItemSize);
+}
+
+py::dtype lv::python::getArrayDType(int nDepth) {
+    switch(nDepth) {
+        case CV_8U: return py::dtype::of<uint8_t>();
+        case CV_8S: return py::dtype::of<int8_t>();
+        case CV_16U: return py::dtype::of<uint16_t>();
+        case CV_16S: return py::dtype::of<int16_t>();
+        case CV_32S: return py::dtype::of<int32_t>();
+        case CV_32F: return py::dtype::of<float>();
+        case CV_64F: return py::dtype::of<double>();
+        default: lvError_("unsupported mat depth (%d)",nDepth);
+    }
+}
+
+cv::Mat lv::python::toMat(const py::array& oArray) {
+    lvAssert_(oArray.ndim()==2 || oArray.ndim()==3,"array must be 2-dim (rows,cols) or 3-dim (rows,cols,channels)");
+    const int nDepth = getMatDepth(oArray.dtype());
+    const int nRows = (int)oArray.shape(0), nCols = (int)oArray.shape(1);
+    const int nChannels = oArray.ndim()==3?(int)oArray.shape(2):1;
+    lvAssert__(nChannels>0 && nChannels<=CV_CN_MAX,"array channel count must be in [1,%d]",CV_CN_MAX);
+    const ssize_t nElemSize = oArray.itemsize();
+    // strides of unit-length dimensions are meaningless (numpy may set them to anything), so they are not checked
+    lvAssert_((nChannels==1 || oArray.strides(2)==nElemSize) && (nCols<=1 || oArray.strides(1)==nElemSize*nChannels),"array pixels & channels must be packed (only rows may be strided)");
+    const size_t nRowStep = nRows>1?(size_t)oArray.strides(0):size_t(nCols*nChannels*nElemSize);
+    lvAssert_(nRows<=1 || oArray.strides(0)>=nCols*nChannels*nElemSize,"array rows must be in increasing address order, and must not overlap");
+    return cv::Mat(nRows,nCols,CV_MAKETYPE(nDepth,nChannels),const_cast<void*>(oArray.data()),nRowStep);
+}
+
+py::array lv::python::toArray(const cv::Mat& oMat, bool bWritable) {
+    lvAssert_(oMat.dims<=2,"only 2-dim mats can be exported as arrays");
+    if(oMat.empty())
+        return py::array(getArrayDType(oMat.depth()),std::vector<ssize_t>{0,0});
+    // mats that do not own their buffer (e.g. views of external memory) cannot be kept alive by the array, and are cloned first
+    const cv::Mat oMatRef = oMat.u?oMat:oMat.clone();
+    const int nChannels = oMatRef.channels();
+    std::vector<ssize_t> vnShape = {oMatRef.rows,oMatRef.cols};
+    std::vector<ssize_t> vnStrides = {(ssize_t)oMatRef.step[0],(ssize_t)oMatRef.elemSize()};
+    if(nChannels>1) {
+        vnShape.push_back(nChannels);
+        vnStrides.push_back((ssize_t)oMatRef.elemSize1());
+    }
+    // the capsule owns a copy of the mat header, i.e. a reference on its buffer (released once the array is collected)
+    py::capsule oBufferOwner(new cv::Mat(oMatRef),[](void* pMat){delete reinterpret_cast<cv::Mat*>(pMat);});
+    py::array oArray(getArrayDType(oMatRef.depth()),vnShape,vnStrides,oMatRef.data,oBufferOwner);
+    if(!bWritable)
+        py::detail::array_proxy(oArray.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+    return oArray;
+}
+
+cv::Mat lv::python::toOutputMat(const py::object& oOutput) {
+    if(oOutput.is_none())
+        return cv::Mat();
+    const py::array oArray = oOutput.cast<py::array>();
+    lvAssert_(oArray.writeable(),"output array must be writable");
+    return toMat(oArray);
+}
+
+py::array lv::python::fromOutputMat(const cv::Mat& oMat, const py::object& oOutput) {
+    if(oOutput.is_none())
+        return toArray(oMat);
+    const py::array oArray = oOutput.cast<py::array>();
+    lvAssert__(oMat.data==oArray.data(),"output array was reallocated due to a shape or dtype mismatch (expected %dx%d, %d channel(s), depth %d)",oMat.rows,oMat.cols,oMat.channels(),oMat.depth());
+    return oArray;
+}
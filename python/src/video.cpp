@@ -0,0 +1,80 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "bindings.hpp"
+
+namespace py = pybind11;
+
+void lv::python::registerVideo(py::module& oModule) {
+    py::class_<IIBackgroundSubtractor,std::shared_ptr<IIBackgroundSubtractor>>(oModule,"IBackgroundSubtractor","background subtractor interface; instances are not thread-safe, but several instances can run concurrently from different python threads")
+        .def("initialize",[](IIBackgroundSubtractor& oAlgo, const py::array& oInitImage, const py::object& oROI) {
+            // initialization is a one-off call after which the algo may hold on to the given mats, so they get their own copies
+            const cv::Mat oInitInput = toMat(oInitImage).clone();
+            const cv::Mat oInitROI = oROI.is_none()?cv::Mat():toMat(oROI.cast<py::array>()).clone();
+            py::gil_scoped_release oNoGIL;
+            oAlgo.initialize(oInitInput,oInitROI);
+        },py::arg("image"),py::arg("roi")=py::none(),"(re)initializes the model; needs to be called before starting background subtraction")
+        .def("apply",[](IIBackgroundSubtractor& oAlgo, const py::array& oImage, const py::object& oFGMask, double dLearningRate) {
+            const cv::Mat oInput = toMat(oImage);
+            cv::Mat oOutput = toOutputMat(oFGMask);
+            {
+                py::gil_scoped_release oNoGIL;
+                oAlgo.apply(oInput,oOutput,dLearningRate);
+            }
+            return fromOutputMat(oOutput,oFGMask);
+        },py::arg("image"),py::arg("fgmask")=py::none(),py::arg("learning_rate")=-1.0,
+          "updates the model & segments the image, writing the FG mask in the given (or a new) uint8 array")
+        .def("applyTimestamped",[](IIBackgroundSubtractor& oAlgo, const py::array& oImage, double dTimestamp, const py::object& oFGMask, double dLearningRate) {
+            const cv::Mat oInput = toMat(oImage);
+            cv::Mat oOutput = toOutputMat(oFGMask);
+            {
+                py::gil_scoped_release oNoGIL;
+                oAlgo.applyTimestamped(oInput,oOutput,dTimestamp,dLearningRate);
+            }
+            return fromOutputMat(oOutput,oFGMask);
+        },py::arg("image"),py::arg("timestamp"),py::arg("fgmask")=py::none(),py::arg("learning_rate")=-1.0,
+          "same as 'apply', but for timestamped frames (in seconds, see 'setTemporalDecimation')")
+        .def("getBackgroundImage",[](const IIBackgroundSubtractor& oAlgo, const py::object& oBGImage) {
+            cv::Mat oOutput = toOutputMat(oBGImage);
+            {
+                py::gil_scoped_release oNoGIL;
+                oAlgo.getBackgroundImage(oOutput);
+            }
+            return fromOutputMat(oOutput,oBGImage);
+        },py::arg("bgimage")=py::none(),"returns the latest reconstructed background image, in the given (or a new) array")
+        .def("getDefaultLearningRate",&IIBackgroundSubtractor::getDefaultLearningRate)
+        .def("setAutomaticModelReset",&IIBackgroundSubtractor::setAutomaticModelReset,py::arg("enabled"))
+        .def("setRandomSeed",&IIBackgroundSubtractor::setRandomSeed,py::arg("seed"))
+        .def("getROICopy",[](const IIBackgroundSubtractor& oAlgo) {return toArray(oAlgo.getROICopy());})
+        .def("setROICompactedProcessing",&IIBackgroundSubtractor::setROICompactedProcessing,py::arg("enabled"))
+        .def("setFusedPostProcessing",&IIBackgroundSubtractor::setFusedPostProcessing,py::arg("enabled"))
+        .def("setProcessingScale",&IIBackgroundSubtractor::setProcessingScale,py::arg("scale"))
+        .def("getProcessingScale",&IIBackgroundSubtractor::getProcessingScale)
+        .def("setTemporalDecimation",&IIBackgroundSubtractor::setTemporalDecimation,py::arg("enabled"),py::arg("nominal_frame_interval")=1.0/30,py::arg("update_stride")=1)
+        .def("setGovernor",&IIBackgroundSubtractor::setGovernor,py::arg("enabled"),py::arg("frame_time_budget")=1.0/30,py::arg("allow_rescaling")=false)
+        .def("setGovernorLevel",&IIBackgroundSubtractor::setGovernorLevel,py::arg("level"))
+        .def("getGovernorLevel",&IIBackgroundSubtractor::getGovernorLevel)
+        .def("getGovernorAvgFrameTime",&IIBackgroundSubtractor::getGovernorAvgFrameTime)
+        .def("setInstrumentation",&IIBackgroundSubtractor::setInstrumentation,py::arg("enabled"));
+    py::class_<BackgroundSubtractorSuBSENSE,IIBackgroundSubtractor,std::shared_ptr<BackgroundSubtractorSuBSENSE>>(oModule,"BackgroundSubtractorSuBSENSE")
+        .def(py::init<>());
+    py::class_<BackgroundSubtractorLOBSTER,IIBackgroundSubtractor,std::shared_ptr<BackgroundSubtractorLOBSTER>>(oModule,"BackgroundSubtractorLOBSTER")
+        .def(py::init<>());
+    py::class_<BackgroundSubtractorPAWCS,IIBackgroundSubtractor,std::shared_ptr<BackgroundSubtractorPAWCS>>(oModule,"BackgroundSubtractorPAWCS")
+        .def(py::init<>());
+}
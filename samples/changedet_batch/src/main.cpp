@@ -0,0 +1,77 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2016 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+/////////////////////////////////////////////////////////////////////////////
+//
+// This sample demonstrates how to process several video streams at once
+// using the batched background subtraction engine, which owns one algo
+// instance per stream and dispatches whole frame batches on a single shared
+// thread pool. The input streams are synthesized from the sample data image
+// (a static background with a moving object), and the aggregated processing
+// throughput is displayed.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include "litiv/video.hpp" // includes all background subtraction algos, along with most core utility & opencv headers
+
+#define STREAM_COUNT 4 // defines how many simultaneous streams should be processed in each batch
+#define THREAD_COUNT 0 // defines how many threads should be used to process the streams (0 = one per hardware thread)
+#define FRAME_COUNT 300 // defines how many frames should be processed in each stream
+
+int main(int, char**) { // this sample uses no command line argument
+    try { // its always a good idea to scope your app's top level in some try/catch blocks!
+        const cv::Mat oImage = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg"); // load a training image taken from the BSDS500 dataset (used to synthesize input streams)
+        if(oImage.empty()) // check if the mat is empty (i.e. if the image failed to load)
+            CV_Error(-1,"Could not load test image from internal sample data folder");
+        const cv::Size oFrameSize(oImage.cols/2,oImage.rows/2); // each stream will show a different quarter of the image as background
+        const cv::Size oObjectSize(oFrameSize.width/6,oFrameSize.height/6); // size of the object moving in front of the background
+        auto lGenerateFrame = [&](size_t nStreamIdx, size_t nFrameIdx, cv::Mat& oFrame) { // synthesizes a frame for a given stream: a static background, and a bouncing object
+            const cv::Point oBGOffset(int(nStreamIdx%2)*oFrameSize.width,int((nStreamIdx/2)%2)*oFrameSize.height);
+            oImage(cv::Rect(oBGOffset,oFrameSize)).copyTo(oFrame);
+            const int nRangeX = oFrameSize.width-oObjectSize.width, nRangeY = oFrameSize.height-oObjectSize.height;
+            const int nPosX = int((nFrameIdx*3+nStreamIdx*17)%(2*nRangeX)), nPosY = int((nFrameIdx*2+nStreamIdx*29)%(2*nRangeY));
+            const cv::Point oObjectPos(nPosX<nRangeX?nPosX:2*nRangeX-nPosX,nPosY<nRangeY?nPosY:2*nRangeY-nPosY);
+            cv::rectangle(oFrame,cv::Rect(oObjectPos,oObjectSize),cv::Scalar(0,0,255),-1);
+        };
+        // The batch engine below creates STREAM_COUNT independent 'LOBSTER' instances using default parameters (any
+        // other argument given after the thread count would be forwarded to each instance's constructor). Note that
+        // only non-parallel (cpu) algorithm implementations can be batched this way.
+        BackgroundSubtractorBatch<BackgroundSubtractorLOBSTER> oBatch(STREAM_COUNT,THREAD_COUNT);
+        std::cout << "Processing " << oBatch.getStreamCount() << " streams using " << oBatch.getThreadCount() << " thread(s)..." << std::endl;
+        std::vector<cv::Mat> voFrames(STREAM_COUNT),voFGMasks; // one input frame & output mask per stream (the masks are allocated once, and reused across calls)
+        for(size_t nStreamIdx=0; nStreamIdx<STREAM_COUNT; ++nStreamIdx)
+            lGenerateFrame(nStreamIdx,0,voFrames[nStreamIdx]);
+        oBatch.initialize(voFrames); // initialize all background models using the first frame of each stream (all ROIs are left empty, so the full frames are used)
+        lv::StopWatch oStopWatch;
+        for(size_t nFrameIdx=1; nFrameIdx<=FRAME_COUNT; ++nFrameIdx) { // loop over all frames, processing one frame of each stream per call
+            for(size_t nStreamIdx=0; nStreamIdx<STREAM_COUNT; ++nStreamIdx)
+                lGenerateFrame(nStreamIdx,nFrameIdx,voFrames[nStreamIdx]);
+            oBatch.applyBatch(voFrames,voFGMasks,nFrameIdx<=50?1:-1); // boost the learning rate in the first ~50 frames for initialization, and use each stream's default after
+            if((nFrameIdx%50)==0) { // every 50 frames, display the total average processing speed
+                const double dElapsedTime = oStopWatch.tock(false);
+                std::cout << " avg batch rate = " << nFrameIdx/dElapsedTime << " Hz,  total throughput = " << (nFrameIdx*STREAM_COUNT)/dElapsedTime << " frames/sec  (" << (nFrameIdx*STREAM_COUNT*oFrameSize.area())/(dElapsedTime*1e6) << " Mpx/sec)" << std::endl;
+            }
+        }
+        cv::imshow("Last input (stream #1)",voFrames[0]); // display the last input frame of the first stream
+        cv::imshow("Last segmentation output (stream #1)",voFGMasks[0]); // display the last output segmentation mask of the first stream (white = foreground)
+        cv::waitKey(0); // wait for the user to press a key before shutting down
+    }
+    catch(const cv::Exception& e) {std::cout << "\nmain caught cv::Exception:\n" << e.what() << "\n" << std::endl; return -1;}
+    catch(const std::exception& e) {std::cout << "\nmain caught std::exception:\n" << e.what() << "\n" << std::endl; return -1;}
+    catch(...) {std::cout << "\nmain caught unhandled exception\n" << std::endl; return -1;}
+    return 0;
+}
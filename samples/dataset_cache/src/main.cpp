@@ -0,0 +1,103 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2016 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+/////////////////////////////////////////////////////////////////////////////
+//
+// This sample demonstrates how to create and consume packed dataset caches.
+// All packets of a work batch are decoded & transformed once, and written to
+// a single binary file of raw aligned planes; the file is then memory-mapped,
+// and packets are returned as zero-copy views of the mapping. The packet
+// read throughput is displayed for both the regular (decoding) path and the
+// cached path, and the cached packets are then processed by an edge detector.
+//
+// The custom dataset used here is the same as in the 'dataset_simple' sample;
+// see its source code for more information on how it is parsed.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include "litiv/imgproc.hpp" // includes all edge detection algos, along with most core utility & opencv headers
+#include "litiv/datasets.hpp" // includes all datasets module utilities (along with pre-implemented datset specializations)
+
+#define READ_PASS_COUNT 10 // defines how many times all packets of a batch should be read to measure throughput
+
+int main(int, char**) { // this sample uses no command line argument
+    try { // its always a good idea to scope your app's top level in some try/catch blocks!
+
+        std::cout << "\nNote: a directory will be created at '" << lv::GetCurrentWorkDirPath() << "'\n" << std::endl;
+
+        using DatasetType = lv::Dataset_<lv::DatasetTask_EdgDet,lv::Dataset_Custom,lv::NonParallel>;
+        lv::IDatasetPtr pDataset = lv::datasets::create<lv::DatasetTask_EdgDet,lv::Dataset_Custom,lv::NonParallel>(
+            "Custom Dataset Cache Example",
+            lv::AddDirSlashIfMissing(SAMPLES_DATA_ROOT)+"custom_dataset_ex/",
+            "results_cache_test",
+            "edge_mask_",
+            ".png",
+            std::vector<std::string>{"batch1","batch2","batch3"},
+            std::vector<std::string>(),
+            std::vector<std::string>(),
+            0,
+            false, // outputs are not saved here, as we are mostly interested in packet loading speed
+            false,
+            false,
+            1.0
+        );
+        lv::IDataHandlerPtrArray vpBatches = pDataset->getBatches(false); // returns a list of all work batches in the dataset without considering hierarchy
+        if(vpBatches.size()==0 || pDataset->getTotPackets()==0) // check that data was indeed properly parsed automatically from the dataset directory
+            lvError_("Could not parse any data for dataset '%s'",pDataset->getName().c_str());
+        std::shared_ptr<IEdgeDetector> pAlgo = std::make_shared<EdgeDetectorLBSP>(); // instantiate an edge detector algo with default parameters
+        cv::Mat oEdgeMask; // no need to preallocate the output matrix (the algo will make sure it is allocated at some point)
+        for(auto pBatchIter = vpBatches.begin(); pBatchIter!=vpBatches.end(); ++pBatchIter) { // loop over all batches
+            DatasetType::WorkBatch& oBatch = dynamic_cast<DatasetType::WorkBatch&>(**pBatchIter);
+            const size_t nTotPackets = oBatch.getImageCount();
+            auto lReadAllPackets = [&]() { // reads all packets of the batch READ_PASS_COUNT times, and returns the read throughput (in packets/sec) along with the total byte count
+                size_t nTotBytes = 0;
+                lv::StopWatch oStopWatch;
+                for(size_t nPassIdx=0; nPassIdx<READ_PASS_COUNT; ++nPassIdx)
+                    for(size_t nPacketIdx=0; nPacketIdx<nTotPackets; ++nPacketIdx) {
+                        const cv::Mat& oPacket = oBatch.getInput(nPacketIdx);
+                        nTotBytes += oPacket.total()*oPacket.elemSize();
+                    }
+                const double dElapsedTime = std::max(oStopWatch.tock(),1e-9);
+                return std::make_pair((READ_PASS_COUNT*nTotPackets)/dElapsedTime,nTotBytes/(dElapsedTime*1024*1024));
+            };
+            std::cout << "\tBatch '" << oBatch.getName() << "' [" << nTotPackets << " packet(s)]" << std::endl;
+            const auto oDecodeSpeed = lReadAllPackets(); // first, read all packets through the regular path (decoding & transforming them on each request)
+            std::cout << "\t\tregular reads: " << oDecodeSpeed.first << " packets/sec (" << oDecodeSpeed.second << " MB/sec)" << std::endl;
+            const std::string sCacheFilePath = oBatch.getOutputPath()+"/packed_cache.bin";
+            lv::StopWatch oCreationStopWatch;
+            oBatch.writePackedCache(sCacheFilePath,false); // decode & transform all input packets once, and write them to the packed cache file (no gt is available in this dataset)
+            std::cout << "\t\tcache created in " << oCreationStopWatch.tock() << " sec at '" << sCacheFilePath << "'" << std::endl;
+            oBatch.usePackedCache(sCacheFilePath); // memory-map the cache file; from now on, packets are zero-copy views of the mapping (this could also be done in another run/process)
+            lvAssert_(oBatch.isUsingPackedCache(),"packed cache should be in use");
+            const auto oCachedSpeed = lReadAllPackets(); // read all packets again, this time through the packed cache
+            std::cout << "\t\tcached reads:  " << oCachedSpeed.first << " packets/sec (" << oCachedSpeed.second << " MB/sec)" << std::endl;
+            oBatch.startProcessing(); // the cached packets can then be processed as usual
+            for(size_t nPacketIdx=0; nPacketIdx<nTotPackets; ++nPacketIdx) {
+                pAlgo->apply(oBatch.getInput(nPacketIdx),oEdgeMask);
+                oBatch.push(oEdgeMask,nPacketIdx);
+            }
+            oBatch.stopProcessing();
+            std::cout << "\t\tprocessed from cache at ~" << nTotPackets/oBatch.getProcessTime() << " Hz" << std::endl;
+        }
+        pDataset->writeEvalReport(); // will write a basic evaluation report listing processed packet counts, processing speed, session duration, and framework version
+        std::cout << "All done!\n" << std::endl;
+    }
+    catch(const cv::Exception& e) {std::cout << "\nmain caught cv::Exception:\n" << e.what() << "\n" << std::endl; return -1;}
+    catch(const std::exception& e) {std::cout << "\nmain caught std::exception:\n" << e.what() << "\n" << std::endl; return -1;}
+    catch(...) {std::cout << "\nmain caught unhandled exception\n" << std::endl; return -1;}
+    return 0;
+}
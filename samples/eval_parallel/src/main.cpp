@@ -0,0 +1,96 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2016 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+/////////////////////////////////////////////////////////////////////////////
+//
+// This sample demonstrates how to evaluate binary classification results in
+// parallel, either by splitting large masks into row bands processed by a
+// thread pool, or by accumulating many frames concurrently in per-task
+// counters which are merged afterwards. Both approaches return exactly the
+// same counters as a serial evaluation. The classification results and
+// groundtruth masks are synthesized from the sample data image, and the
+// evaluation throughput of each approach is displayed.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include "litiv/datasets.hpp" // includes all datasets module utilities (along with the evaluation metrics helpers)
+
+#define MASK_UPSCALE_FACTOR 4 // defines the upscaling factor applied to the sample image to obtain 'large' masks
+#define FRAME_COUNT 64 // defines how many frames should be evaluated by each approach
+#define THREAD_COUNT 0 // defines how many threads should be used for parallel evaluation (0 = one per hardware thread)
+
+int main(int, char**) { // this sample uses no command line argument
+    try { // its always a good idea to scope your app's top level in some try/catch blocks!
+        const cv::Mat oImage = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg",cv::IMREAD_GRAYSCALE); // load a training image taken from the BSDS500 dataset (used to synthesize masks)
+        if(oImage.empty()) // check if the mat is empty (i.e. if the image failed to load)
+            CV_Error(-1,"Could not load test image from internal sample data folder");
+        cv::Mat oImageLarge;
+        cv::resize(oImage,oImageLarge,cv::Size(),MASK_UPSCALE_FACTOR,MASK_UPSCALE_FACTOR,cv::INTER_LINEAR);
+        // the synthetic groundtruth is a thresholded version of the image, with an out-of-scope border, and the
+        // synthetic classification results below are thresholded versions of a blurred copy (with varying thresholds)
+        cv::Mat oGT = oImageLarge>128; // comparisons return 255 (i.e. DATASETUTILS_POSITIVE_VAL) for true, and 0 for false
+        const int nBorderSize = oGT.rows/20;
+        oGT.rowRange(0,nBorderSize) = cv::Scalar_<uchar>(DATASETUTILS_OUTOFSCOPE_VAL);
+        oGT.rowRange(oGT.rows-nBorderSize,oGT.rows) = cv::Scalar_<uchar>(DATASETUTILS_OUTOFSCOPE_VAL);
+        cv::Mat oBlurred;
+        cv::GaussianBlur(oImageLarge,oBlurred,cv::Size(9,9),0);
+        std::vector<cv::Mat> voClassifs(FRAME_COUNT);
+        for(size_t nFrameIdx=0; nFrameIdx<FRAME_COUNT; ++nFrameIdx)
+            voClassifs[nFrameIdx] = oBlurred>int(112+nFrameIdx%32);
+        const size_t nTotPixels = FRAME_COUNT*oGT.total();
+        auto lPrintSpeed = [&](const char* sName, double dElapsedTime, const lv::BinClassifMetricsAccumulator& oMetrics) {
+            std::cout << "\t" << sName << ": " << FRAME_COUNT/dElapsedTime << " frames/sec (" << nTotPixels/(dElapsedTime*1e6) << " Mpx/sec), F-Measure = " << lv::BinClassifMetricsCalculator::CalcFMeasure(oMetrics) << std::endl;
+        };
+        lv::ThreadPool oThreadPool(THREAD_COUNT); // the pool handle used by both parallel approaches below
+        std::cout << "Evaluating " << FRAME_COUNT << " masks of " << oGT.cols << "x" << oGT.rows << " pixels using up to " << oThreadPool.getThreadCount() << " thread(s)..." << std::endl;
+
+        // 1st approach: serial, frame by frame (this is what dataset evaluators do by default)
+        lv::BinClassifMetricsAccumulatorPtr pSerialMetrics = lv::BinClassifMetricsAccumulator::create();
+        lv::StopWatch oStopWatch;
+        for(size_t nFrameIdx=0; nFrameIdx<FRAME_COUNT; ++nFrameIdx)
+            pSerialMetrics->accumulate(voClassifs[nFrameIdx],oGT);
+        lPrintSpeed("serial      ",oStopWatch.tock(),*pSerialMetrics);
+
+        // 2nd approach: each frame is split into row bands evaluated on the thread pool (useful for very large masks)
+        lv::BinClassifMetricsAccumulatorPtr pBandedMetrics = lv::BinClassifMetricsAccumulator::create();
+        oStopWatch.tick();
+        for(size_t nFrameIdx=0; nFrameIdx<FRAME_COUNT; ++nFrameIdx)
+            pBandedMetrics->accumulate(voClassifs[nFrameIdx],oGT,cv::Mat(),oThreadPool);
+        lPrintSpeed("row bands   ",oStopWatch.tock(),*pBandedMetrics);
+
+        // 3rd approach: frames are evaluated concurrently in per-task accumulators, which are then merged
+        std::vector<lv::BinClassifMetricsAccumulatorPtr> vpTaskMetrics(oThreadPool.getThreadCount());
+        for(auto& pTaskMetrics : vpTaskMetrics)
+            pTaskMetrics = lv::BinClassifMetricsAccumulator::create();
+        oStopWatch.tick();
+        oThreadPool.parallel_for(vpTaskMetrics.size(),[&](size_t nTaskIdx) {
+            for(size_t nFrameIdx=nTaskIdx; nFrameIdx<FRAME_COUNT; nFrameIdx+=vpTaskMetrics.size())
+                vpTaskMetrics[nTaskIdx]->accumulate(voClassifs[nFrameIdx],oGT);
+        });
+        lv::BinClassifMetricsAccumulatorPtr pMergedMetrics = lv::BinClassifMetricsAccumulator::create();
+        for(const auto& pTaskMetrics : vpTaskMetrics)
+            *pMergedMetrics += *pTaskMetrics;
+        lPrintSpeed("frame tasks ",oStopWatch.tock(),*pMergedMetrics);
+
+        lvAssert_(pSerialMetrics->isEqual(pBandedMetrics) && pSerialMetrics->isEqual(pMergedMetrics),"parallel evaluation results should match the serial ones");
+        std::cout << "All done! (all approaches returned identical counters)\n" << std::endl;
+    }
+    catch(const cv::Exception& e) {std::cout << "\nmain caught cv::Exception:\n" << e.what() << "\n" << std::endl; return -1;}
+    catch(const std::exception& e) {std::cout << "\nmain caught std::exception:\n" << e.what() << "\n" << std::endl; return -1;}
+    catch(...) {std::cout << "\nmain caught unhandled exception\n" << std::endl; return -1;}
+    return 0;
+}
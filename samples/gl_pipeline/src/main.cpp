@@ -0,0 +1,89 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2016 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+/////////////////////////////////////////////////////////////////////////////
+//
+// This sample demonstrates how to run a GLSL background subtraction algo as
+// the head of a GPU pipeline, with fenced asynchronous output readbacks. The
+// input upload of the next frame, the processing of the current frame, and
+// the readback of the previous frame's output then all overlap, and
+// intermediate pipeline outputs never leave the GPU. The input stream is
+// synthesized from the sample data image, and the processing throughput is
+// displayed.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include "litiv/video.hpp" // includes all background subtraction algos, along with most core utility & opencv headers
+
+#define USE_ASYNC_FETCHING 1 // defines whether outputs should be read back asynchronously (adds one frame of latency) or not (1/0)
+#define FRAME_COUNT 500 // defines how many frames should be processed
+
+int main(int, char**) { // this sample uses no command line argument
+    try { // its always a good idea to scope your app's top level in some try/catch blocks!
+        const cv::Mat oImage = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg"); // load a training image taken from the BSDS500 dataset (used to synthesize the input stream)
+        if(oImage.empty()) // check if the mat is empty (i.e. if the image failed to load)
+            CV_Error(-1,"Could not load test image from internal sample data folder");
+        cv::Mat oImageRGBA; // GLSL algos are much happier with 4-byte aligned inputs, so we convert the image to 4-channel data first
+        cv::cvtColor(oImage,oImageRGBA,cv::COLOR_BGR2BGRA);
+        const cv::Size oObjectSize(oImage.cols/8,oImage.rows/8); // size of the object moving in front of the background
+        auto lGenerateFrame = [&](size_t nFrameIdx, cv::Mat& oFrame) { // synthesizes a frame: a static background, and an object moving along the diagonal
+            oImageRGBA.copyTo(oFrame);
+            const int nRange = std::min(oImage.cols-oObjectSize.width,oImage.rows-oObjectSize.height), nPos = int((nFrameIdx*2)%(2*nRange));
+            cv::rectangle(oFrame,cv::Rect(cv::Point(nPos<nRange?nPos:2*nRange-nPos,nPos<nRange?nPos:2*nRange-nPos),oObjectSize),cv::Scalar(0,0,255,255),-1);
+        };
+        lv::gl::Context oContext(oImage.size(),"gl_pipeline"); // creates & activates an (hidden, or headless if no display is available) OpenGL context for this thread
+        std::shared_ptr<BackgroundSubtractorLOBSTER_GLSL> pAlgo = std::make_shared<BackgroundSubtractorLOBSTER_GLSL>(); // instantiate a GLSL background subtractor algo with default parameters
+        const double dDefaultLearningRate = pAlgo->getDefaultLearningRate(); // gets the suggested learning rate to use post-initialization
+        cv::Mat oFrame,oForegroundMask; // the input frame is regenerated each iteration, and the output mask will be allocated by the pipeline
+        lGenerateFrame(0,oFrame);
+        pAlgo->initialize_gl(oFrame,cv::Mat()); // initialize the background model on the gpu using the first frame (the ROI is left empty, so the full frame is used)
+        // The pipeline below chains the background subtractor with a pass-through stage; any other GLImageProcAlgo
+        // (e.g. a post-processing filter) could be appended the same way. Each appended stage directly reads the output
+        // image of the previous one on the gpu, and only the last stage's output is read back to the host.
+        GLImageProcPipeline oPipeline(pAlgo);
+        std::shared_ptr<GLImagePassThroughAlgo> pLastStage = std::make_shared<GLImagePassThroughAlgo>(CV_8UC1,false,false,false);
+        oPipeline.addStage(pLastStage);
+        oPipeline.initialize_gl(cv::Mat());
+#if USE_ASYNC_FETCHING
+        if(!pLastStage->setAsyncFetching(true)) // fetches then return the output queued by the previous call instead of stalling on the current one
+            std::cout << "Note: async fetching requires output PBOs, falling back to synchronous readbacks." << std::endl;
+#endif //USE_ASYNC_FETCHING
+        size_t nFetchedFrames = 0; // counts fetched outputs (in async mode, the first call has nothing to return yet)
+        lv::StopWatch oStopWatch;
+        for(size_t nFrameIdx=1; nFrameIdx<=FRAME_COUNT; ++nFrameIdx) { // loop over all frames
+            lGenerateFrame(nFrameIdx,oFrame);
+            pAlgo->apply_gl(oFrame,false,nFrameIdx<=50?1:dDefaultLearningRate); // upload the frame & process it on the gpu (boost the learning rate in the first ~50 frames for initialization)
+            oPipeline.apply_gl(); // run all appended stages on the latest background subtractor output
+            oPipeline.fetchLastOutput(oForegroundMask); // read back the latest available output of the final stage (see 'setAsyncFetching' for its latency)
+            if(!oForegroundMask.empty())
+                ++nFetchedFrames;
+            if(oContext.pollEventsAndCheckIfShouldClose()) // keep the context responsive, and stop if it was closed
+                break;
+            if((nFrameIdx%100)==0) // every 100 frames, display the total average processing speed
+                std::cout << " avgFPS = " << nFrameIdx/oStopWatch.tock(false) << "  (" << nFetchedFrames << " outputs fetched)" << std::endl;
+        }
+        glErrorCheck; // make sure no error was raised by the gl driver along the way
+        if(!oForegroundMask.empty()) {
+            cv::imshow("Last segmentation output",oForegroundMask); // display the last fetched output segmentation mask (white = foreground)
+            cv::waitKey(0); // wait for the user to press a key before shutting down
+        }
+    }
+    catch(const cv::Exception& e) {std::cout << "\nmain caught cv::Exception:\n" << e.what() << "\n" << std::endl; return -1;}
+    catch(const std::exception& e) {std::cout << "\nmain caught std::exception:\n" << e.what() << "\n" << std::endl; return -1;}
+    catch(...) {std::cout << "\nmain caught unhandled exception\n" << std::endl; return -1;}
+    return 0;
+}